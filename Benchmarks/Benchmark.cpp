@@ -0,0 +1,186 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===========
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "Math/Simd.h"
+//======================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+void Benchmark::Run(const string& name, const uint64_t operations, const function<float()>& function)
+{
+    if (!m_filter.empty() && name.find(m_filter) == string::npos)
+        return;
+
+    // Warm up the caches, the branch predictors and the clock speed
+    for (uint32_t i = 0; i < warm_up_count; i++)
+    {
+        m_sink = m_sink + function();
+    }
+
+    vector<double> samples(sample_count);
+    for (double& sample : samples)
+    {
+        const auto start    = chrono::steady_clock::now();
+        m_sink              = m_sink + function();
+        const auto end      = chrono::steady_clock::now();
+        sample              = chrono::duration<double, nano>(end - start).count() / static_cast<double>(operations);
+    }
+    sort(samples.begin(), samples.end());
+
+    auto percentile = [&samples](const double fraction) { return samples[static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1) + 0.5)]; };
+
+    Result result;
+    result.name         = name;
+    result.samples      = sample_count;
+    result.operations   = operations;
+    result.ns_min       = samples.front();
+    result.ns_p50       = percentile(0.5);
+    result.ns_p90       = percentile(0.9);
+    result.ns_p99       = percentile(0.99);
+    m_results.emplace_back(result);
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-32s %10.2f %10.2f %10.2f %10.2f ns", name.c_str(), result.ns_min, result.ns_p50, result.ns_p90, result.ns_p99);
+    cout << line << endl;
+}
+
+bool Benchmark::SaveJson(const string& path) const
+{
+    ofstream file(path);
+    if (!file.good())
+    {
+        cerr << "Failed to open \"" << path << "\" for writing" << endl;
+        return false;
+    }
+
+    file << "{" << endl;
+    file << "    \"build\": \"" << GetBuild() << "\"," << endl;
+    file << "    \"benchmarks\":" << endl;
+    file << "    [" << endl;
+    for (size_t i = 0; i < m_results.size(); i++)
+    {
+        const Result& result = m_results[i];
+        char line[512];
+        snprintf(line, sizeof(line), "        { \"name\": \"%s\", \"samples\": %u, \"operations\": %llu, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f }%s",
+            result.name.c_str(), result.samples, static_cast<unsigned long long>(result.operations), result.ns_min, result.ns_p50, result.ns_p90, result.ns_p99, i + 1 < m_results.size() ? "," : "");
+        file << line << endl;
+    }
+    file << "    ]" << endl;
+    file << "}" << endl;
+
+    return true;
+}
+
+bool Benchmark::Compare(const string& path_baseline, const double tolerance) const
+{
+    ifstream file(path_baseline);
+    if (!file.good())
+    {
+        cerr << "Failed to open \"" << path_baseline << "\"" << endl;
+        return false;
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    const string json = buffer.str();
+
+    // The files are the ones SaveJson() writes, so a benchmark's fields follow its name on the same line
+    auto find_field = [&json](const string& name, const string& field, double* value)
+    {
+        const size_t line = json.find("\"name\": \"" + name + "\"");
+        if (line == string::npos)
+            return false;
+
+        const size_t position = json.find("\"" + field + "\": ", line);
+        if (position == string::npos || position > json.find('\n', line))
+            return false;
+
+        *value = strtod(json.c_str() + position + field.size() + 4, nullptr);
+        return true;
+    };
+
+    const size_t build = json.find("\"build\": \"");
+    if (build != string::npos && json.compare(build + 10, strlen(GetBuild()), GetBuild()) != 0)
+    {
+        cout << "The baseline was produced by another build, the comparison may not be meaningful" << endl;
+    }
+
+    bool regressed = false;
+    for (const Result& result : m_results)
+    {
+        double baseline = 0.0;
+        if (!find_field(result.name, "p50", &baseline) || baseline <= 0.0)
+        {
+            cout << result.name << ": not in the baseline" << endl;
+            continue;
+        }
+
+        const double change = result.ns_p50 / baseline - 1.0;
+        const bool slower   = change > tolerance;
+        regressed           = regressed || slower;
+
+        char line[256];
+        snprintf(line, sizeof(line), "%-32s %10.2f -> %10.2f ns %+7.1f%%%s", result.name.c_str(), baseline, result.ns_p50, change * 100.0, slower ? "  REGRESSION" : "");
+        cout << line << endl;
+    }
+
+    return !regressed;
+}
+
+const char* Benchmark::GetBuild()
+{
+    // What changes the generated math code, the compiler, the configuration and the instruction set
+#if defined(_MSC_VER)
+    const string compiler = "msvc_" + to_string(_MSC_VER);
+#else
+    const string compiler = "other";
+#endif
+
+#if defined(DEBUG)
+    const string configuration = "debug";
+#else
+    const string configuration = "release";
+#endif
+
+#if defined(SPARTAN_MATH_SSE) && (defined(__FMA__) || defined(__AVX2__))
+    const string simd = "sse_fma";
+#elif defined(SPARTAN_MATH_SSE)
+    const string simd = "sse";
+#elif defined(SPARTAN_MATH_NEON)
+    const string simd = "neon";
+#else
+    const string simd = "scalar";
+#endif
+
+    static const string build = compiler + "_" + configuration + "_" + simd;
+    return build.c_str();
+}
@@ -0,0 +1,66 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======
+#include <functional>
+#include <string>
+#include <vector>
+//=================
+
+// Times a function over a fixed number of samples, after a warm-up, and keeps the percentiles of the time per operation.
+// The counts don't depend on how long the functions take, so that every build does the same work and the results of different commits can be compared.
+class Benchmark
+{
+public:
+    struct Result
+    {
+        std::string name;
+        uint32_t samples    = 0;
+        uint64_t operations = 0; // per sample
+        double ns_min       = 0.0; // per operation
+        double ns_p50       = 0.0;
+        double ns_p90       = 0.0;
+        double ns_p99       = 0.0;
+    };
+
+    // Only the benchmarks whose name contains the filter run (all of them if it's empty)
+    Benchmark(const std::string& filter) : m_filter(filter) {}
+
+    // The function performs the operations and returns a value which depends on all of them, so that they can't be optimized away
+    void Run(const std::string& name, uint64_t operations, const std::function<float()>& function);
+
+    // One benchmark per line, along with the build which produced them
+    bool SaveJson(const std::string& path) const;
+    // Compares the medians with the ones of an earlier run, returns false if any of them is slower by more than the tolerance (a fraction)
+    bool Compare(const std::string& path_baseline, double tolerance) const;
+
+    static const char* GetBuild();
+
+private:
+    static constexpr uint32_t warm_up_count = 16;
+    static constexpr uint32_t sample_count  = 201;
+
+    std::string m_filter;
+    std::vector<Result> m_results;
+    volatile float m_sink = 0.0f;
+};
@@ -0,0 +1,235 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===================
+#include <iostream>
+#include <random>
+#include "Benchmark.h"
+#include "Math/BoundingBox.h"
+#include "Math/Frustum.h"
+#include "Math/Matrix.h"
+#include "Math/Quaternion.h"
+#include "Math/Ray.h"
+//==============================
+
+//= NAMESPACES ===========
+using namespace std;
+using namespace Spartan::Math;
+//========================
+
+// Micro-benchmarks of Runtime/Math, the inputs come from a fixed seed so every run measures the same work.
+//
+// Usage: Benchmarks [--filter text] [--json path] [--baseline path] [--tolerance fraction]
+// The results are written to benchmarks.json by default. With a baseline (the json of an earlier run) the medians are compared
+// and the exit code is 1 if any benchmark got slower than the tolerance allows (0.1 by default).
+
+namespace
+{
+    constexpr uint32_t input_count = 1024; // a power of two, inputs are indexed with a mask
+
+    struct Inputs
+    {
+        vector<Matrix> matrices;
+        vector<Vector3> positions;
+        vector<Quaternion> rotations;
+        vector<Vector3> scales;
+        vector<BoundingBox> boxes;
+        vector<Ray> rays;
+        FrustumBoxes frustum_boxes;
+        Frustum frustum;
+    };
+
+    Inputs CreateInputs()
+    {
+        mt19937 generator(1234);
+        uniform_real_distribution<float> position(-50.0f, 50.0f);
+        uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        uniform_real_distribution<float> size(0.1f, 5.0f);
+
+        Inputs inputs;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            Quaternion rotation(unit(generator), unit(generator), unit(generator), unit(generator));
+            rotation.Normalize();
+            const Vector3 translation(position(generator), position(generator), position(generator));
+            const Vector3 scale(size(generator), size(generator), size(generator));
+
+            inputs.rotations.emplace_back(rotation);
+            inputs.positions.emplace_back(translation);
+            inputs.scales.emplace_back(scale);
+            inputs.matrices.emplace_back(translation, rotation, scale);
+
+            const Vector3 extent(size(generator), size(generator), size(generator));
+            inputs.boxes.emplace_back(translation - extent, translation + extent);
+            inputs.frustum_boxes.Add(translation, extent);
+            inputs.rays.emplace_back(Vector3(position(generator), position(generator), position(generator)), Vector3(position(generator), position(generator), position(generator)));
+        }
+
+        const Matrix view       = Matrix::CreateLookAtLH(Vector3(0.0f, 2.0f, -20.0f), Vector3::Zero, Vector3::Up);
+        const Matrix projection = Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 16.0f / 9.0f, 0.3f, 1000.0f);
+        inputs.frustum          = Frustum(view, projection, 1000.0f);
+
+        return inputs;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string filter;
+    string path_json        = "benchmarks.json";
+    string path_baseline;
+    double tolerance        = 0.1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const string argument = argv[i];
+        if (argument == "--filter")         filter          = argv[i + 1];
+        else if (argument == "--json")      path_json       = argv[i + 1];
+        else if (argument == "--baseline")  path_baseline   = argv[i + 1];
+        else if (argument == "--tolerance") tolerance       = atof(argv[i + 1]);
+        else
+        {
+            cerr << "Unknown argument \"" << argument << "\"" << endl;
+            return 1;
+        }
+    }
+
+    const Inputs inputs = CreateInputs();
+    Benchmark benchmark(filter);
+    cout << "Build: " << Benchmark::GetBuild() << endl;
+    cout << "                                        min        p50        p90        p99" << endl;
+
+    constexpr uint32_t mask = input_count - 1;
+
+    //= MATRIX ==================================================================================
+    benchmark.Run("matrix_multiply", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            sum += (inputs.matrices[i] * inputs.matrices[(i + 1) & mask]).Data()[0];
+        }
+        return sum;
+    });
+
+    benchmark.Run("matrix_invert", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (const Matrix& matrix : inputs.matrices)
+        {
+            sum += Matrix::Invert(matrix).Data()[0];
+        }
+        return sum;
+    });
+
+    benchmark.Run("matrix_transform_point", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            sum += (inputs.matrices[i] * inputs.positions[(i + 1) & mask]).x;
+        }
+        return sum;
+    });
+
+    benchmark.Run("matrix_compose_trs", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            sum += Matrix(inputs.positions[i], inputs.rotations[i], inputs.scales[i]).Data()[0];
+        }
+        return sum;
+    });
+    //===========================================================================================
+
+    //= QUATERNION ==============================================================================
+    benchmark.Run("quaternion_multiply", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            sum += (inputs.rotations[i] * inputs.rotations[(i + 1) & mask]).w;
+        }
+        return sum;
+    });
+
+    benchmark.Run("quaternion_rotate_vector", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            sum += (inputs.rotations[i] * inputs.positions[(i + 1) & mask]).x;
+        }
+        return sum;
+    });
+    //===========================================================================================
+
+    //= CULLING =================================================================================
+    benchmark.Run("bounding_box_transform", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            sum += inputs.boxes[i].Transform(inputs.matrices[(i + 1) & mask]).GetMin().x;
+        }
+        return sum;
+    });
+
+    benchmark.Run("frustum_box", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (const BoundingBox& box : inputs.boxes)
+        {
+            sum += inputs.frustum.IsVisible(box.GetCenter(), box.GetExtents()) ? 1.0f : 0.0f;
+        }
+        return sum;
+    });
+
+    vector<uint8_t> visible;
+    benchmark.Run("frustum_box_batch", input_count, [&inputs, &visible]()
+    {
+        inputs.frustum.IsVisible(inputs.frustum_boxes, visible);
+        return static_cast<float>(visible[0] + visible[input_count - 1]);
+    });
+
+    benchmark.Run("ray_box", input_count, [&inputs]()
+    {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < input_count; i++)
+        {
+            const float distance = inputs.rays[i].HitDistance(inputs.boxes[(i + 1) & mask]);
+            sum += distance == INFINITY ? 0.0f : distance;
+        }
+        return sum;
+    });
+    //===========================================================================================
+
+    if (!benchmark.SaveJson(path_json))
+        return 1;
+
+    if (!path_baseline.empty())
+    {
+        cout << endl << "Compared to " << path_baseline << endl;
+        return benchmark.Compare(path_baseline, tolerance) ? 0 : 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========
+#include "Common.hlsl"
+//====================
+
+// The exposure, a single texel which carries over from frame to frame (added to g_exposure when tone-mapping)
+RWTexture2D<float> tex_out : register(u0);
+
+static const uint histogram_bins            = 256;
+static const uint2 histogram_samples        = uint2(256, 128); // the input is sampled on this grid, whatever its resolution is
+static const float histogram_log_min        = -10.0f;          // log2 of the luminance, anything darker goes to the first bin (which the average leaves out)
+static const float histogram_log_range      = 22.0f;
+static const float exposure_key             = 0.18f;           // the average luminance is exposed to middle gray
+
+groupshared uint histogram[histogram_bins];
+groupshared float2 histogram_sums[histogram_bins];
+
+inline uint luminance_to_bin(float3 color)
+{
+    float luminance_log = log2(luminance(color));
+    if (luminance_log < histogram_log_min)
+        return 0;
+
+    return (uint)(saturate((luminance_log - histogram_log_min) / histogram_log_range) * (histogram_bins - 2) + 1.0f);
+}
+
+// A single group builds the histogram of the frame (a bin per thread) and adapts the exposure towards its average,
+// so both happen in one dispatch and nothing but the exposure itself ever leaves the group.
+[numthreads(16, 16, 1)]
+void mainCS(uint3 thread_id : SV_GroupThreadID, uint group_index : SV_GroupIndex)
+{
+    histogram[group_index] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    // Each thread takes a block of the sample grid, the bilinear taps average the pixels between them
+    const uint2 block = histogram_samples / 16;
+    for (uint y = 0; y < block.y; y++)
+    {
+        for (uint x = 0; x < block.x; x++)
+        {
+            float2 uv       = ((thread_id.xy * block + uint2(x, y)) + 0.5f) / float2(histogram_samples);
+            float3 color    = tex.SampleLevel(sampler_bilinear_clamp, uv, 0).rgb;
+            InterlockedAdd(histogram[luminance_to_bin(color)], 1);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // The weighted sum of the bins and the number of pixels in them, without the first bin
+    float count     = group_index == 0 ? 0.0f : (float)histogram[group_index];
+    float2 sum      = float2(count * (float)(group_index - 1), count);
+
+#if defined(__SHADER_TARGET_MAJOR) && __SHADER_TARGET_MAJOR >= 6
+    // A sum per wave, then the first thread adds up the waves
+    sum = WaveActiveSum(sum);
+    if (WaveIsFirstLane())
+    {
+        histogram_sums[group_index / WaveGetLaneCount()] = sum;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (group_index != 0)
+        return;
+
+    for (uint wave = 1; wave < histogram_bins / WaveGetLaneCount(); wave++)
+    {
+        sum += histogram_sums[wave];
+    }
+#else
+    // Shader model 5 has no wave operations, a reduction through groupshared memory instead
+    histogram_sums[group_index] = sum;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint stride = histogram_bins / 2; stride > 0; stride >>= 1)
+    {
+        if (group_index < stride)
+        {
+            histogram_sums[group_index] += histogram_sums[group_index + stride];
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (group_index != 0)
+        return;
+
+    sum = histogram_sums[0];
+#endif
+
+    // A black frame keeps the exposure it had
+    float exposure_previous = tex_out[uint2(0, 0)];
+    bool reset              = g_color.z != 0.0f || isnan(exposure_previous) || isinf(exposure_previous);
+    if (sum.y == 0.0f)
+    {
+        tex_out[uint2(0, 0)] = reset ? 0.0f : exposure_previous;
+        return;
+    }
+
+    // The exposure which takes the average to middle gray (ToneMap() scales by exp() of it), the previous one moves towards it exponentially
+    float luminance_log     = (sum.x / sum.y) / (histogram_bins - 2) * histogram_log_range + histogram_log_min;
+    float exposure_target   = log(exposure_key) - luminance_log * log(2.0f);
+    float adaptation        = 1.0f - exp(-g_color.x * g_color.y);
+
+    tex_out[uint2(0, 0)] = reset ? exposure_target : lerp(exposure_previous, exposure_target, adaptation);
+}
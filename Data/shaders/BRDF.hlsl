@@ -19,6 +19,9 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#ifndef SPARTAN_BRDF
+#define SPARTAN_BRDF
+
 //= INCLUDES =========
 #include "Common.hlsl"
 //====================
@@ -235,23 +238,20 @@ inline float3 BRDF_Specular_Sheen(Material material, float n_dot_v, float n_dot_
     Image based lighting
 ------------------------------------------------------------------------------*/
 
-static const float mip_max = 11.0f;
+// The prefiltered environment, a slice per roughness level followed by the irradiance
+static const float environment_slices_specular = 6.0f; // must match the renderer
 
-inline float3 SampleEnvironment(Texture2D tex_environment, float2 uv, float mip_level)
+// Roughness (the squared one) 0 is the environment itself, each slice is the next 1 / environment_slices_specular of it
+inline float3 SampleEnvironment(Texture2D tex_environment, Texture2DArray tex_environment_prefiltered, float2 uv, float a)
 {
-    // We are currently using a spherical environment map which has a 2:1 ratio, so at the smallest 
-    // mipmap we have to do a bit of blending otherwise we'll get a visible seem in the middle.
-    if (mip_level == mip_max)
-    {
-        float2 mip_size = float2(2, 1);
-        float dx        = mip_size.x;
+    float level     = saturate(a) * environment_slices_specular;
+    float level_0   = floor(level);
+    float level_1   = min(level_0 + 1.0f, environment_slices_specular);
     
-        float3 tl = (tex_environment.SampleLevel(sampler_trilinear_clamp, uv + float2(-dx, 0.0f), mip_level).rgb);
-        float3 tr = (tex_environment.SampleLevel(sampler_trilinear_clamp, uv + float2(dx, 0.0f), mip_level).rgb);
-        return (tl + tr) / 2.0f;
-    }
+    float3 color_0 = (level_0 == 0.0f) ? tex_environment.SampleLevel(sampler_trilinear_clamp, uv, 0.0f).rgb : tex_environment_prefiltered.SampleLevel(sampler_bilinear_clamp, float3(uv, level_0 - 1.0f), 0.0f).rgb;
+    float3 color_1 = tex_environment_prefiltered.SampleLevel(sampler_bilinear_clamp, float3(uv, level_1 - 1.0f), 0.0f).rgb;
     
-    return (tex_environment.SampleLevel(sampler_trilinear_clamp, uv, mip_level).rgb);
+    return lerp(color_0, color_1, level - level_0);
 }
 
 inline float3 GetSpecularDominantDir(float3 normal, float3 reflection, float roughness)
@@ -275,12 +275,13 @@ inline float3 EnvBRDFApprox(float3 specColor, float roughness, float NdV)
     return specColor * AB.x + AB.y;
 }
 
-inline float3 Brdf_Diffuse_Ibl(Material material, float3 normal, Texture2D tex_environment)
+inline float3 Brdf_Diffuse_Ibl(Material material, float3 normal, Texture2DArray tex_environment_prefiltered)
 {
-    return SampleEnvironment(tex_environment, direction_sphere_uv(normal), mip_max) * material.albedo;
+    float3 irradiance = tex_environment_prefiltered.SampleLevel(sampler_bilinear_clamp, float3(direction_sphere_uv(normal), environment_slices_specular), 0.0f).rgb;
+    return irradiance * material.albedo;
 }
 
-inline float3 Brdf_Specular_Ibl(Material material, float3 normal, float3 camera_to_pixel, Texture2D tex_environment, Texture2D tex_lutIBL, inout float3 diffuse_energy, inout float3 reflectivity)
+inline float3 Brdf_Specular_Ibl(Material material, float3 normal, float3 camera_to_pixel, Texture2D tex_environment, Texture2DArray tex_environment_prefiltered, Texture2D tex_lutIBL, inout float3 diffuse_energy, inout float3 reflectivity)
 {
     // remapping and linearization
     float roughness = clamp(material.roughness, 0.089f, 1.0f);
@@ -291,8 +292,7 @@ inline float3 Brdf_Specular_Ibl(Material material, float3 normal, float3 camera_
     float n_dot_v           = dot(-camera_to_pixel, normal);
     float f90               = 0.5 + 2 * n_dot_v * n_dot_v * material.roughness;
     float3 F                = F_Schlick(material.F0, f90, material.roughness);
-    float mip_level         = lerp(0, mip_max, a);
-    float3 prefilteredColor = SampleEnvironment(tex_environment, direction_sphere_uv(reflection), mip_level);
+    float3 prefilteredColor = SampleEnvironment(tex_environment, tex_environment_prefiltered, direction_sphere_uv(reflection), a);
     float2 envBRDF          = tex_lutIBL.Sample(sampler_bilinear_clamp, float2(saturate(n_dot_v), material.roughness)).xy;
     reflectivity            *= F * envBRDF.x + envBRDF.y;
 
@@ -300,3 +300,5 @@ inline float3 Brdf_Specular_Ibl(Material material, float3 normal, float3 camera_
     
     return prefilteredColor * reflectivity;   
 }
+
+#endif // SPARTAN_BRDF
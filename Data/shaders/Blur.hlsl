@@ -21,25 +21,27 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 float4 Blur_Box(float2 uv, Texture2D tex)
 {
-    float4 result   = float4(0.0f, 0.0f, 0.0f, 0.0f);
-    float temp      = float(-int(g_blur_sigma)) * 0.5f + 0.5f;
-    float2 hlim     = float2(temp, temp);
+    // Every tap is weighted as it's accumulated, so the sum stays within half precision range
+    real4 result        = real4(0.0f, 0.0f, 0.0f, 0.0f);
+    const real weight   = (real)(1.0f / (g_blur_sigma * g_blur_sigma));
+    float temp          = float(-int(g_blur_sigma)) * 0.5f + 0.5f;
+    float2 hlim         = float2(temp, temp);
     
     for (float i = 0; i < g_blur_sigma; i += g_blur_direction.x)
     {
         for (float j = 0; j < g_blur_sigma; j += g_blur_direction.y) 
         {
             float2 offset = (hlim + float2(float(i), float(j))) * g_texel_size;
-            result += tex.SampleLevel(sampler_bilinear_clamp, uv + offset, 0);
+            result += (real4)tex.SampleLevel(sampler_bilinear_clamp, uv + offset, 0) * weight;
         }
     }
 
-    return result / float(g_blur_sigma * g_blur_sigma);
+    return result;
 }
 
 float4 Blur_Gaussian_Fast(float2 uv, Texture2D tex)
 {
-    float4 color  = 0.0f;
+    real4 color   = 0.0f;
     float2 off1   = float2(1.3846153846, 1.3846153846) * g_blur_direction;
     float2 off2   = float2(3.2307692308, 3.2307692308) * g_blur_direction;
     color += tex.SampleLevel(sampler_bilinear_clamp, uv, 0) * 0.2270270270;
@@ -50,26 +52,55 @@ float4 Blur_Gaussian_Fast(float2 uv, Texture2D tex)
     return color;
 }
 
-// Calculates the gaussian blur weight for a given distance and sigmas
-float CalcGaussianWeight(int sampleDist)
+// Gaussian weight without the normalization factor (the blurs divide by the weight sum anyway),
+// sigma_factor is -1 / (2 * sigma^2) so that it's computed once per pixel instead of once per tap.
+inline float gaussian_weight(float distance, float sigma_factor)
 {
-    float sigma2 = g_blur_sigma * g_blur_sigma;
-    float g = 1.0f / sqrt(2.0f * 3.14159f * sigma2);
-    return (g * exp(-(sampleDist * sampleDist) / (2.0f * sigma2)));
+    return exp(distance * distance * sigma_factor);
 }
 
+static const int blur_gaussian_radius = 5;
+
 // Performs a gaussian blur in one direction
 float4 Blur_Gaussian(float2 uv, Texture2D tex)
 {
     // https://github.com/TheRealMJP/MSAAFilter/blob/master/MSAAFilter/PostProcessing.hlsl#L50
-    float weightSum = 0.0f;
-    float4 color    = 0;
-    for (int i = -5; i < 5; i++)
+    const float sigma_factor    = -1.0f / (2.0f * g_blur_sigma * g_blur_sigma);
+    float weightSum             = 1.0f;
+    float4 color                = tex.SampleLevel(sampler_point_clamp, uv, 0);
+
+    [branch]
+    if (dot(g_blur_direction, g_blur_direction) == 1.0f)
+    {
+        // Adjacent texels, so every two taps are merged into a single bilinear fetch placed between them, weighted by their weights
+        // http://rastergrid.com/blog/2010/09/efficient-gaussian-blur-with-linear-sampling/
+        [unroll]
+        for (int i = 1; i <= blur_gaussian_radius; i += 2)
+        {
+            float weight_0  = gaussian_weight(i, sigma_factor);
+            float weight_1  = i + 1 <= blur_gaussian_radius ? gaussian_weight(i + 1, sigma_factor) : 0.0f;
+            float weight    = weight_0 + weight_1;
+            float offset    = (i * weight_0 + (i + 1) * weight_1) / weight;
+            float2 uv_delta = offset * g_texel_size * g_blur_direction;
+
+            color       += tex.SampleLevel(sampler_bilinear_clamp, uv + uv_delta, 0) * weight;
+            color       += tex.SampleLevel(sampler_bilinear_clamp, uv - uv_delta, 0) * weight;
+            weightSum   += weight * 2.0f;
+        }
+    }
+    else
     {
-        float2 sample_uv    = uv + (i * g_texel_size * g_blur_direction);    
-        float weight        = CalcGaussianWeight(i);
-        color               += tex.SampleLevel(sampler_bilinear_clamp, sample_uv, 0) * weight;
-        weightSum           += weight;
+        // Texels are further apart than one, they can't share a bilinear fetch
+        [unroll]
+        for (int i = 1; i <= blur_gaussian_radius; i++)
+        {
+            float weight    = gaussian_weight(i, sigma_factor);
+            float2 uv_delta = i * g_texel_size * g_blur_direction;
+
+            color       += tex.SampleLevel(sampler_point_clamp, uv + uv_delta, 0) * weight;
+            color       += tex.SampleLevel(sampler_point_clamp, uv - uv_delta, 0) * weight;
+            weightSum   += weight * 2.0f;
+        }
     }
 
     color /= weightSum;
@@ -80,29 +111,67 @@ float4 Blur_Gaussian(float2 uv, Texture2D tex)
 // Performs a bilateral gaussian blur (depth aware) in one direction
 float4 Blur_GaussianBilateral(float2 uv, Texture2D tex)
 {
-    float weightSum         = 0.0f;
-    float4 color            = 0.0f;
-    float center_depth      = get_linear_depth(tex_depth.SampleLevel(sampler_point_clamp, uv, 0).r);
-    float3 center_normal    = normal_decode(tex_normal.SampleLevel(sampler_point_clamp, uv, 0).xyz);
-    float threshold         = 0.1f;
-    
+    const float sigma_factor    = -1.0f / (2.0f * g_blur_sigma * g_blur_sigma);
+    float weightSum             = 0.0f;
+    float4 color                = 0.0f;
+    float center_depth          = get_linear_depth(tex_depth.SampleLevel(sampler_point_clamp, uv, 0).r);
+    float3 center_normal        = gbuffer_normal_decode(tex_normal.SampleLevel(sampler_point_clamp, uv, 0));
+    float threshold             = 0.1f;
 
-    for (int i = -5; i < 5; i++)
+    // The taps sit on texel centers, so the point sampler fetches the same values as the bilinear one did, for less
+    [unroll]
+    for (int i = -blur_gaussian_radius; i <= blur_gaussian_radius; i++)
     {
         float2 sample_uv        = uv + (i * g_texel_size * g_blur_direction);    
-        float sample_depth      = get_linear_depth(tex_depth.SampleLevel(sampler_bilinear_clamp, sample_uv, 0).r);
-        float3 sample_normal    = normal_decode(tex_normal.SampleLevel(sampler_bilinear_clamp, sample_uv, 0).xyz);
+        float sample_depth      = get_linear_depth(tex_depth.SampleLevel(sampler_point_clamp, sample_uv, 0).r);
+        float3 sample_normal    = gbuffer_normal_decode(tex_normal.SampleLevel(sampler_point_clamp, sample_uv, 0));
         
         // Depth-awareness
         float awareness_depth   = saturate(threshold - abs(center_depth - sample_depth));
         float awareness_normal  = saturate(dot(center_normal, sample_normal)) + FLT_MIN; // FLT_MIN prevents NaN
         float awareness         = awareness_normal * awareness_depth;
 
-        float weight        = CalcGaussianWeight(i) * awareness;
-        color               += tex.SampleLevel(sampler_bilinear_clamp, sample_uv, 0) * weight;
+        float weight        = gaussian_weight(i, sigma_factor) * awareness;
+        color               += tex.SampleLevel(sampler_point_clamp, sample_uv, 0) * weight;
         weightSum           += weight; 
     }
     color /= weightSum;
 
     return color;
 }
+
+// Joint bilateral upsample, tex is the low resolution input and tex2 its (downsampled) depth, g_resolution is the low resolution.
+// The four low resolution texels around the pixel are weighted bilinearly and by how close their depth is to the full resolution depth,
+// so that occlusion and reflections don't bleed across edges.
+float4 Upsample_Bilateral(float2 uv, Texture2D tex)
+{
+    float center_depth  = get_linear_depth(tex_depth.SampleLevel(sampler_point_clamp, uv, 0).r);
+    float threshold     = 0.1f;
+
+    // Lower left texel of the 2x2 neighbourhood and the bilinear weights
+    float2 position     = uv * g_resolution - 0.5f;
+    float2 position_low = floor(position);
+    float2 f            = position - position_low;
+    float4 weights_bilinear = float4((1.0f - f.x) * (1.0f - f.y), f.x * (1.0f - f.y), (1.0f - f.x) * f.y, f.x * f.y);
+
+    float2 offsets[4] = { float2(0.5f, 0.5f), float2(1.5f, 0.5f), float2(0.5f, 1.5f), float2(1.5f, 1.5f) };
+
+    float weightSum = 0.0f;
+    float4 color    = 0.0f;
+    [unroll]
+    for (uint i = 0; i < 4; i++)
+    {
+        float2 sample_uv    = (position_low + offsets[i]) * g_texel_size;
+        float sample_depth  = get_linear_depth(tex2.SampleLevel(sampler_point_clamp, sample_uv, 0).r);
+
+        // Depth-awareness
+        float awareness_depth   = saturate(threshold - abs(center_depth - sample_depth)) + FLT_MIN; // FLT_MIN prevents NaN
+
+        float weight    = weights_bilinear[i] * awareness_depth;
+        color           += tex.SampleLevel(sampler_point_clamp, sample_uv, 0) * weight;
+        weightSum       += weight;
+    }
+    color /= weightSum;
+
+    return color;
+}
@@ -23,6 +23,19 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Common.hlsl"
 //====================
 
+#if INSTANCED
+// Debug primitives, every instance places a unit primitive and carries its color (see Renderer::DrawBox())
+Pixel_PosColor mainVS(Vertex_PosColor_Instanced input)
+{
+    Pixel_PosColor output;
+
+    input.position.w    = 1.0f;
+    output.position     = mul(mul(input.position, instance_matrix(input.instance_transform)), g_viewProjectionUnjittered);
+    output.color        = input.color * input.instance_color;
+
+    return output;
+}
+#else
 Pixel_PosColor mainVS(Vertex_PosColor input)
 {
     Pixel_PosColor output;
@@ -33,6 +46,7 @@ Pixel_PosColor mainVS(Vertex_PosColor input)
     
     return output;
 }
+#endif
 
 float4 mainPS(Pixel_PosColor input) : SV_TARGET
 {
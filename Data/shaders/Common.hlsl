@@ -24,12 +24,31 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =================
 #include "Common_Struct.hlsl"
-#include "Common_Vertex.hlsl"
 #include "Common_Buffer.hlsl"
+#include "Common_Vertex.hlsl"
 #include "Common_Sampler.hlsl"
 #include "Common_Texture.hlsl"
 //============================
 
+/*------------------------------------------------------------------------------
+    PRECISION
+------------------------------------------------------------------------------*/
+// Colors and weights of the passes which tolerate 16-bit floats, the renderer compiles those passes with HALF_PRECISION
+// where the GPU does 16-bit math natively (DXC then makes these float16_t). Texture coordinates and positions stay in float.
+#if HALF_PRECISION
+typedef min16float      real;
+typedef min16float2     real2;
+typedef min16float3     real3;
+typedef min16float4     real4;
+typedef min16float3x3   real3x3;
+#else
+typedef float           real;
+typedef float2          real2;
+typedef float3          real3;
+typedef float4          real4;
+typedef float3x3        real3x3;
+#endif
+
 /*------------------------------------------------------------------------------
     CONSTANTS
 ------------------------------------------------------------------------------*/
@@ -110,11 +129,67 @@ inline float3 normal_decode(float3 normal)  { return normalize(normal); }
 // No encoding required (just normalise)
 inline float3 normal_encode(float3 normal)  { return normalize(normal); }
 
+// Octahedral encoding, maps a unit vector to [0, 1] in two channels
+inline float2 normal_encode_octahedral(float3 normal)
+{
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+
+    if (normal.z < 0.0f)
+    {
+        float2 sign_xy  = float2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+        normal.xy       = (1.0f - abs(normal.yx)) * sign_xy;
+    }
+
+    return normal.xy * 0.5f + 0.5f;
+}
+
+inline float3 normal_decode_octahedral(float2 encoded)
+{
+    encoded         = encoded * 2.0f - 1.0f;
+    float3 normal   = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t         = saturate(-normal.z);
+    normal.x        += normal.x >= 0.0f ? -t : t;
+    normal.y        += normal.y >= 0.0f ? -t : t;
+
+    return normalize(normal);
+}
+
+/*------------------------------------------------------------------------------
+    G-BUFFER
+------------------------------------------------------------------------------*/
+// The normal target holds the world space normal and the material id, in one of two layouts:
+// Default (R16G16B16A16_Float) - xyz: normal,                  w: material id
+// Compact (R10G10B10A2_Unorm)  - xy:  octahedral encoded normal, z: material id (half the bytes per pixel)
+static const float gbuffer_material_id_max          = 65535.0f;
+static const float gbuffer_material_id_max_compact  = 1023.0f; // same as the maximum number of material instances
+
+inline float4 gbuffer_normal_encode(float3 normal, float material_id)
+{
+    [branch]
+    if (g_gbuffer_compact != 0.0f)
+        return float4(normal_encode_octahedral(normal), material_id / gbuffer_material_id_max_compact, 0.0f);
+
+    return float4(normal_encode(normal), material_id / gbuffer_material_id_max);
+}
+
+inline float3 gbuffer_normal_decode(float4 sample_normal)
+{
+    [branch]
+    if (g_gbuffer_compact != 0.0f)
+        return normal_decode_octahedral(sample_normal.xy);
+
+    return normal_decode(sample_normal.xyz);
+}
+
+inline int gbuffer_material_id(float4 sample_normal)
+{
+    return g_gbuffer_compact != 0.0f ? round(sample_normal.z * gbuffer_material_id_max_compact) : round(sample_normal.w * gbuffer_material_id_max);
+}
+
+// The encoded normals can't be filtered, so this is a point sample
 inline float3 get_normal(float2 uv)
 {
-    //float2 pos = clamp(uv * g_resolution, 0.0f, g_resolution);
-    //return normal_decode(tex_normal.Load(int3(pos, 0)).rgb);
-    return tex_normal.SampleLevel(sampler_bilinear_clamp, uv, 0).xyz;
+    return gbuffer_normal_decode(tex_normal.SampleLevel(sampler_point_clamp, uv, 0));
 }
 
 inline float3 get_normal_view_space(float2 uv)
@@ -233,6 +308,15 @@ inline float2 direction_sphere_uv(float3 direction)
     return uv;
 }
 
+// The inverse of direction_sphere_uv()
+inline float3 sphere_uv_direction(float2 uv)
+{
+    float phi   = (1.0f - uv.x) * PI2;
+    float theta = uv.y * PI;
+    
+    return float3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+}
+
 inline uint direction_to_cube_face_index(const float3 direction)
 {
     float3 direction_abs = abs(direction);
@@ -292,6 +376,60 @@ inline float blue_noise(float2 uv)
     return tex_blue_noise.Sample(sampler_bilinear_wrap, uv * noise_scale + temporal_factor).r;
 }
 
+// http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
+// efficient VanDerCorpus calculation.
+inline float RadicalInverse_VdC(uint bits) 
+{
+     bits = (bits << 16u) | (bits >> 16u);
+     bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+     bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+     bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+     bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+     return float(bits) * 2.3283064365386963e-10; // / 0x100000000
+}
+
+inline float2 Hammersley(uint i, uint n)
+{
+    return float2(float(i)/float(n), RadicalInverse_VdC(i));
+}
+
+// From a hemisphere around +Z to a hemisphere around n
+inline float3 hemisphere_to_world(float3 direction, float3 n)
+{
+    float3 up        = abs(n.z) < 0.999 ? float3(0.0, 0.0, 1.0) : float3(1.0, 0.0, 0.0);
+    float3 tangent   = normalize(cross(up, n));
+    float3 bitangent = cross(n, tangent);
+    
+    return normalize(tangent * direction.x + bitangent * direction.y + n * direction.z);
+}
+
+inline float3 ImportanceSampleGGX(float2 Xi, float3 N, float roughness)
+{
+    float a = roughness*roughness;
+    
+    float phi = 2.0 * PI * Xi.x;
+    float cosTheta = sqrt((1.0 - Xi.y) / (1.0 + (a*a - 1.0) * Xi.y));
+    float sinTheta = sqrt(1.0 - cosTheta*cosTheta);
+    
+    // from spherical coordinates to cartesian coordinates - halfway vector
+    float3 H;
+    H.x = cos(phi) * sinTheta;
+    H.y = sin(phi) * sinTheta;
+    H.z = cosTheta;
+    
+    // from tangent-space H vector to world-space sample vector
+    return hemisphere_to_world(H, N);
+}
+
+inline float3 ImportanceSampleCosine(float2 Xi, float3 N)
+{
+    float phi       = 2.0 * PI * Xi.x;
+    float cosTheta  = sqrt(1.0 - Xi.y);
+    float sinTheta  = sqrt(Xi.y);
+    
+    return hemisphere_to_world(float3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta), N);
+}
+
 /*------------------------------------------------------------------------------
     OCCLUSION/SHADOWING
 ------------------------------------------------------------------------------*/
@@ -322,6 +460,47 @@ float microw_shadowing_cod(float n_dot_l, float visibility)
     return microShadow * microShadow;
 }
 
+/*------------------------------------------------------------------------------
+    DISPLACEMENT
+------------------------------------------------------------------------------*/
+// Displaced vertices are a flat patch whose units are texels of a height map laid over the world's xz plane (see Model::SetVertexDisplacement()).
+// The patch origin (the translation of its world matrix) maps to the height map through the object buffer, the vertices are lifted by what they sample.
+#if DISPLACED_VERTEX
+float displacement_sample(float2 uv)
+{
+    return lerp(g_draw.displacement_height.x, g_draw.displacement_height.y, tex_displacement.SampleLevel(sampler_bilinear_clamp, uv, 0).r);
+}
+
+float2 displacement_uv(float3 position, float3 origin_world, out float2 texel_size)
+{
+    tex_displacement.GetDimensions(texel_size.x, texel_size.y);
+    texel_size = 1.0f / texel_size;
+    return origin_world.xz * g_draw.displacement_uv_scale_offset.xy + g_draw.displacement_uv_scale_offset.zw + position.xz * texel_size;
+}
+
+void vertex_displace(inout float4 position, float3 origin_world)
+{
+    float2 texel_size;
+    position.y += displacement_sample(displacement_uv(position.xyz, origin_world, texel_size));
+}
+
+// The normal and the tangent follow the slope of the height map (central differences, a texel is a unit of the patch)
+void vertex_displace(inout float4 position, inout float3 normal, inout float3 tangent, float3 origin_world)
+{
+    float2 texel_size;
+    float2 uv = displacement_uv(position.xyz, origin_world, texel_size);
+    position.y += displacement_sample(uv);
+
+    float slope_x   = (displacement_sample(uv + float2(texel_size.x, 0.0f)) - displacement_sample(uv - float2(texel_size.x, 0.0f))) * 0.5f;
+    float slope_z   = (displacement_sample(uv + float2(0.0f, texel_size.y)) - displacement_sample(uv - float2(0.0f, texel_size.y))) * 0.5f;
+    normal          = normalize(float3(-slope_x, 1.0f, -slope_z));
+    tangent         = normalize(float3(1.0f, slope_x, 0.0f));
+}
+#else
+void vertex_displace(inout float4 position, float3 origin_world) {}
+void vertex_displace(inout float4 position, inout float3 normal, inout float3 tangent, float3 origin_world) {}
+#endif
+
 /*------------------------------------------------------------------------------
     MISC
 ------------------------------------------------------------------------------*/
@@ -55,7 +55,8 @@ cbuffer BufferFrame : register(b0)
     float2 g_taa_jitter_offset;
 
     uint g_frame;
-    float3 g_padding;
+    float g_gbuffer_compact;
+    float2 g_taa_jitter;
 };
 
 // Low frequency - Updates once per frame
@@ -90,7 +91,13 @@ cbuffer BufferUber : register(b2)
     float g_mat_height;
 
     float g_mat_id;
-    float3 g_padding2;
+    uint g_postprocess_flags;
+    uint g_light_index; // the light which a light pass draws, in BufferLights
+    float g_padding2;
+
+    float4 g_mat_texture_slices; // roughness, metallic, occlusion and mask, their slice in tex_material_array, negative if bound on their own
+
+    float4 g_transform_axis_colors[4]; // x, y, z and xyz, for the instanced transform handle
 };
 
 // High frequency - Updates per object
@@ -99,15 +106,84 @@ cbuffer BufferObject : register(b3)
     matrix g_object_transform;
     matrix g_object_wvp_current;
     matrix g_object_wvp_previous;
+
+    float4 g_object_impostor_center_radius; // impostors, the bounds of the model
+
+    float4 g_object_particle_velocity_spread; // particle emitters
+    float4 g_object_particle_color_start;
+    float4 g_object_particle_color_end;
+    float4 g_object_particle_time_period_lifetime_gravity;
+    float4 g_object_particle_rate_size_seed;
+};
+
+// Highest frequency - Updates per draw, pushed into the command list on Vulkan and a constant buffer of the command list elsewhere
+struct DrawData
+{
+    float3 position_offset; // compact vertices
+    float padding;
+    float3 position_scale;
+    float padding2;
+
+    float4 displacement_uv_scale_offset; // displaced vertices
+    float2 displacement_height;
+    float2 padding3;
+};
+#if defined(__spirv__)
+[[vk::push_constant]] DrawData g_draw;
+#else
+cbuffer BufferDraw : register(b9) // must match rhi_push_constant_slot
+{
+    DrawData g_draw;
+};
+#endif
+
+// High frequency - Updates per skinned object, once per frame
+static const uint g_max_skin_bones = 64; // must match rhi_max_skin_bones
+cbuffer BufferSkin : register(b6)
+{
+    matrix g_skin_bones[g_max_skin_bones];
+};
+
+// Low frequency - Updates once per frame, every light
+static const uint g_max_lights = 64;
+cbuffer BufferLights : register(b4)
+{
+    matrix light_view_projection[g_max_lights * 6]; // six per light, the cascades or the cube faces
+    float4 light_color_intensity[g_max_lights];
+    float4 light_position_range[g_max_lights];
+    float4 light_direction_angle[g_max_lights];     // w is negative for point and directional lights
+    float4 light_bias_normal_bias[g_max_lights];    // z is the channel of the screen space shadow mask plus one (zero for none), w is one for directional lights
+    uint4 light_screen_space_shadows;               // the light of each channel of the screen space shadow mask, g_max_lights for none
 };
 
-// High frequency - Updates per light
-cbuffer LightBuffer : register(b4)
+// Low frequency - Updates once per frame, the lights which don't need shadow maps binned into clusters
+static const uint g_light_cluster_count_x       = 16;
+static const uint g_light_cluster_count_y       = 9;
+static const uint g_light_cluster_count_z       = 24;
+static const uint g_light_cluster_count         = g_light_cluster_count_x * g_light_cluster_count_y * g_light_cluster_count_z;
+cbuffer BufferLightClusters : register(b5)
 {
-    matrix light_view_projection[6];
-    float4 intensity_range_angle_bias;
-    float3 color;
-    float normal_bias;
-    float4 position;
-    float4 direction;
-};
\ No newline at end of file
+    float4 cluster_slice_scale_bias_count;
+    uint4 cluster_masks[g_light_cluster_count / 2]; // two clusters per element, xy is the first mask and zw the second, bits index BufferLights
+};
+
+// Low frequency - Updates once per frame, the decals in view binned into the same clusters as the lights
+static const uint g_max_decals = 64;
+cbuffer BufferDecals : register(b7)
+{
+    float4 decal_slice_scale_bias_count;
+    matrix decal_world_to_box[g_max_decals];
+    float4 decal_atlas_rect[g_max_decals];          // uv offset (xy) and scale (zw) of the decal's cell in the atlas, no texture if the scale is zero
+    float4 decal_color[g_max_decals];
+    float4 decal_roughness_metallic[g_max_decals];
+    uint4 decal_masks[g_light_cluster_count / 2];   // as the light cluster masks, bits index the decals above
+};
+
+// Low frequency - Updates once per frame, the baked reflection probes nearest to the camera
+static const uint g_max_reflection_probes = 8;
+cbuffer BufferReflectionProbes : register(b8)
+{
+    float4 reflection_probe_count;
+    float4 reflection_probe_center_fade[g_max_reflection_probes];   // center of the box and the fade distance
+    float4 reflection_probe_extents_slice[g_max_reflection_probes]; // half size of the box and the first slice in the atlas
+};
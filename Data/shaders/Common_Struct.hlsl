@@ -50,6 +50,7 @@ struct Light
     float   bias;
     float   normal_bias;
     uint    array_size;
+    uint    index; // in BufferLights
 };
 
 struct Surface
@@ -61,3 +61,26 @@ Texture2D tex_blue_noise                : register(t31);
 
 // Compute
 Texture2D<float4> tex_in                : register(t32);
+
+// Environment, prefiltered per roughness level (and the irradiance)
+Texture2DArray tex_environment_prefiltered : register(t33);
+
+// Vertex, the height map which displaced vertices are lifted by
+Texture2D tex_displacement              : register(t34);
+
+// Impostors, the frames of a model rendered from around it (see Impostor.hlsl)
+Texture2D tex_impostor_albedo           : register(t35);
+Texture2D tex_impostor_normal           : register(t36);
+
+// Decals, a cell per decal texture (see Decal.hlsl)
+Texture2D tex_decal_atlas               : register(t37);
+
+// Reflection probes, the faces of the one which is being baked and the atlas of the baked ones (see ReflectionProbe.hlsl)
+Texture2DArray tex_reflection_probe_faces : register(t38);
+Texture2DArray tex_reflection_probes    : register(t39);
+
+// Exposure, adapted to the luminance of the frame (see AutoExposure.hlsl)
+Texture2D tex_exposure                  : register(t40);
+
+// Small material textures, a slice each (see GBuffer.hlsl)
+Texture2DArray tex_material_array       : register(t41);
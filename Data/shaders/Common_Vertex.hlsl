@@ -44,6 +44,145 @@ struct Vertex_PosUvNorTan
     float3 tangent      : TANGENT0;
 };
 
+// Instanced vertices, the per-instance matrices come in as rows (the instance buffer stores them column-major)
+struct Vertex_Pos_Instanced
+{
+    float4 position                 : POSITION0;
+    float4 instance_transform[4]    : INSTANCE_TRANSFORM0;
+    float4 instance_wvp_previous[4] : INSTANCE_WVP_PREVIOUS0;
+};
+
+// Debug primitives have no use for last frame's matrix, so its first row carries their color
+struct Vertex_PosColor_Instanced
+{
+    float4 position                 : POSITION0;
+    float4 color                    : COLOR0;
+    float4 instance_transform[4]    : INSTANCE_TRANSFORM0;
+    float4 instance_color           : INSTANCE_WVP_PREVIOUS0;
+};
+
+struct Vertex_PosUv_Instanced
+{
+    float4 position                 : POSITION0;
+    float2 uv                       : TEXCOORD0;
+    float4 instance_transform[4]    : INSTANCE_TRANSFORM0;
+    float4 instance_wvp_previous[4] : INSTANCE_WVP_PREVIOUS0;
+};
+
+struct Vertex_PosUvNorTan_Instanced
+{
+    float4 position                 : POSITION0;
+    float2 uv                       : TEXCOORD0;
+    float3 normal                   : NORMAL0;
+    float3 tangent                  : TANGENT0;
+    float4 instance_transform[4]    : INSTANCE_TRANSFORM0;
+    float4 instance_wvp_previous[4] : INSTANCE_WVP_PREVIOUS0;
+};
+
+float4x4 instance_matrix(float4 rows[4])
+{
+    return transpose(float4x4(rows[0], rows[1], rows[2], rows[3]));
+}
+
+// Compact vertices, positions are normalized to the bounds of the model, normals and tangents are octahedral
+struct Vertex_PosUvNorTanCompact
+{
+    float4 position     : POSITION0;
+    float2 uv           : TEXCOORD0;
+    float2 normal       : NORMAL0;
+    float2 tangent      : TANGENT0;
+};
+
+struct Vertex_PosUvNorTanCompact_Instanced
+{
+    float4 position                 : POSITION0;
+    float2 uv                       : TEXCOORD0;
+    float2 normal                   : NORMAL0;
+    float2 tangent                  : TANGENT0;
+    float4 instance_transform[4]    : INSTANCE_TRANSFORM0;
+    float4 instance_wvp_previous[4] : INSTANCE_WVP_PREVIOUS0;
+};
+
+// Skinned vertices, the bone indices come in normalized (like the weights)
+struct Vertex_PosUvNorTanSkin
+{
+    float4 position     : POSITION0;
+    float2 uv           : TEXCOORD0;
+    float3 normal       : NORMAL0;
+    float3 tangent      : TANGENT0;
+    float4 bones        : BLENDINDICES0;
+    float4 weights      : BLENDWEIGHT0;
+};
+
+struct Vertex_PosUvNorTanSkin_Instanced
+{
+    float4 position                 : POSITION0;
+    float2 uv                       : TEXCOORD0;
+    float3 normal                   : NORMAL0;
+    float3 tangent                  : TANGENT0;
+    float4 bones                    : BLENDINDICES0;
+    float4 weights                  : BLENDWEIGHT0;
+    float4 instance_transform[4]    : INSTANCE_TRANSFORM0;
+    float4 instance_wvp_previous[4] : INSTANCE_WVP_PREVIOUS0;
+};
+
+// The bone palette (see BufferSkin) blended by the weights, a vertex without weights stays where it is
+float4x4 skin_matrix(float4 bones, float4 weights)
+{
+    uint4 indices       = (uint4)(bones * 255.0f + 0.5f);
+    float4x4 skin       = g_skin_bones[indices.x] * weights.x;
+    skin                += g_skin_bones[indices.y] * weights.y;
+    skin                += g_skin_bones[indices.z] * weights.z;
+    skin                += g_skin_bones[indices.w] * weights.w;
+
+    float weight_sum    = dot(weights, 1.0f);
+    float4x4 identity   = float4x4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+    return weight_sum > 0.0f ? skin : identity;
+}
+
+// Shaders which draw models are compiled with COMPACT_VERTEX or SKINNED_VERTEX for models with those vertices,
+// they take a Vertex_Mesh and read it through vertex_position(), vertex_direction() and vertex_skin(), which work with any of them.
+#if COMPACT_VERTEX
+#define Vertex_Mesh             Vertex_PosUvNorTanCompact
+#define Vertex_Mesh_Instanced   Vertex_PosUvNorTanCompact_Instanced
+#elif SKINNED_VERTEX
+#define Vertex_Mesh             Vertex_PosUvNorTanSkin
+#define Vertex_Mesh_Instanced   Vertex_PosUvNorTanSkin_Instanced
+#else
+#define Vertex_Mesh             Vertex_PosUvNorTan
+#define Vertex_Mesh_Instanced   Vertex_PosUvNorTan_Instanced
+#endif
+
+float4 vertex_position(float4 position)
+{
+#if COMPACT_VERTEX
+    return float4(g_draw.position_offset + position.xyz * g_draw.position_scale, 1.0f);
+#else
+    return float4(position.xyz, 1.0f);
+#endif
+}
+
+// The skin of a vertex, which the geometry (its position and directions) is multiplied with before the world matrix
+#if SKINNED_VERTEX
+#define vertex_skin(input) skin_matrix(input.bones, input.weights)
+#else
+#define vertex_skin(input) float4x4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f)
+#endif
+
+float3 vertex_direction(float3 direction)
+{
+    return direction;
+}
+
+float3 vertex_direction(float2 octahedral)
+{
+    float3 direction    = float3(octahedral.x, octahedral.y, 1.0f - abs(octahedral.x) - abs(octahedral.y));
+    float fold          = saturate(-direction.z);
+    direction.x         += direction.x >= 0.0f ? -fold : fold;
+    direction.y         += direction.y >= 0.0f ? -fold : fold;
+    return normalize(direction);
+}
+
 struct Vertex_Pos2dUvColor
 {
     float2 position     : POSITION0;
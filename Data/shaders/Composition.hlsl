@@ -19,9 +19,11 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-// = INCLUDES ======
+// = INCLUDES ============
 #include "BRDF.hlsl"
-//==================
+#include "Froxel.hlsl"
+#include "ReflectionProbe.hlsl"
+//========================
 
 float4 mainPS(Pixel_PosUv input) : SV_TARGET
 {
@@ -31,16 +33,17 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
     // Sample from textures
     float4 sample_normal    = tex_normal.Sample(sampler_point_clamp, uv);
     float4 sample_material  = tex_material.Sample(sampler_point_clamp, uv);
-    float3 light_volumetric = tex_lightVolumetric.Sample(sampler_point_clamp, uv).rgb;   
     float depth             = tex_depth.Sample(sampler_point_clamp, uv).r;
     float2 sample_ssr       = tex_ssr.Sample(sampler_point_clamp, uv).xy;
     float4 sample_hbao      = tex_hbao.Sample(sampler_point_clamp, uv);
     float3 camera_to_pixel  = get_view_direction(depth, uv);
 
     // Post-process samples
-    int mat_id = round(sample_normal.a * 65535);
+    int mat_id = gbuffer_material_id(sample_normal);
     
-    // Volumetric lighting
+    // Volumetric lighting, the froxels in front of the pixel
+    float depth_view        = dot(get_position(depth, uv) - g_camera_position, g_camera_direction);
+    float3 light_volumetric = froxel_sample(tex_lightVolumetric, uv, depth_view);
     color += light_volumetric;
     
     [branch]
@@ -66,23 +69,27 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
         material.F0         = lerp(0.04f, material.albedo, material.metallic);
 
         // Light - Image based
+        float3 normal               = gbuffer_normal_decode(sample_normal);
         float3 diffuse_energy       = 1.0f;
         float3 reflective_energy    = 1.0f;
-        float3 light_ibl_specular   = Brdf_Specular_Ibl(material, sample_normal.xyz, camera_to_pixel, tex_environment, tex_lutIbl, diffuse_energy, reflective_energy);
-        float3 light_ibl_diffuse    = Brdf_Diffuse_Ibl(material, sample_normal.xyz, tex_environment) * diffuse_energy; // Tone down diffuse such as that only non metals have it
+        float3 light_ibl_specular   = Brdf_Specular_Ibl(material, normal, camera_to_pixel, tex_environment, tex_environment_prefiltered, tex_lutIbl, diffuse_energy, reflective_energy);
+        float3 light_ibl_diffuse    = Brdf_Diffuse_Ibl(material, normal, tex_environment_prefiltered) * diffuse_energy; // Tone down diffuse such as that only non metals have it
+
+        // Light - Reflection probes, inside their boxes they stand in for the environment (and for what SSR misses)
+        reflection_probe_ibl(get_position(depth, uv), material, normal, camera_to_pixel, diffuse_energy, reflective_energy, light_ibl_diffuse, light_ibl_specular);
 
         // Light - Bounce (diffuse)
-        float3 light_bounce = 0.0f;
+        real3 light_bounce = 0.0f;
         #if INDIRECT_BOUNCE
         light_bounce += sample_hbao.rgb * material.albedo;
         #endif
         
         // Light - SSR
-        float3 light_reflection = 0.0f;
+        real3 light_reflection = 0.0f;
         [branch]
         if (g_ssr_enabled && all(sample_ssr))
         {
-            float fade = 1.0f - material.roughness; // fade with roughness as we don't have blurry screen space reflections yet
+            real fade = 1.0f - material.roughness; // fade with roughness as we don't have blurry screen space reflections yet
             
             // Reflection
             light_reflection = saturate(tex_frame.Sample(sampler_bilinear_clamp, sample_ssr).rgb);
@@ -98,7 +105,7 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
         float3 light_emissive = material.emissive * material.albedo * 50.0f;
 
         // Light - Ambient
-        float3 light_ambient = saturate(g_directional_light_intensity * 0.01f);
+        real3 light_ambient = saturate(g_directional_light_intensity * 0.01f);
 		#if INDIRECT_BOUNCE
 		light_ambient *= sample_hbao.a;
 		#else
@@ -0,0 +1,73 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// Decal atlas, must match the renderer
+static const float g_decal_atlas_size = 8.0f * 256.0f;
+
+// Blends the decals whose boxes contain the position into the surface, screen_uv picks the cluster
+void ApplyDecals(float3 position, float2 screen_uv, inout float4 albedo, inout float roughness, inout float metallic)
+{
+    // Find the pixel's cluster, like the clustered lights do
+    float depth_view    = mul(float4(position, 1.0f), g_view).z;
+    uint2 tile          = min(uint2(screen_uv * float2(g_light_cluster_count_x, g_light_cluster_count_y)), uint2(g_light_cluster_count_x - 1, g_light_cluster_count_y - 1));
+    uint slice          = (uint)clamp(floor(log(max(depth_view, g_camera_near)) * decal_slice_scale_bias_count.x + decal_slice_scale_bias_count.y), 0.0f, g_light_cluster_count_z - 1.0f);
+    uint cluster_index  = (slice * g_light_cluster_count_y + tile.y) * g_light_cluster_count_x + tile.x;
+    uint4 masks         = decal_masks[cluster_index / 2];
+    uint2 mask          = (cluster_index % 2) == 0 ? masks.xy : masks.zw;
+
+    // Go through the decals that reach the cluster, in order, so later ones go on top
+    [loop]
+    for (uint mask_index = 0; mask_index < 2; mask_index++)
+    {
+        uint bits = mask[mask_index];
+
+        [loop]
+        while (bits != 0)
+        {
+            uint decal_index = mask_index * 32 + firstbitlow(bits);
+            bits &= bits - 1;
+
+            // Into the unit box, projected along z
+            float3 position_box = mul(float4(position, 1.0f), decal_world_to_box[decal_index]).xyz;
+            [branch]
+            if (any(abs(position_box) > 0.5f))
+                continue;
+
+            float4 color = decal_color[decal_index];
+            float4 rect  = decal_atlas_rect[decal_index];
+            [branch]
+            if (rect.z != 0.0f)
+            {
+                // Stay half a texel inside the cell, so the neighbours don't bleed in
+                float2 uv           = float2(position_box.x + 0.5f, 0.5f - position_box.y);
+                float half_texel    = 0.5f / g_decal_atlas_size;
+                uv                  = clamp(rect.xy + uv * rect.zw, rect.xy + half_texel, rect.xy + rect.zw - half_texel);
+                float4 sample       = tex_decal_atlas.SampleLevel(sampler_bilinear_clamp, uv, 0);
+                color               *= float4(degamma(sample.rgb), sample.a);
+            }
+
+            albedo.rgb  = lerp(albedo.rgb, color.rgb, color.a);
+            roughness   = lerp(roughness, decal_roughness_metallic[decal_index].x, color.a);
+            metallic    = lerp(metallic, decal_roughness_metallic[decal_index].y, color.a);
+        }
+    }
+}
@@ -23,19 +23,99 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Common.hlsl"
 //====================
 
-Pixel_PosUv mainVS(Vertex_PosUv input)
+// Opaque objects only need positions, which models keep in a stream of their own.
+// Transparent ones also need the uv, compact vertices have it at another offset so they come in whole.
+// Skinned vertices come in whole too, for opaque objects as well, as their positions follow the bones.
+// Displaced vertices only need positions as well, they are drawn instanced (the instance carries where the patch is).
+#if POSITION_ONLY
+#define Vertex_Depth            Vertex_Pos
+#define Vertex_Depth_Instanced  Vertex_Pos_Instanced
+#elif COMPACT_VERTEX
+#define Vertex_Depth            Vertex_PosUvNorTanCompact
+#define Vertex_Depth_Instanced  Vertex_PosUvNorTanCompact_Instanced
+#elif SKINNED_VERTEX
+#define Vertex_Depth            Vertex_PosUvNorTanSkin
+#define Vertex_Depth_Instanced  Vertex_PosUvNorTanSkin_Instanced
+#else
+#define Vertex_Depth            Vertex_PosUv
+#define Vertex_Depth_Instanced  Vertex_PosUv_Instanced
+#endif
+
+#if LAYERED
+// All the slices of a light (cube faces or cascades) are drawn at once, the instance carries the world view projection of its slice
+// and the first element of the second matrix carries the slice (the next three carry the world position, which displaced vertices need)
+struct Pixel_PosUvSlice
+{
+    float4 position : SV_POSITION;
+    float2 uv       : TEXCOORD;
+    uint slice      : SV_RenderTargetArrayIndex;
+};
+
+Pixel_PosUvSlice mainVS(Vertex_Depth_Instanced input)
+{
+    Pixel_PosUvSlice output;
+
+    float4 position     = mul(vertex_position(input.position), vertex_skin(input));
+    vertex_displace(position, input.instance_wvp_previous[0].yzw); // the rest of that element carries the world position of the instance
+    output.position     = mul(position, instance_matrix(input.instance_transform));
+#if POSITION_ONLY
+    output.uv           = 0.0f;
+#else
+    output.uv           = input.uv;
+#endif
+    output.slice        = (uint)input.instance_wvp_previous[0].x;
+
+    return output;
+}
+#elif INSTANCED
+// The instance carries the world matrix, the object buffer carries the view projection of the light
+Pixel_PosUv mainVS(Vertex_Depth_Instanced input)
 {
     Pixel_PosUv output;
 
-    input.position.w    = 1.0f; 
-    output.position     = mul(input.position, g_object_transform);
+    float4x4 transform  = instance_matrix(input.instance_transform);
+    float4 position     = mul(vertex_position(input.position), vertex_skin(input));
+    vertex_displace(position, transform[3].xyz);
+    output.position     = mul(position, transform);
+    output.position     = mul(output.position, g_object_transform);
+#if POSITION_ONLY
+    output.uv           = 0.0f;
+#else
     output.uv           = input.uv;
+#endif
 
     return output;
 }
+#else
+Pixel_PosUv mainVS(Vertex_Depth input)
+{
+    Pixel_PosUv output;
+
+    output.position     = mul(mul(vertex_position(input.position), vertex_skin(input)), g_object_transform);
+#if POSITION_ONLY
+    output.uv           = 0.0f;
+#else
+    output.uv           = input.uv;
+#endif
 
+    return output;
+}
+#endif
+
+#if ALPHA_TEST
+// The depth pre-pass discards the pixels which the g-buffer discards (see GBuffer.hlsl), tex is the albedo and tex2 the mask (white without them)
+void mainPS(Pixel_PosUv input)
+{
+    float2 uv               = float2(input.uv.x * g_mat_tiling.x + g_mat_offset.x, input.uv.y * g_mat_tiling.y + g_mat_offset.y);
+    float mask_threshold    = 0.6f;
+
+    if (all(tex2.Sample(sampler_anisotropic_wrap, uv).rgb <= mask_threshold) || tex.Sample(sampler_anisotropic_wrap, uv).a <= mask_threshold)
+        discard;
+}
+#else
 float4 mainPS(Pixel_PosUv input) : SV_TARGET
 {
     float2 uv = float2(input.uv.x * g_mat_tiling.x + g_mat_offset.x, input.uv.y * g_mat_offset.y + g_mat_tiling.y);
     return degamma(tex.Sample(sampler_anisotropic_wrap, uv)) * g_mat_color;
 }
+#endif
@@ -0,0 +1,72 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========
+#include "Common.hlsl"
+//====================
+
+struct PixelOutputType
+{
+    float depth     : SV_Target0;
+    float4 normal   : SV_Target1;
+};
+
+// Downsamples the depth and the normals of the g-buffer, g_resolution is the resolution of the source.
+// Averaging would invent surfaces along the edges, so each pixel keeps one real sample out of the inner 2x2 texels of its footprint,
+// the closest and the farthest alternate in a checkerboard pattern so that both sides of an edge survive the downsampling.
+PixelOutputType mainPS(Pixel_PosUv input)
+{
+    float2 uv       = input.uv;
+    float4 offset   = g_texel_size.xyxy * float4(-0.5f, -0.5f, 0.5f, 0.5f);
+
+    float2 uvs[4] =
+    {
+        uv + offset.xy,
+        uv + offset.zy,
+        uv + offset.xw,
+        uv + offset.zw
+    };
+
+    float4 depths = float4
+    (
+        tex_depth.SampleLevel(sampler_point_clamp, uvs[0], 0).r,
+        tex_depth.SampleLevel(sampler_point_clamp, uvs[1], 0).r,
+        tex_depth.SampleLevel(sampler_point_clamp, uvs[2], 0).r,
+        tex_depth.SampleLevel(sampler_point_clamp, uvs[3], 0).r
+    );
+
+    // Checkerboard
+    int2 pixel      = int2(input.position.xy);
+    bool farthest   = ((pixel.x + pixel.y) & 1) != 0;
+
+    uint index = 0;
+    for (uint i = 1; i < 4; i++)
+    {
+        bool pick = farthest ? (depths[i] > depths[index]) : (depths[i] < depths[index]);
+        index = pick ? i : index;
+    }
+
+    PixelOutputType output;
+    output.depth    = depths[index];
+    output.normal   = tex_normal.SampleLevel(sampler_point_clamp, uvs[index], 0);
+
+    return output;
+}
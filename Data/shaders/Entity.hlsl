@@ -29,27 +29,51 @@ struct PixelInputType
     float2 uv           : TEXCOORD;
     float3 normal       : NORMAL;
     float3 positionWS   : POSITIONT_WS;
+#if INSTANCED
+    nointerpolation uint instance : INSTANCE_ID;
+#endif
 };
 
-PixelInputType mainVS(Vertex_PosUvNorTan input)
+#if INSTANCED
+// Every axis of the transform handle is an instance, its color is g_transform_axis_colors[instance]
+PixelInputType mainVS(Vertex_Mesh_Instanced input, uint instance_id : SV_InstanceID)
 {
     PixelInputType output;
 
-    input.position.w = 1.0f;
-    output.positionWS = mul(input.position, g_transform).xyz;
+    float4x4 transform  = instance_matrix(input.instance_transform);
+    output.positionWS   = mul(vertex_position(input.position), transform).xyz;
+    output.position     = mul(float4(output.positionWS, 1.0f), g_viewProjectionUnjittered);
+    output.normal       = mul(vertex_direction(input.normal), (float3x3)transform);
+    output.uv           = input.uv;
+    output.instance     = instance_id;
+
+    return output;
+}
+#else
+PixelInputType mainVS(Vertex_Mesh input)
+{
+    PixelInputType output;
+
+    float4x4 skin = vertex_skin(input);
+    output.positionWS = mul(mul(vertex_position(input.position), skin), g_transform).xyz;
     output.position = mul(float4(output.positionWS, 1.0f), g_viewProjectionUnjittered);
-    output.normal = mul(input.normal, (float3x3)g_transform);
+    output.normal = mul(mul(vertex_direction(input.normal), (float3x3)skin), (float3x3)g_transform);
     output.uv = input.uv;
 
     return output;
 }
+#endif
 
 float4 mainPS(PixelInputType input) : SV_TARGET
 {
 	float4 color = 0.0f;
 
 #ifdef TRANSFORM
+#if INSTANCED
+    float3 color_diffuse = g_transform_axis_colors[input.instance].xyz;
+#else
     float3 color_diffuse = g_transform_axis.xyz;
+#endif
     float3 color_ambient = color_diffuse * 0.3f;
     float3 color_specular = 1.0f;
     float3 lightPos = float3(10.0f, 10.0f, 10.0f);
@@ -79,10 +103,10 @@ float4 mainPS(PixelInputType input) : SV_TARGET
     float halfScaleCeil     = ceil(scale * 0.5f);
 
     // Sample X pattern
-    float3 normal0 = tex_normal.Sample(sampler_point_clamp, uv - g_texel_size * halfScaleFloor).rgb;                                             // bottom left
-    float3 normal1 = tex_normal.Sample(sampler_point_clamp, uv + g_texel_size * halfScaleCeil).rgb;                                              // top right
-    float3 normal2 = tex_normal.Sample(sampler_point_clamp, uv + float2(g_texel_size.x * halfScaleCeil, -g_texel_size.y * halfScaleFloor)).rgb;  // bottom right
-    float3 normal3 = tex_normal.Sample(sampler_point_clamp, uv + float2(-g_texel_size.x * halfScaleFloor, g_texel_size.y * halfScaleCeil)).rgb;  // top left
+    float3 normal0 = gbuffer_normal_decode(tex_normal.Sample(sampler_point_clamp, uv - g_texel_size * halfScaleFloor));                                             // bottom left
+    float3 normal1 = gbuffer_normal_decode(tex_normal.Sample(sampler_point_clamp, uv + g_texel_size * halfScaleCeil));                                              // top right
+    float3 normal2 = gbuffer_normal_decode(tex_normal.Sample(sampler_point_clamp, uv + float2(g_texel_size.x * halfScaleCeil, -g_texel_size.y * halfScaleFloor)));  // bottom right
+    float3 normal3 = gbuffer_normal_decode(tex_normal.Sample(sampler_point_clamp, uv + float2(-g_texel_size.x * halfScaleFloor, g_texel_size.y * halfScaleCeil)));  // top left
 
     // Compute edge normal
     float3 normalFiniteDifference0 = normal1 - normal0;
@@ -91,7 +115,7 @@ float4 mainPS(PixelInputType input) : SV_TARGET
 
     // Compute view direction bias
     float3 view         = get_view_direction(uv);
-    float3 normal       = tex_normal.Sample(sampler_point_clamp, uv).rgb;
+    float3 normal       = gbuffer_normal_decode(tex_normal.Sample(sampler_point_clamp, uv));
     float view_dir_bias = dot(view, normal) * 0.5f + 0.5f;
 
     if (edge_normal * view_dir_bias < normal_threshold)
@@ -0,0 +1,116 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========
+#include "Common.hlsl"
+//====================
+
+// The prefiltered environment is a texture array with the same spherical mapping as the environment. The first slices are the
+// specular lobes for increasing roughness, the last slice is the irradiance. Each slice renders once, when the environment changes.
+
+static const uint sample_count_specular = 64;
+static const uint sample_count_diffuse  = 128;
+
+// Filtered importance sampling, each sample reads the mip whose texels cover the solid angle of the sample
+// GPU Gems 3, Chapter 20. GPU-Based Importance Sampling
+float get_mip(float pdf, uint sample_count, float2 size)
+{
+    float solid_angle_texel     = (4.0f * PI) / (size.x * size.y);
+    float solid_angle_sample    = 1.0f / (float(sample_count) * pdf + FLT_MIN);
+    
+    return max(0.5f * log2(solid_angle_sample / solid_angle_texel) + 1.0f, 0.0f);
+}
+
+#if PROJECT_FACES
+// The faces of a reflection probe bake look along these directions, with these up vectors (must match the renderer)
+static const float3 face_forward[6] = { float3(1.0f, 0.0f, 0.0f), float3(-1.0f, 0.0f, 0.0f), float3(0.0f, 1.0f, 0.0f), float3(0.0f, -1.0f, 0.0f), float3(0.0f, 0.0f, 1.0f), float3(0.0f, 0.0f, -1.0f) };
+static const float3 face_up[6]      = { float3(0.0f, 1.0f, 0.0f), float3(0.0f, 1.0f, 0.0f), float3(0.0f, 0.0f, -1.0f), float3(0.0f, 0.0f, 1.0f), float3(0.0f, 1.0f, 0.0f), float3(0.0f, 1.0f, 0.0f) };
+
+// The six faces into the spherical mapping of the environment, so that the probe is prefiltered and sampled like it (what the faces didn't draw is the environment)
+float4 mainPS(Pixel_PosUv input) : SV_TARGET
+{
+    float3 direction = sphere_uv_direction(input.uv);
+
+    // The face along the largest axis
+    float3 a    = abs(direction);
+    uint face   = (a.x >= a.y && a.x >= a.z) ? (direction.x > 0.0f ? 0 : 1) : ((a.y >= a.z) ? (direction.y > 0.0f ? 2 : 3) : (direction.z > 0.0f ? 4 : 5));
+
+    // Into the face's view, the axes as Matrix::CreateLookAtLH() builds them
+    float3 z    = face_forward[face];
+    float3 x    = normalize(cross(face_up[face], z));
+    float3 y    = cross(z, x);
+    float2 ndc  = float2(dot(direction, x), dot(direction, y)) / dot(direction, z);
+    float2 uv   = float2(ndc.x * 0.5f + 0.5f, 0.5f - ndc.y * 0.5f);
+
+    float4 color = tex_reflection_probe_faces.SampleLevel(sampler_bilinear_clamp, float3(uv, face), 0.0f);
+    color.rgb   += tex_environment.SampleLevel(sampler_bilinear_clamp, input.uv, 0.0f).rgb * (1.0f - color.a);
+
+    return float4(color.rgb, 1.0f);
+}
+#else
+float4 mainPS(Pixel_PosUv input) : SV_TARGET
+{
+    float2 size;
+    float mip_count;
+    tex_environment.GetDimensions(0, size.x, size.y, mip_count);
+    
+    float3 n        = sphere_uv_direction(input.uv);
+    float3 color    = 0.0f;
+    
+#if DIFFUSE
+    // Cosine weighted, the average radiance is the irradiance over pi, which is what the lambertian diffuse multiplies with the albedo
+    for (uint i = 0; i < sample_count_diffuse; i++)
+    {
+        float3 l    = ImportanceSampleCosine(Hammersley(i, sample_count_diffuse), n);
+        float pdf   = saturate(dot(n, l)) * INV_PI;
+        float mip   = min(get_mip(pdf, sample_count_diffuse, size), mip_count - 1.0f);
+        color       += tex_environment.SampleLevel(sampler_trilinear_clamp, direction_sphere_uv(l), mip).rgb;
+    }
+    color /= float(sample_count_diffuse);
+#else
+    // The view direction is assumed to be the normal (split sum approximation), the lobe is weighted by n dot l
+    float roughness = g_mat_roughness;
+    float a2        = pow(roughness, 4.0f);
+    float weight    = 0.0f;
+    for (uint i = 0; i < sample_count_specular; i++)
+    {
+        float3 h        = ImportanceSampleGGX(Hammersley(i, sample_count_specular), n, roughness);
+        float3 l        = normalize(2.0f * dot(n, h) * h - n);
+        float n_dot_l   = saturate(dot(n, l));
+        
+        if (n_dot_l > 0.0f)
+        {
+            float n_dot_h   = saturate(dot(n, h));
+            float d         = n_dot_h * n_dot_h * (a2 - 1.0f) + 1.0f;
+            float pdf       = (a2 / (PI * d * d)) * 0.25f; // D * n_dot_h / (4 * v_dot_h), with v = n
+            float mip       = min(get_mip(pdf, sample_count_specular, size), mip_count - 1.0f);
+            
+            color   += tex_environment.SampleLevel(sampler_trilinear_clamp, direction_sphere_uv(l), mip).rgb * n_dot_l;
+            weight  += n_dot_l;
+        }
+    }
+    color /= max(weight, FLT_MIN);
+#endif
+
+    return float4(color, 1.0f);
+}
+#endif
@@ -38,11 +38,18 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
 {
     float4 color = float4(0.0f, 0.0f, 0.0f, 1.0f);
     
+#if SDF
+    // The atlas holds a distance field, 0.5 is the edge, so the edge stays sharp at any scale
+    float distance  = tex_font_atlas.Sample(sampler_bilinear_wrap, input.uv).r;
+    float width     = max(fwidth(distance), 0.0001f);
+    color           = smoothstep(0.5f - width, 0.5f + width, distance);
+#else
     // Sample text from texture atlas
     color.r = tex_font_atlas.Sample(sampler_bilinear_wrap, input.uv).r;
     color.g = color.r;
     color.b = color.r;
     color.a = color.r;
+#endif
     
     // Color it
     color *= g_color;
@@ -0,0 +1,89 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SPARTAN_FROXEL
+#define SPARTAN_FROXEL
+
+//= INCLUDES ======
+#include "Common.hlsl"
+//=================
+
+// The froxels (frustum voxels) of the volumetric lighting, the camera frustum cut in screen space tiles and exponential depth slices.
+// There are no 3D textures, so the slices are laid out as tiles of a 2D atlas, row by row.
+static const uint g_froxel_count_x          = 160; // must match the renderer
+static const uint g_froxel_count_y          = 90;  // must match the renderer
+static const uint g_froxel_count_z          = 64;  // must match the renderer
+static const uint g_froxel_atlas_tiles_x    = 8;   // slices per atlas row
+static const float g_froxel_depth_max       = 128.0f; // view depth the last slice ends at (or the far plane, if closer)
+
+inline float froxel_depth_far()
+{
+    return min(g_camera_far, g_froxel_depth_max);
+}
+
+// View depth to a continuous slice coordinate, slice i spans [i, i + 1)
+inline float froxel_depth_to_slice(float depth)
+{
+    return log(max(depth, g_camera_near) / g_camera_near) / log(froxel_depth_far() / g_camera_near) * g_froxel_count_z;
+}
+
+inline float froxel_slice_to_depth(float slice)
+{
+    return g_camera_near * pow(froxel_depth_far() / g_camera_near, slice / g_froxel_count_z);
+}
+
+// The froxel an atlas pixel belongs to
+inline uint3 froxel_from_atlas(uint2 pixel)
+{
+    uint2 tile = pixel / uint2(g_froxel_count_x, g_froxel_count_y);
+    return uint3(pixel % uint2(g_froxel_count_x, g_froxel_count_y), tile.y * g_froxel_atlas_tiles_x + tile.x);
+}
+
+inline uint2 froxel_to_atlas(uint3 froxel)
+{
+    uint2 tile = uint2(froxel.z % g_froxel_atlas_tiles_x, froxel.z / g_froxel_atlas_tiles_x);
+    return tile * uint2(g_froxel_count_x, g_froxel_count_y) + froxel.xy;
+}
+
+// World position at a screen uv and view depth
+inline float3 froxel_position(float2 uv, float depth)
+{
+    float3 view_direction = get_view_direction(0.5f, uv);
+    return g_camera_position + view_direction * (depth / dot(view_direction, g_camera_direction));
+}
+
+// Samples the atlas at a screen uv and view depth, filtering between the two nearest slices (the bilinear filter stays within a slice's tile)
+inline float3 froxel_sample(Texture2D tex_atlas, float2 uv, float depth)
+{
+    static const float2 atlas_size  = float2(g_froxel_count_x * g_froxel_atlas_tiles_x, g_froxel_count_y * (g_froxel_count_z / g_froxel_atlas_tiles_x));
+    static const float2 tile_size   = float2(g_froxel_count_x, g_froxel_count_y);
+
+    float slice         = clamp(froxel_depth_to_slice(depth) - 0.5f, 0.0f, g_froxel_count_z - 1.0f);
+    uint slice_front    = (uint)slice;
+    uint slice_back     = min(slice_front + 1, g_froxel_count_z - 1);
+    float2 texel        = clamp(uv * tile_size, 0.5f, tile_size - 0.5f);
+
+    float3 front    = tex_atlas.SampleLevel(sampler_bilinear_clamp, (froxel_to_atlas(uint3(0, 0, slice_front)) + texel) / atlas_size, 0).rgb;
+    float3 back     = tex_atlas.SampleLevel(sampler_bilinear_clamp, (froxel_to_atlas(uint3(0, 0, slice_back)) + texel) / atlas_size, 0).rgb;
+    return lerp(front, back, frac(slice));
+}
+
+#endif // SPARTAN_FROXEL
@@ -22,6 +22,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==================
 #include "Common.hlsl"
 #include "ParallaxMapping.hlsl"
+#if FORWARD
+#include "LightAccumulation.hlsl"
+#include "ShadowMapping.hlsl"
+#else
+#include "Decal.hlsl"
+#endif
 //=============================
 
 struct PixelInputType
@@ -32,8 +38,24 @@ struct PixelInputType
     float3 tangent              : TANGENT;
     float4 position_ss_current  : SCREEN_POS;
     float4 position_ss_previous : SCREEN_POS_PREVIOUS;
+    float3 position_world       : POSITION_WORLD;
 };
 
+#if FORWARD
+#if TRANSPARENT_OIT
+// Weighted blended order independent transparency [McGuire 2013, "Weighted Blended Order-Independent Transparency"]
+struct PixelOutputType
+{
+    float4 accumulation : SV_Target0; // rgb is the weighted color (added), a is the revealage (multiplied)
+    float weight        : SV_Target1; // the sum of the weights
+};
+#else
+struct PixelOutputType
+{
+    float4 color : SV_Target0;
+};
+#endif
+#else
 struct PixelOutputType
 {
     float4 albedo   : SV_Target0;
@@ -41,18 +63,46 @@ struct PixelOutputType
     float4 material : SV_Target2;
     float2 velocity : SV_Target3;
 };
+#endif
+
+// Small material textures are packed into the slices of a shared array by the renderer, a negative slice means the texture is bound on its own.
+// The slices have no mips, the textures which qualify are small enough for that not to matter much.
+float4 sample_material(Texture2D tex, float slice, float2 uv)
+{
+    if (slice >= 0.0f)
+        return tex_material_array.Sample(sampler_anisotropic_wrap, float3(uv, slice));
+
+    return tex.Sample(sampler_anisotropic_wrap, uv);
+}
 
-PixelInputType mainVS(Vertex_PosUvNorTan input)
+#if INSTANCED
+PixelInputType mainVS(Vertex_Mesh_Instanced input)
 {
     PixelInputType output;
+
+    float4x4 transform          = instance_matrix(input.instance_transform);
+    float4x4 wvp_previous       = instance_matrix(input.instance_wvp_previous);
+#else
+PixelInputType mainVS(Vertex_Mesh input)
+{
+    PixelInputType output;
+
+    float4x4 transform          = g_object_transform;
+    float4x4 wvp_previous       = g_object_wvp_previous;
+#endif
     
-    input.position.w            = 1.0f;     
-    output.position_ss_previous = mul(input.position, g_object_wvp_previous);
-    output.position             = mul(input.position, g_object_transform);
+    float4x4 skin               = vertex_skin(input);
+    float4 position             = mul(vertex_position(input.position), skin);
+    float3 normal               = mul(vertex_direction(input.normal), (float3x3)skin);
+    float3 tangent              = mul(vertex_direction(input.tangent), (float3x3)skin);
+    vertex_displace(position, normal, tangent, transform[3].xyz);
+    output.position_ss_previous = mul(position, wvp_previous);
+    output.position             = mul(position, transform);
+    output.position_world       = output.position.xyz;
     output.position             = mul(output.position, g_viewProjection);
     output.position_ss_current  = output.position;
-    output.normal               = normalize(mul(input.normal, (float3x3)g_object_transform)).xyz;   
-    output.tangent              = normalize(mul(input.tangent, (float3x3)g_object_transform)).xyz;
+    output.normal               = normalize(mul(normal, (float3x3)transform)).xyz;   
+    output.tangent              = normalize(mul(tangent, (float3x3)transform)).xyz;
     output.uv                   = input.uv;
     
     return output;
@@ -60,7 +110,7 @@ PixelInputType mainVS(Vertex_PosUvNorTan input)
 
 PixelOutputType mainPS(PixelInputType input)
 {
-    PixelOutputType g_buffer;
+    PixelOutputType output;
 
     float2 texCoords    = float2(input.uv.x * g_mat_tiling.x + g_mat_offset.x, input.uv.y * g_mat_tiling.y + g_mat_offset.y);
     float4 albedo       = g_mat_color;
@@ -69,7 +119,6 @@ PixelOutputType mainPS(PixelInputType input)
     float3 normal       = input.normal.xyz;
     float emission      = 0.0f;
     float occlusion     = 1.0f;
-    float material_id   = g_mat_id / float(65535);
     
     //= VELOCITY ================================================================================
     float2 position_current     = (input.position_ss_current.xy / input.position_ss_current.w);
@@ -93,49 +142,155 @@ PixelOutputType mainPS(PixelInputType input)
     float mask_threshold = 0.6f;
     
     #if MASK_MAP
-        float3 maskSample = tex_material_mask.Sample(sampler_anisotropic_wrap, texCoords).rgb;
+        float3 maskSample = sample_material(tex_material_mask, g_mat_texture_slices.w, texCoords).rgb;
         if (maskSample.r <= mask_threshold && maskSample.g <= mask_threshold && maskSample.b <= mask_threshold)
             discard;
     #endif
 
     #if ALBEDO_MAP
         float4 albedo_sample = tex_material_albedo.Sample(sampler_anisotropic_wrap, texCoords);
+        #if !FORWARD // blended, so the alpha is kept instead
         if (albedo_sample.a <= mask_threshold)
             discard;
+        #endif
 
         albedo_sample.rgb = degamma(albedo_sample.rgb);
         albedo *= albedo_sample;
     #endif
     
     #if ROUGHNESS_MAP
-        roughness *= tex_material_roughness.Sample(sampler_anisotropic_wrap, texCoords).r;
+        roughness *= sample_material(tex_material_roughness, g_mat_texture_slices.x, texCoords).r;
     #endif
     
     #if METALLIC_MAP
-        metallic *= tex_material_metallic.Sample(sampler_anisotropic_wrap, texCoords).r;
+        metallic *= sample_material(tex_material_metallic, g_mat_texture_slices.y, texCoords).r;
     #endif
     
     #if NORMAL_MAP
-        // Get tangent space normal and apply intensity
-        float3 tangent_normal   = normalize(unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, texCoords).rgb));
+        // Get tangent space normal and apply intensity, z is reconstructed as normal maps can be stored as two channels (BC5)
+        float2 tangent_xy       = unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, texCoords).rg);
+        float3 tangent_normal   = normalize(float3(tangent_xy, sqrt(saturate(1.0f - dot(tangent_xy, tangent_xy)))));
         float normal_intensity  = clamp(g_mat_normal, 0.012f, g_mat_normal);
         tangent_normal.xy       *= saturate(normal_intensity);
         normal                  = normalize(mul(tangent_normal, TBN).xyz); // Transform to world space
     #endif
 
     #if OCCLUSION_MAP
-        occlusion = tex_material_occlusion.Sample(sampler_anisotropic_wrap, texCoords).r;
+        occlusion = sample_material(tex_material_occlusion, g_mat_texture_slices.z, texCoords).r;
     #endif
     
     #if EMISSION_MAP
         emission = tex_material_emission.Sample(sampler_anisotropic_wrap, texCoords).r;
     #endif
 
-    // Write to G-Buffer
-    g_buffer.albedo     = albedo;
-    g_buffer.normal     = float4(normal_encode(normal), material_id);
-    g_buffer.material   = float4(roughness, metallic, emission, occlusion);
-    g_buffer.velocity   = velocity;
+    #if FORWARD
+    {
+        // Fill surface struct
+        Surface surface;
+        surface.uv                      = input.position.xy / g_resolution;
+        surface.depth                   = input.position.z;
+        surface.position                = input.position_world;
+        surface.normal                  = normal;
+        surface.camera_to_pixel         = normalize(surface.position - g_camera_position.xyz);
+        surface.camera_to_pixel_length  = length(surface.position - g_camera_position.xyz);
 
-    return g_buffer;
+        // Create material
+        int mat_id = (int)g_mat_id;
+        Material material;
+        material.albedo                 = albedo.rgb;
+        material.roughness              = roughness;
+        material.metallic               = metallic;
+        material.emissive               = emission;
+        material.clearcoat              = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].x;
+        material.clearcoat_roughness    = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].y;
+        material.anisotropic            = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].z;
+        material.anisotropic_rotation   = mat_clearcoat_clearcoatRough_aniso_anisoRot[mat_id].w;
+        material.sheen                  = mat_sheen_sheenTint_pad[mat_id].x;
+        material.sheen_tint             = mat_sheen_sheenTint_pad[mat_id].y;
+        material.occlusion              = occlusion;
+        material.F0                     = lerp(0.04f, material.albedo, material.metallic);
+        material.is_transparent         = true;
+        material.is_sky                 = false;
+
+        float3 light_diffuse    = 0.0f;
+        float3 light_specular   = 0.0f;
+        float3 multi_bounce_ao  = MultiBounceAO(material.occlusion, material.albedo);
+
+        // Directional light, g_light_index points to it when g_color.x is set and g_color.y says if it has a shadow map
+        [branch]
+        if (g_color.x != 0.0f)
+        {
+            Light light;
+            light.index             = g_light_index;
+            light.color             = light_color_intensity[light.index].rgb * light_color_intensity[light.index].a;
+            light.position          = light_position_range[light.index].xyz;
+            light.range             = light_position_range[light.index].w;
+            light.angle             = light_direction_angle[light.index].w;
+            light.bias              = light_bias_normal_bias[light.index].x;
+            light.normal_bias       = light_bias_normal_bias[light.index].y;
+            light.distance_to_pixel = length(surface.position - light.position);
+            light.array_size        = 4;
+            light.direction         = light_direction_angle[light.index].xyz;
+            light.attenuation       = 1.0f;
+
+            float4 shadow = 1.0f;
+            [branch]
+            if (g_color.y != 0.0f)
+            {
+                shadow = Shadow_Map(surface, light, material.is_transparent);
+            }
+            light.color *= shadow.rgb * shadow.a * multi_bounce_ao;
+
+            AccumulateLight(surface, material, light, light_diffuse, light_specular);
+        }
+
+        // Point and spot lights without shadow maps, through the clusters of the opaque light pass (which are binned for the main camera, so views set g_color.z to skip them)
+        [branch]
+        if (g_color.z == 0.0f)
+        {
+            AccumulateLightsClustered(surface, material, multi_bounce_ao, light_diffuse, light_specular);
+        }
+
+        // Light - Image based
+        float3 diffuse_energy       = 1.0f;
+        float3 reflective_energy    = 1.0f;
+        float3 light_ibl_specular   = Brdf_Specular_Ibl(material, normal, surface.camera_to_pixel, tex_environment, tex_environment_prefiltered, tex_lutIbl, diffuse_energy, reflective_energy);
+        float3 light_ibl_diffuse    = Brdf_Diffuse_Ibl(material, normal, tex_environment_prefiltered) * diffuse_energy;
+
+        // Light - Ambient
+        float3 light_ambient = saturate(g_directional_light_intensity * 0.01f) * multi_bounce_ao;
+
+        // Light - Emissive
+        float3 light_emissive = material.emissive * material.albedo * 50.0f;
+
+        float3 radiance = light_diffuse + light_specular + (light_ibl_diffuse + light_ibl_specular) * light_ambient + light_emissive;
+
+        #if TRANSPARENT_OIT
+        // Nearer and more opaque surfaces weigh more, the view depth is scaled so that the weight doesn't run out of half float range
+        float depth_view        = mul(float4(surface.position, 1.0f), g_view).z;
+        float weight            = albedo.a * clamp(0.03f / (0.00001f + pow(depth_view / 200.0f, 4.0f)), 0.01f, 3000.0f);
+        output.accumulation     = float4(saturate_16(radiance * weight), albedo.a);
+        output.weight           = weight;
+        #else
+        output.color            = float4(radiance, albedo.a);
+        #endif
+    }
+    #else
+    {
+        // Decals, in the clusters of this frame
+        [branch]
+        if (decal_slice_scale_bias_count.z != 0.0f)
+        {
+            ApplyDecals(input.position_world, input.position.xy / g_resolution, albedo, roughness, metallic);
+        }
+
+        // Write to G-Buffer
+        output.albedo     = albedo;
+        output.normal     = gbuffer_normal_encode(normal, g_mat_id);
+        output.material   = float4(roughness, metallic, emission, occlusion);
+        output.velocity   = velocity;
+    }
+    #endif
+
+    return output;
 }
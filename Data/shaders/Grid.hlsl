@@ -0,0 +1,70 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// = INCLUDES ========
+#include "Common.hlsl"
+//====================
+
+// An infinite grid, the lines are anti-aliased analytically and fade out with the distance from the camera
+static const float grid_major_spacing   = 10.0f;
+static const float grid_fade_start      = 0.25f; // fraction of the grid's extent
+static const float grid_fade_end        = 1.0f;
+
+struct Pixel_Grid
+{
+    float4 position         : SV_POSITION;
+    float3 position_world   : POSITION_WORLD;
+};
+
+Pixel_Grid mainVS(Vertex_Pos input)
+{
+    Pixel_Grid output;
+
+    input.position.w        = 1.0f;
+    output.position_world   = mul(input.position, g_transform).xyz;
+    output.position         = mul(float4(output.position_world, 1.0f), g_viewProjectionUnjittered);
+
+    return output;
+}
+
+// Coverage of the lines at every multiple of spacing, they stay a pixel wide at any distance
+float grid_lines(float2 position, float spacing)
+{
+    float2 coord        = position / spacing;
+    float2 derivative   = max(fwidth(coord), 0.0001f);
+    float2 grid         = abs(frac(coord - 0.5f) - 0.5f) / derivative;
+    return 1.0f - saturate(min(grid.x, grid.y));
+}
+
+float4 mainPS(Pixel_Grid input) : SV_TARGET
+{
+    float minor = grid_lines(input.position_world.xz, 1.0f);
+    float major = grid_lines(input.position_world.xz, grid_major_spacing);
+
+    // Fade with the distance (g_color.a carries the extent of the grid)
+    float extent    = g_color.a;
+    float distance  = length(input.position_world.xz - g_camera_position.xz);
+    float fade      = 1.0f - smoothstep(extent * grid_fade_start, extent * grid_fade_end, distance);
+
+    float alpha = max(minor * 0.5f, major) * fade;
+    return float4(g_color.rgb, alpha);
+}
@@ -0,0 +1,167 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========
+#include "Common.hlsl"
+//====================
+
+// An impostor is a model rendered from a grid of directions over the upper hemisphere (hemi-octahedral, like the frames of the atlas), into an albedo
+// atlas and a normal atlas (in the space of the model). Far away, a quad per instance stands in for the model, it faces the frame whose direction is
+// the closest to the camera's and writes that frame to the g-buffer. The center and the radius of the model's bounds come with the object buffer.
+
+static const float impostor_frames = 8.0f; // along a side of the atlas, must match the renderer
+
+// Hemi-octahedral mapping of the directions above the horizon to [0, 1]
+float2 impostor_direction_encode(float3 direction)
+{
+    direction.y     = max(direction.y, 0.0f);
+    direction       /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+    return float2(direction.x + direction.z, direction.x - direction.z) * 0.5f + 0.5f;
+}
+
+float3 impostor_direction_decode(float2 uv)
+{
+    uv = uv * 2.0f - 1.0f;
+    float3 direction = float3((uv.x + uv.y) * 0.5f, 0.0f, (uv.x - uv.y) * 0.5f);
+    direction.y = 1.0f - abs(direction.x) - abs(direction.z);
+    return normalize(direction);
+}
+
+#if BAKE
+
+struct PixelInputType
+{
+    float4 position : SV_POSITION;
+    float2 uv       : TEXCOORD;
+    float3 normal   : NORMAL;
+};
+
+struct PixelOutputType
+{
+    float4 albedo : SV_Target0;
+    float4 normal : SV_Target1;
+};
+
+// The object buffer carries the view projection of the frame which is being rendered, in the space of the model
+PixelInputType mainVS(Vertex_Mesh input)
+{
+    PixelInputType output;
+    output.position = mul(vertex_position(input.position), g_object_wvp_current);
+    output.normal   = vertex_direction(input.normal);
+    output.uv       = input.uv;
+
+    return output;
+}
+
+PixelOutputType mainPS(PixelInputType input)
+{
+    PixelOutputType output;
+
+    float2 uv       = input.uv * g_mat_tiling + g_mat_offset;
+    float4 albedo   = g_mat_color;
+
+    // Materials without an albedo map come with a white one
+    float4 albedo_sample = tex_material_albedo.Sample(sampler_anisotropic_wrap, uv);
+    if (albedo_sample.a <= 0.6f)
+        discard;
+    albedo.rgb *= degamma(albedo_sample.rgb);
+
+    // Whatever the alpha, the atlas is covered where the model is
+    output.albedo = float4(albedo.rgb, 1.0f);
+    output.normal = float4(normalize(input.normal) * 0.5f + 0.5f, 1.0f);
+
+    return output;
+}
+
+#else
+
+struct PixelInputType
+{
+    float4 position             : SV_POSITION;
+    float2 uv                   : TEXCOORD;
+    float3x3 rotation           : ROTATION; // from the space of the model to the world
+    float4 position_ss_current  : SCREEN_POS;
+    float4 position_ss_previous : SCREEN_POS_PREVIOUS;
+};
+
+struct PixelOutputType
+{
+    float4 albedo   : SV_Target0;
+    float4 normal   : SV_Target1;
+    float4 material : SV_Target2;
+    float2 velocity : SV_Target3;
+};
+
+PixelInputType mainVS(Vertex_PosUv_Instanced input)
+{
+    PixelInputType output;
+
+    float4x4 transform      = instance_matrix(input.instance_transform);
+    float4x4 wvp_previous   = instance_matrix(input.instance_wvp_previous);
+    float3 center           = g_object_impostor_center_radius.xyz;
+    float radius            = g_object_impostor_center_radius.w;
+
+    // The direction to the camera, in the space of the model (the scale is taken out of the rotation)
+    float3x3 rotation       = float3x3(normalize(transform[0].xyz), normalize(transform[1].xyz), normalize(transform[2].xyz));
+    float3 center_world     = mul(float4(center, 1.0f), transform).xyz;
+    float3 to_camera        = normalize(mul(rotation, g_camera_position - center_world)); // transposed, so it's the inverse
+
+    // The closest frame, and the plane it was rendered on
+    float2 frame            = min(floor(impostor_direction_encode(to_camera) * impostor_frames), impostor_frames - 1.0f);
+    float3 direction        = impostor_direction_decode((frame + 0.5f) / impostor_frames);
+    float3 up_frame         = abs(direction.y) > 0.99f ? float3(0.0f, 0.0f, 1.0f) : float3(0.0f, 1.0f, 0.0f);
+    float3 right            = normalize(cross(up_frame, -direction));
+    float3 up               = cross(-direction, right);
+    float4 position         = float4(center + (right * input.position.x + up * input.position.y) * radius, 1.0f);
+
+    output.position_ss_previous = mul(position, wvp_previous);
+    output.position             = mul(mul(position, transform), g_viewProjection);
+    output.position_ss_current  = output.position;
+    output.rotation             = rotation;
+    output.uv                   = (frame + input.uv) / impostor_frames;
+
+    return output;
+}
+
+PixelOutputType mainPS(PixelInputType input)
+{
+    PixelOutputType output;
+
+    float4 albedo = tex_impostor_albedo.Sample(sampler_bilinear_clamp, input.uv);
+    if (albedo.a <= 0.5f)
+        discard;
+
+    float3 normal = tex_impostor_normal.Sample(sampler_bilinear_clamp, input.uv).xyz * 2.0f - 1.0f;
+    normal        = normalize(mul(normal, input.rotation));
+
+    float2 position_current     = input.position_ss_current.xy / input.position_ss_current.w;
+    float2 position_previous    = input.position_ss_previous.xy / input.position_ss_previous.w;
+    float2 velocity             = (position_current - position_previous - g_taa_jitter_offset) * float2(0.5f, -0.5f);
+
+    output.albedo   = float4(albedo.rgb, 1.0f); // the material's color is baked in
+    output.normal   = gbuffer_normal_encode(normal, g_mat_id);
+    output.material = float4(g_mat_roughness, g_mat_metallic, 0.0f, 1.0f);
+    output.velocity = velocity;
+
+    return output;
+}
+
+#endif
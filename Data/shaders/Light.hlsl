@@ -20,16 +20,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 //= INCLUDES =====================      
-#include "BRDF.hlsl"              
+#include "LightAccumulation.hlsl"
 #include "ShadowMapping.hlsl"
-#include "VolumetricLighting.hlsl"
 //================================
 
 struct PixelOutputType
 {
     float3 diffuse      : SV_Target0;
     float3 specular     : SV_Target1;
-    float3 volumetric   : SV_Target2;
 };
 
 PixelOutputType mainPS(Pixel_PosUv input)
@@ -37,7 +35,6 @@ PixelOutputType mainPS(Pixel_PosUv input)
     PixelOutputType light_out;
     light_out.diffuse       = 0.0f;
     light_out.specular      = 0.0f;
-    light_out.volumetric    = 0.0f;
 
     // Sample textures
     float4 sample_albedo    = tex_albedo.Sample(sampler_point_clamp, input.uv);
@@ -46,7 +43,7 @@ PixelOutputType mainPS(Pixel_PosUv input)
     float4 sample_hbao      = tex_hbao.Sample(sampler_point_clamp, input.uv);
 
     // Post-process samples
-    int mat_id      = round(sample_normal.a * 65535);
+    int mat_id      = gbuffer_material_id(sample_normal);
     float occlusion = sample_material.a;
     
     // Fill surface struct
@@ -54,7 +51,7 @@ PixelOutputType mainPS(Pixel_PosUv input)
     surface.uv                      = input.uv;
     surface.depth                   = tex_depth.Sample(sampler_point_clamp, surface.uv).r;
     surface.position                = get_position(surface.depth, surface.uv);
-    surface.normal                  = normal_decode(sample_normal.xyz);
+    surface.normal                  = gbuffer_normal_decode(sample_normal);
     surface.camera_to_pixel         = normalize(surface.position - g_camera_position.xyz);
     surface.camera_to_pixel_length  = length(surface.position - g_camera_position.xyz);
 
@@ -77,135 +74,81 @@ PixelOutputType mainPS(Pixel_PosUv input)
         material.is_sky                 = mat_id == 0;
     }
 
-    // Fill light struct
-    float light_intensity = intensity_range_angle_bias.x;
-    
-    Light light;
-    light.color             = color.xyz * light_intensity;
-    light.position          = position.xyz;
-    light.range             = intensity_range_angle_bias.y;
-    light.angle             = intensity_range_angle_bias.z;
-    light.bias              = intensity_range_angle_bias.w;
-    light.normal_bias       = normal_bias;
-    light.distance_to_pixel = length(surface.position - light.position);
-    #if DIRECTIONAL
-    light.array_size    = 4;
-    light.direction     = direction.xyz; 
-    light.attenuation   = 1.0f;
-    #elif POINT
-    light.array_size    = 1;
-    light.direction     = normalize(surface.position - light.position);
-    light.attenuation   = saturate(1.0f - (light.distance_to_pixel / light.range)); light.attenuation *= light.attenuation;    
-    #elif SPOT
-    light.array_size    = 1;
-    light.direction     = normalize(surface.position - light.position);
-    float cutoffAngle   = 1.0f - light.angle;
-    float theta         = dot(direction.xyz, light.direction);
-    float epsilon       = cutoffAngle - cutoffAngle * 0.9f;
-    light.attenuation   = saturate((theta - cutoffAngle) / epsilon); // attenuate when approaching the outer cone
-    light.attenuation   *= saturate(1.0f - light.distance_to_pixel / light.range); light.attenuation *= light.attenuation;
-    #endif
-    light.color *= light.attenuation;
-    
-    // Shadow 
+    #if CLUSTERED
     {
-        float4 shadow = 1.0f;
-        
-        // Shadow mapping
-        #if SHADOWS
-        {
-            shadow = Shadow_Map(surface, light, material.is_transparent);
+        // None of these lights have shadows, so ambient occlusion is all that modulates them
+        float3 multi_bounce_ao = MultiBounceAO(material.occlusion, sample_albedo.rgb);
 
-            // Volumetric lighting (requires shadow maps)
-            #if VOLUMETRIC
-            {
-                light_out.volumetric.rgb = VolumetricLighting(surface, light);
-            }
-            #endif
-        }
-        #endif
-        
-        // Screen space shadows
-        #if SHADOWS_SCREEN_SPACE
+        [branch]
+        if (!material.is_sky)
         {
-            shadow.a = min(shadow.a, ScreenSpaceShadows(surface, light));
+            AccumulateLightsClustered(surface, material, multi_bounce_ao, light_out.diffuse, light_out.specular);
         }
-        #endif
-    
-        // Compute multi-bounce ambient occlusion
-        float3 multi_bounce_ao = MultiBounceAO(material.occlusion, sample_albedo.rgb);
-
-        // Modulate light with shadow color, visibility and ambient occlusion
-        light.color *= shadow.rgb * shadow.a * multi_bounce_ao;
     }
-
-    // Reflectance equation
-    [branch]
-    if (any(light.color) && !material.is_sky)
+    #else
     {
-        // Compute some vectors and dot products
-        float3 l        = -light.direction;
-        float3 v        = -surface.camera_to_pixel;
-        float3 h        = normalize(v + l);
-        float l_dot_h   = saturate(dot(l, h));
-        float v_dot_h   = saturate(dot(v, h));
-        float n_dot_v   = saturate(dot(surface.normal, v));
-        float n_dot_l   = saturate(dot(surface.normal, l));
-        float n_dot_h   = saturate(dot(surface.normal, h));
-
-        float3 diffuse_energy       = 1.0f;
-        float3 reflective_energy    = 1.0f;
-        
-        // Specular
-        float3 specular = 0.0f;
-        if (material.anisotropic == 0.0f)
-        {
-            specular = BRDF_Specular_Isotropic(material, n_dot_v, n_dot_l, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
-        }
-        else
-        {
-            specular = BRDF_Specular_Anisotropic(material, surface, v, l, h, n_dot_v, n_dot_l, n_dot_h, l_dot_h, diffuse_energy, reflective_energy);
-        }
-
-        // Specular clearcoat
-        float3 specular_clearcoat = 0.0f;
-        if (material.clearcoat != 0.0f)
-        {
-            specular_clearcoat = BRDF_Specular_Clearcoat(material, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
-        }
-
-        // Sheen
-        float3 specular_sheen = 0.0f;
-        if (material.sheen != 0.0f)
+        // Fill light struct
+        Light light;
+        light.index             = g_light_index;
+        light.color             = light_color_intensity[light.index].rgb * light_color_intensity[light.index].a;
+        light.position          = light_position_range[light.index].xyz;
+        light.range             = light_position_range[light.index].w;
+        light.angle             = light_direction_angle[light.index].w;
+        light.bias              = light_bias_normal_bias[light.index].x;
+        light.normal_bias       = light_bias_normal_bias[light.index].y;
+        light.distance_to_pixel = length(surface.position - light.position);
+        #if DIRECTIONAL
+        light.array_size    = 4;
+        light.direction     = light_direction_angle[light.index].xyz; 
+        light.attenuation   = 1.0f;
+        #elif POINT
+        light.array_size    = 1;
+        light.direction     = normalize(surface.position - light.position);
+        light.attenuation   = saturate(1.0f - (light.distance_to_pixel / light.range)); light.attenuation *= light.attenuation;    
+        #elif SPOT
+        light.array_size    = 1;
+        light.direction     = normalize(surface.position - light.position);
+        float cutoffAngle   = 1.0f - light.angle;
+        float theta         = dot(light_direction_angle[light.index].xyz, light.direction);
+        float epsilon       = cutoffAngle - cutoffAngle * 0.9f;
+        light.attenuation   = saturate((theta - cutoffAngle) / epsilon); // attenuate when approaching the outer cone
+        light.attenuation   *= saturate(1.0f - light.distance_to_pixel / light.range); light.attenuation *= light.attenuation;
+        #endif
+        light.color *= light.attenuation;
+    
+        // Shadow 
         {
-            specular_sheen = BRDF_Specular_Sheen(material, n_dot_v, n_dot_l, n_dot_h, diffuse_energy, reflective_energy);
-        }
+            float4 shadow = 1.0f;
         
-        // Diffuse
-        float3 diffuse = BRDF_Diffuse(material, n_dot_v, n_dot_l, v_dot_h);
-
-        // Tone down diffuse such as that only non metals have it
-        diffuse *= diffuse_energy;
+            // Shadow mapping
+            #if SHADOWS
+            {
+                shadow = Shadow_Map(surface, light, material.is_transparent);
+            }
+            #endif
+        
+            // Screen space shadows, marched for all the lights which have them in a single pass before, each has a channel of the mask
+            #if SHADOWS_SCREEN_SPACE
+            {
+                uint channel = (uint)light_bias_normal_bias[light.index].z;
+                [branch]
+                if (channel != 0)
+                {
+                    shadow.a = min(shadow.a, tex.Sample(sampler_point_clamp, surface.uv)[channel - 1]);
+                }
+            }
+            #endif
+    
+            // Compute multi-bounce ambient occlusion
+            float3 multi_bounce_ao = MultiBounceAO(material.occlusion, sample_albedo.rgb);
 
-        // SSR
-        float3 light_reflection = 0.0f;
-        #if SCREEN_SPACE_REFLECTIONS
-        float2 sample_ssr = tex_ssr.Sample(sampler_point_clamp, input.uv).xy;
-        [branch]
-        if (sample_ssr.x * sample_ssr.y != 0.0f)
-        {
-            // saturate as reflections will accumulate int tex_frame overtime, causing more light to go out that it comes in.
-            light_reflection = saturate(tex_frame.Sample(sampler_bilinear_clamp, sample_ssr.xy).rgb);
-            light_reflection *= reflective_energy;
-            light_reflection *= 1.0f - material.roughness; // fade with roughness as we don't have blurry screen space reflections yet
+            // Modulate light with shadow color, visibility and ambient occlusion
+            light.color *= shadow.rgb * shadow.a * multi_bounce_ao;
         }
-        #endif
 
-        float3 radiance = light.color * n_dot_l;
-        
-        light_out.diffuse.rgb   = saturate_16(diffuse * radiance);
-        light_out.specular.rgb  = saturate_16((specular + specular_clearcoat + specular_sheen) * radiance + light_reflection);
+        AccumulateLight(surface, material, light, light_out.diffuse, light_out.specular);
     }
+    #endif
 
     return light_out;
 }
@@ -0,0 +1,155 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SPARTAN_LIGHT_ACCUMULATION
+#define SPARTAN_LIGHT_ACCUMULATION
+
+//= INCLUDES =========
+#include "BRDF.hlsl"
+//====================
+
+// Reflectance equation, adds the light's contribution to the diffuse and specular light
+void AccumulateLight(Surface surface, Material material, Light light, inout float3 light_diffuse, inout float3 light_specular)
+{
+    [branch]
+    if (!any(light.color) || material.is_sky)
+        return;
+
+    // Compute some vectors and dot products
+    float3 l        = -light.direction;
+    float3 v        = -surface.camera_to_pixel;
+    float3 h        = normalize(v + l);
+    float l_dot_h   = saturate(dot(l, h));
+    float v_dot_h   = saturate(dot(v, h));
+    float n_dot_v   = saturate(dot(surface.normal, v));
+    float n_dot_l   = saturate(dot(surface.normal, l));
+    float n_dot_h   = saturate(dot(surface.normal, h));
+
+    float3 diffuse_energy       = 1.0f;
+    float3 reflective_energy    = 1.0f;
+    
+    // Specular
+    float3 specular = 0.0f;
+    if (material.anisotropic == 0.0f)
+    {
+        specular = BRDF_Specular_Isotropic(material, n_dot_v, n_dot_l, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
+    }
+    else
+    {
+        specular = BRDF_Specular_Anisotropic(material, surface, v, l, h, n_dot_v, n_dot_l, n_dot_h, l_dot_h, diffuse_energy, reflective_energy);
+    }
+
+    // Specular clearcoat
+    float3 specular_clearcoat = 0.0f;
+    if (material.clearcoat != 0.0f)
+    {
+        specular_clearcoat = BRDF_Specular_Clearcoat(material, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
+    }
+
+    // Sheen
+    float3 specular_sheen = 0.0f;
+    if (material.sheen != 0.0f)
+    {
+        specular_sheen = BRDF_Specular_Sheen(material, n_dot_v, n_dot_l, n_dot_h, diffuse_energy, reflective_energy);
+    }
+    
+    // Diffuse
+    float3 diffuse = BRDF_Diffuse(material, n_dot_v, n_dot_l, v_dot_h);
+
+    // Tone down diffuse such as that only non metals have it
+    diffuse *= diffuse_energy;
+
+    // SSR
+    float3 light_reflection = 0.0f;
+    #if SCREEN_SPACE_REFLECTIONS
+    float2 sample_ssr = tex_ssr.Sample(sampler_point_clamp, surface.uv).xy;
+    [branch]
+    if (sample_ssr.x * sample_ssr.y != 0.0f)
+    {
+        // saturate as reflections will accumulate int tex_frame overtime, causing more light to go out that it comes in.
+        light_reflection = saturate(tex_frame.Sample(sampler_bilinear_clamp, sample_ssr.xy).rgb);
+        light_reflection *= reflective_energy;
+        light_reflection *= 1.0f - material.roughness; // fade with roughness as we don't have blurry screen space reflections yet
+    }
+    #endif
+
+    float3 radiance = light.color * n_dot_l;
+    
+    light_diffuse   += saturate_16(diffuse * radiance);
+    light_specular  += saturate_16((specular + specular_clearcoat + specular_sheen) * radiance + light_reflection);
+}
+
+// Adds the point and spot lights which reach the surface's cluster, surface.uv has to be the screen position
+void AccumulateLightsClustered(Surface surface, Material material, float3 multi_bounce_ao, inout float3 light_diffuse, inout float3 light_specular)
+{
+    // Find the pixel's cluster
+    float depth_view    = mul(float4(surface.position, 1.0f), g_view).z;
+    uint2 tile          = min(uint2(surface.uv * float2(g_light_cluster_count_x, g_light_cluster_count_y)), uint2(g_light_cluster_count_x - 1, g_light_cluster_count_y - 1));
+    uint slice          = (uint)clamp(floor(log(max(depth_view, g_camera_near)) * cluster_slice_scale_bias_count.x + cluster_slice_scale_bias_count.y), 0.0f, g_light_cluster_count_z - 1.0f);
+    uint cluster_index  = (slice * g_light_cluster_count_y + tile.y) * g_light_cluster_count_x + tile.x;
+    uint4 masks         = cluster_masks[cluster_index / 2];
+    uint2 mask          = (cluster_index % 2) == 0 ? masks.xy : masks.zw;
+
+    // Go through the lights that reach the cluster
+    [loop]
+    for (uint mask_index = 0; mask_index < 2; mask_index++)
+    {
+        uint bits = mask[mask_index];
+
+        [loop]
+        while (bits != 0)
+        {
+            uint light_index = mask_index * 32 + firstbitlow(bits);
+            bits &= bits - 1;
+
+            Light light;
+            light.color             = light_color_intensity[light_index].rgb * light_color_intensity[light_index].a;
+            light.position          = light_position_range[light_index].xyz;
+            light.range             = light_position_range[light_index].w;
+            light.angle             = light_direction_angle[light_index].w;
+            light.bias              = 0.0f;
+            light.normal_bias       = 0.0f;
+            light.array_size        = 1;
+            light.index             = light_index;
+            light.distance_to_pixel = length(surface.position - light.position);
+            light.direction         = normalize(surface.position - light.position);
+            light.attenuation       = saturate(1.0f - (light.distance_to_pixel / light.range));
+
+            // Spot lights, attenuate when approaching the outer cone
+            [branch]
+            if (light.angle >= 0.0f)
+            {
+                float cutoffAngle   = 1.0f - light.angle;
+                float theta         = dot(light_direction_angle[light_index].xyz, light.direction);
+                float epsilon       = cutoffAngle - cutoffAngle * 0.9f;
+                light.attenuation   *= saturate((theta - cutoffAngle) / epsilon);
+            }
+            light.attenuation *= light.attenuation;
+
+            // None of these lights have shadows, so ambient occlusion is all that modulates them
+            light.color *= light.attenuation * multi_bounce_ao;
+
+            AccumulateLight(surface, material, light, light_diffuse, light_specular);
+        }
+    }
+}
+
+#endif // SPARTAN_LIGHT_ACCUMULATION
@@ -0,0 +1,107 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========
+#include "Common.hlsl"
+//====================
+
+// Particles have no state, every instance of the quad is a particle and the vertex shader works out where it is from its index and the time
+// of the emitter. Particle i spawns at i / rate and again every period after, its randomness comes from its index and its spawn cycle.
+
+static const uint particle_cycles = 1024; // must match ParticleEmitter
+
+struct PixelInputType
+{
+    float4 position : SV_POSITION;
+    float2 uv       : TEXCOORD;
+    float4 color    : COLOR;
+};
+
+uint particle_hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float particle_random(inout uint state)
+{
+    state = particle_hash(state);
+    return float(state) / 4294967296.0f;
+}
+
+PixelInputType mainVS(Vertex_PosUv input, uint instance_id : SV_InstanceID)
+{
+    PixelInputType output;
+
+    float time      = g_object_particle_time_period_lifetime_gravity.x;
+    float period    = g_object_particle_time_period_lifetime_gravity.y;
+    float lifetime  = g_object_particle_time_period_lifetime_gravity.z;
+    float gravity   = g_object_particle_time_period_lifetime_gravity.w;
+    float rate      = g_object_particle_rate_size_seed.x;
+
+    // Age of the particle, those which haven't spawned yet or are dead collapse to a point outside of the clip space
+    float since     = time - float(instance_id) / rate;
+    float age       = since - floor(since / period) * period;
+    if (since < 0.0f || age >= lifetime)
+    {
+        output.position = float4(0.0f, 0.0f, 0.0f, -1.0f);
+        output.uv       = 0.0f;
+        output.color    = 0.0f;
+        return output;
+    }
+
+    // A random velocity within a sphere
+    uint cycle  = uint(floor(since / period)) % particle_cycles;
+    uint state  = particle_hash(instance_id * particle_cycles + cycle) ^ particle_hash(uint(g_object_particle_rate_size_seed.w));
+    float z     = particle_random(state) * 2.0f - 1.0f;
+    float phi   = particle_random(state) * PI2;
+    float r     = pow(particle_random(state), 1.0f / 3.0f) * g_object_particle_velocity_spread.w;
+    float3 velocity = g_object_particle_velocity_spread.xyz + float3(sqrt(1.0f - z * z) * cos(phi), z, sqrt(1.0f - z * z) * sin(phi)) * r;
+
+    // Flies in the space of the emitter, falls in the space of the world
+    float3 position = mul(float4(velocity * age, 1.0f), g_object_transform).xyz;
+    position.y      += 0.5f * gravity * age * age;
+
+    // Faces the camera
+    float t                 = age / lifetime;
+    float size              = lerp(g_object_particle_rate_size_seed.y, g_object_particle_rate_size_seed.z, t);
+    float3 position_view    = mul(float4(position, 1.0f), g_view).xyz + float3(input.position.xy * size * 0.5f, 0.0f);
+
+    output.position = mul(float4(position_view, 1.0f), g_projection);
+    output.uv       = input.uv;
+    output.color    = lerp(g_object_particle_color_start, g_object_particle_color_end, t);
+
+    return output;
+}
+
+// Blended additively, so the order they are drawn in doesn't matter
+float4 mainPS(PixelInputType input) : SV_Target
+{
+    float4 sprite   = tex_material_albedo.Sample(sampler_bilinear_clamp, input.uv);
+    float alpha     = sprite.a * input.color.a;
+
+    return float4(degamma(sprite.rgb) * input.color.rgb * alpha, 0.0f);
+}
@@ -0,0 +1,110 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+// Must match PostProcess_Flags in Renderer_ConstantBuffers.h
+static const uint postprocess_tonemapping           = 1 << 0;
+static const uint postprocess_dithering             = 1 << 1;
+static const uint postprocess_sharpening            = 1 << 2;
+static const uint postprocess_chromatic_aberration  = 1 << 3;
+static const uint postprocess_gamma_correction      = 1 << 4;
+static const uint postprocess_auto_exposure         = 1 << 5;
+
+inline bool postprocess_enabled(uint flag)
+{
+    return (g_postprocess_flags & flag) != 0;
+}
+
+// Every tap is tone-mapped, so the effects which follow see the same input as they would in their own pass
+inline real4 postprocess_sample(Texture2D tex, SamplerState sampler_state, float2 uv)
+{
+    real4 color = tex.SampleLevel(sampler_state, uv, 0);
+
+    [branch]
+    if (postprocess_enabled(postprocess_tonemapping))
+    {
+        float exposure = g_exposure;
+        if (postprocess_enabled(postprocess_auto_exposure))
+        {
+            exposure += tex_exposure.Load(int3(0, 0, 0)).r;
+        }
+
+        color.rgb = ToneMap(color.rgb, exposure);
+    }
+
+    return color;
+}
+
+// Tone-mapping, sharpening, chromatic aberration, dithering and gamma correction in a single pass.
+// The intermediate results never leave the registers, g_postprocess_flags selects the effects.
+float4 PostProcess_Fused(float2 uv, Texture2D tex)
+{
+    real4 sample_center     = postprocess_sample(tex, sampler_point_clamp, uv);
+    real3 color             = sample_center.rgb;
+
+    // Sharpening - same as LumaSharpen()
+    [branch]
+    if (postprocess_enabled(postprocess_sharpening))
+    {
+        const real3 luma_coefficient    = real3(0.2126f, 0.7152f, 0.0722f);
+        const float2 offset             = g_texel_size * 0.5f;
+
+        real3 blur = postprocess_sample(tex, sampler_bilinear_clamp, uv + float2(offset.x, -offset.y)).rgb;
+        blur += postprocess_sample(tex, sampler_bilinear_clamp, uv + float2(-offset.x, -offset.y)).rgb;
+        blur += postprocess_sample(tex, sampler_bilinear_clamp, uv + float2(offset.x, offset.y)).rgb;
+        blur += postprocess_sample(tex, sampler_bilinear_clamp, uv + float2(-offset.x, offset.y)).rgb;
+        blur *= 0.25f;
+
+        real4 strength_luma_clamp   = real4(luma_coefficient * (real)(g_sharpen_strength * (0.5f / g_sharpen_clamp)), 0.5f);
+        real sharp_luma             = saturate(dot(real4(color - blur, 1.0f), strength_luma_clamp));
+        sharp_luma                  = (g_sharpen_clamp * 2.0f) * sharp_luma - g_sharpen_clamp;
+        color                       = saturate(color + sharp_luma);
+    }
+
+    // Chromatic aberration - same as ChromaticAberration()
+    [branch]
+    if (postprocess_enabled(postprocess_chromatic_aberration))
+    {
+        float2 shift    = float2(2.5f, -2.5f) * abs(uv * 2.0f - 1.0f);
+        real strength   = 0.75f;
+
+        real3 color_shifted     = color;
+        color_shifted.r         = postprocess_sample(tex, sampler_bilinear_clamp, uv + (g_texel_size * shift)).r;
+        color_shifted.b         = postprocess_sample(tex, sampler_bilinear_clamp, uv - (g_texel_size * shift)).b;
+        color                   = lerp(color, color_shifted, strength);
+    }
+
+    // Dithering
+    [branch]
+    if (postprocess_enabled(postprocess_dithering))
+    {
+        color += dither(uv);
+    }
+
+    // Gamma correction
+    [branch]
+    if (postprocess_enabled(postprocess_gamma_correction))
+    {
+        color = gamma(color);
+    }
+
+    return float4(color, sample_center.a);
+}
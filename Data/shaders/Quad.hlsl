@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "MotionBlur.hlsl"
 #include "Dithering.hlsl"
 #include "Scaling.hlsl"
+#include "PostProcess.hlsl"
 #define FXAA_PC 1
 #define FXAA_HLSL_5 1
 #define FXAA_QUALITY__PRESET 39
@@ -56,6 +57,10 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
     color       = gamma(color);
 #endif
 
+#if PASS_POSTPROCESS_FUSED
+    color = PostProcess_Fused(uv, tex);
+#endif
+
 #if PASS_TONEMAPPING
     color       = tex.Sample(sampler_point_clamp, uv);
     color.rgb   = ToneMap(color.rgb, g_exposure);
@@ -65,6 +70,13 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
     color = tex.Sample(sampler_bilinear_clamp, uv);
 #endif
 
+#if PASS_TRANSPARENT_RESOLVE
+    // Weighted blended transparency, tex is the accumulation and tex2 the sum of the weights, alpha is the coverage
+    float4 accumulation = tex.Sample(sampler_point_clamp, uv);
+    float weight        = tex2.Sample(sampler_point_clamp, uv).r;
+    color               = float4(accumulation.rgb / max(weight, 0.00001f), 1.0f - accumulation.a);
+#endif
+
 #if PASS_FXAA
     FxaaTex fxaa_tex            = { sampler_bilinear_clamp, tex };
     float2 fxaaQualityRcpFrame  = g_texel_size;
@@ -105,6 +117,10 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
     color = Upsample_Box(uv, tex);
 #endif
 
+#if PASS_UPSAMPLE_BILATERAL
+    color = Upsample_Bilateral(uv, tex);
+#endif
+
 #if PASS_DOWNSAMPLE_BOX
     color = Downsample_Box(uv, tex);
 #endif
@@ -151,7 +167,7 @@ float4 mainPS(Pixel_PosUv input) : SV_TARGET
 #endif
 
 #if DEBUG_NORMAL
-    float3 normal = tex.Sample(sampler_point_clamp, uv).rgb;
+    float3 normal = gbuffer_normal_decode(tex.Sample(sampler_point_clamp, uv));
     normal = pack(normal);
     color = float4(normal, 1.0f);
 #endif
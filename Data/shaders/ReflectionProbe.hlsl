@@ -0,0 +1,88 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef SPARTAN_REFLECTION_PROBE
+#define SPARTAN_REFLECTION_PROBE
+
+//= INCLUDES ======
+#include "BRDF.hlsl"
+//=================
+
+// The slices of a probe in the atlas, its radiance, the specular levels and the irradiance (must match the renderer)
+static const float reflection_probe_slices = environment_slices_specular + 2.0f;
+
+// Parallax correction, the direction from the probe's center to where the ray leaves the box [Lagarde 2012, "Local Image-based Lighting With Parallax-corrected Cubemap"]
+inline float3 reflection_probe_box_project(float3 position, float3 direction, float3 center, float3 extents)
+{
+    float3 t_max    = (center + extents - position) / direction;
+    float3 t_min    = (center - extents - position) / direction;
+    float3 t_far    = max(t_max, t_min);
+    float t         = min(min(t_far.x, t_far.y), t_far.z);
+
+    return position + direction * t - center;
+}
+
+// Replaces the image based lighting of the environment with that of the probe whose box the position is deepest into, faded towards the box's faces
+void reflection_probe_ibl(float3 position, Material material, float3 normal, float3 camera_to_pixel, float3 diffuse_energy, float3 reflectivity, inout float3 light_ibl_diffuse, inout float3 light_ibl_specular)
+{
+    float weight    = 0.0f;
+    uint probe      = 0;
+    [loop]
+    for (uint i = 0; i < (uint)reflection_probe_count.x; i++)
+    {
+        float3 distance = reflection_probe_extents_slice[i].xyz - abs(position - reflection_probe_center_fade[i].xyz);
+        float inside    = min(min(distance.x, distance.y), distance.z);
+        float w         = saturate(inside / max(reflection_probe_center_fade[i].w, FLT_MIN));
+        if (inside > 0.0f && w > weight)
+        {
+            weight  = w;
+            probe   = i;
+        }
+    }
+
+    [branch]
+    if (weight == 0.0f)
+        return;
+
+    float3 center   = reflection_probe_center_fade[probe].xyz;
+    float3 extents  = reflection_probe_extents_slice[probe].xyz;
+    float slice     = reflection_probe_extents_slice[probe].w;
+
+    // Specular, along the same direction as Brdf_Specular_Ibl() but projected onto the box
+    float roughness     = clamp(material.roughness, 0.089f, 1.0f);
+    float3 reflection   = GetSpecularDominantDir(normal, reflect(camera_to_pixel, normal), material.roughness);
+    float2 uv           = direction_sphere_uv(reflection_probe_box_project(position, reflection, center, extents));
+    float level         = saturate(roughness * roughness) * environment_slices_specular;
+    float level_0       = floor(level);
+    float level_1       = min(level_0 + 1.0f, environment_slices_specular);
+    float3 color_0      = tex_reflection_probes.SampleLevel(sampler_bilinear_clamp, float3(uv, slice + level_0), 0.0f).rgb;
+    float3 color_1      = tex_reflection_probes.SampleLevel(sampler_bilinear_clamp, float3(uv, slice + level_1), 0.0f).rgb;
+    float3 specular     = lerp(color_0, color_1, level - level_0) * reflectivity;
+
+    // Diffuse, the irradiance is smooth enough to do without the projection
+    float3 irradiance   = tex_reflection_probes.SampleLevel(sampler_bilinear_clamp, float3(direction_sphere_uv(normal), slice + reflection_probe_slices - 1.0f), 0.0f).rgb;
+    float3 diffuse      = irradiance * material.albedo * diffuse_energy;
+
+    light_ibl_specular  = lerp(light_ibl_specular, specular, weight);
+    light_ibl_diffuse   = lerp(light_ibl_diffuse, diffuse, weight);
+}
+
+#endif // SPARTAN_REFLECTION_PROBE
@@ -70,21 +70,36 @@ float4 ResolveTAA(float2 uv, Texture2D tex_history, Texture2D tex_current)
     float2 velocity         = GetVelocity_DepthMin(uv);
     float2 uv_reprojected   = uv - velocity;
     float3 color_history    = Reinhard(tex_history.Sample(sampler_bilinear_clamp, uv_reprojected).rgb);
-    float3 color_current    = Reinhard(tex_current.Sample(sampler_point_clamp, uv).rgb);
+
+#if TAA_UPSCALE
+    // The current frame is rendered below the output resolution (g_resolution), so it's the input sample
+    // (jittered) closest to this pixel which contributes, weighted by how far from the pixel it landed.
+    float2 resolution_current;
+    tex_current.GetDimensions(resolution_current.x, resolution_current.y);
+    float2 texel_size_current   = 1.0f / resolution_current;
+    float2 jitter_uv            = g_taa_jitter * float2(0.5f, -0.5f);
+    float2 uv_current           = (floor((uv + jitter_uv) * resolution_current) + 0.5f) * texel_size_current;
+    float2 sample_offset        = (uv_current - jitter_uv - uv) * g_resolution; // in output pixels
+    float sample_weight         = exp(-2.29f * dot(sample_offset, sample_offset)); // Blackman-Harris, approximated with a gaussian
+#else
+    float2 texel_size_current   = g_texel_size;
+    float2 uv_current           = uv;
+#endif
+    float3 color_current        = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current).rgb);
     
     //= History clipping ==================================================================================
-    float2 du = float2(g_texel_size.x, 0.0f);
-    float2 dv = float2(0.0f, g_texel_size.y);
+    float2 du = float2(texel_size_current.x, 0.0f);
+    float2 dv = float2(0.0f, texel_size_current.y);
 
-    float3 ctl = Reinhard(tex_current.Sample(sampler_point_clamp, uv - dv - du).rgb);
-    float3 ctc = Reinhard(tex_current.Sample(sampler_point_clamp, uv - dv).rgb);
-    float3 ctr = Reinhard(tex_current.Sample(sampler_point_clamp, uv - dv + du).rgb);
-    float3 cml = Reinhard(tex_current.Sample(sampler_point_clamp, uv - du).rgb);
+    float3 ctl = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current - dv - du).rgb);
+    float3 ctc = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current - dv).rgb);
+    float3 ctr = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current - dv + du).rgb);
+    float3 cml = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current - du).rgb);
     float3 cmc = color_current;
-    float3 cmr = Reinhard(tex_current.Sample(sampler_point_clamp, uv + du).rgb);
-    float3 cbl = Reinhard(tex_current.Sample(sampler_point_clamp, uv + dv - du).rgb);
-    float3 cbc = Reinhard(tex_current.Sample(sampler_point_clamp, uv + dv).rgb);
-    float3 cbr = Reinhard(tex_current.Sample(sampler_point_clamp, uv + dv + du).rgb);
+    float3 cmr = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current + du).rgb);
+    float3 cbl = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current + dv - du).rgb);
+    float3 cbc = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current + dv).rgb);
+    float3 cbr = Reinhard(tex_current.Sample(sampler_point_clamp, uv_current + dv + du).rgb);
 
     float3 color_min = min(ctl, min(ctc, min(ctr, min(cml, min(cmc, min(cmr, min(cbl, min(cbc, cbr))))))));
     float3 color_max = max(ctl, max(ctc, max(ctr, max(cml, max(cmc, max(cmr, max(cbl, max(cbc, cbr))))))));
@@ -111,6 +126,11 @@ float4 ResolveTAA(float2 uv, Texture2D tex_history, Texture2D tex_current)
 
     // Compute blend factor
     float blend_factor = saturate(factor_subpixel * factor_contrast);
+
+#if TAA_UPSCALE
+    // Samples which land far from the pixel mostly go to the history, that's how it accumulates the detail of the output resolution
+    blend_factor *= sample_weight;
+#endif
     
     // Use max blend if the re-projected uv is out of screen
     blend_factor = is_saturated(uv_reprojected) ? blend_factor : 1.0f;
@@ -19,26 +19,23 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+//= INCLUDES =========
+#include "Common.hlsl"
+#include "Dithering.hlsl"
+//====================
+
 static const uint g_sss_steps               = 8;
 static const float g_sss_tolerance          = 0.01f;
 static const float g_sss_ray_max_distance   = 0.05f;
 
-//= INLUCES =============
-#include "Dithering.hlsl"
-//=======================
-
-float ScreenSpaceShadows(Surface surface, Light light)
+// Marches the depth buffer from a view space position towards the light, returns 1 when lit and 0 when occluded
+float ScreenSpaceShadow(float3 ray_pos, float3 ray_dir, float offset)
 {
-    // Compute ray
-    float3 ray_pos      = mul(float4(surface.position, 1.0f), g_view).xyz;
-    float3 ray_dir      = mul(float4(-light.direction, 0.0f), g_view).xyz;
     float step_length   = g_sss_ray_max_distance / (float)g_sss_steps;
     float3 ray_step     = ray_dir * step_length;
     float2 ray_uv       = 0.0f;
-    float shadow        = 1.0f;
 
     // Offseting with some temporal interleaved gradient noise, will capture more detail
-    float offset = interleaved_gradient_noise(g_resolution * surface.uv);
     ray_pos += ray_step * offset;
 
     // Ray march towards the light
@@ -69,4 +66,34 @@ float ScreenSpaceShadows(Surface surface, Light light)
     occlusion *= screen_fade(ray_uv);
     
     return 1.0f - occlusion;
-}
\ No newline at end of file
+}
+
+// The lights with screen space shadows are marched together, each writes a channel of the mask which the light pass reads.
+// The pixel's position and noise are computed once for all of them.
+float4 mainPS(Pixel_PosUv input) : SV_TARGET
+{
+    float4 mask = 1.0f;
+
+    float depth = tex_depth.Sample(sampler_point_clamp, input.uv).r;
+    float3 position_world   = get_position(depth, input.uv);
+    float3 position_view    = mul(float4(position_world, 1.0f), g_view).xyz;
+    float offset            = interleaved_gradient_noise(g_resolution * input.uv);
+
+    [unroll]
+    for (uint i = 0; i < 4; i++)
+    {
+        uint index = light_screen_space_shadows[i];
+
+        [branch]
+        if (index < g_max_lights)
+        {
+            // Towards the light, which is the opposite of the light's direction (directional) or of the light to pixel direction
+            bool directional    = light_bias_normal_bias[index].w != 0.0f;
+            float3 to_light     = directional ? -light_direction_angle[index].xyz : normalize(light_position_range[index].xyz - position_world);
+            float3 ray_dir      = mul(float4(to_light, 0.0f), g_view).xyz;
+            mask[i]             = ScreenSpaceShadow(position_view, ray_dir, offset);
+        }
+    }
+
+    return mask;
+}
@@ -0,0 +1,95 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========
+#include "Common.hlsl"
+//====================
+
+// The rates as the shading rate image encodes them, the log2 of the width shifted by two, or'd with the log2 of the height
+static const uint g_shading_rate_1x1 = 0;
+static const uint g_shading_rate_1x2 = 1;
+static const uint g_shading_rate_2x1 = 4;
+static const uint g_shading_rate_2x2 = 5;
+
+static const uint g_vrs_samples             = 4;     // per axis, per tile
+static const float g_vrs_contrast           = 0.04f; // relative luminance difference between neighbours, below it the detail survives a coarser rate
+static const float g_vrs_motion             = 6.0f;  // pixels per frame, above it the motion (and motion blur) hides a coarser rate
+static const float g_vrs_foveation_radius   = 0.35f; // distance from the centre (in uv) which is always shaded at full rate
+
+// Every pixel of the target is a tile of the frame, g_resolution is the size of the target. Its contrast comes from the previous
+// output (tex), reprojected with the velocity, along each axis on its own, so that the rate can only be coarsened along the flat one.
+uint mainPS(Pixel_PosUv input) : SV_TARGET
+{
+    float2 tile_size    = 1.0f / g_resolution;
+    float2 tile_origin  = input.uv - tile_size * 0.5f;
+    float2 sample_step  = tile_size / (float)g_vrs_samples;
+
+    float2 frame_size;
+    tex_velocity.GetDimensions(frame_size.x, frame_size.y);
+
+    float luma[g_vrs_samples][g_vrs_samples];
+    float motion = 0.0f;
+    [unroll]
+    for (uint y = 0; y < g_vrs_samples; y++)
+    {
+        [unroll]
+        for (uint x = 0; x < g_vrs_samples; x++)
+        {
+            float2 uv       = tile_origin + (float2(x, y) + 0.5f) * sample_step;
+            float2 velocity = tex_velocity.SampleLevel(sampler_point_clamp, uv, 0).xy;
+            luma[y][x]      = luminance(tex.SampleLevel(sampler_bilinear_clamp, uv - velocity, 0).rgb);
+            motion          = max(motion, length(velocity * frame_size));
+        }
+    }
+
+    float contrast_x = 0.0f;
+    float contrast_y = 0.0f;
+    [unroll]
+    for (uint i = 0; i < g_vrs_samples; i++)
+    {
+        [unroll]
+        for (uint j = 0; j < g_vrs_samples - 1; j++)
+        {
+            contrast_x = max(contrast_x, abs(luma[i][j] - luma[i][j + 1]) / max(luma[i][j] + luma[i][j + 1], 0.01f));
+            contrast_y = max(contrast_y, abs(luma[j][i] - luma[j + 1][i]) / max(luma[j][i] + luma[j + 1][i], 0.01f));
+        }
+    }
+
+    // Fast motion and the periphery tolerate twice the contrast
+    float tolerance = g_vrs_contrast;
+    tolerance       *= motion > g_vrs_motion ? 2.0f : 1.0f;
+    tolerance       *= length(input.uv - 0.5f) > g_vrs_foveation_radius ? 2.0f : 1.0f;
+
+    bool coarse_x = contrast_x < tolerance;
+    bool coarse_y = contrast_y < tolerance;
+
+    if (coarse_x && coarse_y)
+        return g_shading_rate_2x2;
+
+    if (coarse_x)
+        return g_shading_rate_2x1;
+
+    if (coarse_y)
+        return g_shading_rate_1x2;
+
+    return g_shading_rate_1x1;
+}
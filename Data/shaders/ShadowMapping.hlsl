@@ -19,9 +19,9 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =====================
-#include "ScreenSpaceShadows.hlsl"
-//================================
+//= INCLUDES =============
+#include "Dithering.hlsl"
+//========================
 
 /*------------------------------------------------------------------------------
     SETTINGS
@@ -328,7 +328,7 @@ float4 Shadow_Map(Surface surface, Light light, bool transparent_pixel)
         for (uint cascade = 0; cascade < light.array_size; cascade++)
         {
             // Compute position in clip space for primary cascade
-            float3 pos = project(position_world, light_view_projection[cascade]);
+            float3 pos = project(position_world, light_view_projection[light.index * 6 + cascade]);
             
             // If the position exists within the cascade, sample it
             [branch]
@@ -355,7 +355,7 @@ float4 Shadow_Map(Surface surface, Light light, bool transparent_pixel)
                     int cacade_secondary = cascade + 1;
 
                     // Compute position in clip space for secondary cascade
-                    pos = project(position_world, light_view_projection[cacade_secondary]);
+                    pos = project(position_world, light_view_projection[light.index * 6 + cacade_secondary]);
 
                     // Sample secondary cascade
                     compare_depth           = bias_sloped_scaled(pos.z, light.bias * (cacade_secondary + 2));
@@ -384,7 +384,7 @@ float4 Shadow_Map(Surface surface, Light light, bool transparent_pixel)
         if (light.distance_to_pixel < light.range)
         {
             uint projection_index   = direction_to_cube_face_index(light.direction);
-            float pos_z             = project_depth(position_world, light_view_projection[projection_index]);   
+            float pos_z             = project_depth(position_world, light_view_projection[light.index * 6 + projection_index]);   
             float compare_depth     = bias_sloped_scaled(pos_z, light.bias);
             shadow.a                = SampleShadowMap(light.direction, compare_depth);
             
@@ -402,7 +402,7 @@ float4 Shadow_Map(Surface surface, Light light, bool transparent_pixel)
         [branch]
         if (light.distance_to_pixel < light.range)
         {
-            float3 pos_clip     = project(position_world, light_view_projection[0]);
+            float3 pos_clip     = project(position_world, light_view_projection[light.index * 6]);
             float compare_depth = bias_sloped_scaled(pos_clip.z, light.bias);
             shadow.a            = SampleShadowMap(float3(pos_clip.xy, 0.0f), compare_depth);
 
@@ -19,25 +19,25 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-float3 Reinhard(float3 hdr, float k = 1.0f)
+real3 Reinhard(real3 hdr, real k = 1.0f)
 {
     return hdr / (hdr + k);
 }
 
-float3 ReinhardInverse(float3 sdr, float k = 1.0)
+real3 ReinhardInverse(real3 sdr, real k = 1.0)
 {
     return k * sdr / (k - sdr);
 }
 
-float3 Uncharted2(float3 x)
+real3 Uncharted2(real3 x)
 {
-    float A = 0.15;
-    float B = 0.50;
-    float C = 0.10;
-    float D = 0.20;
-    float E = 0.02;
-    float F = 0.30;
-    float W = 11.2;
+    real A = 0.15;
+    real B = 0.50;
+    real C = 0.10;
+    real D = 0.20;
+    real E = 0.02;
+    real F = 0.30;
+    real W = 11.2;
     return ((x*(A*x+C*B)+D*E)/(x*(A*x+B)+D*F))-E/F;
 }
 
@@ -49,7 +49,7 @@ float3 Uncharted2(float3 x)
 //=========================================
 
 // sRGB => XYZ => D65_2_D60 => AP1 => RRT_SAT
-static const float3x3 ACESInputMat =
+static const real3x3 ACESInputMat =
 {
     {0.59719, 0.35458, 0.04823},
     {0.07600, 0.90834, 0.01566},
@@ -57,21 +57,21 @@ static const float3x3 ACESInputMat =
 };
 
 // ODT_SAT => XYZ => D60_2_D65 => sRGB
-static const float3x3 ACESOutputMat =
+static const real3x3 ACESOutputMat =
 {
     { 1.60475, -0.53108, -0.07367},
     {-0.10208,  1.10813, -0.00605},
     {-0.00327, -0.07276,  1.07602}
 };
 
-float3 RRTAndODTFit(float3 v)
+real3 RRTAndODTFit(real3 v)
 {
-    float3 a = v * (v + 0.0245786f) - 0.000090537f;
-    float3 b = v * (0.983729f * v + 0.4329510f) + 0.238081f;
+    real3 a = v * (v + 0.0245786f) - 0.000090537f;
+    real3 b = v * (0.983729f * v + 0.4329510f) + 0.238081f;
     return a / b;
 }
 
-float3 ACESFitted(float3 color)
+real3 ACESFitted(real3 color)
 {
     color = mul(ACESInputMat, color);
 
@@ -86,9 +86,14 @@ float3 ACESFitted(float3 color)
     return color;
 }
 
-float3 ToneMap(float3 color, float exposure = 1.0f)
+real3 ToneMap(real3 color, float exposure = 1.0f)
 {
-    color *= exp(exposure);
+    color *= (real)exp(exposure);
+
+    #if HALF_PRECISION
+    // The curves square the color on the way, past this it would overflow 16 bits (and they have long flattened out by then)
+    color = min(color, 250.0f);
+    #endif
     
     [branch]
     if (g_toneMapping == 0) // OFF
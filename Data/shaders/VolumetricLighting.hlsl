@@ -19,10 +19,15 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-static const uint g_vl_steps        = 4;
-static const float g_vl_tolerance   = 0.45f;
-static const float g_vl_scattering  = 0.994f;
-static const float g_vl_pow         = 0.5f;
+//= INCLUDES =================
+#include "Froxel.hlsl"
+#include "ShadowMapping.hlsl"
+//============================
+
+static const float g_vl_scattering          = 0.994f;
+static const float g_vl_pow                 = 0.5f;
+static const float g_vl_density             = 0.02f; // extinction per meter, all of it scatters
+static const float g_vl_history_weight      = 0.9f;  // how much of the reprojected previous frame a froxel keeps
 
 // Mie scaterring approximated with Henyey-Greenstein phase function.
 float vl_compute_scattering(float v_dot_l)
@@ -33,111 +38,130 @@ float vl_compute_scattering(float v_dot_l)
     return result / pow(e, g_vl_pow);
 }
 
-float vl_raymarch(Light light, float3 ray_pos, float3 ray_step, float ray_dot_light, int array_index)
+// How much of the light reaches a point in the air, a single shadow map comparison (the temporal filter smooths it out)
+float vl_visibility(Light light, float3 position)
 {
-    float fog = 0.0f;
-    
-    for (uint i = 0; i < g_vl_steps; i++)
+    #if DIRECTIONAL
     {
-        // Compute position in clip space
-        float3 pos = project(ray_pos, light_view_projection[array_index]);
-        
-        // Compare depth
-        #if POINT
-        float depth_delta = compare_depth(normalize(ray_pos - light.position), pos.z);
-        #else // directional & spot
-        float depth_delta = compare_depth(float3(pos.xy, array_index), pos.z);
-        #endif
-       
-        // Depth test
-        if (abs(g_vl_tolerance - depth_delta) > g_vl_tolerance)
+        [loop]
+        for (uint cascade = 0; cascade < light.array_size; cascade++)
         {
-            fog += vl_compute_scattering(ray_dot_light);
+            float3 pos = project(position, light_view_projection[light.index * 6 + cascade]);
+
+            [branch]
+            if (is_saturated(pos))
+                return compare_depth(float3(pos.xy, cascade), pos.z + light.bias * 0.01f);
         }
-        
-        ray_pos += ray_step;
+        return 1.0f;
     }
+    #elif POINT
+    {
+        uint projection_index   = direction_to_cube_face_index(light.direction);
+        float pos_z             = project_depth(position, light_view_projection[light.index * 6 + projection_index]);
+        return compare_depth(light.direction, pos_z + light.bias * 0.01f);
+    }
+    #elif SPOT
+    {
+        float3 pos = project(position, light_view_projection[light.index * 6]);
+        return is_saturated(pos) ? compare_depth(float3(pos.xy, 0.0f), pos.z + light.bias * 0.01f) : 0.0f;
+    }
+    #endif
 
-    return fog / (float)g_vl_steps;
+    return 0.0f;
 }
 
-float3 VolumetricLighting(Surface surface, Light light)
+// The light a froxel scatters towards the camera
+float3 VolumetricLighting(Light light, float3 position, float3 view_direction)
 {
-    float3 ray_pos      = surface.position;
-    float3 ray_dir      = -surface.camera_to_pixel;
-    float step_length   = surface.camera_to_pixel_length / (float)g_vl_steps;
-    float3 ray_step     = ray_dir * step_length;   
-    float ray_dot_light = dot(ray_dir, light.direction);
-    float fog           = 0.0f;
-    
-    // Offset ray to get away with way less steps and great detail
-    float offset = interleaved_gradient_noise(surface.uv * g_resolution);
-    float offset_blue_noise = blue_noise(surface.uv);
-    ray_pos += ray_step  * offset;
-    
-    #if DIRECTIONAL
+    [branch]
+    if (light.attenuation <= 0.0f)
+        return 0.0f;
+
+    return vl_visibility(light, position) * vl_compute_scattering(dot(view_direction, light.direction)) * light.color * light.attenuation;
+}
+
+float4 mainPS(Pixel_PosUv input) : SV_TARGET
+{
+    uint2 pixel     = (uint2)input.position.xy;
+    uint3 froxel    = froxel_from_atlas(pixel);
+    float2 uv       = (froxel.xy + 0.5f) / float2(g_froxel_count_x, g_froxel_count_y);
+
+    #if PASS_INJECT
     {
-		[loop]
-        for (uint array_index = 0; array_index < light.array_size; array_index++)
-        {
-			// Compute position in clip space
-			float3 pos = project(ray_pos, light_view_projection[array_index]);
-		
-			[branch]
-			if (is_saturated(pos))
-			{
-				// Ray-march
-				fog += vl_raymarch(light, ray_pos, ray_step, ray_dot_light, array_index);
-				
-				// If we are close to the edge of the primary cascade and a next cascade exists, lerp with it.
-				static const float blend_threshold = 0.1f;
-				float distance_to_edge = 1.0f - max3(abs(pos * 2.0f - 1.0f));
-				uint array_index_secondary = array_index + 1;
-				[branch]
-				if (distance_to_edge < blend_threshold && array_index_secondary < light.array_size)
-				{
-					// Ray-march using the next cascade
-					float fog_secondary = vl_raymarch(light, ray_pos, ray_step, ray_dot_light, array_index_secondary);
-					
-					// Blend cascades
-					float alpha = smoothstep(0.0f, blend_threshold, distance_to_edge);
-					fog = lerp(fog_secondary, fog, alpha);
-				}
-				break;
-			}
-		}
+        // Additively blended, once per volumetric light. The sample is jittered in depth every frame, the temporal pass accumulates it.
+        float jitter            = frac(interleaved_gradient_noise(froxel.xy) + g_frame * 0.618034f);
+        float3 position         = froxel_position(uv, froxel_slice_to_depth(froxel.z + jitter));
+        float3 view_direction   = normalize(position - g_camera_position);
+
+        Light light;
+        light.index             = g_light_index;
+        light.color             = light_color_intensity[light.index].rgb * light_color_intensity[light.index].a;
+        light.position          = light_position_range[light.index].xyz;
+        light.range             = light_position_range[light.index].w;
+        light.angle             = light_direction_angle[light.index].w;
+        light.bias              = light_bias_normal_bias[light.index].x;
+        light.normal_bias       = light_bias_normal_bias[light.index].y;
+        light.distance_to_pixel = length(position - light.position);
+        #if DIRECTIONAL
+        light.array_size        = 4;
+        light.direction         = light_direction_angle[light.index].xyz;
+        light.attenuation       = 1.0f;
+        #elif POINT
+        light.array_size        = 1;
+        light.direction         = normalize(position - light.position);
+        light.attenuation       = saturate(1.0f - (light.distance_to_pixel / light.range)); light.attenuation *= light.attenuation;
+        #elif SPOT
+        light.array_size        = 1;
+        light.direction         = normalize(position - light.position);
+        float cutoffAngle       = 1.0f - light.angle;
+        float theta             = dot(light_direction_angle[light.index].xyz, light.direction);
+        float epsilon           = cutoffAngle - cutoffAngle * 0.9f;
+        light.attenuation       = saturate((theta - cutoffAngle) / epsilon);
+        light.attenuation       *= saturate(1.0f - light.distance_to_pixel / light.range); light.attenuation *= light.attenuation;
+        #endif
+
+        return float4(VolumetricLighting(light, position, view_direction), 0.0f);
     }
-    #elif POINT
+    #elif PASS_TEMPORAL
     {
+        // tex is this frame's injection, tex2 the previous frame's result and g_transform the previous frame's view projection
+        float3 current  = tex.Load(int3(pixel, 0)).rgb;
+        float3 position = froxel_position(uv, froxel_slice_to_depth(froxel.z + 0.5f));
+
+        float4 position_clip_previous   = mul(float4(position, 1.0f), g_transform);
+        float2 uv_previous              = (position_clip_previous.xy / position_clip_previous.w) * float2(0.5f, -0.5f) + 0.5f;
+        float depth_previous            = position_clip_previous.w; // view depth, for a perspective projection
+
+        // Froxels which were outside of the previous frustum start over
         [branch]
-        if (light.distance_to_pixel < light.range)
-        {
-            uint projection_index = direction_to_cube_face_index(light.direction);
-            
-            // Compute position in clip space
-            float3 pos = project(ray_pos, light_view_projection[projection_index]);
-            
-            // Ray-march
-            fog = vl_raymarch(light, ray_pos, ray_step, ray_dot_light, projection_index);
-        }
+        if (!is_saturated(uv_previous) || depth_previous < g_camera_near)
+            return float4(current, 0.0f);
+
+        float3 history = froxel_sample(tex2, uv_previous, depth_previous);
+        return float4(lerp(current, history, g_vl_history_weight), 0.0f);
     }
-    #elif SPOT
+    #elif PASS_INTEGRATE
     {
-        [branch]
-        if (light.distance_to_pixel < light.range)
+        // Front to back, the light which the froxels up to this one scatter towards the camera, minus what is absorbed on the way
+        float3 scattering       = 0.0f;
+        float transmittance     = 1.0f;
+        float depth_front       = g_camera_near;
+
+        [loop]
+        for (uint slice = 0; slice <= froxel.z; slice++)
         {
-            // Compute position in clip space
-            float3 pos = project(ray_pos, light_view_projection[0]);
-            
-            // Ray-march
-            [branch]
-            if (is_saturated(pos))
-            {
-                fog = vl_raymarch(light, ray_pos, ray_step, ray_dot_light, 0);
-            }
+            float depth_back        = froxel_slice_to_depth(slice + 1.0f);
+            float slice_absorbed    = 1.0f - exp(-g_vl_density * (depth_back - depth_front));
+            float3 slice_light      = tex.Load(int3(froxel_to_atlas(uint3(froxel.xy, slice)), 0)).rgb;
+
+            scattering      += transmittance * slice_light * slice_absorbed;
+            transmittance   *= 1.0f - slice_absorbed;
+            depth_front     = depth_back;
         }
+
+        return float4(scattering, transmittance);
     }
     #endif
-    
-    return fog * light.color;
+
+    return 0.0f;
 }
@@ -85,6 +85,11 @@ void Editor::OnWindowMessage(WindowData& window_data)
         m_renderer      = m_context->GetSubsystem<Renderer>();
         m_profiler      = m_context->GetSubsystem<Profiler>();
         m_rhi_device    = m_renderer->GetRhiDevice();
+
+        // An idle editor shouldn't keep re-rendering the same frame
+        m_renderer->SetOption(Render_Idle, true);
+        // Moving the camera around is a preview, it doesn't need the full resolution
+        m_renderer->SetOptionValue(Option_Value_PreviewScale, 0.5f);
         
         if (m_renderer->IsInitialized())
         {
@@ -165,6 +170,7 @@ void Editor::OnTick()
     ImGui::NewFrame();
 
     // Editor - update
+    IconProvider::Get().Tick();
     Widgets_Tick();
 
     // ImGui - end frame
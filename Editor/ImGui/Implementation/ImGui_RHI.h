@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =========================
 #include <vector>
+#include <unordered_map>
 #include "ImGui_RHI.h"
 #include "../Source/imgui.h"
 #include "Rendering/Renderer.h"
@@ -55,8 +56,15 @@ namespace ImGui::RHI
 	// RHI resources
 	static shared_ptr<RHI_Device>				g_rhi_device;
 	static unique_ptr<RHI_Texture>				g_texture;
-	static vector<unique_ptr<RHI_VertexBuffer>>	g_vertex_buffers;
-	static vector<unique_ptr<RHI_IndexBuffer>>	g_index_buffers;
+
+	// Vertex and index buffers, a ring of them per swap chain (one for each of its command lists) so that a buffer
+	// is only written once the frame which reads from it has completed, and child windows don't overwrite the main window's
+	struct SwapChainBuffers
+	{
+		vector<unique_ptr<RHI_VertexBuffer>> vertex;
+		vector<unique_ptr<RHI_IndexBuffer>> index;
+	};
+	static unordered_map<const RHI_SwapChain*, SwapChainBuffers> g_buffers;
 	static unique_ptr<RHI_DepthStencilState>	g_depth_stencil_state;
 	static unique_ptr<RHI_RasterizerState>		g_rasterizer_state;
 	static unique_ptr<RHI_BlendState>			g_blend_state;
@@ -144,6 +152,7 @@ namespace ImGui::RHI
     inline void Shutdown()
     {
         DestroyPlatformWindows();
+        g_buffers.clear();
     }
 
 	inline void Render(ImDrawData* draw_data, RHI_SwapChain* swap_chain_other = nullptr, const bool clear = true)
@@ -183,21 +192,22 @@ namespace ImGui::RHI
         RHI_VertexBuffer* vertex_buffer = nullptr;
         RHI_IndexBuffer* index_buffer   = nullptr;
         {
-            uint32_t cmd_index = swap_chain->GetCmdIndex();
+            SwapChainBuffers& buffers   = g_buffers[swap_chain];
+            const uint32_t cmd_index    = swap_chain->GetCmdIndex();
 
-            if (cmd_index >= g_vertex_buffers.size())
+            while (cmd_index >= buffers.vertex.size())
             {
-                g_vertex_buffers.emplace_back(make_unique<RHI_VertexBuffer>(g_rhi_device, static_cast<uint32_t>(sizeof(ImDrawVert))));
-                g_index_buffers.emplace_back(make_unique<RHI_IndexBuffer>(g_rhi_device));
+                buffers.vertex.emplace_back(make_unique<RHI_VertexBuffer>(g_rhi_device, static_cast<uint32_t>(sizeof(ImDrawVert))));
+                buffers.index.emplace_back(make_unique<RHI_IndexBuffer>(g_rhi_device));
             }
 
-            vertex_buffer   = g_vertex_buffers[cmd_index].get();
-            index_buffer    = g_index_buffers[cmd_index].get();
+            vertex_buffer   = buffers.vertex[cmd_index].get();
+            index_buffer    = buffers.index[cmd_index].get();
 
-			// Grow vertex buffer as needed
+			// Grow vertex buffer as needed, with headroom so that a growing UI doesn't re-create it every few frames
 			if (vertex_buffer->GetVertexCount() < static_cast<unsigned int>(draw_data->TotalVtxCount))
 			{
-				const unsigned int new_size = draw_data->TotalVtxCount + 5000;
+				const unsigned int new_size = draw_data->TotalVtxCount + draw_data->TotalVtxCount / 2 + 5000;
 				if (!vertex_buffer->CreateDynamic<ImDrawVert>(new_size))
 					return;
 			}
@@ -205,12 +215,12 @@ namespace ImGui::RHI
 			// Grow index buffer as needed
 			if (index_buffer->GetIndexCount() < static_cast<unsigned int>(draw_data->TotalIdxCount))
 			{
-				const unsigned int new_size = draw_data->TotalIdxCount + 10000;
+				const unsigned int new_size = draw_data->TotalIdxCount + draw_data->TotalIdxCount / 2 + 10000;
 				if (!index_buffer->CreateDynamic<ImDrawIdx>(new_size))
 					return;
 			}
 
-			// Copy and convert all vertices into a single contiguous buffer		
+			// Copy and convert all vertices into a single contiguous buffer (the buffers stay mapped on Vulkan, see m_persistent_mapping)
 			auto vtx_dst = static_cast<ImDrawVert*>(vertex_buffer->Map());
 			auto idx_dst = static_cast<ImDrawIdx*>(index_buffer->Map());
 			if (vtx_dst && idx_dst)
@@ -284,11 +294,51 @@ namespace ImGui::RHI
             cmd_list->SetBufferVertex(vertex_buffer);
             cmd_list->SetBufferIndex(index_buffer);
 
+            // Consecutive commands which share the texture, the clip rectangle and the vertex offset, and whose indices follow
+            // each other, are drawn with a single call. The scissor rectangle and the texture are only set when they change.
+            struct Draw
+            {
+                RHI_Texture* texture    = nullptr;
+                ImVec4 clip_rect        = ImVec4(0.0f, 0.0f, 0.0f, 0.0f);
+                uint32_t index_offset   = 0;
+                uint32_t index_count    = 0;
+                uint32_t vertex_offset  = 0;
+            };
+            Draw draw;
+            Draw draw_previous;
+            bool draw_previous_valid    = false;
+            const auto& clip_off        = draw_data->DisplayPos;
+            const auto same_clip_rect   = [](const ImVec4& a, const ImVec4& b) { return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w; };
+            const auto flush            = [&]()
+            {
+                if (draw.index_count == 0)
+                    return;
+
+                if (!draw_previous_valid || !same_clip_rect(draw.clip_rect, draw_previous.clip_rect))
+                {
+                    Math::Rectangle scissor_rect;
+                    scissor_rect.left   = draw.clip_rect.x - clip_off.x;
+                    scissor_rect.top    = draw.clip_rect.y - clip_off.y;
+                    scissor_rect.right  = draw.clip_rect.z - clip_off.x;
+                    scissor_rect.bottom = draw.clip_rect.w - clip_off.y;
+                    cmd_list->SetScissorRectangle(scissor_rect);
+                }
+
+                if (!draw_previous_valid || draw.texture != draw_previous.texture)
+                {
+                    cmd_list->SetTexture(28, draw.texture);
+                }
+
+                cmd_list->DrawIndexed(draw.index_count, draw.index_offset, draw.vertex_offset);
+
+                draw_previous       = draw;
+                draw_previous_valid = true;
+                draw.index_count    = 0;
+            };
+
             // Render command lists
             int global_vtx_offset   = 0;
             int global_idx_offset   = 0;
-            const auto& clip_off    = draw_data->DisplayPos;
-            Math::Rectangle scissor_rect;
             for (auto i = 0; i < draw_data->CmdListsCount; i++)
             {
                 auto cmd_list_imgui = draw_data->CmdLists[i];
@@ -297,26 +347,42 @@ namespace ImGui::RHI
                     const auto pcmd = &cmd_list_imgui->CmdBuffer[cmd_i];
                     if (pcmd->UserCallback != nullptr)
                     {
+                        flush();
                         pcmd->UserCallback(cmd_list_imgui, pcmd);
+                        draw_previous_valid = false; // the callback can change any state
                     }
                     else
                     {
-                        // Compute scissor rectangle
-                        scissor_rect.left      = pcmd->ClipRect.x - clip_off.x;
-                        scissor_rect.top       = pcmd->ClipRect.y - clip_off.y;
-                        scissor_rect.right     = pcmd->ClipRect.z - clip_off.x;
-                        scissor_rect.bottom    = pcmd->ClipRect.w - clip_off.y;
-
-                        // Apply scissor rectangle, bind texture and draw
-                        cmd_list->SetScissorRectangle(scissor_rect);
-                        cmd_list->SetTexture(28, static_cast<RHI_Texture*>(pcmd->TextureId));
-                        cmd_list->DrawIndexed(pcmd->ElemCount, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset);
+                        RHI_Texture* texture            = static_cast<RHI_Texture*>(pcmd->TextureId);
+                        const uint32_t index_offset     = pcmd->IdxOffset + global_idx_offset;
+                        const uint32_t vertex_offset    = pcmd->VtxOffset + global_vtx_offset;
+
+                        const bool mergeable =
+                            draw.index_count != 0                               &&
+                            draw.texture == texture                             &&
+                            draw.vertex_offset == vertex_offset                 &&
+                            draw.index_offset + draw.index_count == index_offset &&
+                            same_clip_rect(draw.clip_rect, pcmd->ClipRect);
+
+                        if (mergeable)
+                        {
+                            draw.index_count += pcmd->ElemCount;
+                        }
+                        else
+                        {
+                            flush();
+                            draw.texture        = texture;
+                            draw.clip_rect      = pcmd->ClipRect;
+                            draw.index_offset   = index_offset;
+                            draw.index_count    = pcmd->ElemCount;
+                            draw.vertex_offset  = vertex_offset;
+                        }
                     }
-
                 }
                 global_idx_offset += cmd_list_imgui->IdxBuffer.Size;
                 global_vtx_offset += cmd_list_imgui->VtxBuffer.Size;
             }
+            flush();
 
             cmd_list->EndRenderPass();
         }
@@ -381,6 +447,7 @@ namespace ImGui::RHI
         if (!swap_chain)
             return;
 
+		g_buffers.erase(swap_chain);
 		safe_delete(swap_chain);
 		viewport->RendererUserData = nullptr;
 	}
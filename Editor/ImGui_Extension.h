@@ -59,13 +59,8 @@ public:
 
 	void LoadModel(const std::string& file_path) const
 	{
-		auto resource_cache = g_resource_cache;
-
 		// Load the model asynchronously
-		g_threading->AddTask([resource_cache, file_path]()
-		{
-			resource_cache->Load<Spartan::Model>(file_path);
-		});
+		g_resource_cache->LoadAsync<Spartan::Model>(file_path);
 	}
 
 	void LoadWorld(const std::string& file_path) const
@@ -79,7 +74,7 @@ public:
 		g_threading->AddTask([world, file_path]()
 		{
 			world->LoadFromFile(file_path);
-		});
+		}, {}, Spartan::Threading_Pool_Background);
 	}
 
 	void SaveWorld(const std::string& file_path) const
@@ -90,7 +85,7 @@ public:
 		g_threading->AddTask([world, file_path]()
 		{
 			world->SaveToFile(file_path);
-		});
+		}, {}, Spartan::Threading_Pool_Background);
 	}
 
 	void PickEntity()
@@ -177,11 +172,13 @@ namespace ImGuiEx
 
     inline void Image(const Thumbnail& thumbnail, const float size)
     {
+        Spartan::Math::Vector4 uv;
+        Spartan::RHI_Texture* texture = IconProvider::Get().GetTextureByThumbnail(thumbnail, &uv);
         ImGui::Image(
-            static_cast<ImTextureID>(IconProvider::Get().GetTextureByThumbnail(thumbnail)),
+            static_cast<ImTextureID>(texture),
             ImVec2(size, size),
-            ImVec2(0, 0),
-            ImVec2(1, 1),
+            ImVec2(uv.x, uv.y),
+            ImVec2(uv.z, uv.w),
             default_tint,		    // tint
             ImColor(0, 0, 0, 0)		// border
         );
@@ -316,7 +313,8 @@ namespace ImGuiEx
         {
             try
             {
-                if (const auto tex = EditorHelper::Get().g_resource_cache->Load<Spartan::RHI_Texture2D>(std::get<const char*>(payload->data)))
+                // The texture is set right away, it shows up once it's loaded
+                if (const auto tex = EditorHelper::Get().g_resource_cache->LoadAsync<Spartan::RHI_Texture2D>(std::get<const char*>(payload->data)))
                 {
                     setter(tex);
                 }
@@ -58,14 +58,18 @@ void Widget_Console::Tick()
 		if (ImGuiEx::ImageButton(icon, 15.0f))
 		{
             visibility = !visibility;
+            LogsFilter();
             m_scroll_to_bottom = true;
 		}
 		ImGui::PopStyleColor();
 		ImGui::SameLine();
-        ImGui::Text("%d", m_log_type_count[index]);
+        ImGui::Text("%d", m_log_type_count[index].load());
         ImGui::SameLine();
 	};
 
+	// Pick up the packages which were logged since the last frame
+	LogsUpdate();
+
 	// Log category visibility buttons
 	button_log_type_visibility_toggle(Icon_Console_Info,       0);
 	button_log_type_visibility_toggle(Icon_Console_Warning,    1);
@@ -73,7 +77,10 @@ void Widget_Console::Tick()
 
 	// Text filter
     const float label_width = 37.0f; //ImGui::CalcTextSize("Filter", nullptr, true).x;
-	m_log_filter.Draw("Filter", ImGui::GetContentRegionAvail().x - label_width);
+	if (m_log_filter.Draw("Filter", ImGui::GetContentRegionAvail().x - label_width))
+    {
+        LogsFilter();
+    }
 	ImGui::Separator();
 
 	// Content
@@ -90,43 +97,35 @@ void Widget_Console::Tick()
         max_log_width = Math::Helper::Max(max_log_width, ImGui::GetWindowContentRegionWidth());
         ImGui::PushItemWidth(max_log_width);
 
-        // Wait for reading to finish
-        while (m_is_reading)
+        // Only the visible rows are drawn
+        ImGuiListClipper clipper(static_cast<int>(m_logs_filtered.size()));
+        while (clipper.Step())
         {
-            this_thread::sleep_for(std::chrono::milliseconds(16));
-        }
-
-        uint32_t index = 0;
-        m_is_reading = true;
-        for (LogPackage& log : m_logs)
-        {
-            if (m_log_filter.PassFilter(log.text.c_str()))
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
             {
-                if (m_log_type_visibility[log.error_level])
+                LogPackage& log = m_logs[m_logs_filtered[row] % m_log_max_count];
+
+                // Log entry
+                ImGui::PushID(row);
+                ImGui::BeginGroup();
                 {
-                    // Log entry
-                    ImGui::BeginGroup();
+                    ImGui::PushStyleColor(ImGuiCol_Text, m_log_type_color[log.error_level]);            // text color
+                    ImGui::PushStyleColor(ImGuiCol_FrameBg, row % 2 != 0 ? color_odd : color_even);     // background color
+                    ImGui::InputText("##log", &log.text, ImGuiInputTextFlags_ReadOnly);
+                    ImGui::PopStyleColor(2);
+
+                    ImGui::EndGroup();
+
+                    // Trigger context menu
+                    if (ImGui::IsMouseClicked(1) && ImGui::IsItemHovered(ImGuiHoveredFlags_RectOnly))
                     {
-                        ImGui::PushStyleColor(ImGuiCol_Text, m_log_type_color[log.error_level]);            // text color
-                        ImGui::PushStyleColor(ImGuiCol_FrameBg, index % 2 != 0 ? color_odd : color_even);   // background color
-                        ImGui::InputText("##log", &log.text, ImGuiInputTextFlags_ReadOnly);
-                        ImGui::PopStyleColor(2);
-
-                        ImGui::EndGroup();
-
-                        // Trigger context menu
-                        if (ImGui::IsMouseClicked(1) && ImGui::IsItemHovered(ImGuiHoveredFlags_RectOnly))
-                        {
-                            m_log_selected = log;
-                            ImGui::OpenPopup("##ConsoleContextMenu");
-                        }
+                        m_log_selected = log;
+                        ImGui::OpenPopup("##ConsoleContextMenu");
                     }
-
-                    index++;
                 }
+                ImGui::PopID();
             }
         }
-        m_is_reading = false;
 
         ImGui::PopItemWidth();
 
@@ -163,42 +162,27 @@ void Widget_Console::Tick()
 
 void Widget_Console::AddLogPackage(const LogPackage& package)
 {
-    // Wait for reading to finish
-    while (m_is_reading) {}
-
-    // Save to deque
-	m_logs.push_back(package);
-	if (static_cast<uint32_t>(m_logs.size()) > m_log_max_count)
-	{
-		m_logs.pop_front();
-	}
-
-    // Update count
     m_log_type_count[package.error_level]++;
 
-    // Compute max width
-    float& width = m_log_type_max_width[package.error_level];
-    if (ImGui::GetCurrentContext()->Font)
-    {
-        width = Math::Helper::Max(width, ImGui::CalcTextSize(package.text.c_str()).x + 10);
-    }
-    else
-    {
-        // During startup, the font can be null, so compute a poor man's width
-        width = Math::Helper::Max(width, package.text.size() * 23.0f);
-    }
-
-    // If the user is displaying this type of messages, scroll to bottom
-    if (m_log_type_visibility[package.error_level])
+    lock_guard<mutex> lock(m_logs_pending_mutex);
+    m_logs_pending.emplace_back(package);
+    if (m_logs_pending.size() > m_log_max_count)
     {
-        m_scroll_to_bottom = true;
+        m_logs_pending.pop_front();
     }
 }
 
 void Widget_Console::Clear()
 {
+    {
+        lock_guard<mutex> lock(m_logs_pending_mutex);
+        m_logs_pending.clear();
+    }
+
 	m_logs.clear();
 	m_logs.shrink_to_fit();
+    m_logs_filtered.clear();
+    m_log_count = 0;
 
     m_log_type_max_width[0] = 0;
     m_log_type_max_width[1] = 0;
@@ -208,3 +192,68 @@ void Widget_Console::Clear()
     m_log_type_count[1] = 0;
     m_log_type_count[2] = 0;
 }
+
+void Widget_Console::LogsUpdate()
+{
+    deque<LogPackage> packages;
+    {
+        lock_guard<mutex> lock(m_logs_pending_mutex);
+        packages.swap(m_logs_pending);
+    }
+
+    if (packages.empty())
+        return;
+
+    m_logs.resize(m_log_max_count);
+
+    for (LogPackage& package : packages)
+    {
+        const uint32_t error_level = package.error_level;
+
+        // Compute max width
+        float& width = m_log_type_max_width[error_level];
+        width = Math::Helper::Max(width, ImGui::CalcTextSize(package.text.c_str()).x + 10);
+
+        // Save to the ring, overwriting the oldest package (once it's full)
+        const uint64_t log_index = m_log_count++;
+        const bool passes_filter = LogPassesFilter(package);
+        m_logs[log_index % m_log_max_count] = move(package);
+
+        if (passes_filter)
+        {
+            m_logs_filtered.emplace_back(log_index);
+        }
+
+        // If the user is displaying this type of messages, scroll to bottom
+        if (m_log_type_visibility[error_level])
+        {
+            m_scroll_to_bottom = true;
+        }
+    }
+
+    // Drop the packages which were overwritten
+    const uint64_t log_oldest = m_log_count > m_log_max_count ? m_log_count - m_log_max_count : 0;
+    while (!m_logs_filtered.empty() && m_logs_filtered.front() < log_oldest)
+    {
+        m_logs_filtered.pop_front();
+    }
+}
+
+bool Widget_Console::LogPassesFilter(const LogPackage& log) const
+{
+    return m_log_type_visibility[log.error_level] && m_log_filter.PassFilter(log.text.c_str());
+}
+
+void Widget_Console::LogsFilter()
+{
+    m_logs_filtered.clear();
+
+    const uint64_t log_oldest = m_log_count > m_log_max_count ? m_log_count - m_log_max_count : 0;
+    for (uint64_t log_index = log_oldest; log_index < m_log_count; log_index++)
+    {
+        if (LogPassesFilter(m_logs[log_index % m_log_max_count]))
+        {
+            m_logs_filtered.emplace_back(log_index);
+        }
+    }
+}
@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <functional>
 #include <deque>
+#include <mutex>
 #include <atomic>
 #include "Logging/ILogger.h"
 //==========================
@@ -63,24 +64,36 @@ class Widget_Console : public Widget
 public:
 	Widget_Console(Editor* editor);
 	void Tick() override;
+	// Can be called from any thread, the packages are picked up by the next Tick()
 	void AddLogPackage(const LogPackage& package);
 	void Clear();
 
 private:
+    void LogsUpdate();
+    bool LogPassesFilter(const LogPackage& log) const;
+    void LogsFilter();
+
     bool m_scroll_to_bottom         = false;
-    uint32_t m_log_max_count        = 1000;
+    uint32_t m_log_max_count        = 10000;
     float m_log_type_max_width[3]   = { 0, 0, 0 };
     bool m_log_type_visibility[3]   = { true, true, true };
-    uint32_t m_log_type_count[3]    = { 0, 0, 0 };
+    std::atomic<uint32_t> m_log_type_count[3] = { 0, 0, 0 }; // counted as they are logged, even the ones which were dropped
     const std::vector<Spartan::Math::Vector4> m_log_type_color =
     {
         Spartan::Math::Vector4(0.76f, 0.77f, 0.8f, 1.0f),	// Info
         Spartan::Math::Vector4(0.7f, 0.75f, 0.0f, 1.0f),	// Warning
         Spartan::Math::Vector4(0.7f, 0.3f, 0.3f, 1.0f)	    // Error
     };
-    std::atomic<bool> m_is_reading = false;
     std::shared_ptr<EngineLogger> m_logger;
-    std::deque<LogPackage> m_logs;
+
+    // Logs, a ring of m_log_max_count packages (the oldest are overwritten). Package n (counting from the first one
+    // since the last clear) is at n % m_log_max_count, the packages which pass the filter are listed by n, so that only
+    // new packages are filtered and only the visible rows are drawn.
+    std::vector<LogPackage> m_logs;
+    uint64_t m_log_count = 0;
+    std::deque<uint64_t> m_logs_filtered;
+    std::deque<LogPackage> m_logs_pending; // bounded too, the console doesn't tick while it's hidden
+    std::mutex m_logs_pending_mutex;
     ImGuiTextFilter m_log_filter;
     LogPackage m_log_selected;
 };
@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../WidgetsDeferred/FileDialog.h"
 #include "Core/Settings.h"
 #include "Rendering/Model.h"
+#include "IO/Archive.h"
+#include "Resource/ResourceCache.h"
 //========================================
 
 //= NAMESPACES ==========
@@ -83,6 +85,25 @@ void Widget_MenuBar::Tick()
 				_Widget_MenuBar::g_fileDialogVisible = true;
 			}
 
+			ImGui::Separator();
+
+			// Saves the world in cells, which stream in and out around the camera
+			bool streaming = _Widget_MenuBar::world->GetStreaming();
+			if (ImGui::MenuItem("Streaming", nullptr, &streaming))
+			{
+				_Widget_MenuBar::world->SetStreaming(streaming);
+			}
+
+			ImGui::Separator();
+
+			// Packs the project's engine files into an archive, to ship it, place it next to the executable (the editor doesn't mount it)
+			if (ImGui::MenuItem("Pack Project"))
+			{
+				const string directory = m_context->GetSubsystem<ResourceCache>()->GetProjectDirectory();
+				FileSystem::CreateDirectory_("Build/");
+				Archive::Build(directory, "Build/project" + string(EXTENSION_ARCHIVE));
+			}
+
 			ImGui::EndMenu();
 		}
 
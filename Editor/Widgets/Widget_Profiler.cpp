@@ -24,6 +24,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Math/Vector3.h"
 #include "Core/Context.h"
 #include "Math/Vector2.h"
+#include "Profiling/MemoryTracker.h"
+#include "Core/FrameArena.h"
+#include "Rendering/RenderGraph.h"
+#include "Profiling/FrameCapture.h"
 //==========================
 
 //= NAMESPACES =========
@@ -32,6 +36,30 @@ using namespace Spartan;
 using namespace Math;
 //======================
 
+namespace _Widget_Profiler
+{
+	// A block of the timeline or the flame graph, colored by its name so that it's recognizable across frames
+	inline void draw_block(ImDrawList* draw_list, const ImVec2& min, const ImVec2& max, const StringId& name, const float duration)
+	{
+		const uint32_t hash = name.GetHash();
+		draw_list->AddRectFilled(min, max, IM_COL32(70 + hash % 110, 70 + (hash >> 8) % 110, 70 + (hash >> 16) % 110, 255));
+		draw_list->AddRect(min, max, IM_COL32(0, 0, 0, 100));
+
+		// Label, only when there is room for some of it
+		if (max.x - min.x > 20.0f)
+		{
+			draw_list->PushClipRect(min, max, true);
+			draw_list->AddText(ImVec2(min.x + 3.0f, min.y), IM_COL32(255, 255, 255, 255), name.c_str());
+			draw_list->PopClipRect();
+		}
+
+		if (ImGui::IsMouseHoveringRect(min, max))
+		{
+			ImGui::SetTooltip("%s - %.3f ms", name.c_str(), duration);
+		}
+	}
+}
+
 Widget_Profiler::Widget_Profiler(Editor* editor) : Widget(editor)
 {
 	m_flags         |= ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoScrollbar;
@@ -51,20 +79,85 @@ void Widget_Profiler::Tick()
 	ImGui::SameLine();
 	ImGui::RadioButton("GPU", &item_type, 1);
 	ImGui::SameLine();
+	ImGui::RadioButton("Memory", &item_type, 2);
+	ImGui::SameLine();
+	ImGui::RadioButton("Timeline", &item_type, 3);
+	ImGui::SameLine();
+	ImGui::RadioButton("Flame graph", &item_type, 4);
+	ImGui::SameLine();
+	ImGui::RadioButton("Counters", &item_type, 5);
+	ImGui::SameLine();
+	ImGui::RadioButton("Benchmark", &item_type, 6);
+	ImGui::SameLine();
 	float interval = m_profiler->GetUpdateInterval();
 	ImGui::DragFloat("Update interval (The smaller the interval the higher the performance impact)", &interval, 0.001f, 0.0f, 0.5f);
 	m_profiler->SetUpdateInterval(interval);
+
+	// Trace capture
+	bool capturing = m_profiler->IsTraceCapturing();
+	if (ImGui::Checkbox("Capture trace", &capturing))
+	{
+		if (capturing)	m_profiler->TraceCaptureStart();
+		else			m_profiler->TraceCaptureStop();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Export trace"))
+	{
+		m_profiler->TraceExport("profiler_trace.json");
+	}
+	ImGui::SameLine();
+	ImGui::Text("%d time blocks", m_profiler->GetTraceEventCount());
+	bool hitches = m_profiler->IsHitchCapturing();
+	if (ImGui::Checkbox("Capture hitches", &hitches))
+	{
+		m_profiler->SetHitchCapture(hitches);
+	}
+	ImGui::SameLine();
+	ImGui::Text("%d reports", m_profiler->GetHitchCount());
+	FrameCapture* frame_capture = m_context->GetSubsystem<FrameCapture>();
+	bool recording = frame_capture->IsRecording();
+	if (ImGui::Checkbox("Capture frames (for the runner to replay)", &recording))
+	{
+		if (recording)	frame_capture->RecordStart("frame_capture.fcap");
+		else			frame_capture->RecordStop();
+	}
+	if (recording)
+	{
+		ImGui::SameLine();
+		ImGui::Text("%d frames", static_cast<uint32_t>(frame_capture->GetFrames().size()));
+	}
 	ImGui::Separator();
-    const bool show_cpu = (item_type == 0);
 
-	if (show_cpu)
+	FrameCapture();
+
+	if (item_type == 0)
 	{
 		ShowCPU();
 	}
-	else
+	else if (item_type == 1)
 	{
 		ShowGPU();
 	}
+	else if (item_type == 2)
+	{
+		ShowMemory();
+	}
+	else if (item_type == 3)
+	{
+		ShowTimeline();
+	}
+	else if (item_type == 4)
+	{
+		ShowFlameGraph();
+	}
+	else if (item_type == 5)
+	{
+		ShowCounters();
+	}
+	else
+	{
+		ShowBenchmark();
+	}
 }
 
 void Widget_Profiler::ShowCPU()
@@ -74,15 +167,34 @@ void Widget_Profiler::ShowCPU()
 	const auto time_block_count = static_cast<unsigned int>(time_blocks.size());
 	const auto time_cpu			= m_profiler->GetTimeCpuLast();	
 
-	// Time blocks	
+	// Time blocks (grouped by thread)
+	thread::id thread_id;
 	for (unsigned int i = 0; i < time_block_count; i++)
 	{
         if (time_blocks[i].GetType() != TimeBlock_Cpu)
             continue;
 
+        if (time_blocks[i].GetThreadId() != thread_id)
+        {
+            thread_id = time_blocks[i].GetThreadId();
+            ImGui::TextDisabled("%s", m_profiler->GetThreadName(thread_id).c_str());
+        }
+
         ShowTimeBlock(time_blocks[i], time_cpu);
 	}
 
+	// Time samples (script calls, by class and method)
+	const auto& time_samples = m_profiler->GetTimeSamples();
+	if (!time_samples.empty())
+	{
+		ImGui::Separator();
+		ImGui::Text("Scripts");
+		for (const TimeSample& time_sample : time_samples)
+		{
+			ShowTimeSample(time_sample, time_cpu);
+		}
+	}
+
 	ImGui::Separator();
 	ShowPlot(m_plot_times_cpu, m_metric_cpu, time_cpu, m_profiler->IsCpuStuttering());
 }
@@ -113,6 +225,138 @@ void Widget_Profiler::ShowGPU()
     const unsigned int memory_available	= m_profiler->GpuGetMemoryAvailable();
     const string overlay                = "Memory " + to_string(memory_used) + "/" + to_string(memory_available) + " MB";
 	ImGui::ProgressBar((float)memory_used / (float)memory_available, ImVec2(-1, 0), overlay.c_str());
+
+    // Budget and memory pools (only reported by backends which allocate from pools)
+    if (const unsigned int memory_budget = m_profiler->GpuGetMemoryBudget())
+    {
+        ImGui::Text("Budget: %u MB", memory_budget);
+
+        static const char* pool_names[RHI_Memory_Pool_Count] = { "Render targets", "Textures", "Geometry", "Staging" };
+        const auto& pools = m_profiler->GpuGetMemoryPoolStats();
+
+        ImGui::Columns(6, "##widget_profiler_memory_pools");
+        ImGui::Text("Pool");        ImGui::NextColumn();
+        ImGui::Text("Used (MB)");   ImGui::NextColumn();
+        ImGui::Text("Size (MB)");   ImGui::NextColumn();
+        ImGui::Text("Allocations"); ImGui::NextColumn();
+        ImGui::Text("Blocks");      ImGui::NextColumn();
+        ImGui::Text("Free ranges"); ImGui::NextColumn();
+        ImGui::Separator();
+        for (uint32_t i = 0; i < RHI_Memory_Pool_Count; i++)
+        {
+            ImGui::Text("%s", pool_names[i]);                                                   ImGui::NextColumn();
+            ImGui::Text("%.1f", static_cast<double>(pools[i].used) / 1024.0 / 1024.0);         ImGui::NextColumn();
+            ImGui::Text("%.1f", static_cast<double>(pools[i].size) / 1024.0 / 1024.0);         ImGui::NextColumn();
+            ImGui::Text("%u", pools[i].allocation_count);                                       ImGui::NextColumn();
+            ImGui::Text("%u", pools[i].block_count);                                            ImGui::NextColumn();
+            ImGui::Text("%u", pools[i].free_range_count);                                       ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+    }
+}
+
+void Widget_Profiler::ShowMemory() const
+{
+	ImGui::Text("Frame arena: %.2f KB last frame, %.2f MB reserved", FrameArena::GetBytesFrame() / 1024.0, FrameArena::GetBytesReserved() / 1048576.0);
+	ImGui::Separator();
+
+	if (!MemoryTracker::IsEnabled())
+	{
+		ImGui::Text("Memory tracking is disabled (SPARTAN_MEMORY_TRACKING)");
+		return;
+	}
+
+	ImGui::Columns(5, "##widget_profiler_memory");
+	ImGui::Text("Tag");					ImGui::NextColumn();
+	ImGui::Text("Live (MB)");			ImGui::NextColumn();
+	ImGui::Text("Allocations");			ImGui::NextColumn();
+	ImGui::Text("Allocations/frame");	ImGui::NextColumn();
+	ImGui::Text("Budget (MB)");			ImGui::NextColumn();
+	ImGui::Separator();
+
+	Memory_Tag_Stats total;
+	for (uint8_t i = 0; i < Memory_Tag_Count; i++)
+	{
+		const Memory_Tag tag			= static_cast<Memory_Tag>(i);
+		const Memory_Tag_Stats stats	= MemoryTracker::GetStats(tag);
+		const bool over_budget			= stats.budget != 0 && stats.bytes > static_cast<int64_t>(stats.budget);
+		const ImVec4 color				= over_budget ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImGui::GetStyle().Colors[ImGuiCol_Text];
+
+		ImGui::TextColored(color, "%s", MemoryTracker::GetTagName(tag));	ImGui::NextColumn();
+		ImGui::TextColored(color, "%.2f", stats.bytes / 1048576.0);			ImGui::NextColumn();
+		ImGui::Text("%lld", stats.allocations);								ImGui::NextColumn();
+		ImGui::Text("%llu", stats.allocations_frame);						ImGui::NextColumn();
+		if (stats.budget != 0)	ImGui::Text("%.0f", stats.budget / 1048576.0);
+		else					ImGui::Text("-");
+		ImGui::NextColumn();
+
+		total.bytes				+= stats.bytes;
+		total.allocations		+= stats.allocations;
+		total.allocations_frame	+= stats.allocations_frame;
+	}
+
+	ImGui::Separator();
+	ImGui::Text("Total");							ImGui::NextColumn();
+	ImGui::Text("%.2f", total.bytes / 1048576.0);	ImGui::NextColumn();
+	ImGui::Text("%lld", total.allocations);			ImGui::NextColumn();
+	ImGui::Text("%llu", total.allocations_frame);	ImGui::NextColumn();
+	ImGui::NextColumn();
+	ImGui::Columns(1);
+}
+
+void Widget_Profiler::ShowCounters() const
+{
+	ImGui::Columns(3, "##widget_profiler_counters");
+	ImGui::Text("Counter");	ImGui::NextColumn();
+	ImGui::Text("Value");	ImGui::NextColumn();
+	ImGui::Text("Type");	ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (const CounterValue& counter : m_profiler->GetCounters())
+	{
+		ImGui::Text("%s", counter.counter->name.c_str());										ImGui::NextColumn();
+		ImGui::Text("%lld %s", counter.value, counter.counter->unit.c_str());					ImGui::NextColumn();
+		ImGui::Text("%s", counter.counter->type == Counter_PerFrame ? "per frame" : "cumulative");	ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+}
+
+void Widget_Profiler::ShowBenchmark()
+{
+	RenderGraph* render_graph = m_context->GetSubsystem<Renderer>()->GetRenderGraph();
+	if (!render_graph)
+		return;
+
+	// The passes of the last frame
+	const vector<const char*>& pass_names = render_graph->GetPassNames();
+	if (pass_names.empty())
+		return;
+	m_benchmark_pass = Helper::Clamp(m_benchmark_pass, 0, static_cast<int>(pass_names.size()) - 1);
+
+	ImGui::Combo("Pass", &m_benchmark_pass, pass_names.data(), static_cast<int>(pass_names.size()));
+	ImGui::InputInt("Repetitions per frame", &m_benchmark_repetitions);
+	m_benchmark_repetitions = Helper::Clamp(m_benchmark_repetitions, 1, 256);
+
+	if (ImGui::Button(render_graph->IsBenchmarking() ? "Restart" : "Start"))
+	{
+		render_graph->BenchmarkStart(pass_names[m_benchmark_pass], static_cast<uint32_t>(m_benchmark_repetitions));
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Stop"))
+	{
+		render_graph->BenchmarkStop();
+	}
+	ImGui::Separator();
+
+	if (!render_graph->IsBenchmarking())
+	{
+		ImGui::Text("Executes a pass again, with the inputs it just had, and times every execution on the GPU");
+		return;
+	}
+
+	const RenderGraph::BenchmarkResult result = render_graph->GetBenchmarkResult();
+	ImGui::Text("%s, %d samples", result.pass.c_str(), result.samples);
+	ImGui::Text("Min: %.3f ms, Median: %.3f ms, Max: %.3f ms", result.min, result.median, result.max);
 }
 
 void Widget_Profiler::ShowTimeBlock(const TimeBlock& time_block, float total_time) const
@@ -134,6 +378,41 @@ void Widget_Profiler::ShowTimeBlock(const TimeBlock& time_block, float total_tim
     // Text
     ImGui::SetCursorPos(ImVec2(pos.x + m_tree_depth_stride * time_block.GetTreeDepth(), pos.y));
     ImGui::Text("%s - %.2f ms", name, duration);
+
+    // Pipeline statistics
+    if (const RHI_Pipeline_Statistics* statistics = time_block.GetPipelineStatistics())
+    {
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip
+            (
+                "Primitives:\t\t%llu\nVertex invocations:\t%llu\nClipping:\t\t%llu in, %llu out\nPixel invocations:\t%llu\nCompute invocations:\t%llu",
+                statistics->input_assembly_primitives,
+                statistics->vertex_invocations,
+                statistics->clipping_invocations,
+                statistics->clipping_primitives,
+                statistics->pixel_invocations,
+                statistics->compute_invocations
+            );
+        }
+    }
+}
+
+void Widget_Profiler::ShowTimeSample(const TimeSample& time_sample, float total_time) const
+{
+    const char* name        = time_sample.name.c_str();
+    const float fraction    = time_sample.duration / total_time;
+    const float width       = fraction * ImGui::GetWindowContentRegionWidth();
+    const auto& color       = ImGui::GetStyle().Colors[ImGuiCol_FrameBgActive];
+    const ImVec2 pos_screen = ImGui::GetCursorScreenPos();
+    const ImVec2 pos        = ImGui::GetCursorPos();
+    const float text_height = ImGui::CalcTextSize(name, nullptr, true).y;
+
+    // Rectangle
+    ImGui::GetWindowDrawList()->AddRectFilled(pos_screen, ImVec2(pos_screen.x + width, pos_screen.y + text_height), IM_COL32(color.x * 255, color.y * 255, color.z * 255, 255));
+    // Text
+    ImGui::SetCursorPos(ImVec2(pos.x + m_tree_depth_stride, pos.y));
+    ImGui::Text("%s - %.2f ms (%u calls)", name, time_sample.duration, time_sample.count);
 }
 
 void Widget_Profiler::ShowPlot(vector<float>& data, Metric& metric, float time_value, bool is_stuttering) const
@@ -159,3 +438,283 @@ void Widget_Profiler::ShowPlot(vector<float>& data, Metric& metric, float time_v
 	// Plot data
 	ImGui::PlotLines("", data.data(), static_cast<int>(data.size()), 0, "", metric.m_min, metric.m_max, ImVec2(ImGui::GetWindowContentRegionWidth(), 80));
 }
+
+void Widget_Profiler::ShowTimeline()
+{
+	if (!ShowFrameScrubber())
+		return;
+
+	const ProfilerFrame* frame = FrameGet(static_cast<uint32_t>(m_frame_selected));
+	ImGui::Text("Frame: %.2f ms", frame->duration);
+	ImGui::SameLine();
+	ImGui::PushItemWidth(200.0f);
+	ImGui::SliderFloat("Zoom", &m_timeline_zoom, 1.0f, 50.0f, "%.1fx");
+	ImGui::PopItemWidth();
+
+	// Every lane gets a row per tree depth
+	const float row_height	= ImGui::GetTextLineHeightWithSpacing();
+	const float lane_gap	= 4.0f;
+	const float label_width	= 120.0f;
+	vector<float> lane_y(m_lanes.size());
+	float height = 0.0f;
+	for (uint32_t i = 0; i < m_lanes.size(); i++)
+	{
+		lane_y[i]	= height;
+		height		+= (m_lanes[i].depth_max + 1) * row_height + lane_gap;
+	}
+
+	if (ImGui::BeginChild("##widget_profiler_timeline", ImVec2(ImGui::GetWindowContentRegionWidth(), Helper::Min(height + 20.0f, 500.0f)), true, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		const float width		= (ImGui::GetWindowContentRegionWidth() - label_width) * m_timeline_zoom;
+		const float ms_to_px	= width / Helper::Max(frame->duration, 0.001f);
+		const ImVec2 origin		= ImGui::GetCursorScreenPos();
+		ImDrawList* draw_list	= ImGui::GetWindowDrawList();
+
+		for (const ProfilerFrameBlock& block : frame->blocks)
+		{
+			const ImVec2 min = ImVec2(origin.x + label_width + block.start * ms_to_px, origin.y + lane_y[block.lane] + block.depth * row_height);
+			const ImVec2 max = ImVec2(min.x + Helper::Max(block.duration * ms_to_px, 1.0f), min.y + row_height - 1.0f);
+			if (!ImGui::IsRectVisible(min, max))
+				continue;
+
+			_Widget_Profiler::draw_block(draw_list, min, max, block.name, block.duration);
+		}
+
+		// Lane names, over the blocks so that they stay readable when scrolled
+		const float scroll_x = ImGui::GetScrollX();
+		for (uint32_t i = 0; i < m_lanes.size(); i++)
+		{
+			const ImVec2 min = ImVec2(origin.x + scroll_x, origin.y + lane_y[i]);
+			draw_list->AddRectFilled(min, ImVec2(min.x + label_width - 4.0f, min.y + (m_lanes[i].depth_max + 1) * row_height), IM_COL32(30, 30, 30, 230));
+			draw_list->AddText(ImVec2(min.x + 3.0f, min.y), IM_COL32(200, 200, 200, 255), m_lanes[i].name.c_str());
+		}
+
+		ImGui::Dummy(ImVec2(label_width + width, height));
+	}
+	ImGui::EndChild();
+}
+
+void Widget_Profiler::ShowFlameGraph()
+{
+	if (!ShowFrameScrubber() || m_lanes.empty())
+		return;
+
+	// Lane and the number of frames to aggregate
+	m_flame_lane = Helper::Clamp(m_flame_lane, 0, static_cast<int>(m_lanes.size()) - 1);
+	ImGui::PushItemWidth(200.0f);
+	ImGui::Combo("Lane", &m_flame_lane, [](void* data, const int index, const char** text)
+	{
+		*text = static_cast<const vector<ProfilerLane>*>(data)->at(index).name.c_str();
+		return true;
+	}, &m_lanes, static_cast<int>(m_lanes.size()));
+	ImGui::SameLine();
+	ImGui::SliderInt("Frames", &m_flame_frames, 1, static_cast<int>(m_frame_capacity));
+	ImGui::PopItemWidth();
+
+	// Merge the blocks of the lane by call path, over the selected frame and the ones before it
+	m_flame_nodes.clear();
+	m_flame_nodes.emplace_back(); // root
+	vector<uint32_t> path; // the node of each tree depth
+	uint32_t frames = 0;
+	for (; frames < static_cast<uint32_t>(m_flame_frames); frames++)
+	{
+		const ProfilerFrame* frame = FrameGet(m_frame_selected + frames);
+		if (!frame)
+			break;
+
+		for (const ProfilerFrameBlock& block : frame->blocks)
+		{
+			if (block.lane != static_cast<uint32_t>(m_flame_lane))
+				continue;
+
+			// Blocks come in the order they started, so a parent is always on the path before its children
+			path.resize(block.depth, 0);
+			const uint32_t parent = block.depth == 0 ? 0 : path[block.depth - 1];
+
+			uint32_t node = 0;
+			for (const uint32_t child : m_flame_nodes[parent].children)
+			{
+				if (m_flame_nodes[child].name == block.name)
+				{
+					node = child;
+					break;
+				}
+			}
+
+			if (node == 0)
+			{
+				node = static_cast<uint32_t>(m_flame_nodes.size());
+				m_flame_nodes.emplace_back().name = block.name;
+				m_flame_nodes[parent].children.emplace_back(node);
+			}
+
+			m_flame_nodes[node].duration += block.duration;
+			if (parent == 0)
+			{
+				m_flame_nodes[0].duration += block.duration;
+			}
+			path.emplace_back(node);
+		}
+	}
+
+	// Average
+	for (ProfilerFlameNode& node : m_flame_nodes)
+	{
+		node.duration /= static_cast<float>(Helper::Max(frames, 1u));
+	}
+
+	ImGui::Text("%.2f ms per frame, averaged over %u frames", m_flame_nodes[0].duration, frames);
+
+	const float row_height	= ImGui::GetTextLineHeightWithSpacing();
+	const float height		= (m_lanes[m_flame_lane].depth_max + 1) * row_height;
+	if (ImGui::BeginChild("##widget_profiler_flame_graph", ImVec2(ImGui::GetWindowContentRegionWidth(), Helper::Min(height + 20.0f, 500.0f)), true))
+	{
+		const float width		= ImGui::GetWindowContentRegionWidth();
+		const ImVec2 origin		= ImGui::GetCursorScreenPos();
+		ShowFlameNode(0, origin.x, origin.y, width / Helper::Max(m_flame_nodes[0].duration, 0.001f));
+		ImGui::Dummy(ImVec2(width, height));
+	}
+	ImGui::EndChild();
+}
+
+void Widget_Profiler::ShowFlameNode(const uint32_t node_index, float x, const float y, const float ms_to_px) const
+{
+	const float row_height = ImGui::GetTextLineHeightWithSpacing();
+	for (const uint32_t child : m_flame_nodes[node_index].children)
+	{
+		const ProfilerFlameNode& node	= m_flame_nodes[child];
+		const float width				= node.duration * ms_to_px;
+		if (width >= 1.0f)
+		{
+			_Widget_Profiler::draw_block(ImGui::GetWindowDrawList(), ImVec2(x, y), ImVec2(x + width, y + row_height - 1.0f), node.name, node.duration);
+			ShowFlameNode(child, x, y + row_height, ms_to_px);
+		}
+		x += width;
+	}
+}
+
+bool Widget_Profiler::ShowFrameScrubber()
+{
+	const uint32_t frame_count = static_cast<uint32_t>(Helper::Min(m_frame_count, static_cast<uint64_t>(m_frame_capacity)));
+	if (frame_count == 0)
+	{
+		ImGui::Text("No profiled frames yet");
+		return false;
+	}
+	m_frame_selected = Helper::Clamp(m_frame_selected, 0, static_cast<int>(frame_count) - 1);
+
+	// The duration of every kept frame, the oldest first
+	vector<float> durations(frame_count);
+	for (uint32_t i = 0; i < frame_count; i++)
+	{
+		durations[i] = FrameGet(frame_count - 1 - i)->duration;
+	}
+
+	ImGui::Checkbox("Pause", &m_frame_paused);
+	ImGui::SameLine();
+	ImGui::PushItemWidth(200.0f);
+	ImGui::SliderInt("##widget_profiler_frame", &m_frame_selected, 0, static_cast<int>(frame_count) - 1, "%d frames ago");
+	ImGui::PopItemWidth();
+
+	ImGui::PlotHistogram("##widget_profiler_frames", durations.data(), static_cast<int>(frame_count), 0, nullptr, 0.0f, FLT_MAX, ImVec2(ImGui::GetWindowContentRegionWidth(), 50.0f));
+	const ImVec2 min	= ImGui::GetItemRectMin();
+	const ImVec2 max	= ImGui::GetItemRectMax();
+	const float bar		= (max.x - min.x) / static_cast<float>(frame_count);
+
+	// Clicking (or dragging over) a frame selects it, and pauses so that it stays put
+	if (ImGui::IsItemHovered() && ImGui::IsMouseDown(0))
+	{
+		const int index		= Helper::Clamp(static_cast<int>((ImGui::GetIO().MousePos.x - min.x) / bar), 0, static_cast<int>(frame_count) - 1);
+		m_frame_selected	= static_cast<int>(frame_count) - 1 - index;
+		m_frame_paused		= true;
+	}
+
+	// Mark the selected frame
+	const float x = min.x + (frame_count - 1 - m_frame_selected) * bar;
+	ImGui::GetWindowDrawList()->AddRectFilled(ImVec2(x, min.y), ImVec2(x + Helper::Max(bar, 2.0f), max.y), IM_COL32(255, 255, 255, 90));
+
+	return true;
+}
+
+void Widget_Profiler::FrameCapture()
+{
+	if (m_frame_paused || m_profiler->GetTimeBlocksFrame() == m_frame_profiled)
+		return;
+	m_frame_profiled = m_profiler->GetTimeBlocksFrame();
+
+	const auto& time_blocks = m_profiler->GetTimeBlocks();
+	if (time_blocks.empty())
+		return;
+
+	// The frame starts with its earliest CPU block (GPU blocks only know when they were recorded)
+	auto frame_start = chrono::steady_clock::time_point::max();
+	for (const TimeBlock& time_block : time_blocks)
+	{
+		if (time_block.IsComplete() && time_block.GetType() == TimeBlock_Cpu && time_block.GetStartTime() < frame_start)
+		{
+			frame_start = time_block.GetStartTime();
+		}
+	}
+	if (frame_start == chrono::steady_clock::time_point::max())
+		return;
+
+	m_frames.resize(m_frame_capacity);
+	ProfilerFrame& frame = m_frames[m_frame_count++ % m_frame_capacity];
+	frame.blocks.clear();
+	frame.duration = 0.0f;
+
+	// GPU blocks are laid out back to back, like a trace capture does it (see Profiler::TraceRecord())
+	vector<float> gpu_cursor;
+	for (const TimeBlock& time_block : time_blocks)
+	{
+		if (!time_block.IsComplete())
+			continue;
+
+		const bool is_gpu			= time_block.GetType() == TimeBlock_Gpu;
+		ProfilerFrameBlock& block	= frame.blocks.emplace_back();
+		block.name					= time_block.GetName() ? time_block.GetName() : "N/A";
+		block.lane					= FrameLane(time_block.GetThreadId(), is_gpu);
+		block.depth					= time_block.GetTreeDepth();
+		block.duration				= time_block.GetDuration();
+		block.start					= Helper::Max(chrono::duration<float, milli>(time_block.GetStartTime() - frame_start).count(), 0.0f);
+
+		if (is_gpu)
+		{
+			if (gpu_cursor.size() < block.depth + 2)
+			{
+				gpu_cursor.resize(block.depth + 2, 0.0f);
+			}
+
+			block.start						= (block.depth == 0) ? Helper::Max(block.start, gpu_cursor[0]) : gpu_cursor[block.depth];
+			gpu_cursor[block.depth]			= block.start + block.duration;
+			gpu_cursor[block.depth + 1]		= block.start;
+		}
+
+		m_lanes[block.lane].depth_max	= Helper::Max(m_lanes[block.lane].depth_max, block.depth);
+		frame.duration					= Helper::Max(frame.duration, block.start + block.duration);
+	}
+}
+
+uint32_t Widget_Profiler::FrameLane(const thread::id thread_id, const bool is_gpu)
+{
+	for (uint32_t i = 0; i < m_lanes.size(); i++)
+	{
+		if (is_gpu ? m_lanes[i].is_gpu : (!m_lanes[i].is_gpu && m_lanes[i].thread_id == thread_id))
+			return i;
+	}
+
+	ProfilerLane& lane	= m_lanes.emplace_back();
+	lane.thread_id		= thread_id;
+	lane.is_gpu			= is_gpu;
+	lane.name			= is_gpu ? "GPU" : m_profiler->GetThreadName(thread_id);
+
+	return static_cast<uint32_t>(m_lanes.size() - 1);
+}
+
+const ProfilerFrame* Widget_Profiler::FrameGet(const uint32_t frames_ago) const
+{
+	if (frames_ago >= Helper::Min(m_frame_count, static_cast<uint64_t>(m_frame_capacity)))
+		return nullptr;
+
+	return &m_frames[(m_frame_count - 1 - frames_ago) % m_frame_capacity];
+}
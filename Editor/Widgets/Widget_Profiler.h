@@ -26,7 +26,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Profiling/Profiler.h"
 #include "Math/MathHelper.h"
 #include "Core/Timer.h"
+#include "Core/StringId.h"
 #include <vector>
+#include <thread>
 //=============================
 
 struct Metric
@@ -58,6 +60,39 @@ struct Metric
 	uint64_t m_sample_count;
 };
 
+// The time blocks of a profiled frame, kept so that earlier frames can be inspected
+struct ProfilerFrameBlock
+{
+	Spartan::StringId name;
+	uint32_t lane	= 0;
+	uint32_t depth	= 0;
+	float start		= 0.0f; // ms since the frame's first block
+	float duration	= 0.0f; // ms
+};
+
+struct ProfilerFrame
+{
+	std::vector<ProfilerFrameBlock> blocks; // grouped by lane, in the order they started
+	float duration = 0.0f;
+};
+
+// A row group of the timeline, one per thread and one for the GPU
+struct ProfilerLane
+{
+	std::thread::id thread_id;
+	std::string name;
+	bool is_gpu			= false;
+	uint32_t depth_max	= 0;
+};
+
+// A call path of the flame graph, averaged over the frames it aggregates
+struct ProfilerFlameNode
+{
+	Spartan::StringId name;
+	float duration = 0.0f;
+	std::vector<uint32_t> children;
+};
+
 class Widget_Profiler : public Widget
 {
 public:
@@ -67,8 +102,34 @@ public:
 private:
 	void ShowCPU();
 	void ShowGPU();
+	void ShowMemory() const;
+	void ShowCounters() const;
+	void ShowBenchmark();
     void ShowTimeBlock(const Spartan::TimeBlock& time_block, float total_time) const;
+    void ShowTimeSample(const Spartan::TimeSample& time_sample, float total_time) const;
 	void ShowPlot(std::vector<float>& data, Metric& metric, float time_value, bool is_stuttering) const;
+	void ShowTimeline();
+	void ShowFlameGraph();
+	void ShowFlameNode(uint32_t node_index, float x, float y, float ms_to_px) const;
+	bool ShowFrameScrubber();
+
+	// Frame history
+	void FrameCapture();
+	uint32_t FrameLane(std::thread::id thread_id, bool is_gpu);
+	const ProfilerFrame* FrameGet(uint32_t frames_ago) const;
+	std::vector<ProfilerFrame> m_frames; // ring
+	std::vector<ProfilerLane> m_lanes;
+	uint64_t m_frame_count			= 0;
+	uint64_t m_frame_profiled		= 0; // the profiler's frame which was captured last
+	uint32_t m_frame_capacity		= 240;
+	int m_frame_selected			= 0; // frames ago
+	bool m_frame_paused				= false;
+	float m_timeline_zoom			= 1.0f;
+	int m_flame_frames				= 30;
+	int m_flame_lane				= 0;
+	int m_benchmark_pass			= 0;
+	int m_benchmark_repetitions		= 16;
+	std::vector<ProfilerFlameNode> m_flame_nodes;
 
 	std::vector<float> m_plot_times_cpu;
 	std::vector<float> m_plot_times_gpu;
@@ -48,7 +48,8 @@ Widget_ProgressDialog::Widget_ProgressDialog(Editor* editor) : Widget(editor)
         ProgressReport& progressReport  = ProgressReport::Get();
         const bool is_loading_model     = progressReport.GetIsLoading(g_progress_model_importer);
         const bool is_loading_scene     = progressReport.GetIsLoading(g_progress_world);
-        const bool in_progress          = is_loading_model || is_loading_scene;
+        const bool is_loading_shaders   = progressReport.GetIsLoading(g_progress_shaders);
+        const bool in_progress          = is_loading_model || is_loading_scene || is_loading_shaders;
 
         // Acquire progress
         if (is_loading_model)
@@ -61,6 +62,11 @@ Widget_ProgressDialog::Widget_ProgressDialog(Editor* editor) : Widget(editor)
             m_progress          = progressReport.GetPercentage(g_progress_world);
             m_progressStatus    = progressReport.GetStatus(g_progress_world);
         }
+        else if (is_loading_shaders)
+        {
+            m_progress          = progressReport.GetPercentage(g_progress_shaders);
+            m_progressStatus    = progressReport.GetStatus(g_progress_shaders);
+        }
 
         // Show only if an operation is in progress
         m_is_visible = in_progress;
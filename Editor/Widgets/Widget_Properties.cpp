@@ -39,6 +39,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "World/Components/Script.h"
 #include "World/Components/Environment.h"
 #include "World/Components/Terrain.h"
+#include "World/Components/Foliage.h"
+#include "World/Components/ParticleEmitter.h"
+#include "World/Components/Decal.h"
+#include "World/Components/ReflectionProbe.h"
 //===============================================
 
 //= NAMESPACES =========
@@ -165,6 +169,10 @@ void Widget_Properties::Tick()
 		ShowLight(entity_ptr->GetComponent<Light>());
 		ShowCamera(entity_ptr->GetComponent<Camera>());
         ShowTerrain(entity_ptr->GetComponent<Terrain>());
+        ShowFoliage(entity_ptr->GetComponent<Foliage>());
+        ShowParticleEmitter(entity_ptr->GetComponent<ParticleEmitter>());
+        ShowDecal(entity_ptr->GetComponent<Decal>());
+        ShowReflectionProbe(entity_ptr->GetComponent<ReflectionProbe>());
         ShowEnvironment(entity_ptr->GetComponent<Environment>());
 		ShowAudioSource(entity_ptr->GetComponent<AudioSource>());
 		ShowAudioListener(entity_ptr->GetComponent<AudioListener>());
@@ -414,6 +422,7 @@ void Widget_Properties::ShowRenderable(Renderable* renderable) const
 		auto material_name		= material ? material->GetResourceName() : "N/A";
 		bool cast_shadows		= renderable->GetCastShadows();
 		bool receive_shadows	= renderable->GetReceiveShadows();
+		float impostor_distance	= renderable->GetImpostorDistance();
 		//=======================================================================
 
 		ImGui::Text("Mesh");
@@ -440,10 +449,15 @@ void Widget_Properties::ShowRenderable(Renderable* renderable) const
 		ImGui::Text("Receive Shadows");
 		ImGui::SameLine(ComponentProperty::g_column); ImGui::Checkbox("##RenderableReceiveShadows", &receive_shadows);
 
-		//= MAP ==============================================================================================
-		if (cast_shadows != renderable->GetCastShadows())		renderable->SetCastShadows(cast_shadows);
-		if (receive_shadows != renderable->GetReceiveShadows())	renderable->SetReceiveShadows(receive_shadows);
-		//====================================================================================================
+		// Impostor distance
+		ImGui::Text("Impostor Distance");
+		ImGui::SameLine(ComponentProperty::g_column); ImGui::PushItemWidth(300); ImGui::DragFloat("##RenderableImpostorDistance", &impostor_distance, 1.0f, 0.0f, 10000.0f); ImGui::PopItemWidth();
+
+		//= MAP ==================================================================================================
+		if (cast_shadows != renderable->GetCastShadows())				renderable->SetCastShadows(cast_shadows);
+		if (receive_shadows != renderable->GetReceiveShadows())			renderable->SetReceiveShadows(receive_shadows);
+		if (impostor_distance != renderable->GetImpostorDistance())		renderable->SetImpostorDistance(impostor_distance);
+		//========================================================================================================
 	}
 	ComponentProperty::End();
 }
@@ -567,7 +581,8 @@ void Widget_Properties::ShowCollider(Collider* collider) const
 			"Cylinder",
 			"Capsule",
 			"Cone",
-			"Mesh"
+			"Mesh",
+			"Terrain"
 		};
 		const char* shape_char_ptr		= type[static_cast<int>(collider->GetShapeType())].c_str();
 		bool optimize					= collider->GetOptimize();
@@ -799,7 +814,11 @@ void Widget_Properties::ShowMaterial(Material* material) const
                         else
                         {
                             ImGui::PushID(static_cast<int>(ImGui::GetCursorPosX() + ImGui::GetCursorPosY()));
-                            ImGui::DragFloat("", &material->GetProperty(type), 0.004f, 0.0f, 1.0f);
+                            float value = material->GetProperty(type);
+                            if (ImGui::DragFloat("", &value, 0.004f, 0.0f, 1.0f))
+                            {
+                                material->SetProperty(type, value);
+                            }
                             ImGui::PopID();
                         }
                     }
@@ -947,6 +966,7 @@ void Widget_Properties::ShowTerrain(Terrain* terrain) const
         //= REFLECT =====================================
         float min_y             = terrain->GetMinY();
         float max_y             = terrain->GetMaxY();
+        bool displaced          = terrain->GetDisplaced();
         const float progress    = terrain->GetProgress();
         //===============================================
 
@@ -971,6 +991,7 @@ void Widget_Properties::ShowTerrain(Terrain* terrain) const
         {
             ImGui::InputFloat("Min Y", &min_y);
             ImGui::InputFloat("Max Y", &max_y);
+            ImGui::Checkbox("Displaced", &displaced);
 
             if (progress > 0.0f && progress < 1.0f)
             {
@@ -984,11 +1005,213 @@ void Widget_Properties::ShowTerrain(Terrain* terrain) const
         //= MAP =================================================
         if (min_y != terrain->GetMinY()) terrain->SetMinY(min_y);
         if (max_y != terrain->GetMaxY()) terrain->SetMaxY(max_y);
+        if (displaced != terrain->GetDisplaced()) terrain->SetDisplaced(displaced);
         //=======================================================
     }
     ComponentProperty::End();
 }
 
+void Widget_Properties::ShowFoliage(Foliage* foliage) const
+{
+    if (!foliage)
+        return;
+
+    if (ComponentProperty::Begin("Foliage", Icon_Component_Terrain, foliage))
+    {
+        //= REFLECT =============================================================
+        const Entity* source    = foliage->GetSource();
+        string source_name      = source ? source->GetName() : "N/A";
+        float density           = foliage->GetDensity();
+        float scale_min         = foliage->GetScaleMin();
+        float scale_max         = foliage->GetScaleMax();
+        int seed                = static_cast<int>(foliage->GetSeed());
+        //=======================================================================
+
+        const float cursor_y = ImGui::GetCursorPosY();
+
+        ImGui::BeginGroup();
+        {
+            ImGui::Text("Density Map");
+
+            ImGuiEx::ImageSlot(foliage->GetDensityMap(), [&foliage](const shared_ptr<RHI_Texture>& texture) { foliage->SetDensityMap(static_pointer_cast<RHI_Texture2D>(texture)); });
+
+            if (ImGui::Button("Generate", ImVec2(82, 0)))
+            {
+                foliage->GenerateAsync();
+            }
+        }
+        ImGui::EndGroup();
+
+        ImGui::SameLine();
+        ImGui::SetCursorPosY(cursor_y);
+        ImGui::BeginGroup();
+        {
+            ImGui::PushID("##FoliageSource");
+            ImGui::InputText("Source", &source_name, ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_ReadOnly);
+            if (auto payload = ImGuiEx::ReceiveDragPayload(ImGuiEx::DragPayload_Entity))
+            {
+                foliage->SetSource(_Widget_Properties::scene->EntityGetById(get<unsigned int>(payload->data)).get());
+            }
+            ImGui::PopID();
+            ImGui::InputFloat("Density", &density);
+            ImGui::InputFloat("Scale Min", &scale_min);
+            ImGui::InputFloat("Scale Max", &scale_max);
+            ImGui::InputInt("Seed", &seed);
+            ImGui::Text("Instances: %u", foliage->GetInstanceCount());
+        }
+        ImGui::EndGroup();
+
+        //= MAP ====================================================================================================
+        if (density != foliage->GetDensity())                       foliage->SetDensity(Math::Helper::Max(density, 0.0f));
+        if (scale_min != foliage->GetScaleMin())                    foliage->SetScaleMin(scale_min);
+        if (scale_max != foliage->GetScaleMax())                    foliage->SetScaleMax(scale_max);
+        if (static_cast<uint32_t>(seed) != foliage->GetSeed())      foliage->SetSeed(static_cast<uint32_t>(seed));
+        //==========================================================================================================
+    }
+    ComponentProperty::End();
+}
+
+void Widget_Properties::ShowParticleEmitter(ParticleEmitter* emitter) const
+{
+    if (!emitter)
+        return;
+
+    if (ComponentProperty::Begin("Particle Emitter", Icon_Component_Options, emitter))
+    {
+        //= REFLECT ===================================================
+        float emission_rate     = emitter->GetEmissionRate();
+        float lifetime          = emitter->GetLifetime();
+        Math::Vector3 velocity  = emitter->GetVelocity();
+        float velocity_spread   = emitter->GetVelocitySpread();
+        float gravity           = emitter->GetGravity();
+        float size_start        = emitter->GetSizeStart();
+        float size_end          = emitter->GetSizeEnd();
+        Math::Vector4 color_start = emitter->GetColorStart();
+        Math::Vector4 color_end = emitter->GetColorEnd();
+        float intensity         = emitter->GetIntensity();
+        int seed                = static_cast<int>(emitter->GetSeed());
+        //=============================================================
+
+        const float cursor_y = ImGui::GetCursorPosY();
+
+        ImGui::BeginGroup();
+        {
+            ImGui::Text("Texture");
+
+            ImGuiEx::ImageSlot(emitter->GetTexture(), [&emitter](const shared_ptr<RHI_Texture>& texture) { emitter->SetTexture(static_pointer_cast<RHI_Texture2D>(texture)); });
+
+            if (ImGui::Button("Restart", ImVec2(82, 0)))
+            {
+                emitter->Restart();
+            }
+        }
+        ImGui::EndGroup();
+
+        ImGui::SameLine();
+        ImGui::SetCursorPosY(cursor_y);
+        ImGui::BeginGroup();
+        {
+            ImGui::InputFloat("Emission Rate", &emission_rate);
+            ImGui::InputFloat("Lifetime", &lifetime);
+            ImGui::InputFloat3("Velocity", &velocity.x);
+            ImGui::InputFloat("Velocity Spread", &velocity_spread);
+            ImGui::InputFloat("Gravity", &gravity);
+            ImGui::InputFloat("Size Start", &size_start);
+            ImGui::InputFloat("Size End", &size_end);
+            ImGui::ColorEdit4("Color Start", &color_start.x);
+            ImGui::ColorEdit4("Color End", &color_end.x);
+            ImGui::InputFloat("Intensity", &intensity);
+            ImGui::InputInt("Seed", &seed);
+            ImGui::Text("Particles: %u", emitter->GetParticleCount());
+        }
+        ImGui::EndGroup();
+
+        //= MAP ========================================================================================================
+        if (emission_rate != emitter->GetEmissionRate())            emitter->SetEmissionRate(emission_rate);
+        if (lifetime != emitter->GetLifetime())                     emitter->SetLifetime(lifetime);
+        if (velocity != emitter->GetVelocity())                     emitter->SetVelocity(velocity);
+        if (velocity_spread != emitter->GetVelocitySpread())        emitter->SetVelocitySpread(velocity_spread);
+        if (gravity != emitter->GetGravity())                       emitter->SetGravity(gravity);
+        if (size_start != emitter->GetSizeStart())                  emitter->SetSizeStart(size_start);
+        if (size_end != emitter->GetSizeEnd())                      emitter->SetSizeEnd(size_end);
+        if (color_start != emitter->GetColorStart())                emitter->SetColorStart(color_start);
+        if (color_end != emitter->GetColorEnd())                    emitter->SetColorEnd(color_end);
+        if (intensity != emitter->GetIntensity())                   emitter->SetIntensity(intensity);
+        if (static_cast<uint32_t>(seed) != emitter->GetSeed())      emitter->SetSeed(static_cast<uint32_t>(seed));
+        //==============================================================================================================
+    }
+    ComponentProperty::End();
+}
+
+void Widget_Properties::ShowDecal(Decal* decal) const
+{
+    if (!decal)
+        return;
+
+    if (ComponentProperty::Begin("Decal", Icon_Component_Options, decal))
+    {
+        //= REFLECT ===========================================
+        Math::Vector4 color = decal->GetColor();
+        float roughness     = decal->GetRoughness();
+        float metallic      = decal->GetMetallic();
+        //=====================================================
+
+        const float cursor_y = ImGui::GetCursorPosY();
+
+        ImGui::BeginGroup();
+        {
+            ImGui::Text("Texture");
+
+            ImGuiEx::ImageSlot(decal->GetTexture(), [&decal](const shared_ptr<RHI_Texture>& texture) { decal->SetTexture(static_pointer_cast<RHI_Texture2D>(texture)); });
+        }
+        ImGui::EndGroup();
+
+        ImGui::SameLine();
+        ImGui::SetCursorPosY(cursor_y);
+        ImGui::BeginGroup();
+        {
+            ImGui::ColorEdit4("Color", &color.x);
+            ImGui::SliderFloat("Roughness", &roughness, 0.0f, 1.0f);
+            ImGui::SliderFloat("Metallic", &metallic, 0.0f, 1.0f);
+        }
+        ImGui::EndGroup();
+
+        //= MAP =========================================================================
+        if (color != decal->GetColor())             decal->SetColor(color);
+        if (roughness != decal->GetRoughness())     decal->SetRoughness(roughness);
+        if (metallic != decal->GetMetallic())       decal->SetMetallic(metallic);
+        //===============================================================================
+    }
+    ComponentProperty::End();
+}
+
+void Widget_Properties::ShowReflectionProbe(ReflectionProbe* probe) const
+{
+    if (!probe)
+        return;
+
+    if (ComponentProperty::Begin("Reflection Probe", Icon_Component_Options, probe))
+    {
+        //= REFLECT ===========================================
+        Math::Vector3 extents   = probe->GetExtents();
+        float fade_distance     = probe->GetFadeDistance();
+        //=====================================================
+
+        ImGui::InputFloat3("Extents", &extents.x);
+        ImGui::InputFloat("Fade Distance", &fade_distance);
+        if (ImGui::Button("Bake", ImVec2(82, 0)))
+        {
+            probe->Bake();
+        }
+
+        //= MAP =====================================================================================
+        if (extents != probe->GetExtents())                 probe->SetExtents(extents);
+        if (fade_distance != probe->GetFadeDistance())      probe->SetFadeDistance(fade_distance);
+        //===========================================================================================
+    }
+    ComponentProperty::End();
+}
+
 void Widget_Properties::ShowAudioSource(AudioSource* audio_source) const
 {
 	if (!audio_source)
@@ -1188,6 +1411,30 @@ void Widget_Properties::ComponentContextMenu_Add() const
             {
                 entity->AddComponent<Terrain>();
             }
+
+            // FOLIAGE
+            if (ImGui::MenuItem("Foliage"))
+            {
+                entity->AddComponent<Foliage>();
+            }
+
+            // PARTICLE EMITTER
+            if (ImGui::MenuItem("Particle Emitter"))
+            {
+                entity->AddComponent<ParticleEmitter>();
+            }
+
+            // DECAL
+            if (ImGui::MenuItem("Decal"))
+            {
+                entity->AddComponent<Decal>();
+            }
+
+            // REFLECTION PROBE
+            if (ImGui::MenuItem("Reflection Probe"))
+            {
+                entity->AddComponent<ReflectionProbe>();
+            }
 		}
 
 		ImGui::EndPopup();
@@ -43,6 +43,10 @@ namespace Spartan
 	class AudioListener;
 	class Script;
     class Terrain;
+    class Foliage;
+    class ParticleEmitter;
+    class Decal;
+    class ReflectionProbe;
     class Environment;
 	class IComponent;
 }
@@ -72,6 +76,10 @@ private:
 	void ShowCamera(Spartan::Camera* camera) const;
     void ShowEnvironment(Spartan::Environment* environment) const;
     void ShowTerrain(Spartan::Terrain* terrain) const;
+    void ShowFoliage(Spartan::Foliage* foliage) const;
+    void ShowParticleEmitter(Spartan::ParticleEmitter* emitter) const;
+    void ShowDecal(Spartan::Decal* decal) const;
+    void ShowReflectionProbe(Spartan::ReflectionProbe* probe) const;
 	void ShowAudioSource(Spartan::AudioSource* audio_source) const;
 	void ShowAudioListener(Spartan::AudioListener* audio_listener) const;
 	void ShowScript(Spartan::Script* script) const;
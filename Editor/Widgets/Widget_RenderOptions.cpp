@@ -24,10 +24,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Rendering/Renderer.h"
 #include "Core/Context.h"
 #include "Core/Timer.h"
+#include "Core/Settings.h"
 #include "Math/MathHelper.h"
 #include "Rendering/Model.h"
 #include "../ImGui_Extension.h"
 #include "RHI/RHI_Device.h"
+#include "RHI/RHI_SwapChain.h"
 #include "Profiling/Profiler.h"
 //===============================
 
@@ -53,6 +55,7 @@ void Widget_RenderOptions::Tick()
     if (ImGui::CollapsingHeader("Graphics", ImGuiTreeNodeFlags_DefaultOpen))
     {
         bool do_bloom                   = m_renderer->GetOption(Render_Bloom);
+        bool do_auto_exposure           = m_renderer->GetOption(Render_AutoExposure);
         bool do_volumetric_lighting     = m_renderer->GetOption(Render_VolumetricLighting);    
         bool do_hbao                    = m_renderer->GetOption(Render_Hbao);
         bool do_sss                     = m_renderer->GetOption(Render_ScreenSpaceShadows);
@@ -64,7 +67,27 @@ void Widget_RenderOptions::Tick()
         bool do_chromatic_aberration    = m_renderer->GetOption(Render_ChromaticAberration);
         bool do_dithering               = m_renderer->GetOption(Render_Dithering);
         bool do_indirect_bounce         = m_renderer->GetOption(Render_IndirectBounce);
+        bool do_dynamic_resolution      = m_renderer->GetOption(Render_DynamicResolution);
         int resolution_shadow           = m_renderer->GetOptionValue<int>(Option_Value_ShadowResolution);
+        int shadow_slice_budget         = m_renderer->GetOptionValue<int>(Option_Value_ShadowSliceBudget);
+        int texture_streaming_budget    = m_renderer->GetOptionValue<int>(Option_Value_TextureStreamingBudget);
+
+        // Quality preset
+        {
+            Settings* settings = m_context->GetSubsystem<Settings>();
+            ImGui::Text("Quality preset: %s", settings->GetQualityPreset());
+            ImGui::SameLine();
+            if (settings->IsCalibrating())
+            {
+                ImGui::Text("(calibrating...)");
+            }
+            else if (ImGui::Button("Calibrate"))
+            {
+                settings->CalibrationStart();
+            }
+            ImGuiEx::Tooltip("Renders the world at each preset, from the highest down, and keeps the first one which meets the target GPU ms (see Dynamic Resolution)");
+            ImGui::Separator();
+        }
 
         // Display
         {
@@ -166,6 +189,13 @@ void Widget_RenderOptions::Tick()
                 }
                 ImGui::SameLine(); render_option_float("##tonemapping_option_1", "Exposure", Option_Value_Exposure);
                 ImGui::SameLine(); render_option_float("##tonemapping_option_2", "Gamma", Option_Value_Gamma);
+                ImGui::Checkbox("Auto exposure", &do_auto_exposure);
+                ImGuiEx::Tooltip("Adapts to the brightness of the frame, the exposure above compensates it");
+                if (!m_renderer->GetRhiDevice()->IsComputeSupported())
+                {
+                    ImGui::SameLine();
+                    ImGui::TextUnformatted("(not supported by the graphics API)");
+                }
                 ImGui::Separator();
             }
 
@@ -195,6 +225,30 @@ void Widget_RenderOptions::Tick()
             {
                 ImGui::Checkbox("SSGI - Screen space global illumination", &do_indirect_bounce);
                 ImGuiEx::Tooltip("Computes one bounce of indirect light using. HBAO and SSR are used for diffuse and specular light, so at least one has to be active");
+
+                // Screen space resolution
+                static const array<string, 3> screen_space_scale_options    = { "Full", "Half", "Quarter" };
+                static const array<float, 3> screen_space_scale_values      = { 1.0f, 2.0f, 4.0f };
+                const float screen_space_scale                              = m_renderer->GetOptionValue<float>(Option_Value_ScreenSpaceScale);
+                const uint32_t screen_space_scale_index                     = screen_space_scale >= 4.0f ? 2 : (screen_space_scale >= 2.0f ? 1 : 0);
+
+                if (ImGui::BeginCombo("HBAO/SSR Resolution", screen_space_scale_options[screen_space_scale_index].c_str()))
+                {
+                    for (uint32_t i = 0; i < static_cast<uint32_t>(screen_space_scale_options.size()); i++)
+                    {
+                        const auto is_selected = i == screen_space_scale_index;
+                        if (ImGui::Selectable(screen_space_scale_options[i].c_str(), is_selected))
+                        {
+                            m_renderer->SetOptionValue(Option_Value_ScreenSpaceScale, screen_space_scale_values[i]);
+                        }
+                        if (is_selected)
+                        {
+                            ImGui::SetItemDefaultFocus();
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+                ImGuiEx::Tooltip("Lower resolutions are upsampled with a depth-aware filter");
                 ImGui::Separator();
             }
 
@@ -229,15 +283,55 @@ void Widget_RenderOptions::Tick()
 
             // Shadow resolution
             ImGui::InputInt("Shadow Resolution", &resolution_shadow, 1);
+
+            // Shadow slice budget
+            ImGui::InputInt("Shadow Slice Budget", &shadow_slice_budget, 1);
+            ImGuiEx::Tooltip("How many shadow map slices with moving casters are re-rendered per frame, 0 re-renders all of them");
+
+            // Level of detail
+            render_option_float("##lod_option_1", "LOD Bias", Option_Value_LodBias, "Scales the screen space error a level of detail may have, higher values pick coarser levels sooner");
+            render_option_float("##lod_option_2", "LOD Bias Shadows", Option_Value_LodBias_Shadows, "Same as the above, for the shadow maps");
+            ImGui::Separator();
+
+            // Texture streaming
+            ImGui::InputInt("Texture Streaming Budget (MB)", &texture_streaming_budget, 64);
+            ImGuiEx::Tooltip("The GPU memory streamed textures may take, the mips which are needed the least are dropped to stay within it");
+            ImGui::Separator();
+
+            // Resolution scale
+            ImGui::Checkbox("Dynamic Resolution", &do_dynamic_resolution);
+            ImGuiEx::Tooltip("Lowers the render resolution when the GPU time goes over the target and raises it when there is headroom");
+            ImGui::SameLine(); render_option_float("##resolution_option_1", "Target GPU ms", Option_Value_DynamicResolution_TargetMs);
+            render_option_float("##resolution_option_2", "Resolution Scale", Option_Value_ResolutionScale, "Fraction of the output resolution the frame is rendered at, before it's upsampled (with TAA on, TAA reconstructs the output resolution)", 0.05f);
+            ImGui::SameLine();
+            if (ImGui::BeginCombo("##resolution_option_3", "Presets"))
+            {
+                static const array<string, 4> resolution_scale_presets      = { "Native (100%)", "Quality (75%)", "Balanced (67%)", "Performance (50%)" };
+                static const array<float, 4> resolution_scale_preset_values = { 1.0f, 0.75f, 0.67f, 0.5f };
+                for (uint32_t i = 0; i < static_cast<uint32_t>(resolution_scale_presets.size()); i++)
+                {
+                    if (ImGui::Selectable(resolution_scale_presets[i].c_str(), m_renderer->GetOptionValue<float>(Option_Value_ResolutionScale) == resolution_scale_preset_values[i]))
+                    {
+                        m_renderer->SetOptionValue(Option_Value_ResolutionScale, resolution_scale_preset_values[i]);
+                        do_taa = do_taa || resolution_scale_preset_values[i] != 1.0f;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+            const Vector2& resolution_render = m_renderer->GetResolutionRender();
+            ImGui::SameLine(); ImGui::Text("%dx%d", static_cast<int>(resolution_render.x), static_cast<int>(resolution_render.y));
+            render_option_float("##resolution_option_4", "Preview Scale", Option_Value_PreviewScale, "Resolution scale used while the camera moves (outside of game mode), 1 disables it", 0.05f);
         }
 
         // Map back to engine
         m_renderer->SetOption(Render_Bloom,                         do_bloom);
+        m_renderer->SetOption(Render_AutoExposure,                  do_auto_exposure);
         m_renderer->SetOption(Render_VolumetricLighting,            do_volumetric_lighting); 
         m_renderer->SetOption(Render_Hbao,                          do_hbao); 
         m_renderer->SetOption(Render_ScreenSpaceShadows,            do_sss);
         m_renderer->SetOption(Render_ScreenSpaceReflections,        do_ssr);
         m_renderer->SetOption(Render_IndirectBounce,                do_indirect_bounce);
+        m_renderer->SetOption(Render_DynamicResolution,             do_dynamic_resolution);
         m_renderer->SetOption(Render_AntiAliasing_Taa,              do_taa);
         m_renderer->SetOption(Render_AntiAliasing_Fxaa,             do_fxaa);
         m_renderer->SetOption(Render_MotionBlur,                    do_motion_blur);
@@ -245,6 +339,8 @@ void Widget_RenderOptions::Tick()
         m_renderer->SetOption(Render_ChromaticAberration,           do_chromatic_aberration);
         m_renderer->SetOption(Render_Dithering,                     do_dithering);
         m_renderer->SetOptionValue(Option_Value_ShadowResolution,   static_cast<float>(resolution_shadow));
+        m_renderer->SetOptionValue(Option_Value_ShadowSliceBudget,  static_cast<float>(max(shadow_slice_budget, 0)));
+        m_renderer->SetOptionValue(Option_Value_TextureStreamingBudget, static_cast<float>(max(texture_streaming_budget, 0)));
     }
 
     if (ImGui::CollapsingHeader("Widgets", ImGuiTreeNodeFlags_None))
@@ -258,6 +354,56 @@ void Widget_RenderOptions::Tick()
             timer->SetTargetFps(fps_target);
             const auto fps_policy = timer->GetFpsPolicy();
             ImGui::SameLine(); ImGui::Text(fps_policy == Fps_FixedMonitor ? "Fixed (Monitor)" : fps_target == Fps_Unlocked ? "Unlocked" : "Fixed");
+
+            // Idle
+            bool do_idle = m_renderer->GetOption(Render_Idle);
+            ImGui::Checkbox("Idle when nothing changes", &do_idle);
+            m_renderer->SetOption(Render_Idle, do_idle);
+            auto fps_idle = timer->GetIdleFps();
+            ImGui::SameLine(); ImGui::InputDouble("Idle FPS", &fps_idle);
+            timer->SetIdleFps(Helper::Max(fps_idle, 1.0));
+        }
+
+        // Present mode
+        if (RHI_SwapChain* swap_chain = m_renderer->GetSwapChain())
+        {
+            static const array<const char*, 4> present_mode_names   = { "Immediate", "Mailbox", "Fifo", "Fifo Relaxed" };
+            static const array<uint32_t, 4> present_modes           = { RHI_Present_Immediate, RHI_Present_Mailbox, RHI_Present_Fifo, RHI_Present_FifoRelaxed };
+
+            const uint32_t flags    = swap_chain->GetPresentMode();
+            uint32_t flags_new      = flags;
+            bool low_latency        = flags & RHI_SwapChain_Low_Latency;
+
+            const char* present_mode_name = present_mode_names[2]; // no mode means a validated away request, which falls back to Fifo
+            for (uint32_t i = 0; i < static_cast<uint32_t>(present_modes.size()); i++)
+            {
+                present_mode_name = (flags & present_modes[i]) ? present_mode_names[i] : present_mode_name;
+            }
+
+            if (ImGui::BeginCombo("Present Mode", present_mode_name))
+            {
+                for (uint32_t i = 0; i < static_cast<uint32_t>(present_modes.size()); i++)
+                {
+                    const bool is_selected = (flags & present_modes[i]) != 0;
+                    if (ImGui::Selectable(present_mode_names[i], is_selected))
+                    {
+                        flags_new = present_modes[i] | (flags & RHI_SwapChain_Low_Latency);
+                    }
+                    if (is_selected)
+                    {
+                        ImGui::SetItemDefaultFocus();
+                    }
+                }
+                ImGui::EndCombo();
+            }
+
+            ImGui::SameLine(); ImGui::Checkbox("Low Latency", &low_latency);
+            flags_new = low_latency ? (flags_new | RHI_SwapChain_Low_Latency) : (flags_new & ~RHI_SwapChain_Low_Latency);
+
+            if (flags_new != flags)
+            {
+                swap_chain->SetPresentMode(flags_new);
+            }
         }
         ImGui::Separator();
 
@@ -309,6 +455,10 @@ void Widget_RenderOptions::Tick()
         // Reflect from engine
         auto do_depth_prepass   = m_renderer->GetOption(Render_DepthPrepass);
         auto do_reverse_z       = m_renderer->GetOption(Render_ReverseZ);
+        auto do_occlusion       = m_renderer->GetOption(Render_OcclusionCulling);
+        auto do_gbuffer_compact = m_renderer->GetOption(Render_GBuffer_Compact);
+        auto do_oit             = m_renderer->GetOption(Render_TransparentOit);
+        auto do_vrs             = m_renderer->GetOption(Render_VariableRateShading);
 
         {
             // Buffer
@@ -367,10 +517,31 @@ void Widget_RenderOptions::Tick()
 
             // Reverse-Z
             ImGui::Checkbox("Reverse-Z", &do_reverse_z);
+
+            // Occlusion culling
+            ImGui::Checkbox("Occlusion Culling", &do_occlusion);
+
+            // G-Buffer layout
+            ImGui::Checkbox("Compact G-Buffer", &do_gbuffer_compact);
+
+            // Transparency
+            ImGui::Checkbox("Order Independent Transparency", &do_oit);
+
+            // Variable rate shading
+            ImGui::Checkbox("Variable Rate Shading", &do_vrs);
+            if (!m_renderer->GetRhiDevice()->IsVariableRateShadingSupported())
+            {
+                ImGui::SameLine();
+                ImGui::TextUnformatted("(not supported by the GPU)");
+            }
         }
 
         // Map back to engine
         m_renderer->SetOption(Render_DepthPrepass, do_depth_prepass);
         m_renderer->SetOption(Render_ReverseZ, do_reverse_z);
+        m_renderer->SetOption(Render_OcclusionCulling, do_occlusion);
+        m_renderer->SetOption(Render_GBuffer_Compact, do_gbuffer_compact);
+        m_renderer->SetOption(Render_TransparentOit, do_oit);
+        m_renderer->SetOption(Render_VariableRateShading, do_vrs);
     }
 }
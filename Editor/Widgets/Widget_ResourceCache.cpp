@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Resource/ResourceCache.h"
 #include "../ImGui/Source/imgui.h"
 #include "Core/Spartan_Object.h"
+#include <algorithm>
 //=================================
 
 //= NAMESPACES ==========
@@ -80,36 +81,65 @@ void Widget_ResourceCache::Tick()
         m_column_width_set = true;
     }
 
-    // Set column titles
-	ImGui::Text("Type");            ImGui::NextColumn();
-	ImGui::Text("ID");              ImGui::NextColumn();
-	ImGui::Text("Name");            ImGui::NextColumn();
-    ImGui::Text("Path");            ImGui::NextColumn();
-	ImGui::Text("Path (native)");   ImGui::NextColumn();
-	ImGui::Text("Size CPU");        ImGui::NextColumn();
-    ImGui::Text("Size GPU");        ImGui::NextColumn();
+    // Set column titles, they sort the rows
+    static const char* titles[] = { "Type", "ID", "Name", "Path", "Path (native)", "Size CPU", "Size GPU" };
+    for (int i = 0; i < 7; i++)
+    {
+        const string title = string(titles[i]) + (m_sort_column == i ? (m_sort_descending ? " (v)" : " (^)") : "");
+        if (ImGui::Selectable(title.c_str(), m_sort_column == i))
+        {
+            m_sort_descending   = m_sort_column == i ? !m_sort_descending : true;
+            m_sort_column       = i;
+        }
+        ImGui::NextColumn();
+    }
 	ImGui::Separator();
 
-    // Fill rows with resource information
-	for (const shared_ptr<IResource>& resource : resources)
-	{
-		if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
+    // Sort
+    vector<pair<IResource*, Spartan_Object*>> rows;
+    rows.reserve(resources.size());
+    for (const shared_ptr<IResource>& resource : resources)
+    {
+        if (Spartan_Object* object = dynamic_cast<Spartan_Object*>(resource.get()))
         {
-		    // Type
-		    ImGui::Text(resource->GetResourceTypeCstr());					ImGui::NextColumn();
-		    // ID
-		    ImGui::Text(to_string(object->GetId()).c_str());		        ImGui::NextColumn();
-		    // Name
-            ImGui::Text(resource->GetResourceName().c_str());				ImGui::NextColumn();
-            // Path
-            ImGui::Text(resource->GetResourceFilePath().c_str());		    ImGui::NextColumn();
-		    // Path (native)
-		    ImGui::Text(resource->GetResourceFilePathNative().c_str());		ImGui::NextColumn();
-		    // Memory CPU
-            print_memory(object->GetSizeCpu());                             ImGui::NextColumn();
-            // Memory GPU
-            print_memory(object->GetSizeGpu());                             ImGui::NextColumn();
+            rows.emplace_back(resource.get(), object);
         }
+    }
+    const auto compare = [this](const pair<IResource*, Spartan_Object*>& a, const pair<IResource*, Spartan_Object*>& b)
+    {
+        switch (m_sort_column)
+        {
+            case 0:  return a.first->GetResourceType() < b.first->GetResourceType();
+            case 1:  return a.second->GetId() < b.second->GetId();
+            case 2:  return a.first->GetResourceName() < b.first->GetResourceName();
+            case 3:  return a.first->GetResourceFilePath() < b.first->GetResourceFilePath();
+            case 4:  return a.first->GetResourceFilePathNative() < b.first->GetResourceFilePathNative();
+            case 5:  return a.second->GetSizeCpu() < b.second->GetSizeCpu();
+            default: return a.second->GetSizeGpu() < b.second->GetSizeGpu();
+        }
+    };
+    stable_sort(rows.begin(), rows.end(), [this, &compare](const auto& a, const auto& b) { return m_sort_descending ? compare(b, a) : compare(a, b); });
+
+    // Fill rows with resource information
+	for (const auto& row : rows)
+	{
+        IResource* resource     = row.first;
+        Spartan_Object* object  = row.second;
+
+		// Type
+		ImGui::Text(resource->GetResourceTypeCstr());					ImGui::NextColumn();
+		// ID
+		ImGui::Text(to_string(object->GetId()).c_str());		        ImGui::NextColumn();
+		// Name
+        ImGui::Text(resource->GetResourceName().c_str());				ImGui::NextColumn();
+        // Path
+        ImGui::Text(resource->GetResourceFilePath().c_str());		    ImGui::NextColumn();
+		// Path (native)
+		ImGui::Text(resource->GetResourceFilePathNative().c_str());		ImGui::NextColumn();
+		// Memory CPU
+        print_memory(object->GetSizeCpu());                             ImGui::NextColumn();
+        // Memory GPU
+        print_memory(object->GetSizeGpu());                             ImGui::NextColumn();
 	}
 	ImGui::Columns(1);
 }
@@ -33,4 +33,6 @@ public:
 
 private:
     bool m_column_width_set = false;
+    int m_sort_column       = 6; // clicking a column's title sorts by it, clicking it again flips the order
+    bool m_sort_descending  = true;
 };
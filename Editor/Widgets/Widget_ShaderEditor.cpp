@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Rendering/ShaderGBuffer.h"
 #include <fstream>
 #include <sstream>
+#include <unordered_set>
 #include "../ImGui/Source/imgui_stdlib.h"
 //=======================================
 
@@ -37,6 +38,17 @@ using namespace std;
 using namespace Spartan;
 //======================
 
+namespace _Widget_ShaderEditor
+{
+    static string file_read(const string& file_path)
+    {
+        ifstream in(file_path);
+        stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+}
+
 Widget_ShaderEditor::Widget_ShaderEditor(Editor* editor) : Widget(editor)
 {
     m_title         = "Shader Editor";
@@ -122,17 +134,22 @@ void Widget_ShaderEditor::ShowShaderSource()
             
             if (ImGui::Button("Compile"))
             {
-                // Save all files
-                for (ShaderFile& shader_file : m_shader_sources)
+                Compile();
+            }
+
+            // Recompilation progress
+            {
+                uint32_t recompiling = 0;
+                for (RHI_Shader* shader : m_shaders)
                 {
-                    ofstream out(shader_file.path);
-                    out << shader_file.source;
-                    out.flush();
-                    out.close();
+                    recompiling += shader->IsRecompiling() ? 1 : 0;
                 }
 
-                // Compile synchronously so that the last frame switch immediately to the new shader, much better than seeing flickering.
-                m_shader->Compile(m_shader->GetShaderStage(), m_shader->GetFilePath());
+                if (recompiling != 0)
+                {
+                    ImGui::SameLine();
+                    ImGui::Text("Compiling %d shaders...", static_cast<int>(recompiling));
+                }
             }
 
             ImGui::EndChild();
@@ -141,6 +158,54 @@ void Widget_ShaderEditor::ShowShaderSource()
     ImGui::EndGroup();
 }
 
+void Widget_ShaderEditor::Compile()
+{
+    if (!m_shader)
+        return;
+
+    // Save the files which were edited
+    unordered_set<string> files_changed;
+    for (ShaderFile& shader_file : m_shader_sources)
+    {
+        if (_Widget_ShaderEditor::file_read(shader_file.path) == shader_file.source)
+            continue;
+
+        ofstream out(shader_file.path);
+        out << shader_file.source;
+        out.flush();
+        out.close();
+
+        files_changed.emplace(shader_file.path);
+    }
+
+    // Recompile every permutation which sees one of those files (the selected shader always, for a forced rebuild), in the background.
+    // The previous shaders keep rendering until the new ones are swapped in, so the viewport doesn't stall or flicker.
+    m_shader->RecompileAsync();
+    if (files_changed.empty())
+        return;
+
+    for (RHI_Shader* shader : m_shaders)
+    {
+        bool dependent = files_changed.count(shader->GetFilePath()) != 0;
+        if (!dependent)
+        {
+            for (const string& include_path : FileSystem::GetIncludedFiles(shader->GetFilePath()))
+            {
+                if (files_changed.count(include_path) != 0)
+                {
+                    dependent = true;
+                    break;
+                }
+            }
+        }
+
+        if (dependent)
+        {
+            shader->RecompileAsync();
+        }
+    }
+}
+
 void Widget_ShaderEditor::ShowShaderList()
 {
     GetShaderInstances();
@@ -179,7 +244,7 @@ void Widget_ShaderEditor::ShowShaderList()
                 {
                     if (define.second != "0")
                     {
-                        name += "_" + define.first;
+                        name += "_" + define.first.Get();
                     }
                 }
 
@@ -218,10 +283,7 @@ void Widget_ShaderEditor::GetShaderSource(const string& file_path)
         // Update shader files
         for (const string& include_path : include_paths)
         {
-            ifstream in(include_path);
-            stringstream buffer;
-            buffer << in.rdbuf();
-            m_shader_sources.emplace_back(include_path, buffer.str());
+            m_shader_sources.emplace_back(include_path, _Widget_ShaderEditor::file_read(include_path));
         }
     }
 }
@@ -59,6 +59,7 @@ public:
 private:
     void ShowShaderSource();
     void ShowShaderList();
+    void Compile();
 
     void GetShaderSource(const std::string& file_path);
     void GetShaderInstances();
@@ -19,13 +19,14 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ==================
+//= INCLUDES ======================
 #include "Widget_Viewport.h"
 #include "Core/Timer.h"
 #include "Core/Settings.h"
 #include "Rendering/Model.h"
 #include "../ImGui_Extension.h"
-//=============================
+#include "../ImGui/Source/imgui_internal.h"
+//=================================
 
 //= NAMESPACES =========
 using namespace std;
@@ -42,6 +43,15 @@ Widget_Viewport::Widget_Viewport(Editor* editor) : Widget(editor)
     m_world     = m_context->GetSubsystem<World>();
     m_renderer  = m_context->GetSubsystem<Renderer>();
     m_settings  = m_context->GetSubsystem<Settings>();
+
+    // A closed viewport doesn't tick, so it tells the renderer here that there is nothing to render for
+    m_callback_on_start = [this]()
+    {
+        if (!m_is_visible && m_renderer)
+        {
+            m_renderer->SetViewportVisible(false);
+        }
+    };
 }
 
 void Widget_Viewport::Tick()
@@ -53,6 +63,9 @@ void Widget_Viewport::Tick()
 	float width			= static_cast<float>(ImGui::GetWindowContentRegionMax().x - ImGui::GetWindowContentRegionMin().x);
 	float height		= static_cast<float>(ImGui::GetWindowContentRegionMax().y - ImGui::GetWindowContentRegionMin().y);
 
+    // Nothing to render for while the viewport is an unselected tab
+    m_renderer->SetViewportVisible(!m_window || !m_window->Hidden);
+
 	// Update engine's viewport
 	Vector2 offset = Vector2(ImGui::GetWindowPos()) + m_window_padding;
 	m_renderer->SetViewport(width, height, offset.x, offset.y);
@@ -74,6 +87,16 @@ void Widget_Viewport::Tick()
 		ImColor(50, 127, 166, 255)
 	);
 
+    // The transform gizmo reacts to the mouse (hovered handles light up), which the renderer can't tell apart from an unchanged frame
+    if (ImGui::IsItemHovered() && !EditorHelper::Get().g_selected_entity.expired())
+    {
+        const ImGuiIO& io = ImGui::GetIO();
+        if (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f || ImGui::IsAnyMouseDown())
+        {
+            m_renderer->WakeUp();
+        }
+    }
+
 	// If this widget was released, make the engine pick an entity.
 	// Don't do that on mouse down as a mouse down event might also mean that the user is currently transforming the entity.
 	if (ImGui::IsMouseReleased(0) && ImGui::IsItemHovered())
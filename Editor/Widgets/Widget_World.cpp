@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Resource/ProgressReport.h"
 #include "Rendering/Model.h"
 #include "World/Entity.h"
+#include "World/Prefab.h"
 #include "World/Components/Transform.h"
 #include "World/Components/Light.h"
 #include "World/Components/AudioSource.h"
@@ -38,6 +39,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "World/Components/Renderable.h"
 #include "World/Components/Environment.h"
 #include "World/Components/Terrain.h"
+#include <algorithm>
 //=========================================
 
 //= NAMESPACES ==========
@@ -67,6 +69,11 @@ Widget_World::Widget_World(Editor* editor) : Widget(editor)
 
 	// Subscribe to entity clicked engine event
 	EditorHelper::Get().g_on_entity_selected = [this](){ SetSelectedEntity(EditorHelper::Get().g_selected_entity.lock(), false); };
+
+	// The rows point to entities, they are rebuilt whenever the world changes which entities there are.
+	// The matches of the previous search are dropped too, they can't be narrowed down any more.
+	SUBSCRIBE_TO_EVENT(Event_World_Resolve_Complete, [this](const Variant&) { m_tree_dirty = true; m_search_previous.clear(); });
+	SUBSCRIBE_TO_EVENT(Event_World_Unload, [this](const Variant&) { m_tree_rows.clear(); m_search_matches.clear(); m_search_previous.clear(); m_tree_dirty = true; });
 }
 
 void Widget_World::Tick()
@@ -97,6 +104,13 @@ void Widget_World::TreeShow()
 {
 	OnTreeBegin();
 
+	// Search
+	const float label_width = 45.0f;
+	if (m_search.Draw("Search", ImGui::GetContentRegionAvail().x - label_width))
+	{
+		m_tree_dirty = true;
+	}
+
 	if (ImGui::TreeNodeEx("Root", ImGuiTreeNodeFlags_DefaultOpen))
 	{
 		// Dropping on the scene node should unparent the entity
@@ -106,22 +120,28 @@ void Widget_World::TreeShow()
 			if (const auto dropped_entity = _Widget_World::g_world->EntityGetById(entity_id))
 			{
 				dropped_entity->GetTransform()->SetParent(nullptr);
+				m_tree_dirty = true;
 			}
 		}
 
-		auto rootentities = _Widget_World::g_world->EntityGetRoots();
-		for (const auto& entity : rootentities)
+		if (m_expand_to_selection)
+		{
+			TreeExpandToSelection();
+		}
+		else if (m_tree_dirty)
 		{
-			TreeAddEntity(entity.get());
+			TreeRebuild();
 		}
 
-        // If we have been expanding to show an entity and no more expansions are taking place, we reached it.
-        // So, we stop expanding and we bring it into view.
-        if (m_expand_to_selection && !m_expanded_to_selection)
-        {
-            ImGui::ScrollToBringRectIntoView(m_window, m_selected_entity_rect);
-            m_expand_to_selection = false;
-        }
+		// Only the rows which are in view
+		ImGuiListClipper clipper(static_cast<int>(m_tree_rows.size()), ImGui::GetTextLineHeightWithSpacing());
+		while (clipper.Step())
+		{
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				TreeShowRow(m_tree_rows[i]);
+			}
+		}
 
 		ImGui::TreePop();
 	}
@@ -129,98 +149,164 @@ void Widget_World::TreeShow()
 	OnTreeEnd();
 }
 
-void Widget_World::OnTreeBegin()
+void Widget_World::TreeRebuild()
 {
-	_Widget_World::g_entity_hovered = nullptr;
-}
+	m_tree_rows.clear();
+	m_tree_dirty = false;
 
-void Widget_World::OnTreeEnd()
-{
-	HandleKeyShortcuts();
-	HandleClicking();
-	Popups();
+	// Search, the matches are listed without their hierarchy
+	if (m_search.IsActive())
+	{
+		// Every match of a longer search is also a match of the shorter one (unless there are several terms or exclusions)
+		const string search		= m_search.InputBuf;
+		const bool is_simple	= search.find_first_of(",-") == string::npos;
+		const bool refines		= is_simple && !m_search_previous.empty() && search.find(m_search_previous) != string::npos;
+
+		if (refines)
+		{
+			m_search_matches.erase(remove_if(m_search_matches.begin(), m_search_matches.end(), [this](Entity* entity)
+			{
+				return !m_search.PassFilter(entity->GetName().c_str());
+			}), m_search_matches.end());
+		}
+		else
+		{
+			m_search_matches.clear();
+			for (const auto& entity : _Widget_World::g_world->EntityGetAll())
+			{
+				if (entity->IsVisibleInHierarchy() && m_search.PassFilter(entity->GetName().c_str()))
+				{
+					m_search_matches.emplace_back(entity.get());
+				}
+			}
+		}
+		m_search_previous = is_simple ? search : string();
+
+		m_tree_rows.reserve(m_search_matches.size());
+		for (Entity* entity : m_search_matches)
+		{
+			m_tree_rows.push_back({ entity, 0, false });
+		}
+
+		return;
+	}
+	m_search_previous.clear();
+	m_search_matches.clear();
+
+	for (const auto& entity : _Widget_World::g_world->EntityGetRoots())
+	{
+		TreeAddRows(entity.get(), 0);
+	}
 }
 
-void Widget_World::TreeAddEntity(Entity* entity)
+void Widget_World::TreeAddRows(Entity* entity, const uint32_t depth)
 {
-	if (!entity)
+	// Don't show invisible entities
+	if (!entity || !entity->IsVisibleInHierarchy())
 		return;
 
-    m_expanded_to_selection             = false;
-    bool is_selected_entity             = false;
-	const bool is_visible_in_hierarchy	= entity->IsVisibleInHierarchy();
-    bool has_visible_children			= false;
-   
+	const auto& children = entity->GetTransform()->GetChildren();
+	const bool has_visible_children = any_of(children.begin(), children.end(), [](Transform* child) { return child->GetEntity()->IsVisibleInHierarchy(); });
+	m_tree_rows.push_back({ entity, depth, has_visible_children });
 
-	// Don't draw invisible entities
-	if (!is_visible_in_hierarchy)
+	// The children of a collapsed entity are not visited at all
+	if (!has_visible_children || m_tree_expanded.find(entity->GetId()) == m_tree_expanded.end())
 		return;
 
-	// Determine children visibility
-	auto children = entity->GetTransform()->GetChildren();
-	for (const auto& child : children)
+	for (Transform* child : children)
 	{
-		if (child->GetEntity()->IsVisibleInHierarchy())
-		{
-			has_visible_children = true;
-			break;
-		}
+		TreeAddRows(child->GetEntity(), depth + 1);
 	}
+}
+
+void Widget_World::TreeShowRow(const TreeRow& row)
+{
+	Entity* entity = row.entity;
 
 	// Flags
-	ImGuiTreeNodeFlags node_flags	= ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_SpanAvailWidth;
+	ImGuiTreeNodeFlags node_flags = ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+	node_flags |= row.has_children ? ImGuiTreeNodeFlags_OpenOnArrow : ImGuiTreeNodeFlags_Leaf;
+	if (const auto selected_entity = EditorHelper::Get().g_selected_entity.lock())
+	{
+		node_flags |= selected_entity->GetId() == entity->GetId() ? ImGuiTreeNodeFlags_Selected : 0;
+	}
 
-	// Flag - Is expandable (has children) ?
-	node_flags |= has_visible_children ? ImGuiTreeNodeFlags_OpenOnArrow : ImGuiTreeNodeFlags_Leaf; 
+	// The rows are flat, the depth is an indentation
+	const float indent = row.depth * ImGui::GetStyle().IndentSpacing;
+	if (indent > 0.0f)
+	{
+		ImGui::Indent(indent);
+	}
 
-	// Flag - Is selected?
-	if (const auto selected_entity = EditorHelper::Get().g_selected_entity.lock())
+	if (row.has_children)
 	{
-        node_flags |= selected_entity->GetId() == entity->GetId() ? ImGuiTreeNodeFlags_Selected : node_flags;
+		ImGui::SetNextItemOpen(m_tree_expanded.find(entity->GetId()) != m_tree_expanded.end());
+	}
+	ImGui::TreeNodeEx(reinterpret_cast<void*>(static_cast<intptr_t>(entity->GetId())), node_flags, entity->GetName().c_str());
 
-		if (m_expand_to_selection)
+	// Expanding or collapsing changes which rows there are, they are rebuilt for the next frame
+	if (ImGui::IsItemToggledOpen())
+	{
+		if (!m_tree_expanded.erase(entity->GetId()))
 		{
-			// If the selected entity is a descendant of the this entity, start expanding (this can happen if an entity is selected in the viewport)
-			if (selected_entity->GetTransform()->IsDescendantOf(entity->GetTransform()))
-			{
-				ImGui::SetNextItemOpen(true);
-                m_expanded_to_selection = true;
-			}
+			m_tree_expanded.insert(entity->GetId());
 		}
+		m_tree_dirty = true;
 	}
 
-	const bool is_node_open = ImGui::TreeNodeEx(reinterpret_cast<void*>(static_cast<intptr_t>(entity->GetId())), node_flags, entity->GetName().c_str());
-
-    // Keep a copy of the selected item's rect so that we can scroll to bring it into view
-    if ((node_flags & ImGuiTreeNodeFlags_Selected) && m_expand_to_selection)
-    {
-        m_selected_entity_rect = m_window->DC.LastItemRect;
-    }
-
 	// Manually detect some useful states
 	if (ImGui::IsItemHovered(ImGuiHoveredFlags_RectOnly))
 	{
 		_Widget_World::g_entity_hovered = entity;
 	}
 
-	EntityHandleDragDrop(entity);	
+	EntityHandleDragDrop(entity);
 
-	// Recursively show all child nodes
-	if (is_node_open)
+	if (indent > 0.0f)
 	{
-		if (has_visible_children)
+		ImGui::Unindent(indent);
+	}
+}
+
+void Widget_World::TreeExpandToSelection()
+{
+	m_expand_to_selection = false;
+
+	const auto selected_entity = EditorHelper::Get().g_selected_entity.lock();
+	if (!selected_entity)
+	{
+		if (m_tree_dirty)
 		{
-			for (const auto& child : children)
-			{
-				if (!child->GetEntity()->IsVisibleInHierarchy())
-					continue;
+			TreeRebuild();
+		}
+		return;
+	}
 
-				TreeAddEntity(child->GetEntity());
-			}
+	// Expand the ancestors (this can happen if an entity is selected in the viewport)
+	if (!m_search.IsActive())
+	{
+		for (Transform* parent = selected_entity->GetTransform()->GetParent(); parent; parent = parent->GetParent())
+		{
+			m_tree_dirty |= m_tree_expanded.insert(parent->GetEntity()->GetId()).second;
 		}
+	}
 
-		// Pop if isNodeOpen
-		ImGui::TreePop();
+	if (m_tree_dirty)
+	{
+		TreeRebuild();
+	}
+
+	// Bring its row into view, the rows are drawn from the cursor on, one line each
+	const auto it = find_if(m_tree_rows.begin(), m_tree_rows.end(), [&selected_entity](const TreeRow& row) { return row.entity == selected_entity.get(); });
+	if (it == m_tree_rows.end())
+		return;
+
+	const float line_height	= ImGui::GetTextLineHeightWithSpacing();
+	const float row_y		= ImGui::GetCursorPosY() + static_cast<float>(distance(m_tree_rows.begin(), it)) * line_height;
+	const float scroll_y	= ImGui::GetScrollY();
+	if (row_y < scroll_y || row_y + line_height > scroll_y + ImGui::GetWindowHeight())
+	{
+		ImGui::SetScrollFromPosY(row_y - scroll_y, 0.5f);
 	}
 }
 
@@ -258,7 +344,7 @@ void Widget_World::HandleClicking()
 	}
 }
 
-void Widget_World::EntityHandleDragDrop(Entity* entity_ptr) const
+void Widget_World::EntityHandleDragDrop(Entity* entity_ptr)
 {
 	// Drag
 	if (ImGui::BeginDragDropSource())
@@ -277,6 +363,7 @@ void Widget_World::EntityHandleDragDrop(Entity* entity_ptr) const
 			if (dropped_entity->GetId() != entity_ptr->GetId())
 			{
 				dropped_entity->GetTransform()->SetParent(entity_ptr->GetTransform());
+				m_tree_dirty = true;
 			}
 		}
 	}
@@ -331,6 +418,11 @@ void Widget_World::PopupContextMenu() const
 	{
 		ActionEntityDelete(selected_entity);
 	}
+
+	if (on_entity) if (ImGui::MenuItem("Save as Prefab"))
+	{
+		ActionEntitySavePrefab(selected_entity);
+	}
 	ImGui::Separator();
 
 	// EMPTY
@@ -497,6 +589,42 @@ void Widget_World::ActionEntityDelete(const shared_ptr<Entity>& entity)
 	_Widget_World::g_world->EntityRemove(entity);
 }
 
+void Widget_World::ActionEntitySavePrefab(const shared_ptr<Entity>& entity)
+{
+	auto resource_cache			= entity->GetContext()->GetSubsystem<ResourceCache>();
+	shared_ptr<Prefab> prefab	= make_shared<Prefab>(entity->GetContext());
+	if (!prefab->SetTemplate(entity.get()))
+		return;
+
+	prefab->SetResourceFilePath(resource_cache->GetProjectDirectory() + entity->GetName() + EXTENSION_PREFAB);
+	// A prefab of the same name is already cached, overwrite its template
+	const shared_ptr<Prefab> prefab_cached = resource_cache->Cache(prefab);
+	if (!prefab_cached)
+		return;
+
+	if (prefab_cached != prefab)
+	{
+		prefab = prefab_cached;
+		prefab->SetTemplate(entity.get());
+		prefab->SaveToFile(prefab->GetResourceFilePathNative());
+	}
+
+	// The hierarchy becomes the first instance, its nodes follow the template's depth first order
+	uint32_t node = 0;
+	function<void(Entity*)> link = [&link, &prefab, &node](Entity* entity)
+	{
+		entity->SetPrefab(prefab, node++);
+		for (Transform* child : entity->GetTransform()->GetChildren())
+		{
+			if (child->GetEntity())
+			{
+				link(child->GetEntity());
+			}
+		}
+	};
+	link(entity.get());
+}
+
 Entity* Widget_World::ActionEntityCreateEmpty()
 {
 	const auto entity = _Widget_World::g_world->EntityCreate().get();
@@ -24,6 +24,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==============================
 #include "Widget.h"
 #include <memory>
+#include <vector>
+#include <string>
+#include <unordered_set>
 #include "../ImGui/Source/imgui_internal.h"
 //=========================================
 
@@ -36,13 +39,25 @@ public:
 	void Tick() override;
 
 private:
-	// Tree
+	// A visible line of the tree
+	struct TreeRow
+	{
+		Spartan::Entity* entity	= nullptr;
+		uint32_t depth			= 0;
+		bool has_children		= false;
+	};
+
+	// Tree, the visible lines are flattened into a list which is rebuilt only when the hierarchy, the expanded entities or the search change
+	// and only the lines which are scrolled into view are drawn, so the cost doesn't grow with the size of the world.
 	void TreeShow();
+	void TreeRebuild();
+	void TreeAddRows(Spartan::Entity* entity, uint32_t depth);
+	void TreeShowRow(const TreeRow& row);
+	void TreeExpandToSelection();
 	void OnTreeBegin();
 	void OnTreeEnd();
-	void TreeAddEntity(Spartan::Entity* entity);
 	void HandleClicking();
-	void EntityHandleDragDrop(Spartan::Entity* entity_ptr) const;
+	void EntityHandleDragDrop(Spartan::Entity* entity_ptr);
 	void SetSelectedEntity(const std::shared_ptr<Spartan::Entity>& entity, bool from_editor = true);
 
 	// Misc
@@ -53,6 +68,7 @@ private:
 
 	// Context menu actions
 	static void ActionEntityDelete(const std::shared_ptr<Spartan::Entity>& entity);
+	static void ActionEntitySavePrefab(const std::shared_ptr<Spartan::Entity>& entity);
 	static Spartan::Entity* ActionEntityCreateEmpty();
 	static void ActionEntityCreateCube();
 	static void ActionEntityCreateQuad();
@@ -73,7 +89,15 @@ private:
 	static void ActionEntityCreateSkybox();
 	
 	std::shared_ptr<Spartan::Entity> m_entity_empty;
-	bool m_expand_to_selection      = false;
-    bool m_expanded_to_selection    = false;
-    ImRect m_selected_entity_rect;
+	bool m_expand_to_selection = false;
+
+	// Tree
+	std::vector<TreeRow> m_tree_rows;
+	std::unordered_set<uint32_t> m_tree_expanded; // entity ids
+	bool m_tree_dirty = true;
+
+	// Search, a search which narrows down the previous one only filters its matches again
+	ImGuiTextFilter m_search;
+	std::string m_search_previous;
+	std::vector<Spartan::Entity*> m_search_matches;
 };
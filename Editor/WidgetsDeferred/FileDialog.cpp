@@ -35,6 +35,25 @@ using namespace Spartan::Math;
 #define OPERATION_NAME	(m_operation == FileDialog_Op_Open)	? "Open"		: (m_operation == FileDialog_Op_Load)	? "Load"		: (m_operation == FileDialog_Op_Save) ? "Save" : "View"
 #define FILTER_NAME		(m_filter == FileDialog_Filter_All)	? "All (*.*)"	: (m_filter == FileDialog_Filter_Model)	? "Model(*.*)"	: "World (*.world)"
 
+namespace _FileDialog
+{
+    inline bool filter_accepts(const FileDialog_Filter filter, const string& file_path)
+    {
+        if (filter == FileDialog_Filter_Scene)  return FileSystem::IsEngineSceneFile(file_path);
+        if (filter == FileDialog_Filter_Model)  return FileSystem::IsSupportedModelFile(file_path);
+
+        return !FileSystem::IsEngineTextureFile(file_path) && !FileSystem::IsEngineModelFile(file_path);
+    }
+
+    inline Icon_Type filter_thumbnail(const FileDialog_Filter filter)
+    {
+        if (filter == FileDialog_Filter_Scene)  return Thumbnail_File_Scene;
+        if (filter == FileDialog_Filter_Model)  return Thumbnail_File_Model;
+
+        return Thumbnail_Custom;
+    }
+}
+
 FileDialog::FileDialog(Context* context, const bool standalone_window, const FileDialog_Type type, const FileDialog_Operation operation, const FileDialog_Filter filter)
 {
 	m_context							= context;
@@ -69,6 +88,8 @@ bool FileDialog::Show(bool* is_visible, string* directory /*= nullptr*/, string*
 	m_selection_made		= false;
 	m_is_hovering_item	    = false;
 	m_is_hovering_window	= false;
+
+	DialogUpdateFromScan(); // Whatever the background scan read since the last frame
 	
 	ShowTop(is_visible);	// Top menu	
 	ShowMiddle();			// Contents of the current directory
@@ -285,11 +306,19 @@ void FileDialog::ShowMiddle()
                         ItemDrag(&item);
                     }
 
-                    ImGui::SetCursorScreenPos(ImVec2(rect_button.Min.x + style.FramePadding.x, rect_button.Min.y + style.FramePadding.y));
-                    ImGui::Image(item.GetTexture(), ImVec2(
-                        rect_button.Max.x - rect_button.Min.x - style.FramePadding.x * 2.0f,
-                        rect_button.Max.y - rect_button.Min.y - style.FramePadding.y - label_height - 5.0f)
-                    );
+                    // Only ask for the texture of visible items, image thumbnails are decoded once they are asked for
+                    if (ImGui::IsRectVisible(rect_button.Min, rect_button.Max))
+                    {
+                        Vector4 uv;
+                        RHI_Texture* texture = item.GetTexture(&uv);
+                        ImGui::SetCursorScreenPos(ImVec2(rect_button.Min.x + style.FramePadding.x, rect_button.Min.y + style.FramePadding.y));
+                        ImGui::Image(texture, ImVec2(
+                            rect_button.Max.x - rect_button.Min.x - style.FramePadding.x * 2.0f,
+                            rect_button.Max.y - rect_button.Min.y - style.FramePadding.y - label_height - 5.0f),
+                            ImVec2(uv.x, uv.y),
+                            ImVec2(uv.z, uv.w)
+                        );
+                    }
 
                     ImGui::PopStyleColor(2);
                     ImGui::PopID();
@@ -353,6 +382,12 @@ void FileDialog::ShowBottom(bool* is_visible)
 
         const char* text = (m_displayed_item_count == 1) ? "%d item" : "%d items";
         ImGui::Text(text, m_displayed_item_count);
+
+        if (m_scan)
+        {
+            ImGui::SameLine();
+            ImGui::TextUnformatted("(reading...)");
+        }
     }
     else
     {
@@ -403,7 +438,7 @@ void FileDialog::ItemDrag(FileDialogItem* item) const
         if (FileSystem::IsEngineMaterialFile(item->GetPath()))  { set_payload(ImGuiEx::DragPayload_Material,    item->GetPath()); }
 
         // Preview
-		ImGuiEx::Image(item->GetTexture(), 50);
+		ImGuiEx::Image(item->GetThumbnail(), 50);
 
 		ImGui::EndDragDropSource();
 	}
@@ -463,45 +498,85 @@ bool FileDialog::DialogUpdateFromDirectory(const std::string& path)
 
 	m_items.clear();
 	m_items.shrink_to_fit();
+	m_item_directory_count = 0;
 
-	// Get directories
-	auto child_directories = FileSystem::GetDirectoriesInDirectory(path);
-	for (const auto& child_dir : child_directories)
+	// Whatever a previous scan still reads is dropped
+	if (m_scan)
 	{
-		m_items.emplace_back(child_dir, IconProvider::Get().Thumbnail_Load(child_dir, Thumbnail_Folder, static_cast<int>(m_item_size.x)));
+		m_scan->cancelled = true;
 	}
+	m_scan = make_shared<FileDialogScan>();
 
-	// Get files (based on filter)
-	vector<string> child_files;
-	if (m_filter == FileDialog_Filter_All)
+	shared_ptr<FileDialogScan> scan	= m_scan;
+	const FileDialog_Filter filter	= m_filter;
+	m_context->GetSubsystem<Threading>()->AddTask([scan, path, filter]()
 	{
-		child_files = FileSystem::GetFilesInDirectory(path);
-		for (const auto& child_file : child_files)
+		const size_t batch_size = 64;
+		vector<pair<string, bool>> batch;
+
+		const auto hand_over = [&scan, &batch]()
 		{
-            if (!FileSystem::IsEngineTextureFile(child_file) && !FileSystem::IsEngineModelFile(child_file))
-            {
-                m_items.emplace_back(child_file, IconProvider::Get().Thumbnail_Load(child_file, Thumbnail_Custom, static_cast<int>(m_item_size.x)));
-            }
-		}
+			lock_guard<mutex> lock(scan->mutex);
+			move(batch.begin(), batch.end(), back_inserter(scan->entries));
+			batch.clear();
+		};
+
+		FileSystem::IterateDirectory(path, [&scan, &batch, &hand_over, filter, batch_size](const string& entry_path, const bool is_directory)
+		{
+			if (scan->cancelled)
+				return false;
+
+			if (is_directory || _FileDialog::filter_accepts(filter, entry_path))
+			{
+				batch.emplace_back(entry_path, is_directory);
+			}
+
+			if (batch.size() >= batch_size)
+			{
+				hand_over();
+			}
+
+			return true;
+		});
+
+		hand_over();
+		scan->done = true;
+	}, {}, Threading_Pool_Background);
+
+	return true;
+}
+
+void FileDialog::DialogUpdateFromScan()
+{
+	if (!m_scan)
+		return;
+
+	// Read before taking the entries, everything is handed over by the time the scan is done
+	const bool done = m_scan->done;
+
+	vector<pair<string, bool>> entries;
+	{
+		lock_guard<mutex> lock(m_scan->mutex);
+		entries.swap(m_scan->entries);
 	}
-	else if (m_filter == FileDialog_Filter_Scene)
+
+	const int size = static_cast<int>(m_item_size.x);
+	for (const auto& entry : entries)
 	{
-		child_files = FileSystem::GetSupportedSceneFilesInDirectory(path);
-		for (const auto& child_file : child_files)
+		if (entry.second)
 		{
-            m_items.emplace_back(child_file, IconProvider::Get().Thumbnail_Load(child_file, Thumbnail_File_Scene, static_cast<int>(m_item_size.x)));
+			m_items.emplace(m_items.begin() + m_item_directory_count++, entry.first, IconProvider::Get().Thumbnail_Load(entry.first, Thumbnail_Folder, size), true);
 		}
-	}
-	else if (m_filter == FileDialog_Filter_Model)
-	{
-		child_files = FileSystem::GetSupportedModelFilesInDirectory(path);
-		for (const auto& child_file : child_files)
+		else
 		{
-            m_items.emplace_back(child_file, IconProvider::Get().Thumbnail_Load(child_file, Thumbnail_File_Model, static_cast<int>(m_item_size.x)));
+			m_items.emplace_back(entry.first, IconProvider::Get().Thumbnail_Load(entry.first, _FileDialog::filter_thumbnail(m_filter), size), false);
 		}
 	}
 
-	return true;
+	if (done)
+	{
+		m_scan = nullptr;
+	}
 }
 
 void FileDialog::EmptyAreaContextMenu()
@@ -22,6 +22,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==================
+#include <atomic>
+#include <mutex>
 #include "IconProvider.h"
 #include "../ImGui_Extension.h"
 #include "Core/FileSystem.h"
@@ -158,19 +160,20 @@ public:
 class FileDialogItem
 {
 public:
-	FileDialogItem(const std::string& path, const Thumbnail& thumbnail)
+	FileDialogItem(const std::string& path, const Thumbnail& thumbnail, const bool is_directory)
 	{
 		m_path			= path;
 		m_thumbnail		= thumbnail;
 		m_id			= Spartan::Spartan_Object::GenerateId();
-		m_isDirectory	= Spartan::FileSystem::IsDirectory(path);
+		m_isDirectory	= is_directory;
 		m_label			= Spartan::FileSystem::GetFileNameFromFilePath(path);
 	}
 
 	const auto& GetPath()           const { return m_path; }
 	const auto& GetLabel()          const { return m_label; }
+	const auto& GetThumbnail()      const { return m_thumbnail; }
 	auto GetId()                    const { return m_id; }
-	auto GetTexture()               const { return IconProvider::Get().GetTextureByThumbnail(m_thumbnail); }
+	auto GetTexture(Spartan::Math::Vector4* uv = nullptr) const { return IconProvider::Get().GetTextureByThumbnail(m_thumbnail, uv); }
 	auto IsDirectory()              const { return m_isDirectory; }
 	auto GetTimeSinceLastClickMs()  const { return static_cast<float>(m_time_since_last_click.count()); }
 
@@ -191,6 +194,15 @@ private:
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_last_click_time;
 };
 
+// The entries of a directory are read in the background and handed over in batches, so that a large directory doesn't stall the editor
+struct FileDialogScan
+{
+	std::vector<std::pair<std::string, bool>> entries; // path, is directory
+	std::mutex mutex;
+	std::atomic<bool> cancelled = { false };
+	std::atomic<bool> done      = { false };
+};
+
 class FileDialog
 {
 public:
@@ -222,6 +234,7 @@ private:
 
 	// Misc
     bool DialogUpdateFromDirectory(const std::string& path);
+    void DialogUpdateFromScan();
 	void EmptyAreaContextMenu();
 
     // Options
@@ -250,6 +263,8 @@ private:
     FileDialog_Operation m_operation;
     FileDialog_Filter m_filter;
     std::vector<FileDialogItem> m_items;
+    uint32_t m_item_directory_count = 0; // directories are listed first
+    std::shared_ptr<FileDialogScan> m_scan;
     Spartan::Math::Vector2 m_item_size;
     ImGuiTextFilter m_search_filter;
 	Spartan::Context* m_context;
@@ -19,16 +19,20 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ==================
+//= INCLUDES ===========================
 #include "IconProvider.h"
 #include "../ImGui_Extension.h"
 #include "Rendering\Model.h"
-//=============================
+#include "Resource/Import/ImageImporter.h"
+#include "Resource/Import/DerivedDataCache.h"
+#include "Utilities/Hash.h"
+//======================================
 
-//= NAMESPACES ==========
+//= NAMESPACES ===============
 using namespace std;
 using namespace Spartan;
-//=======================
+using namespace Spartan::Math;
+//============================
 
 static Thumbnail g_noThumbnail;
 
@@ -39,12 +43,16 @@ IconProvider::IconProvider()
 
 IconProvider::~IconProvider()
 {
+	m_thumbnails_by_path.clear();
+	m_thumbnails_by_type.clear();
 	m_thumbnails.clear();
 }
 
 void IconProvider::Initialize(Context* context)
 {
 	m_context = context;
+	m_atlas_data.resize(m_atlas_size * m_atlas_size * 4);
+	m_atlas_slots.resize((m_atlas_size / m_atlas_slot_size) * (m_atlas_size / m_atlas_slot_size));
     const string data_dir = m_context->GetSubsystem<ResourceCache>()->GetDataDirectory() + "/";
 
 	// Load standard icons
@@ -86,6 +94,70 @@ void IconProvider::Initialize(Context* context)
 	Thumbnail_Load(data_dir + "Icons/font.png",							    Thumbnail_File_Font);
 }
 
+void IconProvider::Tick()
+{
+	m_frame++;
+
+	vector<DecodedThumbnail> decoded;
+	{
+		lock_guard<mutex> lock(m_decoded_mutex);
+		decoded.swap(m_decoded);
+	}
+
+	// Pack what finished decoding
+	const uint32_t slots_per_row = m_atlas_size / m_atlas_slot_size;
+	const uint32_t row_bytes     = m_atlas_slot_size * 4;
+	for (DecodedThumbnail& image : decoded)
+	{
+		Thumbnail* thumbnail = GetThumbnailByPath(image.file_path);
+		if (!thumbnail)
+			continue;
+
+		thumbnail->decoding = false;
+
+		// Files which can't be decoded show the default file icon from now on
+		if (image.pixels.empty())
+		{
+			thumbnail->type = Thumbnail_File_Default;
+			continue;
+		}
+
+		const int slot			= AtlasAllocateSlot();
+		const uint32_t slot_x	= (slot % slots_per_row) * m_atlas_slot_size;
+		const uint32_t slot_y	= (slot / slots_per_row) * m_atlas_slot_size;
+		for (uint32_t y = 0; y < m_atlas_slot_size; y++)
+		{
+			memcpy(&m_atlas_data[((slot_y + y) * m_atlas_size + slot_x) * 4], &image.pixels[y * row_bytes], row_bytes);
+		}
+
+		m_atlas_slots[slot]		= thumbnail;
+		thumbnail->frame_used	= m_frame;
+		m_atlas_pending.emplace_back(thumbnail, slot);
+		m_atlas_dirty			= true;
+	}
+
+	// Create the atlas again, not more often than every few frames as it's a full upload. The previous one is kept
+	// around until the next upload, by then the frames which drew from it have completed.
+	const uint64_t upload_interval = 4;
+	if (m_atlas_dirty && (!m_atlas || m_frame - m_frame_uploaded >= upload_interval))
+	{
+		m_atlas_previous	= m_atlas;
+		m_atlas				= make_shared<RHI_Texture2D>(m_context, m_atlas_size, m_atlas_size, RHI_Format_R8G8B8A8_Unorm, m_atlas_data);
+		m_atlas_dirty		= false;
+		m_frame_uploaded	= m_frame;
+
+		// The slots are only drawn from once their pixels are on the gpu
+		for (const auto& pending : m_atlas_pending)
+		{
+			if (m_atlas_slots[pending.second] == pending.first)
+			{
+				pending.first->atlas_slot = pending.second;
+			}
+		}
+		m_atlas_pending.clear();
+	}
+}
+
 RHI_Texture* IconProvider::GetTextureByType(Icon_Type type)
 {
 	return Thumbnail_Load("", type).texture.get();
@@ -96,17 +168,50 @@ RHI_Texture* IconProvider::GetTextureByFilePath(const std::string& filePath)
 	return Thumbnail_Load(filePath).texture.get();
 }
 
-RHI_Texture* IconProvider::GetTextureByThumbnail(const Thumbnail& thumbnail)
+RHI_Texture* IconProvider::GetTextureByThumbnail(const Thumbnail& thumbnail, Vector4* uv /*= nullptr*/)
 {
-	for (const auto& thumbnailTemp : m_thumbnails)
+	if (uv)
 	{
-		if (thumbnailTemp.texture->GetLoadState() != LoadState_Completed)
-			continue;
+		*uv = Vector4(0.0f, 0.0f, 1.0f, 1.0f);
+	}
+
+	// Icons (and engine textures)
+	if (thumbnail.texture)
+		return thumbnail.texture->GetLoadState() == LoadState_Completed ? thumbnail.texture.get() : nullptr;
 
-		if (thumbnailTemp.texture->GetId() == thumbnail.texture->GetId())
+	// Image files, the thumbnail that was handed out is a copy so look up the one which tracks the atlas slot
+	Thumbnail* image = thumbnail.filePath.empty() ? nullptr : GetThumbnailByPath(thumbnail.filePath);
+	if (!image)
+		return nullptr;
+
+	if (image->type != Thumbnail_Custom)
+		return GetTextureByType(image->type);
+
+	image->frame_used = m_frame;
+
+	if (image->atlas_slot >= 0 && m_atlas)
+	{
+		if (uv)
 		{
-			return thumbnailTemp.texture.get();
+			const uint32_t slots_per_row	= m_atlas_size / m_atlas_slot_size;
+			const float slot_uv				= static_cast<float>(m_atlas_slot_size) / static_cast<float>(m_atlas_size);
+			const float x					= static_cast<float>(image->atlas_slot % slots_per_row) * slot_uv;
+			const float y					= static_cast<float>(image->atlas_slot / slots_per_row) * slot_uv;
+			*uv = Vector4(x, y, x + slot_uv, y + slot_uv);
 		}
+
+		return m_atlas.get();
+	}
+
+	// Decode once it's drawn, so that browsing a large directory only decodes what's visible
+	if (!image->decoding)
+	{
+		image->decoding = true;
+		const string file_path = image->filePath;
+		m_context->GetSubsystem<Threading>()->AddTask([this, file_path]()
+		{
+			AtlasDecode(file_path);
+		}, {}, Threading_Pool_Background);
 	}
 
 	return nullptr;
@@ -117,19 +222,13 @@ const Thumbnail& IconProvider::Thumbnail_Load(const string& file_path, Icon_Type
 	// Check if we already have this thumbnail (by type)
 	if (type != Thumbnail_Custom)
 	{
-		for (auto& thumbnail : m_thumbnails)
-		{
-			if (thumbnail.type == type)
-				return thumbnail;
-		}
+		const auto it = m_thumbnails_by_type.find(type);
+		if (it != m_thumbnails_by_type.end())
+			return *it->second;
 	}
-	else // Check if we already have this thumbnail (by path)
-	{		
-		for (auto& thumbnail : m_thumbnails)
-		{
-			if (thumbnail.filePath == file_path)
-				return thumbnail;
-		}
+	else if (Thumbnail* thumbnail = GetThumbnailByPath(file_path)) // Check if we already have this thumbnail (by path)
+	{
+		return *thumbnail;
 	}
 
 	// Deduce file path type
@@ -165,7 +264,11 @@ const Thumbnail& IconProvider::Thumbnail_Load(const string& file_path, Icon_Type
 	// Texture
 	if (FileSystem::IsSupportedImageFile(file_path) || FileSystem::IsEngineTextureFile(file_path))
 	{
-		// Make a cheap texture
+		// Images are drawn from the atlas, they are decoded (see GetTextureByThumbnail()) once they are drawn
+		if (type == Thumbnail_Custom && FileSystem::IsSupportedImageFile(file_path))
+			return ThumbnailAdd(type, nullptr, file_path);
+
+		// Icons (and engine textures) get a cheap texture of their own
 		bool m_generate_mipmaps = false;
 		auto texture = std::make_shared<RHI_Texture2D>(m_context, m_generate_mipmaps);
 		texture->SetWidth(size);
@@ -175,10 +278,9 @@ const Thumbnail& IconProvider::Thumbnail_Load(const string& file_path, Icon_Type
 		m_context->GetSubsystem<Threading>()->AddTask([texture, file_path]()
 		{
 			texture->LoadFromFile(file_path);
-		});
+		}, {}, Threading_Pool_Background);
 
-		m_thumbnails.emplace_back(type, texture, file_path);
-		return m_thumbnails.back();
+		return ThumbnailAdd(type, texture, file_path);
 	}
 
 	return GetThumbnailByType(Thumbnail_File_Default);
@@ -186,11 +288,115 @@ const Thumbnail& IconProvider::Thumbnail_Load(const string& file_path, Icon_Type
 
 const Thumbnail& IconProvider::GetThumbnailByType(Icon_Type type)
 {
-	for (auto& thumbnail : m_thumbnails)
+	const auto it = m_thumbnails_by_type.find(type);
+	return it != m_thumbnails_by_type.end() ? *it->second : g_noThumbnail;
+}
+
+Thumbnail* IconProvider::GetThumbnailByPath(const string& file_path)
+{
+	const auto it = m_thumbnails_by_path.find(file_path);
+	return it != m_thumbnails_by_path.end() ? it->second : nullptr;
+}
+
+Thumbnail& IconProvider::ThumbnailAdd(Icon_Type type, shared_ptr<RHI_Texture> texture, const string& file_path)
+{
+	Thumbnail& thumbnail = m_thumbnails.emplace_back(type, move(texture), file_path);
+
+	if (type != Thumbnail_Custom)
+	{
+		m_thumbnails_by_type.emplace(type, &thumbnail);
+	}
+
+	if (!file_path.empty())
+	{
+		m_thumbnails_by_path.emplace(file_path, &thumbnail);
+	}
+
+	return thumbnail;
+}
+
+void IconProvider::AtlasDecode(const string& file_path)
+{
+	DecodedThumbnail image;
+	image.file_path = file_path;
+
+	ResourceCache* resource_cache			= m_context->GetSubsystem<ResourceCache>();
+	DerivedDataCache* derived_data_cache	= resource_cache->GetDerivedDataCache();
+	const size_t pixel_bytes				= m_atlas_slot_size * m_atlas_slot_size * 4;
+
+	// The downscaled pixels persist in the derived data cache, keyed by the file's path, size and last write time,
+	// so a directory which was browsed before (even in an earlier session) doesn't decode anything
+	size_t key = derived_data_cache->ComputeKeyFromTimestamp(file_path);
+	if (key != 0)
+	{
+		Utility::Hash::hash_combine(key, m_atlas_slot_size);
+	}
+
+	string data;
+	if (derived_data_cache->Load(key, &data) && data.size() == pixel_bytes)
 	{
-		if (thumbnail.type == type)
-			return thumbnail;
+		image.pixels.resize(pixel_bytes);
+		memcpy(image.pixels.data(), data.data(), pixel_bytes);
 	}
+	else
+	{
+		// Decode, the importer scales it down to the slot size
+		RHI_Texture2D texture(m_context, false);
+		texture.SetWidth(m_atlas_slot_size);
+		texture.SetHeight(m_atlas_slot_size);
+		const bool loaded = resource_cache->GetImageImporter()->Load(file_path, &texture, false);
+		const vector<std::byte>* mip = loaded ? texture.GetData(0) : nullptr;
+
+		if (mip && texture.GetWidth() == m_atlas_slot_size && texture.GetHeight() == m_atlas_slot_size)
+		{
+			if (texture.GetFormat() == RHI_Format_R8G8B8A8_Unorm && mip->size() == pixel_bytes)
+			{
+				image.pixels = *mip;
+			}
+			else if (texture.GetFormat() == RHI_Format_R32G32B32A32_Float && mip->size() == pixel_bytes * sizeof(float))
+			{
+				const float* source = reinterpret_cast<const float*>(mip->data());
+				image.pixels.resize(pixel_bytes);
+				for (size_t i = 0; i < pixel_bytes; i++)
+				{
+					image.pixels[i] = static_cast<std::byte>(Helper::Saturate(source[i]) * 255.0f);
+				}
+			}
+		}
+
+		if (!image.pixels.empty())
+		{
+			derived_data_cache->Save(key, string(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size()));
+		}
+	}
+
+	lock_guard<mutex> lock(m_decoded_mutex);
+	m_decoded.emplace_back(move(image));
+}
+
+int IconProvider::AtlasAllocateSlot()
+{
+	// A free slot
+	for (uint32_t i = 0; i < m_atlas_slots.size(); i++)
+	{
+		if (!m_atlas_slots[i])
+			return static_cast<int>(i);
+	}
+
+	// The slot of the least recently drawn thumbnail
+	uint32_t slot = 0;
+	for (uint32_t i = 1; i < m_atlas_slots.size(); i++)
+	{
+		if (m_atlas_slots[i]->frame_used < m_atlas_slots[slot]->frame_used)
+		{
+			slot = i;
+		}
+	}
+
+	Thumbnail* evicted		= m_atlas_slots[slot];
+	evicted->atlas_slot		= -1;
+	evicted->decoding		= false;
+	m_atlas_slots[slot]		= nullptr;
 
-	return g_noThumbnail;
+	return static_cast<int>(slot);
 }
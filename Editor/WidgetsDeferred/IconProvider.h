@@ -25,8 +25,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <utility>
 #include <vector>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include "RHI/RHI_Definition.h"
+#include "Math/Vector4.h"
 //=============================
 
 enum Icon_Type
@@ -86,6 +90,11 @@ struct Thumbnail
     Icon_Type type = Icon_NotAssigned;
 	std::shared_ptr<Spartan::RHI_Texture> texture;
 	std::string filePath;
+
+	// Image files don't get a texture of their own, they are drawn from a slot of the thumbnail atlas (-1 while decoding or evicted)
+	int atlas_slot      = -1;
+	bool decoding       = false;
+	uint64_t frame_used = 0;
 };
 
 class IconProvider
@@ -101,14 +110,48 @@ public:
 	~IconProvider();
 
 	void Initialize(Spartan::Context* context);
+	// Packs the thumbnails which finished decoding into the atlas, once per frame
+	void Tick();
 
 	Spartan::RHI_Texture* GetTextureByType(Icon_Type type);
 	Spartan::RHI_Texture* GetTextureByFilePath(const std::string& filePath);
-	Spartan::RHI_Texture* GetTextureByThumbnail(const Thumbnail& thumbnail);
+	// The uv rectangle (min xy, max xy) is the thumbnail's slot when it's drawn from the atlas
+	Spartan::RHI_Texture* GetTextureByThumbnail(const Thumbnail& thumbnail, Spartan::Math::Vector4* uv = nullptr);
 	const Thumbnail& Thumbnail_Load(const std::string& filePath, Icon_Type type = Thumbnail_Custom, int size = 100);
 
 private:
 	const Thumbnail& GetThumbnailByType(Icon_Type type);
-	std::vector<Thumbnail> m_thumbnails;
+	Thumbnail* GetThumbnailByPath(const std::string& file_path);
+	Thumbnail& ThumbnailAdd(Icon_Type type, std::shared_ptr<Spartan::RHI_Texture> texture, const std::string& file_path);
+
+	// A deque, so that the thumbnails don't move as more are added
+	std::deque<Thumbnail> m_thumbnails;
+	std::unordered_map<std::string, Thumbnail*> m_thumbnails_by_path;
+	std::unordered_map<int, Thumbnail*> m_thumbnails_by_type;
+
+	// Atlas, the decoded (and downscaled) images are written into fixed size slots on the cpu and the texture is created again from them
+	// when slots changed. When all the slots are taken, the least recently drawn thumbnail gives its slot up and decodes again when it's drawn.
+	void AtlasDecode(const std::string& file_path);
+	int AtlasAllocateSlot();
+	static const uint32_t m_atlas_size      = 2048;
+	static const uint32_t m_atlas_slot_size = 128;
+	std::vector<std::byte> m_atlas_data;
+	std::vector<Thumbnail*> m_atlas_slots;
+	std::vector<std::pair<Thumbnail*, int>> m_atlas_pending; // packed, but not uploaded yet
+	std::shared_ptr<Spartan::RHI_Texture> m_atlas;
+	std::shared_ptr<Spartan::RHI_Texture> m_atlas_previous; // can still be referenced by the frames in flight
+	bool m_atlas_dirty          = false;
+	uint64_t m_frame            = 0;
+	uint64_t m_frame_uploaded   = 0;
+
+	// Decoded in the background, packed on the main thread
+	struct DecodedThumbnail
+	{
+		std::string file_path;
+		std::vector<std::byte> pixels; // rgba8, empty if it failed
+	};
+	std::vector<DecodedThumbnail> m_decoded;
+	std::mutex m_decoded_mutex;
+
 	Spartan::Context* m_context;
 };
@@ -0,0 +1,104 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==========
+#include "CameraPath.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+//=====================
+
+//= NAMESPACES ===========
+using namespace std;
+using namespace Spartan::Math;
+//========================
+
+namespace
+{
+    template<typename T>
+    T catmull_rom(const T& p0, const T& p1, const T& p2, const T& p3, const float t)
+    {
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        return (p1 * 2.0f + (p2 - p0) * t + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * t2 + (p1 * 3.0f - p0 - p2 * 3.0f + p3) * t3) * 0.5f;
+    }
+}
+
+bool CameraPath::Load(const string& path)
+{
+    ifstream file(path);
+    if (!file.good())
+    {
+        cerr << "Failed to open \"" << path << "\"" << endl;
+        return false;
+    }
+
+    m_keys.clear();
+    string line;
+    uint32_t line_number = 0;
+    while (getline(file, line))
+    {
+        line_number++;
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        Key key;
+        istringstream stream(line);
+        if (!(stream >> key.position.x >> key.position.y >> key.position.z >> key.pitch >> key.yaw))
+        {
+            cerr << path << "(" << line_number << "): expected \"x y z pitch yaw\"" << endl;
+            return false;
+        }
+        m_keys.emplace_back(key);
+    }
+
+    if (m_keys.empty())
+    {
+        cerr << "\"" << path << "\" has no keys" << endl;
+        return false;
+    }
+
+    return true;
+}
+
+CameraPath::Key CameraPath::Evaluate(const float fraction) const
+{
+    if (m_keys.size() == 1)
+        return m_keys.front();
+
+    // The segment and the position in it, the end keys are repeated so that the spline goes through them
+    const float segments    = static_cast<float>(m_keys.size() - 1);
+    const float position    = (fraction < 0.0f ? 0.0f : fraction > 1.0f ? 1.0f : fraction) * segments;
+    const size_t i          = position >= segments ? m_keys.size() - 2 : static_cast<size_t>(position);
+    const float t           = position - static_cast<float>(i);
+
+    const Key& k0 = m_keys[i == 0 ? 0 : i - 1];
+    const Key& k1 = m_keys[i];
+    const Key& k2 = m_keys[i + 1];
+    const Key& k3 = m_keys[i + 2 < m_keys.size() ? i + 2 : i + 1];
+
+    Key key;
+    key.position    = catmull_rom(k0.position, k1.position, k2.position, k3.position, t);
+    key.pitch       = catmull_rom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t);
+    key.yaw         = catmull_rom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+    return key;
+}
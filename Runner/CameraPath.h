@@ -0,0 +1,53 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ============
+#include <string>
+#include <vector>
+#include "Math/Vector3.h"
+//=======================
+
+// A camera path for the runner, a Catmull-Rom spline through keys which are spaced evenly in time.
+//
+// The file has a key per line, "x y z pitch yaw" (the angles in degrees), lines which start with # are comments.
+// Angles are interpolated as they are, so a turn from 350 to 10 degrees should be written as 350 to 370.
+class CameraPath
+{
+public:
+    struct Key
+    {
+        Spartan::Math::Vector3 position;
+        float pitch = 0.0f;
+        float yaw   = 0.0f;
+    };
+
+    bool Load(const std::string& path);
+    void AddKey(const Key& key) { m_keys.emplace_back(key); }
+    // A fraction goes from 0 (the first key) to 1 (the last key)
+    Key Evaluate(float fraction) const;
+    bool IsEmpty() const { return m_keys.empty(); }
+
+private:
+    std::vector<Key> m_keys;
+};
@@ -0,0 +1,273 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include "Report.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "Profiling/Profiler.h"
+//================================
+
+//= NAMESPACES ========
+using namespace std;
+using namespace Spartan;
+//=====================
+
+void Report::AddFrame(const Profiler* profiler)
+{
+    Frame& frame                    = m_frames.emplace_back();
+    frame.index                     = static_cast<uint32_t>(m_frames.size() - 1);
+    frame.meshes_rendered           = profiler->m_renderer_meshes_rendered;
+    frame.draw_calls                = profiler->m_rhi_draw_calls;
+    frame.bindings_buffer_index     = profiler->m_rhi_bindings_buffer_index;
+    frame.bindings_buffer_vertex    = profiler->m_rhi_bindings_buffer_vertex;
+    frame.bindings_buffer_constant  = profiler->m_rhi_bindings_buffer_constant;
+    frame.bindings_sampler          = profiler->m_rhi_bindings_sampler;
+    frame.bindings_texture          = profiler->m_rhi_bindings_texture;
+    frame.bindings_shader_vertex    = profiler->m_rhi_bindings_shader_vertex;
+    frame.bindings_shader_pixel     = profiler->m_rhi_bindings_shader_pixel;
+    frame.bindings_shader_compute   = profiler->m_rhi_bindings_shader_compute;
+    frame.bindings_render_target    = profiler->m_rhi_bindings_render_target;
+    frame.bindings_descriptor_set   = profiler->m_rhi_bindings_descriptor_set;
+    frame.bindings_pipeline         = profiler->m_rhi_bindings_pipeline;
+    frame.pipeline_barriers         = profiler->m_rhi_pipeline_barriers;
+}
+
+void Report::SetTimes(const Profiler* profiler)
+{
+    if (m_frames.empty())
+        return;
+
+    Frame& frame        = m_frames.back();
+    frame.time_frame    = profiler->GetTimeFrameLast();
+    frame.time_cpu      = profiler->GetTimeCpuLast();
+    frame.time_gpu      = profiler->GetTimeGpuLast();
+}
+
+bool Report::SaveCsv(const string& path) const
+{
+    ofstream file(path);
+    if (!file.good())
+    {
+        cerr << "Failed to open \"" << path << "\" for writing" << endl;
+        return false;
+    }
+
+    file << "frame,frame_ms,cpu_ms,gpu_ms,meshes_rendered,draw_calls,bindings_buffer_index,bindings_buffer_vertex,bindings_buffer_constant,bindings_sampler,"
+            "bindings_texture,bindings_shader_vertex,bindings_shader_pixel,bindings_shader_compute,bindings_render_target,bindings_descriptor_set,bindings_pipeline,pipeline_barriers" << endl;
+    for (const Frame& frame : m_frames)
+    {
+        char line[512];
+        snprintf(line, sizeof(line), "%u,%.3f,%.3f,%.3f,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u",
+            frame.index, frame.time_frame, frame.time_cpu, frame.time_gpu, frame.meshes_rendered, frame.draw_calls,
+            frame.bindings_buffer_index, frame.bindings_buffer_vertex, frame.bindings_buffer_constant, frame.bindings_sampler, frame.bindings_texture,
+            frame.bindings_shader_vertex, frame.bindings_shader_pixel, frame.bindings_shader_compute, frame.bindings_render_target,
+            frame.bindings_descriptor_set, frame.bindings_pipeline, frame.pipeline_barriers);
+        file << line << endl;
+    }
+
+    return true;
+}
+
+bool Report::SaveJson(const string& path) const
+{
+    ofstream file(path);
+    if (!file.good())
+    {
+        cerr << "Failed to open \"" << path << "\" for writing" << endl;
+        return false;
+    }
+
+    // A metric per line, so that Compare() can find them without a json parser
+    file << "{" << endl;
+    file << "    \"build\": \"" << GetBuild() << "\"," << endl;
+    file << "    \"world\": \"" << m_world << "\"," << endl;
+    file << "    \"resolution\": [" << m_width << ", " << m_height << "]," << endl;
+    file << "    \"frames\": " << m_frames.size() << "," << endl;
+    file << "    \"times\":" << endl;
+    file << "    [" << endl;
+    {
+        const pair<const char*, float Frame::*> fields[] = { { "frame_ms", &Frame::time_frame }, { "cpu_ms", &Frame::time_cpu }, { "gpu_ms", &Frame::time_gpu } };
+        for (size_t i = 0; i < size(fields); i++)
+        {
+            const Percentiles percentiles = ComputePercentiles(fields[i].second);
+            char line[256];
+            snprintf(line, sizeof(line), "        { \"name\": \"%s\", \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s",
+                fields[i].first, percentiles.p50, percentiles.p90, percentiles.p99, percentiles.max, i + 1 < size(fields) ? "," : "");
+            file << line << endl;
+        }
+    }
+    file << "    ]," << endl;
+    file << "    \"counters\":" << endl;
+    file << "    {" << endl;
+    {
+        const pair<const char*, uint32_t Frame::*> fields[] =
+        {
+            { "meshes_rendered",            &Frame::meshes_rendered },
+            { "draw_calls",                 &Frame::draw_calls },
+            { "bindings_buffer_index",      &Frame::bindings_buffer_index },
+            { "bindings_buffer_vertex",     &Frame::bindings_buffer_vertex },
+            { "bindings_buffer_constant",   &Frame::bindings_buffer_constant },
+            { "bindings_sampler",           &Frame::bindings_sampler },
+            { "bindings_texture",           &Frame::bindings_texture },
+            { "bindings_shader_vertex",     &Frame::bindings_shader_vertex },
+            { "bindings_shader_pixel",      &Frame::bindings_shader_pixel },
+            { "bindings_shader_compute",    &Frame::bindings_shader_compute },
+            { "bindings_render_target",     &Frame::bindings_render_target },
+            { "bindings_descriptor_set",    &Frame::bindings_descriptor_set },
+            { "bindings_pipeline",          &Frame::bindings_pipeline },
+            { "pipeline_barriers",          &Frame::pipeline_barriers }
+        };
+        for (size_t i = 0; i < size(fields); i++)
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "        \"%s\": %.2f%s", fields[i].first, ComputeAverage(fields[i].second), i + 1 < size(fields) ? "," : "");
+            file << line << endl;
+        }
+    }
+    file << "    }" << endl;
+    file << "}" << endl;
+
+    return true;
+}
+
+bool Report::Compare(const string& path_baseline, const double tolerance) const
+{
+    ifstream file(path_baseline);
+    if (!file.good())
+    {
+        cerr << "Failed to open \"" << path_baseline << "\"" << endl;
+        return false;
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    const string json = buffer.str();
+
+    auto find_p50 = [&json](const string& name, double* value)
+    {
+        const size_t line = json.find("\"name\": \"" + name + "\"");
+        if (line == string::npos)
+            return false;
+
+        const size_t position = json.find("\"p50\": ", line);
+        if (position == string::npos || position > json.find('\n', line))
+            return false;
+
+        *value = strtod(json.c_str() + position + 7, nullptr);
+        return true;
+    };
+
+    if (json.find("\"world\": \"" + m_world + "\"") == string::npos)
+    {
+        cout << "The baseline was produced with another world, the comparison may not be meaningful" << endl;
+    }
+
+    bool regressed = false;
+    const pair<const char*, float Frame::*> fields[] = { { "frame_ms", &Frame::time_frame }, { "cpu_ms", &Frame::time_cpu }, { "gpu_ms", &Frame::time_gpu } };
+    for (const auto& field : fields)
+    {
+        double baseline = 0.0;
+        if (!find_p50(field.first, &baseline) || baseline <= 0.0)
+        {
+            cout << field.first << ": not in the baseline" << endl;
+            continue;
+        }
+
+        const double p50    = ComputePercentiles(field.second).p50;
+        const double change = p50 / baseline - 1.0;
+        const bool slower   = change > tolerance;
+        regressed           = regressed || slower;
+
+        char line[256];
+        snprintf(line, sizeof(line), "%-12s %10.3f -> %10.3f ms %+7.1f%%%s", field.first, baseline, p50, change * 100.0, slower ? "  REGRESSION" : "");
+        cout << line << endl;
+    }
+
+    return !regressed;
+}
+
+const char* Report::GetBuild()
+{
+#if defined(_MSC_VER)
+    const string compiler = "msvc_" + to_string(_MSC_VER);
+#else
+    const string compiler = "other";
+#endif
+
+#if defined(DEBUG)
+    const string configuration = "debug";
+#else
+    const string configuration = "release";
+#endif
+
+#if defined(API_GRAPHICS_D3D11)
+    const string api = "d3d11";
+#elif defined(API_GRAPHICS_D3D12)
+    const string api = "d3d12";
+#elif defined(API_GRAPHICS_VULKAN)
+    const string api = "vulkan";
+#else
+    const string api = "unknown";
+#endif
+
+    static const string build = compiler + "_" + configuration + "_" + api;
+    return build.c_str();
+}
+
+Report::Percentiles Report::ComputePercentiles(float Frame::* field) const
+{
+    Percentiles percentiles;
+    if (m_frames.empty())
+        return percentiles;
+
+    vector<double> samples;
+    samples.reserve(m_frames.size());
+    for (const Frame& frame : m_frames)
+    {
+        samples.emplace_back(frame.*field);
+    }
+    sort(samples.begin(), samples.end());
+
+    auto percentile = [&samples](const double fraction) { return samples[static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1) + 0.5)]; };
+    percentiles.p50 = percentile(0.5);
+    percentiles.p90 = percentile(0.9);
+    percentiles.p99 = percentile(0.99);
+    percentiles.max = samples.back();
+    return percentiles;
+}
+
+double Report::ComputeAverage(uint32_t Frame::* field) const
+{
+    if (m_frames.empty())
+        return 0.0;
+
+    double sum = 0.0;
+    for (const Frame& frame : m_frames)
+    {
+        sum += frame.*field;
+    }
+    return sum / static_cast<double>(m_frames.size());
+}
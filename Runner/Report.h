@@ -0,0 +1,87 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ======
+#include <string>
+#include <vector>
+//=================
+
+namespace Spartan { class Profiler; }
+
+// The frames of a runner session, saved as CSV (a row per frame) and JSON (the percentiles of the times and the averages of the counters)
+class Report
+{
+public:
+    struct Frame
+    {
+        uint32_t index                    = 0;
+        float time_frame                  = 0.0f; // ms
+        float time_cpu                    = 0.0f; // ms
+        float time_gpu                    = 0.0f; // ms
+        uint32_t meshes_rendered          = 0;
+        uint32_t draw_calls               = 0;
+        uint32_t bindings_buffer_index    = 0;
+        uint32_t bindings_buffer_vertex   = 0;
+        uint32_t bindings_buffer_constant = 0;
+        uint32_t bindings_sampler         = 0;
+        uint32_t bindings_texture         = 0;
+        uint32_t bindings_shader_vertex   = 0;
+        uint32_t bindings_shader_pixel    = 0;
+        uint32_t bindings_shader_compute  = 0;
+        uint32_t bindings_render_target   = 0;
+        uint32_t bindings_descriptor_set  = 0;
+        uint32_t bindings_pipeline        = 0;
+        uint32_t pipeline_barriers        = 0;
+    };
+
+    Report(const std::string& world, uint32_t width, uint32_t height) : m_world(world), m_width(width), m_height(height) {}
+
+    // The counters are the ones of the frame which was just recorded
+    void AddFrame(const Spartan::Profiler* profiler);
+    // The profiler measures a frame when the next one starts, so the times arrive a frame late
+    void SetTimes(const Spartan::Profiler* profiler);
+
+    bool SaveCsv(const std::string& path) const;
+    bool SaveJson(const std::string& path) const;
+    // Compares the medians of the times with the ones of an earlier run, returns false if any of them is slower by more than the tolerance (a fraction)
+    bool Compare(const std::string& path_baseline, double tolerance) const;
+
+    static const char* GetBuild();
+
+private:
+    struct Percentiles
+    {
+        double p50  = 0.0;
+        double p90  = 0.0;
+        double p99  = 0.0;
+        double max  = 0.0;
+    };
+    Percentiles ComputePercentiles(float Frame::* field) const;
+    double ComputeAverage(uint32_t Frame::* field) const;
+
+    std::string m_world;
+    uint32_t m_width    = 0;
+    uint32_t m_height   = 0;
+    std::vector<Frame> m_frames;
+};
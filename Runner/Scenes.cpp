@@ -0,0 +1,400 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================================
+#include "Scenes.h"
+#include <iostream>
+#include <random>
+#include "Core/Context.h"
+#include "Core/FileSystem.h"
+#include "Rendering/Material.h"
+#include "Rendering/Model.h"
+#include "Resource/ResourceCache.h"
+#include "RHI/RHI_Texture2D.h"
+#include "Utilities/Geometry.h"
+#include "World/Entity.h"
+#include "World/World.h"
+#include "World/Components/Collider.h"
+#include "World/Components/Light.h"
+#include "World/Components/Renderable.h"
+#include "World/Components/RigidBody.h"
+#include "World/Components/Script.h"
+#include "World/Components/Terrain.h"
+#include "World/Components/Transform.h"
+//================================================
+
+//= NAMESPACES ===========
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//========================
+
+namespace
+{
+    // A single model which all the entities of a scene share, the way an imported model's meshes are shared
+    struct Mesh
+    {
+        shared_ptr<Model> model;
+        uint32_t index_count    = 0;
+        uint32_t vertex_count   = 0;
+        BoundingBox bounding_box;
+    };
+
+    Mesh create_mesh(Context* context, const Geometry_Type type, const string& name)
+    {
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        vector<uint32_t> indices;
+        if (type == Geometry_Default_Quad)          Utility::Geometry::CreateQuad(&vertices, &indices);
+        else if (type == Geometry_Default_Sphere)   Utility::Geometry::CreateSphere(&vertices, &indices, 0.5f);
+        else                                        Utility::Geometry::CreateCube(&vertices, &indices);
+
+        Mesh mesh;
+        mesh.model          = make_shared<Model>(context);
+        mesh.index_count    = static_cast<uint32_t>(indices.size());
+        mesh.vertex_count   = static_cast<uint32_t>(vertices.size());
+        mesh.bounding_box   = BoundingBox(vertices.data(), mesh.vertex_count);
+        mesh.model->SetResourceFilePath(context->GetSubsystem<ResourceCache>()->GetProjectDirectory() + name + EXTENSION_MODEL);
+        mesh.model->AppendGeometry(indices, vertices);
+        mesh.model->UpdateGeometry();
+        return mesh;
+    }
+
+    shared_ptr<Material> create_material(Context* context, const string& name, const Vector4& color)
+    {
+        shared_ptr<Material> material = make_shared<Material>(context);
+        material->SetResourceFilePath(context->GetSubsystem<ResourceCache>()->GetProjectDirectory() + name + EXTENSION_MATERIAL);
+        material->SetColorAlbedo(color);
+        return material;
+    }
+
+    Entity* create_entity(World* world, const string& name, const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+    {
+        Entity* entity = world->EntityCreate().get();
+        entity->SetName(name);
+        entity->GetTransform()->SetPosition(position);
+        entity->GetTransform()->SetRotation(rotation);
+        entity->GetTransform()->SetScale(scale);
+        return entity;
+    }
+
+    void add_renderable(Entity* entity, const Mesh& mesh, const shared_ptr<Material>& material)
+    {
+        Renderable* renderable = entity->AddComponent<Renderable>();
+        renderable->GeometrySet("runner_mesh", 0, mesh.index_count, 0, mesh.vertex_count, mesh.bounding_box, mesh.model.get());
+        renderable->SetMaterial(material);
+    }
+
+    Entity* create_floor(Context* context, World* world, const float size, const bool physics)
+    {
+        const Mesh mesh             = create_mesh(context, Geometry_Default_Cube, "runner_floor");
+        Entity* floor               = create_entity(world, "Floor", Vector3(0.0f, -0.5f, 0.0f), Quaternion::Identity, Vector3(size, 1.0f, size));
+        add_renderable(floor, mesh, create_material(context, "runner_floor", Vector4(0.5f, 0.5f, 0.5f, 1.0f)));
+
+        if (physics)
+        {
+            floor->AddComponent<RigidBody>(); // no mass, so it's static
+            floor->AddComponent<Collider>();
+        }
+
+        return floor;
+    }
+
+    // A circle around the center, looking at it from above
+    void add_orbit(CameraPath& path, const float radius, const float height, const float pitch)
+    {
+        constexpr uint32_t key_count = 9;
+        for (uint32_t i = 0; i < key_count; i++)
+        {
+            const float angle = static_cast<float>(i) / static_cast<float>(key_count - 1) * Helper::PI_2;
+
+            CameraPath::Key key;
+            key.position    = Vector3(sin(angle) * -radius, height, cos(angle) * -radius);
+            key.pitch       = pitch;
+            key.yaw         = angle * Helper::RAD_TO_DEG;
+            path.AddKey(key);
+        }
+    }
+
+    // 100k static instances of a few materials, it's the geometry pass (and culling) which is measured
+    bool create_instances(Context* context, World* world, const uint32_t count, mt19937& random, Scenes::Scene* scene)
+    {
+        const Mesh mesh = create_mesh(context, Geometry_Default_Cube, "runner_cube");
+        const shared_ptr<Material> materials[] =
+        {
+            create_material(context, "runner_red",      Vector4(0.8f, 0.2f, 0.2f, 1.0f)),
+            create_material(context, "runner_green",    Vector4(0.2f, 0.8f, 0.2f, 1.0f)),
+            create_material(context, "runner_blue",     Vector4(0.2f, 0.2f, 0.8f, 1.0f)),
+            create_material(context, "runner_white",    Vector4(0.9f, 0.9f, 0.9f, 1.0f))
+        };
+
+        const float extent = sqrt(static_cast<float>(count)) * 1.5f;
+        uniform_real_distribution<float> position(-extent, extent);
+        uniform_real_distribution<float> scale(0.5f, 2.0f);
+        uniform_real_distribution<float> angle(0.0f, 360.0f);
+        uniform_int_distribution<uint32_t> material(0, static_cast<uint32_t>(size(materials)) - 1);
+
+        create_floor(context, world, extent * 2.0f, false);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float height  = scale(random);
+            Entity* entity      = create_entity(world, "Instance", Vector3(position(random), height * 0.5f, position(random)), Quaternion::FromEulerAngles(0.0f, angle(random), 0.0f), Vector3(scale(random), height, scale(random)));
+            add_renderable(entity, mesh, materials[material(random)]);
+        }
+
+        add_orbit(scene->camera_path, extent * 0.5f, 20.0f, 20.0f);
+        return true;
+    }
+
+    // 1k shadowed point lights over occluders, it's the light depth pass which is measured
+    bool create_lights(Context* context, World* world, const uint32_t count, mt19937& random, Scenes::Scene* scene)
+    {
+        const Mesh mesh                         = create_mesh(context, Geometry_Default_Cube, "runner_cube");
+        const shared_ptr<Material> material     = create_material(context, "runner_white", Vector4(0.9f, 0.9f, 0.9f, 1.0f));
+
+        const float extent = sqrt(static_cast<float>(count)) * 4.0f;
+        uniform_real_distribution<float> position(-extent, extent);
+        uniform_real_distribution<float> height(1.0f, 4.0f);
+        uniform_real_distribution<float> color(0.2f, 1.0f);
+
+        create_floor(context, world, extent * 2.0f, false);
+        for (uint32_t i = 0; i < count * 2; i++)
+        {
+            const float size    = height(random);
+            Entity* entity      = create_entity(world, "Occluder", Vector3(position(random), size * 0.5f, position(random)), Quaternion::Identity, Vector3(1.0f, size, 1.0f));
+            add_renderable(entity, mesh, material);
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Entity* entity  = create_entity(world, "Light", Vector3(position(random), height(random) + 1.0f, position(random)), Quaternion::Identity, Vector3::One);
+            Light* light    = entity->AddComponent<Light>();
+            light->SetLightType(LightType_Point);
+            light->SetColor(color(random), color(random), color(random), 1.0f);
+            light->SetRange(8.0f);
+            light->SetIntensity(5.0f);
+            light->SetShadowsEnabled(true);
+        }
+
+        add_orbit(scene->camera_path, extent * 0.5f, 10.0f, 25.0f);
+        return true;
+    }
+
+    // 10k rigid bodies falling in a pile, it's the physics simulation which is measured
+    bool create_rigid_bodies(Context* context, World* world, const uint32_t count, mt19937& random, Scenes::Scene* scene)
+    {
+        const Mesh mesh                         = create_mesh(context, Geometry_Default_Cube, "runner_cube");
+        const shared_ptr<Material> material     = create_material(context, "runner_red", Vector4(0.8f, 0.2f, 0.2f, 1.0f));
+
+        // Columns of bodies, with a bit of jitter so that the pile collapses
+        const uint32_t side = static_cast<uint32_t>(ceil(sqrt(static_cast<float>(count) / 20.0f)));
+        uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+
+        create_floor(context, world, static_cast<float>(side) * 4.0f, true);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t column   = i % (side * side);
+            const uint32_t level    = i / (side * side);
+            const Vector3 position
+            (
+                (static_cast<float>(column % side) - side * 0.5f) * 1.5f + jitter(random),
+                static_cast<float>(level) * 1.2f + 1.0f,
+                (static_cast<float>(column / side) - side * 0.5f) * 1.5f + jitter(random)
+            );
+
+            Entity* entity = create_entity(world, "Body", position, Quaternion::Identity, Vector3::One);
+            add_renderable(entity, mesh, material);
+            entity->AddComponent<RigidBody>()->SetMass(1.0f);
+            entity->AddComponent<Collider>();
+        }
+
+        add_orbit(scene->camera_path, static_cast<float>(side) * 2.0f, 15.0f, 25.0f);
+        scene->game = true;
+        return true;
+    }
+
+    // 5k entities which run a script every frame, it's the world tick (and the script calls) which is measured
+    bool create_scripts(Context* context, World* world, const uint32_t count, mt19937& random, Scenes::Scene* scene)
+    {
+        const Mesh mesh                         = create_mesh(context, Geometry_Default_Cube, "runner_cube");
+        const shared_ptr<Material> material     = create_material(context, "runner_green", Vector4(0.2f, 0.8f, 0.2f, 1.0f));
+        const string script                     = context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Scripts) + "/RotateAroundSelf.as";
+
+        const uint32_t side = static_cast<uint32_t>(ceil(sqrt(static_cast<float>(count))));
+        uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+        create_floor(context, world, static_cast<float>(side) * 3.0f, false);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const Vector3 position((static_cast<float>(i % side) - side * 0.5f) * 2.0f, 1.0f, (static_cast<float>(i / side) - side * 0.5f) * 2.0f);
+            Entity* entity = create_entity(world, "Scripted", position, Quaternion::FromEulerAngles(0.0f, angle(random), 0.0f), Vector3::One);
+            add_renderable(entity, mesh, material);
+            if (!entity->AddComponent<Script>()->SetScript(script))
+            {
+                cerr << "Failed to load \"" << script << "\"" << endl;
+                return false;
+            }
+        }
+
+        add_orbit(scene->camera_path, static_cast<float>(side) * 0.75f, 12.0f, 25.0f);
+        scene->game = true;
+        return true;
+    }
+
+    // A large terrain from a generated height map (octaves of value noise), it's the terrain generation and its rendering which is measured
+    bool create_terrain(Context* context, World* world, const uint32_t count, mt19937& random, Scenes::Scene* scene)
+    {
+        const uint32_t size = count;
+
+        // A lattice of random values, interpolated smoothly
+        constexpr uint32_t lattice_size = 256;
+        vector<float> lattice(lattice_size * lattice_size);
+        uniform_real_distribution<float> value(0.0f, 1.0f);
+        for (float& v : lattice)
+        {
+            v = value(random);
+        }
+
+        const auto noise = [&lattice](const float x, const float y)
+        {
+            const uint32_t x0   = static_cast<uint32_t>(x), y0 = static_cast<uint32_t>(y);
+            const float fx      = x - static_cast<float>(x0), fy = y - static_cast<float>(y0);
+            const float sx      = fx * fx * (3.0f - 2.0f * fx), sy = fy * fy * (3.0f - 2.0f * fy);
+            const auto at       = [&lattice](const uint32_t x, const uint32_t y) { return lattice[(y % lattice_size) * lattice_size + (x % lattice_size)]; };
+            return Helper::Lerp(Helper::Lerp(at(x0, y0), at(x0 + 1, y0), sx), Helper::Lerp(at(x0, y0 + 1), at(x0 + 1, y0 + 1), sx), sy);
+        };
+
+        vector<std::byte> pixels(size * size * 4);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                float height    = 0.0f;
+                float amplitude = 0.5f;
+                float frequency = 8.0f / static_cast<float>(size);
+                for (uint32_t octave = 0; octave < 5; octave++)
+                {
+                    height      += noise(x * frequency, y * frequency) * amplitude;
+                    amplitude   *= 0.5f;
+                    frequency   *= 2.0f;
+                }
+
+                const std::byte pixel = static_cast<std::byte>(static_cast<uint8_t>(Helper::Clamp(height, 0.0f, 1.0f) * 255.0f));
+                std::byte* rgba = &pixels[(y * size + x) * 4];
+                rgba[0] = rgba[1] = rgba[2] = pixel;
+                rgba[3] = static_cast<std::byte>(255);
+            }
+        }
+
+        shared_ptr<RHI_Texture2D> height_map = make_shared<RHI_Texture2D>(context, size, size, RHI_Format_R8G8B8A8_Unorm, pixels);
+        height_map->SetResourceFilePath(context->GetSubsystem<ResourceCache>()->GetProjectDirectory() + "runner_height_map" + EXTENSION_TEXTURE);
+
+        Entity* entity      = create_entity(world, "Terrain", Vector3::Zero, Quaternion::Identity, Vector3::One);
+        Terrain* terrain    = entity->AddComponent<Terrain>();
+        terrain->SetMinY(0.0f);
+        terrain->SetMaxY(static_cast<float>(size) * 0.1f);
+        terrain->SetHeightMap(height_map);
+        terrain->GenerateAsync();
+
+        // Ready once the generated geometry is there
+        scene->is_ready = [entity]()
+        {
+            const Renderable* renderable = entity->GetComponent<Renderable>();
+            return renderable && renderable->GeometryIndexCount() != 0;
+        };
+
+        add_orbit(scene->camera_path, static_cast<float>(size) * 0.3f, static_cast<float>(size) * 0.15f, 20.0f);
+        return true;
+    }
+
+    // Layers of overlapping transparent spheres in front of the camera, it's the transparent pass (and its overdraw) which is measured
+    bool create_transparency(Context* context, World* world, const uint32_t count, mt19937& random, Scenes::Scene* scene)
+    {
+        const Mesh mesh = create_mesh(context, Geometry_Default_Sphere, "runner_sphere");
+        const shared_ptr<Material> materials[] =
+        {
+            create_material(context, "runner_glass_red",    Vector4(0.9f, 0.3f, 0.3f, 0.3f)),
+            create_material(context, "runner_glass_green",  Vector4(0.3f, 0.9f, 0.3f, 0.3f)),
+            create_material(context, "runner_glass_blue",   Vector4(0.3f, 0.3f, 0.9f, 0.3f))
+        };
+
+        const float extent = cbrt(static_cast<float>(count)) * 0.75f;
+        uniform_real_distribution<float> position(-extent, extent);
+        uniform_real_distribution<float> scale(0.5f, 2.0f);
+        uniform_int_distribution<uint32_t> material(0, static_cast<uint32_t>(size(materials)) - 1);
+
+        create_floor(context, world, extent * 4.0f, false);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float size = scale(random);
+            Entity* entity = create_entity(world, "Transparent", Vector3(position(random), position(random) + extent + 1.0f, position(random)), Quaternion::Identity, Vector3(size, size, size));
+            add_renderable(entity, mesh, materials[material(random)]);
+        }
+
+        add_orbit(scene->camera_path, extent * 2.0f, extent + 1.0f, 0.0f);
+        return true;
+    }
+
+    struct SceneEntry
+    {
+        const char* name;
+        uint32_t count;
+        bool (*create)(Context*, World*, uint32_t, mt19937&, Scenes::Scene*);
+    };
+
+    const SceneEntry scene_entries[] =
+    {
+        { "instances",      100000, create_instances },
+        { "lights",         1000,   create_lights },
+        { "rigid_bodies",   10000,  create_rigid_bodies },
+        { "scripts",        5000,   create_scripts },
+        { "terrain",        2048,   create_terrain },   // the height map's size
+        { "transparency",   5000,   create_transparency }
+    };
+}
+
+bool Scenes::Create(const string& name, Context* context, const uint32_t count, const uint32_t seed, Scene* scene)
+{
+    for (const SceneEntry& entry : scene_entries)
+    {
+        if (name != entry.name)
+            continue;
+
+        mt19937 random(seed);
+        return entry.create(context, context->GetSubsystem<World>(), count != 0 ? count : entry.count, random, scene);
+    }
+
+    cerr << "There is no scene named \"" << name << "\"" << endl;
+    return false;
+}
+
+const vector<string>& Scenes::GetNames()
+{
+    static vector<string> names;
+    if (names.empty())
+    {
+        for (const SceneEntry& entry : scene_entries)
+        {
+            names.emplace_back(entry.name);
+        }
+    }
+    return names;
+}
@@ -0,0 +1,50 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ===========
+#include <functional>
+#include <string>
+#include <vector>
+#include "CameraPath.h"
+//======================
+
+namespace Spartan { class Context; }
+
+// Generated worlds for the runner, each one stresses a single part of the engine so that it can be measured in isolation:
+// instances (Pass_GBuffer), lights (Pass_LightDepth), rigid_bodies (Physics::Tick), scripts (World::Tick), terrain and transparency.
+// The random numbers come from a fixed seed, so a scene is the same from run to run (and from commit to commit).
+class Scenes
+{
+public:
+    struct Scene
+    {
+        CameraPath camera_path;
+        bool game = false;                  // physics and scripts only run in game mode
+        std::function<bool()> is_ready;     // some scenes finish generating after a few frames
+    };
+
+    // The count replaces the scene's default (the number of instances, lights, bodies or scripts), zero keeps it
+    static bool Create(const std::string& name, Spartan::Context* context, uint32_t count, uint32_t seed, Scene* scene);
+    static const std::vector<std::string>& GetNames();
+};
@@ -0,0 +1,350 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========================
+#include <iostream>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include "CameraPath.h"
+#include "Report.h"
+#include "Scenes.h"
+#include "Core/Context.h"
+#include "Core/Engine.h"
+#include "Logging/ILogger.h"
+#include "Profiling/Profiler.h"
+#include "Profiling/FrameCapture.h"
+#include "Rendering/Renderer.h"
+#include "RHI/RHI_CommandList.h"
+#include "RHI/RHI_SwapChain.h"
+#include "Threading/Threading.h"
+#include "World/World.h"
+#include "World/Components/Camera.h"
+#include "World/Components/Transform.h"
+//====================================
+
+//= NAMESPACES ===========
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//========================
+
+// Headless runner, it renders a world into a window which is never shown, along a camera path and for a fixed number of frames,
+// so that every run does the same work and the results of different commits can be compared.
+//
+// Usage: Runner (--world path | --scene name [--count count] [--seed seed] | --replay path) [--camera path] [--frames count] [--warm-up count]
+//               [--width pixels] [--height pixels] [--csv path] [--json path] [--baseline path] [--tolerance fraction] [--game]
+// The frames are written to runner.csv and a summary to runner.json by default. With a baseline (the json of an earlier run) the medians
+// of the frame, CPU and GPU times are compared and the exit code is 1 if any of them got slower than the tolerance allows (0.1 by default).
+// Without --game the world is simulated like in the editor (no scripts, no physics), which keeps the frames the same from run to run.
+// A scene is generated instead of loaded (see Scenes.h), it comes with its own camera path and decides whether it needs game mode.
+// A replay runs the frames of a frame capture (see FrameCapture.h) on the world it captured, with the delta times, input and camera
+// it captured, and in the mode it was captured in. The capture decides how many frames there are.
+
+namespace
+{
+    class ConsoleLogger : public ILogger
+    {
+    public:
+        void Log(const string& log, uint32_t type) override
+        {
+            // The frames are measured, so only what went wrong is printed
+            if (type != Log_Info)
+            {
+                cerr << log << endl;
+            }
+        }
+    };
+
+    HWND CreateHiddenWindow(const uint32_t width, const uint32_t height)
+    {
+        WNDCLASSEX window_class     = {};
+        window_class.cbSize         = sizeof(WNDCLASSEX);
+        window_class.lpfnWndProc    = DefWindowProc;
+        window_class.hInstance      = GetModuleHandle(nullptr);
+        window_class.lpszClassName  = L"SpartanRunner";
+        if (!RegisterClassEx(&window_class))
+            return nullptr;
+
+        // The client area is the resolution
+        RECT rect = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+        AdjustWindowRect(&rect, WS_OVERLAPPEDWINDOW, FALSE);
+
+        return CreateWindowEx(0, window_class.lpszClassName, L"Runner", WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, rect.right - rect.left, rect.bottom - rect.top, nullptr, nullptr, window_class.hInstance, nullptr);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string path_world;
+    string scene_name;
+    string path_camera;
+    string path_replay;
+    string path_csv         = "runner.csv";
+    string path_json        = "runner.json";
+    string path_baseline;
+    uint32_t frame_count    = 600;
+    uint32_t warm_up_count  = 120;
+    uint32_t width          = 1920;
+    uint32_t height         = 1080;
+    uint32_t scene_count    = 0;
+    uint32_t scene_seed     = 1;
+    double tolerance        = 0.1;
+    bool game               = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const string argument = argv[i];
+        if (argument == "--game")
+        {
+            game = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            cerr << "\"" << argument << "\" needs a value" << endl;
+            return 1;
+        }
+
+        const char* value = argv[++i];
+        if (argument == "--world")          path_world      = value;
+        else if (argument == "--scene")     scene_name      = value;
+        else if (argument == "--replay")    path_replay     = value;
+        else if (argument == "--count")     scene_count     = static_cast<uint32_t>(atoi(value));
+        else if (argument == "--seed")      scene_seed      = static_cast<uint32_t>(atoi(value));
+        else if (argument == "--camera")    path_camera     = value;
+        else if (argument == "--frames")    frame_count     = static_cast<uint32_t>(atoi(value));
+        else if (argument == "--warm-up")   warm_up_count   = static_cast<uint32_t>(atoi(value));
+        else if (argument == "--width")     width           = static_cast<uint32_t>(atoi(value));
+        else if (argument == "--height")    height          = static_cast<uint32_t>(atoi(value));
+        else if (argument == "--csv")       path_csv        = value;
+        else if (argument == "--json")      path_json       = value;
+        else if (argument == "--baseline")  path_baseline   = value;
+        else if (argument == "--tolerance") tolerance       = atof(value);
+        else
+        {
+            cerr << "Unknown argument \"" << argument << "\"" << endl;
+            return 1;
+        }
+    }
+
+    if ((path_world.empty() + scene_name.empty() + path_replay.empty()) != 2 || frame_count == 0 || width == 0 || height == 0)
+    {
+        cerr << "Usage: Runner (--world path | --scene name [--count count] [--seed seed] | --replay path) [--camera path] [--frames count] [--warm-up count] [--width pixels] [--height pixels] [--csv path] [--json path] [--baseline path] [--tolerance fraction] [--game]" << endl;
+        cerr << "Scenes:";
+        for (const string& name : Scenes::GetNames())
+        {
+            cerr << " " << name;
+        }
+        cerr << endl;
+        return 1;
+    }
+
+    CameraPath camera_path;
+    if (!path_camera.empty() && !camera_path.Load(path_camera))
+        return 1;
+
+    shared_ptr<ConsoleLogger> logger = make_shared<ConsoleLogger>();
+    Log::SetLogger(logger);
+    LOG_TO_FILE(false);
+
+    // The swapchain needs a window, it's created but never shown
+    HWND window = CreateHiddenWindow(width, height);
+    if (!window)
+    {
+        cerr << "Failed to create a window" << endl;
+        return 1;
+    }
+
+    WindowData window_data;
+    window_data.handle          = static_cast<void*>(window);
+    window_data.instance        = static_cast<void*>(GetModuleHandle(nullptr));
+    window_data.width           = static_cast<float>(width);
+    window_data.height          = static_cast<float>(height);
+    window_data.monitor_width   = GetSystemMetrics(SM_CXSCREEN);
+    window_data.monitor_height  = GetSystemMetrics(SM_CYSCREEN);
+
+    unique_ptr<Engine> engine = make_unique<Engine>(window_data);
+    Context* context    = engine->GetContext();
+    Renderer* renderer  = context->GetSubsystem<Renderer>();
+    Profiler* profiler  = context->GetSubsystem<Profiler>();
+    if (!renderer->IsInitialized())
+    {
+        cerr << "Failed to initialize the renderer" << endl;
+        return 1;
+    }
+
+    // Game mode starts once the world is there, so that the entities start along with it
+    engine->EngineMode_Disable(Engine_Game);
+
+    // A replay brings its world, and the mode it was captured in
+    FrameCapture* frame_capture = context->GetSubsystem<FrameCapture>();
+    if (!path_replay.empty())
+    {
+        if (!frame_capture->Load(path_replay) || frame_capture->GetFrames().empty())
+        {
+            cerr << "Failed to load the frame capture \"" << path_replay << "\"" << endl;
+            return 1;
+        }
+
+        path_world  = frame_capture->GetWorldFilePath();
+        frame_count = static_cast<uint32_t>(frame_capture->GetFrames().size());
+        game        = frame_capture->GetGameMode();
+    }
+
+    // Every frame is measured
+    profiler->SetUpdateInterval(0.0f);
+
+    auto tick = [&engine, renderer]()
+    {
+        MSG message;
+        while (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE))
+        {
+            TranslateMessage(&message);
+            DispatchMessage(&message);
+        }
+
+        renderer->GetSwapChain()->GetCmdList()->Begin();
+        engine->Tick();
+        renderer->Present();
+    };
+
+    // The world is loaded while the engine ticks, as that's where it waits for the renderer to let go of the entities
+    const string world_name = scene_name.empty() ? path_world : "scene_" + scene_name;
+    if (!scene_name.empty())
+    {
+        Scenes::Scene scene;
+        if (!Scenes::Create(scene_name, context, scene_count, scene_seed, &scene))
+            return 1;
+
+        if (camera_path.IsEmpty())
+        {
+            camera_path = scene.camera_path;
+        }
+        game = game || scene.game;
+
+        while (scene.is_ready && !scene.is_ready())
+        {
+            tick();
+        }
+    }
+    else
+    {
+        Threading* threading    = context->GetSubsystem<Threading>();
+        World* world            = context->GetSubsystem<World>();
+        bool loaded             = false;
+        shared_ptr<Task> task   = threading->AddTask([world, &path_world, &loaded]() { loaded = world->LoadFromFile(path_world); }, {}, Threading_Pool_Background);
+        while (!task->IsDone())
+        {
+            tick();
+        }
+
+        if (!loaded)
+        {
+            cerr << "Failed to load \"" << path_world << "\"" << endl;
+            return 1;
+        }
+    }
+
+    // A replay's world has to stay as it was captured until the replay starts, so it starts the game after the warm-up
+    if (game && path_replay.empty())
+    {
+        engine->EngineMode_Enable(Engine_Game);
+    }
+
+    // The renderer picks up the camera during the first frames after the load
+    auto get_camera = [renderer]() { return renderer->GetCamera() ? renderer->GetCamera()->GetTransform() : nullptr; };
+    auto set_camera = [&camera_path, &get_camera, frame_capture](const float fraction)
+    {
+        Transform* transform = get_camera();
+        if (!transform)
+            return;
+
+        // The replay moves the camera itself, the warm-up sees what its first frame will
+        if (!frame_capture->GetFrames().empty())
+        {
+            if (!frame_capture->IsReplaying())
+            {
+                transform->SetPosition(frame_capture->GetFrames().front().camera_position);
+                transform->SetRotation(frame_capture->GetFrames().front().camera_rotation);
+            }
+            return;
+        }
+
+        if (camera_path.IsEmpty())
+            return;
+
+        const CameraPath::Key key = camera_path.Evaluate(fraction);
+        transform->SetPosition(key.position);
+        transform->SetRotation(Quaternion::FromEulerAngles(key.pitch, key.yaw, 0.0f));
+    };
+
+    // Let the pipelines compile and the textures stream in
+    for (uint32_t i = 0; i < warm_up_count; i++)
+    {
+        set_camera(0.0f);
+        tick();
+    }
+
+    if (!get_camera())
+    {
+        cerr << "\"" << world_name << "\" has no camera" << endl;
+        return 1;
+    }
+
+    if (!path_replay.empty())
+    {
+        if (game)
+        {
+            engine->EngineMode_Enable(Engine_Game);
+        }
+        frame_capture->ReplayStart();
+    }
+
+    Report report(world_name, width, height);
+    for (uint32_t i = 0; i < frame_count; i++)
+    {
+        set_camera(frame_count > 1 ? static_cast<float>(i) / static_cast<float>(frame_count - 1) : 0.0f);
+        tick();
+
+        report.SetTimes(profiler);
+        report.AddFrame(profiler);
+    }
+
+    // One more frame, for the times of the last one
+    tick();
+    report.SetTimes(profiler);
+
+    if (!report.SaveCsv(path_csv) || !report.SaveJson(path_json))
+        return 1;
+
+    cout << "Build: " << Report::GetBuild() << ", " << frame_count << " frames of \"" << world_name << "\" written to " << path_csv << " and " << path_json << endl;
+
+    if (!path_baseline.empty())
+    {
+        cout << endl << "Compared to " << path_baseline << endl;
+        return report.Compare(path_baseline, tolerance) ? 0 : 1;
+    }
+
+    return 0;
+}
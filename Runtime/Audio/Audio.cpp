@@ -21,6 +21,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =============================
 #include "Audio.h"
+#include <algorithm>
 #include <fmod.hpp>
 #include <fmod_errors.h>
 #include <sstream>
@@ -28,6 +29,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Core/EventSystem.h"
 #include "../Core/Settings.h"
 #include "../Core/Context.h"
+#include "AudioClip.h"
+#include "SoundBank.h"
 #include "../Profiling/Profiler.h"
 #include "../World/Components/Transform.h"
 //========================================
@@ -49,6 +52,22 @@ namespace Spartan
 		// Unsubscribe from events
 		UNSUBSCRIBE_FROM_EVENT(Event_World_Unload, [this](Variant) { m_listener = nullptr; });
 
+		// Clips outlive the subsystem, so they must not reference it after this
+		for (const auto clip : m_spatial_clips)
+		{
+			clip->SkipSpatial();
+		}
+		m_spatial_clips.clear();
+		m_banks.clear();
+		{
+			lock_guard<mutex> lock(m_clips_mutex);
+			for (const auto clip : m_clips)
+			{
+				clip->Detach();
+			}
+			m_clips.clear();
+		}
+
 		if (!m_system_fmod)
 			return;
 
@@ -70,6 +89,15 @@ namespace Spartan
 
     bool Audio::Initialize()
     {
+        // Route FMOD's allocations to the pool, this has to happen before any other FMOD call
+        m_memory_pool = make_unique<std::byte[]>(m_memory_pool_size);
+        m_result_fmod = Memory_Initialize(m_memory_pool.get(), static_cast<int>(m_memory_pool_size), nullptr, nullptr, nullptr);
+        if (m_result_fmod != FMOD_OK)
+        {
+            LogErrorFmod(m_result_fmod);
+            return false;
+        }
+
         // Create FMOD instance
         m_result_fmod = System_Create(&m_system_fmod);
         if (m_result_fmod != FMOD_OK)
@@ -102,8 +130,35 @@ namespace Spartan
             return false;
         }
 
+        // Set the number of mixed voices, the rest of the voices (up to m_max_channels) are virtual
+        m_result_fmod = m_system_fmod->setSoftwareChannels(m_max_channels_real);
+        if (m_result_fmod != FMOD_OK)
+        {
+            LogErrorFmod(m_result_fmod);
+            return false;
+        }
+
+        // Set the volume under which voices go virtual
+        FMOD_ADVANCEDSETTINGS advanced_settings = {};
+        advanced_settings.cbSize            = sizeof(FMOD_ADVANCEDSETTINGS);
+        advanced_settings.vol0virtualvol    = m_virtual_volume;
+        m_result_fmod = m_system_fmod->setAdvancedSettings(&advanced_settings);
+        if (m_result_fmod != FMOD_OK)
+        {
+            LogErrorFmod(m_result_fmod);
+            return false;
+        }
+
         // Initialize FMOD
-        m_result_fmod = m_system_fmod->init(m_max_channels, FMOD_INIT_NORMAL, nullptr);
+        m_result_fmod = m_system_fmod->init(m_max_channels, FMOD_INIT_NORMAL | FMOD_INIT_VOL0_BECOMES_VIRTUAL, nullptr);
+        if (m_result_fmod != FMOD_OK)
+        {
+            LogErrorFmod(m_result_fmod);
+            return false;
+        }
+
+        // Set stream buffer size
+        m_result_fmod = m_system_fmod->setStreamBufferSize(m_stream_buffer_size, FMOD_TIMEUNIT_RAWBYTES);
         if (m_result_fmod != FMOD_OK)
         {
             LogErrorFmod(m_result_fmod);
@@ -148,6 +203,10 @@ namespace Spartan
 
         SCOPED_TIME_BLOCK(m_profiler);
 
+		// Submit the 3D attributes of the listener and of the clips which played during the last frame, FMOD applies them in update()
+		UpdateListener();
+		UpdateSpatial();
+
 		// Update FMOD
 		m_result_fmod = m_system_fmod->update();
 		if (m_result_fmod != FMOD_OK)
@@ -155,33 +214,162 @@ namespace Spartan
 			LogErrorFmod(m_result_fmod);
 			return;
 		}
+	}
+
+    void Audio::SetListenerTransform(Transform* transform)
+	{
+		m_listener = transform;
+	}
 
-		if (m_listener)
+	void Audio::SetStreamBufferSize(const uint32_t size)
+	{
+		m_stream_buffer_size = size;
+
+		if (!m_initialized)
+			return;
+
+		m_result_fmod = m_system_fmod->setStreamBufferSize(m_stream_buffer_size, FMOD_TIMEUNIT_RAWBYTES);
+		if (m_result_fmod != FMOD_OK)
 		{
-			auto position = m_listener->GetPosition();
-			auto velocity = Math::Vector3::Zero;
-			auto forward = m_listener->GetForward();
-			auto up = m_listener->GetUp();
-
-			// Set 3D attributes
-			m_result_fmod = m_system_fmod->set3DListenerAttributes(
-				0, 
-				reinterpret_cast<FMOD_VECTOR*>(&position), 
-				reinterpret_cast<FMOD_VECTOR*>(&velocity), 
-				reinterpret_cast<FMOD_VECTOR*>(&forward), 
-				reinterpret_cast<FMOD_VECTOR*>(&up)
-			);
-			if (m_result_fmod != FMOD_OK)
-			{
-				LogErrorFmod(m_result_fmod);
-				return;
-			}
+			LogErrorFmod(m_result_fmod);
 		}
 	}
 
-    void Audio::SetListenerTransform(Transform* transform)
+	shared_ptr<SoundBank> Audio::LoadBank(const string& name, const vector<string>& file_paths)
 	{
-		m_listener = transform;
+		if (auto bank = GetBank(name))
+			return bank;
+
+		auto bank = make_shared<SoundBank>(m_context, name);
+		if (!bank->Load(file_paths))
+		{
+			LOG_WARNING("Some of the clips of sound bank \"%s\" failed to load", name.c_str());
+		}
+
+		m_banks[name] = bank;
+		return bank;
+	}
+
+	void Audio::UnloadBank(const string& name)
+	{
+		m_banks.erase(name);
+	}
+
+	shared_ptr<SoundBank> Audio::GetBank(const string& name) const
+	{
+		const auto it = m_banks.find(name);
+		return it != m_banks.end() ? it->second : nullptr;
+	}
+
+	void Audio::RegisterClip(AudioClip* clip)
+	{
+		lock_guard<mutex> lock(m_clips_mutex);
+		m_clips.emplace(clip);
+	}
+
+	void Audio::UnregisterClip(AudioClip* clip)
+	{
+		lock_guard<mutex> lock(m_clips_mutex);
+		m_clips.erase(clip);
+	}
+
+	void Audio::RequestSpatialUpdate(AudioClip* clip)
+	{
+		m_spatial_clips.emplace_back(clip);
+	}
+
+	void Audio::CancelSpatialUpdate(AudioClip* clip)
+	{
+		m_spatial_clips.erase(remove(m_spatial_clips.begin(), m_spatial_clips.end(), clip), m_spatial_clips.end());
+	}
+
+	void Audio::UpdateListener()
+	{
+		if (!m_listener)
+			return;
+
+		auto position	= m_listener->GetPosition();
+		auto velocity	= Math::Vector3::Zero;
+		auto forward	= m_listener->GetForward();
+		auto up			= m_listener->GetUp();
+
+		// Skip if the listener didn't move
+		if (m_listener_submitted && position == m_listener_position && forward == m_listener_forward && up == m_listener_up)
+			return;
+
+		// Set 3D attributes
+		m_result_fmod = m_system_fmod->set3DListenerAttributes(
+			0, 
+			reinterpret_cast<FMOD_VECTOR*>(&position), 
+			reinterpret_cast<FMOD_VECTOR*>(&velocity), 
+			reinterpret_cast<FMOD_VECTOR*>(&forward), 
+			reinterpret_cast<FMOD_VECTOR*>(&up)
+		);
+		if (m_result_fmod != FMOD_OK)
+		{
+			LogErrorFmod(m_result_fmod);
+			return;
+		}
+
+		m_listener_position		= position;
+		m_listener_forward		= forward;
+		m_listener_up			= up;
+		m_listener_submitted	= true;
+	}
+
+	void Audio::UpdateSpatial()
+	{
+		if (m_spatial_clips.empty())
+			return;
+
+		const auto count			= static_cast<uint32_t>(m_spatial_clips.size());
+		const auto budget			= min(count, m_spatial_update_budget);
+		const auto listener_position	= m_listener ? m_listener->GetPosition() : Math::Vector3::Zero;
+
+		// Gather the positions and the audibility of the clips in one pass
+		m_spatial_positions.resize(count);
+		m_spatial_scores.resize(count);
+		m_spatial_order.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			m_spatial_positions[i]	= m_spatial_clips[i]->GetTransform()->GetPosition();
+			m_spatial_scores[i]		= m_spatial_clips[i]->GetAudibility(Math::Vector3::Distance(m_spatial_positions[i], listener_position));
+			m_spatial_order[i]		= i;
+		}
+
+		// Sort the most audible clips first
+		const auto by_score = [this](const uint32_t a, const uint32_t b) { return m_spatial_scores[a] > m_spatial_scores[b]; };
+		partial_sort(m_spatial_order.begin(), m_spatial_order.begin() + budget, m_spatial_order.end(), by_score);
+
+		// Of the rest, update the ones which have been waiting for the longest
+		auto extra = 0u;
+		if (budget < count)
+		{
+			for (uint32_t i = budget; i < count; i++)
+			{
+				m_spatial_scores[m_spatial_order[i]] = static_cast<float>(m_spatial_clips[m_spatial_order[i]]->GetSpatialFramesSkipped());
+			}
+
+			extra = min(count - budget, max(budget / 4, 1u));
+			partial_sort(m_spatial_order.begin() + budget, m_spatial_order.begin() + budget + extra, m_spatial_order.end(), by_score);
+		}
+
+		// Submit, the clips skip the ones which didn't move since their last submission
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const auto index = m_spatial_order[i];
+
+			if (i < budget + extra)
+			{
+				m_spatial_clips[index]->UpdateSpatial(m_spatial_positions[index]);
+			}
+			else
+			{
+				m_spatial_clips[index]->SkipSpatial();
+			}
+		}
+
+		m_spatial_clips.clear();
 	}
 
 	void Audio::LogErrorFmod(int error) const
@@ -22,7 +22,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==================
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <unordered_map>
 #include "../Core/ISubsystem.h"
+#include "../Math/Vector3.h"
 //=============================
 
 //= FORWARD DECLARATIONS =
@@ -36,6 +42,8 @@ namespace Spartan
 {
 	class Transform;
 	class Profiler;
+	class AudioClip;
+	class SoundBank;
 
 	class Audio : public ISubsystem
 	{
@@ -51,13 +59,64 @@ namespace Spartan
 		auto GetSystemFMOD() const { return m_system_fmod; }
 		void SetListenerTransform(Transform* transform);
 
+		// Clips whose file is at least this large are streamed from disk instead of being decoded into memory
+		auto GetStreamThreshold() const			{ return m_stream_threshold; }
+		void SetStreamThreshold(uint64_t size)	{ m_stream_threshold = size; }
+
+		// The size of the file buffer of each stream, it applies to streams which are opened after it's set
+		auto GetStreamBufferSize() const { return m_stream_buffer_size; }
+		void SetStreamBufferSize(uint32_t size);
+
+		// Sound banks, their clips stay loaded (and are shared with audio sources) until the bank is unloaded
+		std::shared_ptr<SoundBank> LoadBank(const std::string& name, const std::vector<std::string>& file_paths);
+		void UnloadBank(const std::string& name);
+		std::shared_ptr<SoundBank> GetBank(const std::string& name) const;
+
+		// Clips register themselves, so that they can release their sounds if the subsystem shuts down first
+		void RegisterClip(AudioClip* clip);
+		void UnregisterClip(AudioClip* clip);
+
+		// Playing clips ask for their 3D attributes to be updated, only the most audible ones (up to the budget) are updated
+		// every frame, the rest take turns so that they can become audible again (FMOD keeps them virtual meanwhile).
+		void RequestSpatialUpdate(AudioClip* clip);
+		void CancelSpatialUpdate(AudioClip* clip);
+		auto GetSpatialUpdateBudget() const				{ return m_spatial_update_budget; }
+		void SetSpatialUpdateBudget(uint32_t budget)	{ m_spatial_update_budget = budget; }
+
 	private:
+		void UpdateListener();
+		void UpdateSpatial();
 		void LogErrorFmod(int error) const;
 
 		uint32_t m_result_fmod		= 0;
-		uint32_t m_max_channels		= 32;
+		uint32_t m_max_channels		= 1024;	// virtual voices, they are tracked but not mixed
+		uint32_t m_max_channels_real	= 64;	// mixed voices, the least important (priority first, then audibility) of the playing voices go virtual
+		float m_virtual_volume		= 0.001f;	// voices which are quieter than this go virtual
+		uint32_t m_spatial_update_budget = 32;
+
+		// Spatial requests of the last frame, as parallel arrays
+		std::vector<AudioClip*> m_spatial_clips;
+		std::vector<Math::Vector3> m_spatial_positions;
+		std::vector<float> m_spatial_scores;
+		std::vector<uint32_t> m_spatial_order;
+
+		// The last submitted listener attributes
+		Math::Vector3 m_listener_position	= Math::Vector3::Zero;
+		Math::Vector3 m_listener_forward	= Math::Vector3::Zero;
+		Math::Vector3 m_listener_up			= Math::Vector3::Zero;
+		bool m_listener_submitted			= false;
 		float m_distance_entity		= 1.0f;
+		uint64_t m_stream_threshold	= 1024 * 1024;
+		uint32_t m_stream_buffer_size	= 64 * 1024;
 		bool m_initialized			= false;
+
+		// All of FMOD's memory comes from this pool, so loading and playing sounds doesn't touch the global allocator
+		uint32_t m_memory_pool_size	= 64 * 1024 * 1024; // a multiple of 512
+		std::unique_ptr<std::byte[]> m_memory_pool;
+
+		std::unordered_map<std::string, std::shared_ptr<SoundBank>> m_banks;
+		std::unordered_set<AudioClip*> m_clips;
+		std::mutex m_clips_mutex;
 		Transform* m_listener		= nullptr;
 		Profiler* m_profiler		= nullptr;
 		FMOD::System* m_system_fmod = nullptr;
@@ -21,6 +21,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =============================
 #include "AudioClip.h"
+#include <filesystem>
 #include <fmod.hpp>
 #include <fmod_errors.h>
 #include "Audio.h"
@@ -40,7 +41,8 @@ namespace Spartan
 	{
 		// AudioClip
 		m_transform		= nullptr;
-		m_systemFMOD	= static_cast<System*>(context->GetSubsystem<Audio>()->GetSystemFMOD());
+		m_audio			= context->GetSubsystem<Audio>();
+		m_systemFMOD	= static_cast<System*>(m_audio->GetSystemFMOD());
 		m_result		= FMOD_OK;
 		m_soundFMOD		= nullptr;
 		m_channelFMOD	= nullptr;
@@ -49,10 +51,43 @@ namespace Spartan
 		m_maxDistance	= 10000.0f;
 		m_modeRolloff	= FMOD_3D_LINEARROLLOFF;
 		m_modeLoop		= FMOD_LOOP_OFF;
+		m_ready			= false;
+		m_streamable	= true;
+		m_playPending	= false;
+		m_spatialRequested		= false;
+		m_spatialFramesSkipped	= 0;
+		m_spatialPosition		= Vector3::Zero;
+		m_spatialSubmitted		= false;
+		m_volume		= 1.0f;
+		m_mute			= false;
+		m_priority		= 128;
+		m_pitch			= 1.0f;
+		m_pan			= 0.0f;
+
+		m_audio->RegisterClip(this);
 	}
 
 	AudioClip::~AudioClip()
 	{
+		if (!m_audio)
+			return;
+
+		if (m_spatialRequested)
+		{
+			m_audio->CancelSpatialUpdate(this);
+		}
+		m_audio->UnregisterClip(this);
+
+		Detach();
+	}
+
+	void AudioClip::Detach()
+	{
+		m_audio			= nullptr;
+		m_channelFMOD	= nullptr;
+		m_ready			= false;
+		m_playPending	= false;
+
 		if (!m_soundFMOD)
 			return;
 
@@ -61,12 +96,18 @@ namespace Spartan
 		{
 			LogErrorFmod(m_result);
 		}
+		m_soundFMOD = nullptr;
 	}
 
 	bool AudioClip::LoadFromFile(const string& file_path)
 	{
+		if (!m_audio)
+			return false;
+
 		m_soundFMOD     = nullptr;
 		m_channelFMOD   = nullptr;
+		m_ready         = false;
+		m_playPending   = false;
 
         // Native
         if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_AUDIO)
@@ -85,6 +126,11 @@ namespace Spartan
             SetResourceFilePath(file_path);
         }
 
+        // Stream large clips, decoding them into memory would stall and keep the whole clip around
+        error_code error;
+        const auto file_size = filesystem::file_size(GetResourceFilePath(), error);
+        m_playMode = (m_streamable && !error && file_size >= m_audio->GetStreamThreshold()) ? Play_Stream : Play_Memory;
+
 		return (m_playMode == Play_Memory) ? CreateSound(GetResourceFilePath()) : CreateStream(GetResourceFilePath());
 	}
 
@@ -103,6 +149,13 @@ namespace Spartan
 
     bool AudioClip::Play()
 	{
+		// If the sound is still opening, start playing once it's ready (see Update())
+		if (!IsReady())
+		{
+			m_playPending = m_soundFMOD != nullptr;
+			return m_playPending;
+		}
+
 		// Check if the sound is playing
 		if (IsChannelValid())
 		{
@@ -120,7 +173,18 @@ namespace Spartan
 		}
 
 		// Start playing the sound
-		m_result = m_systemFMOD->playSound(m_soundFMOD, nullptr, false, &m_channelFMOD);
+		m_result = m_systemFMOD->playSound(m_soundFMOD, nullptr, true, &m_channelFMOD);
+		m_spatialSubmitted = false;
+		if (m_result != FMOD_OK)
+		{
+			LogErrorFmod(m_result);
+			return false;
+		}
+
+		// Apply the settings before un-pausing, so that the start of the sound doesn't play without them
+		ApplyChannelSettings();
+
+		m_result = m_channelFMOD->setPaused(false);
 		if (m_result != FMOD_OK)
 		{
 			LogErrorFmod(m_result);
@@ -161,6 +225,8 @@ namespace Spartan
 
 	bool AudioClip::Stop()
 	{
+		m_playPending = false;
+
 		if (!IsChannelValid())
 			return true;
 
@@ -189,6 +255,10 @@ namespace Spartan
 		if (!m_soundFMOD)
 			return false;
 
+		// Applied once the sound is ready
+		if (!IsReady())
+			return true;
+
 		// Infinite loops
 		if (loop)
 		{
@@ -208,6 +278,8 @@ namespace Spartan
 
 	bool AudioClip::SetVolume(float volume)
 	{
+		m_volume = volume;
+
 		if (!IsChannelValid())
 			return false;
 
@@ -223,6 +295,8 @@ namespace Spartan
 
 	bool AudioClip::SetMute(const bool mute)
 	{
+		m_mute = mute;
+
 		if (!IsChannelValid())
 			return false;
 
@@ -238,6 +312,8 @@ namespace Spartan
 
 	bool AudioClip::SetPriority(const int priority)
 	{
+		m_priority = priority;
+
 		if (!IsChannelValid())
 			return false;
 
@@ -253,6 +329,8 @@ namespace Spartan
 
 	bool AudioClip::SetPitch(const float pitch)
 	{
+		m_pitch = pitch;
+
 		if (!IsChannelValid())
 			return false;
 
@@ -268,6 +346,8 @@ namespace Spartan
 
 	bool AudioClip::SetPan(const float pan)
 	{
+		m_pan = pan;
+
 		if (!IsChannelValid())
 			return false;
 
@@ -324,23 +404,70 @@ namespace Spartan
 
 	bool AudioClip::Update()
 	{
+		// Start a playback which was waiting for the sound to open
+		if (m_playPending && IsReady())
+		{
+			m_playPending = false;
+			Play();
+		}
+
 		if (!IsChannelValid() || !m_transform)
 			return true;
 
-		const auto pos = m_transform->GetPosition();
+		// The audio subsystem decides if the 3D attributes are updated this frame
+		if (!m_spatialRequested)
+		{
+			m_spatialRequested = true;
+			m_audio->RequestSpatialUpdate(this);
+		}
+
+		return true;
+	}
+
+	float AudioClip::GetAudibility(const float distance) const
+	{
+		if (m_mute)
+			return 0.0f;
+
+		// Linear rolloff between the min and max distance (custom curves are approximated by it)
+		const auto attenuation	= Helper::Clamp(1.0f - (distance - m_minDistance) / (m_maxDistance - m_minDistance), 0.0f, 1.0f);
+
+		return m_volume * attenuation;
+	}
+
+	void AudioClip::SkipSpatial()
+	{
+		m_spatialRequested = false;
+		m_spatialFramesSkipped++;
+	}
+
+	bool AudioClip::UpdateSpatial(const Vector3& position)
+	{
+		m_spatialRequested		= false;
+		m_spatialFramesSkipped	= 0;
 
-		FMOD_VECTOR f_mod_pos = { pos.x, pos.y, pos.z };
+		// Skip if FMOD already has this position
+		if (!m_channelFMOD || (m_spatialSubmitted && position == m_spatialPosition))
+			return true;
+
+		FMOD_VECTOR f_mod_pos = { position.x, position.y, position.z };
 		FMOD_VECTOR f_mod_vel = { 0, 0, 0 };
 
-		// Set 3D attributes
+		// Set 3D attributes, a channel which stopped or was stolen is released (Update() already checked it's valid this frame)
 		m_result = m_channelFMOD->set3DAttributes(&f_mod_pos, &f_mod_vel);
 		if (m_result != FMOD_OK)
 		{
 			m_channelFMOD = nullptr;
-			LogErrorFmod(m_result);
+			if (m_result != FMOD_ERR_INVALID_HANDLE && m_result != FMOD_ERR_CHANNEL_STOLEN)
+			{
+				LogErrorFmod(m_result);
+			}
 			return false;
 		}
 
+		m_spatialPosition	= position;
+		m_spatialSubmitted	= true;
+
 		return true;
 	}
 
@@ -364,15 +491,20 @@ namespace Spartan
 	bool AudioClip::CreateSound(const string& file_path)
 	{
 		// Create sound
-		m_result = m_systemFMOD->createSound(file_path.c_str(), GetSoundMode(), nullptr, &m_soundFMOD);
+		m_result = m_systemFMOD->createSound(file_path.c_str(), GetSoundMode() | FMOD_NONBLOCKING, nullptr, &m_soundFMOD);
 		if (m_result != FMOD_OK)
 		{
 			LogErrorFmod(m_result);
 			return false;
 		}
 
-		// Set 3D min max distance
-		m_result = m_soundFMOD->set3DMinMaxDistance(m_minDistance, m_maxDistance);
+		return true;
+	}
+
+	bool AudioClip::CreateStream(const string& file_path)
+	{
+		// Create sound
+		m_result = m_systemFMOD->createStream(file_path.c_str(), GetSoundMode() | FMOD_NONBLOCKING, nullptr, &m_soundFMOD);
 		if (m_result != FMOD_OK)
 		{
 			LogErrorFmod(m_result);
@@ -382,27 +514,65 @@ namespace Spartan
 		return true;
 	}
 
-	bool AudioClip::CreateStream(const string& file_path)
+	bool AudioClip::IsReady()
 	{
-		// Create sound
-		m_result = m_systemFMOD->createStream(file_path.c_str(), GetSoundMode(), nullptr, &m_soundFMOD);
+		if (m_ready)
+			return true;
+
+		if (!m_soundFMOD)
+			return false;
+
+		// Check if the sound has finished opening
+		FMOD_OPENSTATE state = FMOD_OPENSTATE_LOADING;
+		m_result = m_soundFMOD->getOpenState(&state, nullptr, nullptr, nullptr);
 		if (m_result != FMOD_OK)
 		{
+			// Also the case when the file failed to open
 			LogErrorFmod(m_result);
+			m_soundFMOD->release();
+			m_soundFMOD		= nullptr;
+			m_playPending	= false;
 			return false;
 		}
 
+		if (state != FMOD_OPENSTATE_READY)
+			return false;
+
+		m_ready = true;
+
 		// Set 3D min max distance
 		m_result = m_soundFMOD->set3DMinMaxDistance(m_minDistance, m_maxDistance);
 		if (m_result != FMOD_OK)
 		{
 			LogErrorFmod(m_result);
-			return false;
 		}
 
+		// Set the loop mode which was requested while opening
+		SetLoop(m_modeLoop == FMOD_LOOP_NORMAL);
+
 		return true;
 	}
 
+	bool AudioClip::ApplyChannelSettings()
+	{
+		if (!IsChannelValid())
+			return false;
+
+		const auto result =
+			m_channelFMOD->setVolume(m_volume)		== FMOD_OK &&
+			m_channelFMOD->setMute(m_mute)			== FMOD_OK &&
+			m_channelFMOD->setPriority(m_priority)	== FMOD_OK &&
+			m_channelFMOD->setPitch(m_pitch)		== FMOD_OK &&
+			m_channelFMOD->setPan(m_pan)			== FMOD_OK;
+
+		if (!result)
+		{
+			LOG_ERROR("Failed to apply channel settings");
+		}
+
+		return result;
+	}
+
 	int AudioClip::GetSoundMode() const
 	{
 		return FMOD_3D | m_modeLoop | m_modeRolloff;
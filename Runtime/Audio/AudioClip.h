@@ -38,6 +38,7 @@ namespace FMOD
 namespace Spartan
 {
 	class Transform;
+	class Audio;
 
 	enum PlayMode
 	{
@@ -89,23 +90,44 @@ namespace Spartan
 		bool SetRolloff(Rolloff rolloff);
 
 		// Makes the audio use the 3D attributes of the transform
-		void SetTransform(Transform* transform) { m_transform = transform; }
+		void SetTransform(Transform* transform)	{ m_transform = transform; }
+		auto GetTransform() const				{ return m_transform; }
 
 		// Should be called per frame to update the 3D attributes of the sound
 		bool Update();
 
+		// Spatial updates are budgeted by the audio subsystem (see Audio::RequestSpatialUpdate())
+		float GetAudibility(float distance) const;
+		bool UpdateSpatial(const Math::Vector3& position);
+		void SkipSpatial();
+		auto GetSpatialFramesSkipped() const { return m_spatialFramesSkipped; }
+
 		bool IsPlaying();
 
+		// Large clips are streamed (see Audio::GetStreamThreshold()), unless streaming is disabled before loading
+		auto GetPlayMode() const				{ return m_playMode; }
+		void SetStreamable(bool streamable)	{ m_streamable = streamable; }
+
+		// True once the sound has opened and can play
+		bool IsLoaded() { return IsReady(); }
+
+		// Releases the sound, called by the audio subsystem when it shuts down before the clip is destroyed
+		void Detach();
+
 	private:
 		//= CREATION ===================================
 		bool CreateSound(const std::string& file_path);
 		bool CreateStream(const std::string& file_path);
 		//==============================================
+		// Sounds are opened asynchronously, this applies the deferred sound settings once they are ready
+		bool IsReady();
+		bool ApplyChannelSettings();
 		int GetSoundMode() const;
 		void LogErrorFmod(int error) const;
 		bool IsChannelValid() const;
 
 		Transform* m_transform;
+		Audio* m_audio;
 		FMOD::System* m_systemFMOD;
 		FMOD::Sound* m_soundFMOD;
 		FMOD::Channel* m_channelFMOD;	
@@ -115,5 +137,19 @@ namespace Spartan
 		float m_maxDistance;
 		int m_modeRolloff;
 		int m_result;
+		bool m_ready;
+		bool m_streamable;
+		bool m_playPending;
+		bool m_spatialRequested;
+		uint32_t m_spatialFramesSkipped;
+		Math::Vector3 m_spatialPosition;	// the last submitted position
+		bool m_spatialSubmitted;			// false until the channel has a position
+
+		// Channel settings, kept so that they apply to playbacks which start after they are set
+		float m_volume;
+		bool m_mute;
+		int m_priority;
+		float m_pitch;
+		float m_pan;
 	};
 }
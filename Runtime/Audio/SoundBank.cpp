@@ -0,0 +1,107 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========================
+#include "SoundBank.h"
+#include "AudioClip.h"
+#include "../Resource/ResourceCache.h"
+//====================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+	SoundBank::SoundBank(Context* context, const string& name)
+	{
+		m_context	= context;
+		m_name		= name;
+	}
+
+	SoundBank::~SoundBank()
+	{
+		Unload();
+	}
+
+	bool SoundBank::Load(const vector<string>& file_paths)
+	{
+		auto resource_cache	= m_context->GetSubsystem<ResourceCache>();
+		auto result			= true;
+
+		m_clips.reserve(m_clips.size() + file_paths.size());
+		for (const auto& file_path : file_paths)
+		{
+			// Share the clip if it's already loaded
+			const auto name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
+			if (resource_cache->IsCached(name, Resource_Audio))
+			{
+				m_clips.emplace_back(resource_cache->GetByName<AudioClip>(name));
+				continue;
+			}
+
+			auto clip = make_shared<AudioClip>(m_context);
+			clip->SetStreamable(false);
+			if (!clip->LoadFromFile(file_path))
+			{
+				LOG_ERROR("Failed to load \"%s\" into sound bank \"%s\"", file_path.c_str(), m_name.c_str());
+				result = false;
+				continue;
+			}
+
+			// Cache it, so that audio sources which use the same clip find it
+			if (auto cached = resource_cache->Cache(clip))
+			{
+				m_clips.emplace_back(cached);
+			}
+		}
+
+		return result;
+	}
+
+	void SoundBank::Unload()
+	{
+		m_clips.clear();
+	}
+
+	bool SoundBank::IsLoaded() const
+	{
+		for (const auto& clip : m_clips)
+		{
+			if (!clip->IsLoaded())
+				return false;
+		}
+
+		return true;
+	}
+
+	shared_ptr<AudioClip> SoundBank::GetClip(const string& name) const
+	{
+		for (const auto& clip : m_clips)
+		{
+			if (clip->GetResourceName() == name)
+				return clip;
+		}
+
+		return nullptr;
+	}
+}
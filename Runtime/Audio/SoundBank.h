@@ -0,0 +1,61 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==================
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Core/EngineDefs.h"
+//=============================
+
+namespace Spartan
+{
+	class Context;
+	class AudioClip;
+
+	// A group of clips which are loaded up front (into FMOD's memory pool, see Audio) and stay loaded until the bank is unloaded.
+	// The clips of a bank are never streamed, so triggering them doesn't touch the disk.
+	class SPARTAN_CLASS SoundBank
+	{
+	public:
+		SoundBank(Context* context, const std::string& name);
+		~SoundBank();
+
+		// The clips open in the background, clips which are already loaded are shared
+		bool Load(const std::vector<std::string>& file_paths);
+		void Unload();
+
+		// True once every clip is ready to play
+		bool IsLoaded() const;
+
+		std::shared_ptr<AudioClip> GetClip(const std::string& name) const;
+		const auto& GetClips() const	{ return m_clips; }
+		const auto& GetName() const		{ return m_name; }
+
+	private:
+		Context* m_context = nullptr;
+		std::string m_name;
+		std::vector<std::shared_ptr<AudioClip>> m_clips;
+	};
+}
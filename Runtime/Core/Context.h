@@ -22,9 +22,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==============
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include "EngineDefs.h"
 #include "ISubsystem.h"
 #include "../Logging/Log.h"
+#include "../Profiling/MemoryTracker.h"
 //=========================
 
 namespace Spartan
@@ -37,16 +42,45 @@ namespace Spartan
         Tick_Smoothed
     };
 
+    // How a subsystem steps when the timer's fixed step is enabled (otherwise they all tick once per frame)
+    enum Step_Mode
+    {
+        Step_Frame, // once per frame, with the delta time of its tick group
+        Step_Fixed  // zero or more times per frame, with the fixed step, between the variable and the smoothed tick groups
+    };
+
+    // When and where a subsystem initializes
+    enum Initialize_Mode
+    {
+        Initialize_Serial,  // on the calling thread, after the serial subsystems which were registered before it
+        Initialize_Parallel // on a thread of its own, as soon as its dependencies have initialized
+    };
+
+    enum Initialize_State
+    {
+        Initialize_Pending,
+        Initialize_Running,
+        Initialize_Done
+    };
+
     struct _subystem
     {
-        _subystem(const std::shared_ptr<ISubsystem>& subsystem, Tick_Group tick_group)
+        _subystem(const std::shared_ptr<ISubsystem>& subsystem, Tick_Group tick_group, Memory_Tag memory_tag, Initialize_Mode initialize_mode, Step_Mode step_mode)
         {
             ptr = subsystem;
             this->tick_group = tick_group;
+            this->memory_tag = memory_tag;
+            this->initialize_mode = initialize_mode;
+            this->step_mode = step_mode;
         }
 
         std::shared_ptr<ISubsystem> ptr;
         Tick_Group tick_group;
+        Memory_Tag memory_tag;
+        Initialize_Mode initialize_mode;
+        Step_Mode step_mode;
+        std::vector<size_t> dependencies; // indices of subsystems which were registered before
+        Initialize_State initialize_state = Initialize_Pending;
     };
 
 	class SPARTAN_CLASS Context
@@ -65,43 +99,114 @@ namespace Spartan
             m_subsystems.clear();
         }
 
-		// Register a subsystem
-		template <class T>
-		void RegisterSubsystem(Tick_Group tick_group = Tick_Variable)
+		// Register a subsystem, what it allocates while it's constructed, initialized and ticked is attributed to the memory tag.
+		// A subsystem which initializes in parallel waits for the Dependencies, which have to be registered before it.
+		template <class T, class... Dependencies>
+		void RegisterSubsystem(Tick_Group tick_group = Tick_Variable, Memory_Tag memory_tag = Memory_Tag_Other, Initialize_Mode initialize_mode = Initialize_Serial, Step_Mode step_mode = Step_Frame)
 		{
             validate_subsystem_type<T>();
 
-            m_subsystems.emplace_back(std::make_shared<T>(this), tick_group);
+            MemoryTagScope memory_tag_scope(memory_tag);
+            _subystem& subsystem = m_subsystems.emplace_back(std::make_shared<T>(this), tick_group, memory_tag, initialize_mode, step_mode);
+            (subsystem.dependencies.emplace_back(GetSubsystemIndex<Dependencies>()), ...);
 		}
 
-		// Initialize subsystems
+		// Initialize subsystems, those which initialize in parallel start on a thread of their own as soon as their dependencies are done
 		bool Initialize()
 		{
-			auto result = true;
-            for (const auto& subsystem : m_subsystems)
+            std::atomic<bool> result = true;
+            auto initialize = [&result](_subystem& subsystem)
             {
+                MemoryTagScope memory_tag(subsystem.memory_tag);
                 if (!subsystem.ptr->Initialize())
                 {
-                	LOG_ERROR("Failed to initialize %s", typeid(*subsystem.ptr).name());
-                	result = false;
+                    LOG_ERROR("Failed to initialize %s", typeid(*subsystem.ptr).name());
+                    result = false;
+                }
+            };
+
+            std::mutex mutex;
+            std::condition_variable condition;
+            std::vector<std::thread> threads;
+            std::unique_lock<std::mutex> lock(mutex);
+            size_t initialized_count = 0;
+            while (initialized_count < m_subsystems.size())
+            {
+                bool started = false;
+                for (size_t i = 0; i < m_subsystems.size() && !started; i++)
+                {
+                    _subystem& subsystem = m_subsystems[i];
+                    if (subsystem.initialize_state != Initialize_Pending || !IsReadyToInitialize(i))
+                        continue;
+
+                    subsystem.initialize_state = Initialize_Running;
+                    started = true;
+
+                    if (subsystem.initialize_mode == Initialize_Parallel)
+                    {
+                        threads.emplace_back([&, i]()
+                        {
+                            initialize(m_subsystems[i]);
+
+                            std::lock_guard<std::mutex> guard(mutex);
+                            m_subsystems[i].initialize_state = Initialize_Done;
+                            initialized_count++;
+                            condition.notify_one();
+                        });
+                    }
+                    else
+                    {
+                        lock.unlock();
+                        initialize(subsystem);
+                        lock.lock();
+
+                        subsystem.initialize_state = Initialize_Done;
+                        initialized_count++;
+                    }
                 }
+
+                // Nothing can start until one of the running subsystems is done
+                if (!started)
+                {
+                    condition.wait(lock);
+                }
+            }
+            lock.unlock();
+
+            for (std::thread& thread : threads)
+            {
+                thread.join();
             }
 
 			return result;
 		}
 
-        // Tick
-		void Tick(Tick_Group tick_group, float delta_time = 0.0f)
+        // Tick, a subsystem which the caller ticks by itself can be skipped, as can those which step with the fixed step
+		void Tick(Tick_Group tick_group, float delta_time = 0.0f, const ISubsystem* skip = nullptr, bool skip_fixed_step = false)
 		{
             for (const auto& subsystem : m_subsystems)
             {
-                if (subsystem.tick_group != tick_group)
+                if (subsystem.tick_group != tick_group || subsystem.ptr.get() == skip || (skip_fixed_step && subsystem.step_mode == Step_Fixed))
                     continue;
 
+                MemoryTagScope memory_tag(subsystem.memory_tag);
                 subsystem.ptr->Tick(delta_time);
             }
 		}
 
+        // Takes a single fixed step, the subsystems which step with it tick in registration order
+        void TickFixedStep(float step)
+        {
+            for (const auto& subsystem : m_subsystems)
+            {
+                if (subsystem.step_mode != Step_Fixed)
+                    continue;
+
+                MemoryTagScope memory_tag(subsystem.memory_tag);
+                subsystem.ptr->Tick(step);
+            }
+        }
+
 		// Get a subsystem
 		template <class T> 
         T* GetSubsystem() const
@@ -110,7 +215,8 @@ namespace Spartan
 
 			for (const auto& subsystem : m_subsystems)
 			{
-                if (typeid(T) == typeid(*subsystem.ptr))
+                // Subsystems are released one by one on shutdown, the released ones can't be returned
+                if (subsystem.ptr && typeid(T) == typeid(*subsystem.ptr))
                     return static_cast<T*>(subsystem.ptr.get());
 			}
 
@@ -120,6 +226,44 @@ namespace Spartan
         Engine* m_engine = nullptr;
 
 	private:
+        template <class T>
+        size_t GetSubsystemIndex() const
+        {
+            for (size_t i = 0; i < m_subsystems.size(); i++)
+            {
+                if (typeid(T) == typeid(*m_subsystems[i].ptr))
+                    return i;
+            }
+
+            LOG_ERROR("%s has to be registered before the subsystems which depend on it", typeid(T).name());
+            return 0;
+        }
+
+        bool IsReadyToInitialize(const size_t index) const
+        {
+            const _subystem& subsystem = m_subsystems[index];
+
+            // Parallel subsystems are only waited for by those which depend on them (and by Initialize() before it returns)
+            if (subsystem.initialize_mode == Initialize_Serial)
+            {
+                for (size_t i = 0; i < index; i++)
+                {
+                    if (m_subsystems[i].initialize_mode == Initialize_Serial && m_subsystems[i].initialize_state != Initialize_Done)
+                        return false;
+                }
+
+                return true;
+            }
+
+            for (const size_t dependency : subsystem.dependencies)
+            {
+                if (m_subsystems[dependency].initialize_state != Initialize_Done)
+                    return false;
+            }
+
+            return true;
+        }
+
 		std::vector<_subystem> m_subsystems;
 	};
 }
@@ -22,12 +22,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =========================
 #include "Engine.h"
 #include "Timer.h"
+#include "FrameArena.h"
 #include "EventSystem.h"
 #include "Settings.h"
 #include "../Audio/Audio.h"
 #include "../Input/Input.h"
+#include "../IO/FileIO.h"
+#include "../Logging/Log.h"
 #include "../Physics/Physics.h"
 #include "../Profiling/Profiler.h"
+#include "../Profiling/FrameCapture.h"
 #include "../Rendering/Renderer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scripting/Scripting.h"
@@ -58,33 +62,93 @@ namespace Spartan
 		// Register subsystems
         m_context->RegisterSubsystem<Timer>(Tick_Variable);         // must be first so it ticks first
         m_context->RegisterSubsystem<Threading>(Tick_Variable);
-		m_context->RegisterSubsystem<ResourceCache>(Tick_Variable);		
-		m_context->RegisterSubsystem<Audio>(Tick_Variable);
-        m_context->RegisterSubsystem<Physics>(Tick_Variable);       // integrates internally
-        m_context->RegisterSubsystem<Input>(Tick_Smoothed);
-		m_context->RegisterSubsystem<Scripting>(Tick_Smoothed);
-		m_context->RegisterSubsystem<World>(Tick_Smoothed);
+        m_context->RegisterSubsystem<FileIO>(Tick_Variable);       // before the resource cache, which reads through it
+		m_context->RegisterSubsystem<ResourceCache>(Tick_Variable, Memory_Tag_Resources);
+		m_context->RegisterSubsystem<Audio>(Tick_Variable, Memory_Tag_Audio, Initialize_Parallel);
+        m_context->RegisterSubsystem<Physics>(Tick_Variable, Memory_Tag_Physics, Initialize_Parallel, Step_Fixed); // integrates internally, unless it steps with the fixed step
+        m_context->RegisterSubsystem<Input>(Tick_Variable);                                                         // polls before the fixed steps
+		m_context->RegisterSubsystem<Scripting>(Tick_Smoothed, Memory_Tag_Scripting, Initialize_Parallel);
+		m_context->RegisterSubsystem<World>(Tick_Smoothed, Memory_Tag_World, Initialize_Serial, Step_Fixed);       // scripts run as part of it
         m_context->RegisterSubsystem<Profiler>(Tick_Variable);
-        m_context->RegisterSubsystem<Renderer>(Tick_Smoothed);
+        m_context->RegisterSubsystem<Renderer>(Tick_Smoothed, Memory_Tag_Renderer);
         m_context->RegisterSubsystem<Settings>(Tick_Variable);
+        m_context->RegisterSubsystem<FrameCapture>(Tick_Variable);                                                  // records and replays when a frame ends
              	
 		// Initialize above subsystems
 		m_context->Initialize();
 
-        m_timer = m_context->GetSubsystem<Timer>();
+        m_timer     = m_context->GetSubsystem<Timer>();
+        m_threading = m_context->GetSubsystem<Threading>();
+        m_renderer  = m_context->GetSubsystem<Renderer>();
+        m_profiler  = m_context->GetSubsystem<Profiler>();
+
+        // Transient allocations of the frame before the one which ends are released
+        SUBSCRIBE_TO_EVENT(Event_Frame_End, EVENT_HANDLER_STATIC(FrameArena::OnFrameEnd));
 	}
 
 	Engine::~Engine()
 	{
 		EventSystem::Get().Clear(); // this must become a subsystem
+
+        // Subsystems log while they shut down, so they go first and then whatever is still queued gets logged
+        m_context = nullptr;
+        Log::Flush();
 	}
 
 	void Engine::Tick() const
     {
-        m_context->Tick(Tick_Variable, static_cast<float>(m_timer->GetDeltaTimeSec()));
-        m_context->Tick(Tick_Smoothed, static_cast<float>(m_timer->GetDeltaTimeSmoothedSec()));
+        const float delta_time          = static_cast<float>(m_timer->GetDeltaTimeSec());
+        const float delta_time_smoothed = static_cast<float>(m_timer->GetDeltaTimeSmoothedSec());
+        const bool fixed_step           = m_timer->IsFixedStepEnabled();
+
+        // Queued events fire here, before anything ticks (and while the renderer isn't recording)
+        EventSystem::Get().Flush();
+
+        if (!EngineMode_IsSet(Engine_Pipelined))
+        {
+            m_context->Tick(Tick_Variable, delta_time, nullptr, fixed_step);
+            TickFixedSteps();
+            m_context->Tick(Tick_Smoothed, delta_time_smoothed, nullptr, fixed_step);
+            FIRE_EVENT(Event_Frame_End);
+            return;
+        }
+
+        // Pipelined: The renderer records what the previous simulation step produced, while the next step is being simulated.
+        // This is the only point where neither of them is running, so the profiler ends its frame and the renderer takes its snapshot here.
+        m_profiler->Tick(delta_time);
+        {
+            MemoryTagScope memory_tag(Memory_Tag_Renderer);
+            m_renderer->Snapshot();
+        }
+        shared_ptr<Task> task_render = m_threading->AddTask([this, delta_time_smoothed]()
+        {
+            MemoryTagScope memory_tag(Memory_Tag_Renderer);
+            m_renderer->Tick(delta_time_smoothed);
+        });
+
+        m_context->Tick(Tick_Variable, delta_time, m_profiler, fixed_step);
+        TickFixedSteps();
+        m_context->Tick(Tick_Smoothed, delta_time_smoothed, m_renderer, fixed_step);
+
+        // The frame has to be fully recorded before the caller can present it
+        m_threading->Wait(task_render);
+        FIRE_EVENT(Event_Frame_End);
 	}
 
+    void Engine::TickFixedSteps() const
+    {
+        // The timer ticked first, so it already knows how many steps fit in this frame
+        if (!m_timer->IsFixedStepEnabled())
+            return;
+
+        const float step = m_timer->GetFixedStepSec();
+        for (uint32_t i = 0; i < m_timer->GetFixedStepCount(); i++)
+        {
+            m_timer->OnFixedStep();
+            m_context->TickFixedStep(step);
+        }
+    }
+
     void Engine::SetWindowData(WindowData& window_data)
     {
         m_window_data = window_data;
@@ -30,6 +30,9 @@ namespace Spartan
 {
 	class Context;
     class Timer;
+    class Threading;
+    class Renderer;
+    class Profiler;
 
     struct WindowData
     {
@@ -53,6 +56,7 @@ namespace Spartan
 	{
 		Engine_Physics	= 1UL << 0, // Should the physics tick?	
 		Engine_Game		= 1UL << 1,	// Is the engine running in game or editor mode?
+		Engine_Pipelined = 1UL << 2, // Should the renderer record the previous frame while the next one is simulated?
 	};
 
 	class SPARTAN_CLASS Engine
@@ -79,9 +83,15 @@ namespace Spartan
         auto GetContext() const { return m_context.get(); }
 
 	private:
+        // Steps the subsystems which step with the timer's fixed step, as many times as fit in the frame
+        void TickFixedSteps() const;
+
         WindowData m_window_data;
         uint32_t m_flags        = 0;
         Timer* m_timer          = nullptr;
+        Threading* m_threading  = nullptr;
+        Renderer* m_renderer    = nullptr;
+        Profiler* m_profiler    = nullptr;
 		std::shared_ptr<Context> m_context;
 	};
 }
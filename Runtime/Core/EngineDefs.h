@@ -30,6 +30,11 @@ constexpr auto engine_version = "v0.32 WIP";
 //#define API_GRAPHICS_VULKAN
 #define API_INPUT_WINDOWS
 
+// Memory tracking - replaces the global operator new/delete to count heap allocations per Memory_Tag (16 bytes of overhead per allocation)
+#ifndef SPARTAN_MEMORY_TRACKING
+#define SPARTAN_MEMORY_TRACKING 1
+#endif
+
 // Class
 #define SPARTAN_CLASS
 #if SPARTAN_RUNTIME_SHARED == 1
@@ -75,4 +80,9 @@ namespace Spartan
     }
 }
 
+// A failed assert aborts, so what was logged before it is flushed first (the log is written by a thread of its own)
+#if defined(NDEBUG)
 #define SPARTAN_ASSERT(expression) assert(expression)
+#else
+#define SPARTAN_ASSERT(expression) do { if (!(expression)) { Spartan::Log::Flush(); assert(expression); } } while (false)
+#endif
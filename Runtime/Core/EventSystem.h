@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unordered_map>
 #include <vector>
 #include <functional>
+#include <atomic>
 #include "../Core/Variant.h"
 //==========================
 
@@ -35,8 +36,14 @@ To subscribe a function to an event		-> SUBSCRIBE_TO_EVENT(EVENT_ID, Handler);
 To unsubscribe a function from an event	-> SUBSCRIBE_TO_EVENT(EVENT_ID, Handler);
 To fire an event						-> FIRE_EVENT(EVENT_ID);
 To fire an event with data				-> FIRE_EVENT_DATA(EVENT_ID, Variant);
-
-Note: Currently, this is a blocking event system
+To fire an event with bulk data			-> FIRE_EVENT_DATA(EVENT_ID, Span<T>(vector)); (not copied, can't be queued)
+To queue an event						-> FIRE_EVENT_DEFERRED(EVENT_ID);
+To queue an event with data				-> FIRE_EVENT_DATA_DEFERRED(EVENT_ID, Variant);
+
+Note: Firing is blocking, the subscribers are called on the firing thread.
+Queued events can be fired from any thread, their subscribers are called on the main
+thread when the engine flushes the queue (at the start of every frame). Queued events
+without data coalesce, firing one which is already in the queue does nothing.
 =================================================================================
 */
 
@@ -50,10 +57,15 @@ enum Event_Type
 	Event_World_Loaded,		        // The world finished loading from file
 	Event_World_Unload,		        // The world should clear everything
 	Event_World_Resolve_Pending,	// The world should resolve
-	Event_World_Resolve_Complete,	// The world has finished resolving
+	Event_World_Resolve_Complete,	// The world has finished resolving, the data is a Span of its entities
+	Event_World_Schedule_Pending,	// The components which the world calls in each phase changed (e.g. an entity was activated), no resolve needed
+	Event_World_Cell_Loaded,		// A streamed cell of the world finished loading, the data is the index of the cell
+	Event_World_Cell_Unloaded,		// A streamed cell of the world was unloaded, the data is the index of the cell
 	Event_World_Stop,		        // The world should stop ticking
 	Event_World_Start,		        // The world should start ticking
-    Event_Frame_Resolution_Changed
+    Event_Frame_Resolution_Changed,
+    Event_Shaders_Compiled,         // The shaders which the renderer compiles on start-up are ready
+    Event_Count                     // Must stay below 64, queued events coalesce through a 64-bit mask
 };
 
 //= MACROS ====================================================================================================
@@ -68,11 +80,15 @@ enum Event_Type
 
 #define FIRE_EVENT(eventID)							Spartan::EventSystem::Get().Fire(eventID)
 #define FIRE_EVENT_DATA(eventID, data)				Spartan::EventSystem::Get().Fire(eventID, data)
+#define FIRE_EVENT_DEFERRED(eventID)				Spartan::EventSystem::Get().FireDeferred(eventID)
+#define FIRE_EVENT_DATA_DEFERRED(eventID, data)		Spartan::EventSystem::Get().FireDeferred(eventID, data)
 
 #define SUBSCRIBE_TO_EVENT(eventID, function)		Spartan::EventSystem::Get().Subscribe(eventID, function);
 #define UNSUBSCRIBE_FROM_EVENT(eventID, function)	Spartan::EventSystem::Get().Unsubscribe(eventID, function);
 //=============================================================================================================
 
+static_assert(Event_Count <= 64, "Queued events coalesce through a 64-bit mask");
+
 namespace Spartan
 {
 	using subscriber = std::function<void(const Variant&)>;
@@ -118,12 +134,94 @@ namespace Spartan
 			}
 		}
 
+		// Queues an event without data, unless one of the same type is already queued
+		void FireDeferred(const Event_Type event_id)
+		{
+			const uint64_t bit = GetPendingBit(event_id);
+			if (m_deferred_pending.fetch_or(bit, std::memory_order_acq_rel) & bit)
+				return;
+
+			Push(new DeferredEvent{ event_id, 0, true });
+		}
+
+		// Queues an event with data, these never coalesce
+		void FireDeferred(const Event_Type event_id, const Variant& data)
+		{
+			Push(new DeferredEvent{ event_id, data, false });
+		}
+
+		// A view doesn't own what it points to, so it can't wait in the queue
+		template <typename T>
+		void FireDeferred(const Event_Type event_id, const Span<T>& data) = delete;
+
+		// Fires the queued events in the order they were queued, events which are queued meanwhile wait for the next flush
+		void Flush()
+		{
+			DeferredEvent* event = ReverseToFifo(m_deferred_head.exchange(nullptr, std::memory_order_acquire));
+			while (event)
+			{
+				DeferredEvent* next = event->next;
+
+				// Cleared before firing, so a subscriber can queue the same event for the next flush
+				if (event->coalesces)
+				{
+					m_deferred_pending.fetch_and(~GetPendingBit(event->event_id), std::memory_order_acq_rel);
+				}
+
+				Fire(event->event_id, event->data);
+				delete event;
+				event = next;
+			}
+		}
+
 		void Clear() 
 		{
 			m_subscribers.clear(); 
+
+			DeferredEvent* event = m_deferred_head.exchange(nullptr, std::memory_order_acquire);
+			while (event)
+			{
+				DeferredEvent* next = event->next;
+				delete event;
+				event = next;
+			}
+			m_deferred_pending = 0;
 		}
 
 	private:
+		struct DeferredEvent
+		{
+			Event_Type event_id;
+			Variant data;
+			bool coalesces;
+			DeferredEvent* next = nullptr;
+		};
+
+		static uint64_t GetPendingBit(const Event_Type event_id) { return static_cast<uint64_t>(1) << static_cast<uint32_t>(event_id); }
+
+		// Any number of producers push onto a lock-free stack, the single consumer takes the whole stack at once (so there is no ABA)
+		void Push(DeferredEvent* event)
+		{
+			event->next = m_deferred_head.load(std::memory_order_relaxed);
+			while (!m_deferred_head.compare_exchange_weak(event->next, event, std::memory_order_release, std::memory_order_relaxed)) {}
+		}
+
+		static DeferredEvent* ReverseToFifo(DeferredEvent* event)
+		{
+			DeferredEvent* fifo = nullptr;
+			while (event)
+			{
+				DeferredEvent* next	= event->next;
+				event->next			= fifo;
+				fifo				= event;
+				event				= next;
+			}
+
+			return fifo;
+		}
+
 		std::unordered_map<Event_Type, std::vector<subscriber>> m_subscribers;
+		std::atomic<DeferredEvent*> m_deferred_head	= nullptr;
+		std::atomic<uint64_t> m_deferred_pending	= 0;
 	};
 }
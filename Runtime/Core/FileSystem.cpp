@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <fstream>
 #include <sstream> 
 #include "../Logging/Log.h"
+#include "../IO/Archive.h"
 #include <Windows.h>
 #include <shellapi.h>
 //=========================
@@ -247,6 +248,10 @@ namespace Spartan
 
     bool FileSystem::Exists(const string& path)
     {
+        // Packed files are found without touching the disk
+        if (Archive::Exists(path))
+            return true;
+
         try
         {
             if (filesystem::exists(path))
@@ -280,6 +285,9 @@ namespace Spartan
         if (path.empty())
             return false;
 
+        if (Archive::Exists(path))
+            return true;
+
         try
         {
             if (filesystem::exists(path) && filesystem::is_regular_file(path))
@@ -293,6 +301,20 @@ namespace Spartan
         return false;
     }
 
+    uint64_t FileSystem::GetFileSize(const string& path)
+    {
+        error_code error;
+        const uintmax_t size = filesystem::file_size(path, error);
+        return error ? 0 : static_cast<uint64_t>(size);
+    }
+
+    uint64_t FileSystem::GetLastWriteTime(const string& path)
+    {
+        error_code error;
+        const auto time = filesystem::last_write_time(path, error);
+        return error ? 0 : static_cast<uint64_t>(time.time_since_epoch().count());
+    }
+
 	bool FileSystem::CopyFileFromTo(const string& source, const string& destination)
 	{
 		if (source == destination)
@@ -439,6 +461,35 @@ namespace Spartan
 		return file_paths;
 	}
 
+    void FileSystem::IterateDirectory(const string& path, const function<bool(const string& path, bool is_directory)>& callback)
+    {
+        error_code error;
+        const filesystem::directory_iterator it_end; // default construction yields past-the-end
+        for (filesystem::directory_iterator it(path, error); !error && it != it_end; it.increment(error))
+        {
+            const bool is_directory = filesystem::is_directory(it->status());
+            if (!is_directory && !filesystem::is_regular_file(it->status()))
+                continue;
+
+            string entry_path;
+
+            // A system_error is possible if the characters are
+            // something that can't be converted, like Russian.
+            try
+            {
+                entry_path = it->path().string();
+            }
+            catch (system_error& e)
+            {
+                LOG_WARNING("Failed to read a path. %s", e.what());
+                continue;
+            }
+
+            if (!callback(entry_path, is_directory))
+                return;
+        }
+    }
+
 	bool FileSystem::IsSupportedAudioFile(const string& path)
 	{
         const string extension = GetExtensionFromFilePath(path);
@@ -550,6 +601,11 @@ namespace Spartan
 		return GetExtensionFromFilePath(path) == EXTENSION_TEXTURE;
 	}
 
+	bool FileSystem::IsEngineAnimationFile(const string& path)
+	{
+		return GetExtensionFromFilePath(path) == EXTENSION_ANIMATION;
+	}
+
     bool FileSystem::IsEngineAudioFile(const std::string& path)
     {
         return GetExtensionFromFilePath(path) == EXTENSION_AUDIO;
@@ -569,6 +625,7 @@ namespace Spartan
                 IsEngineMeshFile(path)     ||
                 IsEngineSceneFile(path)    ||
                 IsEngineTextureFile(path)  ||
+                IsEngineAnimationFile(path) ||
                 IsEngineAudioFile(path)    ||
                 IsEngineShaderFile(path);
     }
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==================
 #include <vector>
 #include <string>
+#include <functional>
 #include "../Core/EngineDefs.h"
 //=============================
 
@@ -51,6 +52,9 @@ namespace Spartan
 		static bool Exists(const std::string& path);
         static bool IsDirectory(const std::string& path);
         static bool IsFile(const std::string& path);
+        // Size in bytes and last write time (in the file system's clock ticks) of a file, zero if it can't be queried
+        static uint64_t GetFileSize(const std::string& path);
+        static uint64_t GetLastWriteTime(const std::string& path);
 		static bool CopyFileFromTo(const std::string& source, const std::string& destination);
 		static std::string GetFileNameFromFilePath(const std::string& path);
 		static std::string GetFileNameNoExtensionFromFilePath(const std::string& path);
@@ -64,6 +68,8 @@ namespace Spartan
         static std::string GetParentDirectory(const std::string& path);
 		static std::vector<std::string> GetDirectoriesInDirectory(const std::string& path);
 		static std::vector<std::string> GetFilesInDirectory(const std::string& path);
+        // Calls back with each entry as it's read (return false to stop), instead of collecting all of them first
+        static void IterateDirectory(const std::string& path, const std::function<bool(const std::string& path, bool is_directory)>& callback);
 
         // Supported files
 		static bool IsSupportedAudioFile(const std::string& path);
@@ -78,6 +84,7 @@ namespace Spartan
 		static bool IsEngineModelFile(const std::string& path);
 		static bool IsEngineSceneFile(const std::string& path);
 		static bool IsEngineTextureFile(const std::string& path);
+		static bool IsEngineAnimationFile(const std::string& path);
         static bool IsEngineAudioFile(const std::string& path);
 		static bool IsEngineShaderFile(const std::string& path);
         static bool IsEngineFile(const std::string& path);
@@ -101,6 +108,8 @@ namespace Spartan
     static const char* EXTENSION_TEXTURE   = ".texture";
     static const char* EXTENSION_MESH      = ".mesh";
     static const char* EXTENSION_AUDIO     = ".audio";
+    static const char* EXTENSION_ARCHIVE   = ".archive";
+    static const char* EXTENSION_ANIMATION = ".animation";
 
     static const std::vector<std::string> supported_formats_image
     {
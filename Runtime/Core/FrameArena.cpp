@@ -0,0 +1,163 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+//= INCLUDES ==========
+#include "FrameArena.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <limits>
+//=====================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace _FrameArena
+    {
+        constexpr size_t chunk_size         = 256 * 1024;
+        constexpr uint32_t frames_in_flight = 2;
+
+        struct Chunk
+        {
+            unique_ptr<byte[]> memory;
+            size_t size = 0;
+        };
+
+        // The allocations of one frame, chunks are kept once the thread has needed them
+        struct Buffer
+        {
+            vector<Chunk> chunks;
+            uint32_t chunk              = 0;
+            size_t offset               = 0;
+            // Also read by other threads, for the statistics
+            atomic<uint64_t> frame      = numeric_limits<uint64_t>::max();
+            atomic<uint64_t> bytes      = 0;
+            atomic<uint64_t> reserved   = 0;
+        };
+
+        struct Thread
+        {
+            Buffer buffers[frames_in_flight];
+        };
+
+        atomic<uint64_t> frame = 0;
+        mutex threads_mutex;
+        vector<unique_ptr<Thread>> threads; // threads are never removed, their chunks stay reserved
+        thread_local Thread* thread_arena = nullptr;
+
+        Thread* get_thread()
+        {
+            if (!thread_arena)
+            {
+                lock_guard<mutex> lock(threads_mutex);
+                thread_arena = threads.emplace_back(make_unique<Thread>()).get();
+            }
+
+            return thread_arena;
+        }
+    }
+
+    void* FrameArena::Allocate(const size_t size, const size_t alignment /*= alignof(max_align_t)*/)
+    {
+        const uint64_t frame        = _FrameArena::frame.load(memory_order_relaxed);
+        _FrameArena::Buffer& buffer = _FrameArena::get_thread()->buffers[frame % _FrameArena::frames_in_flight];
+
+        // The buffer still holds an older frame, which is no longer used
+        if (buffer.frame.load(memory_order_relaxed) != frame)
+        {
+            buffer.frame.store(frame, memory_order_relaxed);
+            buffer.chunk    = 0;
+            buffer.offset   = 0;
+            buffer.bytes.store(0, memory_order_relaxed);
+        }
+
+        while (true)
+        {
+            if (buffer.chunk < buffer.chunks.size())
+            {
+                _FrameArena::Chunk& chunk   = buffer.chunks[buffer.chunk];
+                const uintptr_t base        = reinterpret_cast<uintptr_t>(chunk.memory.get());
+                const size_t offset         = ((base + buffer.offset + alignment - 1) & ~(alignment - 1)) - base;
+                if (offset + size <= chunk.size)
+                {
+                    buffer.offset = offset + size;
+                    buffer.bytes.fetch_add(size, memory_order_relaxed);
+                    return chunk.memory.get() + offset;
+                }
+
+                buffer.chunk++;
+                buffer.offset = 0;
+                continue;
+            }
+
+            // Out of chunks, allocations which are bigger than a chunk get one of their own
+            _FrameArena::Chunk& chunk   = buffer.chunks.emplace_back();
+            chunk.size                  = size + alignment > _FrameArena::chunk_size ? size + alignment : _FrameArena::chunk_size;
+            chunk.memory                = make_unique<byte[]>(chunk.size);
+            buffer.reserved.fetch_add(chunk.size, memory_order_relaxed);
+        }
+    }
+
+    void FrameArena::OnFrameEnd()
+    {
+        _FrameArena::frame.fetch_add(1, memory_order_relaxed);
+    }
+
+    uint64_t FrameArena::GetBytesFrame()
+    {
+        const uint64_t frame = _FrameArena::frame.load(memory_order_relaxed);
+        if (frame == 0)
+            return 0;
+
+        uint64_t bytes = 0;
+        lock_guard<mutex> lock(_FrameArena::threads_mutex);
+        for (const unique_ptr<_FrameArena::Thread>& thread : _FrameArena::threads)
+        {
+            const _FrameArena::Buffer& buffer = thread->buffers[(frame - 1) % _FrameArena::frames_in_flight];
+            if (buffer.frame.load(memory_order_relaxed) == frame - 1)
+            {
+                bytes += buffer.bytes.load(memory_order_relaxed);
+            }
+        }
+
+        return bytes;
+    }
+
+    uint64_t FrameArena::GetBytesReserved()
+    {
+        uint64_t bytes = 0;
+        lock_guard<mutex> lock(_FrameArena::threads_mutex);
+        for (const unique_ptr<_FrameArena::Thread>& thread : _FrameArena::threads)
+        {
+            for (const _FrameArena::Buffer& buffer : thread->buffers)
+            {
+                bytes += buffer.reserved.load(memory_order_relaxed);
+            }
+        }
+
+        return bytes;
+    }
+}
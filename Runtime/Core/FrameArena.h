@@ -0,0 +1,72 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#pragma once
+
+//= INCLUDES ============
+#include <vector>
+#include <cstddef>
+#include "EngineDefs.h"
+//=======================
+
+namespace Spartan
+{
+    // A linear allocator for transient data, an allocation is a pointer bump in a chunk which belongs to the calling thread (so there are no locks)
+    // and nothing is freed individually, a frame's allocations are released all at once and their chunks are reused.
+    // Memory stays valid until the end of the frame after the one which allocated it, so that the pipelined renderer can use what the simulation left for it.
+    // It's not meant for anything which can outlive that, like the work of background tasks.
+    class SPARTAN_CLASS FrameArena
+    {
+    public:
+        static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        // Subscribed to Event_Frame_End, the memory of the frame before the one which ends gets reused from then on
+        static void OnFrameEnd();
+
+        static uint64_t GetBytesFrame();    // allocated during the last frame, by all threads
+        static uint64_t GetBytesReserved(); // the chunks which the threads hold
+    };
+
+    // An STL allocator which allocates from the frame arena, deallocation does nothing
+    template <typename T>
+    class FrameAllocator
+    {
+    public:
+        typedef T value_type;
+
+        FrameAllocator() = default;
+        template <typename U>
+        FrameAllocator(const FrameAllocator<U>&) {}
+
+        T* allocate(const size_t n)     { return static_cast<T*>(FrameArena::Allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, const size_t) {}
+
+        template <typename U>
+        bool operator==(const FrameAllocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const FrameAllocator<U>&) const { return false; }
+    };
+
+    template <typename T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+}
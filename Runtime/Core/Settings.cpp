@@ -24,9 +24,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Timer.h"
 #include "Context.h"
 #include <fstream>
+#include <cstring>
+#include <algorithm>
 #include "../Logging/Log.h"
 #include "../Core/FileSystem.h"
+#include "../Core/EventSystem.h"
 #include "../Rendering/Renderer.h"
+#include "../Profiling/Profiler.h"
 #include "../Threading/Threading.h"
 #include "pugixml.hpp"
 //=================================
@@ -58,11 +62,79 @@ namespace _Settings
             {
                 const auto lastindex = line.find_last_of('=');
                 const auto read_value = line.substr(lastindex + 1, line.length());
-                value = static_cast<T>(stof(read_value));
+                value = static_cast<T>(stod(read_value)); // a float can't hold every renderer flag
                 return;
             }
         }
     }
+
+    // The options which quality presets decide, the rest (debug, culling, etc.) are left as they are
+    const uint64_t quality_options =
+        Spartan::Render_Bloom                   |
+        Spartan::Render_VolumetricLighting      |
+        Spartan::Render_AntiAliasing_Taa        |
+        Spartan::Render_AntiAliasing_Fxaa       |
+        Spartan::Render_Hbao                    |
+        Spartan::Render_IndirectBounce          |
+        Spartan::Render_ScreenSpaceShadows      |
+        Spartan::Render_ScreenSpaceReflections  |
+        Spartan::Render_MotionBlur              |
+        Spartan::Render_Sharpening_LumaSharpen;
+
+    // Options calibration turns off while it measures, so that every frame is rendered and at the same resolution
+    const uint64_t calibration_options_off = Spartan::Render_Idle | Spartan::Render_DynamicResolution;
+
+    struct quality_preset
+    {
+        const char* name;
+        uint64_t options; // of quality_options, the ones which are on
+        float shadow_resolution;
+        float anisotropy;
+        float screen_space_scale;
+        float resolution_scale;
+        float lod_bias;
+    };
+
+    // From the highest to the lowest
+    const uint64_t quality_options_ultra    = quality_options & ~Spartan::Render_AntiAliasing_Fxaa;
+    const uint64_t quality_options_high     = quality_options_ultra & ~Spartan::Render_IndirectBounce;
+    const uint64_t quality_options_medium   = quality_options_high & ~(Spartan::Render_VolumetricLighting | Spartan::Render_ScreenSpaceReflections | Spartan::Render_MotionBlur);
+    const uint64_t quality_options_low      = Spartan::Render_Bloom | Spartan::Render_AntiAliasing_Fxaa;
+    const uint64_t quality_options_lowest   = Spartan::Render_AntiAliasing_Fxaa;
+    const quality_preset quality_presets[] =
+    {
+        // name     options                 shadows  aniso  ss scale  res scale  lod bias
+        { "Ultra",  quality_options_ultra,  4096.0f, 16.0f, 1.0f,     1.0f,      1.0f },
+        { "High",   quality_options_high,   2048.0f, 16.0f, 2.0f,     1.0f,      1.0f },
+        { "Medium", quality_options_medium, 2048.0f, 8.0f,  2.0f,     0.85f,     1.5f },
+        { "Low",    quality_options_low,    1024.0f, 4.0f,  4.0f,     0.75f,     2.0f },
+        { "Lowest", quality_options_lowest, 512.0f,  0.0f,  4.0f,     0.5f,      3.0f }
+    };
+    const int32_t quality_preset_count = static_cast<int32_t>(sizeof(quality_presets) / sizeof(quality_presets[0]));
+
+    // The GPU time blocks of the passes which an option adds, by the prefix of their name
+    struct quality_pass
+    {
+        uint64_t option;
+        const char* name;
+    };
+
+    const quality_pass quality_passes[] =
+    {
+        { Spartan::Render_VolumetricLighting,      "Pass_VolumetricLighting" },
+        { Spartan::Render_Hbao,                    "Pass_Hbao" },
+        { Spartan::Render_ScreenSpaceReflections,  "Pass_Ssr" },
+        { Spartan::Render_ScreenSpaceShadows,      "Pass_ScreenSpaceShadows" },
+        { Spartan::Render_MotionBlur,              "Pass_MotionBlur" },
+        { Spartan::Render_Bloom,                   "Pass_Bloom" },
+        { Spartan::Render_AntiAliasing_Taa,        "Pass_TAA" },
+        { Spartan::Render_Sharpening_LumaSharpen,  "Pass_LumaSharpen" }
+    };
+    const uint32_t quality_pass_count = static_cast<uint32_t>(sizeof(quality_passes) / sizeof(quality_passes[0]));
+
+    // Frames after a preset is applied which aren't measured (pipelines, shadow maps and render targets get created), and frames which are
+    const uint32_t calibration_frames_warmup   = 30;
+    const uint32_t calibration_frames_measured = 60;
 }
 
 namespace Spartan
@@ -82,6 +154,13 @@ namespace Spartan
 
     Settings::~Settings()
     {
+        // Quitting halfway keeps the preset which was being measured, it's the best guess so far
+        if (m_calibration_preset >= 0)
+        {
+            CalibrationFinish(m_calibration_preset);
+            return;
+        }
+
         Reflect();
         Save();
     }
@@ -99,19 +178,24 @@ namespace Spartan
         else
         {
             Save();
+            m_calibration_pending = true;
         }
 
+        SUBSCRIBE_TO_EVENT(Event_Frame_End, EVENT_HANDLER(OnFrameEnd));
+
         LOG_INFO("Resolution: %dx%d", static_cast<int>(m_resolution.x), static_cast<int>(m_resolution.y));
         LOG_INFO("FPS Limit: %f", m_fps_limit);
         LOG_INFO("Shadow resolution: %d", m_shadow_map_resolution);
         LOG_INFO("Anisotropy: %d", m_anisotropy);
         LOG_INFO("Max threads: %d", m_max_thread_count);
+        LOG_INFO("Quality preset: %s", GetQualityPreset());
 
         return true;
     }
 
     void Settings::RegisterThirdPartyLib(const std::string& name, const std::string& version, const std::string& url)
     {
+        lock_guard<mutex> lock(m_mutex_third_party_libs);
         m_third_party_libs.emplace_back(name, version, url);
     }
 
@@ -130,6 +214,10 @@ namespace Spartan
 		_Settings::write_setting(_Settings::fout, "fFPSLimit",              m_fps_limit);
 		_Settings::write_setting(_Settings::fout, "iMaxThreadCount",        m_max_thread_count);
         _Settings::write_setting(_Settings::fout, "iRendererFlags",         m_renderer_flags);
+        _Settings::write_setting(_Settings::fout, "fScreenSpaceScale",      m_screen_space_scale);
+        _Settings::write_setting(_Settings::fout, "fResolutionScale",       m_resolution_scale);
+        _Settings::write_setting(_Settings::fout, "fLodBias",               m_lod_bias);
+        _Settings::write_setting(_Settings::fout, "iQualityPreset",         m_quality_preset);
 
 		// Close the file.
 		_Settings::fout.close();
@@ -150,6 +238,10 @@ namespace Spartan
 		_Settings::read_setting(_Settings::fin, "fFPSLimit",            m_fps_limit);
 		_Settings::read_setting(_Settings::fin, "iMaxThreadCount",      m_max_thread_count);
         _Settings::read_setting(_Settings::fin, "iRendererFlags",       m_renderer_flags);
+        _Settings::read_setting(_Settings::fin, "fScreenSpaceScale",    m_screen_space_scale);
+        _Settings::read_setting(_Settings::fin, "fResolutionScale",     m_resolution_scale);
+        _Settings::read_setting(_Settings::fin, "fLodBias",             m_lod_bias);
+        _Settings::read_setting(_Settings::fin, "iQualityPreset",       m_quality_preset);
 
 		// Close the file.
 		_Settings::fin.close();
@@ -166,6 +258,9 @@ namespace Spartan
         m_resolution            = renderer->GetResolution();   
         m_shadow_map_resolution = renderer->GetOptionValue<uint32_t>(Option_Value_ShadowResolution);
         m_anisotropy            = renderer->GetOptionValue<uint32_t>(Option_Value_Anisotropy);
+        m_screen_space_scale    = renderer->GetOptionValue<float>(Option_Value_ScreenSpaceScale);
+        m_resolution_scale      = renderer->GetOptionValue<float>(Option_Value_ResolutionScale);
+        m_lod_bias              = renderer->GetOptionValue<float>(Option_Value_LodBias);
         m_renderer_flags        = renderer->GetOptions();
     }
 
@@ -177,6 +272,164 @@ namespace Spartan
         renderer->SetResolution(static_cast<uint32_t>(m_resolution.x), static_cast<uint32_t>(m_resolution.y));
         renderer->SetOptionValue(Option_Value_Anisotropy, static_cast<float>(m_anisotropy));
         renderer->SetOptionValue(Option_Value_ShadowResolution, static_cast<float>(m_shadow_map_resolution));
+        renderer->SetOptionValue(Option_Value_ScreenSpaceScale, m_screen_space_scale);
+        renderer->SetOptionValue(Option_Value_ResolutionScale, m_resolution_scale);
+        renderer->SetOptionValue(Option_Value_LodBias, m_lod_bias);
         renderer->SetOptions(m_renderer_flags);
     }
+
+    const char* Settings::GetQualityPreset() const
+    {
+        return (m_quality_preset >= 0 && m_quality_preset < _Settings::quality_preset_count) ? _Settings::quality_presets[m_quality_preset].name : "Custom";
+    }
+
+    void Settings::CalibrationStart()
+    {
+        // Starts when the frame ends, so that nothing which is mapping options back this frame overrides the first preset
+        m_calibration_requested = true;
+    }
+
+    void Settings::CalibrationBegin()
+    {
+        Renderer* renderer  = m_context->GetSubsystem<Renderer>();
+        Timer* timer        = m_context->GetSubsystem<Timer>();
+
+        // Frames aren't paced or skipped while measuring
+        m_calibration_options_kept  = renderer->GetOptions() & _Settings::calibration_options_off;
+        m_calibration_fps_limit     = timer->GetTargetFps();
+        m_calibration_pending       = false;
+        m_calibration_requested     = false;
+        timer->SetTargetFps(0.0);
+
+        LOG_INFO("Calibrating for %.2f ms", renderer->GetOptionValue<float>(Option_Value_DynamicResolution_TargetMs));
+        CalibrationApply(0);
+    }
+
+    void Settings::CalibrationApply(const int32_t preset_index)
+    {
+        const _Settings::quality_preset& preset = _Settings::quality_presets[preset_index];
+        Renderer* renderer                      = m_context->GetSubsystem<Renderer>();
+
+        renderer->SetOptions((renderer->GetOptions() & ~(_Settings::quality_options | _Settings::calibration_options_off)) | preset.options);
+        renderer->SetOptionValue(Option_Value_ShadowResolution,  preset.shadow_resolution);
+        renderer->SetOptionValue(Option_Value_Anisotropy,        preset.anisotropy);
+        renderer->SetOptionValue(Option_Value_ScreenSpaceScale,  preset.screen_space_scale);
+        renderer->SetOptionValue(Option_Value_ResolutionScale,   preset.resolution_scale);
+        renderer->SetOptionValue(Option_Value_LodBias,           preset.lod_bias);
+
+        m_calibration_preset            = preset_index;
+        m_calibration_frame             = 0;
+        m_calibration_gpu_time          = 0.0f;
+        m_calibration_profiled_frames   = 0;
+        m_calibration_frame_times.clear();
+        m_calibration_pass_times.assign(_Settings::quality_pass_count, 0.0f);
+    }
+
+    void Settings::CalibrationFinish(const int32_t preset_index)
+    {
+        Renderer* renderer = m_context->GetSubsystem<Renderer>();
+        renderer->SetOptions(renderer->GetOptions() | m_calibration_options_kept);
+        m_context->GetSubsystem<Timer>()->SetTargetFps(m_calibration_fps_limit);
+
+        m_quality_preset        = preset_index;
+        m_calibration_preset    = -1;
+        LOG_INFO("Quality preset: %s", GetQualityPreset());
+
+        Reflect();
+        Save();
+    }
+
+    void Settings::OnFrameEnd()
+    {
+        Profiler* profiler = m_context->GetSubsystem<Profiler>();
+
+        // The first run waits for something to measure
+        if (m_calibration_preset < 0 && (m_calibration_requested || (m_calibration_pending && profiler->m_renderer_meshes_rendered != 0)))
+        {
+            CalibrationBegin();
+            return;
+        }
+
+        if (m_calibration_preset < 0)
+            return;
+
+        m_calibration_frame++;
+        if (m_calibration_frame <= _Settings::calibration_frames_warmup)
+            return;
+
+        // Frame time, unpaced, so it's what the CPU and the GPU take
+        m_calibration_frame_times.emplace_back(static_cast<float>(m_context->GetSubsystem<Timer>()->GetDeltaTimeMs()));
+
+        // GPU time of the passes, from the frames the profiler profiled
+        if (profiler->GetTimeBlocksFrame() != m_calibration_profiler_frame)
+        {
+            m_calibration_profiler_frame = profiler->GetTimeBlocksFrame();
+            m_calibration_gpu_time += profiler->GetTimeGpuLast();
+            m_calibration_profiled_frames++;
+
+            for (const TimeBlock& time_block : profiler->GetTimeBlocks())
+            {
+                if (time_block.GetType() != TimeBlock_Gpu || !time_block.GetName())
+                    continue;
+
+                for (uint32_t i = 0; i < _Settings::quality_pass_count; i++)
+                {
+                    if (strncmp(time_block.GetName(), _Settings::quality_passes[i].name, strlen(_Settings::quality_passes[i].name)) == 0)
+                    {
+                        m_calibration_pass_times[i] += time_block.GetDuration();
+                    }
+                }
+            }
+        }
+
+        if (m_calibration_frame < _Settings::calibration_frames_warmup + _Settings::calibration_frames_measured)
+            return;
+
+        // The median, a hitch or two don't decide the preset
+        nth_element(m_calibration_frame_times.begin(), m_calibration_frame_times.begin() + m_calibration_frame_times.size() / 2, m_calibration_frame_times.end());
+        const float frame_time                  = m_calibration_frame_times[m_calibration_frame_times.size() / 2];
+        const float target                      = m_context->GetSubsystem<Renderer>()->GetOptionValue<float>(Option_Value_DynamicResolution_TargetMs);
+        const _Settings::quality_preset& preset = _Settings::quality_presets[m_calibration_preset];
+        const int32_t preset_last               = _Settings::quality_preset_count - 1;
+        LOG_INFO("%s: %.2f ms", preset.name, frame_time);
+
+        if (frame_time <= target || m_calibration_preset == preset_last)
+        {
+            CalibrationFinish(m_calibration_preset);
+            return;
+        }
+
+        // Without GPU times, presets are measured one after the other. With them, the presets which are estimated to still miss the target
+        // are skipped, a preset saves the time of the passes it turns off and what's left of the GPU time scales with the pixel count.
+        int32_t preset_next = m_calibration_preset + 1;
+        if (m_calibration_profiled_frames != 0)
+        {
+            const float profiled_frames = static_cast<float>(m_calibration_profiled_frames);
+            const float gpu_time        = m_calibration_gpu_time / profiled_frames;
+
+            preset_next = preset_last;
+            for (int32_t i = m_calibration_preset + 1; i < preset_last; i++)
+            {
+                const _Settings::quality_preset& candidate = _Settings::quality_presets[i];
+
+                float saving = 0.0f;
+                for (uint32_t pass = 0; pass < _Settings::quality_pass_count; pass++)
+                {
+                    const uint64_t option = _Settings::quality_passes[pass].option;
+                    saving += ((preset.options & option) && !(candidate.options & option)) ? m_calibration_pass_times[pass] / profiled_frames : 0.0f;
+                }
+
+                const float scale   = candidate.resolution_scale / preset.resolution_scale;
+                saving              += max(gpu_time - saving, 0.0f) * (1.0f - scale * scale);
+
+                if (frame_time - saving <= target)
+                {
+                    preset_next = i;
+                    break;
+                }
+            }
+        }
+
+        CalibrationApply(preset_next);
+    }
 }
@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ISubsystem.h"
 #include "../Math/Vector2.h"
 #include <vector>
+#include <mutex>
 //==========================
 
 namespace Spartan
@@ -55,6 +56,13 @@ namespace Spartan
         bool Initialize() override;
         //=========================
 
+        // Quality presets, calibration renders the loaded world at each preset, from the highest down, and keeps the first one whose frame time
+        // meets Option_Value_DynamicResolution_TargetMs. The GPU cost the passes of each option were measured at lets it skip presets which can't
+        // get there. The first run calibrates once a frame draws something, the result is saved along with the rest of the settings.
+        void CalibrationStart();
+        bool IsCalibrating()            const { return m_calibration_preset >= 0 || m_calibration_requested; }
+        const char* GetQualityPreset()  const; // the one calibration picked, "Custom" if it never ran
+
 		//= MISC =======================================================
         bool GetIsFullScreen()      const { return m_is_fullscreen; }
         bool GetIsMouseVisible()    const { return m_is_mouse_visible; }
@@ -70,6 +78,10 @@ namespace Spartan
 
         void Reflect();
         void Map() const;
+        void OnFrameEnd();
+        void CalibrationBegin();
+        void CalibrationApply(int32_t preset);
+        void CalibrationFinish(int32_t preset);
 
 		bool m_is_fullscreen				= false;
 		bool m_is_mouse_visible				= true;
@@ -79,8 +91,26 @@ namespace Spartan
 		uint32_t m_anisotropy				= 0;
 		uint32_t m_max_thread_count			= 0;
         double m_fps_limit                  = 0;
+        float m_screen_space_scale          = 0.0f;
+        float m_resolution_scale            = 0.0f;
+        float m_lod_bias                    = 0.0f;
+        int32_t m_quality_preset            = -1;
         bool m_loaded                       = false;
         Context* m_context                  = nullptr;
         std::vector<ThirdPartyLib> m_third_party_libs;
+        std::mutex m_mutex_third_party_libs; // subsystems which initialize in parallel register theirs concurrently
+
+        // Calibration
+        int32_t m_calibration_preset            = -1; // the one being measured
+        bool m_calibration_pending              = false; // first run, waits for a frame which draws something
+        bool m_calibration_requested            = false;
+        uint32_t m_calibration_frame            = 0;
+        std::vector<float> m_calibration_frame_times;
+        std::vector<float> m_calibration_pass_times; // GPU time of the passes of each option, summed over the profiled frames
+        float m_calibration_gpu_time            = 0.0f;
+        uint32_t m_calibration_profiled_frames  = 0;
+        uint64_t m_calibration_profiler_frame   = 0;
+        uint64_t m_calibration_options_kept     = 0; // the options calibration turns off while it measures, as they were
+        double m_calibration_fps_limit          = 0.0;
 	};
 }
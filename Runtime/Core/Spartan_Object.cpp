@@ -0,0 +1,49 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =============
+#include "Spartan_Object.h"
+#include <atomic>
+//========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    // A single counter for the whole engine (a header static would give every translation unit its own, and so duplicate ids)
+    static atomic<uint32_t> g_id = 0;
+
+    void Spartan_Object::SetId(const uint32_t id)
+    {
+        m_id = id;
+
+        // Ids which are read from disk are reserved, so that the ones generated afterwards don't collide with them
+        uint32_t id_current = g_id.load();
+        while (id_current < id && !g_id.compare_exchange_weak(id_current, id)) {}
+    }
+
+    uint32_t Spartan_Object::GenerateId()
+    {
+        return ++g_id;
+    }
+}
@@ -0,0 +1,130 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===========
+#include "StringId.h"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+//======================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace _StringId
+    {
+        struct Table
+        {
+            Table()
+            {
+                strings.emplace_back();
+                hashes.emplace_back(0);
+            }
+
+            // A deque doesn't move its elements as it grows, so the views (and the references Get() returns) stay valid
+            deque<string> strings;
+            deque<uint32_t> hashes;
+            unordered_map<string_view, uint32_t> ids;
+            shared_mutex mutex;
+        };
+
+        // Interned strings can be used during static initialization and destruction, so the table is never destroyed
+        static Table& table()
+        {
+            static Table* table = new Table();
+            return *table;
+        }
+
+        static uint32_t hash(const string_view& str)
+        {
+            // 32-bit FNV-1a
+            uint32_t hash = 2166136261u;
+            for (const char c : str)
+            {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+    }
+
+    StringId::StringId(const string& str) : StringId(str.c_str())
+    {
+
+    }
+
+    StringId::StringId(const char* str)
+    {
+        if (!str || str[0] == '\0')
+            return;
+
+        _StringId::Table& table = _StringId::table();
+        const string_view view(str);
+
+        // Most strings are interned already
+        {
+            shared_lock<shared_mutex> lock(table.mutex);
+            const auto it = table.ids.find(view);
+            if (it != table.ids.end())
+            {
+                m_id    = it->second;
+                m_hash  = table.hashes[m_id];
+                return;
+            }
+        }
+
+        unique_lock<shared_mutex> lock(table.mutex);
+
+        // Another thread may have interned it in the meantime
+        const auto it = table.ids.find(view);
+        if (it != table.ids.end())
+        {
+            m_id    = it->second;
+            m_hash  = table.hashes[m_id];
+            return;
+        }
+
+        m_id    = static_cast<uint32_t>(table.strings.size());
+        m_hash  = _StringId::hash(view);
+        const string& interned = table.strings.emplace_back(view);
+        table.hashes.emplace_back(m_hash);
+        table.ids.emplace(string_view(interned), m_id);
+    }
+
+    const string& StringId::Get() const
+    {
+        _StringId::Table& table = _StringId::table();
+        shared_lock<shared_mutex> lock(table.mutex);
+        return table.strings[m_id];
+    }
+
+    uint32_t StringId::GetCount()
+    {
+        _StringId::Table& table = _StringId::table();
+        shared_lock<shared_mutex> lock(table.mutex);
+        return static_cast<uint32_t>(table.strings.size());
+    }
+}
@@ -0,0 +1,67 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==========
+#include <string>
+#include <functional>
+#include "EngineDefs.h"
+//=====================
+
+namespace Spartan
+{
+    // An interned string, equal strings share a single copy in a global table and get the same id.
+    // Comparing and hashing is an integer operation (the hash is computed once, when the string is interned),
+    // so it's meant for keys which are looked up often (names, paths, defines). Interned strings are never released.
+    class SPARTAN_CLASS StringId
+    {
+    public:
+        StringId() = default;
+        StringId(const std::string& str);
+        StringId(const char* str);
+
+        const std::string& Get()    const; // the interned string, stays valid for the lifetime of the program
+        const char* c_str()         const { return Get().c_str(); }
+        uint32_t GetId()            const { return m_id; }
+        uint32_t GetHash()          const { return m_hash; }
+        bool IsEmpty()              const { return m_id == 0; }
+
+        bool operator==(const StringId& rhs) const { return m_id == rhs.m_id; }
+        bool operator!=(const StringId& rhs) const { return m_id != rhs.m_id; }
+        bool operator<(const StringId& rhs)  const { return m_id < rhs.m_id; } // by id, not alphabetical
+
+        static uint32_t GetCount(); // strings in the table
+
+    private:
+        uint32_t m_id   = 0; // zero is the empty string
+        uint32_t m_hash = 0;
+    };
+}
+
+namespace std
+{
+    template <>
+    struct hash<Spartan::StringId>
+    {
+        size_t operator()(const Spartan::StringId& string_id) const { return string_id.GetHash(); }
+    };
+}
@@ -26,6 +26,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Logging/Log.h"
 #include "../RHI/RHI_Device.h"
 #include "../Rendering/Renderer.h"
+#include <thread>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002 // missing from older SDKs
+#endif
+#endif
 //================================
 
 //= NAMESPACES =====
@@ -39,49 +49,154 @@ namespace Spartan
         m_time_start        = chrono::high_resolution_clock::now();
 		m_time_frame_start  = chrono::high_resolution_clock::now();
 		m_time_frame_end    = chrono::high_resolution_clock::now();
+
+        // A high resolution waitable timer (Windows 10 1803 and later), the regular sleep has a granularity of a millisecond or worse
+        #if defined(_WIN32)
+            m_waitable_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        #endif
 	}
 
+    Timer::~Timer()
+    {
+        #if defined(_WIN32)
+            if (m_waitable_timer)
+            {
+                CloseHandle(static_cast<HANDLE>(m_waitable_timer));
+            }
+        #endif
+    }
+
+    bool Timer::Initialize()
+    {
+        m_renderer = m_context->GetSubsystem<Renderer>();
+        return true;
+    }
+
 	void Timer::Tick(float delta_time)
 	{
+        // Fps limiting, the frame starts one target frame time after the previous one started.
+        // Pacing against the previous start (instead of the length of the previous frame) keeps the frame times even.
+        // An idle renderer has nothing to show, so the thread sleeps for most of the frame.
+        const double fps_target         = (m_renderer && m_renderer->IsIdle() && m_fps_idle < m_fps_target) ? m_fps_idle : m_fps_target;
+        const auto frame_start_target   = m_time_frame_start + chrono::duration_cast<chrono::high_resolution_clock::duration>(chrono::duration<double, milli>(1000.0 / fps_target));
+        if (m_delta_time_override_ms == 0.0 && chrono::high_resolution_clock::now() < frame_start_target)
+        {
+            SleepUntil(frame_start_target);
+        }
+
         // Get time
         m_time_frame_end    = m_time_frame_start;
         m_time_frame_start  = chrono::high_resolution_clock::now();
 
         // Compute durations
-        const chrono::duration<double, milli> time_elapsed      = m_time_start - m_time_frame_start;
-        chrono::duration<double, milli> time_delta              = m_time_frame_start - m_time_frame_end;
-		const chrono::duration<double, milli> time_remaining    = chrono::duration<double, milli>(1000.0 / m_fps_target) - time_delta;
-
-        // Fps limiting
-		if (time_remaining.count() > 0)
-		{
-            // Compute sleep duration and account for the sleep overhead.
-            // The sleep overhead is the time the kernel takes to wake up the thread after the thread has finished sleeping.
-            chrono::duration<double, milli> sleep_duration_requested = chrono::duration<double, milli>(time_remaining.count() - m_sleep_overhead);
-
-            // Put the thread to sleep
-            this_thread::sleep_until(m_time_frame_start + sleep_duration_requested);
-
-            // Compute sleep overhead (to use in next tick)
-            chrono::duration<double, milli> sleep_time_real = chrono::high_resolution_clock::now() - m_time_frame_start;
-            m_sleep_overhead = sleep_time_real.count() - sleep_duration_requested.count();
-
-            // Account for sleep duration
-            time_delta += sleep_time_real;
-		}
+        const chrono::duration<double, milli> time_elapsed  = m_time_start - m_time_frame_start;
+        const chrono::duration<double, milli> time_delta    = m_time_frame_start - m_time_frame_end;
 
         // Save times
         m_time_ms           = static_cast<double>(time_elapsed.count());
 		m_delta_time_ms     = static_cast<double>(time_delta.count());
 
+        // Overridden, the time advances by the delta time only
+        if (m_delta_time_override_ms != 0.0)
+        {
+            m_time_override_ms  += m_delta_time_override_ms;
+            m_time_ms           = m_time_override_ms;
+            m_delta_time_ms     = m_delta_time_override_ms;
+        }
+        else
+        {
+            m_time_override_ms  = m_time_ms;
+        }
+
         // Compute smoothed delta time
         const double frames_to_accumulate   = 5;
         const double delta_feedback         = 1.0 / frames_to_accumulate;
         double delta_max                    = 1000.0 / m_fps_min;
         const double delta_clamped          = m_delta_time_ms > delta_max ? delta_max : m_delta_time_ms; // If frame time is too high/slow, clamp it   
         m_delta_time_smoothed_ms            = m_delta_time_smoothed_ms * (1.0 - delta_feedback) + delta_clamped * delta_feedback;
+
+        // Fixed step, the frame's time is consumed in whole steps and what's left over becomes the interpolation alpha
+        if (m_fixed_step_enabled)
+        {
+            m_fixed_step_accumulator    += m_delta_time_ms;
+            m_fixed_step_count          = static_cast<uint32_t>(m_fixed_step_accumulator / m_fixed_step_ms);
+            if (m_fixed_step_count > m_fixed_step_max)
+            {
+                m_fixed_step_count          = m_fixed_step_max;
+                m_fixed_step_accumulator    = m_fixed_step_ms * m_fixed_step_max;
+            }
+            m_fixed_step_accumulator    -= m_fixed_step_count * m_fixed_step_ms;
+            m_fixed_step_alpha          = static_cast<float>(m_fixed_step_accumulator / m_fixed_step_ms);
+        }
 	}
 
+    void Timer::SetFixedStepEnabled(const bool enabled)
+    {
+        if (m_fixed_step_enabled == enabled)
+            return;
+
+        m_fixed_step_enabled        = enabled;
+        m_fixed_step_accumulator    = 0.0;
+        m_fixed_step_count          = 0;
+        m_fixed_step_index          = 0;
+        m_fixed_step_alpha          = 1.0f;
+        LOG_INFO("Fixed step %s", enabled ? "enabled" : "disabled");
+    }
+
+    void Timer::SetFixedStepHz(const double hz)
+    {
+        if (hz <= 0.0)
+        {
+            LOG_ERROR("Invalid fixed step rate %.2f Hz", hz);
+            return;
+        }
+
+        m_fixed_step_ms = 1000.0 / hz;
+    }
+
+    void Timer::SleepUntil(const chrono::high_resolution_clock::time_point& time)
+    {
+        // The last stretch is too short for any timer, the thread yields until it's over
+        const chrono::duration<double, milli> yield_duration = chrono::duration<double, milli>(0.1);
+
+        #if defined(_WIN32)
+        if (m_waitable_timer)
+        {
+            const chrono::duration<double, milli> sleep_duration = time - chrono::high_resolution_clock::now() - yield_duration;
+            if (sleep_duration.count() > 0.0)
+            {
+                // Relative due time, in 100 nanosecond units
+                LARGE_INTEGER due_time;
+                due_time.QuadPart = -static_cast<LONGLONG>(sleep_duration.count() * 10000.0);
+
+                if (SetWaitableTimerEx(static_cast<HANDLE>(m_waitable_timer), &due_time, 0, nullptr, nullptr, nullptr, 0))
+                {
+                    WaitForSingleObject(static_cast<HANDLE>(m_waitable_timer), INFINITE);
+                }
+            }
+        }
+        else
+        #endif
+        {
+            // Account for the sleep overhead, the time the kernel takes to wake up the thread after it has finished sleeping
+            const auto sleep_start = chrono::high_resolution_clock::now();
+            const chrono::duration<double, milli> sleep_duration_requested = time - sleep_start - chrono::duration<double, milli>(m_sleep_overhead);
+            if (sleep_duration_requested.count() > 0.0)
+            {
+                this_thread::sleep_until(sleep_start + chrono::duration_cast<chrono::high_resolution_clock::duration>(sleep_duration_requested));
+
+                // Compute sleep overhead (to use in next tick)
+                const chrono::duration<double, milli> sleep_duration_real = chrono::high_resolution_clock::now() - sleep_start;
+                m_sleep_overhead = sleep_duration_real.count() - sleep_duration_requested.count();
+            }
+        }
+
+        while (chrono::high_resolution_clock::now() < time)
+        {
+            this_thread::yield();
+        }
+    }
+
     void Timer::SetTargetFps(double fps_in)
     {
         if (fps_in < 0.0f) // negative -> match monitor's refresh rate
@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {
     class Context;
+    class Renderer;
 
     enum FPS_Policy
     {
@@ -41,9 +42,10 @@ namespace Spartan
 	{
 	public:
 		Timer(Context* context);
-		~Timer() = default;
+		~Timer();
 
         //= ISybsystem ======================
+        bool Initialize() override;
 		void Tick(float delta_time) override;
         //===================================
 
@@ -52,6 +54,8 @@ namespace Spartan
         auto GetTargetFps() const   { return m_fps_target; }
         auto GetMinFps() const      { return m_fps_min; }
         auto GetFpsPolicy() const   { return m_fps_policy; }
+        void SetIdleFps(double fps) { m_fps_idle = fps; }   // paced at while the renderer is idle (see Render_Idle)
+        auto GetIdleFps() const     { return m_fps_idle; }
         //==================================================
 
         auto GetTimeMs()                const { return m_time_ms; }
@@ -60,8 +64,28 @@ namespace Spartan
 		auto GetDeltaTimeSec()          const { return static_cast<float>(m_delta_time_ms / 1000.0); }
         auto GetDeltaTimeSmoothedMs()   const { return m_delta_time_smoothed_ms; }
         auto GetDeltaTimeSmoothedSec()  const { return static_cast<float>(m_delta_time_smoothed_ms / 1000.0); }
+        // Replaces the measured delta time of the next ticks (and doesn't limit the frame rate), zero goes back to measuring it.
+        // Frame replays use it, so that the simulation sees the times it saw when it was captured.
+        void SetDeltaTimeOverride(double delta_time_ms) { m_delta_time_override_ms = delta_time_ms; }
+
+        //= FIXED STEP ====================================================================================================
+        // When enabled, the simulation steps at a fixed rate (zero or more steps per frame) and the renderer interpolates
+        // between the last two steps. The step size doesn't depend on the frame rate, so neither does the simulation.
+        void SetFixedStepEnabled(bool enabled);
+        void SetFixedStepHz(double hz);
+        auto IsFixedStepEnabled()       const { return m_fixed_step_enabled; }
+        auto GetFixedStepHz()           const { return 1000.0 / m_fixed_step_ms; }
+        auto GetFixedStepSec()          const { return static_cast<float>(m_fixed_step_ms / 1000.0); }
+        auto GetFixedStepCount()        const { return m_fixed_step_count; }    // steps to take this frame
+        auto GetFixedStepIndex()        const { return m_fixed_step_index; }    // steps taken since the fixed step was enabled
+        auto GetFixedStepAlpha()        const { return m_fixed_step_alpha; }    // how far the frame is between the last two steps [0, 1]
+        void OnFixedStep()                    { m_fixed_step_index++; } // the engine calls it before each step
+        //=================================================================================================================
 
 	private:
+        // Sleeps until the given time, a high resolution timer (if available) keeps the error well under a millisecond
+        void SleepUntil(const std::chrono::high_resolution_clock::time_point& time);
+
         // Frame time
         std::chrono::high_resolution_clock::time_point m_time_start;
         std::chrono::high_resolution_clock::time_point m_time_frame_start;
@@ -70,12 +94,26 @@ namespace Spartan
 		double m_delta_time_ms          = 0.0f;
         double m_delta_time_smoothed_ms = 0.0f;
         double m_sleep_overhead         = 0.0f;
+        double m_delta_time_override_ms = 0.0;
+        double m_time_override_ms       = 0.0; // continues from the measured time when the override starts
+        void* m_waitable_timer          = nullptr;
 
         // FPS
         double m_fps_min                = 30.0;
         double m_fps_max                = 1000.0;
         double m_fps_target             = m_fps_max;
+        double m_fps_idle               = 20.0;
         bool m_user_selected_fps_target = false;
         FPS_Policy m_fps_policy         = Fps_Unlocked;
+        Renderer* m_renderer            = nullptr;
+
+        // Fixed step
+        bool m_fixed_step_enabled       = false;
+        double m_fixed_step_ms          = 1000.0 / 60.0;
+        double m_fixed_step_accumulator = 0.0;
+        uint32_t m_fixed_step_count     = 0;
+        uint32_t m_fixed_step_max       = 8; // per frame, the time beyond that is dropped so that a slow frame doesn't cause even slower ones
+        uint64_t m_fixed_step_index     = 0;
+        float m_fixed_step_alpha        = 1.0f;
 	};
 }
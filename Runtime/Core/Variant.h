@@ -29,6 +29,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Math/Matrix.h"
 #include "EngineDefs.h"
 #include <variant>
+#include <vector>
+#include <memory>
+#include <type_traits>
 //=============================
 
 //= FORWARD DECLARATIONS =
@@ -38,28 +41,52 @@ namespace Spartan
 }
 //========================
 
-#define _VARIANT_TYPES								\
-	char,											\
-	unsigned char,									\
-	int,											\
-	uint32_t,									    \
-	bool,											\
-	float,											\
-	double,											\
-	void*,											\
-	Spartan::Entity*,								\
-	std::shared_ptr<Spartan::Entity>,				\
-	std::weak_ptr<Spartan::Entity>,					\
-	std::vector<std::weak_ptr<Spartan::Entity>>,	\
-	std::vector<std::shared_ptr<Spartan::Entity>>,	\
-	Spartan::Math::Vector2,							\
-	Spartan::Math::Vector3,							\
-	Spartan::Math::Vector4,							\
-	Spartan::Math::Matrix,							\
+namespace Spartan
+{
+    // A non-owning view of contiguous elements, so that bulk data can travel in a Variant without being copied.
+    // Firing an event is blocking, so what a view points to outlives the subscribers, but it can't be queued (see EventSystem::FireDeferred()).
+    template <typename T>
+    class Span
+    {
+    public:
+        Span() = default;
+        Span(const T* data, size_t size) : m_data(data), m_size(size) {}
+        Span(const std::vector<T>& vector) : m_data(vector.data()), m_size(vector.size()) {}
+
+        const T* begin()                    const { return m_data; }
+        const T* end()                      const { return m_data + m_size; }
+        const T& operator[](size_t index)   const { return m_data[index]; }
+        const T* data()                     const { return m_data; }
+        size_t size()                       const { return m_size; }
+        bool empty()                        const { return m_size == 0; }
+
+    private:
+        const T* m_data = nullptr;
+        size_t m_size   = 0;
+    };
+}
+
+// Nothing in here allocates, the largest type is a matrix (bulk data travels as a Span)
+#define _VARIANT_TYPES								    \
+	char,											    \
+	unsigned char,									    \
+	int,											    \
+	uint32_t,									        \
+	bool,											    \
+	float,											    \
+	double,											    \
+	void*,											    \
+	Spartan::Entity*,								    \
+	std::shared_ptr<Spartan::Entity>,				    \
+	std::weak_ptr<Spartan::Entity>,					    \
+	Spartan::Span<std::shared_ptr<Spartan::Entity>>,	\
+	Spartan::Math::Vector2,							    \
+	Spartan::Math::Vector3,							    \
+	Spartan::Math::Vector4,							    \
+	Spartan::Math::Matrix,							    \
 	Spartan::Math::Quaternion
 
-#define VARIANT_TYPES std::variant<_VARIANT_TYPES>
-typedef std::variant<_VARIANT_TYPES, VARIANT_TYPES> VariantInternal;
+typedef std::variant<_VARIANT_TYPES> VariantInternal;
 
 namespace Spartan
 {
@@ -70,26 +97,28 @@ namespace Spartan
 		Variant() = default;
         ~Variant() = default;
 
-        // Copy constructor 1
-		Variant(const Variant& var){ m_variant = var.GetVariantRaw(); }
-		// Copy constructor 2
-		template <class T, class = std::enable_if<!std::is_same<T, Variant>::value>>
-		Variant(T value) { m_variant = value; }
+        // Copy and move
+		Variant(const Variant& var)             = default;
+		Variant(Variant&& var)                  = default;
+		Variant& operator =(const Variant& rhs) = default;
+		Variant& operator =(Variant&& rhs)      = default;
+
+		// From any of the types, constructed in place
+		template <class T, class = std::enable_if_t<!std::is_same_v<std::decay_t<T>, Variant>>>
+		Variant(T&& value) : m_variant(std::forward<T>(value)) {}
 
-		// Assignment operator 1
-		Variant& operator =(const Variant& rhs);
-		// Assignment operator 2
-		template <class T, class = std::enable_if<!std::is_same<T, Variant>::value>>
-		Variant& operator =(T rhs) { return m_variant = rhs; }
+		template <class T, class = std::enable_if_t<!std::is_same_v<std::decay_t<T>, Variant>>>
+		Variant& operator =(T&& rhs) { m_variant = std::forward<T>(rhs); return *this; }
 
 		const VariantInternal& GetVariantRaw() const { return m_variant; }
 
 		template<class T>
 		inline const T& Get() const { return std::get<T>(m_variant); }
 
+		template<class T>
+		inline bool Is() const { return std::holds_alternative<T>(m_variant); }
+
 	private:
 		VariantInternal m_variant;
 	};
-
-	
 }
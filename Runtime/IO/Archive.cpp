@@ -0,0 +1,465 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ====================
+#include "Archive.h"
+#include <filesystem>
+#include <fstream>
+#include <shared_mutex>
+#include <algorithm>
+#include <cstring>
+#include "FileStream.h"
+#include "../Core/FileSystem.h"
+#include "../Logging/Log.h"
+//===============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace _Archive
+{
+	// Layout: header (magic, version, entry count, toc offset) | entries, aligned | toc (path, offset, stored size, size, compression)
+	static const uint32_t magic			= 0x52415053; // "SPAR"
+	static const uint32_t version		= 1;
+	static const uint64_t header_size	= sizeof(uint32_t) * 3 + sizeof(uint64_t);
+
+	// Compressing is only worth it (decompressing instead of reading in place) if the entry shrinks to this much of its size
+	static const double compression_ratio_max = 0.75;
+
+	static vector<unique_ptr<Spartan::Archive>> archives;
+	static shared_mutex archives_mutex;
+
+	//= LZ4 BLOCK FORMAT ================================================================================================
+	// A sequence is a token (literal length << 4 | match length - 4), the literals, a 2 byte offset and the match.
+	// Lengths of 15 and more continue in bytes of 255 and a remainder. The last sequence has literals only,
+	// and (for the decoders which copy in wide steps) the last match starts 12 bytes, and ends 5 bytes, before the end.
+	static const uint32_t lz4_hash_bits		= 16;
+	static const size_t lz4_match_min		= 4;
+	static const size_t lz4_offset_max		= 65535;
+	static const size_t lz4_match_last		= 12;
+	static const size_t lz4_literals_last	= 5;
+
+	static void lz4_write_length(string& output, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+		{
+			output.push_back(static_cast<char>(255));
+		}
+		output.push_back(static_cast<char>(length));
+	}
+
+	static void lz4_write_sequence(string& output, const uint8_t* literals, const size_t literal_length, const size_t offset, const size_t match_length)
+	{
+		const size_t match_code = match_length != 0 ? match_length - lz4_match_min : 0;
+		output.push_back(static_cast<char>(((literal_length < 15 ? literal_length : 15) << 4) | (match_code < 15 ? match_code : 15)));
+
+		if (literal_length >= 15)
+		{
+			lz4_write_length(output, literal_length - 15);
+		}
+		output.append(reinterpret_cast<const char*>(literals), literal_length);
+
+		if (match_length == 0)
+			return;
+
+		output.push_back(static_cast<char>(offset & 0xFF));
+		output.push_back(static_cast<char>(offset >> 8));
+		if (match_code >= 15)
+		{
+			lz4_write_length(output, match_code - 15);
+		}
+	}
+
+	static string lz4_compress(const uint8_t* input, const size_t size)
+	{
+		string output;
+		output.reserve(size / 2 + 16);
+
+		vector<uint32_t> table(size_t(1) << lz4_hash_bits, 0);
+		const size_t match_start_end	= size > lz4_match_last ? size - lz4_match_last : 0;
+		const size_t match_end			= size > lz4_literals_last ? size - lz4_literals_last : 0;
+		size_t anchor					= 0;
+		size_t position					= 0;
+
+		while (position < match_start_end)
+		{
+			uint32_t sequence = 0;
+			memcpy(&sequence, input + position, sizeof(uint32_t));
+			const uint32_t hash		= (sequence * 2654435761u) >> (32 - lz4_hash_bits);
+			const size_t candidate	= table[hash];
+			table[hash]				= static_cast<uint32_t>(position);
+
+			uint32_t sequence_candidate = 0;
+			memcpy(&sequence_candidate, input + candidate, sizeof(uint32_t));
+			if (candidate >= position || position - candidate > lz4_offset_max || sequence_candidate != sequence)
+			{
+				position++;
+				continue;
+			}
+
+			size_t match_length = lz4_match_min;
+			while (position + match_length < match_end && input[candidate + match_length] == input[position + match_length])
+			{
+				match_length++;
+			}
+
+			lz4_write_sequence(output, input + anchor, position - anchor, position - candidate, match_length);
+			position	+= match_length;
+			anchor		= position;
+		}
+
+		lz4_write_sequence(output, input + anchor, size - anchor, 0, 0);
+		return output;
+	}
+
+	static bool lz4_read_length(const uint8_t*& input, const uint8_t* input_end, size_t& length)
+	{
+		uint8_t byte = 255;
+		while (byte == 255)
+		{
+			if (input >= input_end)
+				return false;
+
+			byte	= *input++;
+			length	+= byte;
+		}
+
+		return true;
+	}
+
+	static bool lz4_decompress(const uint8_t* input, const size_t input_size, uint8_t* output, const size_t output_size)
+	{
+		const uint8_t* input_end	= input + input_size;
+		uint8_t* const output_start	= output;
+		uint8_t* const output_end	= output + output_size;
+
+		while (input < input_end)
+		{
+			const uint8_t token = *input++;
+
+			// Literals
+			size_t literal_length = token >> 4;
+			if (literal_length == 15 && !lz4_read_length(input, input_end, literal_length))
+				return false;
+
+			if (literal_length > static_cast<size_t>(input_end - input) || literal_length > static_cast<size_t>(output_end - output))
+				return false;
+
+			memcpy(output, input, literal_length);
+			input	+= literal_length;
+			output	+= literal_length;
+
+			// The last sequence has no match
+			if (input == input_end)
+				break;
+
+			// Match
+			if (input_end - input < 2)
+				return false;
+
+			const size_t offset = static_cast<size_t>(input[0]) | (static_cast<size_t>(input[1]) << 8);
+			input += 2;
+			if (offset == 0 || offset > static_cast<size_t>(output - output_start))
+				return false;
+
+			size_t match_length = token & 15;
+			if (match_length == 15 && !lz4_read_length(input, input_end, match_length))
+				return false;
+
+			match_length += lz4_match_min;
+			if (match_length > static_cast<size_t>(output_end - output))
+				return false;
+
+			// Byte by byte, a match can overlap the bytes it produces
+			const uint8_t* match = output - offset;
+			for (size_t i = 0; i < match_length; i++)
+			{
+				output[i] = match[i];
+			}
+			output += match_length;
+		}
+
+		return output == output_end;
+	}
+	//===================================================================================================================
+}
+
+namespace Spartan
+{
+	Archive::~Archive()
+	{
+		m_entries.clear();
+		m_file.reset();
+	}
+
+	bool Archive::Mount(const string& path)
+	{
+		// Opened before the lock is taken, the stream looks up the mounted archives too
+		auto archive = make_unique<Archive>();
+		if (!archive->Open(path))
+			return false;
+
+		unique_lock<shared_mutex> lock(_Archive::archives_mutex);
+		LOG_INFO("Mounted \"%s\" (%d files)", path.c_str(), static_cast<int>(archive->m_entries.size()));
+		_Archive::archives.emplace_back(move(archive));
+
+		return true;
+	}
+
+	void Archive::UnmountAll()
+	{
+		unique_lock<shared_mutex> lock(_Archive::archives_mutex);
+		_Archive::archives.clear();
+	}
+
+	bool Archive::Exists(const string& path)
+	{
+		shared_lock<shared_mutex> lock(_Archive::archives_mutex);
+		if (_Archive::archives.empty())
+			return false;
+
+		const string key = GetKey(path);
+		for (const auto& archive : _Archive::archives)
+		{
+			if (archive->m_entries.count(key))
+				return true;
+		}
+
+		return false;
+	}
+
+	bool Archive::Read(const string& path, const std::byte** data, size_t* size, string* storage)
+	{
+		shared_lock<shared_mutex> lock(_Archive::archives_mutex);
+		if (_Archive::archives.empty())
+			return false;
+
+		const string key = GetKey(path);
+		for (const auto& archive : _Archive::archives)
+		{
+			const auto it = archive->m_entries.find(key);
+			if (it != archive->m_entries.end())
+				return archive->ReadEntry(it->second, data, size, storage);
+		}
+
+		return false;
+	}
+
+	bool Archive::Build(const string& directory, const string& archive_path, const bool compress /*= true*/)
+	{
+		if (!FileSystem::IsDirectory(directory))
+		{
+			LOG_ERROR("\"%s\" is not a directory", directory.c_str());
+			return false;
+		}
+
+		// Gather the engine files, sorted so that the same files always produce the same archive
+		vector<string> file_paths;
+		for (const auto& it : filesystem::recursive_directory_iterator(directory))
+		{
+			if (!it.is_regular_file())
+				continue;
+
+			const string file_path = it.path().string();
+			if (FileSystem::IsEngineFile(file_path) && FileSystem::GetExtensionFromFilePath(file_path) != EXTENSION_ARCHIVE)
+			{
+				file_paths.emplace_back(file_path);
+			}
+		}
+		sort(file_paths.begin(), file_paths.end());
+
+		ofstream file(archive_path, ios::out | ios::binary | ios::trunc);
+		if (!file.is_open())
+		{
+			LOG_ERROR("Failed to open \"%s\" for writing", archive_path.c_str());
+			return false;
+		}
+
+		// The header is written again once the toc offset is known
+		uint64_t offset = _Archive::header_size;
+		file.write(string(static_cast<size_t>(offset), '\0').data(), offset);
+
+		vector<pair<string, Entry>> entries;
+		entries.reserve(file_paths.size());
+		string contents;
+		uint64_t size_total	= 0;
+		for (const string& file_path : file_paths)
+		{
+			// Read straight from the disk, a stream would read a mounted archive's copy
+			ifstream input(file_path, ios::in | ios::binary | ios::ate);
+			if (!input.is_open())
+			{
+				LOG_WARNING("Failed to read \"%s\", skipping", file_path.c_str());
+				continue;
+			}
+			contents.resize(static_cast<size_t>(input.tellg()));
+			input.seekg(0, ios::beg);
+			input.read(contents.data(), contents.size());
+
+			Entry entry;
+			entry.size = contents.size();
+
+			string compressed;
+			if (compress && !contents.empty())
+			{
+				compressed = _Archive::lz4_compress(reinterpret_cast<const uint8_t*>(contents.data()), contents.size());
+			}
+			const bool is_compressed	= !compressed.empty() && compressed.size() <= static_cast<size_t>(contents.size() * _Archive::compression_ratio_max);
+			const string& stored		= is_compressed ? compressed : contents;
+
+			// Align
+			const uint64_t padding = (archive_entry_alignment - offset % archive_entry_alignment) % archive_entry_alignment;
+			file.write(string(static_cast<size_t>(padding), '\0').data(), padding);
+			offset += padding;
+
+			entry.offset		= offset;
+			entry.size_stored	= stored.size();
+			entry.compression	= is_compressed ? Archive_Compression_Lz4 : Archive_Compression_None;
+			file.write(stored.data(), stored.size());
+			offset		+= stored.size();
+			size_total	+= entry.size;
+
+			entries.emplace_back(GetKey(file_path), entry);
+		}
+
+		// Table of contents
+		const uint64_t toc_offset = offset;
+		for (const auto& entry : entries)
+		{
+			const auto path_length = static_cast<uint32_t>(entry.first.size());
+			const auto compression = static_cast<uint32_t>(entry.second.compression);
+			file.write(reinterpret_cast<const char*>(&path_length), sizeof(path_length));
+			file.write(entry.first.data(), path_length);
+			file.write(reinterpret_cast<const char*>(&entry.second.offset), sizeof(uint64_t));
+			file.write(reinterpret_cast<const char*>(&entry.second.size_stored), sizeof(uint64_t));
+			file.write(reinterpret_cast<const char*>(&entry.second.size), sizeof(uint64_t));
+			file.write(reinterpret_cast<const char*>(&compression), sizeof(uint32_t));
+		}
+
+		// Header
+		const auto entry_count = static_cast<uint32_t>(entries.size());
+		file.seekp(0, ios::beg);
+		file.write(reinterpret_cast<const char*>(&_Archive::magic), sizeof(uint32_t));
+		file.write(reinterpret_cast<const char*>(&_Archive::version), sizeof(uint32_t));
+		file.write(reinterpret_cast<const char*>(&entry_count), sizeof(uint32_t));
+		file.write(reinterpret_cast<const char*>(&toc_offset), sizeof(uint64_t));
+
+		const bool result = file.good();
+		file.close();
+
+		LOG_INFO("Packed %d files into \"%s\", %d KB from %d KB", static_cast<int>(entries.size()), archive_path.c_str(), static_cast<int>(toc_offset / 1024), static_cast<int>(size_total / 1024));
+		return result;
+	}
+
+	bool Archive::Open(const string& path)
+	{
+		m_file = make_unique<FileStream>(path, FileStream_Read | FileStream_Mapped);
+		if (!m_file->IsOpen())
+			return false;
+
+		const auto magic		= m_file->ReadAs<uint32_t>();
+		const auto version		= m_file->ReadAs<uint32_t>();
+		const auto entry_count	= m_file->ReadAs<uint32_t>();
+		const auto toc_offset	= m_file->ReadAs<uint64_t>();
+		if (magic != _Archive::magic || version != _Archive::version || toc_offset < _Archive::header_size)
+		{
+			LOG_ERROR("\"%s\" is not an archive (or it's of an unsupported version)", path.c_str());
+			return false;
+		}
+
+		// The entries are read in place, the toc follows them
+		const std::byte* entries = m_file->ReadSpan(static_cast<size_t>(toc_offset - _Archive::header_size));
+		if (!entries)
+		{
+			LOG_ERROR("\"%s\" is truncated", path.c_str());
+			return false;
+		}
+		m_data		= entries - _Archive::header_size;
+		m_data_size	= toc_offset;
+
+		m_entries.reserve(entry_count);
+		for (uint32_t i = 0; i < entry_count; i++)
+		{
+			string key;
+			Entry entry;
+			m_file->Read(&key);
+			m_file->Read(&entry.offset);
+			m_file->Read(&entry.size_stored);
+			m_file->Read(&entry.size);
+			entry.compression = static_cast<Archive_Compression>(m_file->ReadAs<uint32_t>());
+
+			if (entry.offset < _Archive::header_size || entry.offset + entry.size_stored > m_data_size)
+			{
+				LOG_ERROR("\"%s\" has an invalid entry (\"%s\")", path.c_str(), key.c_str());
+				return false;
+			}
+
+			m_entries[key] = entry;
+		}
+
+		m_path = path;
+		return true;
+	}
+
+	bool Archive::ReadEntry(const Entry& entry, const std::byte** data, size_t* size, string* storage) const
+	{
+		const std::byte* stored = m_data + entry.offset;
+
+		if (entry.compression == Archive_Compression_None)
+		{
+			*data = stored;
+			*size = static_cast<size_t>(entry.size);
+			return true;
+		}
+
+		if (entry.compression == Archive_Compression_Lz4)
+		{
+			storage->resize(static_cast<size_t>(entry.size));
+			if (!_Archive::lz4_decompress(reinterpret_cast<const uint8_t*>(stored), static_cast<size_t>(entry.size_stored), reinterpret_cast<uint8_t*>(storage->data()), storage->size()))
+			{
+				LOG_ERROR("Failed to decompress an entry of \"%s\"", m_path.c_str());
+				storage->clear();
+				return false;
+			}
+
+			*data = reinterpret_cast<const std::byte*>(storage->data());
+			*size = storage->size();
+			return true;
+		}
+
+		LOG_ERROR("Unknown compression in \"%s\"", m_path.c_str());
+		return false;
+	}
+
+	string Archive::GetKey(const string& path)
+	{
+		string key = FileSystem::GetRelativePath(path);
+		replace(key.begin(), key.end(), '\\', '/');
+
+		if (key.rfind("./", 0) == 0)
+		{
+			key.erase(0, 2);
+		}
+
+		return key;
+	}
+}
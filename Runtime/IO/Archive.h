@@ -0,0 +1,86 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../Core/EngineDefs.h"
+//=============================
+
+namespace Spartan
+{
+	class FileStream;
+
+	// Entries start at multiples of this, so the ones which are stored as is can be uploaded straight from the mapping
+	constexpr uint64_t archive_entry_alignment = 16;
+
+	enum Archive_Compression : uint32_t
+	{
+		Archive_Compression_None,
+		Archive_Compression_Lz4 // lz4 block format
+	};
+
+	// Many files packed into one, which is mapped once and indexed by a table of contents.
+	// While an archive is mounted, FileSystem::Exists()/IsFile() and FileStream look in it before they go to
+	// the disk, so engine files (worlds, models, textures, materials, etc.) load from it transparently.
+	// Files which third party importers open by themselves (images, fonts, foreign models) can't be read from an archive.
+	class SPARTAN_CLASS Archive
+	{
+	public:
+		Archive() = default;
+		~Archive();
+
+		// Mounted archives are searched in mount order, they stay mapped until they are unmounted (which any open stream of theirs must outlive)
+		static bool Mount(const std::string& path);
+		static void UnmountAll();
+
+		// Lookups across the mounted archives
+		static bool Exists(const std::string& path);
+		// Stored entries point into the mapping, compressed ones are decompressed into storage
+		static bool Read(const std::string& path, const std::byte** data, size_t* size, std::string* storage);
+
+		// Packs every engine file in a directory (and its sub-directories), their paths are kept relative to the working directory (like resource paths)
+		static bool Build(const std::string& directory, const std::string& archive_path, bool compress = true);
+
+	private:
+		struct Entry
+		{
+			uint64_t offset					= 0;
+			uint64_t size_stored			= 0;
+			uint64_t size					= 0;
+			Archive_Compression compression	= Archive_Compression_None;
+		};
+
+		bool Open(const std::string& path);
+		bool ReadEntry(const Entry& entry, const std::byte** data, size_t* size, std::string* storage) const;
+		static std::string GetKey(const std::string& path);
+
+		std::string m_path;
+		std::unique_ptr<FileStream> m_file;
+		const std::byte* m_data	= nullptr; // the start of the file
+		uint64_t m_data_size	= 0;
+		std::unordered_map<std::string, Entry> m_entries;
+	};
+}
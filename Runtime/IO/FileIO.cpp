@@ -0,0 +1,439 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ====================
+#include "FileIO.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "Archive.h"
+#include "../Core/Context.h"
+#include "../Logging/Log.h"
+#include "../Profiling/Profiler.h"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+//===============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace _FileIO
+{
+    // The innermost FileIO_Scope of the thread
+    static thread_local const Spartan::FileIO_Scope* scope = nullptr;
+
+#if defined(_WIN32)
+    // An overlapped operation, the completion port hands back the OVERLAPPED so it has to come first
+    struct Chunk
+    {
+        OVERLAPPED overlapped   = {};
+        void* read              = nullptr;
+        DWORD size              = 0;
+    };
+#endif
+}
+
+namespace Spartan
+{
+    FileIO::FileIO(Context* context) : ISubsystem(context)
+    {
+
+    }
+
+    FileIO::~FileIO()
+    {
+        m_stopping = true;
+
+    #if defined(_WIN32)
+        if (m_completion_port)
+        {
+            PostQueuedCompletionStatus(m_completion_port, 0, 0, nullptr);
+        }
+    #endif
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_condition_requests.notify_one();
+        }
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+    #if defined(_WIN32)
+        if (m_completion_port)
+        {
+            CloseHandle(m_completion_port);
+            m_completion_port = nullptr;
+        }
+    #endif
+    }
+
+    bool FileIO::Initialize()
+    {
+        m_threading = m_context->GetSubsystem<Threading>();
+
+    #if defined(_WIN32)
+        // A single thread dequeues the completions
+        m_completion_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+        if (!m_completion_port)
+        {
+            LOG_WARNING("Failed to create an I/O completion port, files will be read one at a time");
+        }
+    #endif
+
+        m_thread = thread(&FileIO::ThreadLoop, this);
+
+        return true;
+    }
+
+    void FileIO::ReadAsync(const string& path, FileIO_Callback&& callback, const uint64_t offset, const uint64_t size, const Threading_Pool pool)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            Request& request    = m_requests.emplace_back();
+            request.path        = path;
+            request.offset      = offset;
+            request.size        = size;
+            request.pool        = pool;
+            request.callback    = move(callback);
+            m_pending++;
+            m_condition_requests.notify_one();
+        }
+
+        // Wake the I/O thread up, it waits on the completion port
+    #if defined(_WIN32)
+        if (m_completion_port)
+        {
+            PostQueuedCompletionStatus(m_completion_port, 0, 0, nullptr);
+        }
+    #endif
+    }
+
+    void FileIO::WaitIdle()
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_condition_idle.wait(lock, [this]() { return m_pending.load() == 0; });
+    }
+
+    void FileIO::ThreadLoop()
+    {
+        while (true)
+        {
+            // Pick up the new requests
+            vector<Request> requests;
+            {
+                unique_lock<mutex> lock(m_mutex);
+                if (!m_completion_port)
+                {
+                    m_condition_requests.wait(lock, [this]() { return !m_requests.empty() || m_stopping; });
+                }
+                requests.swap(m_requests);
+            }
+            Coalesce(requests);
+
+            // Reads which didn't start yet are dropped when stopping, the ones in flight are waited for since the OS writes to their memory
+            if (m_stopping)
+            {
+                for (unique_ptr<Read>& read : m_reads_queued)
+                {
+                    read->failed = true;
+                    Complete(*read);
+                }
+                m_reads_queued.clear();
+            }
+
+            // Without a completion port, every read blocks this thread
+            if (!m_completion_port)
+            {
+                for (unique_ptr<Read>& read : m_reads_queued)
+                {
+                    read->failed = !ReadBlocking(*read);
+                    Complete(*read);
+                }
+                m_reads_queued.clear();
+
+                if (m_stopping)
+                    return;
+
+                continue;
+            }
+
+        #if defined(_WIN32)
+            // Keep as many operations in flight as allowed, a read issues all its chunks at once
+            while (!m_reads_queued.empty() && m_operations_in_flight < file_io_operations_in_flight)
+            {
+                unique_ptr<Read> read = move(m_reads_queued.front());
+                m_reads_queued.erase(m_reads_queued.begin());
+
+                Issue(*read);
+                if (read->chunks_pending == 0)
+                {
+                    Complete(*read);
+                }
+                else
+                {
+                    m_reads_in_flight.emplace_back(move(read));
+                }
+            }
+
+            if (m_stopping && m_reads_in_flight.empty())
+                return;
+
+            // Wait for an operation to complete, or for a wake up (which carries no operation)
+            DWORD bytes             = 0;
+            ULONG_PTR key           = 0;
+            OVERLAPPED* overlapped  = nullptr;
+            const BOOL result       = GetQueuedCompletionStatus(m_completion_port, &bytes, &key, &overlapped, INFINITE);
+            if (!overlapped)
+                continue;
+
+            _FileIO::Chunk* chunk   = reinterpret_cast<_FileIO::Chunk*>(overlapped);
+            Read* read              = static_cast<Read*>(chunk->read);
+            read->failed            |= !result || bytes != chunk->size;
+            read->chunks_pending--;
+            m_operations_in_flight--;
+            delete chunk;
+
+            if (read->chunks_pending == 0)
+            {
+                Complete(*read);
+                m_reads_in_flight.erase(remove_if(m_reads_in_flight.begin(), m_reads_in_flight.end(), [read](const unique_ptr<Read>& in_flight) { return in_flight.get() == read; }), m_reads_in_flight.end());
+            }
+        #endif
+        }
+    }
+
+    void FileIO::Coalesce(vector<Request>& requests)
+    {
+        if (requests.empty())
+            return;
+
+        // Requests of the same file next to each other, by offset
+        sort(requests.begin(), requests.end(), [](const Request& a, const Request& b)
+        {
+            return a.path != b.path ? a.path < b.path : a.offset < b.offset;
+        });
+
+        for (size_t group_start = 0; group_start < requests.size();)
+        {
+            size_t group_end = group_start + 1;
+            while (group_end < requests.size() && requests[group_end].path == requests[group_start].path)
+            {
+                group_end++;
+            }
+            const string& path = requests[group_start].path;
+
+            // Packed files are already in memory, they complete right away
+            const std::byte* packed = nullptr;
+            size_t packed_size      = 0;
+            string packed_storage;
+            const bool is_packed    = Archive::Read(path, &packed, &packed_size, &packed_storage);
+
+            uint64_t file_size = packed_size;
+            bool file_exists   = is_packed;
+            if (!is_packed)
+            {
+                error_code error;
+                file_size   = static_cast<uint64_t>(filesystem::file_size(path, error));
+                file_exists = !error;
+            }
+
+            // Ranges which go past the end of the file are clipped to it
+            for (size_t i = group_start; i < group_end; i++)
+            {
+                Request& request    = requests[i];
+                request.offset      = min(request.offset, file_size);
+                request.size        = request.size == 0 ? file_size - request.offset : min(request.size, file_size - request.offset);
+            }
+
+            if (!file_exists || is_packed)
+            {
+                Read read;
+                read.path   = path;
+                read.size   = file_size;
+                read.failed = !file_exists;
+                if (is_packed)
+                {
+                    read.data.assign(packed, packed + packed_size);
+                }
+                move(requests.begin() + group_start, requests.begin() + group_end, back_inserter(read.requests));
+
+                if (!file_exists)
+                {
+                    LOG_ERROR("\"%s\" doesn't exist.", path.c_str());
+                }
+
+                Complete(read);
+                group_start = group_end;
+                continue;
+            }
+
+            // Ranges which overlap, or are only a small gap apart, are read at once
+            Read* read = nullptr;
+            for (size_t i = group_start; i < group_end; i++)
+            {
+                Request& request = requests[i];
+                if (!read || request.offset > read->offset + read->size + file_io_coalesce_gap)
+                {
+                    read            = m_reads_queued.emplace_back(make_unique<Read>()).get();
+                    read->path      = path;
+                    read->offset    = request.offset;
+                }
+
+                read->size = max(read->offset + read->size, request.offset + request.size) - read->offset;
+                read->requests.emplace_back(move(request));
+            }
+
+            group_start = group_end;
+        }
+    }
+
+    void FileIO::Issue(Read& read)
+    {
+    #if defined(_WIN32)
+        Profiler::EventAdd("File I/O", read.path);
+
+        HANDLE file = CreateFileA(read.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE || !CreateIoCompletionPort(file, m_completion_port, 0, 0))
+        {
+            LOG_ERROR("Failed to open \"%s\" for reading", read.path.c_str());
+            if (file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(file);
+            }
+            read.failed = true;
+            return;
+        }
+        read.file = file;
+        read.data.resize(read.size);
+
+        for (uint64_t position = 0; position < read.size; position += file_io_chunk_size)
+        {
+            const uint64_t offset           = read.offset + position;
+            _FileIO::Chunk* chunk           = new _FileIO::Chunk();
+            chunk->read                     = &read;
+            chunk->size                     = static_cast<DWORD>(min(file_io_chunk_size, read.size - position));
+            chunk->overlapped.Offset        = static_cast<DWORD>(offset & 0xFFFFFFFF);
+            chunk->overlapped.OffsetHigh    = static_cast<DWORD>(offset >> 32);
+
+            // The completion is queued to the port even if the read finishes right away
+            if (!ReadFile(file, read.data.data() + position, chunk->size, nullptr, &chunk->overlapped) && GetLastError() != ERROR_IO_PENDING)
+            {
+                read.failed = true;
+                delete chunk;
+                break;
+            }
+
+            read.chunks_pending++;
+            m_operations_in_flight++;
+        }
+    #else
+        read.failed = !ReadBlocking(read);
+    #endif
+    }
+
+    void FileIO::Complete(Read& read)
+    {
+    #if defined(_WIN32)
+        if (read.file)
+        {
+            CloseHandle(static_cast<HANDLE>(read.file));
+            read.file = nullptr;
+        }
+    #endif
+
+        // Every request gets its range, a read which serves a single request gives it the data as is
+        const bool success = !read.failed;
+        for (Request& request : read.requests)
+        {
+            vector<std::byte> data;
+            if (success)
+            {
+                const uint64_t start = request.offset - read.offset;
+                if (read.requests.size() == 1 && start == 0 && request.size == read.data.size())
+                {
+                    data = move(read.data);
+                }
+                else
+                {
+                    data.assign(read.data.begin() + start, read.data.begin() + start + request.size);
+                }
+            }
+
+            m_threading->AddTask([callback = move(request.callback), data = move(data), success]() mutable
+            {
+                callback(success, data);
+            }, {}, request.pool);
+        }
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_pending -= static_cast<uint32_t>(read.requests.size());
+        }
+        m_condition_idle.notify_all();
+    }
+
+    bool FileIO::ReadBlocking(Read& read)
+    {
+        Profiler::EventAdd("File I/O", read.path);
+
+        ifstream file(read.path, ios::binary);
+        if (!file.is_open())
+        {
+            LOG_ERROR("Failed to open \"%s\" for reading", read.path.c_str());
+            return false;
+        }
+
+        read.data.resize(read.size);
+        file.seekg(static_cast<streamoff>(read.offset));
+        file.read(reinterpret_cast<char*>(read.data.data()), static_cast<streamsize>(read.size));
+        return static_cast<uint64_t>(file.gcount()) == read.size;
+    }
+
+    FileIO_Scope::FileIO_Scope(const string& path, const vector<std::byte>& data) : m_path(path), m_data(data)
+    {
+        m_previous      = _FileIO::scope;
+        _FileIO::scope  = this;
+    }
+
+    FileIO_Scope::~FileIO_Scope()
+    {
+        _FileIO::scope = m_previous;
+    }
+
+    const FileIO_Scope* FileIO_Scope::Find(const string& path)
+    {
+        for (const FileIO_Scope* scope = _FileIO::scope; scope; scope = scope->m_previous)
+        {
+            if (scope->m_path == path)
+                return scope;
+        }
+
+        return nullptr;
+    }
+}
@@ -0,0 +1,134 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==========================
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Core/ISubsystem.h"
+#include "../Threading/Threading.h"
+//=====================================
+
+namespace Spartan
+{
+    // Reads of a file which are closer than this are coalesced into one, the gap is read and thrown away
+    constexpr uint64_t file_io_coalesce_gap         = 64 * 1024;
+    // Coalesced reads are issued in chunks of this size, every chunk is an overlapped operation of its own
+    constexpr uint64_t file_io_chunk_size           = 8 * 1024 * 1024;
+    // Overlapped operations which can be in flight at once
+    constexpr uint32_t file_io_operations_in_flight = 32;
+
+    // The result of a read, data is empty if the read failed (or the range was)
+    using FileIO_Callback = std::function<void(bool success, std::vector<std::byte>& data)>;
+
+    // Reads files on a thread of its own, so that the workers which need the data don't sit on the disk.
+    // Requests are queued from any thread, the I/O thread coalesces the ones which touch neighbouring ranges of the same file,
+    // keeps many reads in flight (overlapped I/O with a completion port on Windows, blocking reads elsewhere) and hands
+    // every result to a task on the pool the request asked for. Files in mounted archives are served without touching the disk.
+    class SPARTAN_CLASS FileIO : public ISubsystem
+    {
+    public:
+        FileIO(Context* context);
+        ~FileIO();
+
+        //= ISubsystem ======================
+        bool Initialize() override;
+        //===================================
+
+        // Reads size bytes (0 is up to the end of the file) from offset, the callback runs as a task on the pool once they are in
+        void ReadAsync(const std::string& path, FileIO_Callback&& callback, uint64_t offset = 0, uint64_t size = 0, Threading_Pool pool = Threading_Pool_Background);
+        // Blocks until every queued read has completed and its callback was scheduled
+        void WaitIdle();
+        // Reads which were queued but haven't completed yet
+        uint32_t GetPendingCount() const { return m_pending.load(); }
+
+    private:
+        struct Request
+        {
+            std::string path;
+            uint64_t offset = 0;
+            uint64_t size   = 0;
+            Threading_Pool pool;
+            FileIO_Callback callback;
+        };
+
+        // The requests of a file which are served by one read
+        struct Read
+        {
+            std::string path;
+            uint64_t offset = 0;
+            uint64_t size   = 0;
+            std::vector<Request> requests;
+            std::vector<std::byte> data;
+            void* file              = nullptr;
+            uint32_t chunks_pending = 0;
+            bool failed             = false;
+        };
+
+        void ThreadLoop();
+        void Coalesce(std::vector<Request>& requests);
+        void Issue(Read& read);
+        void Complete(Read& read);
+        static bool ReadBlocking(Read& read);
+
+        Threading* m_threading = nullptr;
+        std::thread m_thread;
+        std::atomic<bool> m_stopping    = false;
+        std::atomic<uint32_t> m_pending = 0;
+
+        // Requests which the I/O thread hasn't picked up yet
+        std::vector<Request> m_requests;
+        std::mutex m_mutex;
+        std::condition_variable m_condition_idle;
+        std::condition_variable m_condition_requests; // where overlapped I/O isn't available
+
+        // Owned by the I/O thread
+        std::vector<std::unique_ptr<Read>> m_reads_queued;
+        std::vector<std::unique_ptr<Read>> m_reads_in_flight;
+        uint32_t m_operations_in_flight = 0;
+        void* m_completion_port         = nullptr;
+    };
+
+    // While one is alive, a FileStream which reads its path on the same thread reads the data instead of the disk.
+    // The data outlives the scope, so streams of the path have to be closed before it ends (see ResourceCache::LoadAsync()).
+    class SPARTAN_CLASS FileIO_Scope
+    {
+    public:
+        FileIO_Scope(const std::string& path, const std::vector<std::byte>& data);
+        ~FileIO_Scope();
+
+        // The innermost scope of the calling thread which holds the path, nullptr if there is none
+        static const FileIO_Scope* Find(const std::string& path);
+        const std::vector<std::byte>& GetData() const { return m_data; }
+
+    private:
+        std::string m_path;
+        const std::vector<std::byte>& m_data;
+        const FileIO_Scope* m_previous = nullptr;
+    };
+}
@@ -19,10 +19,20 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+
 //= INCLUDES =================
 #include "FileStream.h"
+#include "Archive.h"
+#include "FileIO.h"
 #include "../Logging/Log.h"
 #include "../RHI/RHI_Vertex.h"
+#include "../Profiling/Profiler.h"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
 //============================
 
 //= NAMESPACES =====
@@ -36,6 +46,8 @@ namespace Spartan
 		m_is_open	= false;
 		m_flags		= flags;
 
+		Profiler::EventAdd("File I/O", path);
+
 		int ios_flags	= ios::binary;
 		ios_flags		|= (flags & FileStream_Read)	? ios::in	: 0;
 		ios_flags		|= (flags & FileStream_Write)	? ios::out	: 0;
@@ -49,20 +61,81 @@ namespace Spartan
 				LOG_ERROR("Failed to open \"%s\" for writing", path.c_str());
 				return;
 			}
+
+			m_write_to_file = true;
+			m_write_buffer.reserve(file_stream_write_buffer_size);
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.open(path, ios_flags);
-			if(in.fail())
+			// Files which the I/O thread already read are read from its data
+			if (const FileIO_Scope* scope = FileIO_Scope::Find(path))
+			{
+				m_read_from_memory	= true;
+				m_read_cursor		= reinterpret_cast<const char*>(scope->GetData().data());
+				m_read_end			= m_read_cursor + scope->GetData().size();
+				m_is_open			= true;
+				return;
+			}
+
+			// Packed files are read from their archive's mapping (or decompressed into memory)
+			const std::byte* packed	= nullptr;
+			size_t packed_size		= 0;
+			if (Archive::Read(path, &packed, &packed_size, &m_read_buffer))
 			{
-				LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
+				m_read_from_memory	= true;
+				m_read_cursor		= reinterpret_cast<const char*>(packed);
+				m_read_end			= m_read_cursor + packed_size;
+				m_is_open			= true;
 				return;
 			}
+
+			// Mapping can fail (e.g. for files on some network drives), the whole file is read instead
+			const bool in_memory = ((m_flags & FileStream_Mapped) && Map(path)) || ((m_flags & (FileStream_Mapped | FileStream_Memory)) && ReadWhole(path));
+
+			if (!in_memory)
+			{
+				in.open(path, ios_flags);
+				if (in.fail())
+				{
+					LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
+					return;
+				}
+			}
 		}
 
 		m_is_open = true;
 	}
 
+	FileStream::FileStream(string* memory, uint32_t flags)
+	{
+		m_flags		= flags;
+		m_is_open	= memory != nullptr;
+
+		if (!memory)
+			return;
+
+		if (m_flags & FileStream_Write)
+		{
+			memory->clear();
+			m_write_target = memory;
+		}
+		else if (m_flags & FileStream_Read)
+		{
+			m_read_from_memory	= true;
+			m_read_cursor		= memory->data();
+			m_read_end			= memory->data() + memory->size();
+		}
+	}
+
+	FileStream::FileStream(const std::byte* data, const size_t size)
+	{
+		m_flags				= FileStream_Read;
+		m_is_open			= data != nullptr || size == 0;
+		m_read_from_memory	= true;
+		m_read_cursor		= reinterpret_cast<const char*>(data);
+		m_read_end			= m_read_cursor + (data ? size : 0);
+	}
+
 	FileStream::~FileStream()
 	{
 		Close();
@@ -72,14 +145,116 @@ namespace Spartan
 	{
 		if (m_flags & FileStream_Write)
 		{
-			out.flush();
-			out.close();
+			Flush();
+			m_write_target = &m_write_buffer;
+
+			if (m_write_to_file)
+			{
+				out.flush();
+				out.close();
+				m_write_to_file = false;
+			}
 		}
 		else if (m_flags & FileStream_Read)
 		{
 			in.clear();
 			in.close();
+			Unmap();
+			m_read_buffer		= string();
+			m_read_from_memory	= false;
+			m_read_cursor		= nullptr;
+			m_read_end			= nullptr;
+		}
+	}
+
+	void FileStream::Flush()
+	{
+		if (!m_write_to_file || m_write_buffer.empty())
+			return;
+
+		out.write(m_write_buffer.data(), m_write_buffer.size());
+		m_write_buffer.clear();
+	}
+
+	bool FileStream::Map(const string& path)
+	{
+	#if defined(_WIN32)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size = {};
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		// Empty files can't be mapped, but there is nothing to read anyway
+		if (size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			m_read_from_memory = true;
+			return true;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_map_file			= file;
+		m_map_mapping		= mapping;
+		m_map_view			= view;
+		m_read_from_memory	= true;
+		m_read_cursor		= static_cast<const char*>(view);
+		m_read_end			= m_read_cursor + static_cast<size_t>(size.QuadPart);
+		return true;
+	#else
+		return false;
+	#endif
+	}
+
+	bool FileStream::ReadWhole(const string& path)
+	{
+		ifstream file(path, ios::in | ios::binary | ios::ate);
+		if (!file.is_open())
+			return false;
+
+		m_read_buffer.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0, ios::beg);
+		if (!m_read_buffer.empty() && !file.read(&m_read_buffer[0], m_read_buffer.size()))
+		{
+			m_read_buffer = string();
+			return false;
 		}
+
+		m_read_from_memory	= true;
+		m_read_cursor		= m_read_buffer.data();
+		m_read_end			= m_read_buffer.data() + m_read_buffer.size();
+		return true;
+	}
+
+	void FileStream::Unmap()
+	{
+	#if defined(_WIN32)
+		if (m_map_view)		UnmapViewOfFile(m_map_view);
+		if (m_map_mapping)	CloseHandle(static_cast<HANDLE>(m_map_mapping));
+		if (m_map_file)		CloseHandle(static_cast<HANDLE>(m_map_file));
+	#endif
+		m_map_view		= nullptr;
+		m_map_mapping	= nullptr;
+		m_map_file		= nullptr;
 	}
 
 	void FileStream::Write(const string& value)
@@ -87,7 +262,7 @@ namespace Spartan
 		const auto length = static_cast<uint32_t>(value.length());
 		Write(length);
 
-		out.write(const_cast<char*>(value.c_str()), length);
+		WriteBytes(value.data(), length);
 	}
 
 	void FileStream::Write(const vector<string>& value)
@@ -105,28 +280,42 @@ namespace Spartan
 	{
 		const auto length = static_cast<uint32_t>(value.size());
 		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(RHI_Vertex_PosTexNorTan) * length);
+		WriteBytes(value.data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
+	}
+
+	void FileStream::Write(const vector<RHI_Vertex_Skin>& value)
+	{
+		const auto length = static_cast<uint32_t>(value.size());
+		Write(length);
+		WriteBytes(value.data(), sizeof(RHI_Vertex_Skin) * length);
+	}
+
+	void FileStream::Write(const vector<uint16_t>& value)
+	{
+		const auto length = static_cast<uint32_t>(value.size());
+		Write(length);
+		WriteBytes(value.data(), sizeof(uint16_t) * length);
 	}
 
 	void FileStream::Write(const vector<uint32_t>& value)
 	{
 		const auto length = static_cast<uint32_t>(value.size());
 		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(uint32_t) * length);
+		WriteBytes(value.data(), sizeof(uint32_t) * length);
 	}
 
 	void FileStream::Write(const vector<unsigned char>& value)
 	{
 		const auto size = static_cast<uint32_t>(value.size());
 		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(unsigned char) * size);
+		WriteBytes(value.data(), sizeof(unsigned char) * size);
 	}
 
 	void FileStream::Write(const vector<std::byte>& value)
 	{
 		const auto size = static_cast<uint32_t>(value.size());
 		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(std::byte) * size);
+		WriteBytes(value.data(), sizeof(std::byte) * size);
 	}
 
 	void FileStream::Skip(uint32_t n)
@@ -134,21 +323,46 @@ namespace Spartan
 		// Set the seek cursor to offset n from the current position
 		if (m_flags & FileStream_Write)
 		{
-			out.seekp(n, ios::cur);
+			if (m_write_to_file)
+			{
+				Flush();
+				out.seekp(n, ios::cur);
+			}
+			else
+			{
+				m_write_target->append(n, '\0');
+			}
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.ignore(n, ios::cur);
+			if (m_read_from_memory)
+			{
+				ReadSpan(n);
+			}
+			else
+			{
+				in.ignore(n);
+			}
 		}
 	}
 
+	const std::byte* FileStream::ReadSpan(const size_t size)
+	{
+		if (!m_read_from_memory || static_cast<size_t>(m_read_end - m_read_cursor) < size)
+			return nullptr;
+
+		const char* data = m_read_cursor;
+		m_read_cursor += size;
+		return reinterpret_cast<const std::byte*>(data);
+	}
+
 	void FileStream::Read(string* value)
 	{
 		uint32_t length = 0;
 		Read(&length);
 
 		value->resize(length);
-		in.read(const_cast<char*>(value->c_str()), length);
+		ReadBytes(&(*value)[0], length);
 	}
 
 	void FileStream::Read(vector<string>* vec)
@@ -183,7 +397,38 @@ namespace Spartan
 		vec->reserve(length);
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(RHI_Vertex_PosTexNorTan) * length);
+		ReadBytes(vec->data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
+	}
+
+	void FileStream::Read(vector<RHI_Vertex_Skin>* vec)
+	{
+		if (!vec)
+			return;
+
+		vec->clear();
+		vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+		vec->resize(length);
+
+		ReadBytes(vec->data(), sizeof(RHI_Vertex_Skin) * length);
+	}
+
+	void FileStream::Read(vector<uint16_t>* vec)
+	{
+		if (!vec)
+			return;
+
+		vec->clear();
+		vec->shrink_to_fit();
+
+        const auto length = ReadAs<uint32_t>();
+
+		vec->reserve(length);
+		vec->resize(length);
+
+		ReadBytes(vec->data(), sizeof(uint16_t) * length);
 	}
 
 	void FileStream::Read(vector<uint32_t>* vec)
@@ -199,7 +444,7 @@ namespace Spartan
 		vec->reserve(length);
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(uint32_t) * length);
+		ReadBytes(vec->data(), sizeof(uint32_t) * length);
 	}
 
 	void FileStream::Read(vector<unsigned char>* vec)
@@ -215,7 +460,7 @@ namespace Spartan
 		vec->reserve(length);
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(unsigned char) * length);
+		ReadBytes(vec->data(), sizeof(unsigned char) * length);
 	}
 
 	void FileStream::Read(vector<std::byte>* vec)
@@ -231,6 +476,6 @@ namespace Spartan
 		vec->reserve(length);
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(std::byte) * length);
+		ReadBytes(vec->data(), sizeof(std::byte) * length);
 	}
 }
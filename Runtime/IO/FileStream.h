@@ -24,32 +24,49 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===================
 #include <vector>
 #include <fstream>
+#include <cstring>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
 #include "../Math/Quaternion.h"
+#include "../Math/Matrix.h"
 #include "../Math/BoundingBox.h"
 //==============================
 
 namespace Spartan
 {
 	class Entity;
+	struct RHI_Vertex_Skin;
+
+	// Writes to files are buffered, the buffer goes to the file once it's this big (and on close)
+	constexpr size_t file_stream_write_buffer_size = 1024 * 1024;
 
 	enum FileStream_Mode : uint32_t
 	{
 		FileStream_Read		= 1 << 0,
 		FileStream_Write	= 1 << 1,
 		FileStream_Append	= 1 << 2,
+		FileStream_Memory	= 1 << 3, // reading only, the whole file is read on open, so the stream can be opened on one thread and read on another without touching the disk
+		FileStream_Mapped	= 1 << 4, // reading only, the file is mapped into memory and read straight out of it (falls back to FileStream_Memory where mapping fails)
 	};
 
 	class SPARTAN_CLASS FileStream
 	{
 	public:
 		FileStream(const std::string& path, uint32_t flags);
+		// Reads from, or writes to, a string instead of a file (reading doesn't copy it, so it has to outlive the stream)
+		FileStream(std::string* memory, uint32_t flags);
+		// Reads from memory which outlives the stream
+		FileStream(const std::byte* data, size_t size);
 		~FileStream();
 
+		FileStream(const FileStream&)				= delete;
+		FileStream& operator=(const FileStream&)	= delete;
+
 		auto IsOpen() const { return m_is_open; }
 		void Close();
+		// Writes any buffered data to the file
+		void Flush();
 
 		//= WRITING ==================================================
 		template <class T, class = typename std::enable_if<
@@ -72,16 +89,19 @@ namespace Spartan
 			std::is_same<T, Math::Vector3>::value		||
 			std::is_same<T, Math::Vector4>::value		||
 			std::is_same<T, Math::Quaternion>::value	||
+			std::is_same<T, Math::Matrix>::value		||
 			std::is_same<T, Math::BoundingBox>::value
 		>::type>
 		void Write(T value)
 		{
-			out.write(reinterpret_cast<char*>(&value), sizeof(value));
+			WriteBytes(&value, sizeof(value));
 		}
 
 		void Write(const std::string& value);
 		void Write(const std::vector<std::string>& value);
 		void Write(const std::vector<RHI_Vertex_PosTexNorTan>& value);
+		void Write(const std::vector<RHI_Vertex_Skin>& value);
+		void Write(const std::vector<uint16_t>& value);
 		void Write(const std::vector<uint32_t>& value);
 		void Write(const std::vector<unsigned char>& value);
 		void Write(const std::vector<std::byte>& value);
@@ -110,15 +130,18 @@ namespace Spartan
 			std::is_same<T, Math::Vector3>::value		||
 			std::is_same<T, Math::Vector4>::value		||
 			std::is_same<T, Math::Quaternion>::value	||
+			std::is_same<T, Math::Matrix>::value		||
 			std::is_same<T, Math::BoundingBox>::value
 		>::type>
 		void Read(T* value)
 		{
-			in.read(reinterpret_cast<char*>(value), sizeof(T));
+			ReadBytes(value, sizeof(T));
 		}
 		void Read(std::string* value);
 		void Read(std::vector<std::string>* vec);
 		void Read(std::vector<RHI_Vertex_PosTexNorTan>* vec);
+		void Read(std::vector<RHI_Vertex_Skin>* vec);
+		void Read(std::vector<uint16_t>* vec);
 		void Read(std::vector<uint32_t>* vec);
 		void Read(std::vector<unsigned char>* vec);
 		void Read(std::vector<std::byte>* vec);
@@ -149,12 +172,85 @@ namespace Spartan
 			Read(&value);
 			return value;
 		}
+
+		// Reading without a copy, for streams which read from memory (FileStream_Mapped, FileStream_Memory or memory of the caller).
+		// The returned data lives as long as the stream and isn't necessarily aligned, it's nullptr when there isn't enough data left.
+		const std::byte* ReadSpan(size_t size);
+		// Reads the element count of a vector of T and returns its elements
+		template <class T>
+		const T* ReadSpan(uint32_t* count)
+		{
+			*count = ReadAs<uint32_t>();
+			const std::byte* data = ReadSpan(static_cast<size_t>(*count) * sizeof(T));
+			if (!data)
+			{
+				*count = 0;
+			}
+
+			return reinterpret_cast<const T*>(data);
+		}
+		bool IsMemory() const { return m_read_from_memory; }
 		//=====================================================
 
 	private:
+		// Reads from memory are a pointer bump, any data past the end is left untouched (like a failed stream read)
+		void ReadBytes(void* destination, const size_t size)
+		{
+			if (!m_read_from_memory)
+			{
+				in.read(static_cast<char*>(destination), size);
+				return;
+			}
+
+			const size_t available = static_cast<size_t>(m_read_end - m_read_cursor);
+			const size_t count = size < available ? size : available;
+			if (count != 0)
+			{
+				memcpy(destination, m_read_cursor, count);
+				m_read_cursor += count;
+			}
+		}
+
+		void WriteBytes(const void* source, const size_t size)
+		{
+			// Big writes (like vertex or texture data) go straight to the file, there's no point in copying them to the buffer first
+			if (m_write_to_file && size >= file_stream_write_buffer_size)
+			{
+				Flush();
+				out.write(static_cast<const char*>(source), size);
+				return;
+			}
+
+			m_write_target->append(static_cast<const char*>(source), size);
+			if (m_write_to_file && m_write_buffer.size() >= file_stream_write_buffer_size)
+			{
+				Flush();
+			}
+		}
+
+		bool Map(const std::string& path);
+		bool ReadWhole(const std::string& path);
+		void Unmap();
+
+		// Files
 		std::ofstream out;
 		std::ifstream in;
-		uint32_t m_flags;
-		bool m_is_open;
+
+		// Reading from memory
+		bool m_read_from_memory			= false;
+		const char* m_read_cursor		= nullptr;
+		const char* m_read_end			= nullptr;
+		std::string m_read_buffer;		// the file, for FileStream_Memory
+		void* m_map_file				= nullptr;
+		void* m_map_mapping				= nullptr;
+		const void* m_map_view			= nullptr;
+
+		// Writing, through a buffer to a file or straight to a string
+		std::string m_write_buffer;
+		std::string* m_write_target		= &m_write_buffer;
+		bool m_write_to_file			= false;
+
+		uint32_t m_flags				= 0;
+		bool m_is_open					= false;
 	};
 }
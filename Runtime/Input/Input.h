@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==================
 #include <array>
+#include <mutex>
+#include <thread>
 #include "../Math/Vector2.h"
 #include "../Core/ISubsystem.h"
 //=============================
@@ -80,7 +82,7 @@ namespace Spartan
 	{
 	public:
 		Input(Context* context);
-        ~Input() = default;
+        ~Input();
 
         void OnWindowData();
 		//= ISubsystem ======================
@@ -96,6 +98,22 @@ namespace Spartan
 		const Math::Vector2& GetMousePosition() const	{ return m_mouse_position; }
 		const Math::Vector2& GetMouseDelta() const		{ return m_mouse_delta; }
 
+        // Raw mouse motion, in counts, accumulated by a dedicated thread as the device reports it (rather than once per tick).
+        // The motion of a tick is the difference of two readings, so anything which runs later in the frame (e.g. the renderer
+        // late-latching the camera) can pick up the motion which arrived after the tick.
+        struct MouseMotion
+        {
+            int64_t x       = 0;
+            int64_t y       = 0;
+            double time_ms  = 0.0; // when the latest of the motion arrived
+        };
+        MouseMotion GetMouseMotion();                                               // now, from any thread
+        const MouseMotion& GetMouseMotionAtTick() const { return m_mouse_motion_tick; } // what GetMouseDelta() was computed from
+        static Math::Vector2 GetMouseMotionDelta(const MouseMotion& from, const MouseMotion& to)
+        {
+            return Math::Vector2(static_cast<float>(to.x - from.x), static_cast<float>(to.y - from.y));
+        }
+
 		// Gamepad
 		bool GamepadIsConnected() const							{ return m_gamepad_connected; }
 		const Math::Vector2& GetGamepadThumbStickLeft() const	{ return m_gamepad_thumb_left; }
@@ -107,6 +125,22 @@ namespace Spartan
 		// The two motors are not the same, and they create different vibration effects.
 		bool GamepadVibrate(float left_motor_speed, float right_motor_speed) const;
 
+        // The state a tick leaves behind, which a frame capture records. A replayed state replaces what the devices report,
+        // starting with the next tick, until it's cleared (nullptr).
+        struct State
+        {
+            std::array<bool, 99> keys           = {};
+            Math::Vector2 mouse_position        = Math::Vector2::Zero;
+            Math::Vector2 mouse_delta           = Math::Vector2::Zero;
+            float mouse_wheel_delta             = 0.0f;
+            Math::Vector2 gamepad_thumb_left    = Math::Vector2::Zero;
+            Math::Vector2 gamepad_thumb_right   = Math::Vector2::Zero;
+            float gamepad_trigger_left          = 0.0f;
+            float gamepad_trigger_right         = 0.0f;
+        };
+        State GetState() const;
+        void SetStateReplayed(const State* state);
+
 	private:
 		// Keys
 		std::array<bool, 99> m_keys;
@@ -117,6 +151,12 @@ namespace Spartan
 		// Mouse
 		Math::Vector2 m_mouse_position	= Math::Vector2::Zero;
 		Math::Vector2 m_mouse_delta		= Math::Vector2::Zero;
+        MouseMotion m_mouse_motion;         // written by the raw input thread
+        MouseMotion m_mouse_motion_tick;
+        std::mutex m_mouse_motion_mutex;
+        std::thread m_raw_input_thread;
+        uint32_t m_raw_input_thread_id  = 0;
+        bool m_raw_input_threaded       = false; // otherwise the window receives the raw input
 		int m_mouse_wheel				= 0;
 		float m_mouse_wheel_delta		= 0;
 
@@ -130,5 +170,7 @@ namespace Spartan
         // Misc
         bool m_is_new_frame         = false;
         bool m_check_for_new_device = false;
+        bool m_state_replayed       = false;
+        State m_state_replay;
 	};
 }
@@ -26,6 +26,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Core/Context.h"
 #include "../../Core/Engine.h"
 #include <sstream>
+#include <chrono>
+#include <condition_variable>
 //==================================
 
 //= NAMESPACES ===============
@@ -38,6 +40,42 @@ namespace Spartan
 	XINPUT_STATE	g_gamepad;
     uint32_t		g_gamepad_num = 0;
 
+    #ifndef HID_USAGE_PAGE_GENERIC
+    #define HID_USAGE_PAGE_GENERIC         ((USHORT) 0x01)
+    #endif
+    #ifndef HID_USAGE_GENERIC_MOUSE
+    #define HID_USAGE_GENERIC_MOUSE        ((USHORT) 0x02)
+    #endif
+
+    static bool register_raw_mouse(const HWND window_handle)
+    {
+        RAWINPUTDEVICE Rid[1];
+        Rid[0].usUsagePage  = HID_USAGE_PAGE_GENERIC;
+        Rid[0].usUsage      = HID_USAGE_GENERIC_MOUSE;
+        Rid[0].dwFlags      = RIDEV_INPUTSINK;
+        Rid[0].hwndTarget   = window_handle;
+        return RegisterRawInputDevices(Rid, 1, sizeof(Rid[0])) == TRUE;
+    }
+
+    // Adds the motion of a WM_INPUT message, relative motion only (absolute devices, like tablets, aren't mouse look devices)
+    static void accumulate_raw_mouse(const LPARAM lparam, Input::MouseMotion& motion, mutex& motion_mutex)
+    {
+        UINT size = sizeof(RAWINPUT);
+        RAWINPUT raw;
+        if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lparam), RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1))
+            return;
+
+        if (raw.header.dwType != RIM_TYPEMOUSE || (raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE))
+            return;
+
+        const double time_ms = chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+
+        lock_guard<mutex> lock(motion_mutex);
+        motion.x        += raw.data.mouse.lLastX;
+        motion.y        += raw.data.mouse.lLastY;
+        motion.time_ms  = time_ms;
+    }
+
 	Input::Input(Context* context) : ISubsystem(context)
 	{
         const WindowData& window_data   = context->m_engine->GetWindowData();
@@ -49,32 +87,92 @@ namespace Spartan
             return;
         }
 
-        // Register mouse
+        // Raw mouse input goes to a message-only window of its own thread, so that motion is picked up as soon as the
+        // device reports it, instead of when the main thread gets around to its message queue (once per frame)
+        {
+            mutex startup_mutex;
+            condition_variable startup_condition;
+            bool startup_done = false;
+
+            m_raw_input_thread = thread([this, &startup_mutex, &startup_condition, &startup_done]()
+            {
+                const HINSTANCE instance = GetModuleHandle(nullptr);
+
+                WNDCLASSEX window_class     = {};
+                window_class.cbSize         = sizeof(WNDCLASSEX);
+                window_class.lpfnWndProc    = DefWindowProc;
+                window_class.hInstance      = instance;
+                window_class.lpszClassName  = TEXT("Spartan_RawInput");
+                RegisterClassEx(&window_class);
+
+                const HWND window   = CreateWindowEx(0, window_class.lpszClassName, TEXT(""), 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, instance, nullptr);
+                const bool threaded = window && register_raw_mouse(window);
+
+                {
+                    lock_guard<mutex> lock(startup_mutex);
+                    m_raw_input_threaded    = threaded;
+                    m_raw_input_thread_id   = GetCurrentThreadId();
+                    startup_done            = true;
+                }
+                startup_condition.notify_one();
+
+                // Until the destructor posts WM_QUIT
+                MSG message;
+                while (threaded && GetMessage(&message, nullptr, 0, 0) > 0)
+                {
+                    if (message.message == WM_INPUT)
+                    {
+                        accumulate_raw_mouse(message.lParam, m_mouse_motion, m_mouse_motion_mutex);
+                    }
+
+                    DispatchMessage(&message); // WM_INPUT has to reach DefWindowProc, which cleans up after it
+                }
+
+                if (window)
+                {
+                    DestroyWindow(window);
+                }
+                UnregisterClass(window_class.lpszClassName, instance);
+            });
+
+            unique_lock<mutex> lock(startup_mutex);
+            startup_condition.wait(lock, [&startup_done]() { return startup_done; });
+        }
+
+        // If the thread couldn't register, the window receives it (and the motion is picked up with its messages)
+        if (!m_raw_input_threaded)
         {
-            #ifndef HID_USAGE_PAGE_GENERIC
-            #define HID_USAGE_PAGE_GENERIC         ((USHORT) 0x01)
-            #endif
-            #ifndef HID_USAGE_GENERIC_MOUSE
-            #define HID_USAGE_GENERIC_MOUSE        ((USHORT) 0x02)
-            #endif
-            RAWINPUTDEVICE Rid[1];
-            Rid[0].usUsagePage  = HID_USAGE_PAGE_GENERIC;
-            Rid[0].usUsage      = HID_USAGE_GENERIC_MOUSE;
-            Rid[0].dwFlags      = RIDEV_INPUTSINK;
-            Rid[0].hwndTarget   = window_handle;
-            RegisterRawInputDevices(Rid, 1, sizeof(Rid[0]));
+            LOG_WARNING("Raw input is handled on the main thread");
+            register_raw_mouse(window_handle);
         }
 
         SUBSCRIBE_TO_EVENT(Event_Window_Data, EVENT_HANDLER(OnWindowData));
 	}
 
+    Input::~Input()
+    {
+        if (m_raw_input_thread.joinable())
+        {
+            if (m_raw_input_threaded)
+            {
+                PostThreadMessage(m_raw_input_thread_id, WM_QUIT, 0, 0);
+            }
+            m_raw_input_thread.join();
+        }
+    }
+
+    Input::MouseMotion Input::GetMouseMotion()
+    {
+        lock_guard<mutex> lock(m_mouse_motion_mutex);
+        return m_mouse_motion;
+    }
+
     void Input::OnWindowData()
     {
         // OnWindowData can run multiple times per frame (for each window message)
         // So only code within the if statement scope will run once per frame
         if (m_is_new_frame)
         {
-            m_mouse_delta           = Vector2::Zero;
             m_keys_previous_frame   = m_keys;
             m_check_for_new_device  = false;
         }
@@ -89,18 +187,10 @@ namespace Spartan
             m_keys[start_index_mouse + 1]   = (::GetKeyState(VK_MBUTTON) & 0x8000) != 0; // Middle button pressed
             m_keys[start_index_mouse + 2]   = (::GetKeyState(VK_RBUTTON) & 0x8000) != 0; // Right button pressed
 
-            // Delta
-            if (window_data.message == WM_INPUT)
+            // Motion, only if the raw input thread couldn't take it (the delta is computed when ticking)
+            if (window_data.message == WM_INPUT && !m_raw_input_threaded)
             {
-                UINT dwSize = 48;
-                static BYTE lpb[48];
-                GetRawInputData((HRAWINPUT)window_data.lparam, RID_INPUT, lpb, &dwSize, sizeof(RAWINPUTHEADER));
-                RAWINPUT* raw = (RAWINPUT*)lpb;
-                if (raw->header.dwType == RIM_TYPEMOUSE)
-                {
-                    m_mouse_delta.x = static_cast<float>(raw->data.mouse.lLastX);
-                    m_mouse_delta.y = static_cast<float>(raw->data.mouse.lLastY);
-                }
+                accumulate_raw_mouse(static_cast<LPARAM>(window_data.lparam), m_mouse_motion, m_mouse_motion_mutex);
             }
 
             // Position
@@ -227,6 +317,13 @@ namespace Spartan
 
 	void Input::Tick(float delta_time)
 	{
+        // Mouse delta, all the motion since the previous tick (every message of it, not only the latest)
+        {
+            const MouseMotion motion    = GetMouseMotion();
+            m_mouse_delta               = GetMouseMotionDelta(m_mouse_motion_tick, motion);
+            m_mouse_motion_tick         = motion;
+        }
+
         // Check for new device
         if (m_check_for_new_device)
         {
@@ -285,9 +382,46 @@ namespace Spartan
 			}
 		}
 
+        // A replay decides what was pressed, whatever the devices say
+        if (m_state_replayed)
+        {
+            m_keys_previous_frame       = m_keys;
+            m_keys                      = m_state_replay.keys;
+            m_mouse_position            = m_state_replay.mouse_position;
+            m_mouse_delta               = m_state_replay.mouse_delta;
+            m_mouse_wheel_delta         = m_state_replay.mouse_wheel_delta;
+            m_gamepad_thumb_left        = m_state_replay.gamepad_thumb_left;
+            m_gamepad_thumb_right       = m_state_replay.gamepad_thumb_right;
+            m_gamepad_trigger_left      = m_state_replay.gamepad_trigger_left;
+            m_gamepad_trigger_right     = m_state_replay.gamepad_trigger_right;
+        }
+
         m_is_new_frame = true;
 	}
 
+    Input::State Input::GetState() const
+    {
+        State state;
+        state.keys                  = m_keys;
+        state.mouse_position        = m_mouse_position;
+        state.mouse_delta           = m_mouse_delta;
+        state.mouse_wheel_delta     = m_mouse_wheel_delta;
+        state.gamepad_thumb_left    = m_gamepad_thumb_left;
+        state.gamepad_thumb_right   = m_gamepad_thumb_right;
+        state.gamepad_trigger_left  = m_gamepad_trigger_left;
+        state.gamepad_trigger_right = m_gamepad_trigger_right;
+        return state;
+    }
+
+    void Input::SetStateReplayed(const State* state)
+    {
+        m_state_replayed = state != nullptr;
+        if (state)
+        {
+            m_state_replay = *state;
+        }
+    }
+
 	bool Input::GamepadVibrate(const float left_motor_speed, const float right_motor_speed) const
 	{
 		if (!m_gamepad_connected)
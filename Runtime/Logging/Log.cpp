@@ -24,6 +24,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ILogger.h"
 #include <fstream>
 #include <cstdarg>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include "../World/Entity.h"
 #include "../Core/EventSystem.h"
 #include "../Core/FileSystem.h"
@@ -43,6 +47,147 @@ namespace Spartan
 	string Log::m_log_file_name	    = "log.txt";
 	bool Log::m_log_to_file		    = true; // start logging to file (unless changed by the user, e.g. Renderer initialization was successful, so logging can happen on screen)
 	bool Log::m_first_log		    = true;
+
+    namespace _Log
+    {
+        constexpr uint64_t ring_size                = 1024; // has to be a power of two
+        constexpr size_t text_size                  = 2048;
+        constexpr chrono::milliseconds flush_period = chrono::milliseconds(10);
+
+        struct Slot
+        {
+            atomic<uint64_t> sequence   = 0; // the position which can write to the slot, or plus one, the position which can read it
+            Log_Type type               = Log_Info;
+            char text[text_size];
+        };
+
+        // A bounded multi-producer single-consumer ring, the writers only contend on the position and the thread which logs never blocks them
+        struct Writer
+        {
+            Writer();
+            ~Writer();
+            bool LogBatch();
+
+            unique_ptr<Slot[]> ring;
+            atomic<uint64_t> position_write     = 0;
+            atomic<uint64_t> position_logged    = 0;
+            uint64_t position_read              = 0;
+            mutex mutex_wake;
+            condition_variable wake;
+            condition_variable logged;
+            bool stop                           = false;
+            thread logger;
+        };
+
+        atomic<bool> writer_destroyed       = false; // what's written once the writer is gone (at exit) is logged right away
+        thread_local bool is_writer         = false;
+        thread_local char buffer[text_size];    // formatting happens on the calling thread, so every thread has its own buffer
+
+        Writer& get_writer()
+        {
+            static Writer writer;
+            return writer;
+        }
+
+        bool Writer::LogBatch()
+        {
+            Slot& first = ring[position_read & (ring_size - 1)];
+            if (first.sequence.load(memory_order_acquire) != position_read + 1)
+                return false;
+
+            {
+                lock_guard<mutex> guard(Log::m_mutex_log);
+
+                while (true)
+                {
+                    Slot& slot = ring[position_read & (ring_size - 1)];
+                    if (slot.sequence.load(memory_order_acquire) != position_read + 1)
+                        break;
+
+                    Log::Output(slot.text, slot.type);
+
+                    slot.sequence.store(position_read + ring_size, memory_order_release);
+                    position_read++;
+                }
+
+                // The file is written once per batch
+                if (Log::m_fout.is_open())
+                {
+                    Log::m_fout.close();
+                }
+            }
+
+            {
+                lock_guard<mutex> lock(mutex_wake);
+                position_logged.store(position_read);
+            }
+            logged.notify_all();
+
+            return true;
+        }
+
+        Writer::Writer()
+        {
+            ring = make_unique<Slot[]>(ring_size);
+            for (uint64_t i = 0; i < ring_size; i++)
+            {
+                ring[i].sequence.store(i, memory_order_relaxed);
+            }
+
+            logger = thread([this]()
+            {
+                is_writer = true;
+
+                while (true)
+                {
+                    bool stopping = false;
+                    {
+                        unique_lock<mutex> lock(mutex_wake);
+                        wake.wait_for(lock, flush_period);
+                        stopping = stop;
+                    }
+
+                    while (LogBatch()) {}
+
+                    // Anything that was claimed before the stop has been published by now
+                    if (stopping && position_read == position_write.load())
+                        break;
+                }
+            });
+        }
+
+        Writer::~Writer()
+        {
+            writer_destroyed = true;
+
+            {
+                lock_guard<mutex> lock(mutex_wake);
+                stop = true;
+            }
+            wake.notify_one();
+
+            logger.join();
+        }
+    }
+
+    void Log::SetLogger(const weak_ptr<ILogger>& logger)
+    {
+        lock_guard<mutex> guard(m_mutex_log);
+        m_logger = logger;
+    }
+
+    void Log::Flush()
+    {
+        if (_Log::writer_destroyed || _Log::is_writer)
+            return;
+
+        _Log::Writer& writer    = _Log::get_writer();
+        const uint64_t target   = writer.position_write.load();
+
+        unique_lock<mutex> lock(writer.mutex_wake);
+        writer.wake.notify_one();
+        writer.logged.wait(lock, [&writer, target]() { return writer.position_logged.load() >= target; });
+    }
    
 	// Everything resolves to this
 	void Log::Write(const char* text, const Log_Type type)
@@ -53,53 +198,97 @@ namespace Spartan
             return;
         }
 
-        lock_guard<mutex> guard(m_mutex_log);
+        // The logger thread already holds the lock (e.g. something that logs while logging)
+        if (_Log::is_writer)
+        {
+            Output(text, type);
+            return;
+        }
 
-        const auto log_to_file = m_logger.expired() || m_log_to_file;
+        if (_Log::writer_destroyed)
+        {
+            lock_guard<mutex> guard(m_mutex_log);
+            Output(text, type);
+            m_fout.close();
+            return;
+        }
 
-        if (log_to_file)
+        _Log::Writer& writer = _Log::get_writer();
+
+        // Claim a slot
+        uint64_t position = writer.position_write.load(memory_order_relaxed);
+        _Log::Slot* slot  = nullptr;
+        while (true)
         {
-            m_log_buffer.emplace_back(text, type);
-            LogToFile(text, type);
+            slot                    = &writer.ring[position & (_Log::ring_size - 1)];
+            const uint64_t sequence = slot->sequence.load(memory_order_acquire);
+            const int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+            if (difference == 0)
+            {
+                if (writer.position_write.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                // The ring is full, nothing is dropped so wait for the logger to catch up
+                writer.wake.notify_one();
+                this_thread::yield();
+                position = writer.position_write.load(memory_order_relaxed);
+            }
+            else
+            {
+                position = writer.position_write.load(memory_order_relaxed);
+            }
         }
-        else
+
+        // Publish it
+        strncpy(slot->text, text, _Log::text_size - 1);
+        slot->text[_Log::text_size - 1] = '\0';
+        slot->type                      = type;
+        slot->sequence.store(position + 1, memory_order_release);
+
+        // Warnings and errors show up right away, the rest is logged in batches
+        if (type != Log_Info || (position & (_Log::ring_size / 2 - 1)) == 0)
         {
-            FlushBuffer();
-            LogString(text, type);
+            writer.wake.notify_one();
+        }
+
+        // An error can be followed by a crash, so it's on file before the caller carries on
+        if (type == Log_Error)
+        {
+            Flush();
         }
 	}
 
     void Log::WriteFInfo(const char* text, ...)
 	{
-		char buffer[1024];
 		va_list args;
 		va_start(args, text);
-		auto w = vsnprintf(buffer, sizeof(buffer), text, args);
+		vsnprintf(_Log::buffer, sizeof(_Log::buffer), text, args);
 		va_end(args);
 
-		Write(buffer, Log_Info);
+		Write(_Log::buffer, Log_Info);
 	}
 
     void Log::WriteFWarning(const char* text, ...)
 	{
-		char buffer[1024];
 		va_list args;
 		va_start(args, text);
-		auto w = vsnprintf(buffer, sizeof(buffer), text, args);
+		vsnprintf(_Log::buffer, sizeof(_Log::buffer), text, args);
 		va_end(args);
 
-		Write(buffer, Log_Warning);
+		Write(_Log::buffer, Log_Warning);
 	}
 
     void Log::WriteFError(const char* text, ...)
 	{
-		char buffer[1024];
 		va_list args;
 		va_start(args, text);
-		auto w = vsnprintf(buffer, sizeof(buffer), text, args);
+		vsnprintf(_Log::buffer, sizeof(_Log::buffer), text, args);
 		va_end(args);
 
-		Write(buffer, Log_Error);
+		Write(_Log::buffer, Log_Error);
 	}
 
     void Log::Write(const string& text, const Log_Type type)
@@ -109,35 +298,32 @@ namespace Spartan
 
     void Log::WriteFInfo(const string text, ...)
     {
-        char buffer[2048];
         va_list args;
         va_start(args, text);
-        auto w = vsnprintf(buffer, sizeof(buffer), text.c_str(), args);
+        vsnprintf(_Log::buffer, sizeof(_Log::buffer), text.c_str(), args);
         va_end(args);
 
-        Write(buffer, Log_Info);
+        Write(_Log::buffer, Log_Info);
     }
 
     void Log::WriteFWarning(const string text, ...)
     {
-        char buffer[2048];
         va_list args;
         va_start(args, text);
-        auto w = vsnprintf(buffer, sizeof(buffer), text.c_str(), args);
+        vsnprintf(_Log::buffer, sizeof(_Log::buffer), text.c_str(), args);
         va_end(args);
 
-        Write(buffer, Log_Warning);
+        Write(_Log::buffer, Log_Warning);
     }
 
     void Log::WriteFError(const string text, ...)
     {
-        char buffer[2048];
         va_list args;
         va_start(args, text);
-        auto w = vsnprintf(buffer, sizeof(buffer), text.c_str(), args);
+        vsnprintf(_Log::buffer, sizeof(_Log::buffer), text.c_str(), args);
         va_end(args);
 
-        Write(buffer, Log_Error);
+        Write(_Log::buffer, Log_Error);
     }
 
     void Log::Write(const weak_ptr<Entity>& entity, const Log_Type type)
@@ -175,6 +361,22 @@ namespace Spartan
 		Write(value.ToString(), type);
 	}
 
+    void Log::Output(const char* text, const Log_Type type)
+    {
+        const auto log_to_file = m_logger.expired() || m_log_to_file;
+
+        if (log_to_file)
+        {
+            m_log_buffer.emplace_back(text, type);
+            LogToFile(text, type);
+        }
+        else
+        {
+            FlushBuffer();
+            LogString(text, type);
+        }
+    }
+
     void Log::FlushBuffer()
     {
         if (m_logger.expired() || m_log_buffer.empty())
@@ -217,16 +419,16 @@ namespace Spartan
 			m_first_log = false;
 		}
 
-		// Open/Create a log file to write the error message to
-		m_fout.open(m_log_file_name, ofstream::out | ofstream::app);
+		// Open/Create a log file to write the error message to (it's closed once the batch of messages is written)
+        if (!m_fout.is_open())
+        {
+		    m_fout.open(m_log_file_name, ofstream::out | ofstream::app);
+        }
 
 		if (m_fout.is_open())
 		{
 			// Write out the error message
-			m_fout << final_text << endl;
-
-			// Close the file
-			m_fout.close();
+			m_fout << final_text << '\n';
 		}
 	}
 }
@@ -45,6 +45,7 @@ namespace Spartan
 
 	// Forward declarations
 	class Entity;
+	namespace _Log { struct Writer; }
 	namespace Math
 	{
 		class Quaternion;
@@ -76,11 +77,15 @@ namespace Spartan
 	class SPARTAN_CLASS Log
 	{
 		friend class ILogger;
+		friend struct _Log::Writer;
 	public:
         Log() = default;
 
 		// Set a logger to be used (if not set, logging will done in a text file.
-		static void SetLogger(const std::weak_ptr<ILogger>& logger) { m_logger = logger; }
+		static void SetLogger(const std::weak_ptr<ILogger>& logger);
+
+        // Messages are queued and logged by a thread of their own, this waits until what was written so far has been logged
+        static void Flush();
 
 		// Alpha
 		static void Write(const char* text, const Log_Type type);
@@ -126,6 +131,7 @@ namespace Spartan
 		static bool m_log_to_file;     
 
 	private:
+        static void Output(const char* text, Log_Type type);
         static void FlushBuffer();
 		static void LogString(const char* text, Log_Type type);
 		static void LogToFile(const char* text, Log_Type type);
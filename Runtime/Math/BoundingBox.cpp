@@ -112,6 +112,25 @@ namespace Spartan::Math
 
 	BoundingBox BoundingBox::Transform(const Matrix& transform) const
 	{
+#if defined(SPARTAN_MATH_SIMD)
+        // The transform is affine, the center goes through it and the extents through its absolute (the translation drops out with w = 0)
+        using namespace Simd;
+        const float* data           = transform.Data();
+        const float4 column0        = load(data);
+        const float4 column1        = load(data + 4);
+        const float4 column2        = load(data + 8);
+        const float4 column3        = load(data + 12);
+        const Vector3 center_old    = GetCenter();
+        const Vector3 extent_old    = GetExtents();
+        const float4 center_new     = dot4(set(center_old.x, center_old.y, center_old.z, 1.0f), column0, column1, column2, column3);
+        const float4 extent_new     = dot4(set(extent_old.x, extent_old.y, extent_old.z, 0.0f), abs(column0), abs(column1), abs(column2), abs(column3));
+
+        alignas(16) float min[4];
+        alignas(16) float max[4];
+        store(min, sub(center_new, extent_new));
+        store(max, add(center_new, extent_new));
+        return BoundingBox(Vector3(min[0], min[1], min[2]), Vector3(max[0], max[1], max[2]));
+#else
         const Vector3 center_new = transform * GetCenter();
         const Vector3 extent_old = GetExtents();
         const Vector3 extend_new = Vector3
@@ -122,6 +141,7 @@ namespace Spartan::Math
 		);
 
 		return BoundingBox(center_new - extend_new, center_new + extend_new);
+#endif
 	}
 
     void BoundingBox::Merge(const BoundingBox& box)
@@ -130,7 +150,7 @@ namespace Spartan::Math
         m_min.y = Helper::Min(m_min.y, box.m_min.y);
         m_min.z = Helper::Min(m_min.z, box.m_min.z);
         m_max.x = Helper::Max(m_max.x, box.m_max.x);
-        m_max.y = Helper::Max(m_max.x, box.m_max.x);
-        m_max.z = Helper::Max(m_max.x, box.m_max.x);
+        m_max.y = Helper::Max(m_max.y, box.m_max.y);
+        m_max.z = Helper::Max(m_max.z, box.m_max.z);
     }
 }
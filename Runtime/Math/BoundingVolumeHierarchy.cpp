@@ -0,0 +1,380 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ======================
+#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+#include <numeric>
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::Math
+{
+    namespace _BoundingVolumeHierarchy
+    {
+        // How much bigger than the given box a leaf is, per axis (a fixed part plus a part of the size)
+        static const float fat_margin       = 0.1f;
+        static const float fat_margin_size  = 0.1f;
+
+        static BoundingBox merged(const BoundingBox& a, const BoundingBox& b)
+        {
+            BoundingBox box = a;
+            box.Merge(b);
+            return box;
+        }
+
+        static float surface_area(const BoundingBox& box)
+        {
+            const Vector3 size = box.GetSize();
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        static bool contains(const BoundingBox& outer, const BoundingBox& inner)
+        {
+            return outer.IsInside(inner) == Inside;
+        }
+
+        static BoundingBox fattened(const BoundingBox& box, const float scale)
+        {
+            const Vector3 margin = (Vector3(fat_margin) + box.GetSize() * fat_margin_size) * scale;
+            return BoundingBox(box.GetMin() - margin, box.GetMax() + margin);
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::Insert(const BoundingBox& box, const uint32_t user_data)
+    {
+        const uint32_t leaf = NodeAllocate();
+
+        Node& node      = m_nodes[leaf];
+        node.box        = _BoundingVolumeHierarchy::fattened(box, 1.0f);
+        node.user_data  = user_data;
+        node.height     = 0;
+
+        LeafInsert(leaf);
+        m_leaf_count++;
+
+        return leaf;
+    }
+
+    void BoundingVolumeHierarchy::Remove(const uint32_t proxy)
+    {
+        if (proxy >= m_nodes.size() || !m_nodes[proxy].IsLeaf() || m_nodes[proxy].height != 0)
+            return;
+
+        LeafRemove(proxy);
+        NodeFree(proxy);
+        m_leaf_count--;
+    }
+
+    bool BoundingVolumeHierarchy::Update(const uint32_t proxy, const BoundingBox& box)
+    {
+        if (proxy >= m_nodes.size() || m_nodes[proxy].height != 0)
+            return false;
+
+        // Still inside the fat box, and the fat box isn't too loose for it either (the box could have shrunk)
+        const BoundingBox& box_fat = m_nodes[proxy].box;
+        if (_BoundingVolumeHierarchy::contains(box_fat, box) && _BoundingVolumeHierarchy::contains(_BoundingVolumeHierarchy::fattened(box, 4.0f), box_fat))
+            return false;
+
+        LeafRemove(proxy);
+        m_nodes[proxy].box = _BoundingVolumeHierarchy::fattened(box, 1.0f);
+        LeafInsert(proxy);
+
+        return true;
+    }
+
+    void BoundingVolumeHierarchy::Clear()
+    {
+        m_nodes.clear();
+        m_root          = null_node;
+        m_free_list     = null_node;
+        m_leaf_count    = 0;
+    }
+
+    void BoundingVolumeHierarchy::Build(const vector<BoundingBox>& boxes)
+    {
+        Clear();
+
+        if (boxes.empty())
+            return;
+
+        m_nodes.reserve(boxes.size() * 2 - 1);
+
+        vector<uint32_t> indices(boxes.size());
+        iota(indices.begin(), indices.end(), 0);
+
+        m_root          = BuildNode(indices.data(), static_cast<uint32_t>(indices.size()), boxes, null_node);
+        m_leaf_count    = static_cast<uint32_t>(boxes.size());
+    }
+
+    uint32_t BoundingVolumeHierarchy::BuildNode(uint32_t* indices, const uint32_t count, const vector<BoundingBox>& boxes, const uint32_t parent)
+    {
+        const uint32_t index = NodeAllocate();
+        m_nodes[index].parent = parent;
+
+        if (count == 1)
+        {
+            Node& node      = m_nodes[index];
+            node.box        = boxes[indices[0]];
+            node.user_data  = indices[0];
+            node.height     = 0;
+            return index;
+        }
+
+        // Split at the median of the centers, along the axis which they spread the most on
+        BoundingBox bounds_centers;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const Vector3 center = boxes[indices[i]].GetCenter();
+            bounds_centers.Merge(BoundingBox(center, center));
+        }
+        const Vector3 spread    = bounds_centers.GetSize();
+        const uint32_t axis     = (spread.x >= spread.y && spread.x >= spread.z) ? 0 : (spread.y >= spread.z ? 1 : 2);
+        const uint32_t half     = count / 2;
+        nth_element(indices, indices + half, indices + count, [&boxes, axis](const uint32_t a, const uint32_t b)
+        {
+            return boxes[a].GetCenter().Data()[axis] < boxes[b].GetCenter().Data()[axis];
+        });
+
+        // The children are built before the node is referenced, they can grow the node vector
+        const uint32_t child_left   = BuildNode(indices, half, boxes, index);
+        const uint32_t child_right  = BuildNode(indices + half, count - half, boxes, index);
+
+        Node& node          = m_nodes[index];
+        node.child_left     = child_left;
+        node.child_right    = child_right;
+        node.box            = _BoundingVolumeHierarchy::merged(m_nodes[child_left].box, m_nodes[child_right].box);
+        node.height         = 1 + Helper::Max(m_nodes[child_left].height, m_nodes[child_right].height);
+
+        return index;
+    }
+
+    uint32_t BoundingVolumeHierarchy::NodeAllocate()
+    {
+        uint32_t index = m_free_list;
+        if (index != null_node)
+        {
+            m_free_list = m_nodes[index].parent;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        m_nodes[index] = Node();
+        return index;
+    }
+
+    void BoundingVolumeHierarchy::NodeFree(const uint32_t index)
+    {
+        Node& node          = m_nodes[index];
+        node.parent         = m_free_list;
+        node.child_left     = null_node;
+        node.child_right    = null_node;
+        node.height         = -1;
+        m_free_list         = index;
+    }
+
+    void BoundingVolumeHierarchy::LeafInsert(const uint32_t leaf)
+    {
+        if (m_root == null_node)
+        {
+            m_root                  = leaf;
+            m_nodes[leaf].parent    = null_node;
+            return;
+        }
+
+        // Find the best sibling, descending to the child whose box grows the least (surface area heuristic)
+        const BoundingBox box   = m_nodes[leaf].box;
+        uint32_t index          = m_root;
+        while (!m_nodes[index].IsLeaf())
+        {
+            const Node& node                = m_nodes[index];
+            const float area                = _BoundingVolumeHierarchy::surface_area(node.box);
+            const float area_combined       = _BoundingVolumeHierarchy::surface_area(_BoundingVolumeHierarchy::merged(node.box, box));
+            
+            // The cost of making a new parent for this node and the leaf, and the cost every child pays for the growth of this node
+            const float cost                = 2.0f * area_combined;
+            const float cost_inheritance    = 2.0f * (area_combined - area);
+
+            auto cost_descend = [this, &box, cost_inheritance](const uint32_t child)
+            {
+                const Node& node_child  = m_nodes[child];
+                const float area_merged = _BoundingVolumeHierarchy::surface_area(_BoundingVolumeHierarchy::merged(node_child.box, box));
+                return (node_child.IsLeaf() ? area_merged : area_merged - _BoundingVolumeHierarchy::surface_area(node_child.box)) + cost_inheritance;
+            };
+
+            const float cost_left   = cost_descend(node.child_left);
+            const float cost_right  = cost_descend(node.child_right);
+
+            if (cost < cost_left && cost < cost_right)
+                break;
+
+            index = cost_left < cost_right ? node.child_left : node.child_right;
+        }
+
+        // Make a new parent for the sibling and the leaf
+        const uint32_t sibling      = index;
+        const uint32_t parent_old   = m_nodes[sibling].parent;
+        const uint32_t parent_new   = NodeAllocate();
+        {
+            Node& node          = m_nodes[parent_new];
+            node.parent         = parent_old;
+            node.box            = _BoundingVolumeHierarchy::merged(box, m_nodes[sibling].box);
+            node.height         = m_nodes[sibling].height + 1;
+            node.child_left     = sibling;
+            node.child_right    = leaf;
+        }
+
+        if (parent_old != null_node)
+        {
+            Node& node = m_nodes[parent_old];
+            (node.child_left == sibling ? node.child_left : node.child_right) = parent_new;
+        }
+        else
+        {
+            m_root = parent_new;
+        }
+
+        m_nodes[sibling].parent = parent_new;
+        m_nodes[leaf].parent    = parent_new;
+
+        Refit(m_nodes[leaf].parent);
+    }
+
+    void BoundingVolumeHierarchy::LeafRemove(const uint32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = null_node;
+            return;
+        }
+
+        // The sibling takes the place of the parent
+        const uint32_t parent       = m_nodes[leaf].parent;
+        const uint32_t grandparent  = m_nodes[parent].parent;
+        const uint32_t sibling      = m_nodes[parent].child_left == leaf ? m_nodes[parent].child_right : m_nodes[parent].child_left;
+
+        if (grandparent != null_node)
+        {
+            Node& node = m_nodes[grandparent];
+            (node.child_left == parent ? node.child_left : node.child_right) = sibling;
+            m_nodes[sibling].parent = grandparent;
+            NodeFree(parent);
+
+            Refit(grandparent);
+        }
+        else
+        {
+            m_root                  = sibling;
+            m_nodes[sibling].parent = null_node;
+            NodeFree(parent);
+        }
+    }
+
+    void BoundingVolumeHierarchy::Refit(uint32_t index)
+    {
+        while (index != null_node)
+        {
+            index = Balance(index);
+
+            Node& node              = m_nodes[index];
+            const Node& left        = m_nodes[node.child_left];
+            const Node& right       = m_nodes[node.child_right];
+            node.height             = 1 + Helper::Max(left.height, right.height);
+            node.box                = _BoundingVolumeHierarchy::merged(left.box, right.box);
+
+            index = node.parent;
+        }
+    }
+
+    uint32_t BoundingVolumeHierarchy::Balance(const uint32_t index_a)
+    {
+        Node& a = m_nodes[index_a];
+        if (a.IsLeaf() || a.height < 2)
+            return index_a;
+
+        const uint32_t index_b  = a.child_left;
+        const uint32_t index_c  = a.child_right;
+        Node& b                 = m_nodes[index_b];
+        Node& c                 = m_nodes[index_c];
+        const int32_t balance   = c.height - b.height;
+
+        // The child which is too high (c or b) moves up and takes the place of a, a takes the lower grandchild
+        auto rotate = [this, index_a, &a](const uint32_t index_up, Node& up, Node& other, const bool up_is_right)
+        {
+            const uint32_t index_f  = up.child_left;
+            const uint32_t index_g  = up.child_right;
+            Node& f                 = m_nodes[index_f];
+            Node& g                 = m_nodes[index_g];
+
+            // Swap a and up
+            up.child_left   = index_a;
+            up.parent       = a.parent;
+            a.parent        = index_up;
+
+            if (up.parent != null_node)
+            {
+                Node& parent = m_nodes[up.parent];
+                (parent.child_left == index_a ? parent.child_left : parent.child_right) = index_up;
+            }
+            else
+            {
+                m_root = index_up;
+            }
+
+            // The higher grandchild stays with up and the lower one goes to a (where up used to be)
+            const bool f_higher         = f.height > g.height;
+            const uint32_t index_keep   = f_higher ? index_f : index_g;
+            const uint32_t index_give   = f_higher ? index_g : index_f;
+            Node& keep                  = m_nodes[index_keep];
+            Node& give                  = m_nodes[index_give];
+
+            up.child_right = index_keep;
+            (up_is_right ? a.child_right : a.child_left) = index_give;
+            give.parent = index_a;
+
+            a.box       = _BoundingVolumeHierarchy::merged(other.box, give.box);
+            up.box      = _BoundingVolumeHierarchy::merged(a.box, keep.box);
+            a.height    = 1 + Helper::Max(other.height, give.height);
+            up.height   = 1 + Helper::Max(a.height, keep.height);
+        };
+
+        if (balance > 1)
+        {
+            rotate(index_c, c, b, true);
+            return index_c;
+        }
+
+        if (balance < -1)
+        {
+            rotate(index_b, b, c, false);
+            return index_b;
+        }
+
+        return index_a;
+    }
+}
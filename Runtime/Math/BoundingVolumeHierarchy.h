@@ -0,0 +1,165 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include <array>
+#include "../Core/EngineDefs.h"
+#include "BoundingBox.h"
+#include "Frustum.h"
+#include "Ray.h"
+//=============================
+
+namespace Spartan::Math
+{
+    // A dynamic bounding volume hierarchy over axis aligned boxes.
+    // Leaves hold a slightly bigger (fat) box than the one they were given, so small movements don't touch the tree,
+    // and the tree is kept balanced with rotations as leaves come and go. Queries visit the user data of every
+    // leaf whose box passes the test, it's up to the caller to do an exact test against its own box.
+    class SPARTAN_CLASS BoundingVolumeHierarchy
+    {
+    public:
+        static constexpr uint32_t null_node = 0xFFFFFFFF;
+
+        BoundingVolumeHierarchy() = default;
+        ~BoundingVolumeHierarchy() = default;
+
+        // Adds a leaf, returns its proxy
+        uint32_t Insert(const BoundingBox& box, uint32_t user_data);
+        // Removes a leaf
+        void Remove(uint32_t proxy);
+        // Moves a leaf, returns true if it had to be re-inserted (the box left the fat box of the leaf)
+        bool Update(uint32_t proxy, const BoundingBox& box);
+        // Removes all the leaves
+        void Clear();
+        // Replaces the tree with one built top-down over boxes which don't move (the triangles of a mesh for example),
+        // the leaves are tight and the user data of a leaf is the index of its box
+        void Build(const std::vector<BoundingBox>& boxes);
+
+        void SetUserData(const uint32_t proxy, const uint32_t user_data)    { m_nodes[proxy].user_data = user_data; }
+        uint32_t GetUserData(const uint32_t proxy) const                    { return m_nodes[proxy].user_data; }
+        const BoundingBox& GetBox(const uint32_t proxy) const               { return m_nodes[proxy].box; }
+        uint32_t GetLeafCount() const                                       { return m_leaf_count; }
+        uint32_t GetHeight() const                                          { return m_root != null_node ? static_cast<uint32_t>(m_nodes[m_root].height) : 0; }
+
+        // Visits the leaves which are (or might be) inside a frustum
+        template <typename Function>
+        void Query(const Frustum& frustum, Function&& function) const
+        {
+            Traverse([&frustum](const BoundingBox& box) { return frustum.IsVisible(box.GetCenter(), box.GetExtents()); }, function);
+        }
+
+        // Visits the leaves which overlap a sphere
+        template <typename Function>
+        void Query(const Vector3& center, const float radius, Function&& function) const
+        {
+            const float radius_squared = radius * radius;
+            Traverse([&center, radius_squared](const BoundingBox& box)
+            {
+                const Vector3& min = box.GetMin();
+                const Vector3& max = box.GetMax();
+                const Vector3 closest
+                (
+                    Helper::Clamp(center.x, min.x, max.x),
+                    Helper::Clamp(center.y, min.y, max.y),
+                    Helper::Clamp(center.z, min.z, max.z)
+                );
+                return Vector3::DistanceSquared(center, closest) <= radius_squared;
+            }, function);
+        }
+
+        // Visits the leaves which overlap a box
+        template <typename Function>
+        void Query(const BoundingBox& box, Function&& function) const
+        {
+            Traverse([&box](const BoundingBox& node_box) { return box.IsInside(node_box) != Outside; }, function);
+        }
+
+        // Visits the leaves which a ray hits
+        template <typename Function>
+        void Query(const Ray& ray, Function&& function) const
+        {
+            Traverse([&ray](const BoundingBox& box) { return ray.HitDistance(box) != INFINITY; }, function);
+        }
+
+    private:
+        struct Node
+        {
+            bool IsLeaf() const { return child_left == null_node; }
+
+            BoundingBox box;
+            uint32_t parent         = null_node; // the next free node, while the node is free
+            uint32_t child_left     = null_node;
+            uint32_t child_right    = null_node;
+            uint32_t user_data      = 0;
+            int32_t height          = -1; // zero for leaves, -1 for free nodes
+        };
+
+        // Any tree this deep is far from balanced, the rotations keep the height at roughly 1.44 * log2(leaf count)
+        static constexpr uint32_t traversal_stack_size = 128;
+
+        template <typename Overlaps, typename Function>
+        void Traverse(Overlaps&& overlaps, Function& function) const
+        {
+            if (m_root == null_node)
+                return;
+
+            std::array<uint32_t, traversal_stack_size> stack;
+            uint32_t stack_count = 0;
+            stack[stack_count++] = m_root;
+
+            while (stack_count != 0)
+            {
+                const Node& node = m_nodes[stack[--stack_count]];
+                if (!overlaps(node.box))
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    function(node.user_data);
+                }
+                else if (stack_count + 2 <= traversal_stack_size)
+                {
+                    stack[stack_count++] = node.child_left;
+                    stack[stack_count++] = node.child_right;
+                }
+            }
+        }
+
+        uint32_t BuildNode(uint32_t* indices, uint32_t count, const std::vector<BoundingBox>& boxes, uint32_t parent);
+        uint32_t NodeAllocate();
+        void NodeFree(uint32_t index);
+        void LeafInsert(uint32_t leaf);
+        void LeafRemove(uint32_t leaf);
+        // Rotates the children of a node if they are out of balance, returns the node which took its place
+        uint32_t Balance(uint32_t index);
+        // Walks up from a node, balancing and refitting the ancestors
+        void Refit(uint32_t index);
+
+        std::vector<Node> m_nodes;
+        uint32_t m_root         = null_node;
+        uint32_t m_free_list    = null_node;
+        uint32_t m_leaf_count   = 0;
+    };
+}
@@ -22,7 +22,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =======
 #include "Frustum.h"
 #include "Plane.h"
-#include <limits>
 //==================
 
 //= NAMESPACES =====
@@ -88,79 +87,80 @@ namespace Spartan::Math
 
     bool Frustum::IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane /*= false*/) const
     {
-        float radius = 0.0f;
-
-        if (!ignore_near_plane)
-        {
-            radius = Helper::Max3(extent.x, extent.y, extent.z);
-        }
-        else
+        // The near plane is the first, casters behind it can still cast shadows into the frustum
+        for (uint32_t i = ignore_near_plane ? 1 : 0; i < 6; i++)
         {
-            constexpr float z = numeric_limits<float>::infinity(); // reverse-z only (but I must read form Renderer)
-            radius = Helper::Max3(extent.x, extent.y, z);
-        }
-
-        // Check sphere first as it's cheaper
-        if (CheckSphere(center, radius) != Outside)
-            return true;
+            const Plane& plane  = m_planes[i];
+            const float d       = center.x * plane.normal.x + center.y * plane.normal.y + center.z * plane.normal.z;
+            const float r       = extent.x * Helper::Abs(plane.normal.x) + extent.y * Helper::Abs(plane.normal.y) + extent.z * Helper::Abs(plane.normal.z);
 
-        if (CheckCube(center, radius) != Outside)
-            return true;
+            if (d + r < -plane.d)
+                return false;
+        }
 
-        return false;
+        return true;
     }
 
-	Intersection Frustum::CheckCube(const Vector3& center, const Vector3& extent) const
-	{
-        Intersection result = Inside;
-        Plane plane_abs;
-
-		// Check if any one point of the cube is in the view frustum.
-		
-		for (const Plane& plane : m_planes)
-		{
-            plane_abs.normal    = plane.normal.Abs();
-            plane_abs.d         = plane.d;
-
-            const float d   = center.x * plane.normal.x + center.y * plane.normal.y + center.z * plane.normal.z;
-            const float r   = extent.x * plane_abs.normal.x + extent.y * plane_abs.normal.y + extent.z * plane_abs.normal.z;
-
-            const float d_p_r = d + r;
-            const float d_m_r = d - r;
-
-			if (d_p_r < -plane.d)
-			{
-				result = Outside;
-				break;
-			}
-
-			if (d_m_r < -plane.d)
-			{
-				result = Intersects;
-			}
-		}
-
-		return result;
-	}
+    void Frustum::IsVisible(const FrustumBoxes& boxes, vector<uint8_t>& visible, bool ignore_near_plane /*= false*/) const
+    {
+        const uint32_t count        = boxes.Count();
+        const uint32_t plane_first  = ignore_near_plane ? 1 : 0;
+        visible.resize(count);
+
+        uint32_t i = 0;
+#if defined(SPARTAN_MATH_SIMD)
+        using namespace Simd;
+
+        // The planes with their absolute normals, broadcast once for the whole batch
+        float4 plane_n[6][3];
+        float4 plane_n_abs[6][3];
+        float4 plane_d[6];
+        for (uint32_t p = plane_first; p < 6; p++)
+        {
+            const Plane& plane = m_planes[p];
+            plane_n[p][0]       = set(plane.normal.x);
+            plane_n[p][1]       = set(plane.normal.y);
+            plane_n[p][2]       = set(plane.normal.z);
+            plane_n_abs[p][0]   = set(Helper::Abs(plane.normal.x));
+            plane_n_abs[p][1]   = set(Helper::Abs(plane.normal.y));
+            plane_n_abs[p][2]   = set(Helper::Abs(plane.normal.z));
+            plane_d[p]          = set(-plane.d);
+        }
 
-	Intersection Frustum::CheckSphere(const Vector3& center, float radius) const
-	{
-		// calculate our distances to each of the planes
-		for (const auto& plane : m_planes)
-		{
-			// find the distance to this plane
-            const float distance = Vector3::Dot(plane.normal, center) + plane.d;
-
-			// if this distance is < -sphere.radius, we are outside
-			if (distance < -radius)
-				return Outside;
-
-			// else if the distance is between +- radius, then we intersect
-			if (static_cast<float>(Helper::Abs(distance)) < radius)
-				return Intersects;
-		}
-
-		// otherwise we are fully in view
-		return Inside;
-	}
+        // Four boxes at a time, the planes stop as soon as all four are behind one
+        for (; i + 4 <= count; i += 4)
+        {
+            const float4 center_x = load(boxes.center_x.data() + i);
+            const float4 center_y = load(boxes.center_y.data() + i);
+            const float4 center_z = load(boxes.center_z.data() + i);
+            const float4 extent_x = load(boxes.extent_x.data() + i);
+            const float4 extent_y = load(boxes.extent_y.data() + i);
+            const float4 extent_z = load(boxes.extent_z.data() + i);
+
+            int outside = 0;
+            for (uint32_t p = plane_first; p < 6 && outside != 0xF; p++)
+            {
+                float4 distance = mul(center_x, plane_n[p][0]);
+                distance        = madd(center_y, plane_n[p][1], distance);
+                distance        = madd(center_z, plane_n[p][2], distance);
+                distance        = madd(extent_x, plane_n_abs[p][0], distance);
+                distance        = madd(extent_y, plane_n_abs[p][1], distance);
+                distance        = madd(extent_z, plane_n_abs[p][2], distance);
+                outside        |= mask_bits(less(distance, plane_d[p]));
+            }
+
+            visible[i]      = (outside & 1) ? 0 : 1;
+            visible[i + 1]  = (outside & 2) ? 0 : 1;
+            visible[i + 2]  = (outside & 4) ? 0 : 1;
+            visible[i + 3]  = (outside & 8) ? 0 : 1;
+        }
+#endif
+        // What's left of the batch (or all of it, without SIMD)
+        for (; i < count; i++)
+        {
+            const Vector3 center(boxes.center_x[i], boxes.center_y[i], boxes.center_z[i]);
+            const Vector3 extent(boxes.extent_x[i], boxes.extent_y[i], boxes.extent_z[i]);
+            visible[i] = IsVisible(center, extent, ignore_near_plane) ? 1 : 0;
+        }
+    }
 }
@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES =============
+#include <vector>
 #include "../Math/Plane.h"
 #include "Matrix.h"
 #include "Vector3.h"
@@ -29,6 +30,31 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan::Math
 {
+    // Boxes laid out one component per array, so that a batch of them can be tested against a frustum a few at a time
+    struct FrustumBoxes
+    {
+        void Clear()
+        {
+            center_x.clear(); center_y.clear(); center_z.clear();
+            extent_x.clear(); extent_y.clear(); extent_z.clear();
+        }
+
+        void Add(const Vector3& center, const Vector3& extent)
+        {
+            center_x.emplace_back(center.x); center_y.emplace_back(center.y); center_z.emplace_back(center.z);
+            extent_x.emplace_back(extent.x); extent_y.emplace_back(extent.y); extent_z.emplace_back(extent.z);
+        }
+
+        uint32_t Count() const { return static_cast<uint32_t>(center_x.size()); }
+
+        std::vector<float> center_x;
+        std::vector<float> center_y;
+        std::vector<float> center_z;
+        std::vector<float> extent_x;
+        std::vector<float> extent_y;
+        std::vector<float> extent_z;
+    };
+
 	class Frustum
 	{
 	public:
@@ -36,12 +62,12 @@ namespace Spartan::Math
         Frustum(const Matrix& mView, const Matrix& mProjection, float screenDepth);
 		~Frustum() = default;
 
+        // A box is visible unless it's entirely behind one of the planes
         bool IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane = false) const;
+        // The same test for a batch of boxes, visible holds a 1 or a 0 per box
+        void IsVisible(const FrustumBoxes& boxes, std::vector<uint8_t>& visible, bool ignore_near_plane = false) const;
 
 	private:
-        Intersection CheckCube(const Vector3& center, const Vector3& extent) const;
-        Intersection CheckSphere(const Vector3& center, float radius) const;
-
 		Plane m_planes[6];
 	};
 }
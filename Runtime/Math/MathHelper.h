@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ====
 #include <cmath>
+#include <cstring>
 #include <limits>
 #include <random>
 //===============
@@ -132,4 +133,33 @@ namespace Spartan::Math::Helper
         n |= n >> 16;
         return n++;
     }
+
+    // Rounds to the nearest half float, values out of its range become infinities
+    inline uint16_t FloatToHalf(const float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign     = (bits >> 16) & 0x8000;
+        const int32_t exponent  = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa       = bits & 0x7FFFFF;
+
+        // Denormals
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+                return static_cast<uint16_t>(sign);
+
+            mantissa |= 0x800000;
+            const uint32_t shift    = static_cast<uint32_t>(14 - exponent);
+            const uint32_t half     = (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        if (exponent >= 31)
+            return static_cast<uint16_t>(sign | 0x7C00);
+
+        // A carry out of the mantissa rounds into the exponent, which is what it should do
+        const uint32_t half = ((static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1);
+        return static_cast<uint16_t>(sign | half);
+    }
 }
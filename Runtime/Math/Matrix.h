@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Quaternion.h"
 #include "Vector3.h"
 #include "Vector4.h"
+#include "Simd.h"
 //=====================
 
 namespace Spartan::Math
@@ -57,14 +58,23 @@ namespace Spartan::Math
 			this->m30 = m30; this->m31 = m31; this->m32 = m32; this->m33 = m33;
 		}
 
+		// The same as CreateScale(scale) * CreateRotation(rotation) * CreateTranslation(translation), without building the intermediate matrices
 		Matrix(const Vector3& translation, const Quaternion& rotation, const Vector3& scale)
 		{
-            const Matrix mRotation = CreateRotation(rotation);
-
-			m00 = scale.x * mRotation.m00;  m01 = scale.x * mRotation.m01;  m02 = scale.x * mRotation.m02;  m03 = 0.0f;
-			m10 = scale.y * mRotation.m10;  m11 = scale.y * mRotation.m11;  m12 = scale.y * mRotation.m12;  m13 = 0.0f;
-			m20 = scale.z * mRotation.m20;  m21 = scale.z * mRotation.m21;  m22 = scale.z * mRotation.m22;  m23 = 0.0f;
-			m30 = translation.x;            m31 = translation.y;            m32 = translation.z;            m33 = 1.0f;
+            const float xx = rotation.x * rotation.x;
+            const float yy = rotation.y * rotation.y;
+            const float zz = rotation.z * rotation.z;
+            const float xy = rotation.x * rotation.y;
+            const float zw = rotation.z * rotation.w;
+            const float zx = rotation.z * rotation.x;
+            const float yw = rotation.y * rotation.w;
+            const float yz = rotation.y * rotation.z;
+            const float xw = rotation.x * rotation.w;
+
+			m00 = scale.x * (1.0f - 2.0f * (yy + zz));  m01 = scale.x * 2.0f * (xy + zw);          m02 = scale.x * 2.0f * (zx - yw);          m03 = 0.0f;
+			m10 = scale.y * 2.0f * (xy - zw);          m11 = scale.y * (1.0f - 2.0f * (zz + xx));  m12 = scale.y * 2.0f * (yz + xw);          m13 = 0.0f;
+			m20 = scale.z * 2.0f * (zx + yw);          m21 = scale.z * 2.0f * (yz - xw);          m22 = scale.z * (1.0f - 2.0f * (yy + xx));  m23 = 0.0f;
+			m30 = translation.x;                       m31 = translation.y;                       m32 = translation.z;                       m33 = 1.0f;
 		}
 
         ~Matrix() = default;
@@ -286,6 +296,90 @@ namespace Spartan::Math
         [[nodiscard]] Matrix Inverted() const { return Invert(*this); }
 		static inline Matrix Invert(const Matrix& matrix)
 		{
+#if defined(SPARTAN_MATH_SSE)
+            // Cramer's rule on four lanes at a time (after Intel's "Streaming SIMD Extensions - Inverse of 4x4 Matrix"),
+            // the inverse of the transpose is the transpose of the inverse so it works on either memory order.
+            const float* src = matrix.Data();
+            __m128 minor0, minor1, minor2, minor3;
+            __m128 row0, row1, row2, row3;
+            __m128 det, tmp1;
+
+            tmp1    = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src)), reinterpret_cast<const __m64*>(src + 4));
+            row1    = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src + 8)), reinterpret_cast<const __m64*>(src + 12));
+            row0    = _mm_shuffle_ps(tmp1, row1, 0x88);
+            row1    = _mm_shuffle_ps(row1, tmp1, 0xDD);
+            tmp1    = _mm_loadh_pi(_mm_loadl_pi(tmp1, reinterpret_cast<const __m64*>(src + 2)), reinterpret_cast<const __m64*>(src + 6));
+            row3    = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(src + 10)), reinterpret_cast<const __m64*>(src + 14));
+            row2    = _mm_shuffle_ps(tmp1, row3, 0x88);
+            row3    = _mm_shuffle_ps(row3, tmp1, 0xDD);
+
+            tmp1    = _mm_mul_ps(row2, row3);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+            minor0  = _mm_mul_ps(row1, tmp1);
+            minor1  = _mm_mul_ps(row0, tmp1);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+            minor0  = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0);
+            minor1  = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
+            minor1  = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+            tmp1    = _mm_mul_ps(row1, row2);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+            minor0  = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0);
+            minor3  = _mm_mul_ps(row0, tmp1);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+            minor0  = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1));
+            minor3  = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
+            minor3  = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+            tmp1    = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+            row2    = _mm_shuffle_ps(row2, row2, 0x4E);
+            minor0  = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0);
+            minor2  = _mm_mul_ps(row0, tmp1);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+            minor0  = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1));
+            minor2  = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
+            minor2  = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+            tmp1    = _mm_mul_ps(row0, row1);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+            minor2  = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
+            minor3  = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+            minor2  = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
+            minor3  = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+
+            tmp1    = _mm_mul_ps(row0, row3);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+            minor1  = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
+            minor2  = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+            minor1  = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
+            minor2  = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+
+            tmp1    = _mm_mul_ps(row0, row2);
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+            minor1  = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
+            minor3  = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
+            tmp1    = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+            minor1  = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
+            minor3  = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
+
+            // A full division rather than the reciprocal estimate, the inverse of the view projection is used to reconstruct positions
+            det     = _mm_mul_ps(row0, minor0);
+            det     = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+            det     = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
+            det     = _mm_div_ss(_mm_set_ss(1.0f), det);
+            det     = _mm_shuffle_ps(det, det, 0x00);
+
+            Matrix result;
+            float* dst = const_cast<float*>(result.Data());
+            _mm_storeu_ps(dst,      _mm_mul_ps(det, minor0));
+            _mm_storeu_ps(dst + 4,  _mm_mul_ps(det, minor1));
+            _mm_storeu_ps(dst + 8,  _mm_mul_ps(det, minor2));
+            _mm_storeu_ps(dst + 12, _mm_mul_ps(det, minor3));
+            return result;
+#else
 			float v0 = matrix.m20 * matrix.m31 - matrix.m21 * matrix.m30;
 			float v1 = matrix.m20 * matrix.m32 - matrix.m22 * matrix.m30;
 			float v2 = matrix.m20 * matrix.m33 - matrix.m23 *matrix.m30;
@@ -339,6 +433,7 @@ namespace Spartan::Math
 				i10, i11, i12, i13,
 				i20, i21, i22, i23,
 				i30, i31, i32, i33);
+#endif
 		}
 		//================================================================================================
 
@@ -360,6 +455,29 @@ namespace Spartan::Math
 		//= MULTIPLICATION ================================================================================================================
 		Matrix operator*(const Matrix& rhs) const
 		{
+#if defined(SPARTAN_MATH_SIMD)
+            // The columns are contiguous, each column of the product is the columns of this matrix weighted by a column of rhs
+            using namespace Simd;
+            const float* lhs_data   = Data();
+            const float* rhs_data   = rhs.Data();
+            const float4 c0         = load(lhs_data);
+            const float4 c1         = load(lhs_data + 4);
+            const float4 c2         = load(lhs_data + 8);
+            const float4 c3         = load(lhs_data + 12);
+
+            Matrix result;
+            float* result_data = const_cast<float*>(result.Data());
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                const float4 column = load(rhs_data + i * 4);
+                float4 value        = mul(c0, splat<0>(column));
+                value               = madd(c1, splat<1>(column), value);
+                value               = madd(c2, splat<2>(column), value);
+                value               = madd(c3, splat<3>(column), value);
+                store(result_data + i * 4, value);
+            }
+            return result;
+#else
 			return Matrix(
 				m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20 + m03 * rhs.m30,
 				m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21 + m03 * rhs.m31,
@@ -378,12 +496,21 @@ namespace Spartan::Math
 				m30 * rhs.m02 + m31 * rhs.m12 + m32 * rhs.m22 + m33 * rhs.m32,
 				m30 * rhs.m03 + m31 * rhs.m13 + m32 * rhs.m23 + m33 * rhs.m33
 			);
+#endif
 		}
 
 		void operator*=(const Matrix& rhs) { (*this) = (*this) * rhs; }
 
 		Vector3 operator*(const Vector3& rhs) const
 		{
+#if defined(SPARTAN_MATH_SIMD)
+            using namespace Simd;
+            const float* data = Data();
+            alignas(16) float result[4];
+            store(result, dot4(set(rhs.x, rhs.y, rhs.z, 1.0f), load(data), load(data + 4), load(data + 8), load(data + 12)));
+            const float w_inverted = 1.0f / result[3];
+            return Vector3(result[0] * w_inverted, result[1] * w_inverted, result[2] * w_inverted);
+#else
 			Vector4 vWorking;
 
 			vWorking.x = (rhs.x * m00) + (rhs.y * m10) + (rhs.z * m20) + m30;
@@ -392,10 +519,18 @@ namespace Spartan::Math
 			vWorking.w = 1 / ((rhs.x * m03) + (rhs.y * m13) + (rhs.z * m23) + m33);
 
 			return Vector3(vWorking.x * vWorking.w, vWorking.y * vWorking.w, vWorking.z * vWorking.w);
+#endif
 		}
 
         Vector4 operator*(const Vector4& rhs) const
         {
+#if defined(SPARTAN_MATH_SIMD)
+            using namespace Simd;
+            const float* data = Data();
+            Vector4 result;
+            store(&result.x, dot4(load(rhs.Data()), load(data), load(data + 4), load(data + 8), load(data + 12)));
+            return result;
+#else
             return Vector4
             (
                 (rhs.x * m00) + (rhs.y * m10) + (rhs.z * m20) + (rhs.w * m30),
@@ -403,6 +538,7 @@ namespace Spartan::Math
                 (rhs.x * m02) + (rhs.y * m12) + (rhs.z * m22) + (rhs.w * m32),
                 (rhs.x * m03) + (rhs.y * m13) + (rhs.z * m23) + (rhs.w * m33)
             );
+#endif
         }
 		//=================================================================================================================================
 
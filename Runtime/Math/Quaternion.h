@@ -215,6 +215,19 @@ namespace Spartan::Math
                 return *this;
 		}
 
+        // Interpolates along the shortest arc and normalizes, close enough to a slerp for small angles (like those between two steps)
+        static inline Quaternion Lerp(const Quaternion& from, const Quaternion& to, float t)
+        {
+            const float dot = from.x * to.x + from.y * to.y + from.z * to.z + from.w * to.w;
+            const float sign = dot < 0.0f ? -1.0f : 1.0f;
+            return Quaternion(
+                from.x + (to.x * sign - from.x) * t,
+                from.y + (to.y * sign - from.y) * t,
+                from.z + (to.z * sign - from.z) * t,
+                from.w + (to.w * sign - from.w) * t
+            ).Normalized();
+        }
+
         // Returns the inverse
 		Quaternion Inverse() const 
 		{
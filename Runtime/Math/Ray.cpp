@@ -28,6 +28,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../World/Entity.h"
 #include "../World/Components/Environment.h"
 #include "../World/Components/Renderable.h"
+#include "../Rendering/Renderer.h"
 //=========================================
 
 //= NAMESPACES =====
@@ -47,17 +48,19 @@ namespace Spartan::Math
 
 	vector<RayHit> Ray::Trace(Context* context) const
 	{
-		// Find all the entities that the ray hits
+		// Find all the entities that the ray might hit, the renderer's bounding volume hierarchy only visits the ones along the ray
 		vector<RayHit> hits;
-		const auto& entities = context->GetSubsystem<World>()->EntityGetAll();
-		for (const auto& entity : entities)
+        vector<Entity*> entities;
+        context->GetSubsystem<Renderer>()->Query(*this, entities);
+		for (Entity* entity : entities)
 		{
-			// Make sure there entity has a renderable
-			if (!entity->HasComponent<Renderable>())
-				continue;
+            // The renderable could have been removed since the renderer's snapshot
+            Renderable* renderable = entity->GetRenderable();
+            if (!renderable)
+                continue;
 
 			// Get object oriented bounding box
-			const auto& aabb = entity->GetComponent<Renderable>()->GetAabb();
+			const auto& aabb = renderable->GetAabb();
 
 			// Compute hit distance
 			auto distance = HitDistance(aabb);
@@ -67,7 +70,7 @@ namespace Spartan::Math
 				continue;
 
 			hits.emplace_back(
-                entity,                             // Entity
+                entity->GetPtrShared(),             // Entity
                 m_start + distance * m_direction,   // Position
                 distance,                           // Distance
                 distance == 0.0f                    // Inside
@@ -175,4 +178,29 @@ namespace Spartan::Math
 
 		return dist;
 	}
+
+    float Ray::HitDistance(const Vector3& v1, const Vector3& v2, const Vector3& v3) const
+    {
+        // Moller-Trumbore, both sides of the triangle are hit
+        const Vector3 edge1 = v2 - v1;
+        const Vector3 edge2 = v3 - v1;
+        const Vector3 p     = Vector3::Cross(m_direction, edge2);
+        const float det     = Vector3::Dot(edge1, p);
+        if (det == 0.0f) // parallel
+            return INFINITY;
+
+        const float det_inv = 1.0f / det;
+        const Vector3 t     = m_start - v1;
+        const float u       = Vector3::Dot(t, p) * det_inv;
+        if (u < 0.0f || u > 1.0f)
+            return INFINITY;
+
+        const Vector3 q = Vector3::Cross(t, edge1);
+        const float v   = Vector3::Dot(m_direction, q) * det_inv;
+        if (v < 0.0f || u + v > 1.0f)
+            return INFINITY;
+
+        const float distance = Vector3::Dot(edge2, q) * det_inv;
+        return distance >= 0.0f ? distance : INFINITY;
+    }
 }
@@ -49,6 +49,9 @@ namespace Spartan
 			// Returns hit distance to a bounding box, or infinity if there is no hit.
 			float HitDistance(const BoundingBox& box) const;
 
+			// Returns hit distance to a triangle, or infinity if there is no hit.
+			float HitDistance(const Vector3& v1, const Vector3& v2, const Vector3& v3) const;
+
 			const auto& GetStart()      const { return m_start; }
 			const auto& GetEnd()        const { return m_end; }
             const auto& GetLength()     const { return m_length; }
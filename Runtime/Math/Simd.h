@@ -0,0 +1,114 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+// The SIMD paths of the math classes, picked by the target (define SPARTAN_MATH_SCALAR to build the scalar ones instead).
+// Loads and stores are unaligned, the classes keep their plain float layout since they are copied into GPU buffers and files as they are.
+#if !defined(SPARTAN_MATH_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define SPARTAN_MATH_SSE
+    #include <emmintrin.h>
+    #if defined(__FMA__) || defined(__AVX2__)
+        #include <immintrin.h>
+    #endif
+#elif !defined(SPARTAN_MATH_SCALAR) && (defined(__aarch64__) || defined(_M_ARM64))
+    #define SPARTAN_MATH_NEON
+    #include <arm_neon.h>
+#endif
+
+#if defined(SPARTAN_MATH_SSE) || defined(SPARTAN_MATH_NEON)
+#define SPARTAN_MATH_SIMD
+
+namespace Spartan::Math::Simd
+{
+#if defined(SPARTAN_MATH_SSE)
+    using float4 = __m128;
+    using mask4  = __m128;
+
+    inline float4 load(const float* data)                               { return _mm_loadu_ps(data); }
+    inline void store(float* data, const float4 v)                      { _mm_storeu_ps(data, v); }
+    inline float4 set(const float x, const float y, const float z, const float w) { return _mm_set_ps(w, z, y, x); }
+    inline float4 set(const float value)                                { return _mm_set1_ps(value); }
+    inline float4 add(const float4 a, const float4 b)                   { return _mm_add_ps(a, b); }
+    inline float4 sub(const float4 a, const float4 b)                   { return _mm_sub_ps(a, b); }
+    inline float4 mul(const float4 a, const float4 b)                   { return _mm_mul_ps(a, b); }
+    inline float4 abs(const float4 v)                                   { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+    template <int lane> inline float4 splat(const float4 v)             { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(lane, lane, lane, lane)); }
+
+    // Lane masks, mask_bits() packs them into the low four bits (lane 0 first)
+    inline mask4 less(const float4 a, const float4 b)                   { return _mm_cmplt_ps(a, b); }
+    inline mask4 mask_or(const mask4 a, const mask4 b)                  { return _mm_or_ps(a, b); }
+    inline int mask_bits(const mask4 mask)                              { return _mm_movemask_ps(mask); }
+
+    // a * b + c, fused when the target has FMA (AVX2)
+    inline float4 madd(const float4 a, const float4 b, const float4 c)
+    {
+    #if defined(__FMA__) || defined(__AVX2__)
+        return _mm_fmadd_ps(a, b, c);
+    #else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    #endif
+    }
+
+    // The dot products of v with a, b, c and d
+    inline float4 dot4(const float4 v, float4 a, float4 b, float4 c, float4 d)
+    {
+        a = _mm_mul_ps(v, a);
+        b = _mm_mul_ps(v, b);
+        c = _mm_mul_ps(v, c);
+        d = _mm_mul_ps(v, d);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        return _mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d));
+    }
+#elif defined(SPARTAN_MATH_NEON)
+    using float4 = float32x4_t;
+    using mask4  = uint32x4_t;
+
+    inline float4 load(const float* data)                               { return vld1q_f32(data); }
+    inline void store(float* data, const float4 v)                      { vst1q_f32(data, v); }
+    inline float4 set(const float x, const float y, const float z, const float w) { const float data[4] = { x, y, z, w }; return vld1q_f32(data); }
+    inline float4 set(const float value)                                { return vdupq_n_f32(value); }
+    inline float4 add(const float4 a, const float4 b)                   { return vaddq_f32(a, b); }
+    inline float4 sub(const float4 a, const float4 b)                   { return vsubq_f32(a, b); }
+    inline float4 mul(const float4 a, const float4 b)                   { return vmulq_f32(a, b); }
+    inline float4 abs(const float4 v)                                   { return vabsq_f32(v); }
+    template <int lane> inline float4 splat(const float4 v)             { return vdupq_laneq_f32(v, lane); }
+
+    // Lane masks, mask_bits() packs them into the low four bits (lane 0 first)
+    inline mask4 less(const float4 a, const float4 b)                   { return vcltq_f32(a, b); }
+    inline mask4 mask_or(const mask4 a, const mask4 b)                  { return vorrq_u32(a, b); }
+    inline int mask_bits(const mask4 mask)
+    {
+        const uint32_t bits[4] = { 1, 2, 4, 8 };
+        return static_cast<int>(vaddvq_u32(vandq_u32(mask, vld1q_u32(bits))));
+    }
+    inline float4 madd(const float4 a, const float4 b, const float4 c)  { return vfmaq_f32(c, a, b); }
+
+    // The dot products of v with a, b, c and d
+    inline float4 dot4(const float4 v, const float4 a, const float4 b, const float4 c, const float4 d)
+    {
+        const float4 ab = vpaddq_f32(vmulq_f32(v, a), vmulq_f32(v, b));
+        const float4 cd = vpaddq_f32(vmulq_f32(v, c), vmulq_f32(v, d));
+        return vpaddq_f32(ab, cd);
+    }
+#endif
+}
+#endif
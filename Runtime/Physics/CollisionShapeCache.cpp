@@ -0,0 +1,174 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================================
+#include "CollisionShapeCache.h"
+#include "BulletPhysicsHelper.h"
+#include "../Logging/Log.h"
+#pragma warning(push, 0) // Hide warnings which belong to Bullet
+#include <BulletCollision/CollisionShapes/btConvexHullShape.h>
+#pragma warning(pop)
+//=====================================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    bool CollisionShapeKey::operator<(const CollisionShapeKey& rhs) const
+    {
+        if (type != rhs.type)                                   return type < rhs.type;
+        if (geometry != rhs.geometry)                           return geometry < rhs.geometry;
+        if (geometry_vertex_count != rhs.geometry_vertex_count) return geometry_vertex_count < rhs.geometry_vertex_count;
+        if (optimize != rhs.optimize)                           return optimize < rhs.optimize;
+
+        const float lhs_values[6] = { size.x, size.y, size.z, scale.x, scale.y, scale.z };
+        const float rhs_values[6] = { rhs.size.x, rhs.size.y, rhs.size.z, rhs.scale.x, rhs.scale.y, rhs.scale.z };
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            if (lhs_values[i] != rhs_values[i])
+                return lhs_values[i] < rhs_values[i];
+        }
+
+        return false;
+    }
+
+    CollisionShapeCache::~CollisionShapeCache()
+    {
+        if (!m_shapes.empty())
+        {
+            LOG_WARNING("%d collision shapes are still referenced", static_cast<uint32_t>(m_shapes.size()));
+        }
+
+        for (auto& it : m_shapes)
+        {
+            delete it.second.shape;
+        }
+    }
+
+    btCollisionShape* CollisionShapeCache::Acquire(const CollisionShapeKey& key, const function<btCollisionShape*()>& create)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto it = m_shapes.find(key);
+        if (it != m_shapes.end())
+        {
+            it->second.references++;
+            return it->second.shape;
+        }
+
+        btCollisionShape* shape = create();
+        if (!shape)
+            return nullptr;
+
+        m_shapes[key]   = { shape, 1 };
+        m_keys[shape]   = key;
+        return shape;
+    }
+
+    btCollisionShape* CollisionShapeCache::AcquireHull(const CollisionShapeKey& key, const function<bool(vector<btVector3>& points)>& get_points)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto it = m_shapes.find(key);
+        if (it != m_shapes.end())
+        {
+            it->second.references++;
+            return it->second.shape;
+        }
+
+        // The points, computed for the first scale of the geometry
+        const CollisionShapeKey hull_key = GetHullKey(key);
+        auto it_hull = m_hulls.find(hull_key);
+        if (it_hull == m_hulls.end())
+        {
+            Hull hull;
+            if (!get_points(hull.points) || hull.points.empty())
+                return nullptr;
+
+            // An optimized hull keeps the points which lie on it (the hull of the scaled points is the scaled hull, so this is done unscaled)
+            if (key.optimize)
+            {
+                btConvexHullShape shape_optimized(reinterpret_cast<const btScalar*>(hull.points.data()), static_cast<int>(hull.points.size()), sizeof(btVector3));
+                shape_optimized.optimizeConvexHull();
+                hull.points.assign(shape_optimized.getUnscaledPoints(), shape_optimized.getUnscaledPoints() + shape_optimized.getNumPoints());
+            }
+
+            it_hull = m_hulls.emplace(hull_key, move(hull)).first;
+        }
+
+        btConvexHullShape* shape = new btConvexHullShape(reinterpret_cast<const btScalar*>(it_hull->second.points.data()), static_cast<int>(it_hull->second.points.size()), sizeof(btVector3));
+        shape->setLocalScaling(ToBtVector3(key.scale));
+        if (key.optimize)
+        {
+            shape->initializePolyhedralFeatures();
+        }
+        it_hull->second.references++;
+
+        m_shapes[key]   = { shape, 1 };
+        m_keys[shape]   = key;
+        return shape;
+    }
+
+    void CollisionShapeCache::Release(btCollisionShape* shape)
+    {
+        if (!shape)
+            return;
+
+        lock_guard<mutex> lock(m_mutex);
+
+        auto it_key = m_keys.find(shape);
+        if (it_key == m_keys.end())
+        {
+            LOG_ERROR("The shape doesn't belong to the cache");
+            return;
+        }
+
+        const CollisionShapeKey key = it_key->second;
+        Shape& entry = m_shapes[key];
+        if (--entry.references != 0)
+            return;
+
+        delete entry.shape;
+        m_shapes.erase(key);
+        m_keys.erase(it_key);
+
+        if (key.geometry != 0)
+        {
+            auto it_hull = m_hulls.find(GetHullKey(key));
+            if (it_hull != m_hulls.end() && --it_hull->second.references == 0)
+            {
+                m_hulls.erase(it_hull);
+            }
+        }
+    }
+
+    CollisionShapeKey CollisionShapeCache::GetHullKey(const CollisionShapeKey& key)
+    {
+        // Any scale
+        CollisionShapeKey hull_key  = key;
+        hull_key.size               = Vector3::Zero;
+        hull_key.scale              = Vector3::One;
+        return hull_key;
+    }
+}
@@ -0,0 +1,88 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <map>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include "../Math/Vector3.h"
+//=============================
+
+class btCollisionShape;
+class btVector3;
+
+namespace Spartan
+{
+    // What makes two collision shapes interchangeable, the shape type (ColliderShape), its size and scale and, for hulls, the geometry they are built from
+    struct CollisionShapeKey
+    {
+        uint32_t type                   = 0;
+        Math::Vector3 size              = Math::Vector3::Zero;
+        Math::Vector3 scale             = Math::Vector3::One;
+        uint64_t geometry               = 0; // model id and vertex offset, 0 for primitives
+        uint32_t geometry_vertex_count  = 0;
+        bool optimize                   = false;
+
+        bool operator<(const CollisionShapeKey& rhs) const;
+    };
+
+    // Collision shapes are immutable once they are created, so colliders which agree on a key share a single one, reference counted.
+    // The points of a convex hull are computed (and optimized) once per geometry and shared between the hulls of different scales.
+    class CollisionShapeCache
+    {
+    public:
+        CollisionShapeCache() = default;
+        ~CollisionShapeCache();
+
+        // Returns the shape of the key, creating it the first time
+        btCollisionShape* Acquire(const CollisionShapeKey& key, const std::function<btCollisionShape*()>& create);
+        // Returns the convex hull of the key, the points are requested the first time (the geometry's vertex positions)
+        btCollisionShape* AcquireHull(const CollisionShapeKey& key, const std::function<bool(std::vector<btVector3>& points)>& get_points);
+        // Every acquired shape is released once, the last release deletes it
+        void Release(btCollisionShape* shape);
+
+        uint32_t GetShapeCount() const { return static_cast<uint32_t>(m_shapes.size()); }
+
+    private:
+        struct Shape
+        {
+            btCollisionShape* shape = nullptr;
+            uint32_t references     = 0;
+        };
+
+        struct Hull
+        {
+            std::vector<btVector3> points; // unscaled
+            uint32_t references = 0;      // per cached shape
+        };
+
+        static CollisionShapeKey GetHullKey(const CollisionShapeKey& key);
+
+        std::map<CollisionShapeKey, Shape> m_shapes;
+        std::unordered_map<const btCollisionShape*, CollisionShapeKey> m_keys;
+        std::map<CollisionShapeKey, Hull> m_hulls;
+        std::mutex m_mutex;
+    };
+}
@@ -21,21 +21,31 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===================================================================
 #include "Physics.h"
+#include <algorithm>
 #include "PhysicsDebugDraw.h"
+#include "CollisionShapeCache.h"
 #include "BulletPhysicsHelper.h"
 #include "../Core/Engine.h"
 #include "../Core/Context.h"
 #include "../Core/Settings.h"
+#include "../Core/Timer.h"
 #include "../Profiling/Profiler.h"
 #include "../Rendering/Renderer.h"
+#include "../Threading/Threading.h"
+#include "../World/Components/RigidBody.h"
+#include "../World/Entity.h"
 #pragma warning(push, 0) // Hide warnings belonging to Bullet
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 #include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
 #include <BulletSoftBody/btSoftBody.h>
 #include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
 #include <BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h>
 #pragma warning(pop)
 //==============================================================================
@@ -47,26 +57,363 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
-    static const bool m_soft_body_support = true;
+    // Bullet's multithreaded world runs collision dispatch and island solving in parallel, but it can't host soft bodies.
+    // It takes a Bullet which was built with BT_THREADSAFE, and the engine has to be built with the same define.
+#if defined(BT_THREADSAFE) && BT_THREADSAFE
+    static const bool m_multithreaded = true;
+#else
+    static const bool m_multithreaded = false;
+#endif
+    static const bool m_soft_body_support = !m_multithreaded;
+
+    namespace _Physics
+    {
+        // Runs Bullet's parallel loops on the frame workers, so that there is no second thread pool competing for the cores
+        class TaskScheduler : public btITaskScheduler
+        {
+        public:
+            TaskScheduler(Threading* threading) : btITaskScheduler("Spartan"), m_threading(threading) {}
+
+            // Bullet keeps state per thread (btGetCurrentThreadIndex()), for every frame worker and the threads which step (main and simulation)
+            int getMaxNumThreads() const override   { return static_cast<int>(m_threading->GetThreadCount(Threading_Pool_Frame)) + 2; }
+            int getNumThreads() const override      { return getMaxNumThreads(); }
+            void setNumThreads(int) override        {} // the frame pool has a size of its own
+
+            void parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body) override
+            {
+                if (end <= begin)
+                    return;
+
+                m_threading->ParallelFor([begin, &body](uint32_t start, uint32_t stop)
+                {
+                    body.forLoop(begin + static_cast<int>(start), begin + static_cast<int>(stop));
+                }, static_cast<uint32_t>(end - begin), static_cast<uint32_t>(Helper::Max(grain_size, 1)));
+            }
+
+            btScalar parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body) override
+            {
+                if (end <= begin)
+                    return btScalar(0);
+
+                // A sum per chunk, added up in order so that the result doesn't depend on which thread took which chunk
+                const uint32_t range        = static_cast<uint32_t>(end - begin);
+                const uint32_t chunk_size   = static_cast<uint32_t>(Helper::Max(grain_size, 1));
+                vector<btScalar> sums((range + chunk_size - 1) / chunk_size, btScalar(0));
+                m_threading->ParallelFor([begin, chunk_size, &body, &sums](uint32_t start, uint32_t stop)
+                {
+                    sums[start / chunk_size] = body.sumLoop(begin + static_cast<int>(start), begin + static_cast<int>(stop));
+                }, range, chunk_size);
+
+                btScalar sum = btScalar(0);
+                for (const btScalar value : sums)
+                {
+                    sum += value;
+                }
+                return sum;
+            }
+
+        private:
+            Threading* m_threading = nullptr;
+        };
+
+        // The broadphase as soft bodies see it (btSoftBodyWorldInfo), serialized so that bodies which predict their motion in parallel can update their bounds
+        class SoftBodyBroadphase : public btBroadphaseInterface
+        {
+        public:
+            SoftBodyBroadphase(btBroadphaseInterface* broadphase) : m_broadphase(broadphase) {}
+
+            btBroadphaseProxy* createProxy(const btVector3& aabb_min, const btVector3& aabb_max, int shape_type, void* user, int group, int mask, btDispatcher* dispatcher) override
+            {
+                lock_guard<mutex> lock(m_mutex);
+                return m_broadphase->createProxy(aabb_min, aabb_max, shape_type, user, group, mask, dispatcher);
+            }
+            void destroyProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher) override                                          { lock_guard<mutex> lock(m_mutex); m_broadphase->destroyProxy(proxy, dispatcher); }
+            void setAabb(btBroadphaseProxy* proxy, const btVector3& aabb_min, const btVector3& aabb_max, btDispatcher* dispatcher) override { lock_guard<mutex> lock(m_mutex); m_broadphase->setAabb(proxy, aabb_min, aabb_max, dispatcher); }
+            void getAabb(btBroadphaseProxy* proxy, btVector3& aabb_min, btVector3& aabb_max) const override                         { lock_guard<mutex> lock(m_mutex); m_broadphase->getAabb(proxy, aabb_min, aabb_max); }
+            void rayTest(const btVector3& from, const btVector3& to, btBroadphaseRayCallback& callback, const btVector3& aabb_min, const btVector3& aabb_max) override { lock_guard<mutex> lock(m_mutex); m_broadphase->rayTest(from, to, callback, aabb_min, aabb_max); }
+            void aabbTest(const btVector3& aabb_min, const btVector3& aabb_max, btBroadphaseAabbCallback& callback) override         { lock_guard<mutex> lock(m_mutex); m_broadphase->aabbTest(aabb_min, aabb_max, callback); }
+            void calculateOverlappingPairs(btDispatcher* dispatcher) override                                                       { lock_guard<mutex> lock(m_mutex); m_broadphase->calculateOverlappingPairs(dispatcher); }
+            btOverlappingPairCache* getOverlappingPairCache() override                                                              { return m_broadphase->getOverlappingPairCache(); }
+            const btOverlappingPairCache* getOverlappingPairCache() const override                                                  { return m_broadphase->getOverlappingPairCache(); }
+            void getBroadphaseAabb(btVector3& aabb_min, btVector3& aabb_max) const override                                         { lock_guard<mutex> lock(m_mutex); m_broadphase->getBroadphaseAabb(aabb_min, aabb_max); }
+            void resetPool(btDispatcher* dispatcher) override                                                                       { lock_guard<mutex> lock(m_mutex); m_broadphase->resetPool(dispatcher); }
+            void printStats() override                                                                                              { m_broadphase->printStats(); }
+
+        private:
+            btBroadphaseInterface* m_broadphase = nullptr;
+            mutable mutex m_mutex;
+        };
+
+        // Bullet's soft body solver, with the per body work spread over the frame workers
+        class SoftBodySolver : public btDefaultSoftBodySolver
+        {
+        public:
+            SoftBodySolver(Threading* threading) : m_threading(threading) {}
+
+            void predictMotion(btScalar dt) override
+            {
+                // Bodies only share the broadphase here (see SoftBodyBroadphase)
+                GatherActive();
+                m_threading->ParallelFor([this, dt](uint32_t start, uint32_t end)
+                {
+                    for (uint32_t i = start; i < end; i++)
+                    {
+                        m_active[i]->predictMotion(dt);
+                    }
+                }, static_cast<uint32_t>(m_active.size()), 1);
+            }
+
+            void solveConstraints(btScalar) override
+            {
+                // Bodies which push the same dynamic rigid body (contacts, anchors) are solved by the same thread, so are the ones touching other soft bodies
+                GatherActive();
+                const uint32_t count = static_cast<uint32_t>(m_active.size());
+                m_parents.resize(count + 1); // the last one stands for all soft-soft contacts
+                for (uint32_t i = 0; i <= count; i++)
+                {
+                    m_parents[i] = i;
+                }
+                m_owners.clear();
+
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    btSoftBody* body = m_active[i];
+
+                    for (int j = 0; j < body->m_rcontacts.size(); j++)
+                    {
+                        Join(i, btRigidBody::upcast(body->m_rcontacts[j].m_cti.m_colObj));
+                    }
+
+                    for (int j = 0; j < body->m_anchors.size(); j++)
+                    {
+                        Join(i, body->m_anchors[j].m_body);
+                    }
+
+                    if (body->m_scontacts.size() != 0)
+                    {
+                        Union(i, count);
+                    }
+                }
+
+                // Groups, in body order
+                m_groups.clear();
+                m_group_of.assign(count + 1, -1);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const uint32_t root = Find(i);
+                    if (m_group_of[root] == -1)
+                    {
+                        m_group_of[root] = static_cast<int>(m_groups.size());
+                        m_groups.emplace_back();
+                    }
+                    m_groups[m_group_of[root]].emplace_back(m_active[i]);
+                }
+
+                m_threading->ParallelFor([this](uint32_t start, uint32_t end)
+                {
+                    for (uint32_t i = start; i < end; i++)
+                    {
+                        for (btSoftBody* body : m_groups[i])
+                        {
+                            body->solveConstraints();
+                        }
+                    }
+                }, static_cast<uint32_t>(m_groups.size()), 1);
+            }
+
+            void updateSoftBodies() override
+            {
+                GatherActive();
+                m_threading->ParallelFor([this](uint32_t start, uint32_t end)
+                {
+                    for (uint32_t i = start; i < end; i++)
+                    {
+                        m_active[i]->integrateMotion();
+                    }
+                }, static_cast<uint32_t>(m_active.size()), 1);
+            }
+
+        private:
+            void GatherActive()
+            {
+                m_active.clear();
+                for (int i = 0; i < m_softBodySet.size(); i++)
+                {
+                    if (m_softBodySet[i]->isActive())
+                    {
+                        m_active.emplace_back(m_softBodySet[i]);
+                    }
+                }
+            }
+
+            void Join(const uint32_t body, const btRigidBody* rigid_body)
+            {
+                // Static and kinematic bodies don't take impulses
+                if (!rigid_body || rigid_body->getInvMass() == 0.0f)
+                    return;
+
+                auto it = m_owners.find(rigid_body);
+                if (it == m_owners.end())
+                {
+                    m_owners[rigid_body] = body;
+                }
+                else
+                {
+                    Union(body, it->second);
+                }
+            }
+
+            uint32_t Find(uint32_t i)
+            {
+                while (m_parents[i] != i)
+                {
+                    m_parents[i] = m_parents[m_parents[i]];
+                    i = m_parents[i];
+                }
+                return i;
+            }
+
+            void Union(const uint32_t a, const uint32_t b) { m_parents[Find(a)] = Find(b); }
+
+            Threading* m_threading = nullptr;
+            vector<btSoftBody*> m_active;
+            vector<uint32_t> m_parents;
+            vector<int> m_group_of;
+            vector<vector<btSoftBody*>> m_groups;
+            unordered_map<const btRigidBody*, uint32_t> m_owners;
+        };
+
+        // The deepest contact of a query shape, the shape is the first object of every result
+        class OverlapCallback : public btCollisionWorld::ContactResultCallback
+        {
+        public:
+            btScalar addSingleResult(btManifoldPoint& point, const btCollisionObjectWrapper* wrapper_own, int, int, const btCollisionObjectWrapper* wrapper_other, int, int) override
+            {
+                if (point.getDistance() < m_distance)
+                {
+                    m_distance  = point.getDistance();
+                    m_object    = wrapper_other->getCollisionObject();
+                    m_position  = point.getPositionWorldOnB();
+                    m_normal    = point.m_normalWorldOnB;
+                }
+                return 0;
+            }
+
+            const btCollisionObject* m_object   = nullptr;
+            btScalar m_distance                 = BT_LARGE_FLOAT;
+            btVector3 m_position                = btVector3(0, 0, 0);
+            btVector3 m_normal                  = btVector3(0, 0, 0);
+        };
+
+        static Entity* get_entity(const btCollisionObject* object)
+        {
+            // Rigid bodies are the only ones which add btRigidBody, with themselves as the user pointer
+            const btRigidBody* body = btRigidBody::upcast(object);
+            const RigidBody* rigid_body = body ? static_cast<const RigidBody*>(body->getUserPointer()) : nullptr;
+            return rigid_body ? rigid_body->GetEntity() : nullptr;
+        }
+
+        static void query(const btCollisionWorld* world, const PhysicsQuery& query, PhysicsHit& hit)
+        {
+            hit = PhysicsHit();
+
+            const btVector3 from = ToBtVector3(query.from);
+            const btVector3 to   = ToBtVector3(query.to);
+
+            if (query.type == PhysicsQuery_Ray)
+            {
+                btCollisionWorld::ClosestRayResultCallback callback(from, to);
+                world->rayTest(from, to, callback);
+                if (callback.hasHit())
+                {
+                    hit.hit         = true;
+                    hit.entity      = get_entity(callback.m_collisionObject);
+                    hit.position    = ToVector3(callback.m_hitPointWorld);
+                    hit.normal      = ToVector3(callback.m_hitNormalWorld);
+                    hit.fraction    = callback.m_closestHitFraction;
+                }
+                return;
+            }
+
+            btSphereShape sphere(query.extent.x);
+            btBoxShape box(ToBtVector3(query.extent));
+            const bool is_sphere = query.type == PhysicsQuery_SphereSweep || query.type == PhysicsQuery_SphereOverlap;
+
+            if (query.type == PhysicsQuery_SphereSweep || query.type == PhysicsQuery_BoxSweep)
+            {
+                const btQuaternion rotation = ToBtQuaternion(query.rotation);
+                btCollisionWorld::ClosestConvexResultCallback callback(from, to);
+                world->convexSweepTest(is_sphere ? static_cast<btConvexShape*>(&sphere) : static_cast<btConvexShape*>(&box), btTransform(rotation, from), btTransform(rotation, to), callback);
+                if (callback.hasHit())
+                {
+                    hit.hit         = true;
+                    hit.entity      = get_entity(callback.m_hitCollisionObject);
+                    hit.position    = ToVector3(callback.m_hitPointWorld);
+                    hit.normal      = ToVector3(callback.m_hitNormalWorld);
+                    hit.fraction    = callback.m_closestHitFraction;
+                }
+                return;
+            }
+
+            btCollisionObject object;
+            object.setCollisionShape(is_sphere ? static_cast<btCollisionShape*>(&sphere) : static_cast<btCollisionShape*>(&box));
+            object.setWorldTransform(btTransform(ToBtQuaternion(query.rotation), from));
+
+            OverlapCallback callback;
+            const_cast<btCollisionWorld*>(world)->contactTest(&object, callback); // doesn't modify the world, but isn't const
+            if (callback.m_object)
+            {
+                hit.hit         = true;
+                hit.entity      = get_entity(callback.m_object);
+                hit.position    = ToVector3(callback.m_position);
+                hit.normal      = ToVector3(callback.m_normal);
+                hit.fraction    = 0.0f;
+            }
+        }
+    }
 
 	Physics::Physics(Context* context) : ISubsystem(context)
 	{
-        m_broadphase        = new btDbvtBroadphase();
-        m_constraint_solver = new btSequentialImpulseConstraintSolver();
+        m_threading     = m_context->GetSubsystem<Threading>();
+        m_shape_cache   = new CollisionShapeCache();
+        m_broadphase    = new btDbvtBroadphase();
+
+        if (m_multithreaded)
+        {
+            // The scheduler has to be in place before the multithreaded classes are created, they size their per thread state by it
+            m_task_scheduler    = new _Physics::TaskScheduler(m_threading);
+            btSetTaskScheduler(m_task_scheduler);
 
-        if (m_soft_body_support)
+            // Create
+            const int solver_count      = m_task_scheduler->getNumThreads();
+            m_collision_configuration   = new btDefaultCollisionConfiguration();
+            m_collision_dispatcher      = new btCollisionDispatcherMt(m_collision_configuration);
+            m_constraint_solver         = new btConstraintSolverPoolMt(solver_count);
+            m_constraint_solver_mt      = new btSequentialImpulseConstraintSolverMt();
+            m_world                     = new btDiscreteDynamicsWorldMt(m_collision_dispatcher, m_broadphase, static_cast<btConstraintSolverPoolMt*>(m_constraint_solver), m_constraint_solver_mt, m_collision_configuration);
+
+            // Soft body components still create their bodies (which the world then refuses), the helpers need the world info
+            m_world_info                = new btSoftBodyWorldInfo();
+            m_world_info->m_dispatcher  = m_collision_dispatcher;
+            m_world_info->m_broadphase  = m_broadphase;
+            m_world_info->m_gravity     = ToBtVector3(m_gravity);
+        }
+        else if (m_soft_body_support)
         {
             // Create
+            m_constraint_solver        = new btSequentialImpulseConstraintSolver();
             m_collision_configuration  = new btSoftBodyRigidBodyCollisionConfiguration();
             m_collision_dispatcher     = new btCollisionDispatcher(m_collision_configuration);
-            m_world                    = new btSoftRigidDynamicsWorld(m_collision_dispatcher, m_broadphase, m_constraint_solver, m_collision_configuration);
+            m_soft_body_solver         = new _Physics::SoftBodySolver(m_threading);
+            m_soft_body_broadphase     = new _Physics::SoftBodyBroadphase(m_broadphase);
+            m_world                    = new btSoftRigidDynamicsWorld(m_collision_dispatcher, m_broadphase, m_constraint_solver, m_collision_configuration, m_soft_body_solver);
 
             // Setup         
             m_world_info = new btSoftBodyWorldInfo();
             m_world_info->m_sparsesdf.Initialize();
             m_world->getDispatchInfo().m_enableSPU  = true;
             m_world_info->m_dispatcher              = m_collision_dispatcher;
-            m_world_info->m_broadphase              = m_broadphase;
+            m_world_info->m_broadphase              = m_soft_body_broadphase;
             m_world_info->air_density               = (btScalar)1.2;
             m_world_info->water_density             = 0;
             m_world_info->water_offset              = 0;
@@ -77,6 +424,7 @@ namespace Spartan
         else
         {
             // Create
+            m_constraint_solver         = new btSequentialImpulseConstraintSolver();
             m_collision_configuration   = new btDefaultCollisionConfiguration();
             m_collision_dispatcher      = new btCollisionDispatcher(m_collision_configuration);
             m_world                     = new btDiscreteDynamicsWorld(m_collision_dispatcher, m_broadphase, m_constraint_solver, m_collision_configuration);
@@ -91,13 +439,26 @@ namespace Spartan
 
 	Physics::~Physics()
 	{
+        AsyncStop();
+
         safe_delete(m_world);
+        safe_delete(m_soft_body_solver);
+        safe_delete(m_soft_body_broadphase);
         safe_delete(m_constraint_solver);
+        safe_delete(m_constraint_solver_mt);
         safe_delete(m_collision_dispatcher);
         safe_delete(m_collision_configuration);
         safe_delete(m_broadphase);
         safe_delete(m_world_info);
         safe_delete(m_debug_draw);
+        safe_delete(m_shape_cache);
+
+        // Bullet can't call into the workers any more
+        if (m_task_scheduler)
+        {
+            btSetTaskScheduler(btGetSequentialTaskScheduler());
+            safe_delete(m_task_scheduler);
+        }
 	}
 
 	bool Physics::Initialize()
@@ -105,6 +466,10 @@ namespace Spartan
         // Get dependencies
 		m_renderer = m_context->GetSubsystem<Renderer>();
 		m_profiler = m_context->GetSubsystem<Profiler>();
+		m_timer    = m_context->GetSubsystem<Timer>();
+
+        // Islands are simulated independently (and in parallel when multithreaded), so their count is the parallelism there is
+        m_counter_islands = Profiler::CounterRegister("Physics islands", "islands", Counter_Cumulative);
 
         // Get version
         const auto major = to_string(btGetVersion() / 100);
@@ -132,11 +497,37 @@ namespace Spartan
 		// Debug draw
 		if (m_renderer->GetOptions() & Render_Debug_Physics)
 		{
+            const auto lock = LockWorld();
             m_world->debugDrawWorld();
+            m_debug_draw->Flush();
 		}
 
 		// Don't simulate physics if they are turned off or the we are in editor mode
-		if (!m_context->m_engine->EngineMode_IsSet(Engine_Physics) || !m_context->m_engine->EngineMode_IsSet(Engine_Game))
+        const bool simulate = m_context->m_engine->EngineMode_IsSet(Engine_Physics) && m_context->m_engine->EngineMode_IsSet(Engine_Game);
+
+        // With the timer's fixed step, the engine steps the physics (once per tick) so that they are deterministic
+        const bool fixed_step = m_timer->IsFixedStepEnabled();
+
+        // The simulation thread steps, the transforms follow it here
+        if (simulate && m_asynchronous && !fixed_step)
+        {
+            SCOPED_TIME_BLOCK(m_profiler);
+
+            if (!m_async_running)
+            {
+                AsyncStart();
+            }
+
+            AsyncInterpolate();
+            return;
+        }
+
+        if (m_async_running)
+        {
+            AsyncStop();
+        }
+
+		if (!simulate)
 			return;
 
         SCOPED_TIME_BLOCK(m_profiler);
@@ -144,7 +535,7 @@ namespace Spartan
 		// This equation must be met: timeStep < maxSubSteps * fixedTimeStep
 		auto internal_time_step	= 1.0f / m_internal_fps;
 		auto max_substeps		= static_cast<int>(delta_time_sec * m_internal_fps) + 1;
-		if (m_max_sub_steps < 0)
+		if (m_max_sub_steps < 0 || fixed_step)
 		{
 			internal_time_step	= delta_time_sec;
 			max_substeps		= 1;
@@ -158,21 +549,39 @@ namespace Spartan
 		m_simulating = true;
         m_world->stepSimulation(delta_time_sec, max_substeps, internal_time_step);
 		m_simulating = false;
+
+        CountIslands();
 	}
 
-    void Physics::AddBody(btRigidBody* body) const
+    void Physics::AddBody(btRigidBody* body)
     {
         if (!m_world)
             return;
 
+        const auto lock = LockWorld();
         m_world->addRigidBody(body);
+
+        // Rigid bodies are the only ones which add btRigidBody, with themselves as the user pointer
+        if (RigidBody* rigid_body = static_cast<RigidBody*>(body->getUserPointer()))
+        {
+            const auto lock_poses = LockPoses();
+            rigid_body->Pose_Reset();
+            m_rigid_bodies.emplace_back(rigid_body);
+        }
     }
 
-    void Physics::RemoveBody(btRigidBody*& body) const
+    void Physics::RemoveBody(btRigidBody*& body)
     {
         if (!m_world)
             return;
 
+        const auto lock = LockWorld();
+        if (RigidBody* rigid_body = static_cast<RigidBody*>(body->getUserPointer()))
+        {
+            const auto lock_poses = LockPoses();
+            m_rigid_bodies.erase(remove(m_rigid_bodies.begin(), m_rigid_bodies.end(), rigid_body), m_rigid_bodies.end());
+        }
+
         m_world->removeRigidBody(body);
         delete body->getMotionState();
         safe_delete(body);
@@ -183,6 +592,7 @@ namespace Spartan
         if (!m_world)
             return;
 
+        const auto lock = LockWorld();
         m_world->addConstraint(constraint, !collision_with_linked_body);
     }
 
@@ -191,6 +601,7 @@ namespace Spartan
         if (!m_world)
             return;
 
+        const auto lock = LockWorld();
         m_world->removeConstraint(constraint);
         safe_delete(constraint);
     }
@@ -200,6 +611,14 @@ namespace Spartan
         if (!m_world)
             return;
 
+        const auto lock = LockWorld();
+
+        if (!m_soft_body_support)
+        {
+            LOG_WARNING("Soft bodies are not supported by the multithreaded world");
+            return;
+        }
+
         if (btSoftRigidDynamicsWorld* world = static_cast<btSoftRigidDynamicsWorld*>(m_world))
         {
             world->addSoftBody(body);
@@ -208,6 +627,14 @@ namespace Spartan
 
     void Physics::RemoveBody(btSoftBody*& body) const
     {
+        // The multithreaded world never took it
+        if (!m_soft_body_support)
+        {
+            safe_delete(body);
+            return;
+        }
+
+        const auto lock = LockWorld();
         if (btSoftRigidDynamicsWorld* world = static_cast<btSoftRigidDynamicsWorld*>(m_world))
         {
             world->removeSoftBody(body);
@@ -225,4 +652,193 @@ namespace Spartan
 		}
 		return gravity ? ToVector3(gravity) : Vector3::Zero;
 	}
+
+    bool Physics::Defer(const void* owner, function<void()>&& function)
+    {
+        if (!m_async_running || IsSimulationThread())
+            return false;
+
+        lock_guard<mutex> lock(m_mutex_deferred);
+        m_deferred.emplace_back(owner, move(function));
+        return true;
+    }
+
+    void Physics::DeferCancel(const void* owner)
+    {
+        // The simulation thread runs deferred functions with the world locked, so the caller has to hold it for none of the owner's to be running
+        const auto lock_world = LockWorld();
+        lock_guard<mutex> lock(m_mutex_deferred);
+        m_deferred.erase(remove_if(m_deferred.begin(), m_deferred.end(), [owner](const pair<const void*, function<void()>>& deferred) { return deferred.first == owner; }), m_deferred.end());
+    }
+
+    void Physics::AsyncStart()
+    {
+        // Both poses of every body start at where it is
+        {
+            const auto lock_world = LockWorld();
+            const auto lock_poses = LockPoses();
+            for (RigidBody* rigid_body : m_rigid_bodies)
+            {
+                rigid_body->Pose_Reset();
+            }
+            m_async_step_time = chrono::steady_clock::now();
+        }
+
+        m_async_running = true;
+        m_async_thread  = thread(&Physics::AsyncLoop, this);
+    }
+
+    void Physics::AsyncStop()
+    {
+        if (!m_async_thread.joinable())
+            return;
+
+        m_async_running = false;
+        m_async_thread.join();
+
+        // Whatever didn't make it to a step, the world is the caller's again
+        AsyncRunDeferred();
+    }
+
+    void Physics::AsyncLoop()
+    {
+        m_async_thread_id = this_thread::get_id();
+
+        const float step_sec                        = 1.0f / m_internal_fps;
+        const chrono::steady_clock::duration step   = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(step_sec));
+        chrono::steady_clock::time_point time_next  = chrono::steady_clock::now();
+
+        while (m_async_running)
+        {
+            // Fixed rate, a simulation which fell too far behind starts over from now rather than stepping in a burst
+            time_next += step;
+            const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+            if (now < time_next)
+            {
+                this_thread::sleep_until(time_next);
+            }
+            else if (now - time_next > step * async_steps_behind_max)
+            {
+                time_next = now;
+            }
+
+            const auto lock = LockWorld();
+            AsyncRunDeferred();
+
+            // A single step of the fixed size
+            m_simulating = true;
+            m_world->stepSimulation(step_sec, 0);
+            m_simulating = false;
+
+            CountIslands();
+
+            // Publish
+            const auto lock_poses = LockPoses();
+            for (RigidBody* rigid_body : m_rigid_bodies)
+            {
+                rigid_body->Pose_Publish();
+            }
+            m_async_step_time = chrono::steady_clock::now();
+        }
+
+        m_async_thread_id = thread::id();
+    }
+
+    void Physics::CountIslands()
+    {
+        // Bodies which sleep, or never move, aren't simulated so their islands don't count
+        m_island_tags.clear();
+        const btCollisionObjectArray& objects = m_world->getCollisionObjectArray();
+        for (int i = 0; i < objects.size(); i++)
+        {
+            const btCollisionObject* object = objects[i];
+            if (object->getIslandTag() >= 0 && object->isActive() && !object->isStaticOrKinematicObject())
+            {
+                m_island_tags.emplace_back(object->getIslandTag());
+            }
+        }
+
+        sort(m_island_tags.begin(), m_island_tags.end());
+        m_counter_islands->Set(unique(m_island_tags.begin(), m_island_tags.end()) - m_island_tags.begin());
+    }
+
+    void Physics::AsyncRunDeferred()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex_deferred);
+            m_deferred_running.swap(m_deferred);
+        }
+
+        for (pair<const void*, function<void()>>& deferred : m_deferred_running)
+        {
+            deferred.second();
+        }
+        m_deferred_running.clear();
+    }
+
+    void Physics::AsyncInterpolate()
+    {
+        const float step_sec = 1.0f / m_internal_fps;
+
+        const auto lock     = LockPoses();
+        const float elapsed = chrono::duration<float>(chrono::steady_clock::now() - m_async_step_time).count();
+        const float alpha   = Helper::Clamp(elapsed / step_sec, 0.0f, 1.0f);
+        for (RigidBody* rigid_body : m_rigid_bodies)
+        {
+            rigid_body->Pose_Interpolate(alpha);
+        }
+    }
+
+    void Physics::Query(const PhysicsQuery* queries, const uint32_t count, PhysicsHit* hits) const
+    {
+        if (!m_world || !queries || !hits || count == 0)
+            return;
+
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        const auto lock = LockWorld();
+
+        // Bullet's broadphase queries share a stack unless it's thread safe
+        if (m_multithreaded)
+        {
+            m_threading->ParallelFor([this, queries, hits](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    _Physics::query(m_world, queries[i], hits[i]);
+                }
+            }, count, 16);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                _Physics::query(m_world, queries[i], hits[i]);
+            }
+        }
+    }
+
+    void Physics::Query(PhysicsQueryBatch& batch) const
+    {
+        batch.GetHits().resize(batch.GetCount());
+        Query(batch.GetQueries().data(), batch.GetCount(), batch.GetHits().data());
+    }
+
+    bool Physics::Raycast(const Vector3& from, const Vector3& to, PhysicsHit* hit /*= nullptr*/) const
+    {
+        PhysicsQuery query;
+        query.type  = PhysicsQuery_Ray;
+        query.from  = from;
+        query.to    = to;
+
+        PhysicsHit result;
+        Query(&query, 1, &result);
+
+        if (hit)
+        {
+            *hit = result;
+        }
+
+        return result.hit;
+    }
 }
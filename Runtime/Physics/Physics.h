@@ -22,14 +22,23 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==================
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "../Core/ISubsystem.h"
 #include "../Math/Vector3.h"
+#include "PhysicsQuery.h"
 //=============================
 
 //= FORWARD DECLARATIONS =================
 class btBroadphaseInterface;
 class btCollisionDispatcher;
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
+class btITaskScheduler;
+class btSoftBodySolver;
 class btDefaultCollisionConfiguration;
 class btCollisionObject;
 class btDiscreteDynamicsWorld;
@@ -43,7 +52,12 @@ namespace Spartan
 {
 	class Renderer;
 	class PhysicsDebugDraw;
+	class CollisionShapeCache;
 	class Profiler;
+    struct Counter;
+	class Threading;
+	class Timer;
+	class RigidBody;
 	namespace Math { class Vector3; }	
 
 	class Physics : public ISubsystem
@@ -58,8 +72,8 @@ namespace Spartan
 		//===================================
 
         // Rigid body
-        void AddBody(btRigidBody* body) const;
-        void RemoveBody(btRigidBody*& body) const;
+        void AddBody(btRigidBody* body);
+        void RemoveBody(btRigidBody*& body);
 
         // Soft body
         void AddBody(btSoftBody* body) const;
@@ -69,24 +83,75 @@ namespace Spartan
         void AddConstraint(btTypedConstraint* constraint, bool collision_with_linked_body = true) const;
         void RemoveConstraint(btTypedConstraint*& constraint) const;
 
+        // Queries against the world, hits[i] is the closest (or deepest) hit of queries[i].
+        // They run in parallel on the frame workers when Bullet is thread safe, and wait for a running step of the asynchronous simulation.
+        void Query(const PhysicsQuery* queries, uint32_t count, PhysicsHit* hits) const;
+        void Query(PhysicsQueryBatch& batch) const;
+        bool Raycast(const Math::Vector3& from, const Math::Vector3& to, PhysicsHit* hit = nullptr) const;
+
         // Properties
 		Math::Vector3 GetGravity()  const;
         auto& GetSoftWorldInfo()    const { return *m_world_info; }
         auto GetPhysicsDebugDraw()  const { return m_debug_draw; }
+        auto GetShapeCache()        const { return m_shape_cache; }
 		bool IsSimulating()         const { return m_simulating; }
 
+        // Asynchronous simulation: while the game runs, the world steps at a fixed rate on a thread of its own, so a slow step doesn't hold up the frame.
+        // Rigid bodies publish their pose after every step and the main thread interpolates their transforms between the last two (a step behind).
+        // Another thread which touches the world either locks it (adding, removing and reconfiguring bodies and constraints, which waits for a running step)
+        // or defers to the simulation thread (forces, velocities and poses, which are applied right before the next step without waiting).
+        void SetAsynchronous(const bool asynchronous)   { m_asynchronous = asynchronous; } // takes effect with the next tick
+        bool IsAsynchronous()                   const   { return m_async_running; }
+        bool IsSimulationThread()               const   { return std::this_thread::get_id() == m_async_thread_id.load(); }
+        std::unique_lock<std::recursive_mutex> LockWorld() const { return std::unique_lock<std::recursive_mutex>(m_mutex_world); }
+        std::unique_lock<std::mutex> LockPoses()        const { return std::unique_lock<std::mutex>(m_mutex_poses); }
+        // Queues a function for the simulation thread, returns false (without taking it) if the caller can touch the world itself
+        bool Defer(const void* owner, std::function<void()>&& function);
+        // Drops the queued functions of an owner which is going away
+        void DeferCancel(const void* owner);
+
 	private:
+        void AsyncStart();
+        void AsyncStop();
+        void AsyncLoop();
+        void AsyncRunDeferred();
+        void AsyncInterpolate();
+        void CountIslands(); // after a step, publishes how many islands are awake
+
         btBroadphaseInterface* m_broadphase                         = nullptr;
         btCollisionDispatcher* m_collision_dispatcher               = nullptr;
-        btSequentialImpulseConstraintSolver* m_constraint_solver    = nullptr;
+        btConstraintSolver* m_constraint_solver                     = nullptr; // a pool of solvers (one per island) when multithreaded
+        btConstraintSolver* m_constraint_solver_mt                  = nullptr; // multithreaded only, solves the islands which are too big for a single thread
+        btITaskScheduler* m_task_scheduler                          = nullptr; // multithreaded only, Bullet's parallel loops on the frame workers
         btDefaultCollisionConfiguration* m_collision_configuration  = nullptr;
         btDiscreteDynamicsWorld* m_world                            = nullptr;
         btSoftBodyWorldInfo* m_world_info                           = nullptr;
+        btSoftBodySolver* m_soft_body_solver                        = nullptr; // soft bodies only, solves them in parallel
+        btBroadphaseInterface* m_soft_body_broadphase               = nullptr; // soft bodies only, the broadphase serialized for them
         PhysicsDebugDraw* m_debug_draw                              = nullptr;
+        CollisionShapeCache* m_shape_cache                          = nullptr;
 
         // Misc
-        Renderer* m_renderer = nullptr;
-        Profiler* m_profiler = nullptr;
+        Renderer* m_renderer    = nullptr;
+        Profiler* m_profiler    = nullptr;
+        Threading* m_threading  = nullptr;
+        Timer* m_timer          = nullptr;
+        Counter* m_counter_islands = nullptr;
+        std::vector<int> m_island_tags;
+
+        // Asynchronous simulation
+        static constexpr uint32_t async_steps_behind_max = 4; // a simulation which falls further behind (a spike) slows down instead of catching up
+        bool m_asynchronous                                 = true;
+        std::atomic<bool> m_async_running                   = false;
+        std::atomic<std::thread::id> m_async_thread_id;
+        std::thread m_async_thread;
+        std::chrono::steady_clock::time_point m_async_step_time; // when the last step was published
+        mutable std::recursive_mutex m_mutex_world;
+        mutable std::mutex m_mutex_poses;
+        std::mutex m_mutex_deferred;
+        std::vector<std::pair<const void*, std::function<void()>>> m_deferred;
+        std::vector<std::pair<const void*, std::function<void()>>> m_deferred_running;
+        std::vector<RigidBody*> m_rigid_bodies; // in the world, the poses are published and interpolated for them
 
 		//= PROPERTIES =================================================
         int m_max_sub_steps         = 1;
@@ -40,7 +40,8 @@ namespace Spartan
 
 	void PhysicsDebugDraw::drawLine(const btVector3& from, const btVector3& to, const btVector3& fromColor, const btVector3& toColor)
 	{
-		m_renderer->DrawLine(ToVector3(from), ToVector3(to), ToVector4(fromColor), ToVector4(toColor));
+		m_lines.emplace_back(ToVector3(from), ToVector4(fromColor));
+		m_lines.emplace_back(ToVector3(to), ToVector4(toColor));
 	}
 
 	void PhysicsDebugDraw::drawContactPoint(const btVector3& PointOnB, const btVector3& normalOnB, btScalar distance, int lifeTime, const btVector3& color)
@@ -50,6 +51,12 @@ namespace Spartan
 		drawLine(from, to, color);
 	}
 
+	void PhysicsDebugDraw::Flush()
+	{
+		m_renderer->DrawLines(m_lines.data(), static_cast<uint32_t>(m_lines.size()));
+		m_lines.clear();
+	}
+
 	void PhysicsDebugDraw::reportErrorWarning(const char* error_warning)
 	{
 		LOG_WARNING("%s", error_warning);
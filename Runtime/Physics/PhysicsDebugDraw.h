@@ -22,6 +22,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==========================
+#include <vector>
+#include "../RHI/RHI_Vertex.h"
 // Hide warnings which belong to Bullet
 #pragma warning(push, 0)   
 #include <LinearMath/btIDebugDraw.h>
@@ -46,10 +48,15 @@ namespace Spartan
 		void draw3dText(const btVector3& location, const char* textString) override {}
 		void setDebugMode(const int debugMode) override	{ m_debugMode = debugMode; }
 		int getDebugMode() const override			    { return m_debugMode; }
+		void flushLines() override					    { Flush(); }
 		//=============================================================================================================================================
 
+		// Bullet draws a line at a time, they are collected and handed to the renderer at once (soft bodies draw after Bullet flushes, so the world flushes again)
+		void Flush();
+
 	private:
 		Renderer* m_renderer;
 		int m_debugMode;
+		std::vector<RHI_Vertex_PosCol> m_lines;
 	};
 }
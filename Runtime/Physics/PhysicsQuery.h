@@ -0,0 +1,87 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include "../Math/Vector3.h"
+#include "../Math/Quaternion.h"
+//=============================
+
+namespace Spartan
+{
+    class Entity;
+
+    enum PhysicsQuery_Type : uint32_t
+    {
+        PhysicsQuery_Ray,           // the closest hit along a segment
+        PhysicsQuery_SphereSweep,   // the closest hit of a sphere moved along a segment
+        PhysicsQuery_BoxSweep,      // the closest hit of an (oriented) box moved along a segment
+        PhysicsQuery_SphereOverlap, // the deepest contact of a sphere at a position
+        PhysicsQuery_BoxOverlap     // the deepest contact of an (oriented) box at a position
+    };
+
+    struct PhysicsQuery
+    {
+        PhysicsQuery_Type type      = PhysicsQuery_Ray;
+        Math::Vector3 from          = Math::Vector3::Zero;  // the position of overlaps
+        Math::Vector3 to            = Math::Vector3::Zero;
+        Math::Vector3 extent        = Math::Vector3::Zero;  // half extents of boxes, radius (x) of spheres
+        Math::Quaternion rotation   = Math::Quaternion::Identity;
+    };
+
+    struct PhysicsHit
+    {
+        Entity* entity          = nullptr;              // of the rigid body which was hit, if any
+        Math::Vector3 position  = Math::Vector3::Zero;
+        Math::Vector3 normal    = Math::Vector3::Zero;
+        float fraction          = 1.0f;                 // along the segment (sweeps and rays)
+        bool hit                = false;
+    };
+
+    // Queries which are built up and then run together (see Physics::Query()), the hits line up with the queries
+    class PhysicsQueryBatch
+    {
+    public:
+        uint32_t AddRay(const Math::Vector3& from, const Math::Vector3& to)                                                                                 { return Add({ PhysicsQuery_Ray, from, to }); }
+        uint32_t AddSphereSweep(const Math::Vector3& from, const Math::Vector3& to, const float radius)                                                     { return Add({ PhysicsQuery_SphereSweep, from, to, Math::Vector3(radius) }); }
+        uint32_t AddBoxSweep(const Math::Vector3& from, const Math::Vector3& to, const Math::Vector3& extent, const Math::Quaternion& rotation)             { return Add({ PhysicsQuery_BoxSweep, from, to, extent, rotation }); }
+        uint32_t AddSphereOverlap(const Math::Vector3& position, const float radius)                                                                        { return Add({ PhysicsQuery_SphereOverlap, position, position, Math::Vector3(radius) }); }
+        uint32_t AddBoxOverlap(const Math::Vector3& position, const Math::Vector3& extent, const Math::Quaternion& rotation)                                { return Add({ PhysicsQuery_BoxOverlap, position, position, extent, rotation }); }
+        void Clear()                                        { m_queries.clear(); m_hits.clear(); }
+
+        uint32_t GetCount()                         const   { return static_cast<uint32_t>(m_queries.size()); }
+        const std::vector<PhysicsQuery>& GetQueries() const { return m_queries; }
+        std::vector<PhysicsHit>& GetHits()                  { return m_hits; }
+        const PhysicsHit& GetHit(const uint32_t index) const { static const PhysicsHit none; return index < m_hits.size() ? m_hits[index] : none; }
+
+    private:
+        uint32_t Add(const PhysicsQuery& query)
+        {
+            m_queries.emplace_back(query);
+            return static_cast<uint32_t>(m_queries.size() - 1);
+        }
+
+        std::vector<PhysicsQuery> m_queries;
+        std::vector<PhysicsHit> m_hits;
+    };
+}
@@ -0,0 +1,294 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ===========================
+#include "FrameCapture.h"
+#include "../Core/Context.h"
+#include "../Core/Engine.h"
+#include "../Core/EventSystem.h"
+#include "../Core/FileSystem.h"
+#include "../Core/Timer.h"
+#include "../IO/FileStream.h"
+#include "../Physics/Physics.h"
+#include "../Rendering/Renderer.h"
+#include "../World/World.h"
+#include "../World/Components/Camera.h"
+#include "../World/Components/Transform.h"
+//======================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace _FrameCapture
+{
+    static const uint32_t magic     = 0x50414346; // "FCAP"
+    static const uint32_t version   = 1;
+
+    // The keys are stored as bits
+    inline void keys_write(Spartan::FileStream& stream, const array<bool, 99>& keys)
+    {
+        uint64_t bits[2] = { 0, 0 };
+        for (uint32_t i = 0; i < keys.size(); i++)
+        {
+            bits[i / 64] |= keys[i] ? (1ull << (i % 64)) : 0;
+        }
+        stream.Write(bits[0]);
+        stream.Write(bits[1]);
+    }
+
+    inline void keys_read(Spartan::FileStream& stream, array<bool, 99>& keys)
+    {
+        uint64_t bits[2] = { 0, 0 };
+        stream.Read(&bits[0]);
+        stream.Read(&bits[1]);
+        for (uint32_t i = 0; i < keys.size(); i++)
+        {
+            keys[i] = (bits[i / 64] & (1ull << (i % 64))) != 0;
+        }
+    }
+}
+
+namespace Spartan
+{
+    FrameCapture::FrameCapture(Context* context) : ISubsystem(context)
+    {
+        SUBSCRIBE_TO_EVENT(Event_Frame_End, EVENT_HANDLER(OnFrameEnd));
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        if (m_recording)
+        {
+            RecordStop();
+        }
+    }
+
+    bool FrameCapture::Initialize()
+    {
+        m_timer     = m_context->GetSubsystem<Timer>();
+        m_input     = m_context->GetSubsystem<Input>();
+        m_renderer  = m_context->GetSubsystem<Renderer>();
+
+        return true;
+    }
+
+    bool FrameCapture::RecordStart(const string& file_path)
+    {
+        if (m_recording || m_replaying)
+        {
+            LOG_WARNING("A capture is already recording or replaying");
+            return false;
+        }
+
+        // The world, as it is when the first frame starts
+        m_file_path         = file_path;
+        m_world_file_path   = FileSystem::GetFilePathWithoutExtension(file_path) + EXTENSION_WORLD;
+        if (!m_context->GetSubsystem<World>()->SaveToFile(m_world_file_path))
+        {
+            LOG_ERROR("Failed to save the world of the capture");
+            return false;
+        }
+
+        Physics* physics        = m_context->GetSubsystem<Physics>();
+        m_physics_asynchronous  = physics->IsAsynchronous();
+        physics->SetAsynchronous(false);
+
+        m_game_mode     = m_context->m_engine->EngineMode_IsSet(Engine_Game);
+        m_fixed_step    = m_timer->IsFixedStepEnabled();
+        m_fixed_step_hz = m_timer->GetFixedStepHz();
+        m_frames.clear();
+        m_recording     = true;
+
+        LOG_INFO("Capturing frames to \"%s\"", file_path.c_str());
+        return true;
+    }
+
+    bool FrameCapture::RecordStop()
+    {
+        if (!m_recording)
+            return false;
+
+        m_recording = false;
+        m_context->GetSubsystem<Physics>()->SetAsynchronous(m_physics_asynchronous);
+
+        auto file = make_unique<FileStream>(m_file_path, FileStream_Write);
+        if (!file->IsOpen())
+            return false;
+
+        file->Write(_FrameCapture::magic);
+        file->Write(_FrameCapture::version);
+        file->Write(FileSystem::GetFileNameFromFilePath(m_world_file_path));
+        file->Write(m_game_mode);
+        file->Write(m_fixed_step);
+        file->Write(m_fixed_step_hz);
+        file->Write(static_cast<uint32_t>(m_frames.size()));
+        for (const Frame& frame : m_frames)
+        {
+            file->Write(frame.delta_time_ms);
+            file->Write(frame.camera_position);
+            file->Write(frame.camera_rotation);
+            _FrameCapture::keys_write(*file, frame.input.keys);
+            file->Write(frame.input.mouse_position);
+            file->Write(frame.input.mouse_delta);
+            file->Write(frame.input.mouse_wheel_delta);
+            file->Write(frame.input.gamepad_thumb_left);
+            file->Write(frame.input.gamepad_thumb_right);
+            file->Write(frame.input.gamepad_trigger_left);
+            file->Write(frame.input.gamepad_trigger_right);
+        }
+        file->Close();
+
+        LOG_INFO("Captured %d frames to \"%s\"", static_cast<uint32_t>(m_frames.size()), m_file_path.c_str());
+        return true;
+    }
+
+    bool FrameCapture::Load(const string& file_path)
+    {
+        auto file = make_unique<FileStream>(file_path, FileStream_Read);
+        if (!file->IsOpen())
+            return false;
+
+        uint32_t magic      = 0;
+        uint32_t version    = 0;
+        file->Read(&magic);
+        file->Read(&version);
+        if (magic != _FrameCapture::magic || version != _FrameCapture::version)
+        {
+            LOG_ERROR("\"%s\" isn't a frame capture, or it's of another version", file_path.c_str());
+            return false;
+        }
+
+        // The world is next to the capture
+        string world_file_name;
+        file->Read(&world_file_name);
+        m_world_file_path = FileSystem::GetDirectoryFromFilePath(file_path) + world_file_name;
+
+        uint32_t frame_count = 0;
+        file->Read(&m_game_mode);
+        file->Read(&m_fixed_step);
+        file->Read(&m_fixed_step_hz);
+        file->Read(&frame_count);
+
+        m_frames.resize(frame_count);
+        for (Frame& frame : m_frames)
+        {
+            file->Read(&frame.delta_time_ms);
+            file->Read(&frame.camera_position);
+            file->Read(&frame.camera_rotation);
+            _FrameCapture::keys_read(*file, frame.input.keys);
+            file->Read(&frame.input.mouse_position);
+            file->Read(&frame.input.mouse_delta);
+            file->Read(&frame.input.mouse_wheel_delta);
+            file->Read(&frame.input.gamepad_thumb_left);
+            file->Read(&frame.input.gamepad_thumb_right);
+            file->Read(&frame.input.gamepad_trigger_left);
+            file->Read(&frame.input.gamepad_trigger_right);
+        }
+
+        m_file_path = file_path;
+        return true;
+    }
+
+    void FrameCapture::ReplayStart()
+    {
+        if (m_frames.empty() || m_recording)
+            return;
+
+        Physics* physics        = m_context->GetSubsystem<Physics>();
+        m_physics_asynchronous  = physics->IsAsynchronous();
+        physics->SetAsynchronous(false);
+
+        m_timer->SetFixedStepEnabled(m_fixed_step);
+        if (m_fixed_step)
+        {
+            m_timer->SetFixedStepHz(m_fixed_step_hz);
+        }
+
+        m_replay_index  = 0;
+        m_replaying     = true;
+        ReplayPrepare(0);
+    }
+
+    void FrameCapture::ReplayStop()
+    {
+        if (!m_replaying)
+            return;
+
+        m_replaying = false;
+        m_timer->SetDeltaTimeOverride(0.0);
+        m_input->SetStateReplayed(nullptr);
+        m_context->GetSubsystem<Physics>()->SetAsynchronous(m_physics_asynchronous);
+    }
+
+    void FrameCapture::ReplayPrepare(const uint32_t index)
+    {
+        // The timer and the input tick first, so what they report for the next frame is set when the previous one ends
+        const Frame& frame = m_frames[index];
+        m_timer->SetDeltaTimeOverride(frame.delta_time_ms > 0.0 ? frame.delta_time_ms : 0.001);
+        m_input->SetStateReplayed(&frame.input);
+    }
+
+    void FrameCapture::OnFrameEnd()
+    {
+        if (!m_recording && !m_replaying)
+            return;
+
+        const shared_ptr<Camera>& camera    = m_renderer->GetCamera();
+        Transform* transform                = camera ? camera->GetTransform() : nullptr;
+
+        if (m_recording)
+        {
+            Frame& frame        = m_frames.emplace_back();
+            frame.delta_time_ms = m_timer->GetDeltaTimeMs();
+            frame.input         = m_input->GetState();
+            if (transform)
+            {
+                frame.camera_position = transform->GetPosition();
+                frame.camera_rotation = transform->GetRotation();
+            }
+            return;
+        }
+
+        // The camera ends the frame where it ended when it was captured, the renderer's next snapshot takes it from there
+        if (m_replay_index < m_frames.size())
+        {
+            if (transform)
+            {
+                transform->SetPosition(m_frames[m_replay_index].camera_position);
+                transform->SetRotation(m_frames[m_replay_index].camera_rotation);
+            }
+
+            m_replay_index++;
+        }
+
+        if (m_replay_index < m_frames.size())
+        {
+            ReplayPrepare(m_replay_index);
+        }
+        else
+        {
+            ReplayStop();
+        }
+    }
+}
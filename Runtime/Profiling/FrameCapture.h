@@ -0,0 +1,99 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <string>
+#include <vector>
+#include "../Core/ISubsystem.h"
+#include "../Input/Input.h"
+#include "../Math/Vector3.h"
+#include "../Math/Quaternion.h"
+//================================
+
+namespace Spartan
+{
+    class Timer;
+    class Renderer;
+
+    // Records what a run of frames depends on, so that it can be replayed deterministically (e.g. by the runner, to reproduce a hitch which
+    // was reported from the field with full profiling). A capture is the world as it was when the capture started (saved next to the capture)
+    // and per frame, the delta time, the input state and the camera's transform. Both recording and replaying step the physics on the engine's
+    // thread, as the asynchronous simulation depends on thread timing.
+    class SPARTAN_CLASS FrameCapture : public ISubsystem
+    {
+    public:
+        struct Frame
+        {
+            double delta_time_ms            = 0.0;
+            Math::Vector3 camera_position   = Math::Vector3::Zero;
+            Math::Quaternion camera_rotation;
+            Input::State input;
+        };
+
+        FrameCapture(Context* context);
+        ~FrameCapture();
+
+        //= Subsystem =============
+        bool Initialize() override;
+        //=========================
+
+        // Recording, every frame which ends is added, until the capture stops (which writes the file)
+        bool RecordStart(const std::string& file_path);
+        bool RecordStop();
+        bool IsRecording()                      const { return m_recording; }
+
+        // Replay, loads a capture (the caller loads its world), then the frames replay from the next tick on
+        bool Load(const std::string& file_path);
+        void ReplayStart();
+        void ReplayStop();
+        bool IsReplaying()                      const { return m_replaying; }
+        bool IsReplayDone()                     const { return m_replay_index >= m_frames.size(); }
+
+        // Properties
+        const std::string& GetWorldFilePath()   const { return m_world_file_path; }
+        const auto& GetFrames()                 const { return m_frames; }
+        bool GetGameMode()                      const { return m_game_mode; } // the capture was taken in game mode
+        uint32_t GetReplayIndex()               const { return m_replay_index; }
+
+    private:
+        void OnFrameEnd();
+        void ReplayPrepare(uint32_t index);
+
+        std::string m_file_path;
+        std::string m_world_file_path;
+        std::vector<Frame> m_frames;
+        bool m_game_mode            = false;
+        bool m_fixed_step           = false;
+        double m_fixed_step_hz      = 0.0;
+        bool m_recording            = false;
+        bool m_replaying            = false;
+        uint32_t m_replay_index     = 0;
+        bool m_physics_asynchronous = true; // restored when recording or replaying stops
+
+        // Dependencies
+        Timer* m_timer          = nullptr;
+        Input* m_input          = nullptr;
+        Renderer* m_renderer    = nullptr;
+    };
+}
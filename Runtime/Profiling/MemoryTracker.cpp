@@ -0,0 +1,183 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ===============
+#include "MemoryTracker.h"
+#include <atomic>
+#include <array>
+#include <new>
+#include <cstdlib>
+#include "../Logging/Log.h"
+//==========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace _MemoryTracker
+    {
+        // Constant initialized, so they can be used by allocations which happen before (and after) static initialization
+        array<atomic<int64_t>, Memory_Tag_Count> bytes                  = {};
+        array<atomic<int64_t>, Memory_Tag_Count> allocations            = {};
+        array<atomic<uint64_t>, Memory_Tag_Count> allocations_total     = {};
+        array<uint64_t, Memory_Tag_Count> allocations_total_last_frame  = {};
+        array<uint64_t, Memory_Tag_Count> allocations_frame             = {};
+        array<atomic<uint64_t>, Memory_Tag_Count> budgets               = {};
+        array<bool, Memory_Tag_Count> over_budget                       = {};
+        thread_local Memory_Tag tag                                     = Memory_Tag_Other;
+
+        const char* tag_names[Memory_Tag_Count] =
+        {
+            "Other",
+            "Renderer",
+            "World",
+            "Physics",
+            "Resources",
+            "Scripting",
+            "Audio"
+        };
+    }
+
+    void MemoryTracker::OnAllocate(const Memory_Tag tag, const size_t size)
+    {
+        _MemoryTracker::bytes[tag].fetch_add(static_cast<int64_t>(size), memory_order_relaxed);
+        _MemoryTracker::allocations[tag].fetch_add(1, memory_order_relaxed);
+        _MemoryTracker::allocations_total[tag].fetch_add(1, memory_order_relaxed);
+    }
+
+    void MemoryTracker::OnFree(const Memory_Tag tag, const size_t size)
+    {
+        _MemoryTracker::bytes[tag].fetch_sub(static_cast<int64_t>(size), memory_order_relaxed);
+        _MemoryTracker::allocations[tag].fetch_sub(1, memory_order_relaxed);
+    }
+
+    Memory_Tag MemoryTracker::GetTag()
+    {
+        return _MemoryTracker::tag;
+    }
+
+    void MemoryTracker::SetTag(const Memory_Tag tag)
+    {
+        _MemoryTracker::tag = tag;
+    }
+
+    void MemoryTracker::OnFrameEnd()
+    {
+        for (uint32_t i = 0; i < Memory_Tag_Count; i++)
+        {
+            const uint64_t allocations_total                    = _MemoryTracker::allocations_total[i].load(memory_order_relaxed);
+            _MemoryTracker::allocations_frame[i]                = allocations_total - _MemoryTracker::allocations_total_last_frame[i];
+            _MemoryTracker::allocations_total_last_frame[i]     = allocations_total;
+
+            // Warn once when a tag goes over its budget, and again only after it went back under
+            const uint64_t budget   = _MemoryTracker::budgets[i].load(memory_order_relaxed);
+            const int64_t bytes     = _MemoryTracker::bytes[i].load(memory_order_relaxed);
+            const bool over_budget  = budget != 0 && bytes > static_cast<int64_t>(budget);
+            if (over_budget && !_MemoryTracker::over_budget[i])
+            {
+                LOG_WARNING("%s is using %.1f MB, over its budget of %.1f MB", _MemoryTracker::tag_names[i], bytes / 1048576.0, budget / 1048576.0);
+            }
+            _MemoryTracker::over_budget[i] = over_budget;
+        }
+    }
+
+    Memory_Tag_Stats MemoryTracker::GetStats(const Memory_Tag tag)
+    {
+        Memory_Tag_Stats stats;
+        stats.bytes             = _MemoryTracker::bytes[tag].load(memory_order_relaxed);
+        stats.allocations       = _MemoryTracker::allocations[tag].load(memory_order_relaxed);
+        stats.allocations_frame = _MemoryTracker::allocations_frame[tag];
+        stats.budget            = _MemoryTracker::budgets[tag].load(memory_order_relaxed);
+        return stats;
+    }
+
+    void MemoryTracker::SetBudget(const Memory_Tag tag, const uint64_t bytes)
+    {
+        _MemoryTracker::budgets[tag].store(bytes, memory_order_relaxed);
+    }
+
+    const char* MemoryTracker::GetTagName(const Memory_Tag tag)
+    {
+        return tag < Memory_Tag_Count ? _MemoryTracker::tag_names[tag] : "Unknown";
+    }
+}
+
+#if SPARTAN_MEMORY_TRACKING == 1
+// Every allocation is prefixed with its size and tag, so that a free can be attributed to the tag which allocated it
+// (the header keeps the alignment which malloc guarantees). Over-aligned allocations go through the untracked aligned operators.
+namespace Spartan::_MemoryTracker
+{
+    struct AllocationHeader
+    {
+        uint64_t size;
+        uint32_t tag;
+        uint32_t padding;
+    };
+    static_assert(sizeof(AllocationHeader) == 16, "The header has to keep the allocation 16 byte aligned");
+
+    void* tracked_allocate(const size_t size) noexcept
+    {
+        AllocationHeader* header = static_cast<AllocationHeader*>(malloc(sizeof(AllocationHeader) + (size ? size : 1)));
+        if (!header)
+            return nullptr;
+
+        header->size    = size;
+        header->tag     = MemoryTracker::GetTag();
+        MemoryTracker::OnAllocate(static_cast<Memory_Tag>(header->tag), size);
+
+        return header + 1;
+    }
+
+    void tracked_free(void* ptr) noexcept
+    {
+        if (!ptr)
+            return;
+
+        AllocationHeader* header = static_cast<AllocationHeader*>(ptr) - 1;
+        MemoryTracker::OnFree(static_cast<Memory_Tag>(header->tag), static_cast<size_t>(header->size));
+        free(header);
+    }
+
+    void* tracked_allocate_or_throw(const size_t size)
+    {
+        if (void* ptr = tracked_allocate(size))
+            return ptr;
+
+        throw bad_alloc();
+    }
+}
+
+using namespace Spartan::_MemoryTracker;
+
+void* operator new(size_t size)                                     { return tracked_allocate_or_throw(size); }
+void* operator new[](size_t size)                                   { return tracked_allocate_or_throw(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept          { return tracked_allocate(size); }
+void* operator new[](size_t size, const nothrow_t&) noexcept        { return tracked_allocate(size); }
+void operator delete(void* ptr) noexcept                            { tracked_free(ptr); }
+void operator delete[](void* ptr) noexcept                          { tracked_free(ptr); }
+void operator delete(void* ptr, size_t) noexcept                    { tracked_free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept                  { tracked_free(ptr); }
+void operator delete(void* ptr, const nothrow_t&) noexcept          { tracked_free(ptr); }
+void operator delete[](void* ptr, const nothrow_t&) noexcept        { tracked_free(ptr); }
+#endif
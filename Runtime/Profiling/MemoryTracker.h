@@ -0,0 +1,92 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==================
+#include <cstddef>
+#include "../Core/EngineDefs.h"
+//=============================
+
+namespace Spartan
+{
+    // What heap allocations are attributed to, allocations are tagged with the tag of the calling thread
+    enum Memory_Tag : uint8_t
+    {
+        Memory_Tag_Other,
+        Memory_Tag_Renderer,
+        Memory_Tag_World,
+        Memory_Tag_Physics,
+        Memory_Tag_Resources,
+        Memory_Tag_Scripting,
+        Memory_Tag_Audio,
+        Memory_Tag_Count
+    };
+
+    struct Memory_Tag_Stats
+    {
+        int64_t bytes               = 0;    // live
+        int64_t allocations         = 0;    // live
+        uint64_t allocations_frame  = 0;    // made during the last frame
+        uint64_t budget             = 0;    // bytes, 0 for none
+    };
+
+    // Counts the heap allocations which go through the global operator new/delete (see SPARTAN_MEMORY_TRACKING), per tag.
+    // Counting is lock free, allocation happens from any thread.
+    class SPARTAN_CLASS MemoryTracker
+    {
+    public:
+        static void OnAllocate(Memory_Tag tag, size_t size);
+        static void OnFree(Memory_Tag tag, size_t size);
+
+        // The tag of the calling thread
+        static Memory_Tag GetTag();
+        static void SetTag(Memory_Tag tag);
+
+        // Takes the per frame counts and warns (once) about tags which went over their budget
+        static void OnFrameEnd();
+
+        static Memory_Tag_Stats GetStats(Memory_Tag tag);
+        static void SetBudget(Memory_Tag tag, uint64_t bytes);
+        static const char* GetTagName(Memory_Tag tag);
+        static bool IsEnabled() { return SPARTAN_MEMORY_TRACKING == 1; }
+    };
+
+    // Tags the allocations of the calling thread, for as long as it's in scope
+    class MemoryTagScope
+    {
+    public:
+        MemoryTagScope(const Memory_Tag tag)
+        {
+            m_tag_previous = MemoryTracker::GetTag();
+            MemoryTracker::SetTag(tag);
+        }
+
+        ~MemoryTagScope()
+        {
+            MemoryTracker::SetTag(m_tag_previous);
+        }
+
+    private:
+        Memory_Tag m_tag_previous = Memory_Tag_Other;
+    };
+}
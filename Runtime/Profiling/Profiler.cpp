@@ -21,12 +21,17 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =========================
 #include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <deque>
 #include "../RHI/RHI_Device.h"
 #include "../Rendering/Renderer.h"
 #include "../RHI/RHI_CommandList.h"
 #include "../Resource/ResourceCache.h"
 #include "../RHI/RHI_Implementation.h"
 #include "../Core/Timer.h"
+#include "../Threading/Threading.h"
+#include "MemoryTracker.h"
 //====================================
 
 //= NAMESPACES =====
@@ -35,19 +40,44 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace _Profiler
+    {
+        // The time blocks of the calling thread, resolved once per thread
+        thread_local TimeBlockThread* thread_blocks = nullptr;
+        thread_local const Profiler* thread_owner   = nullptr;
+
+        // Marks an entry of the open block stack which wasn't recorded
+        constexpr uint64_t time_block_skipped = numeric_limits<uint64_t>::max();
+
+        // Events (see EventAdd()), they are few so a locked queue of the most recent ones is enough
+        struct Event
+        {
+            const char* category = nullptr;
+            string detail;
+            chrono::steady_clock::time_point time;
+            thread::id thread_id;
+        };
+        constexpr size_t events_max = 4096;
+        atomic<bool> events_enabled = false;
+        mutex events_mutex;
+        deque<Event> events;
+
+        // Counters, they are never unregistered so the pointers which CounterRegister() hands out stay valid
+        mutex counters_mutex;
+        vector<unique_ptr<Counter>> counters;
+    }
+
 	Profiler::Profiler(Context* context) : ISubsystem(context)
 	{
         m_time_blocks_read.reserve(m_time_block_capacity);
-        m_time_blocks_read.resize(m_time_block_capacity);
-		m_time_blocks_write.reserve(m_time_block_capacity);
-		m_time_blocks_write.resize(m_time_block_capacity);
 	}
 
     Profiler::~Profiler()
     {
         if (m_profile) OnFrameEnd();
-        m_time_blocks_write.clear();
         m_time_blocks_read.clear();
+        m_time_block_threads.clear();
+        _Profiler::events_enabled = false;
         ClearRhiMetrics();
     }
 
@@ -56,6 +86,7 @@ namespace Spartan
 		m_resource_manager	= m_context->GetSubsystem<ResourceCache>();
 		m_renderer			= m_context->GetSubsystem<Renderer>();
         m_timer             = m_context->GetSubsystem<Timer>();
+        m_threading         = m_context->GetSubsystem<Threading>();
 
 		return true;
 	}
@@ -69,44 +100,31 @@ namespace Spartan
         if (!rhi_device || !rhi_device->GetContextRhi()->profiler)
             return;
 
-        if (m_increase_capacity)
+        if (m_profile)
         {
             OnFrameEnd();
-
-            const uint32_t new_size = m_time_block_count + 100;
-            m_time_blocks_read.reserve(new_size);
-            m_time_blocks_read.resize(new_size);
-            m_time_blocks_write.reserve(new_size);
-            m_time_blocks_write.resize(new_size);
-            LOG_WARNING("Time block list has grown to fit %d commands. Consider making the capacity larger to avoid re-allocations.", m_time_block_count + 1);
-            m_increase_capacity = false;
-            m_profile = true;
-        }
-        else
-        {
-            if (m_profile)
-            {
-                OnFrameEnd();
-            }
         }
 
         // Compute fps
         ComputeFps(delta_time);
 
-        // Check whether we should profile or not
+        // Allocations per frame and memory budgets
+        MemoryTracker::OnFrameEnd();
+
+        // Check whether we should profile or not (a trace capture needs every frame)
         m_time_since_profiling_sec += delta_time;
-        if (m_time_since_profiling_sec >= m_profiling_interval_sec)
-        {
-            m_time_since_profiling_sec  = 0.0f;
-            m_profile                   = true;
-        }
-        else if (m_profile)
+        const bool interval_elapsed = m_time_since_profiling_sec >= m_profiling_interval_sec;
+        if (interval_elapsed)
         {
-            m_profile = false;
+            m_time_since_profiling_sec = 0.0f;
         }
+        m_profile = interval_elapsed || m_trace_capturing;
+
+        // Every frame, so that per frame counters start over
+        CountersLatch();
 
         // Updating every m_profiling_interval_sec
-        if (m_profile)
+        if (interval_elapsed)
         {
             AcquireGpuData();
 
@@ -122,35 +140,52 @@ namespace Spartan
 
     void Profiler::OnFrameEnd()
     {
-        // Clear time blocks
+        // Merge the time blocks which the threads have published
         {
-            uint32_t pass_index_gpu = 0;
+            m_trace_gpu_cursor.clear();
+            m_time_blocks_read.clear();
 
-            for (uint32_t i = 0; i < m_time_block_count; i++)
+            lock_guard<mutex> lock(m_time_block_threads_mutex);
+            for (const unique_ptr<TimeBlockThread>& thread : m_time_block_threads)
             {
-                TimeBlock& time_block = m_time_blocks_write[i];
+                const uint64_t capacity     = thread->blocks.size();
+                const uint64_t published    = thread->published.load(memory_order_acquire);
 
-                if (time_block.IsComplete())
+                for (uint64_t i = thread->consumed.load(memory_order_relaxed); i < published; i++)
                 {
+                    TimeBlock& time_block = thread->blocks[i % capacity];
+
                     // Must not happen when TimeBlockEnd() ends as D3D11 waits
                     // too much for the results to be ready, which increases CPU time.
-                    time_block.ComputeDuration(pass_index_gpu);
-                    if (time_block.GetType() == TimeBlock_Gpu)
+                    time_block.ComputeDuration();
+
+                    m_time_blocks_read.emplace_back(time_block);
+
+                    if (m_trace_capturing)
                     {
-                        pass_index_gpu += 2;
+                        TraceRecord(time_block);
                     }
 
-                    m_time_blocks_read[i] = time_block;
+                    time_block.Reset();
                 }
-                else
+
+                thread->consumed.store(published, memory_order_release);
+
+                if (const uint32_t dropped = thread->dropped.exchange(0))
                 {
-                    LOG_WARNING("TimeBlockEnd() was not called for time block \"%s\"", time_block.GetName());
+                    LOG_WARNING("%d time blocks of thread \"%s\" didn't fit, consider increasing the capacity (%d)", dropped, GetThreadName(thread->thread_id).c_str(), m_time_block_capacity);
                 }
-                
-                time_block.Reset();
             }
 
-            m_time_block_count = 0;
+            m_time_blocks_read_frame++;
+        }
+
+        // Swap time samples
+        {
+            lock_guard<mutex> lock(m_time_blocks_mutex);
+            m_time_samples_read.swap(m_time_samples_write);
+            m_time_samples_write.clear();
+            sort(m_time_samples_read.begin(), m_time_samples_read.end(), [](const TimeSample& a, const TimeSample& b) { return a.duration > b.duration; });
         }
 
         // Detect stutters
@@ -166,17 +201,39 @@ namespace Spartan
             m_time_cpu_last         = 0.0f;
             m_time_gpu_last         = 0.0f;
 
+            // Worker threads run in parallel with the frame, so only the roots of the other threads add up to the frame's CPU time
+            const auto is_worker = [this](const thread::id thread_id)
+            {
+                for (const unique_ptr<TimeBlockThread>& thread : m_time_block_threads)
+                {
+                    if (thread->thread_id == thread_id)
+                        return thread->is_worker;
+                }
+                return false;
+            };
+
+            thread::id thread_id_last;
+            bool thread_is_worker = false;
             for (const TimeBlock& time_block : m_time_blocks_read)
             {
-                if (!time_block.IsComplete())
+                if (!time_block.IsComplete() || time_block.GetTreeDepth() != 0)
                     continue;
 
-                if (!time_block.GetParent() && time_block.GetType() == TimeBlock_Cpu)
+                if (time_block.GetType() == TimeBlock_Cpu)
                 {
-                    m_time_cpu_last += time_block.GetDuration();
+                    if (time_block.GetThreadId() != thread_id_last)
+                    {
+                        thread_id_last      = time_block.GetThreadId();
+                        thread_is_worker    = is_worker(thread_id_last);
+                    }
+
+                    if (!thread_is_worker)
+                    {
+                        m_time_cpu_last += time_block.GetDuration();
+                    }
                 }
 
-                if (!time_block.GetParent() && time_block.GetType() == TimeBlock_Gpu)
+                if (time_block.GetType() == TimeBlock_Gpu)
                 {
                     m_time_gpu_last += time_block.GetDuration();
                 }
@@ -194,44 +251,427 @@ namespace Spartan
 
             // Frame
             m_time_frame_last   = static_cast<float>(m_timer->GetDeltaTimeMs());
+            if (m_hitch_capturing)
+            {
+                HitchRecord(m_time_frame_avg);
+            }
             m_time_frame_avg    = m_time_frame_avg * (1.0f - delta_feedback) + m_time_frame_last * delta_feedback;
             m_time_frame_min    = Math::Helper::Min(m_time_frame_min, m_time_frame_last);
             m_time_frame_max    = Math::Helper::Max(m_time_frame_max, m_time_frame_last);
         }
     }
 
-    void Profiler::TimeBlockStart(const char* func_name, TimeBlock_Type type, RHI_CommandList* cmd_list /*= nullptr*/)
+    void Profiler::TimeBlockStart(const char* func_name, TimeBlock_Type type, RHI_CommandList* cmd_list /*= nullptr*/, const bool statistics /*= false*/)
 	{
-		if (!m_profile)
-			return;
+        TimeBlockThread* thread = GetTimeBlockThread();
 
         const bool can_profile_cpu = (type == TimeBlock_Cpu) && m_profile_cpu_enabled;
         const bool can_profile_gpu = (type == TimeBlock_Gpu) && m_profile_gpu_enabled;
 
-		if (!can_profile_cpu && !can_profile_gpu)
+		if (!m_profile || (!can_profile_cpu && !can_profile_gpu))
+		{
+            thread->open.emplace_back(_Profiler::time_block_skipped);
+			return;
+		}
+
+        // The ring is full, the profiler hasn't consumed the previous blocks yet
+        const uint64_t capacity = thread->blocks.size();
+        if (thread->recorded - thread->consumed.load(memory_order_acquire) >= capacity)
+        {
+            thread->dropped.fetch_add(1, memory_order_relaxed);
+            thread->open.emplace_back(_Profiler::time_block_skipped);
+            return;
+        }
+
+        // Last open block of the same type, is the parent
+        const TimeBlock* time_block_parent = nullptr;
+        for (auto it = thread->open.rbegin(); it != thread->open.rend(); it++)
+        {
+            if (*it != _Profiler::time_block_skipped && thread->blocks[*it % capacity].GetType() == type)
+            {
+                time_block_parent = &thread->blocks[*it % capacity];
+                break;
+            }
+        }
+
+        TimeBlock& time_block = thread->blocks[thread->recorded % capacity];
+        thread->open.emplace_back(thread->recorded++);
+        thread->open_recorded++;
+
+        time_block.Begin(func_name, type, time_block_parent, cmd_list, m_renderer->GetRhiDevice(), statistics);
+	}
+
+	void Profiler::TimeSampleAdd(const char* name, const float duration_ms)
+	{
+		if (!IsProfilingCpu())
 			return;
 
-        // Last incomplete block of the same type, is the parent
-        TimeBlock* time_block_parent = GetLastIncompleteTimeBlock(type);
+		lock_guard<mutex> lock(m_time_blocks_mutex);
 
-		if (TimeBlock* time_block = GetNewTimeBlock())
+		for (TimeSample& sample : m_time_samples_write)
 		{
-			time_block->Begin(func_name, type, time_block_parent, cmd_list, m_renderer->GetRhiDevice());
+			if (sample.name == name)
+			{
+				sample.duration += duration_ms;
+				sample.count++;
+				return;
+			}
 		}
+
+		TimeSample& sample	= m_time_samples_write.emplace_back();
+		sample.name			= name;
+		sample.duration		= duration_ms;
+		sample.count		= 1;
 	}
 
 	void Profiler::TimeBlockEnd()
 	{
-        // If the capacity 
-        if (m_increase_capacity)
+        TimeBlockThread* thread = GetTimeBlockThread();
+        if (thread->open.empty())
             return;
 
-		if (TimeBlock* time_block = GetLastIncompleteTimeBlock())
-		{
-			time_block->End();
-		}
+        const uint64_t index = thread->open.back();
+        thread->open.pop_back();
+
+        if (index == _Profiler::time_block_skipped)
+            return;
+
+        thread->blocks[index % thread->blocks.size()].End();
+
+        // Once the root has ended, the whole tree can be consumed
+        if (--thread->open_recorded == 0)
+        {
+            thread->published.store(thread->recorded, memory_order_release);
+        }
 	}
 
+    const string& Profiler::GetThreadName(const thread::id thread_id) const
+    {
+        static const string unknown = "unknown";
+        return m_threading ? m_threading->GetThreadName(thread_id) : unknown;
+    }
+
+    void Profiler::TraceCaptureStart(const uint32_t capacity /*= 262144*/)
+    {
+        lock_guard<mutex> lock(m_trace_mutex);
+
+        m_trace_events.clear();
+        m_trace_events.resize(Math::Helper::Max(capacity, 1u));
+        m_trace_event_count = 0;
+        m_trace_counters.clear();
+        m_trace_counters.resize(Math::Helper::Max(capacity / 4, 1u));
+        m_trace_counter_count = 0;
+        m_trace_start       = chrono::steady_clock::now();
+        m_trace_capturing   = true;
+
+        LOG_INFO("Capturing up to %d time blocks", capacity);
+    }
+
+    void Profiler::TraceCaptureStop()
+    {
+        m_trace_capturing = false;
+    }
+
+    void Profiler::TraceRecord(const TimeBlock& time_block)
+    {
+        lock_guard<mutex> lock(m_trace_mutex);
+
+        // Intern the name, blocks can be named by strings which don't outlive them
+        const char* name = time_block.GetName() ? time_block.GetName() : "N/A";
+        auto it = m_trace_names.find(name);
+        if (it == m_trace_names.end())
+        {
+            it = m_trace_names.emplace(name, name).first;
+        }
+
+        TraceEvent& event   = m_trace_events[m_trace_event_count++ % m_trace_events.size()];
+        event.name          = it->second.c_str();
+        event.type          = time_block.GetType();
+        event.thread_id     = time_block.GetThreadId();
+        event.duration      = static_cast<double>(time_block.GetDuration()) * 1000.0;
+        event.start         = chrono::duration<double, micro>(time_block.GetStartTime() - m_trace_start).count();
+
+        // There are no GPU clock timestamps to line up with the CPU, so the GPU blocks of a frame are laid out back to back,
+        // starting no earlier than they were recorded. Children start with their parent, so a timeline shows them nested.
+        if (event.type == TimeBlock_Gpu)
+        {
+            const uint32_t depth = time_block.GetTreeDepth();
+            if (m_trace_gpu_cursor.size() < depth + 2)
+            {
+                m_trace_gpu_cursor.resize(depth + 2, 0.0);
+            }
+
+            event.start                     = (depth == 0) ? Math::Helper::Max(event.start, m_trace_gpu_cursor[0]) : m_trace_gpu_cursor[depth];
+            m_trace_gpu_cursor[depth]       = event.start + event.duration;
+            m_trace_gpu_cursor[depth + 1]   = event.start;
+        }
+    }
+
+    bool Profiler::TraceExport(const string& file_path)
+    {
+        return TraceWrite(file_path, numeric_limits<double>::lowest(), "");
+    }
+
+    bool Profiler::TraceWrite(const string& file_path, const double since, const string& metadata)
+    {
+        lock_guard<mutex> lock(m_trace_mutex);
+
+        const uint64_t capacity = m_trace_events.size();
+        const uint64_t count    = Math::Helper::Min(m_trace_event_count, static_cast<uint64_t>(capacity));
+        if (count == 0)
+        {
+            LOG_WARNING("There are no captured time blocks to export");
+            return false;
+        }
+
+        ofstream out(file_path, ios::out | ios::trunc);
+        if (!out.is_open())
+        {
+            LOG_ERROR("Failed to open \"%s\" for writing", file_path.c_str());
+            return false;
+        }
+
+        // Escapes the characters which JSON doesn't allow in strings
+        const auto write_string = [&out](const char* text)
+        {
+            out << '"';
+            for (const char* c = text; *c; c++)
+            {
+                if (*c == '"' || *c == '\\')      out << '\\' << *c;
+                else if (static_cast<unsigned char>(*c) < 0x20) out << ' ';
+                else                                out << *c;
+            }
+            out << '"';
+        };
+
+        // CPU threads are the threads of process 1, the GPU is process 2
+        const int pid_cpu = 1;
+        const int pid_gpu = 2;
+        unordered_map<thread::id, int> thread_ids;
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid_cpu << ",\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+        out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid_gpu << ",\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+        out.precision(3);
+        out << fixed;
+
+        // Threads get a tid (and a name) the first time they show up
+        const auto get_tid = [&](const thread::id thread_id)
+        {
+            auto it = thread_ids.find(thread_id);
+            if (it == thread_ids.end())
+            {
+                it = thread_ids.emplace(thread_id, static_cast<int>(thread_ids.size()) + 1).first;
+
+                const string thread_name = m_threading ? m_threading->GetThreadName(thread_id) : "thread_" + to_string(it->second);
+                out << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid_cpu << ",\"tid\":" << it->second << ",\"args\":{\"name\":";
+                write_string(thread_name.c_str());
+                out << "}}";
+            }
+            return it->second;
+        };
+
+        // Time blocks, oldest first
+        uint32_t written = 0;
+        const uint64_t first = m_trace_event_count - count;
+        for (uint64_t i = first; i < m_trace_event_count; i++)
+        {
+            const TraceEvent& event = m_trace_events[i % capacity];
+            if (event.start < since)
+                continue;
+
+            const bool is_gpu   = event.type == TimeBlock_Gpu;
+            const int tid       = is_gpu ? 0 : get_tid(event.thread_id);
+
+            out << ",\n{\"ph\":\"X\",\"name\":";
+            write_string(event.name);
+            out << ",\"cat\":\"" << (is_gpu ? "gpu" : "cpu") << "\",\"pid\":" << (is_gpu ? pid_gpu : pid_cpu) << ",\"tid\":" << tid;
+            out << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+            written++;
+        }
+
+        // Events, as instant events on the thread which added them
+        {
+            lock_guard<mutex> lock_events(_Profiler::events_mutex);
+            for (const _Profiler::Event& event : _Profiler::events)
+            {
+                const double time = chrono::duration<double, micro>(event.time - m_trace_start).count();
+                if (time < since)
+                    continue;
+
+                out << ",\n{\"ph\":\"i\",\"s\":\"t\",\"name\":";
+                write_string(event.category);
+                out << ",\"cat\":\"event\",\"pid\":" << pid_cpu << ",\"tid\":" << get_tid(event.thread_id) << ",\"ts\":" << time << ",\"args\":{\"detail\":";
+                write_string(event.detail.c_str());
+                out << "}}";
+            }
+        }
+
+        // Counters, as counter tracks
+        const uint64_t counter_count = Math::Helper::Min(m_trace_counter_count, static_cast<uint64_t>(m_trace_counters.size()));
+        for (uint64_t i = m_trace_counter_count - counter_count; i < m_trace_counter_count; i++)
+        {
+            const TraceCounter& sample = m_trace_counters[i % m_trace_counters.size()];
+            if (sample.time < since)
+                continue;
+
+            out << ",\n{\"ph\":\"C\",\"name\":";
+            write_string(sample.counter->name.c_str());
+            out << ",\"cat\":\"counter\",\"pid\":" << pid_cpu << ",\"ts\":" << sample.time << ",\"args\":{";
+            write_string(sample.counter->unit.empty() ? "value" : sample.counter->unit.c_str());
+            out << ":" << sample.value << "}}";
+        }
+
+        // Hitch capture frames, as counters
+        const uint64_t frame_count = Math::Helper::Min(m_hitch_frame_count, static_cast<uint64_t>(m_hitch_frames.size()));
+        for (uint64_t i = m_hitch_frame_count - frame_count; i < m_hitch_frame_count; i++)
+        {
+            const HitchFrame& frame = m_hitch_frames[i % m_hitch_frames.size()];
+            if (frame.start < since)
+                continue;
+
+            out << ",\n{\"ph\":\"C\",\"name\":\"Frame\",\"pid\":" << pid_cpu << ",\"ts\":" << frame.start << ",\"args\":{";
+            out << "\"frame_ms\":" << frame.time_frame << ",\"cpu_ms\":" << frame.time_cpu << ",\"gpu_ms\":" << frame.time_gpu << "}}";
+            out << ",\n{\"ph\":\"C\",\"name\":\"Allocations\",\"pid\":" << pid_cpu << ",\"ts\":" << frame.start << ",\"args\":{\"count\":" << frame.allocations << "}}";
+        }
+
+        out << "\n]";
+        if (!metadata.empty())
+        {
+            out << ",\"metadata\":{" << metadata << "}";
+        }
+        out << "}\n";
+        out.close();
+
+        LOG_INFO("Exported %d time blocks to \"%s\"", written, file_path.c_str());
+        return true;
+    }
+
+    void Profiler::SetHitchCapture(const bool enabled, const float threshold /*= 2.0f*/, const uint32_t frames /*= 120*/)
+    {
+        m_hitch_capturing   = enabled;
+        m_hitch_threshold   = threshold;
+
+        if (enabled)
+        {
+            m_hitch_frames.assign(Math::Helper::Max(frames, 2u), HitchFrame());
+            m_hitch_frame_count = 0;
+            m_hitch_frame_last  = 0;
+
+            if (!m_trace_capturing)
+            {
+                TraceCaptureStart();
+            }
+        }
+        else
+        {
+            TraceCaptureStop();
+
+            lock_guard<mutex> lock(_Profiler::events_mutex);
+            _Profiler::events.clear();
+        }
+
+        _Profiler::events_enabled = enabled;
+    }
+
+    void Profiler::HitchRecord(const float time_frame_avg)
+    {
+        const auto now = chrono::steady_clock::now();
+
+        uint64_t allocations = 0;
+        for (uint8_t i = 0; i < Memory_Tag_Count; i++)
+        {
+            allocations += MemoryTracker::GetStats(static_cast<Memory_Tag>(i)).allocations_frame;
+        }
+
+        HitchFrame& frame   = m_hitch_frames[m_hitch_frame_count++ % m_hitch_frames.size()];
+        frame.time_frame    = m_time_frame_last;
+        frame.time_cpu      = m_time_cpu_last;
+        frame.time_gpu      = m_time_gpu_last;
+        frame.allocations   = allocations;
+        frame.frame         = m_renderer ? m_renderer->GetFrameNum() : m_hitch_frame_count;
+        frame.start         = chrono::duration<double, micro>(now - m_trace_start).count() - m_time_frame_last * 1000.0;
+
+        // The average needs some frames to settle, and a report per hitch is enough (writing one is a hitch of its own)
+        const uint64_t frames = m_hitch_frames.size();
+        if (m_hitch_frame_count < frames || m_hitch_frame_count - m_hitch_frame_last < frames)
+            return;
+
+        if (m_time_frame_last <= time_frame_avg * m_hitch_threshold)
+            return;
+
+        m_hitch_frame_last = m_hitch_frame_count;
+        m_hitch_count++;
+
+        char metadata[256];
+        sprintf_s(metadata, "\"frame\":%llu,\"frame_ms\":%.3f,\"average_ms\":%.3f,\"threshold\":%.2f",
+            static_cast<unsigned long long>(frame.frame), m_time_frame_last, time_frame_avg, m_hitch_threshold);
+
+        // The oldest frame which is kept is where the report starts
+        const double since = m_hitch_frames[m_hitch_frame_count % frames].start;
+        const string file_path = "profiler_hitch_" + to_string(frame.frame) + ".json";
+        LOG_WARNING("Frame %llu took %.2f ms (average %.2f ms), saving a report to \"%s\"", static_cast<unsigned long long>(frame.frame), m_time_frame_last, time_frame_avg, file_path.c_str());
+        TraceWrite(file_path, since, metadata);
+    }
+
+    void Profiler::EventAdd(const char* category, const string& detail)
+    {
+        if (!_Profiler::events_enabled.load(memory_order_relaxed))
+            return;
+
+        lock_guard<mutex> lock(_Profiler::events_mutex);
+
+        _Profiler::Event& event = _Profiler::events.emplace_back();
+        event.category          = category;
+        event.detail            = detail;
+        event.time              = chrono::steady_clock::now();
+        event.thread_id         = this_thread::get_id();
+
+        if (_Profiler::events.size() > _Profiler::events_max)
+        {
+            _Profiler::events.pop_front();
+        }
+    }
+
+    Counter* Profiler::CounterRegister(const char* name, const char* unit /*= ""*/, const Counter_Type type /*= Counter_PerFrame*/)
+    {
+        lock_guard<mutex> lock(_Profiler::counters_mutex);
+
+        for (const unique_ptr<Counter>& counter : _Profiler::counters)
+        {
+            if (counter->name == name)
+                return counter.get();
+        }
+
+        return _Profiler::counters.emplace_back(make_unique<Counter>(name, unit, type)).get();
+    }
+
+    void Profiler::CountersLatch()
+    {
+        const double time = chrono::duration<double, micro>(chrono::steady_clock::now() - m_trace_start).count();
+
+        lock_guard<mutex> lock(_Profiler::counters_mutex);
+
+        m_counters_read.resize(_Profiler::counters.size());
+        for (size_t i = 0; i < _Profiler::counters.size(); i++)
+        {
+            Counter* counter            = _Profiler::counters[i].get();
+            m_counters_read[i].counter  = counter;
+            m_counters_read[i].value    = counter->type == Counter_PerFrame ? counter->value.exchange(0, memory_order_relaxed) : counter->value.load(memory_order_relaxed);
+
+            if (m_trace_capturing)
+            {
+                lock_guard<mutex> lock_trace(m_trace_mutex);
+
+                TraceCounter& sample    = m_trace_counters[m_trace_counter_count++ % m_trace_counters.size()];
+                sample.counter          = counter;
+                sample.time             = time;
+                sample.value            = m_counters_read[i].value;
+            }
+        }
+    }
+
     void Profiler::ResetMetrics()
     {
         m_time_frame_avg    = 0.0f;
@@ -248,34 +688,26 @@ namespace Spartan
         m_time_gpu_last     = 0.0f;
     }
 
-    TimeBlock* Profiler::GetNewTimeBlock()
-	{
-		// Increase capacity if needed
-		if (m_time_block_count >= static_cast<uint32_t>(m_time_blocks_write.size()))
-		{
-            m_increase_capacity = true;
-            return nullptr;
-		}
+    TimeBlockThread* Profiler::GetTimeBlockThread()
+    {
+        if (_Profiler::thread_owner == this)
+            return _Profiler::thread_blocks;
 
-		// Return a time block
-		return &m_time_blocks_write[m_time_block_count++];
-	}
+        // First block of this thread, the ring is allocated once and never grows (the profiler could be reading it)
+        auto thread         = make_unique<TimeBlockThread>();
+        thread->thread_id   = this_thread::get_id();
+        thread->is_worker   = m_threading && m_threading->IsWorkerThread();
+        thread->blocks.resize(m_time_block_capacity);
+        thread->open.reserve(32);
 
-	TimeBlock* Profiler::GetLastIncompleteTimeBlock(TimeBlock_Type type /*= TimeBlock_Undefined*/)
-	{
-		for (int i = m_time_block_count - 1; i >= 0; i--)
-		{
-			TimeBlock& time_block = m_time_blocks_write[i];
+        _Profiler::thread_blocks    = thread.get();
+        _Profiler::thread_owner     = this;
 
-            if (type == time_block.GetType() || type == TimeBlock_Undefined)
-            {
-                if (!time_block.IsComplete())
-                    return &time_block;
-            }
-		}
+        lock_guard<mutex> lock(m_time_block_threads_mutex);
+        m_time_block_threads.emplace_back(move(thread));
 
-		return nullptr;
-	}
+        return _Profiler::thread_blocks;
+    }
 
 	void Profiler::ComputeFps(const float delta_time)
 	{
@@ -298,8 +730,15 @@ namespace Spartan
             m_gpu_name              = physical_device->GetName();
             m_gpu_memory_used       = RHI_CommandList::Gpu_GetMemoryUsed(rhi_device);
             m_gpu_memory_available  = RHI_CommandList::Gpu_GetMemory(rhi_device);
+            m_gpu_memory_budget     = rhi_device->Memory_GetBudget();
             m_gpu_driver            = physical_device->GetDriverVersion();
             m_gpu_api               = physical_device->GetApiVersion();
+
+            for (uint32_t i = 0; i < RHI_Memory_Pool_Count; i++)
+            {
+                m_gpu_memory_pools[i] = RHI_Memory_Pool_Stats();
+                rhi_device->Memory_GetPoolStats(static_cast<RHI_Memory_Pool>(i), m_gpu_memory_pools[i]);
+            }
         }
     }
 
@@ -387,5 +826,19 @@ namespace Spartan
 		);
 
 		m_metrics = string(buffer);
+
+        // Counters
+        if (!m_counters_read.empty())
+        {
+            m_metrics += "\n";
+            for (const CounterValue& counter : m_counters_read)
+            {
+                m_metrics += "\n" + counter.counter->name + ":\t\t" + to_string(counter.value);
+                if (!counter.counter->unit.empty())
+                {
+                    m_metrics += " " + counter.counter->unit;
+                }
+            }
+        }
 	}
 }
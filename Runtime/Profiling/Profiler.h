@@ -24,10 +24,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==================
 #include <string>
 #include <vector>
+#include <array>
+#include <mutex>
+#include <unordered_map>
 #include "TimeBlock.h"
 #include "../Core/EngineDefs.h"
 #include "../Core/ISubsystem.h"
 #include "../Core/Stopwatch.h"
+#include "../RHI/RHI_Definition.h"
 //=============================
 
 #define TIME_BLOCK_START_NAMED(profiler, name)  profiler->TimeBlockStart(name, Spartan::TimeBlock_Type::TimeBlock_Cpu, nullptr);
@@ -42,6 +46,68 @@ namespace Spartan
 	class Renderer;
     class Variant;
     class Timer;
+    class Threading;
+
+    // A named duration which is summed over a frame, for work which is too fine grained for a time block each (e.g. script calls)
+    struct TimeSample
+    {
+        std::string name;
+        float duration  = 0.0f; // ms
+        uint32_t count  = 0;
+    };
+
+    // The time blocks of a thread. Only the owning thread records into it and only the profiler consumes it (at the end of a frame),
+    // so it's a single producer, single consumer ring which needs no locks. A tree of blocks is published once its root has ended.
+    struct TimeBlockThread
+    {
+        std::thread::id thread_id;
+        bool is_worker                      = false;
+        std::vector<TimeBlock> blocks;
+        std::atomic<uint64_t> published     = 0; // written by the thread, the blocks before this are complete
+        std::atomic<uint64_t> consumed      = 0; // written by the profiler, the slots before this can be reused
+        std::atomic<uint32_t> dropped       = 0; // blocks which didn't fit, the profiler reports and resets these
+        // Only accessed by the owning thread
+        uint64_t recorded                   = 0;
+        uint32_t open_recorded              = 0;
+        std::vector<uint64_t> open;              // the blocks which haven't ended, skipped ones included so that ends still pair up
+    };
+
+    enum Counter_Type
+    {
+        Counter_PerFrame,   // starts from zero every frame, publishers add to it
+        Counter_Cumulative  // keeps its value across frames, publishers add to it (a total) or set it (a level, e.g. a queue's depth)
+    };
+
+    // A named value which any subsystem can publish to, from any thread (see Profiler::CounterRegister())
+    struct Counter
+    {
+        Counter(const char* name, const char* unit, const Counter_Type type) : name(name), unit(unit), type(type) {}
+
+        void Add(const int64_t amount = 1)  { value.fetch_add(amount, std::memory_order_relaxed); }
+        void Set(const int64_t amount)      { value.store(amount, std::memory_order_relaxed); }
+
+        const std::string name;
+        const std::string unit;
+        const Counter_Type type;
+        std::atomic<int64_t> value = 0;
+    };
+
+    // The value of a counter when the last frame ended
+    struct CounterValue
+    {
+        const Counter* counter  = nullptr;
+        int64_t value           = 0;
+    };
+
+    // A time block of a trace capture, times are in microseconds since the capture started
+    struct TraceEvent
+    {
+        const char* name    = nullptr; // interned by the profiler, valid for as long as the profiler is
+        TimeBlock_Type type = TimeBlock_Undefined;
+        std::thread::id thread_id;
+        double start        = 0.0;
+        double duration     = 0.0;
+    };
 
 	class SPARTAN_CLASS Profiler : public ISubsystem
 	{
@@ -55,15 +121,44 @@ namespace Spartan
 		//===================================
 
         void OnFrameEnd();
-		void TimeBlockStart(const char* func_name, TimeBlock_Type type, RHI_CommandList* cmd_list = nullptr);
+		// GPU blocks can also collect pipeline statistics (the passes do)
+		void TimeBlockStart(const char* func_name, TimeBlock_Type type, RHI_CommandList* cmd_list = nullptr, bool statistics = false);
 		void TimeBlockEnd();
+        // Can be called from any thread, the samples of a frame are sorted by duration
+        void TimeSampleAdd(const char* name, float duration_ms);
         void ResetMetrics();
 
+        // Trace capture, while capturing every frame is profiled and its time blocks are kept in a ring buffer (the oldest are overwritten).
+        // The export is Chrome trace JSON, which chrome://tracing and the Perfetto UI can open.
+        void TraceCaptureStart(uint32_t capacity = 262144);
+        void TraceCaptureStop();
+        bool TraceExport(const std::string& file_path);
+        bool IsTraceCapturing()                         const { return m_trace_capturing; }
+
+        // Hitch capture, keeps a trace capture running and when a frame takes longer than threshold times the average frame time,
+        // the last frames (time blocks, allocations and the events below) are saved as a report (a trace which has the hitch at its end).
+        void SetHitchCapture(bool enabled, float threshold = 2.0f, uint32_t frames = 120);
+        bool IsHitchCapturing()                         const { return m_hitch_capturing; }
+        uint32_t GetHitchCount()                        const { return m_hitch_count; }
+        // Work which commonly causes hitches (pipeline and descriptor creation, file I/O), recorded while a hitch capture runs, from any thread
+        static void EventAdd(const char* category, const std::string& detail);
+        uint32_t GetTraceEventCount()                   const { return static_cast<uint32_t>(m_trace_event_count < m_trace_events.size() ? m_trace_event_count : m_trace_events.size()); }
+
+        // Counters, a subsystem registers a counter once (a name which is already registered returns the same counter) and keeps
+        // the pointer, which is valid for as long as the process is. Their values are latched when a frame ends, trace captures
+        // keep them as counter tracks.
+        static Counter* CounterRegister(const char* name, const char* unit = "", Counter_Type type = Counter_PerFrame);
+        const auto& GetCounters()                       const { return m_counters_read; } // in the order they were registered
+
         // Properties
 		void SetProfilingEnabledCpu(const bool enabled)	{ m_profile_cpu_enabled = enabled; }
 		void SetProfilingEnabledGpu(const bool enabled)	{ m_profile_gpu_enabled = enabled; }
 		const std::string& GetMetrics()                 const { return m_metrics; }
-		const auto& GetTimeBlocks()                     const { return m_time_blocks_read; }
+		const auto& GetTimeBlocks()                     const { return m_time_blocks_read; } // grouped by thread, in the order they started
+		uint64_t GetTimeBlocksFrame()                   const { return m_time_blocks_read_frame; } // changes whenever the time blocks of a newly profiled frame are merged
+		const std::string& GetThreadName(std::thread::id thread_id) const;
+		const auto& GetTimeSamples()                    const { return m_time_samples_read; }
+		bool IsProfilingCpu()                           const { return m_profile && m_profile_cpu_enabled; }
 		float GetTimeCpuLast()                          const { return m_time_cpu_last; }
 		float GetTimeGpuLast()                          const { return m_time_gpu_last; }
 		float GetTimeFrameLast()                        const { return m_time_frame_last; }
@@ -73,6 +168,8 @@ namespace Spartan
 		const auto& GpuGetName()                        const { return m_gpu_name; }
         auto GpuGetMemoryAvailable()                    const { return m_gpu_memory_available; }
         auto GpuGetMemoryUsed()                         const { return m_gpu_memory_used; }
+        auto GpuGetMemoryBudget()                       const { return m_gpu_memory_budget; }
+        const auto& GpuGetMemoryPoolStats()             const { return m_gpu_memory_pools; }
         bool IsCpuStuttering()                          const { return m_is_stuttering_cpu; }
         bool IsGpuStuttering()                          const { return m_is_stuttering_gpu; }
 		
@@ -127,8 +224,11 @@ namespace Spartan
             m_rhi_pipeline_barriers         = 0;
         }
 
-		TimeBlock* GetNewTimeBlock();
-		TimeBlock* GetLastIncompleteTimeBlock(TimeBlock_Type type = TimeBlock_Undefined);
+		TimeBlockThread* GetTimeBlockThread();
+		void CountersLatch();
+		void TraceRecord(const TimeBlock& time_block);
+		bool TraceWrite(const std::string& file_path, double since, const std::string& metadata);
+		void HitchRecord(float time_frame_avg);
 		void ComputeFps(float delta_time);
         void AcquireGpuData();
 		void UpdateRhiMetricsString();
@@ -139,11 +239,54 @@ namespace Spartan
 		float m_profiling_interval_sec		= 0.3f;
 		float m_time_since_profiling_sec	= m_profiling_interval_sec;
 
-		// Time blocks (double buffered)
-		uint32_t m_time_block_capacity	= 200;
-		uint32_t m_time_block_count		= 0;
-		std::vector<TimeBlock> m_time_blocks_write;
+		// Time blocks, recorded per thread and merged (by thread) at the end of a frame
+		uint32_t m_time_block_capacity	= 1024; // per thread
         std::vector<TimeBlock> m_time_blocks_read;
+        uint64_t m_time_blocks_read_frame = 0;
+        std::vector<std::unique_ptr<TimeBlockThread>> m_time_block_threads;
+        std::mutex m_time_block_threads_mutex; // only taken when a thread records for the first time and when merging
+        std::mutex m_time_blocks_mutex; // time samples can be added from any thread
+
+		// Time samples (double buffered)
+		std::vector<TimeSample> m_time_samples_write;
+		std::vector<TimeSample> m_time_samples_read;
+
+		// Trace capture
+		std::vector<TraceEvent> m_trace_events;
+		uint64_t m_trace_event_count = 0; // total recorded, the ring buffer index is this modulo the capacity
+		std::unordered_map<const char*, std::string> m_trace_names;
+		std::vector<double> m_trace_gpu_cursor; // per tree depth, where the next GPU block of the frame starts
+		std::chrono::steady_clock::time_point m_trace_start;
+		std::mutex m_trace_mutex;
+		bool m_trace_capturing = false;
+
+		// Counters, the values of the last frame, and their samples while a trace capture runs (a ring, like the time blocks)
+		struct TraceCounter
+		{
+			const Counter* counter	= nullptr;
+			double time				= 0.0;
+			int64_t value			= 0;
+		};
+		std::vector<CounterValue> m_counters_read;
+		std::vector<TraceCounter> m_trace_counters;
+		uint64_t m_trace_counter_count = 0;
+
+		// Hitch capture
+		struct HitchFrame
+		{
+			double start			= 0.0; // microseconds since the trace capture started
+			float time_frame		= 0.0f;
+			float time_cpu			= 0.0f;
+			float time_gpu			= 0.0f;
+			uint64_t allocations	= 0;
+			uint64_t frame			= 0;
+		};
+		std::vector<HitchFrame> m_hitch_frames; // ring
+		uint64_t m_hitch_frame_count	= 0;
+		uint64_t m_hitch_frame_last		= 0;	// the frame of the last report
+		uint32_t m_hitch_count			= 0;
+		float m_hitch_threshold			= 2.0f;
+		bool m_hitch_capturing			= false;
 
 		// FPS
         float m_delta_time      = 0.0f;
@@ -157,6 +300,8 @@ namespace Spartan
         std::string m_gpu_api           = "N/A";
 		uint32_t m_gpu_memory_available	= 0;
 		uint32_t m_gpu_memory_used		= 0;
+        uint32_t m_gpu_memory_budget    = 0;
+        std::array<RHI_Memory_Pool_Stats, RHI_Memory_Pool_Count> m_gpu_memory_pools;
 
         // Stutter detection
         float m_stutter_delta_ms    = 0.5f;
@@ -166,13 +311,12 @@ namespace Spartan
 		// Misc
 		std::string m_metrics = "N/A";
 		bool m_profile = true;
-        bool m_increase_capacity = 0.0f;
-        bool m_allow_time_block_end = true;
 	
 		// Dependencies
 		ResourceCache* m_resource_manager	= nullptr;
 		Renderer* m_renderer				= nullptr;
         Timer* m_timer                      = nullptr;
+        Threading* m_threading              = nullptr;
 	};
 
     class ScopedTimeBlock
@@ -32,14 +32,38 @@ using namespace std;
 
 namespace Spartan
 {
-    uint32_t TimeBlock::m_max_tree_depth = 0;
+    atomic<uint32_t> TimeBlock::m_max_tree_depth = 0;
 
 	TimeBlock::~TimeBlock()
 	{
 		Reset();
 	}
 
-	void TimeBlock::Begin(const char* name, TimeBlock_Type type, const TimeBlock* parent /*= nullptr*/, RHI_CommandList* cmd_list /*= nullptr*/, const shared_ptr<RHI_Device>& rhi_device /*= nullptr*/)
+    TimeBlock& TimeBlock::operator=(const TimeBlock& other)
+    {
+        if (this == &other)
+            return *this;
+
+        Reset();
+
+        m_name              = other.m_name;
+        m_type              = other.m_type;
+        m_duration          = other.m_duration;
+        m_parent            = other.m_parent;
+        m_tree_depth        = other.m_tree_depth;
+        m_is_complete       = other.m_is_complete;
+        m_rhi_device        = other.m_rhi_device;
+        m_thread_id         = other.m_thread_id;
+        m_start             = other.m_start;
+        m_end               = other.m_end;
+        m_cmd_list          = other.m_cmd_list;
+        m_statistics        = other.m_statistics;
+        m_has_statistics    = other.m_has_statistics;
+
+        return *this;
+    }
+
+	void TimeBlock::Begin(const char* name, TimeBlock_Type type, const TimeBlock* parent /*= nullptr*/, RHI_CommandList* cmd_list /*= nullptr*/, const shared_ptr<RHI_Device>& rhi_device /*= nullptr*/, const bool statistics /*= false*/)
 	{
 		m_name			    = name;
 		m_parent		    = parent;
@@ -47,13 +71,15 @@ namespace Spartan
 		m_rhi_device	    = rhi_device.get();
         m_cmd_list          = cmd_list;
         m_type              = type;
-        m_max_tree_depth    = Math::Helper::Max(m_max_tree_depth, m_tree_depth);
+        m_thread_id         = this_thread::get_id();
 
-		if (type == TimeBlock_Cpu)
-		{
-			m_start = chrono::high_resolution_clock::now();
-		}
-		else if (type == TimeBlock_Gpu)
+        if (m_tree_depth > m_max_tree_depth.load(memory_order_relaxed))
+        {
+            m_max_tree_depth.store(m_tree_depth, memory_order_relaxed);
+        }
+        m_start             = chrono::high_resolution_clock::now();
+
+		if (type == TimeBlock_Gpu)
 		{
 			// Create required queries
 			if (!m_query_disjoint)
@@ -65,7 +91,12 @@ namespace Spartan
 
             if (cmd_list)
             {
-                cmd_list->Timestamp_Start(m_query_disjoint, m_query_start);
+                cmd_list->Timestamp_Start(m_query_disjoint, m_query_start, &m_timestamp_start);
+
+                if (statistics)
+                {
+                    cmd_list->PipelineStatistics_Start(&m_statistics_index);
+                }
             }
 		}
 	}
@@ -80,14 +111,19 @@ namespace Spartan
 		{
             if (m_cmd_list)
             {
-                m_cmd_list->Timestamp_End(m_query_disjoint, m_query_end);
+                if (m_statistics_index != numeric_limits<uint32_t>::max())
+                {
+                    m_cmd_list->PipelineStatistics_End(m_statistics_index);
+                }
+
+                m_cmd_list->Timestamp_End(m_query_disjoint, m_query_end, &m_timestamp_end);
             }
 		}
 
         m_is_complete = true;
 	}
 
-    void TimeBlock::ComputeDuration(const uint32_t pass_index)
+    void TimeBlock::ComputeDuration()
     {
         if (!m_is_complete)
         {
@@ -104,7 +140,12 @@ namespace Spartan
         {
             if (m_cmd_list)
             {
-                m_duration = m_cmd_list->Timestamp_GetDuration(m_query_disjoint, m_query_start, m_query_end, pass_index);
+                m_duration = m_cmd_list->Timestamp_GetDuration(m_query_disjoint, m_query_start, m_query_end, m_timestamp_start, m_timestamp_end);
+
+                if (m_statistics_index != numeric_limits<uint32_t>::max())
+                {
+                    m_has_statistics = m_cmd_list->PipelineStatistics_Get(m_statistics_index, m_statistics);
+                }
             }
         }
     }
@@ -115,9 +156,12 @@ namespace Spartan
 		m_parent		    = nullptr;
 		m_tree_depth	    = 0;
 		m_duration	        = 0.0f;
-        m_max_tree_depth    = 0;
         m_type              = TimeBlock_Undefined;
         m_is_complete       = false;
+        m_timestamp_start   = numeric_limits<uint32_t>::max();
+        m_timestamp_end     = numeric_limits<uint32_t>::max();
+        m_statistics_index  = numeric_limits<uint32_t>::max();
+        m_has_statistics    = false;
 
         if (m_rhi_device && m_rhi_device->IsInitialized())
         {
@@ -24,6 +24,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <chrono>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <limits>
 #include "..\RHI\RHI_Definition.h"
 //================================
 
@@ -44,21 +47,30 @@ namespace Spartan
 		TimeBlock() = default;
 		~TimeBlock();
 
-		void Begin(const char* name, TimeBlock_Type type, const TimeBlock* parent = nullptr, RHI_CommandList* cmd_list = nullptr, const std::shared_ptr<RHI_Device>& rhi_device = nullptr);
+        // Copies are snapshots for reading, the GPU queries stay with the original
+        TimeBlock(const TimeBlock& other) { *this = other; }
+        TimeBlock& operator=(const TimeBlock& other);
+
+		void Begin(const char* name, TimeBlock_Type type, const TimeBlock* parent = nullptr, RHI_CommandList* cmd_list = nullptr, const std::shared_ptr<RHI_Device>& rhi_device = nullptr, bool statistics = false);
 		void End();
-        void ComputeDuration(const uint32_t pass_index);
+        void ComputeDuration();
         void Reset();
         TimeBlock_Type GetType()        const { return m_type; }	
 		const char* GetName()           const { return m_name; }
         const TimeBlock* GetParent()    const { return m_parent; }
         uint32_t GetTreeDepth()         const { return m_tree_depth; }
-        uint32_t GetTreeDepthMax()      const { return m_max_tree_depth; }
+        uint32_t GetTreeDepthMax()      const { return m_max_tree_depth.load(std::memory_order_relaxed); }
         float GetDuration()             const { return m_duration; }
         bool IsComplete()               const { return m_is_complete; }
+        std::thread::id GetThreadId()   const { return m_thread_id; }
+        // For GPU blocks, this is when the block was recorded on the CPU
+        const auto& GetStartTime()      const { return m_start; }
+        // GPU blocks which requested them (and which weren't nested in another block with statistics)
+        const RHI_Pipeline_Statistics* GetPipelineStatistics() const { return m_has_statistics ? &m_statistics : nullptr; }
 
 	private:	
 		static uint32_t FindTreeDepth(const TimeBlock* time_block, uint32_t depth = 0);
-        static uint32_t m_max_tree_depth;
+        static std::atomic<uint32_t> m_max_tree_depth; // blocks are recorded by any thread
 
 		const char* m_name          = nullptr;
         TimeBlock_Type m_type       = TimeBlock_Undefined;
@@ -67,6 +79,7 @@ namespace Spartan
 		uint32_t m_tree_depth	    = 0;
         bool m_is_complete          = false;
         RHI_Device* m_rhi_device    = nullptr;
+        std::thread::id m_thread_id;
 
 		// CPU timing
 		std::chrono::steady_clock::time_point m_start;
@@ -77,5 +90,10 @@ namespace Spartan
 		void* m_query_start		    = nullptr;
 		void* m_query_end		    = nullptr;
         RHI_CommandList* m_cmd_list = nullptr;
+        uint32_t m_timestamp_start  = std::numeric_limits<uint32_t>::max();
+        uint32_t m_timestamp_end    = std::numeric_limits<uint32_t>::max();
+        uint32_t m_statistics_index = std::numeric_limits<uint32_t>::max();
+        RHI_Pipeline_Statistics m_statistics;
+        bool m_has_statistics       = false;
 	};
 }
@@ -60,10 +60,22 @@ namespace Spartan
         m_rhi_device        = m_renderer->GetRhiDevice().get();
         m_pipeline_cache    = m_renderer->GetPipelineCache();
         m_descriptor_cache  = m_renderer->GetDescriptorCache();
-        m_timestamps.fill(0);
+
+        // Push constants are emulated with a constant buffer, which is small enough to be updated whole
+        D3D11_BUFFER_DESC buffer_desc   = {};
+        buffer_desc.ByteWidth           = rhi_max_push_constant_size;
+        buffer_desc.Usage               = D3D11_USAGE_DEFAULT;
+        buffer_desc.BindFlags           = D3D11_BIND_CONSTANT_BUFFER;
+        if (FAILED(m_rhi_device->GetContextRhi()->device->CreateBuffer(&buffer_desc, nullptr, reinterpret_cast<ID3D11Buffer**>(&m_push_constant_buffer))))
+        {
+            LOG_ERROR("Failed to create push constant buffer");
+        }
 	}
 
-	RHI_CommandList::~RHI_CommandList() = default;
+	RHI_CommandList::~RHI_CommandList()
+    {
+        d3d11_utility::release(*reinterpret_cast<ID3D11Buffer**>(&m_push_constant_buffer));
+    }
 
     bool RHI_CommandList::Begin()
     {
@@ -400,14 +412,28 @@ namespace Spartan
         return true;
 	}
 
-    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset)
+    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count, const uint32_t instance_offset)
     {
-        m_rhi_device->GetContextRhi()->device_context->DrawIndexed
-        (
-            static_cast<UINT>(index_count),
-            static_cast<UINT>(index_offset),
-            static_cast<INT>(vertex_offset)
-        );
+        if (instance_count == 1 && instance_offset == 0)
+        {
+            m_rhi_device->GetContextRhi()->device_context->DrawIndexed
+            (
+                static_cast<UINT>(index_count),
+                static_cast<UINT>(index_offset),
+                static_cast<INT>(vertex_offset)
+            );
+        }
+        else
+        {
+            m_rhi_device->GetContextRhi()->device_context->DrawIndexedInstanced
+            (
+                static_cast<UINT>(index_count),
+                static_cast<UINT>(instance_count),
+                static_cast<UINT>(index_offset),
+                static_cast<INT>(vertex_offset),
+                static_cast<UINT>(instance_offset)
+            );
+        }
 
         m_profiler->m_rhi_draw_calls++;
 
@@ -486,6 +512,34 @@ namespace Spartan
         m_profiler->m_rhi_bindings_buffer_vertex++;
 	}
 
+	void RHI_CommandList::SetBufferInstance(const RHI_VertexBuffer* buffer, const uint64_t offset /*= 0*/)
+    {
+		if (!buffer || !buffer->GetResource())
+		{
+			LOG_ERROR_INVALID_PARAMETER();
+			return;
+		}
+
+        ID3D11Buffer* instance_buffer       = static_cast<ID3D11Buffer*>(buffer->GetResource());
+        UINT stride                         = buffer->GetStride();
+        UINT offsets[]                      = { static_cast<UINT>(offset) };
+        ID3D11DeviceContext* device_context = m_rhi_device->GetContextRhi()->device_context;
+
+        // Get currently set buffer
+        ID3D11Buffer* set_buffer    = nullptr;
+        UINT set_stride             = buffer->GetStride();
+        UINT set_offset             = 0;
+        device_context->IAGetVertexBuffers(rhi_binding_instance, 1, &set_buffer, &set_stride, &set_offset);
+
+        // Skip if already set
+        if (set_buffer == instance_buffer && set_offset == offset)
+            return;
+
+        // Set
+        device_context->IASetVertexBuffers(rhi_binding_instance, 1, &instance_buffer, &stride, offsets);
+        m_profiler->m_rhi_bindings_buffer_vertex++;
+	}
+
 	void RHI_CommandList::SetBufferIndex(const RHI_IndexBuffer* buffer, const uint64_t offset /*= 0*/)
     {
 		if (!buffer || !buffer->GetResource())
@@ -560,6 +614,27 @@ namespace Spartan
         return true;
     }
 
+    bool RHI_CommandList::SetPushConstants(const void* data, const uint32_t size)
+    {
+        if (!m_push_constant_buffer || size > rhi_max_push_constant_size)
+        {
+            LOG_ERROR("Invalid buffer or size");
+            return false;
+        }
+
+        // Constant buffers can only be updated whole
+        array<uint8_t, rhi_max_push_constant_size> bytes = {};
+        memcpy(bytes.data(), data, size);
+
+        ID3D11DeviceContext* device_context = m_rhi_device->GetContextRhi()->device_context;
+        ID3D11Buffer* buffer                = static_cast<ID3D11Buffer*>(m_push_constant_buffer);
+        device_context->UpdateSubresource(buffer, 0, nullptr, bytes.data(), 0, 0);
+        device_context->VSSetConstantBuffers(rhi_push_constant_slot, 1, &buffer);
+        device_context->PSSetConstantBuffers(rhi_push_constant_slot, 1, &buffer);
+
+        return true;
+    }
+
     void RHI_CommandList::SetSampler(const uint32_t slot, RHI_Sampler* sampler) const
     {
         const UINT start_slot               = slot;
@@ -627,7 +702,19 @@ namespace Spartan
         m_profiler->m_rhi_bindings_texture++;
 	}
 
-    bool RHI_CommandList::Timestamp_Start(void* query_disjoint /*= nullptr*/, void* query_start /*= nullptr*/)
+    void RHI_CommandList::SetLayouts(RHI_Texture* const* textures, const RHI_Image_Layout* layouts, const uint32_t count)
+    {
+        // D3D11 transitions resources implicitly, only the tracked layouts have to be updated
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (textures[i])
+            {
+                textures[i]->SetLayout(layouts[i]);
+            }
+        }
+    }
+
+    bool RHI_CommandList::Timestamp_Start(void* query_disjoint /*= nullptr*/, void* query_start /*= nullptr*/, uint32_t* index /*= nullptr*/)
     {
         if (!query_disjoint || !query_start)
         {
@@ -648,7 +735,7 @@ namespace Spartan
         return true;
     }
 
-    bool RHI_CommandList::Timestamp_End(void* query_disjoint /*= nullptr*/, void* query_end /*= nullptr*/)
+    bool RHI_CommandList::Timestamp_End(void* query_disjoint /*= nullptr*/, void* query_end /*= nullptr*/, uint32_t* index /*= nullptr*/)
     {
         if (!query_disjoint || !query_end)
         {
@@ -670,7 +757,7 @@ namespace Spartan
         return true;
     }
 
-    float RHI_CommandList::Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t pass_index)
+    float RHI_CommandList::Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t index_start, const uint32_t index_end)
     {
         if (!query_disjoint || !query_start || !query_end)
         {
@@ -755,6 +842,22 @@ namespace Spartan
         return 0;
     }
 
+    bool RHI_CommandList::PipelineStatistics_Start(uint32_t* index)
+    {
+        // Not implemented, D3D11 would need a query object per time block
+        return false;
+    }
+
+    bool RHI_CommandList::PipelineStatistics_End(const uint32_t index)
+    {
+        return false;
+    }
+
+    bool RHI_CommandList::PipelineStatistics_Get(const uint32_t index, RHI_Pipeline_Statistics& statistics) const
+    {
+        return false;
+    }
+
     bool RHI_CommandList::Gpu_QueryCreate(RHI_Device* rhi_device, void** query, const RHI_Query_Type type)
     {
         RHI_Context* rhi_context = rhi_device->GetContextRhi();
@@ -814,7 +917,7 @@ namespace Spartan
             if (m_profiler)
             {
                 m_profiler->TimeBlockStart(pipeline_state->pass_name, TimeBlock_Cpu, this);
-                m_profiler->TimeBlockStart(pipeline_state->pass_name, TimeBlock_Gpu, this);
+                m_profiler->TimeBlockStart(pipeline_state->pass_name, TimeBlock_Gpu, this, true);
             }
         }
 
@@ -825,6 +928,38 @@ namespace Spartan
         }
     }
 
+    void RHI_CommandList::Scope_Begin(const char* name)
+    {
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+        if (rhi_context->profiler && m_profiler)
+        {
+            m_profiler->TimeBlockStart(name, TimeBlock_Cpu, this);
+            m_profiler->TimeBlockStart(name, TimeBlock_Gpu, this);
+        }
+
+        if (rhi_context->markers)
+        {
+            rhi_context->annotation->BeginEvent(FileSystem::StringToWstring(name).c_str());
+        }
+    }
+
+    void RHI_CommandList::Scope_End()
+    {
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+        if (rhi_context->markers)
+        {
+            rhi_context->annotation->EndEvent();
+        }
+
+        if (rhi_context->profiler && m_profiler)
+        {
+            m_profiler->TimeBlockEnd(); // gpu
+            m_profiler->TimeBlockEnd(); // cpu
+        }
+    }
+
     void RHI_CommandList::Timeblock_End(const RHI_PipelineState* pipeline_state)
     {
         if (!pipeline_state)
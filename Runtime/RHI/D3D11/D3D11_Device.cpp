@@ -184,6 +184,27 @@ namespace Spartan
 			}
 		}
 
+		// Layered rendering, SV_RenderTargetArrayIndex from the vertex shader
+		{
+			D3D11_FEATURE_DATA_D3D11_OPTIONS3 options = {};
+			if (SUCCEEDED(m_rhi_context->device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS3, &options, sizeof(options))))
+			{
+				m_layered_rendering = options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizer == TRUE;
+			}
+		}
+
+		// Minimum precision, min16float is only a hint here, the driver is free to keep using 32 bits
+		{
+			D3D11_FEATURE_DATA_SHADER_MIN_PRECISION_SUPPORT precision = {};
+			if (SUCCEEDED(m_rhi_context->device->CheckFeatureSupport(D3D11_FEATURE_SHADER_MIN_PRECISION_SUPPORT, &precision, sizeof(precision))))
+			{
+				m_shader_float16 = (precision.PixelShaderMinPrecision & D3D11_SHADER_MIN_PRECISION_16_BIT) != 0;
+			}
+		}
+
+		// Compute, the only backend whose command list dispatches so far
+		m_compute = true;
+
 		// Multi-thread protection
 		if (multithread_protection)
 		{
@@ -220,7 +241,7 @@ namespace Spartan
         d3d11_utility::release(m_rhi_context->annotation);
 	}
 
-    bool RHI_Device::Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore /*= nullptr*/, void* signal_semaphore /*= nullptr*/, void* wait_fence /*= nullptr*/, uint32_t wait_flags /*= 0*/) const
+    bool RHI_Device::Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore /*= nullptr*/, void* signal_semaphore /*= nullptr*/, void* wait_fence /*= nullptr*/, uint32_t wait_flags /*= 0*/, uint64_t* timeline_value /*= nullptr*/) const
     {
         return true;
     }
@@ -230,4 +251,29 @@ namespace Spartan
         m_rhi_context->device_context->Flush();
         return true;
     }
+
+    bool RHI_Device::Queue_WaitValue(const RHI_Queue_Type type, const uint64_t value) const
+    {
+        return true;
+    }
+
+    bool RHI_Device::Queue_HasTimeline() const
+    {
+        return false;
+    }
+
+    void RHI_Device::Memory_Tick(const uint64_t frame)
+    {
+
+    }
+
+    bool RHI_Device::Memory_GetPoolStats(const RHI_Memory_Pool pool, RHI_Memory_Pool_Stats& stats) const
+    {
+        return false;
+    }
+
+    uint32_t RHI_Device::Memory_GetBudget() const
+    {
+        return 0;
+    }
 }
@@ -54,15 +54,17 @@ namespace Spartan
 		vector<D3D11_INPUT_ELEMENT_DESC> vertex_attributes;
 		for (const auto& vertex_attribute : m_vertex_attributes)
 		{
+			const bool per_instance = vertex_attribute.binding == rhi_binding_instance;
+
 			vertex_attributes.emplace_back(D3D11_INPUT_ELEMENT_DESC
 			{ 
-				vertex_attribute.name.c_str(),			// SemanticName
-				0,										// SemanticIndex
-				d3d11_format[vertex_attribute.format],	// Format
-				0,										// InputSlot
-				vertex_attribute.offset,				// AlignedByteOffset
-				D3D11_INPUT_PER_VERTEX_DATA,			// InputSlotClass
-				0										// InstanceDataStepRate
+				vertex_attribute.name.c_str(),												// SemanticName
+				vertex_attribute.semantic_index,											// SemanticIndex
+				d3d11_format[vertex_attribute.format],										// Format
+				vertex_attribute.binding,													// InputSlot
+				vertex_attribute.offset,													// AlignedByteOffset
+				per_instance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA,	// InputSlotClass
+				per_instance ? 1u : 0u														// InstanceDataStepRate
 			});
 		}
 
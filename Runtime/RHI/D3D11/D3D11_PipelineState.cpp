@@ -26,13 +26,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
-    bool RHI_PipelineState::CreateFrameResources(const RHI_Device* rhi_device)
+    void* RHI_PipelineState::GetRenderPass(const RHI_Device* rhi_device) const
     {
-        return true;
+        return nullptr;
     }
 
-    void RHI_PipelineState::DestroyFrameResources()
+    void* RHI_PipelineState::GetFrameBuffer(const RHI_Device* rhi_device) const
     {
-
+        return nullptr;
     }
 }
@@ -41,21 +41,8 @@ namespace Spartan
         d3d11_utility::release(*reinterpret_cast<ID3D11VertexShader**>(&m_resource));
 	}
 
-	void* RHI_Shader::_Compile(const string& shader)
+	bool RHI_Shader::_Compile(const string& shader, vector<std::byte>& bytecode)
 	{
-		if (!m_rhi_device)
-		{
-			LOG_ERROR_INVALID_INTERNALS();
-			return nullptr;
-		}
-
-		auto d3d11_device = m_rhi_device->GetContextRhi()->device;
-		if (!d3d11_device)
-		{
-			LOG_ERROR_INVALID_INTERNALS();
-			return nullptr;
-		}
-
 		// Compile flags
         uint32_t compile_flags = 0;
 		#ifdef DEBUG
@@ -117,7 +104,7 @@ namespace Spartan
         else
         {
             LOG_ERROR("\"%s\" is not file or a source", shader.c_str());
-            return nullptr;
+            return false;
         }
 
 		// Log any compilation possible warnings and/or errors
@@ -155,40 +142,71 @@ namespace Spartan
 			}
 		}
 
+		// Get the bytecode
+		if (!shader_blob)
+            return false;
+
+        const std::byte* data = static_cast<const std::byte*>(shader_blob->GetBufferPointer());
+        bytecode.assign(data, data + shader_blob->GetBufferSize());
+        d3d11_utility::release(shader_blob);
+
+		return true;
+	}
+
+    void* RHI_Shader::_CreateResource(const vector<std::byte>& bytecode)
+    {
+		auto d3d11_device = m_rhi_device->GetContextRhi()->device;
+		if (!d3d11_device)
+		{
+			LOG_ERROR_INVALID_INTERNALS();
+			return nullptr;
+		}
+
+        // The input layout validates against the bytecode, which it expects in a blob
+        ID3DBlob* shader_blob = nullptr;
+        if (FAILED(D3DCreateBlob(bytecode.size(), &shader_blob)))
+        {
+            LOG_ERROR("Failed to create shader blob");
+            return nullptr;
+        }
+        memcpy(shader_blob->GetBufferPointer(), bytecode.data(), bytecode.size());
+
 		// Create shader
 		void* shader_view = nullptr;
-		if (shader_blob)
+		if (m_shader_type == RHI_Shader_Vertex)
 		{
-			if (m_shader_type == RHI_Shader_Vertex)
+			if (FAILED(d3d11_device->CreateVertexShader(shader_blob->GetBufferPointer(), shader_blob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11VertexShader**>(&shader_view))))
 			{
-				if (FAILED(d3d11_device->CreateVertexShader(shader_blob->GetBufferPointer(), shader_blob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11VertexShader**>(&shader_view))))
-				{
-                    LOG_ERROR("Failed to create vertex shader, %s", d3d11_utility::dxgi_error_to_string(result));
-				}
-
-				// Create input layout
-                if (!m_input_layout->Create(m_vertex_type, shader_blob))
-                {
-                    LOG_ERROR("Failed to create input layout for %s", FileSystem::GetFileNameFromFilePath(m_file_path).c_str());
-                }
+                LOG_ERROR("Failed to create vertex shader");
 			}
-			else if (m_shader_type == RHI_Shader_Pixel)
+
+			// Create input layout
+            if (!m_input_layout->Create(m_vertex_type, shader_blob, IsInstanced()))
+            {
+                LOG_ERROR("Failed to create input layout for %s", FileSystem::GetFileNameFromFilePath(m_file_path).c_str());
+            }
+		}
+		else if (m_shader_type == RHI_Shader_Pixel)
+		{
+			if (FAILED(d3d11_device->CreatePixelShader(shader_blob->GetBufferPointer(), shader_blob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11PixelShader**>(&shader_view))))
 			{
-				if (FAILED(d3d11_device->CreatePixelShader(shader_blob->GetBufferPointer(), shader_blob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11PixelShader**>(&shader_view))))
-				{
-					LOG_ERROR("Failed to create pixel shader, %s", d3d11_utility::dxgi_error_to_string(result));
-				}
+				LOG_ERROR("Failed to create pixel shader");
 			}
-            else if (m_shader_type == RHI_Shader_Compute)
+		}
+        else if (m_shader_type == RHI_Shader_Compute)
+        {
+            if (FAILED(d3d11_device->CreateComputeShader(shader_blob->GetBufferPointer(), shader_blob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11ComputeShader**>(&shader_view))))
             {
-                if (FAILED(d3d11_device->CreateComputeShader(shader_blob->GetBufferPointer(), shader_blob->GetBufferSize(), nullptr, reinterpret_cast<ID3D11ComputeShader**>(&shader_view))))
-                {
-                    LOG_ERROR("Failed to create compute shader, %s", d3d11_utility::dxgi_error_to_string(result));
-                }
+                LOG_ERROR("Failed to create compute shader");
             }
-		}
+        }
 
         d3d11_utility::release(shader_blob);
 		return shader_view;
 	}
+
+    uint32_t RHI_Shader::_GetCompilerVersion() const
+    {
+        return D3D_COMPILER_VERSION;
+    }
 }
@@ -109,11 +109,28 @@ namespace Spartan
 			desc.SwapEffect				= d3d11_utility::swap_chain::get_swap_effect(m_flags);
 			desc.Flags					= d3d11_utility::swap_chain::get_flags(m_flags);
 
+            // The flip model can hand out a waitable object which is signalled when the swapchain is ready for a new frame
+            if (d3d11_utility::swap_chain::is_flip_model(desc.SwapEffect))
+            {
+                desc.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+            }
+
 			if (!d3d11_utility::error_check(dxgi_factory->CreateSwapChain(m_rhi_device->GetContextRhi()->device, &desc, reinterpret_cast<IDXGISwapChain**>(&m_swap_chain_view))))
 			{
                 LOG_ERROR("Failed to create swapchain");
 				return;
 			}
+
+            if (desc.Flags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT)
+            {
+                IDXGISwapChain2* swap_chain_2 = nullptr;
+                if (d3d11_utility::error_check(static_cast<IDXGISwapChain*>(m_swap_chain_view)->QueryInterface(IID_PPV_ARGS(&swap_chain_2))))
+                {
+                    swap_chain_2->SetMaximumFrameLatency((m_flags & RHI_SwapChain_Low_Latency) ? 1 : rhi_frames_in_flight_max);
+                    m_frame_latency_waitable = swap_chain_2->GetFrameLatencyWaitableObject();
+                    d3d11_utility::release(swap_chain_2);
+                }
+            }
 		}
 
 		// Create the render target
@@ -159,6 +176,12 @@ namespace Spartan
 
         m_cmd_lists.clear();
 
+        if (m_frame_latency_waitable)
+        {
+            CloseHandle(static_cast<HANDLE>(m_frame_latency_waitable));
+            m_frame_latency_waitable = nullptr;
+        }
+
         d3d11_utility::release(swap_chain);
         d3d11_utility::release(*reinterpret_cast<ID3D11RenderTargetView**>(&m_resource_view_renderTarget));
 	}
@@ -218,9 +241,10 @@ namespace Spartan
             }
 		}
 	
-		// Resize swapchain buffers
-		const UINT d3d11_flags = d3d11_utility::swap_chain::get_flags(d3d11_utility::swap_chain::validate_flags(m_flags));
-		auto result = swap_chain->ResizeBuffers(m_buffer_count, static_cast<UINT>(width), static_cast<UINT>(height), d3d11_format[m_format], d3d11_flags);
+		// Resize swapchain buffers, the flags have to match the ones the swapchain was created with
+        DXGI_SWAP_CHAIN_DESC desc = {};
+        swap_chain->GetDesc(&desc);
+		auto result = swap_chain->ResizeBuffers(m_buffer_count, static_cast<UINT>(width), static_cast<UINT>(height), d3d11_format[m_format], desc.Flags);
 		if (FAILED(result))
 		{
 			LOG_ERROR("Failed to resize swapchain buffers, %s.", d3d11_utility::dxgi_error_to_string(result));
@@ -266,8 +290,10 @@ namespace Spartan
 		}
 
         // Build flags
+        // Mailbox: a sync interval of 0 without tearing, the flip model replaces the queued frame with the newest one.
+        // FifoRelaxed: there is no DXGI equivalent, it's treated as Fifo.
 		const bool tearing_allowed	= m_flags & RHI_Present_Immediate;
-        const UINT sync_interval    = tearing_allowed ? 0 : 1; // sync interval can go up to 4, so this could be improved
+        const UINT sync_interval    = (m_flags & (RHI_Present_Immediate | RHI_Present_Mailbox)) ? 0 : 1; // sync interval can go up to 4, so this could be improved
 		const UINT flags			= (tearing_allowed && m_windowed) ? DXGI_PRESENT_ALLOW_TEARING : 0;	
 
         // Present
@@ -279,6 +305,31 @@ namespace Spartan
             return false;
         }
 
+        // Block until the swapchain can take another frame, so the next one starts (and samples input) as late as possible
+        if (m_frame_latency_waitable)
+        {
+            WaitForSingleObjectEx(static_cast<HANDLE>(m_frame_latency_waitable), 1000, TRUE);
+        }
+
 		return true;
 	}
+
+    bool RHI_SwapChain::SetPresentMode(const uint32_t flags)
+    {
+        const uint32_t flags_new = (m_flags & ~(rhi_present_mode_mask | RHI_SwapChain_Low_Latency)) | (flags & (rhi_present_mode_mask | RHI_SwapChain_Low_Latency));
+        if (flags_new == m_flags)
+            return true;
+
+        // The present mode is a parameter of Present(), only the frame latency belongs to the swapchain
+        m_flags = d3d11_utility::swap_chain::validate_flags(flags_new);
+
+        IDXGISwapChain2* swap_chain_2 = nullptr;
+        if (m_frame_latency_waitable && d3d11_utility::error_check(static_cast<IDXGISwapChain*>(m_swap_chain_view)->QueryInterface(IID_PPV_ARGS(&swap_chain_2))))
+        {
+            swap_chain_2->SetMaximumFrameLatency((m_flags & RHI_SwapChain_Low_Latency) ? 1 : rhi_frames_in_flight_max);
+            d3d11_utility::release(swap_chain_2);
+        }
+
+        return true;
+    }
 }
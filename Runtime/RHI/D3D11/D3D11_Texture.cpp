@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Texture2D.h"
 #include "../RHI_TextureCube.h"
 #include "../RHI_CommandList.h"
+#include "../../Math/MathHelper.h"
 //================================
 
 //= NAMESPACES ===============
@@ -91,14 +92,13 @@ namespace Spartan
 
 	inline bool CreateTexture2d(
 		void*& texture,
+		const RHI_Texture* texture_rhi,
 		const uint32_t width,
 		const uint32_t height,
-		const uint32_t channels,
-		const uint32_t bits_per_channel,
 		const uint32_t array_size,
 		const DXGI_FORMAT format,
 		const UINT bind_flags,
-		vector<vector<std::byte>>& data,
+		const vector<const std::byte*>& data,
 		const shared_ptr<RHI_Device>& rhi_device
 	)
 	{
@@ -120,16 +120,16 @@ namespace Spartan
 		vector<D3D11_SUBRESOURCE_DATA> vec_subresource_data;
 		for (uint32_t mip_level = 0; mip_level < static_cast<uint32_t>(data.size()); mip_level++)
 		{
-			if (data[mip_level].empty())
+			if (!data[mip_level])
 			{
 				LOG_ERROR("Mipmap %d has invalid data.", mip_level);
 				return false;
 			}
 
 			auto& subresource_data				= vec_subresource_data.emplace_back(D3D11_SUBRESOURCE_DATA{});
-			subresource_data.pSysMem			= data[mip_level].data();					                // Data pointer		
-			subresource_data.SysMemPitch		= (width >> mip_level) * channels * (bits_per_channel / 8);	// Line width in bytes
-			subresource_data.SysMemSlicePitch	= 0;								                        // This is only used for 3D textures
+			subresource_data.pSysMem			= data[mip_level];							                // Data pointer		
+			subresource_data.SysMemPitch		= texture_rhi->GetRowPitch(Math::Helper::Max(width >> mip_level, 1u));	// Line width in bytes (of blocks, if compressed)
+			subresource_data.SysMemSlicePitch	= 0;								                                        // This is only used for 3D textures
 		}
 
 		// Create
@@ -165,6 +165,19 @@ namespace Spartan
             }
         }
 
+        // A view of all the slices, the vertex shader picks one
+        if (array_size > 1 && array_size < state_max_render_target_count)
+        {
+            view_desc.Texture2DArray.FirstArraySlice    = 0;
+            view_desc.Texture2DArray.ArraySize          = array_size;
+            const auto result = rhi_device->GetContextRhi()->device->CreateRenderTargetView(static_cast<ID3D11Resource*>(texture), &view_desc, reinterpret_cast<ID3D11RenderTargetView**>(&views[array_size]));
+            if (FAILED(result))
+            {
+                LOG_ERROR("Failed, %s.", d3d11_utility::dxgi_error_to_string(result));
+                return false;
+            }
+        }
+
 		return true;
 	}
 
@@ -191,10 +204,23 @@ namespace Spartan
 			}
 		}
 
+        // A view of all the slices, the vertex shader picks one
+        if (array_size > 1 && array_size < state_max_render_target_count)
+        {
+            dsv_desc.Texture2DArray.FirstArraySlice = 0;
+            dsv_desc.Texture2DArray.ArraySize       = array_size;
+            const auto result = rhi_device->GetContextRhi()->device->CreateDepthStencilView(static_cast<ID3D11Resource*>(texture), &dsv_desc, reinterpret_cast<ID3D11DepthStencilView**>(&views[array_size]));
+            if (FAILED(result))
+            {
+                LOG_ERROR("Failed, %s.", d3d11_utility::dxgi_error_to_string(result));
+                return false;
+            }
+        }
+
 		return true;
 	}
 
-	inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, vector<vector<std::byte>>& data, const shared_ptr<RHI_Device>& rhi_device)
+	inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, const vector<const std::byte*>& data, const shared_ptr<RHI_Device>& rhi_device)
 	{
 		// Describe
 		D3D11_SHADER_RESOURCE_VIEW_DESC shader_resource_view_desc	= {};
@@ -235,6 +261,11 @@ namespace Spartan
 	}
 
     RHI_Texture2D::~RHI_Texture2D()
+    {
+        DestroyResourceGpu();
+    }
+
+    void RHI_Texture2D::DestroyResourceGpu()
     {
         d3d11_utility::release(*reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource_view[0]));
         d3d11_utility::release(*reinterpret_cast<ID3D11UnorderedAccessView**>(&m_resource_view_unorderedAccess));
@@ -280,18 +311,24 @@ namespace Spartan
         const DXGI_FORMAT format_dsv	= GetDepthFormatDsv(m_format);
         const DXGI_FORMAT format_srv	= GetDepthFormatSrv(m_format);
 
+        // Mip data (it can point into a mapped file)
+        vector<const std::byte*> data(GetMipDataCount());
+        for (uint32_t mip_index = 0; mip_index < static_cast<uint32_t>(data.size()); mip_index++)
+        {
+            data[mip_index] = GetMipData(mip_index);
+        }
+
 		// TEXTURE
 		result_tex = CreateTexture2d
 		(
             m_resource,
-			m_width,
-			m_height,
-			m_channel_count,
-			m_bits_per_channel,
+			this,
+			GetWidthResident(),
+			GetHeightResident(),
 			m_array_size,
 			format,
 			flags,
-			m_data,
+			data,
 			m_rhi_device
 		);
 
@@ -303,7 +340,7 @@ namespace Spartan
                 m_resource_view[0],
                 format_srv,
                 m_array_size,
-                m_data,
+                data,
                 m_rhi_device
             );
         }
@@ -485,6 +522,19 @@ namespace Spartan
 			}
 		}
 
+        // A view of all the slices, the vertex shader picks one
+        if (array_size > 1 && array_size < state_max_render_target_count)
+        {
+            dsv_desc.Texture2DArray.FirstArraySlice = 0;
+            dsv_desc.Texture2DArray.ArraySize       = array_size;
+            const auto result = rhi_device->GetContextRhi()->device->CreateDepthStencilView(static_cast<ID3D11Resource*>(texture), &dsv_desc, reinterpret_cast<ID3D11DepthStencilView**>(&views[array_size]));
+            if (FAILED(result))
+            {
+                LOG_ERROR("Failed, %s.", d3d11_utility::dxgi_error_to_string(result));
+                return false;
+            }
+        }
+
 		return true;
 	}
 
@@ -510,6 +560,19 @@ namespace Spartan
             }
         }
 
+        // A view of all the slices, the vertex shader picks one
+        if (array_size > 1 && array_size < state_max_render_target_count)
+        {
+            view_desc.Texture2DArray.FirstArraySlice    = 0;
+            view_desc.Texture2DArray.ArraySize          = array_size;
+            const auto result = rhi_device->GetContextRhi()->device->CreateRenderTargetView(static_cast<ID3D11Resource*>(texture), &view_desc, reinterpret_cast<ID3D11RenderTargetView**>(&views[array_size]));
+            if (FAILED(result))
+            {
+                LOG_ERROR("Failed, %s.", d3d11_utility::dxgi_error_to_string(result));
+                return false;
+            }
+        }
+
 		return true;
 	}
 
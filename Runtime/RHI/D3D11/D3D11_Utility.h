@@ -263,11 +263,16 @@ namespace Spartan::d3d11_utility
 			UINT d3d11_flags = 0;
 
 			d3d11_flags |= flags & RHI_SwapChain_Allow_Mode_Switch	? DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH    : 0;
-			d3d11_flags |= flags & RHI_Present_Immediate            ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING        : 0;
+			d3d11_flags |= CheckTearingSupport()                    ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING        : 0; // whenever supported, so that the present mode can change without re-creating the swapchain
 
 			return d3d11_flags;
 		}
 
+        inline bool is_flip_model(const DXGI_SWAP_EFFECT swap_effect)
+        {
+            return swap_effect == DXGI_SWAP_EFFECT_FLIP_DISCARD || swap_effect == DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+        }
+
 		inline DXGI_SWAP_EFFECT get_swap_effect(uint32_t flags)
 		{
 			#if !defined(_WIN32_WINNT_WIN10)
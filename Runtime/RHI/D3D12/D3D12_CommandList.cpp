@@ -52,33 +52,153 @@ namespace Spartan
 {
 	RHI_CommandList::RHI_CommandList(uint32_t index, RHI_SwapChain* swap_chain, Context* context)
 	{
-
+        m_swap_chain        = swap_chain;
+        m_renderer          = context->GetSubsystem<Renderer>();
+        m_profiler          = context->GetSubsystem<Profiler>();
+        m_rhi_device        = m_renderer->GetRhiDevice().get();
+        m_pipeline_cache    = m_renderer->GetPipelineCache();
+        m_descriptor_cache  = m_renderer->GetDescriptorCache();
+
+        ID3D12Device* device = m_rhi_device->GetContextRhi()->device;
+
+        // Command allocator, every command list has its own so that recording a frame never resets memory which an earlier frame still executes
+        if (!d3d12_utility::error::check(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(reinterpret_cast<ID3D12CommandAllocator**>(&m_cmd_allocator)))))
+        {
+            LOG_ERROR("Failed to create command allocator");
+            return;
+        }
+
+        // Command buffer, it's created in the recording state and it's closed until Begin()
+        if (!d3d12_utility::error::check(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, static_cast<ID3D12CommandAllocator*>(m_cmd_allocator), nullptr, IID_PPV_ARGS(reinterpret_cast<ID3D12GraphicsCommandList**>(&m_cmd_buffer)))))
+        {
+            LOG_ERROR("Failed to create command list");
+            return;
+        }
+        static_cast<ID3D12GraphicsCommandList*>(m_cmd_buffer)->Close();
+
+        // Descriptor heap segments
+        d3d12_utility::descriptor_heap::segment_acquire(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_descriptor_segments[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]);
+        d3d12_utility::descriptor_heap::segment_acquire(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, m_descriptor_segments[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER]);
 	}
 
-	RHI_CommandList::~RHI_CommandList() = default;
+	RHI_CommandList::~RHI_CommandList()
+    {
+        // Wait in case the buffer is still in use by the graphics queue
+        m_rhi_device->Queue_Wait(RHI_Queue_Graphics);
+
+        d3d12_utility::descriptor_heap::segment_release(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_descriptor_segments[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]);
+        d3d12_utility::descriptor_heap::segment_release(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, m_descriptor_segments[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER]);
+
+        d3d12_utility::release(*reinterpret_cast<ID3D12GraphicsCommandList**>(&m_cmd_buffer));
+        d3d12_utility::release(*reinterpret_cast<ID3D12CommandAllocator**>(&m_cmd_allocator));
+    }
 
     bool RHI_CommandList::Begin()
     {
+        // Sync CPU to GPU
+        if (!Wait())
+        {
+            LOG_ERROR("Failed to wait");
+            return false;
+        }
+
+        if (m_cmd_state != RHI_Cmd_List_Idle)
+        {
+            LOG_ERROR("The command list is still being used");
+            return false;
+        }
+
+        // The GPU is done with the previous recording, so its memory can be reused
+        ID3D12CommandAllocator* cmd_allocator   = static_cast<ID3D12CommandAllocator*>(m_cmd_allocator);
+        ID3D12GraphicsCommandList* cmd_list     = static_cast<ID3D12GraphicsCommandList*>(m_cmd_buffer);
+        if (!d3d12_utility::error::check(cmd_allocator->Reset()))
+            return false;
+
+        if (!d3d12_utility::error::check(cmd_list->Reset(cmd_allocator, nullptr)))
+            return false;
+
+        // The shader visible heaps are bound once, descriptor tables point into this command list's segments of them
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+        ID3D12DescriptorHeap* heaps[] =
+        {
+            rhi_context->descriptor_heaps_gpu[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV].heap,
+            rhi_context->descriptor_heaps_gpu[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER].heap
+        };
+        cmd_list->SetDescriptorHeaps(2, heaps);
+        m_descriptor_segments_used.fill(0);
+
+        m_cmd_state = RHI_Cmd_List_Recording;
+        m_flushed   = false;
         return true;
     }
 
     bool RHI_CommandList::Stop()
     {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("The command list is not recording, no need to stop it");
+            return true;
+        }
+
+        if (!d3d12_utility::error::check(static_cast<ID3D12GraphicsCommandList*>(m_cmd_buffer)->Close()))
+            return false;
+
+        m_cmd_state = RHI_Cmd_List_Submittable;
         return true;
     }
 
     bool RHI_CommandList::Submit()
     {
+        // Ensure the command list has recorded
+        if (m_cmd_state == RHI_Cmd_List_Idle)
+        {
+            LOG_WARNING("The command list is idle, nothing to submit");
+            return false;
+        }
+
+        // Ensure the command list is not recording
+        if (m_cmd_state == RHI_Cmd_List_Recording)
+        {
+            if (!Stop())
+            {
+                LOG_ERROR("Failed to stop recording");
+                return false;
+            }
+        }
+
+        if (!m_rhi_device->Queue_Submit(RHI_Queue_Graphics, m_cmd_buffer, nullptr, nullptr, nullptr, 0, &m_timeline_value))
+            return false;
+
+        m_cmd_state = RHI_Cmd_List_Pending;
         return true;
     }
 
     bool RHI_CommandList::Wait()
     {
+        if (m_cmd_state == RHI_Cmd_List_Pending)
+        {
+            if (!m_rhi_device->Queue_WaitValue(RHI_Queue_Graphics, m_timeline_value))
+                return false;
+
+            m_descriptor_cache->ResetIfNeeded();
+            m_cmd_state = RHI_Cmd_List_Idle;
+        }
+
         return true;
     }
 
     bool RHI_CommandList::Reset()
     {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+            return true;
+
+        lock_guard<mutex> guard(m_mutex_reset);
+
+        // Closing discards nothing that matters, the allocator and the list are reset by the next Begin()
+        if (!d3d12_utility::error::check(static_cast<ID3D12GraphicsCommandList*>(m_cmd_buffer)->Close()))
+            return false;
+
+        m_cmd_state = RHI_Cmd_List_Idle;
         return true;
     }
 
@@ -103,7 +223,7 @@ namespace Spartan
         return true;
 	}
 
-    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset)
+    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count, const uint32_t instance_offset)
     {
         return true;
 	}
@@ -128,6 +248,11 @@ namespace Spartan
 		
 	}
 
+	void RHI_CommandList::SetBufferInstance(const RHI_VertexBuffer* buffer, const uint64_t offset /*= 0*/)
+    {
+		
+	}
+
 	void RHI_CommandList::SetBufferIndex(const RHI_IndexBuffer* buffer, const uint64_t offset /*= 0*/)
     {
 		
@@ -138,6 +263,11 @@ namespace Spartan
         return true;
     }
 
+    bool RHI_CommandList::SetPushConstants(const void* data, const uint32_t size)
+    {
+        return true;
+    }
+
     void RHI_CommandList::SetSampler(const uint32_t slot, RHI_Sampler* sampler) const
     {
         
@@ -148,21 +278,41 @@ namespace Spartan
         
 	}
 
-    bool RHI_CommandList::Timestamp_Start(void* query_disjoint /*= nullptr*/, void* query_start /*= nullptr*/)
+    void RHI_CommandList::SetLayouts(RHI_Texture* const* textures, const RHI_Image_Layout* layouts, const uint32_t count)
+    {
+
+    }
+
+    bool RHI_CommandList::Timestamp_Start(void* query_disjoint /*= nullptr*/, void* query_start /*= nullptr*/, uint32_t* index /*= nullptr*/)
     {
         return true;
     }
 
-    bool RHI_CommandList::Timestamp_End(void* query_disjoint /*= nullptr*/, void* query_end /*= nullptr*/)
+    bool RHI_CommandList::Timestamp_End(void* query_disjoint /*= nullptr*/, void* query_end /*= nullptr*/, uint32_t* index /*= nullptr*/)
     {
         return true;
     }
 
-    float RHI_CommandList::Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t pass_index)
+    float RHI_CommandList::Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t index_start, const uint32_t index_end)
     {
         return 0.0f;
     }
 
+    bool RHI_CommandList::PipelineStatistics_Start(uint32_t* index)
+    {
+        return false;
+    }
+
+    bool RHI_CommandList::PipelineStatistics_End(const uint32_t index)
+    {
+        return false;
+    }
+
+    bool RHI_CommandList::PipelineStatistics_Get(const uint32_t index, RHI_Pipeline_Statistics& statistics) const
+    {
+        return false;
+    }
+
     uint32_t RHI_CommandList::Gpu_GetMemory(RHI_Device* rhi_device)
     {
         return 0;
@@ -185,17 +335,17 @@ namespace Spartan
 
     bool RHI_CommandList::IsRecording() const
     {
-        return true;
+        return m_cmd_state == RHI_Cmd_List_Recording;
     }
 
     bool RHI_CommandList::IsPending() const
     {
-        return true;
+        return m_cmd_state == RHI_Cmd_List_Pending;
     }
 
     bool RHI_CommandList::IsIdle() const
     {
-        return true;
+        return m_cmd_state == RHI_Cmd_List_Idle;
     }
 
     void RHI_CommandList::Timeblock_Start(const RHI_PipelineState* pipeline_state)
@@ -208,6 +358,16 @@ namespace Spartan
 
     }
 
+    void RHI_CommandList::Scope_Begin(const char* name)
+    {
+
+    }
+
+    void RHI_CommandList::Scope_End()
+    {
+
+    }
+
     bool RHI_CommandList::Deferred_BeginRenderPass()
     {
         return true;
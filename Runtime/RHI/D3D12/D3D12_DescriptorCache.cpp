@@ -29,13 +29,18 @@ namespace Spartan
     RHI_DescriptorCache::~RHI_DescriptorCache()
     = default;
 
-    void RHI_DescriptorCache::SetDescriptorSetCapacity(uint32_t descriptor_set_capacity)
+    void* RHI_DescriptorCache::AllocateDescriptorSet(void* descriptor_set_layout)
     {
-
+        return nullptr;
     }
 
     bool RHI_DescriptorCache::CreateDescriptorPool(uint32_t descriptor_set_capacity)
     {
         return true;
     }
+
+    void RHI_DescriptorCache::ResetDescriptorPools()
+    {
+
+    }
 }
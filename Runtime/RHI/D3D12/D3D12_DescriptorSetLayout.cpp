@@ -35,7 +35,7 @@ namespace Spartan
 
     }
 
-    void* RHI_DescriptorSetLayout::CreateDescriptorSet(const size_t hash, const RHI_DescriptorCache* descriptor_cache)
+    void* RHI_DescriptorSetLayout::CreateDescriptorSet(const size_t hash, RHI_DescriptorCache* descriptor_cache)
     {
         return nullptr;
     }
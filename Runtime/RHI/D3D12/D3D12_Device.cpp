@@ -94,6 +94,50 @@ namespace Spartan
             return;
         }
 
+        // Queues
+        {
+            const D3D12_COMMAND_LIST_TYPE queue_types[] = { D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_TYPE_COPY, D3D12_COMMAND_LIST_TYPE_COMPUTE };
+            void** queues[] = { &m_rhi_context->queue_graphics, &m_rhi_context->queue_transfer, &m_rhi_context->queue_compute };
+
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                D3D12_COMMAND_QUEUE_DESC queue_desc = {};
+                queue_desc.Type                     = queue_types[i];
+                queue_desc.Flags                    = D3D12_COMMAND_QUEUE_FLAG_NONE;
+
+                if (!d3d12_utility::error::check(m_rhi_context->device->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(reinterpret_cast<ID3D12CommandQueue**>(queues[i])))))
+                {
+                    LOG_ERROR("Failed to create command queue");
+                    return;
+                }
+
+                if (!d3d12_utility::error::check(m_rhi_context->device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_rhi_context->queue_fences[i]))))
+                {
+                    LOG_ERROR("Failed to create queue fence");
+                    return;
+                }
+            }
+        }
+
+        // Descriptor heaps
+        {
+            for (uint32_t type = 0; type < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; type++)
+            {
+                if (!d3d12_utility::descriptor_heap::create(m_rhi_context->descriptor_heaps_cpu[type], static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(type), RHI_Context::descriptor_heap_cpu_capacity, false))
+                {
+                    LOG_ERROR("Failed to create descriptor heap");
+                    return;
+                }
+            }
+
+            if (!d3d12_utility::descriptor_heap::create(m_rhi_context->descriptor_heaps_gpu[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV], D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, RHI_Context::descriptor_heap_gpu_capacity, true) ||
+                !d3d12_utility::descriptor_heap::create(m_rhi_context->descriptor_heaps_gpu[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER], D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, RHI_Context::descriptor_heap_gpu_capacity_sampler, true))
+            {
+                LOG_ERROR("Failed to create shader visible descriptor heap");
+                return;
+            }
+        }
+
         // Log feature level
         if (Settings* settings = m_context->GetSubsystem<Settings>())
         {
@@ -105,16 +149,97 @@ namespace Spartan
 
 	RHI_Device::~RHI_Device()
 	{
+        Queue_WaitAll();
+
+        for (RHI_Context::descriptor_heap& heap : m_rhi_context->descriptor_heaps_gpu)
+        {
+            d3d12_utility::descriptor_heap::destroy(heap);
+        }
+
+        for (RHI_Context::descriptor_heap& heap : m_rhi_context->descriptor_heaps_cpu)
+        {
+            d3d12_utility::descriptor_heap::destroy(heap);
+        }
+
+        for (ID3D12Fence*& fence : m_rhi_context->queue_fences)
+        {
+            d3d12_utility::release(fence);
+        }
+
+        d3d12_utility::release(*reinterpret_cast<ID3D12CommandQueue**>(&m_rhi_context->queue_graphics));
+        d3d12_utility::release(*reinterpret_cast<ID3D12CommandQueue**>(&m_rhi_context->queue_transfer));
+        d3d12_utility::release(*reinterpret_cast<ID3D12CommandQueue**>(&m_rhi_context->queue_compute));
         d3d12_utility::release(m_rhi_context->device);
 	}
 
-    bool RHI_Device::Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore /*= nullptr*/, void* signal_semaphore /*= nullptr*/, void* wait_fence /*= nullptr*/, uint32_t wait_flags /*= 0*/) const
+    bool RHI_Device::Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore /*= nullptr*/, void* signal_semaphore /*= nullptr*/, void* wait_fence /*= nullptr*/, uint32_t wait_flags /*= 0*/, uint64_t* timeline_value /*= nullptr*/) const
     {
+        ID3D12CommandQueue* queue = static_cast<ID3D12CommandQueue*>(Queue_Get(type));
+        if (!queue)
+            return false;
+
+        // Work on a queue executes in submission order and presenting is ordered by the queue too, so there are no semaphores.
+        // The fence of the queue is its timeline, every submission which asks for a value signals the next one.
+        ID3D12CommandList* cmd_lists[] = { static_cast<ID3D12CommandList*>(cmd_buffer) };
+
+        lock_guard<mutex> lock(m_queue_mutex);
+        queue->ExecuteCommandLists(1, cmd_lists);
+
+        if (!timeline_value)
+            return true;
+
+        const uint64_t value = ++m_rhi_context->queue_fence_values[type];
+        if (!d3d12_utility::error::check(queue->Signal(m_rhi_context->queue_fences[type], value)))
+            return false;
+
+        *timeline_value = value;
         return true;
     }
 
     bool RHI_Device::Queue_Wait(const RHI_Queue_Type type) const
+    {
+        ID3D12CommandQueue* queue = static_cast<ID3D12CommandQueue*>(Queue_Get(type));
+        if (!queue)
+            return true;
+
+        uint64_t value = 0;
+        {
+            lock_guard<mutex> lock(m_queue_mutex);
+            value = ++m_rhi_context->queue_fence_values[type];
+            if (!d3d12_utility::error::check(queue->Signal(m_rhi_context->queue_fences[type], value)))
+                return false;
+        }
+
+        return Queue_WaitValue(type, value);
+    }
+
+    bool RHI_Device::Queue_WaitValue(const RHI_Queue_Type type, const uint64_t value) const
+    {
+        ID3D12Fence* fence = m_rhi_context->queue_fences[type];
+        if (!fence)
+            return false;
+
+        // A null event blocks until the fence reaches the value
+        return fence->GetCompletedValue() >= value || d3d12_utility::error::check(fence->SetEventOnCompletion(value, nullptr));
+    }
+
+    bool RHI_Device::Queue_HasTimeline() const
     {
         return true;
     }
+
+    void RHI_Device::Memory_Tick(const uint64_t frame)
+    {
+
+    }
+
+    bool RHI_Device::Memory_GetPoolStats(const RHI_Memory_Pool pool, RHI_Memory_Pool_Stats& stats) const
+    {
+        return false;
+    }
+
+    uint32_t RHI_Device::Memory_GetBudget() const
+    {
+        return 0;
+    }
 }
@@ -0,0 +1,117 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ========================
+#include "../RHI_Implementation.h"
+#include "../RHI_PipelineCache.h"
+#include "../RHI_Device.h"
+#include "../../Core/FileSystem.h"
+#include "../../IO/FileStream.h"
+//===================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    // A pipeline library references the serialized data it was created from, so the two live together
+    struct d3d12_pipeline_library
+    {
+        ID3D12PipelineLibrary* library = nullptr;
+        vector<std::byte> data;
+    };
+
+    bool RHI_PipelineCache::CreateResource()
+    {
+        ID3D12Device1* device = nullptr;
+        if (!d3d12_utility::error::check(m_rhi_device->GetContextRhi()->device->QueryInterface(IID_PPV_ARGS(&device))))
+            return false;
+
+        auto pipeline_library = new d3d12_pipeline_library();
+
+        // Load the data of the previous run, it's only usable by the same driver and device
+        if (FileSystem::IsFile(m_file_path))
+        {
+            auto file = make_unique<FileStream>(m_file_path, FileStream_Read);
+            if (file->IsOpen())
+            {
+                file->Read(&pipeline_library->data);
+            }
+        }
+
+        HRESULT result = device->CreatePipelineLibrary(pipeline_library->data.data(), pipeline_library->data.size(), IID_PPV_ARGS(&pipeline_library->library));
+
+        // The driver or device changed (or the data is corrupt), start from an empty library
+        if (result == D3D12_ERROR_DRIVER_VERSION_MISMATCH || result == D3D12_ERROR_ADAPTER_NOT_FOUND || result == E_INVALIDARG)
+        {
+            LOG_INFO("The pipeline cache \"%s\" belongs to a different driver or device, it will be rebuilt", m_file_path.c_str());
+            pipeline_library->data.clear();
+            result = device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&pipeline_library->library));
+        }
+
+        d3d12_utility::release(device);
+
+        if (!d3d12_utility::error::check(result))
+        {
+            delete pipeline_library;
+            return false;
+        }
+
+        m_resource = static_cast<void*>(pipeline_library);
+        return true;
+    }
+
+    void RHI_PipelineCache::SaveResource()
+    {
+        if (!m_resource || m_file_path.empty())
+            return;
+
+        ID3D12PipelineLibrary* library = static_cast<d3d12_pipeline_library*>(m_resource)->library;
+
+        // Get the data
+        vector<std::byte> data(library->GetSerializedSize());
+        if (data.empty() || !d3d12_utility::error::check(library->Serialize(data.data(), data.size())))
+            return;
+
+        // Write it
+        auto file = make_unique<FileStream>(m_file_path, FileStream_Write);
+        if (!file->IsOpen())
+        {
+            LOG_ERROR("Failed to save the pipeline cache to \"%s\"", m_file_path.c_str());
+            return;
+        }
+
+        file->Write(data);
+    }
+
+    void RHI_PipelineCache::DestroyResource()
+    {
+        if (!m_resource)
+            return;
+
+        auto pipeline_library = static_cast<d3d12_pipeline_library*>(m_resource);
+        d3d12_utility::release(pipeline_library->library);
+        delete pipeline_library;
+        m_resource = nullptr;
+    }
+}
@@ -41,8 +41,18 @@ namespace Spartan
 		
 	}
 
-	void* RHI_Shader::_Compile(const string& shader)
+	bool RHI_Shader::_Compile(const string& shader, vector<std::byte>& bytecode)
 	{
-        return nullptr;
+        return false;
 	}
+
+    void* RHI_Shader::_CreateResource(const vector<std::byte>& bytecode)
+    {
+        return nullptr;
+    }
+
+    uint32_t RHI_Shader::_GetCompilerVersion() const
+    {
+        return 0;
+    }
 }
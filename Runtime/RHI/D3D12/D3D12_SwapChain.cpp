@@ -68,4 +68,10 @@ namespace Spartan
     {
 		return true;
 	}
+
+    bool RHI_SwapChain::SetPresentMode(const uint32_t flags)
+    {
+        m_flags = (m_flags & ~(rhi_present_mode_mask | RHI_SwapChain_Low_Latency)) | (flags & (rhi_present_mode_mask | RHI_SwapChain_Low_Latency));
+        return true;
+    }
 }
@@ -38,6 +38,11 @@ namespace Spartan
        
     }
 
+    void RHI_Texture2D::DestroyResourceGpu()
+    {
+
+    }
+
     void RHI_Texture::SetLayout(const RHI_Image_Layout new_layout, RHI_CommandList* command_list /*= nullptr*/)
     {
         
@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Device.h"
 #include "../../Core/EngineDefs.h"
 #include "../../Logging/Log.h"
+#include <mutex>
 //================================
 
 namespace Spartan::d3d12_utility
@@ -92,4 +93,115 @@ namespace Spartan::d3d12_utility
             ptr = nullptr;
         }
     }
+
+    namespace descriptor_heap
+    {
+        inline bool create(RHI_Context::descriptor_heap& heap, const D3D12_DESCRIPTOR_HEAP_TYPE type, const uint32_t capacity, const bool shader_visible)
+        {
+            D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+            desc.Type                       = type;
+            desc.NumDescriptors             = capacity;
+            desc.Flags                      = shader_visible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+            if (!error::check(globals::rhi_context->device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap.heap))))
+                return false;
+
+            heap.cpu_start  = heap.heap->GetCPUDescriptorHandleForHeapStart();
+            heap.gpu_start  = shader_visible ? heap.heap->GetGPUDescriptorHandleForHeapStart() : D3D12_GPU_DESCRIPTOR_HANDLE{};
+            heap.increment  = globals::rhi_context->device->GetDescriptorHandleIncrementSize(type);
+            heap.capacity   = capacity;
+
+            // Free descriptors (or segments), in reverse so that the lowest ones are handed out first
+            const uint32_t count = shader_visible ? RHI_Context::descriptor_heap_gpu_segments : capacity;
+            heap.free.resize(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                heap.free[i] = count - 1 - i;
+            }
+
+            return true;
+        }
+
+        inline void destroy(RHI_Context::descriptor_heap& heap)
+        {
+            release(heap.heap);
+            heap.free.clear();
+            heap.capacity = 0;
+        }
+
+        // CPU heaps
+        inline bool allocate(const D3D12_DESCRIPTOR_HEAP_TYPE type, D3D12_CPU_DESCRIPTOR_HANDLE& handle)
+        {
+            RHI_Context::descriptor_heap& heap = globals::rhi_context->descriptor_heaps_cpu[type];
+            std::lock_guard<std::mutex> lock(heap.mutex);
+
+            if (heap.free.empty())
+            {
+                LOG_ERROR("Out of descriptors, consider increasing descriptor_heap_cpu_capacity");
+                return false;
+            }
+
+            handle.ptr = heap.cpu_start.ptr + static_cast<SIZE_T>(heap.free.back()) * heap.increment;
+            heap.free.pop_back();
+            return true;
+        }
+
+        inline void free(const D3D12_DESCRIPTOR_HEAP_TYPE type, const D3D12_CPU_DESCRIPTOR_HANDLE handle)
+        {
+            RHI_Context::descriptor_heap& heap = globals::rhi_context->descriptor_heaps_cpu[type];
+            std::lock_guard<std::mutex> lock(heap.mutex);
+
+            heap.free.emplace_back(static_cast<uint32_t>((handle.ptr - heap.cpu_start.ptr) / heap.increment));
+        }
+
+        // Shader visible heaps
+        inline bool segment_acquire(const D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t& segment)
+        {
+            RHI_Context::descriptor_heap& heap = globals::rhi_context->descriptor_heaps_gpu[type];
+            std::lock_guard<std::mutex> lock(heap.mutex);
+
+            if (heap.free.empty())
+            {
+                LOG_ERROR("Out of descriptor heap segments, consider increasing descriptor_heap_gpu_segments");
+                return false;
+            }
+
+            segment = heap.free.back();
+            heap.free.pop_back();
+            return true;
+        }
+
+        inline void segment_release(const D3D12_DESCRIPTOR_HEAP_TYPE type, const uint32_t segment)
+        {
+            RHI_Context::descriptor_heap& heap = globals::rhi_context->descriptor_heaps_gpu[type];
+            std::lock_guard<std::mutex> lock(heap.mutex);
+
+            heap.free.emplace_back(segment);
+        }
+
+        // Copies CPU descriptors into the next free range of a segment and returns the table to bind, the segment is reset once its command list has executed
+        inline bool copy_to_segment(const D3D12_DESCRIPTOR_HEAP_TYPE type, const uint32_t segment, uint32_t& used, const D3D12_CPU_DESCRIPTOR_HANDLE* descriptors, const uint32_t count, D3D12_GPU_DESCRIPTOR_HANDLE& table)
+        {
+            RHI_Context::descriptor_heap& heap  = globals::rhi_context->descriptor_heaps_gpu[type];
+            const uint32_t segment_size         = heap.capacity / RHI_Context::descriptor_heap_gpu_segments;
+
+            if (used + count > segment_size)
+            {
+                LOG_ERROR("The command list ran out of descriptors, consider increasing the capacity of the shader visible heaps");
+                return false;
+            }
+
+            const SIZE_T offset = static_cast<SIZE_T>(segment * segment_size + used) * heap.increment;
+            D3D12_CPU_DESCRIPTOR_HANDLE destination = { heap.cpu_start.ptr + offset };
+            for (uint32_t i = 0; i < count; i++)
+            {
+                globals::rhi_context->device->CopyDescriptorsSimple(1, destination, descriptors[i], type);
+                destination.ptr += heap.increment;
+            }
+
+            table.ptr   = heap.gpu_start.ptr + offset;
+            used        += count;
+            return true;
+        }
+    }
 }
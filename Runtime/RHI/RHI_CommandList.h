@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ======================
 #include <array>
+#include <vector>
 #include <atomic>
 #include "RHI_Definition.h"
 #include "../Core/Spartan_Object.h"
@@ -99,7 +100,7 @@ namespace Spartan
 
 		// Draw/Dispatch
         bool Draw(uint32_t vertex_count);
-		bool DrawIndexed(uint32_t index_count, uint32_t index_offset = 0, uint32_t vertex_offset = 0);
+		bool DrawIndexed(uint32_t index_count, uint32_t index_offset = 0, uint32_t vertex_offset = 0, uint32_t instance_count = 1, uint32_t instance_offset = 0);
         void Dispatch(uint32_t x, uint32_t y, uint32_t z = 1) const;
 
 		// Viewport
@@ -111,6 +112,9 @@ namespace Spartan
 		// Vertex buffer
 		void SetBufferVertex(const RHI_VertexBuffer* buffer, const uint64_t offset = 0);
 
+		// Instance buffer, per-instance vertex data which instanced vertex shaders read from a second binding
+		void SetBufferInstance(const RHI_VertexBuffer* buffer, const uint64_t offset = 0);
+
 		// Index buffer
 		void SetBufferIndex(const RHI_IndexBuffer* buffer, const uint64_t offset = 0);
 
@@ -118,6 +122,10 @@ namespace Spartan
         bool SetConstantBuffer(const uint32_t slot, const uint8_t scope, RHI_ConstantBuffer* constant_buffer) const;
         inline bool SetConstantBuffer(const uint32_t slot, const uint8_t scope, const std::shared_ptr<RHI_ConstantBuffer>& constant_buffer) const { return SetConstantBuffer(slot, scope, constant_buffer.get()); }
 
+        // Push constants, small per-draw data which is recorded into the command list, so setting it touches no descriptor.
+        // Vulkan pushes it, D3D11 updates a constant buffer of its own (in slot rhi_push_constant_slot).
+        bool SetPushConstants(const void* data, const uint32_t size);
+
 		// Sampler
         void SetSampler(const uint32_t slot, RHI_Sampler* sampler) const;
         inline void SetSampler(const uint32_t slot, const std::shared_ptr<RHI_Sampler>& sampler) const { SetSampler(slot, sampler.get()); }
@@ -125,11 +133,23 @@ namespace Spartan
 		// Texture
         void SetTexture(const uint32_t slot, RHI_Texture* texture, const uint8_t scope = RHI_Shader_Pixel);
         inline void SetTexture(const uint32_t slot, const std::shared_ptr<RHI_Texture>& texture, const uint8_t scope = RHI_Shader_Pixel) { SetTexture(slot, texture.get(), scope); }
+
+        // Transitions textures to the given layouts with a single barrier (textures which are already there are skipped), can't be done in a render pass
+        void SetLayouts(RHI_Texture* const* textures, const RHI_Image_Layout* layouts, const uint32_t count);
         
-        // Timestamps
-        bool Timestamp_Start(void* query_disjoint = nullptr, void* query_start = nullptr);
-        bool Timestamp_End(void* query_disjoint = nullptr, void* query_end = nullptr);
-        float Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t pass_index);
+        // Timestamps, the index (where the API has one) is what Timestamp_GetDuration() needs to find the timestamp again
+        bool Timestamp_Start(void* query_disjoint = nullptr, void* query_start = nullptr, uint32_t* index = nullptr);
+        bool Timestamp_End(void* query_disjoint = nullptr, void* query_end = nullptr, uint32_t* index = nullptr);
+        float Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t index_start, const uint32_t index_end);
+
+        // Pipeline statistics, they can't be nested and can't begin and end on different sides of a render pass
+        bool PipelineStatistics_Start(uint32_t* index);
+        bool PipelineStatistics_End(const uint32_t index);
+        bool PipelineStatistics_Get(const uint32_t index, RHI_Pipeline_Statistics& statistics) const;
+
+        // Nested CPU and GPU time blocks (and a debug marker), for a group of passes
+        void Scope_Begin(const char* name);
+        void Scope_End();
 
         static uint32_t Gpu_GetMemory(RHI_Device* rhi_device);
         static uint32_t Gpu_GetMemoryUsed(RHI_Device* rhi_device);
@@ -142,11 +162,13 @@ namespace Spartan
         bool IsPending() const;
         bool IsIdle() const;
         void*& GetProcessedSemaphore() { return m_processed_semaphore; }
+        uint64_t GetTimelineValue() const { return m_timeline_value; } // the value the graphics queue timeline reaches once the last submission has executed
 
 	private:
         void Timeblock_Start(const RHI_PipelineState* pipeline_state);
         void Timeblock_End(const RHI_PipelineState* pipeline_state);
         bool Deferred_BeginRenderPass();
+        bool Deferred_BeginRendering(); // Vulkan, dynamic rendering, the attachments are given directly
         bool Deferred_BindPipeline();
         bool Deferred_BindDescriptorSet();
         bool OnDraw();
@@ -164,20 +186,49 @@ namespace Spartan
         void* m_processed_fence                     = nullptr;
         void* m_processed_semaphore                 = nullptr;
         void* m_query_pool                          = nullptr;
+        void* m_push_constant_buffer                = nullptr; // D3D11
+        uint64_t m_timeline_value                   = 0;
         bool m_render_pass_active                   = false;
+        bool m_render_pass_dynamic                  = false; // Vulkan, the active render pass began with dynamic rendering
         bool m_pipeline_active                      = false;
         bool m_flushed                              = false;
         static bool memory_query_support;
         std::mutex m_mutex_reset;
 
-        // Profiling
-        uint32_t m_timestamp_index = 0;
-        static const uint32_t m_max_timestamps = 256;
-        std::array<uint64_t, m_max_timestamps> m_timestamps;
+        // D3D12, the allocator which backs the command buffer (it can only be reset once the GPU is done with it)
+        // and the segments of the shader visible descriptor heaps which the command list copies its descriptors into
+        void* m_cmd_allocator                               = nullptr;
+        std::array<uint32_t, 2> m_descriptor_segments       = {};
+        std::array<uint32_t, 2> m_descriptor_segments_used  = {};
+
+        // Profiling, the query pools double in size (once the GPU is done with them) when a frame needs more queries than they have
+        uint32_t m_timestamp_index                  = 0;
+        uint32_t m_timestamp_capacity               = 256;
+        bool m_timestamp_overflow                   = false;
+        std::vector<uint64_t> m_timestamps;
+        void* m_query_pool_statistics               = nullptr;
+        uint32_t m_statistics_index                 = 0;
+        uint32_t m_statistics_capacity              = 64;
+        bool m_statistics_overflow                  = false;
+        bool m_statistics_active                    = false;
+        std::vector<uint64_t> m_statistics;         // the values of a query are contiguous, see RHI_Pipeline_Statistics
+
+        // Upper limit of textures which SetLayouts() transitions with a single barrier
+        static const uint32_t m_max_batched_transitions = 32;
+
+        // Transitions of the textures which SetTexture() binds, they are flushed with a single barrier before the render pass begins.
+        // The tracked layout of a texture changes right away (so that descriptors get it), the old one is kept for the barrier.
+        void FlushTransitions();
+        std::array<RHI_Texture*, m_max_batched_transitions> m_transitions_pending_textures;
+        std::array<RHI_Image_Layout, m_max_batched_transitions> m_transitions_pending_layouts_old;
+        std::array<RHI_Image_Layout, m_max_batched_transitions> m_transitions_pending_layouts_new;
+        uint32_t m_transitions_pending_count = 0;
 
         // Variables to minimise state changes
         uint32_t m_vertex_buffer_id     = 0;
         uint64_t m_vertex_buffer_offset = 0;
+        uint32_t m_instance_buffer_id   = 0;
+        uint64_t m_instance_buffer_offset = 0;
         uint32_t m_index_buffer_id      = 0;
         uint64_t m_index_buffer_offset  = 0;
 	};
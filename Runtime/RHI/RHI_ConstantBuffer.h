@@ -44,6 +44,64 @@ namespace Spartan
             return _create();
 		}
 
+        // Ring allocation, for dynamic buffers which get sub-allocated per draw. Every frame in flight owns a region of
+        // offset_count offsets and only sub-allocates from it, so a frame never overwrites offsets the GPU may still be
+        // reading for an earlier frame (the frame's command list fence guarantees that once it starts recording again).
+        template<typename T>
+        bool CreateRing(const uint32_t offset_count, const uint32_t frame_count)
+        {
+            m_ring_frame_count  = frame_count;
+            m_ring_offset_count = m_is_dynamic ? offset_count : 1;
+            m_ring_first        = 0;
+            m_ring_used         = 0;
+
+            return Create<T>(m_ring_offset_count * (m_is_dynamic ? m_ring_frame_count : 1));
+        }
+
+        // Rewinds to the start of the frame's region, the ring grows first if the previous frame ran out of offsets
+        bool BeginFrame(const uint32_t frame_index)
+        {
+            if (m_ring_overflowed)
+            {
+                m_ring_overflowed   = false;
+                m_ring_offset_count *= 2;
+                m_offset_count      = m_ring_offset_count * m_ring_frame_count;
+
+                if (!_create())
+                    return false;
+            }
+
+            m_ring_first    = (frame_index % m_ring_frame_count) * m_ring_offset_count;
+            m_ring_used     = 0;
+
+            return true;
+        }
+
+        // Moves to the next offset of the frame's region, returns false if the region is full
+        bool Allocate()
+        {
+            // Without dynamic offsets there is a single offset, which the API renames whenever it's mapped
+            if (!m_is_dynamic)
+            {
+                m_ring_used = 1;
+                return true;
+            }
+
+            if (m_ring_used == m_ring_offset_count)
+            {
+                m_ring_overflowed = true;
+                return false;
+            }
+
+            m_offset_dynamic_index = m_ring_first + m_ring_used++;
+            return true;
+        }
+
+        // Hands out the frame's region from the start again, only valid once the GPU is done with it (e.g. after a flush)
+        void Rewind()                               { m_ring_used = 0; }
+        uint32_t GetAllocationCount()       const   { return m_ring_used; } // offsets handed out since the frame began
+        uint32_t GetRingOffsetCount()       const   { return m_ring_offset_count; }
+
 		void* Map();  
 		bool Unmap(const uint64_t offset = 0, const uint64_t size = 0);
 
@@ -73,6 +131,11 @@ namespace Spartan
         uint32_t m_offset_count         = 1;
         uint32_t m_offset_index         = 0;
         uint32_t m_offset_dynamic_index = 0;
+        uint32_t m_ring_frame_count     = 1;
+        uint32_t m_ring_offset_count    = 1;
+        uint32_t m_ring_first           = 0;
+        uint32_t m_ring_used            = 0;
+        bool m_ring_overflowed          = false;
 
 		// API
 		void* m_buffer      = nullptr;
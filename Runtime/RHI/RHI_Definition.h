@@ -56,6 +56,9 @@ namespace Spartan
 	struct RHI_Vertex_PosCol;
 	struct RHI_Vertex_PosUvCol;
 	struct RHI_Vertex_PosTexNorTan;
+	struct RHI_Vertex_PosTexNorTanCompact;
+	struct RHI_Vertex_PosTexNorTanSkin;
+	struct RHI_Vertex_Skin;
 
     enum RHI_PhysicalDevice_Type
     {
@@ -87,9 +90,14 @@ namespace Spartan
         RHI_Swap_Sequential             = 1 << 7,
         RHI_Swap_Flip_Sequential        = 1 << 8,
         RHI_Swap_Flip_Discard           = 1 << 9,
-        RHI_SwapChain_Allow_Mode_Switch = 1 << 10
+        RHI_SwapChain_Allow_Mode_Switch = 1 << 10,
+
+        // The CPU waits for the display to be ready for a new frame before recording one (least input latency)
+        RHI_SwapChain_Low_Latency       = 1 << 11
 	};
 
+    static const uint32_t rhi_present_mode_mask = RHI_Present_Immediate | RHI_Present_Mailbox | RHI_Present_Fifo | RHI_Present_FifoRelaxed | RHI_Present_SharedDemandRefresh | RHI_Present_SharedDContinuousRefresh;
+
     enum RHI_Queue_Type
     {
         RHI_Queue_Graphics,
@@ -194,10 +202,32 @@ namespace Spartan
         // DEPTH
         RHI_Format_D32_Float,
         RHI_Format_D32_Float_S8X24_Uint,
+        // BLOCK COMPRESSED (4x4 pixel blocks)
+        RHI_Format_BC4_Unorm,   // one channel (masks)
+        RHI_Format_BC5_Unorm,   // two channels (normals, z is reconstructed)
+        RHI_Format_BC6H_Uf16,   // HDR color
+        RHI_Format_BC7_Unorm,   // color and alpha
+        // RGBA (after the block compressed ones, so that the formats which were serialized before keep their values)
+        RHI_Format_R16G16B16A16_Unorm, // compact vertex positions
+        // R
+        RHI_Format_R8_Uint,            // shading rate images
 
         RHI_Format_Undefined
 	};
 
+    // The bytes of a 4x4 block, zero for formats which aren't block compressed
+    inline uint32_t rhi_format_block_size(const RHI_Format format)
+    {
+        switch (format)
+        {
+            case RHI_Format_BC4_Unorm:  return 8;
+            case RHI_Format_BC5_Unorm:  return 16;
+            case RHI_Format_BC6H_Uf16:  return 16;
+            case RHI_Format_BC7_Unorm:  return 16;
+            default:                    return 0;
+        }
+    }
+
 	enum RHI_Blend
 	{
 		RHI_Blend_Zero,
@@ -247,7 +277,39 @@ namespace Spartan
         RHI_Image_Depth_Stencil_Read_Only_Optimal,    
         RHI_Image_Shader_Read_Only_Optimal,
         RHI_Image_Transfer_Dst_Optimal,
-        RHI_Image_Present_Src
+        RHI_Image_Present_Src,
+        RHI_Image_Shading_Rate_Attachment_Optimal
+    };
+
+    // Resources are allocated from a pool which matches their usage, so that long lived and short lived allocations don't share memory blocks
+    enum RHI_Memory_Pool
+    {
+        RHI_Memory_Pool_RenderTarget,
+        RHI_Memory_Pool_Texture,
+        RHI_Memory_Pool_Geometry,
+        RHI_Memory_Pool_Staging,
+        RHI_Memory_Pool_Count
+    };
+
+    struct RHI_Memory_Pool_Stats
+    {
+        uint64_t size               = 0; // memory blocks allocated from the driver
+        uint64_t used               = 0; // memory used by allocations
+        uint64_t free_range_max     = 0; // largest contiguous free range, smaller than size - used when the pool is fragmented
+        uint32_t allocation_count   = 0;
+        uint32_t block_count        = 0;
+        uint32_t free_range_count   = 0;
+    };
+
+    // What the GPU did during a pass, tells whether it's vertex, pixel or compute bound
+    struct RHI_Pipeline_Statistics
+    {
+        uint64_t input_assembly_primitives  = 0;
+        uint64_t vertex_invocations         = 0;
+        uint64_t clipping_invocations       = 0; // primitives which reached the clipper
+        uint64_t clipping_primitives        = 0; // primitives which the clipper output
+        uint64_t pixel_invocations          = 0;
+        uint64_t compute_invocations        = 0;
     };
 
     struct RHI_Descriptor
@@ -295,6 +357,12 @@ namespace Spartan
             case RHI_Format_R32G32B32A32_Float:	    return "RHI_Format_R32G32B32A32_Float";
             case RHI_Format_D32_Float:	            return "RHI_Format_D32_Float";
             case RHI_Format_D32_Float_S8X24_Uint:	return "RHI_Format_D32_Float_S8X24_Uint";
+            case RHI_Format_BC4_Unorm:	            return "RHI_Format_BC4_Unorm";
+            case RHI_Format_BC5_Unorm:	            return "RHI_Format_BC5_Unorm";
+            case RHI_Format_BC6H_Uf16:	            return "RHI_Format_BC6H_Uf16";
+            case RHI_Format_BC7_Unorm:	            return "RHI_Format_BC7_Unorm";
+            case RHI_Format_R16G16B16A16_Unorm:	    return "RHI_Format_R16G16B16A16_Unorm";
+            case RHI_Format_R8_Uint:	            return "RHI_Format_R8_Uint";
             case RHI_Format_Undefined:              return "RHI_Format_Undefined";
         }
 
@@ -311,6 +379,11 @@ namespace Spartan
     static const uint8_t        state_max_render_target_count   = 8;
     static const uint8_t        state_max_constant_buffer_count = 8;
     static const uint32_t       state_dynamic_offset_empty      = (std::numeric_limits<uint32_t>::max)();
+    static const uint32_t       rhi_binding_instance            = 1; // vertex buffer binding of per-instance data
+    static const uint32_t       rhi_frames_in_flight_max        = 2; // how many frames the CPU can record ahead of the GPU (when queues have timelines)
+    static const uint32_t       rhi_max_skin_bones              = 64; // bones which a skinned draw can follow, must match the shader
+    static const uint32_t       rhi_max_push_constant_size      = 128; // bytes of per-draw data, the least Vulkan guarantees
+    static const uint32_t       rhi_push_constant_slot          = 9;  // the constant buffer which stands in for push constants where the API has none, must match the shader
 
     enum RHI_Shader_Type : uint8_t
 	{
@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Implementation.h"
 #include "RHI_DescriptorSetLayout.h"
 #include "..\Utilities\Hash.h"
+#include "..\Profiling\Profiler.h"
 //==================================
 
 //= NAMESPACES =====
@@ -41,8 +42,8 @@ namespace Spartan
     {
         m_rhi_device = rhi_device;
 
-        // Set the descriptor set capacity to an initial value
-        SetDescriptorSetCapacity(m_descriptor_set_capacity);
+        // Create the first descriptor pool
+        CreateDescriptorPool(m_descriptor_pool_capacity);
     }
 
     void RHI_DescriptorCache::SetPipelineState(RHI_PipelineState& pipeline_state)
@@ -80,6 +81,7 @@ namespace Spartan
        {
            // Generate descriptors from the reflected shaders
            vector<RHI_Descriptor> descriptors = GenerateDescriptors(pipeline_state);
+           Profiler::EventAdd("Descriptor set layout creation", pipeline_state.pass_name ? pipeline_state.pass_name : "");
 
            // Emplace a new descriptor set layout
            it = m_descriptor_set_layouts.emplace(make_pair(hash, make_shared<RHI_DescriptorSetLayout>(m_rhi_device, descriptors))).first;
@@ -145,34 +147,24 @@ namespace Spartan
         return m_descriptor_layout_current->GetResource_DescriptorSet(this, descriptor_set);
     }
 
-    bool RHI_DescriptorCache::HasEnoughCapacity() const
+    void RHI_DescriptorCache::ResetIfNeeded()
     {
-        return m_descriptor_set_capacity > GetDescriptorSetCount();
-    }
-
-    void RHI_DescriptorCache::GrowIfNeeded()
-    {
-        // If there is room for at least one more descriptor set (hence +1), we don't need to re-allocate yet
-        const uint32_t required_capacity = GetDescriptorSetCount() + 1;
+        // Sets are only released in bulk, this is mostly sets which reference resources that are long gone (e.g. render targets of a previous resolution)
+        if (m_descriptor_set_count <= RHI_Context::descriptor_set_count_max)
+            return;
 
-        // If we are over-budget, re-allocate the descriptor pool with double size
-        if (required_capacity > m_descriptor_set_capacity)
-        {
-            m_descriptor_set_capacity *= 2;
-            SetDescriptorSetCapacity(m_descriptor_set_capacity);
-            LOG_INFO("Capacity has been increased to %d elements", m_descriptor_set_capacity);
-        }
-    }
+        // Wait in case the descriptor sets are still in use
+        m_rhi_device->Queue_WaitAll();
 
-    uint32_t RHI_DescriptorCache::GetDescriptorSetCount() const
-    {
-        uint32_t descriptor_set_count = 0;
+        // Drop the cached descriptor sets
         for (const auto& it : m_descriptor_set_layouts)
         {
-            descriptor_set_count += it.second->GetDescriptorSetCount();
+            it.second->ClearDescriptorSets();
         }
 
-        return descriptor_set_count;
+        ResetDescriptorPools();
+        LOG_INFO("%d descriptor sets have been released", m_descriptor_set_count);
+        m_descriptor_set_count = 0;
     }
 
     vector<RHI_Descriptor> RHI_DescriptorCache::GenerateDescriptors(RHI_PipelineState& pipeline_state)
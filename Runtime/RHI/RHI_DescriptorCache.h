@@ -46,27 +46,31 @@ namespace Spartan
         void SetTexture(const uint32_t slot, RHI_Texture* texture);
 
         // Properties
-        void* GetResource_DescriptorSetPool() const { return m_descriptor_pool; }
         void* GetResource_DescriptorSetLayout() const;
         bool GetResource_DescriptorSet(void*& descriptor_set);
 
-        // Capacity
-        bool HasEnoughCapacity() const;
-        void GrowIfNeeded();
+        // Descriptor sets are allocated once and then reused for as long as their resources are bound.
+        // A full pool is followed by a bigger one, so allocating never has to wait for the GPU or invalidate existing sets.
+        void* AllocateDescriptorSet(void* descriptor_set_layout);
+
+        // Once more sets than RHI_Context::descriptor_set_count_max are cached, they are all dropped and the pools are reset in bulk.
+        // Meant to be called between frames, as it waits for the GPU.
+        void ResetIfNeeded();
 
     private:
-        uint32_t GetDescriptorSetCount() const;
-        void SetDescriptorSetCapacity(uint32_t descriptor_capacity);
         bool CreateDescriptorPool(uint32_t descriptor_set_capacity);
+        void ResetDescriptorPools();
         std::vector<RHI_Descriptor> GenerateDescriptors(RHI_PipelineState& pipeline_state);
 
         // Descriptor set layouts 
         std::unordered_map<std::size_t, std::shared_ptr<RHI_DescriptorSetLayout>> m_descriptor_set_layouts;
         RHI_DescriptorSetLayout* m_descriptor_layout_current = nullptr;
 
-        // Descriptor pool
-        uint32_t m_descriptor_set_capacity = 16;
-        void* m_descriptor_pool = nullptr;
+        // Descriptor pools, sets are allocated from the last one
+        std::vector<void*> m_descriptor_pools;
+        uint32_t m_descriptor_pool_capacity     = 16;   // sets the last pool can hold
+        uint32_t m_descriptor_pool_allocated    = 0;    // sets allocated from the last pool
+        uint32_t m_descriptor_set_count         = 0;    // sets allocated from all pools
 
         // Dependencies
         const RHI_Device* m_rhi_device;
@@ -133,15 +133,11 @@ namespace Spartan
         auto it = m_descriptor_sets.find(hash);
         if (it == m_descriptor_sets.end())
         {
-            // Only allocate if the descriptor set cache hash enough capacity
-            if (descriptor_cache->HasEnoughCapacity())
-            {
-                descriptor_set = CreateDescriptorSet(hash, descriptor_cache);
-            }
-            else
-            {
+            descriptor_set = CreateDescriptorSet(hash, descriptor_cache);
+            if (!descriptor_set)
                 return false;
-            }
+
+            m_needs_to_bind = false;
         }
         else // retrieve the existing one
         {
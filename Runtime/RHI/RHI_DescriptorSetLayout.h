@@ -48,10 +48,11 @@ namespace Spartan
         void* GetResource_DescriptorSetLayout() const { return m_descriptor_set_layout; }      
         uint32_t GetDescriptorSetCount()        const { return static_cast<uint32_t>(m_descriptor_sets.size()); }
         void NeedsToBind()                            { m_needs_to_bind = true; }
+        void ClearDescriptorSets()                    { m_descriptor_sets.clear(); m_needs_to_bind = true; }
 
     private:
         std::size_t ComputeDescriptorSetHash(const std::vector<RHI_Descriptor>& descriptors);
-        void* CreateDescriptorSet(const std::size_t hash, const RHI_DescriptorCache* descriptor_cache);
+        void* CreateDescriptorSet(const std::size_t hash, RHI_DescriptorCache* descriptor_cache);
         void UpdateDescriptorSet(void* descriptor_set, const std::vector<RHI_Descriptor>& descriptors);
         void* CreateDescriptorSetLayout(const std::vector<RHI_Descriptor>& descriptors);
 
@@ -116,9 +116,60 @@ namespace Spartan
 
 	bool RHI_Device::Queue_WaitAll() const
     {
-        return Queue_Wait(RHI_Queue_Graphics) && Queue_Wait(RHI_Queue_Transfer) && Queue_Wait(RHI_Queue_Compute);
+        if (!(Queue_Wait(RHI_Queue_Graphics) && Queue_Wait(RHI_Queue_Transfer) && Queue_Wait(RHI_Queue_Compute)))
+            return false;
+
+        // Nothing is in flight anymore
+        DeletionQueue_Release(true);
+        return true;
 	}
 
+    void RHI_Device::DeletionQueue_Add(function<void()>&& release)
+    {
+        if (!release)
+            return;
+
+        // Without a device there are no frames in flight (e.g. during shutdown)
+        if (!m_initialized)
+        {
+            release();
+            return;
+        }
+
+        lock_guard<mutex> lock(m_deletion_queue_mutex);
+        m_deletion_queue.push_back({ m_deletion_queue_frame, move(release) });
+    }
+
+    void RHI_Device::DeletionQueue_Tick(const uint64_t frame)
+    {
+        {
+            lock_guard<mutex> lock(m_deletion_queue_mutex);
+            m_deletion_queue_frame = frame;
+        }
+
+        DeletionQueue_Release(false);
+    }
+
+    void RHI_Device::DeletionQueue_Release(const bool all) const
+    {
+        // Released outside of the lock, releasing can destroy objects which queue deletions of their own
+        vector<DeletionQueueEntry> retired;
+        {
+            lock_guard<mutex> lock(m_deletion_queue_mutex);
+            auto it = all ? m_deletion_queue.end() : stable_partition(m_deletion_queue.begin(), m_deletion_queue.end(), [this](const DeletionQueueEntry& entry)
+            {
+                return entry.frame + deletion_queue_latency <= m_deletion_queue_frame;
+            });
+            retired.insert(retired.end(), make_move_iterator(m_deletion_queue.begin()), make_move_iterator(it));
+            m_deletion_queue.erase(m_deletion_queue.begin(), it);
+        }
+
+        for (DeletionQueueEntry& entry : retired)
+        {
+            entry.release();
+        }
+    }
+
     void* RHI_Device::Queue_Get(const RHI_Queue_Type type) const
     {
         if (type == RHI_Queue_Graphics)
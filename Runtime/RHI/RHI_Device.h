@@ -25,6 +25,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Core/Spartan_Object.h"
 #include <mutex>
 #include <memory>
+#include <vector>
+#include <functional>
 #include "RHI_DisplayMode.h"
 #include "RHI_PhysicalDevice.h"
 //=================================
@@ -52,17 +54,38 @@ namespace Spartan
 
         // Queue
         bool Queue_Present(void* swapchain_view, uint32_t* image_index, void* wait_semaphore = nullptr) const;
-        bool Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore = nullptr, void* signal_semaphore = nullptr, void* signal_fence = nullptr, const uint32_t wait_flags = 0) const;
+        // When timeline_value is set, the submission also signals the timeline of the queue and the signalled value is returned (if timelines are supported)
+        bool Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore = nullptr, void* signal_semaphore = nullptr, void* signal_fence = nullptr, const uint32_t wait_flags = 0, uint64_t* timeline_value = nullptr) const;
         bool Queue_Wait(const RHI_Queue_Type type) const;
+        bool Queue_WaitValue(const RHI_Queue_Type type, const uint64_t value) const; // blocks until the timeline of the queue reaches the value
+        bool Queue_HasTimeline() const;
         bool Queue_WaitAll() const;
         void* Queue_Get(const RHI_Queue_Type type) const;
         uint32_t Queue_Index(const RHI_Queue_Type type) const;
 
+        // Deletion queue, GPU objects which the frames in flight could still be using are released once those frames have retired,
+        // so that destroying a batch of resources doesn't wait for the GPU to go idle once per object
+        void DeletionQueue_Add(std::function<void()>&& release);
+        void DeletionQueue_Tick(const uint64_t frame); // the renderer calls this once per frame
+        static const uint64_t deletion_queue_latency = 4; // frames, one more than the swapchain buffers (which bound the frames in flight)
+
+        // Memory
+        void Memory_Tick(const uint64_t frame);
+        bool Memory_GetPoolStats(const RHI_Memory_Pool pool, RHI_Memory_Pool_Stats& stats) const;
+        uint32_t Memory_GetBudget() const; // MBs, what the driver lets the application use before it starts paging
+
         // Misc
 		auto IsInitialized()                const { return m_initialized; }
         RHI_Context* GetContextRhi()	    const { return m_rhi_context.get(); }
         Context* GetContext()               const { return m_context; }
         uint32_t GetEnabledGraphicsStages() const { return m_enabled_graphics_shader_stages; }
+        bool IsLayeredRenderingSupported()  const { return m_layered_rendering; } // the vertex shader can pick the array slice it renders to
+        // A render pass can take a shading rate image, whose texels (of GetShadingRateTileSize() pixels along a side) pick 1x1 or coarser shading
+        bool IsVariableRateShadingSupported()   const { return m_variable_rate_shading; }
+        uint32_t GetShadingRateTileSize()       const { return m_shading_rate_tile_size; }
+        bool IsShaderFloat16Supported()         const { return m_shader_float16; } // shaders compiled with HALF_PRECISION do their arithmetic in 16 bits
+        bool IsDynamicRenderingSupported()      const { return m_dynamic_rendering; } // Vulkan, passes need no render pass or frame buffer objects
+        bool IsComputeSupported()               const { return m_compute; } // RHI_CommandList::Dispatch() is implemented by the backend
 
 	private:	
 		std::vector<PhysicalDevice> m_physical_devices;
@@ -71,7 +94,25 @@ namespace Spartan
         uint32_t m_physical_device_index            = 0;     
         uint32_t m_enabled_graphics_shader_stages   = 0;
         bool m_initialized                          = false;
+        bool m_memory_over_budget                   = false;
+        bool m_layered_rendering                    = false;
+        bool m_variable_rate_shading                = false;
+        uint32_t m_shading_rate_tile_size           = 0;
+        bool m_shader_float16                       = false;
+        bool m_dynamic_rendering                    = false;
+        bool m_compute                              = false;
         mutable std::mutex m_queue_mutex;
+
+        // Deletion queue
+        void DeletionQueue_Release(const bool all) const;
+        struct DeletionQueueEntry
+        {
+            uint64_t frame = 0;
+            std::function<void()> release;
+        };
+        mutable std::vector<DeletionQueueEntry> m_deletion_queue;
+        mutable std::mutex m_deletion_queue_mutex;
+        uint64_t m_deletion_queue_frame = 0;
         std::shared_ptr<RHI_Context> m_rhi_context;
 	};
 }
@@ -32,19 +32,86 @@ namespace Spartan
 #ifdef API_GRAPHICS_VULKAN
     bool RHI_Context::initalise_allocator()
     {
+        memory_budget = vulkan_utility::extension::is_present_device("VK_EXT_memory_budget", device_physical);
+
         VmaAllocatorCreateInfo allocator_info   = {};
         allocator_info.physicalDevice           = device_physical;
         allocator_info.device                   = device;
         allocator_info.instance                 = instance;
         allocator_info.vulkanApiVersion         = api_version;
+        allocator_info.flags                    = memory_budget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0;
         
-        return vulkan_utility::error::check(vmaCreateAllocator(&allocator_info, &allocator));
+        if (!vulkan_utility::error::check(vmaCreateAllocator(&allocator_info, &allocator)))
+            return false;
+
+        // Pools, the memory type of each one is picked with a representative resource of its usage
+        for (uint32_t i = 0; i < RHI_Memory_Pool_Count; i++)
+        {
+            const RHI_Memory_Pool pool = static_cast<RHI_Memory_Pool>(i);
+
+            VmaAllocationCreateInfo allocation_info = {};
+            allocation_info.usage                   = pool == RHI_Memory_Pool_Staging ? VMA_MEMORY_USAGE_CPU_ONLY : VMA_MEMORY_USAGE_GPU_ONLY;
+
+            uint32_t memory_type_index = 0;
+            VkResult result = VK_SUCCESS;
+            if (pool == RHI_Memory_Pool_RenderTarget || pool == RHI_Memory_Pool_Texture)
+            {
+                VkImageCreateInfo image_info    = {};
+                image_info.sType                = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                image_info.imageType            = VK_IMAGE_TYPE_2D;
+                image_info.extent               = { 1024, 1024, 1 };
+                image_info.mipLevels            = 1;
+                image_info.arrayLayers          = 1;
+                image_info.format               = VK_FORMAT_R8G8B8A8_UNORM;
+                image_info.tiling               = VK_IMAGE_TILING_OPTIMAL;
+                image_info.initialLayout        = VK_IMAGE_LAYOUT_UNDEFINED;
+                image_info.usage                = VK_IMAGE_USAGE_SAMPLED_BIT | (pool == RHI_Memory_Pool_RenderTarget ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT : VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+                image_info.samples              = VK_SAMPLE_COUNT_1_BIT;
+                image_info.sharingMode          = VK_SHARING_MODE_EXCLUSIVE;
+
+                result = vmaFindMemoryTypeIndexForImageInfo(allocator, &image_info, &allocation_info, &memory_type_index);
+            }
+            else
+            {
+                VkBufferCreateInfo buffer_info  = {};
+                buffer_info.sType               = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+                buffer_info.size                = 1024;
+                buffer_info.usage               = pool == RHI_Memory_Pool_Staging ? VK_BUFFER_USAGE_TRANSFER_SRC_BIT : (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+                buffer_info.sharingMode         = VK_SHARING_MODE_EXCLUSIVE;
+
+                result = vmaFindMemoryTypeIndexForBufferInfo(allocator, &buffer_info, &allocation_info, &memory_type_index);
+            }
+
+            // Without a pool, resources of that usage simply come from the default pools
+            if (result != VK_SUCCESS)
+            {
+                LOG_WARNING("Failed to find a memory type for memory pool %d", i);
+                continue;
+            }
+
+            VmaPoolCreateInfo pool_info = {};
+            pool_info.memoryTypeIndex   = memory_type_index;
+            pool_info.blockSize         = pool == RHI_Memory_Pool_Geometry ? 64 * 1024 * 1024 : 0; // zero picks the default (a fraction of the heap)
+
+            vulkan_utility::error::check(vmaCreatePool(allocator, &pool_info, &memory_pools[i]));
+        }
+
+        return true;
     }
 
     void RHI_Context::destroy_allocator()
     {
         if (allocator != nullptr)
         {
+            for (VmaPool& pool : memory_pools)
+            {
+                if (pool)
+                {
+                    vmaDestroyPool(allocator, pool);
+                    pool = nullptr;
+                }
+            }
+
             vmaDestroyAllocator(allocator);
             allocator = nullptr;
         }
@@ -80,6 +80,15 @@ static const DXGI_FORMAT d3d11_format[] =
     // Depth
     DXGI_FORMAT_D32_FLOAT,
     DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
+    // Block compressed
+    DXGI_FORMAT_BC4_UNORM,
+    DXGI_FORMAT_BC5_UNORM,
+    DXGI_FORMAT_BC6H_UF16,
+    DXGI_FORMAT_BC7_UNORM,
+    // RGBA
+    DXGI_FORMAT_R16G16B16A16_UNORM,
+    // R
+    DXGI_FORMAT_R8_UINT,
 
     DXGI_FORMAT_UNKNOWN
 };
@@ -156,6 +165,42 @@ static const D3D11_BLEND_OP d3d11_blend_operation[] =
 #include <dxgi1_3.h>
 #include <dxgi1_4.h>
 #pragma warning(pop)
+
+static const DXGI_FORMAT d3d12_format[] =
+{
+    // R
+	DXGI_FORMAT_R8_UNORM,
+	DXGI_FORMAT_R16_UINT,
+	DXGI_FORMAT_R16_FLOAT,
+	DXGI_FORMAT_R32_UINT,
+	DXGI_FORMAT_R32_FLOAT,
+    // RG
+	DXGI_FORMAT_R8G8_UNORM,
+	DXGI_FORMAT_R16G16_FLOAT,
+	DXGI_FORMAT_R32G32_FLOAT,
+    // RGB
+    DXGI_FORMAT_R11G11B10_FLOAT,
+	DXGI_FORMAT_R32G32B32_FLOAT,
+    // RGBA
+	DXGI_FORMAT_R8G8B8A8_UNORM,
+    DXGI_FORMAT_R10G10B10A2_UNORM,
+	DXGI_FORMAT_R16G16B16A16_FLOAT,
+	DXGI_FORMAT_R32G32B32A32_FLOAT,
+    // Depth
+    DXGI_FORMAT_D32_FLOAT,
+    DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
+    // Block compressed
+    DXGI_FORMAT_BC4_UNORM,
+    DXGI_FORMAT_BC5_UNORM,
+    DXGI_FORMAT_BC6H_UF16,
+    DXGI_FORMAT_BC7_UNORM,
+    // RGBA
+    DXGI_FORMAT_R16G16B16A16_UNORM,
+    // R
+    DXGI_FORMAT_R8_UINT,
+
+    DXGI_FORMAT_UNKNOWN
+};
 #endif
 
 // Definition - Vulkan
@@ -210,6 +255,15 @@ static const VkFormat vulkan_format[] =
     // DEPTH
     VK_FORMAT_D32_SFLOAT,
     VK_FORMAT_D32_SFLOAT_S8_UINT,
+    // BLOCK COMPRESSED
+    VK_FORMAT_BC4_UNORM_BLOCK,
+    VK_FORMAT_BC5_UNORM_BLOCK,
+    VK_FORMAT_BC6H_UFLOAT_BLOCK,
+    VK_FORMAT_BC7_UNORM_BLOCK,
+    // RGBA
+    VK_FORMAT_R16G16B16A16_UNORM,
+    // R
+    VK_FORMAT_R8_UINT,
 
     VK_FORMAT_MAX_ENUM
 };
@@ -308,7 +362,8 @@ static const VkImageLayout vulkan_image_layout[] =
     VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+    VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR
 };
 #endif
 
@@ -317,8 +372,15 @@ static const VkImageLayout vulkan_image_layout[] =
 #if defined (API_GRAPHICS_VULKAN)
     #include "Vulkan/vk_mem_alloc.h"
     #include <vector>
+    #include <array>
+    #include <mutex>
     #include <unordered_map>
 #endif
+#if defined (API_GRAPHICS_D3D12)
+    #include <vector>
+    #include <array>
+    #include <mutex>
+#endif
 
 // RHI_Context
 namespace Spartan
@@ -335,6 +397,29 @@ namespace Spartan
         #if defined(API_GRAPHICS_D3D12)
             RHI_Api_Type api_type   = RHI_Api_D3d12;
             ID3D12Device* device    = nullptr;
+
+            // Every queue has a fence, waiting for a queue signals the next value and blocks until the GPU reaches it
+            std::array<ID3D12Fence*, 3> queue_fences        = {};
+            std::array<uint64_t, 3> queue_fence_values      = {};
+
+            // CPU heaps hand out single descriptors from a free list, views live as long as the resource they belong to.
+            // Shader visible heaps are split into segments, every command list owns one and copies the descriptors of its draws into it linearly.
+            struct descriptor_heap
+            {
+                ID3D12DescriptorHeap* heap              = nullptr;
+                D3D12_CPU_DESCRIPTOR_HANDLE cpu_start   = {};
+                D3D12_GPU_DESCRIPTOR_HANDLE gpu_start   = {};
+                uint32_t increment                      = 0;
+                uint32_t capacity                       = 0;
+                std::vector<uint32_t> free;             // descriptors (CPU heaps) or segments (shader visible heaps)
+                std::mutex mutex;
+            };
+            std::array<descriptor_heap, D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES> descriptor_heaps_cpu;
+            std::array<descriptor_heap, 2> descriptor_heaps_gpu; // D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV and D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER
+            static const uint32_t descriptor_heap_cpu_capacity          = 4096;
+            static const uint32_t descriptor_heap_gpu_capacity          = 65536;
+            static const uint32_t descriptor_heap_gpu_capacity_sampler  = 2048; // the limit of shader visible sampler heaps
+            static const uint32_t descriptor_heap_gpu_segments          = 8;    // more than the command lists which can be in flight
         #endif
 
         #if defined(API_GRAPHICS_VULKAN)
@@ -348,8 +433,25 @@ namespace Spartan
             VkFormat surface_format                         = VK_FORMAT_UNDEFINED;
             VkColorSpaceKHR surface_color_space             = VK_COLOR_SPACE_MAX_ENUM_KHR;
             VmaAllocator allocator                          = nullptr;
+            std::array<VmaPool, RHI_Memory_Pool_Count> memory_pools = {};
+            bool memory_budget                              = false; // VK_EXT_memory_budget, the budget is reported by the driver instead of estimated
+
+            // Timeline semaphores (Vulkan 1.2), every queue has one and submissions which ask for it signal the next value
+            bool timeline_semaphores                        = false;
+            std::array<VkSemaphore, 3> queue_timelines      = {};
+            std::array<uint64_t, 3> queue_timeline_values   = {};
             std::unordered_map<uint64_t, VmaAllocation> allocations;
 
+            // Geometry buffers which defragmentation can move, a move re-creates the buffer and patches the owner's handle
+            struct allocation_movable
+            {
+                void** owner        = nullptr;
+                uint64_t size       = 0;
+                uint32_t usage      = 0;
+            };
+            std::unordered_map<VmaAllocation, allocation_movable> allocations_movable;
+            std::mutex mutex_allocations;
+
             // Extensions
             #ifdef DEBUG
                 /*
@@ -368,11 +470,11 @@ namespace Spartan
                 Identify specific sections within a VkQueue or VkCommandBuffer using labels to aid organization and offline analysis in external tools.
 
                 */
-                std::vector<const char*> extensions_device      = { "VK_KHR_swapchain", "VK_EXT_memory_budget", "VK_EXT_depth_clip_enable" };
+                std::vector<const char*> extensions_device      = { "VK_KHR_swapchain", "VK_EXT_memory_budget", "VK_EXT_depth_clip_enable", "VK_EXT_shader_viewport_index_layer", "VK_KHR_fragment_shading_rate", "VK_KHR_dynamic_rendering" };
                 std::vector<const char*> validation_layers      = { "VK_LAYER_KHRONOS_validation" };
                 std::vector<const char*> extensions_instance    = { "VK_KHR_surface", "VK_KHR_win32_surface", "VK_EXT_debug_report", "VK_EXT_debug_utils" };
             #else
-                std::vector<const char*> extensions_device      = { "VK_KHR_swapchain", "VK_EXT_memory_budget", "VK_EXT_depth_clip_enable" };
+                std::vector<const char*> extensions_device      = { "VK_KHR_swapchain", "VK_EXT_memory_budget", "VK_EXT_depth_clip_enable", "VK_EXT_shader_viewport_index_layer", "VK_KHR_fragment_shading_rate", "VK_KHR_dynamic_rendering" };
                 std::vector<const char*> validation_layers      = { };
                 std::vector<const char*> extensions_instance    = { "VK_KHR_surface", "VK_KHR_win32_surface" };
             #endif
@@ -403,6 +505,7 @@ namespace Spartan
         static const uint32_t descriptor_max_constant_buffers_dynamic   = 10;
         static const uint32_t descriptor_max_samplers                   = 10;
         static const uint32_t descriptor_max_textures                   = 10;
+        static const uint32_t descriptor_set_count_max                  = 16384; // cached sets, beyond that they are released and re-created on demand
 
         // Device limits
         uint32_t max_texture_dimension_2d   = 16384;
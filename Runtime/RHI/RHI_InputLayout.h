@@ -34,13 +34,14 @@ namespace Spartan
 {
 	struct VertexAttribute 
 	{
-		VertexAttribute(const std::string& name, const uint32_t location, const uint32_t binding, const RHI_Format format, const uint32_t offset)
+		VertexAttribute(const std::string& name, const uint32_t location, const uint32_t binding, const RHI_Format format, const uint32_t offset, const uint32_t semantic_index = 0)
 		{
-			this->name		= name;
-			this->location	= location;
-			this->binding	= binding;
-			this->format	= format;
-			this->offset	= offset;
+			this->name				= name;
+			this->location			= location;
+			this->binding			= binding;
+			this->format			= format;
+			this->offset			= offset;
+			this->semantic_index	= semantic_index;
 		}
 
 		std::string name;
@@ -48,6 +49,7 @@ namespace Spartan
 		uint32_t binding;
 		RHI_Format format;
 		uint32_t offset;
+		uint32_t semantic_index;
 	};
 
 	class SPARTAN_CLASS RHI_InputLayout : public Spartan_Object
@@ -60,7 +62,7 @@ namespace Spartan
 
 		~RHI_InputLayout();
 
-		bool Create(const RHI_Vertex_Type vertex_type, void* vertex_shader_blob = nullptr)
+		bool Create(const RHI_Vertex_Type vertex_type, void* vertex_shader_blob = nullptr, const bool instanced = false)
 		{
             if (vertex_type == RHI_Vertex_Type_Unknown)
             {
@@ -117,6 +119,49 @@ namespace Spartan
 				};
 			}
 
+			if (vertex_type == RHI_Vertex_Type_PositionTextureNormalTangentCompact)
+			{
+				m_vertex_attributes =
+				{
+					{ "POSITION",	0, binding, RHI_Format_R16G16B16A16_Unorm,	offsetof(RHI_Vertex_PosTexNorTanCompact, pos) },
+					{ "TEXCOORD",	1, binding, RHI_Format_R16G16_Float,		offsetof(RHI_Vertex_PosTexNorTanCompact, tex) },
+					{ "NORMAL",		2, binding, RHI_Format_R16G16_Float,		offsetof(RHI_Vertex_PosTexNorTanCompact, nor) },
+					{ "TANGENT",	3, binding, RHI_Format_R16G16_Float,		offsetof(RHI_Vertex_PosTexNorTanCompact, tan) }
+				};
+			}
+
+			// The bone indices are normalized too (the shader scales them back), so that every backend has the format
+			if (vertex_type == RHI_Vertex_Type_PositionTextureNormalTangentSkin)
+			{
+				m_vertex_attributes =
+				{
+					{ "POSITION",		0, binding, RHI_Format_R32G32B32_Float,	offsetof(RHI_Vertex_PosTexNorTanSkin, pos) },
+					{ "TEXCOORD",		1, binding, RHI_Format_R32G32_Float,	offsetof(RHI_Vertex_PosTexNorTanSkin, tex) },
+					{ "NORMAL",			2, binding, RHI_Format_R32G32B32_Float,	offsetof(RHI_Vertex_PosTexNorTanSkin, nor) },
+					{ "TANGENT",		3, binding, RHI_Format_R32G32B32_Float,	offsetof(RHI_Vertex_PosTexNorTanSkin, tan) },
+					{ "BLENDINDICES",	4, binding, RHI_Format_R8G8B8A8_Unorm,	offsetof(RHI_Vertex_PosTexNorTanSkin, bones) },
+					{ "BLENDWEIGHT",	5, binding, RHI_Format_R8G8B8A8_Unorm,	offsetof(RHI_Vertex_PosTexNorTanSkin, weights) }
+				};
+			}
+
+			// Instanced shaders also read a world matrix and last frame's world view projection matrix per instance, a row per location
+			m_instance_stride = 0;
+			if (instanced && !m_vertex_attributes.empty())
+			{
+				const uint32_t location = static_cast<uint32_t>(m_vertex_attributes.size());
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					m_vertex_attributes.emplace_back("INSTANCE_TRANSFORM", location + i, rhi_binding_instance, RHI_Format_R32G32B32A32_Float, static_cast<uint32_t>(offsetof(RHI_Vertex_Instance, transform) + i * 16), i);
+				}
+
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					m_vertex_attributes.emplace_back("INSTANCE_WVP_PREVIOUS", location + 4 + i, rhi_binding_instance, RHI_Format_R32G32B32A32_Float, static_cast<uint32_t>(offsetof(RHI_Vertex_Instance, wvp_previous) + i * 16), i);
+				}
+
+				m_instance_stride = static_cast<uint32_t>(sizeof(RHI_Vertex_Instance));
+			}
+
 			if (vertex_shader_blob && !m_vertex_attributes.empty())
 			{
 				return _CreateResource(vertex_shader_blob);
@@ -127,6 +172,7 @@ namespace Spartan
 
         RHI_Vertex_Type GetVertexType()			const { return m_vertex_type; }
 		const auto& GetAttributeDescriptions()	const { return m_vertex_attributes; }
+		uint32_t GetInstanceStride()			const { return m_instance_stride; } // zero unless the layout is instanced
         void* GetResource()						const { return m_resource; }
 
 		bool operator==(const RHI_InputLayout& rhs) const { return m_vertex_type == rhs.GetVertexType(); }
@@ -139,5 +185,6 @@ namespace Spartan
 		std::shared_ptr<RHI_Device> m_rhi_device;
 		void* m_resource = nullptr;
 		std::vector<VertexAttribute> m_vertex_attributes;
+		uint32_t m_instance_stride = 0;
 	};
 }
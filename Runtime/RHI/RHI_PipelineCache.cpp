@@ -25,6 +25,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Pipeline.h"
 #include "RHI_SwapChain.h"
 #include "RHI_DescriptorCache.h"
+#include "RHI_CommandList.h"
+#include "RHI_Device.h"
+#include "../Core/Context.h"
+#include "../Threading/Threading.h"
+#include "../Profiling/Profiler.h"
 //==============================
 
 //= NAMESPACES =====
@@ -33,6 +38,31 @@ using namespace std;
 
 namespace Spartan
 {
+    RHI_PipelineCache::RHI_PipelineCache(const RHI_Device* rhi_device, const string& file_path)
+    {
+        m_rhi_device    = rhi_device;
+        m_file_path     = file_path;
+
+        CreateResource();
+    }
+
+    RHI_PipelineCache::~RHI_PipelineCache()
+    {
+        // Pipelines which are still compiling write into the cache
+        for (auto& it : m_cache)
+        {
+            if (it.second.task)
+            {
+                m_rhi_device->GetContext()->GetSubsystem<Threading>()->Wait(it.second.task);
+            }
+        }
+
+        // Destroy the pipelines before the API cache, then keep what the driver has learned for the next run
+        m_cache.clear();
+        SaveResource();
+        DestroyResource();
+    }
+
     RHI_Pipeline* RHI_PipelineCache::GetPipeline(RHI_CommandList* cmd_list, RHI_PipelineState& pipeline_state, void* descriptor_set_layout)
     {
         // Validate it
@@ -42,8 +72,12 @@ namespace Spartan
             return nullptr;
         }
 
-        // Render target layout transitions
+        // Render target layout transitions, the textures are transitioned with a single barrier
         {
+            array<RHI_Texture*, state_max_render_target_count + 2> textures;
+            array<RHI_Image_Layout, state_max_render_target_count + 2> layouts;
+            uint32_t count = 0;
+
             // Color
             {
                 // Swapchain
@@ -59,7 +93,10 @@ namespace Spartan
                 {
                     if (RHI_Texture* texture = pipeline_state.render_target_color_textures[i])
                     {
-                        texture->SetLayout(RHI_Image_Color_Attachment_Optimal, cmd_list);
+                        textures[count]  = texture;
+                        layouts[count]   = RHI_Image_Color_Attachment_Optimal;
+                        count++;
+
                         pipeline_state.render_target_color_layout_initial   = RHI_Image_Color_Attachment_Optimal;
                         pipeline_state.render_target_color_layout_final     = RHI_Image_Color_Attachment_Optimal;
                     }
@@ -69,10 +106,23 @@ namespace Spartan
             // Depth
             if (RHI_Texture* texture = pipeline_state.render_target_depth_texture)
             {
-                texture->SetLayout(RHI_Image_Depth_Stencil_Attachment_Optimal, cmd_list);
+                textures[count]  = texture;
+                layouts[count]   = RHI_Image_Depth_Stencil_Attachment_Optimal;
+                count++;
+
                 pipeline_state.render_target_depth_layout_initial   = RHI_Image_Depth_Stencil_Attachment_Optimal;
                 pipeline_state.render_target_depth_layout_final     = RHI_Image_Depth_Stencil_Attachment_Optimal;
             }
+
+            // Shading rate
+            if (RHI_Texture* texture = pipeline_state.render_target_shading_rate_texture)
+            {
+                textures[count]  = texture;
+                layouts[count]   = RHI_Image_Shading_Rate_Attachment_Optimal;
+                count++;
+            }
+
+            cmd_list->SetLayouts(textures.data(), layouts.data(), count);
         }
 
         // Compute a hash for it
@@ -83,10 +133,35 @@ namespace Spartan
         auto it = m_cache.find(hash);
         if (it == m_cache.end())
         {
-            // Cache a new pipeline
-            it = m_cache.emplace(make_pair(hash, move(make_shared<RHI_Pipeline>(m_rhi_device, pipeline_state, descriptor_set_layout)))).first;
+            it = m_cache.emplace(hash, Entry()).first;
+            Entry& entry = it->second;
+
+            Profiler::EventAdd("Pipeline creation", pipeline_state.pass_name ? pipeline_state.pass_name : "");
+
+            if (pipeline_state.compile_async)
+            {
+                // Compile in the background, the caller skips its work until the pipeline is there (entries are never moved, so the task can keep a reference)
+                entry.task = m_rhi_device->GetContext()->GetSubsystem<Threading>()->AddTask([this, &entry, pipeline_state, descriptor_set_layout]() mutable
+                {
+                    entry.pipeline = make_shared<RHI_Pipeline>(m_rhi_device, pipeline_state, descriptor_set_layout, m_resource);
+                }, {}, Threading_Pool_Shaders);
+            }
+            else
+            {
+                entry.pipeline = make_shared<RHI_Pipeline>(m_rhi_device, pipeline_state, descriptor_set_layout, m_resource);
+            }
+        }
+
+        // Still compiling
+        Entry& entry = it->second;
+        if (entry.task)
+        {
+            if (!entry.task->IsDone())
+                return nullptr;
+
+            entry.task.reset();
         }
 
-        return it->second.get();
+        return entry.pipeline.get();
     }
 }
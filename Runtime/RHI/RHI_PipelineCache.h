@@ -19,10 +19,12 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+
 #pragma once
 
 //= INCLUDES ======================
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include "RHI_Definition.h"
 #include "../Core/Spartan_Object.h"
@@ -30,15 +32,34 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
+    class Task;
+
 	class RHI_PipelineCache : public Spartan_Object
 	{
 	public:
-        RHI_PipelineCache(const RHI_Device* rhi_device) { m_rhi_device = rhi_device; }
+        RHI_PipelineCache(const RHI_Device* rhi_device, const std::string& file_path);
+        ~RHI_PipelineCache();
+
+        // Returns null while the pipeline of a state which allows asynchronous compilation is still compiling (or if the state is invalid)
         RHI_Pipeline* GetPipeline(RHI_CommandList* cmd_list, RHI_PipelineState& pipeline_state, void* descriptor_set_layout);
 
 	private:
+        struct Entry
+        {
+            std::shared_ptr<RHI_Pipeline> pipeline;
+            std::shared_ptr<Task> task; // set while the pipeline compiles in the background
+        };
+
+        // The API pipeline cache, it's loaded from and saved to disk so that pipelines which were compiled before are quick to create
+        bool CreateResource();
+        void SaveResource();
+        void DestroyResource();
+
         // <hash of pipeline state, pipeline state object>
-        std::unordered_map<std::size_t, std::shared_ptr<RHI_Pipeline>> m_cache;
+        std::unordered_map<std::size_t, Entry> m_cache;
+
+        std::string m_file_path;
+        void* m_resource = nullptr;
 
         // Dependencies
         const RHI_Device* m_rhi_device;
@@ -136,6 +136,15 @@ namespace Spartan
         return 0;
     }
 
+    uint32_t RHI_PipelineState::GetLayerCount() const
+    {
+        // A view index equal to the array size stands for a view of all the slices
+        if (render_target_depth_texture && render_target_depth_stencil_texture_array_index == render_target_depth_texture->GetArraySize())
+            return render_target_depth_stencil_texture_array_index;
+
+        return 1;
+    }
+
 	void RHI_PipelineState::ResetClearValues()
 	{
         clear_color.fill(state_color_load);
@@ -145,105 +154,43 @@ namespace Spartan
 
 	void RHI_PipelineState::ComputeHash()
     {
-        m_hash = 0;
-
-        Utility::Hash::hash_combine(m_hash, dynamic_scissor);
-        Utility::Hash::hash_combine(m_hash, viewport.x);
-        Utility::Hash::hash_combine(m_hash, viewport.y);
-        Utility::Hash::hash_combine(m_hash, viewport.width);
-        Utility::Hash::hash_combine(m_hash, viewport.height);
-        Utility::Hash::hash_combine(m_hash, primitive_topology);
-        Utility::Hash::hash_combine(m_hash, vertex_buffer_stride);
-        Utility::Hash::hash_combine(m_hash, render_target_color_texture_array_index);
-        Utility::Hash::hash_combine(m_hash, render_target_depth_stencil_texture_array_index);
-        Utility::Hash::hash_combine(m_hash, render_target_swapchain != nullptr);
-
-        if (!dynamic_scissor)
+        // Gather everything the pipeline depends on into a fixed layout key, object ids of zero mean null. Render targets only
+        // contribute their formats, which is all a pipeline is compiled against, and the viewport and scissor are set when the
+        // pipeline is bound, so passes which render to different targets or mips (or clear them differently) share a pipeline.
+        array<uint32_t, m_hash_key_size> key;
+        uint32_t i = 0;
+
+        const auto id = [](const Spartan_Object* object) { return object ? object->GetId() : 0; };
+
+        key[i++] = primitive_topology;
+        key[i++] = vertex_buffer_stride;
+        key[i++] = render_target_swapchain != nullptr;
+        key[i++] = id(rasterizer_state);
+        key[i++] = id(blend_state);
+        key[i++] = id(depth_stencil_state);
+        key[i++] = id(shader_compute);
+        key[i++] = id(shader_vertex);
+        key[i++] = id(shader_pixel);
+
+        // RT formats, offset by one so that a missing target differs from the first format
+        const auto format = [](const RHI_Texture* texture) { return texture ? static_cast<uint32_t>(texture->GetFormat()) + 1 : 0; };
+        for (uint32_t rt = 0; rt < state_max_render_target_count; rt++)
         {
-            Utility::Hash::hash_combine(m_hash, scissor.left);
-            Utility::Hash::hash_combine(m_hash, scissor.top);
-            Utility::Hash::hash_combine(m_hash, scissor.right);
-            Utility::Hash::hash_combine(m_hash, scissor.bottom);
+            key[i++] = format(render_target_color_textures[rt]);
         }
+        key[i++] = format(render_target_depth_texture);
+        key[i++] = render_target_shading_rate_texture != nullptr;
+        SPARTAN_ASSERT(i == m_hash_key_size);
 
-        if (rasterizer_state)
-        {
-            Utility::Hash::hash_combine(m_hash, rasterizer_state->GetId());
-        }
+        // Most states are static and come back with the same fields every frame, comparing the key is cheaper than hashing it
+        if (m_hash != 0 && key == m_hash_key)
+            return;
 
-        if (blend_state)
+        m_hash_key  = key;
+        m_hash      = 0;
+        for (const uint32_t value : m_hash_key)
         {
-            Utility::Hash::hash_combine(m_hash, blend_state->GetId());
-        }
-
-        if (depth_stencil_state)
-        {
-            Utility::Hash::hash_combine(m_hash, depth_stencil_state->GetId());
-        }
-
-        // Shaders
-        {
-            if (shader_compute)
-            {
-                Utility::Hash::hash_combine(m_hash, shader_compute->GetId());
-            }
-
-            if (shader_vertex)
-            {
-                Utility::Hash::hash_combine(m_hash, shader_vertex->GetId());
-            }
-
-            if (shader_pixel)
-            {
-                Utility::Hash::hash_combine(m_hash, shader_pixel->GetId());
-            }
-        }
-
-        // RTs
-        bool has_rt_color = false;
-        {
-            uint8_t load_op = 0;
-
-            // Color
-            for (uint32_t i = 0; i < state_max_render_target_count; i++)
-            {
-                if (RHI_Texture* texture = render_target_color_textures[i])
-                {
-                    Utility::Hash::hash_combine(m_hash, texture->GetId());
-
-                    load_op = clear_color[i] == state_color_dont_care ? 0 : clear_color[i] == state_color_load ? 1 : 2;
-                    Utility::Hash::hash_combine(m_hash, load_op);
-
-                    has_rt_color = true;
-                }
-            }
-
-            // Depth
-            if (render_target_depth_texture)
-            {
-                Utility::Hash::hash_combine(m_hash, render_target_depth_texture->GetId());
-
-                load_op = clear_depth == state_depth_dont_care ? 0 : clear_depth == state_depth_load ? 1 : 2;
-                Utility::Hash::hash_combine(m_hash, load_op);
-
-                load_op = clear_stencil == state_stencil_dont_care ? 0 : clear_stencil == state_stencil_load ? 1 : 2;
-                Utility::Hash::hash_combine(m_hash, load_op);
-            }
-        }
-
-        // Initial and final layouts
-        {
-            if (has_rt_color)
-            {
-                Utility::Hash::hash_combine(m_hash, render_target_color_layout_initial);
-                Utility::Hash::hash_combine(m_hash, render_target_color_layout_final);
-            }
-
-            if (render_target_depth_texture)
-            {
-                Utility::Hash::hash_combine(m_hash, render_target_depth_layout_initial);
-                Utility::Hash::hash_combine(m_hash, render_target_depth_layout_final);
-            }
+            Utility::Hash::hash_combine(m_hash, value);
         }
     }
 }
@@ -35,17 +35,13 @@ namespace Spartan
     {
     public:
         RHI_PipelineState();
-        ~RHI_PipelineState() { DestroyFrameResources(); }
 
         bool IsValid();   
-        bool CreateFrameResources(const RHI_Device* rhi_device);
-        void* GetFrameBuffer() const;
         void ComputeHash();
         uint32_t GetWidth() const;
         uint32_t GetHeight() const;
         void ResetClearValues();
         auto GetHash()                                  const { return m_hash; }
-        void* GetRenderPass()                           const { return m_render_pass; }
         bool operator==(const RHI_PipelineState& rhs)   const { return m_hash == rhs.GetHash(); }
 
         //= Static, modification can potentially generate a new pipeline ===========================================================
@@ -80,7 +76,10 @@ namespace Spartan
             nullptr
         };
 
-        // RT indices (affect render pass)
+        // Shading rate image, a texel per tile of the render targets says how coarse the pixel shader runs there (only if the device supports variable rate shading)
+        RHI_Texture* render_target_shading_rate_texture = nullptr;
+
+        // RT indices (affect the frame buffer)
         uint32_t render_target_color_texture_array_index            = 0;
         uint32_t render_target_depth_stencil_texture_array_index    = 0;
 
@@ -103,6 +102,7 @@ namespace Spartan
         //= Dynamic, modification is free =============================================================
         RHI_Texture* unordered_access_view         = nullptr;
         bool render_target_depth_texture_read_only = false;
+        bool compile_async                         = false; // a new pipeline compiles in the background and the pass is skipped until it's ready
 
         // such a hack, must fix. Update: Came back to byte me in the ass
         int dynamic_constant_buffer_slot    = 2;
@@ -117,24 +117,18 @@ namespace Spartan
         bool profile            = false;
         //=============================================================================================
 
-    private:
-        void DestroyFrameResources();
+        //= Vulkan ===================================================================================================================
+        // Looked up in a cache which every state with the same attachments shares, the render pass by formats, layouts and load/store
+        // ops, the frame buffer by the views. Neither is needed when the device supports dynamic rendering.
+        void* GetRenderPass(const RHI_Device* rhi_device) const;
+        void* GetFrameBuffer(const RHI_Device* rhi_device) const;
+        uint32_t GetLayerCount() const; // more than one when the depth view covers all the slices (layered rendering)
+        //==========================================================================================================================
 
+    private:
+        // The fields the hash depends on, packed, so that an unchanged state costs a compare instead of a re-hash
+        static const uint32_t m_hash_key_size = 19;
+        std::array<uint32_t, m_hash_key_size> m_hash_key = {};
         std::size_t m_hash  = 0;
-        void* m_render_pass = nullptr;
-        std::array<void*, state_max_render_target_count> m_frame_buffers =
-        {
-            nullptr,
-            nullptr,
-            nullptr,
-            nullptr,
-            nullptr,
-            nullptr,
-            nullptr,
-            nullptr,
-        };
-
-        // Dependencies
-        const RHI_Device* m_rhi_device = nullptr;
     };
 }
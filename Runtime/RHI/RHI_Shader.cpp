@@ -26,6 +26,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Core/FileSystem.h"
 #include "../Threading/Threading.h"
 #include "../Rendering/Renderer.h"
+#include "../IO/FileStream.h"
+#include "../Utilities/Hash.h"
+#include <sstream>
+#include <map>
+#include <mutex>
 #pragma warning(push, 0) // Hide warnings belonging SPIRV-Cross 
 #include <spirv_hlsl.hpp>
 #pragma warning(pop)
@@ -37,6 +42,78 @@ using namespace std;
 
 namespace Spartan
 {
+    // Bump when the layout of the cache files changes
+    static const uint32_t shader_cache_version = 1;
+
+    // The bytecode and reflection of a shader, laid out the same way in the cache files and the archive
+    struct ShaderCacheEntry
+    {
+        vector<std::byte> bytecode;
+        vector<RHI_Descriptor> descriptors;
+    };
+
+    // Archives are read once and kept in memory, keyed by their file path
+    static unordered_map<string, unordered_map<size_t, ShaderCacheEntry>> cache_archives;
+    static mutex cache_archives_mutex;
+
+    // Background recompilations, only the main thread touches these (the tasks only touch their staging shader)
+    struct ShaderRecompilation
+    {
+        RHI_Shader* shader = nullptr;
+        shared_ptr<RHI_Shader> staging;
+        shared_ptr<Task> task;
+    };
+    static vector<ShaderRecompilation> recompilations;
+    // Swapped out modules, kept alive until the frames in flight which may have used them are done
+    static vector<pair<shared_ptr<RHI_Shader>, uint32_t>> recompilations_retired;
+    static const uint32_t recompilation_retire_frames = 3;
+
+    static bool ReadCacheEntry(FileStream* file, vector<std::byte>& bytecode, vector<RHI_Descriptor>& descriptors)
+    {
+        file->Read(&bytecode);
+        if (bytecode.empty())
+            return false;
+
+        const uint32_t descriptor_count = file->ReadAs<uint32_t>();
+        descriptors.reserve(descriptor_count);
+        for (uint32_t i = 0; i < descriptor_count; i++)
+        {
+            const auto type         = static_cast<RHI_Descriptor_Type>(file->ReadAs<uint32_t>());
+            const uint32_t slot     = file->ReadAs<uint32_t>();
+            const uint32_t stage    = file->ReadAs<uint32_t>();
+            descriptors.emplace_back(type, slot, stage);
+        }
+
+        return true;
+    }
+
+    static bool ReadCacheFile(const string& file_path, vector<std::byte>& bytecode, vector<RHI_Descriptor>& descriptors)
+    {
+        if (!FileSystem::IsFile(file_path))
+            return false;
+
+        auto file = make_unique<FileStream>(file_path, FileStream_Read);
+        if (!file->IsOpen())
+            return false;
+
+        if (file->ReadAs<uint32_t>() != shader_cache_version)
+            return false;
+
+        return ReadCacheEntry(file.get(), bytecode, descriptors);
+    }
+
+    static void WriteCacheEntry(FileStream* file, const vector<std::byte>& bytecode, const vector<RHI_Descriptor>& descriptors)
+    {
+        file->Write(bytecode);
+        file->Write(static_cast<uint32_t>(descriptors.size()));
+        for (const RHI_Descriptor& descriptor : descriptors)
+        {
+            file->Write(static_cast<uint32_t>(descriptor.type));
+            file->Write(descriptor.slot);
+            file->Write(descriptor.stage);
+        }
+    }
+
 	RHI_Shader::RHI_Shader(Context* context) : Spartan_Object(context)
 	{
 		m_rhi_device	= context->GetSubsystem<Renderer>()->GetRhiDevice();
@@ -49,6 +126,11 @@ namespace Spartan
         m_shader_type = type;
         m_vertex_type = RHI_Vertex_Type_To_Enum<T>();
 
+        CompileInternal(shader);
+	}
+
+    void RHI_Shader::CompileInternal(const string& shader)
+    {
         // Can also be the source
         const bool is_file = FileSystem::IsFile(shader);
 
@@ -64,17 +146,34 @@ namespace Spartan
 			m_file_path.clear();
 		}
 
-		// Compile
+		// Compile, unless a previous run already did (only files are cached, sources are cheap to tell apart but they are rare)
         m_compilation_state = Shader_Compilation_Compiling;
-        m_resource          = _Compile(shader);
+        m_descriptors.clear();
+        bool from_cache = false;
+        {
+            const size_t cache_hash = is_file ? ComputeCacheHash(shader) : 0;
+            vector<std::byte> bytecode;
+            from_cache = is_file && LoadFromCache(cache_hash, bytecode);
+
+            if (from_cache || _Compile(shader, bytecode))
+            {
+                m_resource = _CreateResource(bytecode);
+
+                if (m_resource && is_file && !from_cache)
+                {
+                    SaveToCache(cache_hash, bytecode);
+                }
+            }
+        }
         m_compilation_state = m_resource ? Shader_Compilation_Succeeded : Shader_Compilation_Failed;
 
 		// Log compilation result
         {
+            const char* verb = from_cache ? "loaded" : "compiled";
             string type_str = "unknown";
-            type_str        = type == RHI_Shader_Vertex     ? "vertex"   : type_str;
-            type_str        = type == RHI_Shader_Pixel      ? "pixel"    : type_str;
-            type_str        = type == RHI_Shader_Compute    ? "compute"  : type_str;
+            type_str        = m_shader_type == RHI_Shader_Vertex     ? "vertex"   : type_str;
+            type_str        = m_shader_type == RHI_Shader_Pixel      ? "pixel"    : type_str;
+            type_str        = m_shader_type == RHI_Shader_Compute    ? "compute"  : type_str;
 
             string defines;
             for (const auto& define : m_defines)
@@ -82,18 +181,18 @@ namespace Spartan
                 if (!defines.empty())
                     defines += ", ";
 
-                defines += define.first + " = " + define.second;
+                defines += define.first.Get() + " = " + define.second;
             }
 
             if (m_compilation_state == Shader_Compilation_Succeeded)
             {
                 if (defines.empty())
                 {
-                    LOG_INFO("Successfully compiled %s shader from \"%s\"", type_str.c_str(), shader.c_str());
+                    LOG_INFO("Successfully %s %s shader from \"%s\"", verb, type_str.c_str(), shader.c_str());
                 }
                 else
                 {
-                    LOG_INFO("Successfully compiled %s shader from \"%s\" with definitions \"%s\"", type_str.c_str(), shader.c_str(), defines.c_str());
+                    LOG_INFO("Successfully %s %s shader from \"%s\" with definitions \"%s\"", verb, type_str.c_str(), shader.c_str(), defines.c_str());
                 }
             }
             else if (m_compilation_state == Shader_Compilation_Failed)
@@ -108,24 +207,29 @@ namespace Spartan
                 }
             }
         }
-	}
+    }
 
 	template <typename T>
 	void RHI_Shader::CompileAsync(const RHI_Shader_Type type, const string& shader)
 	{
-		m_context->GetSubsystem<Threading>()->AddTask([this, type, shader]()
+		m_compilation_task = m_context->GetSubsystem<Threading>()->AddTask([this, type, shader]()
 		{
 			Compile<T>(type, shader);
-		});
+		}, {}, Threading_Pool_Shaders);
 	}
 
 	void RHI_Shader::WaitForCompilation()
 	{
         // Wait
-        while (m_compilation_state == Shader_Compilation_Compiling)
+        if (m_compilation_task)
         {
-            LOG_INFO("Waiting for shader \"%s\" to compile...", m_name.c_str());
-            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            if (!m_compilation_task->IsDone())
+            {
+                LOG_INFO("Waiting for shader \"%s\" to compile...", m_name.c_str());
+                m_context->GetSubsystem<Threading>()->Wait(m_compilation_task);
+            }
+
+            m_compilation_task.reset();
         }
         
         // Log error in case of failure
@@ -135,6 +239,68 @@ namespace Spartan
         }
 	}
 
+    void RHI_Shader::RecompileAsync()
+    {
+        if (m_recompiling || m_file_path.empty())
+            return;
+
+        // Same permutation, compiled on the side
+        shared_ptr<RHI_Shader> staging  = make_shared<RHI_Shader>(m_context);
+        staging->m_defines              = m_defines;
+        staging->m_shader_type          = m_shader_type;
+        staging->m_vertex_type          = m_vertex_type;
+
+        RHI_Shader* staging_raw     = staging.get();
+        const string file_path      = m_file_path;
+        shared_ptr<Task> task       = m_context->GetSubsystem<Threading>()->AddTask([staging_raw, file_path]()
+        {
+            staging_raw->CompileInternal(file_path);
+        }, {}, Threading_Pool_Shaders);
+
+        m_recompiling = true;
+        recompilations.push_back({ this, staging, task });
+    }
+
+    void RHI_Shader::ApplyRecompilations()
+    {
+        for (auto it = recompilations_retired.begin(); it != recompilations_retired.end();)
+        {
+            it = --it->second == 0 ? recompilations_retired.erase(it) : it + 1;
+        }
+
+        for (auto it = recompilations.begin(); it != recompilations.end();)
+        {
+            if (!it->task->IsDone())
+            {
+                ++it;
+                continue;
+            }
+
+            RHI_Shader* shader  = it->shader;
+            RHI_Shader* staging = it->staging.get();
+            if (staging->IsCompiled())
+            {
+                // The staging shader takes the previous module (and destroys it once retired)
+                swap(shader->m_resource,        staging->m_resource);
+                swap(shader->m_descriptors,     staging->m_descriptors);
+                swap(shader->m_input_layout,    staging->m_input_layout);
+                shader->m_compilation_state = Shader_Compilation_Succeeded;
+
+                // Pipelines and descriptor sets are cached by shader id, a new one makes them get created against the new module
+                shader->SetId(GenerateId());
+
+                recompilations_retired.emplace_back(it->staging, recompilation_retire_frames);
+            }
+            else
+            {
+                LOG_ERROR("Failed to recompile \"%s\", keeping the previous version", shader->m_name.c_str());
+            }
+
+            shader->m_recompiling = false;
+            it = recompilations.erase(it);
+        }
+    }
+
 	const char* RHI_Shader::GetEntryPoint() const
     {
         static const char* entry_point_empty = nullptr;
@@ -168,6 +334,16 @@ namespace Spartan
         static const char* target_profile_cs = "cs_6_0";
         #endif
 
+        // Native 16-bit types need shader model 6.2, fxc has no such thing (min16float is a hint there)
+        #if defined(API_GRAPHICS_D3D12) || defined(API_GRAPHICS_VULKAN)
+        if (IsHalfPrecision())
+        {
+            if (m_shader_type == RHI_Shader_Vertex)     return "vs_6_2";
+            if (m_shader_type == RHI_Shader_Pixel)      return "ps_6_2";
+            if (m_shader_type == RHI_Shader_Compute)    return "cs_6_2";
+        }
+        #endif
+
         if (m_shader_type == RHI_Shader_Vertex)     return target_profile_vs;
         if (m_shader_type == RHI_Shader_Pixel)      return target_profile_ps;
         if (m_shader_type == RHI_Shader_Compute)    return target_profile_cs;
@@ -175,6 +351,13 @@ namespace Spartan
         return target_profile_empty;
     }
 
+    bool RHI_Shader::IsHalfPrecision() const
+    {
+        static const StringId half_precision("HALF_PRECISION");
+        const auto it = m_defines.find(half_precision);
+        return it != m_defines.end() && it->second == "1";
+    }
+
     const char* RHI_Shader::GetShaderModel() const
     {
         #if defined(API_GRAPHICS_D3D11)
@@ -188,6 +371,200 @@ namespace Spartan
         return shader_model;
     }
 
+    size_t RHI_Shader::ComputeCacheHash(const string& file_path) const
+    {
+        size_t hash = 0;
+
+        // The source, along with every file it includes (that's what the preprocessor would see)
+        vector<string> file_paths = FileSystem::GetIncludedFiles(file_path);
+        file_paths.insert(file_paths.begin(), file_path);
+        for (const string& path : file_paths)
+        {
+            ifstream in(path);
+            stringstream buffer;
+            buffer << in.rdbuf();
+            Utility::Hash::hash_combine(hash, buffer.str());
+        }
+
+        // The defines, sorted as their map is not
+        map<string, string> defines;
+        for (const auto& define : m_defines)
+        {
+            defines.emplace(define.first.Get(), define.second);
+        }
+        for (const auto& define : defines)
+        {
+            Utility::Hash::hash_combine(hash, define.first);
+            Utility::Hash::hash_combine(hash, define.second);
+        }
+
+        // The compiler and what it's asked to output
+        Utility::Hash::hash_combine(hash, _GetCompilerVersion());
+        Utility::Hash::hash_combine(hash, static_cast<uint32_t>(m_shader_type));
+        Utility::Hash::hash_combine(hash, string(GetTargetProfile()));
+        Utility::Hash::hash_combine(hash, shader_cache_version);
+        #ifdef DEBUG
+        Utility::Hash::hash_combine(hash, true);
+        #endif
+
+        return hash;
+    }
+
+    string RHI_Shader::GetCacheFilePath(const size_t hash) const
+    {
+        return FileSystem::GetDirectoryFromFilePath(m_file_path) + "cache/" + FileSystem::GetFileNameNoExtensionFromFilePath(m_file_path) + "_" + to_string(hash) + ".bin";
+    }
+
+    bool RHI_Shader::LoadFromCache(const size_t hash, vector<std::byte>& bytecode)
+    {
+        return LoadFromCacheArchive(hash, bytecode) || LoadFromCacheFile(hash, bytecode);
+    }
+
+    bool RHI_Shader::LoadFromCacheArchive(const size_t hash, vector<std::byte>& bytecode)
+    {
+        const string file_path = GetCacheArchiveFilePath(FileSystem::GetDirectoryFromFilePath(m_file_path));
+
+        lock_guard<mutex> guard(cache_archives_mutex);
+
+        // Load the archive the first time it's looked in (a missing archive is remembered as an empty one)
+        auto it = cache_archives.find(file_path);
+        if (it == cache_archives.end())
+        {
+            it = cache_archives.emplace(file_path, unordered_map<size_t, ShaderCacheEntry>()).first;
+
+            if (FileSystem::IsFile(file_path))
+            {
+                auto file = make_unique<FileStream>(file_path, FileStream_Read);
+                if (file->IsOpen() && file->ReadAs<uint32_t>() == shader_cache_version)
+                {
+                    const uint32_t entry_count = file->ReadAs<uint32_t>();
+                    for (uint32_t i = 0; i < entry_count; i++)
+                    {
+                        const size_t entry_hash = static_cast<size_t>(file->ReadAs<uint64_t>());
+                        ShaderCacheEntry& entry = it->second[entry_hash];
+                        if (!ReadCacheEntry(file.get(), entry.bytecode, entry.descriptors))
+                        {
+                            LOG_ERROR("Shader archive \"%s\" is corrupt, ignoring it", file_path.c_str());
+                            it->second.clear();
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        auto it_entry = it->second.find(hash);
+        if (it_entry == it->second.end())
+            return false;
+
+        bytecode        = it_entry->second.bytecode;
+        m_descriptors   = it_entry->second.descriptors;
+
+        return true;
+    }
+
+    bool RHI_Shader::LoadFromCacheFile(const size_t hash, vector<std::byte>& bytecode)
+    {
+        return ReadCacheFile(GetCacheFilePath(hash), bytecode, m_descriptors);
+    }
+
+    void RHI_Shader::SaveToCache(const size_t hash, const vector<std::byte>& bytecode) const
+    {
+        const string file_path = GetCacheFilePath(hash);
+        FileSystem::CreateDirectory_(FileSystem::GetDirectoryFromFilePath(file_path));
+
+        auto file = make_unique<FileStream>(file_path, FileStream_Write);
+        if (!file->IsOpen())
+        {
+            LOG_WARNING("Failed to cache shader \"%s\"", m_name.c_str());
+            return;
+        }
+
+        file->Write(shader_cache_version);
+        WriteCacheEntry(file.get(), bytecode, m_descriptors);
+    }
+
+    bool RHI_Shader::CompileToCache(const RHI_Shader_Type type, const string& file_path)
+    {
+        if (!FileSystem::IsFile(file_path))
+        {
+            LOG_ERROR("\"%s\" is not a shader file", file_path.c_str());
+            return false;
+        }
+
+        m_shader_type   = type;
+        m_name          = FileSystem::GetFileNameFromFilePath(file_path);
+        m_file_path     = file_path;
+        m_cache_hash    = ComputeCacheHash(file_path);
+        m_descriptors.clear();
+
+        // Up to date already, the archive is not looked in as it's what is being rebuilt
+        vector<std::byte> bytecode;
+        if (LoadFromCacheFile(m_cache_hash, bytecode))
+            return true;
+
+        if (!_Compile(file_path, bytecode))
+        {
+            LOG_ERROR("Failed to compile \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        SaveToCache(m_cache_hash, bytecode);
+        return true;
+    }
+
+    bool RHI_Shader::SaveCacheArchive(const string& shader_directory, const vector<shared_ptr<RHI_Shader>>& shaders)
+    {
+        // Gather the cache files, shaders which ended up with the same hash are packed once
+        unordered_map<size_t, ShaderCacheEntry> entries;
+        for (const shared_ptr<RHI_Shader>& shader : shaders)
+        {
+            if (entries.find(shader->m_cache_hash) != entries.end())
+                continue;
+
+            ShaderCacheEntry& entry = entries[shader->m_cache_hash];
+            if (!ReadCacheFile(shader->GetCacheFilePath(shader->m_cache_hash), entry.bytecode, entry.descriptors))
+            {
+                LOG_ERROR("\"%s\" has not been compiled to the cache", shader->m_name.c_str());
+                return false;
+            }
+        }
+
+        const string file_path = GetCacheArchiveFilePath(shader_directory);
+        FileSystem::CreateDirectory_(FileSystem::GetDirectoryFromFilePath(file_path));
+
+        auto file = make_unique<FileStream>(file_path, FileStream_Write);
+        if (!file->IsOpen())
+        {
+            LOG_ERROR("Failed to create \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        file->Write(shader_cache_version);
+        file->Write(static_cast<uint32_t>(entries.size()));
+        for (const auto& entry : entries)
+        {
+            file->Write(static_cast<uint64_t>(entry.first));
+            WriteCacheEntry(file.get(), entry.second.bytecode, entry.second.descriptors);
+        }
+
+        LOG_INFO("Packed %d shaders into \"%s\"", static_cast<int>(entries.size()), file_path.c_str());
+        return true;
+    }
+
+    string RHI_Shader::GetCacheArchiveFilePath(const string& shader_directory)
+    {
+        #if defined(API_GRAPHICS_D3D11)
+        static const char* api = "d3d11";
+        #elif defined(API_GRAPHICS_D3D12)
+        static const char* api = "d3d12";
+        #elif defined(API_GRAPHICS_VULKAN)
+        static const char* api = "vulkan";
+        #endif
+
+        return shader_directory + "cache/shaders_" + api + ".pak";
+    }
+
     void RHI_Shader::_Reflect(const RHI_Shader_Type shader_type, const uint32_t* ptr, const uint32_t size)
 	{
 		// Initialize compiler with SPIR-V data
@@ -237,5 +614,7 @@ namespace Spartan
     template void RHI_Shader::CompileAsync<RHI_Vertex_PosCol>(const RHI_Shader_Type, const std::string&);
     template void RHI_Shader::CompileAsync<RHI_Vertex_Pos2dTexCol8>(const RHI_Shader_Type, const std::string&);
     template void RHI_Shader::CompileAsync<RHI_Vertex_PosTexNorTan>(const RHI_Shader_Type, const std::string&);
+    template void RHI_Shader::CompileAsync<RHI_Vertex_PosTexNorTanCompact>(const RHI_Shader_Type, const std::string&);
+    template void RHI_Shader::CompileAsync<RHI_Vertex_PosTexNorTanSkin>(const RHI_Shader_Type, const std::string&);
     //=========================================================================================================
 }
@@ -29,12 +29,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "RHI_Vertex.h"
 #include "RHI_Definition.h"
 #include "../Core/Spartan_Object.h"
+#include "../Core/StringId.h"
 //=================================
 
 namespace Spartan
 {
 	// Forward declarations
 	class Context;
+    class Task;
 
 	class SPARTAN_CLASS RHI_Shader : public Spartan_Object
 	{
@@ -60,6 +62,19 @@ namespace Spartan
         }
 
         void WaitForCompilation();
+        const auto& GetCompilationTask() const { return m_compilation_task; } // null once waited for, or if the compilation wasn't asynchronous
+
+        // Recompiles a copy of the shader in the background (the binary cache serves it if nothing it depends on changed) while this one
+        // stays in use, ApplyRecompilations() then swaps the result in, so a frame never sees a shader which is half way through compiling
+        void RecompileAsync();
+        bool IsRecompiling() const { return m_recompiling; }
+        static void ApplyRecompilations(); // the renderer calls this at the start of a frame, before any pass binds a shader
+
+        // Offline compilation, only fills the binary cache and creates no API resource (so it works without a device)
+        bool CompileToCache(const RHI_Shader_Type type, const std::string& file_path);
+        // Packs the cache files of shaders compiled with CompileToCache() into a single archive, which Compile() looks in first
+        static bool SaveCacheArchive(const std::string& shader_directory, const std::vector<std::shared_ptr<RHI_Shader>>& shaders);
+        static std::string GetCacheArchiveFilePath(const std::string& shader_directory);
 
 		// Properties
         void* GetResource()                 const									{ return m_resource; }
@@ -70,8 +85,10 @@ namespace Spartan
         bool IsCompiled()                   const									{ return m_compilation_state == Shader_Compilation_Succeeded; }
 		const std::string& GetName()        const									{ return m_name; }
 		void SetName(const std::string& name)										{ m_name = name; }
-		void AddDefine(const std::string& define, const std::string& value = "1")	{ m_defines[define] = value; }
+		void AddDefine(StringId define, const std::string& value = "1")				{ m_defines[define] = value; }
         auto& GetDefines()                  const                                   { return m_defines; }
+        bool IsInstanced()                  const                                   { static const StringId instanced("INSTANCED"); return m_defines.count(instanced) != 0; } // instanced vertex shaders read per-instance data
+        bool IsHalfPrecision()              const;                                  // HALF_PRECISION is defined as 1, the shader does its arithmetic in 16 bits
         const auto& GetFilePath()           const                                   { return m_file_path; }
         RHI_Shader_Type GetShaderStage()    const                                   { return m_shader_type; }
         const char* GetEntryPoint()         const;
@@ -82,18 +99,33 @@ namespace Spartan
 		std::shared_ptr<RHI_Device> m_rhi_device;
 
 	private:
-        // All compile functions resolve to this, and this is the underlying API implements
-		void* _Compile(const std::string& shader);
+        void CompileInternal(const std::string& shader);
+
+        // All compile functions resolve to these, and these are what the underlying API implements
+		bool _Compile(const std::string& shader, std::vector<std::byte>& bytecode);
+        void* _CreateResource(const std::vector<std::byte>& bytecode);
+        uint32_t _GetCompilerVersion() const;
 		void _Reflect(const RHI_Shader_Type shader_type, const uint32_t* ptr, uint32_t size);
 
+        // Binary cache, the bytecode and reflection of shader files is kept on disk, keyed by everything which affects the output
+        std::size_t ComputeCacheHash(const std::string& file_path) const;
+        std::string GetCacheFilePath(std::size_t hash) const;
+        bool LoadFromCache(std::size_t hash, std::vector<std::byte>& bytecode);
+        bool LoadFromCacheArchive(std::size_t hash, std::vector<std::byte>& bytecode);
+        bool LoadFromCacheFile(std::size_t hash, std::vector<std::byte>& bytecode);
+        void SaveToCache(std::size_t hash, const std::vector<std::byte>& bytecode) const;
+
 		std::string m_name;
 		std::string m_file_path;
-		std::unordered_map<std::string, std::string> m_defines;
+		std::unordered_map<StringId, std::string> m_defines;
 		std::vector<RHI_Descriptor> m_descriptors;
 		std::shared_ptr<RHI_InputLayout> m_input_layout;
 		Shader_Compilation_State m_compilation_state    = Shader_Compilation_Unknown;
         RHI_Shader_Type m_shader_type                   = RHI_Shader_Unknown;
         RHI_Vertex_Type m_vertex_type                   = RHI_Vertex_Type_Unknown;
+        std::shared_ptr<Task> m_compilation_task;
+        std::size_t m_cache_hash                        = 0;
+        bool m_recompiling                              = false;
 
 		// API 
 		void* m_resource = nullptr;
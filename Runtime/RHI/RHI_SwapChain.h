@@ -50,6 +50,10 @@ namespace Spartan
 		bool Resize(uint32_t width, uint32_t height, const bool force = false);
 		bool Present();
 
+        // Present mode (one of RHI_Present_Mode) and RHI_SwapChain_Low_Latency, the swapchain is re-created if needed
+        bool SetPresentMode(const uint32_t flags);
+        uint32_t GetPresentMode() const { return m_flags & (rhi_present_mode_mask | RHI_SwapChain_Low_Latency); }
+
         // Misc
         uint32_t GetWidth()                 const { return m_width; }
         uint32_t GetHeight()                const { return m_height; }
@@ -90,13 +94,19 @@ namespace Spartan
 		void* m_surface				        = nullptr;	
 		void* m_window_handle		        = nullptr;
         void* m_cmd_pool                    = nullptr;
+        void* m_frame_latency_waitable      = nullptr;
         bool m_image_acquired               = false;
         bool m_present                      = true;
+        bool m_recreate                     = false;
         uint32_t m_cmd_index                = 0;
         uint32_t m_image_index              = 0;
         RHI_Device* m_rhi_device            = nullptr;
         RHI_Image_Layout m_layout           = RHI_Image_Undefined;
         std::vector<std::shared_ptr<RHI_CommandList>> m_cmd_lists;
+
+        // Graphics queue timeline values of the last presented frames, before recording another frame the CPU waits for the oldest one
+        std::array<uint64_t, rhi_frames_in_flight_max> m_frame_timeline_values = {};
+        uint64_t m_frame_count = 0;
         std::array<void*, state_max_render_target_count> m_image_acquired_semaphore     = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
         std::array<void*, state_max_render_target_count> m_resource_view                = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
         std::array<void*, state_max_render_target_count> m_resource                     = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
@@ -119,13 +119,16 @@ namespace Spartan
 
 		m_data.clear();
 		m_data.shrink_to_fit();
-		m_load_state = LoadState_Started;
+		m_load_state        = LoadState_Started;
+        m_mip_count_file    = 0;
+        m_mip_resident      = 0;
 
 		// Load from disk
-		auto texture_data_loaded = false;		
+		auto texture_data_loaded = false;
+        unique_ptr<FileStream> file_mapped; // an engine texture is uploaded from its mapping, so it stays open until the gpu resource exists
 		if (FileSystem::IsEngineTextureFile(path)) // engine format (binary)
 		{
-			texture_data_loaded = LoadFromFile_NativeFormat(path);
+			texture_data_loaded = LoadFromFile_NativeFormat(path, file_mapped);
 		}	
 		else if (FileSystem::IsSupportedImageFile(path)) // foreign format (most known image formats)
 		{
@@ -140,10 +143,13 @@ namespace Spartan
 			return false;
 		}
 
-        m_mip_levels = static_cast<uint32_t>(m_data.size());
+        m_mip_levels = GetMipDataCount();
 
 		// Create GPU resource
-        if (!m_context->GetSubsystem<Renderer>()->GetRhiDevice()->IsInitialized() || !CreateResourceGpu())
+        const bool created = m_context->GetSubsystem<Renderer>()->GetRhiDevice()->IsInitialized() && CreateResourceGpu();
+        m_data_mapped.clear();
+        file_mapped.reset();
+        if (!created)
         {
             LOG_ERROR("Failed to create shader resource for \"%s\".", GetResourceFilePathNative().c_str());
             m_load_state = LoadState_Failed;
@@ -161,15 +167,11 @@ namespace Spartan
         // Compute memory usage
         {
             m_size_cpu = 0;
-            m_size_gpu = 0;
             for (uint8_t mip_index = 0; mip_index < m_mip_levels; mip_index++)
             {
-                const uint32_t mip_width  = m_width >> mip_index;
-                const uint32_t mip_height = m_height >> mip_index;
-
                 m_size_cpu += mip_index < m_data.size() ? m_data[mip_index].size() * sizeof(std::byte) : 0;
-                m_size_gpu += mip_width * mip_height * (m_bits_per_channel / 8);
             }
+            m_size_gpu = GetSizeGpu(m_mip_resident);
         }
 
 		return true;
@@ -186,6 +188,14 @@ namespace Spartan
 		return &m_data[index];
 	}
 
+    const std::byte* RHI_Texture::GetMipData(const uint32_t index) const
+    {
+        if (!m_data_mapped.empty())
+            return index < m_data_mapped.size() ? m_data_mapped[index] : nullptr;
+
+        return index < m_data.size() && !m_data[index].empty() ? m_data[index].data() : nullptr;
+    }
+
     vector<std::byte> RHI_Texture::GetMipmap(const uint32_t index)
     {
         vector<std::byte> data;
@@ -198,7 +208,7 @@ namespace Spartan
         // Else attempt to load the data
         else
         {
-            auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read);
+            auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read | FileStream_Mapped);
             if (file->IsOpen())
             {
                 auto byte_count = file->ReadAs<uint32_t>();
@@ -206,9 +216,17 @@ namespace Spartan
 
                 if (index < mip_count)
                 {
+                    // The mips before the requested one are skipped over in the mapping, only the requested one is copied
+                    uint32_t size = 0;
+                    const std::byte* mip = nullptr;
                     for (uint32_t i = 0; i <= index; i++)
                     {
-                        file->Read(&data);
+                        mip = file->ReadSpan<std::byte>(&size);
+                    }
+
+                    if (mip)
+                    {
+                        data.assign(mip, mip + size);
                     }
                 }
                 else
@@ -226,6 +244,127 @@ namespace Spartan
         return data;
     }
 
+    uint32_t RHI_Texture::GetMipInitial() const
+    {
+        if (!IsStreamed())
+            return 0;
+
+        const uint32_t mip_max = GetMipResidentMax();
+        uint32_t mip = 0;
+        while (mip < mip_max && ((m_width >> mip) > texture_streaming_mip_size_initial || (m_height >> mip) > texture_streaming_mip_size_initial))
+        {
+            mip++;
+        }
+
+        return mip;
+    }
+
+    uint32_t RHI_Texture::GetMipResidentMax() const
+    {
+        if (!IsStreamed())
+            return 0;
+
+        // The most detailed mip of a block compressed texture has to be made of whole blocks
+        uint32_t mip = m_mip_count_file - 1;
+        while (mip > 0 && IsBlockCompressed() && (((m_width >> mip) % 4) != 0 || ((m_height >> mip) % 4) != 0))
+        {
+            mip--;
+        }
+
+        return mip;
+    }
+
+    uint32_t RHI_Texture::GetRowPitch(const uint32_t width) const
+    {
+        if (const uint32_t block_size = rhi_format_block_size(m_format))
+            return ((width + 3) / 4) * block_size;
+
+        return width * GetBytesPerPixel();
+    }
+
+    uint64_t RHI_Texture::GetMipByteCount(const uint32_t width, const uint32_t height) const
+    {
+        const uint64_t rows = IsBlockCompressed() ? (height + 3) / 4 : height;
+        return GetRowPitch(width) * rows;
+    }
+
+    uint64_t RHI_Texture::GetSizeGpu(const uint32_t mip_resident) const
+    {
+        const uint32_t mip_count = IsStreamed() ? m_mip_count_file : m_mip_levels;
+
+        uint64_t size = 0;
+        for (uint32_t mip_index = mip_resident; mip_index < mip_count; mip_index++)
+        {
+            const uint64_t mip_width  = (m_width >> mip_index) != 0 ? m_width >> mip_index : 1;
+            const uint64_t mip_height = (m_height >> mip_index) != 0 ? m_height >> mip_index : 1;
+
+            size += GetMipByteCount(static_cast<uint32_t>(mip_width), static_cast<uint32_t>(mip_height)) * m_array_size;
+        }
+
+        return size;
+    }
+
+    void RHI_Texture::StreamingRequest(const uint32_t mip)
+    {
+        uint32_t mip_requested = m_mip_requested.load();
+        while (mip < mip_requested && !m_mip_requested.compare_exchange_weak(mip_requested, mip)) {}
+    }
+
+    bool RHI_Texture::StreamMips(uint32_t mip_resident)
+    {
+        if (!IsStreamed() || m_load_state != LoadState_Completed)
+            return false;
+
+        mip_resident = mip_resident < GetMipResidentMax() ? mip_resident : GetMipResidentMax();
+        if (mip_resident == m_mip_resident)
+            return true;
+
+        auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read | FileStream_Mapped);
+        if (!file->IsOpen())
+            return false;
+
+        // The mips which become resident are pointed to in the mapping, like when loading
+        file->ReadAs<uint32_t>(); // byte count
+        if (file->ReadAs<uint32_t>() != m_mip_count_file)
+        {
+            LOG_ERROR("\"%s\" has changed since it was loaded", GetResourceFilePathNative().c_str());
+            return false;
+        }
+
+        m_data_mapped.clear();
+        for (uint32_t mip_index = 0; mip_index < m_mip_count_file; mip_index++)
+        {
+            uint32_t size = 0;
+            const std::byte* mip = file->ReadSpan<std::byte>(&size);
+            if (!mip)
+            {
+                LOG_ERROR("\"%s\" is truncated", GetResourceFilePathNative().c_str());
+                m_data_mapped.clear();
+                return false;
+            }
+
+            if (mip_index >= mip_resident)
+            {
+                m_data_mapped.emplace_back(mip);
+            }
+        }
+
+        DestroyResourceGpu();
+        m_mip_resident  = mip_resident;
+        m_mip_levels    = GetMipDataCount();
+
+        const bool created = CreateResourceGpu();
+        m_data_mapped.clear();
+        m_size_gpu = created ? GetSizeGpu(m_mip_resident) : 0;
+        if (!created)
+        {
+            LOG_ERROR("Failed to stream mip %d of \"%s\"", mip_resident, GetResourceFilePathNative().c_str());
+            return false;
+        }
+
+        return true;
+    }
+
     bool RHI_Texture::LoadFromFile_ForeignFormat(const string& file_path, const bool generate_mipmaps)
 	{
 		// Load texture
@@ -239,9 +378,9 @@ namespace Spartan
 		return true;
 	}
 
-	bool RHI_Texture::LoadFromFile_NativeFormat(const string& file_path)
+	bool RHI_Texture::LoadFromFile_NativeFormat(const string& file_path, unique_ptr<FileStream>& file)
 	{
-		auto file = make_unique<FileStream>(file_path, FileStream_Read);
+		file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
 		if (!file->IsOpen())
 			return false;
 
@@ -252,11 +391,18 @@ namespace Spartan
 		auto byte_count = file->ReadAs<uint32_t>();
         const auto mip_count  = file->ReadAs<uint32_t>();
 
-		// Read bytes
-		m_data.resize(mip_count);
-		for (auto& mip : m_data)
+		// The mips are stored tightly packed, row after row, which is how they are uploaded, so they are pointed to instead of copied
+		m_data_mapped.resize(mip_count);
+		for (auto& mip : m_data_mapped)
 		{
-			file->Read(&mip);
+            uint32_t size = 0;
+			mip = file->ReadSpan<std::byte>(&size);
+            if (!mip)
+            {
+                LOG_ERROR("\"%s\" is truncated", file_path.c_str());
+                m_data_mapped.clear();
+                return false;
+            }
 		}
 
 		// Read properties
@@ -269,6 +415,13 @@ namespace Spartan
 		SetId(file->ReadAs<uint32_t>());
 		SetResourceFilePath(file->ReadAs<string>());
 
+        // Sampled textures with mips are streamed, they start out with their small mips only
+        const bool streamed = m_resource_type == Resource_Texture2d && m_array_size == 1 && mip_count > 1 &&
+            (m_flags & RHI_Texture_ShaderView) && !(m_flags & (RHI_Texture_UnorderedAccessView | RHI_Texture_RenderTargetView | RHI_Texture_DepthStencilView));
+        m_mip_count_file    = streamed ? mip_count : 0;
+        m_mip_resident      = GetMipInitial();
+        m_data_mapped.erase(m_data_mapped.begin(), m_data_mapped.begin() + m_mip_resident);
+
 		return true;
 	}
 
@@ -290,6 +443,12 @@ namespace Spartan
 			case RHI_Format_R32G32B32A32_Float:	    return 4;
             case RHI_Format_D32_Float:			    return 1;
             case RHI_Format_D32_Float_S8X24_Uint:   return 2;
+            case RHI_Format_BC4_Unorm:              return 1;
+            case RHI_Format_BC5_Unorm:              return 2;
+            case RHI_Format_BC6H_Uf16:              return 3;
+            case RHI_Format_BC7_Unorm:              return 4;
+            case RHI_Format_R16G16B16A16_Unorm:     return 4;
+            case RHI_Format_R8_Uint:                return 1;
 			default:						        return 0;
 		}
 	}
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <array>
+#include <atomic>
 #include "RHI_Viewport.h"
 #include "RHI_Definition.h"
 #include "../Resource/IResource.h"
@@ -31,6 +32,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
+    class FileStream;
+
+    // An engine texture with mips only uploads the ones which are this big (or smaller) when it loads, the renderer streams in the rest
+    constexpr uint32_t texture_streaming_mip_size_initial = 256;
+
 	enum RHI_Texture_Flags : uint16_t
 	{
 		RHI_Texture_ShaderView			        = 1 << 0,
@@ -40,7 +46,9 @@ namespace Spartan
         RHI_Texture_DepthStencilViewReadOnly    = 1 << 4,
         RHI_Texture_Grayscale                   = 1 << 5,
         RHI_Texture_Transparent                 = 1 << 6,
-        RHI_Texture_GenerateMipsWhenLoading     = 1 << 7
+        RHI_Texture_GenerateMipsWhenLoading     = 1 << 7,
+        RHI_Texture_Srgb                        = 1 << 8, // color is gamma encoded (the shaders decode it), mips are filtered in linear space
+        RHI_Texture_ShadingRate                 = 1 << 9  // can be the shading rate image of a render pass (see RHI_PipelineState)
 	};
 
     enum RHI_Shader_View_Type : uint8_t
@@ -73,6 +81,9 @@ namespace Spartan
 		auto GetTransparency() const									{ return m_flags & RHI_Texture_Transparent; }
 		void SetTransparency(const bool is_transparent)					{ is_transparent ? m_flags |= RHI_Texture_Transparent : m_flags &= ~RHI_Texture_Transparent; }
 
+		auto GetSrgb() const											{ return m_flags & RHI_Texture_Srgb; }
+		void SetSrgb(const bool is_srgb)								{ is_srgb ? m_flags |= RHI_Texture_Srgb : m_flags &= ~RHI_Texture_Srgb; }
+
         uint32_t GetBitsPerChannel() const								{ return m_bits_per_channel; }
 		void SetBitsPerChannel(const uint32_t bits)						{ m_bits_per_channel = bits; }
         uint32_t GetBytesPerChannel() const                             { return m_bits_per_channel / 8; }
@@ -84,8 +95,17 @@ namespace Spartan
 		auto GetFormat() const											{ return m_format; }
 		void SetFormat(const RHI_Format format)							{ m_format = format; }
 
+        // The block compressed format the texture is stored in once it's imported (see ImageImporter), Undefined keeps it as is
+        RHI_Format GetCompression() const                               { return m_format_compressed; }
+        void SetCompression(const RHI_Format format)                    { m_format_compressed = format; }
+        bool IsBlockCompressed() const                                  { return rhi_format_block_size(m_format) != 0; }
+		static uint32_t GetChannelCountFromFormat(RHI_Format format);
+        // The bytes of a row of pixels, or a row of blocks for block compressed formats
+        uint32_t GetRowPitch(uint32_t width) const;
+        uint64_t GetMipByteCount(uint32_t width, uint32_t height) const;
+
 		// Data
-        bool HasData() const                                            { return !m_data.empty(); }
+        bool HasData() const                                            { return !m_data.empty() || !m_data_mapped.empty(); }
 		const auto& GetData() const										{ return m_data; }		
         void SetData(const std::vector<std::vector<std::byte>>& data)   { m_data = data; }
         auto AddMipmap()                                                { return &m_data.emplace_back(std::vector<std::byte>()); }
@@ -93,6 +113,26 @@ namespace Spartan
         uint32_t GetMiplevels() const                                   { return m_mip_levels; }
         std::vector<std::byte>* GetData(uint32_t mipmap_index);
         std::vector<std::byte> GetMipmap(uint32_t index);
+        // The data which the gpu resource is created from, while an engine texture loads it points into the mapped file (see LoadFromFile_NativeFormat())
+        const std::byte* GetMipData(uint32_t index) const;
+        uint32_t GetMipDataCount() const                                { return static_cast<uint32_t>(m_data_mapped.empty() ? m_data.size() : m_data_mapped.size()); }
+
+        // Streaming, the gpu resource of a streamed texture holds the mips from the resident one down (its mip 0), the width, the height
+        // and GetMipmap() keep referring to the full texture. The renderer picks the resident mip (see Renderer::TextureStreaming()).
+        bool IsStreamed() const                                         { return m_mip_count_file > 1; }
+        uint32_t GetMipCountFile() const                                { return m_mip_count_file; }
+        uint32_t GetMipResident() const                                 { return m_mip_resident; }
+        uint32_t GetMipInitial() const;
+        uint32_t GetMipResidentMax() const;
+        uint32_t GetWidthResident() const                               { return (m_width >> m_mip_resident) != 0 ? m_width >> m_mip_resident : 1; }
+        uint32_t GetHeightResident() const                              { return (m_height >> m_mip_resident) != 0 ? m_height >> m_mip_resident : 1; }
+        uint64_t GetSizeGpu(uint32_t mip_resident) const;
+        // The most detailed mip something on screen needs, the lowest request since the last take wins
+        void StreamingRequest(uint32_t mip);
+        uint32_t StreamingRequestTake()                                 { return m_mip_requested.exchange(mip_requested_none); }
+        // Re-creates the gpu resource from the file's mips, it can't be in use (the renderer streams before it records)
+        bool StreamMips(uint32_t mip_resident);
+        static constexpr uint32_t mip_requested_none = 0xFFFFFFFF;
 
         // Binding type
         bool IsSampled()                    const { return m_flags & RHI_Texture_ShaderView; }
@@ -120,27 +160,33 @@ namespace Spartan
         void  Set_Resource(void* resource)                                        { m_resource = resource; }
         void* Get_Resource_View(const uint32_t i = 0)                       const { return m_resource_view[i]; }
         void* Get_Resource_View_UnorderedAccess()	                        const { return m_resource_view_unorderedAccess; }
+        // Render target and depth stencil views are per array slice, arrays also have one at index GetArraySize() which covers all of them (layered rendering)
         void* Get_Resource_View_DepthStencil(const uint32_t i = 0)          const { return i < m_resource_view_depthStencil.size() ? m_resource_view_depthStencil[i] : nullptr; }
         void* Get_Resource_View_DepthStencilReadOnly(const uint32_t i = 0)  const { return i < m_resource_view_depthStencilReadOnly.size() ? m_resource_view_depthStencilReadOnly[i] : nullptr; }
         void* Get_Resource_View_RenderTarget(const uint32_t i = 0)          const { return i < m_resource_view_renderTarget.size() ? m_resource_view_renderTarget[i] : nullptr; }
 
 	protected:
-		bool LoadFromFile_NativeFormat(const std::string& file_path);
+		bool LoadFromFile_NativeFormat(const std::string& file_path, std::unique_ptr<FileStream>& file);
 		bool LoadFromFile_ForeignFormat(const std::string& file_path, bool generate_mipmaps);
-		static uint32_t GetChannelCountFromFormat(RHI_Format format);
         virtual bool CreateResourceGpu() { LOG_ERROR("Function not implemented by API"); return false; }
+        virtual void DestroyResourceGpu() {}
 
 		uint32_t m_bits_per_channel = 8;
 		uint32_t m_width		    = 0;
 		uint32_t m_height		    = 0;
 		uint32_t m_channel_count	= 4;
         uint32_t m_array_size       = 1;
-        uint32_t m_mip_levels       = 1;
+        uint32_t m_mip_levels       = 1; // of the gpu resource
+        uint32_t m_mip_count_file   = 0; // of a streamed texture's file
+        uint32_t m_mip_resident     = 0;
+        std::atomic<uint32_t> m_mip_requested = mip_requested_none;
 		RHI_Format m_format		    = RHI_Format_Undefined;
+        RHI_Format m_format_compressed = RHI_Format_Undefined;
         RHI_Image_Layout m_layout   = RHI_Image_Undefined;
         uint16_t m_flags	        = 0;
 		RHI_Viewport m_viewport;
 		std::vector<std::vector<std::byte>> m_data;
+        std::vector<const std::byte*> m_data_mapped;
 		std::shared_ptr<RHI_Device> m_rhi_device;
 
         // API
@@ -22,9 +22,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ===============
+#include <cstring>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
+#include "../Math/Matrix.h"
 //==========================
 
 namespace Spartan
@@ -33,6 +35,7 @@ namespace Spartan
 
 	struct RHI_Vertex_Pos
 	{
+		RHI_Vertex_Pos() = default;
 		RHI_Vertex_Pos(const Math::Vector3& position)
 		{
 			this->pos[0] = position.x;
@@ -127,11 +130,106 @@ namespace Spartan
 		float tan[3] = { 0 };
 	};
 
+	// A quantized RHI_Vertex_PosTexNorTan (20 bytes instead of 44), for models which opt into it.
+	// The position is normalized to the bounds of the model (which shaders scale back with the object buffer),
+	// the uv is two halfs and the normal and the tangent are octahedral, in halfs as well.
+	struct RHI_Vertex_PosTexNorTanCompact
+	{
+		RHI_Vertex_PosTexNorTanCompact() = default;
+		RHI_Vertex_PosTexNorTanCompact(const RHI_Vertex_PosTexNorTan& vertex, const Math::Vector3& position_min, const Math::Vector3& position_scale_inv)
+		{
+			const float position[3]		= { vertex.pos[0] - position_min.x, vertex.pos[1] - position_min.y, vertex.pos[2] - position_min.z };
+			const float scale_inv[3]	= { position_scale_inv.x, position_scale_inv.y, position_scale_inv.z };
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				this->pos[i] = static_cast<uint16_t>(Math::Helper::Saturate(position[i] * scale_inv[i]) * 65535.0f + 0.5f);
+			}
+
+			this->tex[0] = Math::Helper::FloatToHalf(vertex.tex[0]);
+			this->tex[1] = Math::Helper::FloatToHalf(vertex.tex[1]);
+
+			EncodeOctahedral(vertex.nor, this->nor);
+			EncodeOctahedral(vertex.tan, this->tan);
+		}
+
+		uint16_t pos[4] = { 0 }; // the fourth is padding
+		uint16_t tex[2] = { 0 };
+		uint16_t nor[2] = { 0 };
+		uint16_t tan[2] = { 0 };
+
+	private:
+		// Projects the direction onto an octahedron and unfolds its lower half over the upper one
+		static void EncodeOctahedral(const float direction[3], uint16_t encoded[2])
+		{
+			const float length = Math::Helper::Abs(direction[0]) + Math::Helper::Abs(direction[1]) + Math::Helper::Abs(direction[2]);
+			float x = length > 0.0f ? direction[0] / length : 0.0f;
+			float y = length > 0.0f ? direction[1] / length : 0.0f;
+			if (direction[2] < 0.0f)
+			{
+				const float x_folded = (1.0f - Math::Helper::Abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+				const float y_folded = (1.0f - Math::Helper::Abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+				x = x_folded;
+				y = y_folded;
+			}
+
+			encoded[0] = Math::Helper::FloatToHalf(x);
+			encoded[1] = Math::Helper::FloatToHalf(y);
+		}
+	};
+
+	// The bones which a vertex of a skinned model follows, up to four of them with weights (in 255ths) which add up to 255.
+	// A vertex without weights isn't skinned.
+	struct RHI_Vertex_Skin
+	{
+		uint8_t bones[4]	= { 0 }; // into the bones of the renderable
+		uint8_t weights[4]	= { 0 };
+	};
+
+	// A RHI_Vertex_PosTexNorTan along with its RHI_Vertex_Skin, what the gpu gets for skinned models
+	struct RHI_Vertex_PosTexNorTanSkin
+	{
+		RHI_Vertex_PosTexNorTanSkin() = default;
+		RHI_Vertex_PosTexNorTanSkin(const RHI_Vertex_PosTexNorTan& vertex, const RHI_Vertex_Skin& skin)
+		{
+			memcpy(this->pos, vertex.pos, sizeof(this->pos));
+			memcpy(this->tex, vertex.tex, sizeof(this->tex));
+			memcpy(this->nor, vertex.nor, sizeof(this->nor));
+			memcpy(this->tan, vertex.tan, sizeof(this->tan));
+			memcpy(this->bones, skin.bones, sizeof(this->bones));
+			memcpy(this->weights, skin.weights, sizeof(this->weights));
+		}
+
+		float pos[3]		= { 0 };
+		float tex[2]		= { 0 };
+		float nor[3]		= { 0 };
+		float tan[3]		= { 0 };
+		uint8_t bones[4]	= { 0 };
+		uint8_t weights[4]	= { 0 };
+	};
+
+	// Per-instance data of instanced draws, it's streamed from the instance buffer binding
+	struct RHI_Vertex_Instance
+	{
+		RHI_Vertex_Instance() = default;
+		RHI_Vertex_Instance(const Math::Matrix& transform, const Math::Matrix& wvp_previous)
+		{
+			memcpy(this->transform,		transform.Data(),		sizeof(this->transform));
+			memcpy(this->wvp_previous,	wvp_previous.Data(),	sizeof(this->wvp_previous));
+		}
+
+		float transform[16]		= { 0 }; // column-major, like the matrices in the constant buffers
+		float wvp_previous[16]	= { 0 }; // velocity
+	};
+
 	static_assert(std::is_trivially_copyable<RHI_Vertex_Pos>::value,			"RHI_Vertex_Pos is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_PosTex>::value,			"RHI_Vertex_PosTex is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_PosCol>::value,			"RHI_Vertex_PosCol is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_Pos2dTexCol8>::value,	"RHI_Vertex_Pos2dTexCol8 is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_PosTexNorTan>::value,	"RHI_Vertex_PosTexNorTan is not trivially copyable");
+	static_assert(std::is_trivially_copyable<RHI_Vertex_PosTexNorTanCompact>::value,	"RHI_Vertex_PosTexNorTanCompact is not trivially copyable");
+	static_assert(std::is_trivially_copyable<RHI_Vertex_Skin>::value,			"RHI_Vertex_Skin is not trivially copyable");
+	static_assert(std::is_trivially_copyable<RHI_Vertex_PosTexNorTanSkin>::value,	"RHI_Vertex_PosTexNorTanSkin is not trivially copyable");
+	static_assert(std::is_trivially_copyable<RHI_Vertex_Instance>::value,		"RHI_Vertex_Instance is not trivially copyable");
 
 	enum RHI_Vertex_Type
 	{
@@ -140,6 +238,8 @@ namespace Spartan
 		RHI_Vertex_Type_PositionColor,
 		RHI_Vertex_Type_PositionTexture,
 		RHI_Vertex_Type_PositionTextureNormalTangent,
+		RHI_Vertex_Type_PositionTextureNormalTangentCompact,
+		RHI_Vertex_Type_PositionTextureNormalTangentSkin,
 		RHI_Vertex_Type_Position2dTextureColor8
 	};
 
@@ -151,4 +251,6 @@ namespace Spartan
 	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosCol>()			{ return RHI_Vertex_Type_PositionColor; }
 	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_Pos2dTexCol8>()	{ return RHI_Vertex_Type_Position2dTextureColor8; }
 	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosTexNorTan>()	{ return RHI_Vertex_Type_PositionTextureNormalTangent; }
+	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosTexNorTanCompact>()	{ return RHI_Vertex_Type_PositionTextureNormalTangentCompact; }
+	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosTexNorTanSkin>()	{ return RHI_Vertex_Type_PositionTextureNormalTangentSkin; }
 }
@@ -39,6 +39,65 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace _Vulkan_CommandList
+    {
+        constexpr uint32_t query_invalid = numeric_limits<uint32_t>::max();
+
+        // The order of the values of a query follows the order of the bits
+        constexpr VkQueryPipelineStatisticFlags statistics_flags =
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT       |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT       |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT            |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT             |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT     |
+            VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+        constexpr uint32_t statistics_count = 6;
+
+        static void* query_pool_create(RHI_Context* rhi_context, const VkQueryType type, const uint32_t count)
+        {
+            VkQueryPoolCreateInfo query_pool_create_info    = {};
+            query_pool_create_info.sType                    = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            query_pool_create_info.queryType                = type;
+            query_pool_create_info.queryCount               = count;
+            query_pool_create_info.pipelineStatistics       = type == VK_QUERY_TYPE_PIPELINE_STATISTICS ? statistics_flags : 0;
+
+            VkQueryPool query_pool = nullptr;
+            if (!vulkan_utility::error::check(vkCreateQueryPool(rhi_context->device, &query_pool_create_info, nullptr, &query_pool)))
+                return nullptr;
+
+            return static_cast<void*>(query_pool);
+        }
+
+        static void query_pool_destroy(RHI_Context* rhi_context, void*& query_pool)
+        {
+            if (!query_pool)
+                return;
+
+            vkDestroyQueryPool(rhi_context->device, static_cast<VkQueryPool>(query_pool), nullptr);
+            query_pool = nullptr;
+        }
+
+        // Reads back the first count queries, the GPU is expected to be done with them
+        static void query_pool_read(RHI_Context* rhi_context, void* query_pool, const uint32_t count, const uint32_t values_per_query, vector<uint64_t>& values)
+        {
+            if (!query_pool || count == 0)
+                return;
+
+            const size_t stride = sizeof(uint64_t) * values_per_query;
+
+            vkGetQueryPoolResults(
+                rhi_context->device,                // device
+                static_cast<VkQueryPool>(query_pool),// queryPool
+                0,                                  // firstQuery
+                count,                              // queryCount
+                count * stride,                     // dataSize
+                values.data(),                      // pData
+                stride,                             // stride
+                VK_QUERY_RESULT_64_BIT              // flags
+            );
+        }
+    }
+
     RHI_CommandList::RHI_CommandList(uint32_t index, RHI_SwapChain* swap_chain, Context* context)
 	{
         m_swap_chain        = swap_chain;
@@ -62,18 +121,17 @@ namespace Spartan
         vulkan_utility::semaphore::create(m_processed_semaphore);
         vulkan_utility::debug::set_name(static_cast<VkSemaphore>(m_processed_semaphore), "cmd_buffer_processed");
 
-        // Query pool
+        // Query pools
         if (rhi_context->profiler)
         {
-            VkQueryPoolCreateInfo query_pool_create_info    = {};
-            query_pool_create_info.sType                    = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
-            query_pool_create_info.queryType                = VK_QUERY_TYPE_TIMESTAMP;
-            query_pool_create_info.queryCount               = m_max_timestamps;
-
-            auto query_pool = reinterpret_cast<VkQueryPool*>(&m_query_pool);
-            vulkan_utility::error::check(vkCreateQueryPool(rhi_context->device, &query_pool_create_info, nullptr, query_pool));
+            m_query_pool = _Vulkan_CommandList::query_pool_create(rhi_context, VK_QUERY_TYPE_TIMESTAMP, m_timestamp_capacity);
+            m_timestamps.assign(m_timestamp_capacity, 0);
 
-            m_timestamps.fill(0);
+            if (rhi_context->device_features.pipelineStatisticsQuery)
+            {
+                m_query_pool_statistics = _Vulkan_CommandList::query_pool_create(rhi_context, VK_QUERY_TYPE_PIPELINE_STATISTICS, m_statistics_capacity);
+                m_statistics.assign(m_statistics_capacity * _Vulkan_CommandList::statistics_count, 0);
+            }
         }
 	}
 
@@ -91,12 +149,9 @@ namespace Spartan
         // Command buffer
         vulkan_utility::command_buffer::destroy(m_swap_chain->GetCmdPool(), m_cmd_buffer);
 
-        // Query pool
-        if (m_query_pool)
-        {
-            vkDestroyQueryPool(rhi_context->device, static_cast<VkQueryPool>(m_query_pool), nullptr);
-            m_query_pool = nullptr;
-        }
+        // Query pools
+        _Vulkan_CommandList::query_pool_destroy(rhi_context, m_query_pool);
+        _Vulkan_CommandList::query_pool_destroy(rhi_context, m_query_pool_statistics);
 	}
 
     bool RHI_CommandList::Begin()
@@ -110,31 +165,38 @@ namespace Spartan
 
         // Get queries
         {
-            if (m_rhi_device->GetContextRhi()->profiler)
+            RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+            if (rhi_context->profiler)
             {
-                if (m_query_pool)
+                _Vulkan_CommandList::query_pool_read(rhi_context, m_query_pool, m_timestamp_index, 1, m_timestamps);
+                _Vulkan_CommandList::query_pool_read(rhi_context, m_query_pool_statistics, m_statistics_index, _Vulkan_CommandList::statistics_count, m_statistics);
+
+                // The last recording ran out of queries and the GPU is done with the pools, so they can grow
+                if (m_timestamp_overflow && m_query_pool)
                 {
-                    if (m_timestamp_index != 0)
-                    {
-                        const uint32_t query_count      = m_timestamp_index * 2;
-                        const size_t stride             = sizeof(uint64_t);
-                        const VkQueryResultFlags flags  = VK_QUERY_RESULT_64_BIT;
-
-                        vkGetQueryPoolResults(
-                            m_rhi_device->GetContextRhi()->device,  // device
-                            static_cast<VkQueryPool>(m_query_pool), // queryPool
-                            0,                                      // firstQuery
-                            query_count,                            // queryCount
-                            query_count * stride,                   // dataSize
-                            m_timestamps.data(),                    // pData
-                            stride,                                 // stride
-                            flags                                   // flags
-                        );
-                    }
+                    _Vulkan_CommandList::query_pool_destroy(rhi_context, m_query_pool);
+                    m_timestamp_capacity *= 2;
+                    m_query_pool = _Vulkan_CommandList::query_pool_create(rhi_context, VK_QUERY_TYPE_TIMESTAMP, m_timestamp_capacity);
+                    m_timestamps.resize(m_timestamp_capacity, 0);
+                    LOG_INFO("Timestamp query pool has grown to %d queries", m_timestamp_capacity);
+                }
+
+                if (m_statistics_overflow && m_query_pool_statistics)
+                {
+                    _Vulkan_CommandList::query_pool_destroy(rhi_context, m_query_pool_statistics);
+                    m_statistics_capacity *= 2;
+                    m_query_pool_statistics = _Vulkan_CommandList::query_pool_create(rhi_context, VK_QUERY_TYPE_PIPELINE_STATISTICS, m_statistics_capacity);
+                    m_statistics.resize(m_statistics_capacity * _Vulkan_CommandList::statistics_count, 0);
+                    LOG_INFO("Pipeline statistics query pool has grown to %d queries", m_statistics_capacity);
                 }
             }
 
-            m_timestamp_index = 0;
+            m_timestamp_index       = 0;
+            m_timestamp_overflow    = false;
+            m_statistics_index      = 0;
+            m_statistics_overflow   = false;
+            m_statistics_active     = false;
         }
 
         if (m_cmd_state != RHI_Cmd_List_Idle)
@@ -149,7 +211,15 @@ namespace Spartan
         if (!vulkan_utility::error::check(vkBeginCommandBuffer(static_cast<VkCommandBuffer>(m_cmd_buffer), &begin_info)))
             return false;
 
-        vkCmdResetQueryPool(static_cast<VkCommandBuffer>(m_cmd_buffer), static_cast<VkQueryPool>(m_query_pool), 0, m_max_timestamps);
+        if (m_query_pool)
+        {
+            vkCmdResetQueryPool(static_cast<VkCommandBuffer>(m_cmd_buffer), static_cast<VkQueryPool>(m_query_pool), 0, m_timestamp_capacity);
+        }
+
+        if (m_query_pool_statistics)
+        {
+            vkCmdResetQueryPool(static_cast<VkCommandBuffer>(m_cmd_buffer), static_cast<VkQueryPool>(m_query_pool_statistics), 0, m_statistics_capacity);
+        }
 
         m_cmd_state = RHI_Cmd_List_Recording;
         m_flushed   = false;
@@ -164,6 +234,9 @@ namespace Spartan
             return true;
         }
 
+        // Textures which were bound but never drawn with are already tracked in their new layout
+        FlushTransitions();
+
         if (!vulkan_utility::error::check(vkEndCommandBuffer(static_cast<VkCommandBuffer>(m_cmd_buffer))))
             return false;
 
@@ -208,15 +281,21 @@ namespace Spartan
             signal_semaphore    = m_processed_semaphore;
         }
         
-        vulkan_utility::fence::reset(m_processed_fence);
+        // With a timeline the submission is tracked by the value it signals, otherwise by the fence of the command list
+        const bool timeline = m_rhi_device->Queue_HasTimeline();
+        if (!timeline)
+        {
+            vulkan_utility::fence::reset(m_processed_fence);
+        }
 
         if (!m_rhi_device->Queue_Submit(
-            RHI_Queue_Graphics,                             // queue
-            static_cast<VkCommandBuffer>(m_cmd_buffer),     // cmd buffer
-            wait_semaphore,                                 // wait semaphore
-            signal_semaphore,                               // signal semaphore
-            m_processed_fence,                              // signal fence
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)  // wait flags
+            RHI_Queue_Graphics,                                 // queue
+            static_cast<VkCommandBuffer>(m_cmd_buffer),         // cmd buffer
+            wait_semaphore,                                     // wait semaphore
+            signal_semaphore,                                   // signal semaphore
+            timeline ? nullptr : m_processed_fence,             // signal fence
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,      // wait flags
+            timeline ? &m_timeline_value : nullptr)             // timeline value
         )
         return false;
 
@@ -229,10 +308,11 @@ namespace Spartan
     {
         if (m_cmd_state == RHI_Cmd_List_Pending)
         {
-            if (!vulkan_utility::fence::wait(m_processed_fence))
+            const bool waited = m_rhi_device->Queue_HasTimeline() ? m_rhi_device->Queue_WaitValue(RHI_Queue_Graphics, m_timeline_value) : vulkan_utility::fence::wait(m_processed_fence);
+            if (!waited)
                 return false;
 
-            m_descriptor_cache->GrowIfNeeded();
+            m_descriptor_cache->ResetIfNeeded();
             m_cmd_state = RHI_Cmd_List_Idle;
         }
 
@@ -266,7 +346,11 @@ namespace Spartan
             m_pipeline = m_pipeline_cache->GetPipeline(this, pipeline_state, m_descriptor_cache->GetResource_DescriptorSetLayout());
             if (!m_pipeline)
             {
-                LOG_ERROR("Failed to acquire appropriate pipeline");
+                // A pipeline which compiles in the background is expected to be missing for a few frames
+                if (!pipeline_state.compile_async)
+                {
+                    LOG_ERROR("Failed to acquire appropriate pipeline");
+                }
                 return false;
             }
 
@@ -280,8 +364,9 @@ namespace Spartan
         // Shader resources
         {
             // If the pipeline changed, resources have to be set again
-            m_vertex_buffer_id  = 0;
-            m_index_buffer_id   = 0;
+            m_vertex_buffer_id      = 0;
+            m_instance_buffer_id    = 0;
+            m_index_buffer_id       = 0;
 
             // Vulkan doesn't have a persistent state so global resources have to be set
             m_renderer->SetGlobalSamplersAndConstantBuffers(this);
@@ -295,8 +380,17 @@ namespace Spartan
         // Render pass
         if (m_render_pass_active)
         {
-            vkCmdEndRenderPass(static_cast<VkCommandBuffer>(m_cmd_buffer));
-            m_render_pass_active = false;
+            if (m_render_pass_dynamic)
+            {
+                vulkan_utility::functions::end_rendering(static_cast<VkCommandBuffer>(m_cmd_buffer));
+            }
+            else
+            {
+                vkCmdEndRenderPass(static_cast<VkCommandBuffer>(m_cmd_buffer));
+            }
+
+            m_render_pass_active    = false;
+            m_render_pass_dynamic   = false;
         }
 
         // Profiling
@@ -389,7 +483,7 @@ namespace Spartan
         return true;
 	}
 
-    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset)
+    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count, const uint32_t instance_offset)
 	{
         if (m_cmd_state != RHI_Cmd_List_Recording)
         {
@@ -404,10 +498,10 @@ namespace Spartan
 		vkCmdDrawIndexed(
             static_cast<VkCommandBuffer>(m_cmd_buffer), // commandBuffer
             index_count,                                // indexCount
-            1,                                          // instanceCount
+            instance_count,                             // instanceCount
             index_offset,                               // firstIndex
             vertex_offset,                              // vertexOffset
-            0                                           // firstInstance
+            instance_offset                             // firstInstance
         );
 
         m_profiler->m_rhi_draw_calls++;
@@ -493,6 +587,33 @@ namespace Spartan
         m_vertex_buffer_offset  = offset;
 	}
 
+    void RHI_CommandList::SetBufferInstance(const RHI_VertexBuffer* buffer, const uint64_t offset /*= 0*/)
+	{
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return;
+        }
+
+        if (m_instance_buffer_id == buffer->GetId() && m_instance_buffer_offset == offset)
+            return;
+
+		VkBuffer vertex_buffers[]	= { static_cast<VkBuffer>(buffer->GetResource()) };
+		VkDeviceSize offsets[]		= { offset };
+
+		vkCmdBindVertexBuffers(
+            static_cast<VkCommandBuffer>(m_cmd_buffer), // commandBuffer
+            rhi_binding_instance,                       // firstBinding
+            1,                                          // bindingCount
+            vertex_buffers,                             // pBuffers
+            offsets                                     // pOffsets
+        );
+
+        m_profiler->m_rhi_bindings_buffer_vertex++;
+        m_instance_buffer_id        = buffer->GetId();
+        m_instance_buffer_offset    = offset;
+	}
+
 	void RHI_CommandList::SetBufferIndex(const RHI_IndexBuffer* buffer, const uint64_t offset /*= 0*/)
 	{
         if (m_cmd_state != RHI_Cmd_List_Recording)
@@ -528,6 +649,33 @@ namespace Spartan
         return m_descriptor_cache->SetConstantBuffer(slot, constant_buffer);
     }
 
+    bool RHI_CommandList::SetPushConstants(const void* data, const uint32_t size)
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return false;
+        }
+
+        if (!m_pipeline || size > rhi_max_push_constant_size)
+        {
+            LOG_ERROR("Invalid pipeline or size");
+            return false;
+        }
+
+        vkCmdPushConstants
+        (
+            static_cast<VkCommandBuffer>(m_cmd_buffer),                     // commandBuffer
+            static_cast<VkPipelineLayout>(m_pipeline->GetPipelineLayout()), // layout
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,      // stageFlags
+            0,                                                              // offset
+            size,                                                           // size
+            data                                                            // pValues
+        );
+
+        return true;
+    }
+
     void RHI_CommandList::SetSampler(const uint32_t slot, RHI_Sampler* sampler) const
     {
         if (m_cmd_state != RHI_Cmd_List_Recording)
@@ -579,10 +727,20 @@ namespace Spartan
 
             bool transition_required = target_layout != RHI_Image_Undefined;
 
-            // Transition
+            // Transition, deferred until the render pass begins (so that all the textures of a pass share a barrier)
             if (transition_required && !m_render_pass_active)
             {
-                texture->SetLayout(target_layout, this);
+                if (m_transitions_pending_count == m_max_batched_transitions)
+                {
+                    FlushTransitions();
+                }
+
+                m_transitions_pending_textures[m_transitions_pending_count]     = texture;
+                m_transitions_pending_layouts_old[m_transitions_pending_count]  = texture->GetLayout();
+                m_transitions_pending_layouts_new[m_transitions_pending_count]  = target_layout;
+                m_transitions_pending_count++;
+
+                texture->SetLayout(target_layout);
             }
             else if (transition_required && m_render_pass_active)
             {
@@ -595,6 +753,69 @@ namespace Spartan
         m_descriptor_cache->SetTexture(slot, texture);
     }
 
+    void RHI_CommandList::SetLayouts(RHI_Texture* const* textures, const RHI_Image_Layout* layouts, const uint32_t count)
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording)
+        {
+            LOG_WARNING("Can't record command");
+            return;
+        }
+
+        if (m_render_pass_active)
+        {
+            LOG_WARNING("Can't transition textures while a render pass is active");
+            return;
+        }
+
+        // The tracked layouts of pending transitions are already the new ones, so those barriers have to go first
+        FlushTransitions();
+
+        // Keep only the textures which need a transition
+        array<RHI_Texture*, m_max_batched_transitions> transition_textures;
+        array<RHI_Image_Layout, m_max_batched_transitions> transition_layouts;
+        uint32_t transition_count = 0;
+        for (uint32_t i = 0; i < count && transition_count < m_max_batched_transitions; i++)
+        {
+            RHI_Texture* texture = textures[i];
+
+            // The texture is most likely still initialising
+            if (!texture || texture->GetLayout() == RHI_Image_Undefined)
+                continue;
+
+            if (texture->GetLayout() == layouts[i])
+                continue;
+
+            transition_textures[transition_count]  = texture;
+            transition_layouts[transition_count]   = layouts[i];
+            transition_count++;
+        }
+
+        if (transition_count == 0)
+            return;
+
+        if (!vulkan_utility::image::set_layout(m_cmd_buffer, transition_textures.data(), transition_layouts.data(), transition_count))
+            return;
+
+        // The barrier is recorded, only the tracked layouts have to be updated
+        for (uint32_t i = 0; i < transition_count; i++)
+        {
+            transition_textures[i]->SetLayout(transition_layouts[i]);
+        }
+
+        m_profiler->m_rhi_pipeline_barriers++;
+    }
+
+    void RHI_CommandList::FlushTransitions()
+    {
+        if (m_transitions_pending_count == 0)
+            return;
+
+        vulkan_utility::image::set_layout(m_cmd_buffer, m_transitions_pending_textures.data(), m_transitions_pending_layouts_new.data(), m_transitions_pending_count, m_transitions_pending_layouts_old.data());
+        m_transitions_pending_count = 0;
+
+        m_profiler->m_rhi_pipeline_barriers++;
+    }
+
     uint32_t RHI_CommandList::Gpu_GetMemory(RHI_Device* rhi_device)
     {
         if (!rhi_device || !rhi_device->GetContextRhi())
@@ -624,8 +845,10 @@ namespace Spartan
         return static_cast<uint32_t>(device_memory_budget_properties.heapUsage[0] / 1024 / 1024); // MBs
     }
 
-    bool RHI_CommandList::Timestamp_Start(void* query_disjoint /*= nullptr*/, void* query_start /*= nullptr*/)
+    bool RHI_CommandList::Timestamp_Start(void* query_disjoint /*= nullptr*/, void* query_start /*= nullptr*/, uint32_t* index /*= nullptr*/)
     {
+        if (index) *index = _Vulkan_CommandList::query_invalid;
+
         if (m_cmd_state != RHI_Cmd_List_Recording)
         {
             LOG_WARNING("Can't record command");
@@ -638,13 +861,23 @@ namespace Spartan
         if (!m_query_pool)
             return false;
 
-        vkCmdWriteTimestamp(static_cast<VkCommandBuffer>(m_cmd_buffer), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, static_cast<VkQueryPool>(m_query_pool), m_timestamp_index++);
+        if (m_timestamp_index >= m_timestamp_capacity)
+        {
+            m_timestamp_overflow = true;
+            return false;
+        }
+
+        // The timestamp is written once all previous commands have started
+        if (index) *index = m_timestamp_index;
+        vkCmdWriteTimestamp(static_cast<VkCommandBuffer>(m_cmd_buffer), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, static_cast<VkQueryPool>(m_query_pool), m_timestamp_index++);
 
         return true;
     }
 
-    bool RHI_CommandList::Timestamp_End(void* query_disjoint /*= nullptr*/, void* query_end /*= nullptr*/)
+    bool RHI_CommandList::Timestamp_End(void* query_disjoint /*= nullptr*/, void* query_end /*= nullptr*/, uint32_t* index /*= nullptr*/)
     {
+        if (index) *index = _Vulkan_CommandList::query_invalid;
+
         if (m_cmd_state != RHI_Cmd_List_Recording)
         {
             LOG_WARNING("Can't record command");
@@ -657,21 +890,27 @@ namespace Spartan
         if (!m_query_pool)
             return false;
 
+        if (m_timestamp_index >= m_timestamp_capacity)
+        {
+            m_timestamp_overflow = true;
+            return false;
+        }
+
+        // The timestamp is written once all previous commands have finished
+        if (index) *index = m_timestamp_index;
         vkCmdWriteTimestamp(static_cast<VkCommandBuffer>(m_cmd_buffer), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, static_cast<VkQueryPool>(m_query_pool), m_timestamp_index++);
 
         return true;
     }
 
-    float RHI_CommandList::Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t pass_index)
+    float RHI_CommandList::Timestamp_GetDuration(void* query_disjoint, void* query_start, void* query_end, const uint32_t index_start, const uint32_t index_end)
     {
-        if (pass_index + 1 >= m_timestamps.size())
-        {
-            LOG_ERROR("Pass index out of timestamp array range");
+        // Either timestamp didn't fit in the query pool (it grows for the next frames)
+        if (index_start >= m_timestamps.size() || index_end >= m_timestamps.size())
             return 0.0f;
-        }
 
-        uint64_t start  = m_timestamps[pass_index];
-        uint64_t end    = m_timestamps[pass_index + 1];
+        uint64_t start  = m_timestamps[index_start];
+        uint64_t end    = m_timestamps[index_end];
 
         // If end has not been acquired yet (zero), early exit
         if (end < start)
@@ -683,6 +922,57 @@ namespace Spartan
         return duration_ms;
     }
 
+    bool RHI_CommandList::PipelineStatistics_Start(uint32_t* index)
+    {
+        *index = _Vulkan_CommandList::query_invalid;
+
+        if (m_cmd_state != RHI_Cmd_List_Recording || !m_query_pool_statistics)
+            return false;
+
+        // Queries of the same type can't be active at the same time, so only the innermost scope gets statistics
+        if (m_statistics_active)
+            return false;
+
+        if (m_statistics_index >= m_statistics_capacity)
+        {
+            m_statistics_overflow = true;
+            return false;
+        }
+
+        *index              = m_statistics_index++;
+        m_statistics_active = true;
+        vkCmdBeginQuery(static_cast<VkCommandBuffer>(m_cmd_buffer), static_cast<VkQueryPool>(m_query_pool_statistics), *index, 0);
+
+        return true;
+    }
+
+    bool RHI_CommandList::PipelineStatistics_End(const uint32_t index)
+    {
+        if (m_cmd_state != RHI_Cmd_List_Recording || !m_query_pool_statistics || !m_statistics_active || index >= m_statistics_capacity)
+            return false;
+
+        vkCmdEndQuery(static_cast<VkCommandBuffer>(m_cmd_buffer), static_cast<VkQueryPool>(m_query_pool_statistics), index);
+        m_statistics_active = false;
+
+        return true;
+    }
+
+    bool RHI_CommandList::PipelineStatistics_Get(const uint32_t index, RHI_Pipeline_Statistics& statistics) const
+    {
+        if ((index + 1) * _Vulkan_CommandList::statistics_count > m_statistics.size())
+            return false;
+
+        const uint64_t* values                  = &m_statistics[index * _Vulkan_CommandList::statistics_count];
+        statistics.input_assembly_primitives    = values[0];
+        statistics.vertex_invocations           = values[1];
+        statistics.clipping_invocations         = values[2];
+        statistics.clipping_primitives          = values[3];
+        statistics.pixel_invocations            = values[4];
+        statistics.compute_invocations          = values[5];
+
+        return true;
+    }
+
     bool RHI_CommandList::Gpu_QueryCreate(RHI_Device* rhi_device, void** query /*= nullptr*/, RHI_Query_Type type /*= RHI_Query_Timestamp*/)
     {
         // Not needed
@@ -720,7 +1010,7 @@ namespace Spartan
             if (m_profiler && pipeline_state->profile)
             {
                 m_profiler->TimeBlockStart(pipeline_state->pass_name, TimeBlock_Cpu, this);
-                m_profiler->TimeBlockStart(pipeline_state->pass_name, TimeBlock_Gpu, this);
+                m_profiler->TimeBlockStart(pipeline_state->pass_name, TimeBlock_Gpu, this, true);
             }
         }
 
@@ -731,6 +1021,38 @@ namespace Spartan
         }
     }
 
+    void RHI_CommandList::Scope_Begin(const char* name)
+    {
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+        if (rhi_context->profiler && m_profiler)
+        {
+            m_profiler->TimeBlockStart(name, TimeBlock_Cpu, this);
+            m_profiler->TimeBlockStart(name, TimeBlock_Gpu, this);
+        }
+
+        if (rhi_context->markers)
+        {
+            vulkan_utility::debug::marker_begin(static_cast<VkCommandBuffer>(m_cmd_buffer), name, Vector4::Zero);
+        }
+    }
+
+    void RHI_CommandList::Scope_End()
+    {
+        RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+
+        if (rhi_context->markers)
+        {
+            vulkan_utility::debug::marker_end(static_cast<VkCommandBuffer>(m_cmd_buffer));
+        }
+
+        if (rhi_context->profiler && m_profiler)
+        {
+            m_profiler->TimeBlockEnd(); // gpu
+            m_profiler->TimeBlockEnd(); // cpu
+        }
+    }
+
     void RHI_CommandList::Timeblock_End(const RHI_PipelineState* pipeline_state)
     {
         if (!pipeline_state)
@@ -761,23 +1083,28 @@ namespace Spartan
             return false;
         }
 
-        RHI_PipelineState* pipeline_state = m_pipeline->GetPipelineState();
-
-        if (!pipeline_state)
+        // The state the pass was begun with, the pipeline is shared by every state which renders to the same formats
+        if (!m_pipeline_state)
         {
             LOG_ERROR("There is no pipeline state");
             return false;
         }
 
-        if (!pipeline_state->GetRenderPass())
+        // The swapchain relies on the layout transitions of a render pass, so it always begins one
+        if (m_rhi_device->IsDynamicRenderingSupported() && !m_pipeline_state->render_target_swapchain)
+            return Deferred_BeginRendering();
+
+        void* render_pass = m_pipeline_state->GetRenderPass(m_rhi_device);
+        if (!render_pass)
         {
-            LOG_ERROR("Current pipeline has no render pass");
+            LOG_ERROR("Failed to get a render pass");
             return false;
         }
 
-        if (!pipeline_state->GetFrameBuffer())
+        void* frame_buffer = m_pipeline_state->GetFrameBuffer(m_rhi_device);
+        if (!frame_buffer)
         {
-            LOG_ERROR("Current pipeline has no frame buffer");
+            LOG_ERROR("Failed to get a frame buffer");
             return false;
         }
 
@@ -809,11 +1136,11 @@ namespace Spartan
         // Begin render pass
         VkRenderPassBeginInfo render_pass_info      = {};
         render_pass_info.sType                      = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        render_pass_info.renderPass                 = static_cast<VkRenderPass>(pipeline_state->GetRenderPass());
-        render_pass_info.framebuffer                = static_cast<VkFramebuffer>(pipeline_state->GetFrameBuffer());
+        render_pass_info.renderPass                 = static_cast<VkRenderPass>(render_pass);
+        render_pass_info.framebuffer                = static_cast<VkFramebuffer>(frame_buffer);
         render_pass_info.renderArea.offset          = { 0, 0 };
-        render_pass_info.renderArea.extent.width    = pipeline_state->GetWidth();
-        render_pass_info.renderArea.extent.height   = pipeline_state->GetHeight();
+        render_pass_info.renderArea.extent.width    = m_pipeline_state->GetWidth();
+        render_pass_info.renderArea.extent.height   = m_pipeline_state->GetHeight();
         render_pass_info.clearValueCount            = clear_value_count;
         render_pass_info.pClearValues               = clear_values.data();
         vkCmdBeginRenderPass(static_cast<VkCommandBuffer>(m_cmd_buffer), &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
@@ -822,6 +1149,85 @@ namespace Spartan
         return true;
     }
 
+    bool RHI_CommandList::Deferred_BeginRendering()
+    {
+        const auto load_op_color = [](const Vector4& color)
+        {
+            return color == state_color_dont_care ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : color == state_color_load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+        };
+
+        // Color
+        array<VkRenderingAttachmentInfoKHR, state_max_render_target_count> color_attachments = {};
+        uint32_t color_attachment_count = 0;
+        for (uint32_t i = 0; i < state_max_render_target_count; i++)
+        {
+            RHI_Texture* texture = m_pipeline_state->render_target_color_textures[i];
+            if (!texture)
+                continue;
+
+            const Vector4& color                        = m_pipeline_state->clear_color[i];
+            VkRenderingAttachmentInfoKHR& attachment    = color_attachments[color_attachment_count++];
+            attachment.sType                            = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+            attachment.imageView                        = static_cast<VkImageView>(texture->Get_Resource_View_RenderTarget(m_pipeline_state->render_target_color_texture_array_index));
+            attachment.imageLayout                      = vulkan_image_layout[texture->GetLayout()];
+            attachment.loadOp                           = load_op_color(color);
+            attachment.storeOp                          = VK_ATTACHMENT_STORE_OP_STORE;
+            attachment.clearValue.color                 = { {color.x, color.y, color.z, color.w} };
+        }
+
+        // Depth and stencil, the same view is given to both if the format has a stencil
+        VkRenderingAttachmentInfoKHR depth_attachment   = {};
+        VkRenderingAttachmentInfoKHR stencil_attachment = {};
+        RHI_Texture* depth_texture = m_pipeline_state->render_target_depth_texture;
+        if (depth_texture)
+        {
+            const float depth       = m_pipeline_state->clear_depth;
+            const uint32_t stencil  = m_pipeline_state->clear_stencil;
+
+            depth_attachment.sType                          = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+            depth_attachment.imageView                      = static_cast<VkImageView>(depth_texture->Get_Resource_View_DepthStencil(m_pipeline_state->render_target_depth_stencil_texture_array_index));
+            depth_attachment.imageLayout                    = vulkan_image_layout[depth_texture->GetLayout()];
+            depth_attachment.loadOp                         = depth == state_depth_dont_care ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : depth == state_depth_load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depth_attachment.storeOp                        = VK_ATTACHMENT_STORE_OP_STORE;
+            depth_attachment.clearValue.depthStencil        = { depth, stencil };
+
+            if (depth_texture->IsStencilFormat())
+            {
+                stencil_attachment          = depth_attachment;
+                stencil_attachment.loadOp   = stencil == state_stencil_dont_care ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : stencil == state_stencil_load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+                stencil_attachment.storeOp  = m_pipeline_state->depth_stencil_state->GetStencilWriteEnabled() ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            }
+        }
+
+        // Shading rate
+        VkRenderingFragmentShadingRateAttachmentInfoKHR shading_rate_attachment = {};
+        if (RHI_Texture* texture = m_pipeline_state->render_target_shading_rate_texture)
+        {
+            const uint32_t tile_size                                = m_rhi_device->GetShadingRateTileSize();
+            shading_rate_attachment.sType                           = VK_STRUCTURE_TYPE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR;
+            shading_rate_attachment.imageView                       = static_cast<VkImageView>(texture->Get_Resource_View_RenderTarget(0));
+            shading_rate_attachment.imageLayout                     = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR;
+            shading_rate_attachment.shadingRateAttachmentTexelSize  = { tile_size, tile_size };
+        }
+
+        VkRenderingInfoKHR rendering_info       = {};
+        rendering_info.sType                    = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+        rendering_info.pNext                    = m_pipeline_state->render_target_shading_rate_texture ? &shading_rate_attachment : nullptr;
+        rendering_info.renderArea.offset        = { 0, 0 };
+        rendering_info.renderArea.extent.width  = m_pipeline_state->GetWidth();
+        rendering_info.renderArea.extent.height = m_pipeline_state->GetHeight();
+        rendering_info.layerCount               = m_pipeline_state->GetLayerCount();
+        rendering_info.colorAttachmentCount     = color_attachment_count;
+        rendering_info.pColorAttachments        = color_attachments.data();
+        rendering_info.pDepthAttachment         = depth_texture ? &depth_attachment : nullptr;
+        rendering_info.pStencilAttachment       = depth_texture && depth_texture->IsStencilFormat() ? &stencil_attachment : nullptr;
+        vulkan_utility::functions::begin_rendering(static_cast<VkCommandBuffer>(m_cmd_buffer), &rendering_info);
+
+        m_render_pass_active    = true;
+        m_render_pass_dynamic   = true;
+        return true;
+    }
+
     bool RHI_CommandList::Deferred_BindDescriptorSet()
     {
         if (m_cmd_state != RHI_Cmd_List_Recording)
@@ -829,7 +1235,7 @@ namespace Spartan
 
         // Descriptor set != null, result = true    -> the descriptor set must be bound
         // Descriptor set == null, result = true    -> the descriptor set is already bound
-        // Descriptor set == null, result = false   -> a new descriptor was needed but we are out of memory (allocates next frame)
+        // Descriptor set == null, result = false   -> a new descriptor set was needed but it failed to allocate
 
         void* descriptor_set = nullptr;
         bool result = m_descriptor_cache->GetResource_DescriptorSet(descriptor_set);
@@ -868,6 +1274,21 @@ namespace Spartan
             vkCmdBindPipeline(static_cast<VkCommandBuffer>(m_cmd_buffer), VK_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline);
             m_profiler->m_rhi_bindings_pipeline++;
             m_pipeline_active = true;
+
+            // The viewport and scissor are dynamic in every pipeline, so the ones of the state are set here, states
+            // without a viewport leave it to SetViewport() (and states with a dynamic scissor to SetScissorRectangle())
+            if (m_pipeline_state->viewport.IsDefined())
+            {
+                SetViewport(m_pipeline_state->viewport);
+            }
+
+            if (!m_pipeline_state->dynamic_scissor)
+            {
+                const RHI_Viewport& viewport = m_pipeline_state->viewport;
+                SetScissorRectangle(m_pipeline_state->scissor.IsDefined() ? m_pipeline_state->scissor :
+                    viewport.IsDefined() ? Math::Rectangle(0.0f, 0.0f, viewport.width, viewport.height) :
+                    Math::Rectangle(0.0f, 0.0f, static_cast<float>(m_pipeline_state->GetWidth()), static_cast<float>(m_pipeline_state->GetHeight())));
+            }
         }
         else
         {
@@ -889,6 +1310,8 @@ namespace Spartan
         // Begin render pass
         if (!m_render_pass_active)
         {
+            FlushTransitions();
+
             if (!Deferred_BeginRenderPass())
             {
                 LOG_ERROR("Failed to begin render pass");
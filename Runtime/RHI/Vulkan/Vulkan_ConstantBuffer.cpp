@@ -35,9 +35,6 @@ namespace Spartan
 {
     void RHI_ConstantBuffer::_destroy()
     {
-        // Wait in case the buffer is still in use
-        m_rhi_device->Queue_WaitAll();
-
         // Unmap
         if (m_mapped)
         {
@@ -45,8 +42,8 @@ namespace Spartan
             m_mapped = nullptr;
         }
 
-        // Destroy
-        vulkan_utility::buffer::destroy(m_buffer);
+        // Destroy, once the frames in flight are done with it
+        vulkan_utility::buffer::destroy_deferred(m_buffer);
     }
 
     RHI_ConstantBuffer::RHI_ConstantBuffer(const std::shared_ptr<RHI_Device>& rhi_device, const string& name, bool is_dynamic /*= false*/)
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Implementation.h"
 #include "../RHI_DescriptorCache.h"
 #include "../RHI_Shader.h"
+#include "../../Profiling/Profiler.h"
 //=================================
 
 //= NAMESPACES =====
@@ -33,54 +34,88 @@ namespace Spartan
 {
     RHI_DescriptorCache::~RHI_DescriptorCache()
     {
-        if (m_descriptor_pool)
+        if (!m_descriptor_pools.empty())
         {
-            // Wait in case the buffer is still in use
-            m_rhi_device->Queue_WaitAll();
-
-            vkDestroyDescriptorPool(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorPool>(m_descriptor_pool), nullptr);
-            m_descriptor_pool = nullptr;
+            // Released once the frames in flight, which could still be using them, retire
+            RHI_Context* rhi_context = m_rhi_device->GetContextRhi();
+            m_rhi_device->DeletionQueue_Add([rhi_context, descriptor_pools = move(m_descriptor_pools)]()
+            {
+                for (void* descriptor_pool : descriptor_pools)
+                {
+                    vkDestroyDescriptorPool(rhi_context->device, static_cast<VkDescriptorPool>(descriptor_pool), nullptr);
+                }
+            });
+            m_descriptor_pools.clear();
         }
     }
 
-    void RHI_DescriptorCache::SetDescriptorSetCapacity(uint32_t descriptor_set_capacity)
+    void* RHI_DescriptorCache::AllocateDescriptorSet(void* descriptor_set_layout)
     {
         if (!m_rhi_device || !m_rhi_device->GetContextRhi())
         {
             LOG_ERROR_INVALID_INTERNALS();
-            return;
+            return nullptr;
         }
 
-        // Wait in case the pool is being used
-        m_rhi_device->Queue_WaitAll();
+        // If the current pool is full, continue in one of twice the size (the sets of the full one remain valid)
+        if (m_descriptor_pools.empty() || m_descriptor_pool_allocated == m_descriptor_pool_capacity)
+        {
+            const uint32_t capacity = m_descriptor_pools.empty() ? m_descriptor_pool_capacity : m_descriptor_pool_capacity * 2;
+            Profiler::EventAdd("Descriptor pool creation", to_string(capacity));
+            if (!CreateDescriptorPool(capacity))
+                return nullptr;
+
+            LOG_INFO("Capacity has been increased to %d elements", m_descriptor_set_count + m_descriptor_pool_capacity);
+        }
+
+        // Allocate info
+        VkDescriptorSetAllocateInfo allocate_info   = {};
+        allocate_info.sType                         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool                = static_cast<VkDescriptorPool>(m_descriptor_pools.back());
+        allocate_info.descriptorSetCount            = 1;
+        allocate_info.pSetLayouts                   = reinterpret_cast<VkDescriptorSetLayout*>(&descriptor_set_layout);
+
+        // Allocate
+        Profiler::EventAdd("Descriptor set allocation", to_string(m_descriptor_set_count));
+        void* descriptor_set = nullptr;
+        if (!vulkan_utility::error::check(vkAllocateDescriptorSets(m_rhi_device->GetContextRhi()->device, &allocate_info, reinterpret_cast<VkDescriptorSet*>(&descriptor_set))))
+            return nullptr;
 
-        // Destroy layouts (and descriptor sets)
-        m_descriptor_set_layouts.clear();
-        m_descriptor_layout_current = nullptr;
+        m_descriptor_pool_allocated++;
+        m_descriptor_set_count++;
 
-        // Destroy pool
-        if (m_descriptor_pool)
+        return descriptor_set;
+    }
+
+    void RHI_DescriptorCache::ResetDescriptorPools()
+    {
+        if (m_descriptor_pools.empty())
+            return;
+
+        // Keep the last (and biggest) pool, it's sized for what a frame needs
+        for (uint32_t i = 0; i < m_descriptor_pools.size() - 1; i++)
         {
-            vkDestroyDescriptorPool(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorPool>(m_descriptor_pool), nullptr);
-            m_descriptor_pool = nullptr;
+            vkDestroyDescriptorPool(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorPool>(m_descriptor_pools[i]), nullptr);
         }
+        m_descriptor_pools.erase(m_descriptor_pools.begin(), m_descriptor_pools.end() - 1);
 
-        // Re-allocate everything with double size
-        CreateDescriptorPool(descriptor_set_capacity);
+        // Releases all of its sets at once
+        vulkan_utility::error::check(vkResetDescriptorPool(m_rhi_device->GetContextRhi()->device, static_cast<VkDescriptorPool>(m_descriptor_pools.back()), 0));
+        m_descriptor_pool_allocated = 0;
     }
 
     bool RHI_DescriptorCache::CreateDescriptorPool(uint32_t descriptor_set_capacity)
     {
-        // Pool sizes
+        // Pool sizes (the maximums are per set, so the pool needs them for every set it can hand out)
         vector<VkDescriptorPoolSize> pool_sizes(4);
         pool_sizes[0].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        pool_sizes[0].descriptorCount   = RHI_Context::descriptor_max_constant_buffers;
+        pool_sizes[0].descriptorCount   = RHI_Context::descriptor_max_constant_buffers * descriptor_set_capacity;
         pool_sizes[1].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        pool_sizes[1].descriptorCount   = RHI_Context::descriptor_max_constant_buffers_dynamic;
+        pool_sizes[1].descriptorCount   = RHI_Context::descriptor_max_constant_buffers_dynamic * descriptor_set_capacity;
         pool_sizes[2].type              = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        pool_sizes[2].descriptorCount   = RHI_Context::descriptor_max_textures;
+        pool_sizes[2].descriptorCount   = RHI_Context::descriptor_max_textures * descriptor_set_capacity;
         pool_sizes[3].type              = VK_DESCRIPTOR_TYPE_SAMPLER;
-        pool_sizes[3].descriptorCount   = RHI_Context::descriptor_max_samplers;
+        pool_sizes[3].descriptorCount   = RHI_Context::descriptor_max_samplers * descriptor_set_capacity;
 
         // Create info
         VkDescriptorPoolCreateInfo pool_create_info = {};
@@ -91,10 +126,14 @@ namespace Spartan
         pool_create_info.maxSets        = descriptor_set_capacity;
 
         // Pool
-        const auto descriptor_pool = reinterpret_cast<VkDescriptorPool*>(&m_descriptor_pool);
-        if (!vulkan_utility::error::check(vkCreateDescriptorPool(m_rhi_device->GetContextRhi()->device, &pool_create_info, nullptr, descriptor_pool)))
+        void* descriptor_pool = nullptr;
+        if (!vulkan_utility::error::check(vkCreateDescriptorPool(m_rhi_device->GetContextRhi()->device, &pool_create_info, nullptr, reinterpret_cast<VkDescriptorPool*>(&descriptor_pool))))
             return false;
 
+        m_descriptor_pools.emplace_back(descriptor_pool);
+        m_descriptor_pool_capacity  = descriptor_set_capacity;
+        m_descriptor_pool_allocated = 0;
+
         return true;
     }
 }
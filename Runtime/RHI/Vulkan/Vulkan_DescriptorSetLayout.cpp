@@ -40,24 +40,14 @@ namespace Spartan
         }
     }
 
-    void* RHI_DescriptorSetLayout::CreateDescriptorSet(const size_t hash, const RHI_DescriptorCache* descriptor_cache)
+    void* RHI_DescriptorSetLayout::CreateDescriptorSet(const size_t hash, RHI_DescriptorCache* descriptor_cache)
     {
         // Allocate descriptor set
-        void* descriptor_set = nullptr;
-        {
-            // Allocate info
-            VkDescriptorSetAllocateInfo allocate_info   = {};
-            allocate_info.sType                         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            allocate_info.descriptorPool                = static_cast<VkDescriptorPool>(descriptor_cache->GetResource_DescriptorSetPool());
-            allocate_info.descriptorSetCount            = 1;
-            allocate_info.pSetLayouts                   = reinterpret_cast<VkDescriptorSetLayout*>(&m_descriptor_set_layout);
-
-            // Allocate		
-            if (!vulkan_utility::error::check(vkAllocateDescriptorSets(m_rhi_device->GetContextRhi()->device, &allocate_info, reinterpret_cast<VkDescriptorSet*>(&descriptor_set))))
-                return nullptr;
-
-            vulkan_utility::debug::set_name(*reinterpret_cast<VkDescriptorSet*>(&descriptor_set), m_name.c_str());
-        }
+        void* descriptor_set = descriptor_cache->AllocateDescriptorSet(m_descriptor_set_layout);
+        if (!descriptor_set)
+            return nullptr;
+
+        vulkan_utility::debug::set_name(*reinterpret_cast<VkDescriptorSet*>(&descriptor_set), m_name.c_str());
 
         UpdateDescriptorSet(descriptor_set, m_descriptors);
 
@@ -32,6 +32,12 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    // Defragmentation of the geometry pool, it's considered every few frames and only when enough of the pool is unused.
+    // A step moves a limited amount of memory, so that a step (which waits for the GPU) stays short.
+    static const uint64_t memory_defragment_interval    = 120;
+    static const float memory_defragment_threshold      = 0.25f;
+    static const uint64_t memory_defragment_step_max    = 32 * 1024 * 1024;
+
 	RHI_Device::RHI_Device(Context* context)
 	{
         m_context       = context;
@@ -197,26 +203,100 @@ namespace Spartan
                 ENABLE_FEATURE(fillModeNonSolid)
                 ENABLE_FEATURE(wideLines)
                 ENABLE_FEATURE(imageCubeArray)
+                ENABLE_FEATURE(pipelineStatisticsQuery)
+            }
+
+            // Timeline semaphores, they let the CPU wait for a specific submission instead of a fence per command list
+            const bool vulkan_1_2 = m_rhi_context->api_version >= VK_API_VERSION_1_2 && m_rhi_context->device_properties.apiVersion >= VK_API_VERSION_1_2;
+            VkPhysicalDeviceVulkan12Features device_features_12_enabled = {};
+            device_features_12_enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+            VkPhysicalDeviceFragmentShadingRateFeaturesKHR device_features_shading_rate_enabled = {};
+            device_features_shading_rate_enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR;
+            VkPhysicalDeviceDynamicRenderingFeaturesKHR device_features_dynamic_rendering_enabled = {};
+            device_features_dynamic_rendering_enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+            const bool shading_rate_present         = vulkan_1_2 && vulkan_utility::extension::is_present_device("VK_KHR_fragment_shading_rate", m_rhi_context->device_physical);
+            const bool dynamic_rendering_present    = vulkan_1_2 && vulkan_utility::extension::is_present_device("VK_KHR_dynamic_rendering", m_rhi_context->device_physical);
+            if (vulkan_1_2)
+            {
+                VkPhysicalDeviceDynamicRenderingFeaturesKHR device_features_dynamic_rendering = {};
+                device_features_dynamic_rendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+                VkPhysicalDeviceFragmentShadingRateFeaturesKHR device_features_shading_rate = {};
+                device_features_shading_rate.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR;
+                device_features_shading_rate.pNext = dynamic_rendering_present ? &device_features_dynamic_rendering : nullptr;
+
+                VkPhysicalDeviceVulkan12Features device_features_12 = {};
+                device_features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+                device_features_12.pNext = shading_rate_present ? static_cast<void*>(&device_features_shading_rate) : dynamic_rendering_present ? static_cast<void*>(&device_features_dynamic_rendering) : nullptr;
+
+                VkPhysicalDeviceFeatures2 device_features_2 = {};
+                device_features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                device_features_2.pNext = &device_features_12;
+                vkGetPhysicalDeviceFeatures2(m_rhi_context->device_physical, &device_features_2);
+
+                device_features_12_enabled.timelineSemaphore = device_features_12.timelineSemaphore;
+
+                // 16-bit arithmetic in shaders, only registers are 16-bit so no storage feature is needed
+                if (device_features_12.shaderFloat16)
+                {
+                    device_features_12_enabled.shaderFloat16    = VK_TRUE;
+                    m_shader_float16                            = true;
+                }
+
+                // Variable rate shading, from an image (the pipeline rate is needed too, it's what the image rate is combined with)
+                if (device_features_shading_rate.attachmentFragmentShadingRate && device_features_shading_rate.pipelineFragmentShadingRate)
+                {
+                    device_features_shading_rate_enabled.attachmentFragmentShadingRate  = VK_TRUE;
+                    device_features_shading_rate_enabled.pipelineFragmentShadingRate    = VK_TRUE;
+                    device_features_12_enabled.pNext                                    = &device_features_shading_rate_enabled;
+
+                    VkPhysicalDeviceFragmentShadingRatePropertiesKHR properties_shading_rate = {};
+                    properties_shading_rate.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_PROPERTIES_KHR;
+                    VkPhysicalDeviceProperties2 properties_2 = {};
+                    properties_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                    properties_2.pNext = &properties_shading_rate;
+                    vkGetPhysicalDeviceProperties2(m_rhi_context->device_physical, &properties_2);
+
+                    // Square tiles of 16 pixels, or the closest the device takes
+                    const VkExtent2D& texel_min = properties_shading_rate.minFragmentShadingRateAttachmentTexelSize;
+                    const VkExtent2D& texel_max = properties_shading_rate.maxFragmentShadingRateAttachmentTexelSize;
+                    m_shading_rate_tile_size    = Helper::Clamp(16u, Helper::Max(texel_min.width, texel_min.height), Helper::Min(texel_max.width, texel_max.height));
+                    m_variable_rate_shading     = m_shading_rate_tile_size != 0;
+                }
+
+                // Dynamic rendering, passes begin with their attachments directly, so no render pass or frame buffer objects are created
+                if (device_features_dynamic_rendering.dynamicRendering)
+                {
+                    device_features_dynamic_rendering_enabled.dynamicRendering  = VK_TRUE;
+                    device_features_dynamic_rendering_enabled.pNext             = device_features_12_enabled.pNext;
+                    device_features_12_enabled.pNext                            = &device_features_dynamic_rendering_enabled;
+                    m_dynamic_rendering                                         = true;
+                }
             }
+            m_rhi_context->timeline_semaphores = device_features_12_enabled.timelineSemaphore == VK_TRUE;
 
             // Determine enabled graphics shader stages
             m_enabled_graphics_shader_stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
             if (device_features_enabled.geometryShader)
             {
-                m_enabled_graphics_shader_stages = VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+                m_enabled_graphics_shader_stages |= VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
             }
             if (device_features_enabled.tessellationShader)
             {
-                m_enabled_graphics_shader_stages = VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT;
+                m_enabled_graphics_shader_stages |= VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT;
             }
 
             // Get the supported extensions out of the requested extensions
             vector<const char*> extensions_supported = vulkan_utility::extension::get_supported_device(m_rhi_context->extensions_device, m_rhi_context->device_physical);
 
+            // Layered rendering, the vertex shader can write the array slice (SV_RenderTargetArrayIndex)
+            m_layered_rendering = vulkan_utility::extension::is_present_device("VK_EXT_shader_viewport_index_layer", m_rhi_context->device_physical);
+
             // Device create info
 			VkDeviceCreateInfo create_info = {};
 			{
 				create_info.sType					= VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+				create_info.pNext					= vulkan_1_2 ? &device_features_12_enabled : nullptr;
 				create_info.queueCreateInfoCount	= static_cast<uint32_t>(queue_create_infos.size());
 				create_info.pQueueCreateInfos		= queue_create_infos.data();
 				create_info.pEnabledFeatures		= &device_features_enabled;
@@ -238,10 +318,31 @@ namespace Spartan
 			if (!vulkan_utility::error::check(vkCreateDevice(m_rhi_context->device_physical, &create_info, nullptr, &m_rhi_context->device)))
 				return;
 
+            // Dynamic rendering commands, they come from an extension so they are looked up
+            if (m_dynamic_rendering)
+            {
+                vulkan_utility::functions::initialize_device();
+                m_dynamic_rendering = vulkan_utility::functions::begin_rendering && vulkan_utility::functions::end_rendering;
+            }
+
             // Create queues
             vkGetDeviceQueue(m_rhi_context->device, m_rhi_context->queue_graphics_index, 0, reinterpret_cast<VkQueue*>(&m_rhi_context->queue_graphics));
             vkGetDeviceQueue(m_rhi_context->device, m_rhi_context->queue_compute_index,  0, reinterpret_cast<VkQueue*>(&m_rhi_context->queue_compute));
             vkGetDeviceQueue(m_rhi_context->device, m_rhi_context->queue_transfer_index, 0, reinterpret_cast<VkQueue*>(&m_rhi_context->queue_transfer));
+
+            // Create queue timelines
+            if (m_rhi_context->timeline_semaphores)
+            {
+                for (VkSemaphore& timeline : m_rhi_context->queue_timelines)
+                {
+                    if (!vulkan_utility::semaphore::create_timeline(reinterpret_cast<void*&>(timeline)))
+                    {
+                        LOG_WARNING("Failed to create a queue timeline, falling back to fences");
+                        m_rhi_context->timeline_semaphores = false;
+                        break;
+                    }
+                }
+            }
 		}
 
         vulkan_utility::display::detect_display_modes();
@@ -266,11 +367,19 @@ namespace Spartan
         if (!m_rhi_context || !m_rhi_context->queue_graphics)
             return;
 
-        // Release resources
-		if (Queue_Wait(RHI_Queue_Graphics))
+        // Release resources (including the ones waiting in the deletion queue)
+		if (Queue_WaitAll())
 		{
+            m_initialized = false; // anything destroyed from now on is released right away
+            vulkan_utility::staging_ring::destroy();
+            vulkan_utility::render_pass_cache::destroy();
             m_rhi_context->destroy_allocator();
 
+            for (VkSemaphore& timeline : m_rhi_context->queue_timelines)
+            {
+                vulkan_utility::semaphore::destroy(reinterpret_cast<void*&>(timeline));
+            }
+
             if (m_rhi_context->debug)
             {
                 vulkan_utility::debug::shutdown(m_rhi_context->instance);
@@ -297,24 +406,54 @@ namespace Spartan
         return vulkan_utility::error::check(vkQueuePresentKHR(static_cast<VkQueue>(m_rhi_context->queue_graphics), &present_info));
     }
 
-    bool RHI_Device::Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore /*= nullptr*/, void* signal_semaphore /*= nullptr*/, void* signal_fence /*= nullptr*/, uint32_t wait_flags /*= 0*/) const
+    bool RHI_Device::Queue_Submit(const RHI_Queue_Type type, void* cmd_buffer, void* wait_semaphore /*= nullptr*/, void* signal_semaphore /*= nullptr*/, void* signal_fence /*= nullptr*/, uint32_t wait_flags /*= 0*/, uint64_t* timeline_value /*= nullptr*/) const
     {
+        const bool signal_timeline          = timeline_value && m_rhi_context->timeline_semaphores;
         VkSemaphore wait_semaphores[]       = { static_cast<VkSemaphore>(wait_semaphore) };
-        VkSemaphore signal_semaphores[]     = { static_cast<VkSemaphore>(signal_semaphore) };
         VkPipelineStageFlags _wait_flags[]  = { wait_flags };
 
+        // The binary semaphore (if any) goes first, the timeline is appended
+        VkSemaphore signal_semaphores[2]    = {};
+        uint64_t signal_values[2]           = {};
+        uint32_t signal_count               = 0;
+        if (signal_semaphore)
+        {
+            signal_semaphores[signal_count++] = static_cast<VkSemaphore>(signal_semaphore);
+        }
+
+        lock_guard<mutex> lock(m_queue_mutex);
+
+        if (signal_timeline)
+        {
+            signal_values[signal_count]         = ++m_rhi_context->queue_timeline_values[type];
+            signal_semaphores[signal_count++]   = m_rhi_context->queue_timelines[type];
+        }
+
+        VkTimelineSemaphoreSubmitInfo timeline_info = {};
+        timeline_info.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_info.signalSemaphoreValueCount     = signal_count;
+        timeline_info.pSignalSemaphoreValues        = signal_values;
+
         VkSubmitInfo submit_info            = {};
         submit_info.sType                   = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext                   = signal_timeline ? &timeline_info : nullptr;
         submit_info.waitSemaphoreCount      = wait_semaphore ? 1 : 0;
         submit_info.pWaitSemaphores         = wait_semaphores;
-        submit_info.signalSemaphoreCount    = signal_semaphore ? 1 : 0;
+        submit_info.signalSemaphoreCount    = signal_count;
         submit_info.pSignalSemaphores       = signal_semaphores;
         submit_info.pWaitDstStageMask       = _wait_flags;
         submit_info.commandBufferCount      = 1;
         submit_info.pCommandBuffers         = reinterpret_cast<VkCommandBuffer*>(&cmd_buffer);
-        
-        lock_guard<mutex> lock(m_queue_mutex);
-        return vulkan_utility::error::check(vkQueueSubmit(static_cast<VkQueue>(Queue_Get(type)), 1, &submit_info, static_cast<VkFence>(signal_fence)));
+
+        if (!vulkan_utility::error::check(vkQueueSubmit(static_cast<VkQueue>(Queue_Get(type)), 1, &submit_info, static_cast<VkFence>(signal_fence))))
+            return false;
+
+        if (signal_timeline)
+        {
+            *timeline_value = signal_values[signal_count - 1];
+        }
+
+        return true;
     }
 
     bool RHI_Device::Queue_Wait(const RHI_Queue_Type type) const
@@ -322,4 +461,156 @@ namespace Spartan
         lock_guard<mutex> lock(m_queue_mutex);
         return vulkan_utility::error::check(vkQueueWaitIdle(static_cast<VkQueue>(Queue_Get(type))));
     }
+
+    bool RHI_Device::Queue_WaitValue(const RHI_Queue_Type type, const uint64_t value) const
+    {
+        if (!m_rhi_context->timeline_semaphores)
+            return false;
+
+        return vulkan_utility::semaphore::wait_timeline(m_rhi_context->queue_timelines[type], value);
+    }
+
+    bool RHI_Device::Queue_HasTimeline() const
+    {
+        return m_rhi_context->timeline_semaphores;
+    }
+
+    void RHI_Device::Memory_Tick(const uint64_t frame)
+    {
+        VmaAllocator allocator = m_rhi_context->allocator;
+        if (!allocator)
+            return;
+
+        // The budget is queried once per frame index
+        vmaSetCurrentFrameIndex(allocator, static_cast<uint32_t>(frame));
+
+        // Warn when crossing the budget, beyond it the driver starts paging
+        {
+            VmaBudget budget[VK_MAX_MEMORY_HEAPS] = {};
+            vmaGetBudget(allocator, budget);
+
+            const bool over_budget = budget[0].usage > budget[0].budget;
+            if (over_budget && !m_memory_over_budget)
+            {
+                LOG_WARNING("GPU memory usage (%llu MB) exceeds the budget (%llu MB)", budget[0].usage / 1024 / 1024, budget[0].budget / 1024 / 1024);
+            }
+            m_memory_over_budget = over_budget;
+        }
+
+        // Defragment the geometry pool, loading and unloading worlds leaves holes in it
+        VmaPool pool = m_rhi_context->memory_pools[RHI_Memory_Pool_Geometry];
+        if (!pool || frame % memory_defragment_interval != 0)
+            return;
+
+        VmaPoolStats pool_stats = {};
+        vmaGetPoolStats(allocator, pool, &pool_stats);
+        if (pool_stats.blockCount < 2 || pool_stats.unusedSize < static_cast<VkDeviceSize>(pool_stats.size * memory_defragment_threshold))
+            return;
+
+        lock_guard<mutex> lock(m_rhi_context->mutex_allocations);
+
+        vector<VmaAllocation> allocations;
+        allocations.reserve(m_rhi_context->allocations_movable.size());
+        for (const auto& it : m_rhi_context->allocations_movable)
+        {
+            if (it.second.owner)
+            {
+                allocations.emplace_back(it.first);
+            }
+        }
+
+        if (allocations.empty())
+            return;
+        vector<VkBool32> allocations_changed(allocations.size(), VK_FALSE);
+
+        // The moves are copies on the GPU
+        VkCommandBuffer cmd_buffer = vulkan_utility::command_buffer_immediate::begin(RHI_Queue_Transfer);
+        if (!cmd_buffer)
+            return;
+
+        VmaDefragmentationInfo2 defragmentation_info    = {};
+        defragmentation_info.allocationCount            = static_cast<uint32_t>(allocations.size());
+        defragmentation_info.pAllocations               = allocations.data();
+        defragmentation_info.pAllocationsChanged        = allocations_changed.data();
+        defragmentation_info.maxCpuBytesToMove          = 0;
+        defragmentation_info.maxCpuAllocationsToMove    = 0;
+        defragmentation_info.maxGpuBytesToMove          = memory_defragment_step_max;
+        defragmentation_info.maxGpuAllocationsToMove    = UINT32_MAX;
+        defragmentation_info.commandBuffer              = cmd_buffer;
+
+        VmaDefragmentationContext defragmentation_context   = nullptr;
+        VmaDefragmentationStats defragmentation_stats       = {};
+        const VkResult result = vmaDefragmentationBegin(allocator, &defragmentation_info, &defragmentation_stats, &defragmentation_context);
+
+        // Execute the copies, then wait for the frames in flight, they could still be reading the buffers which are about to be destroyed
+        vulkan_utility::command_buffer_immediate::end(RHI_Queue_Transfer);
+        Queue_WaitAll();
+        vmaDefragmentationEnd(allocator, defragmentation_context);
+
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+        {
+            vulkan_utility::error::check(result);
+            return;
+        }
+
+        // A buffer is bound to its memory for life, so the moved ones are re-created at their new place
+        for (uint32_t i = 0; i < static_cast<uint32_t>(allocations.size()); i++)
+        {
+            if (!allocations_changed[i])
+                continue;
+
+            RHI_Context::allocation_movable& movable = m_rhi_context->allocations_movable[allocations[i]];
+            void*& buffer = *movable.owner;
+
+            m_rhi_context->allocations.erase(reinterpret_cast<uint64_t>(buffer));
+            vkDestroyBuffer(m_rhi_context->device, static_cast<VkBuffer>(buffer), nullptr);
+
+            VkBufferCreateInfo buffer_create_info   = {};
+            buffer_create_info.sType                = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_create_info.size                 = movable.size;
+            buffer_create_info.usage                = movable.usage;
+            buffer_create_info.sharingMode          = VK_SHARING_MODE_EXCLUSIVE;
+
+            buffer = nullptr;
+            if (!vulkan_utility::error::check(vkCreateBuffer(m_rhi_context->device, &buffer_create_info, nullptr, reinterpret_cast<VkBuffer*>(&buffer))))
+                continue;
+
+            VkMemoryRequirements memory_requirements;
+            vkGetBufferMemoryRequirements(m_rhi_context->device, static_cast<VkBuffer>(buffer), &memory_requirements);
+            vulkan_utility::error::check(vmaBindBufferMemory(allocator, allocations[i], static_cast<VkBuffer>(buffer)));
+
+            m_rhi_context->allocations[reinterpret_cast<uint64_t>(buffer)] = allocations[i];
+        }
+
+        LOG_INFO("Defragmented geometry memory, moved %u allocations (%llu KB), freed %u blocks", defragmentation_stats.allocationsMoved, defragmentation_stats.bytesMoved / 1024, defragmentation_stats.deviceMemoryBlocksFreed);
+    }
+
+    bool RHI_Device::Memory_GetPoolStats(const RHI_Memory_Pool pool, RHI_Memory_Pool_Stats& stats) const
+    {
+        if (!m_rhi_context->allocator || !m_rhi_context->memory_pools[pool])
+            return false;
+
+        VmaPoolStats pool_stats = {};
+        vmaGetPoolStats(m_rhi_context->allocator, m_rhi_context->memory_pools[pool], &pool_stats);
+
+        stats.size              = pool_stats.size;
+        stats.used              = pool_stats.size - pool_stats.unusedSize;
+        stats.free_range_max    = pool_stats.unusedRangeSizeMax;
+        stats.allocation_count  = static_cast<uint32_t>(pool_stats.allocationCount);
+        stats.block_count       = static_cast<uint32_t>(pool_stats.blockCount);
+        stats.free_range_count  = static_cast<uint32_t>(pool_stats.unusedRangeCount);
+
+        return true;
+    }
+
+    uint32_t RHI_Device::Memory_GetBudget() const
+    {
+        if (!m_rhi_context->allocator)
+            return 0;
+
+        VmaBudget budget[VK_MAX_MEMORY_HEAPS] = {};
+        vmaGetBudget(m_rhi_context->allocator, budget);
+
+        return static_cast<uint32_t>(budget[0].budget / 1024 / 1024); // MBs
+    }
 }
@@ -35,9 +35,6 @@ namespace Spartan
 {
     void RHI_IndexBuffer::_destroy()
     {
-        // Wait in case the buffer is still in use
-        m_rhi_device->Queue_WaitAll();
-
         // Unmap
         if (m_mapped)
         {
@@ -45,8 +42,8 @@ namespace Spartan
             m_mapped = nullptr;
         }
 
-        // Destroy
-        vulkan_utility::buffer::destroy(m_buffer);
+        // Destroy, once the frames in flight are done with it
+        vulkan_utility::buffer::destroy_deferred(m_buffer);
     }
 
 	bool RHI_IndexBuffer::_create(const void* indices)
@@ -83,37 +80,14 @@ namespace Spartan
         {
             // The reason we use staging is because memory with VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT is not mappable but it's fast, we want that.
 
-            // Create staging/source buffer and copy the indices to it
-            void* staging_buffer = nullptr;
-            VmaAllocation allocation_staging = vulkan_utility::buffer::create(staging_buffer, m_size_gpu, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false, indices);
-            if (!allocation_staging)
-                return false;
-
             // Create destination buffer
             VmaAllocation allocation = vulkan_utility::buffer::create(m_buffer, m_size_gpu, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
             if (!allocation)
                 return false;
 
-            // Copy staging buffer to destination buffer
-            {
-                // Create command buffer
-                VkCommandBuffer cmd_buffer = vulkan_utility::command_buffer_immediate::begin(RHI_Queue_Transfer);
-
-                VkBuffer* buffer_vk         = reinterpret_cast<VkBuffer*>(&m_buffer);
-                VkBuffer* buffer_staging_vk = reinterpret_cast<VkBuffer*>(&staging_buffer);
-
-                // Copy
-                VkBufferCopy copy_region = {};
-                copy_region.size = m_size_gpu;
-                vkCmdCopyBuffer(cmd_buffer, *buffer_staging_vk, *buffer_vk, 1, &copy_region);
-
-                // Flush and free command buffer
-                if (!vulkan_utility::command_buffer_immediate::end(RHI_Queue_Transfer))
-                    return false;
-
-                // Destroy staging buffer
-                vulkan_utility::buffer::destroy(staging_buffer);
-            }
+            // Copy the indices to it, on the transfer queue
+            if (!vulkan_utility::buffer::upload(m_buffer, indices, m_size_gpu))
+                return false;
 
             m_allocation    = static_cast<void*>(allocation);
             m_is_mappable   = false;
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Pipeline.h"
 #include "../RHI_Device.h"
 #include "../RHI_Shader.h"
+#include "../RHI_Texture.h"
 #include "../RHI_BlendState.h"
 #include "../RHI_InputLayout.h"
 #include "../RHI_CommandList.h"
@@ -32,6 +33,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_RasterizerState.h"
 #include "../RHI_DepthStencilState.h"
 #include "../../Logging/Log.h"
+#include <array>
 //===================================
 
 //= NAMESPACES =====
@@ -40,30 +42,17 @@ using namespace std;
 
 namespace Spartan
 {
-	RHI_Pipeline::RHI_Pipeline(const RHI_Device* rhi_device, RHI_PipelineState& pipeline_state, void* descriptor_set_layout)
+	RHI_Pipeline::RHI_Pipeline(const RHI_Device* rhi_device, RHI_PipelineState& pipeline_state, void* descriptor_set_layout, void* pipeline_cache)
 	{
 		m_rhi_device    = rhi_device;
 		m_state         = pipeline_state;
-        m_state.CreateFrameResources(rhi_device);
 
-        // Viewport & Scissor
-        vector<VkDynamicState> dynamic_states;
-        VkPipelineDynamicStateCreateInfo dynamic_state      = {};   
-        VkViewport vkViewport                               = {};
-        VkRect2D scissor                                    = {};
+        // Viewport & Scissor, always dynamic, the command list sets the ones of the pipeline state when it binds the pipeline
+        // (so states which only differ in them, like the passes over the mips of a texture, share a pipeline)
+        vector<VkDynamicState> dynamic_states               = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+        VkPipelineDynamicStateCreateInfo dynamic_state      = {};
         VkPipelineViewportStateCreateInfo viewport_state    = {};
         {
-            // If no viewport has been provided, assume dynamic
-            if (!m_state.viewport.IsDefined())
-            {
-                dynamic_states.emplace_back(VK_DYNAMIC_STATE_VIEWPORT);
-            }
-
-            if (m_state.dynamic_scissor)
-            {
-                dynamic_states.emplace_back(VK_DYNAMIC_STATE_SCISSOR);
-            }
-
             // Dynamic states
 		    dynamic_state.sType				= VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 		    dynamic_state.pNext				= nullptr;
@@ -71,34 +60,12 @@ namespace Spartan
 		    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
 		    dynamic_state.pDynamicStates	= dynamic_states.data();
 
-		    // Viewport 
-		    vkViewport.x			= m_state.viewport.x;
-		    vkViewport.y			= m_state.viewport.y;
-		    vkViewport.width		= m_state.viewport.width;
-		    vkViewport.height		= m_state.viewport.height;
-		    vkViewport.minDepth		= m_state.viewport.depth_min;
-		    vkViewport.maxDepth		= m_state.viewport.depth_max;
-
-		    // Scissor	   
-            if (!m_state.scissor.IsDefined())
-            {
-                scissor.offset          = { 0, 0 };
-                scissor.extent.width    = static_cast<uint32_t>(vkViewport.width);
-                scissor.extent.height   = static_cast<uint32_t>(vkViewport.height);
-            }
-            else
-            {
-                scissor.offset          = { static_cast<int32_t>(m_state.scissor.left), static_cast<int32_t>(m_state.scissor.top) };
-                scissor.extent.width    = static_cast<uint32_t>(m_state.scissor.Width());
-                scissor.extent.height   = static_cast<uint32_t>(m_state.scissor.Height());
-            }
-
 		    // Viewport state
 		    viewport_state.sType		    = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		    viewport_state.viewportCount    = 1;
-		    viewport_state.pViewports	    = &vkViewport;
+		    viewport_state.pViewports	    = nullptr;
 		    viewport_state.scissorCount	    = 1;
-		    viewport_state.pScissors	    = &scissor;
+		    viewport_state.pScissors	    = nullptr;
         }
 
         // Shader stages
@@ -145,11 +112,19 @@ namespace Spartan
             shader_stages.push_back(shader_pixel_stage_info);
         }
 
-		// Binding description
-		VkVertexInputBindingDescription binding_description = {};
-		binding_description.binding		= 0;
-		binding_description.inputRate	= VK_VERTEX_INPUT_RATE_VERTEX;
-		binding_description.stride		= m_state.vertex_buffer_stride;
+		// Binding descriptions, instanced vertex shaders also read from a per-instance binding
+		array<VkVertexInputBindingDescription, 2> binding_descriptions = {};
+        uint32_t binding_description_count = 1;
+		binding_descriptions[0].binding		= 0;
+		binding_descriptions[0].inputRate	= VK_VERTEX_INPUT_RATE_VERTEX;
+		binding_descriptions[0].stride		= m_state.vertex_buffer_stride;
+        if (m_state.shader_vertex && m_state.shader_vertex->GetInputLayout() && m_state.shader_vertex->GetInputLayout()->GetInstanceStride() != 0)
+        {
+            binding_descriptions[1].binding     = rhi_binding_instance;
+            binding_descriptions[1].inputRate   = VK_VERTEX_INPUT_RATE_INSTANCE;
+            binding_descriptions[1].stride      = m_state.shader_vertex->GetInputLayout()->GetInstanceStride();
+            binding_description_count           = 2;
+        }
 
 		// Vertex attributes description
         vector<VkVertexInputAttributeDescription> vertex_attribute_descs;
@@ -175,8 +150,8 @@ namespace Spartan
 		VkPipelineVertexInputStateCreateInfo vertex_input_state = {};
         {
 		    vertex_input_state.sType							= VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		    vertex_input_state.vertexBindingDescriptionCount	= 1;
-		    vertex_input_state.pVertexBindingDescriptions		= &binding_description;
+		    vertex_input_state.vertexBindingDescriptionCount	= binding_description_count;
+		    vertex_input_state.pVertexBindingDescriptions		= binding_descriptions.data();
 		    vertex_input_state.vertexAttributeDescriptionCount  = static_cast<uint32_t>(vertex_attribute_descs.size());
 		    vertex_input_state.pVertexAttributeDescriptions		= vertex_attribute_descs.data();
         }
@@ -278,11 +253,17 @@ namespace Spartan
             depth_stencil_state.back                = depth_stencil_state.front;
         }
 
-        // Pipeline layout
+        // Pipeline layout, every layout has the same push constant range so pushed data survives pipeline changes
+        VkPushConstantRange push_constant_range = {};
+        push_constant_range.stageFlags          = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        push_constant_range.offset              = 0;
+        push_constant_range.size                = rhi_max_push_constant_size;
+
 		VkPipelineLayoutCreateInfo pipeline_layout_info	= {};
         { 
 		    pipeline_layout_info.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		    pipeline_layout_info.pushConstantRangeCount	= 0;
+		    pipeline_layout_info.pushConstantRangeCount	= 1;
+		    pipeline_layout_info.pPushConstantRanges	= &push_constant_range;
 		    pipeline_layout_info.setLayoutCount			= 1;		
 		    pipeline_layout_info.pSetLayouts			= reinterpret_cast<VkDescriptorSetLayout*>(&descriptor_set_layout);
 
@@ -302,18 +283,55 @@ namespace Spartan
 		    pipeline_info.pStages				= shader_stages.data();
 		    pipeline_info.pVertexInputState		= &vertex_input_state;
 		    pipeline_info.pInputAssemblyState   = &input_assembly_state;
-		    pipeline_info.pDynamicState			= dynamic_states.empty() ? nullptr : &dynamic_state;
+		    pipeline_info.pDynamicState			= &dynamic_state;
 		    pipeline_info.pViewportState		= &viewport_state;
 		    pipeline_info.pRasterizationState	= &rasterizer_state;
 		    pipeline_info.pMultisampleState		= &multisampling_state;
 		    pipeline_info.pColorBlendState		= &color_blend_state;
             pipeline_info.pDepthStencilState    = &depth_stencil_state;
 		    pipeline_info.layout				= static_cast<VkPipelineLayout>(m_pipeline_layout);
-		    pipeline_info.renderPass			= static_cast<VkRenderPass>(m_state.GetRenderPass());
+
+            // The shading rate image picks the rate, the pipeline's 1x1 rate is replaced by it
+            VkPipelineFragmentShadingRateStateCreateInfoKHR shading_rate_state = {};
+            shading_rate_state.sType            = VK_STRUCTURE_TYPE_PIPELINE_FRAGMENT_SHADING_RATE_STATE_CREATE_INFO_KHR;
+            shading_rate_state.fragmentSize     = { 1, 1 };
+            shading_rate_state.combinerOps[0]   = VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR;
+            shading_rate_state.combinerOps[1]   = VK_FRAGMENT_SHADING_RATE_COMBINER_OP_REPLACE_KHR;
+            const void* p_next = m_state.render_target_shading_rate_texture ? &shading_rate_state : nullptr;
+
+            // Render targets, with dynamic rendering the pipeline is only told their formats, otherwise it's created against a
+            // render pass which is compatible with every pass that renders to these formats (load/store ops and layouts don't matter)
+            array<VkFormat, state_max_render_target_count> color_formats = {};
+            VkPipelineRenderingCreateInfoKHR rendering_info = {};
+            if (m_state.render_target_swapchain || !m_rhi_device->IsDynamicRenderingSupported())
+            {
+                pipeline_info.renderPass = static_cast<VkRenderPass>(m_state.GetRenderPass(m_rhi_device));
+            }
+            else
+            {
+                uint32_t color_format_count = 0;
+                for (RHI_Texture* texture : m_state.render_target_color_textures)
+                {
+                    if (texture)
+                    {
+                        color_formats[color_format_count++] = vulkan_format[texture->GetFormat()];
+                    }
+                }
+
+                RHI_Texture* depth_texture                  = m_state.render_target_depth_texture;
+                rendering_info.sType                        = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+                rendering_info.pNext                        = p_next;
+                rendering_info.colorAttachmentCount         = color_format_count;
+                rendering_info.pColorAttachmentFormats      = color_formats.data();
+                rendering_info.depthAttachmentFormat        = depth_texture ? vulkan_format[depth_texture->GetFormat()] : VK_FORMAT_UNDEFINED;
+                rendering_info.stencilAttachmentFormat      = depth_texture && depth_texture->IsStencilFormat() ? vulkan_format[depth_texture->GetFormat()] : VK_FORMAT_UNDEFINED;
+                p_next                                      = &rendering_info;
+            }
+            pipeline_info.pNext = p_next;
 
             // Create
             auto pipeline = reinterpret_cast<VkPipeline*>(&m_pipeline);
-            vulkan_utility::error::check(vkCreateGraphicsPipelines(m_rhi_device->GetContextRhi()->device, nullptr, 1, &pipeline_info, nullptr, pipeline));
+            vulkan_utility::error::check(vkCreateGraphicsPipelines(m_rhi_device->GetContextRhi()->device, static_cast<VkPipelineCache>(pipeline_cache), 1, &pipeline_info, nullptr, pipeline));
 
             // Name
             vulkan_utility::debug::set_name(*pipeline, m_state.pass_name);
@@ -322,13 +340,16 @@ namespace Spartan
 
 	RHI_Pipeline::~RHI_Pipeline()
 	{
-        // Wait in case the buffer is still in use
-        m_rhi_device->Queue_WaitAll();
-
-		vkDestroyPipeline(m_rhi_device->GetContextRhi()->device, static_cast<VkPipeline>(m_pipeline), nullptr);
-		m_pipeline = nullptr;
-
-		vkDestroyPipelineLayout(m_rhi_device->GetContextRhi()->device, static_cast<VkPipelineLayout>(m_pipeline_layout), nullptr);
-		m_pipeline_layout = nullptr;
+        // Released once the frames in flight, which could still be using it, retire
+        RHI_Context* rhi_context    = m_rhi_device->GetContextRhi();
+        void* pipeline              = m_pipeline;
+        void* pipeline_layout       = m_pipeline_layout;
+        m_rhi_device->DeletionQueue_Add([rhi_context, pipeline, pipeline_layout]()
+        {
+            vkDestroyPipeline(rhi_context->device, static_cast<VkPipeline>(pipeline), nullptr);
+            vkDestroyPipelineLayout(rhi_context->device, static_cast<VkPipelineLayout>(pipeline_layout), nullptr);
+        });
+		m_pipeline          = nullptr;
+		m_pipeline_layout   = nullptr;
 	}
 }
@@ -0,0 +1,126 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ========================
+#include "../RHI_Implementation.h"
+#include "../RHI_PipelineCache.h"
+#include "../RHI_Device.h"
+#include "../../Core/FileSystem.h"
+#include "../../IO/FileStream.h"
+//===================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    bool RHI_PipelineCache::CreateResource()
+    {
+        // Load the data of the previous run, it's only usable by the same driver and device
+        vector<std::byte> data;
+        if (FileSystem::IsFile(m_file_path))
+        {
+            auto file = make_unique<FileStream>(m_file_path, FileStream_Read);
+            if (file->IsOpen())
+            {
+                file->Read(&data);
+            }
+
+            // The header which precedes the data (as laid out by the spec)
+            struct
+            {
+                uint32_t header_size;
+                uint32_t header_version;
+                uint32_t vendor_id;
+                uint32_t device_id;
+                uint8_t uuid[VK_UUID_SIZE];
+            } header = {};
+
+            const VkPhysicalDeviceProperties& properties = m_rhi_device->GetContextRhi()->device_properties;
+            if (data.size() >= sizeof(header))
+            {
+                memcpy(&header, data.data(), sizeof(header));
+            }
+
+            const bool compatible =
+                header.header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE   &&
+                header.vendor_id == properties.vendorID                         &&
+                header.device_id == properties.deviceID                         &&
+                memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+
+            if (!compatible)
+            {
+                LOG_INFO("The pipeline cache \"%s\" belongs to a different driver or device, it will be rebuilt", m_file_path.c_str());
+                data.clear();
+            }
+        }
+
+        // Create info
+        VkPipelineCacheCreateInfo create_info   = {};
+        create_info.sType                       = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        create_info.initialDataSize             = data.size();
+        create_info.pInitialData                = data.empty() ? nullptr : data.data();
+
+        // Pipeline cache
+        if (!vulkan_utility::error::check(vkCreatePipelineCache(m_rhi_device->GetContextRhi()->device, &create_info, nullptr, reinterpret_cast<VkPipelineCache*>(&m_resource))))
+            return false;
+
+        return true;
+    }
+
+    void RHI_PipelineCache::SaveResource()
+    {
+        if (!m_resource || m_file_path.empty())
+            return;
+
+        // Get the size
+        size_t size = 0;
+        if (!vulkan_utility::error::check(vkGetPipelineCacheData(m_rhi_device->GetContextRhi()->device, static_cast<VkPipelineCache>(m_resource), &size, nullptr)) || size == 0)
+            return;
+
+        // Get the data
+        vector<std::byte> data(size);
+        if (!vulkan_utility::error::check(vkGetPipelineCacheData(m_rhi_device->GetContextRhi()->device, static_cast<VkPipelineCache>(m_resource), &size, data.data())))
+            return;
+        data.resize(size);
+
+        // Write it
+        auto file = make_unique<FileStream>(m_file_path, FileStream_Write);
+        if (!file->IsOpen())
+        {
+            LOG_ERROR("Failed to save the pipeline cache to \"%s\"", m_file_path.c_str());
+            return;
+        }
+
+        file->Write(data);
+    }
+
+    void RHI_PipelineCache::DestroyResource()
+    {
+        if (!m_resource)
+            return;
+
+        vkDestroyPipelineCache(m_rhi_device->GetContextRhi()->device, static_cast<VkPipelineCache>(m_resource), nullptr);
+        m_resource = nullptr;
+    }
+}
@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include "../RHI_Implementation.h"
 #include "../RHI_PipelineState.h"
+#include "../../Utilities/Hash.h"
 //================================
 
 //= NAMESPACES =====
@@ -72,9 +73,11 @@ namespace Spartan
         RHI_Context* rhi_context,
         RHI_DepthStencilState* depth_stencil_state,
         RHI_SwapChain* render_target_swapchain,
-        array<RHI_Texture*, state_max_render_target_count>& render_target_color_textures,
-        array<Math::Vector4, state_max_render_target_count>& render_target_color_clear,
+        const array<RHI_Texture*, state_max_render_target_count>& render_target_color_textures,
+        const array<Math::Vector4, state_max_render_target_count>& render_target_color_clear,
         RHI_Texture* render_target_depth_texture,
+        RHI_Texture* render_target_shading_rate_texture,
+        const uint32_t shading_rate_tile_size,
         float clear_value_depth,
         uint32_t clear_value_stencil,
         void*& render_pass
@@ -165,6 +168,77 @@ namespace Spartan
         subpass.colorAttachmentCount    = static_cast<uint32_t>(render_target_depth_texture ? attachment_references.size() - 1 : attachment_references.size());
         subpass.pColorAttachments       = attachment_references.data();
         subpass.pDepthStencilAttachment = render_target_depth_texture ? &attachment_references.back() : nullptr;
+
+        // A shading rate image is only part of the extended description, so the above is translated into it
+        if (render_target_shading_rate_texture)
+        {
+            vector<VkAttachmentDescription2> attachment_descriptions_2;
+            for (const VkAttachmentDescription& attachment_desc : attachment_descriptions)
+            {
+                VkAttachmentDescription2 attachment_desc_2  = {};
+                attachment_desc_2.sType                     = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2;
+                attachment_desc_2.format                    = attachment_desc.format;
+                attachment_desc_2.samples                   = attachment_desc.samples;
+                attachment_desc_2.loadOp                    = attachment_desc.loadOp;
+                attachment_desc_2.storeOp                   = attachment_desc.storeOp;
+                attachment_desc_2.stencilLoadOp             = attachment_desc.stencilLoadOp;
+                attachment_desc_2.stencilStoreOp            = attachment_desc.stencilStoreOp;
+                attachment_desc_2.initialLayout             = attachment_desc.initialLayout;
+                attachment_desc_2.finalLayout               = attachment_desc.finalLayout;
+                attachment_descriptions_2.push_back(attachment_desc_2);
+            }
+
+            vector<VkAttachmentReference2> attachment_references_2;
+            for (const VkAttachmentReference& attachment_ref : attachment_references)
+            {
+                VkAttachmentReference2 attachment_ref_2 = {};
+                attachment_ref_2.sType                  = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+                attachment_ref_2.attachment             = attachment_ref.attachment;
+                attachment_ref_2.layout                 = attachment_ref.layout;
+                attachment_references_2.push_back(attachment_ref_2);
+            }
+
+            // The shading rate image goes last, it's only read
+            const VkImageLayout layout                  = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR;
+            VkAttachmentDescription2 attachment_desc_2  = {};
+            attachment_desc_2.sType                     = VK_STRUCTURE_TYPE_ATTACHMENT_DESCRIPTION_2;
+            attachment_desc_2.format                    = vulkan_format[render_target_shading_rate_texture->GetFormat()];
+            attachment_desc_2.samples                   = VK_SAMPLE_COUNT_1_BIT;
+            attachment_desc_2.loadOp                    = VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachment_desc_2.storeOp                   = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment_desc_2.stencilLoadOp             = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment_desc_2.stencilStoreOp            = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment_desc_2.initialLayout             = layout;
+            attachment_desc_2.finalLayout               = layout;
+
+            VkAttachmentReference2 shading_rate_ref = {};
+            shading_rate_ref.sType                  = VK_STRUCTURE_TYPE_ATTACHMENT_REFERENCE_2;
+            shading_rate_ref.attachment             = static_cast<uint32_t>(attachment_descriptions_2.size());
+            shading_rate_ref.layout                 = layout;
+            attachment_descriptions_2.push_back(attachment_desc_2);
+
+            VkFragmentShadingRateAttachmentInfoKHR shading_rate_info    = {};
+            shading_rate_info.sType                                     = VK_STRUCTURE_TYPE_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR;
+            shading_rate_info.pFragmentShadingRateAttachment            = &shading_rate_ref;
+            shading_rate_info.shadingRateAttachmentTexelSize            = { shading_rate_tile_size, shading_rate_tile_size };
+
+            VkSubpassDescription2 subpass_2     = {};
+            subpass_2.sType                     = VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_2;
+            subpass_2.pNext                     = &shading_rate_info;
+            subpass_2.pipelineBindPoint         = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass_2.colorAttachmentCount      = subpass.colorAttachmentCount;
+            subpass_2.pColorAttachments         = attachment_references_2.data();
+            subpass_2.pDepthStencilAttachment   = render_target_depth_texture ? &attachment_references_2.back() : nullptr;
+
+            VkRenderPassCreateInfo2 render_pass_info_2  = {};
+            render_pass_info_2.sType                    = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO_2;
+            render_pass_info_2.attachmentCount          = static_cast<uint32_t>(attachment_descriptions_2.size());
+            render_pass_info_2.pAttachments             = attachment_descriptions_2.data();
+            render_pass_info_2.subpassCount             = 1;
+            render_pass_info_2.pSubpasses               = &subpass_2;
+
+            return vulkan_utility::error::check(vkCreateRenderPass2(rhi_context->device, &render_pass_info_2, nullptr, reinterpret_cast<VkRenderPass*>(&render_pass)));
+        }
     
         VkRenderPassCreateInfo render_pass_info = {};
         render_pass_info.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -178,7 +252,7 @@ namespace Spartan
         return vulkan_utility::error::check(vkCreateRenderPass(rhi_context->device, &render_pass_info, nullptr, reinterpret_cast<VkRenderPass*>(&render_pass)));
     }
 
-    inline bool create_frame_buffer(RHI_Context* rhi_context, void* render_pass, const std::vector<void*>& attachments, const uint32_t width, const uint32_t height, void*& frame_buffer)
+    inline bool create_frame_buffer(RHI_Context* rhi_context, void* render_pass, const std::vector<void*>& attachments, const uint32_t width, const uint32_t height, void*& frame_buffer, const uint32_t layers = 1)
     {
         VkFramebufferCreateInfo create_info = {};
         create_info.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -187,114 +261,123 @@ namespace Spartan
         create_info.pAttachments            = reinterpret_cast<const VkImageView*>(attachments.data());
         create_info.width                   = width;
         create_info.height                  = height;
-        create_info.layers                  = 1;
+        create_info.layers                  = layers;
 
         return vulkan_utility::error::check(vkCreateFramebuffer(rhi_context->device, &create_info, nullptr, reinterpret_cast<VkFramebuffer*>(&frame_buffer)));
     }
-  
-    void* RHI_PipelineState::GetFrameBuffer() const
+
+    void* RHI_PipelineState::GetRenderPass(const RHI_Device* rhi_device) const
     {
-        // If this is a swapchain, return the appropriate buffer
-        if (render_target_swapchain)
+        // Everything the render pass is made of
+        size_t hash = 0;
         {
-            if (render_target_swapchain->GetImageIndex() >= state_max_render_target_count)
+            const auto load_op = [](const VkAttachmentLoadOp op) { return static_cast<uint32_t>(op); };
+
+            Utility::Hash::hash_combine(hash, render_target_swapchain ? static_cast<uint32_t>(rhi_device->GetContextRhi()->surface_format) : 0);
+            Utility::Hash::hash_combine(hash, render_target_swapchain ? load_op(get_color_load_op(clear_color[0])) : 0);
+            for (uint32_t i = 0; i < state_max_render_target_count; i++)
             {
-                LOG_ERROR("Invalid image index, %d", render_target_swapchain->GetImageIndex());
-                return nullptr;
+                if (const RHI_Texture* texture = render_target_color_textures[i])
+                {
+                    Utility::Hash::hash_combine(hash, i);
+                    Utility::Hash::hash_combine(hash, static_cast<uint32_t>(texture->GetFormat()));
+                    Utility::Hash::hash_combine(hash, static_cast<uint32_t>(texture->GetLayout()));
+                    Utility::Hash::hash_combine(hash, load_op(get_color_load_op(clear_color[i])));
+                }
+            }
+
+            if (render_target_depth_texture)
+            {
+                Utility::Hash::hash_combine(hash, static_cast<uint32_t>(render_target_depth_texture->GetFormat()));
+                Utility::Hash::hash_combine(hash, static_cast<uint32_t>(render_target_depth_texture->GetLayout()));
+                Utility::Hash::hash_combine(hash, load_op(get_depth_load_op(clear_depth)));
             }
 
-            return m_frame_buffers[render_target_swapchain->GetImageIndex()];
+            // The stencil ops apply to every attachment
+            Utility::Hash::hash_combine(hash, load_op(get_stencil_load_op(clear_stencil)));
+            Utility::Hash::hash_combine(hash, static_cast<uint32_t>(get_stencil_store_op(depth_stencil_state)));
+            Utility::Hash::hash_combine(hash, render_target_shading_rate_texture ? rhi_device->GetShadingRateTileSize() : 0);
         }
 
-        // If this is a render texture, return the first buffer 
-        return m_frame_buffers[0];
+        return vulkan_utility::render_pass_cache::get_render_pass(hash, [&](void*& render_pass)
+        {
+            if (!create_render_pass(rhi_device->GetContextRhi(), depth_stencil_state, render_target_swapchain, render_target_color_textures, clear_color, render_target_depth_texture, render_target_shading_rate_texture, rhi_device->GetShadingRateTileSize(), clear_depth, clear_stencil, render_pass))
+                return false;
+
+            const string name = "render_pass_" + to_string(hash);
+            vulkan_utility::debug::set_name(static_cast<VkRenderPass>(render_pass), name.c_str());
+            return true;
+        });
     }
 
-    bool RHI_PipelineState::CreateFrameResources(const RHI_Device* rhi_device)
+    void* RHI_PipelineState::GetFrameBuffer(const RHI_Device* rhi_device) const
     {
-        m_rhi_device = rhi_device;
-
-        const uint32_t render_target_width  = GetWidth();
-        const uint32_t render_target_height = GetHeight();
+        void* render_pass = GetRenderPass(rhi_device);
+        if (!render_pass)
+            return nullptr;
 
-        // Destroy existing frame resources
-        DestroyFrameResources();
-
-        // Create a render pass
-        if (!create_render_pass(m_rhi_device->GetContextRhi(), depth_stencil_state, render_target_swapchain, render_target_color_textures, clear_color, render_target_depth_texture, clear_depth, clear_stencil, m_render_pass))
-            return false;
-
-        // Name the render pass
-        string name = render_target_swapchain ? ("render_pass_swapchain_" + to_string(m_hash)) : ("render_pass_texture_" + to_string(m_hash));
-        vulkan_utility::debug::set_name(static_cast<VkRenderPass>(m_render_pass), name.c_str());
-
-        // Create frame buffer
-        if (render_target_swapchain)
+        // The views, and the objects which own them (a frame buffer goes away with any of them)
+        vector<void*> attachments;
+        array<uint32_t, state_max_render_target_count + 2> owner_ids = {};
         {
-            // Create one frame buffer per image
-            for (uint32_t i = 0; i < render_target_swapchain->GetBufferCount(); i++)
+            if (render_target_swapchain)
             {
-                vector<void*> attachments = { render_target_swapchain->Get_Resource_View(i) };
-                if (!create_frame_buffer(m_rhi_device->GetContextRhi(), m_render_pass, attachments, render_target_width, render_target_height, m_frame_buffers[i]))
-                    return false;
+                const uint32_t image_index = render_target_swapchain->GetImageIndex();
+                if (image_index >= state_max_render_target_count)
+                {
+                    LOG_ERROR("Invalid image index, %d", image_index);
+                    return nullptr;
+                }
 
-                // Name the frame buffer
-                vulkan_utility::debug::set_name(static_cast<VkFramebuffer>(m_frame_buffers[i]), "frame_bufer_swapchain");
+                attachments.emplace_back(render_target_swapchain->Get_Resource_View(image_index));
+                owner_ids[0] = render_target_swapchain->GetId();
             }
 
-            return true;
-        }
-        else
-        {
-            vector<void*> attachments;
-            
             // Color
             for (uint32_t i = 0; i < state_max_render_target_count; i++)
             {
                 if (RHI_Texture* texture = render_target_color_textures[i])
                 {
                     attachments.emplace_back(texture->Get_Resource_View_RenderTarget(render_target_color_texture_array_index));
+                    owner_ids[i] = texture->GetId();
                 }
             }
-            
+
             // Depth
             if (render_target_depth_texture)
             {
                 attachments.emplace_back(render_target_depth_texture->Get_Resource_View_DepthStencil(render_target_depth_stencil_texture_array_index));
+                owner_ids[state_max_render_target_count] = render_target_depth_texture->GetId();
             }
 
-            // Create a frame buffer
-            if (!create_frame_buffer(m_rhi_device->GetContextRhi(), m_render_pass, attachments, render_target_width, render_target_height, m_frame_buffers[0]))
-                return false;
-            
-            // Name the frame buffer
-            vulkan_utility::debug::set_name(static_cast<VkFramebuffer>(m_frame_buffers[0]), "frame_bufer_texture");
-            
-            return true;
+            // Shading rate
+            if (render_target_shading_rate_texture)
+            {
+                attachments.emplace_back(render_target_shading_rate_texture->Get_Resource_View_RenderTarget(0));
+                owner_ids[state_max_render_target_count + 1] = render_target_shading_rate_texture->GetId();
+            }
         }
 
-        return true;
-    }
-
-    void RHI_PipelineState::DestroyFrameResources()
-    {
-        if (!m_rhi_device)
-            return;
-
-        // Wait in case the buffer is still in use by the graphics queue
-        m_rhi_device->Queue_Wait(RHI_Queue_Graphics);
+        const uint32_t width    = GetWidth();
+        const uint32_t height   = GetHeight();
+        const uint32_t layers   = GetLayerCount();
 
-        for (uint32_t i = 0; i < state_max_render_target_count; i++)
+        size_t hash = reinterpret_cast<size_t>(render_pass);
+        for (void* attachment : attachments)
         {
-            if (void* frame_buffer = m_frame_buffers[i])
-            {
-                vkDestroyFramebuffer(m_rhi_device->GetContextRhi()->device, static_cast<VkFramebuffer>(frame_buffer), nullptr);
-            }
+            Utility::Hash::hash_combine(hash, reinterpret_cast<uint64_t>(attachment));
         }
-        m_frame_buffers.fill(nullptr);
+        Utility::Hash::hash_combine(hash, width);
+        Utility::Hash::hash_combine(hash, height);
+        Utility::Hash::hash_combine(hash, layers);
 
-        // Destroy render pass
-        vkDestroyRenderPass(m_rhi_device->GetContextRhi()->device, static_cast<VkRenderPass>(m_render_pass), nullptr);
-        m_render_pass = nullptr;
+        return vulkan_utility::render_pass_cache::get_frame_buffer(hash, owner_ids, [&](void*& frame_buffer)
+        {
+            if (!create_frame_buffer(rhi_device->GetContextRhi(), render_pass, attachments, width, height, frame_buffer, layers))
+                return false;
+
+            vulkan_utility::debug::set_name(static_cast<VkFramebuffer>(frame_buffer), render_target_swapchain ? "frame_buffer_swapchain" : "frame_buffer_texture");
+            return true;
+        });
     }
 }
@@ -42,11 +42,9 @@ namespace Spartan
 {
 	RHI_Shader::~RHI_Shader()
 	{
-        const auto rhi_context = m_rhi_device->GetContextRhi();
-
 		if (HasResource())
 		{
-			vkDestroyShaderModule(rhi_context->device, static_cast<VkShaderModule>(m_resource), nullptr);
+			vkDestroyShaderModule(m_rhi_device->GetContextRhi()->device, static_cast<VkShaderModule>(m_resource), nullptr);
             m_resource = nullptr;
 		}
 	}
@@ -339,7 +337,7 @@ namespace Spartan
 		};
 	}
 	
-	void* RHI_Shader::_Compile(const string& shader)
+	bool RHI_Shader::_Compile(const string& shader, vector<std::byte>& bytecode)
 	{
 		// Deduce some things
         const auto is_file	    = FileSystem::IsSupportedShaderFile(shader);
@@ -351,10 +349,10 @@ namespace Spartan
 		}
 
         // Get resource shifts
-        wstring shift_buffer    = to_wstring(m_rhi_device->GetContextRhi()->shader_shift_buffer);
-        wstring shift_texture   = to_wstring(m_rhi_device->GetContextRhi()->shader_shift_texture);
-        wstring shift_sampler   = to_wstring(m_rhi_device->GetContextRhi()->shader_shift_sampler);
-        wstring shift_rw_buffer = to_wstring(m_rhi_device->GetContextRhi()->shader_shift_rw_buffer);
+        wstring shift_buffer    = to_wstring(RHI_Context::shader_shift_buffer);
+        wstring shift_texture   = to_wstring(RHI_Context::shader_shift_texture);
+        wstring shift_sampler   = to_wstring(RHI_Context::shader_shift_sampler);
+        wstring shift_rw_buffer = to_wstring(RHI_Context::shader_shift_rw_buffer);
 
         vector<LPCWSTR> arguments =
         {
@@ -379,6 +377,12 @@ namespace Spartan
             arguments.emplace_back(L"-fvk-invert-y");
         }
 
+        if (IsHalfPrecision())
+        {
+            // min16float becomes float16_t instead of a relaxed precision float
+            arguments.emplace_back(L"-enable-16bit-types");
+        }
+
 		// Create standard defines
 		vector<DxcDefine> defines =
 		{
@@ -391,7 +395,7 @@ namespace Spartan
 		map<wstring, wstring> defines_wstring;
 		for (const auto& define : m_defines)
 		{
-			auto first	= FileSystem::StringToWstring(define.first);
+			auto first	= FileSystem::StringToWstring(define.first.Get());
             const auto second = FileSystem::StringToWstring(define.second);
 			defines_wstring[first] = second;
 		}
@@ -419,7 +423,7 @@ namespace Spartan
 			if (FAILED(result))
 			{
 				LOG_ERROR("Failed to create source buffer.");
-				return nullptr;
+				return false;
 			}
 		}
 
@@ -442,52 +446,71 @@ namespace Spartan
 			if (!DxShaderCompiler::ValidateOperationResult(compilation_result))
 			{
 				LOG_ERROR("Failed to compile %s", shader.c_str());
-				return nullptr;
+				return false;
 			}
 		}
 		
+		// Get the bytecode
+		CComPtr<IDxcBlob> shader_compiled = nullptr;
+        if (FAILED(compilation_result->GetResult(&shader_compiled)))
+		{
+            LOG_ERROR("Failed to get shader buffer.");
+            return false;
+		}
+
+        const std::byte* data = static_cast<const std::byte*>(shader_compiled->GetBufferPointer());
+        bytecode.assign(data, data + shader_compiled->GetBufferSize());
+
+        // Reflect shader resources (so that descriptor sets can be created later)
+        _Reflect
+        (
+            m_shader_type,
+            reinterpret_cast<const uint32_t*>(bytecode.data()),
+            static_cast<uint32_t>(bytecode.size() / 4)
+        );
+
+		return true;
+	}
+
+    void* RHI_Shader::_CreateResource(const vector<std::byte>& bytecode)
+    {
 		// Create shader module
-		CComPtr<IDxcBlob> shader_compiled	= nullptr;
-		VkShaderModule shader_module		= nullptr;
-        if (SUCCEEDED(compilation_result->GetResult(&shader_compiled)))
+		VkShaderModuleCreateInfo create_info    = {};
+		create_info.sType		                = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		create_info.codeSize	                = bytecode.size();
+		create_info.pCode		                = reinterpret_cast<const uint32_t*>(bytecode.data());
+
+        VkShaderModule shader_module = nullptr;
+		if (vkCreateShaderModule(m_rhi_device->GetContextRhi()->device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
         {
-			VkShaderModuleCreateInfo create_info = {};
-			create_info.sType		= VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-			create_info.codeSize	= static_cast<size_t>(shader_compiled->GetBufferSize());
-			create_info.pCode		= reinterpret_cast<const uint32_t*>(shader_compiled->GetBufferPointer());
-	
-			if (vkCreateShaderModule(m_rhi_device->GetContextRhi()->device, &create_info, nullptr, &shader_module) == VK_SUCCESS)
-			{
-				// Reflect shader resources (so that descriptor sets can be created later)
-				_Reflect
-				(
-                    m_shader_type,
-					reinterpret_cast<uint32_t*>(shader_compiled->GetBufferPointer()),
-					static_cast<uint32_t>(shader_compiled->GetBufferSize() / 4)
-				);
+            LOG_ERROR("Failed to create shader module.");
+            return nullptr;
+        }
 
-                // Create input layout
-                if (m_vertex_type != RHI_Vertex_Type_Unknown)
-                {
-                    if (!m_input_layout->Create(m_vertex_type, nullptr))
-                    {
-                        LOG_ERROR("Failed to create input layout for %s", FileSystem::GetFileNameFromFilePath(shader).c_str());
-                        return nullptr;
-                    }
-                }
-			}
-            else
+        // Create input layout
+        if (m_vertex_type != RHI_Vertex_Type_Unknown)
+        {
+            if (!m_input_layout->Create(m_vertex_type, nullptr, IsInstanced()))
             {
-                LOG_ERROR("Failed to create shader module.");
+                LOG_ERROR("Failed to create input layout for %s", m_name.c_str());
+                vkDestroyShaderModule(m_rhi_device->GetContextRhi()->device, shader_module, nullptr);
                 return nullptr;
             }
-		}	
-        else
-		{
-            LOG_ERROR("Failed to get shader buffer.");
-            return nullptr;
-		}
+        }
 
 		return static_cast<void*>(shader_module);
-	}		
+	}
+
+    uint32_t RHI_Shader::_GetCompilerVersion() const
+    {
+        CComPtr<IDxcVersionInfo> version_info = nullptr;
+        if (FAILED(DxShaderCompiler::Instance::Get().compiler->QueryInterface(&version_info)))
+            return 0;
+
+        UINT32 major = 0;
+        UINT32 minor = 0;
+        version_info->GetVersion(&major, &minor);
+
+        return (major << 16) | minor;
+    }
 }
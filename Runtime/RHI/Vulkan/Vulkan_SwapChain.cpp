@@ -53,11 +53,13 @@ namespace Spartan
             void*& swap_chain_view_out,
             array<void*, state_max_render_target_count>& resource_textures,
             array<void*, state_max_render_target_count>& resource_views,
-            array<void*, state_max_render_target_count>& image_acquired_semaphores
+            array<void*, state_max_render_target_count>& image_acquired_semaphores,
+            void* swap_chain_old = nullptr
         )
         {
-            // Create surface
-            VkSurfaceKHR surface = nullptr;
+            // Create surface, unless the swap chain is re-created for the surface it already has
+            VkSurfaceKHR surface = static_cast<VkSurfaceKHR>(surface_out);
+            if (!surface)
             {
                 VkWin32SurfaceCreateInfoKHR create_info = {};
                 create_info.sType                       = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
@@ -120,7 +122,7 @@ namespace Spartan
                 create_info.compositeAlpha  = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
                 create_info.presentMode     = vulkan_utility::surface::set_present_mode(surface, flags);
                 create_info.clipped         = VK_TRUE;
-                create_info.oldSwapchain    = nullptr;
+                create_info.oldSwapchain    = static_cast<VkSwapchainKHR>(swap_chain_old); // it's retired, frames in flight can still present its images
 
                 if (!vulkan_utility::error::check(vkCreateSwapchainKHR(rhi_context->device, &create_info, nullptr, &swap_chain)))
                     return false;
@@ -276,6 +278,9 @@ namespace Spartan
         // Command pool
         vulkan_utility::command_pool::destroy(m_cmd_pool);
 
+        // Frame buffers made of the image views
+        vulkan_utility::render_pass_cache::evict(GetId());
+
         // Resources
         _Vulkan_SwapChain::destroy
         (
@@ -306,25 +311,20 @@ namespace Spartan
                 return true;
         }
 
-        // Wait in case any command buffer is still in use
-        m_rhi_device->Queue_WaitAll();
-
 		// Save new dimensions
 		m_width		= width;
 		m_height	= height;
 
-		// Destroy previous swap chain
-		_Vulkan_SwapChain::destroy
-		(
-            m_rhi_device->GetContextRhi(),
-            m_buffer_count,
-			m_surface,
-			m_swap_chain_view,
-			m_resource_view,
-			m_image_acquired_semaphore
-		);
+        // The previous swap chain is retired rather than destroyed, so nothing waits for the frames in flight which still use it
+        vulkan_utility::render_pass_cache::evict(GetId());
+        void* swap_chain_old                                                        = m_swap_chain_view;
+        array<void*, state_max_render_target_count> resource_view_old               = m_resource_view;
+        array<void*, state_max_render_target_count> image_acquired_semaphore_old    = m_image_acquired_semaphore;
+        m_swap_chain_view = nullptr;
+        m_resource_view.fill(nullptr);
+        m_image_acquired_semaphore.fill(nullptr);
 
-		// Create the swap chain with the new dimensions
+		// Create the swap chain with the new dimensions (for the same surface)
 		m_initialized = _Vulkan_SwapChain::create
 		(
             m_rhi_device->GetContextRhi(),
@@ -338,9 +338,19 @@ namespace Spartan
 			m_swap_chain_view,
             m_resource,
 			m_resource_view,
-			m_image_acquired_semaphore
+			m_image_acquired_semaphore,
+            swap_chain_old
 		);
 
+        // Release the previous one once those frames retire (everything but the surface, which the new swap chain uses)
+        const RHI_Context* rhi_context  = m_rhi_device->GetContextRhi();
+        const uint8_t buffer_count      = static_cast<uint8_t>(m_buffer_count);
+        m_rhi_device->DeletionQueue_Add([rhi_context, buffer_count, swap_chain_old, resource_view_old, image_acquired_semaphore_old]() mutable
+        {
+            void* surface = nullptr;
+            _Vulkan_SwapChain::destroy(rhi_context, buffer_count, surface, swap_chain_old, resource_view_old, image_acquired_semaphore_old);
+        });
+
 		return m_initialized;
 	}
 
@@ -349,6 +359,18 @@ namespace Spartan
         if (!m_present)
             return true;
 
+        // Frame pacing, the CPU doesn't get more than rhi_frames_in_flight_max frames ahead of the GPU.
+        // In low latency mode it waits for the previous frame, so input is sampled as late as possible.
+        const uint64_t frames_in_flight = (m_flags & RHI_SwapChain_Low_Latency) ? 1 : rhi_frames_in_flight_max;
+        if (m_rhi_device->Queue_HasTimeline() && m_frame_count >= frames_in_flight)
+        {
+            if (!m_rhi_device->Queue_WaitValue(RHI_Queue_Graphics, m_frame_timeline_values[(m_frame_count - frames_in_flight) % rhi_frames_in_flight_max]))
+            {
+                LOG_ERROR("Failed to wait for a frame in flight");
+                return false;
+            }
+        }
+
         bool first_run              = !m_image_acquired;
         m_cmd_index                 = first_run ? 0 : (m_image_index + 1) % m_buffer_count;
         bool reset_pool             = !first_run && m_cmd_index == 0;
@@ -392,12 +414,37 @@ namespace Spartan
             return false;
         }
 
+        m_frame_timeline_values[m_frame_count % rhi_frames_in_flight_max] = GetCmdList()->GetTimelineValue();
+        m_frame_count++;
+
+        // A different present mode was requested
+        if (m_recreate)
+        {
+            m_recreate = false;
+            if (!Resize(m_width, m_height, true))
+                return false;
+        }
+
         if (!AcquireNextImage())
             return false;
 
         return true;
 	}
 
+    bool RHI_SwapChain::SetPresentMode(const uint32_t flags)
+    {
+        const uint32_t flags_new = (m_flags & ~(rhi_present_mode_mask | RHI_SwapChain_Low_Latency)) | (flags & (rhi_present_mode_mask | RHI_SwapChain_Low_Latency));
+        if (flags_new == m_flags)
+            return true;
+
+        // Low latency only affects frame pacing, but the present mode is baked into the swapchain.
+        // An image of the current swapchain is already acquired, so the re-creation waits for the next Present().
+        m_recreate  = m_recreate || (flags_new & rhi_present_mode_mask) != (m_flags & rhi_present_mode_mask);
+        m_flags     = flags_new;
+
+        return true;
+    }
+
     void RHI_SwapChain::SetLayout(RHI_Image_Layout layout, RHI_CommandList* command_list /*= nullptr*/)
     {
         if (m_layout == layout)
@@ -67,7 +67,7 @@ namespace Spartan
         }
     }
 
-    inline bool copy_to_staging_buffer(RHI_Texture* texture, std::vector<VkBufferImageCopy>& buffer_image_copies, void*& staging_buffer)
+    inline bool copy_to_staging_buffer(RHI_Texture* texture, std::vector<VkBufferImageCopy>& buffer_image_copies, vulkan_utility::staging_ring::allocation& staging, bool& use_ring)
     {
         if (!texture->HasData())
         {
@@ -75,11 +75,10 @@ namespace Spartan
             return true;
         }
 
-        const uint32_t width            = texture->GetWidth();
-        const uint32_t height           = texture->GetHeight();
+        const uint32_t width            = texture->GetWidthResident();
+        const uint32_t height           = texture->GetHeightResident();
         const uint32_t array_size       = texture->GetArraySize();
         const uint32_t mip_levels       = texture->GetMiplevels();
-        const uint32_t bytes_per_pixel  = texture->GetBytesPerPixel();
 
         // Fill out VkBufferImageCopy structs describing the array and the mip levels   
         VkDeviceSize buffer_offset = 0;
@@ -87,8 +86,8 @@ namespace Spartan
         {
             for (uint32_t mip_index = 0; mip_index < mip_levels; mip_index++)
             {
-                uint32_t mip_width  = width >> mip_index;
-                uint32_t mip_height = height >> mip_index;
+                uint32_t mip_width  = Math::Helper::Max(width >> mip_index, 1u);
+                uint32_t mip_height = Math::Helper::Max(height >> mip_index, 1u);
 
                 VkBufferImageCopy region				= {};
                 region.bufferOffset						= buffer_offset;
@@ -104,29 +103,47 @@ namespace Spartan
                 buffer_image_copies[mip_index] = region;
 
                 // Update staging buffer memory requirement (in bytes)
-                buffer_offset += mip_width * mip_height * bytes_per_pixel;
+                buffer_offset += texture->GetMipByteCount(mip_width, mip_height);
             }
         }
 
-        // Create staging buffer
-        VmaAllocation allocation = vulkan_utility::buffer::create(staging_buffer, buffer_offset, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        // Get staging memory, from the staging ring if it fits, otherwise from a dedicated staging buffer
+        const VkDeviceSize staging_size = buffer_offset;
+        use_ring                        = vulkan_utility::staging_ring::allocate(staging_size, staging);
+        VmaAllocation allocation        = nullptr;
+        if (use_ring)
+        {
+            for (VkBufferImageCopy& region : buffer_image_copies)
+            {
+                region.bufferOffset += staging.offset;
+            }
+        }
+        else
+        {
+            allocation = vulkan_utility::buffer::create(staging.buffer, staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            if (!allocation)
+                return false;
+        }
 
         // Copy array and mip level data to the staging buffer
-        void* data = nullptr;
+        void* data = use_ring ? staging.mapped : nullptr;
         buffer_offset = 0;
-        if (vulkan_utility::error::check(vmaMapMemory(vulkan_utility::globals::rhi_context->allocator, allocation, &data)))
+        if (use_ring || vulkan_utility::error::check(vmaMapMemory(vulkan_utility::globals::rhi_context->allocator, allocation, &data)))
         {
             for (uint32_t array_index = 0; array_index < array_size; array_index++)
             {
                 for (uint32_t mip_index = 0; mip_index < mip_levels; mip_index++)
                 {
-                    uint64_t buffer_size = (width >> mip_index) * (height >> mip_index) * bytes_per_pixel;
-                    memcpy(static_cast<std::byte*>(data) + buffer_offset, texture->GetData(array_index + mip_index)->data(), buffer_size);
+                    uint64_t buffer_size = texture->GetMipByteCount(Math::Helper::Max(width >> mip_index, 1u), Math::Helper::Max(height >> mip_index, 1u));
+                    memcpy(static_cast<std::byte*>(data) + buffer_offset, texture->GetMipData(array_index + mip_index), buffer_size);
                     buffer_offset += buffer_size;
                 }
             }
 
-            vmaUnmapMemory(vulkan_utility::globals::rhi_context->allocator, allocation);
+            if (!use_ring)
+            {
+                vmaUnmapMemory(vulkan_utility::globals::rhi_context->allocator, allocation);
+            }
         }
 
         return true;
@@ -134,62 +151,75 @@ namespace Spartan
 
     inline bool stage(RHI_Texture* texture, RHI_Image_Layout& texture_layout)
     {
-        // Copy the texture's data to a staging buffer
-        void* staging_buffer = nullptr;
+        // Copy the texture's data to staging memory
+        vulkan_utility::staging_ring::allocation staging;
+        bool use_ring = false;
         std::vector<VkBufferImageCopy> buffer_image_copies(texture->GetMiplevels());
-        if (!copy_to_staging_buffer(texture, buffer_image_copies, staging_buffer))
+        if (!copy_to_staging_buffer(texture, buffer_image_copies, staging, use_ring))
             return false;
 
-        // Copy the staging buffer into the image
-        if (VkCommandBuffer cmd_buffer = vulkan_utility::command_buffer_immediate::begin(RHI_Queue_Graphics))
+        // Copy the staging memory into the image, on the transfer queue (the transitions it needs are transfer and host stages only)
+        bool result = false;
+        if (VkCommandBuffer cmd_buffer = vulkan_utility::command_buffer_immediate::begin(RHI_Queue_Transfer))
         {
             // Optimal layout for images which are the destination of a transfer format
             RHI_Image_Layout layout = RHI_Image_Transfer_Dst_Optimal;
 
             // Transition to layout
-            if (!vulkan_utility::image::set_layout(cmd_buffer, texture, layout))
-                return false;
-
-            // Copy the staging buffer to the image
-            vkCmdCopyBufferToImage(
-                cmd_buffer,
-                static_cast<VkBuffer>(staging_buffer),
-                static_cast<VkImage>(texture->Get_Resource()),
-                vulkan_image_layout[layout],
-                static_cast<uint32_t>(buffer_image_copies.size()),
-                buffer_image_copies.data()
-            );
-
-            // End/flush
-            if (!vulkan_utility::command_buffer_immediate::end(RHI_Queue_Graphics))
-                return false;
-
-            // Free staging buffer
-            vulkan_utility::buffer::destroy(staging_buffer);
+            if (vulkan_utility::image::set_layout(cmd_buffer, texture, layout))
+            {
+                // Copy the staging buffer to the image
+                vkCmdCopyBufferToImage(
+                    cmd_buffer,
+                    static_cast<VkBuffer>(staging.buffer),
+                    static_cast<VkImage>(texture->Get_Resource()),
+                    vulkan_image_layout[layout],
+                    static_cast<uint32_t>(buffer_image_copies.size()),
+                    buffer_image_copies.data()
+                );
+
+                // End/flush
+                result = vulkan_utility::command_buffer_immediate::end(RHI_Queue_Transfer);
+            }
 
             // Let the texture know about it's new layout
-            texture_layout = layout;
+            if (result)
+            {
+                texture_layout = layout;
+            }
         }
 
-        return true;
+        // Release the staging memory
+        if (use_ring)
+        {
+            vulkan_utility::staging_ring::release(staging);
+        }
+        else
+        {
+            vulkan_utility::buffer::destroy(staging.buffer);
+        }
+
+        return result;
     }
 
     RHI_Texture2D::~RHI_Texture2D()
+    {
+        m_data.clear();
+        DestroyResourceGpu();
+    }
+
+    void RHI_Texture2D::DestroyResourceGpu()
     {
         if (!m_rhi_device->IsInitialized())
             return;
 
-        m_rhi_device->Queue_WaitAll();
-        m_data.clear();
-
-        vulkan_utility::image::view::destroy(m_resource_view[0]);
-        vulkan_utility::image::view::destroy(m_resource_view[1]);
-        for (uint32_t i = 0; i < state_max_render_target_count; i++)
-        {
-            vulkan_utility::image::view::destroy(m_resource_view_depthStencil[i]);
-            vulkan_utility::image::view::destroy(m_resource_view_renderTarget[i]);
-        }
-        vulkan_utility::image::destroy(this);
+        // The frames in flight could still be reading it, so it's released once they retire (along with any frame buffer made of its views)
+        vulkan_utility::render_pass_cache::evict(GetId());
+        vulkan_utility::image::view::destroy_deferred(m_resource_view[0]);
+        vulkan_utility::image::view::destroy_deferred(m_resource_view[1]);
+        vulkan_utility::image::view::destroy_deferred(m_resource_view_depthStencil);
+        vulkan_utility::image::view::destroy_deferred(m_resource_view_renderTarget);
+        vulkan_utility::image::destroy_deferred(this);
 	}
 
     void RHI_Texture::SetLayout(const RHI_Image_Layout new_layout, RHI_CommandList* command_list /*= nullptr*/)
@@ -304,6 +334,22 @@ namespace Spartan
                 }
             }
 
+            // A view of all the slices, the vertex shader picks one (cubes are viewed as arrays, a cube view can't be an attachment)
+            if (m_array_size > 1 && m_array_size < state_max_render_target_count)
+            {
+                if (IsRenderTargetColor())
+                {
+                    if (!vulkan_utility::image::view::create(m_resource, m_resource_view_renderTarget[m_array_size], VK_IMAGE_VIEW_TYPE_2D_ARRAY, vulkan_format[m_format], vulkan_utility::image::get_aspect_mask(this), 1, 0, m_array_size))
+                        return false;
+                }
+
+                if (IsRenderTargetDepthStencil())
+                {
+                    if (!vulkan_utility::image::view::create(m_resource, m_resource_view_depthStencil[m_array_size], VK_IMAGE_VIEW_TYPE_2D_ARRAY, vulkan_format[m_format], vulkan_utility::image::get_aspect_mask(this, true), 1, 0, m_array_size))
+                        return false;
+                }
+            }
+
             // Name the image and image view(s)
             set_debug_name(this);
         }
@@ -318,17 +364,15 @@ namespace Spartan
         if (!m_rhi_device->IsInitialized())
             return;
 
-        m_rhi_device->Queue_WaitAll();
         m_data.clear();
 
-        vulkan_utility::image::view::destroy(m_resource_view[0]);
-        vulkan_utility::image::view::destroy(m_resource_view[1]);
-        for (uint32_t i = 0; i < state_max_render_target_count; i++)
-        {
-            vulkan_utility::image::view::destroy(m_resource_view_depthStencil[i]);
-            vulkan_utility::image::view::destroy(m_resource_view_renderTarget[i]);
-        }
-        vulkan_utility::image::destroy(this);
+        // The frames in flight could still be reading it, so it's released once they retire (along with any frame buffer made of its views)
+        vulkan_utility::render_pass_cache::evict(GetId());
+        vulkan_utility::image::view::destroy_deferred(m_resource_view[0]);
+        vulkan_utility::image::view::destroy_deferred(m_resource_view[1]);
+        vulkan_utility::image::view::destroy_deferred(m_resource_view_depthStencil);
+        vulkan_utility::image::view::destroy_deferred(m_resource_view_renderTarget);
+        vulkan_utility::image::destroy_deferred(this);
 	}
 
 	bool RHI_TextureCube::CreateResourceGpu()
@@ -413,6 +457,22 @@ namespace Spartan
                 }
             }
 
+            // A view of all the slices, the vertex shader picks one (cubes are viewed as arrays, a cube view can't be an attachment)
+            if (m_array_size > 1 && m_array_size < state_max_render_target_count)
+            {
+                if (IsRenderTargetColor())
+                {
+                    if (!vulkan_utility::image::view::create(m_resource, m_resource_view_renderTarget[m_array_size], VK_IMAGE_VIEW_TYPE_2D_ARRAY, vulkan_format[m_format], vulkan_utility::image::get_aspect_mask(this), 1, 0, m_array_size))
+                        return false;
+                }
+
+                if (IsRenderTargetDepthStencil())
+                {
+                    if (!vulkan_utility::image::view::create(m_resource, m_resource_view_depthStencil[m_array_size], VK_IMAGE_VIEW_TYPE_2D_ARRAY, vulkan_format[m_format], vulkan_utility::image::get_aspect_mask(this, true), 1, 0, m_array_size))
+                        return false;
+                }
+            }
+
             // Name the image and image view(s)
             set_debug_name(this);
         }
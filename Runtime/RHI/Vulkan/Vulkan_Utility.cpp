@@ -39,9 +39,19 @@ namespace Spartan::vulkan_utility
     PFN_vkCmdBeginDebugUtilsLabelEXT                                        functions::marker_begin                             = nullptr;
     PFN_vkCmdEndDebugUtilsLabelEXT                                          functions::marker_end                               = nullptr;
     PFN_vkGetPhysicalDeviceMemoryProperties2KHR                             functions::get_physical_device_memory_properties_2  = nullptr;
-    mutex                                                                   command_buffer_immediate::m_mutex_begin;
-    mutex                                                                   command_buffer_immediate::m_mutex_end;
-    unordered_map<RHI_Queue_Type, command_buffer_immediate::cmdbi_object>   command_buffer_immediate::m_objects;
+    PFN_vkCmdBeginRenderingKHR                                              functions::begin_rendering                          = nullptr;
+    PFN_vkCmdEndRenderingKHR                                                functions::end_rendering                            = nullptr;
+    mutex                                                                                       command_buffer_immediate::m_mutex;
+    unordered_map<RHI_Queue_Type, vector<unique_ptr<command_buffer_immediate::cmdbi_object>>>   command_buffer_immediate::m_objects;
+    thread_local array<command_buffer_immediate::cmdbi_object*, RHI_Queue_Undefined>            command_buffer_immediate::m_recording = {};
+    void*                                                                                       staging_ring::m_buffer  = nullptr;
+    std::byte*                                                                                  staging_ring::m_mapped  = nullptr;
+    uint64_t                                                                                    staging_ring::m_head    = 0;
+    deque<staging_ring::region>                                                                 staging_ring::m_regions;
+    mutex                                                                                       staging_ring::m_mutex;
+    unordered_map<size_t, void*>                                                                render_pass_cache::m_render_passes;
+    unordered_map<size_t, render_pass_cache::frame_buffer>                                      render_pass_cache::m_frame_buffers;
+    mutex                                                                                       render_pass_cache::m_mutex;
 
 	bool image::create(RHI_Texture* texture)
 	{
@@ -72,8 +82,8 @@ namespace Spartan::vulkan_utility
         create_info.sType               = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         create_info.imageType           = VK_IMAGE_TYPE_2D;
         create_info.flags               = (texture->GetResourceType() == Resource_TextureCube) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
-        create_info.extent.width        = texture->GetWidth();
-        create_info.extent.height       = texture->GetHeight();
+        create_info.extent.width        = texture->GetWidthResident();
+        create_info.extent.height       = texture->GetHeightResident();
         create_info.extent.depth        = 1;
         create_info.mipLevels           = texture->GetMiplevels();
         create_info.arrayLayers         = texture->GetArraySize();
@@ -84,18 +94,36 @@ namespace Spartan::vulkan_utility
         create_info.samples             = VK_SAMPLE_COUNT_1_BIT;
         create_info.sharingMode         = VK_SHARING_MODE_EXCLUSIVE;
 
+        // Images with data are uploaded on the transfer queue and then used on the graphics queue, sharing them
+        // between the two families saves the ownership transfers (which would need a barrier on each queue)
+        const uint32_t queue_family_indices[] = { globals::rhi_context->queue_graphics_index, globals::rhi_context->queue_transfer_index };
+        if (texture->HasData() && queue_family_indices[0] != queue_family_indices[1])
+        {
+            create_info.sharingMode             = VK_SHARING_MODE_CONCURRENT;
+            create_info.queueFamilyIndexCount   = 2;
+            create_info.pQueueFamilyIndices     = queue_family_indices;
+        }
+
+        const bool is_render_target             = (texture->GetFlags() & (RHI_Texture_RenderTargetView | RHI_Texture_DepthStencilView)) != 0;
         VmaAllocationCreateInfo allocation_info = {};
         allocation_info.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+        allocation_info.pool                    = globals::rhi_context->memory_pools[is_render_target ? RHI_Memory_Pool_RenderTarget : RHI_Memory_Pool_Texture];
 
         // Create image, allocate memory and bind memory to image
         VmaAllocation allocation;
         void* resource = nullptr;
-        if (!error::check(vmaCreateImage(globals::rhi_context->allocator, &create_info, &allocation_info, reinterpret_cast<VkImage*>(&resource), &allocation, nullptr)))
-            return false;
+        if (vmaCreateImage(globals::rhi_context->allocator, &create_info, &allocation_info, reinterpret_cast<VkImage*>(&resource), &allocation, nullptr) != VK_SUCCESS)
+        {
+            // The pool's memory type doesn't suit every format (e.g. depth on some hardware), fall back to the default pools
+            allocation_info.pool = nullptr;
+            if (!error::check(vmaCreateImage(globals::rhi_context->allocator, &create_info, &allocation_info, reinterpret_cast<VkImage*>(&resource), &allocation, nullptr)))
+                return false;
+        }
 
         texture->Set_Resource(resource);
 
         // Keep allocation reference
+        lock_guard<mutex> lock(globals::rhi_context->mutex_allocations);
         globals::rhi_context->allocations[texture->GetId()] = allocation;
 
         return true;
@@ -106,6 +134,7 @@ namespace Spartan::vulkan_utility
         void* resource          = texture->Get_Resource();
         uint64_t allocation_id  = texture->GetId();
 
+        lock_guard<mutex> lock(globals::rhi_context->mutex_allocations);
         auto it = globals::rhi_context->allocations.find(allocation_id);
         if (it != globals::rhi_context->allocations.end())
         {
@@ -116,6 +145,25 @@ namespace Spartan::vulkan_utility
         }
     }
 
+    void image::destroy_deferred(RHI_Texture* texture)
+    {
+        // The allocation is unregistered right away, the texture can create a new image under the same id before this one is released
+        void* resource              = texture->Get_Resource();
+        VmaAllocation allocation    = nullptr;
+        {
+            lock_guard<mutex> lock(globals::rhi_context->mutex_allocations);
+            auto it = globals::rhi_context->allocations.find(texture->GetId());
+            if (it == globals::rhi_context->allocations.end())
+                return;
+
+            allocation = it->second;
+            globals::rhi_context->allocations.erase(it);
+        }
+        texture->Set_Resource(nullptr);
+
+        globals::rhi_device->DeletionQueue_Add([resource, allocation]() { vmaDestroyImage(globals::rhi_context->allocator, static_cast<VkImage>(resource), allocation); });
+    }
+
     VmaAllocation buffer::create(void*& _buffer, const uint64_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_property_flags, const bool written_frequently /*= false*/, const void* data /*= nullptr*/)
     {
         VmaAllocator allocator = globals::rhi_context->allocator;
@@ -126,20 +174,37 @@ namespace Spartan::vulkan_utility
         buffer_create_info.usage				= usage;
         buffer_create_info.sharingMode			= VK_SHARING_MODE_EXCLUSIVE;
 
-        bool used_for_staging = (usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) != 0;
+        bool used_for_staging   = (usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) != 0;
+        bool is_geometry        = !used_for_staging && !written_frequently && (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) != 0;
 
         VmaAllocationCreateInfo allocation_create_info  = {};
         allocation_create_info.usage                    = used_for_staging ? VMA_MEMORY_USAGE_CPU_ONLY : (written_frequently ? VMA_MEMORY_USAGE_CPU_TO_GPU : VMA_MEMORY_USAGE_GPU_ONLY);
         allocation_create_info.preferredFlags           = memory_property_flags;
+        allocation_create_info.pool                     = used_for_staging ? globals::rhi_context->memory_pools[RHI_Memory_Pool_Staging] : (is_geometry ? globals::rhi_context->memory_pools[RHI_Memory_Pool_Geometry] : nullptr);
 
         // Create buffer, allocate memory and bind it to the buffer
         VmaAllocation allocation = nullptr;
         VmaAllocationInfo allocation_info;
-        if (!error::check(vmaCreateBuffer(allocator, &buffer_create_info, &allocation_create_info, reinterpret_cast<VkBuffer*>(&_buffer), &allocation, &allocation_info)))
-            return false;
+        if (vmaCreateBuffer(allocator, &buffer_create_info, &allocation_create_info, reinterpret_cast<VkBuffer*>(&_buffer), &allocation, &allocation_info) != VK_SUCCESS)
+        {
+            // Fall back to the default pools
+            allocation_create_info.pool = nullptr;
+            is_geometry                 = false;
+            if (!error::check(vmaCreateBuffer(allocator, &buffer_create_info, &allocation_create_info, reinterpret_cast<VkBuffer*>(&_buffer), &allocation, &allocation_info)))
+                return false;
+        }
 
         // Keep allocation reference
-        globals::rhi_context->allocations[reinterpret_cast<uint64_t>(_buffer)] = allocation;
+        {
+            lock_guard<mutex> lock(globals::rhi_context->mutex_allocations);
+            globals::rhi_context->allocations[reinterpret_cast<uint64_t>(_buffer)] = allocation;
+
+            // Geometry is never mapped, so defragmentation can move it (once its data is uploaded, see upload())
+            if (is_geometry)
+            {
+                globals::rhi_context->allocations_movable[allocation] = { nullptr, size, usage };
+            }
+        }
 
         // If a pointer to the buffer data has been passed, map the buffer and copy over the data
         if (data != nullptr)
@@ -192,13 +257,269 @@ namespace Spartan::vulkan_utility
             return;
 
         uint64_t allocation_id = reinterpret_cast<uint64_t>(_buffer);
+        lock_guard<mutex> lock(globals::rhi_context->mutex_allocations);
         auto it = globals::rhi_context->allocations.find(allocation_id);
         if (it != globals::rhi_context->allocations.end())
         {
             VmaAllocation allocation = it->second;
             vmaDestroyBuffer(globals::rhi_context->allocator, static_cast<VkBuffer>(_buffer), allocation);
+            globals::rhi_context->allocations_movable.erase(allocation);
             globals::rhi_context->allocations.erase(allocation_id);
             _buffer = nullptr;
         }
     }
+
+    void buffer::destroy_deferred(void*& _buffer)
+    {
+        if (!_buffer)
+            return;
+
+        // Defragmentation must not move it while it waits, its owner is about to forget it
+        {
+            lock_guard<mutex> lock(globals::rhi_context->mutex_allocations);
+            auto it = globals::rhi_context->allocations.find(reinterpret_cast<uint64_t>(_buffer));
+            if (it != globals::rhi_context->allocations.end())
+            {
+                auto it_movable = globals::rhi_context->allocations_movable.find(it->second);
+                if (it_movable != globals::rhi_context->allocations_movable.end())
+                {
+                    it_movable->second.owner = nullptr;
+                }
+            }
+        }
+
+        void* buffer_retired = _buffer;
+        _buffer = nullptr;
+        globals::rhi_device->DeletionQueue_Add([buffer_retired]() mutable { destroy(buffer_retired); });
+    }
+
+    bool buffer::upload(void*& _buffer, const void* data, const uint64_t size)
+    {
+        // Stage
+        staging_ring::allocation staging;
+        const bool use_ring = staging_ring::allocate(size, staging);
+        if (use_ring)
+        {
+            memcpy(staging.mapped, data, size);
+        }
+        else if (!create(staging.buffer, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false, data))
+        {
+            return false;
+        }
+
+        // Copy
+        bool result = false;
+        if (VkCommandBuffer cmd_buffer = command_buffer_immediate::begin(RHI_Queue_Transfer))
+        {
+            VkBufferCopy copy_region    = {};
+            copy_region.srcOffset       = staging.offset;
+            copy_region.size            = size;
+            vkCmdCopyBuffer(cmd_buffer, static_cast<VkBuffer>(staging.buffer), static_cast<VkBuffer>(_buffer), 1, &copy_region);
+
+            // Submit and wait for this copy (only)
+            result = command_buffer_immediate::end(RHI_Queue_Transfer);
+        }
+
+        // Release the staging memory
+        if (use_ring)
+        {
+            staging_ring::release(staging);
+        }
+        else
+        {
+            destroy(staging.buffer);
+        }
+
+        // The buffer is ready, from now on defragmentation can move it
+        if (result)
+        {
+            lock_guard<mutex> lock(globals::rhi_context->mutex_allocations);
+            auto it = globals::rhi_context->allocations.find(reinterpret_cast<uint64_t>(_buffer));
+            if (it != globals::rhi_context->allocations.end())
+            {
+                auto it_movable = globals::rhi_context->allocations_movable.find(it->second);
+                if (it_movable != globals::rhi_context->allocations_movable.end())
+                {
+                    it_movable->second.owner = &_buffer;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    bool staging_ring::allocate(const uint64_t size, allocation& _allocation)
+    {
+        const uint64_t size_aligned = (size + m_alignment - 1) & ~(m_alignment - 1);
+
+        // Big uploads would hold most of the ring on their own
+        if (size_aligned > m_capacity / 2)
+            return false;
+
+        lock_guard<mutex> lock(m_mutex);
+
+        // Create on first use
+        if (!m_buffer)
+        {
+            VmaAllocation vma_allocation = buffer::create(m_buffer, m_capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            if (!vma_allocation || !error::check(vmaMapMemory(globals::rhi_context->allocator, vma_allocation, reinterpret_cast<void**>(&m_mapped))))
+            {
+                LOG_ERROR("Failed to create the staging ring");
+                buffer::destroy(m_buffer);
+                return false;
+            }
+
+            debug::set_name(static_cast<VkBuffer>(m_buffer), "staging_ring");
+        }
+
+        // Find room after the head, the space up to the oldest allocation which is still in use is free
+        const uint64_t tail = m_regions.empty() ? m_head : m_regions.front().offset;
+        uint64_t offset     = m_head;
+        if (m_regions.empty() || m_head > tail)
+        {
+            // Free: [head, capacity) and [0, tail), wrap around if the end doesn't fit
+            if (offset + size_aligned > m_capacity)
+            {
+                offset = 0;
+                if (!m_regions.empty() && size_aligned > tail)
+                    return false;
+            }
+        }
+        else if (offset + size_aligned > tail) // free: [head, tail)
+        {
+            return false;
+        }
+
+        m_head = offset + size_aligned;
+        m_regions.push_back({ offset, size_aligned, false });
+
+        _allocation.buffer  = m_buffer;
+        _allocation.offset  = offset;
+        _allocation.mapped  = m_mapped + offset;
+
+        return true;
+    }
+
+    void staging_ring::release(const allocation& _allocation)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        for (region& region : m_regions)
+        {
+            if (region.offset == _allocation.offset)
+            {
+                region.released = true;
+                break;
+            }
+        }
+
+        // Move the tail past everything which is no longer in use
+        while (!m_regions.empty() && m_regions.front().released)
+        {
+            m_regions.pop_front();
+        }
+    }
+
+    void staging_ring::destroy()
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        if (!m_buffer)
+            return;
+
+        auto it = globals::rhi_context->allocations.find(reinterpret_cast<uint64_t>(m_buffer));
+        if (it != globals::rhi_context->allocations.end())
+        {
+            vmaUnmapMemory(globals::rhi_context->allocator, it->second);
+        }
+
+        buffer::destroy(m_buffer);
+        m_mapped = nullptr;
+        m_head   = 0;
+        m_regions.clear();
+    }
+
+    void* render_pass_cache::get_render_pass(const size_t hash, const function<bool(void*&)>& create)
+    {
+        // Pipelines are created on the shader threads too
+        lock_guard<mutex> lock(m_mutex);
+
+        auto it = m_render_passes.find(hash);
+        if (it != m_render_passes.end())
+            return it->second;
+
+        void* render_pass = nullptr;
+        if (!create(render_pass))
+            return nullptr;
+
+        m_render_passes[hash] = render_pass;
+        return render_pass;
+    }
+
+    void* render_pass_cache::get_frame_buffer(const size_t hash, const array<uint32_t, state_max_render_target_count + 2>& owner_ids, const function<bool(void*&)>& create)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto it = m_frame_buffers.find(hash);
+        if (it != m_frame_buffers.end())
+            return it->second.resource;
+
+        frame_buffer entry;
+        entry.owner_ids = owner_ids;
+        if (!create(entry.resource))
+            return nullptr;
+
+        m_frame_buffers[hash] = entry;
+        return entry.resource;
+    }
+
+    void render_pass_cache::evict(const uint32_t owner_id)
+    {
+        if (owner_id == 0)
+            return;
+
+        lock_guard<mutex> lock(m_mutex);
+
+        for (auto it = m_frame_buffers.begin(); it != m_frame_buffers.end();)
+        {
+            const auto& owner_ids = it->second.owner_ids;
+            if (find(owner_ids.begin(), owner_ids.end(), owner_id) == owner_ids.end())
+            {
+                it++;
+                continue;
+            }
+
+            // The frames in flight could still be rendering to it
+            RHI_Context* rhi_context    = globals::rhi_context;
+            void* resource              = it->second.resource;
+            function<void()> release    = [rhi_context, resource]() { vkDestroyFramebuffer(rhi_context->device, static_cast<VkFramebuffer>(resource), nullptr); };
+            if (globals::rhi_device->IsInitialized())
+            {
+                globals::rhi_device->DeletionQueue_Add(move(release));
+            }
+            else
+            {
+                release();
+            }
+
+            it = m_frame_buffers.erase(it);
+        }
+    }
+
+    void render_pass_cache::destroy()
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        for (const auto& it : m_frame_buffers)
+        {
+            vkDestroyFramebuffer(globals::rhi_context->device, static_cast<VkFramebuffer>(it.second.resource), nullptr);
+        }
+        m_frame_buffers.clear();
+
+        for (const auto& it : m_render_passes)
+        {
+            vkDestroyRenderPass(globals::rhi_context->device, static_cast<VkRenderPass>(it.second), nullptr);
+        }
+        m_render_passes.clear();
+    }
 }
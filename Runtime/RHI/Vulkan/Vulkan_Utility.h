@@ -29,7 +29,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_DepthStencilState.h"
 #include "../../Logging/Log.h"
 #include "../../Math/Vector4.h"
+#include <algorithm>
 #include <array>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
 #include <unordered_map>
 #include <atomic>
 //===================================
@@ -253,6 +258,37 @@ namespace Spartan::vulkan_utility
             return error::check(vkCreateSemaphore(globals::rhi_context->device, &semaphore_info, nullptr, semaphore_vk));
         }
 
+        inline bool create_timeline(void*& semaphore, const uint64_t initial_value = 0)
+        {
+            VkSemaphoreTypeCreateInfo type_info = {};
+            type_info.sType                     = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            type_info.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+            type_info.initialValue              = initial_value;
+
+            VkSemaphoreCreateInfo semaphore_info    = {};
+            semaphore_info.sType                    = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphore_info.pNext                    = &type_info;
+
+            VkSemaphore* semaphore_vk = reinterpret_cast<VkSemaphore*>(&semaphore);
+            return error::check(vkCreateSemaphore(globals::rhi_context->device, &semaphore_info, nullptr, semaphore_vk));
+        }
+
+        // Returns immediately if the timeline has already reached the value
+        inline bool wait_timeline(VkSemaphore semaphore, const uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max())
+        {
+            uint64_t value_current = 0;
+            if (error::check(vkGetSemaphoreCounterValue(globals::rhi_context->device, semaphore, &value_current)) && value_current >= value)
+                return true;
+
+            VkSemaphoreWaitInfo wait_info   = {};
+            wait_info.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            wait_info.semaphoreCount        = 1;
+            wait_info.pSemaphores           = &semaphore;
+            wait_info.pValues               = &value;
+
+            return error::check(vkWaitSemaphores(globals::rhi_context->device, &wait_info, timeout));
+        }
+
         inline void destroy(void*& semaphore)
         {
             if (!semaphore)
@@ -344,7 +380,8 @@ namespace Spartan::vulkan_utility
         }
     }
 
-    // Thread-safe immediate command buffer
+    // Thread-safe immediate command buffers. Every queue has a pool of them, so threads which upload at the same time don't queue up
+    // behind each other, and a submission only waits for its own fence (not for the whole queue to go idle, which would stall the frame).
     class command_buffer_immediate
     {
     public:
@@ -356,18 +393,13 @@ namespace Spartan::vulkan_utility
             cmdbi_object() = default;
             ~cmdbi_object()
             {
+                fence::destroy(fence);
                 command_buffer::destroy(cmd_pool, cmd_buffer);
                 command_pool::destroy(cmd_pool);
             }
 
             bool begin(const RHI_Queue_Type queue_type)
             {
-                // Wait
-                while (recording)
-                {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(16));
-                }
-
                 // Initialise
                 if (!initialised)
                 {
@@ -379,6 +411,10 @@ namespace Spartan::vulkan_utility
                     if (!command_buffer::create(cmd_pool, cmd_buffer, VK_COMMAND_BUFFER_LEVEL_PRIMARY))
                         return false;
 
+                    // Create the fence which the submission signals
+                    if (!fence::create(fence))
+                        return false;
+
                     initialised = true;
                     this->queue_type = queue_type;
                 }
@@ -390,12 +426,7 @@ namespace Spartan::vulkan_utility
                 VkCommandBufferBeginInfo begin_info = {};
                 begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
                 begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-                if (error::check(vkBeginCommandBuffer(static_cast<VkCommandBuffer>(cmd_buffer), &begin_info)))
-                {
-                    recording = true;
-                }
-
-                return recording;
+                return error::check(vkBeginCommandBuffer(static_cast<VkCommandBuffer>(cmd_buffer), &begin_info));
             }
 
             bool submit()
@@ -406,36 +437,30 @@ namespace Spartan::vulkan_utility
                     return false;
                 }
 
-                if (!recording)
-                {
-                    LOG_ERROR("Can't submit as the command buffer didn't record anything");
-                    return false;
-                }
-
                 if (!error::check(vkEndCommandBuffer(static_cast<VkCommandBuffer>(cmd_buffer))))
                 {
                     LOG_ERROR("Failed to end command buffer");
                     return false;
                 }
 
-                if (!globals::rhi_device->Queue_Submit(queue_type, cmd_buffer))
+                if (!globals::rhi_device->Queue_Submit(queue_type, cmd_buffer, nullptr, nullptr, fence))
                 {
                     LOG_ERROR("Failed to submit to queue");
                     return false;
                 }
 
-                if (!globals::rhi_device->Queue_Wait(queue_type))
+                if (!fence::wait(fence) || !fence::reset(fence))
                 {
-                    LOG_ERROR("Failed to wait for queue");
+                    LOG_ERROR("Failed to wait for fence");
                     return false;
                 }
 
-                recording = false;
                 return true;
             }
 
             void* cmd_pool                  = nullptr;
             void* cmd_buffer                = nullptr;
+            void* fence                     = nullptr;
             RHI_Queue_Type queue_type       = RHI_Queue_Undefined;
             std::atomic<bool> initialised   = false;
             std::atomic<bool> recording     = false;
@@ -443,34 +468,129 @@ namespace Spartan::vulkan_utility
 
         static VkCommandBuffer begin(const RHI_Queue_Type queue_type)
         {
-            std::lock_guard<std::mutex> lock(m_mutex_begin);
+            cmdbi_object* cmbdi = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
 
-            cmdbi_object& cmbdi = m_objects[queue_type];
+                // Take the first one which isn't recording, or add one
+                std::vector<std::unique_ptr<cmdbi_object>>& objects = m_objects[queue_type];
+                for (std::unique_ptr<cmdbi_object>& object : objects)
+                {
+                    if (!object->recording)
+                    {
+                        cmbdi = object.get();
+                        break;
+                    }
+                }
+
+                if (!cmbdi)
+                {
+                    cmbdi = objects.emplace_back(std::make_unique<cmdbi_object>()).get();
+                }
 
-            if (!cmbdi.begin(queue_type))
+                cmbdi->recording = true;
+            }
+
+            if (!cmbdi->begin(queue_type))
+            {
+                cmbdi->recording = false;
                 return nullptr;
+            }
 
-            return static_cast<VkCommandBuffer>(cmbdi.cmd_buffer);
+            // Begin and end are always called in pairs on the same thread, so that's how end() finds it
+            m_recording[queue_type] = cmbdi;
+            return static_cast<VkCommandBuffer>(cmbdi->cmd_buffer);
         }
 
         static bool end(const RHI_Queue_Type queue_type)
         {
-            std::lock_guard<std::mutex> lock(m_mutex_end);
-            return m_objects[queue_type].submit();
+            cmdbi_object* cmbdi = m_recording[queue_type];
+            if (!cmbdi)
+            {
+                LOG_ERROR("Can't submit as the command buffer didn't record anything");
+                return false;
+            }
+
+            const bool result       = cmbdi->submit();
+            m_recording[queue_type] = nullptr;
+            cmbdi->recording        = false;
+
+            return result;
         }
 
     private:
-        static std::mutex m_mutex_begin;
-        static std::mutex m_mutex_end;
-        static std::unordered_map<RHI_Queue_Type, cmdbi_object> m_objects;
+        static std::mutex m_mutex;
+        static std::unordered_map<RHI_Queue_Type, std::vector<std::unique_ptr<cmdbi_object>>> m_objects;
+        static thread_local std::array<cmdbi_object*, RHI_Queue_Undefined> m_recording;
     };
 
 	namespace buffer
 	{
         VmaAllocation create(void*& _buffer, const uint64_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_property_flags, const bool written_frequently = false, const void* data = nullptr);
         void destroy(void*& _buffer);
+        void destroy_deferred(void*& _buffer); // destroyed once the frames in flight are done with it (see RHI_Device::DeletionQueue_Add())
+        // Copies data into a device local buffer on the transfer queue, through the staging ring (or a dedicated staging buffer).
+        // The buffer is passed by reference since, once uploaded, defragmentation can move it and re-create it.
+        bool upload(void*& _buffer, const void* data, const uint64_t size);
 	}
 
+    // A persistently mapped ring buffer which uploads sub-allocate their staging memory from, instead of creating a staging buffer each.
+    // Uploads wait for their own fence before they release their allocation, so allocations are released out of order, the ring
+    // only moves past the oldest allocation once it's released. An upload which doesn't fit uses a dedicated staging buffer instead.
+    class staging_ring
+    {
+    public:
+        struct allocation
+        {
+            void* buffer        = nullptr;
+            uint64_t offset     = 0;
+            std::byte* mapped   = nullptr;
+        };
+
+        static bool allocate(const uint64_t size, allocation& _allocation);
+        static void release(const allocation& _allocation);
+        static void destroy();
+
+    private:
+        struct region
+        {
+            uint64_t offset = 0;
+            uint64_t size   = 0;
+            bool released   = false;
+        };
+
+        static const uint64_t m_capacity    = 64 * 1024 * 1024;
+        static const uint64_t m_alignment   = 512; // satisfies the offset rules of buffer to buffer and buffer to image copies
+        static void* m_buffer;
+        static std::byte* m_mapped;
+        static uint64_t m_head;
+        static std::deque<region> m_regions;
+        static std::mutex m_mutex;
+    };
+
+    // Render passes and frame buffers are shared by every pipeline state which describes the same attachments, rather than owned by
+    // a pipeline, so pipelines are only created per attachment format. Render passes are keyed by the formats, layouts and load/store
+    // ops (a handful exist), frame buffers by the views they are made of, and they go away with the render target which owns them.
+    class render_pass_cache
+    {
+    public:
+        static void* get_render_pass(const std::size_t hash, const std::function<bool(void*&)>& create);
+        static void* get_frame_buffer(const std::size_t hash, const std::array<uint32_t, state_max_render_target_count + 2>& owner_ids, const std::function<bool(void*&)>& create);
+        static void evict(const uint32_t owner_id); // the object id of a render target or swapchain, its views are about to be destroyed
+        static void destroy();
+
+    private:
+        struct frame_buffer
+        {
+            void* resource = nullptr;
+            std::array<uint32_t, state_max_render_target_count + 2> owner_ids = {}; // color, depth and shading rate, zero if unused
+        };
+
+        static std::unordered_map<std::size_t, void*> m_render_passes;
+        static std::unordered_map<std::size_t, frame_buffer> m_frame_buffers;
+        static std::mutex m_mutex;
+    };
+
     namespace image
     {
         inline VkImageTiling get_format_tiling(const RHI_Format format, VkFormatFeatureFlags feature_flags)
@@ -497,6 +617,7 @@ namespace Spartan::vulkan_utility
             flags |= (texture->GetFlags() & RHI_Texture_ShaderView)         ? VK_IMAGE_USAGE_SAMPLED_BIT                    : 0;
             flags |= (texture->GetFlags() & RHI_Texture_DepthStencilView)   ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT   : 0;
             flags |= (texture->GetFlags() & RHI_Texture_RenderTargetView)   ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT           : 0;
+            flags |= (texture->GetFlags() & RHI_Texture_ShadingRate)        ? VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR : 0;
 
             // If the texture has data, it will be staged
             if (texture->HasData())
@@ -541,6 +662,7 @@ namespace Spartan::vulkan_utility
         bool create(RHI_Texture* texture);
 
         void destroy(RHI_Texture* texture);
+        void destroy_deferred(RHI_Texture* texture);
 
         inline VkPipelineStageFlags access_flags_to_pipeline_stage(VkAccessFlags access_flags, const VkPipelineStageFlags enabled_graphics_shader_stages)
         {
@@ -614,6 +736,10 @@ namespace Spartan::vulkan_utility
                     stages |= VK_PIPELINE_STAGE_HOST_BIT;
                     break;
 
+                case VK_ACCESS_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR:
+                    stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+                    break;
+
                 case VK_ACCESS_MEMORY_READ_BIT:
                     break;
 
@@ -654,11 +780,11 @@ namespace Spartan::vulkan_utility
                 break;
 
             case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
-                access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+                access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT; // read-only depth is also sampled
                 break;
 
             case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-                access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+                access_mask = VK_ACCESS_SHADER_READ_BIT;
                 break;
 
             case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
@@ -692,6 +818,10 @@ namespace Spartan::vulkan_utility
                 access_mask = VK_ACCESS_MEMORY_READ_BIT;
                 break;
 
+            case VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR:
+                access_mask = VK_ACCESS_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR;
+                break;
+
             default:
                 LOG_ERROR("Unexpected image layout");
                 break;
@@ -700,7 +830,7 @@ namespace Spartan::vulkan_utility
             return access_mask;
         }
 
-        inline bool set_layout(void* cmd_buffer, void* image, const VkImageAspectFlags aspect_mask, const uint32_t level_count, const uint32_t layer_count, const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new)
+        inline VkImageMemoryBarrier get_barrier(void* image, const VkImageAspectFlags aspect_mask, const uint32_t level_count, const uint32_t layer_count, const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new, VkPipelineStageFlags& source_stage, VkPipelineStageFlags& destination_stage)
 	    {
             VkImageMemoryBarrier image_barrier              = {};
             image_barrier.sType                             = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -715,18 +845,22 @@ namespace Spartan::vulkan_utility
             image_barrier.subresourceRange.levelCount       = level_count;
             image_barrier.subresourceRange.baseArrayLayer   = 0;
             image_barrier.subresourceRange.layerCount       = layer_count;
-            image_barrier.srcAccessMask                     = layout_to_access_mask(image_barrier.oldLayout, false);
             image_barrier.dstAccessMask                     = layout_to_access_mask(image_barrier.newLayout, true);
 
-            VkPipelineStageFlags source_stage = 0;
+            // Only writes have to be made available, reads of the old layout just have to finish (which the source stages take care of)
+            const VkAccessFlags access_old                  = layout_to_access_mask(image_barrier.oldLayout, false);
+            const VkAccessFlags access_write                = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            image_barrier.srcAccessMask                     = access_old & access_write;
+
+            source_stage = 0;
             {
                 if (image_barrier.oldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
                 {
                     source_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
                 }
-                else if (image_barrier.srcAccessMask != 0)
+                else if (access_old != 0)
                 {
-                    source_stage = access_flags_to_pipeline_stage(image_barrier.srcAccessMask, globals::rhi_device->GetEnabledGraphicsStages());
+                    source_stage = access_flags_to_pipeline_stage(access_old, globals::rhi_device->GetEnabledGraphicsStages());
                 }
                 else
                 {
@@ -734,7 +868,7 @@ namespace Spartan::vulkan_utility
                 }
             }
 
-            VkPipelineStageFlags destination_stage = 0;
+            destination_stage = 0;
             {
                 if (image_barrier.newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
                 {
@@ -750,6 +884,15 @@ namespace Spartan::vulkan_utility
                 }
             }
 
+            return image_barrier;
+	    }
+
+        inline bool set_layout(void* cmd_buffer, void* image, const VkImageAspectFlags aspect_mask, const uint32_t level_count, const uint32_t layer_count, const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new)
+	    {
+            VkPipelineStageFlags source_stage       = 0;
+            VkPipelineStageFlags destination_stage  = 0;
+            VkImageMemoryBarrier image_barrier      = get_barrier(image, aspect_mask, level_count, layer_count, layout_old, layout_new, source_stage, destination_stage);
+
 	    	vkCmdPipelineBarrier
 	    	(
 	    		static_cast<VkCommandBuffer>(cmd_buffer),
@@ -768,6 +911,42 @@ namespace Spartan::vulkan_utility
             return set_layout(cmd_buffer, texture->Get_Resource(), get_aspect_mask(texture), texture->GetMiplevels(), texture->GetArraySize(), texture->GetLayout(), layout_new);
         }
 
+        // Transitions multiple textures with a single barrier, the stages of the individual transitions are merged.
+        // The old layouts are the tracked layouts of the textures, unless given.
+        inline bool set_layout(void* cmd_buffer, RHI_Texture* const* textures, const RHI_Image_Layout* layouts_new, const uint32_t count, const RHI_Image_Layout* layouts_old = nullptr)
+        {
+            if (count == 0)
+                return true;
+
+            std::vector<VkImageMemoryBarrier> image_barriers(count);
+            VkPipelineStageFlags source_stages      = 0;
+            VkPipelineStageFlags destination_stages = 0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const RHI_Texture* texture              = textures[i];
+                VkPipelineStageFlags source_stage       = 0;
+                VkPipelineStageFlags destination_stage  = 0;
+
+                const RHI_Image_Layout layout_old       = layouts_old ? layouts_old[i] : texture->GetLayout();
+
+                image_barriers[i]   = get_barrier(texture->Get_Resource(), get_aspect_mask(texture), texture->GetMiplevels(), texture->GetArraySize(), layout_old, layouts_new[i], source_stage, destination_stage);
+                source_stages       |= source_stage;
+                destination_stages  |= destination_stage;
+            }
+
+            vkCmdPipelineBarrier
+            (
+                static_cast<VkCommandBuffer>(cmd_buffer),
+                source_stages, destination_stages,
+                0,
+                0, nullptr,
+                0, nullptr,
+                count, image_barriers.data()
+            );
+
+            return true;
+        }
+
         inline bool set_layout(void* cmd_buffer, void* image, const RHI_SwapChain* swapchain, const RHI_Image_Layout layout_new)
         {
             return set_layout(cmd_buffer, image, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, swapchain->GetLayout(), layout_new);
@@ -832,6 +1011,23 @@ namespace Spartan::vulkan_utility
                 }
                 image_views.fill(nullptr);
             }
+
+            inline void destroy_deferred(void*& image_view)
+            {
+                if (!image_view)
+                    return;
+
+                globals::rhi_device->DeletionQueue_Add([image_view]() { vkDestroyImageView(globals::rhi_context->device, static_cast<VkImageView>(image_view), nullptr); });
+                image_view = nullptr;
+            }
+
+            inline void destroy_deferred(std::array<void*, state_max_render_target_count>& image_views)
+            {
+                for (void*& image_view : image_views)
+                {
+                    destroy_deferred(image_view);
+                }
+            }
         }
     }
 
@@ -907,7 +1103,8 @@ namespace Spartan::vulkan_utility
             // Get preferred present mode
             VkPresentModeKHR present_mode_preferred = VK_PRESENT_MODE_FIFO_KHR;
             present_mode_preferred = flags & RHI_Present_Immediate                  ? VK_PRESENT_MODE_IMMEDIATE_KHR                 : present_mode_preferred;
-            present_mode_preferred = flags & RHI_Present_Fifo                       ? VK_PRESENT_MODE_MAILBOX_KHR                   : present_mode_preferred;
+            present_mode_preferred = flags & RHI_Present_Mailbox                    ? VK_PRESENT_MODE_MAILBOX_KHR                   : present_mode_preferred;
+            present_mode_preferred = flags & RHI_Present_Fifo                       ? VK_PRESENT_MODE_FIFO_KHR                      : present_mode_preferred;
             present_mode_preferred = flags & RHI_Present_FifoRelaxed                ? VK_PRESENT_MODE_FIFO_RELAXED_KHR              : present_mode_preferred;
             present_mode_preferred = flags & RHI_Present_SharedDemandRefresh        ? VK_PRESENT_MODE_SHARED_DEMAND_REFRESH_KHR     : present_mode_preferred;
             present_mode_preferred = flags & RHI_Present_SharedDContinuousRefresh   ? VK_PRESENT_MODE_SHARED_CONTINUOUS_REFRESH_KHR : present_mode_preferred;
@@ -1083,6 +1280,17 @@ namespace Spartan::vulkan_utility
             }
         }
 
+        static void functions::initialize_device()
+        {
+            #define get_func_device(var, def)\
+            var = reinterpret_cast<PFN_##def>(vkGetDeviceProcAddr(globals::rhi_context->device, #def));\
+            if (!var) LOG_ERROR("Failed to get function pointer for %s", #def);\
+
+            /* VK_KHR_dynamic_rendering */
+            get_func_device(begin_rendering,    vkCmdBeginRenderingKHR);
+            get_func_device(end_rendering,      vkCmdEndRenderingKHR);
+        }
+
         static PFN_vkCreateDebugUtilsMessengerEXT           create_messenger;
         static VkDebugUtilsMessengerEXT                     messenger;
         static PFN_vkDestroyDebugUtilsMessengerEXT          destroy_messenger;
@@ -1091,6 +1299,8 @@ namespace Spartan::vulkan_utility
         static PFN_vkCmdBeginDebugUtilsLabelEXT             marker_begin;
         static PFN_vkCmdEndDebugUtilsLabelEXT               marker_end;
         static PFN_vkGetPhysicalDeviceMemoryProperties2KHR  get_physical_device_memory_properties_2;
+        static PFN_vkCmdBeginRenderingKHR                   begin_rendering;
+        static PFN_vkCmdEndRenderingKHR                     end_rendering;
     };
 
     class debug
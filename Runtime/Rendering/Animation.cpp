@@ -19,13 +19,292 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =========
+//= INCLUDES ==================
 #include "Animation.h"
-//====================
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <emmintrin.h>
+#include "../IO/FileStream.h"
+//=============================
 
-//= NAMESPACES =====
+//= NAMESPACES ================
 using namespace std;
-//==================
+using namespace Spartan::Math;
+//=============================
+
+namespace _Animation
+{
+    // How far the compressed motion can drift from the imported one
+    static const float tolerance_position   = 0.0005f; // units
+    static const float tolerance_rotation   = 0.0005f; // radians
+    static const float tolerance_scale      = 0.0005f;
+
+    // The widest key spacing to try, in frames
+    static const uint32_t stride_log2_max = 4;
+
+    // The smallest three components of a unit quaternion are within this
+    static const float rotation_component_max = 0.70710678f;
+
+    using Sample = array<float, 4>;
+
+    inline __m128 dot4(const __m128 a, const __m128 b)
+    {
+        __m128 product  = _mm_mul_ps(a, b);
+        __m128 shuffled = _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums     = _mm_add_ps(product, shuffled);
+        shuffled        = _mm_movehl_ps(shuffled, sums);
+        sums            = _mm_add_ss(sums, shuffled);
+        return _mm_shuffle_ps(sums, sums, 0);
+    }
+
+    inline __m128 lerp(const __m128 a, const __m128 b, const __m128 t)
+    {
+        return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+    }
+
+    // Interpolates along the shorter arc and normalizes, which is close enough to a slerp for keys which are a few frames apart
+    inline __m128 nlerp(const __m128 a, __m128 b, const __m128 t)
+    {
+        const __m128 sign = _mm_and_ps(dot4(a, b), _mm_set1_ps(-0.0f));
+        b = _mm_xor_ps(b, sign);
+        const __m128 q = lerp(a, b, t);
+        return _mm_div_ps(q, _mm_sqrt_ps(dot4(q, q)));
+    }
+
+    inline __m128 decode_vector(const uint16_t* key, const Spartan::Animation_Track& track)
+    {
+        const __m128 words  = _mm_cvtepi32_ps(_mm_set_epi32(0, key[2], key[1], key[0]));
+        const __m128 min    = _mm_set_ps(0.0f, track.min.z, track.min.y, track.min.x);
+        const __m128 scale  = _mm_mul_ps(_mm_set_ps(0.0f, track.extent.z, track.extent.y, track.extent.x), _mm_set1_ps(1.0f / 65535.0f));
+        return _mm_add_ps(min, _mm_mul_ps(words, scale));
+    }
+
+    inline __m128 decode_rotation(const uint16_t* key)
+    {
+        // The top bits of the first two words hold which component was dropped
+        const uint32_t largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+
+        const __m128 mask_xyz   = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        const __m128 words      = _mm_cvtepi32_ps(_mm_set_epi32(0, key[2] & 0x7FFF, key[1] & 0x7FFF, key[0] & 0x7FFF));
+        const __m128 abc        = _mm_and_ps(_mm_sub_ps(_mm_mul_ps(words, _mm_set1_ps(2.0f * rotation_component_max / 32766.0f)), _mm_set1_ps(rotation_component_max)), mask_xyz);
+        const __m128 l          = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), dot4(abc, abc)), _mm_setzero_ps()));
+        const __m128 abcl       = _mm_or_ps(abc, _mm_andnot_ps(mask_xyz, l));
+
+        switch (largest)
+        {
+            case 0:  return _mm_shuffle_ps(abcl, abcl, _MM_SHUFFLE(2, 1, 0, 3));
+            case 1:  return _mm_shuffle_ps(abcl, abcl, _MM_SHUFFLE(2, 1, 3, 0));
+            case 2:  return _mm_shuffle_ps(abcl, abcl, _MM_SHUFFLE(2, 3, 1, 0));
+            default: return abcl;
+        }
+    }
+
+    inline void encode_vector(const Sample& value, const Spartan::Animation_Track& track, vector<uint16_t>* keys)
+    {
+        const float min[3]      = { track.min.x, track.min.y, track.min.z };
+        const float extent[3]   = { track.extent.x, track.extent.y, track.extent.z };
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            const float normalized = extent[i] > 0.0f ? clamp((value[i] - min[i]) / extent[i], 0.0f, 1.0f) : 0.0f;
+            keys->emplace_back(static_cast<uint16_t>(normalized * 65535.0f + 0.5f));
+        }
+    }
+
+    inline void encode_rotation(const Sample& value, vector<uint16_t>* keys)
+    {
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < 4; i++)
+        {
+            if (fabs(value[i]) > fabs(value[largest]))
+            {
+                largest = i;
+            }
+        }
+
+        // q and -q are the same rotation, so the dropped component can be made positive
+        const float sign = value[largest] < 0.0f ? -1.0f : 1.0f;
+        uint16_t words[3];
+        for (uint32_t i = 0, j = 0; i < 4; i++)
+        {
+            if (i == largest)
+                continue;
+
+            const float normalized = clamp((value[i] * sign / rotation_component_max) * 0.5f + 0.5f, 0.0f, 1.0f);
+            words[j++] = static_cast<uint16_t>(normalized * 32766.0f + 0.5f); // an even range, so that 0 is exact
+        }
+        words[0] |= static_cast<uint16_t>((largest & 1) << 15);
+        words[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+
+        keys->insert(keys->end(), words, words + 3);
+    }
+
+    inline float error(const __m128 decoded, const Sample& value, const bool rotation)
+    {
+        alignas(16) float d[4];
+        _mm_store_ps(d, decoded);
+
+        // The angle of the rotation between the two, from the vector part of conjugate(a) * b which (unlike their dot product) keeps its precision near 0
+        if (rotation)
+        {
+            const float x = d[3] * value[0] - value[3] * d[0] - (d[1] * value[2] - d[2] * value[1]);
+            const float y = d[3] * value[1] - value[3] * d[1] - (d[2] * value[0] - d[0] * value[2]);
+            const float z = d[3] * value[2] - value[3] * d[2] - (d[0] * value[1] - d[1] * value[0]);
+            return 2.0f * asin(min(sqrt(x * x + y * y + z * z), 1.0f));
+        }
+
+        return max(max(fabs(d[0] - value[0]), fabs(d[1] - value[1])), fabs(d[2] - value[2]));
+    }
+
+    // Keeps the widest key spacing which reproduces every sample (a frame each) within the tolerance
+    static void compress_track(const vector<Sample>& samples, const bool rotation, const float tolerance, vector<uint16_t>* keys, Spartan::Animation_Track* track)
+    {
+        track->key_offset = static_cast<uint32_t>(keys->size());
+        if (samples.empty())
+            return;
+
+        if (!rotation)
+        {
+            Sample min = samples[0];
+            Sample max = samples[0];
+            for (const Sample& sample : samples)
+            {
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    min[i] = std::min(min[i], sample[i]);
+                    max[i] = std::max(max[i], sample[i]);
+                }
+            }
+            track->min      = Vector3(min[0], min[1], min[2]);
+            track->extent   = Vector3(max[0] - min[0], max[1] - min[1], max[2] - min[2]);
+        }
+
+        const auto encode = [&](const Sample& sample, vector<uint16_t>* words)
+        {
+            if (rotation)
+            {
+                encode_rotation(sample, words);
+            }
+            else
+            {
+                encode_vector(sample, *track, words);
+            }
+        };
+
+        const auto decode = [&](const uint16_t* key)
+        {
+            return rotation ? decode_rotation(key) : decode_vector(key, *track);
+        };
+
+        const auto frame_count = static_cast<uint32_t>(samples.size());
+        vector<uint16_t> candidate;
+
+        // Constant
+        {
+            encode(samples[0], &candidate);
+            const __m128 value = decode(candidate.data());
+            bool constant = true;
+            for (uint32_t f = 1; f < frame_count && constant; f++)
+            {
+                constant = error(value, samples[f], rotation) <= tolerance;
+            }
+
+            if (constant)
+            {
+                keys->insert(keys->end(), candidate.begin(), candidate.end());
+                track->key_count    = 1;
+                track->stride_log2  = 0;
+                return;
+            }
+        }
+
+        // A key every 2^n frames, the keys past the end hold the last sample
+        for (uint32_t stride_log2 = stride_log2_max; ; stride_log2--)
+        {
+            const uint32_t stride       = 1 << stride_log2;
+            const uint32_t key_count    = ((frame_count - 1 + stride - 1) >> stride_log2) + 1;
+
+            candidate.clear();
+            for (uint32_t k = 0; k < key_count; k++)
+            {
+                encode(samples[min(k << stride_log2, frame_count - 1)], &candidate);
+            }
+
+            bool fits = true;
+            for (uint32_t f = 0; f < frame_count && fits && stride_log2 != 0; f++)
+            {
+                const uint32_t k    = f >> stride_log2;
+                const uint32_t k1   = min(k + 1, key_count - 1);
+                const __m128 t      = _mm_set1_ps(static_cast<float>(f - (k << stride_log2)) / stride);
+                const __m128 a      = decode(&candidate[k * 3]);
+                const __m128 b      = decode(&candidate[k1 * 3]);
+                fits                = error(rotation ? nlerp(a, b, t) : lerp(a, b, t), samples[f], rotation) <= tolerance;
+            }
+
+            // A key every frame is as close as the quantization gets
+            if (fits || stride_log2 == 0)
+            {
+                keys->insert(keys->end(), candidate.begin(), candidate.end());
+                track->key_count    = key_count;
+                track->stride_log2  = stride_log2;
+                return;
+            }
+        }
+    }
+
+    static Sample sample_keys(const vector<Spartan::KeyVector>& keys, const double time)
+    {
+        const auto it = upper_bound(keys.begin(), keys.end(), time, [](const double time, const Spartan::KeyVector& key) { return time < key.time; });
+        if (it == keys.begin())
+            return { keys.front().value.x, keys.front().value.y, keys.front().value.z, 0.0f };
+        if (it == keys.end())
+            return { keys.back().value.x, keys.back().value.y, keys.back().value.z, 0.0f };
+
+        const auto& a = *(it - 1);
+        const auto& b = *it;
+        const float t = static_cast<float>((time - a.time) / max(b.time - a.time, 1e-9));
+        const Vector3 value = a.value + (b.value - a.value) * t;
+        return { value.x, value.y, value.z, 0.0f };
+    }
+
+    static Sample sample_keys(const vector<Spartan::KeyQuaternion>& keys, const double time)
+    {
+        const auto it = upper_bound(keys.begin(), keys.end(), time, [](const double time, const Spartan::KeyQuaternion& key) { return time < key.time; });
+        if (it == keys.begin())
+            return { keys.front().value.x, keys.front().value.y, keys.front().value.z, keys.front().value.w };
+        if (it == keys.end())
+            return { keys.back().value.x, keys.back().value.y, keys.back().value.z, keys.back().value.w };
+
+        // Slerp
+        const Quaternion& a = (it - 1)->value;
+        Quaternion b        = it->value;
+        const float t       = static_cast<float>((time - (it - 1)->time) / max(it->time - (it - 1)->time, 1e-9));
+        float cos_theta     = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+        if (cos_theta < 0.0f)
+        {
+            b           = Quaternion(-b.x, -b.y, -b.z, -b.w);
+            cos_theta   = -cos_theta;
+        }
+
+        float weight_a = 1.0f - t;
+        float weight_b = t;
+        if (cos_theta < 0.9995f)
+        {
+            const float theta       = acos(cos_theta);
+            const float sin_theta   = sin(theta);
+            weight_a                = sin(weight_a * theta) / sin_theta;
+            weight_b                = sin(weight_b * theta) / sin_theta;
+        }
+
+        Sample value = { a.x * weight_a + b.x * weight_b, a.y * weight_a + b.y * weight_b, a.z * weight_a + b.z * weight_b, a.w * weight_a + b.w * weight_b };
+        const float length = sqrt(value[0] * value[0] + value[1] * value[1] + value[2] * value[2] + value[3] * value[3]);
+        for (float& component : value)
+        {
+            component /= length;
+        }
+        return value;
+    }
+}
 
 namespace Spartan
 {
@@ -34,13 +313,181 @@ namespace Spartan
 
 	}
 
-    bool Animation::LoadFromFile(const string& filePath)
+    bool Animation::LoadFromFile(const string& file_path)
 	{
+        auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
+        if (!file->IsOpen())
+            return false;
+
+        file->Read(&m_duration);
+        file->Read(&m_sample_rate);
+        file->Read(&m_frame_count);
+
+        m_channels.clear();
+        m_channels.resize(file->ReadAs<uint32_t>());
+        for (Animation_Channel& channel : m_channels)
+        {
+            file->Read(&channel.name);
+            for (Animation_Track* track : { &channel.position, &channel.rotation, &channel.scale })
+            {
+                file->Read(&track->key_offset);
+                file->Read(&track->key_count);
+                file->Read(&track->stride_log2);
+                file->Read(&track->min);
+                file->Read(&track->extent);
+            }
+        }
+        file->Read(&m_keys);
+
+        SetResourceFilePath(file_path);
+        UpdateMemoryUsage();
+
 		return true;
 	}
 
-	bool Animation::SaveToFile(const string& filePath)
+	bool Animation::SaveToFile(const string& file_path)
 	{
+        auto file = make_unique<FileStream>(file_path, FileStream_Write);
+        if (!file->IsOpen())
+            return false;
+
+        file->Write(m_duration);
+        file->Write(m_sample_rate);
+        file->Write(m_frame_count);
+
+        file->Write(static_cast<uint32_t>(m_channels.size()));
+        for (const Animation_Channel& channel : m_channels)
+        {
+            file->Write(channel.name);
+            for (const Animation_Track* track : { &channel.position, &channel.rotation, &channel.scale })
+            {
+                file->Write(track->key_offset);
+                file->Write(track->key_count);
+                file->Write(track->stride_log2);
+                file->Write(track->min);
+                file->Write(track->extent);
+            }
+        }
+        file->Write(m_keys);
+
+        file->Close();
+
+        SetResourceFilePath(file_path);
+
 		return true;
 	}
+
+    void Animation::SetChannels(const vector<AnimationNode>& nodes, const double duration, double ticks_per_second)
+    {
+        ticks_per_second = ticks_per_second > 0.0 ? ticks_per_second : 25.0;
+
+        // A whole number of frames, at about the sample rate
+        m_duration                  = static_cast<float>(duration / ticks_per_second);
+        const uint32_t intervals    = m_duration > 0.0f ? max(1u, static_cast<uint32_t>(ceil(m_duration * animation_sample_rate - 0.01f))) : 0;
+        m_frame_count               = intervals + 1;
+        m_sample_rate               = m_duration > 0.0f ? intervals / m_duration : animation_sample_rate;
+
+        m_channels.clear();
+        m_keys.clear();
+        m_channels.reserve(nodes.size());
+
+        vector<_Animation::Sample> samples;
+        const auto resample = [this, &samples, duration, intervals](const auto& keys)
+        {
+            samples.clear();
+            if (keys.empty())
+                return;
+
+            for (uint32_t f = 0; f < m_frame_count; f++)
+            {
+                const double time = intervals != 0 ? duration * f / intervals : 0.0;
+                samples.emplace_back(_Animation::sample_keys(keys, time));
+            }
+        };
+
+        for (const AnimationNode& node : nodes)
+        {
+            Animation_Channel& channel = m_channels.emplace_back();
+            channel.name = node.name;
+
+            resample(node.positionFrames);
+            _Animation::compress_track(samples, false, _Animation::tolerance_position, &m_keys, &channel.position);
+
+            resample(node.rotationFrames);
+            _Animation::compress_track(samples, true, _Animation::tolerance_rotation, &m_keys, &channel.rotation);
+
+            resample(node.scaleFrames);
+            _Animation::compress_track(samples, false, _Animation::tolerance_scale, &m_keys, &channel.scale);
+        }
+
+        m_keys.shrink_to_fit();
+        UpdateMemoryUsage();
+    }
+
+    void Animation::Sample(float time, const bool loop, Animation_Pose* pose) const
+    {
+        if (!pose || m_frame_count == 0 || pose->positions.size() < m_channels.size())
+            return;
+
+        // Find the frames around the time, they are the same for every track
+        if (loop && m_duration > 0.0f)
+        {
+            time = fmod(time, m_duration);
+            time = time < 0.0f ? time + m_duration : time;
+        }
+        const float frame       = clamp(time * m_sample_rate, 0.0f, static_cast<float>(m_frame_count - 1));
+        const auto frame_index  = static_cast<uint32_t>(frame);
+        const float fraction    = frame - frame_index;
+        const uint16_t* keys    = m_keys.data();
+
+        // The keys and the interpolation weight of a track at that frame
+        const auto locate = [frame_index, fraction, keys](const Animation_Track& track, const uint16_t** a, const uint16_t** b, __m128* t)
+        {
+            const uint32_t k    = frame_index >> track.stride_log2;
+            const uint32_t k0   = min(k, track.key_count - 1);
+            const uint32_t k1   = min(k + 1, track.key_count - 1);
+            *a                  = keys + track.key_offset + k0 * 3;
+            *b                  = keys + track.key_offset + k1 * 3;
+            *t                  = _mm_set1_ps((static_cast<float>(frame_index - (k << track.stride_log2)) + fraction) / static_cast<float>(1 << track.stride_log2));
+        };
+
+        alignas(16) float value[4];
+        const uint16_t* a   = nullptr;
+        const uint16_t* b   = nullptr;
+        __m128 t            = _mm_setzero_ps();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_channels.size()); i++)
+        {
+            const Animation_Channel& channel = m_channels[i];
+
+            if (channel.position.key_count != 0)
+            {
+                locate(channel.position, &a, &b, &t);
+                _mm_store_ps(value, _Animation::lerp(_Animation::decode_vector(a, channel.position), _Animation::decode_vector(b, channel.position), t));
+                pose->positions[i] = Vector3(value[0], value[1], value[2]);
+            }
+
+            if (channel.rotation.key_count != 0)
+            {
+                locate(channel.rotation, &a, &b, &t);
+                _mm_store_ps(value, _Animation::nlerp(_Animation::decode_rotation(a), _Animation::decode_rotation(b), t));
+                pose->rotations[i] = Quaternion(value[0], value[1], value[2], value[3]);
+            }
+
+            if (channel.scale.key_count != 0)
+            {
+                locate(channel.scale, &a, &b, &t);
+                _mm_store_ps(value, _Animation::lerp(_Animation::decode_vector(a, channel.scale), _Animation::decode_vector(b, channel.scale), t));
+                pose->scales[i] = Vector3(value[0], value[1], value[2]);
+            }
+        }
+    }
+
+    void Animation::UpdateMemoryUsage()
+    {
+        m_size_cpu = sizeof(*this) + m_keys.size() * sizeof(uint16_t);
+        for (const Animation_Channel& channel : m_channels)
+        {
+            m_size_cpu += sizeof(Animation_Channel) + channel.name.size();
+        }
+    }
 }
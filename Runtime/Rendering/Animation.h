@@ -22,25 +22,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES =====================
+#include <vector>
 #include "../Resource/IResource.h"
-#include "../Math/Matrix.h"
+#include "../Math/Vector3.h"
+#include "../Math/Quaternion.h"
 //================================
 
 namespace Spartan
 {
-    struct AnimationVertexWeight
-    {
-        uint32_t vertexID;
-        float weight;
-    };
-
-    struct AnimationBone
-    {
-        std::string name;
-        std::vector<AnimationVertexWeight> vertexWeights;
-        Math::Matrix offset;
-    };
-
+    // The keys of an imported channel, before they are compressed (times are in ticks)
     struct KeyVector
     {
         double time;
@@ -61,6 +51,46 @@ namespace Spartan
         std::vector<KeyVector> scaleFrames;
     };
 
+    // Clips are resampled to (about) this rate, so finding the keys around a time is a division instead of a search
+    constexpr float animation_sample_rate = 30.0f;
+
+    // The keys of a single property of a channel. A track keeps a key every 2^stride_log2 frames, the widest
+    // spacing which the linear interpolation of the keys follows the imported motion within a tolerance.
+    // Every key is three 16-bit words, positions and scales are normalized to the bounds of their track,
+    // rotations keep their smallest three components (the largest is implied by the unit length).
+    struct Animation_Track
+    {
+        uint32_t key_offset     = 0; // the first word of the track's keys
+        uint32_t key_count      = 0; // 0 for properties the clip doesn't animate, 1 for constant ones
+        uint32_t stride_log2    = 0;
+        Math::Vector3 min       = Math::Vector3::Zero;
+        Math::Vector3 extent    = Math::Vector3::Zero;
+    };
+
+    // Each channel controls a single node
+    struct Animation_Channel
+    {
+        std::string name;
+        Animation_Track position;
+        Animation_Track rotation;
+        Animation_Track scale;
+    };
+
+    // The local transforms of every channel, in channel order
+    struct Animation_Pose
+    {
+        void Resize(const uint32_t channel_count)
+        {
+            positions.resize(channel_count, Math::Vector3::Zero);
+            rotations.resize(channel_count, Math::Quaternion::Identity);
+            scales.resize(channel_count, Math::Vector3::One);
+        }
+
+        std::vector<Math::Vector3> positions;
+        std::vector<Math::Quaternion> rotations;
+        std::vector<Math::Vector3> scales;
+    };
+
 	class SPARTAN_CLASS Animation : public IResource
 	{
 	public:
@@ -68,20 +98,29 @@ namespace Spartan
 		~Animation() = default;
 
 		//= IResource ==========================================
-		bool LoadFromFile(const std::string& filePath) override;
-		bool SaveToFile(const std::string& filePath) override;
+		bool LoadFromFile(const std::string& file_path) override;
+		bool SaveToFile(const std::string& file_path) override;
 		//======================================================
 
-		void SetName(const std::string& name)   { m_name = name; }
-		void SetDuration(double duration)       { m_duration = duration; }
-		void SetTicksPerSec(double ticksPerSec) { m_ticksPerSec = ticksPerSec; }
+		// Resamples and compresses the imported channels, which can be released afterwards
+		void SetChannels(const std::vector<AnimationNode>& nodes, double duration, double ticks_per_second);
+
+		// Writes the local transform of every channel at a time (in seconds), properties which the clip doesn't animate are left as they are.
+		// Time wraps around when looping and is clamped otherwise, the pose has to be sized to the channel count.
+		void Sample(float time, bool loop, Animation_Pose* pose) const;
+
+		const auto& GetChannels()	const { return m_channels; }
+		uint32_t GetChannelCount()	const { return static_cast<uint32_t>(m_channels.size()); }
+		float GetDuration()			const { return m_duration; }
+		uint32_t GetKeyCount()		const { return static_cast<uint32_t>(m_keys.size() / 3); }
 
 	private:
-		std::string m_name;
-		double m_duration       = 0;
-		double m_ticksPerSec    = 0;
+		void UpdateMemoryUsage();
 
-		// Each channel controls a single node
-		std::vector<AnimationNode> m_channels;
+		float m_duration		= 0.0f; // seconds
+		float m_sample_rate		= animation_sample_rate; // frames per second, adjusted so that the duration is a whole number of frames
+		uint32_t m_frame_count	= 0;
+		std::vector<Animation_Channel> m_channels;
+		std::vector<uint16_t> m_keys;
 	};
 }
@@ -23,11 +23,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Font.h"
 #include "../Renderer.h"
 #include "../../Core/Stopwatch.h"
+#include "../../Core/FrameArena.h"
 #include "../../RHI/RHI_Vertex.h"
 #include "../../RHI/RHI_VertexBuffer.h"
-#include "../../RHI/RHI_IndexBuffer.h"
 #include "../../Resource/ResourceCache.h"
 #include "../../Resource/Import/FontImporter.h"
+#include "../../Utilities/Hash.h"
 //=============================================
 
 //= NAMESPACES ================
@@ -45,7 +46,6 @@ namespace Spartan
 	{
 		m_rhi_device		= m_context->GetSubsystem<Renderer>()->GetRhiDevice();
 		m_vertex_buffer		= make_shared<RHI_VertexBuffer>(m_rhi_device);
-		m_index_buffer		= make_shared<RHI_IndexBuffer>(m_rhi_device);
 		m_char_max_width	= 0;
 		m_char_max_height	= 0;
 		m_color             = color;
@@ -84,20 +84,44 @@ namespace Spartan
 		return true;
 	}
 
-	void Font::SetText(const string& text, const Vector2& position)
+	void Font::AddText(const string& text, const Vector2& position, const float size /*= 0.0f*/)
 	{
-        const bool same_text    = text == m_current_text;
-        const bool has_buffers  = (m_vertex_buffer && m_index_buffer);
+        if (text.empty())
+            return;
+
+        const float scale = size > 0.0f ? size / static_cast<float>(m_font_size) : 1.0f;
+
+        size_t key = 0;
+        Utility::Hash::hash_combine(key, text);
+        Utility::Hash::hash_combine(key, position.x);
+        Utility::Hash::hash_combine(key, position.y);
+        Utility::Hash::hash_combine(key, scale);
+
+        // Lay the run out, unless it was drawn recently
+        auto it = m_runs.find(key);
+        if (it == m_runs.end())
+        {
+            it = m_runs.emplace(key, FontRun()).first;
+            LayoutRun(text, position, scale, it->second.vertices);
+        }
+        it->second.used = true;
+
+        m_runs_frame.emplace_back(key);
+	}
 
-		if (same_text || !has_buffers)
-			return;
+	void Font::SetText(const string& text, const Vector2& position)
+	{
+        m_runs_frame.clear();
+        AddText(text, position);
+	}
 
+	void Font::LayoutRun(const string& text, const Vector2& position, const float scale, vector<RHI_Vertex_PosTex>& vertices)
+	{
         Vector2 pen = position;
-		m_current_text = text;
-		m_vertices.clear();
+		vertices.reserve(text.size() * 6);
 
 		// Draw each letter onto a quad.
-		for (auto text_char : m_current_text)
+		for (auto text_char : text)
 		{
             Glyph& glyph = m_glyphs[text_char];
 
@@ -105,46 +129,42 @@ namespace Spartan
 			{
 				const uint32_t space_offset	        = m_glyphs[ASCII_SPACE].horizontal_advance;
 				const uint32_t space_count	        = 8; // spaces in a typical terminal
-				const uint32_t tab_spacing	        = space_offset * space_count;
-                const uint32_t offset_from_start    = static_cast<uint32_t>(Math::Helper::Abs(pen.x - position.x));
-                const uint32_t next_column_index    = (offset_from_start / tab_spacing) + 1;
-                const uint32_t offset_to_column     = (next_column_index * tab_spacing) - offset_from_start;
+				const float tab_spacing	            = space_offset * space_count * scale;
+                const float offset_from_start       = Math::Helper::Abs(pen.x - position.x);
+                const float next_column_index       = Math::Helper::Floor(offset_from_start / tab_spacing) + 1.0f;
+                const float offset_to_column        = (next_column_index * tab_spacing) - offset_from_start;
 				pen.x                               += offset_to_column;
 			}
 			else if (text_char == ASCII_NEW_LINE)
 			{
-				pen.y -= m_char_max_height;
+				pen.y -= m_char_max_height * scale;
 				pen.x = position.x;
 			}
 			else if (text_char == ASCII_SPACE)
 			{
                 // Advance
-                pen.x += glyph.horizontal_advance;
+                pen.x += glyph.horizontal_advance * scale;
 			}
             else // Any other char
             {
+                const float left    = pen.x + glyph.offset_x * scale;
+                const float right   = left + glyph.width * scale;
+                const float top     = pen.y + glyph.offset_y * scale;
+                const float bottom  = top - glyph.height * scale;
+
 			    // First triangle in quad.		
-			    m_vertices.emplace_back(pen.x + glyph.offset_x,                 pen.y + glyph.offset_y,                  0.0f, glyph.uv_x_left,  glyph.uv_y_top);       // top left
-			    m_vertices.emplace_back(pen.x + glyph.offset_x  + glyph.width,  pen.y + glyph.offset_y - glyph.height,   0.0f, glyph.uv_x_right, glyph.uv_y_bottom);    // bottom right
-			    m_vertices.emplace_back(pen.x + glyph.offset_x,                 pen.y + glyph.offset_y - glyph.height,   0.0f, glyph.uv_x_left,  glyph.uv_y_bottom);    // bottom left
+			    vertices.emplace_back(left,     top,    0.0f, glyph.uv_x_left,  glyph.uv_y_top);       // top left
+			    vertices.emplace_back(right,    bottom, 0.0f, glyph.uv_x_right, glyph.uv_y_bottom);    // bottom right
+			    vertices.emplace_back(left,     bottom, 0.0f, glyph.uv_x_left,  glyph.uv_y_bottom);    // bottom left
 			    // Second triangle in quad.
-			    m_vertices.emplace_back(pen.x + glyph.offset_x,                 pen.y + glyph.offset_y,                  0.0f, glyph.uv_x_left,  glyph.uv_y_top);       // top left
-			    m_vertices.emplace_back(pen.x + glyph.offset_x	+ glyph.width,	pen.y + glyph.offset_y,                  0.0f, glyph.uv_x_right, glyph.uv_y_top);       // top right
-			    m_vertices.emplace_back(pen.x + glyph.offset_x	+ glyph.width,	pen.y + glyph.offset_y - glyph.height,   0.0f, glyph.uv_x_right, glyph.uv_y_bottom);    // bottom right
+			    vertices.emplace_back(left,     top,    0.0f, glyph.uv_x_left,  glyph.uv_y_top);       // top left
+			    vertices.emplace_back(right,    top,    0.0f, glyph.uv_x_right, glyph.uv_y_top);       // top right
+			    vertices.emplace_back(right,    bottom, 0.0f, glyph.uv_x_right, glyph.uv_y_bottom);    // bottom right
 
 			    // Advance
-                pen.x += glyph.horizontal_advance;
+                pen.x += glyph.horizontal_advance * scale;
             }
 		}
-		m_vertices.shrink_to_fit();		
-		
-		m_indices.clear();
-		for (uint32_t i = 0; i < m_vertices.size(); i++)
-		{
-			m_indices.emplace_back(i);
-		}
-
-		UpdateBuffers(m_vertices, m_indices);
 	}
 
 	void Font::SetSize(const uint32_t size)
@@ -152,46 +172,79 @@ namespace Spartan
 		m_font_size = Helper::Clamp<uint32_t>(size, 8, 50);
 	}
 
-	bool Font::UpdateBuffers(vector<RHI_Vertex_PosTex>& vertices, vector<uint32_t>& indices) const
+	bool Font::UpdateBuffers()
 	{
-		if (!m_context || !m_vertex_buffer || !m_index_buffer)
+		if (!m_context || !m_vertex_buffer)
 		{
 			LOG_ERROR_INVALID_INTERNALS();
 			return false;
 		}
 
-		// Grow buffers (if needed)
-		if (vertices.size() > m_vertex_buffer->GetVertexCount())
+        // Batch the runs of this frame
+        FrameVector<RHI_Vertex_PosTex> vertices;
+        for (const uint64_t key : m_runs_frame)
+        {
+            const vector<RHI_Vertex_PosTex>& run = m_runs[key].vertices;
+            vertices.insert(vertices.end(), run.begin(), run.end());
+        }
+        m_runs_frame.clear();
+
+        // Runs which weren't drawn this frame are dropped (the metrics text changes every profiler interval)
+        for (auto it = m_runs.begin(); it != m_runs.end();)
+        {
+            if (!it->second.used)
+            {
+                it = m_runs.erase(it);
+                continue;
+            }
+
+            it->second.used = false;
+            ++it;
+        }
+
+        // The range of vertices which differ from what the buffer holds
+        const size_t count          = vertices.size();
+        const size_t count_previous = m_vertices.size();
+        size_t dirty_start          = 0;
+        size_t dirty_end            = Helper::Max(count, count_previous);
+        while (dirty_start < Helper::Min(count, count_previous) && memcmp(&vertices[dirty_start], &m_vertices[dirty_start], sizeof(RHI_Vertex_PosTex)) == 0)
+        {
+            dirty_start++;
+        }
+        if (count == count_previous)
+        {
+            while (dirty_end > dirty_start && memcmp(&vertices[dirty_end - 1], &m_vertices[dirty_end - 1], sizeof(RHI_Vertex_PosTex)) == 0)
+            {
+                dirty_end--;
+            }
+        }
+
+        m_vertices.assign(vertices.begin(), vertices.end());
+        if (count == 0 || dirty_start >= Helper::Min(dirty_end, count))
+            return true;
+
+		// Grow buffer (if needed), everything gets uploaded then
+		if (count > m_vertex_buffer->GetVertexCount())
 		{
-			// Vertex buffer
-			if (!m_vertex_buffer->CreateDynamic<RHI_Vertex_PosTex>(static_cast<uint32_t>(vertices.size())))
+			if (!m_vertex_buffer->CreateDynamic<RHI_Vertex_PosTex>(Helper::NextPowerOfTwo(static_cast<uint32_t>(count))))
 			{
 				LOG_ERROR("Failed to update vertex buffer.");
+                m_vertices.clear();
 				return false;
 			}
 
-			// Index buffer
-			if (!m_index_buffer->CreateDynamic<uint32_t>(static_cast<uint32_t>(indices.size())))
-			{
-				LOG_ERROR("Failed to update index buffer.");
-				return false;
-			}
+            dirty_start = 0;
 		}
 
-        bool mapped_vertex = false;
-        if (const auto vertex_buffer = static_cast<RHI_Vertex_PosTex*>(m_vertex_buffer->Map()))
-        {
-            copy(vertices.begin(), vertices.end(), vertex_buffer);
-            mapped_vertex = m_vertex_buffer->Unmap();
-        }
-
-        bool mapped_index = false;
-        if (const auto index_buffer = static_cast<uint32_t*>(m_index_buffer->Map()))
+        const auto vertex_buffer = static_cast<RHI_Vertex_PosTex*>(m_vertex_buffer->Map());
+        if (!vertex_buffer)
         {
-            copy(indices.begin(), indices.end(), index_buffer);
-            mapped_index = m_index_buffer->Unmap();
+            m_vertices.clear();
+            return false;
         }
 
-		return mapped_vertex && mapped_index;
+        const size_t dirty_count = Helper::Min(dirty_end, count) - dirty_start;
+        memcpy(vertex_buffer + dirty_start, m_vertices.data() + dirty_start, dirty_count * sizeof(RHI_Vertex_PosTex));
+        return m_vertex_buffer->Unmap();
 	}
 }
@@ -24,9 +24,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ========================
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "Glyph.h"
 #include "../../RHI/RHI_Definition.h"
 #include "../../Core/EngineDefs.h"
+#include "../../RHI/RHI_Vertex.h"
 #include "../../Resource/IResource.h"
 #include "../../Math/Vector4.h"
 //===================================
@@ -64,7 +66,11 @@ namespace Spartan
 		bool LoadFromFile(const std::string& file_path) override;
 		//======================================================
 
-		void SetText(const std::string& text, const Math::Vector2& position);
+		// Text is drawn in runs, the runs added during a frame are batched into a single vertex buffer (and a single draw).
+		// The quads of a run are cached by its text, position and size, so only runs which weren't drawn the previous frame are laid out.
+		void AddText(const std::string& text, const Math::Vector2& position, float size = 0.0f); // size in pixels, 0 is the font size (only SDF fonts scale cleanly)
+		void SetText(const std::string& text, const Math::Vector2& position);                   // replaces the runs of this frame with this one
+		bool UpdateBuffers(); // batches the runs of this frame and uploads the vertices which changed since the previous upload
 		void SetSize(uint32_t size);
 
 		const Math::Vector4& GetColor()                                 const { return m_color; }
@@ -85,16 +91,19 @@ namespace Spartan
         const auto& GetAtlasOutline()                                   const { return m_atlas_outline; }
         void SetAtlasOutline(const std::shared_ptr<RHI_Texture>& atlas)       { m_atlas_outline = atlas; }
 
-        RHI_IndexBuffer* GetIndexBuffer()                               const { return m_index_buffer.get(); }
         RHI_VertexBuffer* GetVertexBuffer()                             const { return m_vertex_buffer.get(); }
-        uint32_t GetIndexCount()                                        const { return static_cast<uint32_t>(m_indices.size()); }
+        uint32_t GetVertexCount()                                       const { return static_cast<uint32_t>(m_vertices.size()); }
         uint32_t GetSize()                                              const { return m_font_size; }
 		void SetGlyph(const uint32_t char_code, const Glyph& glyph)			  { m_glyphs[char_code] = glyph; }
         Font_Hinting_Type GetHinting()                                  const { return m_hinting; }
 		auto GetForceAutohint()                                         const { return m_force_autohint; }
+
+        // Signed distance field atlas, the glyphs stay sharp at any size (set before loading, it has no outline atlas)
+        void SetSdf(const bool sdf)                                           { m_sdf = sdf; }
+        bool IsSdf()                                                    const { return m_sdf; }
 			
-	private:	
-		bool UpdateBuffers(std::vector<RHI_Vertex_PosTex>& vertices, std::vector<uint32_t>& indices) const;
+	private:
+		void LayoutRun(const std::string& text, const Math::Vector2& position, float scale, std::vector<RHI_Vertex_PosTex>& vertices);
 
 		uint32_t m_font_size	        = 14;
         uint32_t m_outline_size         = 2;
@@ -110,9 +119,17 @@ namespace Spartan
         std::shared_ptr<RHI_Texture> m_atlas_outline;
 		std::unordered_map<uint32_t, Glyph> m_glyphs;
 		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
-		std::shared_ptr<RHI_IndexBuffer> m_index_buffer;
-		std::vector<RHI_Vertex_PosTex> m_vertices;
-		std::vector<uint32_t> m_indices;	
+        bool m_sdf = false;
+
+        // Runs
+        struct FontRun
+        {
+            std::vector<RHI_Vertex_PosTex> vertices;
+            bool used = true;
+        };
+        std::unordered_map<uint64_t, FontRun> m_runs;   // laid out runs, by text, position and size
+        std::vector<uint64_t> m_runs_frame;             // the runs to draw, in the order they were added
+        std::vector<RHI_Vertex_PosTex> m_vertices;      // what the vertex buffer holds
 		std::shared_ptr<RHI_Device> m_rhi_device;
 	};
 }
@@ -22,7 +22,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ========================
-#include <vector>
 #include <memory>
 #include "../../Math/Matrix.h"
 #include "../../Core/EngineDefs.h"
@@ -34,27 +33,21 @@ namespace Spartan
 	class Context;
 	class Transform;
 
+	// The grid is a single quad under the camera, the lines are generated per pixel (see Grid.hlsl),
+	// so its cost doesn't depend on how many lines are visible or how far it extends.
 	class SPARTAN_CLASS Grid
 	{
 	public:
 		Grid(std::shared_ptr<RHI_Device> rhi_device);
         ~Grid() = default;
 		
-		const Math::Matrix& ComputeWorldMatrix(Transform* camera);
+		const Math::Matrix& ComputeWorldMatrix(Transform* camera, float extent);
 		
-		const auto& GetIndexBuffer() const  { return m_indexBuffer; }
-		const auto& GetVertexBuffer() const { return m_vertexBuffer; }
-		uint32_t GetIndexCount() const      { return m_indexCount; }
+		const auto& GetVertexBuffer() const { return m_vertex_buffer; }
+		uint32_t GetVertexCount() const     { return 6; }
 
 	private:
-		void BuildGrid(std::vector<RHI_Vertex_PosCol>* vertices, std::vector<uint32_t>* indices);
-		bool CreateBuffers(std::vector<RHI_Vertex_PosCol>& vertices, std::vector<uint32_t>& indices, std::shared_ptr<RHI_Device>& rhi_device);
-
-		uint32_t m_indexCount;
-		uint32_t m_terrainHeight;
-		uint32_t m_terrainWidth;
-		std::shared_ptr<RHI_VertexBuffer> m_vertexBuffer;
-		std::shared_ptr<RHI_IndexBuffer> m_indexBuffer;
+		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
 		Math::Matrix m_world;
 	};
 }
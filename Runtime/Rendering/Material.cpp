@@ -27,7 +27,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../IO/XmlDocument.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
-#include "../World/World.h"
 //====================================
 
 //= NAMESPACES ===============
@@ -42,6 +41,7 @@ namespace Spartan
 		m_rhi_device = context->GetSubsystem<Renderer>()->GetRhiDevice();
 
 		// Initialize properties
+        m_properties.fill(0.0f);
 		SetProperty(Material_Roughness,             0.9f);
 		SetProperty(Material_Metallic,              0.0f);
 		SetProperty(Material_Normal,                0.0f);
@@ -52,6 +52,7 @@ namespace Spartan
         SetProperty(Material_Anisotropic_Rotation,  0.0f);
         SetProperty(Material_Sheen,                 0.0f);
         SetProperty(Material_Sheen_Tint,            0.0f);
+        m_texture_slices.fill(-1);
 
         // Ensure an a suitable shader exists
         ShaderGBuffer::GenerateVariation(context, m_flags);
@@ -66,16 +67,16 @@ namespace Spartan
 		SetResourceFilePath(file_path);
 
         xml->GetAttribute("Material", "Color",                          &m_color_albedo);
-		xml->GetAttribute("Material", "Roughness_Multiplier",	        &GetProperty(Material_Roughness));
-		xml->GetAttribute("Material", "Metallic_Multiplier",	        &GetProperty(Material_Metallic));
-		xml->GetAttribute("Material", "Normal_Multiplier",		        &GetProperty(Material_Normal));
-		xml->GetAttribute("Material", "Height_Multiplier",		        &GetProperty(Material_Height));
-        xml->GetAttribute("Material", "Clearcoat_Multiplier",           &GetProperty(Material_Clearcoat));
-        xml->GetAttribute("Material", "Clearcoat_Roughness_Multiplier", &GetProperty(Material_Clearcoat_Roughness));
-        xml->GetAttribute("Material", "Anisotropi_Multiplier",          &GetProperty(Material_Anisotropic));
-        xml->GetAttribute("Material", "Anisotropic_Rotatio_Multiplier", &GetProperty(Material_Anisotropic_Rotation));
-        xml->GetAttribute("Material", "Sheen_Multiplier",               &GetProperty(Material_Sheen));
-        xml->GetAttribute("Material", "Sheen_Tint_Multiplier",          &GetProperty(Material_Sheen_Tint));
+		xml->GetAttribute("Material", "Roughness_Multiplier",	        &m_properties[GetPropertyIndex(Material_Roughness)]);
+		xml->GetAttribute("Material", "Metallic_Multiplier",	        &m_properties[GetPropertyIndex(Material_Metallic)]);
+		xml->GetAttribute("Material", "Normal_Multiplier",		        &m_properties[GetPropertyIndex(Material_Normal)]);
+		xml->GetAttribute("Material", "Height_Multiplier",		        &m_properties[GetPropertyIndex(Material_Height)]);
+        xml->GetAttribute("Material", "Clearcoat_Multiplier",           &m_properties[GetPropertyIndex(Material_Clearcoat)]);
+        xml->GetAttribute("Material", "Clearcoat_Roughness_Multiplier", &m_properties[GetPropertyIndex(Material_Clearcoat_Roughness)]);
+        xml->GetAttribute("Material", "Anisotropi_Multiplier",          &m_properties[GetPropertyIndex(Material_Anisotropic)]);
+        xml->GetAttribute("Material", "Anisotropic_Rotatio_Multiplier", &m_properties[GetPropertyIndex(Material_Anisotropic_Rotation)]);
+        xml->GetAttribute("Material", "Sheen_Multiplier",               &m_properties[GetPropertyIndex(Material_Sheen)]);
+        xml->GetAttribute("Material", "Sheen_Tint_Multiplier",          &m_properties[GetPropertyIndex(Material_Sheen_Tint)]);
 		xml->GetAttribute("Material", "IsEditable",				        &m_is_editable);
 		xml->GetAttribute("Material", "UV_Tiling",				        &m_uv_tiling);
 		xml->GetAttribute("Material", "UV_Offset",				        &m_uv_offset);
@@ -101,7 +102,8 @@ namespace Spartan
         // Ensure an a suitable shader exists
         ShaderGBuffer::GenerateVariation(m_context, m_flags);
 
-        m_size_cpu = sizeof(*this);
+        m_size_cpu  = sizeof(*this);
+        m_dirty     = true;
 
 		return true;
 	}
@@ -128,17 +130,21 @@ namespace Spartan
 		xml->AddAttribute("Material", "IsEditable",				        m_is_editable);
 
 		xml->AddChildNode("Material", "Textures");
-		xml->AddAttribute("Textures", "Count", static_cast<uint32_t>(m_textures.size()));
-		auto i = 0;
-		for (const auto& texture : m_textures)
+		uint32_t i = 0;
+		for (uint32_t property_index = 0; property_index < m_property_count; property_index++)
 		{
+            const shared_ptr<RHI_Texture>& texture = m_textures[property_index];
+            if (!texture)
+                continue;
+
 			auto tex_node = "Texture_" + to_string(i);
 			xml->AddChildNode("Textures", tex_node);
-			xml->AddAttribute(tex_node, "Texture_Type", static_cast<uint32_t>(texture.first));
-			xml->AddAttribute(tex_node, "Texture_Name", texture.second ? texture.second->GetResourceName() : "");
-			xml->AddAttribute(tex_node, "Texture_Path", texture.second ? texture.second->GetResourceFilePathNative() : "");
+			xml->AddAttribute(tex_node, "Texture_Type", static_cast<uint32_t>(1 << property_index));
+			xml->AddAttribute(tex_node, "Texture_Name", texture->GetResourceName());
+			xml->AddAttribute(tex_node, "Texture_Path", texture->GetResourceFilePathNative());
 			i++;
 		}
+		xml->AddAttribute("Textures", "Count", i);
 
 		return xml->Save(GetResourceFilePathNative());
 	}
@@ -149,16 +155,18 @@ namespace Spartan
 		{
             // In order for the material to guarantee serialization/deserialization we cache the texture
             const shared_ptr<RHI_Texture> texture_cached = m_context->GetSubsystem<ResourceCache>()->Cache(texture);
-			m_textures[type] = texture_cached != nullptr ? texture_cached : texture;
+			m_textures[GetPropertyIndex(type)] = texture_cached != nullptr ? texture_cached : texture;
             m_flags |= type;
 
             SetProperty(type, multiplier);
 		}
 		else
 		{
-			m_textures.erase(type);
+			m_textures[GetPropertyIndex(type)] = nullptr;
             m_flags &= ~type;
 		}
+        m_texture_slices[GetPropertyIndex(type)] = -1;
+        m_dirty = true;
 
         // Ensure an a suitable shader exists
         ShaderGBuffer::GenerateVariation(m_context, m_flags);
@@ -178,10 +186,10 @@ namespace Spartan
 	{
 		for (const auto& texture : m_textures)
 		{
-			if (!texture.second)
+			if (!texture)
 				continue;
 
-			if (texture.second->GetResourceFilePathNative() == path)
+			if (texture->GetResourceFilePathNative() == path)
 				return true;
 		}
 
@@ -193,7 +201,7 @@ namespace Spartan
 		if (!HasTexture(type))
 			return "";
 
-		return m_textures.at(type)->GetResourceFilePathNative();
+		return m_textures[GetPropertyIndex(type)]->GetResourceFilePathNative();
 	}
 
 	vector<string> Material::GetTexturePaths()
@@ -201,10 +209,10 @@ namespace Spartan
 		vector<string> paths;
 		for (const auto& texture : m_textures)
 		{
-			if (!texture.second)
+			if (!texture)
 				continue;
 
-			paths.emplace_back(texture.second->GetResourceFilePathNative());
+			paths.emplace_back(texture->GetResourceFilePathNative());
 		}
 
 		return paths;
@@ -213,18 +221,24 @@ namespace Spartan
     shared_ptr<Spartan::RHI_Texture>& Material::GetTexture_PtrShared(const Material_Property type)
     {
         static shared_ptr<RHI_Texture> texture_empty;
-        return HasTexture(type) ? m_textures.at(type) : texture_empty;
+        return HasTexture(type) ? m_textures[GetPropertyIndex(type)] : texture_empty;
     }
 
     void Material::SetColorAlbedo(const Math::Vector4& color)
     {
-        // If an object switches from opaque to transparent or vice versa, make the world update so that the renderer
-        // goes through the entities and makes the ones that use this material, render in the correct mode.
-        if ((m_color_albedo.w != 1.0f && color.w == 1.0f) || (m_color_albedo.w == 1.0f && color.w != 1.0f))
+        // If the material switches from opaque to transparent or vice versa, let the renderer
+        // move the entities which use it, so that they render in the correct mode.
+        const bool transparency_changed = (m_color_albedo.w != 1.0f && color.w == 1.0f) || (m_color_albedo.w == 1.0f && color.w != 1.0f);
+
+        m_color_albedo  = color;
+        m_dirty         = true;
+
+        if (transparency_changed)
         {
-            m_context->GetSubsystem<World>()->MakeDirty();
+            if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+            {
+                renderer->RegistryClassify(this);
+            }
         }
-
-        m_color_albedo = color;
     }
 }
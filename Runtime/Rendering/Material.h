@@ -22,8 +22,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ======================
+#include <array>
 #include <memory>
-#include <unordered_map>
 #include "../RHI/RHI_Definition.h"
 #include "../Resource/IResource.h"
 #include "../Math/Vector2.h"
@@ -72,8 +72,15 @@ namespace Spartan
         bool HasTexture(const Material_Property type) const { return m_flags & type; }
 		std::string GetTexturePathByType(Material_Property type);
 		std::vector<std::string> GetTexturePaths();
-		RHI_Texture* GetTexture_Ptr(const Material_Property type) { return HasTexture(type) ? m_textures[type].get() : nullptr; }
+		RHI_Texture* GetTexture_Ptr(const Material_Property type) { return HasTexture(type) ? m_textures[GetPropertyIndex(type)].get() : nullptr; }
         std::shared_ptr<RHI_Texture>& GetTexture_PtrShared(const Material_Property type);
+        const auto& GetTextures() const { return m_textures; } // by property index, empty where there is no texture
+
+        // Small mask textures are packed by the renderer into the slices of a shared texture array, so they don't need a binding of
+        // their own (see Renderer::MaterialArraySlice()), a texture's slice is -1 while it's bound on its own
+        int32_t GetTextureSlice(const Material_Property type) const { return m_texture_slices[GetPropertyIndex(type)]; }
+        void SetTextureSlice(const Material_Property type, const int32_t slice) { m_texture_slices[GetPropertyIndex(type)] = slice; }
+        void ResetTextureSlices() { m_texture_slices.fill(-1); }
 		//=======================================================================================================================
         
         //= PROPERTIES =====================================================================================
@@ -81,28 +88,47 @@ namespace Spartan
         void SetColorAlbedo(const Math::Vector4& color);
 
         const Math::Vector2& GetTiling()                                    const { return m_uv_tiling; }
-        void SetTiling(const Math::Vector2& tiling)                         { m_uv_tiling = tiling; }
+        void SetTiling(const Math::Vector2& tiling)                         { m_uv_tiling = tiling; m_dirty = true; }
 
         const Math::Vector2& GetOffset()                                    const { return m_uv_offset; }
-        void SetOffset(const Math::Vector2& offset)                         { m_uv_offset = offset; }
+        void SetOffset(const Math::Vector2& offset)                         { m_uv_offset = offset; m_dirty = true; }
 
         auto IsEditable()                                                   const { return m_is_editable; }
         void SetIsEditable(const bool is_editable)                          { m_is_editable = is_editable; }
 
-        auto& GetProperty(const Material_Property type)                     { return m_properties[type]; }
-        void SetProperty(const Material_Property type, const float value)   { m_properties[type] = value; }
+        float GetProperty(const Material_Property type)                     const { return m_properties[GetPropertyIndex(type)]; }
+        void SetProperty(const Material_Property type, const float value)   { m_properties[GetPropertyIndex(type)] = value; m_dirty = true; }
 
         uint16_t GetFlags()                                                 const { return m_flags; }
         //==================================================================================================
 
+        // Set whenever a property or texture changes, the renderer clears it once it has uploaded the material
+        bool IsDirty()                                                      const { return m_dirty; }
+        void SetDirty()                                                     { m_dirty = true; }
+        void ClearDirty()                                                   { m_dirty = false; }
+
+        // Properties are bit flags, their bit is their index in the property and texture arrays
+        static const uint32_t m_property_count = 14;
+        static uint32_t GetPropertyIndex(const Material_Property type)
+        {
+            uint32_t index = 0;
+            for (uint32_t flags = type >> 1; flags != 0; flags >>= 1)
+            {
+                index++;
+            }
+            return index;
+        }
+
 	private:
 		Math::Vector4 m_color_albedo	= Math::Vector4(1.0f, 1.0f, 1.0f, 1.0f);
 		Math::Vector2 m_uv_tiling		= Math::Vector2(1.0f, 1.0f);
 		Math::Vector2 m_uv_offset		= Math::Vector2(0.0f, 0.0f);
 		bool m_is_editable				= true;
         uint16_t m_flags                = 0;
-		std::unordered_map<Material_Property, std::shared_ptr<RHI_Texture>> m_textures;
-		std::unordered_map<Material_Property, float> m_properties;
+        bool m_dirty                    = true;
+		std::array<std::shared_ptr<RHI_Texture>, m_property_count> m_textures;
+		std::array<float, m_property_count> m_properties;
+        std::array<int32_t, m_property_count> m_texture_slices;
 		std::shared_ptr<RHI_Device> m_rhi_device;
 	};
 }
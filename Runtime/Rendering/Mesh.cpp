@@ -36,6 +36,8 @@ namespace Spartan
 	{
 		m_vertices.clear();
 		m_vertices.shrink_to_fit();
+		m_skin.clear();
+		m_skin.shrink_to_fit();
 		m_indices.clear();
 		m_indices.shrink_to_fit();
 	}
@@ -44,6 +46,7 @@ namespace Spartan
     {
 		uint32_t size = 0;
 		size += uint32_t(m_vertices.size()	* sizeof(RHI_Vertex_PosTexNorTan));
+		size += uint32_t(m_skin.size()		* sizeof(RHI_Vertex_Skin));
 		size += uint32_t(m_indices.size()	* sizeof(uint32_t));
 
 		return size;
@@ -78,6 +81,17 @@ namespace Spartan
 		m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
 	}
 
+	void Mesh::Skin_Append(const vector<RHI_Vertex_Skin>& skin, const uint32_t vertex_offset)
+	{
+		if (skin.empty() && m_skin.empty())
+			return;
+
+		// The vertices which were appended without a skin (or before the first one) get empty ones, so they aren't skinned
+		m_skin.resize(vertex_offset);
+		m_skin.insert(m_skin.end(), skin.begin(), skin.end());
+		m_skin.resize(m_vertices.size());
+	}
+
 	uint32_t Mesh::Vertices_Count() const
 	{
 		return static_cast<uint32_t>(m_vertices.size());
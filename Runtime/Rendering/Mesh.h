@@ -53,6 +53,12 @@ namespace Spartan
 		std::vector<RHI_Vertex_PosTexNorTan>& Vertices_Get()					{ return m_vertices; }
 		void Vertices_Set(const std::vector<RHI_Vertex_PosTexNorTan>& vertices)	{ m_vertices = vertices; }
 
+		// Skin, either empty or one per vertex
+		void Skin_Append(const std::vector<RHI_Vertex_Skin>& skin, uint32_t vertex_offset);
+		std::vector<RHI_Vertex_Skin>& Skin_Get()				{ return m_skin; }
+		void Skin_Set(const std::vector<RHI_Vertex_Skin>& skin)	{ m_skin = skin; }
+		bool Skin_Exists() const								{ return !m_skin.empty(); }
+
 		// Indices
 		void Index_Add(uint32_t index)							{ m_indices.emplace_back(index); }
 		std::vector<uint32_t>& Indices_Get()					{ return m_indices; }
@@ -65,6 +71,7 @@ namespace Spartan
 		
 	private:
 		std::vector<RHI_Vertex_PosTexNorTan> m_vertices;
+		std::vector<RHI_Vertex_Skin> m_skin;
 		std::vector<uint32_t> m_indices;
 	};
 }
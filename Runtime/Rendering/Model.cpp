@@ -59,11 +59,19 @@ namespace Spartan
     {
         m_root_entity.reset();
         m_vertex_buffer.reset();
+        m_vertex_buffer_position.reset();
         m_index_buffer.reset();
         m_mesh->Geometry_Clear();
+        m_mesh_released = false;
+        GeometryPositionsClear();
         m_aabb.Undefine();
+        {
+            lock_guard<mutex> lock(m_triangle_bvhs_mutex);
+            m_triangle_bvhs.clear();
+        }
         m_normalized_scale = 1.0f;
         m_is_animated = false;
+        m_vertex_skinned = false;
     }
 
 	bool Model::LoadFromFile(const string& file_path)
@@ -80,16 +88,42 @@ namespace Spartan
         if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_MODEL)
         {
             // Deserialize
-            auto file = make_unique<FileStream>(file_path, FileStream_Read);
+            auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
             if (!file->IsOpen())
                 return false;
 
             SetResourceFilePath(file->ReadAs<string>());
             file->Read(&m_normalized_scale);
-            file->Read(&m_mesh->Indices_Get());
-            file->Read(&m_mesh->Vertices_Get());
+            file->Read(&m_vertex_compact);
+
+            // The geometry goes from the mapping straight to the gpu, the cpu copy is only read when something asks for it (see GeometryCpuAcquire())
+            uint32_t index_count    = 0;
+            uint32_t vertex_count   = 0;
+            uint32_t skin_count     = 0;
+            const uint32_t* indices                 = file->ReadSpan<uint32_t>(&index_count);
+            const RHI_Vertex_PosTexNorTan* vertices = file->ReadSpan<RHI_Vertex_PosTexNorTan>(&vertex_count);
+            const RHI_Vertex_Skin* skin             = file->ReadSpan<RHI_Vertex_Skin>(&skin_count);
+            if (index_count == 0 || vertex_count == 0)
+            {
+                LOG_ERROR("\"%s\" has no geometry", file_path.c_str());
+                return false;
+            }
 
-            UpdateGeometry();
+            GeometryCreateBuffers(indices, index_count, vertices, vertex_count, skin_count == vertex_count ? skin : nullptr);
+            m_aabb              = GeometryComputeAabb(reinterpret_cast<const std::byte*>(vertices), vertex_count);
+            m_normalized_scale  = GeometryComputeNormalizedScale();
+            m_mesh->Geometry_Clear();
+            m_mesh_released     = true;
+            GeometryPositionsClear();
+
+            lock_guard<mutex> lock(m_triangle_bvhs_mutex);
+            m_triangle_bvhs.clear();
+
+            // Kept geometry is brought back right away, instead of by whatever needs it first
+            if (m_residency == Model_Residency_Full)
+            {
+                GeometryCpuAcquire();
+            }
         }
         // Load foreign format
         else
@@ -115,9 +149,10 @@ namespace Spartan
             m_size_cpu = !m_mesh ? 0 : m_mesh->Geometry_MemoryUsage();
 
             // Gpu
-            if (m_vertex_buffer && m_index_buffer)
+            if (m_vertex_buffer && m_vertex_buffer_position && m_index_buffer)
             {
                 m_size_gpu = m_vertex_buffer->GetSizeGpu();
+                m_size_gpu += m_vertex_buffer_position->GetSizeGpu();
                 m_size_gpu += m_index_buffer->GetSizeGpu();
             }
         }
@@ -129,51 +164,167 @@ namespace Spartan
 
 	bool Model::SaveToFile(const string& file_path)
 	{
+        // Released geometry is unchanged since it was last saved, so the engine file already holds it
+        const bool is_native = file_path == GetResourceFilePathNative();
+        if (is_native && m_mesh_released)
+            return true;
+
+        // Before the file is opened, it can be the one which the geometry is read back from
+        GeometryCpuAcquire();
+
 		auto file = make_unique<FileStream>(file_path, FileStream_Write);
 		if (!file->IsOpen())
 			return false;
 
 		file->Write(GetResourceFilePath());
 		file->Write(m_normalized_scale);
+		file->Write(m_vertex_compact);
 		file->Write(m_mesh->Indices_Get());
 		file->Write(m_mesh->Vertices_Get());
+		file->Write(m_mesh->Skin_Get());
 
         file->Close();
 
+        // The geometry can be read back from the file now
+        if (is_native)
+        {
+            GeometryCpuRelease();
+        }
+
 		return true;
 	}
 
-	void Model::AppendGeometry(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* index_offset, uint32_t* vertex_offset) const
+	void Model::AppendGeometry(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* index_offset, uint32_t* vertex_offset, const vector<RHI_Vertex_Skin>* skin) const
 	{
-		if (indices.empty() || vertices.empty())
+		// The vertices can be empty, for indices which refer to vertices that were appended before (like levels of detail)
+		if (indices.empty())
 		{
 			LOG_ERROR_INVALID_PARAMETER();
 			return;
 		}
 
 		// Append indices and vertices to the main mesh
+        GeometryCpuAcquire();
+        GeometryPositionsClear();
+		uint32_t vertex_start = 0;
 		m_mesh->Indices_Append(indices, index_offset);
-		m_mesh->Vertices_Append(vertices, vertex_offset);
+		m_mesh->Vertices_Append(vertices, &vertex_start);
+		m_mesh->Skin_Append(skin && skin->size() == vertices.size() ? *skin : vector<RHI_Vertex_Skin>(), vertex_start);
+
+		if (vertex_offset)
+		{
+			*vertex_offset = vertex_start;
+		}
 	}
 
 	void Model::GetGeometry(const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, const uint32_t vertex_count, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices) const
 	{
+        GeometryCpuAcquire();
 		m_mesh->Geometry_Get(index_offset, index_count, vertex_offset, vertex_count, indices, vertices);
 	}
 
 	void Model::UpdateGeometry()
 	{
+        GeometryCpuAcquire();
+
 		if (m_mesh->Indices_Count() == 0 || m_mesh->Vertices_Count() == 0)
 		{
 			LOG_ERROR_INVALID_PARAMETER();
 			return;
 		}
 
-		GeometryCreateBuffers();
+		GeometryCreateBuffers(m_mesh->Indices_Get().data(), m_mesh->Indices_Count(), m_mesh->Vertices_Get().data(), m_mesh->Vertices_Count(), m_mesh->Skin_Exists() ? m_mesh->Skin_Get().data() : nullptr);
 		m_normalized_scale	= GeometryComputeNormalizedScale();
 		m_aabb				= BoundingBox(m_mesh->Vertices_Get().data(), static_cast<uint32_t>(m_mesh->Vertices_Get().size()));
+
+        // The triangles could have changed
+        GeometryPositionsClear();
+        lock_guard<mutex> lock(m_triangle_bvhs_mutex);
+        m_triangle_bvhs.clear();
 	}
 
+    void Model::SetVertexCompact(const bool vertex_compact)
+    {
+        if (m_vertex_compact == vertex_compact)
+            return;
+
+        m_vertex_compact = vertex_compact;
+
+        // Re-create the vertex buffer, if there is one
+        if (m_vertex_buffer)
+        {
+            UpdateGeometry();
+        }
+    }
+
+    void Model::SetResidency(const Model_Residency residency)
+    {
+        m_residency = residency;
+
+        // Kept geometry is brought back now, instead of by whatever needs it first
+        if (m_residency == Model_Residency_Full)
+        {
+            GeometryCpuAcquire();
+        }
+    }
+
+    void Model::SetVertexDisplacement(const shared_ptr<RHI_Texture>& height_map, const Vector4& uv_scale_offset, const Vector2& height_min_max)
+    {
+        // The displacement shaders read full vertices
+        if (height_map)
+        {
+            SetVertexCompact(false);
+        }
+
+        m_vertex_displacement_map               = height_map;
+        m_vertex_displacement_uv_scale_offset   = uv_scale_offset;
+        m_vertex_displacement_height            = height_min_max;
+    }
+
+    float Model::GeometryTrace(const Ray& ray, const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset) const
+    {
+        const vector<uint32_t>& indices = GetIndices();
+        const vector<Vector3>& positions = GetPositions();
+        if (index_count < 3 || index_offset + index_count > indices.size())
+            return INFINITY;
+
+        auto position = [&indices, &positions, index_offset, vertex_offset](const uint32_t i)
+        {
+            return positions[vertex_offset + indices[index_offset + i]];
+        };
+
+        // Get (or build) the hierarchy of the range
+        const BoundingVolumeHierarchy* bvh = nullptr;
+        {
+            lock_guard<mutex> lock(m_triangle_bvhs_mutex);
+
+            unique_ptr<BoundingVolumeHierarchy>& entry = m_triangle_bvhs[(static_cast<uint64_t>(index_offset) << 32) | vertex_offset];
+            if (!entry)
+            {
+                const uint32_t triangle_count = index_count / 3;
+                vector<BoundingBox> boxes(triangle_count);
+                for (uint32_t i = 0; i < triangle_count; i++)
+                {
+                    const Vector3 corners[3] = { position(i * 3), position(i * 3 + 1), position(i * 3 + 2) };
+                    boxes[i] = BoundingBox(corners, 3);
+                }
+
+                entry = make_unique<BoundingVolumeHierarchy>();
+                entry->Build(boxes);
+            }
+
+            bvh = entry.get();
+        }
+
+        float distance = INFINITY;
+        bvh->Query(ray, [&ray, &position, &distance](const uint32_t triangle)
+        {
+            distance = Helper::Min(distance, ray.HitDistance(position(triangle * 3), position(triangle * 3 + 1), position(triangle * 3 + 2)));
+        });
+
+        return distance;
+    }
+
 	void Model::AddMaterial(shared_ptr<Material>& material, const shared_ptr<Entity>& entity) const
     {
 		if (!material || !entity)
@@ -190,45 +341,72 @@ namespace Spartan
         entity->AddComponent<Renderable>()->SetMaterial(material);
 	}
 
-	void Model::AddTexture(shared_ptr<Material>& material, const Material_Property texture_type, const string& file_path)
+	shared_ptr<RHI_Texture2D> Model::LoadTexture(const Material_Property texture_type, const string& file_path) const
 	{
-		if (!material || file_path.empty())
+		if (file_path.empty())
 		{
 			LOG_ERROR_INVALID_PARAMETER();
-			return;
+			return nullptr;
 		}
 
 		// Try to get the texture
 		const auto tex_name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
 		if (auto texture = m_context->GetSubsystem<ResourceCache>()->GetByName<RHI_Texture2D>(tex_name))
+			return texture;
+
+		// If we didn't get a texture, it's not cached, hence we have to load it (it's cached once it's set to a material)
+		auto generate_mipmaps = true;
+		auto texture = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
+
+		// Block compress by what the slot reads, normals only need two channels (z is reconstructed) and masks need one.
+		// Height shares the normal's format, as the importer can move a texture between the two once it knows whether it's grayscale.
+		if (texture_type == Material_Normal || texture_type == Material_Height)
+		{
+			texture->SetCompression(RHI_Format_BC5_Unorm);
+		}
+		else if (texture_type == Material_Color || texture_type == Material_Emission)
 		{
-			material->SetTextureSlot(texture_type, texture);
+			texture->SetCompression(RHI_Format_BC7_Unorm);
 		}
-		// If we didn't get a texture, it's not cached, hence we have to load it and cache it now
 		else
 		{
-			// Load texture
-			auto generate_mipmaps = true;
-            texture = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
-			texture->LoadFromFile(file_path);
-
-			// Set the texture to the provided material
-			material->SetTextureSlot(texture_type, texture);
+			texture->SetCompression(RHI_Format_BC4_Unorm);
 		}
+
+		// Color is gamma encoded, so its mips are filtered in linear space
+		texture->SetSrgb(texture_type == Material_Color);
+
+		texture->LoadFromFile(file_path);
+
+		return texture;
 	}
 
-	bool Model::GeometryCreateBuffers()
+	const shared_ptr<Mesh>& Model::GetMesh() const
 	{
-		auto success = true;
+        GeometryCpuAcquire();
+        return m_mesh;
+	}
+
+    const vector<Vector3>& Model::GetPositions() const
+    {
+        GeometryPositionsAcquire();
+        return m_positions;
+    }
 
-		// Get geometry
-		const auto indices	= m_mesh->Indices_Get();
-		const auto vertices	= m_mesh->Vertices_Get();
+    const vector<uint32_t>& Model::GetIndices() const
+    {
+        GeometryPositionsAcquire();
+        return m_positions_indices;
+    }
 
-		if (!indices.empty())
+	bool Model::GeometryCreateBuffers(const uint32_t* indices, const uint32_t index_count, const RHI_Vertex_PosTexNorTan* vertices, const uint32_t vertex_count, const RHI_Vertex_Skin* skin)
+	{
+		auto success = true;
+
+		if (indices && index_count != 0)
 		{
 			m_index_buffer = make_shared<RHI_IndexBuffer>(m_rhi_device);
-			if (!m_index_buffer->Create(indices))
+			if (!m_index_buffer->Create(indices, index_count))
 			{
 				LOG_ERROR("Failed to create index buffer for \"%s\".", GetResourceName().c_str());
 				success = false;
@@ -240,14 +418,79 @@ namespace Spartan
 			success = false;
 		}
 
-		if (!vertices.empty())
+		if (vertices && vertex_count != 0)
 		{
 			m_vertex_buffer = make_shared<RHI_VertexBuffer>(m_rhi_device);
-			if (!m_vertex_buffer->Create(vertices))
+
+			bool created		= false;
+			m_vertex_skinned	= skin != nullptr;
+			if (m_vertex_skinned)
+			{
+				// The vertices can come from a mapped file, which isn't aligned
+				vector<RHI_Vertex_PosTexNorTanSkin> vertices_skinned(vertex_count);
+				for (uint32_t i = 0; i < vertex_count; i++)
+				{
+					RHI_Vertex_PosTexNorTan vertex;
+					RHI_Vertex_Skin vertex_skin;
+					memcpy(&vertex, reinterpret_cast<const std::byte*>(vertices) + i * sizeof(RHI_Vertex_PosTexNorTan), sizeof(RHI_Vertex_PosTexNorTan));
+					memcpy(&vertex_skin, reinterpret_cast<const std::byte*>(skin) + i * sizeof(RHI_Vertex_Skin), sizeof(RHI_Vertex_Skin));
+					vertices_skinned[i] = RHI_Vertex_PosTexNorTanSkin(vertex, vertex_skin);
+				}
+
+				m_vertex_position_offset	= Vector3::Zero;
+				m_vertex_position_scale		= Vector3::One;
+				created						= m_vertex_buffer->Create(vertices_skinned);
+			}
+			else if (m_vertex_compact)
+			{
+				// Positions are normalized to the bounds, an axis which they are flat on gets a scale of zero
+				const BoundingBox aabb		= GeometryComputeAabb(reinterpret_cast<const std::byte*>(vertices), vertex_count);
+				m_vertex_position_offset	= aabb.GetMin();
+				m_vertex_position_scale		= aabb.GetMax() - aabb.GetMin();
+				const Vector3 scale_inv		= Vector3
+				(
+					m_vertex_position_scale.x > 0.0f ? 1.0f / m_vertex_position_scale.x : 0.0f,
+					m_vertex_position_scale.y > 0.0f ? 1.0f / m_vertex_position_scale.y : 0.0f,
+					m_vertex_position_scale.z > 0.0f ? 1.0f / m_vertex_position_scale.z : 0.0f
+				);
+
+				// The vertices can come from a mapped file, which isn't aligned
+				vector<RHI_Vertex_PosTexNorTanCompact> vertices_compact(vertex_count);
+				for (uint32_t i = 0; i < vertex_count; i++)
+				{
+					RHI_Vertex_PosTexNorTan vertex;
+					memcpy(&vertex, reinterpret_cast<const std::byte*>(vertices) + i * sizeof(RHI_Vertex_PosTexNorTan), sizeof(RHI_Vertex_PosTexNorTan));
+					vertices_compact[i] = RHI_Vertex_PosTexNorTanCompact(vertex, m_vertex_position_offset, scale_inv);
+				}
+
+				created = m_vertex_buffer->Create(vertices_compact);
+			}
+			else
+			{
+				m_vertex_position_offset	= Vector3::Zero;
+				m_vertex_position_scale		= Vector3::One;
+				created						= m_vertex_buffer->Create(vertices, vertex_count);
+			}
+
+			if (!created)
 			{
 				LOG_ERROR("Failed to create vertex buffer for \"%s\".", GetResourceName().c_str());
 				success = false;
 			}
+
+			// Depth only passes read nothing but the positions, so they get a stream of their own
+			vector<RHI_Vertex_Pos> positions(vertex_count);
+			for (uint32_t i = 0; i < vertex_count; i++)
+			{
+				memcpy(positions[i].pos, reinterpret_cast<const std::byte*>(vertices) + i * sizeof(RHI_Vertex_PosTexNorTan) + offsetof(RHI_Vertex_PosTexNorTan, pos), sizeof(positions[i].pos));
+			}
+
+			m_vertex_buffer_position = make_shared<RHI_VertexBuffer>(m_rhi_device);
+			if (!m_vertex_buffer_position->Create(positions))
+			{
+				LOG_ERROR("Failed to create position vertex buffer for \"%s\".", GetResourceName().c_str());
+				success = false;
+			}
 		}
 		else
 		{
@@ -258,6 +501,132 @@ namespace Spartan
 		return success;
 	}
 
+    void Model::GeometryCpuAcquire() const
+    {
+        if (!m_mesh_released.load(memory_order_acquire))
+            return;
+
+        lock_guard<mutex> lock(m_mesh_mutex);
+        if (!m_mesh_released.load(memory_order_relaxed))
+            return;
+
+        auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read | FileStream_Mapped);
+        if (file->IsOpen())
+        {
+            file->ReadAs<string>();
+            file->ReadAs<float>();
+            file->ReadAs<bool>();
+            file->Read(&m_mesh->Indices_Get());
+            file->Read(&m_mesh->Vertices_Get());
+            file->Read(&m_mesh->Skin_Get());
+        }
+        else
+        {
+            LOG_ERROR("Failed to read back the geometry of \"%s\"", GetResourceName().c_str());
+        }
+
+        // Even on failure, so that the file isn't opened by every caller
+        m_mesh_released.store(false, memory_order_release);
+    }
+
+    void Model::GeometryCpuRelease()
+    {
+        if (m_residency == Model_Residency_Full)
+            return;
+
+        {
+            lock_guard<mutex> lock(m_mesh_mutex);
+            m_mesh->Geometry_Clear();
+            m_mesh_released.store(true, memory_order_release);
+        }
+
+        m_size_cpu = m_mesh->Geometry_MemoryUsage();
+    }
+
+    void Model::GeometryPositionsAcquire() const
+    {
+        if (m_positions_valid.load(memory_order_acquire))
+            return;
+
+        lock_guard<mutex> lock(m_mesh_mutex);
+        if (m_positions_valid.load(memory_order_relaxed))
+            return;
+
+        if (!m_mesh_released.load(memory_order_relaxed))
+        {
+            const vector<RHI_Vertex_PosTexNorTan>& vertices = m_mesh->Vertices_Get();
+            m_positions.resize(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                m_positions[i] = Vector3(vertices[i].pos[0], vertices[i].pos[1], vertices[i].pos[2]);
+            }
+            m_positions_indices = m_mesh->Indices_Get();
+        }
+        else
+        {
+            // Only the positions are copied out of the mapping, the full vertices stay on disk
+            auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read | FileStream_Mapped);
+            if (file->IsOpen())
+            {
+                file->ReadAs<string>();
+                file->ReadAs<float>();
+                file->ReadAs<bool>();
+
+                uint32_t index_count    = 0;
+                uint32_t vertex_count   = 0;
+                const uint32_t* indices = file->ReadSpan<uint32_t>(&index_count);
+                const std::byte* vertices = reinterpret_cast<const std::byte*>(file->ReadSpan<RHI_Vertex_PosTexNorTan>(&vertex_count));
+
+                m_positions_indices.resize(index_count);
+                memcpy(m_positions_indices.data(), indices, index_count * sizeof(uint32_t));
+                m_positions.resize(vertex_count);
+                for (uint32_t i = 0; i < vertex_count; i++)
+                {
+                    memcpy(&m_positions[i], vertices + i * sizeof(RHI_Vertex_PosTexNorTan) + offsetof(RHI_Vertex_PosTexNorTan, pos), sizeof(float) * 3);
+                }
+            }
+            else
+            {
+                LOG_ERROR("Failed to read back the positions of \"%s\"", GetResourceName().c_str());
+            }
+        }
+
+        // Even on failure, so that the file isn't opened by every caller
+        m_positions_valid.store(true, memory_order_release);
+    }
+
+    void Model::GeometryPositionsClear() const
+    {
+        lock_guard<mutex> lock(m_mesh_mutex);
+        m_positions.clear();
+        m_positions.shrink_to_fit();
+        m_positions_indices.clear();
+        m_positions_indices.shrink_to_fit();
+        m_positions_valid.store(false, memory_order_release);
+    }
+
+    BoundingBox Model::GeometryComputeAabb(const std::byte* vertices, const uint32_t vertex_count)
+    {
+        // A mapped file isn't aligned, so the positions are copied out instead of being read in place
+        Vector3 min = Vector3::Infinity;
+        Vector3 max = Vector3::InfinityNeg;
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            Vector3 position;
+            memcpy(&position, vertices + i * sizeof(RHI_Vertex_PosTexNorTan) + offsetof(RHI_Vertex_PosTexNorTan, pos), sizeof(float) * 3);
+
+            max.x = Helper::Max(max.x, position.x);
+            max.y = Helper::Max(max.y, position.y);
+            max.z = Helper::Max(max.z, position.z);
+
+            min.x = Helper::Min(min.x, position.x);
+            min.y = Helper::Min(min.y, position.y);
+            min.z = Helper::Min(min.z, position.z);
+        }
+
+        return BoundingBox(min, max);
+    }
+
 	float Model::GeometryComputeNormalizedScale() const
 	{
 		// Compute scale offset
@@ -21,14 +21,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES =====================
+//= INCLUDES =================================
 #include <memory>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include "Material.h"
 #include "../RHI/RHI_Definition.h"
 #include "../Resource/IResource.h"
 #include "../Math/BoundingBox.h"
-//================================
+#include "../Math/BoundingVolumeHierarchy.h"
+//============================================
 
 namespace Spartan
 {
@@ -37,6 +41,12 @@ namespace Spartan
 	class Mesh;
 	namespace Math{ class BoundingBox; }
 
+    enum Model_Residency : uint8_t
+    {
+        Model_Residency_Gpu,    // the cpu geometry is dropped once it's on the gpu and saved, it's read back from the file when something needs it
+        Model_Residency_Full    // the cpu geometry stays, for models whose geometry is edited or read a lot
+    };
+
 	class SPARTAN_CLASS Model : public IResource, public std::enable_shared_from_this<Model>
 	{
 	public:
@@ -54,8 +64,9 @@ namespace Spartan
         void AppendGeometry(
             const std::vector<uint32_t>& indices,
             const std::vector<RHI_Vertex_PosTexNorTan>& vertices,
-            uint32_t* index_offset  = nullptr,
-            uint32_t* vertex_offset = nullptr
+            uint32_t* index_offset                      = nullptr,
+            uint32_t* vertex_offset                     = nullptr,
+            const std::vector<RHI_Vertex_Skin>* skin    = nullptr // one per vertex, if the geometry is skinned
         ) const;
         void GetGeometry(
             uint32_t index_offset,
@@ -66,34 +77,85 @@ namespace Spartan
             std::vector<RHI_Vertex_PosTexNorTan>* vertices
         ) const;
         void UpdateGeometry();
+        // Returns the distance to the closest triangle of a geometry range which a ray (in model space) hits, or infinity if there is none.
+        // The first trace of a range builds a bounding volume hierarchy over its triangles, it's kept until the geometry changes.
+        float GeometryTrace(const Math::Ray& ray, uint32_t index_offset, uint32_t index_count, uint32_t vertex_offset) const;
         const auto& GetAabb() const { return m_aabb; }
-        const auto& GetMesh() const { return m_mesh; }
+        // Models which are loaded from the engine format drop their cpu geometry once it's on the gpu, it's read back from the file the first time it's needed
+        const std::shared_ptr<Mesh>& GetMesh() const;
+        // Positions and indices of all the geometry, a compact copy for picking, physics and occlusion which doesn't bring the full vertices back.
+        // The first call of a released model reads it from the file, it's kept until the geometry changes.
+        const std::vector<Math::Vector3>& GetPositions() const;
+        const std::vector<uint32_t>& GetIndices() const;
+        // Whether the cpu geometry is dropped (the default) or kept, dropping happens once the model is saved to its engine file
+        void SetResidency(Model_Residency residency);
+        Model_Residency GetResidency()              const { return m_residency; }
+        // The gpu can get quantized vertices (see RHI_Vertex_PosTexNorTanCompact), which the cpu geometry is unaffected by.
+        // Set it before the model is loaded to have it at import, engine files keep it. Skinned models ignore it.
+        void SetVertexCompact(bool vertex_compact);
+        bool IsVertexCompact()                      const { return m_vertex_compact && !m_vertex_skinned; }
+        // Models with a skin get RHI_Vertex_PosTexNorTanSkin vertices, which the renderables move with their bones
+        bool IsVertexSkinned()                      const { return m_vertex_skinned; }
+        // What compact positions are scaled by and offset with, to get back to model space
+        const Math::Vector3& GetVertexPositionOffset() const { return m_vertex_position_offset; }
+        const Math::Vector3& GetVertexPositionScale()  const { return m_vertex_position_scale; }
+        // Displaced models are a flat patch whose units are texels of a height map, which the vertex shaders lift the vertices with (a terrain sets it up, it's not saved).
+        // Where a patch samples depends on the translation of its entity: its xz times the scale of uv_scale_offset (xy) plus its offset (zw) is the uv of the patch origin,
+        // a height of 0 to 1 in the height map maps to height_min_max. Displacing a model turns its compact vertices off.
+        void SetVertexDisplacement(const std::shared_ptr<RHI_Texture>& height_map, const Math::Vector4& uv_scale_offset, const Math::Vector2& height_min_max);
+        bool IsVertexDisplaced()                    const { return m_vertex_displacement_map != nullptr && !m_vertex_skinned; }
+        RHI_Texture* GetVertexDisplacementMap()     const { return m_vertex_displacement_map.get(); }
+        const Math::Vector4& GetVertexDisplacementUvScaleOffset() const { return m_vertex_displacement_uv_scale_offset; }
+        const Math::Vector2& GetVertexDisplacementHeight()        const { return m_vertex_displacement_height; }
 
 		// Add resources to the model
         void SetRootEntity(const std::shared_ptr<Entity>& entity) { m_root_entity = entity; }
 		void AddMaterial(std::shared_ptr<Material>& material, const std::shared_ptr<Entity>& entity) const;
-		void AddTexture(std::shared_ptr<Material>& material, Material_Property texture_type, const std::string& file_path);
+		// Gets the texture (if it's cached) or loads it, configured for the material slot. Loads of different files can run in parallel.
+		std::shared_ptr<RHI_Texture2D> LoadTexture(Material_Property texture_type, const std::string& file_path) const;
 
         // Misc
         bool IsAnimated()                           const { return m_is_animated; }
 		void SetAnimated(const bool is_animated)	      { m_is_animated = is_animated; }
 		const RHI_IndexBuffer* GetIndexBuffer()     const { return m_index_buffer.get(); }
 		const RHI_VertexBuffer* GetVertexBuffer()   const { return m_vertex_buffer.get(); }
+		const RHI_VertexBuffer* GetVertexBufferPosition() const { return m_vertex_buffer_position.get(); } // RHI_Vertex_Pos, for depth only passes
 		auto GetSharedPtr()							      { return shared_from_this(); }
 
 	private:
 		// Geometry
-		bool GeometryCreateBuffers();
+		bool GeometryCreateBuffers(const uint32_t* indices, uint32_t index_count, const RHI_Vertex_PosTexNorTan* vertices, uint32_t vertex_count, const RHI_Vertex_Skin* skin);
 		float GeometryComputeNormalizedScale() const;
+        void GeometryCpuAcquire() const;
+        void GeometryCpuRelease();
+        void GeometryPositionsAcquire() const;
+        void GeometryPositionsClear() const;
+        static Math::BoundingBox GeometryComputeAabb(const std::byte* vertices, uint32_t vertex_count);
 
 		// Misc
 		std::weak_ptr<Entity> m_root_entity;
 		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
+		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer_position;
 		std::shared_ptr<RHI_IndexBuffer> m_index_buffer;
 		std::shared_ptr<Mesh> m_mesh;
+        mutable std::atomic<bool> m_mesh_released = false;
+        mutable std::mutex m_mesh_mutex;
+        mutable std::vector<Math::Vector3> m_positions;     // guarded by m_mesh_mutex
+        mutable std::vector<uint32_t> m_positions_indices;  // guarded by m_mesh_mutex
+        mutable std::atomic<bool> m_positions_valid = false;
+        Model_Residency m_residency = Model_Residency_Gpu;
 		Math::BoundingBox m_aabb;
+        mutable std::unordered_map<uint64_t, std::unique_ptr<Math::BoundingVolumeHierarchy>> m_triangle_bvhs; // by index and vertex offset
+        mutable std::mutex m_triangle_bvhs_mutex;
 		float m_normalized_scale	= 1.0f;
 		bool m_is_animated			= false;
+		bool m_vertex_compact		= false;
+		bool m_vertex_skinned		= false;
+		Math::Vector3 m_vertex_position_offset	= Math::Vector3::Zero;
+		Math::Vector3 m_vertex_position_scale	= Math::Vector3::One;
+		std::shared_ptr<RHI_Texture> m_vertex_displacement_map;
+		Math::Vector4 m_vertex_displacement_uv_scale_offset	= Math::Vector4::Zero;
+		Math::Vector2 m_vertex_displacement_height			= Math::Vector2::Zero;
 
         // Dependencies
 		ResourceCache* m_resource_manager;
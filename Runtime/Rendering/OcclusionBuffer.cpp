@@ -0,0 +1,243 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==================
+#include <algorithm>
+#include <limits>
+#include "OcclusionBuffer.h"
+#include "../Math/Vector4.h"
+//=============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        // Nothing rasterized, infinitely far
+        constexpr float depth_empty = numeric_limits<float>::max();
+        // Pixels exactly on an edge which two triangles share can be missed by both, the holes would then spread through the pyramid
+        constexpr float barycentric_tolerance = 1e-4f;
+    }
+
+    OcclusionBuffer::OcclusionBuffer(const uint32_t width /*= 256*/, const uint32_t height /*= 128*/)
+    {
+        uint32_t level_width    = width;
+        uint32_t level_height   = height;
+        while (true)
+        {
+            Level& level    = m_levels.emplace_back();
+            level.width     = level_width;
+            level.height    = level_height;
+            level.depth.resize(level_width * level_height, depth_empty);
+
+            if (level_width == 1 && level_height == 1)
+                break;
+
+            level_width     = max(level_width / 2, 1u);
+            level_height    = max(level_height / 2, 1u);
+        }
+    }
+
+    void OcclusionBuffer::Begin(const Matrix& view_projection, const float near_plane)
+    {
+        m_view_projection       = view_projection;
+        m_near_plane            = near_plane;
+        m_triangles_rasterized  = 0;
+        m_empty                 = true;
+
+        fill(m_levels[0].depth.begin(), m_levels[0].depth.end(), depth_empty);
+    }
+
+    void OcclusionBuffer::Rasterize(const Vector3* positions, const uint32_t* indices, const uint32_t index_count, const Matrix& world)
+    {
+        Level& level        = m_levels[0];
+        const float width   = static_cast<float>(level.width);
+        const float height  = static_cast<float>(level.height);
+        const Matrix world_view_projection = world * m_view_projection;
+
+        for (uint32_t i = 0; i + 2 < index_count; i += 3)
+        {
+            // To screen space, triangles which cross the near plane are skipped (an occluder which is missing a triangle only hides less)
+            float x[3], y[3], w_inv[3];
+            bool clipped = false;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const Vector3& pos  = positions[indices[i + corner]];
+                const Vector4 clip  = Vector4(pos, 1.0f) * world_view_projection;
+                if (clip.w < m_near_plane)
+                {
+                    clipped = true;
+                    break;
+                }
+
+                w_inv[corner]   = 1.0f / clip.w;
+                x[corner]       = (clip.x * w_inv[corner] * 0.5f + 0.5f) * width;
+                y[corner]       = (0.5f - clip.y * w_inv[corner] * 0.5f) * height;
+            }
+
+            if (clipped)
+                continue;
+
+            // Both windings occlude, so the area decides the orientation
+            const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+            if (area == 0.0f)
+                continue;
+
+            const float area_inv = 1.0f / area;
+
+            // Pixel bounds
+            const int32_t x_min = max(static_cast<int32_t>(min({ x[0], x[1], x[2] })), 0);
+            const int32_t y_min = max(static_cast<int32_t>(min({ y[0], y[1], y[2] })), 0);
+            const int32_t x_max = min(static_cast<int32_t>(max({ x[0], x[1], x[2] })), static_cast<int32_t>(level.width) - 1);
+            const int32_t y_max = min(static_cast<int32_t>(max({ y[0], y[1], y[2] })), static_cast<int32_t>(level.height) - 1);
+            if (x_min > x_max || y_min > y_max)
+                continue;
+
+            m_triangles_rasterized++;
+
+            for (int32_t pixel_y = y_min; pixel_y <= y_max; pixel_y++)
+            {
+                const float sample_y = pixel_y + 0.5f;
+                for (int32_t pixel_x = x_min; pixel_x <= x_max; pixel_x++)
+                {
+                    const float sample_x = pixel_x + 0.5f;
+
+                    // Barycentrics, scaled by the area so that they are positive inside for either winding
+                    const float b0 = ((x[1] - sample_x) * (y[2] - sample_y) - (x[2] - sample_x) * (y[1] - sample_y)) * area_inv;
+                    const float b1 = ((x[2] - sample_x) * (y[0] - sample_y) - (x[0] - sample_x) * (y[2] - sample_y)) * area_inv;
+                    const float b2 = 1.0f - b0 - b1;
+                    if (b0 < -barycentric_tolerance || b1 < -barycentric_tolerance || b2 < -barycentric_tolerance)
+                        continue;
+
+                    // 1/w is linear in screen space
+                    const float depth   = 1.0f / (b0 * w_inv[0] + b1 * w_inv[1] + b2 * w_inv[2]);
+                    float& texel        = level.depth[pixel_y * level.width + pixel_x];
+                    texel               = min(texel, depth);
+                }
+            }
+        }
+
+        m_empty = m_empty && m_triangles_rasterized == 0;
+    }
+
+    void OcclusionBuffer::End()
+    {
+        // Every texel keeps the farthest of the texels it covers in the level above, so a box behind it is behind all of them
+        for (size_t i = 1; i < m_levels.size(); i++)
+        {
+            const Level& source = m_levels[i - 1];
+            Level& target       = m_levels[i];
+
+            for (uint32_t y = 0; y < target.height; y++)
+            {
+                for (uint32_t x = 0; x < target.width; x++)
+                {
+                    const uint32_t x0 = min(x * 2, source.width - 1);
+                    const uint32_t x1 = min(x * 2 + 1, source.width - 1);
+                    const uint32_t y0 = min(y * 2, source.height - 1);
+                    const uint32_t y1 = min(y * 2 + 1, source.height - 1);
+
+                    target.depth[y * target.width + x] = max
+                    ({
+                        source.depth[y0 * source.width + x0],
+                        source.depth[y0 * source.width + x1],
+                        source.depth[y1 * source.width + x0],
+                        source.depth[y1 * source.width + x1]
+                    });
+                }
+            }
+        }
+    }
+
+    bool OcclusionBuffer::IsVisible(const Vector3& center, const Vector3& extents) const
+    {
+        if (m_empty)
+            return true;
+
+        // Screen space rectangle and nearest depth of the box
+        const Level& level_top  = m_levels[0];
+        float x_min             = numeric_limits<float>::max();
+        float y_min             = numeric_limits<float>::max();
+        float x_max             = numeric_limits<float>::lowest();
+        float y_max             = numeric_limits<float>::lowest();
+        float depth_min         = numeric_limits<float>::max();
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            const Vector3 position = Vector3
+            (
+                center.x + ((corner & 1) ? extents.x : -extents.x),
+                center.y + ((corner & 2) ? extents.y : -extents.y),
+                center.z + ((corner & 4) ? extents.z : -extents.z)
+            );
+
+            // A box which reaches the near plane is too close to be hidden
+            const Vector4 clip = Vector4(position, 1.0f) * m_view_projection;
+            if (clip.w < m_near_plane)
+                return true;
+
+            const float x   = (clip.x / clip.w * 0.5f + 0.5f) * level_top.width;
+            const float y   = (0.5f - clip.y / clip.w * 0.5f) * level_top.height;
+            x_min           = min(x_min, x);
+            y_min           = min(y_min, y);
+            x_max           = max(x_max, x);
+            y_max           = max(y_max, y);
+            depth_min       = min(depth_min, clip.w);
+        }
+
+        // The frustum test already rejected boxes which are off screen, what's left gets clamped
+        const int32_t pixel_x_min = max(static_cast<int32_t>(x_min), 0);
+        const int32_t pixel_y_min = max(static_cast<int32_t>(y_min), 0);
+        const int32_t pixel_x_max = min(static_cast<int32_t>(x_max), static_cast<int32_t>(level_top.width) - 1);
+        const int32_t pixel_y_max = min(static_cast<int32_t>(y_max), static_cast<int32_t>(level_top.height) - 1);
+        if (pixel_x_min > pixel_x_max || pixel_y_min > pixel_y_max)
+            return true;
+
+        // The level where the rectangle covers at most 2x2 texels
+        uint32_t level_index    = 0;
+        uint32_t size           = static_cast<uint32_t>(max(pixel_x_max - pixel_x_min, pixel_y_max - pixel_y_min));
+        while (size > 1 && level_index + 1 < m_levels.size())
+        {
+            size >>= 1;
+            level_index++;
+        }
+
+        const Level& level      = m_levels[level_index];
+        const uint32_t texel_x0 = min(static_cast<uint32_t>(pixel_x_min) >> level_index, level.width - 1);
+        const uint32_t texel_x1 = min(static_cast<uint32_t>(pixel_x_max) >> level_index, level.width - 1);
+        const uint32_t texel_y0 = min(static_cast<uint32_t>(pixel_y_min) >> level_index, level.height - 1);
+        const uint32_t texel_y1 = min(static_cast<uint32_t>(pixel_y_max) >> level_index, level.height - 1);
+        for (uint32_t y = texel_y0; y <= texel_y1; y++)
+        {
+            for (uint32_t x = texel_x0; x <= texel_x1; x++)
+            {
+                if (depth_min <= level.depth[y * level.width + x])
+                    return true;
+            }
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include "../Math/Matrix.h"
+//=============================
+
+namespace Spartan
+{
+    // A small CPU depth buffer which the nearest, biggest occluders are rasterized into, plus a max depth pyramid of it (Hi-Z).
+    // Bounding boxes are tested against the pyramid level where they cover at most 2x2 texels, a box which is behind all of them is hidden.
+    // Depth is the view space distance (clip w), so it doesn't care about reverse-z.
+    class OcclusionBuffer
+    {
+    public:
+        OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+        ~OcclusionBuffer() = default;
+
+        // Clears the buffer, everything rasterized and tested afterwards goes through this view projection
+        void Begin(const Math::Matrix& view_projection, float near_plane);
+        // Rasterizes the triangles of an occluder, indices are relative to vertex_offset
+        void Rasterize(const Math::Vector3* positions, const uint32_t* indices, uint32_t index_count, const Math::Matrix& world);
+        // Builds the pyramid, has to be called once all occluders are rasterized
+        void End();
+        // Returns false if the box is certainly hidden, thread safe (once End() was called)
+        bool IsVisible(const Math::Vector3& center, const Math::Vector3& extents) const;
+
+        uint32_t GetTrianglesRasterized() const { return m_triangles_rasterized; }
+
+    private:
+        struct Level
+        {
+            uint32_t width  = 0;
+            uint32_t height = 0;
+            std::vector<float> depth;
+        };
+
+        std::vector<Level> m_levels; // level 0 is the full resolution
+        Math::Matrix m_view_projection;
+        float m_near_plane              = 0.0f;
+        uint32_t m_triangles_rasterized = 0;
+        bool m_empty                    = true;
+    };
+}
@@ -0,0 +1,427 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===================
+#include <array>
+#include <algorithm>
+#include "RenderGraph.h"
+#include "../Logging/Log.h"
+#include "../Core/Context.h"
+#include "../Core/FrameArena.h"
+#include "../RHI/RHI_CommandList.h"
+#include "../RHI/RHI_Texture2D.h"
+//==============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    RenderGraph::RenderGraph(Context* context, unordered_map<Renderer_RenderTarget_Type, shared_ptr<RHI_Texture>>& render_targets) : m_render_targets(render_targets)
+    {
+        m_context = context;
+    }
+
+    RenderGraph::~RenderGraph()
+    {
+        BenchmarkStop();
+    }
+
+    void RenderGraph::AddPass(const char* name, const uint64_t reads, const uint64_t writes, function<void(RHI_CommandList*)>&& execute, const uint8_t flags /*= RenderGraph_Pass_None*/)
+    {
+        Pass& pass      = m_passes.emplace_back();
+        pass.name       = name;
+        pass.reads      = reads;
+        pass.writes     = writes;
+        pass.flags      = flags;
+        pass.culled     = false;
+        pass.execute    = move(execute);
+    }
+
+    void RenderGraph::Execute(RHI_CommandList* cmd_list, const uint64_t outputs)
+    {
+        if (!cmd_list)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        Cull(outputs);
+        Group();
+        AssignTransients();
+
+        if (IsBenchmarking())
+        {
+            BenchmarkRead(cmd_list);
+        }
+
+        m_pass_names.clear();
+
+        for (uint32_t pass_index = 0; pass_index < static_cast<uint32_t>(m_passes.size()); pass_index++)
+        {
+            const Pass& pass = m_passes[pass_index];
+            if (pass.culled)
+                continue;
+
+            // The first pass of a group transitions for the whole group
+            if (pass.group_first == pass_index)
+            {
+                uint64_t reads  = 0;
+                uint64_t writes = 0;
+                for (uint32_t i = pass.group_first; i <= pass.group_last; i++)
+                {
+                    if (!m_passes[i].culled)
+                    {
+                        reads   |= m_passes[i].reads;
+                        writes  |= m_passes[i].writes;
+                    }
+                }
+
+                Transition(cmd_list, reads, writes);
+            }
+
+            // A scope per pass, the pipeline passes it runs nest under it
+            cmd_list->Scope_Begin(pass.name);
+            pass.execute(cmd_list);
+            if (IsBenchmarking() && m_benchmark_pass == pass.name)
+            {
+                BenchmarkExecute(cmd_list, pass);
+            }
+            cmd_list->Scope_End();
+
+            m_pass_names.emplace_back(pass.name);
+        }
+
+        // Passes are added again next frame, the vector keeps its capacity
+        m_pass_count = static_cast<uint32_t>(m_passes.size());
+        m_passes.clear();
+    }
+
+    void RenderGraph::AddTransient(const Renderer_RenderTarget_Type type, const uint32_t width, const uint32_t height, const RHI_Format format, const uint16_t flags, const string& name)
+    {
+        Transient& transient    = m_transients.emplace_back();
+        transient.type          = type;
+        transient.width         = width;
+        transient.height        = height;
+        transient.format        = format;
+        transient.flags         = flags;
+        transient.name          = name;
+
+        // Nothing can sample it until a pass has written to it
+        m_render_targets[type] = nullptr;
+    }
+
+    void RenderGraph::ClearTransients()
+    {
+        for (const Transient& transient : m_transients)
+        {
+            m_render_targets[transient.type] = nullptr;
+        }
+
+        m_transients.clear();
+        m_textures.clear();
+    }
+
+    void RenderGraph::BenchmarkStart(const string& pass_name, const uint32_t repetitions /*= 16*/)
+    {
+        BenchmarkStop();
+
+        m_benchmark_pass        = pass_name;
+        m_benchmark_repetitions = Math::Helper::Max(repetitions, 1u);
+        m_benchmark_samples.assign(benchmark_samples_max, 0.0f);
+        m_benchmark_sample_count = 0;
+
+        LOG_INFO("Benchmarking \"%s\", %d times a frame", pass_name.c_str(), m_benchmark_repetitions);
+    }
+
+    void RenderGraph::BenchmarkStop()
+    {
+        for (BenchmarkRecording& recording : m_benchmark_recordings)
+        {
+            for (BenchmarkQuery& query : recording.queries)
+            {
+                RHI_CommandList::Gpu_QueryRelease(query.disjoint);
+                RHI_CommandList::Gpu_QueryRelease(query.start);
+                RHI_CommandList::Gpu_QueryRelease(query.end);
+            }
+        }
+
+        m_benchmark_recordings.clear();
+        m_benchmark_pass.clear();
+    }
+
+    RenderGraph::BenchmarkResult RenderGraph::GetBenchmarkResult() const
+    {
+        BenchmarkResult result;
+        result.pass     = m_benchmark_pass;
+        result.samples  = static_cast<uint32_t>(Math::Helper::Min(m_benchmark_sample_count, static_cast<uint64_t>(m_benchmark_samples.size())));
+        if (result.samples == 0)
+            return result;
+
+        vector<float> samples(m_benchmark_samples.begin(), m_benchmark_samples.begin() + result.samples);
+        sort(samples.begin(), samples.end());
+        result.min      = samples.front();
+        result.median   = samples[samples.size() / 2];
+        result.max      = samples.back();
+
+        return result;
+    }
+
+    void RenderGraph::BenchmarkRead(RHI_CommandList* cmd_list)
+    {
+        for (BenchmarkRecording& recording : m_benchmark_recordings)
+        {
+            if (recording.cmd_list != cmd_list)
+                continue;
+
+            for (uint32_t i = 0; i < recording.query_count; i++)
+            {
+                const BenchmarkQuery& query = recording.queries[i];
+                const float duration        = cmd_list->Timestamp_GetDuration(query.disjoint, query.start, query.end, query.index_start, query.index_end);
+
+                // Zero if the timestamps didn't fit in the command list's pool
+                if (duration > 0.0f)
+                {
+                    m_benchmark_samples[m_benchmark_sample_count++ % m_benchmark_samples.size()] = duration;
+                }
+            }
+
+            recording.query_count = 0;
+        }
+    }
+
+    void RenderGraph::BenchmarkExecute(RHI_CommandList* cmd_list, const Pass& pass)
+    {
+        // Command lists are recorded in turn (one per frame in flight), each keeps its own queries
+        BenchmarkRecording* recording = nullptr;
+        for (BenchmarkRecording& it : m_benchmark_recordings)
+        {
+            if (it.cmd_list == cmd_list)
+            {
+                recording = &it;
+            }
+        }
+        if (!recording)
+        {
+            recording           = &m_benchmark_recordings.emplace_back();
+            recording->cmd_list = cmd_list;
+        }
+
+        RHI_Device* rhi_device = m_context->GetSubsystem<Renderer>()->GetRhiDevice().get();
+        while (recording->queries.size() < m_benchmark_repetitions)
+        {
+            BenchmarkQuery& query = recording->queries.emplace_back();
+            RHI_CommandList::Gpu_QueryCreate(rhi_device, &query.disjoint, RHI_Query_Timestamp_Disjoint);
+            RHI_CommandList::Gpu_QueryCreate(rhi_device, &query.start, RHI_Query_Timestamp);
+            RHI_CommandList::Gpu_QueryCreate(rhi_device, &query.end, RHI_Query_Timestamp);
+        }
+
+        for (uint32_t i = 0; i < m_benchmark_repetitions; i++)
+        {
+            // The pass left its render targets in whatever layout it finished with
+            Transition(cmd_list, pass.reads, pass.writes);
+
+            BenchmarkQuery& query = recording->queries[i];
+            cmd_list->Timestamp_Start(query.disjoint, query.start, &query.index_start);
+            pass.execute(cmd_list);
+            cmd_list->Timestamp_End(query.disjoint, query.end, &query.index_end);
+        }
+
+        recording->query_count = m_benchmark_repetitions;
+    }
+
+    void RenderGraph::Cull(const uint64_t outputs)
+    {
+        // Walk the passes backwards, a pass is needed if it writes something which is needed.
+        // Writes don't clear the needed bits as most passes only write some of the pixels (stencil masking, blending).
+        uint64_t needed     = outputs;
+        m_pass_count_culled = 0;
+        for (auto it = m_passes.rbegin(); it != m_passes.rend(); it++)
+        {
+            Pass& pass  = *it;
+            pass.culled = !(pass.flags & RenderGraph_Pass_NeverCull) && (pass.writes & needed) == 0;
+
+            if (pass.culled)
+            {
+                m_pass_count_culled++;
+                continue;
+            }
+
+            needed |= pass.reads;
+        }
+    }
+
+    void RenderGraph::Group()
+    {
+        for (uint32_t pass_index = 0; pass_index < static_cast<uint32_t>(m_passes.size());)
+        {
+            Pass& first     = m_passes[pass_index];
+            uint64_t reads  = first.reads;
+            uint64_t writes = first.writes;
+
+            // Extend the group with the async passes which follow, as long as they neither read nor write what the group writes, nor write
+            // what it reads (culled passes in between don't execute, so they don't break a group)
+            uint32_t last = pass_index;
+            if (!first.culled && (first.flags & RenderGraph_Pass_Async))
+            {
+                for (uint32_t i = pass_index + 1; i < static_cast<uint32_t>(m_passes.size()); i++)
+                {
+                    const Pass& pass = m_passes[i];
+                    if (pass.culled)
+                        continue;
+
+                    const bool independent = ((pass.reads | pass.writes) & writes) == 0 && (pass.writes & reads) == 0;
+                    if (!(pass.flags & RenderGraph_Pass_Async) || !independent)
+                        break;
+
+                    reads   |= pass.reads;
+                    writes  |= pass.writes;
+                    last    = i;
+                }
+            }
+
+            for (uint32_t i = pass_index; i <= last; i++)
+            {
+                m_passes[i].group_first = pass_index;
+                m_passes[i].group_last  = last;
+            }
+
+            pass_index = last + 1;
+        }
+    }
+
+    void RenderGraph::AssignTransients()
+    {
+        if (m_transients.empty())
+            return;
+
+        // Lifetimes
+        for (Transient& transient : m_transients)
+        {
+            transient.used = false;
+
+            for (uint32_t pass_index = 0; pass_index < static_cast<uint32_t>(m_passes.size()); pass_index++)
+            {
+                const Pass& pass = m_passes[pass_index];
+                if (pass.culled || ((pass.reads | pass.writes) & transient.type) == 0)
+                    continue;
+
+                // The passes of a group can overlap on the GPU, so a transient lives for the whole group
+                if (!transient.used)
+                {
+                    transient.pass_first    = pass.group_first;
+                    transient.used          = true;
+                }
+
+                transient.pass_last = pass.group_last;
+            }
+        }
+
+        // Hand out textures in order of first use, a texture whose previous user is dead by then is reused
+        for (Texture& texture : m_textures)
+        {
+            texture.taken = false;
+        }
+
+        FrameVector<Transient*> order;
+        order.reserve(m_transients.size());
+        for (Transient& transient : m_transients)
+        {
+            if (transient.used)
+            {
+                order.emplace_back(&transient);
+            }
+            else
+            {
+                m_render_targets[transient.type] = nullptr;
+            }
+        }
+        sort(order.begin(), order.end(), [](const Transient* a, const Transient* b) { return a->pass_first < b->pass_first; });
+
+        for (Transient* transient : order)
+        {
+            Texture* match = nullptr;
+            for (Texture& texture : m_textures)
+            {
+                const bool compatible = texture.width == transient->width && texture.height == transient->height && texture.format == transient->format && texture.flags == transient->flags;
+                if (compatible && (!texture.taken || texture.pass_free < transient->pass_first))
+                {
+                    match = &texture;
+                    break;
+                }
+            }
+
+            // Nothing to share, this is the first frame in which this many of these are alive at the same time
+            if (!match)
+            {
+                match           = &m_textures.emplace_back();
+                match->texture  = make_shared<RHI_Texture2D>(m_context, transient->width, transient->height, transient->format, 1, transient->flags, transient->name);
+                match->width    = transient->width;
+                match->height   = transient->height;
+                match->format   = transient->format;
+                match->flags    = transient->flags;
+            }
+
+            match->taken        = true;
+            match->pass_free    = transient->pass_last;
+            m_render_targets[transient->type] = match->texture;
+        }
+    }
+
+    void RenderGraph::Transition(RHI_CommandList* cmd_list, const uint64_t reads, const uint64_t writes)
+    {
+        array<RHI_Texture*, 64> textures;
+        array<RHI_Image_Layout, 64> layouts;
+        uint32_t count = 0;
+
+        // Render targets which a pass both reads and writes (ping-ponging, read-only depth-stencil) are left to the pass
+        const uint64_t reads_only   = reads & ~writes;
+        const uint64_t writes_only  = writes & ~reads;
+
+        for (uint32_t bit = 0; bit < 64; bit++)
+        {
+            const uint64_t type = 1ull << bit;
+            if (((reads_only | writes_only) & type) == 0)
+                continue;
+
+            auto it = m_render_targets.find(static_cast<Renderer_RenderTarget_Type>(type));
+            if (it == m_render_targets.end() || !it->second)
+                continue;
+
+            RHI_Texture* texture    = it->second.get();
+            const bool read         = (reads_only & type) != 0;
+
+            textures[count] = texture;
+            if (texture->IsDepthFormat())
+            {
+                layouts[count] = read ? RHI_Image_Depth_Stencil_Read_Only_Optimal : RHI_Image_Depth_Stencil_Attachment_Optimal;
+            }
+            else
+            {
+                layouts[count] = read ? RHI_Image_Shader_Read_Only_Optimal : RHI_Image_Color_Attachment_Optimal;
+            }
+            count++;
+        }
+
+        cmd_list->SetLayouts(textures.data(), layouts.data(), count);
+    }
+}
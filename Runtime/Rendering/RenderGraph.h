@@ -0,0 +1,162 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "Renderer.h"
+//=============================
+
+namespace Spartan
+{
+    enum RenderGraph_Pass_Flags : uint8_t
+    {
+        RenderGraph_Pass_None       = 0,
+        RenderGraph_Pass_NeverCull  = 1 << 0, // the pass has effects which the graph can't see (e.g. it renders shadow maps)
+        RenderGraph_Pass_Async      = 1 << 1  // independent screen-space work (ambient occlusion, reflections), see Execute()
+    };
+
+    // Passes are added every frame, in execution order, along with the render targets they read (sample) and write (bind as attachments).
+    // On execution, passes which don't contribute to the outputs are culled, the render targets of each pass are transitioned with a single barrier
+    // and transient render targets are handed a texture only for the frames they are used in, shared by transient targets which are never alive at the same time.
+    class SPARTAN_CLASS RenderGraph
+    {
+    public:
+        RenderGraph(Context* context, std::unordered_map<Renderer_RenderTarget_Type, std::shared_ptr<RHI_Texture>>& render_targets);
+        ~RenderGraph();
+
+        // Adds a pass, reads and writes are masks of Renderer_RenderTarget_Type
+        void AddPass(const char* name, uint64_t reads, uint64_t writes, std::function<void(RHI_CommandList*)>&& execute, uint8_t flags = RenderGraph_Pass_None);
+
+        // Culls and executes the passes which were added since the last execution, outputs are the render targets which have to be valid after the frame.
+        // Consecutive async passes which don't touch each other's writes form a group, the render targets of a group are transitioned with
+        // a single barrier up front, so nothing serializes the passes of a group against each other and the GPU is free to overlap them.
+        void Execute(RHI_CommandList* cmd_list, uint64_t outputs);
+
+        // Declares a render target which the graph creates on demand (instead of the renderer creating it upfront)
+        void AddTransient(Renderer_RenderTarget_Type type, uint32_t width, uint32_t height, RHI_Format format, uint16_t flags, const std::string& name);
+        // Releases all transient render targets and their textures (e.g. on a resolution change)
+        void ClearTransients();
+
+        // Stats of the last execution
+        uint32_t GetPassCount()             const { return m_pass_count; }
+        uint32_t GetPassCountCulled()       const { return m_pass_count_culled; }
+        uint32_t GetTransientTextureCount() const { return static_cast<uint32_t>(m_textures.size()); }
+        const auto& GetPassNames()          const { return m_pass_names; } // of the passes which executed
+
+        // Benchmark, the named pass executes again (repetitions times every frame) right after itself. Its inputs are the ones it just
+        // had, so the repetitions only measure the pass, and each of them is timed on the GPU. The results are over the latest samples.
+        struct BenchmarkResult
+        {
+            std::string pass;
+            uint32_t samples    = 0;
+            float min           = 0.0f; // ms
+            float median        = 0.0f;
+            float max           = 0.0f;
+        };
+        void BenchmarkStart(const std::string& pass_name, uint32_t repetitions = 16);
+        void BenchmarkStop();
+        bool IsBenchmarking()               const { return !m_benchmark_pass.empty(); }
+        BenchmarkResult GetBenchmarkResult() const;
+
+    private:
+        struct Pass
+        {
+            const char* name    = nullptr;
+            uint64_t reads      = 0;
+            uint64_t writes     = 0;
+            uint8_t flags       = 0;
+            bool culled         = false;
+            uint32_t group_first = 0; // the passes of the group this pass executes in (a group of one, unless it's async)
+            uint32_t group_last  = 0;
+            std::function<void(RHI_CommandList*)> execute;
+        };
+
+        struct Transient
+        {
+            Renderer_RenderTarget_Type type;
+            uint32_t width      = 0;
+            uint32_t height     = 0;
+            RHI_Format format   = RHI_Format_Undefined;
+            uint16_t flags      = 0;
+            std::string name;
+
+            // Lifetime within the current frame, in pass indices
+            uint32_t pass_first = 0;
+            uint32_t pass_last  = 0;
+            bool used           = false;
+        };
+
+        struct Texture
+        {
+            std::shared_ptr<RHI_Texture> texture;
+            uint32_t width      = 0;
+            uint32_t height     = 0;
+            RHI_Format format   = RHI_Format_Undefined;
+            uint16_t flags      = 0;
+            uint32_t pass_free  = 0; // the texture can be taken by a transient which is first used after this pass
+            bool taken          = false;
+        };
+
+        void Cull(uint64_t outputs);
+        void Group();
+        void AssignTransients();
+        void Transition(RHI_CommandList* cmd_list, uint64_t reads, uint64_t writes);
+        void BenchmarkRead(RHI_CommandList* cmd_list);
+        void BenchmarkExecute(RHI_CommandList* cmd_list, const Pass& pass);
+
+        std::vector<Pass> m_passes;
+        uint32_t m_pass_count           = 0;
+        uint32_t m_pass_count_culled    = 0;
+        std::vector<Transient> m_transients;
+        std::vector<Texture> m_textures;
+        std::unordered_map<Renderer_RenderTarget_Type, std::shared_ptr<RHI_Texture>>& m_render_targets;
+        std::vector<const char*> m_pass_names;
+        Context* m_context = nullptr;
+
+        // Benchmark, the timestamps of a command list are read once it's recording again (the GPU is done with its last submission by then)
+        struct BenchmarkQuery
+        {
+            void* disjoint          = nullptr;
+            void* start             = nullptr;
+            void* end               = nullptr;
+            uint32_t index_start    = 0;
+            uint32_t index_end      = 0;
+        };
+        struct BenchmarkRecording
+        {
+            RHI_CommandList* cmd_list = nullptr;
+            std::vector<BenchmarkQuery> queries;
+            uint32_t query_count = 0; // the queries which were written, with the last recording of the command list
+        };
+        static constexpr uint32_t benchmark_samples_max = 256;
+        std::string m_benchmark_pass;
+        uint32_t m_benchmark_repetitions = 0;
+        std::vector<BenchmarkRecording> m_benchmark_recordings;
+        std::vector<float> m_benchmark_samples; // ring
+        uint64_t m_benchmark_sample_count = 0;
+    };
+}
@@ -22,20 +22,29 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==============================
 #include "Renderer.h"
 #include "Model.h"
+#include "Mesh.h"
 #include "ShaderGBuffer.h"
+#include "RenderGraph.h"
+#include "OcclusionBuffer.h"
 #include "Font/Font.h"
 #include "Gizmos/Grid.h"
 #include "Gizmos/Transform_Gizmo.h"
 #include "../Utilities/Sampling.h"
+#include "../Utilities/Sort.h"
+#include "../Utilities/Hash.h"
 #include "../Profiling/Profiler.h"
 #include "../Resource/ResourceCache.h"
 #include "../Core/Engine.h"
 #include "../Core/Timer.h"
+#include "../Threading/Threading.h"
 #include "../World/Entity.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
 #include "../World/Components/Camera.h"
 #include "../World/Components/Light.h"
+#include "../World/Components/ParticleEmitter.h"
+#include "../World/Components/Decal.h"
+#include "../World/Components/ReflectionProbe.h"
 #include "../RHI/RHI_Device.h"
 #include "../RHI/RHI_PipelineCache.h"
 #include "../RHI/RHI_ConstantBuffer.h"
@@ -43,8 +52,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_SwapChain.h"
 #include "../RHI/RHI_VertexBuffer.h"
+#include "../RHI/RHI_IndexBuffer.h"
 #include "../RHI/RHI_Implementation.h"
 #include "../RHI/RHI_DescriptorCache.h"
+#include "../RHI/RHI_Shader.h"
 //=========================================
 
 //= NAMESPACES ===============
@@ -52,6 +63,22 @@ using namespace std;
 using namespace Spartan::Math;
 //============================
 
+namespace _Renderer
+{
+    // Dynamic resolution
+    static const float dynamic_resolution_scale_min     = 0.5f;
+    static const float dynamic_resolution_scale_step    = 0.05f;  // scales are snapped to it, so that noise in the GPU time doesn't keep re-creating render targets
+    static const float dynamic_resolution_headroom      = 0.85f;  // the GPU time has to stay below this fraction of the target before the resolution goes up
+    static const uint32_t dynamic_resolution_frames_down = 4;     // frames over the target before the resolution goes down
+    static const uint32_t dynamic_resolution_frames_up   = 60;    // frames under the headroom before the resolution goes up
+    static const uint32_t dynamic_resolution_cooldown    = 10;    // frames to ignore after a change, the GPU time of those is still from before
+    static const uint32_t preview_frames_settle         = 8;     // frames the camera has to rest before the preview resolution is left, so that a stop-and-go doesn't keep re-creating render targets
+
+    // Texture streaming
+    static const uint64_t texture_streaming_frames_unseen  = 300;              // frames without a request before a texture drops back to its initial mips
+    static const uint64_t texture_streaming_upload_max     = 64 * 1024 * 1024; // bytes streamed in per frame (at least one texture streams)
+}
+
 namespace Spartan
 {
     Renderer::Renderer(Context* context) : ISubsystem(context)
@@ -70,6 +97,8 @@ namespace Spartan
         m_options |= Render_ScreenSpaceReflections;
         m_options |= Render_AntiAliasing_Taa;
         m_options |= Render_Sharpening_LumaSharpen;
+        m_options |= Render_OcclusionCulling;
+        m_options |= Render_CameraLateLatch;
 
         // Option values
         m_option_values[Option_Value_Anisotropy]              = 16.0f;
@@ -81,16 +110,31 @@ namespace Spartan
         m_option_values[Option_Value_Sharpen_Clamp]           = 0.35f;
         m_option_values[Option_Value_Bloom_Intensity]         = 0.1f;
         m_option_values[Option_Value_Motion_Blur_Intensity]   = 0.02f;
+        m_option_values[Option_Value_ShadowSliceBudget]       = 8.0f;
+        m_option_values[Option_Value_LodBias]                 = 1.0f;
+        m_option_values[Option_Value_LodBias_Shadows]         = 2.0f;
+        m_option_values[Option_Value_ScreenSpaceScale]        = 1.0f;
+        m_option_values[Option_Value_ResolutionScale]         = 1.0f;
+        m_option_values[Option_Value_DynamicResolution_TargetMs] = 16.6f;
+        m_option_values[Option_Value_TextureStreamingBudget]  = 1024.0f;
+        m_option_values[Option_Value_PreviewScale]            = 1.0f;
+
+        // Material table, empty until materials are drawn (the buffer starts out dirty so that the first frame uploads)
+        m_material_table_ids.fill(0);
+        m_material_table_frames.fill(0);
+        memset(&m_buffer_material_cpu, 0, sizeof(BufferMaterial));
 
 		// Subscribe to events
 		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Complete,    EVENT_HANDLER_VARIANT(RenderablesAcquire));
         SUBSCRIBE_TO_EVENT(Event_World_Unload,              EVENT_HANDLER(ClearEntities));
+        SUBSCRIBE_TO_EVENT(Event_Window_Data,               EVENT_HANDLER(WakeUp)); // input, resizing
 	}
 
 	Renderer::~Renderer()
 	{
 		// Unsubscribe from events
 		UNSUBSCRIBE_FROM_EVENT(Event_World_Resolve_Complete, EVENT_HANDLER_VARIANT(RenderablesAcquire));
+        UNSUBSCRIBE_FROM_EVENT(Event_Window_Data, EVENT_HANDLER(WakeUp));
 
 		m_entities.clear();
 		m_camera = nullptr;
@@ -104,6 +148,13 @@ namespace Spartan
         // Get required systems		
         m_resource_cache    = m_context->GetSubsystem<ResourceCache>();
         m_profiler          = m_context->GetSubsystem<Profiler>();
+        m_threading         = m_context->GetSubsystem<Threading>();
+
+        // Counters
+        m_counter_instances_visible = Profiler::CounterRegister("Instances visible", "instances");
+        m_counter_meshlets_culled   = Profiler::CounterRegister("Meshlets culled", "meshlets");
+        m_counter_stream_queue      = Profiler::CounterRegister("Texture streaming queue", "textures", Counter_Cumulative);
+        m_counter_lights_culled     = Profiler::CounterRegister("Lights culled", "lights");
 
         // Resolution, viewport and swapchain default to whatever the window size is
         const WindowData& window_data = m_context->m_engine->GetWindowData();
@@ -124,8 +175,8 @@ namespace Spartan
             return false;
         }
 
-        // Create pipeline cache
-        m_pipeline_cache = make_shared<RHI_PipelineCache>(m_rhi_device.get());
+        // Create pipeline cache (it persists on disk, so pipelines of previous runs are quick to create)
+        m_pipeline_cache = make_shared<RHI_PipelineCache>(m_rhi_device.get(), m_resource_cache->GetDataDirectory() + "/pipeline_cache.bin");
 
         // Create descriptor cache
         m_descriptor_cache = make_shared<RHI_DescriptorCache>(m_rhi_device.get());
@@ -156,11 +207,63 @@ namespace Spartan
 
 		// Line buffer
 		m_vertex_buffer_lines = make_shared<RHI_VertexBuffer>(m_rhi_device);
+        m_vertex_buffer_lines->CreateDynamic<RHI_Vertex_PosCol>(16384);
+        m_buffer_lines_offset = 0;
+
+        // Unit box buffer
+        {
+            const Vector3 corners[8] =
+            {
+                Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, -0.5f), Vector3(-0.5f, 0.5f, -0.5f),
+                Vector3(-0.5f, -0.5f,  0.5f), Vector3(0.5f, -0.5f,  0.5f), Vector3(0.5f, 0.5f,  0.5f), Vector3(-0.5f, 0.5f,  0.5f)
+            };
+            const uint32_t edges[24] = { 0, 1, 1, 2, 2, 3, 3, 0, 4, 5, 5, 6, 6, 7, 7, 4, 0, 4, 1, 5, 2, 6, 3, 7 };
+
+            vector<RHI_Vertex_PosCol> vertices;
+            for (const Vector3& corner : corners)
+            {
+                vertices.emplace_back(corner, Vector4::One);
+            }
+
+            m_vertex_buffer_box = make_shared<RHI_VertexBuffer>(m_rhi_device);
+            m_vertex_buffer_box->Create(vertices);
+            m_index_buffer_box = make_shared<RHI_IndexBuffer>(m_rhi_device);
+            m_index_buffer_box->Create(vector<uint32_t>(begin(edges), end(edges)));
+        }
+
+        // Unit quad buffer
+        {
+            const RHI_Vertex_PosTex corners[4] =
+            {
+                RHI_Vertex_PosTex(Vector3(-1.0f,  1.0f, 0.0f), Vector2(0.0f, 0.0f)),
+                RHI_Vertex_PosTex(Vector3( 1.0f,  1.0f, 0.0f), Vector2(1.0f, 0.0f)),
+                RHI_Vertex_PosTex(Vector3( 1.0f, -1.0f, 0.0f), Vector2(1.0f, 1.0f)),
+                RHI_Vertex_PosTex(Vector3(-1.0f, -1.0f, 0.0f), Vector2(0.0f, 1.0f))
+            };
+            const uint32_t triangles[6] = { 0, 1, 2, 0, 2, 3 };
+
+            m_vertex_buffer_quad = make_shared<RHI_VertexBuffer>(m_rhi_device);
+            m_vertex_buffer_quad->Create(vector<RHI_Vertex_PosTex>(begin(corners), end(corners)));
+            m_index_buffer_quad = make_shared<RHI_IndexBuffer>(m_rhi_device);
+            m_index_buffer_quad->Create(vector<uint32_t>(begin(triangles), end(triangles)));
+        }
 
-        // Editor specific
-        m_gizmo_grid = make_unique<Grid>(m_rhi_device);
+        // Icon buffer
+        m_vertex_buffer_icons = make_shared<RHI_VertexBuffer>(m_rhi_device);
+        m_vertex_buffer_icons->CreateDynamic<RHI_Vertex_PosTex>(1536);
+        m_buffer_icons_offset = 0;
+
+        // Instance buffer
+        m_buffer_instance_gpu = make_shared<RHI_VertexBuffer>(m_rhi_device);
+        m_buffer_instance_gpu->CreateDynamic<RHI_Vertex_Instance>(4096);
+
+        // Editor specific (the grid and the gizmo icons are created once they are drawn)
         m_gizmo_transform = make_unique<Transform_Gizmo>(m_context);
 
+        // Render graph, it has to exist before the render targets as it creates the transient ones
+        m_render_graph = make_unique<RenderGraph>(m_context, m_render_targets);
+        m_occlusion_buffer = make_unique<OcclusionBuffer>();
+
         CreateConstantBuffers();
 		CreateShaders();
 		CreateDepthStencilStates();
@@ -191,6 +294,19 @@ namespace Spartan
 		if (!m_rhi_device || !m_rhi_device->IsInitialized())
 			return;
 
+        // Start-up shader progress
+        ShadersCompilingTick();
+
+        // Swap in shaders which finished recompiling, before this frame binds any of them
+        RHI_Shader::ApplyRecompilations();
+
+        // Unless the engine took it already (while the simulation wasn't running), take the snapshot now
+        if (!m_snapshot_taken)
+        {
+            Snapshot();
+        }
+        m_snapshot_taken = false;
+
         // Don't do any work if the swapchain is not presenting
         if (m_swap_chain && !m_swap_chain->IsPresenting())
             return;
@@ -209,13 +325,134 @@ namespace Spartan
 			return;
 		}
 
-        // Reset dynamic buffer indices when the swapchain resets to first buffer/command list
-        if (m_swap_chain->GetCmdIndex() == 0)
+        // Nothing changed, the render targets still hold the last frame
+        if (m_is_idle)
+            return;
+
+        // Budget tracking and defragmentation, before anything is recorded (a defragmentation step re-creates buffers)
+        m_rhi_device->Memory_Tick(m_frame_num);
+
+        // Release the GPU objects which were destroyed while the frames that are now retired were in flight
+        m_rhi_device->DeletionQueue_Tick(m_frame_num);
+
+        // Dynamic buffers sub-allocate from the region of the current frame in flight
+        {
+            const uint32_t frame_index = m_swap_chain->GetCmdIndex();
+
+            if (!m_buffer_uber_gpu->BeginFrame(frame_index) || !m_buffer_object_gpu->BeginFrame(frame_index) || !m_buffer_skin_gpu->BeginFrame(frame_index))
+            {
+                LOG_ERROR("Failed to grow the dynamic constant buffers");
+                return;
+            }
+            m_buffer_skin_offsets.clear();
+
+            if (frame_index == 0)
+            {
+                m_buffer_instance_offset    = 0;
+                m_buffer_lines_offset       = 0;
+                m_buffer_icons_offset       = 0;
+            }
+        }
+
+        // Before anything is recorded, a resolution change re-creates the render targets
+        UpdatePreviewResolution();
+        UpdateDynamicResolution();
+
+        // Streamed textures re-create their gpu resource, so this also happens before anything is recorded
+        TextureStreaming();
+
+        m_is_rendering = true;
+        Pass_Main(m_swap_chain->GetCmdList());
+        m_is_rendering = false;
+
+        m_frame_num++;
+        m_is_odd_frame = (m_frame_num % 2) == 1;
+	}
+
+    void Renderer::Snapshot()
+    {
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        m_snapshot_taken = true;
+
+        // Pick up whatever changed in the registry since the last snapshot.
+        // Entities which left the world before the previous snapshot are released here (outside of the lock, as their
+        // components unregister when they are destroyed), so they outlive any frame which was recording them.
+        vector<shared_ptr<Entity>> entities_released;
+        bool registry_changed = false;
+        {
+            lock_guard<mutex> lock(m_entities_mutex);
+
+            entities_released   = move(m_entities_released);
+            m_entities_released = move(m_registry_released);
+            m_registry_released.clear();
+
+            if (m_registry_dirty)
+            {
+                RegistryPublish();
+                m_registry_dirty = false;
+                registry_changed = true;
+            }
+        }
+        entities_released.clear();
+
+        m_cull_instances[Renderer_Object_Opaque].clear();
+        m_cull_instances[Renderer_Object_Transparent].clear();
+
+        if (!m_camera)
+            return;
+
+        // With the fixed step, the transforms are captured in between the last two steps, so that motion is smooth at any frame rate
+        Timer* timer                = m_context->GetSubsystem<Timer>();
+        const uint64_t step_index   = timer->IsFixedStepEnabled() ? timer->GetFixedStepIndex() : 0;
+        const float step_alpha      = timer->GetFixedStepAlpha();
+
+        // Let the components capture what the passes read (lights compute their shadow matrices here).
+        // The revisions only ever increase, so their sum changes whenever any of the transforms does.
+        uint64_t transform_revisions = 0;
+        for (const auto& it : m_entities)
+        {
+            for (Entity* entity : it.second)
+            {
+                if (Transform* transform = entity->GetTransform())
+                {
+                    transform_revisions += transform->GetMatrixRevision();
+
+                    if (step_index != 0)
+                    {
+                        transform->OnSnapshot(step_index, step_alpha);
+                    }
+                    else
+                    {
+                        transform->OnSnapshot();
+                    }
+                }
+
+                if (Renderable* renderable = entity->GetRenderable())
+                {
+                    renderable->OnSnapshot();
+                }
+            }
+        }
+
+        for (Entity* entity : m_entities[Renderer_Object_Light])
         {
-            m_buffer_uber_offset_index      = 0;
-            m_buffer_object_offset_index    = 0;
+            if (Light* light = entity->GetComponent<Light>())
+            {
+                light->OnSnapshot();
+            }
+        }
+
+        for (Entity* entity : m_entities[Renderer_Object_ParticleEmitter])
+        {
+            if (ParticleEmitter* emitter = entity->GetComponent<ParticleEmitter>())
+            {
+                emitter->OnSnapshot();
+            }
         }
 
+        CullInstancesAcquire();
+
 		// Get camera matrices
 		{
             if (m_update_ortho_proj || m_near_plane != m_camera->GetNearPlane() || m_far_plane != m_camera->GetFarPlane())
@@ -239,8 +476,8 @@ namespace Spartan
 				const uint64_t samples	        = 16;
 				const uint64_t index	        = m_frame_num % samples;
 				m_taa_jitter			        = (Utility::Sampling::Halton2D(index, 2, 3) * 2.0f - 1.0f);
-				m_taa_jitter.x			        = (m_taa_jitter.x / m_resolution.x) * scale;
-				m_taa_jitter.y			        = (m_taa_jitter.y / m_resolution.y) * scale;
+				m_taa_jitter.x			        = (m_taa_jitter.x / m_resolution_render.x) * scale;
+				m_taa_jitter.y			        = (m_taa_jitter.y / m_resolution_render.y) * scale;
                 m_buffer_frame_cpu.projection   *= Matrix::CreateTranslation(Vector3(m_taa_jitter.x, m_taa_jitter.y, 0.0f));
 			}
 			else
@@ -255,27 +492,53 @@ namespace Spartan
             m_buffer_frame_cpu.view_projection_unjittered   = m_buffer_frame_cpu.view * m_camera->GetProjectionMatrix();
 		}
 
-        m_is_rendering = true;
-        Pass_Main(m_swap_chain->GetCmdList());
-        m_is_rendering = false;
+        // Idle, when nothing which could change the frame did
+        {
+            m_camera_moved = m_buffer_frame_cpu.view_projection_unjittered != m_idle_view_projection;
+
+            const bool changed =
+                m_idle_wake.exchange(false)                                                         ||
+                registry_changed                                                                    ||
+                transform_revisions != m_idle_transform_revisions                                   ||
+                m_camera_moved                                                                      ||
+                !AreShadersCompiled()                                                               ||
+                !GetOption(Render_Idle)                                                             ||
+                m_context->m_engine->EngineMode_IsSet(Engine_Game);
+
+            m_idle_transform_revisions  = transform_revisions;
+            m_idle_view_projection      = m_buffer_frame_cpu.view_projection_unjittered;
+            m_idle_frames_left          = changed ? m_idle_frames_settle : (m_idle_frames_left > 0 ? m_idle_frames_left - 1 : 0);
+            m_is_idle                   = m_idle_frames_left == 0 || (!m_viewport_visible && GetOption(Render_Idle) && !m_context->m_engine->EngineMode_IsSet(Engine_Game));
+        }
 
-        m_frame_num++;
-        m_is_odd_frame = (m_frame_num % 2) == 1;
-	}
+        ViewSelect();
+
+        // Camera
+        m_camera_frustum                    = m_camera->GetFrustum();
+        m_buffer_frame_cpu.camera_near      = m_camera->GetNearPlane();
+        m_buffer_frame_cpu.camera_far       = m_camera->GetFarPlane();
+        m_buffer_frame_cpu.camera_position  = m_camera->GetTransform()->GetPosition();
+        m_buffer_frame_cpu.camera_direction = m_camera->GetTransform()->GetForward();
+        m_camera_late_latch                 = m_camera->GetLateLatchState();
+        m_camera_late_latch_motion          = m_context->GetSubsystem<Input>()->GetMouseMotionAtTick();
+
+        // Time
+        m_buffer_frame_cpu.delta_time       = static_cast<float>(m_context->GetSubsystem<Timer>()->GetDeltaTimeSmoothedSec());
+        m_buffer_frame_cpu.time             = static_cast<float>(m_context->GetSubsystem<Timer>()->GetTimeSec());
+    }
 
     void Renderer::SetViewport(float width, float height, float offset_x /*= 0*/, float offset_y /*= 0*/)
     {
         if (m_viewport.width != width || m_viewport.height != height)
         {
-            Flush(); // viewport quad might be in use
-
             m_brdf_specular_lut_rendered = false; // todo, Vulkan needs to re-renderer it, it shouldn't, what am I missing ?
+            m_environment_prefiltered    = false; // same as above
 
             // Update viewport
             m_viewport.width    = width;
             m_viewport.height   = height;
 
-            // Update full-screen quad
+            // Update full-screen quad (frames in flight which still use the previous one keep it alive through the deletion queue)
             m_viewport_quad = Math::Rectangle(0, 0, width, height);
             m_viewport_quad.CreateBuffers(this);
 
@@ -322,6 +585,9 @@ namespace Spartan
 
 	void Renderer::DrawLine(const Vector3& from, const Vector3& to, const Vector4& color_from, const Vector4& color_to, const bool depth /*= true*/)
 	{
+        // The simulation (e.g. physics debug draw) and the renderer can both add lines
+        lock_guard<mutex> lock(m_lines_mutex);
+
 		if (depth)
 		{
 			m_lines_list_depth_enabled.emplace_back(from, color_from);
@@ -334,6 +600,17 @@ namespace Spartan
 		}
 	}
 
+    void Renderer::DrawLines(const RHI_Vertex_PosCol* vertices, const uint32_t vertex_count, const bool depth /*= true*/)
+    {
+        if (!vertices || vertex_count == 0)
+            return;
+
+        lock_guard<mutex> lock(m_lines_mutex);
+
+        vector<RHI_Vertex_PosCol>& lines = depth ? m_lines_list_depth_enabled : m_lines_list_depth_disabled;
+        lines.insert(lines.end(), vertices, vertices + vertex_count);
+    }
+
 	void Renderer::DrawRectangle(const Math::Rectangle& rectangle, const Math::Vector4& color /*= DebugColor*/, bool depth /*= true*/)
 	{
         const float cam_z = m_camera->GetTransform()->GetPosition().z + m_camera->GetNearPlane() + 5.0f;
@@ -346,23 +623,37 @@ namespace Spartan
 
 	void Renderer::DrawBox(const BoundingBox& box, const Vector4& color, const bool depth /*= true*/)
 	{
-		const auto& min = box.GetMin();
-		const auto& max = box.GetMax();
-	
-		DrawLine(Vector3(min.x, min.y, min.z), Vector3(max.x, min.y, min.z), color, color, depth);
-        DrawLine(Vector3(max.x, min.y, min.z), Vector3(max.x, max.y, min.z), color, color, depth);
-        DrawLine(Vector3(max.x, max.y, min.z), Vector3(min.x, max.y, min.z), color, color, depth);
-        DrawLine(Vector3(min.x, max.y, min.z), Vector3(min.x, min.y, min.z), color, color, depth);
-        DrawLine(Vector3(min.x, min.y, min.z), Vector3(min.x, min.y, max.z), color, color, depth);
-        DrawLine(Vector3(max.x, min.y, min.z), Vector3(max.x, min.y, max.z), color, color, depth);
-        DrawLine(Vector3(max.x, max.y, min.z), Vector3(max.x, max.y, max.z), color, color, depth);
-        DrawLine(Vector3(min.x, max.y, min.z), Vector3(min.x, max.y, max.z), color, color, depth);
-        DrawLine(Vector3(min.x, min.y, max.z), Vector3(max.x, min.y, max.z), color, color, depth);
-        DrawLine(Vector3(max.x, min.y, max.z), Vector3(max.x, max.y, max.z), color, color, depth);
-        DrawLine(Vector3(max.x, max.y, max.z), Vector3(min.x, max.y, max.z), color, color, depth);
-        DrawLine(Vector3(min.x, max.y, max.z), Vector3(min.x, min.y, max.z), color, color, depth);
+        // The instance color goes where the velocity matrix would be, debug primitives don't need it
+        RHI_Vertex_Instance instance(Matrix(box.GetCenter(), Quaternion::Identity, box.GetSize()), Matrix::Identity);
+        instance.wvp_previous[0] = color.x;
+        instance.wvp_previous[1] = color.y;
+        instance.wvp_previous[2] = color.z;
+        instance.wvp_previous[3] = color.w;
+
+        lock_guard<mutex> lock(m_lines_mutex);
+        (depth ? m_boxes_depth_enabled : m_boxes_depth_disabled).emplace_back(instance);
 	}
 
+    void Renderer::CameraLateLatch()
+    {
+        if (!m_camera || !GetOption(Render_CameraLateLatch) || !m_camera_late_latch.active)
+            return;
+
+        // The motion which arrived since the input tick the snapshot's view was built from, the next tick counts it as usual
+        const Vector2 mouse_delta = Input::GetMouseMotionDelta(m_camera_late_latch_motion, m_context->GetSubsystem<Input>()->GetMouseMotion());
+        if (mouse_delta == Vector2::Zero)
+            return;
+
+        // Only the rotation is latched, the position (and the projection) stay as the snapshot captured them
+        const Matrix& projection_unjittered                 = m_camera->GetProjectionMatrix();
+        m_buffer_frame_cpu.view                             = Camera::ComputeViewMatrixLateLatched(m_camera_late_latch, mouse_delta);
+        m_buffer_frame_cpu.view_projection                  = m_buffer_frame_cpu.view * m_buffer_frame_cpu.projection;
+        m_buffer_frame_cpu.view_projection_inv              = Matrix::Invert(m_buffer_frame_cpu.view_projection);
+        m_buffer_frame_cpu.view_projection_unjittered       = m_buffer_frame_cpu.view * projection_unjittered;
+        m_buffer_frame_cpu.camera_direction                 = Matrix::Invert(m_buffer_frame_cpu.view).GetRotation() * Vector3::Forward;
+        m_camera_frustum                                    = Frustum(m_buffer_frame_cpu.view, projection_unjittered, GetOption(Render_ReverseZ) ? m_near_plane : m_far_plane);
+    }
+
 	bool Renderer::UpdateFrameBuffer()
     {
         // Map
@@ -374,24 +665,20 @@ namespace Spartan
         }
 
         // Struct is updated automatically here as per frame data are (by definition) known ahead of time
-        m_buffer_frame_cpu.camera_near                  = m_camera->GetNearPlane();
-        m_buffer_frame_cpu.camera_far                   = m_camera->GetFarPlane();
-        m_buffer_frame_cpu.camera_position              = m_camera->GetTransform()->GetPosition();
-        m_buffer_frame_cpu.camera_direction             = m_camera->GetTransform()->GetForward();
         m_buffer_frame_cpu.bloom_intensity              = m_option_values[Option_Value_Bloom_Intensity];
         m_buffer_frame_cpu.sharpen_strength             = m_option_values[Option_Value_Sharpen_Strength];
         m_buffer_frame_cpu.sharpen_clamp                = m_option_values[Option_Value_Sharpen_Clamp];
         m_buffer_frame_cpu.taa_jitter_offset_previous   = m_buffer_frame_cpu.taa_jitter_offset;
         m_buffer_frame_cpu.taa_jitter_offset            = m_taa_jitter - m_taa_jitter_previous;
+        m_buffer_frame_cpu.taa_jitter                   = m_taa_jitter;
         m_buffer_frame_cpu.motion_blur_strength         = m_option_values[Option_Value_Motion_Blur_Intensity];
-        m_buffer_frame_cpu.delta_time                   = static_cast<float>(m_context->GetSubsystem<Timer>()->GetDeltaTimeSmoothedSec());
-        m_buffer_frame_cpu.time                         = static_cast<float>(m_context->GetSubsystem<Timer>()->GetTimeSec());
         m_buffer_frame_cpu.tonemapping                  = m_option_values[Option_Value_Tonemapping];
         m_buffer_frame_cpu.exposure                     = m_option_values[Option_Value_Exposure];
         m_buffer_frame_cpu.gamma                        = m_option_values[Option_Value_Gamma];
         m_buffer_frame_cpu.ssr_enabled                  = GetOption(Render_ScreenSpaceReflections) ? 1.0f : 0.0f;
         m_buffer_frame_cpu.shadow_resolution            = GetOptionValue<float>(Option_Value_ShadowResolution);
         m_buffer_frame_cpu.frame                        = static_cast<uint32_t>(m_frame_num);
+        m_buffer_frame_cpu.gbuffer_compact              = GetOption(Render_GBuffer_Compact) ? 1.0f : 0.0f;
 
         // Update directional light intensity, just grab the first one
         for (const auto& entity : m_entities[Renderer_Object_Light])
@@ -412,6 +699,10 @@ namespace Spartan
 
     bool Renderer::UpdateMaterialBuffer()
     {
+        // MaterialTableSlot() writes the entries which changed, so most frames there is nothing to upload
+        if (!m_buffer_material_dirty)
+            return true;
+
         // Map
         BufferMaterial* buffer = static_cast<BufferMaterial*>(m_buffer_material_gpu->Map());
         if (!buffer)
@@ -420,56 +711,145 @@ namespace Spartan
             return false;
         }
 
-        // Update
-        for (uint32_t i = 0; i < m_max_material_instances; i++)
-        {
-            Material* material = m_material_instances[i];
-            if (!material)
-                continue;
-
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].x = material->GetProperty(Material_Clearcoat);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].y = material->GetProperty(Material_Clearcoat_Roughness);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].z = material->GetProperty(Material_Anisotropic);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].w = material->GetProperty(Material_Anisotropic_Rotation);
-            buffer->mat_sheen_sheenTint_pad[i].x                   = material->GetProperty(Material_Sheen);
-            buffer->mat_sheen_sheenTint_pad[i].y                   = material->GetProperty(Material_Sheen_Tint);
-        }
+        // Update (a map discards the buffer's previous contents, so the whole table is copied)
+        memcpy(buffer, &m_buffer_material_cpu, sizeof(BufferMaterial));
+        m_buffer_material_dirty = false;
 
         // Unmap
         return m_buffer_material_gpu->Unmap();
     }
 
-    template<typename T>
-    inline bool update_dynamic_buffer(RHI_CommandList* cmd_list, RHI_ConstantBuffer* buffer_gpu, T& buffer_cpu, T& buffer_cpu_previous, uint32_t& offset_index)
+    uint32_t Renderer::MaterialTableSlot(Material* material)
     {
-        offset_index++;
+        const uint64_t frame = m_frame_num + 1; // zero is reserved for "never drawn"
 
-        // Only update if needed
-        bool update = buffer_gpu->GetOffsetIndexDynamic() != offset_index;
-        update      = update ? true : buffer_cpu != buffer_cpu_previous;
-        if (!update)
-            return true;
+        auto it = m_material_table.find(material->GetId());
+        if (it == m_material_table.end())
+        {
+            // Take the slot which was drawn the longest ago (0 is reserved for the sky)
+            uint32_t slot = 1;
+            for (uint32_t i = 2; i < m_max_materials && m_material_table_frames[slot] != 0; i++)
+            {
+                slot = m_material_table_frames[i] < m_material_table_frames[slot] ? i : slot;
+            }
+
+            if (m_material_table_frames[slot] == frame)
+            {
+                LOG_ERROR("The material table is full, a frame can't draw more than %d materials", m_max_materials - 1);
+                return 0;
+            }
+
+            if (m_material_table_frames[slot] != 0)
+            {
+                m_material_table.erase(m_material_table_ids[slot]);
+            }
 
-        const uint32_t offset_count = offset_index + 1;
+            m_material_table_ids[slot]  = material->GetId();
+            it                          = m_material_table.emplace(material->GetId(), slot).first;
 
-        // Re-allocate buffer with double size (if needed)
-        if (buffer_gpu->IsDynamic())
+            // The slot held another material
+            material->SetDirty();
+        }
+
+        const uint32_t slot             = it->second;
+        m_material_table_frames[slot]   = frame;
+
+        // Write the entry of a material which changed since it was last written
+        if (material->IsDirty())
+        {
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[slot].x = material->GetProperty(Material_Clearcoat);
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[slot].y = material->GetProperty(Material_Clearcoat_Roughness);
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[slot].z = material->GetProperty(Material_Anisotropic);
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[slot].w = material->GetProperty(Material_Anisotropic_Rotation);
+            m_buffer_material_cpu.mat_sheen_sheenTint_pad[slot].x                   = material->GetProperty(Material_Sheen);
+            m_buffer_material_cpu.mat_sheen_sheenTint_pad[slot].y                   = material->GetProperty(Material_Sheen_Tint);
+            m_buffer_material_dirty = true;
+
+            material->ClearDirty();
+        }
+
+        return slot;
+    }
+
+    void Renderer::BindMaterialTextures(RHI_CommandList* cmd_list, Material* material)
+    {
+        // Textures which have a slice in the material texture array are sampled from there, their own binding gets the default texture
+        static const array<Material_Property, 4> packable = { Material_Roughness, Material_Metallic, Material_Occlusion, Material_Mask };
+        array<float, 4> slices;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(packable.size()); i++)
         {
-            if (offset_count >= buffer_gpu->GetOffsetCount())
+            int32_t slice = material->GetTextureSlice(packable[i]);
+            if (slice < 0 && material->HasTexture(packable[i]))
             {
-                cmd_list->Flush();
-                const uint32_t new_size = Math::Helper::NextPowerOfTwo(offset_count);
-                if (!buffer_gpu->Create<T>(new_size))
-                {
-                    LOG_ERROR("Failed to re-allocate %s buffer with %d offsets", buffer_gpu->GetName().c_str(), new_size);
-                    return false;
-                }
-                LOG_INFO("Increased %s buffer size to %d, that's %d kb", buffer_gpu->GetName().c_str(), new_size, (new_size * buffer_gpu->GetStride()) / 1000);
+                slice = MaterialArraySlice(material->GetTexture_PtrShared(packable[i]));
+                material->SetTextureSlice(packable[i], slice);
             }
+            slices[i] = static_cast<float>(slice);
+        }
+        m_buffer_uber_cpu.mat_texture_slices = Vector4(slices[0], slices[1], slices[2], slices[3]);
+
+        cmd_list->SetTexture(0, material->GetTexture_Ptr(Material_Color));
+        cmd_list->SetTexture(1, slices[0] < 0.0f ? material->GetTexture_Ptr(Material_Roughness) : nullptr);
+        cmd_list->SetTexture(2, slices[1] < 0.0f ? material->GetTexture_Ptr(Material_Metallic) : nullptr);
+        cmd_list->SetTexture(3, material->GetTexture_Ptr(Material_Normal));
+        cmd_list->SetTexture(4, material->GetTexture_Ptr(Material_Height));
+        cmd_list->SetTexture(5, slices[2] < 0.0f ? material->GetTexture_Ptr(Material_Occlusion) : nullptr);
+        cmd_list->SetTexture(6, material->GetTexture_Ptr(Material_Emission));
+        cmd_list->SetTexture(7, slices[3] < 0.0f ? material->GetTexture_Ptr(Material_Mask) : nullptr);
+        if (m_material_array)
+        {
+            cmd_list->SetTexture(41, m_material_array);
+        }
+    }
+
+    int32_t Renderer::MaterialArraySlice(const shared_ptr<RHI_Texture>& texture)
+    {
+        // Only loaded 2D textures which fit in a slice, streamed ones change their resident mips so they keep their own binding
+        if (!texture || texture->GetResourceType() != Resource_Texture2d || texture->IsStreamed() || !texture->Get_Resource_View())
+            return -1;
+
+        if (texture->GetWidth() > m_material_array_slice_size || texture->GetHeight() > m_material_array_slice_size)
+            return -1;
+
+        // Copied, or waiting to be
+        auto it = m_material_array_lookup.find(texture->GetId());
+        if (it != m_material_array_lookup.end())
+            return it->second;
+
+        // The array is full, the texture stays on its own
+        if (m_material_array_slice_count == m_material_array_slices)
+            return -1;
+
+        if (!m_material_array)
+        {
+            m_material_array = make_shared<RHI_Texture2D>(m_context, m_material_array_slice_size, m_material_array_slice_size, RHI_Format_R8G8B8A8_Unorm, m_material_array_slices, 0, "material_array");
         }
 
-        // Set new buffer offset
-        buffer_gpu->SetOffsetIndexDynamic(offset_index);
+        m_material_array_lookup.emplace(texture->GetId(), -1);
+        m_material_array_copies.emplace_back(texture, m_material_array_slice_count++);
+
+        return -1;
+    }
+
+    template<typename T>
+    inline bool update_dynamic_buffer(RHI_CommandList* cmd_list, RHI_ConstantBuffer* buffer_gpu, T& buffer_cpu, T& buffer_cpu_previous)
+    {
+        // Only update if needed, an offset which was written this frame can be re-used as long as the data is the same
+        if (buffer_gpu->GetAllocationCount() != 0 && buffer_cpu == buffer_cpu_previous)
+            return true;
+
+        // Sub-allocate, if the frame's region is full, flush so that the GPU is done with it and start over (the ring grows next frame)
+        if (!buffer_gpu->Allocate())
+        {
+            LOG_WARNING("%s buffer ran out of its %d offsets per frame, flushing", buffer_gpu->GetName().c_str(), buffer_gpu->GetRingOffsetCount());
+
+            if (!cmd_list->Flush())
+                return false;
+
+            buffer_gpu->Rewind();
+            if (!buffer_gpu->Allocate())
+                return false;
+        }
 
         // Map  
         T* buffer = static_cast<T*>(buffer_gpu->Map());
@@ -480,17 +860,10 @@ namespace Spartan
         }
 
         uint64_t size   = buffer_gpu->GetStride();
-        uint64_t offset = offset_index * size;
+        uint64_t offset = buffer_gpu->IsDynamic() ? buffer_gpu->GetOffsetDynamic() : 0;
 
         // Update
-        if (buffer_gpu->IsDynamic())
-        {
-            memcpy(reinterpret_cast<std::byte*>(buffer) + offset, reinterpret_cast<std::byte*>(&buffer_cpu), size);
-        }
-        else
-        {
-            *buffer = buffer_cpu;
-        }
+        memcpy(reinterpret_cast<std::byte*>(buffer) + offset, reinterpret_cast<std::byte*>(&buffer_cpu), sizeof(T));
         buffer_cpu_previous = buffer_cpu;
 
         // Unmap
@@ -505,7 +878,7 @@ namespace Spartan
             return false;
         }
 
-        if (!update_dynamic_buffer<BufferUber>(cmd_list, m_buffer_uber_gpu.get(), m_buffer_uber_cpu, m_buffer_uber_cpu_previous, m_buffer_uber_offset_index))
+        if (!update_dynamic_buffer<BufferUber>(cmd_list, m_buffer_uber_gpu.get(), m_buffer_uber_cpu, m_buffer_uber_cpu_previous))
             return false;
 
         // Dynamic buffers with offsets have to be rebound whenever the offset changes
@@ -520,144 +893,1699 @@ namespace Spartan
             return false;
         }
 
-        if (!update_dynamic_buffer<BufferObject>(cmd_list, m_buffer_object_gpu.get(), m_buffer_object_cpu, m_buffer_object_cpu_previous, m_buffer_object_offset_index))
+        if (!update_dynamic_buffer<BufferObject>(cmd_list, m_buffer_object_gpu.get(), m_buffer_object_cpu, m_buffer_object_cpu_previous))
             return false;
 
         // Dynamic buffers with offsets have to be rebound whenever the offset changes
         return cmd_list->SetConstantBuffer(3, RHI_Shader_Vertex, m_buffer_object_gpu);
     }
 
-    bool Renderer::UpdateLightBuffer(const Light* light)
+    bool Renderer::UpdateDrawBuffer(RHI_CommandList* cmd_list)
     {
-        if (!light)
+        if (!cmd_list)
+        {
+            LOG_ERROR("Invalid command list");
             return false;
+        }
 
-        // Only update if needed
-        if (m_buffer_light_cpu == m_buffer_light_cpu_previous)
-            return true;
+        // Recorded into the command list, there is no buffer to sub-allocate and no offset to rebind
+        return cmd_list->SetPushConstants(&m_buffer_draw_cpu, static_cast<uint32_t>(sizeof(BufferDraw)));
+    }
 
-        // Map
-        BufferLight* buffer = static_cast<BufferLight*>(m_buffer_light_gpu->Map());
-        if (!buffer)
+    bool Renderer::UpdateSkinBuffer(RHI_CommandList* cmd_list, const Renderable* renderable)
+    {
+        if (!cmd_list || !renderable)
         {
-            LOG_ERROR("Failed to map buffer");
+            LOG_ERROR_INVALID_PARAMETER();
             return false;
         }
 
-        const bool volumetric         = static_cast<float>(m_options & Render_VolumetricLighting);
-        const bool contact_shadows    = static_cast<float>(m_options & Render_ScreenSpaceShadows);
+        // With dynamic offsets, a palette is uploaded by the first pass which draws the renderable and the passes after it bind it where it went
+        if (m_buffer_skin_gpu->IsDynamic())
+        {
+            const auto it = m_buffer_skin_offsets.find(renderable);
+            if (it != m_buffer_skin_offsets.end())
+            {
+                m_buffer_skin_gpu->SetOffsetIndexDynamic(it->second);
+                return cmd_list->SetConstantBuffer(6, RHI_Shader_Vertex, m_buffer_skin_gpu);
+            }
+        }
 
-        for (uint32_t i = 0; i < light->GetShadowArraySize(); i++) { m_buffer_light_cpu.view_projection[i] = light->GetViewMatrix(i) * light->GetProjectionMatrix(i); }
-        m_buffer_light_cpu.intensity_range_angle_bias   = Vector4(light->GetIntensity(), light->GetRange(), light->GetAngle(), GetOption(Render_ReverseZ) ? light->GetBias() : -light->GetBias());
-        m_buffer_light_cpu.color                        = light->GetColor();
-        m_buffer_light_cpu.normal_bias                  = light->GetNormalBias();
-        m_buffer_light_cpu.position                     = light->GetTransform()->GetPosition();
-        m_buffer_light_cpu.direction                    = light->GetDirection();
+        // Bones past the palette aren't referred to by any vertex
+        const vector<Matrix>& palette = renderable->GetBonePaletteRender();
+        const uint32_t bone_count = Helper::Min(static_cast<uint32_t>(palette.size()), rhi_max_skin_bones);
+        for (uint32_t i = 0; i < bone_count; i++)
+        {
+            m_buffer_skin_cpu.bones[i] = palette[i];
+        }
 
-        // Update
-        *buffer = m_buffer_light_cpu;
-        m_buffer_light_cpu_previous = m_buffer_light_cpu;
+        const uint32_t allocations = m_buffer_skin_gpu->GetAllocationCount();
+        if (!update_dynamic_buffer<BufferSkin>(cmd_list, m_buffer_skin_gpu.get(), m_buffer_skin_cpu, m_buffer_skin_cpu_previous))
+            return false;
 
-        // Unmap
-        return m_buffer_light_gpu->Unmap();
+        // A full region starts over (after a flush), which hands out the offsets that were kept
+        if (m_buffer_skin_gpu->GetAllocationCount() < allocations)
+        {
+            m_buffer_skin_offsets.clear();
+        }
+        m_buffer_skin_offsets[renderable] = m_buffer_skin_gpu->GetOffsetIndexDynamic();
+
+        // Dynamic buffers with offsets have to be rebound whenever the offset changes
+        return cmd_list->SetConstantBuffer(6, RHI_Shader_Vertex, m_buffer_skin_gpu);
     }
 
-	void Renderer::RenderablesAcquire(const Variant& entities_variant)
-	{
-        SCOPED_TIME_BLOCK(m_profiler);
+    bool Renderer::UpdateLightBuffer()
+    {
+        // Every light which emits and reaches something in view gets a slot, the ones past the buffer's capacity aren't drawn
+        m_lights.clear();
+        for (const auto& entity : m_entities[Renderer_Object_Light])
+        {
+            const Light* light = entity->GetComponent<Light>();
+            if (!light || light->GetIntensity() == 0)
+                continue;
 
-		// Clear previous state
-		m_entities.clear();
-		m_camera = nullptr;
+            // Outside the frustum or hidden behind occluders
+            if (!IsLightVisible(light))
+            {
+                m_counter_lights_culled->Add(1);
+                continue;
+            }
 
-		vector<shared_ptr<Entity>> entities = entities_variant.Get<vector<shared_ptr<Entity>>>();
-		for (const auto& entity : entities)
-		{
-			if (!entity || !entity->IsActive())
-				continue;
+            if (m_lights.size() == m_max_lights)
+                break;
 
-			// Get all the components we are interested in
-            Renderable* renderable  = entity->GetComponent<Renderable>();
-            Light* light            = entity->GetComponent<Light>();
-            Camera* camera          = entity->GetComponent<Camera>();
+            const uint32_t index = static_cast<uint32_t>(m_lights.size());
+            m_lights.emplace_back(light);
 
-			if (renderable)
-			{
-                bool is_transparent = false;
+            // Cached shadow slices are sampled with the matrices they were rendered with
+            for (uint32_t i = 0; i < light->GetShadowArraySize(); i++)
+            {
+                const Matrix* view_projection_cached                    = GetShadowSliceViewProjection(light, i);
+                m_buffer_lights_cpu.view_projection[index * 6 + i]      = view_projection_cached ? *view_projection_cached : light->GetViewMatrix(i) * light->GetProjectionMatrix(i);
+            }
+
+            const Vector3 position  = light->GetPositionRender();
+            const Vector3 direction = light->GetDirectionRender();
+            const float angle       = light->GetLightType() == LightType_Spot ? light->GetAngle() : -1.0f;
+            m_buffer_lights_cpu.color_intensity[index]  = Vector4(light->GetColor().x, light->GetColor().y, light->GetColor().z, light->GetIntensity());
+            m_buffer_lights_cpu.position_range[index]   = Vector4(position.x, position.y, position.z, light->GetRange());
+            m_buffer_lights_cpu.direction_angle[index]  = Vector4(direction.x, direction.y, direction.z, angle);
+            m_buffer_lights_cpu.bias_normal_bias[index] = Vector4(GetOption(Render_ReverseZ) ? light->GetBias() : -light->GetBias(), light->GetNormalBias(), 0.0f, light->GetLightType() == LightType_Directional ? 1.0f : 0.0f);
+        }
 
-                if (const Material* material = renderable->GetMaterial())
+        // Screen space shadows are marched for a few lights at once, each gets a channel of a mask.
+        // The directional light goes first, then the lights which are the brightest at the camera.
+        m_lights_screen_space_shadows.clear();
+        if (GetOption(Render_ScreenSpaceShadows))
+        {
+            for (const Light* light : m_lights)
+            {
+                if (light->GetShadowsScreenSpaceEnabled())
                 {
-                    is_transparent = material->GetColorAlbedo().w < 1.0f;
+                    m_lights_screen_space_shadows.emplace_back(light);
                 }
+            }
 
-                m_entities[is_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque].emplace_back(entity.get());
-			}
-
-			if (light)
-			{
-				m_entities[Renderer_Object_Light].emplace_back(entity.get());
-			}
-
-			if (camera)
-			{
-				m_entities[Renderer_Object_Camera].emplace_back(entity.get());
-				m_camera = camera->GetPtrShared<Camera>();
-			}
-		}
-
-		RenderablesSort(&m_entities[Renderer_Object_Opaque]);
-		RenderablesSort(&m_entities[Renderer_Object_Transparent]);
-	}
-
-	void Renderer::RenderablesSort(vector<Entity*>* renderables)
-	{
-		if (!m_camera || renderables->size() <= 2)
-			return;
+            const Vector3 camera_position = m_buffer_frame_cpu.camera_position;
+            auto importance = [&camera_position](const Light* light)
+            {
+                if (light->GetLightType() == LightType_Directional)
+                    return numeric_limits<float>::max();
 
-		auto comparison_op = [this](Entity* entity)
-		{
-			auto renderable = entity->GetRenderable();
-			if (!renderable)
-				return 0.0f;
+                return light->GetIntensity() / Helper::Max(Vector3::DistanceSquared(light->GetPositionRender(), camera_position), 1.0f);
+            };
+            stable_sort(m_lights_screen_space_shadows.begin(), m_lights_screen_space_shadows.end(), [&importance](const Light* a, const Light* b) { return importance(a) > importance(b); });
 
-			return (renderable->GetAabb().GetCenter() - m_camera->GetTransform()->GetPosition()).LengthSquared();
-		};
+            if (m_lights_screen_space_shadows.size() > m_max_lights_screen_space_shadows)
+            {
+                m_lights_screen_space_shadows.resize(m_max_lights_screen_space_shadows);
+            }
+        }
 
-		// Sort by depth (front to back)
-		sort(renderables->begin(), renderables->end(), [&comparison_op](Entity* a, Entity* b)
-		{
-            return comparison_op(a) < comparison_op(b);
-		});
-	}
+        for (uint32_t channel = 0; channel < m_max_lights_screen_space_shadows; channel++)
+        {
+            const uint32_t index = channel < m_lights_screen_space_shadows.size() ? GetLightIndex(m_lights_screen_space_shadows[channel]) : m_max_lights;
+            m_buffer_lights_cpu.screen_space_shadows[channel] = index;
+            if (index != m_max_lights)
+            {
+                m_buffer_lights_cpu.bias_normal_bias[index].z = static_cast<float>(channel + 1);
+            }
+        }
 
-    void Renderer::ClearEntities()
-    {
-        m_rhi_device->Queue_WaitAll();
+        // Most frames nothing moved, so there is nothing to upload
+        if (memcmp(&m_buffer_lights_cpu, &m_buffer_lights_cpu_previous, sizeof(BufferLights)) == 0)
+            return true;
 
-        // light depth buffers might be used by the command list
-        if (!m_swap_chain->GetCmdList()->Reset())
+        // Map
+        BufferLights* buffer = static_cast<BufferLights*>(m_buffer_lights_gpu->Map());
+        if (!buffer)
         {
-            LOG_ERROR("Failed to reset command pool");
-            return;
+            LOG_ERROR("Failed to map buffer");
+            return false;
         }
 
-        m_entities.clear();
+        // Update
+        memcpy(buffer, &m_buffer_lights_cpu, sizeof(BufferLights));
+        m_buffer_lights_cpu_previous = m_buffer_lights_cpu;
+
+        // Unmap
+        return m_buffer_lights_gpu->Unmap();
     }
 
-    const shared_ptr<Spartan::RHI_Texture>& Renderer::GetEnvironmentTexture()
+    uint32_t Renderer::GetLightIndex(const Light* light) const
     {
-        if (m_render_targets.find(RenderTarget_Brdf_Prefiltered_Environment) != m_render_targets.end())
-            return m_render_targets[RenderTarget_Brdf_Prefiltered_Environment];
-
-        return m_tex_white;
+        const auto it = find(m_lights.begin(), m_lights.end(), light);
+        return it != m_lights.end() ? static_cast<uint32_t>(it - m_lights.begin()) : m_max_lights;
     }
 
-    void Renderer::SetEnvironmentTexture(const shared_ptr<RHI_Texture>& texture)
+    void Renderer::ClusterSlices(float& slice_scale, float& slice_bias) const
     {
-        m_render_targets[RenderTarget_Brdf_Prefiltered_Environment] = texture;
+        // Depth slices are exponential, so that clusters stay roughly cube shaped all the way to the far plane
+        const float near_plane  = m_buffer_frame_cpu.camera_near;
+        const float far_plane   = m_buffer_frame_cpu.camera_far;
+        slice_scale             = static_cast<float>(m_light_cluster_count_z) / log(far_plane / near_plane);
+        slice_bias              = -log(near_plane) * slice_scale;
     }
 
-	void Renderer::SetOption(Renderer_Option option, bool enable)
+    void Renderer::ClusterBin(uint32_t* masks, const Vector3& position, const float range, const uint32_t index) const
+    {
+        const float near_plane  = m_buffer_frame_cpu.camera_near;
+        const float far_plane   = m_buffer_frame_cpu.camera_far;
+        float slice_scale       = 0.0f;
+        float slice_bias        = 0.0f;
+        ClusterSlices(slice_scale, slice_bias);
+        auto get_slice = [&](const float depth)
+        {
+            const float slice = floor(log(max(depth, near_plane)) * slice_scale + slice_bias);
+            return static_cast<uint32_t>(Helper::Clamp(slice, 0.0f, static_cast<float>(m_light_cluster_count_z - 1)));
+        };
+        auto get_tile = [](const float ndc, const uint32_t tile_count)
+        {
+            const float tile = floor((ndc * 0.5f + 0.5f) * tile_count);
+            return static_cast<uint32_t>(Helper::Clamp(tile, 0.0f, static_cast<float>(tile_count - 1)));
+        };
+
+        // Bound with a sphere of the range, in view space
+        const Vector3 center    = position * m_buffer_frame_cpu.view;
+        const float depth_min   = center.z - range;
+        const float depth_max   = center.z + range;
+        if (depth_max < near_plane || depth_min > far_plane)
+            return;
+
+        // Project the sphere's box to get the tiles it covers, unless it crosses the near plane where projection falls apart
+        Vector2 ndc_min = Vector2(-1.0f, -1.0f);
+        Vector2 ndc_max = Vector2(1.0f, 1.0f);
+        if (depth_min > near_plane)
+        {
+            ndc_min = Vector2(numeric_limits<float>::max(), numeric_limits<float>::max());
+            ndc_max = Vector2(numeric_limits<float>::lowest(), numeric_limits<float>::lowest());
+            for (uint32_t corner = 0; corner < 8; corner++)
+            {
+                const Vector4 clip = Vector4
+                (
+                    center.x + ((corner & 1) ? range : -range),
+                    center.y + ((corner & 2) ? range : -range),
+                    center.z + ((corner & 4) ? range : -range),
+                    1.0f
+                ) * m_buffer_frame_cpu.projection;
+
+                const Vector2 ndc = Vector2(clip.x / clip.w, clip.y / clip.w);
+                ndc_min = Vector2(min(ndc_min.x, ndc.x), min(ndc_min.y, ndc.y));
+                ndc_max = Vector2(max(ndc_max.x, ndc.x), max(ndc_max.y, ndc.y));
+            }
+
+            // Off screen
+            if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f)
+                return;
+        }
+
+        // Tiles go top to bottom, while ndc goes bottom to top
+        const uint32_t x_start  = get_tile(ndc_min.x, m_light_cluster_count_x);
+        const uint32_t x_end    = get_tile(ndc_max.x, m_light_cluster_count_x);
+        const uint32_t y_start  = get_tile(-ndc_max.y, m_light_cluster_count_y);
+        const uint32_t y_end    = get_tile(-ndc_min.y, m_light_cluster_count_y);
+        const uint32_t z_start  = get_slice(depth_min);
+        const uint32_t z_end    = get_slice(depth_max);
+
+        // Two masks of 32 bits per cluster
+        const uint32_t mask_offset  = index / 32;
+        const uint32_t mask_bit     = 1u << (index % 32);
+        for (uint32_t z = z_start; z <= z_end; z++)
+        {
+            for (uint32_t y = y_start; y <= y_end; y++)
+            {
+                for (uint32_t x = x_start; x <= x_end; x++)
+                {
+                    const uint32_t cluster_index = (z * m_light_cluster_count_y + y) * m_light_cluster_count_x + x;
+                    masks[cluster_index * 2 + mask_offset] |= mask_bit;
+                }
+            }
+        }
+    }
+
+    bool Renderer::UpdateLightClusterBuffer()
+    {
+        BufferLightClusters& clusters = m_buffer_light_clusters_cpu;
+        fill(begin(clusters.masks), end(clusters.masks), 0);
+
+        // The masks hold the light's index in the light buffer
+        const uint32_t light_count = static_cast<uint32_t>(m_lights_clustered.size());
+        for (uint32_t light_index = 0; light_index < light_count; light_index++)
+        {
+            const Light* light = m_lights_clustered[light_index];
+            ClusterBin(clusters.masks, light->GetPositionRender(), light->GetRange(), GetLightIndex(light));
+        }
+
+        float slice_scale   = 0.0f;
+        float slice_bias    = 0.0f;
+        ClusterSlices(slice_scale, slice_bias);
+        clusters.slice_scale_bias_count = Vector4(slice_scale, slice_bias, static_cast<float>(light_count), 0.0f);
+
+        // Map
+        BufferLightClusters* buffer = static_cast<BufferLightClusters*>(m_buffer_light_clusters_gpu->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update
+        *buffer = clusters;
+
+        // Unmap
+        return m_buffer_light_clusters_gpu->Unmap();
+    }
+
+    bool Renderer::UpdateDecalBuffer()
+    {
+        BufferDecals& decals = m_buffer_decals_cpu;
+        fill(begin(decals.masks), end(decals.masks), 0);
+        m_decal_atlas_copies.clear();
+
+        // The decals in view, nearest first, a decal is bound by the sphere around its box
+        struct DecalView
+        {
+            const Decal* decal;
+            Matrix transform;
+            Vector3 center;
+            float radius;
+            float distance_squared;
+        };
+        static vector<DecalView> views;
+        views.clear();
+        if (m_camera)
+        {
+            for (Entity* entity : m_entities[Renderer_Object_Decal])
+            {
+                const Decal* decal = entity->GetComponent<Decal>();
+                if (!decal)
+                    continue;
+
+                DecalView view;
+                view.decal              = decal;
+                view.transform          = entity->GetTransform()->GetMatrixRender();
+                view.center             = view.transform.GetTranslation();
+                view.radius             = (view.transform.GetScale() * 0.5f).Length();
+                view.distance_squared   = Vector3::DistanceSquared(view.center, m_buffer_frame_cpu.camera_position);
+                if (!m_camera->IsInViewFrustrum(view.center, Vector3(view.radius, view.radius, view.radius)))
+                    continue;
+
+                views.emplace_back(view);
+            }
+        }
+        sort(views.begin(), views.end(), [](const DecalView& a, const DecalView& b) { return a.distance_squared < b.distance_squared; });
+        if (views.size() > m_max_decals)
+        {
+            views.resize(m_max_decals);
+        }
+
+        if (!views.empty() && !m_decal_atlas)
+        {
+            const uint32_t size = m_decal_atlas_cells * m_decal_atlas_cell_size;
+            m_decal_atlas = make_shared<RHI_Texture2D>(m_context, size, size, RHI_Format_R8G8B8A8_Unorm, 1, 0, "decal_atlas");
+        }
+
+        // When the textures in view don't fit in the cells which are left, the atlas starts over with them
+        const uint32_t cell_count = m_decal_atlas_cells * m_decal_atlas_cells;
+        {
+            uint32_t cells_needed = 0;
+            for (const DecalView& view : views)
+            {
+                const RHI_Texture* texture = view.decal->GetTexture().get();
+                cells_needed += (texture && m_decal_atlas_lookup.find(texture->GetId()) == m_decal_atlas_lookup.end()) ? 1 : 0;
+            }
+            if (m_decal_atlas_lookup.size() + cells_needed > cell_count)
+            {
+                m_decal_atlas_lookup.clear();
+            }
+        }
+
+        uint32_t decal_count = 0;
+        const float cell_scale = 1.0f / static_cast<float>(m_decal_atlas_cells);
+        for (const DecalView& view : views)
+        {
+            // Find the texture's cell, or give it one and copy it there (once it's loaded)
+            Vector4 atlas_rect = Vector4::Zero; // no texture
+            if (RHI_Texture* texture = view.decal->GetTexture().get())
+            {
+                auto it = m_decal_atlas_lookup.find(texture->GetId());
+                if (it == m_decal_atlas_lookup.end())
+                {
+                    if (!texture->Get_Resource_View() || m_decal_atlas_lookup.size() == cell_count)
+                        continue;
+
+                    const uint32_t cell = static_cast<uint32_t>(m_decal_atlas_lookup.size());
+                    it = m_decal_atlas_lookup.emplace(texture->GetId(), cell).first;
+                    m_decal_atlas_copies.emplace_back(texture, cell);
+                }
+
+                const uint32_t cell = it->second;
+                atlas_rect = Vector4(static_cast<float>(cell % m_decal_atlas_cells) * cell_scale, static_cast<float>(cell / m_decal_atlas_cells) * cell_scale, cell_scale, cell_scale);
+            }
+
+            decals.world_to_box[decal_count]        = view.transform.Inverted();
+            decals.atlas_rect[decal_count]          = atlas_rect;
+            decals.color[decal_count]               = view.decal->GetColor();
+            decals.roughness_metallic[decal_count]  = Vector4(view.decal->GetRoughness(), view.decal->GetMetallic(), 0.0f, 0.0f);
+            ClusterBin(decals.masks, view.center, view.radius, decal_count);
+            decal_count++;
+        }
+
+        float slice_scale   = 0.0f;
+        float slice_bias    = 0.0f;
+        ClusterSlices(slice_scale, slice_bias);
+        decals.slice_scale_bias_count = Vector4(slice_scale, slice_bias, static_cast<float>(decal_count), 0.0f);
+
+        // Map
+        BufferDecals* buffer = static_cast<BufferDecals*>(m_buffer_decals_gpu->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update
+        *buffer = decals;
+
+        // Unmap
+        return m_buffer_decals_gpu->Unmap();
+    }
+
+    uint64_t Renderer::ReflectionProbeSignature(const ReflectionProbe* probe)
+    {
+        // What the bake depends on, the box only matters to the projection so it isn't part of it
+        const Vector3 position = probe->GetTransform()->GetPosition();
+        size_t seed = 0;
+        Utility::Hash::hash_combine(seed, position.x);
+        Utility::Hash::hash_combine(seed, position.y);
+        Utility::Hash::hash_combine(seed, position.z);
+        Utility::Hash::hash_combine(seed, probe->GetBakeRevision());
+
+        return static_cast<uint64_t>(seed) | 1; // zero means not baked
+    }
+
+    bool Renderer::UpdateReflectionProbeBuffer()
+    {
+        // The probes nearest to the camera
+        static vector<pair<float, const ReflectionProbe*>> candidates;
+        candidates.clear();
+        for (Entity* entity : m_entities[Renderer_Object_ReflectionProbe])
+        {
+            if (const ReflectionProbe* probe = entity->GetComponent<ReflectionProbe>())
+            {
+                candidates.emplace_back(Vector3::DistanceSquared(entity->GetTransform()->GetPosition(), m_buffer_frame_cpu.camera_position), probe);
+            }
+        }
+        sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        if (candidates.size() > m_max_reflection_probes)
+        {
+            candidates.resize(m_max_reflection_probes);
+        }
+
+        // They keep their slots, the slots of the ones which are no longer among them are given to the ones which just became
+        m_reflection_probes.clear();
+        for (const auto& candidate : candidates)
+        {
+            m_reflection_probes.emplace_back(candidate.second);
+
+            const auto it = m_reflection_probe_slots.find(candidate.second->GetId());
+            if (it != m_reflection_probe_slots.end())
+            {
+                it->second.frame_seen = m_frame_num;
+            }
+        }
+
+        uint32_t slots_taken = 0;
+        for (auto it = m_reflection_probe_slots.begin(); it != m_reflection_probe_slots.end();)
+        {
+            if (it->second.frame_seen != m_frame_num)
+            {
+                it = m_reflection_probe_slots.erase(it);
+                continue;
+            }
+
+            slots_taken |= 1u << it->second.slot;
+            it++;
+        }
+
+        for (const ReflectionProbe* probe : m_reflection_probes)
+        {
+            if (m_reflection_probe_slots.find(probe->GetId()) != m_reflection_probe_slots.end())
+                continue;
+
+            ReflectionProbeSlot slot;
+            while (slots_taken & (1u << slot.slot))
+            {
+                slot.slot++;
+            }
+            slot.frame_seen = m_frame_num;
+            slots_taken |= 1u << slot.slot;
+            m_reflection_probe_slots[probe->GetId()] = slot;
+        }
+
+        // The probe which is being baked carries on, unless it lost its slot or moved (then it starts over),
+        // otherwise the nearest probe which was never baked (or whose bake is out of date) starts.
+        if (m_reflection_probe_bake_id != 0)
+        {
+            const auto it = find_if(m_reflection_probes.begin(), m_reflection_probes.end(), [this](const ReflectionProbe* probe) { return probe->GetId() == m_reflection_probe_bake_id; });
+            if (it == m_reflection_probes.end() || ReflectionProbeSignature(*it) != m_reflection_probe_bake_signature)
+            {
+                m_reflection_probe_bake_id = 0;
+            }
+        }
+
+        if (m_reflection_probe_bake_id == 0)
+        {
+            for (const ReflectionProbe* probe : m_reflection_probes)
+            {
+                const uint64_t signature = ReflectionProbeSignature(probe);
+                if (m_reflection_probe_slots[probe->GetId()].signature != signature)
+                {
+                    m_reflection_probe_bake_id          = probe->GetId();
+                    m_reflection_probe_bake_signature   = signature;
+                    m_reflection_probe_bake_face        = 0;
+                    break;
+                }
+            }
+        }
+
+        // The ones which were baked (at least once) light the frame
+        BufferReflectionProbes& probes  = m_buffer_reflection_probes_cpu;
+        uint32_t probe_count            = 0;
+        for (const ReflectionProbe* probe : m_reflection_probes)
+        {
+            const ReflectionProbeSlot& slot = m_reflection_probe_slots[probe->GetId()];
+            if (slot.signature == 0)
+                continue;
+
+            const Vector3 center    = probe->GetTransform()->GetPosition();
+            const Vector3& extents  = probe->GetExtents();
+            probes.center_fade[probe_count]     = Vector4(center.x, center.y, center.z, probe->GetFadeDistance());
+            probes.extents_slice[probe_count]   = Vector4(extents.x, extents.y, extents.z, static_cast<float>(slot.slot * m_reflection_probe_slices));
+            probe_count++;
+        }
+        probes.count = Vector4(static_cast<float>(probe_count), 0.0f, 0.0f, 0.0f);
+
+        // Map
+        BufferReflectionProbes* buffer = static_cast<BufferReflectionProbes*>(m_buffer_reflection_probes_gpu->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update
+        *buffer = probes;
+
+        // Unmap
+        return m_buffer_reflection_probes_gpu->Unmap();
+    }
+
+	void Renderer::RenderablesAcquire(const Variant& entities_variant)
+	{
+        // The registry already knows about every component, the world resolving only means that
+        // entities might have been activated or deactivated, so the next snapshot re-publishes the registry.
+        lock_guard<mutex> lock(m_entities_mutex);
+        m_registry_dirty = true;
+	}
+
+	void Renderer::RenderablesSort(vector<Entity*>* renderables, const Camera* camera)
+	{
+		if (!camera || renderables->size() <= 2)
+			return;
+
+        // The keys are the squared distances, the bits of a positive float sort like the float itself
+        const Vector3 camera_position = camera->GetTransform()->GetPosition();
+        m_sort_keys.resize(renderables->size());
+        for (size_t i = 0; i < renderables->size(); i++)
+        {
+            const Renderable* renderable = (*renderables)[i]->GetRenderable();
+            const float distance_squared = renderable ? (renderable->GetAabb().GetCenter() - camera_position).LengthSquared() : 0.0f;
+
+            uint32_t distance_bits = 0;
+            memcpy(&distance_bits, &distance_squared, sizeof(distance_bits));
+            m_sort_keys[i] = distance_bits;
+        }
+
+		// Sort by depth (front to back)
+        Utility::Sort::radix_sort(m_sort_keys, *renderables, m_sort_keys_scratch, m_sort_entities_scratch);
+	}
+
+    void Renderer::ClearEntities()
+    {
+        m_rhi_device->Queue_WaitAll();
+
+        // light depth buffers might be used by the command list
+        if (!m_swap_chain->GetCmdList()->Reset())
+        {
+            LOG_ERROR("Failed to reset command pool");
+            return;
+        }
+
+        // Materials of the old world give their slots back
+        m_material_table.clear();
+        m_material_table_frames.fill(0);
+
+        // Impostors of the old world's models
+        m_impostors.clear();
+        m_impostor_bake_requests.clear();
+
+        // Decal textures of the old world
+        m_decal_atlas_lookup.clear();
+
+        // Small material textures of the old world, the materials which outlive it (in the resource cache) ask for new slices
+        m_material_array_lookup.clear();
+        m_material_array_copies.clear();
+        m_material_array_slice_count = 0;
+        for (const shared_ptr<IResource>& resource : m_resource_cache->GetByType(Resource_Material))
+        {
+            static_cast<Material*>(resource.get())->ResetTextureSlices();
+        }
+
+        // Reflection probes of the old world, their slices are simply baked over
+        m_reflection_probe_slots.clear();
+        m_reflection_probes.clear();
+        m_reflection_probe_bake_id = 0;
+
+        // The world is about to drop its entities, keep them alive until no frame records them
+        lock_guard<mutex> lock(m_entities_mutex);
+        m_view_requests.clear();
+        for (uint32_t object_type = 0; object_type < static_cast<uint32_t>(m_registry.size()); object_type++)
+        {
+            for (Entity* entity : m_registry[object_type])
+            {
+                m_registry_released.emplace_back(entity->GetPtrShared());
+            }
+
+            m_registry[object_type].clear();
+            m_registry_indices[object_type].clear();
+        }
+        m_registry_dirty = true;
+    }
+
+    void Renderer::RegistryAdd(Entity* entity, const Renderer_Object_Type object_type)
+    {
+        lock_guard<mutex> lock(m_entities_mutex);
+        RegistryInsert(entity, object_type);
+    }
+
+    void Renderer::RegistryRemove(Entity* entity, const Renderer_Object_Type object_type)
+    {
+        lock_guard<mutex> lock(m_entities_mutex);
+
+        // Renderables can be in either of the two lists
+        if (object_type == Renderer_Object_Opaque || object_type == Renderer_Object_Transparent)
+        {
+            RegistryErase(entity, Renderer_Object_Opaque);
+            RegistryErase(entity, Renderer_Object_Transparent);
+        }
+        else
+        {
+            RegistryErase(entity, object_type);
+        }
+
+        // A view ends with its camera, the entity's address could be reused
+        if (object_type == Renderer_Object_Camera)
+        {
+            m_view_requests.erase(entity);
+        }
+    }
+
+    void Renderer::RegistryClassify(Entity* entity)
+    {
+        Renderable* renderable = entity->GetRenderable();
+        if (!renderable)
+            return;
+
+        const Material* material                = renderable->GetMaterial();
+        const Renderer_Object_Type object_type  = (material && material->GetColorAlbedo().w < 1.0f) ? Renderer_Object_Transparent : Renderer_Object_Opaque;
+        const Renderer_Object_Type object_other = object_type == Renderer_Object_Opaque ? Renderer_Object_Transparent : Renderer_Object_Opaque;
+
+        // Only move registered renderables, anything else registers by itself
+        lock_guard<mutex> lock(m_entities_mutex);
+        if (RegistryErase(entity, object_other))
+        {
+            RegistryInsert(entity, object_type);
+        }
+    }
+
+    void Renderer::RegistryClassify(const Material* material)
+    {
+        // Gather first, as classifying moves entities between the lists
+        vector<Entity*> entities;
+        {
+            lock_guard<mutex> lock(m_entities_mutex);
+            for (Renderer_Object_Type object_type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+            {
+                for (Entity* entity : m_registry[object_type])
+                {
+                    if (entity->GetRenderable()->GetMaterial() == material)
+                    {
+                        entities.emplace_back(entity);
+                    }
+                }
+            }
+        }
+
+        for (Entity* entity : entities)
+        {
+            RegistryClassify(entity);
+        }
+    }
+
+    void Renderer::RegistryRelease(const shared_ptr<Entity>& entity)
+    {
+        lock_guard<mutex> lock(m_entities_mutex);
+
+        bool registered = false;
+        for (uint32_t object_type = 0; object_type < static_cast<uint32_t>(m_registry.size()); object_type++)
+        {
+            registered = RegistryErase(entity.get(), static_cast<Renderer_Object_Type>(object_type)) || registered;
+        }
+
+        if (registered)
+        {
+            m_registry_released.emplace_back(entity);
+        }
+    }
+
+    void Renderer::RegistryInsert(Entity* entity, const Renderer_Object_Type object_type)
+    {
+        auto& indices = m_registry_indices[object_type];
+        if (indices.find(entity) != indices.end())
+            return;
+
+        indices[entity] = static_cast<uint32_t>(m_registry[object_type].size());
+        m_registry[object_type].emplace_back(entity);
+        m_registry_dirty = true;
+    }
+
+    bool Renderer::RegistryErase(Entity* entity, const Renderer_Object_Type object_type)
+    {
+        auto& indices   = m_registry_indices[object_type];
+        auto it         = indices.find(entity);
+        if (it == indices.end())
+            return false;
+
+        // Swap with the last one and pop, the order doesn't matter as the lists are sorted when published
+        vector<Entity*>& entities   = m_registry[object_type];
+        const uint32_t index        = it->second;
+        entities[index]             = entities.back();
+        indices[entities[index]]    = index;
+        entities.pop_back();
+        indices.erase(entity);
+
+        m_registry_dirty = true;
+        return true;
+    }
+
+    void Renderer::RegistryPublish()
+    {
+        m_entities.clear();
+        m_camera.reset();
+
+        for (uint32_t object_type = 0; object_type < static_cast<uint32_t>(m_registry.size()); object_type++)
+        {
+            for (Entity* entity : m_registry[object_type])
+            {
+                if (entity->IsActive())
+                {
+                    m_entities[static_cast<Renderer_Object_Type>(object_type)].emplace_back(entity);
+                }
+            }
+        }
+
+        ViewsPublish();
+
+        for (Entity* entity : m_entities[Renderer_Object_Camera])
+        {
+            Camera* camera  = entity->GetComponent<Camera>();
+            const auto view = find_if(m_views.begin(), m_views.end(), [entity](const View& view) { return view.entity == entity; });
+            if (view != m_views.end())
+            {
+                view->camera = camera;
+            }
+            else
+            {
+                m_camera = camera->GetPtrShared<Camera>();
+            }
+        }
+
+        RenderablesSort(&m_entities[Renderer_Object_Opaque], m_camera.get());
+        RenderablesSort(&m_entities[Renderer_Object_Transparent], m_camera.get());
+    }
+
+    Renderer::DrawList& Renderer::DrawListAdd()
+    {
+        // Lists are never shrunk, a list which is reused keeps the capacity of its entity vector
+        if (m_draw_list_count == m_draw_lists.size())
+        {
+            m_draw_lists.emplace_back();
+        }
+
+        DrawList& draw_list     = m_draw_lists[m_draw_list_count++];
+        draw_list.light         = nullptr;
+        draw_list.array_index   = 0;
+        draw_list.signature     = 0;
+        draw_list.render        = true;
+        draw_list.entities.clear();
+        draw_list.keys.clear();
+        draw_list.batches.clear();
+
+        return draw_list;
+    }
+
+    void Renderer::DrawListBatch(DrawList& draw_list, const bool parallel /*= false*/, const bool back_to_front /*= false*/)
+    {
+        // Blending needs the farthest entities first, so the depth bits are inverted and rotated to the top of the keys for the sort (and back after).
+        // Entities only batch with identical neighbours then.
+        if (back_to_front)
+        {
+            for (uint64_t& key : draw_list.keys)
+            {
+                key = ((~key & 0xFFFF) << 48) | (key >> 16);
+            }
+        }
+
+        // Sort by draw key, entities which can be drawn together end up next to each other
+        Utility::Sort::radix_sort(draw_list.keys, draw_list.entities, draw_list.keys_scratch, draw_list.entities_scratch, parallel ? m_threading : nullptr);
+
+        if (back_to_front)
+        {
+            for (uint64_t& key : draw_list.keys)
+            {
+                key = (key << 16) | (~(key >> 48) & 0xFFFF);
+            }
+        }
+
+        // Split into runs of identical keys (the depth aside)
+        constexpr uint64_t material_unbatched = static_cast<uint64_t>(draw_key_material_count - 1) << 40;
+        constexpr uint64_t geometry_unbatched = static_cast<uint64_t>(draw_key_geometry_count - 1) << 19;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(draw_list.entities.size()); i++)
+        {
+            const uint64_t key = draw_list.keys[i] & draw_key_batch_mask;
+
+            // Materials and geometry which ran out of numbers share the reserved ones, so they can't be batched, neither can skinned entities
+            const bool batchable = (key & material_unbatched) != material_unbatched && (key & geometry_unbatched) != geometry_unbatched && !DrawKeySkinned(key);
+
+            if (batchable && !draw_list.batches.empty())
+            {
+                DrawBatch& batch = draw_list.batches.back();
+                if ((draw_list.keys[batch.entity_start] & draw_key_batch_mask) == key)
+                {
+                    batch.entity_count++;
+                    continue;
+                }
+            }
+
+            DrawBatch& batch    = draw_list.batches.emplace_back();
+            batch.entity_start  = i;
+            batch.entity_count  = 1;
+        }
+    }
+
+    uint64_t Renderer::DrawKey(const Renderer_Object_Type object_type, const uint32_t variation, const uint64_t material_geometry, const uint32_t lod, const float depth)
+    {
+        // The bits of a positive float sort like the float, so the top 16 are a (logarithmic) depth bucket
+        uint32_t depth_bits = 0;
+        memcpy(&depth_bits, &depth, sizeof(depth_bits));
+        depth_bits = depth > 0.0f ? depth_bits : 0;
+
+        return
+            (static_cast<uint64_t>(object_type == Renderer_Object_Transparent ? 1 : 0) << 63) |
+            (static_cast<uint64_t>(variation & (draw_key_variation_count - 1)) << 56)       |
+            material_geometry                                                               |
+            (static_cast<uint64_t>(lod & (draw_key_lod_count - 1)) << 16)                   |
+            static_cast<uint64_t>(depth_bits >> 16);
+    }
+
+    uint64_t Renderer::DrawKeyMaterialGeometry(const Renderable* renderable)
+    {
+        // Number materials in the order they are encountered, the last number is reserved
+        const Material* material = renderable->GetMaterial();
+        auto it_material = m_draw_key_materials.find(material);
+        if (it_material == m_draw_key_materials.end())
+        {
+            const uint32_t material_id  = min(static_cast<uint32_t>(m_draw_key_materials.size()), draw_key_material_count - 1);
+            it_material                 = m_draw_key_materials.emplace(material, material_id).first;
+        }
+
+        // Same with geometry ranges
+        const array<uint32_t, 4> geometry =
+        {
+            renderable->GeometryModel()->GetId(),
+            renderable->GeometryIndexOffset(),
+            renderable->GeometryIndexCount(),
+            renderable->GeometryVertexOffset()
+        };
+        auto it_geometry = m_draw_key_geometries.find(geometry);
+        if (it_geometry == m_draw_key_geometries.end())
+        {
+            const uint32_t geometry_id  = min(static_cast<uint32_t>(m_draw_key_geometries.size()), draw_key_geometry_count - 1);
+            it_geometry                 = m_draw_key_geometries.emplace(geometry, geometry_id).first;
+        }
+
+        const Model* model              = renderable->GeometryModel();
+        const uint64_t vertex_layout    = model->IsVertexSkinned() ? 2 : (model->IsVertexDisplaced() ? 3 : (model->IsVertexCompact() ? 1 : 0));
+        return (vertex_layout << 54) | (static_cast<uint64_t>(it_material->second) << 40) | (static_cast<uint64_t>(it_geometry->second) << 19);
+    }
+
+    uint64_t Renderer::ImpostorKey(const Renderable* renderable)
+    {
+        // The geometry range and the material, the impostor of a model is shared by whatever draws the same
+        size_t seed = 0;
+        Utility::Hash::hash_combine(seed, renderable->GeometryModel()->GetId());
+        Utility::Hash::hash_combine(seed, renderable->GeometryIndexOffset());
+        Utility::Hash::hash_combine(seed, renderable->GeometryIndexCount());
+        Utility::Hash::hash_combine(seed, renderable->GeometryVertexOffset());
+        Utility::Hash::hash_combine(seed, renderable->GetMaterial()->GetId());
+        return static_cast<uint64_t>(seed);
+    }
+
+    void Renderer::ImpostorRequest(const Renderable* renderable, const uint64_t key)
+    {
+        if (m_impostor_bake_requests.count(key) != 0)
+            return;
+
+        ImpostorBakeRequest request;
+        request.model           = const_cast<Model*>(renderable->GeometryModel())->GetSharedPtr();
+        request.material        = m_resource_cache->GetByName<Material>(renderable->GetMaterialName());
+        request.index_offset    = renderable->GeometryIndexOffset();
+        request.index_count     = renderable->GeometryIndexCount();
+        request.vertex_offset   = renderable->GeometryVertexOffset();
+        request.bounding_box    = renderable->GetBoundingBox();
+        if (!request.material)
+            return;
+
+        // The bounds of renderables which carry instances contain all of them, the impostor is of the geometry alone
+        if (renderable->HasInstances())
+        {
+            const vector<Vector3>& positions = renderable->GeometryModel()->GetPositions();
+            if (renderable->GeometryVertexCount() == 0 || request.vertex_offset + renderable->GeometryVertexCount() > positions.size())
+                return;
+
+            request.bounding_box = BoundingBox(positions.data() + request.vertex_offset, renderable->GeometryVertexCount());
+        }
+
+        m_impostor_bake_requests.emplace(key, move(request));
+    }
+
+    uint64_t Renderer::ShadowSliceKey(const Light* light, const uint32_t array_index)
+    {
+        return (static_cast<uint64_t>(light->GetId()) << 8) | array_index;
+    }
+
+    void Renderer::ShadowSlicesSelect(const bool layered)
+    {
+        // Slices which were never rendered (or whose shadow map is new) have to be, the others only if they changed
+        m_shadow_slice_candidates.clear();
+        for (uint32_t i = 0; i < m_draw_list_count; i++)
+        {
+            DrawList& draw_list         = m_draw_lists[i];
+            ShadowSliceCache& cache     = m_shadow_slice_cache[ShadowSliceKey(draw_list.light, draw_list.array_index)];
+            const uint32_t texture_id   = draw_list.light->GetDepthTexture()->GetId();
+            const bool is_new           = cache.frame_seen == 0 || cache.texture_id != texture_id;
+
+            cache.frame_seen    = m_frame_num + 1; // zero is reserved for "never seen"
+            cache.texture_id    = texture_id;
+            draw_list.render    = is_new;
+
+            // Far cascades are only candidates on their turn
+            const Light* light          = draw_list.light;
+            const uint32_t far_count    = light->GetLightType() == LightType_Directional && light->GetCascadeCount() > shadow_cascades_every_frame ? light->GetCascadeCount() - shadow_cascades_every_frame : 0;
+            const bool is_turn          = far_count == 0 || draw_list.array_index < shadow_cascades_every_frame || (m_frame_num % far_count) == draw_list.array_index - shadow_cascades_every_frame;
+
+            if (!is_new && is_turn && cache.signature != draw_list.signature)
+            {
+                m_shadow_slice_candidates.emplace_back(i);
+            }
+        }
+
+        // The ones that waited the longest go first
+        stable_sort(m_shadow_slice_candidates.begin(), m_shadow_slice_candidates.end(), [this](const uint32_t a, const uint32_t b)
+        {
+            const DrawList& draw_list_a = m_draw_lists[a];
+            const DrawList& draw_list_b = m_draw_lists[b];
+            return m_shadow_slice_cache[ShadowSliceKey(draw_list_a.light, draw_list_a.array_index)].frame_rendered < m_shadow_slice_cache[ShadowSliceKey(draw_list_b.light, draw_list_b.array_index)].frame_rendered;
+        });
+
+        const uint32_t budget       = GetOptionValue<uint32_t>(Option_Value_ShadowSliceBudget);
+        const uint32_t update_count = budget == 0 ? static_cast<uint32_t>(m_shadow_slice_candidates.size()) : min(budget, static_cast<uint32_t>(m_shadow_slice_candidates.size()));
+        for (uint32_t i = 0; i < update_count; i++)
+        {
+            m_draw_lists[m_shadow_slice_candidates[i]].render = true;
+        }
+
+        // Faces of a cube which are due together are rendered in one layered pass, which clears them all, so the others come along
+        if (layered)
+        {
+            for (uint32_t i = 0; i < m_draw_list_count;)
+            {
+                const Light* light      = m_draw_lists[i].light;
+                uint32_t slice_count    = 0;
+                uint32_t render_count   = 0;
+                while (i + slice_count < m_draw_list_count && m_draw_lists[i + slice_count].light == light)
+                {
+                    render_count += m_draw_lists[i + slice_count].render ? 1 : 0;
+                    slice_count++;
+                }
+
+                if (light->GetLightType() == LightType_Point && render_count >= 2)
+                {
+                    for (uint32_t slice = 0; slice < slice_count; slice++)
+                    {
+                        m_draw_lists[i + slice].render = true;
+                    }
+                }
+
+                i += slice_count;
+            }
+        }
+
+        // Remember what the slices which are about to be rendered will contain
+        for (uint32_t i = 0; i < m_draw_list_count; i++)
+        {
+            const DrawList& draw_list = m_draw_lists[i];
+            if (!draw_list.render)
+                continue;
+
+            ShadowSliceCache& cache = m_shadow_slice_cache[ShadowSliceKey(draw_list.light, draw_list.array_index)];
+            cache.signature         = draw_list.signature;
+            cache.frame_rendered    = m_frame_num + 1;
+            cache.view_projection   = draw_list.light->GetViewMatrix(draw_list.array_index) * draw_list.light->GetProjectionMatrix(draw_list.array_index);
+        }
+
+        // Forget the slices of lights which are gone or don't cast shadows anymore
+        for (auto it = m_shadow_slice_cache.begin(); it != m_shadow_slice_cache.end();)
+        {
+            it = it->second.frame_seen != m_frame_num + 1 ? m_shadow_slice_cache.erase(it) : next(it);
+        }
+    }
+
+    void Renderer::ShadowSlicesMerge()
+    {
+        // Lights whose slices all render get a list of their own which draws them at once, the vertex shader picks the slice of every instance.
+        // The casters of all the slices are merged and batched together, the low bits of their keys (the depth, which shadows don't use) hold the slice.
+        const uint32_t slice_list_count = m_draw_list_count;
+        for (uint32_t i = 0; i < slice_list_count;)
+        {
+            const Light* light      = m_draw_lists[i].light;
+            uint32_t slice_count    = 0;
+            bool render_all         = true;
+            while (i + slice_count < slice_list_count && m_draw_lists[i + slice_count].light == light)
+            {
+                render_all = render_all && m_draw_lists[i + slice_count].render;
+                slice_count++;
+            }
+
+            if (slice_count > 1 && render_all && slice_count < state_max_render_target_count)
+            {
+                DrawList& draw_list_layered     = DrawListAdd(); // can grow the lists, so the slices are referenced after
+                draw_list_layered.light         = light;
+                draw_list_layered.array_index   = slice_count; // the views of all the slices
+                for (uint32_t slice = 0; slice < slice_count; slice++)
+                {
+                    DrawList& draw_list_slice   = m_draw_lists[i + slice];
+                    draw_list_slice.render      = false;
+                    for (uint32_t entity_index = 0; entity_index < static_cast<uint32_t>(draw_list_slice.entities.size()); entity_index++)
+                    {
+                        draw_list_layered.entities.emplace_back(draw_list_slice.entities[entity_index]);
+                        draw_list_layered.keys.emplace_back((draw_list_slice.keys[entity_index] & draw_key_batch_mask) | slice);
+                    }
+                }
+                DrawListBatch(draw_list_layered);
+            }
+
+            i += slice_count;
+        }
+    }
+
+    const Matrix* Renderer::GetShadowSliceViewProjection(const Light* light, const uint32_t array_index) const
+    {
+        const auto it = m_shadow_slice_cache.find(ShadowSliceKey(light, array_index));
+        return it != m_shadow_slice_cache.end() ? &it->second.view_projection : nullptr;
+    }
+
+    bool Renderer::UpdateInstanceBuffer(RHI_CommandList* cmd_list, uint32_t& instance_offset)
+    {
+        instance_offset = m_buffer_instance_offset;
+
+        const uint32_t instance_count = static_cast<uint32_t>(m_instances_cpu.size());
+        if (instance_count == 0)
+            return true;
+
+        // Re-allocate buffer with double size (if needed)
+        const uint32_t instance_count_required = m_buffer_instance_offset + instance_count;
+        if (instance_count_required > m_buffer_instance_gpu->GetVertexCount())
+        {
+            cmd_list->Flush();
+            const uint32_t new_size = Math::Helper::NextPowerOfTwo(instance_count_required);
+            if (!m_buffer_instance_gpu->CreateDynamic<RHI_Vertex_Instance>(new_size))
+            {
+                LOG_ERROR("Failed to re-allocate instance buffer with %d instances", new_size);
+                return false;
+            }
+            LOG_INFO("Increased instance buffer size to %d, that's %d kb", new_size, (new_size * m_buffer_instance_gpu->GetStride()) / 1000);
+        }
+
+        // Map
+        RHI_Vertex_Instance* buffer = static_cast<RHI_Vertex_Instance*>(m_buffer_instance_gpu->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update
+        memcpy(buffer + instance_offset, m_instances_cpu.data(), instance_count * sizeof(RHI_Vertex_Instance));
+        m_buffer_instance_offset += instance_count;
+
+        // Unmap
+        return m_buffer_instance_gpu->Unmap();
+    }
+
+    bool Renderer::UpdateIconBuffer(RHI_CommandList* cmd_list, uint32_t& vertex_offset)
+    {
+        // Like the line buffer, every frame of a cycle appends a region of its own
+        vertex_offset = m_buffer_icons_offset;
+
+        const uint32_t vertex_count = static_cast<uint32_t>(m_icons_cpu.size());
+        if (vertex_count == 0)
+            return true;
+
+        // Re-allocate buffer with double size (if needed)
+        const uint32_t vertex_count_required = m_buffer_icons_offset + vertex_count;
+        if (vertex_count_required > m_vertex_buffer_icons->GetVertexCount())
+        {
+            cmd_list->Flush();
+            const uint32_t new_size = Math::Helper::NextPowerOfTwo(vertex_count_required);
+            if (!m_vertex_buffer_icons->CreateDynamic<RHI_Vertex_PosTex>(new_size))
+            {
+                LOG_ERROR("Failed to re-allocate icon buffer with %d vertices", new_size);
+                return false;
+            }
+            LOG_INFO("Increased icon buffer size to %d, that's %d kb", new_size, (new_size * m_vertex_buffer_icons->GetStride()) / 1000);
+        }
+
+        // Map
+        RHI_Vertex_PosTex* buffer = static_cast<RHI_Vertex_PosTex*>(m_vertex_buffer_icons->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update
+        memcpy(buffer + vertex_offset, m_icons_cpu.data(), vertex_count * sizeof(RHI_Vertex_PosTex));
+        m_buffer_icons_offset += vertex_count;
+
+        // Unmap
+        return m_vertex_buffer_icons->Unmap();
+    }
+
+    bool Renderer::UpdateLineBuffer(RHI_CommandList* cmd_list, uint32_t& vertex_offset_depth_enabled, uint32_t& vertex_offset_depth_disabled)
+    {
+        // Like the instance buffer, every frame of a cycle appends a region of its own, both kinds of lines are written with a single map
+        const uint32_t vertex_count_depth_enabled   = static_cast<uint32_t>(m_lines_list_depth_enabled.size());
+        const uint32_t vertex_count_depth_disabled  = static_cast<uint32_t>(m_lines_list_depth_disabled.size());
+        vertex_offset_depth_enabled                 = m_buffer_lines_offset;
+        vertex_offset_depth_disabled                = m_buffer_lines_offset + vertex_count_depth_enabled;
+
+        const uint32_t vertex_count = vertex_count_depth_enabled + vertex_count_depth_disabled;
+        if (vertex_count == 0)
+            return true;
+
+        // Re-allocate buffer with double size (if needed)
+        const uint32_t vertex_count_required = m_buffer_lines_offset + vertex_count;
+        if (vertex_count_required > m_vertex_buffer_lines->GetVertexCount())
+        {
+            cmd_list->Flush();
+            const uint32_t new_size = Math::Helper::NextPowerOfTwo(vertex_count_required);
+            if (!m_vertex_buffer_lines->CreateDynamic<RHI_Vertex_PosCol>(new_size))
+            {
+                LOG_ERROR("Failed to re-allocate line buffer with %d vertices", new_size);
+                return false;
+            }
+            LOG_INFO("Increased line buffer size to %d, that's %d kb", new_size, (new_size * m_vertex_buffer_lines->GetStride()) / 1000);
+        }
+
+        // Map
+        RHI_Vertex_PosCol* buffer = static_cast<RHI_Vertex_PosCol*>(m_vertex_buffer_lines->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update
+        memcpy(buffer + vertex_offset_depth_enabled, m_lines_list_depth_enabled.data(), vertex_count_depth_enabled * sizeof(RHI_Vertex_PosCol));
+        memcpy(buffer + vertex_offset_depth_disabled, m_lines_list_depth_disabled.data(), vertex_count_depth_disabled * sizeof(RHI_Vertex_PosCol));
+        m_buffer_lines_offset += vertex_count;
+
+        // Unmap
+        return m_vertex_buffer_lines->Unmap();
+    }
+
+    void Renderer::CullInstancesAcquire()
+    {
+        m_draw_key_materials.clear();
+        m_draw_key_geometries.clear();
+
+        for (uint32_t object_type = Renderer_Object_Opaque; object_type <= Renderer_Object_Transparent; object_type++)
+        {
+            vector<CullInstance>& instances = m_cull_instances[object_type];
+
+            for (Entity* entity : m_entities[static_cast<Renderer_Object_Type>(object_type)])
+            {
+                // Anything which can't be drawn is rejected here, so the passes don't have to
+                Renderable* renderable = entity->GetRenderable();
+                if (!renderable)
+                    continue;
+
+                const auto& model = renderable->GeometryModel();
+                if (!model || !model->GetVertexBuffer() || !model->GetVertexBufferPosition() || !model->GetIndexBuffer())
+                    continue;
+
+                Material* material = renderable->GetMaterial();
+                if (!material)
+                    continue;
+
+                const BoundingBox& aabb = renderable->GetAabbRender();
+
+                CullInstance& instance  = instances.emplace_back();
+                instance.center         = aabb.GetCenter();
+                instance.extents        = aabb.GetExtents();
+                instance.entity         = entity;
+                instance.key            = DrawKeyMaterialGeometry(renderable);
+                instance.flags          = material->GetFlags();
+                instance.casts_shadows  = renderable->GetCastShadows();
+
+                const uint32_t index = static_cast<uint32_t>(instances.size() - 1);
+                BvhAcquire(entity, aabb, object_type == Renderer_Object_Transparent ? (index | bvh_transparent_bit) : index);
+            }
+        }
+
+        BvhPrune();
+        m_bvh_stamp++;
+    }
+
+    void Renderer::BvhAcquire(Entity* entity, const BoundingBox& aabb, const uint32_t user_data)
+    {
+        auto it = m_bvh_proxies.find(entity);
+        if (it == m_bvh_proxies.end())
+        {
+            BvhProxy& proxy = m_bvh_proxies[entity];
+            proxy.proxy     = m_bvh.Insert(aabb, user_data);
+            proxy.stamp     = m_bvh_stamp;
+            return;
+        }
+
+        BvhProxy& proxy = it->second;
+        m_bvh.Update(proxy.proxy, aabb);
+        m_bvh.SetUserData(proxy.proxy, user_data);
+        proxy.stamp = m_bvh_stamp;
+    }
+
+    void Renderer::BvhPrune()
+    {
+        // Entities which weren't acquired by this snapshot left the world (or can't be drawn any more)
+        for (auto it = m_bvh_proxies.begin(); it != m_bvh_proxies.end();)
+        {
+            if (it->second.stamp != m_bvh_stamp)
+            {
+                m_bvh.Remove(it->second.proxy);
+                it = m_bvh_proxies.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void Renderer::Query(const Frustum& frustum, vector<Entity*>& entities) const
+    {
+        entities.clear();
+        BvhQuery([&frustum, &entities](const CullInstance& instance, Renderer_Object_Type)
+        {
+            if (frustum.IsVisible(instance.center, instance.extents))
+            {
+                entities.emplace_back(instance.entity);
+            }
+        }, frustum);
+    }
+
+    void Renderer::Query(const Vector3& center, const float radius, vector<Entity*>& entities) const
+    {
+        entities.clear();
+        BvhQuery([&center, radius, &entities](const CullInstance& instance, Renderer_Object_Type)
+        {
+            const Vector3 offset    = (center - instance.center).Abs() - instance.extents;
+            const Vector3 distance  = Vector3(Helper::Max(offset.x, 0.0f), Helper::Max(offset.y, 0.0f), Helper::Max(offset.z, 0.0f));
+            if (distance.LengthSquared() <= radius * radius)
+            {
+                entities.emplace_back(instance.entity);
+            }
+        }, center, radius);
+    }
+
+    void Renderer::Query(const BoundingBox& box, vector<Entity*>& entities) const
+    {
+        entities.clear();
+        BvhQuery([&box, &entities](const CullInstance& instance, Renderer_Object_Type)
+        {
+            if (box.IsInside(BoundingBox(instance.center - instance.extents, instance.center + instance.extents)) != Outside)
+            {
+                entities.emplace_back(instance.entity);
+            }
+        }, box);
+    }
+
+    void Renderer::Query(const Ray& ray, vector<Entity*>& entities) const
+    {
+        entities.clear();
+        BvhQuery([&ray, &entities](const CullInstance& instance, Renderer_Object_Type)
+        {
+            if (ray.HitDistance(BoundingBox(instance.center - instance.extents, instance.center + instance.extents)) != INFINITY)
+            {
+                entities.emplace_back(instance.entity);
+            }
+        }, ray);
+    }
+
+    void Renderer::ViewAdd(Entity* camera_entity, const float resolution_scale /*= 0.5f*/, const uint32_t update_interval /*= 1*/)
+    {
+        if (!camera_entity || !camera_entity->GetComponent<Camera>())
+        {
+            LOG_ERROR("A view needs an entity with a camera");
+            return;
+        }
+
+        ViewRequest request;
+        request.resolution_scale    = Helper::Clamp(resolution_scale, 0.1f, 1.0f);
+        request.update_interval     = Helper::Max(update_interval, 1u);
+
+        lock_guard<mutex> lock(m_entities_mutex);
+        m_view_requests[camera_entity]  = request;
+        m_registry_dirty                = true;
+    }
+
+    void Renderer::ViewRemove(Entity* camera_entity)
+    {
+        lock_guard<mutex> lock(m_entities_mutex);
+        if (m_view_requests.erase(camera_entity) != 0)
+        {
+            m_registry_dirty = true;
+        }
+    }
+
+    shared_ptr<RHI_Texture> Renderer::GetViewTexture(Entity* camera_entity)
+    {
+        lock_guard<mutex> lock(m_entities_mutex);
+        for (const View& view : m_views)
+        {
+            if (view.entity == camera_entity)
+                return view.color;
+        }
+
+        return nullptr;
+    }
+
+    void Renderer::ViewsPublish()
+    {
+        // Views which are still requested keep their textures and when they last rendered
+        vector<View> views;
+        views.reserve(m_view_requests.size());
+        for (const auto& it : m_view_requests)
+        {
+            View view;
+            for (View& view_previous : m_views)
+            {
+                if (view_previous.entity == it.first)
+                {
+                    view = move(view_previous);
+                    break;
+                }
+            }
+
+            view.entity     = it.first;
+            view.camera     = nullptr; // until RegistryPublish() finds the camera among the registered ones
+            view.request    = it.second;
+            views.emplace_back(move(view));
+        }
+
+        // The frames in flight which render into the textures of a dropped view keep them alive through the deletion queue
+        m_views = move(views);
+        m_view  = nullptr;
+    }
+
+    void Renderer::ViewSelect()
+    {
+        // The view which waited the longest past its interval renders this frame, the others wait their turn
+        m_view = nullptr;
+        uint64_t overdue_max = 0;
+        for (View& view : m_views)
+        {
+            if (!view.camera)
+                continue;
+
+            const uint64_t due = view.frame_rendered == 0 ? 0 : view.frame_rendered + view.request.update_interval;
+            if (view.frame_rendered != 0 && m_frame_num < due)
+                continue;
+
+            const uint64_t overdue = m_frame_num - due + 1;
+            if (overdue > overdue_max)
+            {
+                overdue_max = overdue;
+                m_view      = &view;
+            }
+        }
+
+        if (!m_view)
+            return;
+
+        // Its camera, as the main camera's is captured below (without jitter, a view has no history to resolve it with)
+        const Camera* camera                    = m_view->camera;
+        m_view_frame.view                       = camera->GetViewMatrix();
+        m_view_frame.projection                 = camera->GetProjectionMatrix();
+        m_view_frame.view_projection            = m_view_frame.view * m_view_frame.projection;
+        m_view_frame.view_projection_inv        = Matrix::Invert(m_view_frame.view_projection);
+        m_view_frame.view_projection_unjittered = m_view_frame.view_projection;
+        m_view_frame.camera_near                = camera->GetNearPlane();
+        m_view_frame.camera_far                 = camera->GetFarPlane();
+        m_view_frame.camera_position            = camera->GetTransform()->GetPosition();
+        m_view_frame.camera_direction           = camera->GetTransform()->GetForward();
+        m_view_frustum                          = camera->GetFrustum();
+    }
+
+    void Renderer::CullCamera()
+    {
+        // How many pixels a unit at a distance of one covers, levels of detail are picked by how many pixels their error would cover
+        const float fov_vertical        = m_camera ? m_camera->GetFovVerticalRad() : Helper::DegreesToRadians(90.0f);
+        const float pixels_per_unit     = m_resolution.y / (2.0f * tan(fov_vertical * 0.5f));
+        m_cull_pixels_per_unit          = pixels_per_unit;
+        const float lod_error           = lod_pixel_error * GetOptionValue<float>(Option_Value_LodBias) / pixels_per_unit;
+        const float lod_error_shadows   = lod_pixel_error * GetOptionValue<float>(Option_Value_LodBias_Shadows) / pixels_per_unit;
+        const Vector3 camera_position   = m_buffer_frame_cpu.camera_position;
+
+        // The hierarchy rejects whole groups of instances at once, the instances it lets through are tested with their own box (the leaves are fat)
+        m_cull_visible[Renderer_Object_Opaque].clear();
+        m_cull_visible[Renderer_Object_Transparent].clear();
+        m_bvh.Query(m_camera_frustum, [this](const uint32_t user_data)
+        {
+            const uint32_t object_type  = (user_data & bvh_transparent_bit) ? Renderer_Object_Transparent : Renderer_Object_Opaque;
+            const uint32_t index        = user_data & ~bvh_transparent_bit;
+            m_cull_visible[object_type].emplace_back(index);
+        });
+
+        for (uint32_t object_type = Renderer_Object_Opaque; object_type <= Renderer_Object_Transparent; object_type++)
+        {
+            vector<CullInstance>& instances = m_cull_instances[object_type];
+            vector<uint32_t>& visible       = m_cull_visible[object_type];
+
+            // Back to the original order, so the draw order doesn't depend on the shape of the tree
+            sort(visible.begin(), visible.end());
+
+            // The boxes of what the hierarchy let through, tested in a batch
+            m_cull_boxes.Clear();
+            for (const uint32_t index : visible)
+            {
+                m_cull_boxes.Add(instances[index].center, instances[index].extents);
+            }
+            m_camera_frustum.IsVisible(m_cull_boxes, m_cull_mask);
+
+            uint32_t visible_index = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(visible.size()); i++)
+            {
+                if (m_cull_mask[i])
+                {
+                    visible[visible_index++] = visible[i];
+                }
+            }
+            visible.resize(visible_index);
+
+            // Levels of detail in parallel, for every instance as the shadow passes draw instances the camera can't see
+            const uint32_t instance_count = static_cast<uint32_t>(instances.size());
+            m_threading->ParallelFor([&instances, lod_error, lod_error_shadows, camera_position](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    CullInstance& instance = instances[i];
+
+                    // Level of detail, the error is relative to the bounding box diagonal and the distance is to the closest the box can be
+                    const Renderable* renderable = instance.entity->GetRenderable();
+                    if (renderable->GeometryLodCount() > 1)
+                    {
+                        const float diagonal    = Helper::Max(instance.extents.Length() * 2.0f, Helper::M_EPSILON);
+                        const float distance    = Helper::Max(Vector3::Distance(instance.center, camera_position) - diagonal * 0.5f, 0.0f);
+                        instance.lod            = static_cast<uint8_t>(Helper::Min(renderable->GeometryLodSelect(lod_error * distance / diagonal), draw_key_lod_count - 1));
+                        instance.lod_shadow     = static_cast<uint8_t>(Helper::Min(renderable->GeometryLodSelect(lod_error_shadows * distance / diagonal), draw_key_lod_count - 1));
+                    }
+                }
+            }, instance_count, 256);
+        }
+
+        if (GetOption(Render_OcclusionCulling))
+        {
+            CullOcclusion();
+        }
+
+        m_counter_instances_visible->Add(m_cull_visible[Renderer_Object_Opaque].size() + m_cull_visible[Renderer_Object_Transparent].size());
+    }
+
+    void Renderer::CullOcclusion()
+    {
+        const vector<CullInstance>& instances_opaque    = m_cull_instances[Renderer_Object_Opaque];
+        const vector<uint32_t>& visible_opaque          = m_cull_visible[Renderer_Object_Opaque];
+        const Vector3 camera_position                   = m_buffer_frame_cpu.camera_position;
+
+        // Pick the occluders, big on screen and solid (masked materials have holes)
+        m_occluders.clear();
+        for (const uint32_t instance_index : visible_opaque)
+        {
+            const CullInstance& instance = instances_opaque[instance_index];
+            if (instance.flags & Material_Mask)
+                continue;
+
+            const float distance    = Vector3::Distance(instance.center, camera_position);
+            const float size        = instance.extents.Length() / Helper::Max(distance, m_buffer_frame_cpu.camera_near);
+            if (size >= occluder_size_min)
+            {
+                m_occluders.emplace_back(size, instance_index);
+            }
+        }
+        sort(m_occluders.begin(), m_occluders.end(), [](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b) { return a.first > b.first; });
+
+        // Rasterize them, as long as the triangle budget allows
+        m_occlusion_buffer->Begin(m_buffer_frame_cpu.view_projection_unjittered, m_buffer_frame_cpu.camera_near);
+        uint32_t triangle_count = 0;
+        for (const pair<float, uint32_t>& occluder : m_occluders)
+        {
+            Entity* entity                  = instances_opaque[occluder.second].entity;
+            const Renderable* renderable    = entity->GetRenderable();
+            const Model* model              = renderable->GeometryModel();
+
+            // Skinned meshes are posed on the gpu, their bind pose positions are not where they are drawn
+            if (model->IsVertexSkinned())
+                continue;
+
+            // Displaced chunks share a flat patch, its triangles are not where the terrain is
+            if (model->IsVertexDisplaced())
+                continue;
+
+            // Instanced renderables (foliage) are drawn at their instance transforms, not at the entity's
+            if (renderable->HasInstances())
+                continue;
+
+            const uint32_t index_count = renderable->GeometryIndexCount();
+            if (triangle_count + index_count / 3 > occluder_triangle_budget)
+                continue;
+
+            // The compact positions are enough, so an occluder whose model dropped its cpu geometry doesn't bring all of it back
+            const vector<uint32_t>& model_indices   = model->GetIndices();
+            const vector<Vector3>& model_positions  = model->GetPositions();
+            if (renderable->GeometryIndexOffset() + index_count > model_indices.size())
+                continue;
+
+            const Vector3* positions    = model_positions.data() + renderable->GeometryVertexOffset();
+            const uint32_t* indices     = model_indices.data() + renderable->GeometryIndexOffset();
+            m_occlusion_buffer->Rasterize(positions, indices, index_count, entity->GetTransform()->GetMatrixRender());
+            triangle_count += index_count / 3;
+        }
+        m_occlusion_buffer->End();
+
+        // Test what the frustum let through, occluders don't hide themselves since their box is in front of their triangles
+        for (uint32_t object_type = Renderer_Object_Opaque; object_type <= Renderer_Object_Transparent; object_type++)
+        {
+            const vector<CullInstance>& instances   = m_cull_instances[object_type];
+            vector<uint32_t>& visible               = m_cull_visible[object_type];
+
+            const uint32_t visible_count = static_cast<uint32_t>(visible.size());
+            m_cull_mask.resize(visible_count);
+            m_threading->ParallelFor([this, &instances, &visible](uint32_t start, uint32_t end)
+            {
+                for (uint32_t i = start; i < end; i++)
+                {
+                    const CullInstance& instance = instances[visible[i]];
+                    m_cull_mask[i] = m_occlusion_buffer->IsVisible(instance.center, instance.extents) ? 1 : 0;
+                }
+            }, visible_count, 256);
+
+            uint32_t visible_index = 0;
+            for (uint32_t i = 0; i < visible_count; i++)
+            {
+                if (m_cull_mask[i])
+                {
+                    visible[visible_index++] = visible[i];
+                }
+            }
+            visible.resize(visible_index);
+        }
+    }
+
+    bool Renderer::IsLightVisible(const Light* light) const
+    {
+        if (!light->IsVisible(m_camera_frustum))
+            return false;
+
+        // The occlusion buffer is only built while occlusion culling is on
+        if (!GetOption(Render_OcclusionCulling) || light->GetLightType() == LightType_Directional)
+            return true;
+
+        Vector3 center;
+        Vector3 extents;
+        light->GetBoundingBox(center, extents);
+
+        return m_occlusion_buffer->IsVisible(center, extents);
+    }
+
+    bool Renderer::DrawMeshlets(RHI_CommandList* cmd_list, const Renderable* renderable, const Matrix& transform, const uint32_t lod, const Light* light, const uint32_t array_index, const uint32_t instance_offset)
+    {
+        const vector<Geometry_Meshlet>& meshlets = renderable->GeometryMeshlets();
+        if (meshlets.size() < 2 || lod != 0 || renderable->HasInstances())
+            return false;
+
+        const Model* model = renderable->GeometryModel();
+        if (!model || model->IsVertexSkinned() || model->IsVertexDisplaced())
+            return false;
+
+        // The cone test is done in model space, where the meshlets are, facing is kept by any transform which doesn't mirror
+        const Vector3 axis_x(transform.m00, transform.m01, transform.m02);
+        const Vector3 axis_y(transform.m10, transform.m11, transform.m12);
+        const Vector3 axis_z(transform.m20, transform.m21, transform.m22);
+        const bool cone_test    = Vector3::Dot(Vector3::Cross(axis_x, axis_y), axis_z) > 0.0f;
+        const float scale       = Helper::Max(Helper::Max(axis_x.Length(), axis_y.Length()), axis_z.Length());
+
+        // Directional lights look along their direction, everything else from a point
+        const bool orthographic = light && light->GetLightType() == LightType_Directional;
+        Vector3 view_model;
+        if (cone_test)
+        {
+            const Matrix transform_inverted = transform.Inverted();
+            if (orthographic)
+            {
+                view_model = (light->GetDirectionRender() * transform_inverted - Vector3::Zero * transform_inverted).Normalized();
+            }
+            else
+            {
+                view_model = (light ? light->GetPositionRender() : m_buffer_frame_cpu.camera_position) * transform_inverted;
+            }
+        }
+
+        // Runs of visible meshlets are drawn at once, a run ends where a culled meshlet is
+        const uint32_t vertex_offset    = renderable->GeometryVertexOffset();
+        uint32_t run_offset             = 0;
+        uint32_t run_count              = 0;
+        uint32_t culled_count           = 0;
+        for (const Geometry_Meshlet& meshlet : meshlets)
+        {
+            bool visible = true;
+
+            if (cone_test && meshlet.cone_cutoff < 1.0f)
+            {
+                if (orthographic)
+                {
+                    visible = Vector3::Dot(view_model, meshlet.cone_axis) < meshlet.cone_cutoff;
+                }
+                else
+                {
+                    const Vector3 to_center = meshlet.center - view_model;
+                    visible = Vector3::Dot(to_center, meshlet.cone_axis) < meshlet.cone_cutoff * to_center.Length() + meshlet.radius;
+                }
+            }
+
+            if (visible)
+            {
+                const Vector3 center    = meshlet.center * transform;
+                const Vector3 extents   = Vector3(meshlet.radius * scale);
+                visible = light ? light->IsInViewFrustrum(center, extents, array_index) : m_camera_frustum.IsVisible(center, extents);
+            }
+
+            if (visible)
+            {
+                if (run_count != 0 && run_offset + run_count == meshlet.index_offset)
+                {
+                    run_count += meshlet.index_count;
+                    continue;
+                }
+
+                if (run_count != 0)
+                {
+                    cmd_list->DrawIndexed(run_count, run_offset, vertex_offset, 1, instance_offset);
+                }
+                run_offset  = meshlet.index_offset;
+                run_count   = meshlet.index_count;
+            }
+            else
+            {
+                culled_count++;
+            }
+        }
+
+        if (run_count != 0)
+        {
+            cmd_list->DrawIndexed(run_count, run_offset, vertex_offset, 1, instance_offset);
+        }
+
+        m_counter_meshlets_culled->Add(culled_count);
+
+        return true;
+    }
+
+    const shared_ptr<Spartan::RHI_Texture>& Renderer::GetEnvironmentTexture()
+    {
+        return m_tex_environment ? m_tex_environment : m_tex_white;
+    }
+
+    void Renderer::SetEnvironmentTexture(const shared_ptr<RHI_Texture>& texture)
+    {
+        m_tex_environment = texture;
+
+        // Prefilter the new environment on the next frame
+        m_environment_prefiltered = false;
+    }
+
+	void Renderer::SetOption(Renderer_Option option, bool enable)
 	{
         if (enable && !GetOption(option))
         {
@@ -671,6 +2599,13 @@ namespace Spartan
         {
             return;
         }
+        m_idle_wake = true;
+
+        // The G-Buffer layout decides the format of the normal targets
+        if (option == Render_GBuffer_Compact)
+        {
+            CreateRenderTextures();
+        }
 	}
 
     void Renderer::SetOptionValue(Renderer_Option_Value option, float value)
@@ -686,11 +2621,20 @@ namespace Spartan
         {
             value = Helper::Clamp(value, static_cast<float>(m_resolution_shadow_min), static_cast<float>(m_rhi_device->GetContextRhi()->max_texture_dimension_2d));
         }
+        else if (option == Option_Value_ScreenSpaceScale)
+        {
+            value = value >= 4.0f ? 4.0f : (value >= 2.0f ? 2.0f : 1.0f);
+        }
+        else if (option == Option_Value_ResolutionScale || option == Option_Value_PreviewScale)
+        {
+            value = Helper::Clamp(value, _Renderer::dynamic_resolution_scale_min, 1.0f);
+        }
 
         if (m_option_values[option] == value)
             return;
 
         m_option_values[option] = value;
+        m_idle_wake             = true;
 
         // Shadow resolution handling
         if (option == Option_Value_ShadowResolution)
@@ -705,6 +2649,199 @@ namespace Spartan
                 }
             }
         }
+
+        // The render targets are sized by the scales
+        if (option == Option_Value_ScreenSpaceScale || option == Option_Value_ResolutionScale || (option == Option_Value_PreviewScale && m_preview_active))
+        {
+            CreateRenderTextures();
+        }
+    }
+
+    void Renderer::UpdateDynamicResolution()
+    {
+        // The GPU time of preview frames says nothing about the full resolution
+        if (!GetOption(Render_DynamicResolution) || m_preview_active)
+            return;
+
+        if (m_dynamic_resolution_cooldown != 0)
+        {
+            m_dynamic_resolution_cooldown--;
+            return;
+        }
+
+        const float time_gpu    = m_profiler->GetTimeGpuLast();
+        const float time_target = GetOptionValue<float>(Option_Value_DynamicResolution_TargetMs);
+        if (time_gpu <= 0.0f || time_target <= 0.0f)
+            return;
+
+        // Hysteresis, a few frames over the target are enough to go down but going up takes a long run of frames with headroom
+        m_dynamic_resolution_frames_over    = time_gpu > time_target ? m_dynamic_resolution_frames_over + 1 : 0;
+        m_dynamic_resolution_frames_under   = time_gpu < time_target * _Renderer::dynamic_resolution_headroom ? m_dynamic_resolution_frames_under + 1 : 0;
+
+        const float scale   = GetOptionValue<float>(Option_Value_ResolutionScale);
+        float scale_new     = scale;
+        if (m_dynamic_resolution_frames_over >= _Renderer::dynamic_resolution_frames_down)
+        {
+            // Most of the GPU time scales with the pixel count, so the scale goes with the square root of the time ratio
+            scale_new = Helper::Min(scale * sqrt(time_target / time_gpu), scale - _Renderer::dynamic_resolution_scale_step);
+        }
+        else if (m_dynamic_resolution_frames_under >= _Renderer::dynamic_resolution_frames_up)
+        {
+            scale_new = scale + _Renderer::dynamic_resolution_scale_step;
+        }
+
+        scale_new = round(scale_new / _Renderer::dynamic_resolution_scale_step) * _Renderer::dynamic_resolution_scale_step;
+        scale_new = Helper::Clamp(scale_new, _Renderer::dynamic_resolution_scale_min, 1.0f);
+        if (scale_new == scale)
+            return;
+
+        SetOptionValue(Option_Value_ResolutionScale, scale_new);
+        m_dynamic_resolution_frames_over    = 0;
+        m_dynamic_resolution_frames_under   = 0;
+        m_dynamic_resolution_cooldown       = _Renderer::dynamic_resolution_cooldown;
+    }
+
+    void Renderer::UpdatePreviewResolution()
+    {
+        const bool enabled      = GetOptionValue<float>(Option_Value_PreviewScale) < 1.0f && !m_context->m_engine->EngineMode_IsSet(Engine_Game);
+        m_preview_frames_left   = (enabled && m_camera_moved) ? _Renderer::preview_frames_settle : (m_preview_frames_left > 0 ? m_preview_frames_left - 1 : 0);
+
+        const bool active = enabled && m_preview_frames_left != 0;
+        if (active == m_preview_active)
+            return;
+
+        m_preview_active = active;
+        CreateRenderTextures();
+    }
+
+    void Renderer::TextureStreaming()
+    {
+        const uint64_t budget = static_cast<uint64_t>(GetOptionValue<float>(Option_Value_TextureStreamingBudget)) * 1024 * 1024;
+
+        // Take the requests of the last frame, a texture which nothing asked for in a while goes back to its initial mips
+        uint64_t size = 0;
+        for (auto it = m_textures_streamed.begin(); it != m_textures_streamed.end();)
+        {
+            shared_ptr<RHI_Texture> texture = it->second.texture.lock();
+            if (!texture)
+            {
+                it = m_textures_streamed.erase(it);
+                continue;
+            }
+
+            TextureStreamed& streamed       = it->second;
+            const uint32_t mip_resident     = texture->GetMipResident();
+            const uint32_t mip_requested    = texture->StreamingRequestTake();
+            if (mip_requested != RHI_Texture::mip_requested_none)
+            {
+                streamed.frame_seen = m_frame_num;
+
+                // Detail drops with a mip of slack, so that a texture which is between two mips doesn't keep streaming
+                const bool change   = mip_requested < mip_resident || mip_requested > mip_resident + 1;
+                streamed.mip_target = change ? Helper::Min(mip_requested, texture->GetMipResidentMax()) : mip_resident;
+            }
+            else
+            {
+                const bool unseen   = m_frame_num - streamed.frame_seen > _Renderer::texture_streaming_frames_unseen;
+                streamed.mip_target = unseen ? Helper::Max(mip_resident, texture->GetMipInitial()) : mip_resident;
+            }
+
+            size += texture->GetSizeGpu(streamed.mip_target);
+            it++;
+        }
+
+        // Over the budget, the textures which take the most drop a mip, until everything fits (each mip a texture drops saves three quarters)
+        if (size > budget)
+        {
+            vector<pair<uint64_t, TextureStreamed*>> heap;
+            heap.reserve(m_textures_streamed.size());
+            for (auto& it : m_textures_streamed)
+            {
+                heap.emplace_back(it.first->GetSizeGpu(it.second.mip_target), &it.second);
+            }
+            make_heap(heap.begin(), heap.end());
+
+            while (size > budget && !heap.empty())
+            {
+                pop_heap(heap.begin(), heap.end());
+                TextureStreamed* streamed   = heap.back().second;
+                const uint64_t size_target  = heap.back().first;
+                heap.pop_back();
+
+                shared_ptr<RHI_Texture> texture = streamed->texture.lock();
+                if (streamed->mip_target >= texture->GetMipResidentMax())
+                    continue;
+
+                streamed->mip_target++;
+                const uint64_t size_coarser = texture->GetSizeGpu(streamed->mip_target);
+                size -= size_target - size_coarser;
+
+                heap.emplace_back(size_coarser, streamed);
+                push_heap(heap.begin(), heap.end());
+            }
+        }
+
+        // Drop detail first, that frees memory for what streams in, then stream in what gains the most mips
+        m_textures_streamed_changed.clear();
+        for (auto& it : m_textures_streamed)
+        {
+            if (it.second.mip_target != it.first->GetMipResident())
+            {
+                m_textures_streamed_changed.emplace_back(&it.second);
+            }
+        }
+        m_counter_stream_queue->Set(m_textures_streamed_changed.size());
+
+        if (m_textures_streamed_changed.empty())
+            return;
+
+        const auto order = [](const TextureStreamed* streamed)
+        {
+            const int32_t gain = static_cast<int32_t>(streamed->texture.lock()->GetMipResident()) - static_cast<int32_t>(streamed->mip_target);
+            return gain < 0 ? INT32_MIN : -gain;
+        };
+        sort(m_textures_streamed_changed.begin(), m_textures_streamed_changed.end(), [&order](const TextureStreamed* a, const TextureStreamed* b) { return order(a) < order(b); });
+
+        uint64_t uploaded = 0;
+        for (TextureStreamed* streamed : m_textures_streamed_changed)
+        {
+            shared_ptr<RHI_Texture> texture = streamed->texture.lock();
+            const bool streams_in           = streamed->mip_target < texture->GetMipResident();
+            if (streams_in && uploaded != 0 && uploaded + texture->GetSizeGpu(streamed->mip_target) > _Renderer::texture_streaming_upload_max)
+                break;
+
+            if (!texture->StreamMips(streamed->mip_target))
+            {
+                // Don't try again every frame
+                streamed->mip_target = texture->GetMipResident();
+                continue;
+            }
+
+            uploaded += streams_in ? texture->GetSizeGpu(streamed->mip_target) : 0;
+        }
+    }
+
+    void Renderer::TextureStreamingRequest(Material* material, const float pixels)
+    {
+        // The texture is assumed to cover the object once, so the object's size on screen is the texture's size it needs
+        for (const shared_ptr<RHI_Texture>& texture_shared : material->GetTextures())
+        {
+            RHI_Texture* texture = texture_shared.get();
+            if (!texture || !texture->IsStreamed())
+                continue;
+
+            const float texels  = static_cast<float>(Helper::Max(texture->GetWidth(), texture->GetHeight()));
+            const uint32_t mip  = pixels >= texels ? 0 : static_cast<uint32_t>(log2(texels / Helper::Max(pixels, 1.0f)));
+            texture->StreamingRequest(mip);
+
+            TextureStreamed& streamed = m_textures_streamed[texture];
+            if (streamed.texture.expired())
+            {
+                streamed.texture    = texture_shared;
+                streamed.frame_seen = m_frame_num;
+                streamed.mip_target = texture->GetMipResident();
+            }
+        }
     }
 
     bool Renderer::Present()
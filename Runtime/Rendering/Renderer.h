@@ -25,13 +25,19 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unordered_map>
 #include <array>
 #include <atomic>
+#include <mutex>
 #include "Renderer_ConstantBuffers.h"
 #include "Material.h"
 #include "../Core/ISubsystem.h"
 #include "../Math/Rectangle.h"
+#include "../Math/Frustum.h"
+#include "../Math/BoundingVolumeHierarchy.h"
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Viewport.h"
 #include "../RHI/RHI_Vertex.h"
+#include "../Utilities/Hash.h"
+#include "../Input/Input.h"
+#include "../World/Components/Camera.h"
 //===================================
 
 namespace Spartan
@@ -40,12 +46,20 @@ namespace Spartan
 	class Entity;
 	class Camera;
 	class Light;
+	class ReflectionProbe;
+	class Renderable;
+	class Model;
 	class ResourceCache;
 	class Font;
 	class Variant;
 	class Grid;
 	class Transform_Gizmo;
 	class Profiler;
+	class Threading;
+	class Task;
+	class RenderGraph;
+	class OcclusionBuffer;
+    struct Counter;
 
 	namespace Math
 	{
@@ -77,7 +91,15 @@ namespace Spartan
 		Render_ChromaticAberration	    = 1 << 19,
 		Render_Dithering			    = 1 << 20,
         Render_ReverseZ                 = 1 << 21,
-        Render_DepthPrepass             = 1 << 22
+        Render_DepthPrepass             = 1 << 22,
+        Render_OcclusionCulling         = 1 << 23,
+        Render_DynamicResolution        = 1 << 24, // Adjusts Option_Value_ResolutionScale to meet Option_Value_DynamicResolution_TargetMs
+        Render_GBuffer_Compact          = 1 << 25, // Octahedral encoded normals and the material id in a 32-bit normal target (instead of 64-bit)
+        Render_Idle                     = 1 << 26, // Outside of game mode, frames are skipped (and the timer paces at its idle fps) while the world, the camera and the input don't change
+        Render_TransparentOit           = 1 << 27, // Weighted blended order independent transparency, instead of drawing transparent objects back to front
+        Render_VariableRateShading      = 1 << 28, // The light, composition and post-processing passes shade flat, fast moving and peripheral tiles at a coarser rate (if the GPU supports it)
+        Render_AutoExposure             = 1 << 29, // The exposure adapts to the luminance histogram of the frame, Option_Value_Exposure is added to it as compensation
+        Render_CameraLateLatch          = 1 << 30  // Right before the frame's matrices are uploaded, the camera's mouse look is turned by the mouse motion which arrived since the snapshot
 	};
 
     enum Renderer_Option_Value
@@ -90,7 +112,15 @@ namespace Spartan
         Option_Value_Bloom_Intensity,
         Option_Value_Sharpen_Strength,
         Option_Value_Sharpen_Clamp, // Limits maximum amount of sharpening a pixel receives - Algorithm's default: 0.035f
-        Option_Value_Motion_Blur_Intensity
+        Option_Value_Motion_Blur_Intensity,
+        Option_Value_ShadowSliceBudget, // How many shadow map slices with changed casters get re-rendered per frame, zero means all of them
+        Option_Value_LodBias,           // Scales the screen space error (in pixels) a level of detail may have, higher picks coarser levels
+        Option_Value_LodBias_Shadows,   // Same, for the shadow passes
+        Option_Value_ScreenSpaceScale,  // Resolution divisor of HBAO and SSR, 1 (full), 2 (half) or 4 (quarter), the results are upsampled with a depth-aware filter
+        Option_Value_ResolutionScale,   // Fraction of the output resolution everything up to the post-processing is rendered at, 0.5 to 1
+        Option_Value_DynamicResolution_TargetMs, // The GPU time (in ms) dynamic resolution aims for
+        Option_Value_TextureStreamingBudget,    // The GPU memory (in MB) streamed textures may take, the least needed mips are dropped to stay within it
+        Option_Value_PreviewScale               // Resolution scale used while the camera moves outside of game mode (1 disables it), the full resolution returns once it rests
     };
 
     enum Renderer_ToneMapping_Type
@@ -106,21 +136,55 @@ namespace Spartan
 		Renderer_Object_Opaque,
 		Renderer_Object_Transparent,
         Renderer_Object_Light,
-		Renderer_Object_Camera
+		Renderer_Object_Camera,
+        Renderer_Object_ParticleEmitter,
+        Renderer_Object_Decal,
+        Renderer_Object_ReflectionProbe
 	};
 
 	enum Renderer_Shader_Type
 	{
 		Shader_Gbuffer_V,
+        Shader_Gbuffer_Instanced_V,
+        Shader_Gbuffer_Compact_V,
+        Shader_Gbuffer_Compact_Instanced_V,
+        Shader_Gbuffer_Skinned_V,
+        Shader_Gbuffer_Skinned_Instanced_V,
+        Shader_Gbuffer_Displaced_V,
+        Shader_Gbuffer_Displaced_Instanced_V,
         Shader_Gbuffer_P,
+        Shader_Impostor_V,
+        Shader_Impostor_P,
+        Shader_Impostor_Bake_V,
+        Shader_Impostor_Bake_Compact_V,
+        Shader_Impostor_Bake_P,
+        Shader_Particle_V,
+        Shader_Particle_P,
 		Shader_Depth_V,
+        Shader_Depth_Instanced_V,
+        Shader_Depth_Compact_V,
+        Shader_Depth_Compact_Instanced_V,
+        Shader_Depth_Skinned_V,
+        Shader_Depth_Skinned_Instanced_V,
+        Shader_Depth_Position_V,
+        Shader_Depth_Position_Instanced_V,
+        Shader_Depth_Layered_V,
+        Shader_Depth_Compact_Layered_V,
+        Shader_Depth_Skinned_Layered_V,
+        Shader_Depth_Position_Layered_V,
+        Shader_Depth_Displaced_Instanced_V,
+        Shader_Depth_Displaced_Layered_V,
         Shader_Depth_P,
+        Shader_Depth_AlphaTest_P,
 		Shader_Quad_V,
 		Shader_Texture_P,
+        Shader_TransparentResolve_P,
         Shader_Copy_C,
+        Shader_AutoExposure_C,
 		Shader_Fxaa_P,
 		Shader_Luma_P,
 		Shader_Taa_P,
+        Shader_Taa_Upscale_P,
 		Shader_MotionBlur_P,
 		Shader_Sharpen_Luma_P,
 		Shader_ChromaticAberration_P,	
@@ -130,7 +194,9 @@ namespace Spartan
 		Shader_ToneMapping_P,
 		Shader_GammaCorrection_P,
 		Shader_Dithering_P,
+        Shader_PostProcess_Fused_P,
 		Shader_Upsample_P,
+        Shader_Upsample_Bilateral_P,
         Shader_Downsample_P,
 		Shader_DebugNormal_P,
 		Shader_DebugVelocity_P,
@@ -138,17 +204,35 @@ namespace Spartan
         Shader_DebugChannelA_P,
         Shader_DebugChannelRgbGammaCorrect_P,
         Shader_BrdfSpecularLut,
+        Shader_EnvironmentPrefilter_Specular_P,
+        Shader_EnvironmentPrefilter_Diffuse_P,
+        Shader_ReflectionProbe_Project_P,
         Shader_Light_P,
+        Shader_VolumetricInject_Directional_P,
+        Shader_VolumetricInject_Point_P,
+        Shader_VolumetricInject_Spot_P,
+        Shader_VolumetricTemporal_P,
+        Shader_VolumetricIntegrate_P,
+        Shader_ScreenSpaceShadows_P,
+        Shader_ShadingRate_P,
 		Shader_Composition_P,
         Shader_Composition_IndirectBounce_P,
 		Shader_Color_V,
         Shader_Color_P,
+        Shader_Color_Instanced_V,
+        Shader_Grid_V,
+        Shader_Grid_P,
 		Shader_Font_V,
         Shader_Font_P,
+        Shader_Font_Sdf_P,
 		Shader_Hbao_P,
         Shader_Hbao_IndirectBounce_P,
         Shader_Ssr_P,
+        Shader_DepthNormal_Downsample_P,
 		Shader_Entity_V,
+        Shader_Entity_Compact_V,
+        Shader_Entity_Skinned_V,
+        Shader_Entity_Transform_V,
         Shader_Entity_Transform_P,
 		Shader_BlurBox_P,
 		Shader_BlurGaussian_P,
@@ -178,6 +262,17 @@ namespace Spartan
         RenderTarget_Ssr                            = 1 << 17,
         RenderTarget_Ssgi                           = 1 << 18,
         RenderTarget_TaaHistory                     = 1 << 19,
+        RenderTarget_Gbuffer_Depth_Downsampled      = 1 << 20,
+        RenderTarget_Gbuffer_Normal_Downsampled     = 1 << 21,
+        RenderTarget_Hbao_Downsampled               = 1 << 22,
+        RenderTarget_Ssr_Downsampled                = 1 << 23,
+        RenderTarget_Transparent_Accumulation       = 1 << 24,
+        RenderTarget_Transparent_Weight             = 1 << 25,
+        RenderTarget_Volumetric_Scattering          = 1 << 26,
+        RenderTarget_Volumetric_History             = 1 << 27,
+        RenderTarget_Volumetric_History_2           = 1 << 28,
+        RenderTarget_ScreenSpaceShadows             = 1 << 29,
+        RenderTarget_ShadingRate                    = 1 << 30,
     };
 
 	class SPARTAN_CLASS Renderer : public ISubsystem
@@ -191,10 +286,16 @@ namespace Spartan
 		void Tick(float delta_time) override;
 		//===================================
 
+        // Captures everything the next frame reads from the simulation. Tick() does this by itself, unless it
+        // was already done this frame, which is what allows the simulation to move on while a frame is being recorded.
+        void Snapshot();
+
 		#define DebugColor Math::Vector4(0.41f, 0.86f, 1.0f, 1.0f)
 		void DrawLine(const Math::Vector3& from, const Math::Vector3& to, const Math::Vector4& color_from = DebugColor, const Math::Vector4& color_to = DebugColor, bool depth = true);
+        // A line list (two vertices per line), debug drawers which produce many lines hand them over at once
+        void DrawLines(const RHI_Vertex_PosCol* vertices, uint32_t vertex_count, bool depth = true);
         void DrawRectangle(const Math::Rectangle& rectangle, const Math::Vector4& color = DebugColor, bool depth = true);
-		void DrawBox(const Math::BoundingBox& box, const Math::Vector4& color = DebugColor, bool depth = true);
+		void DrawBox(const Math::BoundingBox& box, const Math::Vector4& color = DebugColor, bool depth = true); // an instance of a unit box, not lines
 
 		// Viewport
 		const RHI_Viewport& GetViewport() const	{ return m_viewport; }
@@ -203,6 +304,8 @@ namespace Spartan
 
         // Resolution
         const Math::Vector2& GetResolution() const { return m_resolution; }
+        // The resolution of the G-Buffer and lighting targets, the resolution scaled by Option_Value_ResolutionScale
+        const Math::Vector2& GetResolutionRender() const { return m_resolution_render; }
         void SetResolution(uint32_t width, uint32_t height);
 
 		// Editor
@@ -241,15 +344,41 @@ namespace Spartan
         // Misc
         const std::shared_ptr<RHI_Device>& GetRhiDevice()   const { return m_rhi_device; } 
         RHI_PipelineCache* GetPipelineCache()               const { return m_pipeline_cache.get(); }
+        RenderGraph* GetRenderGraph()                       const { return m_render_graph.get(); }
         RHI_DescriptorCache* GetDescriptorCache()           const { return m_descriptor_cache.get(); }
         RHI_Texture* GetFrameTexture()                      const { return m_render_targets.at(RenderTarget_Composition_Ldr).get(); }
         auto GetFrameNum()                                  const { return m_frame_num; }
         const auto& GetCamera()                             const { return m_camera; }
         auto IsInitialized()                                const { return m_initialized; }
         auto& GetShaders()                                  const { return m_shaders; }
+        bool AreShadersCompiled()                           const { return m_shaders_compiling.empty(); }
+        void WaitForShaders(); // blocks until the start-up shaders are compiled, Event_Shaders_Compiled fires when they are
         bool IsRendering()                                  const { return m_is_rendering; }
+        bool IsIdle()                                       const { return m_is_idle && !m_idle_wake; } // see Render_Idle
+        void WakeUp()                                             { m_idle_wake = true; } // renders the next frames, for changes which the renderer can't see
+        void SetViewportVisible(bool visible)                     { m_idle_wake = m_idle_wake || (visible && !m_viewport_visible); m_viewport_visible = visible; } // with Render_Idle, nothing renders while the output isn't shown (outside of game mode)
         uint32_t GetMaxResolution() const;
 
+        // Registry, the components which the renderer draws register themselves when they are added and unregister when they are removed
+        void RegistryAdd(Entity* entity, const Renderer_Object_Type object_type);
+        void RegistryRemove(Entity* entity, const Renderer_Object_Type object_type);
+        void RegistryClassify(Entity* entity);                          // moves a renderable between the opaque and the transparent list
+        void RegistryClassify(const Material* material);                // the same, for every renderable which uses the material
+        void RegistryRelease(const std::shared_ptr<Entity>& entity);    // unregisters an entity which leaves the world, it's kept alive until no frame records it
+
+        // Spatial queries, over the bounding boxes of the drawable entities as of the last snapshot
+        void Query(const Math::Frustum& frustum, std::vector<Entity*>& entities) const;
+        void Query(const Math::Vector3& center, float radius, std::vector<Entity*>& entities) const;
+        void Query(const Math::BoundingBox& box, std::vector<Entity*>& entities) const;
+        void Query(const Math::Ray& ray, std::vector<Entity*>& entities) const;
+
+        // Views, cameras besides the main one which render into textures of their own (minimaps, monitors, split-screen). They share the frame's
+        // culling hierarchy, shadow maps and material table, and are shaded forward at a fraction of the render resolution (with the main aspect ratio).
+        // The most overdue view renders once a frame, and a view waits at least its update interval (in frames) between renders.
+        void ViewAdd(Entity* camera_entity, float resolution_scale = 0.5f, uint32_t update_interval = 1);
+        void ViewRemove(Entity* camera_entity);
+        std::shared_ptr<RHI_Texture> GetViewTexture(Entity* camera_entity); // null until the view renders
+
         // Globals
         void SetGlobalShaderObjectTransform(RHI_CommandList* cmd_list, const Math::Matrix& transform);
         void SetGlobalSamplersAndConstantBuffers(RHI_CommandList* cmd_list) const;
@@ -263,20 +392,53 @@ namespace Spartan
 		void CreateBlendStates();
 		void CreateFonts();
 		void CreateTextures();
+		void CreateTexturesGizmo();
 		void CreateShaders();
 		void CreateSamplers();
 		void CreateRenderTextures();
 
+        // Picks the resolution scale which keeps the GPU time within the target
+        void UpdateDynamicResolution();
+        // Drops to Option_Value_PreviewScale while the camera moves
+        void UpdatePreviewResolution();
+
+        // Texture streaming, the G-Buffer passes request the mips which the textures of what they draw need (by its size on screen),
+        // then before the next frame is recorded the textures stream them in (or drop the ones nobody needs) within Option_Value_TextureStreamingBudget
+        struct TextureStreamed
+        {
+            std::weak_ptr<RHI_Texture> texture;
+            uint64_t frame_seen     = 0;
+            uint32_t mip_target     = 0;
+        };
+        void TextureStreaming();
+        void TextureStreamingRequest(Material* material, float pixels);
+        std::unordered_map<RHI_Texture*, TextureStreamed> m_textures_streamed;
+        std::vector<TextureStreamed*> m_textures_streamed_changed;
+
 		// Passes
 		void Pass_Main(RHI_CommandList* cmd_list);
 		void Pass_LightDepth(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type);
-        void Pass_DepthPrePass(RHI_CommandList* cmd_list);
+        struct DrawList;
+        bool Pass_DepthPrePass(RHI_CommandList* cmd_list, const DrawList& draw_list, const uint32_t instance_offset); // returns true if it wrote the depth of the g-buffer's batches
 		void Pass_GBuffer(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type);
+        void Pass_DepthNormalDownsample(RHI_CommandList* cmd_list);
 		void Pass_Hbao(RHI_CommandList* cmd_list, const bool use_stencil);
         void Pass_Ssr(RHI_CommandList* cmd_list, const bool use_stencil);
         void Pass_Light(RHI_CommandList* cmd_list, const bool use_stencil);
+        bool Pass_ScreenSpaceShadows(RHI_CommandList* cmd_list);
+        void Pass_VolumetricLighting(RHI_CommandList* cmd_list);
+        void Pass_ShadingRate(RHI_CommandList* cmd_list);
+        // The shading rate image, if a pass which renders to the given target should use it
+        RHI_Texture* GetShadingRateTexture(const RHI_Texture* tex_out) const;
+
+        // Volumetric lighting froxels, the depth slices are laid out as tiles of a 2D atlas
+        static const uint32_t m_froxel_count_x          = 160; // must match the shader
+        static const uint32_t m_froxel_count_y          = 90;  // must match the shader
+        static const uint32_t m_froxel_count_z          = 64;  // must match the shader
+        static const uint32_t m_froxel_atlas_tiles_x    = 8;   // must match the shader
 		void Pass_Composition(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_out, const bool use_stencil);
         void Pass_AlphaBlend(RHI_CommandList* cmd_list, RHI_Texture* tex_in, RHI_Texture* tex_out, const bool use_stencil);
+        void Pass_TransparentResolve(RHI_CommandList* cmd_list, RHI_Texture* tex_out);
 		void Pass_PostProcess(RHI_CommandList* cmd_list);
 		void Pass_TAA(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
 		bool Pass_DebugBuffer(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_out);
@@ -287,18 +449,34 @@ namespace Spartan
 		void Pass_ChromaticAberration(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
 		void Pass_MotionBlur(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
 		void Pass_Dithering(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
+        void Pass_PostProcessFused(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out, const uint32_t flags);
+        void Pass_AutoExposure(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in);
 		void Pass_Bloom(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
         void Pass_Upsample(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
+        void Pass_UpsampleBilateral(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out, RHI_Texture* tex_depth_in, const bool use_stencil);
         void Pass_Downsample(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out, const Renderer_Shader_Type pixel_shader);
+        void Pass_DownsampleChain(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::vector<std::shared_ptr<RHI_Texture>>& mips, const uint32_t mip_count, const Renderer_Shader_Type pixel_shader_first, const Renderer_Shader_Type pixel_shader);
 		void Pass_BlurBox(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out, const float sigma, const float pixel_stride, const bool use_stencil);
 		void Pass_BlurGaussian(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out, const float sigma, const float pixel_stride = 1.0f);
 		void Pass_BlurBilateralGaussian(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out, const float sigma, const float pixel_stride = 1.0f, const bool use_stencil = false);
+        void Pass_Particles(RHI_CommandList* cmd_list);
+        void Pass_Decals(RHI_CommandList* cmd_list);
+        void Pass_MaterialArray(RHI_CommandList* cmd_list);
 		void Pass_Lines(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_out);
         void Pass_Outline(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_out);
 		void Pass_Icons(RHI_CommandList* cmd_list, RHI_Texture* tex_out);
         void Pass_TransformHandle(RHI_CommandList* cmd_list, RHI_Texture* tex_out);
 		void Pass_Text(RHI_CommandList* cmd_list, RHI_Texture* tex_out);
         void Pass_BrdfSpecularLut(RHI_CommandList* cmd_list);
+        void Pass_EnvironmentPrefilter(RHI_CommandList* cmd_list);
+
+        // The prefiltered environment, a slice per roughness level followed by the irradiance
+        static const uint32_t m_environment_slices_specular = 6; // must match the shader
+
+        void Pass_ImpostorBake(RHI_CommandList* cmd_list);
+        void Pass_View(RHI_CommandList* cmd_list);
+        bool Pass_Forward(RHI_CommandList* cmd_list, RHI_ConstantBuffer* buffer_frame, const BufferFrame& frame, const Math::Frustum& frustum, float pixels_per_unit, RHI_Texture* tex_color, uint32_t tex_color_array_index, RHI_Texture* tex_depth, const Entity* entity_excluded, const Math::Vector4& clear_color, const char* pass_name);
+        void Pass_ReflectionProbes(RHI_CommandList* cmd_list);
         void Pass_Copy(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
         void Pass_Copy_CS(RHI_CommandList* cmd_list, std::shared_ptr<RHI_Texture>& tex_in, std::shared_ptr<RHI_Texture>& tex_out);
 
@@ -307,26 +485,46 @@ namespace Spartan
         bool UpdateMaterialBuffer();
         bool UpdateUberBuffer(RHI_CommandList* cmd_list);
         bool UpdateObjectBuffer(RHI_CommandList* cmd_list);
-        bool UpdateLightBuffer(const Light* light);
+        bool UpdateDrawBuffer(RHI_CommandList* cmd_list); // once the render pass began, it needs the pipeline
+        bool UpdateSkinBuffer(RHI_CommandList* cmd_list, const Renderable* renderable);
+        bool UpdateLightBuffer();
+        bool UpdateLightClusterBuffer();
+        uint32_t GetLightIndex(const Light* light) const; // into the light buffer, m_max_lights if the light isn't in it
+        bool UpdateDecalBuffer();
+        bool UpdateReflectionProbeBuffer();
+        // Cluster binning, shared by the lights and the decals
+        void ClusterSlices(float& slice_scale, float& slice_bias) const;
+        void ClusterBin(uint32_t* masks, const Math::Vector3& position, float range, uint32_t index) const;
+
+        // Tracks the start-up shader batch, reports its progress and fires Event_Shaders_Compiled once it's done
+        void ShadersCompilingTick();
+        std::vector<std::shared_ptr<Task>> m_shaders_compiling;
 
         // Misc
         void RenderablesAcquire(const Variant& renderables);
-        void RenderablesSort(std::vector<Entity*>* renderables);
+        void RenderablesSort(std::vector<Entity*>* renderables, const Camera* camera);
         void ClearEntities();
 
+        // Registry, these expect m_entities_mutex to be locked
+        void RegistryInsert(Entity* entity, const Renderer_Object_Type object_type);
+        bool RegistryErase(Entity* entity, const Renderer_Object_Type object_type);
+        void RegistryPublish();
+
         // Render textures
         std::unordered_map<Renderer_RenderTarget_Type, std::shared_ptr<RHI_Texture>> m_render_targets;
+        std::unique_ptr<RenderGraph> m_render_graph;
         std::vector<std::shared_ptr<RHI_Texture>> m_render_tex_bloom;
 
         // Standard textures
         std::shared_ptr<RHI_Texture> m_tex_noise_normal;
         std::shared_ptr<RHI_Texture> m_tex_blue_noise;
         std::shared_ptr<RHI_Texture> m_tex_white;
+        std::shared_ptr<RHI_Texture> m_tex_environment;
         std::shared_ptr<RHI_Texture> m_tex_black_transparent;
         std::shared_ptr<RHI_Texture> m_tex_black_opaque;
-        std::shared_ptr<RHI_Texture> m_gizmo_tex_light_directional;
-        std::shared_ptr<RHI_Texture> m_gizmo_tex_light_point;
-        std::shared_ptr<RHI_Texture> m_gizmo_tex_light_spot;
+        std::shared_ptr<RHI_Texture> m_tex_particle;            // a soft disc, the sprite of emitters without a texture
+        std::shared_ptr<RHI_Texture> m_gizmo_tex_icons;         // the light icons (directional, point and spot) side by side
+        std::array<Math::Vector4, 3> m_gizmo_icons_rect;        // the pixel rectangle (x, y, width, height) of each icon in the atlas, by LightType
 
 		// Shaders
 		std::unordered_map<Renderer_Shader_Type, std::shared_ptr<RHI_Shader>> m_shaders;
@@ -336,12 +534,14 @@ namespace Spartan
         std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_off_on_r;
 		std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_w;
         std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_r;
+        std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_e;
         std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_on_w;
 
         // Blend states 
         std::shared_ptr<RHI_BlendState> m_blend_disabled;
         std::shared_ptr<RHI_BlendState> m_blend_alpha;
         std::shared_ptr<RHI_BlendState> m_blend_additive;
+        std::shared_ptr<RHI_BlendState> m_blend_transparent_oit;
 
         // Rasterizer states
 		std::shared_ptr<RHI_RasterizerState> m_rasterizer_cull_back_solid;
@@ -364,14 +564,25 @@ namespace Spartan
 		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer_lines;
 		std::vector<RHI_Vertex_PosCol> m_lines_list_depth_enabled;
 		std::vector<RHI_Vertex_PosCol> m_lines_list_depth_disabled;
+        std::mutex m_lines_mutex;
+        uint32_t m_buffer_lines_offset = 0; // vertices written this frame, resets when the swapchain wraps around to its first command list
+        std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer_box;     // the corners of a unit box, every box is an instance of it
+        std::shared_ptr<RHI_IndexBuffer> m_index_buffer_box;       // its edges
+        std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer_quad;    // the corners of a unit quad (facing -z, uvs from the top left), every impostor is an instance of it
+        std::shared_ptr<RHI_IndexBuffer> m_index_buffer_quad;
+        std::vector<RHI_Vertex_Instance> m_boxes_depth_enabled;
+        std::vector<RHI_Vertex_Instance> m_boxes_depth_disabled;
 
         // Gizmos
 		std::unique_ptr<Transform_Gizmo> m_gizmo_transform;
 		std::unique_ptr<Grid> m_gizmo_grid;
-		Math::Rectangle m_gizmo_light_rect;
+        std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer_icons;  // the quads of every icon, drawn with a single call
+        std::vector<RHI_Vertex_PosTex> m_icons_cpu;
+        uint32_t m_buffer_icons_offset = 0; // like m_buffer_lines_offset
 
         // Resolution & Viewport
 		Math::Vector2 m_resolution	            = Math::Vector2::Zero;
+        Math::Vector2 m_resolution_render       = Math::Vector2::Zero;
 		RHI_Viewport m_viewport		            = RHI_Viewport(0, 0, 1920, 1080);
         Math::Vector2 m_viewport_editor_offset  = Math::Vector2::Zero;
 
@@ -384,6 +595,7 @@ namespace Spartan
 		std::unique_ptr<Font> m_font;
         Math::Vector2 m_taa_jitter                  = Math::Vector2::Zero;
 		Math::Vector2 m_taa_jitter_previous         = Math::Vector2::Zero;
+        Math::Matrix m_volumetric_view_projection_previous = Math::Matrix::Identity;
         uint64_t m_render_target_debug              = 0;
 		bool m_initialized                          = false;
         const uint32_t m_resolution_shadow_min      = 128;
@@ -393,36 +605,358 @@ namespace Spartan
         bool m_is_odd_frame                         = false;
         std::atomic<bool> m_is_rendering            = false;
         bool m_brdf_specular_lut_rendered           = false;      
+        std::atomic<bool> m_environment_prefiltered = false;
+        bool m_volumetric_rendered                  = false;
         const float m_gizmo_size_max                = 2.0f;
         const float m_gizmo_size_min                = 0.1f;
         bool m_update_ortho_proj                    = true;
+        bool m_snapshot_taken                       = false;
+
+        // Idle, frames keep rendering for a while after the last change so that temporal effects converge
+        std::atomic<bool> m_idle_wake               = true;
+        bool m_is_idle                              = false;
+        uint32_t m_idle_frames_left                 = 0;
+        const uint32_t m_idle_frames_settle         = 32;
+        uint64_t m_idle_transform_revisions         = 0;
+        Math::Matrix m_idle_view_projection;
+        uint32_t m_dynamic_resolution_frames_over   = 0;
+        uint32_t m_dynamic_resolution_frames_under  = 0;
+        uint32_t m_dynamic_resolution_cooldown      = 0;
+        bool m_viewport_visible                     = true;
+        bool m_camera_moved                         = false;
+        bool m_preview_active                       = false;
+        uint32_t m_preview_frames_left              = 0;
                                                                   
         //= BUFFERS ==============================================
         BufferFrame m_buffer_frame_cpu;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_frame_gpu;
 
+        BufferMaterial m_buffer_material_cpu;
+        bool m_buffer_material_dirty = true;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_material_gpu;
 
         BufferUber m_buffer_uber_cpu;
         BufferUber m_buffer_uber_cpu_previous;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_uber_gpu;
-        uint32_t m_buffer_uber_offset_index = 0;
 
         BufferObject m_buffer_object_cpu;
         BufferObject m_buffer_object_cpu_previous;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_object_gpu;
-        uint32_t m_buffer_object_offset_index = 0;
 
-        BufferLight m_buffer_light_cpu;
-        BufferLight m_buffer_light_cpu_previous;
-        std::shared_ptr<RHI_ConstantBuffer> m_buffer_light_gpu;
+        BufferDraw m_buffer_draw_cpu;
+
+        BufferSkin m_buffer_skin_cpu;
+        BufferSkin m_buffer_skin_cpu_previous;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_skin_gpu;
+        std::unordered_map<const Renderable*, uint32_t> m_buffer_skin_offsets; // where each palette went this frame, so that every pass after the first binds it
+
+        BufferLights m_buffer_lights_cpu;
+        BufferLights m_buffer_lights_cpu_previous;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_lights_gpu;
+        std::vector<const Light*> m_lights; // the lights in the buffer above, in order
+        std::vector<const Light*> m_lights_screen_space_shadows; // the lights of the channels of the screen space shadow mask
+
+        BufferLightClusters m_buffer_light_clusters_cpu;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_light_clusters_gpu;
+        std::vector<const Light*> m_lights_clustered; // the lights which are binned into the clusters
+
+        BufferDecals m_buffer_decals_cpu;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_decals_gpu;
+
+        BufferReflectionProbes m_buffer_reflection_probes_cpu;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_reflection_probes_gpu;
         //========================================================
 
-        // Entities and material references
+        // Entities and material references, as of the last snapshot
         std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> m_entities;
-        std::array<Material*, m_max_material_instances> m_material_instances;
+
+        // Material table, a material keeps its slot in the material buffer for as long as it's drawn and its entry is only written when the slot
+        // is new or the material is dirty, so the buffer only changes when the materials do. Slots of materials which weren't drawn this frame
+        // are handed to new ones, so the limit is on the materials of a single frame.
+        uint32_t MaterialTableSlot(Material* material);
+        std::unordered_map<uint32_t, uint32_t> m_material_table;            // material id to slot
+        std::array<uint32_t, m_max_materials> m_material_table_ids;         // slot to material id
+        std::array<uint64_t, m_max_materials> m_material_table_frames;      // slot to the frame it was last drawn in, zero if never
+
+        // Material texture array, the small roughness, metallic, occlusion and mask textures of the materials which are drawn get a slice
+        // each, so they share a single allocation and don't need a binding of their own. A texture is copied into its slice by Pass_MaterialArray()
+        // the frame after a material asks for it (once it's loaded) and is bound on its own until then. Slices are kept until the world is cleared.
+        void BindMaterialTextures(RHI_CommandList* cmd_list, Material* material);
+        int32_t MaterialArraySlice(const std::shared_ptr<RHI_Texture>& texture);
+        static const uint32_t m_material_array_slice_size   = 128; // pixels along a side of a slice, larger textures aren't packed
+        static const uint32_t m_material_array_slices       = 128;
+        std::shared_ptr<RHI_Texture> m_material_array;
+        uint32_t m_material_array_slice_count               = 0; // slices handed out
+        std::unordered_map<uint32_t, int32_t> m_material_array_lookup; // texture id to slice, -1 while its copy is pending
+        std::vector<std::pair<std::shared_ptr<RHI_Texture>, uint32_t>> m_material_array_copies; // textures to copy, and their slice
         
         std::shared_ptr<Camera> m_camera;
+        Math::Frustum m_camera_frustum;
+
+        // Late latching, the view of the snapshot is rebuilt with the mouse motion which arrived after it, just before the frame buffer is uploaded
+        void CameraLateLatch();
+        Camera::LateLatchState m_camera_late_latch;
+        Input::MouseMotion m_camera_late_latch_motion; // the mouse motion the snapshot's view already includes
+
+        // Registry, it's updated by the simulation as components come and go, and the next snapshot publishes it
+        std::array<std::vector<Entity*>, 7> m_registry;                             // indexed by Renderer_Object_Type
+        std::array<std::unordered_map<Entity*, uint32_t>, 7> m_registry_indices;    // where each entity is in the above, for constant time removal
+        std::vector<std::shared_ptr<Entity>> m_registry_released;                   // entities which left the world since the last snapshot
+        std::vector<std::shared_ptr<Entity>> m_entities_released;                   // kept alive until the frames which could be recording them are done
+        bool m_registry_dirty = false;
+        std::mutex m_entities_mutex;
+
+        // RenderablesSort() keeps these so that it doesn't allocate every time the registry is published
+        std::vector<uint64_t> m_sort_keys;
+        std::vector<uint64_t> m_sort_keys_scratch;
+        std::vector<Entity*> m_sort_entities_scratch;
+
+        // A 64-bit draw key, from the most to the least significant bits:
+        // pass (1) | g-buffer shader variation (7) | vertex layout (2) | material (14) | geometry (21) | level of detail (3) | depth (16)
+        // Sorting by it puts entities which share a pixel shader, a vertex layout, a material and a geometry range next to each other, front to back.
+        // Materials and geometry ranges are numbered once per snapshot, the numbers which don't fit are reserved for "don't batch".
+        // The vertex layout is full, compact, skinned or displaced (in that order), skinned entities have a bone palette each so they aren't batched.
+        static constexpr uint32_t draw_key_variation_count  = 1 << 7;
+        static constexpr uint32_t draw_key_material_count   = 1 << 14;
+        static constexpr uint32_t draw_key_geometry_count   = 1 << 21;
+        static constexpr uint32_t draw_key_lod_count        = 1 << 3;
+        static constexpr uint64_t draw_key_batch_mask       = ~static_cast<uint64_t>(0xFFFF); // everything but the depth
+        static uint64_t DrawKey(const Renderer_Object_Type object_type, const uint32_t variation, const uint64_t material_geometry, const uint32_t lod, const float depth);
+        static uint32_t DrawKeyVariation(const uint64_t key) { return static_cast<uint32_t>((key >> 56) & (draw_key_variation_count - 1)); }
+        static uint32_t DrawKeyLod(const uint64_t key) { return static_cast<uint32_t>((key >> 16) & (draw_key_lod_count - 1)); }
+        static bool DrawKeySkinned(const uint64_t key) { return ((key >> 54) & 3) == 2; }
+        uint64_t DrawKeyMaterialGeometry(const Renderable* renderable);
+        struct DrawKeyGeometryHash
+        {
+            size_t operator()(const std::array<uint32_t, 4>& geometry) const
+            {
+                size_t seed = 0;
+                for (const uint32_t value : geometry)
+                {
+                    Utility::Hash::hash_combine(seed, value);
+                }
+                return seed;
+            }
+        };
+        std::unordered_map<const Material*, uint32_t> m_draw_key_materials;
+        std::unordered_map<std::array<uint32_t, 4>, uint32_t, DrawKeyGeometryHash> m_draw_key_geometries; // model, index offset, index count, vertex offset
+        std::vector<RHI_Shader*> m_draw_key_shaders; // g-buffer shader variation of the draw key to shader
+
+        // A run of draw list entities which share geometry and material, they are drawn with a single instanced draw
+        struct DrawBatch
+        {
+            uint32_t entity_start       = 0;
+            uint32_t entity_count       = 0;
+            uint32_t instance_offset    = 0; // into the instance buffer
+            uint32_t instance_count     = 0; // as many as entities, unless their renderables carry instances of their own
+        };
+
+        // What a render pass (or one slice of it) draws, workers gather these in parallel and the command list then records them in order
+        struct CullInstance;
+        struct DrawList
+        {
+            const Light* light      = nullptr; // shadow passes, the light and the array slice (cascade or cube face) of its shadow map, or the array size for all of them
+            uint32_t array_index    = 0;
+            uint64_t signature      = 0;    // shadow passes, what the slice would draw, it's only re-rendered when this changes
+            bool render             = true; // shadow passes, false if the slice's cached content is still good (or has to wait)
+            std::vector<Entity*> entities;
+            std::vector<uint64_t> keys; // the draw key of each entity
+            std::vector<DrawBatch> batches;
+            std::vector<Entity*> entities_scratch;
+            std::vector<uint64_t> keys_scratch;
+            std::vector<const CullInstance*> cull_candidates; // shadow passes, the casters within the light's range and their boxes, which are tested in a batch
+            Math::FrustumBoxes cull_boxes;
+            std::vector<uint8_t> cull_visible;
+            std::vector<uint8_t> cull_masks; // a bit per slice which the candidate is visible to
+        };
+        std::vector<DrawList> m_draw_lists; // reused by every pass, so the entity vectors don't reallocate every frame
+        uint32_t m_draw_list_count = 0;
+        DrawList& DrawListAdd();
+        void DrawListBatch(DrawList& draw_list, const bool parallel = false, const bool back_to_front = false);
+
+        // The bounds of every drawable opaque and transparent entity, gathered once per snapshot into contiguous arrays,
+        // so that culling (camera and shadow slices alike) streams through memory instead of chasing components.
+        struct CullInstance
+        {
+            Math::Vector3 center;
+            Math::Vector3 extents;
+            Entity* entity      = nullptr;
+            uint64_t key        = 0; // the material and geometry bits of the draw key
+            uint16_t flags      = 0; // material flags, pick the g-buffer shader variation
+            bool casts_shadows  = false;
+            uint8_t lod         = 0; // level of detail for the camera (depth pre-pass and g-buffer)
+            uint8_t lod_shadow  = 0; // level of detail for the shadow passes
+        };
+        // The screen space error (in pixels) a level of detail may have, before the bias
+        static constexpr float lod_pixel_error = 1.0f;
+        float m_cull_pixels_per_unit = 0.0f; // at a distance of one, from the last CullCamera()
+        void CullInstancesAcquire();
+        void CullCamera();
+        std::array<std::vector<CullInstance>, 2> m_cull_instances;  // indexed by Renderer_Object_Opaque and Renderer_Object_Transparent
+        std::array<std::vector<uint32_t>, 2> m_cull_visible;         // indices of the instances which the camera can see
+        std::vector<uint8_t> m_cull_mask;
+        Math::FrustumBoxes m_cull_boxes; // the boxes of the instances which are tested in a batch
+
+        // Draws the meshlets of a renderable which the camera (or a light's slice) can see and which have a triangle facing it, runs of
+        // visible meshlets are one draw. Returns false if the renderable can't be culled by meshlet (the caller draws it whole), i.e. it has
+        // no meshlets, it's not at the full level of detail, its vertices move in the vertex shader or it carries instances.
+        bool DrawMeshlets(RHI_CommandList* cmd_list, const Renderable* renderable, const Math::Matrix& transform, const uint32_t lod, const Light* light = nullptr, const uint32_t array_index = 0, const uint32_t instance_offset = 0);
+
+        // A bounding volume hierarchy over the instances, so that culling and queries only visit what's near them.
+        // It persists across snapshots, every snapshot moves the leaves of the instances (most don't leave their fat box)
+        // and re-points them to the instance arrays. A leaf's user data is the instance index, the top bit is set for transparent instances.
+        static constexpr uint32_t bvh_transparent_bit = 1u << 31;
+        struct BvhProxy
+        {
+            uint32_t proxy  = 0;
+            uint64_t stamp  = 0; // the snapshot which last saw the entity
+        };
+        void BvhAcquire(Entity* entity, const Math::BoundingBox& aabb, uint32_t user_data);
+        void BvhPrune();
+        // Visits the instances (and their type) of the leaves which a shape overlaps, the caller tests the instance's own box
+        template <typename Function, typename... Shape>
+        void BvhQuery(Function&& function, const Shape&... shape) const
+        {
+            m_bvh.Query(shape..., [this, &function](const uint32_t user_data)
+            {
+                const Renderer_Object_Type object_type  = (user_data & bvh_transparent_bit) ? Renderer_Object_Transparent : Renderer_Object_Opaque;
+                const uint32_t index                    = user_data & ~bvh_transparent_bit;
+                const std::vector<CullInstance>& instances = m_cull_instances[object_type];
+                if (index < instances.size()) // instances are cleared when there is no camera, the leaves are pruned on the next acquire
+                {
+                    function(instances[index], object_type);
+                }
+            });
+        }
+        Math::BoundingVolumeHierarchy m_bvh;
+        std::unordered_map<Entity*, BvhProxy> m_bvh_proxies;
+        uint64_t m_bvh_stamp = 0;
+
+        // Occlusion culling, the biggest visible opaque instances are rasterized on the CPU and the rest are tested against that (see OcclusionBuffer)
+        static constexpr float occluder_size_min            = 0.1f;     // bounding radius over distance, smaller instances don't occlude
+        static constexpr uint32_t occluder_triangle_budget  = 32768;    // triangles per frame, the biggest occluders go first
+        void CullOcclusion();
+        // Lights which reach something in view, a point or spot light whose whole reach is behind the occluders lights nothing which can be seen,
+        // so it skips its shadow maps, its volumetric injection and the light pass (with no latency, the occlusion buffer is this frame's)
+        bool IsLightVisible(const Light* light) const;
+        std::unique_ptr<OcclusionBuffer> m_occlusion_buffer;
+        std::vector<std::pair<float, uint32_t>> m_occluders; // size and index of the instances which are rasterized
+        std::unordered_map<uint16_t, uint32_t> m_draw_list_lookup;  // material flags to g-buffer shader variation of the draw key
+
+        // Impostors, the frames of a model (with its material) rendered from a grid of directions over it, into an albedo and a normal atlas.
+        // Opaque instances beyond the impostor distance of their renderable draw a quad with the closest frame instead of the model, those
+        // whose impostor isn't there yet ask for it and are drawn as they are, Pass_ImpostorBake() renders one per frame.
+        static const uint32_t m_impostor_frames         = 8;   // along a side of the atlas, must match the shader
+        static const uint32_t m_impostor_frame_size     = 128; // pixels along a side of a frame
+        struct Impostor
+        {
+            std::shared_ptr<RHI_Texture> albedo;
+            std::shared_ptr<RHI_Texture> normal;
+            Math::Vector4 center_radius; // of the model's bounds
+        };
+        struct ImpostorBakeRequest
+        {
+            std::shared_ptr<Model> model;
+            std::shared_ptr<Material> material;
+            uint32_t index_offset   = 0;
+            uint32_t index_count    = 0;
+            uint32_t vertex_offset  = 0;
+            Math::BoundingBox bounding_box;
+        };
+        static uint64_t ImpostorKey(const Renderable* renderable);
+        void ImpostorRequest(const Renderable* renderable, uint64_t key);
+        std::unordered_map<uint64_t, Impostor> m_impostors;
+        std::unordered_map<uint64_t, ImpostorBakeRequest> m_impostor_bake_requests;
+        std::shared_ptr<RHI_Texture> m_impostor_depth; // shared by the bakes
+        std::vector<std::pair<uint64_t, const CullInstance*>> m_impostor_draws; // of the g-buffer pass, by impostor
+        std::vector<DrawBatch> m_impostor_batches;
+
+        // Views (see ViewAdd()), the requests are published along with the registry, the main camera is the last registered camera which isn't a view
+        struct ViewRequest
+        {
+            float resolution_scale      = 0.5f;
+            uint32_t update_interval    = 1;
+        };
+        struct View
+        {
+            Entity* entity              = nullptr;
+            Camera* camera              = nullptr; // null while the entity's camera isn't registered
+            ViewRequest request;
+            uint64_t frame_rendered     = 0;
+            std::shared_ptr<RHI_Texture> color; // assigned under m_entities_mutex, GetViewTexture() hands it to other threads
+            std::shared_ptr<RHI_Texture> depth;
+        };
+        void ViewsPublish();
+        void ViewSelect();
+        std::unordered_map<Entity*, ViewRequest> m_view_requests; // guarded by m_entities_mutex
+        std::vector<View> m_views;
+        View* m_view = nullptr;         // the view which renders this frame, picked by the snapshot
+        BufferFrame m_view_frame;       // its camera, as of the snapshot
+        Math::Frustum m_view_frustum;
+        std::vector<uint32_t> m_view_visible;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_frame_view_gpu;
+
+        // Reflection probes (see ReflectionProbe), a probe is baked a face per frame into an array of six faces, then its faces are projected into the
+        // spherical mapping of the environment and prefiltered like it, into the probe's run of slices in the atlas. It's baked again when it moves
+        // or it's asked to, until then its old slices stay in use. Of the probes which are registered, the ones nearest to the camera get slots.
+        static const uint32_t m_reflection_probe_face_size  = 128;
+        static const uint32_t m_reflection_probe_slices     = m_environment_slices_specular + 2; // the radiance, the specular levels and the irradiance
+        struct ReflectionProbeSlot
+        {
+            uint32_t slot               = 0;
+            uint64_t signature          = 0; // what it was baked with, zero until it's baked
+            uint64_t frame_seen         = 0;
+        };
+        static uint64_t ReflectionProbeSignature(const ReflectionProbe* probe);
+        std::unordered_map<uint32_t, ReflectionProbeSlot> m_reflection_probe_slots; // by component id
+        std::vector<const ReflectionProbe*> m_reflection_probes; // the ones with slots this frame, nearest first
+        uint32_t m_reflection_probe_bake_id             = 0; // the component id of the probe which is being baked
+        uint64_t m_reflection_probe_bake_signature      = 0;
+        uint32_t m_reflection_probe_bake_face           = 0;
+        std::shared_ptr<RHI_Texture> m_reflection_probe_atlas;
+        std::shared_ptr<RHI_Texture> m_reflection_probe_faces;
+        std::shared_ptr<RHI_Texture> m_reflection_probe_depth;
+        std::shared_ptr<RHI_Texture> m_reflection_probe_radiance; // the input of the prefiltering
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_frame_probe_gpu;
+
+        // The decal atlas, a cell per decal texture, a texture is copied into its cell the first frame a decal in view uses it (and it's loaded)
+        static const uint32_t m_decal_atlas_cells       = 8;   // along a side of the atlas
+        static const uint32_t m_decal_atlas_cell_size   = 256; // pixels along a side of a cell
+        std::shared_ptr<RHI_Texture> m_decal_atlas;
+
+        // Auto exposure, a single texel which the histogram pass adapts from frame to frame and the tone-mapping reads (see AutoExposure.hlsl)
+        static constexpr float m_auto_exposure_adaptation_speed = 1.5f; // per second, how fast the exposure closes in on the one the frame asks for
+        std::shared_ptr<RHI_Texture> m_tex_auto_exposure;
+        std::unordered_map<uint32_t, uint32_t> m_decal_atlas_lookup; // texture id to cell
+        std::vector<std::pair<RHI_Texture*, uint32_t>> m_decal_atlas_copies; // textures to copy this frame, and their cell
+
+        // Shadow slices keep their content for as long as their signature (light matrices, shadow map and casters) stays the same.
+        // Slices that did change are re-rendered within a per-frame budget, the ones which waited the longest first.
+        // The far cascades of a directional light take turns, they are sampled with the matrices they were rendered with, so a cascade which waits a frame still lines up.
+        // With layered rendering, a light whose slices all re-render draws them in a single pass (and a cube which re-renders two faces or more re-renders all six).
+        static constexpr uint32_t shadow_cascades_every_frame = 2;
+        struct ShadowSliceCache
+        {
+            uint64_t signature          = 0;
+            uint64_t frame_rendered     = 0;
+            uint64_t frame_seen         = 0;
+            uint32_t texture_id         = 0;
+            Math::Matrix view_projection;   // what the slice was rendered with, the light pass has to sample it with the same
+        };
+        static uint64_t ShadowSliceKey(const Light* light, const uint32_t array_index);
+        void ShadowSlicesSelect(const bool layered);
+        void ShadowSlicesMerge();
+        const Math::Matrix* GetShadowSliceViewProjection(const Light* light, const uint32_t array_index) const;
+        std::unordered_map<uint64_t, ShadowSliceCache> m_shadow_slice_cache;
+        std::vector<uint32_t> m_shadow_slice_candidates;
+
+        // Instancing, the per-instance data of a pass is staged on the CPU and uploaded with a single map
+        bool UpdateInstanceBuffer(RHI_CommandList* cmd_list, uint32_t& instance_offset);
+        bool UpdateIconBuffer(RHI_CommandList* cmd_list, uint32_t& vertex_offset);
+        bool UpdateLineBuffer(RHI_CommandList* cmd_list, uint32_t& vertex_offset_depth_enabled, uint32_t& vertex_offset_depth_disabled);
+        std::vector<RHI_Vertex_Instance> m_instances_cpu;
+        std::shared_ptr<RHI_VertexBuffer> m_buffer_instance_gpu;
+        uint32_t m_buffer_instance_offset = 0; // instances written this frame, resets when the swapchain wraps around to its first command list
 
         // RHI Core
         std::shared_ptr<RHI_Device> m_rhi_device;
@@ -433,5 +967,12 @@ namespace Spartan
         // Dependencies
         Profiler* m_profiler            = nullptr;
         ResourceCache* m_resource_cache = nullptr;
+        Threading* m_threading          = nullptr;
+
+        // Counters (see Profiler::CounterRegister())
+        Counter* m_counter_instances_visible    = nullptr;
+        Counter* m_counter_meshlets_culled      = nullptr;
+        Counter* m_counter_stream_queue         = nullptr;
+        Counter* m_counter_lights_culled        = nullptr;
     };
 }
@@ -25,10 +25,22 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\Math\Vector2.h"
 #include "..\Math\Vector3.h"
 #include "..\Math\Matrix.h"
+#include "..\RHI\RHI_Definition.h"
 //==========================
 
 namespace Spartan
 {
+    // Effects of the fused post-process pass, must match PostProcess.hlsl
+    enum PostProcess_Flags : uint32_t
+    {
+        PostProcess_ToneMapping         = 1 << 0,
+        PostProcess_Dithering           = 1 << 1,
+        PostProcess_Sharpening          = 1 << 2,
+        PostProcess_ChromaticAberration = 1 << 3,
+        PostProcess_GammaCorrection     = 1 << 4,
+        PostProcess_AutoExposure        = 1 << 5  // the tone-mapping adds the adapted exposure to the one of the options
+    };
+
     // Low frequency buffer - Updates once per frame
     struct BufferFrame
     {
@@ -65,15 +77,17 @@ namespace Spartan
         Math::Vector2 taa_jitter_offset;
 
         uint32_t frame;
-        Math::Vector3 padding;
+        float gbuffer_compact;
+        Math::Vector2 taa_jitter;
     };
     
-    // Low frequency buffer - Updates once per frame
-    static const uint32_t m_max_material_instances = 1024; // must match the shader
+    // Low frequency buffer - Updates when a material changes
+    // The material table, indexed by the material id which the g-buffer stores. Its size is what a constant buffer and the compact g-buffer's id precision allow.
+    static const uint32_t m_max_materials = 1024; // must match the shader
     struct BufferMaterial
     {
-        Math::Vector4 mat_clearcoat_clearcoatRough_anis_anisRot[m_max_material_instances];
-        Math::Vector4 mat_sheen_sheenTint_pad[m_max_material_instances];
+        Math::Vector4 mat_clearcoat_clearcoatRough_anis_anisRot[m_max_materials];
+        Math::Vector4 mat_sheen_sheenTint_pad[m_max_materials];
     };
 
     // Medium frequency - Updates a few dozen times
@@ -100,13 +114,21 @@ namespace Spartan
         float mat_height_mul;
 
         float mat_id;
-        Math::Vector3 padding;
+        uint32_t postprocess_flags;
+        uint32_t light_index; // into BufferLights
+        float padding;
+
+        Math::Vector4 mat_texture_slices = Math::Vector4(-1.0f, -1.0f, -1.0f, -1.0f); // roughness, metallic, occlusion and mask, their slice in the material texture array, -1 if bound on their own
+
+        Math::Vector4 transform_axis_colors[4]; // x, y, z and xyz, for the instanced transform handle
 
         bool operator==(const BufferUber& rhs) const
         {
             return
                 transform           == rhs.transform            &&
                 mat_id              == rhs.mat_id               &&
+                postprocess_flags   == rhs.postprocess_flags    &&
+                light_index         == rhs.light_index          &&
                 mat_albedo          == rhs.mat_albedo           &&
                 mat_tiling_uv       == rhs.mat_tiling_uv        &&
                 mat_offset_uv       == rhs.mat_offset_uv        &&
@@ -114,11 +136,16 @@ namespace Spartan
                 mat_metallic_mul    == rhs.mat_metallic_mul     &&
                 mat_normal_mul      == rhs.mat_normal_mul       &&
                 mat_height_mul      == rhs.mat_height_mul       &&
+                mat_texture_slices  == rhs.mat_texture_slices   &&
                 color               == rhs.color                &&
                 transform_axis      == rhs.transform_axis       &&
                 blur_sigma          == rhs.blur_sigma           &&
                 blur_direction      == rhs.blur_direction       &&
-                resolution          == rhs.resolution;
+                resolution          == rhs.resolution           &&
+                transform_axis_colors[0] == rhs.transform_axis_colors[0] &&
+                transform_axis_colors[1] == rhs.transform_axis_colors[1] &&
+                transform_axis_colors[2] == rhs.transform_axis_colors[2] &&
+                transform_axis_colors[3] == rhs.transform_axis_colors[3];
         }
 
         bool operator!=(const BufferUber& rhs) const { return !(*this == rhs); }
@@ -130,37 +157,119 @@ namespace Spartan
         Math::Matrix object;
         Math::Matrix wvp_current;
         Math::Matrix wvp_previous;
+
+        // Impostors, the center of the model's bounds and the radius of the sphere around them (see Renderable::SetImpostorDistance())
+        Math::Vector4 impostor_center_radius        = Math::Vector4::Zero;
+
+        // Particle emitters, their particles are computed from these and their index (see ParticleEmitter)
+        Math::Vector4 particle_velocity_spread              = Math::Vector4::Zero; // velocity at spawn, radius of the random velocity
+        Math::Vector4 particle_color_start                  = Math::Vector4::Zero;
+        Math::Vector4 particle_color_end                    = Math::Vector4::Zero;
+        Math::Vector4 particle_time_period_lifetime_gravity = Math::Vector4::Zero;
+        Math::Vector4 particle_rate_size_seed               = Math::Vector4::Zero; // rate, start size, end size, seed
     
         bool operator==(const BufferObject& rhs) const
         {
             return
-                object          == rhs.object       &&
-                wvp_current     == rhs.wvp_current  &&
-                wvp_previous    == rhs.wvp_previous;
+                object                          == rhs.object                       &&
+                wvp_current                     == rhs.wvp_current                  &&
+                wvp_previous                    == rhs.wvp_previous                 &&
+                impostor_center_radius          == rhs.impostor_center_radius       &&
+                particle_velocity_spread        == rhs.particle_velocity_spread     &&
+                particle_color_start            == rhs.particle_color_start         &&
+                particle_color_end              == rhs.particle_color_end           &&
+                particle_time_period_lifetime_gravity == rhs.particle_time_period_lifetime_gravity &&
+                particle_rate_size_seed         == rhs.particle_rate_size_seed;
         }
 
         bool operator!=(const BufferObject& rhs) const { return !(*this == rhs); }
     };
-    
-    // Light buffer
-    struct BufferLight
+
+    // Per draw - The vertex data of a batch, small enough to be pushed into the command list (see RHI_CommandList::SetPushConstants()),
+    // so a batch of instances (whose transforms are in the instance buffer) is drawn without touching a descriptor
+    struct BufferDraw
     {
-        Math::Matrix view_projection[6];
-        Math::Vector4 intensity_range_angle_bias;
-        Math::Vector3 color;
-        float normal_bias;
-        Math::Vector4 position;
-        Math::Vector4 direction;
+        // Compact vertices (see Model::SetVertexCompact())
+        Math::Vector3 position_offset   = Math::Vector3::Zero;
+        float padding                   = 0.0f;
+        Math::Vector3 position_scale    = Math::Vector3::One;
+        float padding2                  = 0.0f;
+
+        // Displaced vertices (see Model::SetVertexDisplacement())
+        Math::Vector4 displacement_uv_scale_offset  = Math::Vector4::Zero;
+        Math::Vector2 displacement_height           = Math::Vector2::Zero;
+        Math::Vector2 padding3                      = Math::Vector2::Zero;
+    };
+    static_assert(sizeof(BufferDraw) <= rhi_max_push_constant_size, "BufferDraw doesn't fit in the push constants");
     
-        bool operator==(const BufferLight& rhs)
+    // High frequency - Updates per skinned object, once per frame
+    // The bone palette of the object, what its vertices are skinned with (see Renderable::GetBonePaletteRender())
+    struct BufferSkin
+    {
+        Math::Matrix bones[rhi_max_skin_bones];
+
+        bool operator==(const BufferSkin& rhs) const
         {
-            return
-                view_projection             == rhs.view_projection              &&
-                intensity_range_angle_bias  == rhs.intensity_range_angle_bias   &&
-                normal_bias                 == rhs.normal_bias                  &&
-                color                       == rhs.color                        &&
-                position                    == rhs.position                     &&
-                direction                   == rhs.direction;
+            for (uint32_t i = 0; i < rhi_max_skin_bones; i++)
+            {
+                if (bones[i] != rhs.bones[i])
+                    return false;
+            }
+
+            return true;
         }
     };
+
+    // Low frequency buffer - Updates once per frame
+    // Every light, packed once, the light passes pick theirs with BufferUber::light_index while the clusters and forward shading index the rest
+    static const uint32_t m_max_lights = 64; // must match the shader
+    static const uint32_t m_max_lights_screen_space_shadows = 4; // a channel of the mask each
+    struct BufferLights
+    {
+        Math::Matrix view_projection[m_max_lights * 6]; // six per light, the cascades or the cube faces
+        Math::Vector4 color_intensity[m_max_lights];
+        Math::Vector4 position_range[m_max_lights];
+        Math::Vector4 direction_angle[m_max_lights];    // w is negative for point and directional lights
+        Math::Vector4 bias_normal_bias[m_max_lights];   // z is the channel of the screen space shadow mask plus one (zero for none), w is one for directional lights
+        uint32_t screen_space_shadows[m_max_lights_screen_space_shadows];               // the light of each channel of the screen space shadow mask, m_max_lights for none
+    };
+
+    // Low frequency buffer - Updates once per frame
+    // The lights which don't need shadow maps, binned into a grid of clusters which slices the camera frustum
+    // in screen space tiles and exponential depth slices. Each cluster is a mask of the lights that reach it, by their index in BufferLights.
+    static const uint32_t m_light_cluster_count_x       = 16; // must match the shader
+    static const uint32_t m_light_cluster_count_y       = 9;  // must match the shader
+    static const uint32_t m_light_cluster_count_z       = 24; // must match the shader
+    static const uint32_t m_light_cluster_count         = m_light_cluster_count_x * m_light_cluster_count_y * m_light_cluster_count_z;
+    static_assert(m_max_lights <= 64, "The cluster masks are 64-bit");
+    struct BufferLightClusters
+    {
+        Math::Vector4 slice_scale_bias_count;                       // depth slice = log(view depth) * scale + bias, z is the light count
+        uint32_t masks[m_light_cluster_count * 2];                  // low and high 32 bits of each cluster's mask
+    };
+
+    // Low frequency buffer - Updates once per frame
+    // The decals in view, binned into the same clusters as the lights, by their index in this buffer.
+    // Their textures are copied into cells of an atlas, so that the g-buffer pass samples a single texture.
+    static const uint32_t m_max_decals = 64; // must match the shader
+    static_assert(m_max_decals <= 64, "The cluster masks are 64-bit");
+    struct BufferDecals
+    {
+        Math::Vector4 slice_scale_bias_count;               // z is the decal count, the slices are computed before the light clusters are
+        Math::Matrix world_to_box[m_max_decals];            // into the decal's unit box, projected along z
+        Math::Vector4 atlas_rect[m_max_decals];             // uv offset (xy) and scale (zw) of the decal's cell in the atlas
+        Math::Vector4 color[m_max_decals];
+        Math::Vector4 roughness_metallic[m_max_decals];     // zw are unused
+        uint32_t masks[m_light_cluster_count * 2];          // low and high 32 bits of each cluster's mask
+    };
+
+    // Low frequency buffer - Updates once per frame
+    // The baked reflection probes nearest to the camera, each owns a run of slices in the probe atlas (its radiance, the specular levels and the irradiance).
+    static const uint32_t m_max_reflection_probes = 8; // must match the shader
+    struct BufferReflectionProbes
+    {
+        Math::Vector4 count;                                // x is the probe count
+        Math::Vector4 center_fade[m_max_reflection_probes]; // center of the box (where the probe was baked from) and the fade distance
+        Math::Vector4 extents_slice[m_max_reflection_probes]; // half size of the box and the probe's first slice in the atlas
+    };
 }
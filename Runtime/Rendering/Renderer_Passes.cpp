@@ -24,20 +24,27 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Model.h"
 #include "ShaderGBuffer.h"
 #include "ShaderLight.h"
+#include "RenderGraph.h"
 #include "Font/Font.h"
 #include "Gizmos/Grid.h"
 #include "Gizmos/Transform_Gizmo.h"
 #include "../Profiling/Profiler.h"
+#include "../Threading/Threading.h"
 #include "../RHI/RHI_CommandList.h"
+#include "../RHI/RHI_Device.h"
 #include "../RHI/RHI_Implementation.h"
 #include "../RHI/RHI_VertexBuffer.h"
+#include "../RHI/RHI_IndexBuffer.h"
 #include "../RHI/RHI_PipelineState.h"
 #include "../RHI/RHI_Texture.h"
+#include "../RHI/RHI_Texture2D.h"
 #include "../World/Entity.h"
 #include "../World/Components/Light.h"
 #include "../World/Components/Camera.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
+#include "../World/Components/ParticleEmitter.h"
+#include "../World/Components/ReflectionProbe.h"
 //=========================================
 
 //= NAMESPACES ===============
@@ -54,7 +61,11 @@ namespace Spartan
         cmd_list->SetConstantBuffer(1, RHI_Shader_Pixel, m_buffer_material_gpu);
         cmd_list->SetConstantBuffer(2, RHI_Shader_Vertex | RHI_Shader_Pixel, m_buffer_uber_gpu);
         cmd_list->SetConstantBuffer(3, RHI_Shader_Vertex, m_buffer_object_gpu);
-        cmd_list->SetConstantBuffer(4, RHI_Shader_Pixel, m_buffer_light_gpu);
+        cmd_list->SetConstantBuffer(4, RHI_Shader_Pixel, m_buffer_lights_gpu);
+        cmd_list->SetConstantBuffer(5, RHI_Shader_Pixel, m_buffer_light_clusters_gpu);
+        cmd_list->SetConstantBuffer(6, RHI_Shader_Vertex, m_buffer_skin_gpu);
+        cmd_list->SetConstantBuffer(7, RHI_Shader_Pixel, m_buffer_decals_gpu);
+        cmd_list->SetConstantBuffer(8, RHI_Shader_Pixel, m_buffer_reflection_probes_gpu);
         
         // Samplers
         cmd_list->SetSampler(0, m_sampler_compare_depth);
@@ -73,61 +84,176 @@ namespace Spartan
 
         SCOPED_TIME_BLOCK(m_profiler);
 
+        // Turn the camera by the mouse motion which arrived since the snapshot, as late as possible
+        CameraLateLatch();
+
         // Updates onces, used almost everywhere
         UpdateFrameBuffer();
-        
-        // Runs only once
-        Pass_BrdfSpecularLut(cmd_list);
-        
+
+        // What the camera can see, the depth pre-pass and g-buffer passes only draw these
+        CullCamera();
+
+        // The reflection probes which light the frame, and the one which is being baked
+        UpdateReflectionProbeBuffer();
+
+        // Render targets which are used by most passes
+        const uint64_t gbuffer      = RenderTarget_Gbuffer_Albedo | RenderTarget_Gbuffer_Normal | RenderTarget_Gbuffer_Material | RenderTarget_Gbuffer_Velocity | RenderTarget_Gbuffer_Depth;
+        const uint64_t light        = RenderTarget_Light_Diffuse | RenderTarget_Light_Specular;
+        const uint64_t composition  = RenderTarget_Composition_Hdr | RenderTarget_Composition_Hdr_2 | RenderTarget_Composition_Ldr | RenderTarget_Composition_Ldr_2;
+        const uint64_t depth        = RenderTarget_Gbuffer_Depth;
+
+        // Optional inputs of the lighting passes
+        uint64_t light_inputs = 0;
+        light_inputs |= GetOption(Render_Hbao)                  ? RenderTarget_Hbao : 0;
+        light_inputs |= GetOption(Render_ScreenSpaceReflections) ? RenderTarget_Ssr  : 0;
+
+        // HBAO and SSR can run at a fraction of the resolution, on a downsampled depth and normal buffer (and get upsampled after)
+        const bool screen_space_downsampled     = (GetOption(Render_Hbao) || GetOption(Render_ScreenSpaceReflections)) && GetOptionValue<uint32_t>(Option_Value_ScreenSpaceScale) > 1;
+        const uint64_t depth_normal_downsampled = screen_space_downsampled ? (RenderTarget_Gbuffer_Depth_Downsampled | RenderTarget_Gbuffer_Normal_Downsampled) : 0;
+        const uint64_t hbao_downsampled         = screen_space_downsampled ? RenderTarget_Hbao_Downsampled : 0;
+        const uint64_t ssr_downsampled          = screen_space_downsampled ? RenderTarget_Ssr_Downsampled : 0;
+
+        // Volumetric lighting, the froxel history ping-pongs between two targets
+        const bool volumetric                       = GetOption(Render_VolumetricLighting);
+        const uint64_t volumetric_history           = m_is_odd_frame ? RenderTarget_Volumetric_History_2 : RenderTarget_Volumetric_History;
+        const uint64_t volumetric_history_previous  = m_is_odd_frame ? RenderTarget_Volumetric_History : RenderTarget_Volumetric_History_2;
+
+        // What has to survive the frame, the frame itself and what next frame reads from this one (history, indirect bounce, the specular LUT, the prefiltered environment)
+        const uint64_t outputs = RenderTarget_Composition_Ldr | RenderTarget_Composition_Hdr_2 | RenderTarget_TaaHistory | RenderTarget_Light_Diffuse | RenderTarget_Light_Specular | RenderTarget_Brdf_Specular_Lut | RenderTarget_Brdf_Prefiltered_Environment | (volumetric ? volumetric_history : 0);
+
         const bool draw_transparent_objects = !m_entities[Renderer_Object_Transparent].empty();
-        
+
+        // Variable rate shading, the passes which shade every pixel of the frame read the shading rate image
+        const bool variable_rate_shading    = GetOption(Render_VariableRateShading) && m_rhi_device->IsVariableRateShadingSupported();
+        const uint64_t shading_rate         = variable_rate_shading ? RenderTarget_ShadingRate : 0;
+
+        // Runs only once
+        if (!m_brdf_specular_lut_rendered)
+        {
+            m_render_graph->AddPass("Pass_BrdfSpecularLut", 0, RenderTarget_Brdf_Specular_Lut, [this](RHI_CommandList* cmd_list) { Pass_BrdfSpecularLut(cmd_list); });
+        }
+
+        // Runs when the environment changes
+        if (!m_environment_prefiltered)
+        {
+            m_render_graph->AddPass("Pass_EnvironmentPrefilter", 0, RenderTarget_Brdf_Prefiltered_Environment, [this](RHI_CommandList* cmd_list) { Pass_EnvironmentPrefilter(cmd_list); });
+        }
+
+        // Runs while impostors are waiting to be baked, they belong to the renderer so the graph doesn't see them
+        if (!m_impostor_bake_requests.empty())
+        {
+            m_render_graph->AddPass("Pass_ImpostorBake", 0, 0, [this](RHI_CommandList* cmd_list) { Pass_ImpostorBake(cmd_list); }, RenderGraph_Pass_NeverCull);
+        }
+
+        // Runs while small material textures are waiting to be copied into the material texture array, which belongs to the renderer
+        if (!m_material_array_copies.empty())
+        {
+            m_render_graph->AddPass("Pass_MaterialArray", 0, 0, [this](RHI_CommandList* cmd_list) { Pass_MaterialArray(cmd_list); }, RenderGraph_Pass_NeverCull);
+        }
+
+        // Runs while decals are in the world (and once after the last one is gone, to empty the buffer), the atlas belongs to the renderer
+        if (!m_entities[Renderer_Object_Decal].empty() || m_buffer_decals_cpu.slice_scale_bias_count.z != 0.0f)
+        {
+            m_render_graph->AddPass("Pass_Decals", 0, 0, [this](RHI_CommandList* cmd_list) { Pass_Decals(cmd_list); }, RenderGraph_Pass_NeverCull);
+        }
+
         // Depth
         {
-            Pass_LightDepth(cmd_list, Renderer_Object_Opaque);
+            // Shadow maps belong to the lights, the graph doesn't see them
+            m_render_graph->AddPass("Pass_LightDepth", 0, 0, [this](RHI_CommandList* cmd_list) { Pass_LightDepth(cmd_list, Renderer_Object_Opaque); }, RenderGraph_Pass_NeverCull);
             if (draw_transparent_objects)
             {
-                Pass_LightDepth(cmd_list, Renderer_Object_Transparent);
-            }
-        
-            if (GetOption(Render_DepthPrepass))
-            {
-                Pass_DepthPrePass(cmd_list);
+                m_render_graph->AddPass("Pass_LightDepthTransparent", 0, 0, [this](RHI_CommandList* cmd_list) { Pass_LightDepth(cmd_list, Renderer_Object_Transparent); }, RenderGraph_Pass_NeverCull);
             }
         }
-        
+
         // G-Buffer to Composition
         {
             // Lighting
-            Pass_GBuffer(cmd_list, Renderer_Object_Opaque);
-            Pass_Hbao(cmd_list, false);
-            Pass_Ssr(cmd_list, false);
-            Pass_Light(cmd_list, false);
-            Pass_Composition(cmd_list, m_render_targets[RenderTarget_Composition_Hdr], false);
-        
-            // Lighting for transparent objects
+            m_render_graph->AddPass("Pass_GBuffer", 0, gbuffer, [this](RHI_CommandList* cmd_list) { Pass_GBuffer(cmd_list, Renderer_Object_Opaque); });
+            if (variable_rate_shading)
+            {
+                m_render_graph->AddPass("Pass_ShadingRate", RenderTarget_Gbuffer_Velocity | RenderTarget_Composition_Ldr, RenderTarget_ShadingRate, [this](RHI_CommandList* cmd_list) { Pass_ShadingRate(cmd_list); });
+            }
+            if (screen_space_downsampled)
+            {
+                m_render_graph->AddPass("Pass_DepthNormalDownsample", depth | RenderTarget_Gbuffer_Normal, depth_normal_downsampled, [this](RHI_CommandList* cmd_list) { Pass_DepthNormalDownsample(cmd_list); }, RenderGraph_Pass_Async);
+            }
+            if (GetOption(Render_Hbao))
+            {
+                m_render_graph->AddPass("Pass_Hbao", depth | RenderTarget_Gbuffer_Normal | RenderTarget_Light_Diffuse | depth_normal_downsampled, RenderTarget_Hbao | RenderTarget_Hbao_Noisy | hbao_downsampled, [this](RHI_CommandList* cmd_list) { Pass_Hbao(cmd_list, false); }, RenderGraph_Pass_Async);
+            }
+            if (GetOption(Render_ScreenSpaceReflections))
+            {
+                m_render_graph->AddPass("Pass_Ssr", depth | RenderTarget_Gbuffer_Normal | depth_normal_downsampled, RenderTarget_Ssr | ssr_downsampled, [this](RHI_CommandList* cmd_list) { Pass_Ssr(cmd_list, false); }, RenderGraph_Pass_Async);
+            }
+            m_render_graph->AddPass("Pass_Light", gbuffer | RenderTarget_Composition_Hdr_2 | light_inputs | shading_rate, light | (GetOption(Render_ScreenSpaceShadows) ? RenderTarget_ScreenSpaceShadows : 0), [this](RHI_CommandList* cmd_list) { Pass_Light(cmd_list, false); });
+            if (volumetric)
+            {
+                m_render_graph->AddPass("Pass_VolumetricLighting", volumetric_history_previous, RenderTarget_Volumetric_Scattering | volumetric_history | RenderTarget_Light_Volumetric, [this](RHI_CommandList* cmd_list) { Pass_VolumetricLighting(cmd_list); });
+            }
+            m_render_graph->AddPass("Pass_Composition", gbuffer | light | light_inputs | (volumetric ? RenderTarget_Light_Volumetric : 0) | RenderTarget_Composition_Hdr_2 | RenderTarget_Brdf_Specular_Lut | RenderTarget_Brdf_Prefiltered_Environment | shading_rate, RenderTarget_Composition_Hdr, [this](RHI_CommandList* cmd_list)
+            {
+                Pass_Composition(cmd_list, m_render_targets[RenderTarget_Composition_Hdr], false);
+            });
+
+            // Transparent objects are shaded in a single forward pass on top of the opaque composition, with the light clusters and the
+            // directional shadow map of the passes above. They are blended back to front, unless order independent transparency is enabled.
             if (draw_transparent_objects)
             {
-                Pass_GBuffer(cmd_list, Renderer_Object_Transparent);
-                Pass_Hbao(cmd_list, true);
-                Pass_Ssr(cmd_list, true);
-                Pass_Light(cmd_list, true);
-                Pass_Composition(cmd_list, m_render_targets[RenderTarget_Composition_Hdr_2], true);
-        
-                // Alpha blend the transparent composition on top of opaque one
-                Pass_AlphaBlend(cmd_list, m_render_targets[RenderTarget_Composition_Hdr_2].get(), m_render_targets[RenderTarget_Composition_Hdr].get(), true);
+                if (GetOption(Render_TransparentOit))
+                {
+                    const uint64_t transparent = RenderTarget_Transparent_Accumulation | RenderTarget_Transparent_Weight;
+                    m_render_graph->AddPass("Pass_ForwardTransparent", RenderTarget_Brdf_Specular_Lut | RenderTarget_Brdf_Prefiltered_Environment, depth | transparent, [this](RHI_CommandList* cmd_list) { Pass_GBuffer(cmd_list, Renderer_Object_Transparent); });
+                    m_render_graph->AddPass("Pass_TransparentResolve", transparent, RenderTarget_Composition_Hdr, [this](RHI_CommandList* cmd_list)
+                    {
+                        Pass_TransparentResolve(cmd_list, m_render_targets[RenderTarget_Composition_Hdr].get());
+                    });
+                }
+                else
+                {
+                    m_render_graph->AddPass("Pass_ForwardTransparent", RenderTarget_Brdf_Specular_Lut | RenderTarget_Brdf_Prefiltered_Environment, depth | RenderTarget_Composition_Hdr, [this](RHI_CommandList* cmd_list) { Pass_GBuffer(cmd_list, Renderer_Object_Transparent); });
+                }
+            }
+
+            // Particles add their light on top, tested against the opaque depth
+            if (!m_entities[Renderer_Object_ParticleEmitter].empty())
+            {
+                m_render_graph->AddPass("Pass_Particles", 0, depth | RenderTarget_Composition_Hdr, [this](RHI_CommandList* cmd_list) { Pass_Particles(cmd_list); });
             }
         }
-        
+
+        // A view renders after the frame's shadow maps, light buffer and material table are up to date
+        if (m_view)
+        {
+            m_render_graph->AddPass("Pass_View", RenderTarget_Brdf_Specular_Lut | RenderTarget_Brdf_Prefiltered_Environment, 0, [this](RHI_CommandList* cmd_list) { Pass_View(cmd_list); }, RenderGraph_Pass_NeverCull);
+        }
+
+        // So does the face of a reflection probe, its atlas belongs to the renderer (the composition of the next frame reads the new slices)
+        if (m_reflection_probe_bake_id != 0)
+        {
+            m_render_graph->AddPass("Pass_ReflectionProbes", RenderTarget_Brdf_Specular_Lut | RenderTarget_Brdf_Prefiltered_Environment, 0, [this](RHI_CommandList* cmd_list) { Pass_ReflectionProbes(cmd_list); }, RenderGraph_Pass_NeverCull);
+        }
+
         // Post-processing
         {
-            Pass_PostProcess(cmd_list);
-            Pass_Outline(cmd_list, m_render_targets[RenderTarget_Composition_Ldr]);
-            Pass_Lines(cmd_list, m_render_targets[RenderTarget_Composition_Ldr]);
-            Pass_TransformHandle(cmd_list, m_render_targets[RenderTarget_Composition_Ldr].get());
-            Pass_Icons(cmd_list, m_render_targets[RenderTarget_Composition_Ldr].get());
-            Pass_DebugBuffer(cmd_list, m_render_targets[RenderTarget_Composition_Ldr]);
-            Pass_Text(cmd_list, m_render_targets[RenderTarget_Composition_Ldr].get());
+            // Ping-pongs between the composition targets, so it reads and writes all of them
+            m_render_graph->AddPass("Pass_PostProcess", composition | RenderTarget_TaaHistory | RenderTarget_Gbuffer_Velocity | depth | shading_rate, composition | RenderTarget_TaaHistory, [this](RHI_CommandList* cmd_list) { Pass_PostProcess(cmd_list); });
+            if (GetOption(Render_Debug_SelectionOutline))
+            {
+                m_render_graph->AddPass("Pass_Outline", depth | RenderTarget_Gbuffer_Normal, depth | RenderTarget_Composition_Ldr, [this](RHI_CommandList* cmd_list) { Pass_Outline(cmd_list, m_render_targets[RenderTarget_Composition_Ldr]); });
+            }
+            m_render_graph->AddPass("Pass_Lines", 0, depth | RenderTarget_Composition_Ldr, [this](RHI_CommandList* cmd_list) { Pass_Lines(cmd_list, m_render_targets[RenderTarget_Composition_Ldr]); });
+            m_render_graph->AddPass("Pass_TransformHandle", 0, RenderTarget_Composition_Ldr, [this](RHI_CommandList* cmd_list) { Pass_TransformHandle(cmd_list, m_render_targets[RenderTarget_Composition_Ldr].get()); });
+            m_render_graph->AddPass("Pass_Icons", 0, RenderTarget_Composition_Ldr, [this](RHI_CommandList* cmd_list) { Pass_Icons(cmd_list, m_render_targets[RenderTarget_Composition_Ldr].get()); });
+            if (m_render_target_debug != 0)
+            {
+                m_render_graph->AddPass("Pass_DebugBuffer", m_render_target_debug, RenderTarget_Composition_Ldr, [this](RHI_CommandList* cmd_list) { Pass_DebugBuffer(cmd_list, m_render_targets[RenderTarget_Composition_Ldr]); });
+            }
+            m_render_graph->AddPass("Pass_Text", 0, RenderTarget_Composition_Ldr, [this](RHI_CommandList* cmd_list) { Pass_Text(cmd_list, m_render_targets[RenderTarget_Composition_Ldr].get()); });
         }
+
+        m_render_graph->Execute(cmd_list, outputs);
 	}
 
 	void Renderer::Pass_LightDepth(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type)
@@ -136,20 +262,41 @@ namespace Spartan
         // Opaque objects write their depth information to a depth buffer, using just a vertex shader.
         // Transparent objects, read the opaque depth but don't write their own, instead, they write their color information using a pixel shader.
 
-		// Acquire shader
-		RHI_Shader* shader_v = m_shaders[Shader_Depth_V].get();
-        RHI_Shader* shader_p = m_shaders[Shader_Depth_P].get();
+        const bool transparent_pass = object_type == Renderer_Object_Transparent;
+
+		// Acquire shaders, opaque objects read nothing but positions (models keep them in a stream of their own)
+		RHI_Shader* shader_v                    = m_shaders[transparent_pass ? Shader_Depth_V : Shader_Depth_Position_V].get();
+        RHI_Shader* shader_v_instanced          = m_shaders[transparent_pass ? Shader_Depth_Instanced_V : Shader_Depth_Position_Instanced_V].get();
+        RHI_Shader* shader_v_compact            = m_shaders[Shader_Depth_Compact_V].get();
+        RHI_Shader* shader_v_compact_instanced  = m_shaders[Shader_Depth_Compact_Instanced_V].get();
+        RHI_Shader* shader_v_skinned            = m_shaders[Shader_Depth_Skinned_V].get();
+        RHI_Shader* shader_v_skinned_instanced  = m_shaders[Shader_Depth_Skinned_Instanced_V].get();
+        RHI_Shader* shader_v_layered            = m_shaders[transparent_pass ? Shader_Depth_Layered_V : Shader_Depth_Position_Layered_V].get();
+        RHI_Shader* shader_v_compact_layered    = m_shaders[Shader_Depth_Compact_Layered_V].get();
+        RHI_Shader* shader_v_skinned_layered    = m_shaders[Shader_Depth_Skinned_Layered_V].get();
+        RHI_Shader* shader_v_displaced_instanced = m_shaders[Shader_Depth_Displaced_Instanced_V].get();
+        RHI_Shader* shader_v_displaced_layered  = m_shaders[Shader_Depth_Displaced_Layered_V].get();
+        RHI_Shader* shader_p                    = m_shaders[Shader_Depth_P].get();
 		if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
 			return;
+        const uint32_t vertex_stride = static_cast<uint32_t>(transparent_pass ? sizeof(RHI_Vertex_PosTexNorTan) : sizeof(RHI_Vertex_Pos));
 
-        // Get entities
-        const auto& entities = m_entities[object_type];
-        if (entities.empty())
-            return;
+        // Until the instanced shaders compile, every entity is drawn on its own
+        const bool instancing = shader_v_instanced->IsCompiled() && (!transparent_pass || shader_v_compact_instanced->IsCompiled()) && shader_v_skinned_instanced->IsCompiled();
 
-        const bool transparent_pass = object_type == Renderer_Object_Transparent;
+        // Layered rendering draws all the slices of a light in one pass, where the device lets the vertex shader pick the slice
+        const bool layered = instancing && m_rhi_device->IsLayeredRenderingSupported() && shader_v_layered->IsCompiled() && (!transparent_pass || shader_v_compact_layered->IsCompiled()) && shader_v_skinned_layered->IsCompiled();
+
+        // Get the instances
+        const auto& instances               = m_cull_instances[object_type];
+        const auto& instances_transparent   = m_cull_instances[Renderer_Object_Transparent];
+
+        // The opaque pass goes on without casters, slices which had some have to be cleared
+        if (transparent_pass && instances.empty())
+            return;
 
-        // Go through all of the lights
+        // Every light and array slice (cascade or cube face) gets a draw list
+        m_draw_list_count = 0;
 		const auto& entities_light = m_entities[Renderer_Object_Light];
         for (uint32_t light_index = 0; light_index < entities_light.size(); light_index++)
         {
@@ -165,14 +312,271 @@ namespace Spartan
 
             // Acquire light's shadow maps
             RHI_Texture* tex_depth = light->GetDepthTexture();
-            RHI_Texture* tex_color = light->GetColorTexture();
             if (!tex_depth)
                 continue;
 
+            // Lights which reach nothing in view (or only what's occluded) aren't lit either, their slices keep what they have until the light comes back
+            if (!IsLightVisible(light))
+            {
+                for (uint32_t array_index = 0; !transparent_pass && array_index < tex_depth->GetArraySize(); array_index++)
+                {
+                    const auto it = m_shadow_slice_cache.find(ShadowSliceKey(light, array_index));
+                    if (it != m_shadow_slice_cache.end())
+                    {
+                        it->second.frame_seen = m_frame_num + 1;
+                    }
+                }
+                continue;
+            }
+
+            for (uint32_t array_index = 0; array_index < tex_depth->GetArraySize(); array_index++)
+            {
+                DrawList& draw_list     = DrawListAdd();
+                draw_list.light         = light;
+                draw_list.array_index   = array_index;
+            }
+        }
+
+        // Cull the entities against every light in parallel, the lights only read the snapshot.
+        // The slices of a light are culled together, every caster is visited once and lands in all the slices (cascades or cube faces) it's visible to.
+        m_threading->ParallelFor([this, &instances, &instances_transparent, transparent_pass, object_type](uint32_t start, uint32_t end)
+        {
+            // The hash of a caster, combined with a sum so that the order of the casters doesn't matter.
+            // Skinned casters also change with their bones.
+            auto caster_hash = [](const Entity* entity)
+            {
+                size_t seed = 0;
+                Utility::Hash::hash_combine(seed, entity);
+                const float* matrix = entity->GetTransform()->GetMatrixRender().Data();
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    Utility::Hash::hash_combine(seed, matrix[i]);
+                }
+                for (const Matrix& bone : entity->GetRenderable()->GetBonePaletteRender())
+                {
+                    for (uint32_t i = 0; i < 16; i++)
+                    {
+                        Utility::Hash::hash_combine(seed, bone.Data()[i]);
+                    }
+                }
+                return static_cast<uint64_t>(seed);
+            };
+
+            for (uint32_t i = start; i < end; i++)
+            {
+                DrawList& draw_list = m_draw_lists[i];
+
+                // Slices after the first are filled by it, the signature holds the sum of the caster hashes until it's finalized below
+                const Light* light      = draw_list.light;
+                const bool directional  = light->GetLightType() == LightType_Directional;
+                if (draw_list.array_index != 0)
+                    continue;
+
+                uint32_t slice_count = 1;
+                while (i + slice_count < m_draw_list_count && m_draw_lists[i + slice_count].light == light)
+                {
+                    slice_count++;
+                }
+
+                // Visits the shadow casters with a bit per slice which they are visible to.
+                // Directional lights see most of the world and bring every caster to light space once, for all of their cascades.
+                // The others gather the casters within their range once, which are then tested against the frustum of every slice in a batch.
+                auto for_each_caster = [this, light, directional, slice_count, &draw_list](const vector<CullInstance>& list, const Renderer_Object_Type type, auto&& function)
+                {
+                    if (directional)
+                    {
+                        for (const CullInstance& instance : list)
+                        {
+                            if (!instance.casts_shadows)
+                                continue;
+
+                            const uint32_t mask = light->GetCascadeMask(instance.center, instance.extents);
+                            if (mask != 0)
+                            {
+                                function(instance, mask);
+                            }
+                        }
+                        return;
+                    }
+
+                    draw_list.cull_candidates.clear();
+                    draw_list.cull_boxes.Clear();
+                    BvhQuery([type, &draw_list](const CullInstance& instance, const Renderer_Object_Type instance_type)
+                    {
+                        if (instance_type == type && instance.casts_shadows)
+                        {
+                            draw_list.cull_candidates.emplace_back(&instance);
+                            draw_list.cull_boxes.Add(instance.center, instance.extents);
+                        }
+                    }, light->GetPositionRender(), light->GetRange());
+
+                    draw_list.cull_masks.assign(draw_list.cull_candidates.size(), 0);
+                    for (uint32_t slice = 0; slice < slice_count; slice++)
+                    {
+                        light->IsInViewFrustrum(draw_list.cull_boxes, slice, draw_list.cull_visible);
+                        for (uint32_t candidate = 0; candidate < static_cast<uint32_t>(draw_list.cull_candidates.size()); candidate++)
+                        {
+                            draw_list.cull_masks[candidate] |= draw_list.cull_visible[candidate] ? (1u << slice) : 0u;
+                        }
+                    }
+
+                    for (uint32_t candidate = 0; candidate < static_cast<uint32_t>(draw_list.cull_candidates.size()); candidate++)
+                    {
+                        if (draw_list.cull_masks[candidate] != 0)
+                        {
+                            function(*draw_list.cull_candidates[candidate], draw_list.cull_masks[candidate]);
+                        }
+                    }
+                };
+
+                for_each_caster(instances, object_type, [this, i, slice_count, &caster_hash](const CullInstance& instance, const uint32_t mask)
+                {
+                    const uint64_t key  = DrawKey(Renderer_Object_Opaque, 0, instance.key, instance.lod_shadow, 0.0f);
+                    const uint64_t hash = caster_hash(instance.entity);
+                    for (uint32_t slice = 0; slice < slice_count; slice++)
+                    {
+                        if (!(mask & (1u << slice)))
+                            continue;
+
+                        DrawList& draw_list_slice = m_draw_lists[i + slice];
+                        draw_list_slice.entities.emplace_back(instance.entity);
+                        draw_list_slice.keys.emplace_back(key);
+                        draw_list_slice.signature += hash;
+                    }
+                });
+
+                // The transparent pass draws on top of the opaque one, so the opaque pass decides for both
+                if (transparent_pass || !light->GetShadowsTransparentEnabled())
+                    continue;
+
+                for_each_caster(instances_transparent, Renderer_Object_Transparent, [this, i, slice_count, &caster_hash](const CullInstance& instance, const uint32_t mask)
+                {
+                    const uint64_t hash = caster_hash(instance.entity);
+                    for (uint32_t slice = 0; slice < slice_count; slice++)
+                    {
+                        if (mask & (1u << slice))
+                        {
+                            m_draw_lists[i + slice].signature += hash;
+                        }
+                    }
+                });
+            }
+        }, m_draw_list_count, 1);
+
+        // Batch the slices and finalize their signature
+        m_threading->ParallelFor([this, transparent_pass](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                DrawList& draw_list = m_draw_lists[i];
+                DrawListBatch(draw_list);
+
+                if (transparent_pass)
+                    continue;
+
+                size_t seed = 0;
+                Utility::Hash::hash_combine(seed, draw_list.signature);
+                const Matrix view_projection = draw_list.light->GetViewMatrix(draw_list.array_index) * draw_list.light->GetProjectionMatrix(draw_list.array_index);
+                for (uint32_t j = 0; j < 16; j++)
+                {
+                    Utility::Hash::hash_combine(seed, view_projection.Data()[j]);
+                }
+                draw_list.signature = static_cast<uint64_t>(seed);
+            }
+        }, m_draw_list_count, 1);
+
+        // Pick the slices to render, the transparent pass follows whatever the opaque pass did this frame
+        if (!transparent_pass)
+        {
+            ShadowSlicesSelect(layered);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < m_draw_list_count; i++)
+            {
+                DrawList& draw_list = m_draw_lists[i];
+                const auto it       = m_shadow_slice_cache.find(ShadowSliceKey(draw_list.light, draw_list.array_index));
+                draw_list.render    = it != m_shadow_slice_cache.end() && it->second.frame_rendered == m_frame_num + 1;
+            }
+        }
+
+        if (layered)
+        {
+            ShadowSlicesMerge();
+        }
+
+        // Upload the world matrices of every slice at once
+        uint32_t instance_offset = 0;
+        if (instancing)
+        {
+            m_instances_cpu.clear();
+            for (uint32_t i = 0; i < m_draw_list_count; i++)
+            {
+                DrawList& draw_list = m_draw_lists[i];
+                if (!draw_list.render)
+                    continue;
+
+                // Layered instances are transformed all the way to the slice they are in, which the first element of the second matrix carries
+                // (the next three carry the world position, displaced vertices sample their height map with it)
+                const bool draw_list_layered = draw_list.array_index == draw_list.light->GetDepthTexture()->GetArraySize();
+                array<Matrix, state_max_render_target_count> view_projections;
+                for (uint32_t slice = 0; draw_list_layered && slice < draw_list.array_index; slice++)
+                {
+                    view_projections[slice] = draw_list.light->GetViewMatrix(slice) * draw_list.light->GetProjectionMatrix(slice);
+                }
+
+                for (DrawBatch& batch : draw_list.batches)
+                {
+                    batch.instance_offset = static_cast<uint32_t>(m_instances_cpu.size());
+                    for (uint32_t entity_index = batch.entity_start; entity_index < batch.entity_start + batch.entity_count; entity_index++)
+                    {
+                        Entity* entity                  = draw_list.entities[entity_index];
+                        const Matrix& world             = entity->GetTransform()->GetMatrixRender();
+                        const vector<Matrix>& locals    = entity->GetRenderable()->GetInstances();
+                        const uint32_t slice            = static_cast<uint32_t>(draw_list.keys[entity_index] & 0xFFFF);
+                        const uint32_t count            = locals.empty() ? 1 : static_cast<uint32_t>(locals.size());
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            const Matrix transform = locals.empty() ? world : locals[i] * world;
+                            if (!draw_list_layered)
+                            {
+                                m_instances_cpu.emplace_back(transform, Matrix::Identity);
+                                continue;
+                            }
+
+                            const Vector3 position          = transform.GetTranslation();
+                            RHI_Vertex_Instance& instance   = m_instances_cpu.emplace_back(transform * view_projections[slice], Matrix::Identity);
+                            instance.wvp_previous[0]        = static_cast<float>(slice);
+                            instance.wvp_previous[1]        = position.x;
+                            instance.wvp_previous[2]        = position.y;
+                            instance.wvp_previous[3]        = position.z;
+                        }
+                    }
+                    batch.instance_count = static_cast<uint32_t>(m_instances_cpu.size()) - batch.instance_offset;
+                }
+            }
+
+            if (!UpdateInstanceBuffer(cmd_list, instance_offset))
+                return;
+        }
+
+        // Record the slices in order
+        for (uint32_t i = 0; i < m_draw_list_count; i++)
+        {
+            const DrawList& draw_list   = m_draw_lists[i];
+            if (!draw_list.render)
+                continue;
+
+            const Light* light          = draw_list.light;
+            const uint32_t array_index  = draw_list.array_index;
+            RHI_Texture* tex_depth      = light->GetDepthTexture();
+            RHI_Texture* tex_color      = light->GetColorTexture();
+            const bool draw_list_layered = array_index == tex_depth->GetArraySize();
+
             // Set render state
             static RHI_PipelineState pipeline_state;
-            pipeline_state.shader_vertex                    = shader_v;
-            pipeline_state.vertex_buffer_stride             = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)); // assume all vertex buffers have the same stride (which they do)
+            pipeline_state.shader_vertex                    = draw_list_layered ? shader_v_layered : (instancing ? shader_v_instanced : shader_v); // switched when a batch has another vertex layout
+            pipeline_state.vertex_buffer_stride             = vertex_stride;
             pipeline_state.shader_pixel                     = transparent_pass ? shader_p : nullptr;
             pipeline_state.blend_state                      = transparent_pass ? m_blend_alpha.get() : m_blend_disabled.get();
             pipeline_state.depth_stencil_state              = transparent_pass ? m_depth_stencil_on_off_r.get() : m_depth_stencil_on_off_w.get();
@@ -183,346 +587,701 @@ namespace Spartan
             pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
             pipeline_state.pass_name                        = transparent_pass ? "Pass_LightDepthTransparent" : "Pass_LightDepth";
 
-            for (uint32_t array_index = 0; array_index < tex_depth->GetArraySize(); array_index++)
+            // Set render target texture array index
+            pipeline_state.render_target_color_texture_array_index          = array_index;
+            pipeline_state.render_target_depth_stencil_texture_array_index  = array_index;
+
+            // Set clear values
+            pipeline_state.clear_color[0] = Vector4::One;
+            pipeline_state.clear_depth    = transparent_pass ? state_depth_load : GetClearDepth();
+
+            // Layered instances carry their whole transform
+            const Matrix view_projection = draw_list_layered ? Matrix::Identity : light->GetViewMatrix(array_index) * light->GetProjectionMatrix(array_index);
+
+            // Set appropriate rasterizer state
+            if (light->GetLightType() == LightType_Directional)
+            {
+                // "Pancaking" - https://www.gamedev.net/forums/topic/639036-shadow-mapping-and-high-up-objects/
+                // It's basically a way to capture the silhouettes of potential shadow casters behind the light's view point.
+                // Of course we also have to make sure that the light doesn't cull them in the first place (this is done automatically by the light)
+                pipeline_state.rasterizer_state = m_rasterizer_cull_back_solid_no_clip.get();
+            }
+            else
             {
-                // Set render target texture array index
-                pipeline_state.render_target_color_texture_array_index          = array_index;
-                pipeline_state.render_target_depth_stencil_texture_array_index  = array_index;
+                pipeline_state.rasterizer_state = m_rasterizer_cull_back_solid.get();
+            }
 
-                // Set clear values
-                pipeline_state.clear_color[0] = Vector4::One;
-                pipeline_state.clear_depth    = transparent_pass ? state_depth_load : GetClearDepth();
+            // State tracking
+            bool render_pass_active         = false;
+            uint32_t vertex_layout_bound    = 0;
+            uint32_t m_set_material_id      = 0;
 
-                const Matrix& view_projection = light->GetViewMatrix(array_index) * light->GetProjectionMatrix(array_index);
+            for (const DrawBatch& batch : draw_list.batches)
+            {
+                Renderable* renderable      = draw_list.entities[batch.entity_start]->GetRenderable();
+                const auto& model           = renderable->GeometryModel();
+                const auto& material        = renderable->GetMaterial();
+                const uint32_t lod          = DrawKeyLod(draw_list.keys[batch.entity_start]);
+                const uint32_t index_count  = renderable->GeometryLodIndexCount(lod);
+                const uint32_t index_offset = renderable->GeometryLodIndexOffset(lod);
+                const bool vertex_skinned   = model->IsVertexSkinned();
+                const bool vertex_compact   = transparent_pass && model->IsVertexCompact(); // the position stream is the same for either
+                const bool vertex_displaced = model->IsVertexDisplaced();
+                const uint32_t vertex_layout = vertex_skinned ? 2 : (vertex_displaced ? 3 : (vertex_compact ? 1 : 0));
+
+                // Models with compact or skinned vertices wait for their shader, displaced ones are only drawn instanced (the instance carries where they sample)
+                if ((vertex_compact && !shader_v_compact->IsCompiled()) || (vertex_skinned && !shader_v_skinned->IsCompiled()))
+                    continue;
+                if (vertex_displaced && (transparent_pass || !instancing || !(draw_list_layered ? shader_v_displaced_layered : shader_v_displaced_instanced)->IsCompiled()))
+                    continue;
 
-                // Set appropriate rasterizer state
-                if (light->GetLightType() == LightType_Directional)
+                // The vertex layout switches three times at most, compact vertices sort after the full ones, then skinned and displaced ones (see DrawKey())
+                if (!render_pass_active || vertex_layout != vertex_layout_bound)
+                {
+                    if (render_pass_active)
+                    {
+                        cmd_list->EndRenderPass();
+
+                        // Keep what the previous vertex layout drew
+                        pipeline_state.clear_color[0]   = state_color_load;
+                        pipeline_state.clear_depth      = state_depth_load;
+                    }
+
+                    if (vertex_skinned)
+                    {
+                        pipeline_state.shader_vertex        = draw_list_layered ? shader_v_skinned_layered : (instancing ? shader_v_skinned_instanced : shader_v_skinned);
+                        pipeline_state.vertex_buffer_stride = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTanSkin));
+                    }
+                    else if (vertex_displaced)
+                    {
+                        pipeline_state.shader_vertex        = draw_list_layered ? shader_v_displaced_layered : shader_v_displaced_instanced;
+                        pipeline_state.vertex_buffer_stride = static_cast<uint32_t>(sizeof(RHI_Vertex_Pos));
+                    }
+                    else if (vertex_compact)
+                    {
+                        pipeline_state.shader_vertex        = draw_list_layered ? shader_v_compact_layered : (instancing ? shader_v_compact_instanced : shader_v_compact);
+                        pipeline_state.vertex_buffer_stride = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTanCompact));
+                    }
+                    else
+                    {
+                        pipeline_state.shader_vertex        = draw_list_layered ? shader_v_layered : (instancing ? shader_v_instanced : shader_v);
+                        pipeline_state.vertex_buffer_stride = vertex_stride;
+                    }
+
+                    render_pass_active      = cmd_list->BeginRenderPass(pipeline_state);
+                    vertex_layout_bound     = vertex_layout;
+                    m_set_material_id       = 0;
+
+                    if (!render_pass_active)
+                        continue;
+
+                    // The instances only need the light's view projection
+                    if (instancing)
+                    {
+                        cmd_list->SetBufferInstance(m_buffer_instance_gpu.get());
+                        m_buffer_object_cpu.object = view_projection;
+                        UpdateObjectBuffer(cmd_list);
+                    }
+                }
+
+                // The bounds which compact positions are normalized to
+                if (vertex_compact)
                 {
-                    // "Pancaking" - https://www.gamedev.net/forums/topic/639036-shadow-mapping-and-high-up-objects/
-                    // It's basically a way to capture the silhouettes of potential shadow casters behind the light's view point.
-                    // Of course we also have to make sure that the light doesn't cull them in the first place (this is done automatically by the light)
-                    pipeline_state.rasterizer_state = m_rasterizer_cull_back_solid_no_clip.get();
+                    m_buffer_draw_cpu.position_offset   = model->GetVertexPositionOffset();
+                    m_buffer_draw_cpu.position_scale    = model->GetVertexPositionScale();
                 }
-                else
+
+                // The height map which displaced vertices are lifted by
+                if (vertex_displaced)
                 {
-                    pipeline_state.rasterizer_state = m_rasterizer_cull_back_solid.get();
+                    m_buffer_draw_cpu.displacement_uv_scale_offset  = model->GetVertexDisplacementUvScaleOffset();
+                    m_buffer_draw_cpu.displacement_height           = model->GetVertexDisplacementHeight();
+                    cmd_list->SetTexture(34, model->GetVertexDisplacementMap(), RHI_Shader_Vertex);
                 }
 
-                // State tracking
-                bool render_pass_active     = false;
-                uint32_t m_set_material_id  = 0;
+                if (!UpdateDrawBuffer(cmd_list))
+                    continue;
+
+                // Skinned entities are batches of their own, the palette was uploaded by whichever pass drew them first this frame
+                if (vertex_skinned && !UpdateSkinBuffer(cmd_list, renderable))
+                    continue;
 
-                for (uint32_t entity_index = 0; entity_index < static_cast<uint32_t>(entities.size()); entity_index++)
+                // Bind material
+                if (transparent_pass && m_set_material_id != material->GetId())
                 {
-                    Entity* entity = entities[entity_index];
+                    // Bind material textures
+                    RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
+                    cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
 
-                    // Acquire renderable component
-                    const auto& renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
+                    // Update uber buffer with material properties
+                    m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
+                    m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
+                    m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
 
-                    // Skip meshes that don't cast shadows
-                    if (!renderable->GetCastShadows())
-                        continue;
+                    // Update constant buffer
+                    UpdateUberBuffer(cmd_list);
 
-                    // Acquire geometry
-                    const auto& model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                        continue;
+                    m_set_material_id = material->GetId();
+                }
 
-                    // Acquire material
-                    const auto& material = renderable->GetMaterial();
-                    if (!material)
+                // Bind geometry
+                cmd_list->SetBufferIndex(model->GetIndexBuffer());
+                cmd_list->SetBufferVertex(transparent_pass || vertex_skinned ? model->GetVertexBuffer() : model->GetVertexBufferPosition());
+
+                if (instancing)
+                {
+                    // A lone instance culls its meshlets against the slice, layered draws go to every slice so they can't
+                    const bool instance_lone = !draw_list_layered && batch.instance_count == 1 && batch.entity_count == 1;
+                    if (!instance_lone || !DrawMeshlets(cmd_list, renderable, draw_list.entities[batch.entity_start]->GetTransform()->GetMatrixRender(), lod, light, array_index, instance_offset + batch.instance_offset))
+                    {
+                        cmd_list->DrawIndexed(index_count, index_offset, renderable->GeometryVertexOffset(), batch.instance_count, instance_offset + batch.instance_offset);
+                    }
+                    continue;
+                }
+
+                for (uint32_t entity_index = batch.entity_start; entity_index < batch.entity_start + batch.entity_count; entity_index++)
+                {
+                    // Renderables which carry instances are only drawn instanced
+                    if (draw_list.entities[entity_index]->GetRenderable()->HasInstances())
                         continue;
 
-                    // Skip objects outside of the view frustum
-                    if (!light->IsInViewFrustrum(renderable, array_index))
+                    // Update uber buffer with cascade transform
+                    const Matrix& transform = draw_list.entities[entity_index]->GetTransform()->GetMatrixRender();
+                    m_buffer_object_cpu.object = transform * view_projection;
+                    if (!UpdateObjectBuffer(cmd_list))
                         continue;
 
-                    if (!render_pass_active)
+                    if (!DrawMeshlets(cmd_list, renderable, transform, lod, light, array_index))
                     {
-                        render_pass_active = cmd_list->BeginRenderPass(pipeline_state);
+                        cmd_list->DrawIndexed(index_count, index_offset, renderable->GeometryVertexOffset());
                     }
+                }
+            }
 
-                    // Bind material
-                    if (transparent_pass && m_set_material_id != material->GetId())
-                    {
-                        // Bind material textures
-                        RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
-                        cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
+            // A slice without casters still has to be cleared
+            if (!render_pass_active && !transparent_pass)
+            {
+                render_pass_active = cmd_list->BeginRenderPass(pipeline_state);
+            }
 
-                        // Update uber buffer with material properties
-                        m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
-                        m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
-                        m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
+            if (render_pass_active)
+            {
+                cmd_list->EndRenderPass();
+            }
+        }
+	}
 
-                        // Update constant buffer
-                        UpdateUberBuffer(cmd_list);
+    // Materials whose pixels the g-buffer discards, by their mask or by the alpha of their albedo
+    static bool depth_prepass_masked(Material* material)
+    {
+        RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
+        return material->HasTexture(Material_Mask) || (tex_albedo && tex_albedo->GetTransparency());
+    }
 
-                        m_set_material_id = material->GetId();
-                    }
+    // Whether the depth pre-pass draws a batch of the g-buffer, if it doesn't the g-buffer writes its depth. Masked materials can't discard
+    // the same pixels when parallax mapping moves their uv, or when their vertices are displaced (the depth shader only gets their positions).
+    static bool depth_prepass_draws(Material* material, const Model* model)
+    {
+        return !depth_prepass_masked(material) || (!material->HasTexture(Material_Height) && !model->IsVertexDisplaced());
+    }
 
-                    // Bind geometry
-                    cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                    cmd_list->SetBufferVertex(model->GetVertexBuffer());
+    bool Renderer::Pass_DepthPrePass(RHI_CommandList* cmd_list, const DrawList& draw_list, const uint32_t instance_offset)
+    {
+        // Description: The opaque batches of the g-buffer are drawn with their depth only, the g-buffer then tests for
+        // equality without writing depth, so every pixel is shaded once. The instances were uploaded by the g-buffer,
+        // and the vertex shaders transform them the same way as the g-buffer's do, which the equality test relies on.
 
-                    // Update uber buffer with cascade transform
-                    m_buffer_object_cpu.object = entity->GetTransform()->GetMatrix() * view_projection;
-                    if (!UpdateObjectBuffer(cmd_list))
-                        continue;
+        // Acquire required resources/shaders
+        RHI_Texture* tex_depth                  = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+        RHI_Shader* shader_v_position           = m_shaders[Shader_Depth_Position_Instanced_V].get();
+        RHI_Shader* shader_v                    = m_shaders[Shader_Depth_Instanced_V].get();
+        RHI_Shader* shader_v_compact            = m_shaders[Shader_Depth_Compact_Instanced_V].get();
+        RHI_Shader* shader_v_skinned            = m_shaders[Shader_Depth_Skinned_Instanced_V].get();
+        RHI_Shader* shader_v_displaced          = m_shaders[Shader_Depth_Displaced_Instanced_V].get();
+        RHI_Shader* shader_p_alpha_test         = m_shaders[Shader_Depth_AlphaTest_P].get();
+
+        // Until the shaders compile, the g-buffer writes depth itself (and it rasterizes wireframes differently)
+        if (!shader_v_position->IsCompiled() || !shader_v->IsCompiled() || !shader_v_compact->IsCompiled() || !shader_v_skinned->IsCompiled() || !shader_v_displaced->IsCompiled() || !shader_p_alpha_test->IsCompiled())
+            return false;
+        if (GetOption(Render_Debug_Wireframe))
+            return false;
+
+        // Set render state
+        RHI_PipelineState pso;
+        pso.rasterizer_state            = m_rasterizer_cull_back_solid.get();
+        pso.blend_state                 = m_blend_disabled.get();
+        pso.depth_stencil_state         = m_depth_stencil_on_off_w.get();
+        pso.render_target_depth_texture = tex_depth;
+        pso.clear_depth                 = GetClearDepth();
+        pso.clear_stencil               = 0;
+        pso.viewport                    = tex_depth->GetViewport();
+        pso.primitive_topology          = RHI_PrimitiveTopology_TriangleList;
+        pso.pass_name                   = "Pass_DepthPrePass";
+
+        // Record the batches in the g-buffer's order, a render pass per vertex layout and whether the material is masked
+        bool cleared                    = false;
+        bool render_pass_active         = false;
+        uint32_t vertex_layout_bound    = 0;
+        bool masked_bound               = false;
+        uint32_t material_bound_id      = 0;
+        for (const DrawBatch& batch : draw_list.batches)
+        {
+            Renderable* renderable      = draw_list.entities[batch.entity_start]->GetRenderable();
+            Material* material          = renderable->GetMaterial();
+            const Model* model          = renderable->GeometryModel();
+            if (!depth_prepass_draws(material, model))
+                continue;
+
+            const uint32_t lod          = DrawKeyLod(draw_list.keys[batch.entity_start]);
+            const uint32_t index_count  = renderable->GeometryLodIndexCount(lod);
+            const uint32_t index_offset = renderable->GeometryLodIndexOffset(lod);
+            const bool vertex_compact   = model->IsVertexCompact();
+            const bool vertex_skinned   = model->IsVertexSkinned();
+            const bool vertex_displaced = model->IsVertexDisplaced();
+            const uint32_t vertex_layout = vertex_skinned ? 2 : (vertex_displaced ? 3 : (vertex_compact ? 1 : 0));
+            const bool masked           = depth_prepass_masked(material);
+
+            // Switch shaders
+            if (!render_pass_active || vertex_layout != vertex_layout_bound || masked != masked_bound)
+            {
+                if (render_pass_active)
+                {
+                    cmd_list->EndRenderPass();
+                }
+
+                // Compact vertices are decoded like the g-buffer decodes them (their position stream was decoded on the CPU), full vertices only
+                // need the position stream unless the material is masked. Skinned vertices come whole, displaced ones as positions (never masked).
+                if (vertex_skinned)
+                {
+                    pso.shader_vertex           = shader_v_skinned;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTanSkin));
+                }
+                else if (vertex_displaced)
+                {
+                    pso.shader_vertex           = shader_v_displaced;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_Pos));
+                }
+                else if (vertex_compact)
+                {
+                    pso.shader_vertex           = shader_v_compact;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTanCompact));
+                }
+                else
+                {
+                    pso.shader_vertex           = masked ? shader_v : shader_v_position;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(masked ? sizeof(RHI_Vertex_PosTexNorTan) : sizeof(RHI_Vertex_Pos));
+                }
+                pso.shader_pixel = masked ? shader_p_alpha_test : nullptr;
 
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                render_pass_active  = cmd_list->BeginRenderPass(pso);
+                vertex_layout_bound = vertex_layout;
+                masked_bound        = masked;
+                material_bound_id   = 0;
 
-                }
+                if (!render_pass_active)
+                    continue;
 
-                if (render_pass_active)
+                // Clear only on first pass
+                if (!cleared)
                 {
-                    cmd_list->EndRenderPass();
+                    pso.ResetClearValues();
+                    cleared = true;
                 }
-            }
-        }
-	}
-
-    void Renderer::Pass_DepthPrePass(RHI_CommandList* cmd_list)
-    {
-        // Description: All the opaque meshes are rendered, outputting
-        // just their depth information into a depth map.
 
-        // Acquire required resources/data
-        const auto& shader_depth    = m_shaders[Shader_Depth_V];
-        const auto& tex_depth       = m_render_targets[RenderTarget_Gbuffer_Depth];
-        const auto& entities        = m_entities[Renderer_Object_Opaque];
+                // The instances only need the camera's view projection
+                cmd_list->SetBufferInstance(m_buffer_instance_gpu.get());
+                m_buffer_object_cpu.object = m_buffer_frame_cpu.view_projection;
+                UpdateObjectBuffer(cmd_list);
+            }
 
-        // Ensure the shader has compiled
-        if (!shader_depth->IsCompiled())
-            return;
+            // Set geometry (will only happen if not already set)
+            const bool vertex_positions = vertex_displaced || (!vertex_compact && !vertex_skinned && !masked);
+            cmd_list->SetBufferIndex(model->GetIndexBuffer());
+            cmd_list->SetBufferVertex(vertex_positions ? model->GetVertexBufferPosition() : model->GetVertexBuffer());
 
-        // Set render state
-        static RHI_PipelineState pipeline_state;
-        pipeline_state.shader_vertex                = shader_depth.get();
-        pipeline_state.shader_pixel                 = nullptr;
-        pipeline_state.rasterizer_state             = m_rasterizer_cull_back_solid.get();
-        pipeline_state.blend_state                  = m_blend_disabled.get();
-        pipeline_state.depth_stencil_state          = m_depth_stencil_on_off_w.get();
-        pipeline_state.render_target_depth_texture  = tex_depth.get();
-        pipeline_state.clear_depth                  = GetClearDepth();
-        pipeline_state.viewport                     = tex_depth->GetViewport();
-        pipeline_state.primitive_topology           = RHI_PrimitiveTopology_TriangleList;
-        pipeline_state.pass_name                    = "Pass_DepthPrePass";
+            // The bounds which compact positions are normalized to
+            m_buffer_draw_cpu.position_offset   = model->GetVertexPositionOffset();
+            m_buffer_draw_cpu.position_scale    = model->GetVertexPositionScale();
 
-        // Record commands
-        if (cmd_list->BeginRenderPass(pipeline_state))
-        { 
-            if (!entities.empty())
+            // The height map which displaced vertices are lifted by
+            if (vertex_displaced)
             {
-                // Variables that help reduce state changes
-                uint32_t currently_bound_geometry = 0;
+                m_buffer_draw_cpu.displacement_uv_scale_offset  = model->GetVertexDisplacementUvScaleOffset();
+                m_buffer_draw_cpu.displacement_height           = model->GetVertexDisplacementHeight();
+                cmd_list->SetTexture(34, model->GetVertexDisplacementMap(), RHI_Shader_Vertex);
+            }
 
-                // Draw opaque
-                for (const auto& entity : entities)
-                {
-                    // Get renderable
-                    const auto& renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
+            if (!UpdateDrawBuffer(cmd_list))
+                continue;
 
-                    // Get geometry
-                    const auto& model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                        continue;
+            // Skinned entities are batches of their own, the palette was uploaded by whichever pass drew them first this frame
+            if (vertex_skinned && !UpdateSkinBuffer(cmd_list, renderable))
+                continue;
 
-                    // Skip objects outside of the view frustum
-                    if (!m_camera->IsInViewFrustrum(renderable))
-                        continue;
+            // Masked materials discard with their albedo and mask
+            if (masked && material_bound_id != material->GetId())
+            {
+                RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
+                RHI_Texture* tex_mask   = material->GetTexture_Ptr(Material_Mask);
+                cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
+                cmd_list->SetTexture(29, tex_mask ? tex_mask : m_tex_white.get());
 
-                    // Bind geometry
-                    if (currently_bound_geometry != model->GetId())
-                    {
-                        cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                        cmd_list->SetBufferVertex(model->GetVertexBuffer());
-                        currently_bound_geometry = model->GetId();
-                    }
+                m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
+                m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
+                UpdateUberBuffer(cmd_list);
 
-                    // Update uber buffer with entity transform
-                    if (Transform* transform = entity->GetTransform())
-                    {
-                        // Update uber buffer with cascade transform
-                        m_buffer_uber_cpu.transform = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                        UpdateUberBuffer(cmd_list);
-                    }
+                material_bound_id = material->GetId();
+            }
 
-                    // Draw	
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
-                }
+            // Render all the instances at once, a lone instance culls its meshlets (the same ones as the g-buffer does)
+            const bool instance_lone = batch.instance_count == 1 && batch.entity_count == 1;
+            if (!instance_lone || !DrawMeshlets(cmd_list, renderable, draw_list.entities[batch.entity_start]->GetTransform()->GetMatrixRender(), lod, nullptr, 0, instance_offset + batch.instance_offset))
+            {
+                cmd_list->DrawIndexed(index_count, index_offset, renderable->GeometryVertexOffset(), batch.instance_count, instance_offset + batch.instance_offset);
             }
+        }
+
+        if (render_pass_active)
+        {
             cmd_list->EndRenderPass();
         }
+
+        return cleared;
     }
 
 	void Renderer::Pass_GBuffer(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type)
 	{
+        // Opaque objects fill the g-buffer, transparent objects use the forward variations of the same shaders and are shaded right away
+
         // Acquire required resources/shaders
-        RHI_Texture* tex_albedo       = m_render_targets[RenderTarget_Gbuffer_Albedo].get();
-        RHI_Texture* tex_normal       = m_render_targets[RenderTarget_Gbuffer_Normal].get();
-        RHI_Texture* tex_material     = m_render_targets[RenderTarget_Gbuffer_Material].get();
-        RHI_Texture* tex_velocity     = m_render_targets[RenderTarget_Gbuffer_Velocity].get();
-        RHI_Texture* tex_depth        = m_render_targets[RenderTarget_Gbuffer_Depth].get();
-        RHI_Shader* shader_v          = m_shaders[Shader_Gbuffer_V].get();
-        ShaderGBuffer* shader_p       = static_cast<ShaderGBuffer*>(m_shaders[Shader_Gbuffer_P].get());
+        RHI_Texture* tex_albedo         = m_render_targets[RenderTarget_Gbuffer_Albedo].get();
+        RHI_Texture* tex_normal         = m_render_targets[RenderTarget_Gbuffer_Normal].get();
+        RHI_Texture* tex_material       = m_render_targets[RenderTarget_Gbuffer_Material].get();
+        RHI_Texture* tex_velocity       = m_render_targets[RenderTarget_Gbuffer_Velocity].get();
+        RHI_Texture* tex_depth          = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+        RHI_Shader* shader_v                    = m_shaders[Shader_Gbuffer_V].get();
+        RHI_Shader* shader_v_instanced          = m_shaders[Shader_Gbuffer_Instanced_V].get();
+        RHI_Shader* shader_v_compact            = m_shaders[Shader_Gbuffer_Compact_V].get();
+        RHI_Shader* shader_v_compact_instanced  = m_shaders[Shader_Gbuffer_Compact_Instanced_V].get();
+        RHI_Shader* shader_v_skinned            = m_shaders[Shader_Gbuffer_Skinned_V].get();
+        RHI_Shader* shader_v_skinned_instanced  = m_shaders[Shader_Gbuffer_Skinned_Instanced_V].get();
+        RHI_Shader* shader_v_displaced          = m_shaders[Shader_Gbuffer_Displaced_V].get();
+        RHI_Shader* shader_v_displaced_instanced = m_shaders[Shader_Gbuffer_Displaced_Instanced_V].get();
+        ShaderGBuffer* shader_p                 = static_cast<ShaderGBuffer*>(m_shaders[Shader_Gbuffer_P].get());
+        RHI_Shader* shader_impostor_v           = m_shaders[Shader_Impostor_V].get();
+        RHI_Shader* shader_impostor_p           = m_shaders[Shader_Impostor_P].get();
 
         // Validate that the shader has compiled
         if (!shader_v->IsCompiled())
             return;
 
-        // Clear values that depend on the objects being opaque or transparent
-        const bool is_transparent = object_type == Renderer_Object_Transparent;
+        // Until the instanced shaders compile, every entity is drawn on its own
+        const bool instancing = shader_v_instanced->IsCompiled() && shader_v_compact_instanced->IsCompiled() && shader_v_skinned_instanced->IsCompiled() && shader_v_displaced_instanced->IsCompiled();
+
+        // Transparent objects are tested against the opaque depth without writing it, they either blend into the composition (back to front)
+        // or accumulate for weighted blended order independent transparency
+        const bool is_transparent       = object_type == Renderer_Object_Transparent;
+        const bool oit                  = is_transparent && GetOption(Render_TransparentOit);
+        const uint16_t variation_flags  = !is_transparent ? 0 : (oit ? ShaderGBuffer_Forward_Oit : ShaderGBuffer_Forward);
+
+        // Impostors only write the g-buffer, and come as instances of a quad
+        const bool impostors = !is_transparent && instancing && shader_impostor_v->IsCompiled() && shader_impostor_p->IsCompiled();
+        m_impostor_draws.clear();
+        m_impostor_batches.clear();
 
         // Set render state
         RHI_PipelineState pso;
-        pso.shader_vertex                   = shader_v;
-        pso.vertex_buffer_stride            = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)); // assume all vertex buffers have the same stride (which they do)
-        pso.blend_state                     = m_blend_disabled.get();
         pso.rasterizer_state                = GetOption(Render_Debug_Wireframe) ? m_rasterizer_cull_back_wireframe.get() : m_rasterizer_cull_back_solid.get();
-        pso.depth_stencil_state             = is_transparent ? m_depth_stencil_on_on_w.get() : m_depth_stencil_on_off_w.get(); // GetOptionValue(Render_DepthPrepass) is not accounted for anymore, have to fix
-        pso.render_target_color_textures[0] = tex_albedo;
-        pso.clear_color[0]                  = !is_transparent ? Vector4::Zero : state_color_load;
-        pso.render_target_color_textures[1] = tex_normal;
-        pso.clear_color[1]                  = !is_transparent ? Vector4::Zero : state_color_load;
-        pso.render_target_color_textures[2] = tex_material;
-        pso.clear_color[2]                  = !is_transparent ? Vector4::Zero : state_color_load;
-        pso.render_target_color_textures[3] = tex_velocity;
-        pso.clear_color[3]                  = !is_transparent ? Vector4::Zero : state_color_load;
         pso.render_target_depth_texture     = tex_depth;
-        pso.clear_depth                     = is_transparent || GetOption(Render_DepthPrepass) ? state_depth_load : GetClearDepth();
-        pso.clear_stencil                   = 0;
         pso.viewport                        = tex_albedo->GetViewport();
         pso.primitive_topology              = RHI_PrimitiveTopology_TriangleList;
+        pso.compile_async                   = true; // new material permutations shouldn't stall the frame, their entities show up once compiled
+        if (!is_transparent)
+        {
+            pso.blend_state                     = m_blend_disabled.get();
+            pso.depth_stencil_state             = m_depth_stencil_on_off_w.get();
+            pso.render_target_color_textures[0] = tex_albedo;
+            pso.clear_color[0]                  = Vector4::Zero;
+            pso.render_target_color_textures[1] = tex_normal;
+            pso.clear_color[1]                  = Vector4::Zero;
+            pso.render_target_color_textures[2] = tex_material;
+            pso.clear_color[2]                  = Vector4::Zero;
+            pso.render_target_color_textures[3] = tex_velocity;
+            pso.clear_color[3]                  = Vector4::Zero;
+            pso.clear_depth                     = GetClearDepth();
+            pso.clear_stencil                   = 0;
+        }
+        else
+        {
+            pso.depth_stencil_state                     = m_depth_stencil_on_off_r.get();
+            pso.render_target_depth_texture_read_only   = true;
+            pso.clear_depth                             = state_depth_load;
+            pso.clear_stencil                           = state_stencil_load;
+
+            if (oit)
+            {
+                pso.blend_state                     = m_blend_transparent_oit.get();
+                pso.render_target_color_textures[0] = m_render_targets[RenderTarget_Transparent_Accumulation].get();
+                pso.clear_color[0]                  = Vector4(0.0f, 0.0f, 0.0f, 1.0f); // nothing accumulated, everything revealed
+                pso.render_target_color_textures[1] = m_render_targets[RenderTarget_Transparent_Weight].get();
+                pso.clear_color[1]                  = Vector4::Zero;
+            }
+            else
+            {
+                pso.blend_state                     = m_blend_alpha.get();
+                pso.render_target_color_textures[0] = m_render_targets[RenderTarget_Composition_Hdr].get();
+                pso.clear_color[0]                  = state_color_load;
+            }
+        }
 
         bool cleared = false;
-        uint32_t material_index = 0;
         uint32_t material_bound_id = 0;
-        m_material_instances.fill(nullptr);
+        uint32_t material_slot = 0;
 
-        // Iterate through all the G-Buffer shader variations
+        // Every compiled G-Buffer shader variation (of this pass' output) gets a number, which goes into the draw key
+        m_draw_list_lookup.clear();
+        m_draw_key_shaders.clear();
         for (const auto& it : ShaderGBuffer::GetVariations())
         {
             // Skip the shader until it compiles or the users spots a compilation error
-            if (!it.second->IsCompiled())
+            if (!it.second->IsCompiled() || (it.first & (ShaderGBuffer_Forward | ShaderGBuffer_Forward_Oit)) != variation_flags)
                 continue;
 
-            // Set pixel shader
-            pso.shader_pixel = static_cast<RHI_Shader*>(it.second.get());
+            if (m_draw_key_shaders.size() == draw_key_variation_count)
+            {
+                LOG_WARNING("The draw key can't tell more than %d shader variations apart, some entities will not be drawn", draw_key_variation_count);
+                break;
+            }
 
-            // Set pass name
-            pso.pass_name = pso.shader_pixel->GetName().c_str();
+            m_draw_list_lookup[it.first] = static_cast<uint32_t>(m_draw_key_shaders.size());
+            m_draw_key_shaders.emplace_back(static_cast<RHI_Shader*>(it.second.get()));
+        }
 
-            bool render_pass_active = false;
-            auto& entities = m_entities[object_type];
+        // Key the visible instances, their centers are already at hand so the depth costs next to nothing
+        m_draw_list_count               = 0;
+        DrawList& draw_list             = DrawListAdd();
+        const Vector3 camera_position   = m_buffer_frame_cpu.camera_position;
+        const auto& instances           = m_cull_instances[object_type];
+        for (const uint32_t instance_index : m_cull_visible[object_type])
+        {
+            const CullInstance& instance = instances[instance_index];
 
-            // Record commands
-            for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+            // Skip objects whose shader variation isn't available (yet), materials only ask for their g-buffer variation so the forward ones are asked for here
+            const auto it = m_draw_list_lookup.find(instance.flags | variation_flags);
+            if (it == m_draw_list_lookup.end())
             {
-                Entity* entity = entities[i];
+                if (is_transparent)
+                {
+                    ShaderGBuffer::GenerateVariation(m_context, instance.flags | variation_flags);
+                }
+                continue;
+            }
 
-                // Get renderable
-                const auto& renderable = entity->GetRenderable();
-                if (!renderable)
-                    continue;
+            // Same for the vertex shaders of compact, skinned and displaced vertices
+            const Model* model = instance.entity->GetRenderable()->GeometryModel();
+            if ((!shader_v_compact->IsCompiled() && model->IsVertexCompact()) || (!shader_v_skinned->IsCompiled() && model->IsVertexSkinned()) || (!shader_v_displaced->IsCompiled() && model->IsVertexDisplaced()))
+                continue;
 
-                // Get material
-                Material* material = renderable->GetMaterial();
-                if (!material)
-                    continue;
+            // Skip transparent objects that won't contribute
+            if (is_transparent && instance.entity->GetRenderable()->GetMaterial()->GetColorAlbedo().w == 0)
+                continue;
 
-                // Skip objects with different shader requirements
-                if (!static_cast<ShaderGBuffer*>(pso.shader_pixel)->IsSuitable(material->GetFlags()))
+            // Far enough away, the impostor stands in (skinned and displaced vertices don't keep the shape they were baked with)
+            const Renderable* renderable = instance.entity->GetRenderable();
+            const float impostor_distance = renderable->GetImpostorDistance();
+            if (impostors && impostor_distance > 0.0f && !model->IsVertexSkinned() && !model->IsVertexDisplaced() && (instance.center - camera_position).LengthSquared() > impostor_distance * impostor_distance)
+            {
+                const uint64_t impostor_key = ImpostorKey(renderable);
+                if (m_impostors.count(impostor_key) != 0)
+                {
+                    m_impostor_draws.emplace_back(impostor_key, &instance);
                     continue;
+                }
 
-                // Skip transparent objects that won't contribute
-                if (material->GetColorAlbedo().w == 0 && is_transparent)
-                    continue;
+                ImpostorRequest(renderable, impostor_key);
+            }
 
-                // Get geometry
-                const auto& model = renderable->GeometryModel();
-                if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                    continue;
+            draw_list.entities.emplace_back(instance.entity);
+            draw_list.keys.emplace_back(DrawKey(object_type, it->second, instance.key, instance.lod, (instance.center - camera_position).LengthSquared()));
 
-                // Skip objects outside of the view frustum
-                if (!m_camera->IsInViewFrustrum(renderable))
-                    continue;
+            // The textures which are about to be sampled ask for the mips their size on screen needs
+            const float diagonal    = Helper::Max(instance.extents.Length() * 2.0f, Helper::M_EPSILON);
+            const float distance    = Helper::Max(Vector3::Distance(instance.center, camera_position) - diagonal * 0.5f, m_buffer_frame_cpu.camera_near);
+            TextureStreamingRequest(instance.entity->GetRenderable()->GetMaterial(), diagonal * m_cull_pixels_per_unit / distance);
+        }
 
-                if (!render_pass_active)
+        // Sort by key and group into batches, the sort goes wide when there are many entities (blending needs them back to front instead)
+        DrawListBatch(draw_list, true, is_transparent && !oit);
+
+        // Impostors are batched by the impostor they draw
+        sort(m_impostor_draws.begin(), m_impostor_draws.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_impostor_draws.size()); i++)
+        {
+            if (i == 0 || m_impostor_draws[i].first != m_impostor_draws[i - 1].first)
+            {
+                m_impostor_batches.emplace_back();
+                m_impostor_batches.back().entity_start = i;
+            }
+            m_impostor_batches.back().entity_count++;
+        }
+
+        // Forward shading takes the directional light from the light buffer (the light pass packed it), along with its shadow map
+        const Light* light_directional = nullptr;
+        if (is_transparent)
+        {
+            for (const Light* light : m_lights)
+            {
+                if (light->GetLightType() == LightType_Directional)
                 {
-                    render_pass_active = cmd_list->BeginRenderPass(pso);
+                    light_directional = light;
+                    break;
                 }
+            }
 
-                // Set geometry (will only happen if not already set)
-                cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                cmd_list->SetBufferVertex(model->GetVertexBuffer());
+            m_buffer_uber_cpu.light_index = light_directional ? GetLightIndex(light_directional) : 0;
 
-                // Bind material
-                bool firs_run       = material_index == 0;
-                bool new_material   = material_bound_id != material->GetId();
-                if (firs_run || new_material)
+            // The light pass only bins lights when there are any, the clusters mustn't keep those of an earlier frame
+            if (m_lights_clustered.empty())
+            {
+                UpdateLightClusterBuffer();
+            }
+
+            // Picked up by the uber buffer update of the first material
+            m_buffer_uber_cpu.resolution    = Vector2(static_cast<float>(tex_depth->GetWidth()), static_cast<float>(tex_depth->GetHeight()));
+            m_buffer_uber_cpu.color         = Vector4(light_directional ? 1.0f : 0.0f, (light_directional && light_directional->GetShadowsEnabled()) ? 1.0f : 0.0f, 0.0f, 0.0f);
+        }
+
+        // Upload the transforms of every batch at once, this is also where each entity's matrix for next frame's velocity is saved
+        uint32_t instance_offset = 0;
+        if (instancing)
+        {
+            m_instances_cpu.clear();
+            for (DrawBatch& batch : draw_list.batches)
+            {
+                batch.instance_offset = static_cast<uint32_t>(m_instances_cpu.size());
+                for (uint32_t entity_index = batch.entity_start; entity_index < batch.entity_start + batch.entity_count; entity_index++)
                 {
-                    material_bound_id = material->GetId();
+                    Entity* entity          = draw_list.entities[entity_index];
+                    Transform* transform    = entity->GetTransform();
 
-                    // Keep track of used material instances (they get mapped to shaders)
-                    if (material_index + 1 < m_material_instances.size())
+                    // Instances of a renderable are relative to its entity, and so is their last frame
+                    for (const Matrix& local : entity->GetRenderable()->GetInstances())
                     {
-                        // Advance index (0 is reserved for the sky)
-                        material_index++;
-
-                        // Keep reference
-                        m_material_instances[material_index] = material;
+                        m_instances_cpu.emplace_back(local * transform->GetMatrixRender(), local * transform->GetWvpLastFrame());
                     }
-                    else
+
+                    if (!entity->GetRenderable()->HasInstances())
                     {
-                        LOG_ERROR("Material instance array has reached it's maximum capacity of %d elements. Consider increasing the size.", m_max_material_instances);
+                        m_instances_cpu.emplace_back(transform->GetMatrixRender(), transform->GetWvpLastFrame());
                     }
+                    transform->SetWvpLastFrame(transform->GetMatrixRender() * m_buffer_frame_cpu.view_projection);
+                }
+                batch.instance_count = static_cast<uint32_t>(m_instances_cpu.size()) - batch.instance_offset;
+            }
 
-                    // Bind material textures		
-                    cmd_list->SetTexture(0, material->GetTexture_Ptr(Material_Color));
-                    cmd_list->SetTexture(1, material->GetTexture_Ptr(Material_Roughness));
-                    cmd_list->SetTexture(2, material->GetTexture_Ptr(Material_Metallic));
-                    cmd_list->SetTexture(3, material->GetTexture_Ptr(Material_Normal));
-                    cmd_list->SetTexture(4, material->GetTexture_Ptr(Material_Height));
-                    cmd_list->SetTexture(5, material->GetTexture_Ptr(Material_Occlusion));
-                    cmd_list->SetTexture(6, material->GetTexture_Ptr(Material_Emission));
-                    cmd_list->SetTexture(7, material->GetTexture_Ptr(Material_Mask));
-                
-                    // Update uber buffer with material properties
-                    m_buffer_uber_cpu.mat_id            = static_cast<float>(material_index);
-                    m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
-                    m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
-                    m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
-                    m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
-                    m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
-                    m_buffer_uber_cpu.mat_normal_mul    = material->GetProperty(Material_Normal);
-                    m_buffer_uber_cpu.mat_height_mul    = material->GetProperty(Material_Height);
+            for (DrawBatch& batch : m_impostor_batches)
+            {
+                batch.instance_offset = static_cast<uint32_t>(m_instances_cpu.size());
+                for (uint32_t draw_index = batch.entity_start; draw_index < batch.entity_start + batch.entity_count; draw_index++)
+                {
+                    Entity* entity          = m_impostor_draws[draw_index].second->entity;
+                    Transform* transform    = entity->GetTransform();
 
-                    // Update constant buffer
-                    UpdateUberBuffer(cmd_list);
+                    for (const Matrix& local : entity->GetRenderable()->GetInstances())
+                    {
+                        m_instances_cpu.emplace_back(local * transform->GetMatrixRender(), local * transform->GetWvpLastFrame());
+                    }
+
+                    if (!entity->GetRenderable()->HasInstances())
+                    {
+                        m_instances_cpu.emplace_back(transform->GetMatrixRender(), transform->GetWvpLastFrame());
+                    }
+                    transform->SetWvpLastFrame(transform->GetMatrixRender() * m_buffer_frame_cpu.view_projection);
                 }
-                
-                // Update uber buffer with entity transform
-                if (Transform* transform = entity->GetTransform())
+                batch.instance_count = static_cast<uint32_t>(m_instances_cpu.size()) - batch.instance_offset;
+            }
+
+            if (!UpdateInstanceBuffer(cmd_list, instance_offset))
+                return;
+        }
+
+        // With a depth pre-pass, the batches which it drew only shade the pixels they are visible in
+        const bool depth_prepass = !is_transparent && instancing && GetOption(Render_DepthPrepass) && Pass_DepthPrePass(cmd_list, draw_list, instance_offset);
+        if (depth_prepass)
+        {
+            pso.clear_depth     = state_depth_load;
+            pso.clear_stencil   = state_stencil_load;
+        }
+
+        // Record the batches in key order, a render pass per shader variation, vertex layout and depth test
+        bool render_pass_active         = false;
+        uint32_t variation_bound        = 0;
+        uint32_t vertex_layout_bound    = 0;
+        bool depth_equal_bound          = false;
+        for (const DrawBatch& batch : draw_list.batches)
+        {
+            Renderable* renderable      = draw_list.entities[batch.entity_start]->GetRenderable();
+            Material* material          = renderable->GetMaterial();
+            const auto& model           = renderable->GeometryModel();
+            const uint32_t variation    = DrawKeyVariation(draw_list.keys[batch.entity_start]);
+            const uint32_t lod          = DrawKeyLod(draw_list.keys[batch.entity_start]);
+            const uint32_t index_count  = renderable->GeometryLodIndexCount(lod);
+            const uint32_t index_offset = renderable->GeometryLodIndexOffset(lod);
+            const bool vertex_compact   = model->IsVertexCompact();
+            const bool vertex_skinned   = model->IsVertexSkinned();
+            const bool vertex_displaced = model->IsVertexDisplaced();
+            const uint32_t vertex_layout = vertex_skinned ? 2 : (vertex_displaced ? 3 : (vertex_compact ? 1 : 0));
+            const bool depth_equal      = depth_prepass && depth_prepass_draws(material, model);
+
+            // Switch shaders
+            if (!render_pass_active || variation != variation_bound || vertex_layout != vertex_layout_bound || depth_equal != depth_equal_bound)
+            {
+                if (render_pass_active)
                 {
-                    m_buffer_object_cpu.object          = transform->GetMatrix();
-                    m_buffer_object_cpu.wvp_current     = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                    m_buffer_object_cpu.wvp_previous    = transform->GetWvpLastFrame();
+                    cmd_list->EndRenderPass();
+                }
 
-                    // Save matrix for velocity computation
-                    transform->SetWvpLastFrame(m_buffer_object_cpu.wvp_current);
+                // Batches which the pre-pass didn't draw write their depth
+                if (!is_transparent)
+                {
+                    pso.depth_stencil_state = depth_equal ? m_depth_stencil_on_off_e.get() : m_depth_stencil_on_off_w.get();
+                }
 
-                    // Update object buffer
-                    if (!UpdateObjectBuffer(cmd_list))
-                        continue;
+                // Set vertex shader
+                if (vertex_skinned)
+                {
+                    pso.shader_vertex           = instancing ? shader_v_skinned_instanced : shader_v_skinned;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTanSkin));
                 }
-                
-                // Render	
-                cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
-                m_profiler->m_renderer_meshes_rendered++;
+                else if (vertex_displaced)
+                {
+                    pso.shader_vertex           = instancing ? shader_v_displaced_instanced : shader_v_displaced;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan));
+                }
+                else if (vertex_compact)
+                {
+                    pso.shader_vertex           = instancing ? shader_v_compact_instanced : shader_v_compact;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTanCompact));
+                }
+                else
+                {
+                    pso.shader_vertex           = instancing ? shader_v_instanced : shader_v;
+                    pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan));
+                }
+
+                // Set pixel shader
+                pso.shader_pixel = m_draw_key_shaders[variation];
+
+                // Set pass name
+                pso.pass_name = pso.shader_pixel->GetName().c_str();
+
+                render_pass_active      = cmd_list->BeginRenderPass(pso);
+                variation_bound         = variation;
+                vertex_layout_bound     = vertex_layout;
+                depth_equal_bound       = depth_equal;
+
+                if (!render_pass_active)
+                    continue;
 
                 // Clear only on first pass
                 if (!cleared)
@@ -530,10 +1289,162 @@ namespace Spartan
                     pso.ResetClearValues();
                     cleared = true;
                 }
+
+                if (instancing)
+                {
+                    cmd_list->SetBufferInstance(m_buffer_instance_gpu.get());
+                }
+
+                if (is_transparent)
+                {
+                    if (light_directional && light_directional->GetShadowsEnabled())
+                    {
+                        cmd_list->SetTexture(13, light_directional->GetDepthTexture());
+                        cmd_list->SetTexture(14, light_directional->GetShadowsTransparentEnabled() ? light_directional->GetColorTexture() : m_tex_white.get());
+                    }
+                    cmd_list->SetTexture(19, m_render_targets[RenderTarget_Brdf_Specular_Lut]);
+                    cmd_list->SetTexture(20, GetEnvironmentTexture());
+                    cmd_list->SetTexture(33, m_render_targets[RenderTarget_Brdf_Prefiltered_Environment]);
+                }
+                else if (m_decal_atlas)
+                {
+                    cmd_list->SetTexture(37, m_decal_atlas);
+                }
             }
 
-            if (render_pass_active)
+            // Set geometry (will only happen if not already set)
+            cmd_list->SetBufferIndex(model->GetIndexBuffer());
+            cmd_list->SetBufferVertex(model->GetVertexBuffer());
+
+            // The bounds which compact positions are normalized to
+            m_buffer_draw_cpu.position_offset   = model->GetVertexPositionOffset();
+            m_buffer_draw_cpu.position_scale    = model->GetVertexPositionScale();
+
+            // The height map which displaced vertices are lifted by
+            if (vertex_displaced)
+            {
+                m_buffer_draw_cpu.displacement_uv_scale_offset  = model->GetVertexDisplacementUvScaleOffset();
+                m_buffer_draw_cpu.displacement_height           = model->GetVertexDisplacementHeight();
+                cmd_list->SetTexture(34, model->GetVertexDisplacementMap(), RHI_Shader_Vertex);
+            }
+
+            // Instances are drawn without an object buffer, their transforms are in the instance buffer
+            if (!UpdateDrawBuffer(cmd_list))
+                continue;
+
+            // Skinned entities are batches of their own, the palette is shared with the light depth passes
+            if (vertex_skinned && !UpdateSkinBuffer(cmd_list, renderable))
+                continue;
+
+            // Bind material
+            if (material_slot == 0 || material_bound_id != material->GetId())
+            {
+                material_bound_id   = material->GetId();
+                material_slot       = MaterialTableSlot(material);
+
+                // Bind material textures
+                BindMaterialTextures(cmd_list, material);
+            
+                // Update uber buffer with material properties
+                m_buffer_uber_cpu.mat_id            = static_cast<float>(material_slot);
+                m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
+                m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
+                m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
+                m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
+                m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
+                m_buffer_uber_cpu.mat_normal_mul    = material->GetProperty(Material_Normal);
+                m_buffer_uber_cpu.mat_height_mul    = material->GetProperty(Material_Height);
+
+                // Update constant buffer
+                UpdateUberBuffer(cmd_list);
+            }
+            
+            if (instancing)
+            {
+                // Render all the instances at once, a lone instance culls its meshlets instead
+                const bool instance_lone = batch.instance_count == 1 && batch.entity_count == 1;
+                if (!instance_lone || !DrawMeshlets(cmd_list, renderable, draw_list.entities[batch.entity_start]->GetTransform()->GetMatrixRender(), lod, nullptr, 0, instance_offset + batch.instance_offset))
+                {
+                    cmd_list->DrawIndexed(index_count, index_offset, renderable->GeometryVertexOffset(), batch.instance_count, instance_offset + batch.instance_offset);
+                }
+                m_profiler->m_renderer_meshes_rendered += batch.instance_count;
+            }
+            else
+            {
+                for (uint32_t entity_index = batch.entity_start; entity_index < batch.entity_start + batch.entity_count; entity_index++)
+                {
+                    // Renderables which carry instances are only drawn instanced
+                    if (draw_list.entities[entity_index]->GetRenderable()->HasInstances())
+                        continue;
+
+                    // Update uber buffer with entity transform
+                    if (Transform* transform = draw_list.entities[entity_index]->GetTransform())
+                    {
+                        m_buffer_object_cpu.object          = transform->GetMatrixRender();
+                        m_buffer_object_cpu.wvp_current     = transform->GetMatrixRender() * m_buffer_frame_cpu.view_projection;
+                        m_buffer_object_cpu.wvp_previous    = transform->GetWvpLastFrame();
+
+                        // Save matrix for velocity computation
+                        transform->SetWvpLastFrame(m_buffer_object_cpu.wvp_current);
+
+                        // Update object buffer
+                        if (!UpdateObjectBuffer(cmd_list))
+                            continue;
+                    }
+
+                    // Render
+                    if (!DrawMeshlets(cmd_list, renderable, draw_list.entities[entity_index]->GetTransform()->GetMatrixRender(), lod))
+                    {
+                        cmd_list->DrawIndexed(index_count, index_offset, renderable->GeometryVertexOffset());
+                    }
+                    m_profiler->m_renderer_meshes_rendered++;
+                }
+            }
+        }
+
+        if (render_pass_active)
+        {
+            cmd_list->EndRenderPass();
+        }
+
+        // Impostors, a quad per instance
+        if (!m_impostor_batches.empty())
+        {
+            pso.shader_vertex           = shader_impostor_v;
+            pso.shader_pixel            = shader_impostor_p;
+            pso.depth_stencil_state     = m_depth_stencil_on_off_w.get(); // the pre-pass doesn't draw impostors
+            pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTex));
+            pso.pass_name               = "Pass_Impostors";
+
+            if (cmd_list->BeginRenderPass(pso))
             {
+                cmd_list->SetBufferInstance(m_buffer_instance_gpu.get());
+                cmd_list->SetBufferVertex(m_vertex_buffer_quad.get());
+                cmd_list->SetBufferIndex(m_index_buffer_quad.get());
+
+                for (const DrawBatch& batch : m_impostor_batches)
+                {
+                    const auto& draw        = m_impostor_draws[batch.entity_start];
+                    const Impostor& impostor = m_impostors[draw.first];
+                    Material* material      = draw.second->entity->GetRenderable()->GetMaterial();
+
+                    m_buffer_object_cpu.impostor_center_radius = impostor.center_radius;
+                    if (!UpdateObjectBuffer(cmd_list))
+                        continue;
+
+                    cmd_list->SetTexture(35, impostor.albedo);
+                    cmd_list->SetTexture(36, impostor.normal);
+
+                    // The color is baked in, the rest of the surface comes from the material
+                    m_buffer_uber_cpu.mat_id            = static_cast<float>(MaterialTableSlot(material));
+                    m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
+                    m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
+                    UpdateUberBuffer(cmd_list);
+
+                    cmd_list->DrawIndexed(6, 0, 0, batch.instance_count, instance_offset + batch.instance_offset);
+                    m_profiler->m_renderer_meshes_rendered += batch.instance_count;
+                }
+
                 cmd_list->EndRenderPass();
             }
         }
@@ -542,6 +1453,52 @@ namespace Spartan
         UpdateMaterialBuffer();
 	}
 
+    void Renderer::Pass_DepthNormalDownsample(RHI_CommandList* cmd_list)
+    {
+        // Acquire shaders
+        RHI_Shader* shader_v = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_p = m_shaders[Shader_DepthNormal_Downsample_P].get();
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+            return;
+
+        // Acquire textures
+        RHI_Texture* tex_depth              = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+        RHI_Texture* tex_normal             = m_render_targets[RenderTarget_Gbuffer_Normal].get();
+        RHI_Texture* tex_depth_downsampled  = m_render_targets[RenderTarget_Gbuffer_Depth_Downsampled].get();
+        RHI_Texture* tex_normal_downsampled = m_render_targets[RenderTarget_Gbuffer_Normal_Downsampled].get();
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.shader_pixel                     = shader_p;
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_depth_downsampled;
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.render_target_color_textures[1]  = tex_normal_downsampled;
+        pipeline_state.clear_color[1]                   = state_color_dont_care;
+        pipeline_state.viewport                         = tex_depth_downsampled->GetViewport();
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_DepthNormalDownsample";
+
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            // Update uber buffer (with the source resolution, the shader picks from the texels of each footprint)
+            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_depth->GetWidth()), static_cast<float>(tex_depth->GetHeight()));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(9, tex_normal);
+            cmd_list->SetTexture(12, tex_depth);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+    }
+
 	void Renderer::Pass_Hbao(RHI_CommandList* cmd_list, const bool use_stencil)
 	{
         if ((m_options & Render_Hbao) == 0)
@@ -556,12 +1513,19 @@ namespace Spartan
             return;
         
         // Acquire textures
-        shared_ptr<RHI_Texture>& tex_hbao_noisy     = m_render_targets[RenderTarget_Hbao_Noisy];
-        shared_ptr<RHI_Texture>& tex_hbao_blurred   = m_render_targets[RenderTarget_Hbao];
-        RHI_Texture* tex_depth                      = m_render_targets[RenderTarget_Gbuffer_Depth].get();
-        RHI_Texture* tex_normal                     = m_render_targets[RenderTarget_Gbuffer_Normal].get();
-        RHI_Texture* tex_light_diffuse              = m_render_targets[RenderTarget_Light_Diffuse].get();
-        RHI_Texture* tex_light_specular             = m_render_targets[RenderTarget_Light_Specular].get();
+        shared_ptr<RHI_Texture>& tex_hbao_noisy         = m_render_targets[RenderTarget_Hbao_Noisy];
+        shared_ptr<RHI_Texture>& tex_hbao_blurred       = m_render_targets[RenderTarget_Hbao];
+        shared_ptr<RHI_Texture>& tex_hbao_downsampled   = m_render_targets[RenderTarget_Hbao_Downsampled];
+        RHI_Texture* tex_depth                          = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+        RHI_Texture* tex_normal                         = m_render_targets[RenderTarget_Gbuffer_Normal].get();
+        RHI_Texture* tex_light_diffuse                  = m_render_targets[RenderTarget_Light_Diffuse].get();
+        RHI_Texture* tex_light_specular                 = m_render_targets[RenderTarget_Light_Specular].get();
+
+        // At a reduced resolution, the whole screen is computed from the downsampled depth and normals and the stencil only masks the upsample
+        const bool downsampled                          = tex_hbao_downsampled && tex_hbao_noisy->GetWidth() != tex_hbao_blurred->GetWidth();
+        const bool stencil                              = use_stencil && !downsampled;
+        RHI_Texture* tex_depth_in                       = downsampled ? m_render_targets[RenderTarget_Gbuffer_Depth_Downsampled].get() : tex_depth;
+        RHI_Texture* tex_normal_in                      = downsampled ? m_render_targets[RenderTarget_Gbuffer_Normal_Downsampled].get() : tex_normal;
 
         // Set render state
         static RHI_PipelineState pipeline_state;
@@ -569,13 +1533,13 @@ namespace Spartan
         pipeline_state.shader_pixel                             = shader_p;
         pipeline_state.rasterizer_state                         = m_rasterizer_cull_back_solid.get();
         pipeline_state.blend_state                              = m_blend_disabled.get();
-        pipeline_state.depth_stencil_state                      = use_stencil ? m_depth_stencil_off_on_r.get() : m_depth_stencil_off_off.get();
+        pipeline_state.depth_stencil_state                      = stencil ? m_depth_stencil_off_on_r.get() : m_depth_stencil_off_off.get();
         pipeline_state.vertex_buffer_stride                     = m_viewport_quad.GetVertexBuffer()->GetStride();
-        pipeline_state.render_target_color_textures[0]          = use_stencil ? tex_hbao_blurred.get() : tex_hbao_noisy.get();
-        pipeline_state.clear_color[0]                           = use_stencil ? state_color_load : state_color_dont_care;
-        pipeline_state.render_target_depth_texture              = use_stencil ? tex_depth : nullptr;
-        pipeline_state.clear_stencil                            = use_stencil ? state_stencil_load : state_stencil_dont_care;
-        pipeline_state.render_target_depth_texture_read_only    = use_stencil;
+        pipeline_state.render_target_color_textures[0]          = stencil ? tex_hbao_blurred.get() : tex_hbao_noisy.get();
+        pipeline_state.clear_color[0]                           = stencil ? state_color_load : state_color_dont_care;
+        pipeline_state.render_target_depth_texture              = stencil ? tex_depth : nullptr;
+        pipeline_state.clear_stencil                            = stencil ? state_stencil_load : state_stencil_dont_care;
+        pipeline_state.render_target_depth_texture_read_only    = stencil;
         pipeline_state.viewport                                 = tex_hbao_noisy->GetViewport();
         pipeline_state.primitive_topology                       = RHI_PrimitiveTopology_TriangleList;
         pipeline_state.pass_name                                = "Pass_Hbao";
@@ -589,8 +1553,8 @@ namespace Spartan
 
             cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
             cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-            cmd_list->SetTexture(9, tex_normal);
-            cmd_list->SetTexture(12, tex_depth);
+            cmd_list->SetTexture(9, tex_normal_in);
+            cmd_list->SetTexture(12, tex_depth_in);
             cmd_list->SetTexture(21, m_tex_noise_normal);
             cmd_list->SetTexture(23, tex_light_diffuse);
 
@@ -600,14 +1564,22 @@ namespace Spartan
             // Bilateral blur
             const auto sigma        = 2.0f;
             const auto pixel_stride = 2.0f;
-            Pass_BlurBilateralGaussian(
-                cmd_list,
-                use_stencil ? tex_hbao_blurred : tex_hbao_noisy,
-                use_stencil ? tex_hbao_noisy : tex_hbao_blurred,
-                sigma,
-                pixel_stride,
-                use_stencil
-            );
+            if (!downsampled)
+            {
+                Pass_BlurBilateralGaussian(
+                    cmd_list,
+                    use_stencil ? tex_hbao_blurred : tex_hbao_noisy,
+                    use_stencil ? tex_hbao_noisy : tex_hbao_blurred,
+                    sigma,
+                    pixel_stride,
+                    use_stencil
+                );
+            }
+            else
+            {
+                Pass_BlurBilateralGaussian(cmd_list, tex_hbao_noisy, tex_hbao_downsampled, sigma, pixel_stride, false);
+                Pass_UpsampleBilateral(cmd_list, tex_hbao_downsampled, tex_hbao_blurred, tex_depth_in, use_stencil);
+            }
         }
 	}
 
@@ -623,8 +1595,16 @@ namespace Spartan
             return;
         
         // Acquire render targets
-        auto& tex_ssr   = m_render_targets[RenderTarget_Ssr];
-        auto& tex_depth = m_render_targets[RenderTarget_Gbuffer_Depth];
+        auto& tex_ssr               = m_render_targets[RenderTarget_Ssr];
+        auto& tex_ssr_downsampled   = m_render_targets[RenderTarget_Ssr_Downsampled];
+        auto& tex_depth             = m_render_targets[RenderTarget_Gbuffer_Depth];
+
+        // At a reduced resolution, the whole screen is traced from the downsampled depth and normals and the stencil only masks the upsample
+        const bool downsampled      = tex_ssr_downsampled && tex_ssr_downsampled->GetWidth() != tex_ssr->GetWidth();
+        const bool stencil          = use_stencil && !downsampled;
+        RHI_Texture* tex_out        = downsampled ? tex_ssr_downsampled.get() : tex_ssr.get();
+        RHI_Texture* tex_depth_in   = downsampled ? m_render_targets[RenderTarget_Gbuffer_Depth_Downsampled].get() : tex_depth.get();
+        RHI_Texture* tex_normal_in  = downsampled ? m_render_targets[RenderTarget_Gbuffer_Normal_Downsampled].get() : m_render_targets[RenderTarget_Gbuffer_Normal].get();
 
         // Set render state
         static RHI_PipelineState pipeline_state;
@@ -632,14 +1612,14 @@ namespace Spartan
         pipeline_state.shader_pixel                             = shader_p.get();
         pipeline_state.rasterizer_state                         = m_rasterizer_cull_back_solid.get();
         pipeline_state.blend_state                              = m_blend_disabled.get();
-        pipeline_state.depth_stencil_state                      = use_stencil ? m_depth_stencil_off_on_r.get() : m_depth_stencil_off_off.get();
+        pipeline_state.depth_stencil_state                      = stencil ? m_depth_stencil_off_on_r.get() : m_depth_stencil_off_off.get();
         pipeline_state.vertex_buffer_stride                     = m_viewport_quad.GetVertexBuffer()->GetStride();
-        pipeline_state.render_target_color_textures[0]          = tex_ssr.get();
-        pipeline_state.clear_color[0]                           = use_stencil ? state_color_load : state_color_dont_care;
-        pipeline_state.render_target_depth_texture              = use_stencil ? tex_depth.get() : nullptr;
-        pipeline_state.clear_stencil                            = use_stencil ? state_stencil_load : state_stencil_dont_care;
-        pipeline_state.render_target_depth_texture_read_only    = use_stencil;
-        pipeline_state.viewport                                 = tex_ssr->GetViewport();
+        pipeline_state.render_target_color_textures[0]          = tex_out;
+        pipeline_state.clear_color[0]                           = stencil ? state_color_load : state_color_dont_care;
+        pipeline_state.render_target_depth_texture              = stencil ? tex_depth.get() : nullptr;
+        pipeline_state.clear_stencil                            = stencil ? state_stencil_load : state_stencil_dont_care;
+        pipeline_state.render_target_depth_texture_read_only    = stencil;
+        pipeline_state.viewport                                 = tex_out->GetViewport();
         pipeline_state.primitive_topology                       = RHI_PrimitiveTopology_TriangleList;
         pipeline_state.pass_name                                = "Pass_Ssr";
 
@@ -647,15 +1627,20 @@ namespace Spartan
         if (cmd_list->BeginRenderPass(pipeline_state))
         {
             // Update uber buffer
-            m_buffer_uber_cpu.resolution = Vector2(tex_ssr->GetWidth(), tex_ssr->GetHeight());
+            m_buffer_uber_cpu.resolution = Vector2(tex_out->GetWidth(), tex_out->GetHeight());
             UpdateUberBuffer(cmd_list);
         
             cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
             cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-            cmd_list->SetTexture(9, m_render_targets[RenderTarget_Gbuffer_Normal]);
-            cmd_list->SetTexture(12, m_render_targets[RenderTarget_Gbuffer_Depth]);
+            cmd_list->SetTexture(9, tex_normal_in);
+            cmd_list->SetTexture(12, tex_depth_in);
             cmd_list->DrawIndexed(Rectangle::GetIndexCount());
             cmd_list->EndRenderPass();
+
+            if (downsampled)
+            {
+                Pass_UpsampleBilateral(cmd_list, tex_ssr_downsampled, tex_ssr, tex_depth_in, use_stencil);
+            }
         }
         //// Acquire shader
         //const auto& shader_c = m_shaders[Shader_Ssr_C];
@@ -690,10 +1675,13 @@ namespace Spartan
 
     void Renderer::Pass_Light(RHI_CommandList* cmd_list, const bool use_stencil)
     {
-        // Acquire lights
-        const vector<Entity*>& entities = m_entities[Renderer_Object_Light];
-        if (entities.empty())
+        // Pack every light into the light buffer, once for all the passes which light the frame (the shadow passes have cached their matrices by now)
+        UpdateLightBuffer();
+        if (m_lights.empty())
+        {
+            m_lights_clustered.clear();
             return;
+        }
 
         // Acquire shaders
         RHI_Shader* shader_v    = m_shaders[Shader_Quad_V].get();
@@ -701,10 +1689,12 @@ namespace Spartan
         if (!shader_v->IsCompiled())
             return;
 
+        // The screen space shadows of the lights which have them, in a single pass
+        RHI_Texture* tex_screen_space_shadows = Pass_ScreenSpaceShadows(cmd_list) ? m_render_targets[RenderTarget_ScreenSpaceShadows].get() : m_tex_white.get();
+
         // Acquire render targets
         RHI_Texture* tex_diffuse       = m_render_targets[RenderTarget_Light_Diffuse].get();
         RHI_Texture* tex_specular      = m_render_targets[RenderTarget_Light_Specular].get();
-        RHI_Texture* tex_volumetric    = m_render_targets[RenderTarget_Light_Volumetric].get();
         RHI_Texture* tex_depth         = m_render_targets[RenderTarget_Gbuffer_Depth].get();
 
         // Update uber buffer
@@ -715,6 +1705,9 @@ namespace Spartan
         bool indirect_bounce = (m_options & Render_IndirectBounce) != 0;
         Math::Vector4 clear_color = use_stencil ? (indirect_bounce ? state_color_load : state_color_dont_care) : Vector4::Zero;
 
+        // The g-buffer and the light targets are not merged into subpasses of a single render pass (to keep them on-chip), because the passes
+        // in between (hbao, ssr) and composition (ssr bounce) sample them at other pixels than their own, which input attachments can't do.
+
          // Set render state
         static RHI_PipelineState pipeline_state;
         pipeline_state.shader_vertex                            = shader_v;
@@ -726,84 +1719,337 @@ namespace Spartan
         pipeline_state.clear_color[0]                           = clear_color;
         pipeline_state.render_target_color_textures[1]          = tex_specular;
         pipeline_state.clear_color[1]                           = clear_color;
-        pipeline_state.render_target_color_textures[2]          = tex_volumetric;
-        pipeline_state.clear_color[2]                           = use_stencil ? state_color_dont_care : Vector4::Zero;
         pipeline_state.render_target_depth_texture              = use_stencil ? tex_depth : nullptr;
         pipeline_state.clear_stencil                            = use_stencil ? state_stencil_load : state_stencil_dont_care;
         pipeline_state.render_target_depth_texture_read_only    = use_stencil;
+        pipeline_state.render_target_shading_rate_texture       = GetShadingRateTexture(tex_diffuse);
         pipeline_state.viewport                                 = tex_diffuse->GetViewport();
         pipeline_state.primitive_topology                       = RHI_PrimitiveTopology_TriangleList;
         pipeline_state.pass_name                                = "Pass_Light";
 
         bool cleared = false;
 
-        // Iterate through all the light entities
-        for (const auto& entity : entities)
+        auto set_textures = [this, cmd_list, tex_depth, tex_screen_space_shadows]()
         {
-            if (Light* light = entity->GetComponent<Light>())
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(8, m_render_targets[RenderTarget_Gbuffer_Albedo]);
+            cmd_list->SetTexture(9, m_render_targets[RenderTarget_Gbuffer_Normal]);
+            cmd_list->SetTexture(10, m_render_targets[RenderTarget_Gbuffer_Material]);
+            cmd_list->SetTexture(12, tex_depth);
+            cmd_list->SetTexture(28, tex_screen_space_shadows);
+            cmd_list->SetTexture(22, (m_options & Render_Hbao) ? m_render_targets[RenderTarget_Hbao] : m_tex_black_opaque);
+            cmd_list->SetTexture(26, (m_options & Render_ScreenSpaceReflections) ? m_render_targets[RenderTarget_Ssr] : m_tex_black_transparent);
+            cmd_list->SetTexture(27, m_render_targets[RenderTarget_Composition_Hdr_2]); // previous frame before post-processing
+            cmd_list->SetTexture(31, m_tex_blue_noise);
+        };
+
+        // Point and spot lights which don't need shadow maps are binned into clusters and shaded in a single pass,
+        // where each pixel only evaluates the lights which reach its cluster. The rest are drawn one by one.
+        m_lights_clustered.clear();
+        ShaderLight* shader_p_clustered = ShaderLight::GetVariationClustered(m_context);
+        if (shader_p_clustered->IsCompiled())
+        {
+            for (const Light* light : m_lights)
             {
-                if (light->GetIntensity() != 0)
+                if (ShaderLight::IsClusterable(light, m_options))
                 {
-                    // Set pixel shader
-                    pipeline_state.shader_pixel = static_cast<RHI_Shader*>(ShaderLight::GetVariation(m_context, light, m_options));
+                    m_lights_clustered.emplace_back(light);
+                }
+            }
+        }
 
-                    // Skip the shader until it compiles or the users spots a compilation error
-                    if (!pipeline_state.shader_pixel->IsCompiled())
-                        continue;
+        if (!m_lights_clustered.empty() && UpdateLightClusterBuffer())
+        {
+            pipeline_state.shader_pixel = static_cast<RHI_Shader*>(shader_p_clustered);
 
-                    if (cmd_list->BeginRenderPass(pipeline_state))
-                    {
-                        cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
-                        cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-                        cmd_list->SetTexture(8, m_render_targets[RenderTarget_Gbuffer_Albedo]);
-                        cmd_list->SetTexture(9, m_render_targets[RenderTarget_Gbuffer_Normal]);
-                        cmd_list->SetTexture(10, m_render_targets[RenderTarget_Gbuffer_Material]);
-                        cmd_list->SetTexture(12, tex_depth);
-                        cmd_list->SetTexture(22, (m_options & Render_Hbao) ? m_render_targets[RenderTarget_Hbao] : m_tex_black_opaque);
-                        cmd_list->SetTexture(26, (m_options & Render_ScreenSpaceReflections) ? m_render_targets[RenderTarget_Ssr] : m_tex_black_transparent);
-                        cmd_list->SetTexture(27, m_render_targets[RenderTarget_Composition_Hdr_2]); // previous frame before post-processing
-                        cmd_list->SetTexture(31, m_tex_blue_noise);
-
-                        // Update light buffer
-                        UpdateLightBuffer(light);
-
-                        // Set shadow map
-                        if (light->GetShadowsEnabled())
-                        {
-                            RHI_Texture* tex_depth = light->GetDepthTexture();
-                            RHI_Texture* tex_color = light->GetShadowsTransparentEnabled() ? light->GetColorTexture() : m_tex_white.get();
+            if (cmd_list->BeginRenderPass(pipeline_state))
+            {
+                set_textures();
 
-                            if (light->GetLightType() == LightType_Directional)
-                            {
-                                cmd_list->SetTexture(13, tex_depth);
-                                cmd_list->SetTexture(14, tex_color);
-                            }
-                            else if (light->GetLightType() == LightType_Point)
-                            {
-                                cmd_list->SetTexture(15, tex_depth);
-                                cmd_list->SetTexture(16, tex_color);
-                            }
-                            else if (light->GetLightType() == LightType_Spot)
-                            {
-                                cmd_list->SetTexture(17, tex_depth);
-                                cmd_list->SetTexture(18, tex_color);
-                            }
-                        }
+                // Draw
+                cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+                cmd_list->EndRenderPass();
 
-                        // Draw
-                        cmd_list->DrawIndexed(Rectangle::GetIndexCount());
-                        cmd_list->EndRenderPass();
+                // Clear only on first pass
+                if (!use_stencil)
+                {
+                    pipeline_state.ResetClearValues();
+                    cleared = true;
+                }
+            }
+        }
+        else
+        {
+            m_lights_clustered.clear();
+        }
 
-                        // Clear only on first pass
-                        if (!cleared && !use_stencil)
-                        {
-                            pipeline_state.ResetClearValues();
-                            cleared = true;
-                        }
+        // Iterate through all the lights
+        for (const Light* light : m_lights)
+        {
+            // Skip lights which the clustered pass took care of
+            if (find(m_lights_clustered.begin(), m_lights_clustered.end(), light) != m_lights_clustered.end())
+                continue;
+
+            // Set pixel shader
+            pipeline_state.shader_pixel = static_cast<RHI_Shader*>(ShaderLight::GetVariation(m_context, light, m_options));
+
+            // Skip the shader until it compiles or the users spots a compilation error
+            if (!pipeline_state.shader_pixel->IsCompiled())
+                continue;
+
+            if (cmd_list->BeginRenderPass(pipeline_state))
+            {
+                set_textures();
+
+                // Point the shader to the light, in the light buffer
+                m_buffer_uber_cpu.light_index = GetLightIndex(light);
+                UpdateUberBuffer(cmd_list);
+
+                // Set shadow map
+                if (light->GetShadowsEnabled())
+                {
+                    RHI_Texture* tex_depth = light->GetDepthTexture();
+                    RHI_Texture* tex_color = light->GetShadowsTransparentEnabled() ? light->GetColorTexture() : m_tex_white.get();
+
+                    if (light->GetLightType() == LightType_Directional)
+                    {
+                        cmd_list->SetTexture(13, tex_depth);
+                        cmd_list->SetTexture(14, tex_color);
+                    }
+                    else if (light->GetLightType() == LightType_Point)
+                    {
+                        cmd_list->SetTexture(15, tex_depth);
+                        cmd_list->SetTexture(16, tex_color);
+                    }
+                    else if (light->GetLightType() == LightType_Spot)
+                    {
+                        cmd_list->SetTexture(17, tex_depth);
+                        cmd_list->SetTexture(18, tex_color);
                     }
                 }
+
+                // Draw
+                cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+                cmd_list->EndRenderPass();
+
+                // Clear only on first pass
+                if (!cleared && !use_stencil)
+                {
+                    pipeline_state.ResetClearValues();
+                    cleared = true;
+                }
+            }
+        }
+    }
+
+    bool Renderer::Pass_ScreenSpaceShadows(RHI_CommandList* cmd_list)
+    {
+        // Description: The depth buffer is marched towards every light with screen space shadows (up to four),
+        // in a single pass which reconstructs the pixel once for all of them. Each light writes a channel of the mask.
+
+        if (m_lights_screen_space_shadows.empty())
+            return false;
+
+        // Acquire shaders
+        RHI_Shader* shader_v = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_p = m_shaders[Shader_ScreenSpaceShadows_P].get();
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+            return false;
+
+        // Acquire render targets
+        RHI_Texture* tex_out = m_render_targets[RenderTarget_ScreenSpaceShadows].get();
+        if (!tex_out)
+            return false;
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.shader_pixel                     = shader_p;
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_out;
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_ScreenSpaceShadows";
+
+        if (!cmd_list->BeginRenderPass(pipeline_state))
+            return false;
+
+        // Update uber buffer
+        m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+        UpdateUberBuffer(cmd_list);
+
+        cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+        cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+        cmd_list->SetTexture(12, m_render_targets[RenderTarget_Gbuffer_Depth]);
+        cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+        cmd_list->EndRenderPass();
+
+        return true;
+    }
+
+    void Renderer::Pass_VolumetricLighting(RHI_CommandList* cmd_list)
+    {
+        m_volumetric_rendered = false;
+
+        // Acquire shaders
+        RHI_Shader* shader_v            = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_p_temporal   = m_shaders[Shader_VolumetricTemporal_P].get();
+        RHI_Shader* shader_p_integrate  = m_shaders[Shader_VolumetricIntegrate_P].get();
+        if (!shader_v->IsCompiled() || !shader_p_temporal->IsCompiled() || !shader_p_integrate->IsCompiled())
+            return;
+
+        // Acquire render targets, the history ping-pongs between two targets every other frame
+        RHI_Texture* tex_scattering         = m_render_targets[RenderTarget_Volumetric_Scattering].get();
+        RHI_Texture* tex_history            = m_render_targets[m_is_odd_frame ? RenderTarget_Volumetric_History_2 : RenderTarget_Volumetric_History].get();
+        RHI_Texture* tex_history_previous   = m_render_targets[m_is_odd_frame ? RenderTarget_Volumetric_History : RenderTarget_Volumetric_History_2].get();
+        RHI_Texture* tex_out                = m_render_targets[RenderTarget_Light_Volumetric].get();
+
+        // Update uber buffer, the temporal pass reprojects with the previous frame's view projection
+        m_buffer_uber_cpu.resolution    = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+        m_buffer_uber_cpu.transform     = m_volumetric_view_projection_previous;
+        UpdateUberBuffer(cmd_list);
+        m_volumetric_view_projection_previous = m_buffer_frame_cpu.view_projection_unjittered;
+
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+
+        // Inject, every froxel gathers the light it scatters from each volumetric light, a pass per light (as they each have their own shadow map)
+        pipeline_state.shader_pixel                     = nullptr;
+        pipeline_state.blend_state                      = m_blend_additive.get();
+        pipeline_state.render_target_color_textures[0]  = tex_scattering;
+        pipeline_state.clear_color[0]                   = Vector4::Zero;
+        pipeline_state.pass_name                        = "Pass_VolumetricLighting_Inject";
+        bool cleared = false;
+        for (const Light* light : m_lights)
+        {
+            if (!light->GetVolumetricEnabled() || !light->GetShadowsEnabled())
+                continue;
+
+            Renderer_Shader_Type shader_type    = light->GetLightType() == LightType_Directional ? Shader_VolumetricInject_Directional_P : (light->GetLightType() == LightType_Point ? Shader_VolumetricInject_Point_P : Shader_VolumetricInject_Spot_P);
+            pipeline_state.shader_pixel         = m_shaders[shader_type].get();
+            if (!pipeline_state.shader_pixel->IsCompiled())
+                continue;
+
+            if (cmd_list->BeginRenderPass(pipeline_state))
+            {
+                m_buffer_uber_cpu.light_index = GetLightIndex(light);
+                UpdateUberBuffer(cmd_list);
+
+                cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+                cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+                cmd_list->SetTexture(light->GetLightType() == LightType_Directional ? 13 : (light->GetLightType() == LightType_Point ? 15 : 17), light->GetDepthTexture());
+                cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+                cmd_list->EndRenderPass();
+
+                pipeline_state.ResetClearValues();
+                cleared = true;
             }
         }
+
+        // Without any volumetric light (or before their shaders compile), there is nothing to scatter and composition goes without
+        if (!cleared)
+            return;
+
+        // Temporal, blend with the previous frame's froxels where they reproject to
+        pipeline_state.shader_pixel                     = shader_p_temporal;
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.render_target_color_textures[0]  = tex_history;
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.pass_name                        = "Pass_VolumetricLighting_Temporal";
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, tex_scattering);
+            cmd_list->SetTexture(29, tex_history_previous);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+
+        // Integrate, front to back, so that composition needs a single lookup per pixel
+        pipeline_state.shader_pixel                     = shader_p_integrate;
+        pipeline_state.render_target_color_textures[0]  = tex_out;
+        pipeline_state.pass_name                        = "Pass_VolumetricLighting_Integrate";
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, tex_history);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+
+            m_volumetric_rendered = true;
+        }
+    }
+
+    void Renderer::Pass_ShadingRate(RHI_CommandList* cmd_list)
+    {
+        // Acquire shaders
+        const auto& shader_v = m_shaders[Shader_Quad_V];
+        const auto& shader_p = m_shaders[Shader_ShadingRate_P];
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+            return;
+
+        // Acquire render targets
+        RHI_Texture* tex_out = m_render_targets[RenderTarget_ShadingRate].get();
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v.get();
+        pipeline_state.shader_pixel                     = shader_p.get();
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_out;
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.pass_name                        = "Pass_ShadingRate";
+
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            // Update uber buffer
+            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            UpdateUberBuffer(cmd_list);
+
+            // The contrast comes from the previous frame's output, this frame's is yet to be shaded
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(11, m_render_targets[RenderTarget_Gbuffer_Velocity]);
+            cmd_list->SetTexture(28, m_render_targets[RenderTarget_Composition_Ldr]);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+    }
+
+    RHI_Texture* Renderer::GetShadingRateTexture(const RHI_Texture* tex_out) const
+    {
+        if (!GetOption(Render_VariableRateShading) || !m_rhi_device->IsVariableRateShadingSupported())
+            return nullptr;
+
+        // Covers the render resolution, the passes which run after upsampling shade every pixel
+        const auto it = m_render_targets.find(RenderTarget_ShadingRate);
+        RHI_Texture* tex_shading_rate = it != m_render_targets.end() ? it->second.get() : nullptr;
+        if (!tex_shading_rate || !m_shaders.at(Shader_ShadingRate_P)->IsCompiled())
+            return nullptr;
+
+        const uint32_t tile = m_rhi_device->GetShadingRateTileSize();
+        if (tex_out->GetWidth() > tex_shading_rate->GetWidth() * tile || tex_out->GetHeight() > tex_shading_rate->GetHeight() * tile)
+            return nullptr;
+
+        return tex_shading_rate;
     }
 
 	void Renderer::Pass_Composition(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_out, const bool use_stencil)
@@ -828,6 +2074,7 @@ namespace Spartan
         pipeline_state.clear_color[0]                   = state_color_dont_care;
         pipeline_state.render_target_depth_texture      = use_stencil ? m_render_targets[RenderTarget_Gbuffer_Depth].get() : nullptr;
         pipeline_state.clear_stencil                    = use_stencil ? state_stencil_load : state_stencil_dont_care;
+        pipeline_state.render_target_shading_rate_texture = GetShadingRateTexture(tex_out.get());
         pipeline_state.viewport                         = tex_out->GetViewport();
         pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
         pipeline_state.pass_name                        = "Pass_Composition";
@@ -849,11 +2096,16 @@ namespace Spartan
             cmd_list->SetTexture(22, (m_options & Render_Hbao) ? m_render_targets[RenderTarget_Hbao] : m_tex_black_opaque);
             cmd_list->SetTexture(23, m_render_targets[RenderTarget_Light_Diffuse]);
             cmd_list->SetTexture(24, m_render_targets[RenderTarget_Light_Specular]);
-            cmd_list->SetTexture(25, (m_options & Render_VolumetricLighting)        ? m_render_targets[RenderTarget_Light_Volumetric] : m_tex_black_transparent);
+            cmd_list->SetTexture(25, ((m_options & Render_VolumetricLighting) && m_volumetric_rendered) ? m_render_targets[RenderTarget_Light_Volumetric] : m_tex_black_transparent);
             cmd_list->SetTexture(26, (m_options & Render_ScreenSpaceReflections)    ? m_render_targets[RenderTarget_Ssr] : m_tex_black_transparent);
             cmd_list->SetTexture(27, m_render_targets[RenderTarget_Composition_Hdr_2]); // previous frame before post-processing
             cmd_list->SetTexture(19, m_render_targets[RenderTarget_Brdf_Specular_Lut]);
             cmd_list->SetTexture(20, GetEnvironmentTexture());
+            cmd_list->SetTexture(33, m_render_targets[RenderTarget_Brdf_Prefiltered_Environment]);
+            if (m_reflection_probe_atlas)
+            {
+                cmd_list->SetTexture(39, m_reflection_probe_atlas); // only sampled while probes are baked
+            }
             cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
             cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
             cmd_list->DrawIndexed(Rectangle::GetIndexCount());
@@ -900,81 +2152,142 @@ namespace Spartan
         }
     }
 
+    void Renderer::Pass_TransparentResolve(RHI_CommandList* cmd_list, RHI_Texture* tex_out)
+    {
+        // Acquire shaders
+        const auto& shader_v    = m_shaders[Shader_Quad_V];
+        const auto& shader_p    = m_shaders[Shader_TransparentResolve_P];
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+            return;
+
+        // Update uber buffer
+        m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+        UpdateUberBuffer(cmd_list);
+
+        // Set render state, the resolved color is blended by its coverage
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v.get();
+        pipeline_state.shader_pixel                     = shader_p.get();
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_alpha.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_out;
+        pipeline_state.clear_color[0]                   = state_color_load;
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_TransparentResolve";
+
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, m_render_targets[RenderTarget_Transparent_Accumulation]);
+            cmd_list->SetTexture(29, m_render_targets[RenderTarget_Transparent_Weight]);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+    }
+
 	void Renderer::Pass_PostProcess(RHI_CommandList* cmd_list)
 	{
         // IN:  RenderTarget_Composition_Hdr
         // OUT: RenderTarget_Composition_Ldr
 
         // Acquire render targets
-        auto& tex_in_hdr    = m_render_targets[RenderTarget_Composition_Hdr];
-        auto& tex_out_hdr   = m_render_targets[RenderTarget_Composition_Hdr_2];
         auto& tex_in_ldr    = m_render_targets[RenderTarget_Composition_Ldr];
         auto& tex_out_ldr   = m_render_targets[RenderTarget_Composition_Ldr_2];
 
+        // The HDR passes ping-pong between the composition targets of the render resolution, unless the frame
+        // gets upsampled before them, then they continue on the ones of the output resolution (they are all floating point).
+        shared_ptr<RHI_Texture>* tex_in_hdr     = &m_render_targets[RenderTarget_Composition_Hdr];
+        shared_ptr<RHI_Texture>* tex_out_hdr    = &m_render_targets[RenderTarget_Composition_Hdr_2];
+        const bool upsample                     = (*tex_in_hdr)->GetWidth() != tex_in_ldr->GetWidth() || (*tex_in_hdr)->GetHeight() != tex_in_ldr->GetHeight();
+
         // TAA	
         if (GetOption(Render_AntiAliasing_Taa))
         {
-            Pass_TAA(cmd_list, tex_in_hdr, tex_out_hdr);
-            tex_in_hdr.swap(tex_out_hdr);
+            // Below the output resolution, TAA does the upsampling (temporal upscaling)
+            if (upsample)
+            {
+                Pass_TAA(cmd_list, *tex_in_hdr, tex_in_ldr);
+                tex_in_hdr  = &tex_in_ldr;
+                tex_out_hdr = &tex_out_ldr;
+            }
+            else
+            {
+                Pass_TAA(cmd_list, *tex_in_hdr, *tex_out_hdr);
+                tex_in_hdr->swap(*tex_out_hdr);
+            }
         }
 
         // Motion Blur
         if (GetOption(Render_MotionBlur))
         {
-            Pass_MotionBlur(cmd_list, tex_in_hdr, tex_out_hdr);
-            tex_in_hdr.swap(tex_out_hdr);
+            Pass_MotionBlur(cmd_list, *tex_in_hdr, *tex_out_hdr);
+            tex_in_hdr->swap(*tex_out_hdr);
         }
 
         // Bloom
         if (GetOption(Render_Bloom))
         {
-            Pass_Bloom(cmd_list, tex_in_hdr, tex_out_hdr);
-            tex_in_hdr.swap(tex_out_hdr);
+            Pass_Bloom(cmd_list, *tex_in_hdr, *tex_out_hdr);
+            tex_in_hdr->swap(*tex_out_hdr);
         }
 
-        // Tone-Mapping
-        if (m_option_values[Option_Value_Tonemapping] != 0)
+        // Upsampling, below the output resolution and without TAA
+        if (upsample && tex_in_hdr != &tex_in_ldr)
         {
-            Pass_ToneMapping(cmd_list, tex_in_hdr, tex_in_ldr); // HDR -> LDR
+            Pass_Upsample(cmd_list, *tex_in_hdr, tex_in_ldr);
+            tex_in_hdr  = &tex_in_ldr;
+            tex_out_hdr = &tex_out_ldr;
         }
-        else
+
+        // Tone-mapping, dithering, sharpening, chromatic aberration and gamma correction are fused into a single pass.
+        // FXAA is the exception, it needs the tone-mapped neighbourhood, so when enabled it splits them into two passes.
+        uint32_t flags_ldr = 0;
+        flags_ldr |= GetOption(Render_Sharpening_LumaSharpen)   ? PostProcess_Sharpening            : 0;
+        flags_ldr |= GetOption(Render_ChromaticAberration)      ? PostProcess_ChromaticAberration   : 0;
+        flags_ldr |= PostProcess_GammaCorrection;
+
+        uint32_t flags_hdr = 0;
+        flags_hdr |= m_option_values[Option_Value_Tonemapping] != 0 ? PostProcess_ToneMapping  : 0;
+        flags_hdr |= GetOption(Render_Dithering)                    ? PostProcess_Dithering    : 0;
+
+        // Auto exposure, measured on what is about to be tone-mapped (by a compute shader, so not on backends which can't dispatch)
+        if (GetOption(Render_AutoExposure) && m_rhi_device->IsComputeSupported() && (flags_hdr & PostProcess_ToneMapping))
         {
-            Pass_Copy(cmd_list, tex_in_hdr, tex_in_ldr);
+            Pass_AutoExposure(cmd_list, *tex_in_hdr);
+            flags_hdr |= m_tex_auto_exposure ? PostProcess_AutoExposure : 0;
         }
 
-        // Dithering
-        if (GetOption(Render_Dithering))
+        const bool fxaa = GetOption(Render_AntiAliasing_Fxaa);
+        if (!fxaa)
         {
-            Pass_Dithering(cmd_list, tex_in_ldr, tex_out_ldr);
-            tex_in_ldr.swap(tex_out_ldr);
+            flags_hdr |= flags_ldr;
         }
 
-        // FXAA
-        if (GetOption(Render_AntiAliasing_Fxaa))
+        // HDR -> LDR
+        if (tex_in_hdr == &tex_in_ldr)
         {
-            Pass_FXAA(cmd_list, tex_in_ldr, tex_out_ldr);
+            Pass_PostProcessFused(cmd_list, tex_in_ldr, tex_out_ldr, flags_hdr);
             tex_in_ldr.swap(tex_out_ldr);
         }
-
-        // Sharpening
-        if (GetOption(Render_Sharpening_LumaSharpen))
+        else
         {
-            Pass_LumaSharpen(cmd_list, tex_in_ldr, tex_out_ldr);
-            tex_in_ldr.swap(tex_out_ldr);
+            Pass_PostProcessFused(cmd_list, *tex_in_hdr, tex_in_ldr, flags_hdr);
         }
 
-        // Chromatic aberration
-        if (GetOption(Render_ChromaticAberration))
+        // FXAA
+        if (fxaa)
         {
-            Pass_ChromaticAberration(cmd_list, tex_in_ldr, tex_out_ldr);
+            Pass_FXAA(cmd_list, tex_in_ldr, tex_out_ldr);
             tex_in_ldr.swap(tex_out_ldr);
-        }
-
-        // Gamma correction
-        Pass_GammaCorrection(cmd_list, tex_in_ldr, tex_out_ldr);
 
-        // Swap textures
-        tex_in_ldr.swap(tex_out_ldr);
+            Pass_PostProcessFused(cmd_list, tex_in_ldr, tex_out_ldr, flags_ldr);
+            tex_in_ldr.swap(tex_out_ldr);
+        }
 	}
 
     void Renderer::Pass_Upsample(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
@@ -1013,6 +2326,51 @@ namespace Spartan
         }
     }
 
+    void Renderer::Pass_UpsampleBilateral(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out, RHI_Texture* tex_depth_in, const bool use_stencil)
+    {
+        // Acquire shaders
+        const auto& shader_v = m_shaders[Shader_Quad_V];
+        const auto& shader_p = m_shaders[Shader_Upsample_Bilateral_P];
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+            return;
+
+        // Acquire render targets
+        RHI_Texture* tex_depth = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                            = shader_v.get();
+        pipeline_state.shader_pixel                             = shader_p.get();
+        pipeline_state.rasterizer_state                         = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                              = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state                      = use_stencil ? m_depth_stencil_off_on_r.get() : m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride                     = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]          = tex_out.get();
+        pipeline_state.clear_color[0]                           = use_stencil ? state_color_load : state_color_dont_care;
+        pipeline_state.render_target_depth_texture              = use_stencil ? tex_depth : nullptr;
+        pipeline_state.clear_stencil                            = use_stencil ? state_stencil_load : state_stencil_dont_care;
+        pipeline_state.render_target_depth_texture_read_only    = use_stencil;
+        pipeline_state.viewport                                 = tex_out->GetViewport();
+        pipeline_state.primitive_topology                       = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                                = "Pass_UpsampleBilateral";
+
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            // Update uber buffer (with the input resolution, the shader weights the input texels around each pixel)
+            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_in->GetWidth()), static_cast<float>(tex_in->GetHeight()));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, tex_in);
+            cmd_list->SetTexture(29, tex_depth_in);
+            cmd_list->SetTexture(12, tex_depth);
+            cmd_list->DrawIndexed(m_viewport_quad.GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+    }
+
     void Renderer::Pass_Downsample(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out, const Renderer_Shader_Type pixel_shader)
     {
         // Acquire shaders
@@ -1050,6 +2408,55 @@ namespace Spartan
         }
     }
 
+    void Renderer::Pass_DownsampleChain(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, vector<shared_ptr<RHI_Texture>>& mips, const uint32_t mip_count, const Renderer_Shader_Type pixel_shader_first, const Renderer_Shader_Type pixel_shader)
+    {
+        // Builds a whole mip chain, mips[0] is downsampled from tex_in (with pixel_shader_first, so the first level can also filter)
+        // and every other mip from the one before it. The render state is set up once and only the render target changes per mip.
+
+        // Acquire shaders
+        const auto& shader_v        = m_shaders[Shader_Quad_V];
+        const auto& shader_p_first  = m_shaders[pixel_shader_first];
+        const auto& shader_p        = m_shaders[pixel_shader];
+        if (!shader_v->IsCompiled() || !shader_p_first->IsCompiled() || !shader_p->IsCompiled())
+            return;
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v.get();
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_DownsampleChain";
+
+        const uint32_t count = Math::Helper::Min(mip_count, static_cast<uint32_t>(mips.size()));
+        for (uint32_t i = 0; i < count; i++)
+        {
+            shared_ptr<RHI_Texture>& mip_in     = i == 0 ? tex_in : mips[i - 1];
+            shared_ptr<RHI_Texture>& mip_out    = mips[i];
+
+            pipeline_state.shader_pixel                     = i == 0 ? shader_p_first.get() : shader_p.get();
+            pipeline_state.render_target_color_textures[0]  = mip_out.get();
+            pipeline_state.viewport                         = mip_out->GetViewport();
+
+            // Record commands
+            if (cmd_list->BeginRenderPass(pipeline_state))
+            {
+                // Update uber buffer
+                m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(mip_out->GetWidth()), static_cast<float>(mip_out->GetHeight()));
+                UpdateUberBuffer(cmd_list);
+
+                cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+                cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+                cmd_list->SetTexture(28, mip_in);
+                cmd_list->DrawIndexed(m_viewport_quad.GetIndexCount());
+                cmd_list->EndRenderPass();
+            }
+        }
+    }
+
     void Renderer::Pass_BlurBox(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out, const float sigma, const float pixel_stride, const bool use_stencil)
 	{
         // Acquire shaders
@@ -1184,6 +2591,11 @@ namespace Spartan
         RHI_Texture* tex_depth     = m_render_targets[RenderTarget_Gbuffer_Depth].get();
         RHI_Texture* tex_normal    = m_render_targets[RenderTarget_Gbuffer_Normal].get();
 
+        // Inputs below the g-buffer resolution are weighted against the downsampled depth and normals (the stencil always comes from the g-buffer)
+        const bool downsampled      = tex_in->GetWidth() != tex_depth->GetWidth();
+        RHI_Texture* tex_depth_in   = downsampled ? m_render_targets[RenderTarget_Gbuffer_Depth_Downsampled].get() : tex_depth;
+        RHI_Texture* tex_normal_in  = downsampled ? m_render_targets[RenderTarget_Gbuffer_Normal_Downsampled].get() : tex_normal;
+
         // Set render state for horizontal pass
         static RHI_PipelineState pipeline_state_horizontal;
         pipeline_state_horizontal.shader_vertex                     = shader_v.get();
@@ -1212,8 +2624,8 @@ namespace Spartan
             cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
             cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
             cmd_list->SetTexture(28, tex_in);
-            cmd_list->SetTexture(12, tex_depth);
-            cmd_list->SetTexture(9, tex_normal);
+            cmd_list->SetTexture(12, tex_depth_in);
+            cmd_list->SetTexture(9, tex_normal_in);
             cmd_list->DrawIndexed(m_viewport_quad.GetIndexCount());
             cmd_list->EndRenderPass();
         }
@@ -1245,8 +2657,8 @@ namespace Spartan
             cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
             cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
             cmd_list->SetTexture(28, tex_out);
-            cmd_list->SetTexture(12, tex_depth);
-            cmd_list->SetTexture(9, tex_normal);
+            cmd_list->SetTexture(12, tex_depth_in);
+            cmd_list->SetTexture(9, tex_normal_in);
             cmd_list->DrawIndexed(m_viewport_quad.GetIndexCount());
             cmd_list->EndRenderPass();
         }
@@ -1257,9 +2669,12 @@ namespace Spartan
 
 	void Renderer::Pass_TAA(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
 	{
+        // Rendering below the output resolution, the resolve reconstructs the output from the jittered frames
+        const bool upscale = tex_in->GetWidth() != tex_out->GetWidth() || tex_in->GetHeight() != tex_out->GetHeight();
+
 		// Acquire shaders
         const auto& shader_v = m_shaders[Shader_Quad_V];
-		const auto& shader_p = m_shaders[Shader_Taa_P];
+		const auto& shader_p = m_shaders[upscale ? Shader_Taa_Upscale_P : Shader_Taa_P];
 		if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
 			return;
 
@@ -1312,43 +2727,10 @@ namespace Spartan
 		if (!shader_p_downsample->IsCompiled() || !shader_p_bloom_luminance->IsCompiled() || !shader_p_upsample->IsCompiled() || !shader_p_downsample->IsCompiled())
 			return;
 
-        // Luminance
-        {
-            // Set render state
-            static RHI_PipelineState pipeline_state;
-            pipeline_state.shader_vertex                    = shader_v.get();
-            pipeline_state.shader_pixel                     = shader_p_bloom_luminance.get();
-            pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
-            pipeline_state.blend_state                      = m_blend_disabled.get();
-            pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
-            pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
-            pipeline_state.render_target_color_textures[0]  = m_render_tex_bloom[0].get();
-            pipeline_state.clear_color[0]                   = state_color_dont_care;
-            pipeline_state.viewport                         = m_render_tex_bloom[0]->GetViewport();
-            pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
-            pipeline_state.pass_name                        = "Pass_Bloom_Luminance";
-
-            // Record commands
-            if (cmd_list->BeginRenderPass(pipeline_state))
-            {
-                // Update uber buffer
-                m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(m_render_tex_bloom[0]->GetWidth()), static_cast<float>(m_render_tex_bloom[0]->GetHeight()));
-                UpdateUberBuffer(cmd_list);
-        
-                cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
-                cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-                cmd_list->SetTexture(28, tex_in);
-                cmd_list->DrawIndexed(Rectangle::GetIndexCount());
-                cmd_list->EndRenderPass();
-            }
-        }
-        
-        // Downsample
-        // The last bloom texture is the same size as the previous one (it's used for the Gaussian pass below), so we skip it
-        for (int i = 0; i < static_cast<int>(m_render_tex_bloom.size() - 1); i++)
-        {
-            Pass_Downsample(cmd_list, m_render_tex_bloom[i], m_render_tex_bloom[i + 1], Shader_BloomDownsample_P);
-        }
+        // Luminance and downsample
+        // The first mip keeps the bright parts of the frame, the rest are plain downsamples of the one before them.
+        // The last bloom texture is the same size as the previous one (it's used for the Gaussian pass below), so we skip it.
+        Pass_DownsampleChain(cmd_list, tex_in, m_render_tex_bloom, static_cast<uint32_t>(m_render_tex_bloom.size() - 1), Shader_BloomDownsampleLuminance_P, Shader_BloomDownsample_P);
         
         auto upsample_additive = [this, &cmd_list, &shader_v, &shader_p_upsample](shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
         {
@@ -1585,28 +2967,185 @@ namespace Spartan
         pipeline_state.viewport                         = tex_out->GetViewport();
         pipeline_state.pass_name                        = "Pass_ChromaticAberration";
 
-        // Record commands
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            // Update uber buffer
+            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, tex_in);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+	}
+
+	void Renderer::Pass_MotionBlur(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
+	{
+		// Acquire shaders
+        const auto& shader_v = m_shaders[Shader_Quad_V];
+		const auto& shader_p = m_shaders[Shader_MotionBlur_P];
+		if (!shader_p->IsCompiled())
+			return;
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v.get();
+        pipeline_state.shader_pixel                     = shader_p.get();
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_out.get();
+        pipeline_state.clear_color[0]                   = Vector4::Zero;
+        pipeline_state.render_target_shading_rate_texture = GetShadingRateTexture(tex_out.get());
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.pass_name                        = "Pass_MotionBlur";
+
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            // Update uber buffer
+            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, tex_in);
+            cmd_list->SetTexture(11, m_render_targets[RenderTarget_Gbuffer_Velocity]);
+            cmd_list->SetTexture(12, m_render_targets[RenderTarget_Gbuffer_Depth]);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+	}
+
+	void Renderer::Pass_Dithering(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
+	{
+		// Acquire shaders
+        const auto& shader_v = m_shaders[Shader_Quad_V];
+		const auto& shader_p = m_shaders[Shader_Dithering_P];
+        if (!shader_p->IsCompiled() || !shader_v->IsCompiled())
+            return;
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v.get();
+        pipeline_state.shader_pixel                     = shader_p.get();
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_out.get();
+        pipeline_state.clear_color[0]                   = Vector4::Zero;
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.pass_name                        = "Pass_Dithering";
+
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            // Update uber buffer
+            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, tex_in);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+	}
+
+    void Renderer::Pass_PostProcessFused(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out, const uint32_t flags)
+    {
+        // Acquire shaders
+        const auto& shader_v = m_shaders[Shader_Quad_V];
+        const auto& shader_p = m_shaders[Shader_PostProcess_Fused_P];
+        if (!shader_p->IsCompiled() || !shader_v->IsCompiled())
+            return;
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v.get();
+        pipeline_state.shader_pixel                     = shader_p.get();
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_out.get();
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.render_target_shading_rate_texture = GetShadingRateTexture(tex_out.get());
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.pass_name                        = "Pass_PostProcessFused";
+
+        // Record commands
+        if (cmd_list->BeginRenderPass(pipeline_state))
+        {
+            // Update uber buffer
+            m_buffer_uber_cpu.resolution        = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            m_buffer_uber_cpu.postprocess_flags = flags;
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(28, tex_in);
+            if (flags & PostProcess_AutoExposure)
+            {
+                cmd_list->SetTexture(40, m_tex_auto_exposure);
+            }
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+    }
+
+    void Renderer::Pass_AutoExposure(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in)
+    {
+        // Description: A single dispatch builds the luminance histogram of the frame (sampled on a fixed grid, so its cost doesn't grow with the resolution)
+        // and moves the exposure of the previous frame towards the one which exposes the average to middle gray. The tone-mapping reads it from a 1x1 texture.
+
+        // Acquire shaders
+        RHI_Shader* shader_c = m_shaders[Shader_AutoExposure_C].get();
+        if (!shader_c->IsCompiled())
+            return;
+
+        // Acquire render target, it carries over from frame to frame so it belongs to the renderer (a new one takes the exposure of the frame as is)
+        const bool reset = !m_tex_auto_exposure;
+        if (reset)
+        {
+            m_tex_auto_exposure = make_shared<RHI_Texture2D>(m_context, 1, 1, RHI_Format_R32_Float, 1, 0, "auto_exposure");
+        }
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_compute           = shader_c;
+        pipeline_state.unordered_access_view    = m_tex_auto_exposure.get();
+        pipeline_state.pass_name                = "Pass_AutoExposure";
+
+        // Draw
         if (cmd_list->BeginRenderPass(pipeline_state))
         {
             // Update uber buffer
-            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            m_buffer_uber_cpu.resolution    = Vector2(static_cast<float>(tex_in->GetWidth()), static_cast<float>(tex_in->GetHeight()));
+            m_buffer_uber_cpu.color         = Vector4(m_buffer_frame_cpu.delta_time, m_auto_exposure_adaptation_speed, reset ? 1.0f : 0.0f, 0.0f);
             UpdateUberBuffer(cmd_list);
 
-            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
-            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-            cmd_list->SetTexture(28, tex_in);
-            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->SetTexture(28, tex_in, RHI_Shader_Compute);
+            cmd_list->Dispatch(1, 1);
             cmd_list->EndRenderPass();
         }
-	}
+    }
 
-	void Renderer::Pass_MotionBlur(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
+	void Renderer::Pass_LumaSharpen(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
 	{
 		// Acquire shaders
         const auto& shader_v = m_shaders[Shader_Quad_V];
-		const auto& shader_p = m_shaders[Shader_MotionBlur_P];
-		if (!shader_p->IsCompiled())
-			return;
+		const auto& shader_p = m_shaders[Shader_Sharpen_Luma_P];
+        if (!shader_p->IsCompiled() || !shader_v->IsCompiled())
+            return;
 
         // Set render state
         static RHI_PipelineState pipeline_state;
@@ -1618,9 +3157,9 @@ namespace Spartan
         pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
         pipeline_state.render_target_color_textures[0]  = tex_out.get();
         pipeline_state.clear_color[0]                   = Vector4::Zero;
-        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
         pipeline_state.viewport                         = tex_out->GetViewport();
-        pipeline_state.pass_name                        = "Pass_MotionBlur";
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_LumaSharpen";
 
         // Record commands
         if (cmd_list->BeginRenderPass(pipeline_state))
@@ -1632,86 +3171,177 @@ namespace Spartan
             cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
             cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
             cmd_list->SetTexture(28, tex_in);
-            cmd_list->SetTexture(11, m_render_targets[RenderTarget_Gbuffer_Velocity]);
-            cmd_list->SetTexture(12, m_render_targets[RenderTarget_Gbuffer_Depth]);
             cmd_list->DrawIndexed(Rectangle::GetIndexCount());
             cmd_list->EndRenderPass();
         }
 	}
 
-	void Renderer::Pass_Dithering(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
-	{
-		// Acquire shaders
-        const auto& shader_v = m_shaders[Shader_Quad_V];
-		const auto& shader_p = m_shaders[Shader_Dithering_P];
-        if (!shader_p->IsCompiled() || !shader_v->IsCompiled())
+    void Renderer::Pass_Particles(RHI_CommandList* cmd_list)
+    {
+        // Acquire shaders
+        RHI_Shader* shader_v = m_shaders[Shader_Particle_V].get();
+        RHI_Shader* shader_p = m_shaders[Shader_Particle_P].get();
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled() || !m_camera)
             return;
 
+        // Acquire render targets
+        RHI_Texture* tex_depth  = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+        RHI_Texture* tex_out    = m_render_targets[RenderTarget_Composition_Hdr].get();
+
         // Set render state
         static RHI_PipelineState pipeline_state;
-        pipeline_state.shader_vertex                    = shader_v.get();
-        pipeline_state.shader_pixel                     = shader_p.get();
+        pipeline_state.shader_vertex                            = shader_v;
+        pipeline_state.shader_pixel                             = shader_p;
+        pipeline_state.rasterizer_state                         = m_rasterizer_cull_none_solid.get();
+        pipeline_state.blend_state                              = m_blend_additive.get();
+        pipeline_state.depth_stencil_state                      = m_depth_stencil_on_off_r.get();
+        pipeline_state.vertex_buffer_stride                     = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTex));
+        pipeline_state.render_target_color_textures[0]          = tex_out;
+        pipeline_state.clear_color[0]                           = state_color_load;
+        pipeline_state.render_target_depth_texture              = tex_depth;
+        pipeline_state.render_target_depth_texture_read_only    = true;
+        pipeline_state.clear_depth                              = state_depth_load;
+        pipeline_state.clear_stencil                            = state_stencil_load;
+        pipeline_state.viewport                                 = tex_out->GetViewport();
+        pipeline_state.primitive_topology                       = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                                = "Pass_Particles";
+
+        // Record commands
+        if (!cmd_list->BeginRenderPass(pipeline_state))
+            return;
+
+        cmd_list->SetBufferVertex(m_vertex_buffer_quad.get());
+        cmd_list->SetBufferIndex(m_index_buffer_quad.get());
+
+        // An instanced draw per emitter, a quad per particle
+        for (Entity* entity : m_entities[Renderer_Object_ParticleEmitter])
+        {
+            const ParticleEmitter* emitter  = entity->GetComponent<ParticleEmitter>();
+            const uint32_t particle_count   = emitter ? emitter->GetParticleCount() : 0;
+            if (particle_count == 0)
+                continue;
+
+            const BoundingBox aabb = emitter->GetAabb();
+            if (!m_camera->IsInViewFrustrum(aabb.GetCenter(), aabb.GetExtents()))
+                continue;
+
+            const float intensity = emitter->GetIntensity();
+            m_buffer_object_cpu.object                                  = entity->GetTransform()->GetMatrixRender();
+            m_buffer_object_cpu.particle_velocity_spread                = Vector4(emitter->GetVelocity(), emitter->GetVelocitySpread());
+            m_buffer_object_cpu.particle_color_start                    = Vector4(emitter->GetColorStart().x * intensity, emitter->GetColorStart().y * intensity, emitter->GetColorStart().z * intensity, emitter->GetColorStart().w);
+            m_buffer_object_cpu.particle_color_end                      = Vector4(emitter->GetColorEnd().x * intensity, emitter->GetColorEnd().y * intensity, emitter->GetColorEnd().z * intensity, emitter->GetColorEnd().w);
+            m_buffer_object_cpu.particle_time_period_lifetime_gravity   = Vector4(emitter->GetTime(), emitter->GetPeriod(), emitter->GetLifetime(), emitter->GetGravity());
+            m_buffer_object_cpu.particle_rate_size_seed                 = Vector4(emitter->GetEmissionRate(), emitter->GetSizeStart(), emitter->GetSizeEnd(), static_cast<float>(emitter->GetSeed()));
+            if (!UpdateObjectBuffer(cmd_list))
+                continue;
+
+            cmd_list->SetTexture(0, emitter->GetTexture() ? static_cast<RHI_Texture*>(emitter->GetTexture().get()) : m_tex_particle.get());
+            cmd_list->DrawIndexed(6, 0, 0, particle_count);
+        }
+
+        cmd_list->EndRenderPass();
+    }
+
+    void Renderer::Pass_Decals(RHI_CommandList* cmd_list)
+    {
+        // Description: Bins the decals in view into the clusters (the g-buffer pass blends them) and copies the textures they
+        // need into the atlas, a texture which isn't loaded yet isn't copied and its decals are skipped until it is.
+
+        if (!UpdateDecalBuffer() || m_decal_atlas_copies.empty())
+            return;
+
+        // Acquire shaders
+        RHI_Shader* shader_v = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_p = m_shaders[Shader_Texture_P].get();
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+            return;
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.shader_pixel                     = shader_p;
         pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
         pipeline_state.blend_state                      = m_blend_disabled.get();
         pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
         pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
-        pipeline_state.render_target_color_textures[0]  = tex_out.get();
-        pipeline_state.clear_color[0]                   = Vector4::Zero;
+        pipeline_state.render_target_color_textures[0]  = m_decal_atlas.get();
+        pipeline_state.clear_color[0]                   = state_color_load;
         pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
-        pipeline_state.viewport                         = tex_out->GetViewport();
-        pipeline_state.pass_name                        = "Pass_Dithering";
+        pipeline_state.viewport                         = m_decal_atlas->GetViewport();
+        pipeline_state.pass_name                        = "Pass_Decals";
 
         // Record commands
-        if (cmd_list->BeginRenderPass(pipeline_state))
-        {
-            // Update uber buffer
-            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
-            UpdateUberBuffer(cmd_list);
+        if (!cmd_list->BeginRenderPass(pipeline_state))
+            return;
 
-            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
-            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-            cmd_list->SetTexture(28, tex_in);
+        // The viewport quad covers the viewport, so a cell's viewport stretches it over the cell
+        m_buffer_uber_cpu.resolution    = Vector2(static_cast<float>(m_decal_atlas_cell_size), static_cast<float>(m_decal_atlas_cell_size));
+        m_buffer_uber_cpu.transform     = m_buffer_frame_cpu.view_projection_ortho;
+        UpdateUberBuffer(cmd_list);
+
+        cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+        cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+        for (const auto& [texture, cell] : m_decal_atlas_copies)
+        {
+            const float cell_size = static_cast<float>(m_decal_atlas_cell_size);
+            cmd_list->SetViewport(RHI_Viewport(static_cast<float>(cell % m_decal_atlas_cells) * cell_size, static_cast<float>(cell / m_decal_atlas_cells) * cell_size, cell_size, cell_size));
+            cmd_list->SetTexture(28, texture);
             cmd_list->DrawIndexed(Rectangle::GetIndexCount());
-            cmd_list->EndRenderPass();
         }
-	}
+        cmd_list->EndRenderPass();
 
-	void Renderer::Pass_LumaSharpen(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
-	{
-		// Acquire shaders
-        const auto& shader_v = m_shaders[Shader_Quad_V];
-		const auto& shader_p = m_shaders[Shader_Sharpen_Luma_P];
-        if (!shader_p->IsCompiled() || !shader_v->IsCompiled())
+        m_decal_atlas_copies.clear();
+    }
+
+    void Renderer::Pass_MaterialArray(RHI_CommandList* cmd_list)
+    {
+        // Description: Copies the small material textures which materials asked for into their slices of the material texture array,
+        // a slice is only handed to the materials once its copy is recorded (see Renderer::MaterialArraySlice()).
+
+        // Acquire shaders
+        RHI_Shader* shader_v = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_p = m_shaders[Shader_Texture_P].get();
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
             return;
 
         // Set render state
         static RHI_PipelineState pipeline_state;
-        pipeline_state.shader_vertex                    = shader_v.get();
-        pipeline_state.shader_pixel                     = shader_p.get();
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.shader_pixel                     = shader_p;
         pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
         pipeline_state.blend_state                      = m_blend_disabled.get();
         pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
         pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
-        pipeline_state.render_target_color_textures[0]  = tex_out.get();
-        pipeline_state.clear_color[0]                   = Vector4::Zero;
-        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.render_target_color_textures[0]  = m_material_array.get();
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
         pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
-        pipeline_state.pass_name                        = "Pass_LumaSharpen";
+        pipeline_state.viewport                         = m_material_array->GetViewport();
+        pipeline_state.pass_name                        = "Pass_MaterialArray";
 
-        // Record commands
-        if (cmd_list->BeginRenderPass(pipeline_state))
+        // The viewport quad covers the slice, whatever the size of the texture
+        m_buffer_uber_cpu.resolution    = Vector2(static_cast<float>(m_material_array_slice_size), static_cast<float>(m_material_array_slice_size));
+        m_buffer_uber_cpu.transform     = m_buffer_frame_cpu.view_projection_ortho;
+
+        for (const auto& [texture, slice] : m_material_array_copies)
         {
-            // Update uber buffer
-            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            pipeline_state.render_target_color_texture_array_index = slice;
+
+            if (!cmd_list->BeginRenderPass(pipeline_state))
+                return;
+
             UpdateUberBuffer(cmd_list);
 
             cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
             cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-            cmd_list->SetTexture(28, tex_in);
+            cmd_list->SetTexture(28, texture);
             cmd_list->DrawIndexed(Rectangle::GetIndexCount());
             cmd_list->EndRenderPass();
+
+            m_material_array_lookup[texture->GetId()] = static_cast<int32_t>(slice);
         }
-	}
+
+        m_material_array_copies.clear();
+    }
 
 	void Renderer::Pass_Lines(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_out)
 	{
@@ -1719,7 +3349,7 @@ namespace Spartan
 		const bool draw_aabb		= m_options & Render_Debug_Aabb;
 		const bool draw_grid		= m_options & Render_Debug_Grid;
         const bool draw_lights      = m_options & Render_Debug_Lights;
-		const auto draw_lines		= !m_lines_list_depth_enabled.empty() || !m_lines_list_depth_disabled.empty(); // Any kind of lines, physics, user debug, etc.
+		const auto draw_lines		= !m_lines_list_depth_enabled.empty() || !m_lines_list_depth_disabled.empty() || !m_boxes_depth_enabled.empty() || !m_boxes_depth_disabled.empty(); // Any kind of lines, physics, user debug, etc.
 		const auto draw				= draw_picking_ray || draw_aabb || draw_grid || draw_lines || draw_lights;
 		if (!draw)
 			return;
@@ -1749,8 +3379,8 @@ namespace Spartan
 
                     if (light->GetLightType() == LightType_Spot)
                     {
-                        Vector3 start = light->GetTransform()->GetPosition();
-                        Vector3 end = light->GetTransform()->GetForward() * light->GetRange();
+                        Vector3 start = light->GetPositionRender();
+                        Vector3 end = light->GetDirectionRender() * light->GetRange();
                         DrawLine(start, start + end, Vector4(0, 1, 0, 1));
                     }
                 }
@@ -1763,7 +3393,7 @@ namespace Spartan
                 {
                     if (auto renderable = entity->GetRenderable())
                     {
-                        DrawBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
+                        DrawBox(renderable->GetAabbRender(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
                     }
                 }
 
@@ -1771,61 +3401,125 @@ namespace Spartan
                 {
                     if (auto renderable = entity->GetRenderable())
                     {
-                        DrawBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
+                        DrawBox(renderable->GetAabbRender(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
                     }
                 }
             }
         }
 
+        // Both kinds of lines go into the line buffer at once, each into a region of its own, and so do both kinds of boxes into the instance buffer
+        uint32_t line_vertex_count_depth_enabled    = 0;
+        uint32_t line_vertex_count_depth_disabled   = 0;
+        uint32_t line_vertex_offset_depth_enabled   = 0;
+        uint32_t line_vertex_offset_depth_disabled  = 0;
+        uint32_t box_count_depth_enabled            = 0;
+        uint32_t box_count_depth_disabled           = 0;
+        uint32_t box_offset                         = 0;
+        {
+            lock_guard<mutex> lock(m_lines_mutex);
+            if (UpdateLineBuffer(cmd_list, line_vertex_offset_depth_enabled, line_vertex_offset_depth_disabled))
+            {
+                line_vertex_count_depth_enabled     = static_cast<uint32_t>(m_lines_list_depth_enabled.size());
+                line_vertex_count_depth_disabled    = static_cast<uint32_t>(m_lines_list_depth_disabled.size());
+            }
+            m_lines_list_depth_enabled.clear();
+            m_lines_list_depth_disabled.clear();
+
+            m_instances_cpu.assign(m_boxes_depth_enabled.begin(), m_boxes_depth_enabled.end());
+            m_instances_cpu.insert(m_instances_cpu.end(), m_boxes_depth_disabled.begin(), m_boxes_depth_disabled.end());
+            if (UpdateInstanceBuffer(cmd_list, box_offset))
+            {
+                box_count_depth_enabled     = static_cast<uint32_t>(m_boxes_depth_enabled.size());
+                box_count_depth_disabled    = static_cast<uint32_t>(m_boxes_depth_disabled.size());
+            }
+            m_boxes_depth_enabled.clear();
+            m_boxes_depth_disabled.clear();
+        }
+
+        // Boxes, a single instanced draw per depth mode
+        const auto& shader_color_instanced_v = m_shaders[Shader_Color_Instanced_V];
+        const auto draw_boxes = [this, cmd_list, &tex_out, &shader_color_instanced_v, &shader_color_p](RHI_Texture* tex_depth, const uint32_t instance_offset, const uint32_t instance_count)
+        {
+            if (instance_count == 0 || !shader_color_instanced_v->IsCompiled())
+                return;
+
+            // Set render state
+            static RHI_PipelineState pipeline_state;
+            pipeline_state.shader_vertex                    = shader_color_instanced_v.get();
+            pipeline_state.shader_pixel                     = shader_color_p.get();
+            pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_wireframe.get();
+            pipeline_state.blend_state                      = tex_depth ? m_blend_alpha.get() : m_blend_disabled.get();
+            pipeline_state.depth_stencil_state              = tex_depth ? m_depth_stencil_on_off_r.get() : m_depth_stencil_off_off.get();
+            pipeline_state.vertex_buffer_stride             = m_vertex_buffer_box->GetStride();
+            pipeline_state.render_target_color_textures[0]  = tex_out.get();
+            pipeline_state.render_target_depth_texture      = tex_depth;
+            pipeline_state.viewport                         = tex_out->GetViewport();
+            pipeline_state.primitive_topology               = RHI_PrimitiveTopology_LineList;
+            pipeline_state.pass_name                        = tex_depth ? "Pass_Lines_Boxes" : "Pass_Lines_Boxes_No_Depth";
+
+            // Create and submit command list
+            if (cmd_list->BeginRenderPass(pipeline_state))
+            {
+                cmd_list->SetBufferIndex(m_index_buffer_box.get());
+                cmd_list->SetBufferVertex(m_vertex_buffer_box.get());
+                cmd_list->SetBufferInstance(m_buffer_instance_gpu.get());
+                cmd_list->DrawIndexed(m_index_buffer_box->GetIndexCount(), 0, 0, instance_count, instance_offset);
+                cmd_list->EndRenderPass();
+            }
+        };
+
         // Draw lines with depth
         {
+            // The depth buffer can only be attached when the frame is rendered at the output resolution, below it the lines draw on top
+            RHI_Texture* tex_depth = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+            tex_depth = tex_depth->GetWidth() == tex_out->GetWidth() && tex_depth->GetHeight() == tex_out->GetHeight() ? tex_depth : nullptr;
+
             // Grid
-            if (draw_grid)
+            const auto& shader_grid_v = m_shaders[Shader_Grid_V];
+            const auto& shader_grid_p = m_shaders[Shader_Grid_P];
+            if (draw_grid && shader_grid_v->IsCompiled() && shader_grid_p->IsCompiled())
             {
+                if (!m_gizmo_grid)
+                {
+                    m_gizmo_grid = make_unique<Grid>(m_rhi_device);
+                }
+
                 // Set render state
                 static RHI_PipelineState pipeline_state;
-                pipeline_state.shader_vertex                    = shader_color_v.get();
-                pipeline_state.shader_pixel                     = shader_color_p.get();
-                pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_wireframe.get();
+                pipeline_state.shader_vertex                    = shader_grid_v.get();
+                pipeline_state.shader_pixel                     = shader_grid_p.get();
+                pipeline_state.rasterizer_state                 = m_rasterizer_cull_none_solid.get();
                 pipeline_state.blend_state                      = m_blend_alpha.get();
-                pipeline_state.depth_stencil_state              = m_depth_stencil_on_off_r.get();
+                pipeline_state.depth_stencil_state              = tex_depth ? m_depth_stencil_on_off_r.get() : m_depth_stencil_off_off.get();
                 pipeline_state.vertex_buffer_stride             = m_gizmo_grid->GetVertexBuffer()->GetStride();
                 pipeline_state.render_target_color_textures[0]  = tex_out.get();
-                pipeline_state.render_target_depth_texture      = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+                pipeline_state.render_target_depth_texture      = tex_depth;
                 pipeline_state.viewport                         = tex_out->GetViewport();
-                pipeline_state.primitive_topology               = RHI_PrimitiveTopology_LineList;
+                pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
                 pipeline_state.pass_name                        = "Pass_Lines_Grid";
 
                 // Create and submit command list
                 if (cmd_list->BeginRenderPass(pipeline_state))
                 {
-                    // Update uber buffer
+                    // Update uber buffer (the extent of the grid goes in the alpha, the shader fades the lines out towards it)
+                    const float extent              = Helper::Min(m_camera->GetFarPlane(), 200.0f);
                     m_buffer_uber_cpu.resolution    = m_resolution;
-                    m_buffer_uber_cpu.transform     = m_gizmo_grid->ComputeWorldMatrix(m_camera->GetTransform()) * m_buffer_frame_cpu.view_projection_unjittered;
+                    m_buffer_uber_cpu.transform     = m_gizmo_grid->ComputeWorldMatrix(m_camera->GetTransform(), extent);
+                    m_buffer_uber_cpu.color         = Vector4(1.0f, 1.0f, 1.0f, extent);
                     UpdateUberBuffer(cmd_list);
 
-                    cmd_list->SetBufferIndex(m_gizmo_grid->GetIndexBuffer().get());
                     cmd_list->SetBufferVertex(m_gizmo_grid->GetVertexBuffer().get());
-                    cmd_list->DrawIndexed(m_gizmo_grid->GetIndexCount());
+                    cmd_list->Draw(m_gizmo_grid->GetVertexCount());
                     cmd_list->EndRenderPass();
                 }
             }
 
+            // Boxes
+            draw_boxes(tex_depth, box_offset, box_count_depth_enabled);
+
             // Lines
-            const auto line_vertex_buffer_size = static_cast<uint32_t>(m_lines_list_depth_enabled.size());
-            if (line_vertex_buffer_size != 0)
+            if (line_vertex_count_depth_enabled != 0)
             {
-                // Grow vertex buffer (if needed)
-                if (line_vertex_buffer_size > m_vertex_buffer_lines->GetVertexCount())
-                {
-                    m_vertex_buffer_lines->CreateDynamic<RHI_Vertex_PosCol>(line_vertex_buffer_size);
-                }
-
-                // Update vertex buffer
-                const auto buffer = static_cast<RHI_Vertex_PosCol*>(m_vertex_buffer_lines->Map());
-                copy(m_lines_list_depth_enabled.begin(), m_lines_list_depth_enabled.end(), buffer);
-                m_vertex_buffer_lines->Unmap();
-                m_lines_list_depth_enabled.clear();
 
                 // Set render state
                 static RHI_PipelineState pipeline_state;
@@ -1833,10 +3527,10 @@ namespace Spartan
                 pipeline_state.shader_pixel                     = shader_color_p.get();
                 pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_wireframe.get();
                 pipeline_state.blend_state                      = m_blend_alpha.get();
-                pipeline_state.depth_stencil_state              = m_depth_stencil_on_off_r.get();
+                pipeline_state.depth_stencil_state              = tex_depth ? m_depth_stencil_on_off_r.get() : m_depth_stencil_off_off.get();
                 pipeline_state.vertex_buffer_stride             = m_vertex_buffer_lines->GetStride();
                 pipeline_state.render_target_color_textures[0]  = tex_out.get();
-                pipeline_state.render_target_depth_texture      = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+                pipeline_state.render_target_depth_texture      = tex_depth;
                 pipeline_state.viewport                         = tex_out->GetViewport();
                 pipeline_state.primitive_topology               = RHI_PrimitiveTopology_LineList;
                 pipeline_state.pass_name                        = "Pass_Lines";
@@ -1844,28 +3538,19 @@ namespace Spartan
                 // Create and submit command list
                 if (cmd_list->BeginRenderPass(pipeline_state))
                 {
-                    cmd_list->SetBufferVertex(m_vertex_buffer_lines.get());
-                    cmd_list->Draw(line_vertex_buffer_size);
+                    cmd_list->SetBufferVertex(m_vertex_buffer_lines.get(), static_cast<uint64_t>(line_vertex_offset_depth_enabled) * m_vertex_buffer_lines->GetStride());
+                    cmd_list->Draw(line_vertex_count_depth_enabled);
                     cmd_list->EndRenderPass();
                 }
             }
         }
 
+        // Draw boxes without depth
+        draw_boxes(nullptr, box_offset + box_count_depth_enabled, box_count_depth_disabled);
+
         // Draw lines without depth
-        const auto line_vertex_buffer_size = static_cast<uint32_t>(m_lines_list_depth_disabled.size());
-        if (line_vertex_buffer_size != 0)
+        if (line_vertex_count_depth_disabled != 0)
         {
-            // Grow vertex buffer (if needed)
-            if (line_vertex_buffer_size > m_vertex_buffer_lines->GetVertexCount())
-            {
-                m_vertex_buffer_lines->CreateDynamic<RHI_Vertex_PosCol>(line_vertex_buffer_size);
-            }
-
-            // Update vertex buffer
-            const auto buffer = static_cast<RHI_Vertex_PosCol*>(m_vertex_buffer_lines->Map());
-            copy(m_lines_list_depth_disabled.begin(), m_lines_list_depth_disabled.end(), buffer);
-            m_vertex_buffer_lines->Unmap();
-            m_lines_list_depth_disabled.clear();
 
             // Set render state
             static RHI_PipelineState pipeline_state;
@@ -1883,8 +3568,8 @@ namespace Spartan
             // Create and submit command list
             if (cmd_list->BeginRenderPass(pipeline_state))
             {
-                cmd_list->SetBufferVertex(m_vertex_buffer_lines.get());
-                cmd_list->Draw(line_vertex_buffer_size);
+                cmd_list->SetBufferVertex(m_vertex_buffer_lines.get(), static_cast<uint64_t>(line_vertex_offset_depth_disabled) * m_vertex_buffer_lines->GetStride());
+                cmd_list->Draw(line_vertex_count_depth_disabled);
                 cmd_list->EndRenderPass();
             }
         }
@@ -1902,6 +3587,63 @@ namespace Spartan
 		if (lights.empty() || !shader_quad_v->IsCompiled() || !shader_texture_p->IsCompiled())
 			return;
 
+        if (!m_gizmo_tex_icons)
+        {
+            CreateTexturesGizmo();
+
+            if (!m_gizmo_tex_icons)
+                return;
+        }
+
+        // Gather the quads of every visible icon, in the screen space which the orthographic projection expects (see Rectangle::CreateBuffers())
+        m_icons_cpu.clear();
+        const float atlas_width     = static_cast<float>(m_gizmo_tex_icons->GetWidth());
+        const float atlas_height    = static_cast<float>(m_gizmo_tex_icons->GetHeight());
+        for (const auto& entity : lights)
+        {
+            // Light can be null if it just got removed and our buffer doesn't update till the next frame
+            Light* light = entity->GetComponent<Light>();
+            if (!light)
+                continue;
+
+            const Vector3 position_light_world      = light->GetPositionRender();
+            const Vector3 position_camera_world     = m_buffer_frame_cpu.camera_position;
+            const Vector3 direction_camera_to_light = (position_light_world - position_camera_world).Normalized();
+            const float v_dot_l                     = Vector3::Dot(m_buffer_frame_cpu.camera_direction, direction_camera_to_light);
+
+            // Only draw if it's inside our view
+            if (v_dot_l <= 0.5f)
+                continue;
+
+            // Compute light screen space position and scale (based on distance from the camera)
+            const Vector2 position_light_screen = m_camera->Project(position_light_world);
+            const float distance                = (position_camera_world - position_light_world).Length() + Helper::M_EPSILON;
+            const float scale                   = Helper::Clamp(m_gizmo_size_max / distance, m_gizmo_size_min, m_gizmo_size_max);
+
+            // The icon of the light type
+            const Vector4& rect = m_gizmo_icons_rect[light->GetLightType()];
+            const float width   = rect.z * scale;
+            const float height  = rect.w * scale;
+            const float left    = -(m_viewport.width * 0.5f) + position_light_screen.x - width * 0.5f;
+            const float top     = (m_viewport.height * 0.5f) - position_light_screen.y + height * 0.5f;
+            const float right   = left + width;
+            const float bottom  = top - height;
+            const float u_left  = rect.x / atlas_width;
+            const float u_right = (rect.x + rect.z) / atlas_width;
+            const float v_bottom= rect.w / atlas_height;
+
+            m_icons_cpu.emplace_back(Vector3(left,   top,    0.0f), Vector2(u_left,  0.0f));
+            m_icons_cpu.emplace_back(Vector3(right,  bottom, 0.0f), Vector2(u_right, v_bottom));
+            m_icons_cpu.emplace_back(Vector3(left,   bottom, 0.0f), Vector2(u_left,  v_bottom));
+            m_icons_cpu.emplace_back(Vector3(left,   top,    0.0f), Vector2(u_left,  0.0f));
+            m_icons_cpu.emplace_back(Vector3(right,  top,    0.0f), Vector2(u_right, 0.0f));
+            m_icons_cpu.emplace_back(Vector3(right,  bottom, 0.0f), Vector2(u_right, v_bottom));
+        }
+
+        uint32_t vertex_offset = 0;
+        if (m_icons_cpu.empty() || !UpdateIconBuffer(cmd_list, vertex_offset))
+            return;
+
         // Set render state
         static RHI_PipelineState pipeline_state;
         pipeline_state.shader_vertex                    = shader_quad_v.get();
@@ -1909,71 +3651,24 @@ namespace Spartan
         pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
         pipeline_state.blend_state                      = m_blend_alpha.get();
         pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
-        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride(); // stride matches rect
+        pipeline_state.vertex_buffer_stride             = m_vertex_buffer_icons->GetStride();
         pipeline_state.render_target_color_textures[0]  = tex_out;
         pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
         pipeline_state.viewport                         = tex_out->GetViewport();
         pipeline_state.pass_name                        = "Pass_Gizmos_Lights";
 
-        // For each light
-        for (const auto& entity : lights)
+        // Every icon, with a single draw
+        if (cmd_list->BeginRenderPass(pipeline_state))
         {
-            if (cmd_list->BeginRenderPass(pipeline_state))
-            {
-                // Light can be null if it just got removed and our buffer doesn't update till the next frame
-                if (Light* light = entity->GetComponent<Light>())
-                {
-                    auto position_light_world       = entity->GetTransform()->GetPosition();
-                    auto position_camera_world      = m_camera->GetTransform()->GetPosition();
-                    auto direction_camera_to_light  = (position_light_world - position_camera_world).Normalized();
-                    const auto v_dot_l                    = Vector3::Dot(m_camera->GetTransform()->GetForward(), direction_camera_to_light);
-        
-                    // Only draw if it's inside our view
-                    if (v_dot_l > 0.5f)
-                    {
-                        // Compute light screen space position and scale (based on distance from the camera)
-                        const auto position_light_screen    = m_camera->Project(position_light_world);
-                        const auto distance                 = (position_camera_world - position_light_world).Length() + Helper::M_EPSILON;
-                        auto scale                          = m_gizmo_size_max / distance;
-                        scale                               = Helper::Clamp(scale, m_gizmo_size_min, m_gizmo_size_max);
-        
-                        // Choose texture based on light type
-                        shared_ptr<RHI_Texture> light_tex = nullptr;
-                        const auto type = light->GetLightType();
-                        if (type == LightType_Directional)	light_tex = m_gizmo_tex_light_directional;
-                        else if (type == LightType_Point)	light_tex = m_gizmo_tex_light_point;
-                        else if (type == LightType_Spot)	light_tex = m_gizmo_tex_light_spot;
-        
-                        // Construct appropriate rectangle
-                        const auto tex_width = light_tex->GetWidth() * scale;
-                        const auto tex_height = light_tex->GetHeight() * scale;
-                        auto rectangle = Math::Rectangle
-                        (
-                            position_light_screen.x - tex_width * 0.5f,
-                            position_light_screen.y - tex_height * 0.5f,
-                            position_light_screen.x + tex_width,
-                            position_light_screen.y + tex_height
-                        );
-                        if (rectangle != m_gizmo_light_rect)
-                        {
-                            m_gizmo_light_rect = rectangle;
-                            m_gizmo_light_rect.CreateBuffers(this);
-                        }
-        
-                        // Update uber buffer
-                        m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_width), static_cast<float>(tex_width));
-                        m_buffer_uber_cpu.transform = m_buffer_frame_cpu.view_projection_ortho;
-                        UpdateUberBuffer(cmd_list);
-        
-                        cmd_list->SetTexture(28, light_tex);
-                        cmd_list->SetBufferIndex(m_gizmo_light_rect.GetIndexBuffer());
-                        cmd_list->SetBufferVertex(m_gizmo_light_rect.GetVertexBuffer());
-                        cmd_list->DrawIndexed(Rectangle::GetIndexCount());
-                    }
-                }
-                cmd_list->EndRenderPass();
-            }
-        }  
+            m_buffer_uber_cpu.resolution    = Vector2(atlas_width, atlas_height);
+            m_buffer_uber_cpu.transform     = m_buffer_frame_cpu.view_projection_ortho;
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetTexture(28, m_gizmo_tex_icons);
+            cmd_list->SetBufferVertex(m_vertex_buffer_icons.get(), static_cast<uint64_t>(vertex_offset) * m_vertex_buffer_icons->GetStride());
+            cmd_list->Draw(static_cast<uint32_t>(m_icons_cpu.size()));
+            cmd_list->EndRenderPass();
+        }
 	}
 
     void Renderer::Pass_TransformHandle(RHI_CommandList* cmd_list, RHI_Texture* tex_out)
@@ -1982,7 +3677,7 @@ namespace Spartan
             return;
 
         // Acquire resources
-        auto const& shader_gizmo_transform_v    = m_shaders[Shader_Entity_V];
+        auto const& shader_gizmo_transform_v    = m_shaders[Shader_Entity_Transform_V];
         auto const& shader_gizmo_transform_p    = m_shaders[Shader_Entity_Transform_P];
         if (!shader_gizmo_transform_v->IsCompiled() || !shader_gizmo_transform_p->IsCompiled())
             return;
@@ -1990,6 +3685,21 @@ namespace Spartan
         // Transform
         if (m_gizmo_transform->Update(m_camera.get(), m_gizmo_transform_size, m_gizmo_transform_speed))
         {
+            // The axes are instances of the handle's geometry, their colors are indexed by the instance
+            static const array<Vector3, 4> axes = { Vector3::Right, Vector3::Up, Vector3::Forward, Vector3::One };
+            const TransformHandle& handle       = m_gizmo_transform->GetHandle();
+            const uint32_t axis_count           = m_gizmo_transform->DrawXYZ() ? 4 : 3;
+            m_instances_cpu.clear();
+            for (uint32_t i = 0; i < axis_count; i++)
+            {
+                m_instances_cpu.emplace_back(handle.GetTransform(axes[i]), Matrix::Identity);
+                m_buffer_uber_cpu.transform_axis_colors[i] = Vector4(handle.GetColor(axes[i]), 1.0f);
+            }
+
+            uint32_t instance_offset = 0;
+            if (!UpdateInstanceBuffer(cmd_list, instance_offset))
+                return;
+
             // Set render state
             static RHI_PipelineState pipeline_state;
             pipeline_state.shader_vertex                    = shader_gizmo_transform_v.get();
@@ -2001,65 +3711,18 @@ namespace Spartan
             pipeline_state.render_target_color_textures[0]  = tex_out;
             pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
             pipeline_state.viewport                         = tex_out->GetViewport();
+            pipeline_state.pass_name                        = "Pass_Gizmos_Transform";
 
-            // Axis - X
-            pipeline_state.pass_name = "Pass_Gizmos_Axis_X";
-            if (cmd_list->BeginRenderPass(pipeline_state))
-            {
-                m_buffer_uber_cpu.transform         = m_gizmo_transform->GetHandle().GetTransform(Vector3::Right);
-                m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::Right);
-                UpdateUberBuffer(cmd_list);
-            
-                cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
-                cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
-                cmd_list->EndRenderPass();
-            }
-            
-            // Axis - Y
-            pipeline_state.pass_name = "Pass_Gizmos_Axis_Y";
-            if (cmd_list->BeginRenderPass(pipeline_state))
-            {
-                m_buffer_uber_cpu.transform         = m_gizmo_transform->GetHandle().GetTransform(Vector3::Up);
-                m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::Up);
-                UpdateUberBuffer(cmd_list);
-
-                cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
-                cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
-                cmd_list->EndRenderPass();
-            }
-            
-            // Axis - Z
-            pipeline_state.pass_name = "Pass_Gizmos_Axis_Z";
             if (cmd_list->BeginRenderPass(pipeline_state))
             {
-                m_buffer_uber_cpu.transform         = m_gizmo_transform->GetHandle().GetTransform(Vector3::Forward);
-                m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::Forward);
                 UpdateUberBuffer(cmd_list);
 
                 cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
                 cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
+                cmd_list->SetBufferInstance(m_buffer_instance_gpu.get());
+                cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount(), 0, 0, axis_count, instance_offset);
                 cmd_list->EndRenderPass();
             }
-            
-            // Axes - XYZ
-            if (m_gizmo_transform->DrawXYZ())
-            {
-                pipeline_state.pass_name = "Pass_Gizmos_Axis_XYZ";
-                if (cmd_list->BeginRenderPass(pipeline_state))
-                {
-                    m_buffer_uber_cpu.transform         = m_gizmo_transform->GetHandle().GetTransform(Vector3::One);
-                    m_buffer_uber_cpu.transform_axis    = m_gizmo_transform->GetHandle().GetColor(Vector3::One);
-                    UpdateUberBuffer(cmd_list);
-
-                    cmd_list->SetBufferIndex(m_gizmo_transform->GetIndexBuffer());
-                    cmd_list->SetBufferVertex(m_gizmo_transform->GetVertexBuffer());
-                    cmd_list->DrawIndexed(m_gizmo_transform->GetIndexCount());
-                    cmd_list->EndRenderPass();
-                }
-            }
         }
 	}
 
@@ -2086,7 +3749,7 @@ namespace Spartan
                 return;
 
             // Acquire shaders
-            const auto& shader_v = m_shaders[Shader_Entity_V];
+            const auto& shader_v = m_shaders[model->IsVertexSkinned() ? Shader_Entity_Skinned_V : (model->IsVertexCompact() ? Shader_Entity_Compact_V : Shader_Entity_V)];
             const auto& shader_p = m_shaders[Shader_Entity_Outline_P];
             if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
                 return;
@@ -2094,16 +3757,19 @@ namespace Spartan
             RHI_Texture* tex_depth  = m_render_targets[RenderTarget_Gbuffer_Depth].get();
             RHI_Texture* tex_normal = m_render_targets[RenderTarget_Gbuffer_Normal].get();
 
+            // The depth buffer can only be attached when the frame is rendered at the output resolution (it's still sampled either way)
+            const bool attach_depth = tex_depth->GetWidth() == tex_out->GetWidth() && tex_depth->GetHeight() == tex_out->GetHeight();
+
             // Set render state
             static RHI_PipelineState pipeline_state;
             pipeline_state.shader_vertex                            = shader_v.get();
             pipeline_state.shader_pixel                             = shader_p.get();
             pipeline_state.rasterizer_state                         = m_rasterizer_cull_back_solid.get();
             pipeline_state.blend_state                              = m_blend_alpha.get();
-            pipeline_state.depth_stencil_state                      = m_depth_stencil_on_off_r.get();
+            pipeline_state.depth_stencil_state                      = attach_depth ? m_depth_stencil_on_off_r.get() : m_depth_stencil_off_off.get();
             pipeline_state.vertex_buffer_stride                     = model->GetVertexBuffer()->GetStride();
             pipeline_state.render_target_color_textures[0]          = tex_out.get();
-            pipeline_state.render_target_depth_texture              = tex_depth;
+            pipeline_state.render_target_depth_texture              = attach_depth ? tex_depth : nullptr;
             pipeline_state.render_target_depth_texture_read_only    = true;
             pipeline_state.primitive_topology                       = RHI_PrimitiveTopology_TriangleList;
             pipeline_state.viewport                                 = tex_out->GetViewport();
@@ -2115,11 +3781,21 @@ namespace Spartan
                  // Update uber buffer with entity transform
                 if (Transform* transform = entity->GetTransform())
                 {
-                    m_buffer_uber_cpu.transform     = transform->GetMatrix();
+                    m_buffer_uber_cpu.transform     = transform->GetMatrixRender();
                     m_buffer_uber_cpu.resolution    = Vector2(tex_out->GetWidth(), tex_out->GetHeight());
                     UpdateUberBuffer(cmd_list);
                 }
 
+                // The bounds which compact positions are normalized to
+                m_buffer_draw_cpu.position_offset   = model->GetVertexPositionOffset();
+                m_buffer_draw_cpu.position_scale    = model->GetVertexPositionScale();
+                UpdateDrawBuffer(cmd_list);
+
+                if (model->IsVertexSkinned())
+                {
+                    UpdateSkinBuffer(cmd_list, renderable);
+                }
+
                 cmd_list->SetTexture(12, tex_depth);
                 cmd_list->SetTexture(9, tex_normal);
                 cmd_list->SetBufferVertex(model->GetVertexBuffer());
@@ -2136,10 +3812,16 @@ namespace Spartan
         const bool draw         = m_options & Render_Debug_PerformanceMetrics;
         const bool empty        = m_profiler->GetMetrics().empty();
         const auto& shader_v    = m_shaders[Shader_Font_V];
-        const auto& shader_p    = m_shaders[Shader_Font_P];
+        const auto& shader_p    = m_shaders[m_font->IsSdf() ? Shader_Font_Sdf_P : Shader_Font_P];
         if (!draw || empty || !shader_v->IsCompiled() || !shader_p->IsCompiled())
             return;
 
+        // Update text, all the runs of the frame go into one vertex buffer (and unchanged runs aren't laid out again)
+        const auto text_pos = Vector2(-m_viewport.width * 0.5f + 5.0f, m_viewport.height * 0.5f - m_font->GetSize() - 2.0f);
+        m_font->SetText(m_profiler->GetMetrics(), text_pos);
+        if (!m_font->UpdateBuffers() || m_font->GetVertexCount() == 0)
+            return;
+
         // Set render state
         static RHI_PipelineState pipeline_state;
         pipeline_state.shader_vertex                    = shader_v.get();
@@ -2151,15 +3833,11 @@ namespace Spartan
         pipeline_state.render_target_color_textures[0]  = tex_out;
         pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
         pipeline_state.viewport                         = tex_out->GetViewport();
-        pipeline_state.pass_name                        = "Pass_Text";
-
-        // Update text
-        const auto text_pos = Vector2(-m_viewport.width * 0.5f + 5.0f, m_viewport.height * 0.5f - m_font->GetSize() - 2.0f);
-        m_font->SetText(m_profiler->GetMetrics(), text_pos);
+        pipeline_state.pass_name                        = "Pass_Text";
 
         // Draw outline
-        if (m_font->GetOutline() != Font_Outline_None && m_font->GetOutlineSize() != 0)
-        { 
+        if (m_font->GetOutline() != Font_Outline_None && m_font->GetOutlineSize() != 0 && m_font->GetAtlasOutline())
+        {
             if (cmd_list->BeginRenderPass(pipeline_state))
             {
                 // Update uber buffer
@@ -2167,10 +3845,9 @@ namespace Spartan
                 m_buffer_uber_cpu.color         = m_font->GetColorOutline();
                 UpdateUberBuffer(cmd_list);
 
-                cmd_list->SetBufferIndex(m_font->GetIndexBuffer());
                 cmd_list->SetBufferVertex(m_font->GetVertexBuffer());
                 cmd_list->SetTexture(30, m_font->GetAtlasOutline());
-                cmd_list->DrawIndexed(m_font->GetIndexCount());
+                cmd_list->Draw(m_font->GetVertexCount());
                 cmd_list->EndRenderPass();
             }
         }
@@ -2183,10 +3860,9 @@ namespace Spartan
             m_buffer_uber_cpu.color         = m_font->GetColor();
             UpdateUberBuffer(cmd_list);
 
-            cmd_list->SetBufferIndex(m_font->GetIndexBuffer());
             cmd_list->SetBufferVertex(m_font->GetVertexBuffer());
             cmd_list->SetTexture(30, m_font->GetAtlas());
-            cmd_list->DrawIndexed(m_font->GetIndexCount());
+            cmd_list->Draw(m_font->GetVertexCount());
             cmd_list->EndRenderPass();
         }
 	}
@@ -2273,6 +3949,13 @@ namespace Spartan
             shader_type = Shader_Texture_P;
         }
 
+        // The debug shaders read a 2D texture, so the environment which the slices are prefiltered from is shown
+        if (m_render_target_debug == RenderTarget_Brdf_Prefiltered_Environment)
+        {
+            texture     = GetEnvironmentTexture().get();
+            shader_type = Shader_DebugChannelRgbGammaCorrect_P;
+        }
+
         // Acquire shaders
         RHI_Shader* shader_v = m_shaders[Shader_Quad_V].get();
         RHI_Shader* shader_p = m_shaders[shader_type].get();
@@ -2355,6 +4038,597 @@ namespace Spartan
         }
     }
 
+    void Renderer::Pass_EnvironmentPrefilter(RHI_CommandList* cmd_list)
+    {
+        // Description: The environment is convolved once per roughness level with a GGX lobe (and once with a cosine lobe for the irradiance),
+        // into the slices of a small texture array. Shading then does a couple of bilinear lookups instead of sampling mips of the raw environment.
+
+        if (m_environment_prefiltered || !m_tex_environment)
+            return;
+
+        // Acquire shaders
+        RHI_Shader* shader_v            = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_p_specular   = m_shaders[Shader_EnvironmentPrefilter_Specular_P].get();
+        RHI_Shader* shader_p_diffuse    = m_shaders[Shader_EnvironmentPrefilter_Diffuse_P].get();
+        if (!shader_v->IsCompiled() || !shader_p_specular->IsCompiled() || !shader_p_diffuse->IsCompiled())
+            return;
+
+        // Acquire render target
+        RHI_Texture* tex_out = m_render_targets[RenderTarget_Brdf_Prefiltered_Environment].get();
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.render_target_color_textures[0]  = tex_out;
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.viewport                         = tex_out->GetViewport();
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_EnvironmentPrefilter";
+
+        // The specular slices, slice i is the squared roughness (i + 1) / count, the last slice is the irradiance
+        for (uint32_t i = 0; i <= m_environment_slices_specular; i++)
+        {
+            const bool is_diffuse = i == m_environment_slices_specular;
+
+            pipeline_state.shader_pixel                             = is_diffuse ? shader_p_diffuse : shader_p_specular;
+            pipeline_state.render_target_color_texture_array_index  = i;
+
+            if (!cmd_list->BeginRenderPass(pipeline_state))
+                return;
+
+            // Update uber buffer
+            m_buffer_uber_cpu.resolution        = Vector2(static_cast<float>(tex_out->GetWidth()), static_cast<float>(tex_out->GetHeight()));
+            m_buffer_uber_cpu.mat_roughness_mul = Helper::Sqrt(static_cast<float>(i + 1) / static_cast<float>(m_environment_slices_specular));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(20, m_tex_environment);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+
+        m_environment_prefiltered = true;
+    }
+
+    void Renderer::Pass_ImpostorBake(RHI_CommandList* cmd_list)
+    {
+        // Description: One requested impostor per frame, the model is rendered orthographically from the direction of every frame
+        // (decoded the same way the impostor shader picks them) into its cell of the albedo and normal atlases.
+
+        if (m_impostor_bake_requests.empty())
+            return;
+
+        const auto it = m_impostor_bake_requests.begin();
+        const ImpostorBakeRequest& request = it->second;
+        const Model* model = request.model.get();
+
+        // Acquire shaders
+        RHI_Shader* shader_v = m_shaders[model->IsVertexCompact() ? Shader_Impostor_Bake_Compact_V : Shader_Impostor_Bake_V].get();
+        RHI_Shader* shader_p = m_shaders[Shader_Impostor_Bake_P].get();
+        if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+            return;
+
+        // Acquire render targets
+        const uint32_t size = m_impostor_frames * m_impostor_frame_size;
+        Impostor impostor;
+        impostor.albedo = make_shared<RHI_Texture2D>(m_context, size, size, RHI_Format_R8G8B8A8_Unorm, 1, 0, "impostor_albedo");
+        impostor.normal = make_shared<RHI_Texture2D>(m_context, size, size, RHI_Format_R8G8B8A8_Unorm, 1, 0, "impostor_normal");
+        if (!m_impostor_depth)
+        {
+            m_impostor_depth = make_shared<RHI_Texture2D>(m_context, size, size, RHI_Format_D32_Float, 1, 0, "impostor_depth");
+        }
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.shader_pixel                     = shader_p;
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_on_off_w.get();
+        pipeline_state.vertex_buffer_stride             = static_cast<uint32_t>(model->IsVertexCompact() ? sizeof(RHI_Vertex_PosTexNorTanCompact) : sizeof(RHI_Vertex_PosTexNorTan));
+        pipeline_state.render_target_color_textures[0]  = impostor.albedo.get();
+        pipeline_state.clear_color[0]                   = Vector4::Zero;
+        pipeline_state.render_target_color_textures[1]  = impostor.normal.get();
+        pipeline_state.clear_color[1]                   = Vector4::Zero;
+        pipeline_state.render_target_depth_texture      = m_impostor_depth.get();
+        pipeline_state.clear_depth                      = GetClearDepth();
+        pipeline_state.viewport                         = impostor.albedo->GetViewport();
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_ImpostorBake";
+
+        // Record commands
+        if (!cmd_list->BeginRenderPass(pipeline_state))
+            return;
+
+        cmd_list->SetBufferIndex(model->GetIndexBuffer());
+        cmd_list->SetBufferVertex(model->GetVertexBuffer());
+
+        // The bounds which compact positions are normalized to
+        m_buffer_draw_cpu.position_offset   = model->GetVertexPositionOffset();
+        m_buffer_draw_cpu.position_scale    = model->GetVertexPositionScale();
+        UpdateDrawBuffer(cmd_list);
+
+        // Bind material
+        Material* material = request.material.get();
+        RHI_Texture* tex_color = material->GetTexture_Ptr(Material_Color);
+        cmd_list->SetTexture(0, tex_color ? tex_color : m_tex_white.get());
+        m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
+        m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
+        m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
+        UpdateUberBuffer(cmd_list);
+
+        // The frames look at the center of the bounds from outside of them, and see all of them
+        const Vector3 center    = request.bounding_box.GetCenter();
+        const float radius      = Helper::Max(request.bounding_box.GetExtents().Length(), Helper::M_EPSILON);
+        const bool reverse_z    = GetOption(Render_ReverseZ);
+        const Matrix projection = Matrix::CreateOrthographicLH(radius * 2.0f, radius * 2.0f, reverse_z ? radius * 3.0f : radius, reverse_z ? radius : radius * 3.0f);
+        for (uint32_t j = 0; j < m_impostor_frames; j++)
+        {
+            for (uint32_t i = 0; i < m_impostor_frames; i++)
+            {
+                // Hemi-octahedral decoding of the frame's center, as in the shader
+                const float u           = (static_cast<float>(i) + 0.5f) / static_cast<float>(m_impostor_frames) * 2.0f - 1.0f;
+                const float v           = (static_cast<float>(j) + 0.5f) / static_cast<float>(m_impostor_frames) * 2.0f - 1.0f;
+                Vector3 direction       = Vector3((u + v) * 0.5f, 0.0f, (u - v) * 0.5f);
+                direction.y             = 1.0f - Helper::Abs(direction.x) - Helper::Abs(direction.z);
+                direction.Normalize();
+                const Vector3 up        = Helper::Abs(direction.y) > 0.99f ? Vector3::Forward : Vector3::Up;
+                const Matrix view       = Matrix::CreateLookAtLH(center + direction * radius * 2.0f, center, up);
+
+                const float frame_size = static_cast<float>(m_impostor_frame_size);
+                cmd_list->SetViewport(RHI_Viewport(static_cast<float>(i) * frame_size, static_cast<float>(j) * frame_size, frame_size, frame_size));
+
+                m_buffer_object_cpu.wvp_current = view * projection;
+                if (!UpdateObjectBuffer(cmd_list))
+                    continue;
+
+                cmd_list->DrawIndexed(request.index_count, request.index_offset, request.vertex_offset);
+            }
+        }
+        cmd_list->EndRenderPass();
+
+        impostor.center_radius = Vector4(center.x, center.y, center.z, radius);
+        m_impostors[it->first] = move(impostor);
+        m_impostor_bake_requests.erase(it);
+    }
+
+    void Renderer::Pass_View(RHI_CommandList* cmd_list)
+    {
+        // Description: The view which the snapshot picked, drawn by Pass_Forward() with its camera into its own targets
+
+        if (!m_view)
+            return;
+
+        View& view = *m_view;
+
+        // Acquire render targets, a fraction of the render resolution
+        const uint32_t width    = Helper::Max(static_cast<uint32_t>(m_resolution_render.x * view.request.resolution_scale), 1u);
+        const uint32_t height   = Helper::Max(static_cast<uint32_t>(m_resolution_render.y * view.request.resolution_scale), 1u);
+        if (!view.color || view.color->GetWidth() != width || view.color->GetHeight() != height)
+        {
+            shared_ptr<RHI_Texture> color = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16B16A16_Float, 1, 0, "view_color");
+            shared_ptr<RHI_Texture> depth = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_D32_Float, 1, 0, "view_depth");
+
+            lock_guard<mutex> lock(m_entities_mutex);
+            view.color = color;
+            view.depth = depth;
+        }
+
+        // The frame's constants with the view's camera
+        BufferFrame frame                   = m_buffer_frame_cpu;
+        frame.view                          = m_view_frame.view;
+        frame.projection                    = m_view_frame.projection;
+        frame.view_projection               = m_view_frame.view_projection;
+        frame.view_projection_inv           = m_view_frame.view_projection_inv;
+        frame.view_projection_unjittered    = m_view_frame.view_projection_unjittered;
+        frame.camera_near                   = m_view_frame.camera_near;
+        frame.camera_far                    = m_view_frame.camera_far;
+        frame.camera_position               = m_view_frame.camera_position;
+        frame.camera_direction              = m_view_frame.camera_direction;
+
+        const float pixels_per_unit = static_cast<float>(height) / (2.0f * tan(view.camera->GetFovVerticalRad() * 0.5f));
+        if (Pass_Forward(cmd_list, m_buffer_frame_view_gpu.get(), frame, m_view_frustum, pixels_per_unit, view.color.get(), 0, view.depth.get(), view.entity, Vector4(0.0f, 0.0f, 0.0f, 1.0f), "Pass_View"))
+        {
+            view.frame_rendered = m_frame_num;
+        }
+    }
+
+    bool Renderer::Pass_Forward(RHI_CommandList* cmd_list, RHI_ConstantBuffer* buffer_frame, const BufferFrame& frame, const Frustum& frustum, const float pixels_per_unit, RHI_Texture* tex_color, const uint32_t tex_color_array_index, RHI_Texture* tex_depth, const Entity* entity_excluded, const Vector4& clear_color, const char* pass_name)
+    {
+        // Description: A camera other than the main one (a view, or a face of a reflection probe), it culls through the frame's hierarchy and the opaque
+        // instances it sees are drawn with the forward variations of the g-buffer shaders, lit by the directional light (with the shadow map this frame
+        // rendered) and the environment. The light clusters are binned for the main camera so they are left out, as are the screen space passes and post-processing.
+
+        // Acquire shaders, these cameras only draw instanced
+        RHI_Shader* shader_v            = m_shaders[Shader_Gbuffer_Instanced_V].get();
+        RHI_Shader* shader_v_compact    = m_shaders[Shader_Gbuffer_Compact_Instanced_V].get();
+        RHI_Shader* shader_v_skinned    = m_shaders[Shader_Gbuffer_Skinned_Instanced_V].get();
+        RHI_Shader* shader_v_displaced  = m_shaders[Shader_Gbuffer_Displaced_Instanced_V].get();
+        if (!shader_v->IsCompiled() || !shader_v_compact->IsCompiled() || !shader_v_skinned->IsCompiled() || !shader_v_displaced->IsCompiled())
+            return false;
+
+        // The forward variations, the ones which aren't compiled yet are asked for as the instances need them
+        m_draw_list_lookup.clear();
+        m_draw_key_shaders.clear();
+        for (const auto& it : ShaderGBuffer::GetVariations())
+        {
+            if (!it.second->IsCompiled() || (it.first & (ShaderGBuffer_Forward | ShaderGBuffer_Forward_Oit)) != ShaderGBuffer_Forward)
+                continue;
+
+            if (m_draw_key_shaders.size() == draw_key_variation_count)
+                break;
+
+            m_draw_list_lookup[it.first] = static_cast<uint32_t>(m_draw_key_shaders.size());
+            m_draw_key_shaders.emplace_back(static_cast<RHI_Shader*>(it.second.get()));
+        }
+
+        // Cull through the same hierarchy as the main camera, the levels of detail are picked for the camera's resolution and position
+        const auto& instances           = m_cull_instances[Renderer_Object_Opaque];
+        const Vector3 camera_position   = frame.camera_position;
+        const float lod_error           = lod_pixel_error * GetOptionValue<float>(Option_Value_LodBias) / pixels_per_unit;
+        m_view_visible.clear();
+        m_bvh.Query(frustum, [this](const uint32_t user_data)
+        {
+            if (!(user_data & bvh_transparent_bit))
+            {
+                m_view_visible.emplace_back(user_data);
+            }
+        });
+        sort(m_view_visible.begin(), m_view_visible.end());
+
+        m_draw_list_count   = 0;
+        DrawList& draw_list = DrawListAdd();
+        for (const uint32_t instance_index : m_view_visible)
+        {
+            const CullInstance& instance = instances[instance_index];
+            if (!frustum.IsVisible(instance.center, instance.extents))
+                continue;
+
+            // The camera's own entity would cover the view
+            if (instance.entity == entity_excluded)
+                continue;
+
+            const auto it = m_draw_list_lookup.find(instance.flags | ShaderGBuffer_Forward);
+            if (it == m_draw_list_lookup.end())
+            {
+                ShaderGBuffer::GenerateVariation(m_context, instance.flags | ShaderGBuffer_Forward);
+                continue;
+            }
+
+            const Renderable* renderable    = instance.entity->GetRenderable();
+            const float diagonal            = Helper::Max(instance.extents.Length() * 2.0f, Helper::M_EPSILON);
+            const float distance            = Helper::Max(Vector3::Distance(instance.center, camera_position) - diagonal * 0.5f, 0.0f);
+            const uint32_t lod              = renderable->GeometryLodCount() > 1 ? Helper::Min(renderable->GeometryLodSelect(lod_error * distance / diagonal), draw_key_lod_count - 1) : 0;
+
+            draw_list.entities.emplace_back(instance.entity);
+            draw_list.keys.emplace_back(DrawKey(Renderer_Object_Opaque, it->second, instance.key, lod, (instance.center - camera_position).LengthSquared()));
+        }
+        DrawListBatch(draw_list, true);
+
+        // Upload the transforms, the velocity of the main camera is left alone
+        uint32_t instance_offset = 0;
+        m_instances_cpu.clear();
+        for (DrawBatch& batch : draw_list.batches)
+        {
+            batch.instance_offset = static_cast<uint32_t>(m_instances_cpu.size());
+            for (uint32_t entity_index = batch.entity_start; entity_index < batch.entity_start + batch.entity_count; entity_index++)
+            {
+                Entity* entity          = draw_list.entities[entity_index];
+                const Matrix& transform = entity->GetTransform()->GetMatrixRender();
+
+                for (const Matrix& local : entity->GetRenderable()->GetInstances())
+                {
+                    m_instances_cpu.emplace_back(local * transform, local * transform);
+                }
+
+                if (!entity->GetRenderable()->HasInstances())
+                {
+                    m_instances_cpu.emplace_back(transform, transform);
+                }
+            }
+            batch.instance_count = static_cast<uint32_t>(m_instances_cpu.size()) - batch.instance_offset;
+        }
+
+        if (!UpdateInstanceBuffer(cmd_list, instance_offset))
+            return false;
+
+        // The frame buffer with the camera
+        {
+            BufferFrame* buffer = static_cast<BufferFrame*>(buffer_frame->Map());
+            if (!buffer)
+            {
+                LOG_ERROR("Failed to map buffer");
+                return false;
+            }
+
+            *buffer = frame;
+
+            if (!buffer_frame->Unmap())
+                return false;
+        }
+
+        // The directional light, as the transparent pass takes it
+        const Light* light_directional = nullptr;
+        for (const Light* light : m_lights)
+        {
+            if (light->GetLightType() == LightType_Directional)
+            {
+                light_directional = light;
+                break;
+            }
+        }
+        const bool shadows              = light_directional && light_directional->GetShadowsEnabled();
+        m_buffer_uber_cpu.light_index   = light_directional ? GetLightIndex(light_directional) : 0;
+        m_buffer_uber_cpu.resolution    = Vector2(static_cast<float>(tex_color->GetWidth()), static_cast<float>(tex_color->GetHeight()));
+        m_buffer_uber_cpu.color         = Vector4(light_directional ? 1.0f : 0.0f, shadows ? 1.0f : 0.0f, 1.0f, 0.0f); // z skips the clusters
+
+        // Set render state
+        RHI_PipelineState pso;
+        pso.rasterizer_state                = m_rasterizer_cull_back_solid.get();
+        pso.blend_state                     = m_blend_disabled.get();
+        pso.depth_stencil_state             = m_depth_stencil_on_off_w.get();
+        pso.render_target_color_textures[0]             = tex_color;
+        pso.render_target_color_texture_array_index     = tex_color_array_index;
+        pso.clear_color[0]                              = clear_color;
+        pso.render_target_depth_texture                 = tex_depth;
+        pso.clear_depth                                 = GetClearDepth();
+        pso.viewport                                    = tex_depth->GetViewport();
+        pso.primitive_topology              = RHI_PrimitiveTopology_TriangleList;
+        pso.compile_async                   = true;
+
+        // Record the batches in key order, a render pass per shader variation and vertex layout
+        bool render_pass_active         = false;
+        bool cleared                    = false;
+        uint32_t variation_bound        = 0;
+        uint32_t vertex_layout_bound    = 0;
+        uint32_t material_bound_id      = 0;
+        for (const DrawBatch& batch : draw_list.batches)
+        {
+            Renderable* renderable      = draw_list.entities[batch.entity_start]->GetRenderable();
+            Material* material          = renderable->GetMaterial();
+            const Model* model          = renderable->GeometryModel();
+            const uint32_t variation    = DrawKeyVariation(draw_list.keys[batch.entity_start]);
+            const uint32_t lod          = DrawKeyLod(draw_list.keys[batch.entity_start]);
+            const bool vertex_compact   = model->IsVertexCompact();
+            const bool vertex_skinned   = model->IsVertexSkinned();
+            const bool vertex_displaced = model->IsVertexDisplaced();
+            const uint32_t vertex_layout = vertex_skinned ? 2 : (vertex_displaced ? 3 : (vertex_compact ? 1 : 0));
+
+            // Switch shaders
+            if (!render_pass_active || variation != variation_bound || vertex_layout != vertex_layout_bound)
+            {
+                if (render_pass_active)
+                {
+                    cmd_list->EndRenderPass();
+                }
+
+                pso.shader_vertex           = vertex_skinned ? shader_v_skinned : (vertex_displaced ? shader_v_displaced : (vertex_compact ? shader_v_compact : shader_v));
+                pso.vertex_buffer_stride    = static_cast<uint32_t>(vertex_skinned ? sizeof(RHI_Vertex_PosTexNorTanSkin) : (vertex_compact && !vertex_displaced ? sizeof(RHI_Vertex_PosTexNorTanCompact) : sizeof(RHI_Vertex_PosTexNorTan)));
+                pso.shader_pixel            = m_draw_key_shaders[variation];
+                pso.pass_name               = pass_name;
+
+                render_pass_active      = cmd_list->BeginRenderPass(pso);
+                variation_bound         = variation;
+                vertex_layout_bound     = vertex_layout;
+                material_bound_id       = 0;
+
+                if (!render_pass_active)
+                    continue;
+
+                // Clear only on first pass
+                if (!cleared)
+                {
+                    pso.ResetClearValues();
+                    cleared = true;
+                }
+
+                // Beginning a render pass binds the main frame buffer
+                cmd_list->SetConstantBuffer(0, RHI_Shader_Vertex | RHI_Shader_Pixel, buffer_frame);
+                cmd_list->SetBufferInstance(m_buffer_instance_gpu.get());
+
+                if (shadows)
+                {
+                    cmd_list->SetTexture(13, light_directional->GetDepthTexture());
+                    cmd_list->SetTexture(14, light_directional->GetShadowsTransparentEnabled() ? light_directional->GetColorTexture() : m_tex_white.get());
+                }
+                cmd_list->SetTexture(19, m_render_targets[RenderTarget_Brdf_Specular_Lut]);
+                cmd_list->SetTexture(20, GetEnvironmentTexture());
+                cmd_list->SetTexture(33, m_render_targets[RenderTarget_Brdf_Prefiltered_Environment]);
+            }
+
+            cmd_list->SetBufferIndex(model->GetIndexBuffer());
+            cmd_list->SetBufferVertex(model->GetVertexBuffer());
+
+            m_buffer_draw_cpu.position_offset   = model->GetVertexPositionOffset();
+            m_buffer_draw_cpu.position_scale    = model->GetVertexPositionScale();
+            if (vertex_displaced)
+            {
+                m_buffer_draw_cpu.displacement_uv_scale_offset  = model->GetVertexDisplacementUvScaleOffset();
+                m_buffer_draw_cpu.displacement_height           = model->GetVertexDisplacementHeight();
+                cmd_list->SetTexture(34, model->GetVertexDisplacementMap(), RHI_Shader_Vertex);
+            }
+
+            if (!UpdateDrawBuffer(cmd_list))
+                continue;
+
+            if (vertex_skinned && !UpdateSkinBuffer(cmd_list, renderable))
+                continue;
+
+            // Bind material, through the table slot the g-buffer pass gave it (or a new one)
+            if (material_bound_id != material->GetId())
+            {
+                material_bound_id = material->GetId();
+
+                BindMaterialTextures(cmd_list, material);
+
+                m_buffer_uber_cpu.mat_id            = static_cast<float>(MaterialTableSlot(material));
+                m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
+                m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
+                m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
+                m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
+                m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
+                m_buffer_uber_cpu.mat_normal_mul    = material->GetProperty(Material_Normal);
+                m_buffer_uber_cpu.mat_height_mul    = material->GetProperty(Material_Height);
+                UpdateUberBuffer(cmd_list);
+            }
+
+            cmd_list->DrawIndexed(renderable->GeometryLodIndexCount(lod), renderable->GeometryLodIndexOffset(lod), renderable->GeometryVertexOffset(), batch.instance_count, instance_offset + batch.instance_offset);
+            m_profiler->m_renderer_meshes_rendered += batch.instance_count;
+        }
+
+        // A camera which sees nothing still clears its targets
+        if (!cleared && !m_draw_key_shaders.empty())
+        {
+            pso.shader_vertex           = shader_v;
+            pso.shader_pixel            = m_draw_key_shaders[0];
+            pso.vertex_buffer_stride    = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan));
+            pso.pass_name               = pass_name;
+            render_pass_active          = cmd_list->BeginRenderPass(pso);
+        }
+
+        if (render_pass_active)
+        {
+            cmd_list->EndRenderPass();
+        }
+
+        // Materials which only this camera draws got new slots
+        UpdateMaterialBuffer();
+
+        return true;
+    }
+
+    void Renderer::Pass_ReflectionProbes(RHI_CommandList* cmd_list)
+    {
+        // Description: A face per frame of the probe which UpdateReflectionProbeBuffer() picked, drawn by Pass_Forward() from the probe's position.
+        // Once the six are in, they are projected into the spherical mapping of the environment, which is the probe's first slice, and prefiltered
+        // from there into the rest of its slices, with the shaders of Pass_EnvironmentPrefilter(). Only then the probe's slices are marked as baked.
+
+        if (m_reflection_probe_bake_id == 0 || !m_camera)
+            return;
+
+        const auto it = find_if(m_reflection_probes.begin(), m_reflection_probes.end(), [this](const ReflectionProbe* probe) { return probe->GetId() == m_reflection_probe_bake_id; });
+        if (it == m_reflection_probes.end())
+            return;
+
+        // Acquire shaders
+        RHI_Shader* shader_v            = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_p_project    = m_shaders[Shader_ReflectionProbe_Project_P].get();
+        RHI_Shader* shader_p_specular   = m_shaders[Shader_EnvironmentPrefilter_Specular_P].get();
+        RHI_Shader* shader_p_diffuse    = m_shaders[Shader_EnvironmentPrefilter_Diffuse_P].get();
+        if (!shader_v->IsCompiled() || !shader_p_project->IsCompiled() || !shader_p_specular->IsCompiled() || !shader_p_diffuse->IsCompiled())
+            return;
+
+        // Acquire render targets, the faces keep an alpha so that what they didn't draw can be told apart (and filled with the environment)
+        if (!m_reflection_probe_atlas)
+        {
+            const uint32_t width    = m_reflection_probe_face_size * 2;
+            const uint32_t height   = m_reflection_probe_face_size;
+            m_reflection_probe_atlas    = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R11G11B10_Float, m_max_reflection_probes * m_reflection_probe_slices, 0, "reflection_probe_atlas");
+            m_reflection_probe_radiance = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R11G11B10_Float, 1, 0, "reflection_probe_radiance");
+            m_reflection_probe_faces    = make_shared<RHI_Texture2D>(m_context, m_reflection_probe_face_size, m_reflection_probe_face_size, RHI_Format_R16G16B16A16_Float, 6, 0, "reflection_probe_faces");
+            m_reflection_probe_depth    = make_shared<RHI_Texture2D>(m_context, m_reflection_probe_face_size, m_reflection_probe_face_size, RHI_Format_D32_Float, 1, 0, "reflection_probe_depth");
+        }
+
+        // The next face, the directions and up vectors must match the shader
+        if (m_reflection_probe_bake_face < 6)
+        {
+            static const Vector3 face_forward[6]    = { Vector3::Right, Vector3::Left, Vector3::Up, Vector3::Down, Vector3::Forward, Vector3::Backward };
+            static const Vector3 face_up[6]         = { Vector3::Up, Vector3::Up, Vector3::Backward, Vector3::Forward, Vector3::Up, Vector3::Up };
+
+            const uint32_t face     = m_reflection_probe_bake_face;
+            const Vector3 position  = (*it)->GetTransform()->GetPosition();
+            const bool reverse_z    = GetOption(Render_ReverseZ);
+            const float near_plane  = m_camera->GetNearPlane();
+            const float far_plane   = m_camera->GetFarPlane();
+
+            BufferFrame frame                   = m_buffer_frame_cpu;
+            frame.view                          = Matrix::CreateLookAtLH(position, position + face_forward[face], face_up[face]);
+            frame.projection                    = Matrix::CreatePerspectiveFieldOfViewLH(Helper::PI_DIV_2, 1.0f, reverse_z ? far_plane : near_plane, reverse_z ? near_plane : far_plane);
+            frame.view_projection               = frame.view * frame.projection;
+            frame.view_projection_inv           = Matrix::Invert(frame.view_projection);
+            frame.view_projection_unjittered    = frame.view_projection;
+            frame.camera_near                   = near_plane;
+            frame.camera_far                    = far_plane;
+            frame.camera_position               = position;
+            frame.camera_direction              = face_forward[face];
+
+            const Frustum frustum(frame.view, frame.projection, reverse_z ? near_plane : far_plane);
+            const float pixels_per_unit = static_cast<float>(m_reflection_probe_face_size) * 0.5f; // a 90 degree field of view
+            if (Pass_Forward(cmd_list, m_buffer_frame_probe_gpu.get(), frame, frustum, pixels_per_unit, m_reflection_probe_faces.get(), face, m_reflection_probe_depth.get(), nullptr, Vector4::Zero, "Pass_ReflectionProbes"))
+            {
+                m_reflection_probe_bake_face++;
+            }
+
+            return;
+        }
+
+        const uint32_t slice = m_reflection_probe_slots[m_reflection_probe_bake_id].slot * m_reflection_probe_slices;
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_vertex                    = shader_v;
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = m_depth_stencil_off_off.get();
+        pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+        pipeline_state.clear_color[0]                   = state_color_dont_care;
+        pipeline_state.viewport                         = m_reflection_probe_radiance->GetViewport();
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = "Pass_ReflectionProbes";
+
+        m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(m_reflection_probe_radiance->GetWidth()), static_cast<float>(m_reflection_probe_radiance->GetHeight()));
+
+        // The faces into the spherical mapping, once as the input of the prefiltering and once as the probe's first slice
+        for (RHI_Texture* tex_out : { m_reflection_probe_radiance.get(), m_reflection_probe_atlas.get() })
+        {
+            pipeline_state.shader_pixel                             = shader_p_project;
+            pipeline_state.render_target_color_textures[0]          = tex_out;
+            pipeline_state.render_target_color_texture_array_index  = tex_out == m_reflection_probe_atlas.get() ? slice : 0;
+
+            if (!cmd_list->BeginRenderPass(pipeline_state))
+                return;
+
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(20, GetEnvironmentTexture());
+            cmd_list->SetTexture(38, m_reflection_probe_faces);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+
+        // The specular levels and the irradiance, as the environment's
+        pipeline_state.render_target_color_textures[0] = m_reflection_probe_atlas.get();
+        for (uint32_t i = 0; i <= m_environment_slices_specular; i++)
+        {
+            const bool is_diffuse = i == m_environment_slices_specular;
+
+            pipeline_state.shader_pixel                             = is_diffuse ? shader_p_diffuse : shader_p_specular;
+            pipeline_state.render_target_color_texture_array_index  = slice + 1 + i;
+
+            if (!cmd_list->BeginRenderPass(pipeline_state))
+                return;
+
+            m_buffer_uber_cpu.mat_roughness_mul = Helper::Sqrt(static_cast<float>(i + 1) / static_cast<float>(m_environment_slices_specular));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(20, m_reflection_probe_radiance);
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+        }
+
+        m_reflection_probe_slots[m_reflection_probe_bake_id].signature = m_reflection_probe_bake_signature;
+        m_reflection_probe_bake_id = 0;
+    }
+
     void Renderer::Pass_Copy(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_in, shared_ptr<RHI_Texture>& tex_out)
     {
         // Acquire shaders
@@ -21,10 +21,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ============================
 #include "Renderer.h"
+#include "RenderGraph.h"
 #include "ShaderGBuffer.h"
 #include "ShaderLight.h"
 #include "Font/Font.h"
 #include "../Resource/ResourceCache.h"
+#include "../Resource/ProgressReport.h"
+#include "../Core/EventSystem.h"
+#include "../Threading/Threading.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_Shader.h"
 #include "../RHI/RHI_Sampler.h"
@@ -34,6 +38,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_DepthStencilState.h"
 #include "../RHI/RHI_SwapChain.h"
 #include "../RHI/RHI_CommandList.h"
+#include "../RHI/RHI_Device.h"
 //=======================================
 
 //= NAMESPACES ===============
@@ -50,17 +55,47 @@ namespace Spartan
         m_buffer_frame_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "frame");
         m_buffer_frame_gpu->Create<BufferFrame>();
 
+        // The frame buffer of the view which renders this frame, bound in place of the above while it's drawn
+        m_buffer_frame_view_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "frame_view");
+        m_buffer_frame_view_gpu->Create<BufferFrame>();
+
+        // The same, for the face of a reflection probe which is being baked
+        m_buffer_frame_probe_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "frame_probe");
+        m_buffer_frame_probe_gpu->Create<BufferFrame>();
+
         m_buffer_material_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "material");
         m_buffer_material_gpu->Create<BufferMaterial>();
 
+        // Sub-allocated per draw, every frame in flight gets its own region
+        const uint32_t frame_count = m_swap_chain->GetBufferCount();
+
         m_buffer_uber_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "uber", is_dynamic);
-        m_buffer_uber_gpu->Create<BufferUber>(64);
+        m_buffer_uber_gpu->CreateRing<BufferUber>(256, frame_count);
 
         m_buffer_object_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "object", is_dynamic);
-        m_buffer_object_gpu->Create<BufferObject>();
+        m_buffer_object_gpu->CreateRing<BufferObject>(1024, frame_count);
+
+        m_buffer_skin_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "skin", is_dynamic);
+        m_buffer_skin_gpu->CreateRing<BufferSkin>(64, frame_count);
+
+        m_buffer_lights_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "lights");
+        m_buffer_lights_gpu->Create<BufferLights>();
+
+        m_buffer_light_clusters_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "light_clusters");
+        m_buffer_light_clusters_gpu->Create<BufferLightClusters>();
+
+        m_buffer_decals_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "decals");
+        m_buffer_decals_gpu->Create<BufferDecals>();
+
+        // No decals until Pass_Decals runs, which it only does while there are some
+        if (BufferDecals* buffer = static_cast<BufferDecals*>(m_buffer_decals_gpu->Map()))
+        {
+            buffer->slice_scale_bias_count = Vector4::Zero;
+            m_buffer_decals_gpu->Unmap();
+        }
 
-        m_buffer_light_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "light");
-        m_buffer_light_gpu->Create<BufferLight>();
+        m_buffer_reflection_probes_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "reflection_probes");
+        m_buffer_reflection_probes_gpu->Create<BufferReflectionProbes>();
     }
 
     void Renderer::CreateDepthStencilStates()
@@ -69,6 +104,7 @@ namespace Spartan
         m_depth_stencil_off_off     = make_shared<RHI_DepthStencilState>(m_rhi_device, false,   false,  GetComparisonFunction(), false, false);                         // no depth or stencil
         m_depth_stencil_on_off_w    = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    true,   GetComparisonFunction(), false, false);                         // depth
         m_depth_stencil_on_off_r    = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    false,  GetComparisonFunction(), false, false);                         // depth
+        m_depth_stencil_on_off_e    = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    false,  RHI_Comparison_Equal,    false, false);                         // depth, equal to what a pre-pass wrote
         m_depth_stencil_off_on_r    = make_shared<RHI_DepthStencilState>(m_rhi_device, false,   false,  GetComparisonFunction(), true,  false,  RHI_Comparison_Equal);  // depth + stencil
         m_depth_stencil_on_on_w     = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    true,   GetComparisonFunction(), true,  true,   RHI_Comparison_Always); // depth + stencil
     }
@@ -90,6 +126,9 @@ namespace Spartan
         m_blend_disabled    = make_shared<RHI_BlendState>(m_rhi_device, false);
         m_blend_alpha       = make_shared<RHI_BlendState>(m_rhi_device, true, RHI_Blend_Src_Alpha,  RHI_Blend_Inv_Src_Alpha,    RHI_Blend_Operation_Add, RHI_Blend_One, RHI_Blend_One, RHI_Blend_Operation_Add);
         m_blend_additive    = make_shared<RHI_BlendState>(m_rhi_device, true, RHI_Blend_One,        RHI_Blend_One,              RHI_Blend_Operation_Add, RHI_Blend_One, RHI_Blend_One, RHI_Blend_Operation_Add);
+
+        // Weighted blended transparency, color adds up and alpha (the revealage) multiplies
+        m_blend_transparent_oit = make_shared<RHI_BlendState>(m_rhi_device, true, RHI_Blend_One, RHI_Blend_One, RHI_Blend_Operation_Add, RHI_Blend_Zero, RHI_Blend_Inv_Src_Alpha, RHI_Blend_Operation_Add);
     }
 
     void Renderer::CreateSamplers()
@@ -104,8 +143,17 @@ namespace Spartan
 
     void Renderer::CreateRenderTextures()
     {
-        uint32_t width  = static_cast<uint32_t>(m_resolution.x);
-        uint32_t height = static_cast<uint32_t>(m_resolution.y);
+        // The output resolution, for the targets from tone-mapping on
+        const uint32_t width_output     = static_cast<uint32_t>(m_resolution.x);
+        const uint32_t height_output    = static_cast<uint32_t>(m_resolution.y);
+
+        // The render resolution, for everything before the frame gets upsampled (kept even, like the output resolution)
+        float scale         = GetOptionValue<float>(Option_Value_ResolutionScale);
+        scale               = m_preview_active ? Helper::Min(scale, GetOptionValue<float>(Option_Value_PreviewScale)) : scale;
+        uint32_t width      = static_cast<uint32_t>(m_resolution.x * scale);
+        uint32_t height     = static_cast<uint32_t>(m_resolution.y * scale);
+        width               -= (width   % 2 != 0) ? 1 : 0;
+        height              -= (height  % 2 != 0) ? 1 : 0;
 
         if ((width / 4) == 0 || (height / 4) == 0)
         {
@@ -113,13 +161,16 @@ namespace Spartan
             return;
         }
 
-        Flush();
+        m_resolution_render = Vector2(static_cast<float>(width), static_cast<float>(height));
+
+        // No flush, the previous render targets are released once the frames in flight which use them retire
 
         // G-Buffer
         // Stencil is used to mask transparent objects and also has a read only version
-        // From and below Texture_Format_R8G8B8A8_UNORM, normals have noticeable banding
+        // From and below Texture_Format_R8G8B8A8_UNORM, normals have noticeable banding, unless they are octahedral encoded (compact layout)
+        const RHI_Format format_normal = GetOption(Render_GBuffer_Compact) ? RHI_Format_R10G10B10A2_Unorm : RHI_Format_R16G16B16A16_Float;
         m_render_targets[RenderTarget_Gbuffer_Albedo]   = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R8G8B8A8_Unorm,       1, 0,                                       "rt_gbuffer_albedo");
-        m_render_targets[RenderTarget_Gbuffer_Normal]   = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16B16A16_Float,   1, 0,                                       "rt_gbuffer_normal");
+        m_render_targets[RenderTarget_Gbuffer_Normal]   = make_shared<RHI_Texture2D>(m_context, width, height, format_normal,                   1, 0,                                       "rt_gbuffer_normal");
         m_render_targets[RenderTarget_Gbuffer_Material] = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R8G8B8A8_Unorm,       1, 0,                                       "rt_gbuffer_material");
         m_render_targets[RenderTarget_Gbuffer_Velocity] = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16_Float,         1, 0,                                       "rt_gbuffer_velocity");
         m_render_targets[RenderTarget_Gbuffer_Depth]    = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_D32_Float_S8X24_Uint, 1, RHI_Texture_DepthStencilViewReadOnly,    "gbuffer_depth");
@@ -127,29 +178,69 @@ namespace Spartan
         // Light
         m_render_targets[RenderTarget_Light_Diffuse]    = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R11G11B10_Float, 1, 0, "rt_light_diffuse");
         m_render_targets[RenderTarget_Light_Specular]   = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R11G11B10_Float, 1, 0, "rt_light_specular");
-        m_render_targets[RenderTarget_Light_Volumetric] = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R11G11B10_Float, 1, 0, "rt_light_volumetric");
+
+        // Volumetric lighting, the froxel atlas doesn't depend on the resolution (the integrated froxels and the history persist, the injected ones are transient)
+        const uint32_t froxel_atlas_width   = m_froxel_count_x * m_froxel_atlas_tiles_x;
+        const uint32_t froxel_atlas_height  = m_froxel_count_y * (m_froxel_count_z / m_froxel_atlas_tiles_x);
+        m_render_targets[RenderTarget_Light_Volumetric]         = make_unique<RHI_Texture2D>(m_context, froxel_atlas_width, froxel_atlas_height, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_light_volumetric");
+        m_render_targets[RenderTarget_Volumetric_History]       = make_unique<RHI_Texture2D>(m_context, froxel_atlas_width, froxel_atlas_height, RHI_Format_R11G11B10_Float,    1, 0, "rt_volumetric_history");
+        m_render_targets[RenderTarget_Volumetric_History_2]     = make_unique<RHI_Texture2D>(m_context, froxel_atlas_width, froxel_atlas_height, RHI_Format_R11G11B10_Float,    1, 0, "rt_volumetric_history_2");
 
         // BRDF Specular Lut
         m_render_targets[RenderTarget_Brdf_Specular_Lut] = make_unique<RHI_Texture2D>(m_context, 400, 400, RHI_Format_R8G8_Unorm, 1, 0, "rt_brdf_specular_lut");
         m_brdf_specular_lut_rendered = false;
 
+        // Prefiltered environment, it doesn't need the resolution of the environment since even the least rough slice is a blurred one
+        m_render_targets[RenderTarget_Brdf_Prefiltered_Environment] = make_unique<RHI_Texture2D>(m_context, 512, 256, RHI_Format_R11G11B10_Float, m_environment_slices_specular + 1, 0, "rt_environment_prefiltered");
+        m_environment_prefiltered = false;
+
         // Composition
         {
             m_render_targets[RenderTarget_Composition_Hdr]      = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_composition_hdr"); // Investigate using less bits but have an alpha channel
-            m_render_targets[RenderTarget_Composition_Ldr]      = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_composition_ldr"); // Investigate using less bits but have an alpha channel
+            m_render_targets[RenderTarget_Composition_Ldr]      = make_unique<RHI_Texture2D>(m_context, width_output, height_output, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_composition_ldr"); // Investigate using less bits but have an alpha channel
             // 2nd copies
             m_render_targets[RenderTarget_Composition_Hdr_2]    = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_composition_hdr2"); // Used for ping-ponging between effects during post-processing
-            m_render_targets[RenderTarget_Composition_Ldr_2]    = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_composition_ldr2"); // Used for ping-ponging between effects during post-Processing
+            m_render_targets[RenderTarget_Composition_Ldr_2]    = make_unique<RHI_Texture2D>(m_context, width_output, height_output, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_composition_ldr2"); // Used for ping-ponging between effects during post-Processing
             // 3rd copies
-            m_render_targets[RenderTarget_TaaHistory]           = make_unique<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_taa_history"); // Used for TAA accumulation
+            m_render_targets[RenderTarget_TaaHistory]           = make_unique<RHI_Texture2D>(m_context, width_output, height_output, RHI_Format_R16G16B16A16_Float, 1, 0, "rt_taa_history"); // Used for TAA accumulation (and reconstruction, it's always at the output resolution)
         }
 
-        // HBAO + Indirect bounce
-        m_render_targets[RenderTarget_Hbao_Noisy]   = make_unique<RHI_Texture2D>(m_context, static_cast<uint32_t>(width), static_cast<uint32_t>(height), RHI_Format_R16G16B16A16_Float, 1, 0, "rt_hbao_noisy");
-        m_render_targets[RenderTarget_Hbao]         = make_unique<RHI_Texture2D>(m_context, static_cast<uint32_t>(width), static_cast<uint32_t>(height), RHI_Format_R16G16B16A16_Float, 1, 0, "rt_hbao");
+        // Transient, the render graph creates these when (and only for as long as) a pass needs them
+        m_render_graph->ClearTransients();
+        {
+            // HBAO and SSR can run at a fraction of the resolution, on a downsampled depth and normal buffer
+            const uint32_t scale            = GetOptionValue<uint32_t>(Option_Value_ScreenSpaceScale);
+            const uint32_t width_scaled     = width / scale;
+            const uint32_t height_scaled    = height / scale;
+            m_render_graph->AddTransient(RenderTarget_Gbuffer_Depth_Downsampled,    width_scaled, height_scaled, RHI_Format_R32_Float,          0, "rt_gbuffer_depth_downsampled");
+            m_render_graph->AddTransient(RenderTarget_Gbuffer_Normal_Downsampled,   width_scaled, height_scaled, format_normal,                 0, "rt_gbuffer_normal_downsampled");
+
+            // HBAO + Indirect bounce
+            m_render_graph->AddTransient(RenderTarget_Hbao_Noisy,       width_scaled,   height_scaled,  RHI_Format_R16G16B16A16_Float, 0, "rt_hbao_noisy");
+            m_render_graph->AddTransient(RenderTarget_Hbao_Downsampled, width_scaled,   height_scaled,  RHI_Format_R16G16B16A16_Float, 0, "rt_hbao_downsampled");
+            m_render_graph->AddTransient(RenderTarget_Hbao,             width,          height,         RHI_Format_R16G16B16A16_Float, 0, "rt_hbao");
+
+            // SSR
+            m_render_graph->AddTransient(RenderTarget_Ssr_Downsampled,  width_scaled,   height_scaled,  RHI_Format_R16G16_Float, 0, "rt_ssr_downsampled");
+            m_render_graph->AddTransient(RenderTarget_Ssr,              width,          height,         RHI_Format_R16G16_Float, RHI_Texture_UnorderedAccessView, "rt_ssr");
+
+            // Order independent transparency
+            m_render_graph->AddTransient(RenderTarget_Transparent_Accumulation,  width, height, RHI_Format_R16G16B16A16_Float,  0, "rt_transparent_accumulation");
+            m_render_graph->AddTransient(RenderTarget_Transparent_Weight,        width, height, RHI_Format_R16_Float,           0, "rt_transparent_weight");
+
+            // Screen space shadows, a channel per light
+            m_render_graph->AddTransient(RenderTarget_ScreenSpaceShadows, width, height, RHI_Format_R8G8B8A8_Unorm, 0, "rt_screen_space_shadows");
+
+            // Variable rate shading, a texel per tile
+            if (m_rhi_device->IsVariableRateShadingSupported())
+            {
+                const uint32_t tile = m_rhi_device->GetShadingRateTileSize();
+                m_render_graph->AddTransient(RenderTarget_ShadingRate, (width + tile - 1) / tile, (height + tile - 1) / tile, RHI_Format_R8_Uint, RHI_Texture_ShadingRate, "rt_shading_rate");
+            }
 
-        // SSR
-        m_render_targets[RenderTarget_Ssr] = make_shared<RHI_Texture2D>(m_context, width, height, RHI_Format_R16G16_Float, 1, RHI_Texture_UnorderedAccessView, "rt_ssr");
+            // Volumetric lighting
+            m_render_graph->AddTransient(RenderTarget_Volumetric_Scattering, m_froxel_count_x * m_froxel_atlas_tiles_x, m_froxel_count_y * (m_froxel_count_z / m_froxel_atlas_tiles_x), RHI_Format_R11G11B10_Float, 0, "rt_volumetric_scattering");
+        }
 
         // Bloom
         {
@@ -176,6 +267,9 @@ namespace Spartan
         // Get standard shader directory
         const auto dir_shaders = m_resource_cache->GetDataDirectory(Asset_Shaders) + "/";
 
+        // Bandwidth and ALU bound full screen passes do their color math in 16 bits when the device can
+        const string half_precision = m_rhi_device->IsShaderFloat16Supported() ? "1" : "0";
+
         // Shader which compile different variations when needed
         m_shaders[Shader_Gbuffer_P] = make_shared<ShaderGBuffer>(m_context);
         m_shaders[Shader_Light_P]   = make_shared<ShaderLight>(m_context);
@@ -183,6 +277,53 @@ namespace Spartan
         // G-Buffer
         m_shaders[Shader_Gbuffer_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Gbuffer_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Gbuffer_Instanced_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Compact_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Compact_V]->AddDefine("COMPACT_VERTEX");
+        m_shaders[Shader_Gbuffer_Compact_V]->CompileAsync<RHI_Vertex_PosTexNorTanCompact>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Compact_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Compact_Instanced_V]->AddDefine("COMPACT_VERTEX");
+        m_shaders[Shader_Gbuffer_Compact_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Gbuffer_Compact_Instanced_V]->CompileAsync<RHI_Vertex_PosTexNorTanCompact>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Skinned_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Skinned_V]->AddDefine("SKINNED_VERTEX");
+        m_shaders[Shader_Gbuffer_Skinned_V]->CompileAsync<RHI_Vertex_PosTexNorTanSkin>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Skinned_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Skinned_Instanced_V]->AddDefine("SKINNED_VERTEX");
+        m_shaders[Shader_Gbuffer_Skinned_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Gbuffer_Skinned_Instanced_V]->CompileAsync<RHI_Vertex_PosTexNorTanSkin>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Displaced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Displaced_V]->AddDefine("DISPLACED_VERTEX");
+        m_shaders[Shader_Gbuffer_Displaced_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Displaced_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Displaced_Instanced_V]->AddDefine("DISPLACED_VERTEX");
+        m_shaders[Shader_Gbuffer_Displaced_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Gbuffer_Displaced_Instanced_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+
+        // Impostors
+        m_shaders[Shader_Impostor_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Impostor_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Impostor_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Impostor.hlsl");
+        m_shaders[Shader_Impostor_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Impostor_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Impostor.hlsl");
+        m_shaders[Shader_Impostor_Bake_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Impostor_Bake_V]->AddDefine("BAKE");
+        m_shaders[Shader_Impostor_Bake_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "Impostor.hlsl");
+        m_shaders[Shader_Impostor_Bake_Compact_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Impostor_Bake_Compact_V]->AddDefine("BAKE");
+        m_shaders[Shader_Impostor_Bake_Compact_V]->AddDefine("COMPACT_VERTEX");
+        m_shaders[Shader_Impostor_Bake_Compact_V]->CompileAsync<RHI_Vertex_PosTexNorTanCompact>(RHI_Shader_Vertex, dir_shaders + "Impostor.hlsl");
+        m_shaders[Shader_Impostor_Bake_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Impostor_Bake_P]->AddDefine("BAKE");
+        m_shaders[Shader_Impostor_Bake_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Impostor.hlsl");
+
+        // Particles
+        m_shaders[Shader_Particle_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Particle_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Particle.hlsl");
+        m_shaders[Shader_Particle_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Particle_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Particle.hlsl");
 
         // Quad - Used by almost everything
         m_shaders[Shader_Quad_V] = make_shared<RHI_Shader>(m_context);
@@ -191,23 +332,104 @@ namespace Spartan
         // Depth Vertex
         m_shaders[Shader_Depth_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Depth_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Instanced_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Compact_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Compact_V]->AddDefine("COMPACT_VERTEX");
+        m_shaders[Shader_Depth_Compact_V]->CompileAsync<RHI_Vertex_PosTexNorTanCompact>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Compact_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Compact_Instanced_V]->AddDefine("COMPACT_VERTEX");
+        m_shaders[Shader_Depth_Compact_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Compact_Instanced_V]->CompileAsync<RHI_Vertex_PosTexNorTanCompact>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Skinned_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Skinned_V]->AddDefine("SKINNED_VERTEX");
+        m_shaders[Shader_Depth_Skinned_V]->CompileAsync<RHI_Vertex_PosTexNorTanSkin>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Skinned_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Skinned_Instanced_V]->AddDefine("SKINNED_VERTEX");
+        m_shaders[Shader_Depth_Skinned_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Skinned_Instanced_V]->CompileAsync<RHI_Vertex_PosTexNorTanSkin>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Position_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Position_V]->AddDefine("POSITION_ONLY");
+        m_shaders[Shader_Depth_Position_V]->CompileAsync<RHI_Vertex_Pos>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Position_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Position_Instanced_V]->AddDefine("POSITION_ONLY");
+        m_shaders[Shader_Depth_Position_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Position_Instanced_V]->CompileAsync<RHI_Vertex_Pos>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+
+        // Depth Vertex, layered (all the slices of a light at once)
+        m_shaders[Shader_Depth_Layered_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Layered_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Layered_V]->AddDefine("LAYERED");
+        m_shaders[Shader_Depth_Layered_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Compact_Layered_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Compact_Layered_V]->AddDefine("COMPACT_VERTEX");
+        m_shaders[Shader_Depth_Compact_Layered_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Compact_Layered_V]->AddDefine("LAYERED");
+        m_shaders[Shader_Depth_Compact_Layered_V]->CompileAsync<RHI_Vertex_PosTexNorTanCompact>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Skinned_Layered_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Skinned_Layered_V]->AddDefine("SKINNED_VERTEX");
+        m_shaders[Shader_Depth_Skinned_Layered_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Skinned_Layered_V]->AddDefine("LAYERED");
+        m_shaders[Shader_Depth_Skinned_Layered_V]->CompileAsync<RHI_Vertex_PosTexNorTanSkin>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Position_Layered_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Position_Layered_V]->AddDefine("POSITION_ONLY");
+        m_shaders[Shader_Depth_Position_Layered_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Position_Layered_V]->AddDefine("LAYERED");
+        m_shaders[Shader_Depth_Position_Layered_V]->CompileAsync<RHI_Vertex_Pos>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+
+        // Depth Vertex, displaced (only drawn instanced, the instance carries where the patch is)
+        m_shaders[Shader_Depth_Displaced_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Displaced_Instanced_V]->AddDefine("DISPLACED_VERTEX");
+        m_shaders[Shader_Depth_Displaced_Instanced_V]->AddDefine("POSITION_ONLY");
+        m_shaders[Shader_Depth_Displaced_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Displaced_Instanced_V]->CompileAsync<RHI_Vertex_Pos>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Displaced_Layered_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Displaced_Layered_V]->AddDefine("DISPLACED_VERTEX");
+        m_shaders[Shader_Depth_Displaced_Layered_V]->AddDefine("POSITION_ONLY");
+        m_shaders[Shader_Depth_Displaced_Layered_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Displaced_Layered_V]->AddDefine("LAYERED");
+        m_shaders[Shader_Depth_Displaced_Layered_V]->CompileAsync<RHI_Vertex_Pos>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+
         m_shaders[Shader_Depth_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Depth_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_AlphaTest_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_AlphaTest_P]->AddDefine("ALPHA_TEST");
+        m_shaders[Shader_Depth_AlphaTest_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
 
         // BRDF - Specular Lut
         m_shaders[Shader_BrdfSpecularLut] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_BrdfSpecularLut]->AddDefine("BRDF_ENV_SPECULAR_LUT");
         m_shaders[Shader_BrdfSpecularLut]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "BRDF_SpecularLut.hlsl");
 
+        // Environment prefiltering
+        m_shaders[Shader_EnvironmentPrefilter_Specular_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_EnvironmentPrefilter_Specular_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "EnvironmentPrefilter.hlsl");
+        m_shaders[Shader_EnvironmentPrefilter_Diffuse_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_EnvironmentPrefilter_Diffuse_P]->AddDefine("DIFFUSE");
+        m_shaders[Shader_EnvironmentPrefilter_Diffuse_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "EnvironmentPrefilter.hlsl");
+        m_shaders[Shader_ReflectionProbe_Project_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_ReflectionProbe_Project_P]->AddDefine("PROJECT_FACES");
+        m_shaders[Shader_ReflectionProbe_Project_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "EnvironmentPrefilter.hlsl");
+
         // Texture
         m_shaders[Shader_Texture_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Texture_P]->AddDefine("PASS_TEXTURE");
         m_shaders[Shader_Texture_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
 
+        // Transparent resolve
+        m_shaders[Shader_TransparentResolve_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_TransparentResolve_P]->AddDefine("PASS_TRANSPARENT_RESOLVE");
+        m_shaders[Shader_TransparentResolve_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
+
         // Copy
         m_shaders[Shader_Copy_C] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Copy_C]->CompileAsync(RHI_Shader_Compute, dir_shaders + "Copy.hlsl");
 
+        // Auto exposure
+        m_shaders[Shader_AutoExposure_C] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_AutoExposure_C]->CompileAsync(RHI_Shader_Compute, dir_shaders + "AutoExposure.hlsl");
+
         // FXAA
         m_shaders[Shader_Fxaa_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Fxaa_P]->AddDefine("PASS_FXAA");
@@ -230,6 +452,7 @@ namespace Spartan
 
         // Blur Box
         m_shaders[Shader_BlurBox_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_BlurBox_P]->AddDefine("HALF_PRECISION", half_precision);
         m_shaders[Shader_BlurBox_P]->AddDefine("PASS_BLUR_BOX");
         m_shaders[Shader_BlurBox_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
 
@@ -250,6 +473,7 @@ namespace Spartan
 
         // Tone-mapping
         m_shaders[Shader_ToneMapping_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_ToneMapping_P]->AddDefine("HALF_PRECISION", half_precision);
         m_shaders[Shader_ToneMapping_P]->AddDefine("PASS_TONEMAPPING");
         m_shaders[Shader_ToneMapping_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
 
@@ -263,6 +487,12 @@ namespace Spartan
         m_shaders[Shader_Taa_P]->AddDefine("PASS_TAA_RESOLVE");
         m_shaders[Shader_Taa_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
 
+        // TAA upscale
+        m_shaders[Shader_Taa_Upscale_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Taa_Upscale_P]->AddDefine("PASS_TAA_RESOLVE");
+        m_shaders[Shader_Taa_Upscale_P]->AddDefine("TAA_UPSCALE");
+        m_shaders[Shader_Taa_Upscale_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
+
         // Motion Blur
         m_shaders[Shader_MotionBlur_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_MotionBlur_P]->AddDefine("PASS_MOTION_BLUR");
@@ -273,11 +503,22 @@ namespace Spartan
         m_shaders[Shader_Dithering_P]->AddDefine("PASS_DITHERING");
         m_shaders[Shader_Dithering_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
 
+        // Post-process fused
+        m_shaders[Shader_PostProcess_Fused_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_PostProcess_Fused_P]->AddDefine("HALF_PRECISION", half_precision);
+        m_shaders[Shader_PostProcess_Fused_P]->AddDefine("PASS_POSTPROCESS_FUSED");
+        m_shaders[Shader_PostProcess_Fused_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
+
         // Upsample box
         m_shaders[Shader_Upsample_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Upsample_P]->AddDefine("PASS_UPSAMPLE_BOX");
         m_shaders[Shader_Upsample_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
 
+        // Upsample bilateral
+        m_shaders[Shader_Upsample_Bilateral_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Upsample_Bilateral_P]->AddDefine("PASS_UPSAMPLE_BILATERAL");
+        m_shaders[Shader_Upsample_Bilateral_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Quad.hlsl");
+
         // Downsample box
         m_shaders[Shader_Downsample_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Downsample_P]->AddDefine("PASS_DOWNSAMPLE_BOX");
@@ -331,13 +572,28 @@ namespace Spartan
         m_shaders[Shader_Ssr_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Ssr_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "SSR.hlsl");
 
+        // Depth and normal downsample
+        m_shaders[Shader_DepthNormal_Downsample_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_DepthNormal_Downsample_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "DepthNormal_Downsample.hlsl");
+
         // Entity
         m_shaders[Shader_Entity_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Entity_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
-
-        // Entity - Transform
+        m_shaders[Shader_Entity_Compact_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Entity_Compact_V]->AddDefine("COMPACT_VERTEX");
+        m_shaders[Shader_Entity_Compact_V]->CompileAsync<RHI_Vertex_PosTexNorTanCompact>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
+        m_shaders[Shader_Entity_Skinned_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Entity_Skinned_V]->AddDefine("SKINNED_VERTEX");
+        m_shaders[Shader_Entity_Skinned_V]->CompileAsync<RHI_Vertex_PosTexNorTanSkin>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
+
+        // Entity - Transform, the axes of the handle are instances
+        m_shaders[Shader_Entity_Transform_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Entity_Transform_V]->AddDefine("TRANSFORM");
+        m_shaders[Shader_Entity_Transform_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Entity_Transform_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
         m_shaders[Shader_Entity_Transform_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Entity_Transform_P]->AddDefine("TRANSFORM");
+        m_shaders[Shader_Entity_Transform_P]->AddDefine("INSTANCED");
         m_shaders[Shader_Entity_Transform_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Entity.hlsl");
 
         // Entity - Outline
@@ -345,12 +601,44 @@ namespace Spartan
         m_shaders[Shader_Entity_Outline_P]->AddDefine("OUTLINE");
         m_shaders[Shader_Entity_Outline_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Entity.hlsl");
 
+        // Volumetric lighting - Injection, a variation per light type
+        m_shaders[Shader_VolumetricInject_Directional_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_VolumetricInject_Directional_P]->AddDefine("PASS_INJECT");
+        m_shaders[Shader_VolumetricInject_Directional_P]->AddDefine("DIRECTIONAL");
+        m_shaders[Shader_VolumetricInject_Directional_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "VolumetricLighting.hlsl");
+        m_shaders[Shader_VolumetricInject_Point_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_VolumetricInject_Point_P]->AddDefine("PASS_INJECT");
+        m_shaders[Shader_VolumetricInject_Point_P]->AddDefine("POINT");
+        m_shaders[Shader_VolumetricInject_Point_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "VolumetricLighting.hlsl");
+        m_shaders[Shader_VolumetricInject_Spot_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_VolumetricInject_Spot_P]->AddDefine("PASS_INJECT");
+        m_shaders[Shader_VolumetricInject_Spot_P]->AddDefine("SPOT");
+        m_shaders[Shader_VolumetricInject_Spot_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "VolumetricLighting.hlsl");
+
+        // Volumetric lighting - Temporal reprojection and front to back integration
+        m_shaders[Shader_VolumetricTemporal_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_VolumetricTemporal_P]->AddDefine("PASS_TEMPORAL");
+        m_shaders[Shader_VolumetricTemporal_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "VolumetricLighting.hlsl");
+        m_shaders[Shader_VolumetricIntegrate_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_VolumetricIntegrate_P]->AddDefine("PASS_INTEGRATE");
+        m_shaders[Shader_VolumetricIntegrate_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "VolumetricLighting.hlsl");
+
+        // Screen space shadows
+        m_shaders[Shader_ScreenSpaceShadows_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_ScreenSpaceShadows_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "ScreenSpaceShadows.hlsl");
+
+        // Variable rate shading
+        m_shaders[Shader_ShadingRate_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_ShadingRate_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "ShadingRate.hlsl");
+
         // Composition
         m_shaders[Shader_Composition_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Composition_P]->AddDefine("HALF_PRECISION", half_precision);
         m_shaders[Shader_Composition_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Composition.hlsl");
 
         // Composition
         m_shaders[Shader_Composition_IndirectBounce_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Composition_IndirectBounce_P]->AddDefine("HALF_PRECISION", half_precision);
         m_shaders[Shader_Composition_IndirectBounce_P]->AddDefine("INDIRECT_BOUNCE");
         m_shaders[Shader_Composition_IndirectBounce_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Composition.hlsl");
 
@@ -359,12 +647,75 @@ namespace Spartan
         m_shaders[Shader_Font_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Font.hlsl");
         m_shaders[Shader_Font_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Font_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Font.hlsl");
+        m_shaders[Shader_Font_Sdf_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Font_Sdf_P]->AddDefine("SDF");
+        m_shaders[Shader_Font_Sdf_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Font.hlsl");
 
         // Color
         m_shaders[Shader_Color_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Color_V]->CompileAsync<RHI_Vertex_PosCol>(RHI_Shader_Vertex, dir_shaders + "Color.hlsl");
         m_shaders[Shader_Color_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Color_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Color.hlsl");
+        m_shaders[Shader_Color_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Color_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Color_Instanced_V]->CompileAsync<RHI_Vertex_PosCol>(RHI_Shader_Vertex, dir_shaders + "Color.hlsl");
+
+        // Grid
+        m_shaders[Shader_Grid_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Grid_V]->CompileAsync<RHI_Vertex_Pos>(RHI_Shader_Vertex, dir_shaders + "Grid.hlsl");
+        m_shaders[Shader_Grid_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Grid_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Grid.hlsl");
+
+        // Variations which every world needs (untextured materials and shadowless lights), the rest compile as materials and lights call for them
+        vector<const RHI_Shader*> shaders_startup;
+        shaders_startup.emplace_back(ShaderGBuffer::GenerateVariation(m_context, 0));
+        shaders_startup.emplace_back(ShaderLight::GetVariationClustered(m_context));
+        for (const auto& it : m_shaders)
+        {
+            shaders_startup.emplace_back(it.second.get());
+        }
+
+        // The start-up batch, all of the above are compiling in parallel on the shader pool
+        m_shaders_compiling.clear();
+        for (const RHI_Shader* shader : shaders_startup)
+        {
+            if (shader && shader->GetCompilationTask())
+            {
+                m_shaders_compiling.emplace_back(shader->GetCompilationTask());
+            }
+        }
+
+        ProgressReport& progress_report = ProgressReport::Get();
+        progress_report.Reset(g_progress_shaders);
+        progress_report.SetIsLoading(g_progress_shaders, true);
+        progress_report.SetStatus(g_progress_shaders, "Compiling shaders...");
+        progress_report.SetJobCount(g_progress_shaders, static_cast<int>(m_shaders_compiling.size()));
+    }
+
+    void Renderer::ShadersCompilingTick()
+    {
+        if (m_shaders_compiling.empty())
+            return;
+
+        int jobs_done = 0;
+        for (const auto& task : m_shaders_compiling)
+        {
+            jobs_done += task->IsDone() ? 1 : 0;
+        }
+        ProgressReport::Get().SetJobsDone(g_progress_shaders, jobs_done);
+
+        if (jobs_done != static_cast<int>(m_shaders_compiling.size()))
+            return;
+
+        m_shaders_compiling.clear();
+        ProgressReport::Get().SetIsLoading(g_progress_shaders, false);
+        FIRE_EVENT(Event_Shaders_Compiled);
+    }
+
+    void Renderer::WaitForShaders()
+    {
+        m_threading->Wait(m_shaders_compiling);
+        ShadersCompilingTick();
     }
 
     void Renderer::CreateFonts()
@@ -398,14 +749,68 @@ namespace Spartan
         m_tex_black_opaque = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
         m_tex_black_opaque->LoadFromFile(dir_texture + "black_opaque.png");
 
-        // Gizmo icons
-        m_gizmo_tex_light_directional = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
-        m_gizmo_tex_light_directional->LoadFromFile(dir_texture + "sun.png");
+        // A white disc whose alpha falls off smoothly towards the edge
+        {
+            const uint32_t size = 64;
+            vector<std::byte> data(size * size * 4);
+            for (uint32_t y = 0; y < size; y++)
+            {
+                for (uint32_t x = 0; x < size; x++)
+                {
+                    const float u           = (static_cast<float>(x) + 0.5f) / static_cast<float>(size) * 2.0f - 1.0f;
+                    const float v           = (static_cast<float>(y) + 0.5f) / static_cast<float>(size) * 2.0f - 1.0f;
+                    const float falloff     = Helper::Saturate(1.0f - (u * u + v * v));
+                    const uint32_t index    = (y * size + x) * 4;
+                    data[index + 0]         = std::byte(255);
+                    data[index + 1]         = std::byte(255);
+                    data[index + 2]         = std::byte(255);
+                    data[index + 3]         = static_cast<std::byte>(static_cast<uint8_t>(falloff * falloff * 255.0f));
+                }
+            }
+            m_tex_particle = make_shared<RHI_Texture2D>(m_context, size, size, RHI_Format_R8G8B8A8_Unorm, data);
+        }
+    }
+
+    void Renderer::CreateTexturesGizmo()
+    {
+        // Get standard texture directory
+        const auto dir_texture = m_resource_cache->GetDataDirectory(Asset_Textures) + "/";
+
+        auto generate_mipmaps = false;
+
+        // Icons, in the order of LightType
+        const array<string, 3> icon_files = { "sun.png", "light_bulb.png", "flashlight.png" };
+        array<shared_ptr<RHI_Texture>, 3> icons;
+        uint32_t atlas_width    = 0;
+        uint32_t atlas_height   = 0;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(icons.size()); i++)
+        {
+            icons[i] = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
+            if (!icons[i]->LoadFromFile(dir_texture + icon_files[i]) || icons[i]->GetFormat() != RHI_Format_R8G8B8A8_Unorm || icons[i]->GetData().empty())
+            {
+                LOG_ERROR("Failed to load \"%s\" as an 8-bit RGBA icon", icon_files[i].c_str());
+                return;
+            }
+
+            m_gizmo_icons_rect[i]   = Vector4(static_cast<float>(atlas_width), 0.0f, static_cast<float>(icons[i]->GetWidth()), static_cast<float>(icons[i]->GetHeight()));
+            atlas_width             += icons[i]->GetWidth();
+            atlas_height            = Helper::Max(atlas_height, icons[i]->GetHeight());
+        }
 
-        m_gizmo_tex_light_point = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
-        m_gizmo_tex_light_point->LoadFromFile(dir_texture + "light_bulb.png");
+        // Pack them side by side, so that every icon draws with a single texture
+        const uint32_t bytes_per_pixel = 4;
+        vector<std::byte> atlas(static_cast<size_t>(atlas_width) * atlas_height * bytes_per_pixel, std::byte(0));
+        for (uint32_t i = 0; i < static_cast<uint32_t>(icons.size()); i++)
+        {
+            const vector<std::byte>& pixels = icons[i]->GetData().front();
+            const uint32_t width            = icons[i]->GetWidth();
+            const uint32_t x                = static_cast<uint32_t>(m_gizmo_icons_rect[i].x);
+            for (uint32_t y = 0; y < icons[i]->GetHeight(); y++)
+            {
+                memcpy(&atlas[(static_cast<size_t>(y) * atlas_width + x) * bytes_per_pixel], &pixels[static_cast<size_t>(y) * width * bytes_per_pixel], static_cast<size_t>(width) * bytes_per_pixel);
+            }
+        }
 
-        m_gizmo_tex_light_spot = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
-        m_gizmo_tex_light_spot->LoadFromFile(dir_texture + "flashlight.png");
+        m_gizmo_tex_icons = make_shared<RHI_Texture2D>(m_context, atlas_width, atlas_height, RHI_Format_R8G8B8A8_Unorm, atlas);
     }
 }
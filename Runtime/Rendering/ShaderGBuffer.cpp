@@ -51,12 +51,25 @@ namespace Spartan
     ShaderGBuffer* ShaderGBuffer::Compile(Context* context, const uint16_t flags)
 	{
         // Shader source file path
-        string file_path = context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Shaders) + "/GBuffer.hlsl";
+        string file_path = context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Shaders) + "/" + GetFileName();
 
         // Make new
         shared_ptr<ShaderGBuffer> shader = make_shared<ShaderGBuffer>(context, flags);
 
         // Add defines based on flag properties
+        AddDefines(shader.get(), flags);
+
+        // Compile
+        shader->CompileAsync(RHI_Shader_Pixel, file_path);
+
+        // Save
+        m_variations[flags] = shader;
+
+        return shader.get();
+	}
+
+    void ShaderGBuffer::AddDefines(RHI_Shader* shader, const uint16_t flags)
+    {
         shader->AddDefine("ALBEDO_MAP",		(flags & Material_Color)      ? "1" : "0");
         shader->AddDefine("ROUGHNESS_MAP",  (flags & Material_Roughness)  ? "1" : "0");
         shader->AddDefine("METALLIC_MAP",   (flags & Material_Metallic)   ? "1" : "0");
@@ -66,12 +79,32 @@ namespace Spartan
         shader->AddDefine("EMISSION_MAP",   (flags & Material_Emission)   ? "1" : "0");
         shader->AddDefine("MASK_MAP",       (flags & Material_Mask)       ? "1" : "0");
 
-        // Compile
-        shader->CompileAsync(RHI_Shader_Pixel, file_path);
+        // Forward shading evaluates the directional light with the shadow mapping code of the light pass
+        const bool forward = (flags & (ShaderGBuffer_Forward | ShaderGBuffer_Forward_Oit)) != 0;
+        shader->AddDefine("FORWARD",            forward                             ? "1" : "0");
+        shader->AddDefine("TRANSPARENT_OIT",    (flags & ShaderGBuffer_Forward_Oit) ? "1" : "0");
+        shader->AddDefine("DIRECTIONAL",        forward                             ? "1" : "0");
+    }
 
-        // Save
-        m_variations[flags] = shader;
+    vector<uint16_t> ShaderGBuffer::GetPermutations()
+    {
+        // Only the texture maps affect the defines, so every combination of them, for the g-buffer and for both forward outputs
+        static const uint16_t maps[] = { Material_Color, Material_Roughness, Material_Metallic, Material_Normal, Material_Height, Material_Occlusion, Material_Emission, Material_Mask };
+        static const uint32_t map_count = sizeof(maps) / sizeof(maps[0]);
 
-        return shader.get();
-	}
+        vector<uint16_t> permutations;
+        for (uint32_t combination = 0; combination < (1u << map_count); combination++)
+        {
+            uint16_t flags = 0;
+            for (uint32_t i = 0; i < map_count; i++)
+            {
+                flags |= (combination & (1u << i)) ? maps[i] : 0;
+            }
+            permutations.emplace_back(flags);
+            permutations.emplace_back(flags | ShaderGBuffer_Forward);
+            permutations.emplace_back(flags | ShaderGBuffer_Forward_Oit);
+        }
+
+        return permutations;
+    }
 }
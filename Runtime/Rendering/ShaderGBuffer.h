@@ -24,12 +24,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Shader.h"
 //================================
 
 namespace Spartan
 {
+    // Variation bits which aren't material properties, they sit above the material's
+    enum ShaderGBuffer_Variation : uint16_t
+    {
+        ShaderGBuffer_Forward       = 1 << 14, // shades transparent objects and outputs their color instead of filling the g-buffer
+        ShaderGBuffer_Forward_Oit   = 1 << 15  // forward, with the outputs of weighted blended order independent transparency
+    };
+
 	class SPARTAN_CLASS ShaderGBuffer : public RHI_Shader, public std::enable_shared_from_this<ShaderGBuffer>
 	{
 	public:
@@ -41,6 +49,11 @@ namespace Spartan
         static const ShaderGBuffer* GenerateVariation(Context* context, const uint16_t flags);
         static const auto& GetVariations() { return m_variations; }
 
+        // Everything a variation is made of, so that variations can also be compiled offline
+        static const char* GetFileName() { return "GBuffer.hlsl"; }
+        static void AddDefines(RHI_Shader* shader, const uint16_t flags);
+        static std::vector<uint16_t> GetPermutations();
+
 	private:
         static ShaderGBuffer* Compile(Context* context, const uint16_t flags);
 
@@ -49,7 +49,6 @@ namespace Spartan
         flags |= light->GetShadowsEnabled()                                                                 ? Shader_Light_Shadows                  : flags;
         flags |= (light->GetShadowsScreenSpaceEnabled() && (renderer_flags & Render_ScreenSpaceShadows))    ? Shader_Light_ShadowsScreenSpace       : flags;
         flags |= light->GetShadowsTransparentEnabled()                                                      ? Shader_Light_ShadowsTransparent       : flags;
-        flags |= (light->GetVolumetricEnabled() && (renderer_flags & Render_VolumetricLighting))            ? Shader_Light_Volumetric               : flags;
         flags |= (renderer_flags & Render_ScreenSpaceReflections)                                           ? Shader_Light_ScreenSpaceReflections   : flags;
 
         // Return existing shader, if it's already compiled
@@ -60,23 +59,36 @@ namespace Spartan
         return Compile(context, flags);
     }
 
+    ShaderLight* ShaderLight::GetVariationClustered(Context* context)
+    {
+        const uint16_t flags = Shader_Light_Clustered;
+
+        // Return existing shader, if it's already compiled
+        if (m_variations.find(flags) != m_variations.end())
+            return m_variations.at(flags).get();
+
+        // Compile new shader
+        return Compile(context, flags);
+    }
+
+    bool ShaderLight::IsClusterable(const Light* light, const uint64_t renderer_flags)
+    {
+        if (light->GetLightType() == LightType_Directional || light->GetShadowsEnabled())
+            return false;
+
+        return !(light->GetShadowsScreenSpaceEnabled() && (renderer_flags & Render_ScreenSpaceShadows));
+    }
+
     ShaderLight* ShaderLight::Compile(Context* context, const uint16_t flags)
     {
         // Shader source file path
-        string file_path = context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Shaders) + "/Light.hlsl";
+        string file_path = context->GetSubsystem<ResourceCache>()->GetDataDirectory(Asset_Shaders) + "/" + GetFileName();
 
         // Make new
         shared_ptr<ShaderLight> shader = make_shared<ShaderLight>(context, flags);
 
         // Add defines based on flag properties
-        shader->AddDefine("DIRECTIONAL",                (flags & Shader_Light_Directional)              ? "1" : "0");
-        shader->AddDefine("POINT",                      (flags & Shader_Light_Point)                    ? "1" : "0");
-        shader->AddDefine("SPOT",                       (flags & Shader_Light_Spot)                     ? "1" : "0");
-        shader->AddDefine("SHADOWS",                    (flags & Shader_Light_Shadows)                  ? "1" : "0");
-        shader->AddDefine("SHADOWS_SCREEN_SPACE",       (flags & Shader_Light_ShadowsScreenSpace)       ? "1" : "0");
-        shader->AddDefine("SHADOWS_TRANSPARENT",        (flags & Shader_Light_ShadowsTransparent)       ? "1" : "0");
-        shader->AddDefine("VOLUMETRIC",                 (flags & Shader_Light_Volumetric)               ? "1" : "0");
-        shader->AddDefine("SCREEN_SPACE_REFLECTIONS",   (flags & Shader_Light_ScreenSpaceReflections)   ? "1" : "0");
+        AddDefines(shader.get(), flags);
 
         // Compile
         shader->CompileAsync(RHI_Shader_Pixel, file_path);
@@ -86,4 +98,40 @@ namespace Spartan
 
         return shader.get();
     }
+
+    void ShaderLight::AddDefines(RHI_Shader* shader, const uint16_t flags)
+    {
+        shader->AddDefine("DIRECTIONAL",                (flags & Shader_Light_Directional)              ? "1" : "0");
+        shader->AddDefine("POINT",                      (flags & Shader_Light_Point)                    ? "1" : "0");
+        shader->AddDefine("SPOT",                       (flags & Shader_Light_Spot)                     ? "1" : "0");
+        shader->AddDefine("SHADOWS",                    (flags & Shader_Light_Shadows)                  ? "1" : "0");
+        shader->AddDefine("SHADOWS_SCREEN_SPACE",       (flags & Shader_Light_ShadowsScreenSpace)       ? "1" : "0");
+        shader->AddDefine("SHADOWS_TRANSPARENT",        (flags & Shader_Light_ShadowsTransparent)       ? "1" : "0");
+        shader->AddDefine("SCREEN_SPACE_REFLECTIONS",   (flags & Shader_Light_ScreenSpaceReflections)   ? "1" : "0");
+        shader->AddDefine("CLUSTERED",                  (flags & Shader_Light_Clustered)                ? "1" : "0");
+    }
+
+    vector<uint16_t> ShaderLight::GetPermutations()
+    {
+        // The clustered variation, plus every light type with every combination of the optional features
+        static const uint16_t types[]    = { Shader_Light_Directional, Shader_Light_Point, Shader_Light_Spot };
+        static const uint16_t features[] = { Shader_Light_Shadows, Shader_Light_ShadowsScreenSpace, Shader_Light_ShadowsTransparent, Shader_Light_ScreenSpaceReflections };
+        static const uint32_t feature_count = sizeof(features) / sizeof(features[0]);
+
+        vector<uint16_t> permutations = { Shader_Light_Clustered };
+        for (const uint16_t type : types)
+        {
+            for (uint32_t combination = 0; combination < (1u << feature_count); combination++)
+            {
+                uint16_t flags = type;
+                for (uint32_t i = 0; i < feature_count; i++)
+                {
+                    flags |= (combination & (1u << i)) ? features[i] : 0;
+                }
+                permutations.emplace_back(flags);
+            }
+        }
+
+        return permutations;
+    }
 }
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Shader.h"
 //================================
@@ -41,8 +42,8 @@ namespace Spartan
         Shader_Light_Shadows                = 1 << 3,
         Shader_Light_ShadowsScreenSpace     = 1 << 4,
         Shader_Light_ShadowsTransparent     = 1 << 5,
-        Shader_Light_Volumetric             = 1 << 6,
-        Shader_Light_ScreenSpaceReflections = 1 << 7
+        Shader_Light_ScreenSpaceReflections = 1 << 7,
+        Shader_Light_Clustered              = 1 << 8
     };
 
     class SPARTAN_CLASS ShaderLight : public RHI_Shader
@@ -52,8 +53,17 @@ namespace Spartan
         ~ShaderLight() = default;
 
         static ShaderLight* GetVariation(Context* context, const Light* light, const uint64_t renderer_flags);
+        // The variation which shades all the clustered lights at once
+        static ShaderLight* GetVariationClustered(Context* context);
+        // Point and spot lights which need neither shadow maps nor screen space shadows can be clustered
+        static bool IsClusterable(const Light* light, const uint64_t renderer_flags);
         static auto& GetVariations() { return m_variations; }
 
+        // Everything a variation is made of, so that variations can also be compiled offline
+        static const char* GetFileName() { return "Light.hlsl"; }
+        static void AddDefines(RHI_Shader* shader, const uint16_t flags);
+        static std::vector<uint16_t> GetPermutations();
+
     private:
         static ShaderLight* Compile(Context* context, const uint16_t flags);
 
@@ -28,6 +28,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Texture.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
+#include "../World/Prefab.h"
 //=======================================
 
 //= NAMESPACES ==========
@@ -60,3 +61,4 @@ INSTANTIATE_TO_RESOURCE_TYPE(Material,			Resource_Material)
 INSTANTIATE_TO_RESOURCE_TYPE(Model,				Resource_Model)
 INSTANTIATE_TO_RESOURCE_TYPE(Animation,			Resource_Animation)
 INSTANTIATE_TO_RESOURCE_TYPE(Font,				Resource_Font)
+INSTANTIATE_TO_RESOURCE_TYPE(Prefab,			Resource_Prefab)
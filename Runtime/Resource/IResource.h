@@ -23,9 +23,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===================
 #include <memory>
+#include <atomic>
 #include "../Core/Context.h"
 #include "../Core/FileSystem.h"
 #include "../Core/Spartan_Object.h"
+#include "../Core/StringId.h"
 #include "../Logging/Log.h"
 //==============================
 
@@ -44,7 +46,8 @@ namespace Spartan
 		Resource_Cubemap,	
 		Resource_Animation,
 		Resource_Font,
-		Resource_Shader
+		Resource_Shader,
+		Resource_Prefab
 	};
 
 	enum LoadState
@@ -63,7 +66,7 @@ namespace Spartan
 
 		void SetResourceFilePath(const std::string& path)
         {
-            const bool is_native_file = FileSystem::IsEngineMaterialFile(path) || FileSystem::IsEngineModelFile(path);
+            const bool is_native_file = FileSystem::IsEngineMaterialFile(path) || FileSystem::IsEngineModelFile(path) || FileSystem::IsEnginePrefabFile(path) || FileSystem::IsEngineAnimationFile(path);
 
             // If this is an native engine file, don't do a file check as no actual foreign material exists (it was created on the fly)
             if (!is_native_file)
@@ -91,6 +94,8 @@ namespace Spartan
             }
             m_resource_name                 = FileSystem::GetFileNameNoExtensionFromFilePath(file_path_relative);
             m_resource_directory            = FileSystem::GetDirectoryFromFilePath(file_path_relative);
+            m_resource_name_id              = m_resource_name;
+            m_resource_file_path_native_id  = m_resource_file_path_native;
         }
         
         Resource_Type GetResourceType()                 const { return m_resource_type; }
@@ -99,12 +104,18 @@ namespace Spartan
         const std::string& GetResourceFilePath()        const { return m_resource_file_path_foreign; }
         const std::string& GetResourceFilePathNative()  const { return m_resource_file_path_native; }     
         const std::string& GetResourceName()            const { return m_resource_name; }
+        StringId GetResourceNameId()                    const { return m_resource_name_id; }              // what the cache looks it up by
+        StringId GetResourceFilePathNativeId()          const { return m_resource_file_path_native_id; }
 		const std::string& GetResourceFileName()        const { return m_resource_name; }
 		const std::string& GetResourceDirectory()       const { return m_resource_directory; }
 
 
         // Misc
-		LoadState GetLoadState() const { return m_load_state; }
+		LoadState GetLoadState() const					{ return m_load_state; }
+		void SetLoadState(const LoadState load_state)	{ m_load_state = load_state; }
+		// When the resource was last used, in the resource cache's time (see ResourceCache::Tick())
+		float GetTimeUsed() const						{ return m_time_used; }
+		void SetTimeUsed(const float time)				{ m_time_used = time; }
 
 		// IO
 		virtual bool SaveToFile(const std::string& file_path)	{ return true; }
@@ -116,12 +127,15 @@ namespace Spartan
 
 	protected:
 		Resource_Type m_resource_type	= Resource_Unknown;
-		LoadState m_load_state			= LoadState_Idle;
+		std::atomic<LoadState> m_load_state	= LoadState_Idle; // read by other threads while a resource loads in the background
+		std::atomic<float> m_time_used		= 0.0f;
 
 	private:
 		std::string m_resource_name;
         std::string m_resource_directory;
 		std::string m_resource_file_path_native;
         std::string m_resource_file_path_foreign;
+        StringId m_resource_name_id;
+        StringId m_resource_file_path_native_id;
 	};
 }
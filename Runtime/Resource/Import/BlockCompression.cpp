@@ -0,0 +1,452 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "BlockCompression.h"
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include "../../Logging/Log.h"
+#include "../../Threading/Threading.h"
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace _BlockCompression
+{
+    // Blocks are little endian bit streams, fields are written from the lowest bit up
+    struct BitWriter
+    {
+        uint64_t bits[2]    = { 0, 0 };
+        uint32_t position   = 0;
+
+        void Write(const uint64_t value, const uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; i++, position++)
+            {
+                if ((value >> i) & 1)
+                {
+                    bits[position >> 6] |= 1ull << (position & 63);
+                }
+            }
+        }
+    };
+
+    // Pixels past the edge of the mip repeat the last row/column
+    template <typename T>
+    void block_load(const T* pixels, const uint32_t width, const uint32_t height, const uint32_t block_x, const uint32_t block_y, float block[16][4])
+    {
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                const uint32_t pixel_x  = min(block_x * 4 + x, width - 1);
+                const uint32_t pixel_y  = min(block_y * 4 + y, height - 1);
+                const T* pixel          = pixels + (static_cast<size_t>(pixel_y) * width + pixel_x) * 4;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    block[y * 4 + x][c] = static_cast<float>(pixel[c]);
+                }
+            }
+        }
+    }
+
+    // The endpoints are the extremes of the block along its principal axis (found by power iteration on the covariance)
+    void endpoints_fit(const float block[16][4], const uint32_t channels, const float value_max, float endpoints[2][4])
+    {
+        float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                mean[c] += block[i][c] / 16.0f;
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t a = 0; a < channels; a++)
+            {
+                for (uint32_t b = 0; b < channels; b++)
+                {
+                    covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+                }
+            }
+        }
+
+        float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (uint32_t iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4]   = { 0.0f, 0.0f, 0.0f, 0.0f };
+            float length    = 0.0f;
+            for (uint32_t a = 0; a < channels; a++)
+            {
+                for (uint32_t b = 0; b < channels; b++)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length += next[a] * next[a];
+            }
+
+            // A flat block has no axis, any will do
+            if (length <= 0.0f)
+                break;
+
+            length = sqrt(length);
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        float t_min = 0.0f;
+        float t_max = 0.0f;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                t += (block[i][c] - mean[c]) * axis[c];
+            }
+            t_min = min(t_min, t);
+            t_max = max(t_max, t);
+        }
+
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            endpoints[0][c] = clamp(mean[c] + axis[c] * t_min, 0.0f, value_max);
+            endpoints[1][c] = clamp(mean[c] + axis[c] * t_max, 0.0f, value_max);
+        }
+    }
+
+    void encode_bc4(const float block[16][4], const uint32_t channel, std::byte* out)
+    {
+        uint32_t value_min = 255;
+        uint32_t value_max = 0;
+        uint32_t values[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            values[i]   = static_cast<uint32_t>(block[i][channel]);
+            value_min   = min(value_min, values[i]);
+            value_max   = max(value_max, values[i]);
+        }
+
+        // The first endpoint is the larger one, which picks the eight value palette: max, min and six steps in between
+        BitWriter writer;
+        writer.Write(value_max, 8);
+        writer.Write(value_min, 8);
+        const uint32_t range = value_max - value_min;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            const uint32_t step = range == 0 ? 0 : ((value_max - values[i]) * 7 + range / 2) / range; // 0 at max, 7 at min
+            writer.Write(step == 0 ? 0 : (step == 7 ? 1 : step + 1), 3);
+        }
+
+        memcpy(out, writer.bits, 8);
+    }
+
+    static const uint32_t weights_4bit[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // Mode 6: one subset, RGBA endpoints of 7 bits plus a p-bit each, 4 bit indices
+    void encode_bc7(const float block[16][4], std::byte* out)
+    {
+        float endpoints[2][4];
+        endpoints_fit(block, 4, 255.0f, endpoints);
+
+        // Quantize, each endpoint picks the p-bit (the lowest bit shared by its channels) which fits it best
+        uint32_t quantized[2][4];
+        uint32_t p_bits[2];
+        for (uint32_t e = 0; e < 2; e++)
+        {
+            float error_best = FLT_MAX;
+            for (uint32_t p = 0; p < 2; p++)
+            {
+                uint32_t candidate[4];
+                float error = 0.0f;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    candidate[c]        = static_cast<uint32_t>(clamp(static_cast<int>(round((endpoints[e][c] - p) / 2.0f)), 0, 127));
+                    const float delta   = static_cast<float>((candidate[c] << 1) | p) - endpoints[e][c];
+                    error               += delta * delta;
+                }
+
+                if (error < error_best)
+                {
+                    error_best = error;
+                    p_bits[e]  = p;
+                    memcpy(quantized[e], candidate, sizeof(candidate));
+                }
+            }
+        }
+
+        int palette[16][4];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                const int e0    = static_cast<int>((quantized[0][c] << 1) | p_bits[0]);
+                const int e1    = static_cast<int>((quantized[1][c] << 1) | p_bits[1]);
+                palette[i][c]   = ((64 - weights_4bit[i]) * e0 + weights_4bit[i] * e1 + 32) >> 6;
+            }
+        }
+
+        uint32_t indices[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float error_best = FLT_MAX;
+            for (uint32_t j = 0; j < 16; j++)
+            {
+                float error = 0.0f;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    const float delta = block[i][c] - palette[j][c];
+                    error += delta * delta;
+                }
+
+                if (error < error_best)
+                {
+                    error_best  = error;
+                    indices[i]  = j;
+                }
+            }
+        }
+
+        // The first index is stored without its high bit, so it has to be below 8
+        if (indices[0] & 8)
+        {
+            swap(quantized[0], quantized[1]);
+            swap(p_bits[0], p_bits[1]);
+            for (uint32_t& index : indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter writer;
+        writer.Write(1 << 6, 7);
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            writer.Write(quantized[0][c], 7);
+            writer.Write(quantized[1][c], 7);
+        }
+        writer.Write(p_bits[0], 1);
+        writer.Write(p_bits[1], 1);
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            writer.Write(indices[i], i == 0 ? 3 : 4);
+        }
+
+        memcpy(out, writer.bits, 16);
+    }
+
+    // Positive half floats, negatives (which BC6H_UF16 can't hold) and NaNs become zero
+    uint16_t float_to_half_unsigned(const float value)
+    {
+        if (!(value > 0.0f))
+            return 0;
+
+        if (value >= 65504.0f)
+            return 0x7BFF;
+
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const int32_t exponent  = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+        uint32_t mantissa       = bits & 0x7FFFFF;
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+                return 0;
+
+            mantissa |= 0x800000;
+            return static_cast<uint16_t>(mantissa >> (14 - exponent));
+        }
+
+        return static_cast<uint16_t>((exponent << 10) | (mantissa >> 13));
+    }
+
+    // What the hardware does with a 10 bit unsigned endpoint before interpolating, and to the interpolated value after
+    int32_t bc6h_unquantize(const uint32_t value)
+    {
+        if (value == 0)
+            return 0;
+
+        if (value == 1023)
+            return 0xFFFF;
+
+        return static_cast<int32_t>(((value << 16) + 0x8000) >> 10);
+    }
+
+    int32_t bc6h_finish(const int32_t value)
+    {
+        return (value * 31) >> 6;
+    }
+
+    // Mode 11: one region, RGB endpoints of 10 bits (not delta encoded), 4 bit indices.
+    // The encoder fits the half float bit patterns, which are what the hardware interpolates.
+    void encode_bc6h(const float block[16][4], std::byte* out)
+    {
+        float halfs[16][4];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                halfs[i][c] = static_cast<float>(float_to_half_unsigned(block[i][c]));
+            }
+            halfs[i][3] = 0.0f;
+        }
+
+        float endpoints[2][4];
+        endpoints_fit(halfs, 3, static_cast<float>(0x7BFF), endpoints);
+
+        // The finished value of an endpoint is about 31 times the quantized one
+        uint32_t quantized[2][3];
+        for (uint32_t e = 0; e < 2; e++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                quantized[e][c] = static_cast<uint32_t>(clamp(static_cast<int>(round(endpoints[e][c] / 31.0f)), 0, 1023));
+            }
+        }
+
+        int32_t palette[16][3];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                const int32_t e0 = bc6h_unquantize(quantized[0][c]);
+                const int32_t e1 = bc6h_unquantize(quantized[1][c]);
+                palette[i][c]    = bc6h_finish((e0 * (64 - static_cast<int32_t>(weights_4bit[i])) + e1 * static_cast<int32_t>(weights_4bit[i]) + 32) >> 6);
+            }
+        }
+
+        uint32_t indices[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float error_best = FLT_MAX;
+            for (uint32_t j = 0; j < 16; j++)
+            {
+                float error = 0.0f;
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    const float delta = halfs[i][c] - palette[j][c];
+                    error += delta * delta;
+                }
+
+                if (error < error_best)
+                {
+                    error_best  = error;
+                    indices[i]  = j;
+                }
+            }
+        }
+
+        // The first index is stored without its high bit, so it has to be below 8
+        if (indices[0] & 8)
+        {
+            swap(quantized[0], quantized[1]);
+            for (uint32_t& index : indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter writer;
+        writer.Write(0x03, 5);
+        for (uint32_t e = 0; e < 2; e++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                writer.Write(quantized[e][c], 10);
+            }
+        }
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            writer.Write(indices[i], i == 0 ? 3 : 4);
+        }
+
+        memcpy(out, writer.bits, 16);
+    }
+}
+
+namespace Spartan
+{
+    bool BlockCompression::Encode(const RHI_Format format, const std::byte* pixels, const uint32_t width, const uint32_t height, vector<std::byte>& blocks, Threading* threading /*= nullptr*/)
+    {
+        const uint32_t block_size = rhi_format_block_size(format);
+        if (block_size == 0 || !pixels || width == 0 || height == 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        const uint32_t block_count_x = (width + 3) / 4;
+        const uint32_t block_count_y = (height + 3) / 4;
+        blocks.resize(static_cast<size_t>(block_count_x) * block_count_y * block_size);
+
+        const auto encode_rows = [format, pixels, width, height, block_size, block_count_x, &blocks](const uint32_t start, const uint32_t end)
+        {
+            float block[16][4];
+            for (uint32_t block_y = start; block_y < end; block_y++)
+            {
+                for (uint32_t block_x = 0; block_x < block_count_x; block_x++)
+                {
+                    std::byte* out = blocks.data() + (static_cast<size_t>(block_y) * block_count_x + block_x) * block_size;
+                    if (format == RHI_Format_BC6H_Uf16)
+                    {
+                        _BlockCompression::block_load(reinterpret_cast<const float*>(pixels), width, height, block_x, block_y, block);
+                        _BlockCompression::encode_bc6h(block, out);
+                        continue;
+                    }
+
+                    _BlockCompression::block_load(reinterpret_cast<const uint8_t*>(pixels), width, height, block_x, block_y, block);
+                    if (format == RHI_Format_BC4_Unorm)
+                    {
+                        _BlockCompression::encode_bc4(block, 0, out);
+                    }
+                    else if (format == RHI_Format_BC5_Unorm)
+                    {
+                        _BlockCompression::encode_bc4(block, 0, out);
+                        _BlockCompression::encode_bc4(block, 1, out + 8);
+                    }
+                    else
+                    {
+                        _BlockCompression::encode_bc7(block, out);
+                    }
+                }
+            }
+        };
+
+        if (threading)
+        {
+            threading->ParallelFor(encode_rows, block_count_y);
+        }
+        else
+        {
+            encode_rows(0, block_count_y);
+        }
+
+        return true;
+    }
+}
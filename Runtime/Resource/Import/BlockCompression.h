@@ -0,0 +1,44 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ========================
+#include <vector>
+#include "../../Core/EngineDefs.h"
+#include "../../RHI/RHI_Definition.h"
+//===================================
+
+namespace Spartan
+{
+	class Threading;
+
+	// Block compression of imported texture mips (BC4, BC5, BC6H and BC7).
+	// Each format is encoded with a single mode (BC7 mode 6, BC6H mode 11), fitting the endpoints to the principal axis of the block,
+	// which is fast enough to run at import and is close to what the slower exhaustive encoders achieve on most textures.
+	class SPARTAN_CLASS BlockCompression
+	{
+	public:
+		// The pixels are RGBA8 (BC4 takes red, BC5 red and green) or RGBA32F (BC6H), mips which are smaller than a block are padded.
+		// The rows of blocks are encoded in parallel, when a threading subsystem is provided.
+		static bool Encode(RHI_Format format, const std::byte* pixels, uint32_t width, uint32_t height, std::vector<std::byte>& blocks, Threading* threading = nullptr);
+	};
+}
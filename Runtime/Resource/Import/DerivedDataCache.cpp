@@ -0,0 +1,124 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ========================
+#include "DerivedDataCache.h"
+#include <fstream>
+#include <sstream>
+#include "../ResourceCache.h"
+#include "../../IO/FileStream.h"
+#include "../../Utilities/Hash.h"
+//===================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+	DerivedDataCache::DerivedDataCache(Context* context)
+	{
+		m_context = context;
+		SetDirectory(m_context->GetSubsystem<ResourceCache>()->GetProjectDirectory() + "cache/");
+	}
+
+	size_t DerivedDataCache::ComputeKey(const string& file_path) const
+	{
+		ifstream in(file_path, ios::in | ios::binary);
+		if (!in.good())
+			return 0;
+
+		stringstream buffer;
+		buffer << in.rdbuf();
+
+		size_t key = 0;
+		Utility::Hash::hash_combine(key, buffer.str());
+		Utility::Hash::hash_combine(key, derived_data_cache_version);
+
+		return key;
+	}
+
+	size_t DerivedDataCache::ComputeKeyFromTimestamp(const string& file_path) const
+	{
+		const uint64_t time = FileSystem::GetLastWriteTime(file_path);
+		if (time == 0)
+			return 0;
+
+		size_t key = 0;
+		Utility::Hash::hash_combine(key, file_path);
+		Utility::Hash::hash_combine(key, FileSystem::GetFileSize(file_path));
+		Utility::Hash::hash_combine(key, time);
+		Utility::Hash::hash_combine(key, derived_data_cache_version);
+
+		return key;
+	}
+
+	bool DerivedDataCache::Load(const size_t key, string* data) const
+	{
+		const string file_path = GetEntryFilePath(key);
+		if (key == 0 || !data || !FileSystem::IsFile(file_path))
+			return false;
+
+		auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
+		if (!file->IsOpen() || file->ReadAs<uint32_t>() != derived_data_cache_version)
+			return false;
+
+		file->Read(data);
+
+		return !data->empty();
+	}
+
+	bool DerivedDataCache::Save(const size_t key, const string& data) const
+	{
+		if (key == 0 || data.empty())
+			return false;
+
+		if (!FileSystem::Exists(m_directory) && !FileSystem::CreateDirectory_(m_directory))
+			return false;
+
+		auto file = make_unique<FileStream>(GetEntryFilePath(key), FileStream_Write);
+		if (!file->IsOpen())
+			return false;
+
+		file->Write(derived_data_cache_version);
+		file->Write(data);
+		file->Close();
+
+		return true;
+	}
+
+	void DerivedDataCache::SetDirectory(const string& directory)
+	{
+		m_directory = directory;
+		if (!m_directory.empty() && m_directory.back() != '/' && m_directory.back() != '\\')
+		{
+			m_directory += "/";
+		}
+	}
+
+	string DerivedDataCache::GetEntryFilePath(const size_t key) const
+	{
+		stringstream name;
+		name << hex << key;
+		return m_directory + name.str() + ".bin";
+	}
+}
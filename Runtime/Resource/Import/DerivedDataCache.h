@@ -0,0 +1,64 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==================
+#include <string>
+#include "../../Core/EngineDefs.h"
+//=============================
+
+namespace Spartan
+{
+	class Context;
+
+	// Bump when an importer changes what it derives, so that the entries of older versions are missed
+	constexpr uint32_t derived_data_cache_version = 1;
+
+	// Content addressed storage for what importers derive from source files (post-processed scenes, texture mips, etc.).
+	// An entry's key is the source file's content together with the settings of the import, so an unchanged
+	// file which is imported again (or by another checkout which shares the directory) skips the work.
+	class SPARTAN_CLASS DerivedDataCache
+	{
+	public:
+		DerivedDataCache(Context* context);
+
+		// The content of the source file (and the cache version), importers combine their settings into it. Zero if the file can't be read.
+		size_t ComputeKey(const std::string& file_path) const;
+		// The path, size and last write time of the source file (and the cache version), cheaper than ComputeKey() for derived data which is
+		// queried often and is quick to derive again (e.g. editor thumbnails). Zero if the file can't be queried.
+		size_t ComputeKeyFromTimestamp(const std::string& file_path) const;
+
+		bool Load(size_t key, std::string* data) const;
+		bool Save(size_t key, const std::string& data) const;
+
+		// Defaults to the cache directory of the project
+		const std::string& GetDirectory() const { return m_directory; }
+		void SetDirectory(const std::string& directory);
+
+	private:
+		std::string GetEntryFilePath(size_t key) const;
+
+		std::string m_directory;
+		Context* m_context = nullptr;
+	};
+}
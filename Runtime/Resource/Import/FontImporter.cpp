@@ -38,6 +38,7 @@ namespace Spartan
 	static const uint32_t GLYPH_START	= 32;
 	static const uint32_t GLYPH_END		= 127;
 	static const uint32_t ATLAS_WIDTH	= 512;
+	static const uint32_t SDF_SPREAD	= 6; // pixels, the distance which the signed distance field of a glyph spans on either side of its edge
 
     static FT_UInt32 g_glyph_load_flags = 0;
 
@@ -50,7 +51,7 @@ namespace Spartan
             {
                 if (buffer)
                 {
-                    delete buffer;
+                    delete[] buffer;
                     buffer = nullptr;
                 }
             }
@@ -301,6 +302,50 @@ namespace Spartan
             }
         }
 
+        // Signed distance field of a glyph, padded by the spread on every side, 0.5 (128) is the edge and inside is above it
+        inline void get_bitmap_sdf(ft_bitmap* bitmap_sdf, const ft_bitmap& bitmap, const uint32_t spread)
+        {
+            bitmap_sdf->width       = bitmap.width  + spread * 2;
+            bitmap_sdf->height      = bitmap.height + spread * 2;
+            bitmap_sdf->pixel_mode  = FT_PIXEL_MODE_GRAY;
+            bitmap_sdf->buffer      = new unsigned char[bitmap_sdf->width * bitmap_sdf->height];
+
+            const auto inside = [&bitmap, spread](const int32_t x, const int32_t y)
+            {
+                const int32_t glyph_x = x - static_cast<int32_t>(spread);
+                const int32_t glyph_y = y - static_cast<int32_t>(spread);
+                if (glyph_x < 0 || glyph_y < 0 || glyph_x >= static_cast<int32_t>(bitmap.width) || glyph_y >= static_cast<int32_t>(bitmap.height))
+                    return false;
+
+                return bitmap.buffer[glyph_x + glyph_y * bitmap.width] >= 128;
+            };
+
+            // Brute force within the spread, glyphs are small and this only runs when the font loads
+            const int32_t radius = static_cast<int32_t>(spread);
+            for (int32_t y = 0; y < static_cast<int32_t>(bitmap_sdf->height); y++)
+            {
+                for (int32_t x = 0; x < static_cast<int32_t>(bitmap_sdf->width); x++)
+                {
+                    const bool is_inside    = inside(x, y);
+                    float distance_squared  = static_cast<float>(radius * radius);
+                    for (int32_t offset_y = -radius; offset_y <= radius; offset_y++)
+                    {
+                        for (int32_t offset_x = -radius; offset_x <= radius; offset_x++)
+                        {
+                            if (inside(x + offset_x, y + offset_y) != is_inside)
+                            {
+                                distance_squared = Helper::Min(distance_squared, static_cast<float>(offset_x * offset_x + offset_y * offset_y));
+                            }
+                        }
+                    }
+
+                    const float distance    = sqrt(distance_squared) * (is_inside ? 1.0f : -1.0f);
+                    const float value       = Helper::Saturate(0.5f + distance / static_cast<float>(spread * 2));
+                    bitmap_sdf->buffer[x + y * bitmap_sdf->width] = static_cast<unsigned char>(value * 255.0f);
+                }
+            }
+        }
+
         inline void copy_to_atlas(vector<std::byte>& atlas, const ft_bitmap& bitmap, const Vector2& pen, const uint32_t atlas_width, const uint32_t outline_size)
         {
             for (uint32_t glyph_y = 0; glyph_y < bitmap.height; glyph_y++)
@@ -421,9 +466,11 @@ namespace Spartan
 			return false;
 		}
 
-        // Set outline size
-        uint32_t outline_size   = (font->GetOutline() != Font_Outline_None) ? font->GetOutlineSize() : 0;
+        // Set outline size, a signed distance field has no outline atlas but its glyphs are padded by the spread instead
+        const bool sdf          = font->IsSdf();
+        uint32_t outline_size   = (!sdf && font->GetOutline() != Font_Outline_None) ? font->GetOutlineSize() : 0;
         bool outline            = outline_size != 0;
+        const uint32_t padding  = sdf ? SDF_SPREAD : outline_size;
         if (outline)
         {
             FT_Stroker_Set(m_stroker, outline_size * 64, FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0);
@@ -436,7 +483,7 @@ namespace Spartan
         uint32_t atlas_height       = 0;
         uint32_t atlas_cell_width   = 0;
         uint32_t atlas_cell_height  = 0;
-        ft_helper::get_texture_atlas_dimensions(&atlas_width, &atlas_height, &atlas_cell_width, &atlas_cell_height, ft_font, outline_size);
+        ft_helper::get_texture_atlas_dimensions(&atlas_width, &atlas_height, &atlas_cell_width, &atlas_cell_height, ft_font, padding);
 
         // Atlas for text
         vector<std::byte> atlas_text(atlas_width * atlas_height);
@@ -482,7 +529,15 @@ namespace Spartan
             }
 
             // Copy to atlas buffers
-            if (bitmap_text.buffer)
+            if (bitmap_text.buffer && sdf)
+            {
+                ft_helper::ft_bitmap bitmap_sdf;
+                ft_helper::get_bitmap_sdf(&bitmap_sdf, bitmap_text, SDF_SPREAD);
+                ft_helper::copy_to_atlas(atlas_text, bitmap_sdf, pen, atlas_width, 0);
+
+                writting_started = true;
+            }
+            else if (bitmap_text.buffer)
             {
                 ft_helper::copy_to_atlas(atlas_text, bitmap_text, pen, atlas_width, outline_size);
 
@@ -494,8 +549,14 @@ namespace Spartan
                 writting_started = true;
             }
 
-			// Get glyph
-            font->SetGlyph(char_code, ft_helper::get_glyph(ft_font, char_code, pen, atlas_width, atlas_height, outline_size));
+			// Get glyph (the quad of a signed distance field glyph covers its padding as well)
+            Glyph glyph = ft_helper::get_glyph(ft_font, char_code, pen, atlas_width, atlas_height, padding);
+            if (sdf)
+            {
+                glyph.offset_x -= static_cast<int32_t>(SDF_SPREAD);
+                glyph.offset_y += static_cast<int32_t>(SDF_SPREAD);
+            }
+            font->SetGlyph(char_code, glyph);
 		}
 
 		// Free face
@@ -29,6 +29,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Core/Settings.h"
 #include "../../Math/MathHelper.h"
 #include "../../RHI/RHI_Texture2D.h"
+#include "BlockCompression.h"
+#include "MipChain.h"
+#include "DerivedDataCache.h"
+#include "../ResourceCache.h"
+#include "../../IO/FileStream.h"
+#include "../../Utilities/Hash.h"
 //====================================
 
 //= NAMESPACES =====
@@ -39,23 +45,6 @@ namespace Spartan::freeimage_helper
 {
 	static FREE_IMAGE_FILTER rescale_filter = FILTER_LANCZOS3;
 
-	// A struct that rescaling threads will work with
-	struct RescaleJob
-	{
-		uint32_t width		    = 0;
-		uint32_t height		    = 0;
-		uint32_t channel_count	= 0;
-		vector<std::byte>* data	= nullptr;
-		bool done			    = false;
-
-		RescaleJob(const uint32_t width, const uint32_t height, const uint32_t channel_count)
-		{
-			this->width		    = width;
-			this->height	    = height;
-			this->channel_count	= channel_count;
-		}
-	};
-
     inline uint32_t get_bytes_per_channel(FIBITMAP* bitmap)
     {
         if (!bitmap)
@@ -166,6 +155,20 @@ namespace Spartan
 			return false;
 		}
 
+		// An unchanged image which was imported with the same settings before doesn't have to be decoded, mipmapped and compressed again
+		size_t derived_data_key = m_context->GetSubsystem<ResourceCache>()->GetDerivedDataCache()->ComputeKey(file_path);
+		if (derived_data_key != 0)
+		{
+			Utility::Hash::hash_combine(derived_data_key, generate_mipmaps);
+			Utility::Hash::hash_combine(derived_data_key, texture->GetWidth());
+			Utility::Hash::hash_combine(derived_data_key, texture->GetHeight());
+			Utility::Hash::hash_combine(derived_data_key, static_cast<uint32_t>(texture->GetCompression()));
+			Utility::Hash::hash_combine(derived_data_key, static_cast<bool>(texture->GetSrgb()));
+
+			if (LoadFromDerivedDataCache(derived_data_key, texture))
+				return true;
+		}
+
 		// Acquire image format
 		auto format	= FreeImage_GetFileType(file_path.c_str(), 0);
 		format		= (format == FIF_UNKNOWN) ? FreeImage_GetFIFFromFilename(file_path.c_str()) : format;  // If the format is unknown, try to get it from the the filename	
@@ -217,7 +220,7 @@ namespace Spartan
 		// If the texture supports mipmaps, generate them
 		if (generate_mipmaps)
 		{
-			GenerateMipmaps(bitmap, texture, image_width, image_height, image_channel_count);
+			GenerateMipmaps(texture, image_width, image_height, image_channel_count, image_bytes_per_channel);
 		}
 
 		// Free memory 
@@ -232,6 +235,106 @@ namespace Spartan
 		texture->SetFormat(image_format);
 		texture->SetGrayscale(image_is_grayscale);
 
+		// Block compress the mips (if the texture asks for it)
+		if (texture->GetCompression() != RHI_Format_Undefined)
+		{
+			Compress(texture);
+		}
+
+		SaveToDerivedDataCache(derived_data_key, texture);
+
+		return true;
+	}
+
+	bool ImageImporter::LoadFromDerivedDataCache(const size_t key, RHI_Texture* texture) const
+	{
+		string data;
+		if (!m_context->GetSubsystem<ResourceCache>()->GetDerivedDataCache()->Load(key, &data))
+			return false;
+
+		FileStream stream(reinterpret_cast<const std::byte*>(data.data()), data.size());
+		const uint32_t width				= stream.ReadAs<uint32_t>();
+		const uint32_t height				= stream.ReadAs<uint32_t>();
+		const uint32_t channel_count		= stream.ReadAs<uint32_t>();
+		const uint32_t bits_per_channel		= stream.ReadAs<uint32_t>();
+		const RHI_Format format				= static_cast<RHI_Format>(stream.ReadAs<uint32_t>());
+		const bool is_transparent			= stream.ReadAs<bool>();
+		const bool is_grayscale				= stream.ReadAs<bool>();
+		vector<vector<std::byte>> mips(stream.ReadAs<uint32_t>());
+		for (auto& mip : mips)
+		{
+			stream.Read(&mip);
+		}
+
+		if (mips.empty() || mips.back().empty())
+			return false;
+
+		texture->SetData(mips);
+		texture->SetWidth(width);
+		texture->SetHeight(height);
+		texture->SetChannelCount(channel_count);
+		texture->SetBitsPerChannel(bits_per_channel);
+		texture->SetFormat(format);
+		texture->SetTransparency(is_transparent);
+		texture->SetGrayscale(is_grayscale);
+
+		return true;
+	}
+
+	void ImageImporter::SaveToDerivedDataCache(const size_t key, const RHI_Texture* texture) const
+	{
+		if (key == 0)
+			return;
+
+		string data;
+		{
+			FileStream stream(&data, FileStream_Write);
+			stream.Write(texture->GetWidth());
+			stream.Write(texture->GetHeight());
+			stream.Write(texture->GetChannelCount());
+			stream.Write(texture->GetBitsPerChannel());
+			stream.Write(static_cast<uint32_t>(texture->GetFormat()));
+			stream.Write(static_cast<bool>(texture->GetTransparency()));
+			stream.Write(static_cast<bool>(texture->GetGrayscale()));
+			stream.Write(static_cast<uint32_t>(texture->GetData().size()));
+			for (const auto& mip : texture->GetData())
+			{
+				stream.Write(mip);
+			}
+		}
+
+		m_context->GetSubsystem<ResourceCache>()->GetDerivedDataCache()->Save(key, data);
+	}
+
+	bool ImageImporter::Compress(RHI_Texture* texture) const
+	{
+		const RHI_Format format		= texture->GetCompression();
+		const bool is_hdr			= format == RHI_Format_BC6H_Uf16;
+		const uint32_t width		= texture->GetWidth();
+		const uint32_t height		= texture->GetHeight();
+
+		// The encoders take RGBA8 (or RGBA32F for BC6H), and the top mip has to be made of whole blocks
+		const bool format_compatible = texture->GetChannelCount() == 4 && texture->GetBitsPerChannel() == (is_hdr ? 32 : 8);
+		if (!format_compatible || width % 4 != 0 || height % 4 != 0)
+		{
+			LOG_WARNING("Can't compress %dx%d %s to %s, it will be left uncompressed", width, height, rhi_format_to_string(texture->GetFormat()), rhi_format_to_string(format));
+			return false;
+		}
+
+		const auto& data = texture->GetData();
+		vector<vector<std::byte>> data_compressed(data.size());
+		for (uint32_t mip_index = 0; mip_index < static_cast<uint32_t>(data.size()); mip_index++)
+		{
+			const uint32_t mip_width	= Math::Helper::Max(width >> mip_index, 1u);
+			const uint32_t mip_height	= Math::Helper::Max(height >> mip_index, 1u);
+			if (!BlockCompression::Encode(format, data[mip_index].data(), mip_width, mip_height, data_compressed[mip_index], m_context->GetSubsystem<Threading>()))
+				return false;
+		}
+
+		texture->SetData(data_compressed);
+		texture->SetFormat(format);
+		texture->SetChannelCount(RHI_Texture::GetChannelCountFromFormat(format));
+
 		return true;
 	}
 
@@ -259,64 +362,25 @@ namespace Spartan
 		return true;
 	}
 
-	void ImageImporter::GenerateMipmaps(FIBITMAP* bitmap, RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels)
+	void ImageImporter::GenerateMipmaps(RHI_Texture* texture, const uint32_t width, const uint32_t height, const uint32_t channels, const uint32_t bytes_per_channel)
 	{
-		if (!texture)
+		if (!texture || !texture->HasMipmaps())
 		{
 			LOG_ERROR_INVALID_PARAMETER();
 			return;
 		}
-	
-		// Create a RescaleJob for every mip that we need
-		vector<freeimage_helper::RescaleJob> jobs;
-		while (width > 1 && height > 1)
-		{
-			width	= Math::Helper::Max(width / 2, static_cast<uint32_t>(1));
-			height	= Math::Helper::Max(height / 2, static_cast<uint32_t>(1));
-			jobs.emplace_back(width, height, channels);
-			
-			// Resize the RHI_Texture vector accordingly
-			const auto size = width * height * channels;
-			auto mip		= texture->AddMipmap();
-			mip->reserve(size);
-			mip->resize(size);
-		}
 
-		// Pass data pointers (now that the RHI_Texture mip vector has been constructed)
-		for (uint32_t i = 0; i < jobs.size(); i++)
+		// Every level is filtered from the one above it, the first one is the image itself
+		vector<vector<std::byte>> mips;
+		if (!MipChain::Generate(texture->GetData()[0].data(), width, height, channels, bytes_per_channel, texture->GetSrgb(), mips, m_context->GetSubsystem<Threading>()))
 		{
-			// reminder: i + 1 because the 0 mip is the default image size
-			jobs[i].data = texture->GetData(i + 1);
-		}
-
-		// Parallelize mipmap generation using multiple threads (because FreeImage_Rescale() using FILTER_LANCZOS3 is expensive)
-		auto threading = m_context->GetSubsystem<Threading>();
-		for (auto& job : jobs)
-		{
-			threading->AddTask([this, &job, &bitmap]()
-			{
-				const auto bitmap_scaled = FreeImage_Rescale(bitmap, job.width, job.height, freeimage_helper::rescale_filter);
-				if (!GetBitsFromFibitmap(job.data, bitmap_scaled, job.width, job.height, job.channel_count))
-				{
-					LOG_ERROR("Failed to create mip level %dx%d", job.width, job.height);
-				}
-				FreeImage_Unload(bitmap_scaled);
-				job.done = true;
-			});
+			LOG_ERROR("Failed to generate mipmaps for %dx%d image", width, height);
+			return;
 		}
 
-		// Wait until all mipmaps have been generated
-		auto ready = false;
-		while (!ready)
+		for (auto& mip : mips)
 		{
-			ready = true;
-			for (const auto& job : jobs)
-			{
-				if (!job.done)
-				{
-					ready = false;
-				}
-			}
+			texture->AddMipmap()->swap(mip);
 		}
 	}
 
@@ -44,7 +44,10 @@ namespace Spartan
 
 	private:	
 		bool GetBitsFromFibitmap(std::vector<std::byte>* data, FIBITMAP* bitmap, uint32_t width, uint32_t height, uint32_t channels) const;
-		void GenerateMipmaps(FIBITMAP* bitmap, RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels);
+		void GenerateMipmaps(RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels, uint32_t bytes_per_channel);
+		bool Compress(RHI_Texture* texture) const;
+		bool LoadFromDerivedDataCache(size_t key, RHI_Texture* texture) const;
+		void SaveToDerivedDataCache(size_t key, const RHI_Texture* texture) const;
 		FIBITMAP* ApplyBitmapCorrections(FIBITMAP* bitmap) const;
 		FIBITMAP* _FreeImage_ConvertTo32Bits(FIBITMAP* bitmap) const;
 		FIBITMAP* _FreeImage_Rescale(FIBITMAP* bitmap, uint32_t width, uint32_t height) const;
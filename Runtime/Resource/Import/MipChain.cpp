@@ -0,0 +1,251 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ======================
+#include "MipChain.h"
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <xmmintrin.h>
+#include "../../Logging/Log.h"
+#include "../../Threading/Threading.h"
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace _MipChain
+{
+    // The same curve the shaders decode color with (see degamma())
+    static const float gamma = 2.2f;
+
+    struct GammaTables
+    {
+        GammaTables()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                to_linear[i] = pow(i / 255.0f, gamma);
+            }
+
+            // Encoding picks the closest code, so it searches the midpoints between the decoded ones
+            for (uint32_t i = 0; i < 255; i++)
+            {
+                midpoints[i] = (to_linear[i] + to_linear[i + 1]) * 0.5f;
+            }
+        }
+
+        uint8_t ToGamma(const float value) const
+        {
+            return static_cast<uint8_t>(lower_bound(midpoints, midpoints + 255, value) - midpoints);
+        }
+
+        float to_linear[256];
+        float midpoints[255];
+    };
+
+    static const GammaTables& gamma_tables()
+    {
+        static const GammaTables tables;
+        return tables;
+    }
+
+    // The source texels (and their weights) a destination texel averages, along one axis
+    struct Taps
+    {
+        uint32_t index[3]   = { 0, 0, 0 };
+        float weight[3]     = { 0.0f, 0.0f, 0.0f };
+        uint32_t count      = 0;
+    };
+
+    void taps_compute(const uint32_t size_source, const uint32_t size, vector<Taps>& taps)
+    {
+        taps.resize(size);
+        for (uint32_t i = 0; i < size; i++)
+        {
+            Taps& tap = taps[i];
+            if (size_source == 1)
+            {
+                tap.count       = 1;
+                tap.weight[0]   = 1.0f;
+            }
+            else if (size_source % 2 == 0)
+            {
+                tap.count       = 2;
+                tap.index[0]    = i * 2;
+                tap.index[1]    = i * 2 + 1;
+                tap.weight[0]   = 0.5f;
+                tap.weight[1]   = 0.5f;
+            }
+            else
+            {
+                // 2n + 1 texels to n, each destination texel covers 2 + 1/n source texels
+                const float n   = static_cast<float>(size);
+                tap.count       = 3;
+                tap.index[0]    = i * 2;
+                tap.index[1]    = i * 2 + 1;
+                tap.index[2]    = i * 2 + 2;
+                tap.weight[0]   = (n - i) / (2.0f * n + 1.0f);
+                tap.weight[1]   = n / (2.0f * n + 1.0f);
+                tap.weight[2]   = (i + 1.0f) / (2.0f * n + 1.0f);
+            }
+        }
+    }
+
+    // Levels are filtered as linear RGBA floats, one __m128 per texel
+    void level_filter(const float* source, const uint32_t width_source, const vector<Taps>& taps_x, const vector<Taps>& taps_y, float* destination, const uint32_t start, const uint32_t end)
+    {
+        const uint32_t width = static_cast<uint32_t>(taps_x.size());
+        for (uint32_t y = start; y < end; y++)
+        {
+            const Taps& tap_y = taps_y[y];
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const Taps& tap_x   = taps_x[x];
+                __m128 sum          = _mm_setzero_ps();
+                for (uint32_t j = 0; j < tap_y.count; j++)
+                {
+                    const float* row = source + static_cast<size_t>(tap_y.index[j]) * width_source * 4;
+                    for (uint32_t i = 0; i < tap_x.count; i++)
+                    {
+                        const __m128 texel  = _mm_loadu_ps(row + static_cast<size_t>(tap_x.index[i]) * 4);
+                        sum                 = _mm_add_ps(sum, _mm_mul_ps(texel, _mm_set1_ps(tap_y.weight[j] * tap_x.weight[i])));
+                    }
+                }
+                _mm_storeu_ps(destination + (static_cast<size_t>(y) * width + x) * 4, sum);
+            }
+        }
+    }
+
+    void level_decode(const std::byte* pixels, const size_t texel_count, const uint32_t channel_count, const uint32_t bytes_per_channel, const bool is_srgb, float* level)
+    {
+        const GammaTables& tables = gamma_tables();
+        for (size_t i = 0; i < texel_count; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                float value = 0.0f;
+                if (c < channel_count)
+                {
+                    if (bytes_per_channel == 4)
+                    {
+                        value = reinterpret_cast<const float*>(pixels)[i * channel_count + c];
+                    }
+                    else
+                    {
+                        const uint8_t code  = static_cast<uint8_t>(pixels[i * channel_count + c]);
+                        value               = (is_srgb && c < 3) ? tables.to_linear[code] : code / 255.0f;
+                    }
+                }
+                level[i * 4 + c] = value;
+            }
+        }
+    }
+
+    void level_encode(const float* level, const size_t start, const size_t end, const uint32_t channel_count, const uint32_t bytes_per_channel, const bool is_srgb, std::byte* pixels)
+    {
+        const GammaTables& tables = gamma_tables();
+        for (size_t i = start; i < end; i++)
+        {
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                const float value = level[i * 4 + c];
+                if (bytes_per_channel == 4)
+                {
+                    reinterpret_cast<float*>(pixels)[i * channel_count + c] = value;
+                }
+                else
+                {
+                    const uint8_t code = (is_srgb && c < 3) ? tables.ToGamma(value) : static_cast<uint8_t>(clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+                    pixels[i * channel_count + c] = static_cast<std::byte>(code);
+                }
+            }
+        }
+    }
+}
+
+namespace Spartan
+{
+    bool MipChain::Generate(
+        const std::byte* pixels,
+        uint32_t width,
+        uint32_t height,
+        const uint32_t channel_count,
+        const uint32_t bytes_per_channel,
+        const bool is_srgb,
+        vector<vector<std::byte>>& mips,
+        Threading* threading /*= nullptr*/
+    )
+    {
+        if (!pixels || width == 0 || height == 0 || channel_count == 0 || channel_count > 4 || (bytes_per_channel != 1 && bytes_per_channel != 4))
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        const auto parallel_for = [threading](const function<void(uint32_t, uint32_t)>& function, const uint32_t range)
+        {
+            if (threading)
+            {
+                threading->ParallelFor(function, range);
+            }
+            else
+            {
+                function(0, range);
+            }
+        };
+
+        vector<float> level_source(static_cast<size_t>(width) * height * 4);
+        _MipChain::level_decode(pixels, static_cast<size_t>(width) * height, channel_count, bytes_per_channel, is_srgb, level_source.data());
+
+        vector<float> level;
+        vector<_MipChain::Taps> taps_x;
+        vector<_MipChain::Taps> taps_y;
+        while (width > 1 || height > 1)
+        {
+            const uint32_t width_source     = width;
+            const uint32_t height_source    = height;
+            width                           = max(width / 2, 1u);
+            height                          = max(height / 2, 1u);
+
+            _MipChain::taps_compute(width_source, width, taps_x);
+            _MipChain::taps_compute(height_source, height, taps_y);
+
+            level.resize(static_cast<size_t>(width) * height * 4);
+            parallel_for([&](const uint32_t start, const uint32_t end)
+            {
+                _MipChain::level_filter(level_source.data(), width_source, taps_x, taps_y, level.data(), start, end);
+            }, height);
+
+            vector<std::byte>& mip = mips.emplace_back(static_cast<size_t>(width) * height * channel_count * bytes_per_channel);
+            parallel_for([&](const uint32_t start, const uint32_t end)
+            {
+                _MipChain::level_encode(level.data(), static_cast<size_t>(start) * width, static_cast<size_t>(end) * width, channel_count, bytes_per_channel, is_srgb, mip.data());
+            }, height);
+
+            level_source.swap(level);
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,52 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include "../../Core/EngineDefs.h"
+//=============================
+
+namespace Spartan
+{
+	class Threading;
+
+	// Mip chain generation on the CPU, each level is box filtered from the one above it (3 taps across odd dimensions, so no texel is dropped).
+	// The filtering is done in linear space with SSE, gamma encoded color is decoded first and re-encoded after, alpha is always linear.
+	class SPARTAN_CLASS MipChain
+	{
+	public:
+		// The pixels are 8 bit unorm or 32 bit float channels (up to 4), the mips below the first one are appended to mips (down to 1x1).
+		// The rows of every level are filtered in parallel, when a threading subsystem is provided.
+		static bool Generate(
+			const std::byte* pixels,
+			uint32_t width,
+			uint32_t height,
+			uint32_t channel_count,
+			uint32_t bytes_per_channel,
+			bool is_srgb,
+			std::vector<std::vector<std::byte>>& mips,
+			Threading* threading = nullptr
+		);
+	};
+}
@@ -21,11 +21,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =================================
 #include "ModelImporter.h"
+#include <array>
 #include <assimp/Importer.hpp>
+#include <assimp/Exporter.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/version.h>
 #include "AssimpHelper.h"
+#include "DerivedDataCache.h"
 #include "../ProgressReport.h"
+#include "../ResourceCache.h"
 #include "../../RHI/RHI_Texture.h"
 #include "../../Core/Settings.h"
 #include "../../Rendering/Model.h"
@@ -33,7 +37,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Rendering/Material.h"
 #include "../../World/World.h"
 #include "../../World/Components/Renderable.h"
+#include "../../World/Components/Animator.h"
 #include "../../RHI/RHI_Vertex.h"
+#include "../../Utilities/Geometry.h"
+#include "../../Utilities/Hash.h"
+#include "../../Threading/Threading.h"
+#include "../../RHI/RHI_Texture2D.h"
 //============================================
 
 //= NAMESPACES ================
@@ -70,6 +79,7 @@ namespace Spartan
         params.vertex_limit                 = 1000000;
         params.max_normal_smoothing_angle   = 80.0f; // Normals exceeding this limit are not smoothed.
         params.max_tangent_smoothing_angle  = 80.0f; // Tangents exceeding this limit are not smoothed. Default is 45, max is 175
+        params.optimize_meshes              = true;
         params.file_path                    = file_path;
         params.name                         = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
         params.model                        = model;
@@ -84,6 +94,8 @@ namespace Spartan
 		importer.SetPropertyInteger(AI_CONFIG_PP_SLM_TRIANGLE_LIMIT, params.triangle_limit);
 		// Maximum number of vertices in a mesh (before splitting)	
 		importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, params.vertex_limit);
+		// Maximum number of bones in a mesh (before splitting), a skinned draw can only follow so many
+		importer.SetPropertyInteger(AI_CONFIG_PP_SBBC_MAX_BONES, static_cast<int>(rhi_max_skin_bones));
 		// Remove points and lines.
 		importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_LINE | aiPrimitiveType_POINT);	
 		// Remove cameras and lights
@@ -104,9 +116,9 @@ namespace Spartan
             aiProcess_GenSmoothNormals |
             aiProcess_JoinIdenticalVertices |
             aiProcess_OptimizeMeshes |              // reduce the number of meshes         
-            aiProcess_ImproveCacheLocality |        // re-order triangles for better vertex cache locality.
             aiProcess_RemoveRedundantMaterials |    // remove redundant/unreferenced materials.
-            aiProcess_LimitBoneWeights |
+            aiProcess_LimitBoneWeights |            // at most four bones per vertex (AI_LMW_MAX_WEIGHTS), which is what RHI_Vertex_Skin holds.
+            aiProcess_SplitByBoneCount |
             aiProcess_SplitLargeMeshes |
             aiProcess_Triangulate |
             aiProcess_GenUVCoords |
@@ -115,13 +127,51 @@ namespace Spartan
             aiProcess_FindInvalidData |
             aiProcess_FindInstances |
             aiProcess_ValidateDataStructure |
-            aiProcess_Debone;
+            aiProcess_Debone |
+            (params.optimize_meshes ? 0 : aiProcess_ImproveCacheLocality); // re-order triangles for better vertex cache locality (ConvertMesh() does that and more when optimizing).
 
         // aiProcess_FixInfacingNormals - is not reliable and fails often.
         // aiProcess_OptimizeGraph      - works but because it merges as nodes as possible, you can't really click and select anything other than the entire thing.
 
+        // The post-processed scene of an unchanged file which was imported with the same settings before is read back from the derived data cache
+        DerivedDataCache* derived_data_cache = m_context->GetSubsystem<ResourceCache>()->GetDerivedDataCache();
+        size_t derived_data_key = derived_data_cache->ComputeKey(file_path);
+        if (derived_data_key != 0)
+        {
+            Utility::Hash::hash_combine(derived_data_key, static_cast<uint32_t>(importer_flags));
+            Utility::Hash::hash_combine(derived_data_key, params.triangle_limit);
+            Utility::Hash::hash_combine(derived_data_key, params.vertex_limit);
+            Utility::Hash::hash_combine(derived_data_key, params.max_normal_smoothing_angle);
+            Utility::Hash::hash_combine(derived_data_key, params.max_tangent_smoothing_angle);
+            Utility::Hash::hash_combine(derived_data_key, params.optimize_meshes);
+            Utility::Hash::hash_combine(derived_data_key, aiGetVersionMajor());
+            Utility::Hash::hash_combine(derived_data_key, aiGetVersionMinor());
+            Utility::Hash::hash_combine(derived_data_key, aiGetVersionRevision());
+        }
+
+        const aiScene* scene = nullptr;
+        string derived_data;
+        if (derived_data_cache->Load(derived_data_key, &derived_data))
+        {
+            // Stored as assimp's binary dump, which needs no post-processing
+            scene = importer.ReadFileFromMemory(derived_data.data(), derived_data.size(), 0, "assbin");
+        }
+
 		// Read the 3D model file from disk
-		if (const aiScene* scene = importer.ReadFile(file_path, importer_flags))
+        if (!scene)
+        {
+            scene = importer.ReadFile(file_path, importer_flags);
+            if (scene && derived_data_key != 0)
+            {
+                Exporter exporter;
+                if (const aiExportDataBlob* blob = exporter.ExportToBlob(scene, "assbin"))
+                {
+                    derived_data_cache->Save(derived_data_key, string(static_cast<const char*>(blob->data), blob->size));
+                }
+            }
+        }
+
+		if (scene)
 		{
 			FIRE_EVENT(Event_World_Stop);
 
@@ -139,10 +189,18 @@ namespace Spartan
             AssimpHelper::compute_node_count(scene->mRootNode, &job_count);
             ProgressReport::Get().SetJobCount(g_progress_model_importer, job_count);
 
+            // Convert the meshes and load the materials (and their textures) in parallel, only the entity graph is built serially
+            vector<ModelMesh> meshes;
+            vector<shared_ptr<Material>> materials;
+            params.meshes       = &meshes;
+            params.materials    = &materials;
+            LoadMeshes(params);
+            LoadMaterials(params);
+
             // Parse all nodes, starting from the root node and continuing recursively
 			ParseNode(scene->mRootNode, params, nullptr, new_entity.get());
             // Parse animations
-			ParseAnimations(params);
+			ParseAnimations(params, new_entity.get());
             // Update model geometry
 			model->UpdateGeometry();
 
@@ -194,7 +252,6 @@ namespace Spartan
         for (uint32_t i = 0; i < assimp_node->mNumMeshes; i++)
         {
             auto entity = new_entity; // set the current entity
-            const auto assimp_mesh = params.scene->mMeshes[assimp_node->mMeshes[i]]; // get mesh
             string _name = assimp_node->mName.C_Str(); // get name
 
             // if this node has many meshes, then assign a new entity for each one of them
@@ -210,28 +267,26 @@ namespace Spartan
             entity->SetName(_name);
 
             // Process mesh
-            LoadMesh(assimp_mesh, entity, params);
+            LoadMesh(assimp_node->mMeshes[i], entity, params);
             entity->SetActive(true);
         }
     }
 
-    void ModelImporter::ParseAnimations(const ModelParams& params)
+    void ModelImporter::ParseAnimations(const ModelParams& params, Entity* root_entity)
 	{
+        ResourceCache* resource_cache   = m_context->GetSubsystem<ResourceCache>();
+        Animator* animator              = nullptr;
+
 		for (uint32_t i = 0; i < params.scene->mNumAnimations; i++)
 		{
 			const auto assimp_animation = params.scene->mAnimations[i];
-			auto animation = make_shared<Animation>(m_context);
-
-			// Basic properties
-			animation->SetName(assimp_animation->mName.C_Str());
-			animation->SetDuration(assimp_animation->mDuration);
-			animation->SetTicksPerSec(assimp_animation->mTicksPerSecond != 0.0f ? assimp_animation->mTicksPerSecond : 25.0f);
 
 			// Animation channels
+            vector<AnimationNode> animation_nodes(assimp_animation->mNumChannels);
 			for (uint32_t j = 0; j < static_cast<uint32_t>(assimp_animation->mNumChannels); j++)
 			{
 				const auto assimp_node_anim = assimp_animation->mChannels[j];
-				AnimationNode animation_node;
+				AnimationNode& animation_node = animation_nodes[j];
 
 				animation_node.name = assimp_node_anim->mNodeName.C_Str();
 
@@ -247,7 +302,7 @@ namespace Spartan
 				// Rotation keys
 				for (uint32_t k = 0; k < static_cast<uint32_t>(assimp_node_anim->mNumRotationKeys); k++)
 				{
-					const auto time = assimp_node_anim->mPositionKeys[k].mTime;
+					const auto time = assimp_node_anim->mRotationKeys[k].mTime;
 					const auto value = AssimpHelper::to_quaternion(assimp_node_anim->mRotationKeys[k].mValue);
 
 					animation_node.rotationFrames.emplace_back(KeyQuaternion{ time, value });
@@ -256,28 +311,120 @@ namespace Spartan
 				// Scaling keys
 				for (uint32_t k = 0; k < static_cast<uint32_t>(assimp_node_anim->mNumScalingKeys); k++)
 				{
-					const auto time = assimp_node_anim->mPositionKeys[k].mTime;
+					const auto time = assimp_node_anim->mScalingKeys[k].mTime;
 					const auto value = AssimpHelper::to_vector3(assimp_node_anim->mScalingKeys[k].mValue);
 
 					animation_node.scaleFrames.emplace_back(KeyVector{ time, value });
 				}
 			}
+
+            // Resampled and compressed, the imported keys aren't kept
+            auto animation = make_shared<Animation>(m_context);
+            animation->SetChannels(animation_nodes, assimp_animation->mDuration, assimp_animation->mTicksPerSecond);
+
+            // Saved next to the model, unnamed clips are named after it
+            const string name = assimp_animation->mName.length != 0 ? assimp_animation->mName.C_Str() : params.name + "_animation_" + to_string(i);
+            animation->SetResourceFilePath(FileSystem::RemoveIllegalCharacters(FileSystem::GetDirectoryFromFilePath(params.file_path) + name + EXTENSION_ANIMATION));
+            animation = resource_cache->Cache(animation);
+
+            // The first clip plays on the root
+            if (!animator && animation && root_entity)
+            {
+                animator = root_entity->AddComponent<Animator>();
+                animator->SetAnimation(animation);
+            }
 		}
 	}
 
-	void ModelImporter::LoadMesh(aiMesh* assimp_mesh, Entity* entity_parent, const ModelParams& params)
+    void ModelImporter::LoadMeshes(const ModelParams& params) const
+    {
+        params.meshes->resize(params.scene->mNumMeshes);
+
+        // Meshes vary a lot in size, so threads claim them one at a time
+        m_context->GetSubsystem<Threading>()->ParallelFor([&params](const uint32_t start, const uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                ConvertMesh(params.scene->mMeshes[i], params.optimize_meshes, &(*params.meshes)[i]);
+            }
+        }, params.scene->mNumMeshes, 1);
+    }
+
+	void ModelImporter::LoadMesh(const uint32_t mesh_index, Entity* entity_parent, const ModelParams& params)
 	{
-		if (!assimp_mesh || !entity_parent)
+		if (!entity_parent || mesh_index >= params.meshes->size())
 		{
 			LOG_ERROR_INVALID_PARAMETER();
 			return;
 		}
 
+        ModelMesh& mesh = (*params.meshes)[mesh_index];
+        if (mesh.indices.empty() || mesh.vertices.empty())
+        {
+            LOG_WARNING("Mesh %d of \"%s\" has no geometry", mesh_index, params.name.c_str());
+            return;
+        }
+
+		// Add the mesh to the model
+        if (!mesh.is_appended)
+        {
+            params.model->AppendGeometry(mesh.indices, mesh.vertices, &mesh.index_offset, &mesh.vertex_offset, mesh.skin.empty() ? nullptr : &mesh.skin);
+            for (const auto& lod : mesh.lods)
+            {
+                params.model->AppendGeometry(lod.first, {}, &mesh.lod_index_offsets.emplace_back(), nullptr);
+            }
+            mesh.is_appended = true;
+        }
+
+		// Add a renderable component to this entity
+		auto renderable	= entity_parent->AddComponent<Renderable>();
+
+		// Set the geometry
+		renderable->GeometrySet(
+			entity_parent->GetName(),
+			mesh.index_offset,
+			static_cast<uint32_t>(mesh.indices.size()),
+			mesh.vertex_offset,
+			static_cast<uint32_t>(mesh.vertices.size()),
+			mesh.aabb,
+            params.model
+		);
+
+        // Levels of detail, they index the vertices of the full geometry, so they only take index buffer space
+        for (uint32_t i = 0; i < static_cast<uint32_t>(mesh.lods.size()); i++)
+        {
+            renderable->GeometryLodAdd(mesh.lod_index_offsets[i], static_cast<uint32_t>(mesh.lods[i].first.size()), mesh.lods[i].second);
+        }
+
+        // Meshlets, ranges of the full geometry's indices
+        for (Geometry_Meshlet meshlet : mesh.meshlets)
+        {
+            meshlet.index_offset += mesh.index_offset;
+            renderable->GeometryMeshletAdd(meshlet);
+        }
+
+		// Material
+        const uint32_t material_index = params.scene->mMeshes[mesh_index]->mMaterialIndex;
+		if (material_index < params.materials->size() && (*params.materials)[material_index])
+		{
+            params.model->AddMaterial((*params.materials)[material_index], entity_parent->GetPtrShared());
+		}
+
+		// Bones, the vertices refer to them by their index
+        for (const auto& bone : mesh.bones)
+        {
+            renderable->GeometryBoneAdd(bone.first, bone.second);
+        }
+	}
+
+    void ModelImporter::ConvertMesh(const aiMesh* assimp_mesh, const bool optimize, ModelMesh* mesh)
+    {
         const uint32_t vertex_count = assimp_mesh->mNumVertices;
         const uint32_t index_count  = assimp_mesh->mNumFaces * 3;
 
 		// Vertices
-        vector<RHI_Vertex_PosTexNorTan> vertices = vector<RHI_Vertex_PosTexNorTan>(vertex_count);
+        vector<RHI_Vertex_PosTexNorTan>& vertices = mesh->vertices;
+        vertices.resize(vertex_count);
 		{
 			for (uint32_t i = 0; i < vertex_count; i++)
 			{
@@ -318,8 +465,69 @@ namespace Spartan
 			}
 		}
 
+		// Skin, every vertex keeps its heaviest bones. Bones past what a draw can follow are left out, the meshes are split before that happens (see AI_CONFIG_PP_SBBC_MAX_BONES).
+		if (assimp_mesh->HasBones())
+		{
+			const uint32_t bone_count = Helper::Min(assimp_mesh->mNumBones, rhi_max_skin_bones);
+			if (bone_count < assimp_mesh->mNumBones)
+			{
+				LOG_WARNING("\"%s\" has %d bones, only the first %d of them are followed", assimp_mesh->mName.C_Str(), assimp_mesh->mNumBones, rhi_max_skin_bones);
+			}
+
+			vector<array<pair<float, uint32_t>, 4>> influences(vertex_count);
+			for (uint32_t bone_index = 0; bone_index < bone_count; bone_index++)
+			{
+				const aiBone* bone = assimp_mesh->mBones[bone_index];
+				mesh->bones.emplace_back(bone->mName.C_Str(), AssimpHelper::ai_matrix4_x4_to_matrix(bone->mOffsetMatrix));
+
+				for (uint32_t i = 0; i < bone->mNumWeights; i++)
+				{
+					const aiVertexWeight& weight = bone->mWeights[i];
+					if (weight.mVertexId >= vertex_count)
+						continue;
+
+					// Replace the lightest influence, if this one is heavier
+					auto& vertex_influences	= influences[weight.mVertexId];
+					auto lightest			= min_element(vertex_influences.begin(), vertex_influences.end());
+					if (weight.mWeight > lightest->first)
+					{
+						*lightest = { weight.mWeight, bone_index };
+					}
+				}
+			}
+
+			// Quantize the weights so that they add up to 255, the heaviest one takes what rounding left over
+			mesh->skin.resize(vertex_count);
+			for (uint32_t i = 0; i < vertex_count; i++)
+			{
+				const auto& vertex_influences = influences[i];
+
+				float weight_sum = 0.0f;
+				for (const auto& influence : vertex_influences)
+				{
+					weight_sum += influence.first;
+				}
+
+				if (weight_sum <= 0.0f)
+					continue;
+
+				RHI_Vertex_Skin& skin		= mesh->skin[i];
+				uint32_t weight_total		= 0;
+				uint32_t heaviest			= 0;
+				for (uint32_t j = 0; j < 4; j++)
+				{
+					skin.bones[j]	= static_cast<uint8_t>(vertex_influences[j].second);
+					skin.weights[j]	= static_cast<uint8_t>(vertex_influences[j].first / weight_sum * 255.0f + 0.5f);
+					weight_total	+= skin.weights[j];
+					heaviest		= vertex_influences[j].first > vertex_influences[heaviest].first ? j : heaviest;
+				}
+				skin.weights[heaviest] = static_cast<uint8_t>(static_cast<int32_t>(skin.weights[heaviest]) + 255 - static_cast<int32_t>(weight_total));
+			}
+		}
+
 		// Indices
-		vector<uint32_t> indices = vector<uint32_t>(index_count);
+		vector<uint32_t>& indices = mesh->indices;
+        indices.resize(index_count);
 		{
 			// Get indices by iterating through each face of the mesh.
 			for (uint32_t face_index = 0; face_index < assimp_mesh->mNumFaces; face_index++)
@@ -333,83 +541,227 @@ namespace Spartan
 			}
 		}
 
-		// Compute AABB (before doing move operation on vertices)
-		const auto aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
+        // Reorder the triangles for the post-transform vertex cache and then (in clusters which keep that order) for less overdraw,
+        // the vertices follow the order which the triangles first use them in, so their fetches walk memory forwards.
+        if (optimize)
+        {
+            Utility::Geometry::OptimizeVertexCache(&indices, vertex_count);
+            Utility::Geometry::OptimizeOverdraw(vertices, &indices);
+            Utility::Geometry::OptimizeVertexFetch(&vertices, &indices, mesh->skin.empty() ? nullptr : &mesh->skin);
+        }
 
-		// Add the mesh to the model
-		uint32_t index_offset;
-		uint32_t vertex_offset;
-        params.model->AppendGeometry(move(indices), move(vertices), &index_offset, &vertex_offset);
+		// Compute AABB
+		mesh->aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
 
-		// Add a renderable component to this entity
-		auto renderable	= entity_parent->AddComponent<Renderable>();
+        // Meshlets, after the triangles have their final order
+        BuildMeshlets(mesh);
 
-		// Set the geometry
-		renderable->GeometrySet(
-			entity_parent->GetName(),
-			index_offset,
-			static_cast<uint32_t>(indices.size()),
-			vertex_offset,
-			static_cast<uint32_t>(vertices.size()),
-			aabb,
-            params.model
-		);
+        // Levels of detail, each one is simplified from the full geometry and indexes its vertices
+        {
+            constexpr uint32_t lod_count_max        = 4;    // including the full geometry
+            constexpr uint32_t lod_grid_size        = 64;   // cells per axis of the first simplification, every level after it halves them
+            constexpr uint32_t lod_triangle_min     = 64;   // geometry this small isn't worth simplifying further
+            constexpr float lod_reduction_min       = 0.7f; // a level has to have at most this fraction of the previous level's triangles
+
+            vector<uint32_t> indices_lod;
+            uint32_t triangle_count = static_cast<uint32_t>(indices.size()) / 3;
+            for (uint32_t grid_size = lod_grid_size; grid_size >= 2 && mesh->lods.size() + 1 < lod_count_max && triangle_count > lod_triangle_min; grid_size /= 2)
+            {
+                Utility::Geometry::Simplify(vertices, indices, mesh->aabb, grid_size, &indices_lod);
+                const uint32_t triangle_count_lod = static_cast<uint32_t>(indices_lod.size()) / 3;
+                if (triangle_count_lod == 0)
+                    break;
 
-		// Material
-		if (params.scene->HasMaterials())
-		{
-			// Get aiMaterial
-			const auto assimp_material = params.scene->mMaterials[assimp_mesh->mMaterialIndex];
-			// Convert it and add it to the model
-            shared_ptr<Material> material = LoadMaterial(assimp_material, params);
-            params.model->AddMaterial(material, entity_parent->GetPtrShared());
-		}
+                if (triangle_count_lod > triangle_count * lod_reduction_min)
+                    continue;
 
-		// Bones
-        LoadBones(assimp_mesh, params);
-	}
+                if (optimize)
+                {
+                    Utility::Geometry::OptimizeVertexCache(&indices_lod, static_cast<uint32_t>(vertices.size()));
+                }
+
+                mesh->lods.emplace_back(indices_lod, 1.0f / grid_size);
+                triangle_count = triangle_count_lod;
+            }
+        }
+    }
 
-    void ModelImporter::LoadBones(const aiMesh* assimp_mesh, const ModelParams& params)
+    void ModelImporter::BuildMeshlets(ModelMesh* mesh)
     {
-        // Maximum number of bones per mesh
-        // Must not be higher than same const in skinning shader
-        constexpr uint8_t MAX_BONES = 64;
-        // Maximum number of bones per vertex
-        constexpr uint8_t MAX_BONES_PER_VERTEX = 4;
-
-        //for (uint32_t i = 0; i < assimp_mesh->mNumBones; i++)
-        //{
-        //    uint32_t index = 0;
-
-        //    assert(assimp_mesh->mNumBones <= MAX_BONES);
-
-        //    string name = assimp_mesh->mBones[i]->mName.data;
-
-        //    if (boneMapping.find(name) == boneMapping.end())
-        //    {
-        //        // Bone not present, add new one
-        //        index = numBones;
-        //        numBones++;
-        //        BoneInfo bone;
-        //        boneInfo.push_back(bone);
-        //        boneInfo[index].offset = pMesh->mBones[i]->mOffsetMatrix;
-        //        boneMapping[name] = index;
-        //    }
-        //    else
-        //    {
-        //        index = boneMapping[name];
-        //    }
-
-        //    for (uint32_t j = 0; j < assimp_mesh->mBones[i]->mNumWeights; j++)
-        //    {
-        //        uint32_t vertexID = vertexOffset + pMesh->mBones[i]->mWeights[j].mVertexId;
-        //        Bones[vertexID].add(index, pMesh->mBones[i]->mWeights[j].mWeight);
-        //    }
-        //}
-        //boneTransforms.resize(numBones);
+        constexpr uint32_t meshlet_vertex_max   = 64;
+        constexpr uint32_t meshlet_triangle_max = 124;
+
+        const vector<RHI_Vertex_PosTexNorTan>& vertices = mesh->vertices;
+        const vector<uint32_t>& indices                 = mesh->indices;
+        const uint32_t triangle_count                   = static_cast<uint32_t>(indices.size()) / 3;
+
+        // Geometry which fits in a single meshlet is culled as a whole anyway
+        mesh->meshlets.clear();
+        if (triangle_count <= meshlet_triangle_max)
+            return;
+
+        const auto position = [&vertices](const uint32_t index) { const float* pos = vertices[index].pos; return Vector3(pos[0], pos[1], pos[2]); };
+
+        // The bounding sphere and the normal cone of the triangles of a meshlet
+        vector<uint32_t> meshlet_vertices;
+        vector<Vector3> meshlet_normals;
+        auto meshlet_add = [&](const uint32_t triangle_start, const uint32_t triangle_end)
+        {
+            Geometry_Meshlet& meshlet   = mesh->meshlets.emplace_back();
+            meshlet.index_offset        = triangle_start * 3;
+            meshlet.index_count         = (triangle_end - triangle_start) * 3;
+
+            Vector3 min = Vector3::Infinity;
+            Vector3 max = Vector3::InfinityNeg;
+            for (const uint32_t index : meshlet_vertices)
+            {
+                const Vector3 pos = position(index);
+                min = Vector3(Helper::Min(min.x, pos.x), Helper::Min(min.y, pos.y), Helper::Min(min.z, pos.z));
+                max = Vector3(Helper::Max(max.x, pos.x), Helper::Max(max.y, pos.y), Helper::Max(max.z, pos.z));
+            }
+            meshlet.center = (min + max) * 0.5f;
+            for (const uint32_t index : meshlet_vertices)
+            {
+                meshlet.radius = Helper::Max(meshlet.radius, Vector3::Distance(meshlet.center, position(index)));
+            }
+
+            // The normals of the triangles as they are wound, degenerate triangles face nowhere
+            meshlet_normals.clear();
+            for (uint32_t triangle = triangle_start; triangle < triangle_end; triangle++)
+            {
+                const Vector3 p0        = position(indices[triangle * 3]);
+                const Vector3 normal    = Vector3::Cross(position(indices[triangle * 3 + 1]) - p0, position(indices[triangle * 3 + 2]) - p0);
+                const float length      = normal.Length();
+                if (length > Helper::M_EPSILON)
+                {
+                    meshlet_normals.emplace_back(normal / length);
+                    meshlet.cone_axis += meshlet_normals.back();
+                }
+            }
+
+            // The cone is as wide as the normal furthest from its axis, past a right angle the meshlet always has a triangle facing the viewer
+            const float axis_length = meshlet.cone_axis.Length();
+            if (axis_length <= Helper::M_EPSILON)
+                return;
+
+            meshlet.cone_axis = meshlet.cone_axis / axis_length;
+            float dot_min = 1.0f;
+            for (const Vector3& normal : meshlet_normals)
+            {
+                dot_min = Helper::Min(dot_min, Vector3::Dot(meshlet.cone_axis, normal));
+            }
+            meshlet.cone_cutoff = dot_min <= 0.1f ? 1.0f : Helper::Sqrt(1.0f - dot_min * dot_min);
+        };
+
+        // The triangles keep their order (which the vertex cache optimization keeps local), a meshlet ends where the next triangle would take it past either limit
+        uint32_t triangle_start = 0;
+        meshlet_vertices.reserve(meshlet_vertex_max);
+        for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+        {
+            uint32_t triangle_vertices[3];
+            uint32_t triangle_vertex_count = 0;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const uint32_t index = indices[triangle * 3 + i];
+                if (find(meshlet_vertices.begin(), meshlet_vertices.end(), index) == meshlet_vertices.end() && find(triangle_vertices, triangle_vertices + triangle_vertex_count, index) == triangle_vertices + triangle_vertex_count)
+                {
+                    triangle_vertices[triangle_vertex_count++] = index;
+                }
+            }
+
+            if (triangle - triangle_start == meshlet_triangle_max || meshlet_vertices.size() + triangle_vertex_count > meshlet_vertex_max)
+            {
+                meshlet_add(triangle_start, triangle);
+                triangle_start = triangle;
+                meshlet_vertices.clear();
+
+                // Starting over, every vertex of the triangle is new
+                triangle_vertex_count = 0;
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    const uint32_t index = indices[triangle * 3 + i];
+                    if (find(triangle_vertices, triangle_vertices + triangle_vertex_count, index) == triangle_vertices + triangle_vertex_count)
+                    {
+                        triangle_vertices[triangle_vertex_count++] = index;
+                    }
+                }
+            }
+
+            meshlet_vertices.insert(meshlet_vertices.end(), triangle_vertices, triangle_vertices + triangle_vertex_count);
+        }
+        meshlet_add(triangle_start, triangle_count);
     }
 
-    shared_ptr<Material> ModelImporter::LoadMaterial(aiMaterial* assimp_material, const ModelParams& params)
+    void ModelImporter::LoadMaterials(const ModelParams& params)
+    {
+        if (!params.scene->HasMaterials())
+            return;
+
+        // The materials which the meshes use, along with the textures of their slots
+        params.materials->resize(params.scene->mNumMaterials);
+        vector<vector<pair<Material_Property, string>>> material_textures(params.scene->mNumMaterials);
+        for (uint32_t i = 0; i < params.scene->mNumMeshes; i++)
+        {
+            const uint32_t material_index = params.scene->mMeshes[i]->mMaterialIndex;
+            if (material_index < params.scene->mNumMaterials && !(*params.materials)[material_index])
+            {
+                (*params.materials)[material_index] = LoadMaterial(params.scene->mMaterials[material_index], params, &material_textures[material_index]);
+            }
+        }
+
+        // Every texture is loaded once, in parallel (reading, decoding, mipmapping and compressing are all done per texture)
+        unordered_map<string, shared_ptr<RHI_Texture2D>> textures;
+        vector<pair<Material_Property, string>> textures_to_load;
+        for (const auto& bindings : material_textures)
+        {
+            for (const auto& binding : bindings)
+            {
+                if (textures.emplace(binding.second, nullptr).second)
+                {
+                    textures_to_load.emplace_back(binding);
+                }
+            }
+        }
+
+        vector<shared_ptr<RHI_Texture2D>> textures_loaded(textures_to_load.size());
+        m_context->GetSubsystem<Threading>()->ParallelFor([&params, &textures_to_load, &textures_loaded](const uint32_t start, const uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                textures_loaded[i] = params.model->LoadTexture(textures_to_load[i].first, textures_to_load[i].second);
+            }
+        }, static_cast<uint32_t>(textures_to_load.size()), 1);
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(textures_to_load.size()); i++)
+        {
+            textures[textures_to_load[i].second] = textures_loaded[i];
+        }
+
+        // Set the texture slots
+        for (uint32_t material_index = 0; material_index < params.scene->mNumMaterials; material_index++)
+        {
+            const shared_ptr<Material>& material = (*params.materials)[material_index];
+            for (const auto& binding : material_textures[material_index])
+            {
+                const shared_ptr<RHI_Texture2D>& texture = textures[binding.second];
+                if (!texture)
+                {
+                    LOG_ERROR("Failed to get texture");
+                    continue;
+                }
+
+                // Some models (or Assimp) pass a normal map as a height map
+                // auto textureType others pass a height map as a normal map, we try to fix that.
+                auto proper_type = binding.first;
+                proper_type = (proper_type == Material_Normal && texture->GetGrayscale()) ? Material_Height : proper_type;
+                proper_type = (proper_type == Material_Height && !texture->GetGrayscale()) ? Material_Normal : proper_type;
+
+                material->SetTextureSlot(proper_type, texture);
+            }
+        }
+    }
+
+    shared_ptr<Material> ModelImporter::LoadMaterial(aiMaterial* assimp_material, const ModelParams& params, vector<pair<Material_Property, string>>* textures)
 	{
 		if (!assimp_material)
 		{
@@ -435,8 +787,8 @@ namespace Spartan
 
 		material->SetColorAlbedo(Vector4(color_diffuse.r, color_diffuse.g, color_diffuse.b, opacity.r));
 
-		// TEXTURES
-		const auto load_mat_tex = [&params, &assimp_material, &material](const Material_Property type_spartan, const aiTextureType type_assimp_pbr, const aiTextureType type_assimp_legacy)
+		// TEXTURES (they are loaded by LoadMaterials(), all at once)
+		const auto load_mat_tex = [&params, &assimp_material, &material, &textures](const Material_Property type_spartan, const aiTextureType type_assimp_pbr, const aiTextureType type_assimp_legacy)
 		{
             aiTextureType type_assimp   = assimp_material->GetTextureCount(type_assimp_pbr)     > 0 ? type_assimp_pbr       : aiTextureType_NONE;
             type_assimp                 = assimp_material->GetTextureCount(type_assimp_legacy)  > 0 ? type_assimp_legacy    : type_assimp;
@@ -449,35 +801,13 @@ namespace Spartan
 					const auto deduced_path = AssimpHelper::texture_validate_path(texture_path.data, params.file_path);
 					if (FileSystem::IsSupportedImageFile(deduced_path))
 					{
-                        params.model->AddTexture(material, type_spartan, AssimpHelper::texture_validate_path(texture_path.data, params.file_path));
+                        textures->emplace_back(type_spartan, deduced_path);
 
 						if (type_assimp == aiTextureType_BASE_COLOR || type_assimp == aiTextureType_DIFFUSE)
 						{
 							// FIX: materials that have a diffuse texture should not be tinted black/gray
 							material->SetColorAlbedo(Vector4::One);
 						}
-
-						// Some models (or Assimp) pass a normal map as a height map
-						// auto textureType others pass a height map as a normal map, we try to fix that.
-						if (type_spartan == Material_Normal || type_spartan == Material_Height)
-						{
-                            if (const auto texture = material->GetTexture_PtrShared(type_spartan))
-                            {
-                                auto proper_type = type_spartan;
-                                proper_type = (proper_type == Material_Normal && texture->GetGrayscale()) ? Material_Height : proper_type;
-                                proper_type = (proper_type == Material_Height && !texture->GetGrayscale()) ? Material_Normal : proper_type;
-
-                                if (proper_type != type_spartan)
-                                {
-                                    material->SetTextureSlot(type_spartan, shared_ptr<RHI_Texture>());
-                                    material->SetTextureSlot(proper_type, texture);
-                                }
-                            }
-                            else
-                            {
-                                LOG_ERROR("Failed to get texture");
-                            }
-						}
 					}
 				}
 			}
@@ -25,6 +25,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Core/EngineDefs.h"
 #include <memory>
 #include <string>
+#include <vector>
+#include "../../Math/BoundingBox.h"
+#include "../../RHI/RHI_Vertex.h"
+#include "../../World/Components/Renderable.h"
 //================================
 
 struct aiNode;
@@ -39,6 +43,25 @@ namespace Spartan
 	class Entity;
 	class Model;
 	class World;
+	enum Material_Property : uint16_t;
+
+    // A mesh of the scene, converted (and simplified into levels of detail) before any entity refers to it
+    struct ModelMesh
+    {
+        std::vector<RHI_Vertex_PosTexNorTan> vertices;
+        std::vector<RHI_Vertex_Skin> skin;                          // empty, unless the mesh has bones
+        std::vector<std::pair<std::string, Math::Matrix>> bones;    // the name and offset matrix of the bones which the skin refers to
+        std::vector<uint32_t> indices;
+        Math::BoundingBox aabb;
+        std::vector<std::pair<std::vector<uint32_t>, float>> lods; // the indices and the error of every level
+        std::vector<Geometry_Meshlet> meshlets;                     // of the full geometry, their index offsets are relative to its indices
+
+        // Where the geometry went in the model, a mesh which more than one node refers to is only appended once
+        bool is_appended        = false;
+        uint32_t index_offset   = 0;
+        uint32_t vertex_offset  = 0;
+        std::vector<uint32_t> lod_index_offsets;
+    };
 
     struct ModelParams
     {
@@ -46,11 +69,14 @@ namespace Spartan
         uint32_t vertex_limit;
         float max_normal_smoothing_angle;
         float max_tangent_smoothing_angle;
+        bool optimize_meshes; // reorder triangles and vertices for the vertex cache, overdraw and vertex fetch
         std::string file_path;
         std::string name;
         bool has_animation;
         Model* model            = nullptr;
         const aiScene* scene    = nullptr;
+        std::vector<ModelMesh>* meshes                      = nullptr; // by the scene's mesh index
+        std::vector<std::shared_ptr<Material>>* materials   = nullptr; // by the scene's material index
     };
 
 	class SPARTAN_CLASS ModelImporter
@@ -65,12 +91,15 @@ namespace Spartan
         // Parsing
 		void ParseNode(const aiNode* assimp_node, const ModelParams& params, Entity* parent_node = nullptr, Entity* new_entity = nullptr);
         void ParseNodeMeshes(const aiNode* assimp_node, Entity* new_entity, const ModelParams& params);
-        void ParseAnimations(const ModelParams& params);
+        void ParseAnimations(const ModelParams& params, Entity* root_entity);
 
         // Loading
-		void LoadMesh(aiMesh* assimp_mesh, Entity* entity_parent, const ModelParams& params);
-        void LoadBones(const aiMesh* assimp_mesh, const ModelParams& params);
-		std::shared_ptr<Material> LoadMaterial(aiMaterial* assimp_material, const ModelParams& params);
+        void LoadMeshes(const ModelParams& params) const;
+		void LoadMesh(uint32_t mesh_index, Entity* entity_parent, const ModelParams& params);
+        void LoadMaterials(const ModelParams& params);
+		std::shared_ptr<Material> LoadMaterial(aiMaterial* assimp_material, const ModelParams& params, std::vector<std::pair<Material_Property, std::string>>* textures);
+        static void ConvertMesh(const aiMesh* assimp_mesh, bool optimize, ModelMesh* mesh);
+        static void BuildMeshlets(ModelMesh* mesh);
 
         // Dependencies
 		Context* m_context;
@@ -32,6 +32,7 @@ namespace Spartan
 	static int g_progress_model_importer	= 0;
 	static int g_progress_world				= 1;
 	static int g_progress_resource_cache	= 2;
+	static int g_progress_shaders			= 3;
 
 	struct Progress
 	{
@@ -25,13 +25,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Import/ImageImporter.h"
 #include "Import/ModelImporter.h"
 #include "Import/FontImporter.h"
+#include "Import/DerivedDataCache.h"
 #include "../World/World.h"
 #include "../World/Entity.h"
+#include "../World/Prefab.h"
 #include "../IO/FileStream.h"
+#include "../IO/Archive.h"
+#include "../IO/FileIO.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
 #include "../Audio/AudioClip.h"
 #include "../Rendering/Model.h"
+#include "../Rendering/Animation.h"
+#include "../Threading/Threading.h"
+#include "../Math/MathHelper.h"
 //=================================
 
 //= NAMESPACES ================
@@ -39,6 +46,15 @@ using namespace std;
 using namespace Spartan::Math;
 //=============================
 
+namespace _ResourceCache
+{
+	// How often (in seconds) the memory budgets are checked
+	static const float eviction_interval = 1.0f;
+
+	static const uint64_t budget_textures	= 2048ull * 1024 * 1024;
+	static const uint64_t budget_models		= 1024ull * 1024 * 1024;
+}
+
 namespace Spartan
 {
 	ResourceCache::ResourceCache(Context* context) : ISubsystem(context)
@@ -57,6 +73,19 @@ namespace Spartan
 		// Create project directory
 		SetProjectDirectory("Project/");
 
+		// Memory budgets, for the types which can grow big
+		SetMemoryBudget(Resource_Texture2d,	_ResourceCache::budget_textures);
+		SetMemoryBudget(Resource_Model,		_ResourceCache::budget_models);
+
+		// Mount the archives which are next to the executable, the engine files in them are read instead of the loose ones
+		for (const string& file_path : FileSystem::GetFilesInDirectory(FileSystem::GetWorkingDirectory()))
+		{
+			if (FileSystem::GetExtensionFromFilePath(file_path) == EXTENSION_ARCHIVE)
+			{
+				Archive::Mount(file_path);
+			}
+		}
+
 		// Subscribe to events
 		SUBSCRIBE_TO_EVENT(Event_World_Save,	EVENT_HANDLER(SaveResourcesToFiles));
 		SUBSCRIBE_TO_EVENT(Event_World_Load,	EVENT_HANDLER(LoadResourcesFromFiles));
@@ -68,6 +97,224 @@ namespace Spartan
 		// Unsubscribe from event
 		UNSUBSCRIBE_FROM_EVENT(Event_World_Unload, EVENT_HANDLER(Clear));
 		Clear();
+
+		// The reads ahead complete into this cache, the requests they were for are gone so they start no loads
+		if (FileIO* file_io = m_context->GetSubsystem<FileIO>())
+		{
+			file_io->WaitIdle();
+		}
+		while (m_load_reads.load() != 0)
+		{
+			this_thread::yield();
+		}
+
+		// The loads which already started finish, they run on resources this cache owns
+		vector<shared_ptr<Task>> load_tasks;
+		{
+			lock_guard<mutex> lock(m_load_mutex);
+			load_tasks.swap(m_load_tasks);
+		}
+		m_context->GetSubsystem<Threading>()->Wait(load_tasks);
+
+		Archive::UnmountAll();
+	}
+
+	void ResourceCache::Clear()
+	{
+		{
+			lock_guard<mutex> lock(m_load_mutex);
+			for (LoadRequest& request : m_load_requests)
+			{
+				request.resource->SetLoadState(LoadState_Failed);
+				m_loads_pending.erase(request.file_path);
+			}
+			m_load_requests.clear();
+		}
+
+		lock_guard<mutex> guard(m_mutex);
+		m_resource_groups.clear();
+		m_resource_names.clear();
+		m_resource_paths.clear();
+		m_resources_evicted.clear();
+	}
+
+	void ResourceCache::CacheAdd(const shared_ptr<IResource>& resource)
+	{
+		const Resource_Type type = resource->GetResourceType();
+		m_resource_groups[type].emplace_back(resource);
+		m_resource_names[type][resource->GetResourceNameId()] = resource;
+		m_resources_evicted[type].erase(resource->GetResourceNameId());
+		if (resource->HasFilePathNative())
+		{
+			m_resource_paths[type][resource->GetResourceFilePathNativeId()] = resource;
+		}
+	}
+
+	void ResourceCache::CacheRemove(const IResource* resource)
+	{
+		const Resource_Type type = resource->GetResourceType();
+
+		auto& names = m_resource_names[type];
+		const auto it_name = names.find(resource->GetResourceNameId());
+		if (it_name != names.end() && it_name->second.get() == resource)
+		{
+			names.erase(it_name);
+		}
+
+		auto& paths = m_resource_paths[type];
+		const auto it_path = paths.find(resource->GetResourceFilePathNativeId());
+		if (it_path != paths.end() && it_path->second.get() == resource)
+		{
+			paths.erase(it_path);
+		}
+
+		auto& group = m_resource_groups[type];
+		const auto it = find_if(group.begin(), group.end(), [resource](const shared_ptr<IResource>& cached) { return cached.get() == resource; });
+		if (it != group.end())
+		{
+			group.erase(it);
+		}
+	}
+
+	bool ResourceCache::IsLoading(const IResource* resource)
+	{
+		lock_guard<mutex> lock(m_load_mutex);
+		for (const auto& pending : m_loads_pending)
+		{
+			if (pending.second.get() == resource)
+				return true;
+		}
+
+		return false;
+	}
+
+	shared_ptr<IResource> ResourceCache::LoadAsyncFind(const string& file_path, const float priority)
+	{
+		const auto it = m_loads_pending.find(file_path);
+		if (it == m_loads_pending.end())
+			return nullptr;
+
+		// Raise the priority of a request which hasn't started yet
+		for (LoadRequest& request : m_load_requests)
+		{
+			if (request.file_path == file_path)
+			{
+				request.priority = Helper::Max(request.priority, priority);
+				break;
+			}
+		}
+
+		return it->second;
+	}
+
+	void ResourceCache::LoadAsyncQueue(const string& file_path, const float priority, const shared_ptr<IResource>& resource, function<bool()>&& load)
+	{
+		LoadRequest& request	= m_load_requests.emplace_back();
+		request.file_path		= file_path;
+		request.priority		= priority;
+		request.order			= m_load_order++;
+		request.resource		= resource;
+		request.load			= move(load);
+		m_loads_pending[file_path] = resource;
+
+		// Engine files are read ahead by the I/O thread, so the worker which loads them doesn't wait on the disk (packed files are in memory already)
+		FileIO* file_io			= m_context->GetSubsystem<FileIO>();
+		const bool read_ahead	= file_io && FileSystem::IsEngineFile(file_path) && !Archive::Exists(file_path);
+		if (!read_ahead)
+		{
+			LoadAsyncSchedule();
+			return;
+		}
+
+		request.read = false;
+		m_load_reads++;
+		file_io->ReadAsync(file_path, [this, file_path](bool success, vector<std::byte>& data)
+		{
+			{
+				lock_guard<mutex> lock(m_load_mutex);
+				for (LoadRequest& request : m_load_requests)
+				{
+					if (request.file_path == file_path && !request.read)
+					{
+						// A failed read leaves the load to go to the disk itself, and report why
+						if (success)
+						{
+							request.data = move(data);
+						}
+						request.read = true;
+						LoadAsyncSchedule();
+						break;
+					}
+				}
+			}
+
+			m_load_reads--;
+		});
+	}
+
+	void ResourceCache::LoadAsyncSchedule()
+	{
+		// Every task loads whichever request (which was read) has the highest priority at the time it runs, so the tasks don't have to run in order
+		m_load_tasks.erase(remove_if(m_load_tasks.begin(), m_load_tasks.end(), [](const shared_ptr<Task>& task) { return task->IsDone(); }), m_load_tasks.end());
+		m_load_tasks.emplace_back(m_context->GetSubsystem<Threading>()->AddTask([this]() { LoadAsyncRun(); }, {}, Threading_Pool_Background));
+	}
+
+	void ResourceCache::LoadAsyncRun()
+	{
+		MemoryTagScope memory_tag(Memory_Tag_Resources);
+
+		LoadRequest request;
+		{
+			lock_guard<mutex> lock(m_load_mutex);
+			// Requests which are still being read go last, there is a task for each one which was read
+			const auto it = max_element(m_load_requests.begin(), m_load_requests.end(), [](const LoadRequest& a, const LoadRequest& b)
+			{
+				if (a.read != b.read)
+					return !a.read;
+
+				return a.priority < b.priority || (a.priority == b.priority && a.order > b.order);
+			});
+			if (it == m_load_requests.end() || !it->read) // dropped by Clear()
+				return;
+
+			request = move(*it);
+			m_load_requests.erase(it);
+		}
+
+		IResource* resource = request.resource.get();
+		resource->SetLoadState(LoadState_Started);
+		bool loaded = false;
+		if (!request.data.empty())
+		{
+			FileIO_Scope scope(request.file_path, request.data);
+			loaded = request.load();
+		}
+		else
+		{
+			loaded = request.load();
+		}
+		if (!loaded)
+		{
+			LOG_ERROR("Failed to load \"%s\".", request.file_path.c_str());
+		}
+
+		{
+			lock_guard<mutex> lock(m_load_mutex);
+			m_loads_pending.erase(request.file_path);
+		}
+
+		// Cache it, like Load() does, it can already be cached (without being saved) if something used the placeholder
+		if (loaded)
+		{
+			lock_guard<mutex> guard(m_mutex);
+			resource->SaveToFile(resource->GetResourceFilePathNative());
+			if (!m_resource_names[resource->GetResourceType()].count(resource->GetResourceNameId()))
+			{
+				CacheAdd(request.resource);
+			}
+		}
+
+		resource->SetLoadState(loaded ? LoadState_Completed : LoadState_Failed);
 	}
 
 	bool ResourceCache::Initialize()
@@ -76,36 +323,163 @@ namespace Spartan
 		m_importer_image	= make_shared<ImageImporter>(m_context);
 		m_importer_model	= make_shared<ModelImporter>(m_context);
 		m_importer_font		= make_shared<FontImporter>(m_context);
+
+		// What the importers derive from source files
+		m_derived_data_cache = make_shared<DerivedDataCache>(m_context);
+
 		return true;
 	}
 
-	bool ResourceCache::IsCached(const string& resource_name, const Resource_Type resource_type /*= Resource_Unknown*/)
+	bool ResourceCache::IsCached(const StringId resource_name, const Resource_Type resource_type /*= Resource_Unknown*/)
 	{
-		if (resource_name.empty())
+		if (resource_name.IsEmpty())
 		{
 			LOG_ERROR_INVALID_PARAMETER();
 			return false;
 		}
 
-		for (const auto& resource : m_resource_groups[resource_type])
+		// An evicted resource still counts, it loads again once it's requested
+		lock_guard<mutex> guard(m_mutex);
+		return m_resource_names[resource_type].count(resource_name) != 0 || m_resources_evicted[resource_type].count(resource_name) != 0;
+	}
+
+	shared_ptr<IResource>& ResourceCache::GetByName(const StringId name, const Resource_Type type)
+	{
+        static shared_ptr<IResource> empty;
+
+		for (uint32_t attempt = 0; attempt < 2; attempt++)
 		{
-			if (resource_name == resource->GetResourceName())
-				return true;
+			{
+				lock_guard<mutex> guard(m_mutex);
+				auto& names		= m_resource_names[type];
+				const auto it	= names.find(name);
+				if (it != names.end())
+				{
+					it->second->SetTimeUsed(m_time);
+					return it->second;
+				}
+			}
+
+			if (!ReloadEvicted(type, name))
+				break;
 		}
 
-		return false;
+		return empty;
+	}
+
+	void ResourceCache::Tick(const float delta_time)
+	{
+		m_time += delta_time;
+
+		if (m_time - m_time_evicted < _ResourceCache::eviction_interval)
+			return;
+		m_time_evicted = m_time;
+
+		for (const auto& budget : m_memory_budgets)
+		{
+			if (budget.second != 0)
+			{
+				Evict(budget.first, budget.second);
+			}
+		}
 	}
 
-	shared_ptr<IResource>& ResourceCache::GetByName(const string& name, const Resource_Type type)
+	void ResourceCache::Evict(const Resource_Type type, const uint64_t budget)
 	{
-		for (auto& resource : m_resource_groups[type])
+		lock_guard<mutex> guard(m_mutex);
+
+		// Only the types which can be created again
+		if (!m_resource_factories[type])
+			return;
+
+		auto& group = m_resource_groups[type];
+		auto& paths = m_resource_paths[type];
+		uint64_t size = 0;
+		vector<IResource*> candidates;
+		for (const shared_ptr<IResource>& resource : group)
 		{
-			if (name == resource->GetResourceName())
-				return resource;
+			size += resource->GetSizeCpu() + resource->GetSizeGpu();
+
+			// The cache holds a reference in the group, the name index and (with a native file path) the path index
+			const auto it_path	= paths.find(resource->GetResourceFilePathNativeId());
+			const long held		= (it_path != paths.end() && it_path->second == resource) ? 3 : 2;
+			if (resource.use_count() > held)
+			{
+				// A resource which something references is in use
+				resource->SetTimeUsed(m_time);
+			}
+			else if (resource->GetLoadState() != LoadState_Started && resource->HasFilePathNative())
+			{
+				candidates.emplace_back(resource.get());
+			}
 		}
 
-        static shared_ptr<IResource> empty;
-		return empty;
+		if (size <= budget)
+			return;
+
+		// Least recently used first
+		sort(candidates.begin(), candidates.end(), [](const IResource* a, const IResource* b) { return a->GetTimeUsed() < b->GetTimeUsed(); });
+
+		uint32_t evicted = 0;
+		for (IResource* resource : candidates)
+		{
+			if (size <= budget)
+				break;
+
+			if (IsLoading(resource))
+				continue;
+
+			size -= resource->GetSizeCpu() + resource->GetSizeGpu();
+
+			// Saved first, so that it loads again as it is
+			resource->SaveToFile(resource->GetResourceFilePathNative());
+			m_resources_evicted[type][resource->GetResourceNameId()] = resource->GetResourceFilePathNative();
+			CacheRemove(resource); // the last reference, the resource is released
+			evicted++;
+		}
+
+		if (evicted != 0)
+		{
+			LOG_INFO("Evicted %d resources to fit a budget of %d MB", evicted, static_cast<int>(budget / 1024 / 1024));
+		}
+	}
+
+	shared_ptr<IResource> ResourceCache::ReloadEvicted(const Resource_Type type, const StringId name)
+	{
+		string file_path;
+		function<shared_ptr<IResource>()> factory;
+		{
+			lock_guard<mutex> guard(m_mutex);
+			auto& evicted	= m_resources_evicted[type];
+			const auto it	= evicted.find(name);
+			if (it == evicted.end())
+				return nullptr;
+
+			file_path	= it->second;
+			factory		= m_resource_factories[type];
+			evicted.erase(it);
+		}
+
+		// Loaded without the lock, loading can request other resources (e.g. a material its textures)
+		MemoryTagScope memory_tag(Memory_Tag_Resources);
+		shared_ptr<IResource> resource = factory();
+		resource->SetResourceFilePath(file_path);
+		if (!resource->LoadFromFile(file_path))
+		{
+			LOG_ERROR("Failed to load \"%s\" again.", file_path.c_str());
+			return nullptr;
+		}
+		resource->SetTimeUsed(m_time);
+
+		// Something else could have loaded it in the meantime
+		lock_guard<mutex> guard(m_mutex);
+		auto& names = m_resource_names[type];
+		const auto it = names.find(name);
+		if (it != names.end())
+			return it->second;
+
+		CacheAdd(resource);
+		return resource;
 	}
 
 	vector<shared_ptr<IResource>> ResourceCache::GetByType(const Resource_Type type /*= Resource_Unknown*/)
@@ -211,6 +585,12 @@ namespace Spartan
 				break;
             case Resource_Audio:
                 Load<AudioClip>(file_path);
+                break;
+            case Resource_Prefab:
+                Load<Prefab>(file_path);
+                break;
+            case Resource_Animation:
+                Load<Animation>(file_path);
                 break;
 			}
 		}
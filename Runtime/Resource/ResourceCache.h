@@ -23,16 +23,21 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==================
 #include <unordered_map>
+#include <functional>
+#include <atomic>
 #include "IResource.h"
 #include "../Core/ISubsystem.h"
+#include "../Profiling/MemoryTracker.h"
 //=============================
 
 namespace Spartan
 {
     // Forward declarations
+    class DerivedDataCache;
     class FontImporter;
     class ImageImporter;
     class ModelImporter;
+    class Task;
 
 	enum Asset_Type
 	{
@@ -51,14 +56,15 @@ namespace Spartan
 		ResourceCache(Context* context);
 		~ResourceCache();
 
-		//= Subsystem =============
+		//= Subsystem ========================
 		bool Initialize() override;
-		//=========================
+		void Tick(float delta_time) override;
+		//====================================
 
         // Get by name
-		std::shared_ptr<IResource>& GetByName(const std::string& name, Resource_Type type);
+		std::shared_ptr<IResource>& GetByName(StringId name, Resource_Type type);
 		template <class T> 
-		constexpr std::shared_ptr<T> GetByName(const std::string& name) 
+		constexpr std::shared_ptr<T> GetByName(StringId name) 
 		{ 
 			return std::static_pointer_cast<T>(GetByName(name, IResource::TypeToEnum<T>()));
 		}
@@ -68,15 +74,20 @@ namespace Spartan
 
 		// Get by path
 		template <class T>
-		std::shared_ptr<T> GetByPath(const std::string& path)
+		std::shared_ptr<T> GetByPath(StringId path)
 		{
-			for (auto& resource : m_resource_groups[IResource::TypeToEnum<T>()])
 			{
-				if (path == resource->GetResourceFilePathNative())
-					return std::static_pointer_cast<T>(resource);
+				std::lock_guard<std::mutex> guard(m_mutex);
+				auto& paths		= m_resource_paths[IResource::TypeToEnum<T>()];
+				const auto it	= paths.find(path);
+				if (it != paths.end())
+				{
+					it->second->SetTimeUsed(m_time);
+					return std::static_pointer_cast<T>(it->second);
+				}
 			}
 
-            return nullptr;
+			return std::static_pointer_cast<T>(ReloadEvicted(IResource::TypeToEnum<T>(), FileSystem::GetFileNameNoExtensionFromFilePath(path.Get())));
 		}
 
 		// Caches resource, or replaces with existing cached resource
@@ -102,19 +113,23 @@ namespace Spartan
             }
 
 			// Ensure that this resource is not already cached
-			if (IsCached(resource->GetResourceName(), resource->GetResourceType()))
-				return GetByName<T>(resource->GetResourceName());
+			if (IsCached(resource->GetResourceNameId(), resource->GetResourceType()))
+				return GetByName<T>(resource->GetResourceNameId());
 
             // Prevent threads from colliding in critical section
-            std::lock_guard<mutex> guard(m_mutex);
+            std::lock_guard<std::mutex> guard(m_mutex);
 
-            // In order to guarantee deserialization, we save it now
-            resource->SaveToFile(resource->GetResourceFilePathNative());
+            // In order to guarantee deserialization, we save it now (a resource which is still loading is saved once it's loaded, see LoadAsync())
+            if (!IsLoading(resource.get()))
+            {
+                resource->SaveToFile(resource->GetResourceFilePathNative());
+            }
 
 			// Cache it
-			return static_pointer_cast<T>(m_resource_groups[resource->GetResourceType()].emplace_back(resource));
+			CacheAdd(resource);
+			return resource;
 		}
-		bool IsCached(const std::string& resource_name, Resource_Type resource_type);
+		bool IsCached(StringId resource_name, Resource_Type resource_type);
 
         template <class T>
         void Remove(std::shared_ptr<T>& resource)
@@ -122,18 +137,10 @@ namespace Spartan
             if (!resource)
                 return;
 
-            if (!IsCached(resource->GetResourceName(), resource->GetResourceType()))
+            if (!IsCached(resource->GetResourceNameId(), resource->GetResourceType()))
                 return;
 
-            auto& vector = m_resource_groups[resource->GetResourceType()];
-            for (auto it = vector.begin(); it != vector.end(); it++)
-            {
-                if (dynamic_cast<Spartan_Object*>((*it).get())->GetId() == resource->GetId())
-                {
-                    vector.erase(it);
-                    break;
-                }
-            }
+            CacheRemove(resource.get());
         }
 
 		// Loads a resource and adds it to the resource cache
@@ -147,10 +154,12 @@ namespace Spartan
 			}
 
 			// Check if the resource is already loaded
-            const auto name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
+            const StringId name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
 			if (IsCached(name, IResource::TypeToEnum<T>()))
 				return GetByName<T>(name);
 
+			MemoryTagScope memory_tag(Memory_Tag_Resources);
+
 			// Create new resource
 			auto typed = std::make_shared<T>(m_context);
 
@@ -165,9 +174,44 @@ namespace Spartan
 			}
 
             // Returned cached reference which is guaranteed to be around after deserialization
+			RegisterFactory<T>();
 			return Cache<T>(typed);
 		}
 
+		// Loads a resource in the background and returns it right away, as a placeholder until its load state is LoadState_Completed.
+		// Requests for the same file share the resource, queued requests load by priority (the highest first, e.g. visible or near the camera)
+		// and requesting a queued resource again can raise its priority.
+		template <class T>
+		std::shared_ptr<T> LoadAsync(const std::string& file_path, const float priority = 0.0f)
+		{
+			if (!FileSystem::Exists(file_path))
+			{
+				LOG_ERROR("\"%s\" doesn't exist.", file_path.c_str());
+				return nullptr;
+			}
+
+			// Check if the resource is already loaded
+			const StringId name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
+			if (IsCached(name, IResource::TypeToEnum<T>()))
+				return GetByName<T>(name);
+
+			RegisterFactory<T>();
+			std::lock_guard<std::mutex> lock(m_load_mutex);
+
+			// Check if the resource is already requested
+			if (std::shared_ptr<IResource> resource = LoadAsyncFind(file_path, priority))
+				return std::static_pointer_cast<T>(resource);
+
+			auto typed = std::make_shared<T>(m_context);
+			typed->SetResourceFilePath(file_path);
+			T* resource = typed.get();
+			LoadAsyncQueue(file_path, priority, typed, [resource, file_path]() { return resource->LoadFromFile(file_path); });
+
+			return typed;
+		}
+		// Returns true while a resource is queued or loading in the background
+		bool IsLoading(const IResource* resource);
+
 		//= I/O ======================
 		void SaveResourcesToFiles();
 		void LoadResourcesFromFiles();
@@ -177,8 +221,12 @@ namespace Spartan
 		// Memory
         uint64_t GetMemoryUsageCpu(Resource_Type type = Resource_Unknown);
         uint64_t GetMemoryUsageGpu(Resource_Type type = Resource_Unknown);
-		// Unloads all resources
-		void Clear() { m_resource_groups.clear(); }
+		// Unloads all resources (and drops the queued background loads)
+		void Clear();
+		// Resources of a type are evicted, least recently used first, when the type uses more memory (cpu and gpu) than its budget (0 is no budget).
+		// Only resources which nothing but the cache references are evicted, they are saved first and load again once they are requested.
+		void SetMemoryBudget(const Resource_Type type, const uint64_t bytes)	{ m_memory_budgets[type] = bytes; }
+		uint64_t GetMemoryBudget(const Resource_Type type) const				{ const auto it = m_memory_budgets.find(type); return it != m_memory_budgets.end() ? it->second : 0; }
 		// Returns all resources of a given type
 		uint32_t GetResourceCount(Resource_Type type = Resource_Unknown);
 		//===============================================================
@@ -196,12 +244,58 @@ namespace Spartan
 		auto GetModelImporter() const { return m_importer_model.get(); }
 		auto GetImageImporter() const { return m_importer_image.get(); }
 		auto GetFontImporter()  const { return m_importer_font.get(); }
+		auto GetDerivedDataCache() const { return m_derived_data_cache.get(); }
 
 	private:
-		// Cache
+		// Cache, the name and path indices make a lookup a hash instead of a scan of the group
+		void CacheAdd(const std::shared_ptr<IResource>& resource);
+		void CacheRemove(const IResource* resource);
 		std::unordered_map<Resource_Type, std::vector<std::shared_ptr<IResource>>> m_resource_groups;
+		std::unordered_map<Resource_Type, std::unordered_map<StringId, std::shared_ptr<IResource>>> m_resource_names;
+		std::unordered_map<Resource_Type, std::unordered_map<StringId, std::shared_ptr<IResource>>> m_resource_paths; // native file paths
 		std::mutex m_mutex;
 
+		// Eviction, only the types which were loaded through Load() (or LoadAsync()) can be created again, so only they are evicted
+		template <class T>
+		void RegisterFactory()
+		{
+			std::lock_guard<std::mutex> guard(m_mutex);
+			auto& factory = m_resource_factories[IResource::TypeToEnum<T>()];
+			if (!factory)
+			{
+				factory = [this]() { return std::static_pointer_cast<IResource>(std::make_shared<T>(m_context)); };
+			}
+		}
+		void Evict(Resource_Type type, uint64_t budget);
+		std::shared_ptr<IResource> ReloadEvicted(Resource_Type type, StringId name);
+		std::unordered_map<Resource_Type, uint64_t> m_memory_budgets;
+		std::unordered_map<Resource_Type, std::function<std::shared_ptr<IResource>()>> m_resource_factories;
+		std::unordered_map<Resource_Type, std::unordered_map<StringId, std::string>> m_resources_evicted; // native file paths, by name
+		float m_time			= 0.0f;
+		float m_time_evicted	= 0.0f;
+
+		// Background loading
+		struct LoadRequest
+		{
+			std::string file_path;
+			float priority = 0.0f;
+			uint64_t order = 0; // requests of equal priority load in request order
+			std::shared_ptr<IResource> resource;
+			std::function<bool()> load;
+			bool read = true;				// false while the I/O thread reads the file ahead of the load
+			std::vector<std::byte> data;	// the file, if it was read ahead (the load reads it instead of the disk)
+		};
+		std::shared_ptr<IResource> LoadAsyncFind(const std::string& file_path, float priority);
+		void LoadAsyncQueue(const std::string& file_path, float priority, const std::shared_ptr<IResource>& resource, std::function<bool()>&& load);
+		void LoadAsyncSchedule(); // expects m_load_mutex to be locked
+		void LoadAsyncRun();
+		std::vector<LoadRequest> m_load_requests;
+		std::unordered_map<std::string, std::shared_ptr<IResource>> m_loads_pending; // queued or loading, by file path
+		std::vector<std::shared_ptr<Task>> m_load_tasks;
+		uint64_t m_load_order = 0;
+		std::atomic<uint32_t> m_load_reads = 0; // reads ahead whose completion didn't run yet
+		std::mutex m_load_mutex;
+
 		// Directories
 		std::unordered_map<Asset_Type, std::string> m_standard_resource_directories;
 		std::string m_project_directory;
@@ -210,5 +304,6 @@ namespace Spartan
 		std::shared_ptr<ModelImporter> m_importer_model;
 		std::shared_ptr<ImageImporter> m_importer_image;
 		std::shared_ptr<FontImporter> m_importer_font;
+		std::shared_ptr<DerivedDataCache> m_derived_data_cache;
 	};
 }
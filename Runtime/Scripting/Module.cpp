@@ -23,14 +23,87 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Module.h"
 #include <scriptbuilder/scriptbuilder.cpp>
 #include "Scripting.h"
+#include "ScriptInterface.h"
 #include "../Logging/Log.h"
 #include "../Core/FileSystem.h"
+#include "../Resource/Import/DerivedDataCache.h"
+#include "../Utilities/Hash.h"
 //========================================
 
 //= NAMESPACES =====
 using namespace std;
 //==================
 
+namespace _Module
+{
+	// Reads and writes bytecode from/to a string
+	class BytecodeStream : public asIBinaryStream
+	{
+	public:
+		BytecodeStream(std::string* data) : m_data(data) {}
+
+		int Read(void* ptr, asUINT size) override
+		{
+			if (m_offset + size > m_data->size())
+				return asERROR;
+
+			memcpy(ptr, m_data->data() + m_offset, size);
+			m_offset += size;
+			return asSUCCESS;
+		}
+
+		int Write(const void* ptr, asUINT size) override
+		{
+			m_data->append(static_cast<const char*>(ptr), size);
+			return asSUCCESS;
+		}
+
+		// The files the bytecode was compiled from (the script and what it includes), with the keys of their content
+		void WriteFiles(const std::vector<std::string>& files, const Spartan::DerivedDataCache* derived_data_cache)
+		{
+			const auto count = static_cast<uint32_t>(files.size());
+			Write(&count, sizeof(count));
+			for (const auto& file : files)
+			{
+				const auto length	= static_cast<uint32_t>(file.size());
+				const uint64_t key	= derived_data_cache->ComputeKey(file);
+				Write(&length, sizeof(length));
+				Write(file.data(), length);
+				Write(&key, sizeof(key));
+			}
+		}
+
+		// False if any of the files changed since
+		bool ReadFiles(std::vector<std::string>* files, const Spartan::DerivedDataCache* derived_data_cache)
+		{
+			uint32_t count = 0;
+			if (Read(&count, sizeof(count)) < 0)
+				return false;
+
+			files->resize(count);
+			for (auto& file : *files)
+			{
+				uint32_t length	= 0;
+				uint64_t key	= 0;
+				if (Read(&length, sizeof(length)) < 0 || m_offset + length > m_data->size())
+					return false;
+
+				file.assign(m_data->data() + m_offset, length);
+				m_offset += length;
+
+				if (Read(&key, sizeof(key)) < 0 || key != derived_data_cache->ComputeKey(file))
+					return false;
+			}
+
+			return true;
+		}
+
+	private:
+		std::string* m_data;
+		size_t m_offset = 0;
+	};
+}
+
 namespace Spartan
 {
 	Module::Module(const string& moduleName, Scripting* scriptEngine)
@@ -47,7 +120,7 @@ namespace Spartan
 		}
 	}
 
-	bool Module::LoadScript(const string& filePath)
+	bool Module::LoadScript(const string& filePath, DerivedDataCache* derived_data_cache /*= nullptr*/)
 	{
 		if (!m_scripting)
 		{
@@ -55,9 +128,38 @@ namespace Spartan
 			return false;
 		}
 
+		asIScriptEngine* engine = m_scripting->GetAsIScriptEngine();
+
+		// The bytecode depends on the script, on what the engine registers and on whether it includes JIT instructions
+		size_t derived_data_key = derived_data_cache ? derived_data_cache->ComputeKey(filePath) : 0;
+		if (derived_data_key != 0)
+		{
+			Utility::Hash::hash_combine(derived_data_key, script_interface_version);
+			Utility::Hash::hash_combine(derived_data_key, static_cast<uint32_t>(ANGELSCRIPT_VERSION));
+			Utility::Hash::hash_combine(derived_data_key, static_cast<uint32_t>(engine->GetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS)));
+			Utility::Hash::hash_combine(derived_data_key, sizeof(void*));
+
+			string data;
+			if (derived_data_cache->Load(derived_data_key, &data))
+			{
+				// Included files can change without the script changing
+				_Module::BytecodeStream stream(&data);
+				if (stream.ReadFiles(&m_files, derived_data_cache))
+				{
+					m_module = engine->GetModule(m_moduleName.c_str(), asGM_ALWAYS_CREATE);
+					if (m_module && m_module->LoadByteCode(&stream) >= 0)
+						return true;
+
+					// Fall back to compiling
+					LOG_WARNING("Failed to load the compiled \"%s\", compiling it instead", FileSystem::GetFileNameFromFilePath(filePath).c_str());
+					m_module = nullptr;
+				}
+			}
+		}
+
 		// start new module
 		m_scriptBuilder = make_unique<CScriptBuilder>();
-		int result = m_scriptBuilder->StartNewModule(m_scripting->GetAsIScriptEngine(), m_moduleName.c_str());
+		int result = m_scriptBuilder->StartNewModule(engine, m_moduleName.c_str());
 		if (result < 0)
 		{
 			LOG_ERROR("Failed to start new module, make sure there is enough memory for it to be allocated.");
@@ -79,18 +181,38 @@ namespace Spartan
 			LOG_ERROR("Failed to compile script \"%s\". Correct any errors and try again.", FileSystem::GetFileNameFromFilePath(filePath).c_str());
 			return false;
 		}
+		m_module = m_scriptBuilder->GetModule();
+
+		// The files it depends on
+		m_files.clear();
+		for (unsigned int i = 0; i < m_scriptBuilder->GetSectionCount(); i++)
+		{
+			m_files.emplace_back(m_scriptBuilder->GetSectionName(i));
+		}
+
+		// Keep the bytecode (with debug info, so that exceptions still report lines)
+		if (derived_data_key != 0)
+		{
+			string data;
+			_Module::BytecodeStream stream(&data);
+			stream.WriteFiles(m_files, derived_data_cache);
+			if (m_module->SaveByteCode(&stream) >= 0)
+			{
+				derived_data_cache->Save(derived_data_key, data);
+			}
+		}
 
 		return true;
 	}
 
 	asIScriptModule* Module::GetAsIScriptModule() const
     {
-		if (!m_scriptBuilder)
+		if (!m_module)
 		{
 			LOG_ERROR_INVALID_INTERNALS();
 			return nullptr;
 		}
 
-		return m_scriptBuilder->GetModule();
+		return m_module;
 	}
 }
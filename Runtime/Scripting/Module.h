@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ====
 #include <string>
+#include <vector>
 #include <memory>
 //===============
 
@@ -33,6 +34,7 @@ class asIScriptEngine;
 namespace Spartan
 {
 	class Scripting;
+	class DerivedDataCache;
 
 	class Module
 	{
@@ -40,12 +42,18 @@ namespace Spartan
 		Module(const std::string& moduleName, Scripting* scriptEngine);
 		~Module();
 
-		bool LoadScript(const std::string& filePath);
+		// Compiled bytecode is kept in the derived data cache (if one is provided), an unchanged script loads it instead of compiling again
+		bool LoadScript(const std::string& filePath, DerivedDataCache* derived_data_cache = nullptr);
 		asIScriptModule* GetAsIScriptModule() const;
 
+		// The script and the files it includes
+		const auto& GetFiles() const { return m_files; }
+
 	private:
 		std::string m_moduleName;
 		std::unique_ptr<CScriptBuilder> m_scriptBuilder;
+		asIScriptModule* m_module = nullptr;
+		std::vector<std::string> m_files;
         Scripting* m_scripting;
 	};
 }
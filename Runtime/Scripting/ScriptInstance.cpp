@@ -36,6 +36,11 @@ namespace Spartan
 {
     ScriptInstance::~ScriptInstance()
 	{
+		if (m_scripting)
+		{
+			m_scripting->UnregisterInstance(this);
+		}
+
 		if (m_scriptObject)
 		{
 			m_scriptObject->Release();
@@ -45,6 +50,7 @@ namespace Spartan
 		m_constructorFunction	= nullptr;
 		m_startFunction			= nullptr;
 		m_updateFunction		= nullptr;
+		m_parallelUpdateFunction	= nullptr;
 		m_scripting			    = nullptr;
 		m_isInstantiated		= false;
 	}
@@ -60,11 +66,14 @@ namespace Spartan
 		m_scriptPath				= path;
 		m_entity					= entity;
 		m_className					= FileSystem::GetFileNameNoExtensionFromFilePath(m_scriptPath);
-		m_moduleName				= m_className + to_string(m_entity.lock()->GetId());
 		m_constructorDeclaration	= m_className + " @" + m_className + "(Entity @)";
 
 		// Instantiate the script
 		m_isInstantiated = CreateScriptObject();
+		if (m_isInstantiated)
+		{
+			m_scripting->RegisterInstance(this);
+		}
 
 		return m_isInstantiated;
 	}
@@ -91,6 +100,94 @@ namespace Spartan
 		m_scripting->ExecuteCall(m_updateFunction, m_scriptObject, delta_time);
 	}
 
+	bool ScriptInstance::Reload(const shared_ptr<Module>& module)
+	{
+		if (!m_scripting || !module)
+		{
+			LOG_ERROR_INVALID_INTERNALS();
+			return false;
+		}
+
+		// Keep the current object, in case the new one can't be created
+		const auto module_old				= m_module;
+		asIScriptObject* object_old			= m_scriptObject;
+		asIScriptFunction* constructor_old	= m_constructorFunction;
+		asIScriptFunction* start_old		= m_startFunction;
+		asIScriptFunction* update_old		= m_updateFunction;
+		asIScriptFunction* parallel_old		= m_parallelUpdateFunction;
+
+		m_module		= module;
+		m_scriptObject	= nullptr;
+		if (!CreateScriptObject())
+		{
+			LOG_ERROR("Failed to recreate \"%s\", keeping the old version", m_className.c_str());
+			m_module					= module_old;
+			m_scriptObject				= object_old;
+			m_constructorFunction		= constructor_old;
+			m_startFunction				= start_old;
+			m_updateFunction			= update_old;
+			m_parallelUpdateFunction	= parallel_old;
+			return false;
+		}
+
+		CopyProperties(object_old, m_scriptObject);
+		object_old->Release();
+
+		return true;
+	}
+
+	void ScriptInstance::CopyProperties(asIScriptObject* from, asIScriptObject* to) const
+	{
+		asIScriptEngine* engine = m_scripting->GetAsIScriptEngine();
+
+		for (asUINT i = 0; i < to->GetPropertyCount(); i++)
+		{
+			const int type_id = to->GetPropertyTypeId(i);
+
+			// Find the property with the same name and type, types which the old module declared are different (and skipped)
+			asUINT j = 0;
+			for (; j < from->GetPropertyCount(); j++)
+			{
+				if (from->GetPropertyTypeId(j) == type_id && strcmp(from->GetPropertyName(j), to->GetPropertyName(i)) == 0)
+					break;
+			}
+			if (j == from->GetPropertyCount() || (type_id & asTYPEID_SCRIPTOBJECT))
+				continue;
+
+			void* source		= from->GetAddressOfProperty(j);
+			void* destination	= to->GetAddressOfProperty(i);
+
+			// Primitives
+			if ((type_id & asTYPEID_MASK_OBJECT) == 0)
+			{
+				memcpy(destination, source, engine->GetSizeOfPrimitiveType(type_id));
+				continue;
+			}
+
+			asITypeInfo* type = engine->GetTypeInfoById(type_id);
+
+			// Handles (of engine types, e.g. Entity@)
+			if (type_id & asTYPEID_OBJHANDLE)
+			{
+				void* object_old = *static_cast<void**>(destination);
+				void* object_new = *static_cast<void**>(source);
+				if (object_new)
+				{
+					engine->AddRefScriptObject(object_new, type);
+				}
+				if (object_old)
+				{
+					engine->ReleaseScriptObject(object_old, type);
+				}
+				*static_cast<void**>(destination) = object_new;
+				continue;
+			}
+
+			// Values (of engine types, e.g. Vector3 or string)
+			engine->AssignScriptObject(destination, source, type);
+		}
+	}
+
 	bool ScriptInstance::CreateScriptObject()
 	{
 		if (!m_scripting)
@@ -99,10 +196,9 @@ namespace Spartan
 			return false;
 		}
 
-		// Create module
-		m_module	= make_shared<Module>(m_moduleName, m_scripting);
-        const bool result = m_module->LoadScript(m_scriptPath);
-		if (!result)
+		// Get the (shared) module
+		m_module = m_scripting->GetModule(m_scriptPath);
+		if (!m_module)
 			return false;
 
 		// Get type
@@ -114,6 +210,7 @@ namespace Spartan
 		// Get functions in the script
 		m_startFunction			= type->GetMethodByDecl("void Start()"); // Get the Start function from the script
 		m_updateFunction		= type->GetMethodByDecl("void Update(float delta_time)"); // Get the Update function from the script
+		m_parallelUpdateFunction	= type->GetMethodByDecl("void ParallelUpdate(float delta_time)"); // Optional, runs on a worker thread, entity writes are deferred until all instances are done
 		m_constructorFunction	= type->GetFactoryByDecl(m_constructorDeclaration.c_str()); // Get the constructor function from the script
 		if (!m_constructorFunction)
 		{
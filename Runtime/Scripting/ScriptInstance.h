@@ -44,22 +44,32 @@ namespace Spartan
 		bool IsInstantiated() const { return m_isInstantiated; }
 		const auto& GetScriptPath() const { return m_scriptPath; }
 
+		// Recreates the script object from a rebuilt module, the properties which still exist (by name and type) keep their values
+		bool Reload(const std::shared_ptr<Module>& module);
+		const auto& GetModule() const { return m_module; }
+
 		void ExecuteStart() const;
 		void ExecuteUpdate(float delta_time) const;
 
+		// Scripting::ExecuteUpdates() uses these to batch the updates of instances of the same script
+		auto GetUpdateFunction() const			{ return m_updateFunction; }
+		auto GetParallelUpdateFunction() const	{ return m_parallelUpdateFunction; }
+		auto GetScriptObject() const	{ return m_scriptObject; }
+
 	private:
 		bool CreateScriptObject();
+		void CopyProperties(asIScriptObject* from, asIScriptObject* to) const;
 
 		std::string m_scriptPath;
 		std::string m_className;
 		std::string m_constructorDeclaration;
-		std::string m_moduleName;
 		std::weak_ptr<Entity> m_entity;
 		std::shared_ptr<Module> m_module;
 		asIScriptObject* m_scriptObject				= nullptr;
 		asIScriptFunction* m_constructorFunction	= nullptr;
 		asIScriptFunction* m_startFunction			= nullptr;
 		asIScriptFunction* m_updateFunction			= nullptr;
+		asIScriptFunction* m_parallelUpdateFunction	= nullptr;
         Scripting* m_scripting	                    = nullptr;
 		bool m_isInstantiated						= false;
 	};
@@ -22,8 +22,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==============================
 #include "ScriptInterface.h"
 #include <angelscript.h>
+#include "Scripting.h"
 #include "../Rendering/Material.h"
 #include "../Input/Input.h"
+#include "../Physics/Physics.h"
 #include "../World/Entity.h"
 #include "../World/Components/RigidBody.h"
 #include "../World/Components/Camera.h"
@@ -36,6 +38,23 @@ using namespace std;
 using namespace Spartan::Math;
 //============================
 
+namespace _ScriptInterface
+{
+	// Writes to the world go through this, so that scripts which run in parallel defer them (see Scripting::ExecuteUpdates())
+	template <typename Write>
+	void write(Write&& write)
+	{
+		if (Spartan::Scripting::IsDeferring())
+		{
+			Spartan::Scripting::Defer(std::forward<Write>(write));
+		}
+		else
+		{
+			write();
+		}
+	}
+}
+
 namespace Spartan
 {
 	void ScriptInterface::Register(asIScriptEngine* scriptEngine, Context* context)
@@ -53,6 +72,7 @@ namespace Spartan
 		RegisterTransform();
 		RegisterMaterial();
 		RegisterRigidBody();
+		RegisterPhysics();
 		RegisterEntity();
 		RegisterLog();
 	}
@@ -130,9 +150,13 @@ namespace Spartan
 		m_scriptEngine->RegisterObjectType("Camera", 0, asOBJ_REF | asOBJ_NOCOUNT);
 		m_scriptEngine->RegisterObjectType("RigidBody", 0, asOBJ_REF | asOBJ_NOCOUNT);
 		m_scriptEngine->RegisterObjectType("MathHelper", 0, asOBJ_REF | asOBJ_NOCOUNT);
-		m_scriptEngine->RegisterObjectType("Vector2", sizeof(Vector2), asOBJ_VALUE | asOBJ_APP_CLASS | asOBJ_APP_CLASS_CONSTRUCTOR | asOBJ_APP_CLASS_COPY_CONSTRUCTOR | asOBJ_APP_CLASS_DESTRUCTOR);
-		m_scriptEngine->RegisterObjectType("Vector3", sizeof(Vector3), asOBJ_VALUE | asOBJ_APP_CLASS | asOBJ_APP_CLASS_CONSTRUCTOR | asOBJ_APP_CLASS_COPY_CONSTRUCTOR | asOBJ_APP_CLASS_DESTRUCTOR);
-		m_scriptEngine->RegisterObjectType("Quaternion", sizeof(Quaternion), asOBJ_VALUE | asOBJ_APP_CLASS | asOBJ_APP_CLASS_CONSTRUCTOR | asOBJ_APP_CLASS_COPY_CONSTRUCTOR | asOBJ_APP_CLASS_DESTRUCTOR);
+		m_scriptEngine->RegisterObjectType("Physics", 0, asOBJ_REF | asOBJ_NOCOUNT);
+		m_scriptEngine->RegisterObjectType("PhysicsHit", sizeof(PhysicsHit), asOBJ_VALUE | asOBJ_POD | asGetTypeTraits<PhysicsHit>());
+		m_scriptEngine->RegisterObjectType("PhysicsQueryBatch", sizeof(PhysicsQueryBatch), asOBJ_VALUE | asGetTypeTraits<PhysicsQueryBatch>());
+		// The math types are plain data, so scripts (and a JIT) copy them in place, without calling back into the engine to construct and destruct them
+		m_scriptEngine->RegisterObjectType("Vector2", sizeof(Vector2), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLFLOATS | asGetTypeTraits<Vector2>());
+		m_scriptEngine->RegisterObjectType("Vector3", sizeof(Vector3), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLFLOATS | asGetTypeTraits<Vector3>());
+		m_scriptEngine->RegisterObjectType("Quaternion", sizeof(Quaternion), asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_ALLFLOATS | asGetTypeTraits<Quaternion>());
 	}
 
 	/*------------------------------------------------------------------------------
@@ -151,13 +175,17 @@ namespace Spartan
 	/*------------------------------------------------------------------------------
 										[Entity]
 	------------------------------------------------------------------------------*/
+	void EntitySetName(const string& name, Entity* entity)	{ _ScriptInterface::write([entity, name]()		{ entity->SetName(name); }); }
+	void EntitySetActive(const bool active, Entity* entity)	{ _ScriptInterface::write([entity, active]()	{ entity->SetActive(active); }); }
+	Entity& EntityAssign(const Entity& other, Entity* entity)	{ const Entity* source = &other; _ScriptInterface::write([entity, source]() { *entity = *source; }); return *entity; }
+
 	void ScriptInterface::RegisterEntity()
 	{
-		m_scriptEngine->RegisterObjectMethod("Entity", "Entity &opAssign(const Entity &in)", asMETHODPR(Entity, operator =, (const Entity&), Entity&), asCALL_THISCALL);
+		m_scriptEngine->RegisterObjectMethod("Entity", "Entity &opAssign(const Entity &in)", asFUNCTION(EntityAssign), asCALL_CDECL_OBJLAST);
 		m_scriptEngine->RegisterObjectMethod("Entity", "string GetName()", asMETHOD(Entity, GetName), asCALL_THISCALL);
-		m_scriptEngine->RegisterObjectMethod("Entity", "void SetName(string)", asMETHOD(Entity, SetName), asCALL_THISCALL);
+		m_scriptEngine->RegisterObjectMethod("Entity", "void SetName(string)", asFUNCTION(EntitySetName), asCALL_CDECL_OBJLAST);
 		m_scriptEngine->RegisterObjectMethod("Entity", "bool IsActive()", asMETHOD(Entity, IsActive), asCALL_THISCALL);
-		m_scriptEngine->RegisterObjectMethod("Entity", "void SetActive(bool)", asMETHOD(Entity, SetActive), asCALL_THISCALL);
+		m_scriptEngine->RegisterObjectMethod("Entity", "void SetActive(bool)", asFUNCTION(EntitySetActive), asCALL_CDECL_OBJLAST);
 		m_scriptEngine->RegisterObjectMethod("Entity", "Transform &GetTransform()", asMETHOD(Entity, GetTransform), asCALL_THISCALL);	
 		m_scriptEngine->RegisterObjectMethod("Entity", "Camera &GetCamera()", asMETHOD(Entity, GetComponent<Camera>), asCALL_THISCALL);
 		m_scriptEngine->RegisterObjectMethod("Entity", "RigidBody &GetRigidBody()", asMETHOD(Entity, GetComponent<RigidBody>), asCALL_THISCALL);
@@ -167,23 +195,33 @@ namespace Spartan
 	/*------------------------------------------------------------------------------
 										[TRANSFORM]
 	------------------------------------------------------------------------------*/
+	void TransformSetPosition(const Vector3& position, Transform* transform)	{ _ScriptInterface::write([transform, position]()	{ transform->SetPosition(position); }); }
+	void TransformSetPositionLocal(const Vector3& position, Transform* transform)	{ _ScriptInterface::write([transform, position]()	{ transform->SetPositionLocal(position); }); }
+	void TransformSetScale(const Vector3& scale, Transform* transform)	{ _ScriptInterface::write([transform, scale]()	{ transform->SetScale(scale); }); }
+	void TransformSetScaleLocal(const Vector3& scale, Transform* transform)	{ _ScriptInterface::write([transform, scale]()	{ transform->SetScaleLocal(scale); }); }
+	void TransformSetRotation(const Quaternion& rotation, Transform* transform)	{ _ScriptInterface::write([transform, rotation]()	{ transform->SetRotation(rotation); }); }
+	void TransformSetRotationLocal(const Quaternion& rotation, Transform* transform)	{ _ScriptInterface::write([transform, rotation]()	{ transform->SetRotationLocal(rotation); }); }
+	void TransformTranslate(const Vector3& delta, Transform* transform)	{ _ScriptInterface::write([transform, delta]()	{ transform->Translate(delta); }); }
+	void TransformRotate(const Quaternion& delta, Transform* transform)	{ _ScriptInterface::write([transform, delta]()	{ transform->Rotate(delta); }); }
+	Transform& TransformAssign(const Transform& other, Transform* transform)	{ const Transform* source = &other; _ScriptInterface::write([transform, source]() { *transform = *source; }); return *transform; }
+
 	void ScriptInterface::RegisterTransform() const
     {
 		auto r = 0;
 
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "Transform &opAssign(const Transform &in)",	asMETHODPR(Transform, operator =, (const Transform&), Transform&),	asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "Transform &opAssign(const Transform &in)",	asFUNCTION(TransformAssign),										asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Vector3 GetPosition()",						asMETHOD(Transform, GetPosition),									asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetPosition(Vector3)",					asMETHOD(Transform, SetPosition),									asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetPosition(Vector3)",					asFUNCTION(TransformSetPosition),									asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Vector3 GetPositionLocal()",					asMETHOD(Transform, GetPositionLocal),								asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetPositionLocal(Vector3)",				asMETHOD(Transform, SetPositionLocal),								asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetPositionLocal(Vector3)",				asFUNCTION(TransformSetPositionLocal),								asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Vector3 GetScale()",							asMETHOD(Transform, GetScale),										asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetScale(Vector3)",						asMETHOD(Transform, SetScale),										asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetScale(Vector3)",						asFUNCTION(TransformSetScale),										asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Vector3 GetScaleLocal()",					asMETHOD(Transform, GetScaleLocal),									asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetScaleLocal(Vector3)",				asMETHOD(Transform, SetScaleLocal),									asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetScaleLocal(Vector3)",				asFUNCTION(TransformSetScaleLocal),									asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Quaternion GetRotation()",					asMETHOD(Transform, GetRotation),									asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetRotation(Quaternion)",				asMETHOD(Transform, SetRotation),									asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetRotation(Quaternion)",				asFUNCTION(TransformSetRotation),									asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Quaternion GetRotationLocal()",				asMETHOD(Transform, GetRotationLocal),								asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetRotationLocal(Quaternion)",			asMETHOD(Transform, SetRotationLocal),								asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void SetRotationLocal(Quaternion)",			asFUNCTION(TransformSetRotationLocal),								asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Vector3 GetUp()",							asMETHOD(Transform, GetUp),											asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Vector3 GetForward()",						asMETHOD(Transform, GetForward),									asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Vector3 GetRight()",							asMETHOD(Transform, GetRight),										asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
@@ -192,28 +230,90 @@ namespace Spartan
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Transform &GetChildByIndex(int)",			asMETHOD(Transform, GetChildByIndex),								asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Transform &GetChildByName(string)",			asMETHOD(Transform, GetChildByName),								asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Transform", "Entity &GetEntity()",						asMETHOD(Transform, GetEntity),								        asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void Translate(const Vector3& in)",			asMETHOD(Transform, Translate),										asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectMethod("Transform", "void Rotate(const Quaternion& in)",			asMETHOD(Transform, Rotate),										asCALL_THISCALL); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void Translate(const Vector3& in)",			asFUNCTION(TransformTranslate),										asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Transform", "void Rotate(const Quaternion& in)",			asFUNCTION(TransformRotate),										asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
 	}
 
 	/*------------------------------------------------------------------------------
 								[MATERIAL]
 	------------------------------------------------------------------------------*/
+	void MaterialSetOffset(const Vector2& offset, Material* material) { _ScriptInterface::write([material, offset]() { material->SetOffset(offset); }); }
+
 	void ScriptInterface::RegisterMaterial() const
     {
-		m_scriptEngine->RegisterObjectMethod("Material", "void SetOffsetUV(Vector2)", asMETHOD(Material, SetOffset), asCALL_THISCALL);
+		m_scriptEngine->RegisterObjectMethod("Material", "void SetOffsetUV(Vector2)", asFUNCTION(MaterialSetOffset), asCALL_CDECL_OBJLAST);
 	}
 
 	/*------------------------------------------------------------------------------
 									[RIGIDBODY]
 	------------------------------------------------------------------------------*/
+	void RigidBodyApplyForce(const Vector3& force, const ForceMode mode, RigidBody* body)								{ _ScriptInterface::write([body, force, mode]()				{ body->ApplyForce(force, mode); }); }
+	void RigidBodyApplyForceAtPosition(const Vector3& force, const Vector3& position, const ForceMode mode, RigidBody* body)	{ _ScriptInterface::write([body, force, position, mode]()	{ body->ApplyForceAtPosition(force, position, mode); }); }
+	void RigidBodyApplyTorque(const Vector3& torque, const ForceMode mode, RigidBody* body)								{ _ScriptInterface::write([body, torque, mode]()			{ body->ApplyTorque(torque, mode); }); }
+	void RigidBodySetRotation(const Quaternion& rotation, RigidBody* body)												{ _ScriptInterface::write([body, rotation]()				{ body->SetRotation(rotation); }); }
+	RigidBody& RigidBodyAssign(const RigidBody& other, RigidBody* body)													{ const RigidBody* source = &other; _ScriptInterface::write([body, source]() { *body = *source; }); return *body; }
+
 	void ScriptInterface::RegisterRigidBody() const
     {
-		m_scriptEngine->RegisterObjectMethod("RigidBody", "RigidBody &opAssign(const RigidBody &in)", asMETHODPR(RigidBody, operator =, (const RigidBody&), RigidBody&), asCALL_THISCALL);
-		m_scriptEngine->RegisterObjectMethod("RigidBody", "void ApplyForce(Vector3, ForceMode)", asMETHOD(RigidBody, ApplyForce), asCALL_THISCALL);
-		m_scriptEngine->RegisterObjectMethod("RigidBody", "void ApplyForceAtPosition(Vector3, Vector3, ForceMode)", asMETHOD(RigidBody, ApplyForceAtPosition), asCALL_THISCALL);
-		m_scriptEngine->RegisterObjectMethod("RigidBody", "void ApplyTorque(Vector3, ForceMode)", asMETHOD(RigidBody, ApplyTorque), asCALL_THISCALL);
-		m_scriptEngine->RegisterObjectMethod("RigidBody", "void SetRotation(Quaternion)", asMETHOD(RigidBody, SetRotation), asCALL_THISCALL);
+		m_scriptEngine->RegisterObjectMethod("RigidBody", "RigidBody &opAssign(const RigidBody &in)", asFUNCTION(RigidBodyAssign), asCALL_CDECL_OBJLAST);
+		m_scriptEngine->RegisterObjectMethod("RigidBody", "void ApplyForce(Vector3, ForceMode)", asFUNCTION(RigidBodyApplyForce), asCALL_CDECL_OBJLAST);
+		m_scriptEngine->RegisterObjectMethod("RigidBody", "void ApplyForceAtPosition(Vector3, Vector3, ForceMode)", asFUNCTION(RigidBodyApplyForceAtPosition), asCALL_CDECL_OBJLAST);
+		m_scriptEngine->RegisterObjectMethod("RigidBody", "void ApplyTorque(Vector3, ForceMode)", asFUNCTION(RigidBodyApplyTorque), asCALL_CDECL_OBJLAST);
+		m_scriptEngine->RegisterObjectMethod("RigidBody", "void SetRotation(Quaternion)", asFUNCTION(RigidBodySetRotation), asCALL_CDECL_OBJLAST);
+	}
+
+	/*------------------------------------------------------------------------------
+										[PHYSICS]
+	------------------------------------------------------------------------------*/
+	void ConstructorPhysicsQueryBatch(PhysicsQueryBatch* other)
+	{
+		new(other) PhysicsQueryBatch();
+	}
+
+	void CopyConstructorPhysicsQueryBatch(const PhysicsQueryBatch& in, PhysicsQueryBatch* other)
+	{
+		new(other) PhysicsQueryBatch(in);
+	}
+
+	void DestructPhysicsQueryBatch(PhysicsQueryBatch* other)
+	{
+		other->~PhysicsQueryBatch();
+	}
+
+	bool PhysicsRaycast(const Vector3& from, const Vector3& to, PhysicsHit& hit, Physics* physics)
+	{
+		return physics->Raycast(from, to, &hit);
+	}
+
+	void ScriptInterface::RegisterPhysics() const
+	{
+		int r;
+
+		// Hit
+		r = m_scriptEngine->RegisterObjectProperty("PhysicsHit", "Entity@ entity",		asOFFSET(PhysicsHit, entity));		SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectProperty("PhysicsHit", "Vector3 position",	asOFFSET(PhysicsHit, position));	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectProperty("PhysicsHit", "Vector3 normal",		asOFFSET(PhysicsHit, normal));		SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectProperty("PhysicsHit", "float fraction",		asOFFSET(PhysicsHit, fraction));	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectProperty("PhysicsHit", "bool hit",			asOFFSET(PhysicsHit, hit));			SPARTAN_ASSERT(r >= 0);
+
+		// Batch, scripts add their queries, run them with physics.Query() and read the hits by the index each Add*() returned
+		r = m_scriptEngine->RegisterObjectBehaviour("PhysicsQueryBatch", asBEHAVE_CONSTRUCT, "void f()",								asFUNCTION(ConstructorPhysicsQueryBatch),		asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectBehaviour("PhysicsQueryBatch", asBEHAVE_CONSTRUCT, "void f(const PhysicsQueryBatch &in)",	asFUNCTION(CopyConstructorPhysicsQueryBatch),	asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectBehaviour("PhysicsQueryBatch", asBEHAVE_DESTRUCT, "void f()",								asFUNCTION(DestructPhysicsQueryBatch),			asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "PhysicsQueryBatch &opAssign(const PhysicsQueryBatch &in)",										asMETHODPR(PhysicsQueryBatch, operator =, (const PhysicsQueryBatch&), PhysicsQueryBatch&),	asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "uint AddRay(const Vector3 &in, const Vector3 &in)",												asMETHOD(PhysicsQueryBatch, AddRay),				asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "uint AddSphereSweep(const Vector3 &in, const Vector3 &in, float)",									asMETHOD(PhysicsQueryBatch, AddSphereSweep),		asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "uint AddBoxSweep(const Vector3 &in, const Vector3 &in, const Vector3 &in, const Quaternion &in)",	asMETHOD(PhysicsQueryBatch, AddBoxSweep),			asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "uint AddSphereOverlap(const Vector3 &in, float)",													asMETHOD(PhysicsQueryBatch, AddSphereOverlap),		asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "uint AddBoxOverlap(const Vector3 &in, const Vector3 &in, const Quaternion &in)",					asMETHOD(PhysicsQueryBatch, AddBoxOverlap),			asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "void Clear()",																						asMETHOD(PhysicsQueryBatch, Clear),					asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "uint GetCount() const",																				asMETHOD(PhysicsQueryBatch, GetCount),				asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("PhysicsQueryBatch", "const PhysicsHit &GetHit(uint) const",																asMETHOD(PhysicsQueryBatch, GetHit),				asCALL_THISCALL);	SPARTAN_ASSERT(r >= 0);
+
+		// Physics
+		r = m_scriptEngine->RegisterGlobalProperty("Physics physics", m_context->GetSubsystem<Physics>());																															SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Physics", "void Query(PhysicsQueryBatch &inout) const",										asMETHODPR(Physics, Query, (PhysicsQueryBatch&) const, void),	asCALL_THISCALL);		SPARTAN_ASSERT(r >= 0);
+		r = m_scriptEngine->RegisterObjectMethod("Physics", "bool Raycast(const Vector3 &in, const Vector3 &in, PhysicsHit &out) const",		asFUNCTION(PhysicsRaycast),										asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
 	}
 
 	/*------------------------------------------------------------------------------
@@ -234,11 +334,6 @@ namespace Spartan
 		new(other) Vector2(x, y);
 	}
 
-	void DestructVector2(Vector2* other)
-	{
-		other->~Vector2();
-	}
-
 	static Vector2& Vector2AddAssignVector2(const Vector2& other, Vector2* self)
 	{
 		return *self = *self + other;
@@ -261,7 +356,6 @@ namespace Spartan
 		r = m_scriptEngine->RegisterObjectBehaviour("Vector2", asBEHAVE_CONSTRUCT, "void f()",					asFUNCTION(ConstructorVector2),								asCALL_CDECL_OBJLAST); 	SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectBehaviour("Vector2", asBEHAVE_CONSTRUCT, "void f(const Vector2 &in)", asFUNCTION(CopyConstructorVector2),							asCALL_CDECL_OBJLAST); 	SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectBehaviour("Vector2", asBEHAVE_CONSTRUCT, "void f(float, float)",		asFUNCTION(ConstructorVector2Floats),						asCALL_CDECL_OBJLAST); 	SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectBehaviour("Vector2", asBEHAVE_DESTRUCT, "void f()",					asFUNCTION(DestructVector2),								asCALL_CDECL_OBJLAST); 	SPARTAN_ASSERT(r >= 0);	
 		r = m_scriptEngine->RegisterObjectMethod("Vector2", "Vector2 &opAddAssign(const Vector2 &in)",			asFUNCTION(Vector2AddAssignVector2),						asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectMethod("Vector2", "Vector2 &opAssign(const Vector2 &in)",				asMETHODPR(Vector2, operator=, (const Vector2&), Vector2&), asCALL_THISCALL);		SPARTAN_ASSERT(r >= 0);
         r = m_scriptEngine->RegisterObjectMethod("Vector2", "Vector2 opMul(float)",                             asFUNCTION(Vector2MulFloat), asCALL_CDECL_OBJLAST);	        SPARTAN_ASSERT(r >= 0);
@@ -289,11 +383,6 @@ namespace Spartan
 		new(self) Vector3(x, y, z);
 	}
 
-	void DestructVector3(Vector3* self)
-	{
-		self->~Vector3();
-	}
-
 	static Vector3& Vector3Assignment(const Vector3& other, Vector3* self)
 	{
 		return *self = other;
@@ -342,7 +431,6 @@ namespace Spartan
         r = m_scriptEngine->RegisterObjectBehaviour("Vector3", asBEHAVE_CONSTRUCT, "void f()",						asFUNCTION(ConstructorVector3),			asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
         r = m_scriptEngine->RegisterObjectBehaviour("Vector3", asBEHAVE_CONSTRUCT, "void f(const Vector3 &in)",	    asFUNCTION(CopyConstructorVector3),		asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
         r = m_scriptEngine->RegisterObjectBehaviour("Vector3", asBEHAVE_CONSTRUCT, "void f(float, float, float)",	asFUNCTION(ConstructorVector3Floats),	asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
-        r = m_scriptEngine->RegisterObjectBehaviour("Vector3", asBEHAVE_DESTRUCT, "void f()",						asFUNCTION(DestructVector3),			asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
         r = m_scriptEngine->RegisterObjectMethod("Vector3", "Vector3 &opAssign(const Vector3 &in)",				    asFUNCTION(Vector3Assignment),			asCALL_CDECL_OBJLAST);	SPARTAN_ASSERT(r >= 0);
         r = m_scriptEngine->RegisterObjectMethod("Vector3", "Vector3 opAdd(const Vector3 &in)",					    asFUNCTION(Vector3AddVector3),			asCALL_CDECL_OBJLAST); 	SPARTAN_ASSERT(r >= 0);
         r = m_scriptEngine->RegisterObjectMethod("Vector3", "Vector3 &opAddAssign(const Vector3 &in)",				asFUNCTION(Vector3AddAssignVector3),	asCALL_CDECL_OBJLAST); 	SPARTAN_ASSERT(r >= 0);
@@ -375,11 +463,6 @@ namespace Spartan
 		new(self) Quaternion(x, y, z, w);
 	}
 
-	void DestructQuaternion(Quaternion* in)
-	{
-		in->~Quaternion();
-	}
-
 	static Quaternion& QuaternionMulAssignQuaternion(const Quaternion& other, Quaternion* self)
 	{
 		return *self = *self * other;
@@ -397,7 +480,6 @@ namespace Spartan
 		r = m_scriptEngine->RegisterObjectBehaviour("Quaternion", asBEHAVE_CONSTRUCT, "void f()", asFUNCTION(ConstructorQuaternion), asCALL_CDECL_OBJLAST);                                 SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectBehaviour("Quaternion", asBEHAVE_CONSTRUCT, "void f(const Quaternion &in)", asFUNCTION(CopyConstructorQuaternion), asCALL_CDECL_OBJLAST);         SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectBehaviour("Quaternion", asBEHAVE_CONSTRUCT, "void f(float, float, float, float)", asFUNCTION(ConstructorQuaternionFloats), asCALL_CDECL_OBJLAST); SPARTAN_ASSERT(r >= 0);
-		r = m_scriptEngine->RegisterObjectBehaviour("Quaternion", asBEHAVE_DESTRUCT, "void f()", asFUNCTION(DestructQuaternion), asCALL_CDECL_OBJLAST);                                     SPARTAN_ASSERT(r >= 0);
 
 		r = m_scriptEngine->RegisterObjectProperty("Quaternion", "float x", asOFFSET(Quaternion, x)); SPARTAN_ASSERT(r >= 0);
 		r = m_scriptEngine->RegisterObjectProperty("Quaternion", "float y", asOFFSET(Quaternion, y)); SPARTAN_ASSERT(r >= 0);
@@ -21,12 +21,19 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
+//= INCLUDES =====
+#include <cstdint>
+//================
+
 class asIScriptEngine;
 
 namespace Spartan
 {
 	class Context;
 
+	// Bump when the registered interface changes, so that scripts which were compiled against an older one are compiled again
+	constexpr uint32_t script_interface_version = 1;
+
 	class ScriptInterface
 	{
 	public:
@@ -40,6 +47,7 @@ namespace Spartan
 		void RegisterTransform() const;
 		void RegisterMaterial() const;
 		void RegisterRigidBody() const;
+		void RegisterPhysics() const;
 		void RegisterVector2() const;
 		void RegisterVector3() const;
 		void RegisterQuaternion() const;
@@ -21,15 +21,49 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =================================
 #include "Scripting.h"
+#include <algorithm>
+#include <filesystem>
 #include <scriptstdstring/scriptstdstring.cpp>
 #include "ScriptInterface.h"
+#include "ScriptInstance.h"
+#include "Module.h"
 #include "../Logging/Log.h"
 #include "../Core/FileSystem.h"
 #include "../Core/EventSystem.h"
 #include "../Core/Settings.h"
 #include "../Core/Context.h"
+#include "../Threading/Threading.h"
+#include "../Resource/ResourceCache.h"
+#include "../Profiling/Profiler.h"
+#include "../Core/Stopwatch.h"
 //===========================================
 
+namespace _Scripting
+{
+	// How often the script files are checked for changes (in seconds)
+	constexpr float reload_check_interval = 1.0f;
+
+	int64_t write_time(const std::string& file_path)
+	{
+		std::error_code error;
+		return std::filesystem::last_write_time(file_path, error).time_since_epoch().count();
+	}
+
+	bool is_changed(const std::vector<std::pair<std::string, int64_t>>& files)
+	{
+		for (const auto& file : files)
+		{
+			if (write_time(file.first) != file.second)
+				return true;
+		}
+
+		return false;
+	}
+
+	// The command buffer of the parallel update chunk which runs on this thread, if any
+	thread_local std::vector<std::function<void()>>* commands = nullptr;
+}
+
 namespace Spartan
 {
 	Scripting::Scripting(Context* context) : ISubsystem(context)
@@ -51,6 +85,9 @@ namespace Spartan
 
     bool Scripting::Initialize()
     {
+        // Scripts execute on worker threads too (see ExecuteUpdates())
+        asPrepareMultithread();
+
         m_scriptEngine = asCreateScriptEngine(ANGELSCRIPT_VERSION);
         if (!m_scriptEngine)
         {
@@ -70,6 +107,9 @@ namespace Spartan
 
         m_scriptEngine->SetEngineProperty(asEP_BUILD_WITHOUT_LINE_CUES, true);
 
+        // Get dependencies
+        m_profiler = m_context->GetSubsystem<Profiler>();
+
         // Get version
         const string major = to_string(ANGELSCRIPT_VERSION).erase(1, 4);
         const string minor = to_string(ANGELSCRIPT_VERSION).erase(0, 1).erase(2, 2);
@@ -79,8 +119,20 @@ namespace Spartan
         return true;
     }
 
+    void Scripting::Tick(float delta_time)
+    {
+        m_reload_timer += delta_time;
+        if (m_reload_timer < _Scripting::reload_check_interval)
+            return;
+
+        m_reload_timer = 0.0f;
+        ReloadChanged();
+    }
+
     void Scripting::Clear()
 	{
+		lock_guard<mutex> lock(m_contexts_mutex);
+
 		for (auto& context : m_contexts)
 		{
 			context->Release();
@@ -102,6 +154,8 @@ namespace Spartan
 	// They say you must pool them to avoid overhead. So I do as they say.
 	asIScriptContext* Scripting::RequestContext()
 	{
+		lock_guard<mutex> lock(m_contexts_mutex);
+
 		asIScriptContext* context = nullptr;
 		if (m_contexts.size())
 		{
@@ -125,8 +179,10 @@ namespace Spartan
 			LOG_ERROR("Scripting::ReturnContext: Context is null");
 			return;
 		}
-		m_contexts.push_back(context);
 		context->Unprepare();
+
+		lock_guard<mutex> lock(m_contexts_mutex);
+		m_contexts.push_back(context);
 	}
 
 	/*------------------------------------------------------------------------------
@@ -142,7 +198,13 @@ namespace Spartan
 		ctx->SetObject(obj); // set the object pointer
         if (delta_time != -1.0f) ctx->SetArgFloat(0, delta_time);
 
+        const bool profile = m_profiler && m_profiler->IsProfilingCpu();
+        const Stopwatch stopwatch;
         const int r = ctx->Execute(); // execute the call
+        if (profile)
+        {
+            m_profiler->TimeSampleAdd(GetProfileName(scriptFunc).c_str(), stopwatch.GetElapsedTimeMs());
+        }
 
 		// output any exceptions
 		if (r == asEXECUTION_EXCEPTION)
@@ -156,6 +218,138 @@ namespace Spartan
 		return true;
 	}
 
+	void Scripting::SetJITCompiler(asIJITCompiler* compiler) const
+	{
+		// Only scripts which are compiled after this, include the instructions the JIT hooks into
+		m_scriptEngine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, compiler != nullptr);
+		m_scriptEngine->SetJITCompiler(compiler);
+	}
+
+	void Scripting::ExecuteUpdates(const vector<ScriptInstance*>& instances, const float delta_time)
+	{
+		// Parallel phase, for the instances which have ParallelUpdate()
+		m_updates.clear();
+		for (ScriptInstance* instance : instances)
+		{
+			if (instance->GetParallelUpdateFunction())
+			{
+				m_updates.emplace_back(instance);
+			}
+		}
+
+		if (!m_updates.empty())
+		{
+			stable_sort(m_updates.begin(), m_updates.end(), [](const ScriptInstance* a, const ScriptInstance* b) { return a->GetParallelUpdateFunction() < b->GetParallelUpdateFunction(); });
+
+			m_context->GetSubsystem<Threading>()->ParallelFor([this, delta_time](uint32_t index_start, uint32_t index_end)
+			{
+				CommandBuffer* buffer = nullptr;
+				{
+					lock_guard<mutex> lock(m_command_buffers_mutex);
+					buffer			= &m_command_buffers.emplace_back();
+					buffer->start	= index_start;
+				}
+
+				_Scripting::commands = &buffer->commands;
+				asIScriptContext* ctx = RequestContext();
+				ExecuteBatch(ctx, m_updates, index_start, index_end, true, delta_time);
+				ReturnContext(ctx);
+				_Scripting::commands = nullptr;
+			}, static_cast<uint32_t>(m_updates.size()));
+
+			// Apply the writes, in the order the instances ran in
+			sort(m_command_buffers.begin(), m_command_buffers.end(), [](const CommandBuffer& a, const CommandBuffer& b) { return a.start < b.start; });
+			for (CommandBuffer& buffer : m_command_buffers)
+			{
+				for (const auto& command : buffer.commands)
+				{
+					command();
+				}
+			}
+			m_command_buffers.clear();
+		}
+
+		// Serial phase, grouped by method, the order within a group is the order they came in
+		m_updates.assign(instances.begin(), instances.end());
+		stable_sort(m_updates.begin(), m_updates.end(), [](const ScriptInstance* a, const ScriptInstance* b) { return a->GetUpdateFunction() < b->GetUpdateFunction(); });
+
+		asIScriptContext* ctx = RequestContext();
+		ExecuteBatch(ctx, m_updates, 0, static_cast<uint32_t>(m_updates.size()), false, delta_time);
+		ReturnContext(ctx);
+
+		m_updates.clear();
+	}
+
+	void Scripting::ExecuteBatch(asIScriptContext* ctx, const vector<ScriptInstance*>& instances, const uint32_t start, const uint32_t end, const bool parallel, const float delta_time) const
+	{
+		// The calls of each group are timed together, as a sample named after the class and method
+		const bool profile			= m_profiler && m_profiler->IsProfilingCpu();
+		asIScriptFunction* group	= nullptr;
+		Stopwatch stopwatch;
+		const auto sample = [this, &group, &stopwatch]()
+		{
+			if (group)
+			{
+				m_profiler->TimeSampleAdd(GetProfileName(group).c_str(), stopwatch.GetElapsedTimeMs());
+			}
+		};
+
+		for (uint32_t i = start; i < end; i++)
+		{
+			asIScriptFunction* function = parallel ? instances[i]->GetParallelUpdateFunction() : instances[i]->GetUpdateFunction();
+			if (!function)
+				continue;
+
+			if (profile && function != group)
+			{
+				sample();
+				group = function;
+				stopwatch.Start();
+			}
+
+			// Preparing for the function which was last executed takes a fast path, so this is mostly paid once per group
+			if (ctx->Prepare(function) < 0)
+				continue;
+
+			ctx->SetObject(instances[i]->GetScriptObject());
+			ctx->SetArgFloat(0, delta_time);
+
+			if (ctx->Execute() == asEXECUTION_EXCEPTION)
+			{
+				LogExceptionInfo(ctx);
+			}
+		}
+
+		if (profile)
+		{
+			sample();
+		}
+	}
+
+	const string& Scripting::GetProfileName(asIScriptFunction* function) const
+	{
+		lock_guard<mutex> lock(m_profile_names_mutex);
+
+		auto it = m_profile_names.find(function);
+		if (it == m_profile_names.end())
+		{
+			const char* class_name = function->GetObjectName();
+			it = m_profile_names.emplace(function, string(class_name ? class_name : "") + "::" + function->GetName()).first;
+		}
+
+		return it->second;
+	}
+
+	bool Scripting::IsDeferring()
+	{
+		return _Scripting::commands != nullptr;
+	}
+
+	void Scripting::Defer(function<void()>&& command)
+	{
+		_Scripting::commands->emplace_back(move(command));
+	}
+
 	/*------------------------------------------------------------------------------
 										[MODULE]
 	------------------------------------------------------------------------------*/
@@ -164,6 +358,84 @@ namespace Spartan
 		m_scriptEngine->DiscardModule(moduleName.c_str());
 	}
 
+	shared_ptr<Module> Scripting::GetModule(const string& file_path)
+	{
+		// Share the module if its files didn't change since it was built
+		SharedModule& shared = m_modules[file_path];
+		if (auto module = shared.module.lock())
+		{
+			if (!_Scripting::is_changed(shared.files))
+				return module;
+		}
+
+		return BuildModule(file_path, shared);
+	}
+
+	shared_ptr<Module> Scripting::BuildModule(const string& file_path, SharedModule& shared)
+	{
+		// The name is unique since the module of an older version of the script can still be in use
+		auto module = make_shared<Module>(file_path + "_" + to_string(m_module_id++), this);
+		const bool result = module->LoadScript(file_path, m_context->GetSubsystem<ResourceCache>()->GetDerivedDataCache());
+
+		// Remember the files even if it failed, so that a broken script isn't rebuilt until it changes again
+		shared.files.clear();
+		const vector<string> files_failed = { file_path };
+		for (const auto& file : result ? module->GetFiles() : files_failed)
+		{
+			shared.files.emplace_back(file, _Scripting::write_time(file));
+		}
+
+		if (!result)
+			return nullptr;
+
+		shared.module = module;
+		return module;
+	}
+
+	void Scripting::ReloadChanged()
+	{
+		for (auto it = m_modules.begin(); it != m_modules.end();)
+		{
+			const auto module = it->second.module.lock();
+			if (!module)
+			{
+				it = m_modules.erase(it);
+				continue;
+			}
+
+			if (_Scripting::is_changed(it->second.files))
+			{
+				if (auto module_rebuilt = BuildModule(it->first, it->second))
+				{
+					// Recreate the instances of the old module
+					uint32_t count = 0;
+					for (ScriptInstance* instance : m_instances)
+					{
+						if (instance->GetModule() == module && instance->Reload(module_rebuilt))
+						{
+							count++;
+						}
+					}
+
+					LOG_INFO("Reloaded \"%s\", %d instances", FileSystem::GetFileNameFromFilePath(it->first).c_str(), count);
+				}
+				// Otherwise the instances keep running the old version
+			}
+
+			it++;
+		}
+	}
+
+	void Scripting::RegisterInstance(ScriptInstance* instance)
+	{
+		m_instances.emplace(instance);
+	}
+
+	void Scripting::UnregisterInstance(ScriptInstance* instance)
+	{
+		m_instances.erase(instance);
+	}
+
 	/*------------------------------------------------------------------------------
 									[PRIVATE]
 	------------------------------------------------------------------------------*/
@@ -24,6 +24,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==================
 #include <vector>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 #include "../Core/ISubsystem.h"
 //=============================
 
@@ -33,6 +39,7 @@ class asIScriptFunction;
 class asIScriptEngine;
 class asIScriptContext;
 class asIScriptModule;
+class asIJITCompiler;
 class CScriptBuilder;
 struct asSFuncPtr;
 struct asSMessageInfo;
@@ -41,6 +48,8 @@ struct asSMessageInfo;
 namespace Spartan
 {
 	class Module;
+	class ScriptInstance;
+	class Profiler;
 
 	class Scripting : public ISubsystem
 	{
@@ -48,9 +57,10 @@ namespace Spartan
 		Scripting(Context* context);
 		~Scripting();
 
-        //= Subsystem =============
+        //= Subsystem =========================
         bool Initialize() override;
-        //=========================
+        void Tick(float delta_time) override;
+        //=====================================
 
 		void Clear();
 		asIScriptEngine* GetAsIScriptEngine() const;
@@ -59,15 +69,63 @@ namespace Spartan
 		asIScriptContext* RequestContext();
 		void ReturnContext(asIScriptContext* ctx);
 
+		// An optional JIT, it has to be set before scripts are loaded (the engine doesn't ship one, this is where a platform's JIT plugs in)
+		void SetJITCompiler(asIJITCompiler* compiler) const;
+
 		// Calls
 		bool ExecuteCall(asIScriptFunction* scriptFunc, asIScriptObject* obj, float delta_time = -1.0f);
+		// Calls ParallelUpdate() on the instances which have it, on worker threads, and then Update(), on this thread.
+		// The instances are grouped by script class so that each group runs on a single context which is prepared once.
+		void ExecuteUpdates(const std::vector<ScriptInstance*>& instances, float delta_time);
+
+		// Entity writes which scripts make during ParallelUpdate() are recorded, and applied in instance order once every instance is done (see ScriptInterface)
+		static bool IsDeferring();
+		static void Defer(std::function<void()>&& command);
 
 		// Modules
 		void DiscardModule(const std::string& moduleName) const;
+		// Instances of the same script share its module (and so its class and methods), a script which changed on disk (or any file it includes) gets a new module
+		std::shared_ptr<Module> GetModule(const std::string& file_path);
+
+		// Hot reload, the modules whose files changed are rebuilt and only their instances are recreated (keeping the values of their properties).
+		// Runs periodically from Tick(), instances register so that they can be found.
+		void ReloadChanged();
+		void RegisterInstance(ScriptInstance* instance);
+		void UnregisterInstance(ScriptInstance* instance);
 
 	private:
         asIScriptEngine* m_scriptEngine = nullptr;
 		std::vector<asIScriptContext*> m_contexts;
+		std::mutex m_contexts_mutex;
+
+		struct SharedModule
+		{
+			std::weak_ptr<Module> module;
+			std::vector<std::pair<std::string, int64_t>> files; // the write time of each file, as of the last build
+		};
+		std::shared_ptr<Module> BuildModule(const std::string& file_path, SharedModule& shared);
+		std::unordered_set<ScriptInstance*> m_instances;
+		float m_reload_timer = 0.0f;
+		std::unordered_map<std::string, SharedModule> m_modules;
+		uint32_t m_module_id = 0;
+		std::vector<ScriptInstance*> m_updates;
+
+		// The deferred writes of each chunk of the parallel update, by the index of its first instance
+		struct CommandBuffer
+		{
+			uint32_t start = 0;
+			std::vector<std::function<void()>> commands;
+		};
+		std::deque<CommandBuffer> m_command_buffers;
+		std::mutex m_command_buffers_mutex;
+
+		// Profiling, the durations of calls are added to the profiler as time samples named "class::method"
+		const std::string& GetProfileName(asIScriptFunction* function) const;
+		mutable std::unordered_map<asIScriptFunction*, std::string> m_profile_names;
+		mutable std::mutex m_profile_names_mutex;
+		Profiler* m_profiler = nullptr;
+
+		void ExecuteBatch(asIScriptContext* ctx, const std::vector<ScriptInstance*>& instances, uint32_t start, uint32_t end, bool parallel, float delta_time) const;
 
 		void LogExceptionInfo(asIScriptContext* ctx) const;
 		void message_callback(const asSMessageInfo& msg) const;
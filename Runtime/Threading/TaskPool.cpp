@@ -0,0 +1,84 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ========
+#include "TaskPool.h"
+#include <new>
+//===================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    TaskPool::TaskPool(const size_t block_size, const uint32_t block_count)
+    {
+        // Keep every block aligned to the strictest fundamental alignment
+        const size_t alignment  = alignof(max_align_t);
+        m_block_size            = (block_size + alignment - 1) & ~(alignment - 1);
+        m_block_count           = block_count;
+        m_memory                = make_unique<byte[]>(m_block_size * m_block_count);
+
+        m_blocks_free.reserve(m_block_count);
+        for (uint32_t i = 0; i < m_block_count; i++)
+        {
+            // Reverse order, so that blocks get handed out front to back
+            m_blocks_free.emplace_back(m_memory.get() + m_block_size * (m_block_count - 1 - i));
+        }
+    }
+
+    void* TaskPool::Allocate(const size_t size)
+    {
+        if (size <= m_block_size)
+        {
+            lock_guard<mutex> lock(m_mutex);
+
+            if (!m_blocks_free.empty())
+            {
+                void* ptr = m_blocks_free.back();
+                m_blocks_free.pop_back();
+                return ptr;
+            }
+        }
+
+        return ::operator new(size);
+    }
+
+    void TaskPool::Free(void* ptr)
+    {
+        if (!Owns(ptr))
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+        m_blocks_free.emplace_back(ptr);
+    }
+
+    uint32_t TaskPool::GetBlocksFree()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return static_cast<uint32_t>(m_blocks_free.size());
+    }
+}
@@ -0,0 +1,86 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstddef>
+#include "../Core/EngineDefs.h"
+//=============================
+
+namespace Spartan
+{
+    // A fixed capacity pool of equally sized memory blocks, used to allocate tasks without going to the global allocator.
+    // Allocations which are bigger than a block, or which happen while the pool is exhausted, fall back to the heap.
+    class TaskPool
+    {
+    public:
+        TaskPool(const size_t block_size, const uint32_t block_count);
+        ~TaskPool() = default;
+
+        void* Allocate(const size_t size);
+        void Free(void* ptr);
+
+        size_t GetBlockSize()       const { return m_block_size; }
+        uint32_t GetBlockCount()    const { return m_block_count; }
+        uint32_t GetBlocksFree();
+
+    private:
+        bool Owns(const void* ptr) const { return ptr >= m_memory.get() && ptr < m_memory.get() + m_block_size * m_block_count; }
+
+        std::unique_ptr<std::byte[]> m_memory;
+        std::vector<void*> m_blocks_free;
+        std::mutex m_mutex;
+        size_t m_block_size     = 0;
+        uint32_t m_block_count  = 0;
+    };
+
+    // A minimal allocator which forwards to a TaskPool, meant for std::allocate_shared() so that
+    // the control block and the task end up in a single pooled block.
+    template <typename T>
+    class TaskAllocator
+    {
+    public:
+        typedef T value_type;
+
+        TaskAllocator(const std::shared_ptr<TaskPool>& pool) : m_pool(pool) {}
+        template <typename U>
+        TaskAllocator(const TaskAllocator<U>& other) : m_pool(other.m_pool) {}
+
+        T* allocate(const size_t n)             { return static_cast<T*>(m_pool->Allocate(n * sizeof(T))); }
+        void deallocate(T* ptr, const size_t)   { m_pool->Free(ptr); }
+
+        template <typename U>
+        bool operator==(const TaskAllocator<U>& other) const { return m_pool == other.m_pool; }
+        template <typename U>
+        bool operator!=(const TaskAllocator<U>& other) const { return m_pool != other.m_pool; }
+
+    private:
+        template <typename U> friend class TaskAllocator;
+
+        // Shared, so that task handles which outlive Threading can still be released
+        std::shared_ptr<TaskPool> m_pool;
+    };
+}
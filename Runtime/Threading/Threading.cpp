@@ -22,6 +22,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ================
 #include "Threading.h"
 #include "../Core/Settings.h"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 //===========================
 
 //= NAMESPACES =====
@@ -30,37 +39,150 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace _Threading
+    {
+        // The index of the queue owned by the calling thread, non-worker threads don't own one
+        constexpr uint32_t worker_index_none = numeric_limits<uint32_t>::max();
+        thread_local uint32_t worker_index   = worker_index_none;
+        thread_local Threading_Pool pool     = Threading_Pool_Frame;
+    }
+
+    void TaskQueue::Push(shared_ptr<Task>&& task)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        // Full, double the capacity and unwrap the tasks
+        if (m_count == m_tasks.size())
+        {
+            vector<shared_ptr<Task>> tasks(m_tasks.size() * 2);
+            for (size_t i = 0; i < m_count; i++)
+            {
+                tasks[i] = move(m_tasks[(m_front + i) % m_tasks.size()]);
+            }
+            m_tasks.swap(tasks);
+            m_front = 0;
+        }
+
+        m_tasks[(m_front + m_count) % m_tasks.size()] = move(task);
+        m_count++;
+    }
+
+    bool TaskQueue::Pop(shared_ptr<Task>& task)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        if (m_count == 0)
+            return false;
+
+        m_count--;
+        task = move(m_tasks[(m_front + m_count) % m_tasks.size()]);
+
+        return true;
+    }
+
+    bool TaskQueue::Steal(shared_ptr<Task>& task)
+    {
+        // Don't wait on a queue which is busy, there are other queues to steal from
+        unique_lock<mutex> lock(m_mutex, try_to_lock);
+
+        if (!lock.owns_lock() || m_count == 0)
+            return false;
+
+        task    = move(m_tasks[m_front]);
+        m_front = (m_front + 1) % m_tasks.size();
+        m_count--;
+
+        return true;
+    }
+
+    uint32_t TaskQueue::Clear(vector<shared_ptr<Task>>& tasks)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        const uint32_t count = static_cast<uint32_t>(m_count);
+        for (; m_count != 0; m_count--)
+        {
+            tasks.emplace_back(move(m_tasks[m_front]));
+            m_front = (m_front + 1) % m_tasks.size();
+        }
+
+        return count;
+    }
+
 	Threading::Threading(Context* context) : ISubsystem(context)
 	{
 		m_stopping	                            = false;
         m_thread_count_support                  = thread::hardware_concurrency();
-		m_thread_count                          = m_thread_count_support - 1; // exclude the main (this) thread
         m_thread_names[this_thread::get_id()]   = "main";
+        m_thread_main                           = this_thread::get_id();
+
+        // The frame gets a worker for every core (except the main thread's), the lower priority pools are
+        // smaller and share the same cores, they only really run when the frame workers are asleep.
+        const uint32_t frame_count = min(max(m_thread_count_support, 1u) - 1, threading_worker_count_max);
+        m_pools[Threading_Pool_Frame].name              = "frame";
+        m_pools[Threading_Pool_Frame].worker_count      = frame_count;
+        m_pools[Threading_Pool_Shaders].name            = "shaders";
+        m_pools[Threading_Pool_Shaders].worker_count    = frame_count != 0 ? max(frame_count / 2, 1u) : 0;
+        m_pools[Threading_Pool_Background].name         = "background";
+        m_pools[Threading_Pool_Background].worker_count = frame_count != 0 ? max(frame_count / 4, 1u) : 0;
+
+        for (uint32_t i = 0; i < Threading_Pool_Count; i++)
+        {
+            m_pools[i].worker_first = m_thread_count;
+            m_thread_count          += m_pools[i].worker_count;
+        }
+
+        // Leave room for the shared_ptr control block which allocate_shared() places in front of the task
+        m_task_pool = make_shared<TaskPool>(sizeof(Task) + 64, threading_task_pool_capacity);
+
+        // Create the queues before the threads, since every thread can steal from any queue of its pool
+        for (uint32_t i = 0; i < m_thread_count; i++)
+        {
+            m_queues.emplace_back(make_unique<TaskQueue>());
+        }
+
+        for (uint32_t pool_index = 0; pool_index < Threading_Pool_Count; pool_index++)
+        {
+            const Threading_Pool pool = static_cast<Threading_Pool>(pool_index);
 
-		for (uint32_t i = 0; i < m_thread_count; i++)
-		{
-			m_threads.emplace_back(thread(&Threading::ThreadLoop, this));
-            m_thread_names[m_threads.back().get_id()] = "worker_" + to_string(i);
-		}
+		    for (uint32_t i = 0; i < m_pools[pool].worker_count; i++)
+		    {
+			    m_threads.emplace_back(thread(&Threading::ThreadLoop, this, pool, m_pools[pool].worker_first + i));
+                m_thread_names[m_threads.back().get_id()] = string(m_pools[pool].name) + "_" + to_string(i);
+                ConfigureThread(m_threads.back(), pool, i);
+		    }
+        }
 
-		LOG_INFO("%d threads have been created", m_thread_count);
+		LOG_INFO("%d threads have been created (%d frame, %d shaders, %d background)",
+            m_thread_count,
+            m_pools[Threading_Pool_Frame].worker_count,
+            m_pools[Threading_Pool_Shaders].worker_count,
+            m_pools[Threading_Pool_Background].worker_count
+        );
 	}
 
     Threading::~Threading()
     {
         Flush(true);
 
-        // Put unique lock on task mutex.
-        unique_lock<mutex> lock(m_mutex_tasks);
+        // Set termination flag to true, under every sleep mutex so that no worker misses it
+        for (Pool& pool : m_pools)
+        {
+            pool.mutex_sleep.lock();
+        }
 
-        // Set termination flag to true.
         m_stopping = true;
 
-        // Unlock the mutex
-        lock.unlock();
+        for (Pool& pool : m_pools)
+        {
+            pool.mutex_sleep.unlock();
+        }
 
         // Wake up all threads.
-        m_condition_var.notify_all();
+        for (Pool& pool : m_pools)
+        {
+            pool.condition_var.notify_all();
+        }
 
         // Join all threads.
         for (auto& thread : m_threads)
@@ -72,59 +194,421 @@ namespace Spartan
         m_threads.clear();
     }
 
-    uint32_t Threading::GetThreadsAvailable() const
+    bool Threading::IsWorkerThread() const
     {
-        uint32_t available_threads = m_thread_count;
+        return _Threading::worker_index != _Threading::worker_index_none;
+    }
 
-        for (const auto& task : m_tasks)
-        {
-            available_threads -= task->IsExecuting() ? 1 : 0;
-        }
+    const string& Threading::GetThreadName(const thread::id thread_id) const
+    {
+        static const string unknown = "unknown";
 
-        return available_threads;
+        const auto it = m_thread_names.find(thread_id);
+        return it != m_thread_names.end() ? it->second : unknown;
     }
 
     void Threading::Flush(bool removed_queued /*= false*/)
     {
-        // Clear any queued tasks
+        // Remove any queued tasks, they are marked as done so that nothing waits on them (or on their successors) forever
         if (removed_queued)
         {
-            m_tasks.clear();
+            vector<shared_ptr<Task>> tasks;
+            for (Pool& pool : m_pools)
+            {
+                for (uint32_t i = pool.worker_first; i < pool.worker_first + pool.worker_count; i++)
+                {
+                    const uint32_t count = m_queues[i]->Clear(tasks);
+                    pool.tasks_queued   -= count;
+                    m_tasks_queued      -= count;
+                }
+            }
+
+            {
+                lock_guard<mutex> lock(m_mutex_main);
+                for (shared_ptr<Task>& task : m_tasks_main)
+                {
+                    tasks.emplace_back(move(task));
+                }
+                m_tasks_main.clear();
+                m_tasks_main_queued = 0;
+            }
+
+            for (shared_ptr<Task>& task : tasks)
+            {
+                Cancel(task);
+            }
+
+            NotifyWaiters();
+        }
+
+        // Wait for what's left, every task which finishes notifies the waiters
+        unique_lock<mutex> lock(m_mutex_wait);
+        m_waiters++;
+        m_condition_var_wait.wait(lock, [this] { return m_tasks_queued.load() == 0 && !AreTasksRunning(); });
+        m_waiters--;
+    }
+
+    void Threading::Wait(const shared_ptr<Task>& task)
+    {
+        if (!task)
+            return;
+
+        // Only help with tasks of the caller's own pool, the main thread waiting on the frame must never pick up an import
+        const Threading_Pool pool = _Threading::pool;
+
+        // Main thread tasks which the awaited task doesn't depend on are left for Threading::Tick(),
+        // running them here would race with whatever the main thread is in the middle of
+        const bool is_main          = this_thread::get_id() == m_thread_main;
+        uint64_t main_submitted     = 0;
+        while (!task->IsDone())
+        {
+            // A main thread task which the awaited task depends on (or is) can only be run by the main thread itself
+            if (is_main)
+            {
+                main_submitted = m_tasks_main_submitted.load();
+                if (m_tasks_main_queued.load() != 0 && RunTaskMain(task))
+                    continue;
+            }
+
+            // Help out instead of idling, this is also what prevents workers which wait on each other from deadlocking
+            shared_ptr<Task> task_other;
+            if (GetTask(pool, _Threading::worker_index, task_other))
+            {
+                RunTask(task_other);
+                continue;
+            }
+
+            // Nothing to help with, sleep until a task completes or a new one is submitted
+            unique_lock<mutex> lock(m_mutex_wait);
+            m_waiters++;
+            m_condition_var_wait.wait(lock, [this, &task, pool, is_main, main_submitted] { return task->IsDone() || m_pools[pool].tasks_queued.load() != 0 || (is_main && m_tasks_main_submitted.load() != main_submitted); });
+            m_waiters--;
+        }
+    }
+
+    void Threading::Wait(const vector<shared_ptr<Task>>& tasks)
+    {
+        for (const shared_ptr<Task>& task : tasks)
+        {
+            Wait(task);
+        }
+    }
+
+    void Threading::Schedule(const shared_ptr<Task>& task, const vector<shared_ptr<Task>>& dependencies)
+    {
+        // Hold an extra dependency while linking, so that dependencies which finish in the meantime can't submit the task early
+        task->m_dependencies_pending    = 1;
+        task->m_memory_tag              = MemoryTracker::GetTag();
+
+        for (const shared_ptr<Task>& dependency : dependencies)
+        {
+            if (!dependency)
+                continue;
+
+            lock_guard<mutex> lock(dependency->m_mutex_successors);
+
+            if (dependency->IsDone())
+                continue;
+
+            task->m_dependencies_pending++;
+            dependency->m_successors.emplace_back(task);
+        }
+
+        if (--task->m_dependencies_pending == 0)
+        {
+            Submit(task);
+        }
+    }
+
+    Threading_Pool Threading::GetCallerPool() const
+    {
+        return _Threading::pool;
+    }
+
+    void Threading::Submit(shared_ptr<Task> task)
+    {
+        // Tasks for the main thread wait for its next tick (or for it to wait on them)
+        if (task->m_pool == Threading_Pool_Main)
+        {
+            {
+                lock_guard<mutex> lock(m_mutex_main);
+                m_tasks_main.emplace_back(move(task));
+                m_tasks_main_queued++;
+                m_tasks_main_submitted++;
+            }
+
+            NotifyWaiters();
+            return;
+        }
+
+        Pool& pool = m_pools[task->m_pool];
+
+        // Workers push to their own queue (if the task is for their pool), any other thread distributes tasks in a round-robin fashion
+        uint32_t queue_index = _Threading::worker_index;
+        if (queue_index == _Threading::worker_index_none || _Threading::pool != task->m_pool)
+        {
+            queue_index = pool.worker_first + pool.queue_next++ % pool.worker_count;
+        }
+
+        m_queues[queue_index]->Push(move(task));
+        pool.tasks_queued++;
+        m_tasks_queued++;
+
+        // Acquiring the sleep mutex ensures that a worker which is about to sleep will see the new task
+        {
+            lock_guard<mutex> lock(pool.mutex_sleep);
+        }
+
+        // Wake up a thread
+        pool.condition_var.notify_one();
+
+        // Threads blocked in Wait() can execute it too
+        NotifyWaiters();
+    }
+
+    bool Threading::GetTask(const Threading_Pool pool_type, const uint32_t worker_index, shared_ptr<Task>& task)
+    {
+        Pool& pool = m_pools[pool_type];
+        if (pool.worker_count == 0)
+            return false;
+
+        // Non-worker threads (that are helping while waiting) don't own a queue, so they can only steal
+        const bool is_worker    = worker_index != _Threading::worker_index_none;
+        bool found              = is_worker && m_queues[worker_index]->Pop(task);
+
+        // Start with the neighbouring worker, so that thieves spread out instead of all hitting the same queue
+        const uint32_t start = is_worker ? worker_index - pool.worker_first : 0;
+        for (uint32_t pass = 0; !found && pass < threading_steal_passes; pass++)
+        {
+            for (uint32_t i = is_worker ? 1 : 0; !found && i < pool.worker_count; i++)
+            {
+                found = m_queues[pool.worker_first + (start + i) % pool.worker_count]->Steal(task);
+            }
+        }
+
+        if (found)
+        {
+            // Mark as executing before it stops counting as queued, so Flush() never sees a gap
+            m_tasks_executing++;
+            pool.tasks_queued--;
+            m_tasks_queued--;
+        }
+
+        return found;
+    }
+
+    void Threading::ConfigureThread(thread& thread, const Threading_Pool pool, const uint32_t pool_worker_index)
+    {
+        const bool pin = threading_pin_frame_workers && pool == Threading_Pool_Frame;
+
+    #if defined(_WIN32)
+        const HANDLE handle = static_cast<HANDLE>(thread.native_handle());
+
+        int priority = THREAD_PRIORITY_NORMAL;
+        priority     = pool == Threading_Pool_Shaders    ? THREAD_PRIORITY_BELOW_NORMAL : priority;
+        priority     = pool == Threading_Pool_Background ? THREAD_PRIORITY_LOWEST       : priority;
+        if (!SetThreadPriority(handle, priority))
+        {
+            LOG_WARNING("Failed to set the priority of a %s thread", m_pools[pool].name);
+        }
+
+        if (pin && !SetThreadAffinityMask(handle, DWORD_PTR(1) << ((pool_worker_index + 1) % (sizeof(DWORD_PTR) * 8))))
+        {
+            LOG_WARNING("Failed to pin a %s thread", m_pools[pool].name);
+        }
+    #elif defined(__linux__)
+        // Without privileges the only way to lower the priority of a single thread is its scheduling policy
+        if (pool != Threading_Pool_Frame)
+        {
+            sched_param param = {};
+            if (pthread_setschedparam(thread.native_handle(), pool == Threading_Pool_Background ? SCHED_IDLE : SCHED_BATCH, &param) != 0)
+            {
+                LOG_WARNING("Failed to set the priority of a %s thread", m_pools[pool].name);
+            }
         }
 
-        // If so, wait for them
-        while (AreTasksRunning())
+        if (pin)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET((pool_worker_index + 1) % CPU_SETSIZE, &cpu_set);
+            if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set) != 0)
+            {
+                LOG_WARNING("Failed to pin a %s thread", m_pools[pool].name);
+            }
         }
+    #endif
     }
 
-    void Threading::ThreadLoop()
+    void Threading::ThreadLoop(const Threading_Pool pool_type, const uint32_t worker_index)
     {
+        _Threading::worker_index    = worker_index;
+        _Threading::pool            = pool_type;
+        Pool& pool                  = m_pools[pool_type];
+
         shared_ptr<Task> task;
         while (true)
         {
-            // Lock tasks mutex
-            unique_lock<mutex> lock(m_mutex_tasks);
+            // Execute the task.
+            if (GetTask(pool_type, worker_index, task))
+            {
+                RunTask(task);
+                continue;
+            }
+
+            // Lock the sleep mutex
+            unique_lock<mutex> lock(pool.mutex_sleep);
 
             // Check condition on notification
-            m_condition_var.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+            pool.condition_var.wait(lock, [this, &pool] { return pool.tasks_queued.load() != 0 || m_stopping; });
 
             // If m_stopping is true, it's time to shut everything down
-            if (m_stopping && m_tasks.empty())
+            if (m_stopping && pool.tasks_queued.load() == 0)
                 return;
+        }
+    }
+
+    void Threading::RunTask(shared_ptr<Task>& task)
+    {
+        {
+            MemoryTagScope memory_tag(task->m_memory_tag);
+            task->Execute();
+        }
 
-            // Get next task in the queue.
-            task = m_tasks.front();
+        // Mark as done and take the successors, any task which links to this one from now on will see it as done
+        vector<shared_ptr<Task>> successors;
+        {
+            lock_guard<mutex> lock(task->m_mutex_successors);
+            task->m_done = true;
+            successors.swap(task->m_successors);
+        }
 
-            // Remove it from the queue.
-            m_tasks.pop_front();
+        // Submit the successors which were only waiting for this task
+        for (shared_ptr<Task>& successor : successors)
+        {
+            if (--successor->m_dependencies_pending == 0)
+            {
+                Submit(move(successor));
+            }
+        }
 
-            // Unlock the mutex
-            lock.unlock();
+        task.reset();
 
-            // Execute the task.
-            task->Execute();
+        // Successors have been queued (if any) before this stops counting as executing, so Flush() never sees a gap
+        m_tasks_executing--;
+
+        NotifyWaiters();
+    }
+
+    void Threading::Tick(float delta_time)
+    {
+        RunTasksMain();
+    }
+
+    void Threading::Cancel(shared_ptr<Task>& task)
+    {
+        vector<shared_ptr<Task>> successors;
+        {
+            lock_guard<mutex> lock(task->m_mutex_successors);
+            task->m_done = true;
+            successors.swap(task->m_successors);
+        }
+
+        // A successor which was only waiting for this task would never be submitted, so it's cancelled too
+        for (shared_ptr<Task>& successor : successors)
+        {
+            if (--successor->m_dependencies_pending == 0)
+            {
+                Cancel(successor);
+            }
+        }
+
+        task.reset();
+    }
+
+    bool Threading::RunTasksMain()
+    {
+        // Tasks which these tasks submit to the main thread run on the next tick
+        vector<shared_ptr<Task>> tasks;
+        {
+            lock_guard<mutex> lock(m_mutex_main);
+            tasks.swap(m_tasks_main);
+            m_tasks_main_queued = 0;
+        }
+
+        for (shared_ptr<Task>& task : tasks)
+        {
+            m_tasks_executing++;
+            RunTask(task);
+        }
+
+        return !tasks.empty();
+    }
+
+    bool Threading::RunTaskMain(const shared_ptr<Task>& task)
+    {
+        // Look for one without holding the queue's lock, the search takes the locks of the successors
+        vector<shared_ptr<Task>> candidates;
+        {
+            lock_guard<mutex> lock(m_mutex_main);
+            candidates = m_tasks_main;
+        }
+
+        shared_ptr<Task> task_main;
+        for (const shared_ptr<Task>& candidate : candidates)
+        {
+            if (candidate == task || Precedes(candidate.get(), task.get()))
+            {
+                task_main = candidate;
+                break;
+            }
         }
+
+        if (!task_main)
+            return false;
+
+        {
+            lock_guard<mutex> lock(m_mutex_main);
+            auto it = find(m_tasks_main.begin(), m_tasks_main.end(), task_main);
+            if (it == m_tasks_main.end())
+                return false;
+
+            m_tasks_main.erase(it);
+            m_tasks_main_queued--;
+        }
+
+        m_tasks_executing++;
+        RunTask(task_main);
+
+        return true;
+    }
+
+    bool Threading::Precedes(Task* task, const Task* successor)
+    {
+        vector<shared_ptr<Task>> successors;
+        {
+            lock_guard<mutex> lock(task->m_mutex_successors);
+            successors = task->m_successors;
+        }
+
+        for (const shared_ptr<Task>& other : successors)
+        {
+            if (other.get() == successor || Precedes(other.get(), successor))
+                return true;
+        }
+
+        return false;
+    }
+
+    void Threading::NotifyWaiters()
+    {
+        if (m_waiters.load() == 0)
+            return;
+
+        {
+            lock_guard<mutex> lock(m_mutex_wait);
+        }
+
+        m_condition_var_wait.notify_all();
     }
 }
@@ -25,115 +25,358 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include <thread>
 #include <mutex>
-#include <deque>
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <unordered_map>
-#include <functional>
+#include <type_traits>
+#include <new>
+#include "TaskPool.h"
 #include "../Logging/Log.h"
+#include "../Profiling/MemoryTracker.h"
 #include "../Core/ISubsystem.h"
 //=============================
 
 namespace Spartan
 {
+    //= SCHEDULER CONFIGURATION =============================================================================
+    // Upper limit of worker threads, the remaining hardware threads (if any) are left to the OS
+    constexpr uint32_t threading_worker_count_max   = 32;
+    // How many full passes over the other workers' queues an idle worker makes before it goes to sleep
+    constexpr uint32_t threading_steal_passes       = 2;
+    // Bytes of inline storage for a task's callable, callables with bigger captures go to the heap
+    constexpr uint32_t threading_task_storage_size  = 64;
+    // Number of tasks which can be alive at the same time before task allocation falls back to the heap
+    constexpr uint32_t threading_task_pool_capacity = 4096;
+    // Pin each frame worker to its own core (core 0 is left to the main thread), helps on machines with a busy OS
+    constexpr bool threading_pin_frame_workers      = false;
+    //=======================================================================================================
+
+    // Every pool has its own workers and queues, workers only ever execute tasks of their own pool.
+    // The background and shader pools run at a lower OS priority, so their work only gets the cycles the frame doesn't use.
+    enum Threading_Pool : uint32_t
+    {
+        Threading_Pool_Frame,       // work which a frame waits for, as many workers as there are cores
+        Threading_Pool_Shaders,     // shader compilation
+        Threading_Pool_Background,  // asset import/loading, file I/O and anything else which can take its time
+        Threading_Pool_Count,
+        Threading_Pool_Caller,      // the pool of the calling worker, the frame pool if the caller is not a worker
+        Threading_Pool_Main         // the main thread, at the start of its next Threading::Tick(), for work which touches the world or creates GPU resources
+    };
+
+    // A move-only, type-erased callable which stores small callables inline (unlike std::function, the size is ours to pick)
+    class TaskFunction
+    {
+    public:
+        template <typename Function>
+        TaskFunction(Function&& function)
+        {
+            typedef typename std::decay<Function>::type callable_type;
+
+            if constexpr (sizeof(callable_type) <= sizeof(m_storage) && alignof(callable_type) <= alignof(std::max_align_t))
+            {
+                m_callable  = new (m_storage) callable_type(std::forward<Function>(function));
+                m_destroy   = [](void* callable) { static_cast<callable_type*>(callable)->~callable_type(); };
+            }
+            else
+            {
+                m_callable  = new callable_type(std::forward<Function>(function));
+                m_destroy   = [](void* callable) { delete static_cast<callable_type*>(callable); };
+            }
+
+            m_invoke = [](void* callable) { (*static_cast<callable_type*>(callable))(); };
+        }
+
+        ~TaskFunction() { m_destroy(m_callable); }
+
+        TaskFunction(const TaskFunction&)               = delete;
+        TaskFunction& operator=(const TaskFunction&)    = delete;
+
+        void operator()() { m_invoke(m_callable); }
+
+    private:
+        alignas(std::max_align_t) std::byte m_storage[threading_task_storage_size];
+        void* m_callable                = nullptr;
+        void (*m_invoke)(void*)         = nullptr;
+        void (*m_destroy)(void*)        = nullptr;
+    };
+
 	class Task
 	{
 	public:
-		typedef std::function<void()> function_type;
-
-		Task(function_type&& function)  { m_function = std::forward<function_type>(function); }
-        void Execute()                  { m_is_executing = true; m_function(); m_is_executing = false; }
-        bool IsExecuting() const { return m_is_executing; }
+        template <typename Function>
+		Task(Function&& function) : m_function(std::forward<Function>(function)) {}
+        void Execute()                  { m_function(); }
+        bool IsDone() const             { return m_done.load(); }
 
 	private:
-        bool m_is_executing = false;
-		function_type m_function;
+        friend class Threading;
+
+		TaskFunction m_function;
+        Threading_Pool m_pool = Threading_Pool_Frame;
+        Memory_Tag m_memory_tag = Memory_Tag_Other; // the tag of the thread which added the task
+
+        // Graph
+        std::atomic<bool> m_done                        = false;
+        std::atomic<uint32_t> m_dependencies_pending    = 0;
+        std::vector<std::shared_ptr<Task>> m_successors;
+        std::mutex m_mutex_successors;
 	};
 
+    // A queue which is owned by a single worker. The owner pushes and pops from the back (LIFO, cache friendly),
+    // while other workers steal from the front (FIFO, oldest and usually biggest tasks first).
+    // It's a ring buffer which only grows, so once warmed up it doesn't allocate.
+    class TaskQueue
+    {
+    public:
+        TaskQueue() { m_tasks.resize(256); }
+
+        void Push(std::shared_ptr<Task>&& task);
+        bool Pop(std::shared_ptr<Task>& task);
+        bool Steal(std::shared_ptr<Task>& task);
+        // Moves the queued tasks out, returns how many there were
+        uint32_t Clear(std::vector<std::shared_ptr<Task>>& tasks);
+
+    private:
+        std::vector<std::shared_ptr<Task>> m_tasks;
+        size_t m_front  = 0;
+        size_t m_count  = 0;
+        std::mutex m_mutex;
+    };
+
+    // The shared state of a ParallelFor(), threads claim chunks by incrementing an atomic counter
+    template <typename Function>
+    class ParallelForLoop
+    {
+    public:
+        ParallelForLoop(Function& function, const uint32_t range, const uint32_t grain_size) : m_function(function)
+        {
+            m_range         = range;
+            m_grain_size    = grain_size;
+        }
+
+        void Run()
+        {
+            for (uint32_t start = m_next.fetch_add(m_grain_size); start < m_range; start = m_next.fetch_add(m_grain_size))
+            {
+                m_function(start, std::min(start + m_grain_size, m_range));
+            }
+        }
+
+    private:
+        Function& m_function;
+        std::atomic<uint32_t> m_next    = 0;
+        uint32_t m_range                = 0;
+        uint32_t m_grain_size           = 0;
+    };
+
 	class Threading : public ISubsystem
 	{
 	public:
 		Threading(Context* context);
         ~Threading();
 
-		// Add a task
+        //= ISubsystem ======================
+        void Tick(float delta_time) override;
+        //===================================
+
+		// Add a task, it will only start executing once all of its dependencies have finished
 		template <typename Function>
-		void AddTask(Function&& function)
+		std::shared_ptr<Task> AddTask(Function&& function, const std::vector<std::shared_ptr<Task>>& dependencies = {}, Threading_Pool pool = Threading_Pool_Caller)
 		{
+            // The control block and the task share a single block from the pool
+            std::shared_ptr<Task> task = std::allocate_shared<Task>(TaskAllocator<Task>(m_task_pool), std::forward<Function>(function));
+            task->m_pool = pool != Threading_Pool_Caller ? pool : GetCallerPool();
+
 			if (m_threads.empty())
 			{
 				LOG_WARNING("No available threads, function will execute in the same thread");
-				function();
-				return;
+				task->Execute();
+                task->m_done = true;
+				return task;
 			}
 
-			// Lock tasks mutex
-			std::unique_lock<std::mutex> lock(m_mutex_tasks);
-
-			// Save the task
-			m_tasks.push_back(std::make_shared<Task>(std::bind(std::forward<Function>(function))));
+            Schedule(task, dependencies);
 
-			// Unlock the mutex
-			lock.unlock();
-
-			// Wake up a thread
-			m_condition_var.notify_one();
+			return task;
 		}
 
-        // Adds a task which is a loop and executes chunks of it in parallel
+        // Waits for a task to finish, the calling thread executes other tasks in the meantime
+        void Wait(const std::shared_ptr<Task>& task);
+        // Waits for multiple tasks to finish
+        void Wait(const std::vector<std::shared_ptr<Task>>& tasks);
+
+        // Executes function(start, end) over [0, range) in parallel, chunks of grain_size are handed out dynamically
+        // and the calling thread takes part in the work. A grain_size of zero lets Threading pick one.
         template <typename Function>
-        void AddTaskLoop(Function&& function, uint32_t range)
+        void ParallelFor(Function&& function, const uint32_t range, uint32_t grain_size = 0)
         {
-            uint32_t available_threads  = GetThreadsAvailable();
-            vector<bool> tasks_done     = vector<bool>(available_threads, false);
-            const uint32_t task_count   = available_threads + 1; // plus one for the current thread
+            if (range == 0)
+                return;
 
-            uint32_t start  = 0;
-            uint32_t end    = 0;
-            for (uint32_t i = 0; i < available_threads; i++)
+            // A few chunks per thread, so that threads which finish early can pick up the slack.
+            // The helpers go to the caller's pool, so a loop which runs in the background stays there.
+            const uint32_t worker_count = GetThreadCount(GetCallerPool());
+            const uint32_t thread_count = worker_count + 1; // plus one for the calling thread
+            if (grain_size == 0)
             {
-                start   = (range / task_count) * i;
-                end     = start + (range / task_count);
+                grain_size = std::max(range / (thread_count * 4), 1u);
+            }
+
+            const uint32_t chunk_count = (range + grain_size - 1) / grain_size;
+            if (m_threads.empty() || chunk_count == 1)
+            {
+                function(0, range);
+                return;
+            }
 
-                // Kick off task
-                AddTask([&function, &tasks_done, i, start, end] { function(start, end); tasks_done[i] = true; });
+            // The loop state lives on this stack frame, tasks only capture a pointer to it (so they fit in TaskFunction's inline storage)
+            ParallelForLoop<Function> loop(function, range, grain_size);
+            const uint32_t helper_count = std::min(worker_count, chunk_count - 1);
+            std::array<std::shared_ptr<Task>, threading_worker_count_max> helpers;
+            for (uint32_t i = 0; i < helper_count; i++)
+            {
+                helpers[i] = AddTask([&loop]() { loop.Run(); });
             }
 
-            // Do last task in the current thread
-            function(end, range);
+            loop.Run();
 
-            // Wait till the threads are done
-            uint32_t tasks = 0;
-            while (tasks != tasks_done.size())
+            // The chunks are all taken, wait for the helpers which are still working on theirs
+            for (uint32_t i = 0; i < helper_count; i++)
             {
-                tasks = 0;
-                for (const bool job_done : tasks_done)
-                {
-                    tasks += job_done ? 1 : 0;
-                }
+                Wait(helpers[i]);
             }
         }
 
         // Get the number of threads used
         uint32_t GetThreadCount()           const { return m_thread_count; }
+        // Get the number of threads of a pool
+        uint32_t GetThreadCount(Threading_Pool pool) const { return pool < Threading_Pool_Count ? m_pools[pool].worker_count : 0; }
         // Get the maximum number of threads the hardware supports
         uint32_t GetThreadCountSupport()    const { return m_thread_count_support; }
         // Get the number of threads which are not doing any work
-        uint32_t GetThreadsAvailable()      const;
+        uint32_t GetThreadsAvailable()      const { return m_thread_count - m_tasks_executing.load(); }
         // Returns true if at least one task is running
-        bool AreTasksRunning()              const { return GetThreadsAvailable() != GetThreadCount(); }
-        // Waits for all executing (and queued if requested) tasks to finish
+        bool AreTasksRunning()              const { return m_tasks_executing.load() != 0; }
+        // Waits for all executing tasks to finish, queued tasks are either waited for too or (if requested) removed and marked as done without running
         void Flush(bool removed_queued = false);
+        // Returns true if the calling thread is one of the workers
+        bool IsWorkerThread() const;
+        // Get the name of a worker (or the main thread), the names don't change once the threads are created
+        const std::string& GetThreadName(std::thread::id thread_id) const;
 
 	private:
+        struct Pool
+        {
+            const char* name        = nullptr;
+            uint32_t worker_first   = 0; // workers (and their queues) of a pool are contiguous
+            uint32_t worker_count   = 0;
+            std::atomic<uint32_t> queue_next    = 0;
+            std::atomic<uint32_t> tasks_queued  = 0;
+            std::mutex mutex_sleep;
+            std::condition_variable condition_var;
+        };
+
+        // Returns the pool of the calling worker, or the frame pool for any other thread
+        Threading_Pool GetCallerPool() const;
+        // Links a task to its dependencies and submits it if there is nothing to wait for
+        void Schedule(const std::shared_ptr<Task>& task, const std::vector<std::shared_ptr<Task>>& dependencies);
+        // Places a task in a worker queue and wakes up a sleeping worker
+        void Submit(std::shared_ptr<Task> task);
+        // Gets a task from the worker's own queue, or steals one from another worker of the same pool
+        bool GetTask(Threading_Pool pool, uint32_t worker_index, std::shared_ptr<Task>& task);
+        // Executes a task, releases its successors and notifies any waiters
+        void RunTask(std::shared_ptr<Task>& task);
+        // Marks a task which will never run as done, along with the successors which were only waiting for it
+        void Cancel(std::shared_ptr<Task>& task);
+        // Executes the tasks which were submitted to the main thread, returns false if there were none
+        bool RunTasksMain();
+        // Executes a task which was submitted to the main thread and which the given task is or depends on, returns false if none is queued
+        bool RunTaskMain(const std::shared_ptr<Task>& task);
+        // Returns true if the successor depends on the task, directly or through other tasks
+        static bool Precedes(Task* task, const Task* successor);
+        // Wakes up threads which are blocked in Wait()
+        void NotifyWaiters();
+        // Applies the OS priority of the pool and, optionally, pins the worker to a core
+        void ConfigureThread(std::thread& thread, Threading_Pool pool, uint32_t pool_worker_index);
         // This function is invoked by the threads
-        void ThreadLoop();
+        void ThreadLoop(Threading_Pool pool, uint32_t worker_index);
 
 		uint32_t m_thread_count         = 0;
         uint32_t m_thread_count_support = 0;
 		std::vector<std::thread> m_threads;
-		std::deque<std::shared_ptr<Task>> m_tasks;
-		std::mutex m_mutex_tasks;
-		std::condition_variable m_condition_var;
+        std::vector<std::unique_ptr<TaskQueue>> m_queues;
+        std::array<Pool, Threading_Pool_Count> m_pools;
+        std::shared_ptr<TaskPool> m_task_pool;
+        std::atomic<uint32_t> m_tasks_queued    = 0;
+        std::atomic<uint32_t> m_tasks_executing = 0;
+        std::atomic<uint32_t> m_waiters = 0;
+        std::mutex m_mutex_wait;
+        std::condition_variable m_condition_var_wait;
         std::unordered_map<std::thread::id, std::string> m_thread_names;
 		bool m_stopping;
+
+        // Tasks for the main thread (see Threading_Pool_Main)
+        std::thread::id m_thread_main;
+        std::vector<std::shared_ptr<Task>> m_tasks_main;
+        std::atomic<uint32_t> m_tasks_main_queued = 0;
+        std::atomic<uint64_t> m_tasks_main_submitted = 0; // only grows, so that a waiting main thread can tell when there are new ones
+        std::mutex m_mutex_main;
 	};
+
+    // Stages of work which run one after the other, each on the pool it names (the main thread included), instead of nested
+    // AddTask() calls and is-busy flags. A stage is only scheduled once the one before it finished, so no thread blocks in between.
+    // A stage which returns false ends the chain, the stages after it are skipped. The stages share state through what they capture.
+    class TaskChain
+    {
+    public:
+        TaskChain() = default;
+        TaskChain(Threading* threading) : m_threading(threading), m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+        template <typename Function>
+        TaskChain& Then(const Threading_Pool pool, Function&& function)
+        {
+            std::shared_ptr<std::atomic<bool>> cancelled = m_cancelled;
+            m_task = m_threading->AddTask([cancelled, function = std::forward<Function>(function)]() mutable
+            {
+                if (cancelled->load())
+                    return;
+
+                if constexpr (std::is_same<std::invoke_result_t<std::decay_t<Function>&>, bool>::value)
+                {
+                    if (!function())
+                    {
+                        *cancelled = true;
+                    }
+                }
+                else
+                {
+                    function();
+                }
+            }, { m_task }, pool);
+
+            return *this;
+        }
+
+        // The last stage, the chain is done when it is (whether it ran or was skipped)
+        const std::shared_ptr<Task>& GetTask() const    { return m_task; }
+        bool IsDone() const                             { return !m_task || m_task->IsDone(); }
+        bool IsCancelled() const                        { return m_cancelled && m_cancelled->load(); }
+
+        // Skips the stages which haven't started and waits for the one which is running, for owners which go away before the chain is done
+        void Cancel()
+        {
+            if (!m_task)
+                return;
+
+            *m_cancelled = true;
+            m_threading->Wait(m_task);
+        }
+
+    private:
+        Threading* m_threading = nullptr;
+        std::shared_ptr<Task> m_task;
+        std::shared_ptr<std::atomic<bool>> m_cancelled;
+    };
 }
@@ -23,8 +23,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =====================
 #include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Vertex.h"
+#include "../Math/BoundingBox.h"
 //================================
 
 namespace Spartan::Utility::Geometry
@@ -287,4 +292,353 @@ namespace Spartan::Utility::Geometry
 	{
 		CreateCylinder(vertices, indices, 0.0f, radius, height);
 	}
+
+	// Simplifies a mesh by vertex clustering, the bounding box is split into grid_size^3 cells and the vertices of a cell collapse into one.
+	// The survivor is an existing vertex (the one closest to the cell's average), so the result indexes the same vertices as the input.
+	// Vertices only collapse with vertices which face roughly the same way, so hard edges survive. The error is at most a cell's diagonal.
+	static void Simplify(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, const std::vector<uint32_t>& indices, const Math::BoundingBox& bounding_box, const uint32_t grid_size, std::vector<uint32_t>* indices_simplified)
+	{
+		using namespace Math;
+
+		indices_simplified->clear();
+		if (vertices.empty() || indices.empty() || grid_size == 0)
+			return;
+
+		struct Cluster
+		{
+			Vector3 position_sum		= Vector3::Zero;
+			uint32_t vertex_count		= 0;
+			uint32_t vertex_survivor	= 0;
+			float distance_survivor		= std::numeric_limits<float>::max();
+		};
+
+		// The cell and the dominant normal axis (6 directions) of every vertex
+		const Vector3 size			= bounding_box.GetSize();
+		const Vector3 cell_scale	= Vector3
+		(
+			size.x > 0.0f ? grid_size / size.x : 0.0f,
+			size.y > 0.0f ? grid_size / size.y : 0.0f,
+			size.z > 0.0f ? grid_size / size.z : 0.0f
+		);
+		auto cluster_key = [&bounding_box, &cell_scale, grid_size](const RHI_Vertex_PosTexNorTan& vertex)
+		{
+			const Vector3 cell = (Vector3(vertex.pos[0], vertex.pos[1], vertex.pos[2]) - bounding_box.GetMin()) * cell_scale;
+			const uint64_t x = std::min(static_cast<uint64_t>(std::max(cell.x, 0.0f)), static_cast<uint64_t>(grid_size - 1));
+			const uint64_t y = std::min(static_cast<uint64_t>(std::max(cell.y, 0.0f)), static_cast<uint64_t>(grid_size - 1));
+			const uint64_t z = std::min(static_cast<uint64_t>(std::max(cell.z, 0.0f)), static_cast<uint64_t>(grid_size - 1));
+
+			const float nx = vertex.nor[0], ny = vertex.nor[1], nz = vertex.nor[2];
+			uint64_t direction = 0;
+			if (Helper::Abs(nx) >= Helper::Abs(ny) && Helper::Abs(nx) >= Helper::Abs(nz))	direction = nx >= 0.0f ? 0 : 1;
+			else if (Helper::Abs(ny) >= Helper::Abs(nz))									direction = ny >= 0.0f ? 2 : 3;
+			else																			direction = nz >= 0.0f ? 4 : 5;
+
+			return ((z * grid_size + y) * grid_size + x) * 6 + direction;
+		};
+
+		// Average every cluster
+		std::vector<uint64_t> vertex_keys(vertices.size());
+		std::unordered_map<uint64_t, Cluster> clusters;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(vertices.size()); i++)
+		{
+			vertex_keys[i]		= cluster_key(vertices[i]);
+			Cluster& cluster	= clusters[vertex_keys[i]];
+			cluster.position_sum += Vector3(vertices[i].pos[0], vertices[i].pos[1], vertices[i].pos[2]);
+			cluster.vertex_count++;
+		}
+
+		// Pick the survivors
+		for (uint32_t i = 0; i < static_cast<uint32_t>(vertices.size()); i++)
+		{
+			Cluster& cluster		= clusters[vertex_keys[i]];
+			const float distance	= Vector3::DistanceSquared(Vector3(vertices[i].pos[0], vertices[i].pos[1], vertices[i].pos[2]), cluster.position_sum / static_cast<float>(cluster.vertex_count));
+			if (distance < cluster.distance_survivor)
+			{
+				cluster.distance_survivor	= distance;
+				cluster.vertex_survivor		= i;
+			}
+		}
+
+		// Re-index, triangles which collapsed into a line or a point are gone
+		std::vector<uint32_t> remap(vertices.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(vertices.size()); i++)
+		{
+			remap[i] = clusters[vertex_keys[i]].vertex_survivor;
+		}
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const uint32_t i0 = remap[indices[i + 0]];
+			const uint32_t i1 = remap[indices[i + 1]];
+			const uint32_t i2 = remap[indices[i + 2]];
+			if (i0 == i1 || i1 == i2 || i2 == i0)
+				continue;
+
+			indices_simplified->emplace_back(i0);
+			indices_simplified->emplace_back(i1);
+			indices_simplified->emplace_back(i2);
+		}
+	}
+
+	// Reorders triangles for the post-transform vertex cache (Forsyth's algorithm, tuned for a cache of 32 entries).
+	// A vertex scores higher the more recently it was used and the fewer triangles it has left, the best scoring triangle around the cache goes next.
+	static void OptimizeVertexCache(std::vector<uint32_t>* indices, const uint32_t vertex_count)
+	{
+		constexpr int32_t cache_size	= 32;
+		const uint32_t triangle_count	= static_cast<uint32_t>(indices->size() / 3);
+		if (triangle_count == 0 || vertex_count == 0)
+			return;
+
+		// The triangles of every vertex, the ones which haven't been emitted yet are kept at the front of its range
+		std::vector<uint32_t> triangle_offsets(vertex_count + 1, 0);
+		for (uint32_t i = 0; i < triangle_count * 3; i++)
+		{
+			triangle_offsets[(*indices)[i] + 1]++;
+		}
+		for (uint32_t i = 0; i < vertex_count; i++)
+		{
+			triangle_offsets[i + 1] += triangle_offsets[i];
+		}
+
+		std::vector<uint32_t> vertex_triangles(triangle_count * 3);
+		std::vector<uint32_t> live(vertex_count, 0);
+		for (uint32_t i = 0; i < triangle_count * 3; i++)
+		{
+			const uint32_t vertex = (*indices)[i];
+			vertex_triangles[triangle_offsets[vertex] + live[vertex]++] = i / 3;
+		}
+
+		std::vector<int32_t> cache_position(vertex_count, -1);
+		const auto vertex_score = [&live, &cache_position](const uint32_t vertex)
+		{
+			if (live[vertex] == 0)
+				return -1.0f;
+
+			// The last triangle's vertices score the same, so that the next triangle doesn't favour one of its edges
+			float score = 0.0f;
+			if (const int32_t position = cache_position[vertex]; position >= 0)
+			{
+				score = position < 3 ? 0.75f : std::pow(1.0f - (position - 3) / static_cast<float>(cache_size - 3), 1.5f);
+			}
+
+			// Vertices with few triangles left are finished off first, so they don't linger as lone triangles
+			return score + 2.0f / std::sqrt(static_cast<float>(live[vertex]));
+		};
+
+		std::vector<float> scores_vertex(vertex_count);
+		for (uint32_t i = 0; i < vertex_count; i++)
+		{
+			scores_vertex[i] = vertex_score(i);
+		}
+
+		const auto triangle_score = [indices, &scores_vertex](const uint32_t triangle)
+		{
+			return scores_vertex[(*indices)[triangle * 3]] + scores_vertex[(*indices)[triangle * 3 + 1]] + scores_vertex[(*indices)[triangle * 3 + 2]];
+		};
+
+		int64_t triangle_best = 0;
+		for (uint32_t i = 1; i < triangle_count; i++)
+		{
+			triangle_best = triangle_score(i) > triangle_score(static_cast<uint32_t>(triangle_best)) ? i : triangle_best;
+		}
+
+		std::vector<bool> emitted(triangle_count, false);
+		std::vector<uint32_t> cache;
+		std::vector<uint32_t> cache_next;
+		std::vector<uint32_t> result;
+		result.reserve(indices->size());
+		uint32_t triangle_unemitted = 0;
+		for (uint32_t emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+		{
+			// Nothing around the cache is left, carry on with the next triangle in the original order
+			if (triangle_best < 0)
+			{
+				while (emitted[triangle_unemitted])
+				{
+					triangle_unemitted++;
+				}
+				triangle_best = triangle_unemitted;
+			}
+
+			const uint32_t triangle = static_cast<uint32_t>(triangle_best);
+			emitted[triangle]		= true;
+			cache_next.clear();
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				const uint32_t vertex = (*indices)[triangle * 3 + i];
+				result.emplace_back(vertex);
+				cache_next.emplace_back(vertex);
+
+				// Move the triangle out of the vertex's live range
+				uint32_t* triangles = &vertex_triangles[triangle_offsets[vertex]];
+				for (uint32_t j = 0; j < live[vertex]; j++)
+				{
+					if (triangles[j] == triangle)
+					{
+						std::swap(triangles[j], triangles[live[vertex] - 1]);
+						break;
+					}
+				}
+				live[vertex]--;
+			}
+
+			// The triangle's vertices go to the front of the cache, the ones which are pushed past its end fall out (and are rescored as such)
+			for (const uint32_t vertex : cache)
+			{
+				if (vertex != cache_next[0] && vertex != cache_next[1] && vertex != cache_next[2])
+				{
+					cache_next.emplace_back(vertex);
+				}
+			}
+
+			for (uint32_t i = 0; i < static_cast<uint32_t>(cache_next.size()); i++)
+			{
+				const uint32_t vertex	= cache_next[i];
+				cache_position[vertex]	= static_cast<int32_t>(i) < cache_size ? static_cast<int32_t>(i) : -1;
+				scores_vertex[vertex]	= vertex_score(vertex);
+			}
+
+			// The next triangle is the best one which uses a cached vertex
+			triangle_best		= -1;
+			float score_best	= -1.0f;
+			for (const uint32_t vertex : cache_next)
+			{
+				for (uint32_t j = 0; j < live[vertex]; j++)
+				{
+					const uint32_t candidate	= vertex_triangles[triangle_offsets[vertex] + j];
+					const float score			= triangle_score(candidate);
+					if (score > score_best)
+					{
+						score_best		= score;
+						triangle_best	= candidate;
+					}
+				}
+			}
+
+			cache_next.resize(std::min(cache_next.size(), static_cast<size_t>(cache_size)));
+			cache.swap(cache_next);
+		}
+
+		indices->swap(result);
+	}
+
+	// Reorders clusters of triangles so that the ones which face outwards (and tend to occlude the rest) are drawn first, which reduces overdraw.
+	// Clusters are split where a vertex cache would start over, so the vertex cache order within them (see OptimizeVertexCache()) survives.
+	static void OptimizeOverdraw(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<uint32_t>* indices)
+	{
+		using namespace Math;
+
+		constexpr uint32_t cache_size	= 16;
+		const uint32_t triangle_count	= static_cast<uint32_t>(indices->size() / 3);
+		if (triangle_count == 0 || vertices.empty())
+			return;
+
+		struct Cluster
+		{
+			uint32_t triangle_start = 0;
+			uint32_t triangle_count = 0;
+			Vector3 centroid		= Vector3::Zero;
+			Vector3 normal			= Vector3::Zero;
+			float sort_key			= 0.0f;
+		};
+
+		// A cluster starts at every triangle whose vertices all miss a FIFO cache
+		std::vector<Cluster> clusters;
+		std::vector<uint32_t> cache_timestamps(vertices.size(), 0);
+		uint32_t timestamp = cache_size + 1;
+		for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+		{
+			uint32_t misses = 0;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				const uint32_t vertex = (*indices)[triangle * 3 + i];
+				if (timestamp - cache_timestamps[vertex] > cache_size)
+				{
+					cache_timestamps[vertex] = timestamp++;
+					misses++;
+				}
+			}
+
+			if (clusters.empty() || misses == 3)
+			{
+				clusters.emplace_back().triangle_start = triangle;
+			}
+			clusters.back().triangle_count++;
+		}
+
+		if (clusters.size() < 2)
+			return;
+
+		// The area weighted centroid and normal of every cluster (and of the mesh)
+		const auto position		= [&vertices, indices](const uint32_t i) { const float* pos = vertices[(*indices)[i]].pos; return Vector3(pos[0], pos[1], pos[2]); };
+		Vector3 centroid_mesh	= Vector3::Zero;
+		float area_mesh			= 0.0f;
+		for (Cluster& cluster : clusters)
+		{
+			float area = 0.0f;
+			for (uint32_t triangle = cluster.triangle_start; triangle < cluster.triangle_start + cluster.triangle_count; triangle++)
+			{
+				const Vector3 p0			= position(triangle * 3);
+				const Vector3 p1			= position(triangle * 3 + 1);
+				const Vector3 p2			= position(triangle * 3 + 2);
+				const Vector3 normal		= Vector3::Cross(p1 - p0, p2 - p0); // its length is twice the area
+				const float triangle_area	= normal.Length();
+
+				cluster.normal		+= normal;
+				cluster.centroid	+= (p0 + p1 + p2) * (triangle_area / 3.0f);
+				area				+= triangle_area;
+			}
+
+			centroid_mesh	+= cluster.centroid;
+			area_mesh		+= area;
+			cluster.centroid = area > 0.0f ? cluster.centroid / area : position(cluster.triangle_start * 3);
+		}
+		centroid_mesh = area_mesh > 0.0f ? centroid_mesh / area_mesh : Vector3::Zero;
+
+		// Clusters which are further out along their normal go first
+		for (Cluster& cluster : clusters)
+		{
+			cluster.sort_key = Vector3::Dot(cluster.centroid - centroid_mesh, cluster.normal.Normalized());
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indices->size());
+		for (const Cluster& cluster : clusters)
+		{
+			result.insert(result.end(), indices->begin() + cluster.triangle_start * 3, indices->begin() + (cluster.triangle_start + cluster.triangle_count) * 3);
+		}
+		indices->swap(result);
+	}
+
+	// Reorders vertices by their first use in the indices, so that vertex fetches walk memory forwards. Vertices which no index uses are dropped.
+	// A skin (one per vertex) is reordered along with them.
+	static void OptimizeVertexFetch(std::vector<RHI_Vertex_PosTexNorTan>* vertices, std::vector<uint32_t>* indices, std::vector<RHI_Vertex_Skin>* skin = nullptr)
+	{
+		constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+
+		std::vector<uint32_t> remap(vertices->size(), unused);
+		std::vector<RHI_Vertex_PosTexNorTan> vertices_ordered;
+		std::vector<RHI_Vertex_Skin> skin_ordered;
+		vertices_ordered.reserve(vertices->size());
+		skin_ordered.reserve(skin ? skin->size() : 0);
+		for (uint32_t& index : *indices)
+		{
+			if (remap[index] == unused)
+			{
+				remap[index] = static_cast<uint32_t>(vertices_ordered.size());
+				vertices_ordered.emplace_back((*vertices)[index]);
+				if (skin)
+				{
+					skin_ordered.emplace_back((*skin)[index]);
+				}
+			}
+			index = remap[index];
+		}
+		vertices->swap(vertices_ordered);
+		if (skin)
+		{
+			skin->swap(skin_ordered);
+		}
+	}
 }
@@ -0,0 +1,135 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <vector>
+#include <array>
+#include "../Threading/Threading.h"
+//=================================
+
+namespace Spartan::Utility::Sort
+{
+    // Stable LSD radix sort of 64-bit keys, values move along with their keys. It goes through the keys a byte at a time
+    // and skips the bytes which are the same for every key, so keys which use a few bits only cost a few passes.
+    // The scratch vectors are resized as needed, keep them around so that repeated sorts don't allocate.
+    // If a Threading instance is passed and there are enough keys, the histograms and the scatter are split over the frame workers.
+    template <typename T>
+    void radix_sort(std::vector<uint64_t>& keys, std::vector<T>& values, std::vector<uint64_t>& keys_scratch, std::vector<T>& values_scratch, Threading* threading = nullptr)
+    {
+        constexpr uint32_t bucket_count         = 256;
+        constexpr uint32_t block_count_max      = 16;
+        constexpr uint32_t parallel_threshold   = 4096;
+
+        const uint32_t count = static_cast<uint32_t>(keys.size());
+        if (count <= 1)
+            return;
+
+        keys_scratch.resize(count);
+        values_scratch.resize(count);
+
+        // Each block sorts its own range into its own slots of the output, so blocks need no synchronization
+        const uint32_t block_count  = (threading && count >= parallel_threshold) ? std::min(block_count_max, threading->GetThreadCount(Threading_Pool_Frame) + 1) : 1;
+        const uint32_t block_size   = (count + block_count - 1) / block_count;
+        std::array<std::array<uint32_t, bucket_count>, block_count_max> offsets;
+
+        auto run = [threading, block_count](auto&& function)
+        {
+            if (block_count > 1)
+            {
+                threading->ParallelFor(function, block_count, 1);
+            }
+            else
+            {
+                function(0, 1);
+            }
+        };
+
+        uint64_t* keys_src  = keys.data();
+        uint64_t* keys_dst  = keys_scratch.data();
+        T* values_src       = values.data();
+        T* values_dst       = values_scratch.data();
+
+        for (uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            // Histograms
+            run([&](uint32_t block_start, uint32_t block_end)
+            {
+                for (uint32_t block = block_start; block < block_end; block++)
+                {
+                    offsets[block].fill(0);
+
+                    const uint32_t end = std::min(count, (block + 1) * block_size);
+                    for (uint32_t i = block * block_size; i < end; i++)
+                    {
+                        offsets[block][(keys_src[i] >> shift) & 0xFF]++;
+                    }
+                }
+            });
+
+            // Prefix sum, bucket by bucket and block by block within a bucket, which is what keeps the sort stable
+            uint32_t offset = 0;
+            bool skip       = false;
+            for (uint32_t bucket = 0; bucket < bucket_count; bucket++)
+            {
+                const uint32_t bucket_start = offset;
+                for (uint32_t block = 0; block < block_count; block++)
+                {
+                    const uint32_t block_bucket_count = offsets[block][bucket];
+                    offsets[block][bucket] = offset;
+                    offset += block_bucket_count;
+                }
+
+                skip = skip || (offset - bucket_start) == count;
+            }
+
+            // Every key has the same byte here, the order wouldn't change
+            if (skip)
+                continue;
+
+            // Scatter
+            run([&](uint32_t block_start, uint32_t block_end)
+            {
+                for (uint32_t block = block_start; block < block_end; block++)
+                {
+                    const uint32_t end = std::min(count, (block + 1) * block_size);
+                    for (uint32_t i = block * block_size; i < end; i++)
+                    {
+                        const uint32_t index    = offsets[block][(keys_src[i] >> shift) & 0xFF]++;
+                        keys_dst[index]         = keys_src[i];
+                        values_dst[index]       = std::move(values_src[i]);
+                    }
+                }
+            });
+
+            std::swap(keys_src, keys_dst);
+            std::swap(values_src, values_dst);
+        }
+
+        // An odd number of passes leaves the result in the scratch vectors
+        if (keys_src != keys.data())
+        {
+            keys.swap(keys_scratch);
+            values.swap(values_scratch);
+        }
+    }
+}
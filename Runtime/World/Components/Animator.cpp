@@ -0,0 +1,182 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ============================
+#include "Animator.h"
+#include "Transform.h"
+#include "../Entity.h"
+#include "../../Core/Context.h"
+#include "../../Core/Engine.h"
+#include "../../IO/FileStream.h"
+#include "../../Resource/ResourceCache.h"
+#include <unordered_map>
+#include <functional>
+//=======================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+	Animator::Animator(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
+	{
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_playing, bool);
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_loop, bool);
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_speed, float);
+	}
+
+	void Animator::OnTick(const float delta_time)
+	{
+		if (!m_animation)
+			return;
+
+		// Entities come and go (and get renamed), so the channels are looked up again when any of them is gone
+		bool resolve = m_channel_entities.size() != m_animation->GetChannelCount();
+		if (!resolve)
+		{
+			uint32_t alive = 0;
+			for (const weak_ptr<Entity>& entity : m_channel_entities)
+			{
+				alive += entity.expired() ? 0 : 1;
+			}
+			resolve = alive != m_channel_matches;
+		}
+		if (resolve)
+		{
+			ChannelsResolve();
+		}
+
+		// Like physics, animations only advance while the game is running
+		if (m_playing && m_speed != 0.0f && m_context->m_engine->EngineMode_IsSet(Engine_Game))
+		{
+			m_time += delta_time * m_speed;
+
+			// Keep the time within the clip, so that it doesn't lose precision over a long session
+			const float duration = m_animation->GetDuration();
+			if (m_loop && duration > 0.0f && (m_time >= duration || m_time < 0.0f))
+			{
+				m_time = fmod(m_time, duration);
+				m_time = m_time < 0.0f ? m_time + duration : m_time;
+			}
+
+			m_pose_dirty = true;
+		}
+	}
+
+	void Animator::Serialize(FileStream* stream)
+	{
+		stream->Write(m_playing);
+		stream->Write(m_loop);
+		stream->Write(m_speed);
+		stream->Write(m_time);
+		stream->Write(m_animation ? m_animation->GetResourceName() : string());
+	}
+
+	void Animator::Deserialize(FileStream* stream)
+	{
+		stream->Read(&m_playing);
+		stream->Read(&m_loop);
+		stream->Read(&m_speed);
+		stream->Read(&m_time);
+
+		const string animation_name = stream->ReadAs<string>();
+		SetAnimation(animation_name.empty() ? nullptr : m_context->GetSubsystem<ResourceCache>()->GetByName<Animation>(animation_name));
+	}
+
+	void Animator::SetAnimation(const shared_ptr<Animation>& animation)
+	{
+		m_animation		= animation;
+		m_pose_dirty	= true;
+		m_pose_sampled	= false;
+		m_channel_entities.clear();
+	}
+
+	void Animator::UpdatePose()
+	{
+		if (!m_animation || !m_pose_dirty || m_channel_entities.size() != m_animation->GetChannelCount())
+			return;
+
+		m_animation->Sample(m_time, m_loop, &m_pose);
+		m_pose_dirty	= false;
+		m_pose_sampled	= true;
+	}
+
+	void Animator::ApplyPose()
+	{
+		if (!m_pose_sampled)
+			return;
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_channel_entities.size()); i++)
+		{
+			if (shared_ptr<Entity> entity = m_channel_entities[i].lock())
+			{
+				Transform* transform = entity->GetTransform();
+				transform->SetPositionLocal(m_pose.positions[i]);
+				transform->SetRotationLocal(m_pose.rotations[i]);
+				transform->SetScaleLocal(m_pose.scales[i]);
+			}
+		}
+
+		m_pose_sampled = false;
+	}
+
+	void Animator::ChannelsResolve()
+	{
+		// The entities by name, the first one of a name wins (like the importer, which names the entities after the nodes)
+		unordered_map<string, Entity*> entities;
+		function<void(Transform*)> gather = [&entities, &gather](Transform* transform)
+		{
+			if (Entity* entity = transform->GetEntity())
+			{
+				entities.emplace(entity->GetName(), entity);
+			}
+
+			for (Transform* child : transform->GetChildren())
+			{
+				gather(child);
+			}
+		};
+		gather(GetTransform());
+
+		// The properties which the clip doesn't animate keep the values the entities had
+		const auto& channels = m_animation->GetChannels();
+		m_channel_entities.assign(channels.size(), weak_ptr<Entity>());
+		m_pose.Resize(static_cast<uint32_t>(channels.size()));
+		m_channel_matches = 0;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(channels.size()); i++)
+		{
+			const auto it = entities.find(channels[i].name);
+			if (it == entities.end())
+				continue;
+
+			Transform* transform	= it->second->GetTransform();
+			m_channel_entities[i]	= it->second->GetPtrShared();
+			m_pose.positions[i]		= transform->GetPositionLocal();
+			m_pose.rotations[i]		= transform->GetRotationLocal();
+			m_pose.scales[i]		= transform->GetScaleLocal();
+			m_channel_matches++;
+		}
+
+		m_pose_dirty = true;
+	}
+}
@@ -0,0 +1,85 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include <memory>
+#include <vector>
+#include "IComponent.h"
+#include "../../Rendering/Animation.h"
+//=================================
+
+namespace Spartan
+{
+	// Plays an animation on the entities below it (and itself), a channel drives the local transform of the entity which has its name.
+	// The world samples the poses of all the animators at once (see World::Tick()), within a budget of channels per tick.
+	class SPARTAN_CLASS Animator : public IComponent
+	{
+	public:
+		Animator(Context* context, Entity* entity, uint32_t id = 0);
+		~Animator() = default;
+
+		//= IComponent ===============================
+		void OnTick(float delta_time) override;
+		void Serialize(FileStream* stream) override;
+		void Deserialize(FileStream* stream) override;
+		//============================================
+
+		//= PROPERTIES ======================================================================
+		void SetAnimation(const std::shared_ptr<Animation>& animation);
+		const auto& GetAnimation() const				{ return m_animation; }
+		uint32_t GetChannelCount() const				{ return m_animation ? m_animation->GetChannelCount() : 0; }
+
+		bool GetPlaying() const							{ return m_playing; }
+		void SetPlaying(const bool playing)				{ m_playing = playing; }
+		bool GetLoop() const							{ return m_loop; }
+		void SetLoop(const bool loop)					{ m_loop = loop; }
+		float GetSpeed() const							{ return m_speed; }
+		void SetSpeed(const float speed)				{ m_speed = speed; }
+		float GetTime() const							{ return m_time; }
+		void SetTime(const float time)					{ m_time = time; m_pose_dirty = true; }
+		//===================================================================================
+
+		// Whether the time moved since the pose was last sampled
+		bool IsPoseDirty() const { return m_pose_dirty; }
+		// Samples the pose at the current time, it only writes to the animator so different animators can sample in parallel
+		void UpdatePose();
+		// Writes the last sampled pose to the entities of the channels
+		void ApplyPose();
+
+	private:
+		void ChannelsResolve();
+
+		std::shared_ptr<Animation> m_animation;
+		float m_time		= 0.0f;
+		float m_speed		= 1.0f;
+		bool m_playing		= true;
+		bool m_loop			= true;
+		bool m_pose_dirty	= true;
+		bool m_pose_sampled	= false;
+
+		// The entity of each channel (if any) and the pose which is written to them
+		std::vector<std::weak_ptr<Entity>> m_channel_entities;
+		uint32_t m_channel_matches = 0;
+		Animation_Pose m_pose;
+	};
+}
@@ -119,12 +119,11 @@ namespace Spartan
 
     void AudioSource::SetAudioClip(const string& file_path)
     {
-        // Create and load the audio clip
-        auto audio_clip = make_shared<AudioClip>(m_context);
-        if (audio_clip->LoadFromFile(file_path))
+        // Use the clip if it's already loaded (e.g. by a sound bank), otherwise load it.
+        // In order for the component to guarantee serialization/deserialization, the audio clip is cached.
+        if (auto audio_clip = m_context->GetSubsystem<ResourceCache>()->Load<AudioClip>(file_path))
         {
-            // In order for the component to guarantee serialization/deserialization, we cache the audio clip
-            m_audio_clip = m_context->GetSubsystem<ResourceCache>()->Cache(audio_clip);
+            m_audio_clip = audio_clip;
         }
     }
 
@@ -30,6 +30,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Input/Input.h"
 #include "../../IO/FileStream.h"
 #include "../../Rendering/Renderer.h"
+#include "../../Rendering/Model.h"
 #include "../../Math/MathHelper.h"
 //===================================
 
@@ -40,6 +41,16 @@ using namespace std;
 
 namespace Spartan
 {
+    static const float mouse_sensitivity    = 0.13f;
+    static const float mouse_smoothing      = 0.2f;
+
+    static Quaternion mouse_look_rotation(const Vector2& rotation)
+    {
+        const auto xQuaternion = Quaternion::FromAngleAxis(rotation.x * Helper::DEG_TO_RAD, Vector3::Up);
+        const auto yQuaternion = Quaternion::FromAngleAxis(rotation.y * Helper::DEG_TO_RAD, Vector3::Right);
+        return xQuaternion * yQuaternion;
+    }
+
 	Camera::Camera(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
 	{   
         m_renderer  = m_context->GetSubsystem<Renderer>();
@@ -51,6 +62,17 @@ namespace Spartan
         m_view              = ComputeViewMatrix();
         m_projection        = ComputeProjection(m_renderer->GetOption(Render_ReverseZ));
         m_view_projection   = m_view * m_projection;
+
+        m_renderer->RegistryAdd(m_entity, Renderer_Object_Camera);
+	}
+
+	void Camera::OnRemove()
+	{
+        // The renderer can already be gone if the engine is shutting down
+        if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+        {
+            renderer->RegistryRemove(m_entity, Renderer_Object_Camera);
+        }
 	}
 
 	void Camera::OnTick(float delta_time)
@@ -173,10 +195,47 @@ namespace Spartan
 		if (x_outside || y_outside)
 			return false;
 
-		// Trace ray
+		// Trace ray, against the bounding boxes of the entities along it
 		m_ray		= Ray(GetTransform()->GetPosition(), Unproject(mouse_position_relative));
 		auto hits	= m_ray.Trace(m_context);
 
+        // Go through the triangles of the hits, the closest triangle wins
+        {
+            float distance_closest = INFINITY;
+            for (const auto& hit : hits)
+            {
+                // The boxes are sorted by distance, a box further than the closest triangle can't have a closer one
+                if (hit.m_distance > distance_closest)
+                    break;
+
+                Renderable* renderable = hit.m_entity->GetRenderable();
+                const Model* model     = renderable ? renderable->GeometryModel() : nullptr;
+                if (!model)
+                    continue;
+
+                // Trace in model space, the hit is brought back to world space to measure the distance
+                const Matrix& world             = hit.m_entity->GetTransform()->GetMatrix();
+                const Matrix world_inverted     = world.Inverted();
+                const Ray ray_model             = Ray(m_ray.GetStart() * world_inverted, m_ray.GetEnd() * world_inverted);
+                const float distance_model      = model->GeometryTrace(ray_model, renderable->GeometryIndexOffset(), renderable->GeometryIndexCount(), renderable->GeometryVertexOffset());
+                if (distance_model == INFINITY)
+                    continue;
+
+                const Vector3 position          = (ray_model.GetStart() + ray_model.GetDirection() * distance_model) * world;
+                const float distance            = Vector3::Distance(m_ray.GetStart(), position);
+                if (distance < distance_closest)
+                {
+                    distance_closest    = distance;
+                    picked              = hit.m_entity;
+                }
+            }
+
+            if (distance_closest != INFINITY)
+                return true;
+        }
+
+        // No triangle was hit (or there was no geometry to trace), fall back to scoring the boxes
+
         // Create a struct to hold hit related data
         struct scored_entity
         {
@@ -290,13 +349,12 @@ namespace Spartan
 
     void Camera::FpsControl(float delta_time)
     {
-        static const float mouse_sensitivity        = 0.13f;
-        static const float mouse_smoothing          = 0.2f;
         static const float movement_speed_max       = 40.0f;
         static const float movement_acceleration    = 0.8f;
         static const float movement_drag            = 0.08f;
 
-        if (m_input->GetKey(KeyCode::Click_Right))
+        m_mouse_look = m_input->GetKey(KeyCode::Click_Right);
+        if (m_mouse_look)
         {
             // Mouse look
             {
@@ -320,12 +378,8 @@ namespace Spartan
                 // Clamp rotation along the x-axis
                 mouse_rotation.y = Helper::Clamp(mouse_rotation.y, -90.0f, 90.0f);
 
-                // Compute rotation
-                const auto xQuaternion = Quaternion::FromAngleAxis(mouse_rotation.x * Helper::DEG_TO_RAD, Vector3::Up);
-                const auto yQuaternion = Quaternion::FromAngleAxis(mouse_rotation.y * Helper::DEG_TO_RAD, Vector3::Right);
-
                 // Rotate
-                m_transform->SetRotationLocal(xQuaternion * yQuaternion);
+                m_transform->SetRotationLocal(mouse_look_rotation(mouse_rotation));
             }
 
             // Keyboard movement
@@ -369,6 +423,27 @@ namespace Spartan
 		return Matrix::CreateLookAtLH(position, look_at, up);
 	}
 
+    Camera::LateLatchState Camera::GetLateLatchState() const
+    {
+        LateLatchState state;
+        state.active            = m_fps_control && m_mouse_look;
+        state.position          = GetTransform()->GetPosition();
+        state.rotation_parent   = GetTransform()->GetRotationLocal().Inverse() * GetTransform()->GetRotation(); // world is local * parent
+        state.rotation          = mouse_rotation;
+        return state;
+    }
+
+    Matrix Camera::ComputeViewMatrixLateLatched(const LateLatchState& state, const Vector2& mouse_delta)
+    {
+        // The next tick lerps towards its delta, which includes this motion, so only the part it will apply right away is applied
+        Vector2 rotation    = state.rotation + mouse_delta * mouse_sensitivity * (1.0f - mouse_smoothing);
+        rotation.y          = Helper::Clamp(rotation.y, -90.0f, 90.0f);
+
+        const Quaternion orientation    = mouse_look_rotation(rotation) * state.rotation_parent;
+        const Vector3 look_at           = state.position + orientation * Vector3::Forward;
+        return Matrix::CreateLookAtLH(state.position, look_at, orientation * Vector3::Up);
+    }
+
 	Matrix Camera::ComputeProjection(const bool reverse_z, const float near_plane /*= 0.0f*/, const float far_plane /*= 0.0f*/)
 	{
         float _near  = near_plane != 0 ? near_plane : m_near_plane;
@@ -55,6 +55,7 @@ namespace Spartan
 
 		//= ICOMPONENT ===============================
 		void OnInitialize() override;
+		void OnRemove() override;
 		void OnTick(float delta_time) override;
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
@@ -103,6 +104,7 @@ namespace Spartan
 		//= MISC ==============================================================================
 		bool IsInViewFrustrum(Renderable* renderable) const;
 		bool IsInViewFrustrum(const Math::Vector3& center, const Math::Vector3& extents) const;
+        const Math::Frustum& GetFrustum() const         { return m_frustrum; }
 		const Math::Vector4& GetClearColor() const		{ return m_clear_color; }
 		void SetClearColor(const Math::Vector4& color)	{ m_clear_color = color; }
         bool GetFpsControl()                 const { return m_fps_control; }
@@ -112,6 +114,20 @@ namespace Spartan
         Math::Matrix ComputeViewMatrix() const;
         Math::Matrix ComputeProjection(const bool reverse_z, const float near_plane = 0.0f, const float far_plane = 0.0f);
 
+        //= LATE LATCHING ===========================================================================================================
+        // The mouse look rotation of the last tick, the renderer captures it with its snapshot so that, right before it uploads the
+        // frame's matrices, it can rotate the view by the mouse motion which arrived since (without touching the transform)
+        struct LateLatchState
+        {
+            bool active                         = false; // mouse look was on
+            Math::Vector3 position              = Math::Vector3::Zero;
+            Math::Quaternion rotation_parent    = Math::Quaternion::Identity;
+            Math::Vector2 rotation              = Math::Vector2::Zero; // yaw and pitch, in degrees
+        };
+        LateLatchState GetLateLatchState() const;
+        static Math::Matrix ComputeViewMatrixLateLatched(const LateLatchState& state, const Math::Vector2& mouse_delta); // delta in counts, as Input reports it
+        //===========================================================================================================================
+
 	private:
         void FpsControl(float delta_time);
 
@@ -130,6 +146,7 @@ namespace Spartan
         Math::Vector3 m_movement_speed      = Math::Vector3::Zero;
         Math::Vector2 mouse_smoothed        = Math::Vector2::Zero;
         Math::Vector2 mouse_rotation        = Math::Vector2::Zero;     
+        bool m_mouse_look                   = false;
         RHI_Viewport m_last_known_viewport;
         Math::Ray m_ray;
         Math::Frustum m_frustrum;
@@ -24,11 +24,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Transform.h"
 #include "RigidBody.h"
 #include "Renderable.h"
+#include "Terrain.h"
 #include "../Entity.h"
 #include "../../IO/FileStream.h"
+#include "../../Physics/Physics.h"
+#include "../../Physics/CollisionShapeCache.h"
 #include "../../Physics/BulletPhysicsHelper.h"
 #include "../../Logging/Log.h"
 #include "../../RHI/RHI_Vertex.h"
+#include "../../Rendering/Model.h"
 #pragma warning(push, 0) // Hide warnings which belong to Bullet
 #include <BulletCollision/CollisionShapes/btSphereShape.h>
 #include <BulletCollision/CollisionShapes/btCylinderShape.h>
@@ -36,6 +40,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <BulletCollision/CollisionShapes/btStaticPlaneShape.h>
 #include <BulletCollision/CollisionShapes/btConeShape.h>
 #include <BulletCollision/CollisionShapes/btConvexHullShape.h>
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 #pragma warning(pop)
 //=============================================================
 
@@ -52,6 +57,7 @@ namespace Spartan
 		m_center	= Vector3::Zero;
 		m_size		= Vector3::One;
 		m_shape		= nullptr;
+		m_shape_cache = GetContext()->GetSubsystem<Physics>()->GetShapeCache();
 
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_size, Vector3);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_center, Vector3);
@@ -138,41 +144,46 @@ namespace Spartan
 		Shape_Release();
         const Vector3 worldScale = GetTransform()->GetScale();
 
+		// Colliders which agree on all of these share a shape
+		CollisionShapeKey key;
+		key.type	= static_cast<uint32_t>(m_shapeType);
+		key.size	= m_size;
+		key.scale	= worldScale;
+		const auto scaled = [&key](btCollisionShape* shape) { shape->setLocalScaling(ToBtVector3(key.scale)); return shape; };
+
 		switch (m_shapeType)
 		{
 		case ColliderShape_Box:
-			m_shape = new btBoxShape(ToBtVector3(m_size * 0.5f));
-			m_shape->setLocalScaling(ToBtVector3(worldScale));
+			m_shape = m_shape_cache->Acquire(key, [&key, &scaled]() { return scaled(new btBoxShape(ToBtVector3(key.size * 0.5f))); });
 			break;
 
 		case ColliderShape_Sphere:
-			m_shape = new btSphereShape(m_size.x * 0.5f);
-			m_shape->setLocalScaling(ToBtVector3(worldScale));
+			m_shape = m_shape_cache->Acquire(key, [&key, &scaled]() { return scaled(new btSphereShape(key.size.x * 0.5f)); });
 			break;
 
 		case ColliderShape_StaticPlane:
-			m_shape = new btStaticPlaneShape(btVector3(0.0f, 1.0f, 0.0f), 0.0f);
+			key.size	= Vector3::Zero;
+			key.scale	= Vector3::One;
+			m_shape		= m_shape_cache->Acquire(key, []() { return new btStaticPlaneShape(btVector3(0.0f, 1.0f, 0.0f), 0.0f); });
 			break;
 
 		case ColliderShape_Cylinder:
-			m_shape = new btCylinderShape(btVector3(m_size.x * 0.5f, m_size.y * 0.5f, m_size.x * 0.5f));
-			m_shape->setLocalScaling(ToBtVector3(worldScale));
+			m_shape = m_shape_cache->Acquire(key, [&key, &scaled]() { return scaled(new btCylinderShape(btVector3(key.size.x * 0.5f, key.size.y * 0.5f, key.size.x * 0.5f))); });
 			break;
 
 		case ColliderShape_Capsule:
-			m_shape = new btCapsuleShape(m_size.x * 0.5f, Helper::Max(m_size.y - m_size.x, 0.0f));
-			m_shape->setLocalScaling(ToBtVector3(worldScale));
+			m_shape = m_shape_cache->Acquire(key, [&key, &scaled]() { return scaled(new btCapsuleShape(key.size.x * 0.5f, Helper::Max(key.size.y - key.size.x, 0.0f))); });
 			break;
 
 		case ColliderShape_Cone:
-			m_shape = new btConeShape(m_size.x * 0.5f, m_size.y);
-			m_shape->setLocalScaling(ToBtVector3(worldScale));
+			m_shape = m_shape_cache->Acquire(key, [&key, &scaled]() { return scaled(new btConeShape(key.size.x * 0.5f, key.size.y)); });
 			break;
 
 		case ColliderShape_Mesh:
+		{
 			// Get Renderable
 			Renderable* renderable = GetEntity()->GetComponent<Renderable>();
-			if (!renderable)
+			if (!renderable || !renderable->GeometryModel())
 			{
 				LOG_WARNING("Can't construct mesh shape, there is no Renderable component attached.");
 				return;
@@ -185,37 +196,73 @@ namespace Spartan
 				return;
 			}
 
-			// Get geometry
-			vector<uint32_t> indices;
-			vector<RHI_Vertex_PosTexNorTan> vertices;
-			renderable->GeometryGet(&indices, &vertices);
+			// The hull depends on the geometry only, not on the size
+			key.size					= Vector3::Zero;
+			key.geometry				= (static_cast<uint64_t>(renderable->GeometryModel()->GetId()) << 32) | renderable->GeometryVertexOffset();
+			key.geometry_vertex_count	= renderable->GeometryVertexCount();
+			key.optimize				= m_optimize;
 
-			if (vertices.empty())
+			// Construct hull approximation (the points are only needed by the first collider of this geometry)
+			m_shape = m_shape_cache->AcquireHull(key, [renderable](vector<btVector3>& points)
 			{
-				LOG_WARNING("No vertices.");
+				// The compact positions are enough, so a model which dropped its cpu geometry doesn't bring all of it back
+				const vector<Vector3>& positions	= renderable->GeometryModel()->GetPositions();
+				const uint32_t vertex_offset		= renderable->GeometryVertexOffset();
+				const uint32_t vertex_count			= renderable->GeometryVertexCount();
+				if (vertex_count == 0 || vertex_offset + vertex_count > positions.size())
+				{
+					LOG_WARNING("No vertices.");
+					return false;
+				}
+
+				points.reserve(vertex_count);
+				for (uint32_t i = vertex_offset; i < vertex_offset + vertex_count; i++)
+				{
+					points.emplace_back(positions[i].x, positions[i].y, positions[i].z);
+				}
+				return true;
+			});
+			break;
+		}
+
+		case ColliderShape_Terrain:
+		{
+			Terrain* terrain = GetEntity()->GetComponent<Terrain>();
+			m_height_samples = terrain ? terrain->GetHeightSamples() : nullptr;
+			if (!m_height_samples)
+			{
+				LOG_WARNING("Can't construct terrain shape, there is no generated Terrain component attached.");
 				return;
 			}
 
-			// Construct hull approximation
-			m_shape = new btConvexHullShape(
-				(btScalar*)&vertices[0],					                // points
-				renderable->GeometryVertexCount(),			                // point count
-				static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)));	// stride
-
-			// Scaling has to be done before (potential) optimization
-			m_shape->setLocalScaling(ToBtVector3(worldScale));
+			// Bullet centers the heightfield on its bounding box, the terrain is centered on the height map (a texel is a unit) and starts at min y
+			const Terrain_HeightSamples* samples	= m_height_samples.get();
+			const float height_range				= samples->max_y - samples->min_y;
+			m_center = Vector3(-0.5f, samples->min_y + height_range * 0.5f, -0.5f) * worldScale;
 
-			// Optimize if requested
-			if (m_optimize)
+			// The heights are read from the terrain, a shape per generation of it
+			key.size		= Vector3::Zero;
+			key.geometry	= (static_cast<uint64_t>(terrain->GetId()) << 32) | samples->revision;
+			m_shape = m_shape_cache->Acquire(key, [samples, height_range, &scaled]()
 			{
-				auto hull = static_cast<btConvexHullShape*>(m_shape);
-				hull->optimizeConvexHull();
-				hull->initializePolyhedralFeatures();
-			}
+				return scaled(new btHeightfieldTerrainShape(
+					static_cast<int>(samples->width),
+					static_cast<int>(samples->height),
+					samples->heights.data(),
+					height_range / 255.0f,	// height scale
+					0.0f,					// min height
+					height_range,			// max height
+					1,						// up axis
+					PHY_UCHAR,
+					false					// the diagonal of a quad is the one the terrain's triangles share
+				));
+			});
 			break;
 		}
+		}
 
-		m_shape->setUserPointer(this);
+		if (!m_shape)
+			return;
 
 		RigidBody_SetShape(m_shape);
 		RigidBody_SetCenterOfMass(m_center);
@@ -224,7 +271,9 @@ namespace Spartan
 	void Collider::Shape_Release()
 	{
 		RigidBody_SetShape(nullptr);
-		safe_delete(m_shape);
+		m_shape_cache->Release(m_shape);
+		m_shape = nullptr;
+		m_height_samples.reset();
 	}
 
 	void Collider::RigidBody_SetShape(btCollisionShape* shape) const
@@ -31,6 +31,8 @@ class btCollisionShape;
 namespace Spartan
 {
 	class Mesh;
+	class CollisionShapeCache;
+	struct Terrain_HeightSamples;
 
 	enum ColliderShape
 	{
@@ -41,6 +43,7 @@ namespace Spartan
 		ColliderShape_Capsule,
 		ColliderShape_Cone,
 		ColliderShape_Mesh,
+		ColliderShape_Terrain, // a heightfield which uses the heights of the entity's terrain as they are, its center follows the terrain
 	};
 
 	class SPARTAN_CLASS Collider : public IComponent
@@ -74,17 +77,21 @@ namespace Spartan
 		bool GetOptimize() const { return m_optimize; }
 		void SetOptimize(bool optimize);
 
-	private:
+		// Rebuilds the shape, terrains call it when their heights change
 		void Shape_Update();
+
+	private:
 		void Shape_Release();
 		void RigidBody_SetShape(btCollisionShape* shape) const;
 		void RigidBody_SetCenterOfMass(const Math::Vector3& center) const;
 
 		ColliderShape m_shapeType;
-		btCollisionShape* m_shape;
+		btCollisionShape* m_shape;		// shared with the colliders which have the same key (see CollisionShapeCache)
+		CollisionShapeCache* m_shape_cache = nullptr;
 		Math::Vector3 m_size;
 		Math::Vector3 m_center;
 		uint32_t m_vertexLimit = 100000;
 		bool m_optimize = true;
+		std::shared_ptr<const Terrain_HeightSamples> m_height_samples; // what the terrain shape reads, kept alive for as long as the shape is
 	};
 }
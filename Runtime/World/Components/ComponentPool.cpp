@@ -0,0 +1,123 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =============
+#include "ComponentPool.h"
+#include <array>
+#include <new>
+//========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace _ComponentPool
+    {
+        static const uint32_t blocks_per_chunk = 256;
+    }
+
+    ComponentPool::ComponentPool(const uint32_t blocks_per_chunk)
+    {
+        m_blocks_per_chunk = blocks_per_chunk;
+    }
+
+    void* ComponentPool::Allocate(const size_t size)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        // All the components of a pool are of the same type, so the first allocation decides the block size
+        if (m_block_size == 0)
+        {
+            // Keep every block aligned to the strictest fundamental alignment
+            const size_t alignment  = alignof(max_align_t);
+            m_block_size            = (size + alignment - 1) & ~(alignment - 1);
+        }
+
+        if (size > m_block_size)
+            return ::operator new(size);
+
+        if (m_blocks_free.empty())
+        {
+            AddChunk();
+        }
+
+        void* ptr = m_blocks_free.back();
+        m_blocks_free.pop_back();
+        return ptr;
+    }
+
+    void ComponentPool::Free(void* ptr, const size_t size)
+    {
+        if (size > m_block_size)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+        m_blocks_free.emplace_back(ptr);
+    }
+
+    uint32_t ComponentPool::GetBlocksFree()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return static_cast<uint32_t>(m_blocks_free.size());
+    }
+
+    const shared_ptr<ComponentPool>& ComponentPool::Get(const ComponentType type)
+    {
+        static array<shared_ptr<ComponentPool>, ComponentType_Unknown + 1> pools;
+        static mutex mutex_pools;
+
+        lock_guard<mutex> lock(mutex_pools);
+
+        shared_ptr<ComponentPool>& pool = pools[type];
+        if (!pool)
+        {
+            pool = make_shared<ComponentPool>(_ComponentPool::blocks_per_chunk);
+        }
+
+        return pool;
+    }
+
+    const shared_ptr<ComponentPool>& ComponentPool::GetEntities()
+    {
+        // Entities are bigger than most components, and spawned by the thousand
+        static const shared_ptr<ComponentPool> pool = make_shared<ComponentPool>(_ComponentPool::blocks_per_chunk * 4);
+        return pool;
+    }
+
+    void ComponentPool::AddChunk()
+    {
+        byte* chunk = m_chunks.emplace_back(make_unique<byte[]>(m_block_size * m_blocks_per_chunk)).get();
+
+        m_blocks_free.reserve(m_blocks_free.size() + m_blocks_per_chunk);
+        for (uint32_t i = 0; i < m_blocks_per_chunk; i++)
+        {
+            // Reverse order, so that blocks get handed out front to back
+            m_blocks_free.emplace_back(chunk + m_block_size * (m_blocks_per_chunk - 1 - i));
+        }
+
+        m_block_count += m_blocks_per_chunk;
+    }
+}
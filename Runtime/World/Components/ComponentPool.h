@@ -0,0 +1,92 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==================
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstddef>
+#include "IComponent.h"
+//=============================
+
+namespace Spartan
+{
+    // A pool of equally sized memory blocks which holds the components of a single type, so that components of the same type
+    // sit next to each other in memory instead of being scattered across the heap. It grows a chunk at a time and never moves
+    // a block, so pointers to components stay valid. The block size is picked by the first allocation, bigger ones go to the heap.
+    class SPARTAN_CLASS ComponentPool
+    {
+    public:
+        ComponentPool(const uint32_t blocks_per_chunk);
+        ~ComponentPool() = default;
+
+        void* Allocate(const size_t size);
+        void Free(void* ptr, const size_t size);
+
+        size_t GetBlockSize()       const { return m_block_size; }
+        uint32_t GetBlockCount()    const { return m_block_count; }
+        uint32_t GetBlocksFree();
+
+        // Returns the pool of a component type, every type has its own
+        static const std::shared_ptr<ComponentPool>& Get(const ComponentType type);
+        // Returns the pool of entities, which are created and destroyed in the same numbers as their components
+        static const std::shared_ptr<ComponentPool>& GetEntities();
+
+    private:
+        void AddChunk();
+
+        std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+        std::vector<void*> m_blocks_free;
+        std::mutex m_mutex;
+        size_t m_block_size         = 0;
+        uint32_t m_block_count      = 0;
+        uint32_t m_blocks_per_chunk = 0;
+    };
+
+    // A minimal allocator which forwards to a ComponentPool, meant for std::allocate_shared() so that
+    // the control block and the component end up in a single pooled block.
+    template <typename T>
+    class ComponentAllocator
+    {
+    public:
+        typedef T value_type;
+
+        ComponentAllocator(const std::shared_ptr<ComponentPool>& pool) : m_pool(pool) {}
+        template <typename U>
+        ComponentAllocator(const ComponentAllocator<U>& other) : m_pool(other.m_pool) {}
+
+        T* allocate(const size_t n)                 { return static_cast<T*>(m_pool->Allocate(n * sizeof(T))); }
+        void deallocate(T* ptr, const size_t n)     { m_pool->Free(ptr, n * sizeof(T)); }
+
+        template <typename U>
+        bool operator==(const ComponentAllocator<U>& other) const { return m_pool == other.m_pool; }
+        template <typename U>
+        bool operator!=(const ComponentAllocator<U>& other) const { return m_pool != other.m_pool; }
+
+    private:
+        template <typename U> friend class ComponentAllocator;
+
+        // Shared, so that components which outlive the world (held by the editor for example) can still be released
+        std::shared_ptr<ComponentPool> m_pool;
+    };
+}
@@ -206,6 +206,8 @@ namespace Spartan
 	{
 		if (m_constraint)
 		{
+			const auto lock = m_physics->LockWorld();
+
 			RigidBody* rigid_body_own	= m_entity->GetComponent<RigidBody>();
 			RigidBody* rigid_body_other	= !m_bodyOther.expired() ? m_bodyOther.lock()->GetComponent<RigidBody>() : nullptr;
 
@@ -222,6 +224,8 @@ namespace Spartan
 		if (!m_constraint || m_bodyOther.expired())
 			return;
 
+		const auto lock = m_physics->LockWorld();
+
 		RigidBody* rigid_body_own   = m_entity->GetComponent<RigidBody>();
 		RigidBody* rigid_body_other = !m_bodyOther.expired() ? m_bodyOther.lock()->GetComponent<RigidBody>() : nullptr;
 		btRigidBody* bt_own_body    = rigid_body_own ? rigid_body_own->GetBtRigidBody() : nullptr;
@@ -277,6 +281,8 @@ namespace Spartan
 	------------------------------------------------------------------------------*/
 	void Constraint::Construct()
 	{
+		const auto lock = m_physics->LockWorld();
+
 		ReleaseConstraint();
 
 		// Make sure we have two bodies
@@ -366,6 +372,8 @@ namespace Spartan
 		if (!m_constraint)
 			return;
 
+		const auto lock = m_physics->LockWorld();
+
 		switch (m_constraint->getConstraintType())
 		{
 			case HINGE_CONSTRAINT_TYPE:
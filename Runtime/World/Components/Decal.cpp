@@ -0,0 +1,84 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ============================
+#include "Decal.h"
+#include "..\..\IO\FileStream.h"
+#include "..\..\Rendering\Renderer.h"
+#include "..\..\Resource\ResourceCache.h"
+#include "..\..\RHI\RHI_Texture2D.h"
+//=======================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    Decal::Decal(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
+    {
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_color, Vector4);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_roughness, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_metallic, float);
+
+        m_renderer = m_context->GetSubsystem<Renderer>();
+    }
+
+    void Decal::OnInitialize()
+    {
+        if (m_renderer)
+        {
+            m_renderer->RegistryAdd(m_entity, Renderer_Object_Decal);
+        }
+    }
+
+    void Decal::OnRemove()
+    {
+        // The renderer can already be gone if the engine is shutting down
+        if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+        {
+            renderer->RegistryRemove(m_entity, Renderer_Object_Decal);
+        }
+    }
+
+    void Decal::Serialize(FileStream* stream)
+    {
+        stream->Write(m_texture ? m_texture->GetResourceFilePathNative() : string());
+        stream->Write(m_color);
+        stream->Write(m_roughness);
+        stream->Write(m_metallic);
+    }
+
+    void Decal::Deserialize(FileStream* stream)
+    {
+        m_texture = m_context->GetSubsystem<ResourceCache>()->GetByPath<RHI_Texture2D>(stream->ReadAs<string>());
+        stream->Read(&m_color);
+        stream->Read(&m_roughness);
+        stream->Read(&m_metallic);
+    }
+
+    void Decal::SetTexture(const shared_ptr<RHI_Texture2D>& texture)
+    {
+        // In order for the component to guarantee serialization/deserialization, we cache the texture
+        m_texture = texture ? m_context->GetSubsystem<ResourceCache>()->Cache<RHI_Texture2D>(texture) : nullptr;
+    }
+}
@@ -0,0 +1,71 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ========================
+#include "IComponent.h"
+#include "../../RHI/RHI_Definition.h"
+#include "../../Math/MathHelper.h"
+#include "../../Math/Vector4.h"
+//===================================
+
+namespace Spartan
+{
+    class Renderer;
+
+    // Projects a texture onto the opaque surfaces inside the entity's unit box (from -0.5 to 0.5 along each axis), along the box's z axis.
+    // The renderer bins the decals in view into the light clusters and the g-buffer pass blends them into the albedo and the material
+    // of the pixels they cover, by the texture's alpha times the color's alpha.
+    class SPARTAN_CLASS Decal : public IComponent
+    {
+    public:
+        Decal(Context* context, Entity* entity, uint32_t id = 0);
+        ~Decal() = default;
+
+        //= IComponent ===============================
+        void OnInitialize() override;
+        void OnRemove() override;
+        void Serialize(FileStream* stream) override;
+        void Deserialize(FileStream* stream) override;
+        //============================================
+
+        // No texture projects the color alone
+        const auto& GetTexture() const                  { return m_texture; }
+        void SetTexture(const std::shared_ptr<RHI_Texture2D>& texture);
+
+        // Multiplies the texture
+        const auto& GetColor() const                    { return m_color; }
+        void SetColor(const Math::Vector4& color)       { m_color = color; }
+
+        float GetRoughness() const                      { return m_roughness; }
+        void SetRoughness(const float roughness)        { m_roughness = Math::Helper::Saturate(roughness); }
+        float GetMetallic() const                       { return m_metallic; }
+        void SetMetallic(const float metallic)          { m_metallic = Math::Helper::Saturate(metallic); }
+
+    private:
+        std::shared_ptr<RHI_Texture2D> m_texture;
+        Math::Vector4 m_color   = Math::Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+        float m_roughness       = 1.0f;
+        float m_metallic        = 0.0f;
+        Renderer* m_renderer    = nullptr;
+    };
+}
@@ -68,7 +68,7 @@ namespace Spartan
         m_context->GetSubsystem<Threading>()->AddTask([this]
         {
             SetFromTextureSphere(m_file_paths.front());
-        });
+        }, {}, Threading_Pool_Background);
 
         m_is_dirty = false;
     }
@@ -96,7 +96,7 @@ namespace Spartan
                 
                 SetFromTextureSphere(m_file_paths.front());
             }
-        });
+        }, {}, Threading_Pool_Background);
     }
 
     void Environment::LoadDefault()
@@ -167,11 +167,19 @@ namespace Spartan
 	{
         LOG_INFO("Creating sky sphere...");
 
-        // Don't generate mipmaps as the Renderer will generate a prefiltered environment which is required for proper IBL
+        // The Renderer prefilters the environment on the GPU, its filtered importance sampling reads these mipmaps
         auto generate_mipmaps = true;
 
         // Skysphere
         auto texture = make_shared<RHI_Texture2D>(GetContext(), generate_mipmaps);
+
+        // High dynamic range images can be block compressed without losing their range
+        const string extension = FileSystem::GetExtensionFromFilePath(file_path);
+        if (extension == ".hdr" || extension == ".exr")
+        {
+            texture->SetCompression(RHI_Format_BC6H_Uf16);
+        }
+
         if (texture->LoadFromFile(file_path))
         {
             // Set sky sphere to renderer
@@ -0,0 +1,298 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ============================
+#include <random>
+#include "Foliage.h"
+#include "Terrain.h"
+#include "Renderable.h"
+#include "Transform.h"
+#include "..\Entity.h"
+#include "..\World.h"
+#include "..\..\RHI\RHI_Texture2D.h"
+#include "..\..\Logging\Log.h"
+#include "..\..\Math\MathHelper.h"
+#include "..\..\Math\Quaternion.h"
+#include "..\..\IO\FileStream.h"
+#include "..\..\Resource\ResourceCache.h"
+#include "..\..\Rendering\Material.h"
+#include "..\..\Threading\Threading.h"
+//=======================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    Foliage::Foliage(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
+    {
+
+    }
+
+    Foliage::~Foliage()
+    {
+        // The stages of a scatter which is still going capture this
+        m_generate.Cancel();
+    }
+
+    void Foliage::OnTick(float delta_time)
+    {
+        // Scatter again whenever the terrain has new heights
+        const Terrain* terrain = m_entity->GetComponent<Terrain>();
+        if (!terrain || !m_generate.IsDone())
+            return;
+
+        const shared_ptr<const Terrain_HeightSamples>& samples = terrain->GetHeightSamples();
+        if (samples && samples->revision != m_height_samples_revision && GetSource())
+        {
+            GenerateAsync();
+        }
+    }
+
+    void Foliage::Serialize(FileStream* stream)
+    {
+        stream->Write(m_source_id);
+        stream->Write(m_density_map ? m_density_map->GetResourceFilePathNative() : string());
+        stream->Write(m_density);
+        stream->Write(m_scale_min);
+        stream->Write(m_scale_max);
+        stream->Write(m_seed);
+        stream->Write(m_instance_count);
+    }
+
+    void Foliage::Deserialize(FileStream* stream)
+    {
+        stream->Read(&m_source_id);
+        m_density_map = m_context->GetSubsystem<ResourceCache>()->GetByPath<RHI_Texture2D>(stream->ReadAs<string>());
+        stream->Read(&m_density);
+        stream->Read(&m_scale_min);
+        stream->Read(&m_scale_max);
+        stream->Read(&m_seed);
+        stream->Read(&m_instance_count);
+
+        // The chunks are child entities, they (and the instances of their renderables) deserialize themselves.
+        // The terrain reads its heights again once it's loaded though, and that scatters them again.
+    }
+
+    Entity* Foliage::GetSource() const
+    {
+        return m_source_id != 0 ? m_context->GetSubsystem<World>()->EntityGetById(m_source_id).get() : nullptr;
+    }
+
+    void Foliage::SetSource(const Entity* source)
+    {
+        m_source_id = source ? source->GetId() : 0;
+    }
+
+    void Foliage::SetDensityMap(const shared_ptr<RHI_Texture2D>& density_map)
+    {
+        // In order for the component to guarantee serialization/deserialization, we cache the density map
+        m_density_map = density_map ? m_context->GetSubsystem<ResourceCache>()->Cache<RHI_Texture2D>(density_map) : nullptr;
+    }
+
+    void Foliage::GenerateAsync()
+    {
+        if (!m_generate.IsDone())
+        {
+            LOG_WARNING("Foliage is already being generated, please wait...");
+            return;
+        }
+
+        const Terrain* terrain = m_entity->GetComponent<Terrain>();
+        shared_ptr<const Terrain_HeightSamples> samples = terrain ? terrain->GetHeightSamples() : nullptr;
+        if (!samples)
+        {
+            LOG_WARNING("Foliage needs a generated terrain on the same entity.");
+            return;
+        }
+
+        // Scattered in the background, the chunk entities are created on the main thread
+        m_height_samples_revision   = samples->revision;
+        shared_ptr<vector<Chunk>> chunks = make_shared<vector<Chunk>>();
+        m_generate = TaskChain(m_context->GetSubsystem<Threading>());
+        m_generate.Then(Threading_Pool_Background, [this, samples, chunks]()
+        {
+            const vector<std::byte> density_map = m_density_map ? m_density_map->GetMipmap(0) : vector<std::byte>();
+            Generate(*samples, density_map, m_density_map ? m_density_map->GetWidth() : 0, m_density_map ? m_density_map->GetHeight() : 0, *chunks);
+        })
+        .Then(Threading_Pool_Main, [this, chunks]()
+        {
+            uint32_t instance_count = 0;
+            for (const Chunk& chunk : *chunks)
+            {
+                instance_count += static_cast<uint32_t>(chunk.instances.size());
+            }
+
+            ChunksCreate(*chunks);
+            m_instance_count = instance_count;
+        });
+    }
+
+    void Foliage::Generate(const Terrain_HeightSamples& samples, const vector<std::byte>& density_map, const uint32_t density_width, const uint32_t density_height, vector<Chunk>& chunks)
+    {
+        Entity* source_entity           = GetSource();
+        const Renderable* source        = source_entity ? source_entity->GetRenderable() : nullptr;
+        const bool has_density_map      = !density_map.empty() && density_map.size() >= density_width * density_height * 4;
+        if (!source || !source->GeometryModel() || samples.width < 2 || samples.height < 2)
+            return;
+
+        // A height at a point of the grid, bilinearly between the samples around it
+        auto height_at = [&samples](const float x, const float y)
+        {
+            const uint32_t x0   = Helper::Min(static_cast<uint32_t>(x), samples.width - 2);
+            const uint32_t y0   = Helper::Min(static_cast<uint32_t>(y), samples.height - 2);
+            const float fx      = Helper::Saturate(x - static_cast<float>(x0));
+            const float fy      = Helper::Saturate(y - static_cast<float>(y0));
+            const uint8_t* row0 = &samples.heights[y0 * samples.width + x0];
+            const uint8_t* row1 = row0 + samples.width;
+            const float top     = Helper::Lerp(static_cast<float>(row0[0]), static_cast<float>(row0[1]), fx);
+            const float bottom  = Helper::Lerp(static_cast<float>(row1[0]), static_cast<float>(row1[1]), fx);
+            const float height  = Helper::Lerp(top, bottom, fy) / 255.0f;
+            return Helper::Lerp(samples.min_y, samples.max_y, height);
+        };
+
+        // The density at a point of the grid, the map is stretched over the whole terrain
+        auto density_at = [&](const float x, const float y)
+        {
+            if (!has_density_map)
+                return 1.0f;
+
+            const uint32_t u = Helper::Min(static_cast<uint32_t>(x / static_cast<float>(samples.width - 1) * density_width), density_width - 1);
+            const uint32_t v = Helper::Min(static_cast<uint32_t>(y / static_cast<float>(samples.height - 1) * density_height), density_height - 1);
+            return static_cast<float>(density_map[(v * density_width + u) * 4]) / 255.0f;
+        };
+
+        // Square chunks of the grid, each scattered by a generator of its own so that the result doesn't depend on the order they are scattered in
+        const uint32_t chunk_count_x    = (samples.width - 2) / m_chunk_size + 1;
+        const uint32_t chunk_count_y    = (samples.height - 2) / m_chunk_size + 1;
+        const BoundingBox& source_box   = source->GetBoundingBox();
+        for (uint32_t chunk_y = 0; chunk_y < chunk_count_y; chunk_y++)
+        {
+            for (uint32_t chunk_x = 0; chunk_x < chunk_count_x; chunk_x++)
+            {
+                const float x_start = static_cast<float>(chunk_x * m_chunk_size);
+                const float y_start = static_cast<float>(chunk_y * m_chunk_size);
+                const float x_size  = Helper::Min(static_cast<float>(m_chunk_size), static_cast<float>(samples.width - 1) - x_start);
+                const float y_size  = Helper::Min(static_cast<float>(m_chunk_size), static_cast<float>(samples.height - 1) - y_start);
+
+                mt19937 generator(m_seed * 73856093u ^ chunk_x * 19349663u ^ chunk_y * 83492791u);
+                uniform_real_distribution<float> random(0.0f, 1.0f);
+
+                // As many candidates as full density asks for, the density map then keeps a share of them
+                Chunk chunk;
+                const uint32_t candidate_count = static_cast<uint32_t>(m_density * x_size * y_size + random(generator));
+                for (uint32_t i = 0; i < candidate_count; i++)
+                {
+                    const float x       = x_start + random(generator) * x_size;
+                    const float y       = y_start + random(generator) * y_size;
+                    const float keep    = random(generator);
+                    const float yaw     = random(generator) * Helper::PI_2;
+                    const float scale   = Helper::Lerp(m_scale_min, m_scale_max, random(generator));
+                    if (keep >= density_at(x, y))
+                        continue;
+
+                    // Centered like the positions of the terrain
+                    const Vector3 position = Vector3(x - samples.width * 0.5f, height_at(x, y), y - samples.height * 0.5f);
+                    const Matrix& instance = chunk.instances.emplace_back(position, Quaternion::FromYawPitchRoll(yaw, 0.0f, 0.0f), Vector3(scale));
+                    chunk.aabb.Merge(source_box.Transform(instance));
+                }
+
+                if (!chunk.instances.empty())
+                {
+                    chunks.emplace_back(move(chunk));
+                }
+            }
+        }
+    }
+
+    void Foliage::ChunksRemove()
+    {
+        World* world = m_context->GetSubsystem<World>();
+
+        for (Transform* child : m_entity->GetTransform()->GetChildren())
+        {
+            if (child->GetEntity()->GetName().rfind(m_chunk_name, 0) == 0)
+            {
+                world->EntityRemove(world->EntityGetById(child->GetEntity()->GetId()));
+            }
+        }
+    }
+
+    void Foliage::ChunksCreate(vector<Chunk>& chunks)
+    {
+        ChunksRemove();
+
+        const Renderable* source = GetSource() ? GetSource()->GetRenderable() : nullptr;
+        if (!source)
+            return;
+
+        // The errors of the levels of detail are relative to the diagonal of the bounding box, which is the whole chunk now
+        const float source_diagonal             = source->GetBoundingBox().GetSize().Length();
+        const shared_ptr<Material> material     = m_context->GetSubsystem<ResourceCache>()->GetByName<Material>(source->GetMaterialName());
+
+        // A child entity per chunk, so that each one is culled and picks its level of detail on its own
+        World* world = m_context->GetSubsystem<World>();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(chunks.size()); i++)
+        {
+            Chunk& chunk = chunks[i];
+
+            shared_ptr<Entity> entity = world->EntityCreate();
+            entity->SetName(string(m_chunk_name) + to_string(i));
+            entity->SetHierarchyVisibility(false);
+            entity->GetTransform()->SetParent(m_entity->GetTransform());
+
+            if (Renderable* renderable = entity->AddComponent<Renderable>())
+            {
+                renderable->GeometrySet(
+                    source->GeometryName(),
+                    source->GeometryIndexOffset(),
+                    source->GeometryIndexCount(),
+                    source->GeometryVertexOffset(),
+                    source->GeometryVertexCount(),
+                    chunk.aabb,
+                    const_cast<Model*>(source->GeometryModel())
+                );
+
+                const float error_scale = source_diagonal / Helper::Max(chunk.aabb.GetSize().Length(), Helper::M_EPSILON);
+                for (uint32_t lod = 1; lod < source->GeometryLodCount(); lod++)
+                {
+                    renderable->GeometryLodAdd(source->GeometryLodIndexOffset(lod), source->GeometryLodIndexCount(lod), source->GeometryLodError(lod) * error_scale);
+                }
+
+                renderable->SetInstances(move(chunk.instances));
+                renderable->SetCastShadows(source->GetCastShadows());
+                renderable->SetReceiveShadows(source->GetReceiveShadows());
+                renderable->SetImpostorDistance(source->GetImpostorDistance());
+                if (material)
+                {
+                    renderable->SetMaterial(material);
+                }
+                else
+                {
+                    renderable->UseDefaultMaterial();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ========================
+#include "IComponent.h"
+#include <atomic>
+#include "../../RHI/RHI_Definition.h"
+#include "../../Math/BoundingBox.h"
+#include "../../Math/Matrix.h"
+#include "../../Threading/Threading.h"
+//===================================
+
+namespace Spartan
+{
+    class Entity;
+    struct Terrain_HeightSamples;
+
+    // Scatters copies of an entity's geometry over the terrain of the same entity, as many as a density map asks for. The copies of a chunk of
+    // the terrain are a single child entity whose renderable carries them as instances (see Renderable::SetInstances()), so the renderer culls,
+    // picks the level of detail of and sorts a chunk at a time and draws each one with a single instanced draw, however many copies it has.
+    class SPARTAN_CLASS Foliage : public IComponent
+    {
+    public:
+        Foliage(Context* context, Entity* entity, uint32_t id = 0);
+        ~Foliage();
+
+        //= IComponent ===============================
+        void OnTick(float delta_time) override;
+        void Serialize(FileStream* stream) override;
+        void Deserialize(FileStream* stream) override;
+        //============================================
+
+        // The entity whose renderable (geometry, levels of detail and material) is scattered
+        Entity* GetSource() const;
+        void SetSource(const Entity* source);
+
+        // The first channel of the density map scales the density across the terrain (no map is full density everywhere)
+        const auto& GetDensityMap() const { return m_density_map; }
+        void SetDensityMap(const std::shared_ptr<RHI_Texture2D>& density_map);
+
+        // Copies per square unit of the terrain, at full density
+        float GetDensity() const                { return m_density; }
+        void SetDensity(const float density)    { m_density = density; }
+
+        float GetScaleMin() const               { return m_scale_min; }
+        void SetScaleMin(const float scale)     { m_scale_min = scale; }
+        float GetScaleMax() const               { return m_scale_max; }
+        void SetScaleMax(const float scale)     { m_scale_max = scale; }
+
+        // The same seed scatters the same way
+        uint32_t GetSeed() const                { return m_seed; }
+        void SetSeed(const uint32_t seed)       { m_seed = seed; }
+
+        uint32_t GetInstanceCount() const       { return m_instance_count; }
+
+        // Scatters again, in the background, it also happens on its own whenever the terrain generates
+        void GenerateAsync();
+
+    private:
+        struct Chunk
+        {
+            std::vector<Math::Matrix> instances; // relative to the terrain
+            Math::BoundingBox aabb;
+        };
+        // Scatters the instances into chunks, it only reads, so it runs in the background
+        void Generate(const Terrain_HeightSamples& samples, const std::vector<std::byte>& density_map, uint32_t density_width, uint32_t density_height, std::vector<Chunk>& chunks);
+        void ChunksRemove();
+        void ChunksCreate(std::vector<Chunk>& chunks); // moves the instances out
+
+        static const uint32_t m_chunk_size          = 32; // units along a side, in the grid of the terrain
+        static constexpr const char* m_chunk_name   = "foliage_chunk_"; // the names of the chunk entities start with it
+
+        uint32_t m_source_id                        = 0;
+        std::shared_ptr<RHI_Texture2D> m_density_map;
+        float m_density                             = 0.1f;
+        float m_scale_min                           = 0.8f;
+        float m_scale_max                           = 1.2f;
+        uint32_t m_seed                             = 0;
+        uint32_t m_instance_count                   = 0;
+        uint32_t m_height_samples_revision          = 0; // of the terrain, as of the last scattering
+        TaskChain m_generate;
+    };
+}
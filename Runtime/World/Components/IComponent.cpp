@@ -34,6 +34,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderable.h"
 #include "Transform.h"
 #include "Terrain.h"
+#include "Animator.h"
+#include "Foliage.h"
+#include "ParticleEmitter.h"
+#include "Decal.h"
+#include "ReflectionProbe.h"
 #include "../Entity.h"
 #include "../../Core/FileSystem.h"
 //================================
@@ -82,5 +87,10 @@ namespace Spartan
 	REGISTER_COMPONENT(Script,			ComponentType_Script)
 	REGISTER_COMPONENT(Environment,		ComponentType_Environment)
     REGISTER_COMPONENT(Terrain,         ComponentType_Terrain)
+    REGISTER_COMPONENT(Animator,        ComponentType_Animator)
+    REGISTER_COMPONENT(Foliage,         ComponentType_Foliage)
+    REGISTER_COMPONENT(ParticleEmitter, ComponentType_ParticleEmitter)
+    REGISTER_COMPONENT(Decal,           ComponentType_Decal)
+    REGISTER_COMPONENT(ReflectionProbe, ComponentType_ReflectionProbe)
 	REGISTER_COMPONENT(Transform,		ComponentType_Transform)
 }
@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <any>
 #include <vector>
 #include <functional>
+#include <type_traits>
 #include "../../Core/EngineDefs.h"
 #include "../../Core/Spartan_Object.h"
 //====================================
@@ -53,9 +54,22 @@ namespace Spartan
 		ComponentType_Environment,
 		ComponentType_Transform,
         ComponentType_Terrain,
+        ComponentType_Animator,
+        ComponentType_Foliage,
+        ComponentType_ParticleEmitter,
+        ComponentType_Decal,
+        ComponentType_ReflectionProbe,
 		ComponentType_Unknown
 	};
 
+	// The update phases a component can take part in, the world only calls a component for the phases it overrides
+	enum ComponentPhase : uint8_t
+	{
+		ComponentPhase_Start	= 1 << 0,
+		ComponentPhase_Stop		= 1 << 1,
+		ComponentPhase_Tick		= 1 << 2
+	};
+
 	struct Attribute
 	{
 		std::function<std::any()> getter;
@@ -83,6 +97,9 @@ namespace Spartan
 		// Runs every frame
 		virtual void OnTick(float delta_time) {}
 
+		// Runs when the renderer takes a snapshot, the simulation is not running so it's safe to copy anything the renderer reads
+		virtual void OnSnapshot() {}
+
 		// Runs when the entity is being saved
 		virtual void Serialize(FileStream* stream) {}
 
@@ -99,6 +116,19 @@ namespace Spartan
 		Context* GetContext() const			        { return m_context; }
 		ComponentType GetType() const	            { return m_type; }
         void SetType(ComponentType type)            { m_type = type; }
+        bool HasPhase(ComponentPhase phase) const   { return (m_phases & phase) != 0; }
+        bool IsTickable() const                     { return HasPhase(ComponentPhase_Tick); }
+        void SetPhases(uint8_t phases)              { m_phases = phases; }
+
+        // The phases which T overrides
+        template <typename T>
+        static constexpr uint8_t PhasesOf()
+        {
+            return
+                (std::is_same<decltype(&T::OnStart), void (IComponent::*)()>::value         ? 0 : ComponentPhase_Start) |
+                (std::is_same<decltype(&T::OnStop), void (IComponent::*)()>::value          ? 0 : ComponentPhase_Stop)  |
+                (std::is_same<decltype(&T::OnTick), void (IComponent::*)(float)>::value     ? 0 : ComponentPhase_Tick);
+        }
 
         template <typename T>
         std::shared_ptr<T> GetPtrShared() { return dynamic_pointer_cast<T>(shared_from_this()); }
@@ -143,6 +173,8 @@ namespace Spartan
 		ComponentType m_type	= ComponentType_Unknown;
 		// The state of the component
 		bool m_enabled			= false;
+		// The phases which the component overrides (see ComponentPhase)
+		uint8_t m_phases		= ComponentPhase_Start | ComponentPhase_Stop | ComponentPhase_Tick;
 		// The owner of the component
 		Entity* m_entity		= nullptr;
 		// The transform of the component (always exists)
@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderable.h"
 #include "../World.h"
 #include "../../IO/FileStream.h"
+#include "../../Core/FrameArena.h"
 #include "../../Rendering/Renderer.h"
 #include "../../RHI/RHI_Texture2D.h"
 #include "../../RHI/RHI_TextureCube.h"
@@ -56,7 +57,10 @@ namespace Spartan
 
 	void Light::OnInitialize()
 	{
-        
+        if (m_renderer)
+        {
+            m_renderer->RegistryAdd(m_entity, Renderer_Object_Light);
+        }
 	}
 
 	void Light::OnStart()
@@ -64,7 +68,16 @@ namespace Spartan
 		
 	}
 
-	void Light::OnTick(float delta_time)
+	void Light::OnRemove()
+	{
+        // The renderer can already be gone if the engine is shutting down
+        if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+        {
+            renderer->RegistryRemove(m_entity, Renderer_Object_Light);
+        }
+	}
+
+	void Light::OnSnapshot()
 	{
         // Used in many places, no point in continuing without it
         if (!m_renderer)
@@ -73,6 +86,11 @@ namespace Spartan
             return;
         }
 
+        // The shadow matrices are only ever read by the renderer, so they are computed here
+        // instead of OnTick(), this way the simulation is free to move the light while a frame is recorded.
+        m_position_render   = GetTransform()->GetPosition();
+        m_direction_render  = GetDirection();
+
         // During engine startup, keep checking until the rhi device gets
         // created so we can create potentially required shadow maps
         if (!m_initialized)
@@ -233,6 +251,13 @@ namespace Spartan
                     Vector3 up              = Vector3::Up;
                     m_matrix_view[i]        = Matrix::CreateLookAtLH(position, target, up);
                 }
+
+                // The cascades only differ in translation, so the first view can take any cascade's center to light space
+                for (uint32_t i = 0; i < m_cascade_count; i++)
+                {
+                    ShadowSlice& shadow_map = m_shadow_map.slices[i];
+                    shadow_map.center_view  = shadow_map.center * m_matrix_view[0];
+                }
             }
 		}
 		else if (m_light_type == LightType_Spot)
@@ -336,7 +361,7 @@ namespace Spartan
         const float max_z         = clip_near + clip_range;
         const float range         = max_z - min_z;
         const float ratio         = max_z / min_z;    
-        vector<float> splits(m_cascade_count);
+        FrameVector<float> splits(m_cascade_count);
         for (uint32_t i = 0; i < m_cascade_count; i++)
         {
             const float p           = (i + 1) / static_cast<float>(m_cascade_count);
@@ -482,13 +507,94 @@ namespace Spartan
 
     bool Light::IsInViewFrustrum(Renderable* renderable, uint32_t index) const
     {
-        const auto box          = renderable->GetAabb();
-        const auto center       = box.GetCenter();
-        const auto extents      = box.GetExtents();
+        const auto box = renderable->GetAabbRender();
+        return IsInViewFrustrum(box.GetCenter(), box.GetExtents(), index);
+    }
 
+    bool Light::IsInViewFrustrum(const Vector3& center, const Vector3& extents, uint32_t index) const
+    {
         // ensure that potential shadow casters from behind the near plane are not rejected
         const bool ignore_near_plane = (m_light_type == LightType_Directional) ? true : false; 
 
         return m_shadow_map.slices[index].frustum.IsVisible(center, extents, ignore_near_plane);
     }
+
+    void Light::IsInViewFrustrum(const FrustumBoxes& boxes, uint32_t index, vector<uint8_t>& visible) const
+    {
+        const bool ignore_near_plane = m_light_type == LightType_Directional;
+        m_shadow_map.slices[index].frustum.IsVisible(boxes, visible, ignore_near_plane);
+    }
+
+    bool Light::IsVisible(const Frustum& frustum) const
+    {
+        if (m_light_type == LightType_Directional)
+            return true;
+
+        Vector3 center;
+        Vector3 extents;
+        GetBoundingBox(center, extents);
+
+        return frustum.IsVisible(center, extents);
+    }
+
+    void Light::GetBoundingBox(Vector3& center, Vector3& extents) const
+    {
+        // The box of the range
+        center  = m_position_render;
+        extents = Vector3(m_range);
+
+        // Spot lights, the box of the cone (the angle is the cosine distance of its edge from the direction), which is the apex and the disc that caps it
+        const float cos_angle = 1.0f - m_angle_rad;
+        if (m_light_type == LightType_Spot && cos_angle > 0.0f)
+        {
+            const Vector3& direction    = m_direction_render;
+            const Vector3 cap_center    = m_position_render + direction * m_range;
+            const float cap_radius      = m_range * Helper::Sqrt(1.0f - cos_angle * cos_angle) / cos_angle;
+            const Vector3 cap_extents   = Vector3
+            (
+                cap_radius * Helper::Sqrt(Helper::Max(1.0f - direction.x * direction.x, 0.0f)),
+                cap_radius * Helper::Sqrt(Helper::Max(1.0f - direction.y * direction.y, 0.0f)),
+                cap_radius * Helper::Sqrt(Helper::Max(1.0f - direction.z * direction.z, 0.0f))
+            );
+            const Vector3 cap_min   = cap_center - cap_extents;
+            const Vector3 cap_max   = cap_center + cap_extents;
+            const Vector3 min       = Vector3(Helper::Min(m_position_render.x, cap_min.x), Helper::Min(m_position_render.y, cap_min.y), Helper::Min(m_position_render.z, cap_min.z));
+            const Vector3 max       = Vector3(Helper::Max(m_position_render.x, cap_max.x), Helper::Max(m_position_render.y, cap_max.y), Helper::Max(m_position_render.z, cap_max.z));
+            center                  = (min + max) * 0.5f;
+            extents                 = (max - min) * 0.5f;
+        }
+    }
+
+    uint32_t Light::GetCascadeMask(const Vector3& center, const Vector3& extents) const
+    {
+        if (m_light_type != LightType_Directional || m_shadow_map.slices.empty())
+            return 0;
+
+        // Light space box, the extents are rotated by taking the absolute of the view's rotation
+        const Matrix& view          = m_matrix_view[0];
+        const Vector3 center_view   = center * view;
+        const Vector3 extents_view  = Vector3
+        (
+            extents.x * Helper::Abs(view.m00) + extents.y * Helper::Abs(view.m10) + extents.z * Helper::Abs(view.m20),
+            extents.x * Helper::Abs(view.m01) + extents.y * Helper::Abs(view.m11) + extents.z * Helper::Abs(view.m21),
+            extents.x * Helper::Abs(view.m02) + extents.y * Helper::Abs(view.m12) + extents.z * Helper::Abs(view.m22)
+        );
+
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < m_cascade_count; i++)
+        {
+            const ShadowSlice& shadow_slice = m_shadow_map.slices[i];
+            const Vector3 offset            = center_view - shadow_slice.center_view;
+
+            // Casters in front of the near plane are kept (they can still cast into the cascade), so only the far plane is tested
+            const float depth_far = (shadow_slice.max.z - shadow_slice.min.z) * 10.0f - shadow_slice.max.z;
+            if (Helper::Abs(offset.x) - extents_view.x > shadow_slice.max.x) continue;
+            if (Helper::Abs(offset.y) - extents_view.y > shadow_slice.max.y) continue;
+            if (offset.z - extents_view.z > depth_far) continue;
+
+            mask |= 1 << i;
+        }
+
+        return mask;
+    }
 }  
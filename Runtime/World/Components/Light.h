@@ -50,6 +50,7 @@ namespace Spartan
         Math::Vector3 min       = Math::Vector3::Zero;
         Math::Vector3 max       = Math::Vector3::Zero;
         Math::Vector3 center    = Math::Vector3::Zero;
+        Math::Vector3 center_view = Math::Vector3::Zero; // directional only, the center in the orientation which all cascades share
         Math::Frustum frustum;
     };
 
@@ -69,7 +70,8 @@ namespace Spartan
 		//= COMPONENT ================================
 		void OnInitialize() override;
 		void OnStart() override;
-		void OnTick(float delta_time) override;
+		void OnRemove() override;
+		void OnSnapshot() override;
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
 		//============================================
@@ -109,6 +111,8 @@ namespace Spartan
 		auto GetNormalBias() const { return m_normal_bias; }
 
 		Math::Vector3 GetDirection() const;
+        const Math::Vector3& GetPositionRender()    const { return m_position_render; }   // as of the last renderer snapshot
+        const Math::Vector3& GetDirectionRender()   const { return m_direction_render; }  // as of the last renderer snapshot
 
 		const Math::Matrix& GetViewMatrix(uint32_t index = 0) const;
 		const Math::Matrix& GetProjectionMatrix(uint32_t index = 0) const;
@@ -119,6 +123,15 @@ namespace Spartan
         void CreateShadowMap();
 
         bool IsInViewFrustrum(Renderable* renderable, uint32_t index) const;
+        bool IsInViewFrustrum(const Math::Vector3& center, const Math::Vector3& extents, uint32_t index) const;
+        void IsInViewFrustrum(const Math::FrustumBoxes& boxes, uint32_t index, std::vector<uint8_t>& visible) const;
+        // Directional only, returns a bit per cascade which the box overlaps (the box is brought to light space once, for all cascades)
+        uint32_t GetCascadeMask(const Math::Vector3& center, const Math::Vector3& extents) const;
+        uint32_t GetCascadeCount() const { return m_cascade_count; }
+        // Whether anything the light reaches (its range, or its cone for spot lights) is within the frustum, directional lights reach everything
+        bool IsVisible(const Math::Frustum& frustum) const;
+        // The box around what a point or spot light reaches
+        void GetBoundingBox(Math::Vector3& center, Math::Vector3& extents) const;
 
 	private:
 		void ComputeViewMatrix();
@@ -144,6 +157,8 @@ namespace Spartan
         Math::Quaternion m_previous_rot     = Math::Quaternion::Identity;
         Math::Vector3 m_previous_pos        = Math::Vector3::Infinity;
         Math::Matrix m_previous_camera_view = Math::Matrix::Identity;    	
+        Math::Vector3 m_position_render     = Math::Vector3::Zero;
+        Math::Vector3 m_direction_render    = Math::Vector3::Forward;
         ShadowMap m_shadow_map;
 
 		Renderer* m_renderer;
@@ -0,0 +1,165 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ============================
+#include "ParticleEmitter.h"
+#include "Transform.h"
+#include "..\..\IO\FileStream.h"
+#include "..\..\Rendering\Renderer.h"
+#include "..\..\Resource\ResourceCache.h"
+#include "..\..\RHI\RHI_Texture2D.h"
+//=======================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    ParticleEmitter::ParticleEmitter(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
+    {
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_emission_rate, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_lifetime, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_velocity, Vector3);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_velocity_spread, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_gravity, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_size_start, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_size_end, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_color_start, Vector4);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_color_end, Vector4);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_intensity, float);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_seed, uint32_t);
+
+        m_renderer = m_context->GetSubsystem<Renderer>();
+    }
+
+    void ParticleEmitter::OnInitialize()
+    {
+        if (m_renderer)
+        {
+            m_renderer->RegistryAdd(m_entity, Renderer_Object_ParticleEmitter);
+        }
+    }
+
+    void ParticleEmitter::OnRemove()
+    {
+        // The renderer can already be gone if the engine is shutting down
+        if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+        {
+            renderer->RegistryRemove(m_entity, Renderer_Object_ParticleEmitter);
+        }
+    }
+
+    void ParticleEmitter::OnTick(float delta_time)
+    {
+        m_time += delta_time;
+
+        // Once every particle has spawned, the time goes back by whole periods so it keeps its precision (particles pick their randomness
+        // by their spawn cycle modulo as many periods, so none of them jumps)
+        const float period  = GetPeriod();
+        const float wrap    = period * static_cast<float>(particle_cycles);
+        if (period > 0.0f && m_time >= period + wrap)
+        {
+            m_time -= wrap;
+        }
+    }
+
+    void ParticleEmitter::OnSnapshot()
+    {
+        m_time_render = m_time;
+    }
+
+    void ParticleEmitter::Serialize(FileStream* stream)
+    {
+        stream->Write(m_emission_rate);
+        stream->Write(m_lifetime);
+        stream->Write(m_velocity);
+        stream->Write(m_velocity_spread);
+        stream->Write(m_gravity);
+        stream->Write(m_size_start);
+        stream->Write(m_size_end);
+        stream->Write(m_color_start);
+        stream->Write(m_color_end);
+        stream->Write(m_intensity);
+        stream->Write(m_texture ? m_texture->GetResourceFilePathNative() : string());
+        stream->Write(m_seed);
+    }
+
+    void ParticleEmitter::Deserialize(FileStream* stream)
+    {
+        stream->Read(&m_emission_rate);
+        stream->Read(&m_lifetime);
+        stream->Read(&m_velocity);
+        stream->Read(&m_velocity_spread);
+        stream->Read(&m_gravity);
+        stream->Read(&m_size_start);
+        stream->Read(&m_size_end);
+        stream->Read(&m_color_start);
+        stream->Read(&m_color_end);
+        stream->Read(&m_intensity);
+        m_texture = m_context->GetSubsystem<ResourceCache>()->GetByPath<RHI_Texture2D>(stream->ReadAs<string>());
+        stream->Read(&m_seed);
+    }
+
+    void ParticleEmitter::SetEmissionRate(const float rate)
+    {
+        m_emission_rate = Helper::Clamp(rate, 0.0f, static_cast<float>(particle_count_max) / Helper::Max(m_lifetime, Helper::M_EPSILON));
+    }
+
+    void ParticleEmitter::SetLifetime(const float lifetime)
+    {
+        m_lifetime = Helper::Max(lifetime, Helper::M_EPSILON);
+        SetEmissionRate(m_emission_rate);
+    }
+
+    void ParticleEmitter::SetTexture(const shared_ptr<RHI_Texture2D>& texture)
+    {
+        // In order for the component to guarantee serialization/deserialization, we cache the texture
+        m_texture = texture ? m_context->GetSubsystem<ResourceCache>()->Cache<RHI_Texture2D>(texture) : nullptr;
+    }
+
+    uint32_t ParticleEmitter::GetParticleCount() const
+    {
+        return Helper::Min(static_cast<uint32_t>(Helper::Ceil(m_emission_rate * m_lifetime)), particle_count_max);
+    }
+
+    float ParticleEmitter::GetPeriod() const
+    {
+        // Particle i spawns at i / rate, and again a period later, by then it's dead
+        return m_emission_rate > 0.0f ? static_cast<float>(GetParticleCount()) / m_emission_rate : 0.0f;
+    }
+
+    BoundingBox ParticleEmitter::GetAabb() const
+    {
+        // As far as a particle can get from the emitter over its lifetime, in any direction
+        const Matrix& transform = GetTransform()->GetMatrixRender();
+        const Vector3 scale     = transform.GetScale();
+        const float scale_max   = Helper::Max(Helper::Max(Helper::Abs(scale.x), Helper::Abs(scale.y)), Helper::Abs(scale.z));
+        const float reach       = (m_velocity.Length() + m_velocity_spread) * m_lifetime * scale_max;
+        const float fall        = 0.5f * Helper::Abs(m_gravity) * m_lifetime * m_lifetime;
+        const float extent      = reach + fall + Helper::Max(m_size_start, m_size_end);
+
+        const Vector3 center = transform.GetTranslation();
+        return BoundingBox(center - Vector3(extent, extent, extent), center + Vector3(extent, extent, extent));
+    }
+}
@@ -0,0 +1,125 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ========================
+#include "IComponent.h"
+#include "../../RHI/RHI_Definition.h"
+#include "../../Math/BoundingBox.h"
+#include "../../Math/MathHelper.h"
+#include "../../Math/Vector3.h"
+#include "../../Math/Vector4.h"
+//===================================
+
+namespace Spartan
+{
+    class Renderer;
+
+    // Emits particles which have no state of their own. A particle is a function of its index and the emitter's time: it spawns every period
+    // (the time it takes to emit all of them), flies from the emitter with the velocity plus a random one and falls with the gravity, growing
+    // from the start size to the end size and fading from the start color to the end color over its lifetime. The renderer draws an emitter
+    // with a single instanced draw of a quad and computes the particles in the vertex shader, so only these parameters are on the CPU.
+    class SPARTAN_CLASS ParticleEmitter : public IComponent
+    {
+    public:
+        ParticleEmitter(Context* context, Entity* entity, uint32_t id = 0);
+        ~ParticleEmitter() = default;
+
+        //= IComponent ===============================
+        void OnInitialize() override;
+        void OnRemove() override;
+        void OnTick(float delta_time) override;
+        void OnSnapshot() override;
+        void Serialize(FileStream* stream) override;
+        void Deserialize(FileStream* stream) override;
+        //============================================
+
+        // Particles per second, up to particle_count_max alive at once
+        float GetEmissionRate() const                           { return m_emission_rate; }
+        void SetEmissionRate(const float rate);
+
+        // Seconds a particle lives
+        float GetLifetime() const                               { return m_lifetime; }
+        void SetLifetime(const float lifetime);
+
+        // Velocity at spawn, in the space of the emitter, the spread is the radius of the sphere a random velocity is added from
+        const auto& GetVelocity() const                         { return m_velocity; }
+        void SetVelocity(const Math::Vector3& velocity)         { m_velocity = velocity; }
+        float GetVelocitySpread() const                         { return m_velocity_spread; }
+        void SetVelocitySpread(const float spread)              { m_velocity_spread = Math::Helper::Max(spread, 0.0f); }
+
+        // Acceleration along the world's up axis
+        float GetGravity() const                                { return m_gravity; }
+        void SetGravity(const float gravity)                    { m_gravity = gravity; }
+
+        float GetSizeStart() const                              { return m_size_start; }
+        void SetSizeStart(const float size)                     { m_size_start = Math::Helper::Max(size, 0.0f); }
+        float GetSizeEnd() const                                { return m_size_end; }
+        void SetSizeEnd(const float size)                       { m_size_end = Math::Helper::Max(size, 0.0f); }
+
+        // Particles are blended additively, the alpha scales the color
+        const auto& GetColorStart() const                       { return m_color_start; }
+        void SetColorStart(const Math::Vector4& color)          { m_color_start = color; }
+        const auto& GetColorEnd() const                         { return m_color_end; }
+        void SetColorEnd(const Math::Vector4& color)            { m_color_end = color; }
+        float GetIntensity() const                              { return m_intensity; }
+        void SetIntensity(const float intensity)                { m_intensity = Math::Helper::Max(intensity, 0.0f); }
+
+        // The sprite of a particle (no texture is a soft disc)
+        const auto& GetTexture() const                          { return m_texture; }
+        void SetTexture(const std::shared_ptr<RHI_Texture2D>& texture);
+
+        // The same seed emits the same way
+        uint32_t GetSeed() const                                { return m_seed; }
+        void SetSeed(const uint32_t seed)                       { m_seed = seed; }
+
+        // Emits from the start again
+        void Restart()                                          { m_time = 0.0f; }
+
+        // For the renderer
+        float GetTime() const                                   { return m_time_render; } // as of the last renderer snapshot
+        float GetPeriod() const;
+        uint32_t GetParticleCount() const;
+        Math::BoundingBox GetAabb() const; // of every particle that can be alive
+
+        static const uint32_t particle_count_max    = 262144;
+        static const uint32_t particle_cycles       = 1024; // spawn cycles of a particle with a randomness of their own, must match the shader
+
+    private:
+        float m_emission_rate           = 50.0f;
+        float m_lifetime                = 2.0f;
+        Math::Vector3 m_velocity        = Math::Vector3(0.0f, 2.0f, 0.0f);
+        float m_velocity_spread         = 0.5f;
+        float m_gravity                 = -1.0f;
+        float m_size_start              = 0.1f;
+        float m_size_end                = 0.3f;
+        Math::Vector4 m_color_start     = Math::Vector4(1.0f, 0.6f, 0.2f, 1.0f);
+        Math::Vector4 m_color_end       = Math::Vector4(1.0f, 0.1f, 0.0f, 0.0f);
+        float m_intensity               = 1.0f;
+        std::shared_ptr<RHI_Texture2D> m_texture;
+        uint32_t m_seed                 = 0;
+        float m_time                    = 0.0f;
+        float m_time_render             = 0.0f;
+        Renderer* m_renderer            = nullptr;
+    };
+}
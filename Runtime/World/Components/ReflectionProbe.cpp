@@ -0,0 +1,74 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ============================
+#include "ReflectionProbe.h"
+#include "..\..\IO\FileStream.h"
+#include "..\..\Rendering\Renderer.h"
+//=======================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    ReflectionProbe::ReflectionProbe(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
+    {
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_extents, Vector3);
+        REGISTER_ATTRIBUTE_VALUE_VALUE(m_fade_distance, float);
+    }
+
+    void ReflectionProbe::OnInitialize()
+    {
+        if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+        {
+            renderer->RegistryAdd(m_entity, Renderer_Object_ReflectionProbe);
+        }
+    }
+
+    void ReflectionProbe::OnRemove()
+    {
+        // The renderer can already be gone if the engine is shutting down
+        if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+        {
+            renderer->RegistryRemove(m_entity, Renderer_Object_ReflectionProbe);
+        }
+    }
+
+    void ReflectionProbe::Serialize(FileStream* stream)
+    {
+        stream->Write(m_extents);
+        stream->Write(m_fade_distance);
+    }
+
+    void ReflectionProbe::Deserialize(FileStream* stream)
+    {
+        stream->Read(&m_extents);
+        stream->Read(&m_fade_distance);
+    }
+
+    void ReflectionProbe::SetExtents(const Vector3& extents)
+    {
+        m_extents = Vector3(Helper::Max(extents.x, Helper::M_EPSILON), Helper::Max(extents.y, Helper::M_EPSILON), Helper::Max(extents.z, Helper::M_EPSILON));
+    }
+}
@@ -0,0 +1,65 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ======================
+#include "IComponent.h"
+#include "../../Math/MathHelper.h"
+#include "../../Math/Vector3.h"
+//=================================
+
+namespace Spartan
+{
+    // Captures its surroundings from the entity's position, the renderer bakes the capture into a prefiltered environment of its own
+    // (once, and again when the probe moves or is asked to) and the lighting pass samples it instead of the environment for the pixels
+    // inside the probe's box, with the reflections projected onto the box so that they line up with the walls around them.
+    class SPARTAN_CLASS ReflectionProbe : public IComponent
+    {
+    public:
+        ReflectionProbe(Context* context, Entity* entity, uint32_t id = 0);
+        ~ReflectionProbe() = default;
+
+        //= IComponent ===============================
+        void OnInitialize() override;
+        void OnRemove() override;
+        void Serialize(FileStream* stream) override;
+        void Deserialize(FileStream* stream) override;
+        //============================================
+
+        // Half the size of the box, which is axis aligned and centered on the entity
+        const auto& GetExtents() const                  { return m_extents; }
+        void SetExtents(const Math::Vector3& extents);
+
+        // Distance from the box's faces over which the probe fades into the environment
+        float GetFadeDistance() const                   { return m_fade_distance; }
+        void SetFadeDistance(const float distance)      { m_fade_distance = Math::Helper::Max(distance, 0.0f); }
+
+        // Bakes the probe again, for changes around it which it can't see
+        void Bake()                                     { m_bake_revision++; }
+        uint32_t GetBakeRevision() const                { return m_bake_revision; }
+
+    private:
+        Math::Vector3 m_extents     = Math::Vector3(5.0f, 5.0f, 5.0f);
+        float m_fade_distance       = 1.0f;
+        uint32_t m_bake_revision    = 0;
+    };
+}
@@ -22,12 +22,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ============================
 #include "Renderable.h"
 #include "Transform.h"
+#include <functional>
+#include <unordered_map>
+#include "../Entity.h"
 #include "../../IO/FileStream.h"
 #include "../../Resource/ResourceCache.h"
 #include "../../Utilities/Geometry.h"
 #include "../../RHI/RHI_Texture2D.h"
 #include "../../Rendering/Model.h"
 #include "../../RHI/RHI_Vertex.h"
+#include "../../Rendering/Renderer.h"
 //=======================================
 
 //= NAMESPACES ===============
@@ -101,7 +105,7 @@ namespace Spartan
 		m_receiveShadows		= true;
 
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_material_default,       bool);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_material,              shared_ptr<Material>);
+		RegisterAttribute([this]() { return m_material; }, [this](const any& value) { m_material = any_cast<shared_ptr<Material>>(value); MaterialChanged(); });
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_castShadows,           bool);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_receiveShadows,        bool);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryIndexOffset,   uint32_t);
@@ -110,10 +114,99 @@ namespace Spartan
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryVertexCount,   uint32_t);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometryName,          string);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_model,                 shared_ptr<Model>);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_bounding_box,          BoundingBox);
+		RegisterAttribute([this]() { return m_bounding_box; }, [this](const any& value) { m_bounding_box = any_cast<BoundingBox>(value); m_aabb_revision = 0; });
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_lods,         vector<Geometry_Lod>);
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_meshlets,     vector<Geometry_Meshlet>);
+		REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_bones,        vector<Geometry_Bone>);
 		REGISTER_ATTRIBUTE_GET_SET(Geometry_Type, GeometrySet, Geometry_Type);
 	}
 
+	void Renderable::OnInitialize()
+	{
+		if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+		{
+			renderer->RegistryAdd(m_entity, Renderer_Object_Opaque);
+			renderer->RegistryClassify(m_entity);
+		}
+	}
+
+	void Renderable::OnRemove()
+	{
+		if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+		{
+			renderer->RegistryRemove(m_entity, Renderer_Object_Opaque);
+		}
+	}
+
+	void Renderable::OnSnapshot()
+	{
+		m_aabb_render = GetAabb();
+
+		if (m_geometry_bones.empty())
+		{
+			m_bone_palette_render.clear();
+			return;
+		}
+
+		// Resolve the bones again if any of them went away (or they never were)
+		bool resolve = m_bone_entities.size() != m_geometry_bones.size();
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_bone_entities.size()) && !resolve; i++)
+		{
+			resolve = m_bone_entities[i].expired();
+		}
+		if (resolve)
+		{
+			BonesResolve();
+		}
+
+		// Every bone moves the geometry from its bind pose, bones which can't be found keep it there.
+		// The bounds are the union of the bounds with every bone's movement, which covers whatever share of the geometry each bone moves.
+		const Matrix& world			= GetTransform()->GetMatrix();
+		const Matrix world_inverse	= world.Inverted();
+		m_bone_palette_render.resize(m_geometry_bones.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_geometry_bones.size()); i++)
+		{
+			const shared_ptr<Entity> bone	= m_bone_entities[i].lock();
+			m_bone_palette_render[i]		= bone ? m_geometry_bones[i].offset * bone->GetTransform()->GetMatrix() * world_inverse : Matrix::Identity;
+
+			const BoundingBox aabb = m_bounding_box.Transform(m_bone_palette_render[i] * world);
+			if (i == 0)
+			{
+				m_aabb_render = aabb;
+			}
+			else
+			{
+				m_aabb_render.Merge(aabb);
+			}
+		}
+	}
+
+	void Renderable::BonesResolve()
+	{
+		// The entities by name, the first one of a name wins (like the importer, which names the nodes after the bones)
+		unordered_map<string, Entity*> entities;
+		function<void(Transform*)> gather = [&entities, &gather](Transform* transform)
+		{
+			if (Entity* entity = transform->GetEntity())
+			{
+				entities.emplace(entity->GetName(), entity);
+			}
+
+			for (Transform* child : transform->GetChildren())
+			{
+				gather(child);
+			}
+		};
+		gather(GetTransform()->GetRoot());
+
+		m_bone_entities.resize(m_geometry_bones.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_geometry_bones.size()); i++)
+		{
+			const auto it		= entities.find(m_geometry_bones[i].name);
+			m_bone_entities[i]	= it != entities.end() ? it->second->GetPtrShared() : nullptr;
+		}
+	}
+
 	void Renderable::Serialize(FileStream* stream)
 	{
 		// Mesh
@@ -123,11 +216,40 @@ namespace Spartan
 		stream->Write(m_geometryVertexOffset);
 		stream->Write(m_geometryVertexCount);
 		stream->Write(m_bounding_box);
+		stream->Write(static_cast<uint32_t>(m_geometry_lods.size()));
+		for (const Geometry_Lod& lod : m_geometry_lods)
+		{
+			stream->Write(lod.index_offset);
+			stream->Write(lod.index_count);
+			stream->Write(lod.error);
+		}
+		stream->Write(static_cast<uint32_t>(m_geometry_meshlets.size()));
+		for (const Geometry_Meshlet& meshlet : m_geometry_meshlets)
+		{
+			stream->Write(meshlet.index_offset);
+			stream->Write(meshlet.index_count);
+			stream->Write(meshlet.center);
+			stream->Write(meshlet.radius);
+			stream->Write(meshlet.cone_axis);
+			stream->Write(meshlet.cone_cutoff);
+		}
+		stream->Write(static_cast<uint32_t>(m_geometry_bones.size()));
+		for (const Geometry_Bone& bone : m_geometry_bones)
+		{
+			stream->Write(bone.name);
+			stream->Write(bone.offset);
+		}
+		stream->Write(static_cast<uint32_t>(m_instances.size()));
+		for (const Matrix& instance : m_instances)
+		{
+			stream->Write(instance);
+		}
 		stream->Write(m_model ? m_model->GetResourceName() : "");
 
 		// Material
 		stream->Write(m_castShadows);
 		stream->Write(m_receiveShadows);
+		stream->Write(m_impostor_distance);
 		stream->Write(m_material_default);
 		if (!m_material_default)
 		{
@@ -144,6 +266,36 @@ namespace Spartan
 		m_geometryVertexOffset	= stream->ReadAs<uint32_t>();
 		m_geometryVertexCount	= stream->ReadAs<uint32_t>();
 		stream->Read(&m_bounding_box);
+		m_aabb_revision = 0;
+		m_geometry_lods.resize(stream->ReadAs<uint32_t>());
+		for (Geometry_Lod& lod : m_geometry_lods)
+		{
+			stream->Read(&lod.index_offset);
+			stream->Read(&lod.index_count);
+			stream->Read(&lod.error);
+		}
+		m_geometry_meshlets.resize(stream->ReadAs<uint32_t>());
+		for (Geometry_Meshlet& meshlet : m_geometry_meshlets)
+		{
+			stream->Read(&meshlet.index_offset);
+			stream->Read(&meshlet.index_count);
+			stream->Read(&meshlet.center);
+			stream->Read(&meshlet.radius);
+			stream->Read(&meshlet.cone_axis);
+			stream->Read(&meshlet.cone_cutoff);
+		}
+		m_geometry_bones.resize(stream->ReadAs<uint32_t>());
+		for (Geometry_Bone& bone : m_geometry_bones)
+		{
+			stream->Read(&bone.name);
+			stream->Read(&bone.offset);
+		}
+		m_bone_entities.clear();
+		m_instances.resize(stream->ReadAs<uint32_t>());
+		for (Matrix& instance : m_instances)
+		{
+			stream->Read(&instance);
+		}
 		string model_name;
 		stream->Read(&model_name);
 		m_model = m_context->GetSubsystem<ResourceCache>()->GetByName<Model>(model_name);
@@ -157,6 +309,7 @@ namespace Spartan
 		// Material
 		stream->Read(&m_castShadows);
 		stream->Read(&m_receiveShadows);
+		stream->Read(&m_impostor_distance);
 		stream->Read(&m_material_default);
 		if (m_material_default)
 		{
@@ -167,6 +320,7 @@ namespace Spartan
 			string material_name;
 			stream->Read(&material_name);
 			m_material = m_context->GetSubsystem<ResourceCache>()->GetByName<Material>(material_name);
+			MaterialChanged();
 		}
 	}
 
@@ -178,7 +332,12 @@ namespace Spartan
 		m_geometryVertexOffset	= vertex_offset;
 		m_geometryVertexCount	= vertex_count;
 		m_bounding_box			= bounding_box;
+		m_aabb_revision			= 0;
 		m_model					= model ? model->GetSharedPtr() : nullptr;
+		m_geometry_lods.clear();
+		m_geometry_meshlets.clear();
+		m_geometry_bones.clear();
+		m_bone_entities.clear();
 	}
 
 	void Renderable::GeometrySet(const Geometry_Type type)
@@ -207,13 +366,26 @@ namespace Spartan
 		m_model->GetGeometry(m_geometryIndexOffset, m_geometryIndexCount, m_geometryVertexOffset, m_geometryVertexCount, indices, vertices);
 	}
 
+	uint32_t Renderable::GeometryLodSelect(const float error_max) const
+	{
+		uint32_t lod = 0;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_geometry_lods.size()) && m_geometry_lods[i].error <= error_max; i++)
+		{
+			lod = i + 1;
+		}
+
+		return lod;
+	}
+
     const BoundingBox& Renderable::GetAabb()
 	{
-        // Updated if dirty
-        if (m_last_transform != GetTransform()->GetMatrix())
+        // Updated if the transform changed since
+        const Transform* transform  = GetTransform();
+        const uint64_t revision     = transform->GetMatrixRevision();
+        if (m_aabb_revision != revision)
         {
-            m_aabb = m_bounding_box.Transform(GetTransform()->GetMatrix());
-            m_last_transform = GetTransform()->GetMatrix();
+            m_aabb          = m_bounding_box.Transform(transform->GetMatrix());
+            m_aabb_revision = revision;
         }
 
 		return m_aabb;
@@ -233,6 +405,8 @@ namespace Spartan
 
         // Set to false otherwise material won't serialize/deserialize
         m_material_default = false;
+
+		MaterialChanged();
 	}
 
 	shared_ptr<Material> Renderable::SetMaterial(const string& file_path)
@@ -277,4 +451,12 @@ namespace Spartan
     {
 		return m_material ? m_material->GetResourceName() : "";
 	}
+
+	void Renderable::MaterialChanged()
+	{
+		if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+		{
+			renderer->RegistryClassify(m_entity);
+		}
+	}
 }
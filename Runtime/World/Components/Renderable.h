@@ -49,6 +49,32 @@ namespace Spartan
 		Geometry_Default_Cone
 	};
 
+	// A simplified version of the geometry, it indexes the same vertices
+	struct Geometry_Lod
+	{
+		uint32_t index_offset	= 0;
+		uint32_t index_count	= 0;
+		float error				= 0.0f; // how far the simplified surface can be from the original, relative to the bounding box diagonal
+	};
+
+	// A run of consecutive triangles of the full geometry, small enough to be culled on its own (by its bounds, and by whether all of it faces away)
+	struct Geometry_Meshlet
+	{
+		uint32_t index_offset		= 0;
+		uint32_t index_count		= 0;
+		Math::Vector3 center		= Math::Vector3::Zero;	// of the bounding sphere, in the space of the geometry
+		float radius				= 0.0f;
+		Math::Vector3 cone_axis		= Math::Vector3::Zero;	// the normals of the triangles are within a cone around it
+		float cone_cutoff			= 1.0f;					// the sine of the cone's half angle, 1 if the triangles face too many ways to ever face away together
+	};
+
+	// A bone which skinned geometry follows, it's the entity of the same name under the root of the renderable's entity
+	struct Geometry_Bone
+	{
+		std::string name;
+		Math::Matrix offset; // from the space of the geometry to the space of the bone, in the bind pose
+	};
+
 	class SPARTAN_CLASS Renderable : public IComponent
 	{
 	public:
@@ -56,6 +82,9 @@ namespace Spartan
 		~Renderable() = default;
 
 		//= ICOMPONENT ===============================
+		void OnInitialize() override;
+		void OnRemove() override;
+		void OnSnapshot() override;
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
 		//============================================
@@ -82,6 +111,32 @@ namespace Spartan
 		const Model* GeometryModel()                const { return m_model.get(); }
         const Math::BoundingBox& GetBoundingBox()   const { return m_bounding_box; }
         const Math::BoundingBox& GetAabb();
+        const Math::BoundingBox& GetAabbRender()    const { return m_aabb_render; } // as of the last renderer snapshot
+
+		// Levels of detail, level 0 is the geometry itself and every level after it is coarser
+		void GeometryLodAdd(uint32_t index_offset, uint32_t index_count, float error) { m_geometry_lods.push_back({ index_offset, index_count, error }); }
+		uint32_t GeometryLodCount()						const { return static_cast<uint32_t>(m_geometry_lods.size()) + 1; }
+		uint32_t GeometryLodIndexOffset(uint32_t lod)	const { return lod == 0 || m_geometry_lods.empty() ? m_geometryIndexOffset : m_geometry_lods[Math::Helper::Min(lod, static_cast<uint32_t>(m_geometry_lods.size())) - 1].index_offset; }
+		uint32_t GeometryLodIndexCount(uint32_t lod)	const { return lod == 0 || m_geometry_lods.empty() ? m_geometryIndexCount : m_geometry_lods[Math::Helper::Min(lod, static_cast<uint32_t>(m_geometry_lods.size())) - 1].index_count; }
+		float GeometryLodError(uint32_t lod)			const { return lod == 0 || m_geometry_lods.empty() ? 0.0f : m_geometry_lods[Math::Helper::Min(lod, static_cast<uint32_t>(m_geometry_lods.size())) - 1].error; }
+		// Returns the coarsest level whose error (relative to the bounding box diagonal) is within the given one
+		uint32_t GeometryLodSelect(float error_max) const;
+
+		// Meshlets, the full geometry (level 0) split into runs of triangles which the renderer culls one by one, geometry without them is culled as a whole
+		void GeometryMeshletAdd(const Geometry_Meshlet& meshlet)		{ m_geometry_meshlets.emplace_back(meshlet); }
+		const std::vector<Geometry_Meshlet>& GeometryMeshlets()	const	{ return m_geometry_meshlets; }
+
+		// Instances, the geometry is drawn once per transform (relative to the entity) instead of once, so a single entity stands for many copies (e.g. foliage).
+		// The bounding box which the geometry is set with has to contain all of them, and they are only drawn when the renderer draws instanced.
+		void SetInstances(std::vector<Math::Matrix>&& instances)	{ m_instances = std::move(instances); }
+		const std::vector<Math::Matrix>& GetInstances()		const	{ return m_instances; }
+		bool HasInstances()									const	{ return !m_instances.empty(); }
+
+		// Bones, which the skin of the model's vertices refers to by their index (see RHI_Vertex_Skin)
+		void GeometryBoneAdd(const std::string& name, const Math::Matrix& offset) { m_geometry_bones.push_back({ name, offset }); m_bone_entities.clear(); }
+		uint32_t GeometryBoneCount()							const { return static_cast<uint32_t>(m_geometry_bones.size()); }
+		// As of the last renderer snapshot, a matrix per bone which takes the vertices from the bind pose to where the bones are (in the space of the geometry)
+		const std::vector<Math::Matrix>& GetBonePaletteRender()	const { return m_bone_palette_render; }
 		//=====================================================================================================
 
 		//= MATERIAL ============================================================
@@ -102,9 +157,17 @@ namespace Spartan
 		auto GetCastShadows() const							{ return m_castShadows; }
 		void SetReceiveShadows(const bool receive_shadows)	{ m_receiveShadows = receive_shadows; }
 		auto GetReceiveShadows() const						{ return m_receiveShadows; }
+		// Beyond this distance from the camera, opaque geometry is drawn as an impostor (a quad with the geometry as seen from about the same direction), 0 never is
+		void SetImpostorDistance(const float distance)		{ m_impostor_distance = distance; }
+		auto GetImpostorDistance() const					{ return m_impostor_distance; }
 		//=========================================================================================
 
 	private:
+		// Lets the renderer know that the material changed, it might have to draw this as opaque/transparent now
+		void MaterialChanged();
+		// Finds the entities of the bones, looking under the root of this entity
+		void BonesResolve();
+
 		std::string m_geometryName;
 		uint32_t m_geometryIndexOffset;
 		uint32_t m_geometryIndexCount;
@@ -112,11 +175,19 @@ namespace Spartan
 		uint32_t m_geometryVertexCount;
 		std::shared_ptr<Model> m_model;
 		Geometry_Type m_geometry_type;
+		std::vector<Geometry_Lod> m_geometry_lods;
+		std::vector<Geometry_Meshlet> m_geometry_meshlets;
+		std::vector<Geometry_Bone> m_geometry_bones;
+		std::vector<std::weak_ptr<Entity>> m_bone_entities; // by bone index, resolved on the first snapshot which needs them
+		std::vector<Math::Matrix> m_bone_palette_render;
+		std::vector<Math::Matrix> m_instances;
 		Math::BoundingBox m_bounding_box;
 		Math::BoundingBox m_aabb;
-        Math::Matrix m_last_transform   = Math::Matrix::Identity;
+		Math::BoundingBox m_aabb_render;
+        uint64_t m_aabb_revision        = 0; // the transform's matrix revision which m_aabb was computed with, 0 if it has to be computed again
         bool m_castShadows              = true;
         bool m_receiveShadows           = true;
+        float m_impostor_distance       = 0.0f;
 		bool m_material_default;
         std::shared_ptr<Material> m_material;
 	};
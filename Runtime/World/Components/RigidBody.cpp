@@ -57,8 +57,10 @@ namespace Spartan
 		// Update from engine, ENGINE -> BULLET
 		void getWorldTransform(btTransform& worldTrans) const override
 		{
-            const Vector3 lastPos		= m_rigidBody->GetTransform()->GetPosition();
-            const Quaternion lastRot	= m_rigidBody->GetTransform()->GetRotation();
+            // The simulation thread drives kinematic bodies to the pose which was forwarded to it, the transform belongs to the main thread
+            const bool simulation_thread    = m_rigidBody->m_physics->IsSimulationThread();
+            const Vector3 lastPos		    = simulation_thread ? m_rigidBody->m_pose_kinematic.position : m_rigidBody->GetTransform()->GetPosition();
+            const Quaternion lastRot	    = simulation_thread ? m_rigidBody->m_pose_kinematic.rotation : m_rigidBody->GetTransform()->GetRotation();
 
 			worldTrans.setOrigin(ToBtVector3(lastPos + lastRot * m_rigidBody->GetCenterOfMass()));
 			worldTrans.setRotation(ToBtQuaternion(lastRot));
@@ -70,6 +72,15 @@ namespace Spartan
             const Quaternion newWorldRot	= ToQuaternion(worldTrans.getRotation());
             const Vector3 newWorldPos		= ToVector3(worldTrans.getOrigin()) - newWorldRot * m_rigidBody->GetCenterOfMass();
 
+            // The simulation thread stages the pose, it's published after the step
+            if (m_rigidBody->m_physics->IsSimulationThread())
+            {
+                m_rigidBody->m_pose_step.position   = newWorldPos;
+                m_rigidBody->m_pose_step.rotation   = newWorldRot;
+                m_rigidBody->m_pose_step_moved      = true;
+                return;
+            }
+
 			m_rigidBody->GetTransform()->SetPosition(newWorldPos);
 			m_rigidBody->GetTransform()->SetRotation(newWorldRot);
 		}
@@ -108,6 +119,8 @@ namespace Spartan
 
 	RigidBody::~RigidBody()
 	{
+		const auto lock = m_physics->LockWorld();
+		m_physics->DeferCancel(this);
 		Body_Release();
 	}
 
@@ -119,6 +132,8 @@ namespace Spartan
 
 	void RigidBody::OnRemove()
 	{
+		const auto lock = m_physics->LockWorld();
+		m_physics->DeferCancel(this);
 		Body_Release();
 	}
 
@@ -129,6 +144,23 @@ namespace Spartan
 
 	void RigidBody::OnTick(float delta_time)
 	{
+		// While the simulation is asynchronous, dynamic bodies are interpolated by Physics and kinematic ones are driven by their transform
+		if (IsPoseShared())
+		{
+			if (m_is_kinematic)
+			{
+				Pose pose;
+				pose.position = GetTransform()->GetPosition();
+				pose.rotation = GetTransform()->GetRotation();
+				if (!Defer([this, pose]() { m_pose_kinematic = pose; }))
+				{
+					m_pose_kinematic = pose;
+				}
+			}
+
+			return;
+		}
+
 		// When the rigid body is inactive or we are in editor mode, allow the user to move/rotate it
 		if (!IsActivated() || !m_context->m_engine->EngineMode_IsSet(Engine_Game))
 		{
@@ -194,6 +226,7 @@ namespace Spartan
 		if (!m_rigidBody || m_friction == friction)
 			return;
 
+		const auto lock = m_physics->LockWorld();
 		m_friction = friction;
 		m_rigidBody->setFriction(friction);
 	}
@@ -203,6 +236,7 @@ namespace Spartan
 		if (!m_rigidBody || m_friction_rolling == frictionRolling)
 			return;
 
+		const auto lock = m_physics->LockWorld();
 		m_friction_rolling = frictionRolling;
 		m_rigidBody->setRollingFriction(frictionRolling);
 	}
@@ -212,6 +246,7 @@ namespace Spartan
 		if (!m_rigidBody || m_restitution == restitution)
 			return;
 
+		const auto lock = m_physics->LockWorld();
 		m_restitution = restitution;
 		m_rigidBody->setRestitution(restitution);
 	}
@@ -248,6 +283,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this, velocity, activate]() { SetLinearVelocity(velocity, activate); }))
+			return;
+
 		m_rigidBody->setLinearVelocity(ToBtVector3(velocity));
 		if (velocity != Vector3::Zero && activate)
 		{
@@ -260,6 +298,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this, velocity, activate]() { SetAngularVelocity(velocity, activate); }))
+			return;
+
 		m_rigidBody->setAngularVelocity(ToBtVector3(velocity));
 		if (velocity != Vector3::Zero && activate)
 		{
@@ -272,6 +313,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this, force, mode]() { ApplyForce(force, mode); }))
+			return;
+
 		Activate();
 
 		if (mode == Force)
@@ -289,6 +333,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this, force, position, mode]() { ApplyForceAtPosition(force, position, mode); }))
+			return;
+
 		Activate();
 
 		if (mode == Force)
@@ -306,6 +353,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this, torque, mode]() { ApplyTorque(torque, mode); }))
+			return;
+
 		Activate();
 
 		if (mode == Force)
@@ -335,6 +385,7 @@ namespace Spartan
 		if (!m_rigidBody || m_position_lock == lock)
 			return;
 
+		const auto lock_world = m_physics->LockWorld();
 		m_position_lock = lock;
 		m_rigidBody->setLinearFactor(ToBtVector3(Vector3::One - lock));
 	}
@@ -356,6 +407,7 @@ namespace Spartan
 		if (!m_rigidBody || m_rotation_lock == lock)
 			return;
 
+		const auto lock_world = m_physics->LockWorld();
 		m_rotation_lock = lock;
 		m_rigidBody->setAngularFactor(ToBtVector3(Vector3::One - lock));
 	}
@@ -368,6 +420,12 @@ namespace Spartan
 
 	Vector3 RigidBody::GetPosition() const
 	{
+		if (IsPoseShared())
+		{
+			const auto lock = m_physics->LockPoses();
+			return m_pose_current.position;
+		}
+
 		if (m_rigidBody)
 		{
 			const btTransform& transform = m_rigidBody->getWorldTransform();
@@ -382,6 +440,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this, position, activate]() { SetPosition(position, activate); }))
+			return;
+
         // Set position to world transform
 		btTransform& transform_world = m_rigidBody->getWorldTransform();
 		transform_world.setOrigin(ToBtVector3(position + ToQuaternion(transform_world.getRotation()) * m_center_of_mass));
@@ -399,6 +460,12 @@ namespace Spartan
 
 	Quaternion RigidBody::GetRotation() const
 	{
+		if (IsPoseShared())
+		{
+			const auto lock = m_physics->LockPoses();
+			return m_pose_current.rotation;
+		}
+
 		return m_rigidBody ? ToQuaternion(m_rigidBody->getWorldTransform().getRotation()) : Quaternion::Identity;
 	}
 
@@ -407,6 +474,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this, rotation, activate]() { SetRotation(rotation, activate); }))
+			return;
+
         // Set rotation to world transform
         const Vector3 oldPosition = GetPosition();
 		btTransform& transform_world = m_rigidBody->getWorldTransform();
@@ -438,6 +508,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this]() { ClearForces(); }))
+			return;
+
 		m_rigidBody->clearForces();
 	}
 
@@ -446,6 +519,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this]() { Activate(); }))
+			return;
+
 		if (m_mass > 0.0f)
 		{
 			m_rigidBody->activate(true);
@@ -457,6 +533,9 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		if (Defer([this]() { Deactivate(); }))
+			return;
+
 		m_rigidBody->setActivationState(WANTS_DEACTIVATION);
 	}
 
@@ -499,6 +578,9 @@ namespace Spartan
 
 	void RigidBody::Body_AddToWorld()
 	{
+		// Until it's back in the world (at the end), the body is set up directly
+		const auto lock = m_physics->LockWorld();
+
 		if (m_mass < 0.0f)
 		{
 			m_mass = 0.0f;
@@ -575,6 +657,8 @@ namespace Spartan
 		if (!m_rigidBody)
 			return;
 
+		const auto lock = m_physics->LockWorld();
+
 		// Release any constraints that refer to it
 		for (const auto& constraint : m_constraints)
 		{
@@ -595,6 +679,7 @@ namespace Spartan
 
 		if (m_in_world)
 		{
+			const auto lock = m_physics->LockWorld();
 			m_physics->RemoveBody(m_rigidBody);
 			m_in_world = false;
 		}
@@ -656,4 +741,65 @@ namespace Spartan
 	{
 		return m_rigidBody->isActive();
 	}
+
+	bool RigidBody::Defer(function<void()>&& function) const
+	{
+		// A body which isn't in the world (yet) is set up by whoever holds the world lock
+		return m_in_world && m_physics->Defer(this, move(function));
+	}
+
+	bool RigidBody::IsPoseShared() const
+	{
+		return m_in_world && m_physics->IsAsynchronous() && !m_physics->IsSimulationThread();
+	}
+
+	void RigidBody::Pose_Reset()
+	{
+		if (!m_rigidBody)
+			return;
+
+		const btTransform& transform    = m_rigidBody->getWorldTransform();
+		m_pose_current.rotation         = ToQuaternion(transform.getRotation());
+		m_pose_current.position         = ToVector3(transform.getOrigin()) - m_pose_current.rotation * m_center_of_mass;
+		m_pose_previous                 = m_pose_current;
+		m_pose_step                     = m_pose_current;
+		m_pose_kinematic                = m_pose_current;
+		m_pose_step_moved               = false;
+	}
+
+	void RigidBody::Pose_Publish()
+	{
+		// Bodies which didn't move (asleep) come to rest at the current pose
+		m_pose_previous = m_pose_current;
+		if (m_pose_step_moved)
+		{
+			m_pose_current      = m_pose_step;
+			m_pose_step_moved   = false;
+		}
+	}
+
+	void RigidBody::Pose_Interpolate(const float alpha)
+	{
+		if (m_is_kinematic || m_mass <= 0.0f)
+			return;
+
+		// Normalized lerp along the shortest arc, the steps are small enough for it to be indistinguishable from a slerp
+		const Quaternion& from  = m_pose_previous.rotation;
+		Quaternion to           = m_pose_current.rotation;
+		if (from.x * to.x + from.y * to.y + from.z * to.z + from.w * to.w < 0.0f)
+		{
+			to = Quaternion(-to.x, -to.y, -to.z, -to.w);
+		}
+
+		Quaternion rotation = Quaternion(
+			Helper::Lerp(from.x, to.x, alpha),
+			Helper::Lerp(from.y, to.y, alpha),
+			Helper::Lerp(from.z, to.z, alpha),
+			Helper::Lerp(from.w, to.w, alpha)
+		);
+		rotation.Normalize();
+
+		GetTransform()->SetPosition(Helper::Lerp(m_pose_previous.position, m_pose_current.position, alpha));
+		GetTransform()->SetRotation(rotation);
+	}
 }
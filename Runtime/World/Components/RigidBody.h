@@ -24,7 +24,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ==================
 #include "IComponent.h"
 #include <vector>
+#include <functional>
 #include "../../Math/Vector3.h"
+#include "../../Math/Quaternion.h"
 //=============================
 
 class btRigidBody;
@@ -35,7 +37,6 @@ namespace Spartan
 	class Entity;
 	class Constraint;
 	class Physics;
-	namespace Math { class Quaternion; }
 
 	enum ForceMode
 	{
@@ -138,7 +139,22 @@ namespace Spartan
 		void RemoveConstraint(Constraint* constraint);
 		void SetShape(btCollisionShape* shape);
 
+		// Asynchronous simulation (see Physics), the simulation thread publishes and the main thread interpolates, both with the poses locked
+		void Pose_Reset();
+		void Pose_Publish();
+		void Pose_Interpolate(float alpha);
+
 	private:
+		friend class MotionState;
+
+		struct Pose
+		{
+			Math::Vector3 position		= Math::Vector3::Zero;
+			Math::Quaternion rotation	= Math::Quaternion::Identity;
+		};
+
+		bool Defer(std::function<void()>&& function) const;
+		bool IsPoseShared() const;
 		void Body_AddToWorld();
 		void Body_Release();
 		void Body_RemoveFromWorld();
@@ -163,5 +179,12 @@ namespace Spartan
         bool m_in_world                     = false;
 		Physics* m_physics                  = nullptr;
         std::vector<Constraint*> m_constraints;
+
+        // Asynchronous simulation
+        Pose m_pose_previous;           // the last two published steps, which the transform is interpolated between
+        Pose m_pose_current;
+        Pose m_pose_step;               // written by the motion state during a step (the simulation thread's)
+        bool m_pose_step_moved = false;
+        Pose m_pose_kinematic;          // where a kinematic body is driven to (the simulation thread's)
 	};
 }
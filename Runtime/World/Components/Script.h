@@ -44,6 +44,7 @@ namespace Spartan
 		bool SetScript(const std::string& filePath);
 		std::string GetScriptPath() const;
 		std::string GetName();
+		auto GetScriptInstance() const { return m_scriptInstance.get(); }
 
 	private:
 		std::shared_ptr<ScriptInstance> m_scriptInstance;
@@ -26,6 +26,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Core/Context.h"
 #include "../../Physics/Physics.h"
 #include "../../Physics/BulletPhysicsHelper.h"
+#include "../../Rendering/Renderer.h"
+#include "../../RHI/RHI_Vertex.h"
+#include "../../RHI/RHI_VertexBuffer.h"
 #pragma warning(push, 0) // Hide warnings which belong to Bullet
 #include <BulletSoftBody/btSoftBody.h>
 #include <BulletSoftBody/btSoftBodyHelpers.h>
@@ -82,6 +85,10 @@ namespace Spartan
                 SetRotation(GetTransform()->GetRotation());
             }
         }
+        else
+        {
+            VertexBuffer_Update();
+        }
     }
 
     void SoftBody::Serialize(FileStream* stream)
@@ -242,6 +249,7 @@ namespace Spartan
 
         // Reset it
         m_soft_body = nullptr;
+        m_vertex_buffer.reset();
     }
 
     void SoftBody::Body_AddToWorld()
@@ -262,4 +270,43 @@ namespace Spartan
         m_physics->RemoveBody(m_soft_body);
         m_in_world  = false;
     }
+
+    void SoftBody::VertexBuffer_Update()
+    {
+        if (!m_soft_body || !m_in_world)
+            return;
+
+        const uint32_t node_count = static_cast<uint32_t>(m_soft_body->m_nodes.size());
+        if (node_count == 0)
+            return;
+
+        if (!m_vertex_buffer || m_vertex_buffer->GetVertexCount() != node_count)
+        {
+            m_vertex_buffer = make_shared<RHI_VertexBuffer>(m_context->GetSubsystem<Renderer>()->GetRhiDevice());
+            if (!m_vertex_buffer->CreateDynamic<RHI_Vertex_PosTexNorTan>(node_count))
+            {
+                LOG_ERROR("Failed to create vertex buffer");
+                m_vertex_buffer.reset();
+                return;
+            }
+        }
+
+        auto vertices = static_cast<RHI_Vertex_PosTexNorTan*>(m_vertex_buffer->Map());
+        if (!vertices)
+            return;
+
+        // The simulation thread could be stepping
+        {
+            const auto lock = m_physics->LockWorld();
+            for (uint32_t i = 0; i < node_count; i++)
+            {
+                const btSoftBody::Node& node = m_soft_body->m_nodes[i];
+                RHI_Vertex_PosTexNorTan& vertex = vertices[i];
+                vertex.pos[0] = node.m_x.x(); vertex.pos[1] = node.m_x.y(); vertex.pos[2] = node.m_x.z();
+                vertex.nor[0] = node.m_n.x(); vertex.nor[1] = node.m_n.y(); vertex.nor[2] = node.m_n.z();
+            }
+        }
+
+        m_vertex_buffer->Unmap();
+    }
 }
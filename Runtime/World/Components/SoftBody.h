@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES =====================
+#include <memory>
 #include "IComponent.h"
 #include "..\..\Math\Vector3.h"
 #include "..\..\Math\Quaternion.h"
@@ -35,6 +36,7 @@ namespace Spartan
 {
     // = FORWARD DECLARATIONS =
     class Physics;
+    class RHI_VertexBuffer;
     //=========================
 
     class SPARTAN_CLASS SoftBody : public IComponent
@@ -65,6 +67,9 @@ namespace Spartan
         void Activate() const;
         const Math::Vector3& GetCenterOfMass() const { return m_center_of_mass; }
 
+        // The nodes (positions and normals) as of the last step, written straight into a dynamic vertex buffer
+        RHI_VertexBuffer* GetVertexBuffer() const { return m_vertex_buffer.get(); }
+
     private:
         void CreateBox();
         void CreateAeroCloth() const;
@@ -72,11 +77,13 @@ namespace Spartan
         void Body_Release();
         void Body_AddToWorld();
         void Body_RemoveFromWorld();
+        void VertexBuffer_Update();
 
         Physics* m_physics              = nullptr;
         btSoftBody* m_soft_body         = nullptr;
         bool m_in_world                 = false;
         Math::Vector3 m_center_of_mass  = Math::Vector3::Zero;
         float m_mass                    = 0.0f;
+        std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
     };
 }
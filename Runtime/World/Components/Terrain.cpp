@@ -20,8 +20,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 //= INCLUDES ============================
+#include <limits>
 #include "Terrain.h"
 #include "Renderable.h"
+#include "Transform.h"
+#include "Collider.h"
 #include "..\Entity.h"
 #include "..\..\RHI\RHI_Texture2D.h"
 #include "..\..\Logging\Log.h"
@@ -33,6 +36,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\..\Resource\ResourceCache.h"
 #include "..\..\Rendering\Mesh.h"
 #include "..\..\Threading\Threading.h"
+#include "..\World.h"
 //=======================================
 
 //= NAMESPACES ===============
@@ -42,16 +46,184 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        // The grid coordinates which a level of detail keeps along one side of a chunk, every step-th one and the last one
+        vector<uint32_t> lod_coordinates(const uint32_t start, const uint32_t end, const uint32_t step)
+        {
+            vector<uint32_t> coordinates;
+            for (uint32_t i = start; i < end; i += step)
+            {
+                coordinates.emplace_back(i);
+            }
+            coordinates.emplace_back(end);
+            return coordinates;
+        }
+
+        // Splits a grid of heights into chunks, each one gets its bounding box (centered on the grid, without skirts) and the error of its levels of detail,
+        // which is how far the original heights are from the coarse surface (bilinearly interpolated). Returns the largest error.
+        template<typename Height>
+        float chunks_split(const uint32_t width, const uint32_t height_count, const uint32_t chunk_size, Height height, vector<Terrain_Chunk>& chunks)
+        {
+            float error_max = 0.0f;
+            for (uint32_t y0 = 0; y0 < height_count - 1; y0 += chunk_size)
+            {
+                for (uint32_t x0 = 0; x0 < width - 1; x0 += chunk_size)
+                {
+                    Terrain_Chunk& chunk    = chunks.emplace_back();
+                    chunk.x                 = x0;
+                    chunk.y                 = y0;
+                    chunk.x_end             = Helper::Min(x0 + chunk_size, width - 1);
+                    chunk.y_end             = Helper::Min(y0 + chunk_size, height_count - 1);
+
+                    // Bounding box
+                    float y_min = numeric_limits<float>::max();
+                    float y_max = numeric_limits<float>::lowest();
+                    for (uint32_t y = chunk.y; y <= chunk.y_end; y++)
+                    {
+                        for (uint32_t x = chunk.x; x <= chunk.x_end; x++)
+                        {
+                            y_min = Helper::Min(y_min, height(x, y));
+                            y_max = Helper::Max(y_max, height(x, y));
+                        }
+                    }
+                    const Vector3 center = Vector3(width * 0.5f, 0.0f, height_count * 0.5f);
+                    chunk.aabb = BoundingBox(Vector3(static_cast<float>(chunk.x), y_min, static_cast<float>(chunk.y)) - center, Vector3(static_cast<float>(chunk.x_end), y_max, static_cast<float>(chunk.y_end)) - center);
+
+                    for (uint32_t lod = 1; lod < terrain_chunk_lod_count; lod++)
+                    {
+                        const vector<uint32_t> xs = lod_coordinates(chunk.x, chunk.x_end, 1 << lod);
+                        const vector<uint32_t> ys = lod_coordinates(chunk.y, chunk.y_end, 1 << lod);
+
+                        float error = 0.0f;
+                        for (uint32_t j = 0; j < ys.size() - 1; j++)
+                        {
+                            for (uint32_t i = 0; i < xs.size() - 1; i++)
+                            {
+                                const float h00 = height(xs[i], ys[j]);
+                                const float h10 = height(xs[i + 1], ys[j]);
+                                const float h01 = height(xs[i], ys[j + 1]);
+                                const float h11 = height(xs[i + 1], ys[j + 1]);
+
+                                for (uint32_t y = ys[j]; y <= ys[j + 1]; y++)
+                                {
+                                    for (uint32_t x = xs[i]; x <= xs[i + 1]; x++)
+                                    {
+                                        const float u           = static_cast<float>(x - xs[i]) / static_cast<float>(xs[i + 1] - xs[i]);
+                                        const float v           = static_cast<float>(y - ys[j]) / static_cast<float>(ys[j + 1] - ys[j]);
+                                        const float h_coarse    = Helper::Lerp(Helper::Lerp(h00, h10, u), Helper::Lerp(h01, h11, u), v);
+                                        error                   = Helper::Max(error, Helper::Abs(height(x, y) - h_coarse));
+                                    }
+                                }
+                            }
+                        }
+
+                        chunk.errors[lod]   = error;
+                        error_max           = Helper::Max(error_max, error);
+                    }
+                }
+            }
+
+            return error_max;
+        }
+
+        // The triangles of a level of detail of a chunk (the grid coordinates it keeps), with skirts along its edges.
+        // The skirts have both windings since they are seen from either side.
+        template<typename SkirtIndex>
+        void grid_indices(const vector<uint32_t>& xs, const vector<uint32_t>& ys, const uint32_t width, SkirtIndex skirt_index, vector<uint32_t>& indices)
+        {
+            // Surface
+            for (uint32_t j = 0; j < ys.size() - 1; j++)
+            {
+                for (uint32_t i = 0; i < xs.size() - 1; i++)
+                {
+                    const uint32_t index_bottom_left    = ys[j] * width + xs[i];
+                    const uint32_t index_bottom_right   = ys[j] * width + xs[i + 1];
+                    const uint32_t index_top_left       = ys[j + 1] * width + xs[i];
+                    const uint32_t index_top_right      = ys[j + 1] * width + xs[i + 1];
+
+                    indices.insert(indices.end(), { index_bottom_right, index_bottom_left, index_top_left, index_bottom_right, index_top_left, index_top_right });
+                }
+            }
+
+            // Skirts
+            const auto add_skirt = [&indices, &skirt_index](uint32_t a, uint32_t b)
+            {
+                const uint32_t a_skirt = skirt_index(a);
+                const uint32_t b_skirt = skirt_index(b);
+                indices.insert(indices.end(), { a, b, b_skirt, a, b_skirt, a_skirt, a, b_skirt, b, a, a_skirt, b_skirt });
+            };
+            for (uint32_t i = 0; i < xs.size() - 1; i++)
+            {
+                add_skirt(ys.front() * width + xs[i], ys.front() * width + xs[i + 1]);
+                add_skirt(ys.back() * width + xs[i], ys.back() * width + xs[i + 1]);
+            }
+            for (uint32_t j = 0; j < ys.size() - 1; j++)
+            {
+                add_skirt(ys[j] * width + xs.front(), ys[j + 1] * width + xs.front());
+                add_skirt(ys[j] * width + xs.back(), ys[j + 1] * width + xs.back());
+            }
+        }
+    }
+
     Terrain::Terrain(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
     {
         
     }
 
+    Terrain::~Terrain()
+    {
+        // The stages of a generation which is still going capture this
+        m_generate.Cancel();
+    }
+
     void Terrain::OnInitialize()
     {
         
     }
 
+    void Terrain::OnTick(float delta_time)
+    {
+        // Take the heights of a new generation, a heightfield collider is rebuilt with them
+        bool height_samples_changed = false;
+        {
+            lock_guard<mutex> lock(m_height_samples_mutex);
+            if (m_height_samples_generated)
+            {
+                m_height_samples        = move(m_height_samples_generated);
+                height_samples_changed  = true;
+            }
+        }
+        if (height_samples_changed)
+        {
+            Collider* collider = m_entity->GetComponent<Collider>();
+            if (collider && collider->GetShapeType() == ColliderShape_Terrain)
+            {
+                collider->Shape_Update();
+            }
+        }
+
+        if (!m_model || !m_generate.IsDone())
+            return;
+
+        // Deserialized terrains read their heights again, in the background
+        if (!m_height_samples && !m_height_samples_requested && m_height_map)
+        {
+            m_height_samples_requested = true;
+            m_context->GetSubsystem<Threading>()->AddTask([this]() { GenerateHeightSamples(m_height_map->GetMipmap(0)); }, {}, Threading_Pool_Background);
+        }
+
+        // The patch follows the transform, the height map and the height range right away
+        if (m_patch && m_height_map)
+        {
+            UpdateDisplacement();
+        }
+        else if (m_model->IsVertexDisplaced())
+        {
+            m_model->SetVertexDisplacement(nullptr, Vector4::Zero, Vector2::Zero);
+        }
+    }
+
     void Terrain::Serialize(FileStream* stream)
     {
         const string no_path;
@@ -60,6 +232,8 @@ namespace Spartan
         stream->Write(m_model ? m_model->GetResourceName() : no_path);
         stream->Write(m_min_y);
         stream->Write(m_max_y);
+        stream->Write(m_displaced);
+        stream->Write(m_patch);
     }
 
     void Terrain::Deserialize(FileStream* stream)
@@ -69,8 +243,10 @@ namespace Spartan
         m_model         = resource_cache->GetByName<Model>(stream->ReadAs<string>());
         stream->Read(&m_min_y);
         stream->Read(&m_max_y);
+        stream->Read(&m_displaced);
+        stream->Read(&m_patch);
 
-        UpdateFromModel(m_model);
+        // The chunks are child entities, they (and their renderables) deserialize themselves
     }
 
     void Terrain::SetHeightMap(const shared_ptr<RHI_Texture2D>& height_map)
@@ -81,7 +257,7 @@ namespace Spartan
 
     void Terrain::GenerateAsync()
     {
-        if (m_is_generating)
+        if (!m_generate.IsDone())
         {
             LOG_WARNING("Terrain is already being generated, please wait...");
             return;
@@ -93,18 +269,23 @@ namespace Spartan
 
             m_context->GetSubsystem<ResourceCache>()->Remove(m_model);
             m_model.reset();
-            if (Renderable* renderable = m_entity->AddComponent<Renderable>())
-            {
-                renderable->GeometryClear();
-            }
+            ChunksRemove();
             
             return;
         }
 
-        m_context->GetSubsystem<Threading>()->AddTask([this]()
+        // The geometry is generated in the background, the model and the chunk entities are created on the main thread
+        struct Geometry
         {
-            m_is_generating = true;
+            vector<RHI_Vertex_PosTexNorTan> vertices;
+            vector<uint32_t> indices;
+            vector<Terrain_Chunk> chunks;
+        };
+        shared_ptr<Geometry> geometry = make_shared<Geometry>();
 
+        m_generate = TaskChain(m_context->GetSubsystem<Threading>());
+        m_generate.Then(Threading_Pool_Background, [this, geometry]()
+        {
             // Get height map data
             const vector<std::byte> height_map_data = m_height_map->GetMipmap(0);
             if (height_map_data.empty())
@@ -112,49 +293,81 @@ namespace Spartan
                 LOG_ERROR("Height map has no data");
             }
 
+            // The heights which colliders read
+            GenerateHeightSamples(height_map_data);
+
             // Deduce some stuff
             m_height                            = m_height_map->GetHeight();
             m_width                             = m_height_map->GetWidth();
             m_vertex_count                      = m_height * m_width;
             m_face_count                        = (m_height - 1) * (m_width - 1) * 2;
             m_progress_jobs_done                = 0;
-            m_progress_job_count                = m_vertex_count * 2 + m_face_count + m_vertex_count * m_face_count;
+            const uint32_t chunk_count          = ((m_width - 2) / m_chunk_size + 1) * ((m_height - 2) / m_chunk_size + 1);
+            m_progress_jobs_done                = 0;
+            m_progress_job_count                = m_displaced ? chunk_count : m_vertex_count * 3 + chunk_count; // positions, vertices, normals and chunks
 
-            // Pre-allocate memory for the calculations that follow
-            vector<Vector3> positions                 = vector<Vector3>(m_height * m_width);
-            vector<RHI_Vertex_PosTexNorTan> vertices  = vector<RHI_Vertex_PosTexNorTan>(m_vertex_count);
-            vector<uint32_t> indices                  = vector<uint32_t>(m_face_count * 3);
+            vector<RHI_Vertex_PosTexNorTan>& vertices   = geometry->vertices;
+            vector<uint32_t>& indices                   = geometry->indices;
+            vector<Terrain_Chunk>& chunks               = geometry->chunks;
+            bool generated                              = false;
 
-            // Read height map and construct positions
-            m_progress_desc = "Generating positions...";
-            if (GeneratePositions(positions, height_map_data))
+            // Displaced terrains only need the patch which their chunks share
+            if (m_displaced)
             {
-                // Compute the vertices (without the normals) and the indices
-                m_progress_desc = "Generating terrain vertices and indices...";
-                if (GenerateVerticesIndices(positions, indices, vertices))
-                {
-                    m_progress_desc = "Generating normals and tangents...";
-                    positions.clear();
-                    positions.shrink_to_fit();
+                m_progress_desc = "Generating chunks...";
+                generated       = GeneratePatch(height_map_data, vertices, indices, chunks);
+            }
+            else
+            {
+                // Pre-allocate memory for the calculations that follow
+                vector<Vector3> positions   = vector<Vector3>(m_height * m_width);
+                vertices                    = vector<RHI_Vertex_PosTexNorTan>(m_vertex_count);
 
-                    // Compute the normals by doing normal averaging (very expensive)
-                    if (GenerateNormalTangents(indices, vertices))
+                // Read height map and construct positions
+                m_progress_desc = "Generating positions...";
+                if (GeneratePositions(positions, height_map_data))
+                {
+                    // Compute the vertices (without the normals)
+                    m_progress_desc = "Generating terrain vertices...";
+                    if (GenerateVertices(positions, vertices))
                     {
-                        // Create a model and set it to the renderable component
-                        UpdateFromVertices(indices, vertices);
+                        m_progress_desc = "Generating normals and tangents...";
+                        positions.clear();
+                        positions.shrink_to_fit();
+
+                        // Compute the normals and the tangents from the height map grid
+                        if (GenerateNormalTangents(vertices))
+                        {
+                            // Split the grid into chunks, with their levels of detail and skirts
+                            m_progress_desc = "Generating chunks...";
+                            generated       = GenerateChunks(vertices, indices, chunks);
+                        }
                     }
                 }
             }
 
-            // Clear progress stats
-            m_progress_jobs_done = 0;
-            m_progress_job_count = 1;
-            m_progress_desc.clear();
+            if (!generated)
+            {
+                GenerateProgressClear();
+            }
 
-            m_is_generating = false;
+            return generated;
+        })
+        .Then(Threading_Pool_Main, [this, geometry]()
+        {
+            // Create a model and a renderable per chunk
+            UpdateFromVertices(geometry->indices, geometry->vertices, geometry->chunks);
+            GenerateProgressClear();
         });
     }
 
+    void Terrain::GenerateProgressClear()
+    {
+        m_progress_jobs_done = 0;
+        m_progress_job_count = 1;
+        m_progress_desc.clear();
+    }
+
     bool Terrain::GeneratePositions(vector<Vector3>& positions, const vector<std::byte>& height_map)
     {
         if (height_map.empty())
@@ -189,7 +402,7 @@ namespace Spartan
         return true;
     }
 
-    bool Terrain::GenerateVerticesIndices(const vector<Vector3>& positions, vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    bool Terrain::GenerateVertices(const vector<Vector3>& positions, vector<RHI_Vertex_PosTexNorTan>& vertices)
     {
         if (positions.empty())
         {
@@ -197,222 +410,312 @@ namespace Spartan
             return false;
         }
 
-        uint32_t index      = 0;
-        uint32_t k          = 0;
-        uint32_t u_index    = 0;
-        uint32_t v_index    = 0;
-
-        for (uint32_t y = 0; y < m_height - 1; y++)
+        for (uint32_t y = 0; y < m_height; y++)
         {
-            for (uint32_t x = 0; x < m_width - 1; x++)
+            for (uint32_t x = 0; x < m_width; x++)
             {
-                const uint32_t index_bottom_left  = y * m_width + x;
-                const uint32_t index_bottom_right = y * m_width + x + 1;
-                const uint32_t index_top_left     = (y + 1) * m_width + x;
-                const uint32_t index_top_right    = (y + 1) * m_width + x + 1;
-
-                // Bottom right of quad
-                index           = index_bottom_right;
-                indices[k]      = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 1.0f));
-
-                // Bottom left of quad
-                index           = index_bottom_left;
-                indices[k + 1]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 1.0f));
-
-                // Top left of quad
-                index           = index_top_left;
-                indices[k + 2]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 0.0f));
-
-                // Bottom right of quad
-                index           = index_bottom_right;
-                indices[k + 3]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 1.0f));
-
-                // Top left of quad
-                index           = index_top_left;
-                indices[k + 4]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 0.0f, v_index + 0.0f));
-
-                // Top right of quad
-                index           = index_top_right;
-                indices[k + 5]  = index;
-                vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u_index + 1.0f, v_index + 0.0f));
-
-                k += 6; // next quad
-
-                u_index++;
+                // A texture repetition per quad
+                const uint32_t index    = y * m_width + x;
+                vertices[index]         = RHI_Vertex_PosTexNorTan(positions[index], Vector2(static_cast<float>(x), static_cast<float>(y)));
 
                 // track progress
                 m_progress_jobs_done++;
             }
-            u_index = 0;
-            v_index++;
         }
 
         return true;
     }
 
-    bool Terrain::GenerateNormalTangents(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    bool Terrain::GenerateNormalTangents(vector<RHI_Vertex_PosTexNorTan>& vertices)
     {
-        if (indices.empty())
-        {
-            LOG_ERROR("Indices are empty");
-            return false;
-        }
-
         if (vertices.empty())
         {
             LOG_ERROR("Vertices are empty");
             return false;
         }
 
-        // Normals are computed by normal averaging, which can be crazy slow
-        uint32_t face_count     = static_cast<uint32_t>(indices.size()) / 3;
-        uint32_t vertex_count   = static_cast<uint32_t>(vertices.size());
-
-        // Compute face normals and tangents
-        vector<Vector3> face_normals(face_count);
-        vector<Vector3> face_tangents(face_count);
+        // The vertices are a grid, so the normal and the tangent of a vertex follow from the heights of its neighbours (central differences,
+        // one sided at the edges), instead of averaging the faces which use it. The tangent follows u, which increases with x.
+        const auto compute_normals_tangents = [this, &vertices](uint32_t y_start, uint32_t y_end)
         {
-            for (uint32_t i = 0; i < face_count; ++i)
-            {
-                Vector3 edge_a;
-                Vector3 edge_b;
+            const auto height = [this, &vertices](uint32_t x, uint32_t y) { return vertices[y * m_width + x].pos[1]; };
 
-                // Normal
-                {
-                    // Get the vector describing one edge of our triangle (edge 0, 1)
-                    edge_a = Vector3(
-                        vertices[indices[(i * 3)]].pos[0] - vertices[indices[(i * 3) + 1]].pos[0],
-                        vertices[indices[(i * 3)]].pos[1] - vertices[indices[(i * 3) + 1]].pos[1],
-                        vertices[indices[(i * 3)]].pos[2] - vertices[indices[(i * 3) + 1]].pos[2]
-                    );
-
-                    // Get the vector describing another edge of our triangle (edge 2,1)
-                    edge_b = Vector3(
-                        vertices[indices[(i * 3) + 1]].pos[0] - vertices[indices[(i * 3) + 2]].pos[0],
-                        vertices[indices[(i * 3) + 1]].pos[1] - vertices[indices[(i * 3) + 2]].pos[1],
-                        vertices[indices[(i * 3) + 1]].pos[2] - vertices[indices[(i * 3) + 2]].pos[2]
-                    );
-
-                    // Cross multiply the two edge vectors to get the unnormalized face normal
-                    face_normals[i] = Vector3::Cross(edge_a, edge_b);
-                }
+            for (uint32_t y = y_start; y < y_end; y++)
+            {
+                const uint32_t y_down   = y > 0 ? y - 1 : y;
+                const uint32_t y_up     = y < m_height - 1 ? y + 1 : y;
 
-                // Tangent
+                for (uint32_t x = 0; x < m_width; x++)
                 {
-                    // find first texture coordinate edge 2d vector
-                    const float tcU1 = vertices[indices[(i * 3)]].tex[0] - vertices[indices[(i * 3) + 1]].tex[0];
-                    const float tcV1 = vertices[indices[(i * 3)]].tex[1] - vertices[indices[(i * 3) + 1]].tex[1];
-
-                    // find second texture coordinate edge 2d vector
-                    const float tcU2 = vertices[indices[(i * 3) + 1]].tex[0] - vertices[indices[(i * 3) + 2]].tex[0];
-                    const float tcV2 = vertices[indices[(i * 3) + 1]].tex[1] - vertices[indices[(i * 3) + 2]].tex[1];
-
-                    // find tangent using both tex coord edges and position edges
-                    face_tangents[i].x = (tcV1 * edge_a.x - tcV2 * edge_b.x * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
-                    face_tangents[i].y = (tcV1 * edge_a.y - tcV2 * edge_b.y * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
-                    face_tangents[i].z = (tcV1 * edge_a.z - tcV2 * edge_b.z * (1.0f / (tcU1 * tcV2 - tcU2 * tcV1)));
+                    const uint32_t x_left   = x > 0 ? x - 1 : x;
+                    const uint32_t x_right  = x < m_width - 1 ? x + 1 : x;
+
+                    // Slopes along x and z (the grid spacing is one unit)
+                    const float slope_x = (height(x_right, y) - height(x_left, y)) / Helper::Max(static_cast<float>(x_right - x_left), 1.0f);
+                    const float slope_z = (height(x, y_up) - height(x, y_down)) / Helper::Max(static_cast<float>(y_up - y_down), 1.0f);
+
+                    const Vector3 normal    = Vector3(-slope_x, 1.0f, -slope_z).Normalized();
+                    const Vector3 tangent   = Vector3(1.0f, slope_x, 0.0f).Normalized();
+
+                    RHI_Vertex_PosTexNorTan& vertex = vertices[y * m_width + x];
+                    vertex.nor[0] = normal.x;
+                    vertex.nor[1] = normal.y;
+                    vertex.nor[2] = normal.z;
+                    vertex.tan[0] = tangent.x;
+                    vertex.tan[1] = tangent.y;
+                    vertex.tan[2] = tangent.z;
                 }
 
                 // track progress
-                m_progress_jobs_done++;
+                m_progress_jobs_done += m_width;
             }
+        };
+
+        m_context->GetSubsystem<Threading>()->ParallelFor(compute_normals_tangents, m_height);
+
+        return true;
+    }
+
+    bool Terrain::GenerateChunks(vector<RHI_Vertex_PosTexNorTan>& vertices, vector<uint32_t>& indices, vector<Terrain_Chunk>& chunks)
+    {
+        if (vertices.empty() || m_width < 2 || m_height < 2)
+        {
+            LOG_ERROR("Vertices are empty");
+            return false;
         }
 
-        
-        // Compute vertex normals and tangents (normals averaging) - This is very expensive show we split it into multiple threads below
-        const auto compute_vertex_normals_tangents = [this, &face_normals , &face_tangents, &vertices, &indices, &vertex_count, &face_count](uint32_t i_start, uint32_t i_end)
+        const auto height       = [&vertices, this](uint32_t x, uint32_t y) { return vertices[y * m_width + x].pos[1]; };
+        const float error_max   = chunks_split(m_width, m_height, m_chunk_size, height, chunks);
+
+        // Skirts hang from the edges of every chunk, deep enough to hide the cracks between neighbours of different levels of detail.
+        // A skirt vertex is a copy of an edge vertex, shared by the chunks on both sides of the edge.
+        const float skirt_depth = Helper::Max(error_max, 1.0f);
+        vector<uint32_t> skirt_indices(vertices.size(), numeric_limits<uint32_t>::max());
+        const auto skirt_index = [&vertices, &skirt_indices, skirt_depth](uint32_t index)
+        {
+            if (skirt_indices[index] == numeric_limits<uint32_t>::max())
+            {
+                RHI_Vertex_PosTexNorTan vertex  = vertices[index];
+                vertex.pos[1]                   -= skirt_depth;
+                skirt_indices[index]            = static_cast<uint32_t>(vertices.size());
+                vertices.emplace_back(vertex);
+            }
+            return skirt_indices[index];
+        };
+
+        for (Terrain_Chunk& chunk : chunks)
         {
-            Vector3 normal_sum  = Vector3::Zero;
-            Vector3 tangent_sum = Vector3::Zero;
-            float faces_using   = 0;
+            for (uint32_t lod = 0; lod < m_chunk_lod_count; lod++)
+            {
+                chunk.index_offsets[lod] = static_cast<uint32_t>(indices.size());
+                grid_indices(lod_coordinates(chunk.x, chunk.x_end, 1 << lod), lod_coordinates(chunk.y, chunk.y_end, 1 << lod), m_width, skirt_index, indices);
+                chunk.index_counts[lod] = static_cast<uint32_t>(indices.size()) - chunk.index_offsets[lod];
+            }
 
-            for (uint32_t i = i_start; i < i_end; ++i)
+            // The skirts are part of the chunk
+            chunk.aabb = BoundingBox(chunk.aabb.GetMin() - Vector3(0.0f, skirt_depth, 0.0f), chunk.aabb.GetMax());
+
+            // The errors are relative to the bounding box diagonal, like the levels of detail of imported models
+            const float diagonal = Helper::Max(chunk.aabb.GetSize().Length(), Helper::M_EPSILON);
+            for (float& error : chunk.errors)
             {
-                // Check which triangles use this vertex
-                for (uint32_t j = 0; j < face_count; ++j)
-                {
-                    if (indices[j * 3] == i || indices[(j * 3) + 1] == i || indices[(j * 3) + 2] == i)
-                    {
-                        // If a face is using the vertex, accumulate the face normal/tangent
-                        normal_sum  += face_normals[j];
-                        tangent_sum += face_tangents[j];
-                        faces_using++;
-                    }
+                error /= diagonal;
+            }
 
-                    // Track progress but only every time the inner loop (face_count) finished.
-                    // This is because different threads increment the progress tracker which is also an atomic so it locks and unlocks.
-                    if (j == face_count < 1)
-                    {
-                        m_progress_jobs_done += face_count;
-                    }
-                }
+            // track progress
+            m_progress_jobs_done++;
+        }
 
-                // Compute actual normal
-                normal_sum /= faces_using;
-                normal_sum.Normalize();
+        return true;
+    }
 
-                // Compute actual tangent
-                tangent_sum /= faces_using;
-                tangent_sum.Normalize();
+    bool Terrain::GeneratePatch(const vector<std::byte>& height_map, vector<RHI_Vertex_PosTexNorTan>& vertices, vector<uint32_t>& indices, vector<Terrain_Chunk>& chunks)
+    {
+        if (height_map.empty() || m_width < 2 || m_height < 2)
+        {
+            LOG_ERROR("Height map is empty");
+            return false;
+        }
 
-                // Write normal to vertex
-                vertices[i].nor[0] = normal_sum.x;
-                vertices[i].nor[1] = normal_sum.y;
-                vertices[i].nor[2] = normal_sum.z;
+        // The heights are only read for the bounds and the errors of the chunks, the vertex shaders lift the patch by the same heights
+        const auto height       = [&height_map, this](uint32_t x, uint32_t y) { return Helper::Lerp(m_min_y, m_max_y, static_cast<float>(height_map[(y * m_width + x) * 4]) / 255.0f); };
+        const float error_max   = chunks_split(m_width, m_height, m_chunk_size, height, chunks);
+        const float skirt_depth = Helper::Max(error_max, 1.0f);
 
-                // Write tangent to vertex
-                vertices[i].tan[0] = tangent_sum.x;
-                vertices[i].tan[1] = tangent_sum.y;
-                vertices[i].tan[2] = tangent_sum.z;
+        // A flat grid the size of a chunk, a unit per texel of the height map (the vertex shaders compute the normals and the tangents).
+        // Chunks at the far edges of a height map whose size (minus one) isn't a multiple of the chunk size overhang it, at the height of its edge.
+        const uint32_t size = m_chunk_size + 1;
+        vertices.reserve(size * size + size * 4);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                vertices.emplace_back(Vector3(static_cast<float>(x), 0.0f, static_cast<float>(y)), Vector2(static_cast<float>(x), static_cast<float>(y)), Vector3::Up, Vector3::Right);
+            }
+        }
 
-                // Reset
-                normal_sum  = Vector3::Zero;
-                tangent_sum = Vector3::Zero;
-                faces_using = 0;
+        // Skirts hang below the surface which the vertex shaders lift the patch to
+        vector<uint32_t> skirt_indices(vertices.size(), numeric_limits<uint32_t>::max());
+        const auto skirt_index = [&vertices, &skirt_indices, skirt_depth](uint32_t index)
+        {
+            if (skirt_indices[index] == numeric_limits<uint32_t>::max())
+            {
+                RHI_Vertex_PosTexNorTan vertex  = vertices[index];
+                vertex.pos[1]                   = -skirt_depth;
+                skirt_indices[index]            = static_cast<uint32_t>(vertices.size());
+                vertices.emplace_back(vertex);
             }
+            return skirt_indices[index];
         };
 
-        m_context->GetSubsystem<Threading>()->AddTaskLoop(compute_vertex_normals_tangents, vertex_count);
+        // Every chunk draws the same levels of detail of the patch
+        Terrain_Chunk patch;
+        for (uint32_t lod = 0; lod < m_chunk_lod_count; lod++)
+        {
+            patch.index_offsets[lod] = static_cast<uint32_t>(indices.size());
+            grid_indices(lod_coordinates(0, m_chunk_size, 1 << lod), lod_coordinates(0, m_chunk_size, 1 << lod), size, skirt_index, indices);
+            patch.index_counts[lod] = static_cast<uint32_t>(indices.size()) - patch.index_offsets[lod];
+        }
+
+        for (Terrain_Chunk& chunk : chunks)
+        {
+            chunk.index_offsets = patch.index_offsets;
+            chunk.index_counts  = patch.index_counts;
+
+            // The chunk entities are where the chunks start, so the bounding box is the whole patch with the heights of the chunk and the skirts
+            const float chunk_size  = static_cast<float>(m_chunk_size);
+            chunk.aabb              = BoundingBox(Vector3(0.0f, chunk.aabb.GetMin().y - skirt_depth, 0.0f), Vector3(chunk_size, chunk.aabb.GetMax().y, chunk_size));
+
+            // The errors are relative to the bounding box diagonal, like the levels of detail of imported models
+            const float diagonal = Helper::Max(chunk.aabb.GetSize().Length(), Helper::M_EPSILON);
+            for (float& error : chunk.errors)
+            {
+                error /= diagonal;
+            }
+
+            // track progress
+            m_progress_jobs_done++;
+        }
 
         return true;
     }
 
-    void Terrain::UpdateFromModel(const shared_ptr<Model>& model) const
+    void Terrain::GenerateHeightSamples(const vector<std::byte>& height_map)
     {
-        if (!model)
-        {
-            LOG_ERROR_INVALID_PARAMETER();
+        const uint32_t width    = m_height_map->GetWidth();
+        const uint32_t height   = m_height_map->GetHeight();
+        if (height_map.size() < width * height * 4 || width < 2 || height < 2)
             return;
+
+        // The first channel, like the positions
+        shared_ptr<Terrain_HeightSamples> samples = make_shared<Terrain_HeightSamples>();
+        samples->heights.resize(width * height);
+        samples->width      = width;
+        samples->height     = height;
+        samples->min_y      = m_min_y;
+        samples->max_y      = m_max_y;
+        samples->revision   = ++m_height_samples_revision;
+        for (uint32_t i = 0; i < width * height; i++)
+        {
+            samples->heights[i] = static_cast<uint8_t>(height_map[i * 4]);
+        }
+
+        lock_guard<mutex> lock(m_height_samples_mutex);
+        m_height_samples_generated = move(samples);
+    }
+
+    void Terrain::UpdateDisplacement()
+    {
+        // The uv of a patch origin (in world space), the height map is centered on the terrain and a texel is a unit, times the scale of the terrain
+        const Transform* transform  = m_entity->GetTransform();
+        const Vector3 position      = transform->GetPosition();
+        const Vector3 scale         = transform->GetScale();
+        const Vector2 size          = Vector2(static_cast<float>(m_height_map->GetWidth()), static_cast<float>(m_height_map->GetHeight()));
+        const Vector2 uv_scale      = Vector2(1.0f / Helper::Max(scale.x * size.x, Helper::M_EPSILON), 1.0f / Helper::Max(scale.z * size.y, Helper::M_EPSILON));
+        const Vector4 uv_scale_offset
+        (
+            uv_scale.x,
+            uv_scale.y,
+            -position.x * uv_scale.x + (size.x * 0.5f + 0.5f) / size.x, // texel centers
+            -position.z * uv_scale.y + (size.y * 0.5f + 0.5f) / size.y
+        );
+
+        m_model->SetVertexDisplacement(m_height_map, uv_scale_offset, Vector2(m_min_y, m_max_y));
+    }
+
+    void Terrain::ChunksRemove()
+    {
+        World* world = m_context->GetSubsystem<World>();
+
+        // Chunks from a previous generation
+        for (Transform* child : m_entity->GetTransform()->GetChildren())
+        {
+            if (child->GetEntity()->GetName().rfind(m_chunk_name, 0) == 0)
+            {
+                world->EntityRemove(world->EntityGetById(child->GetEntity()->GetId()));
+            }
         }
 
-        if (Renderable* renderable = m_entity->AddComponent<Renderable>())
+        // The whole terrain, from before it was split into chunks
+        if (m_entity->HasComponent<Renderable>())
+        {
+            m_entity->RemoveComponent<Renderable>();
+        }
+    }
+
+    void Terrain::ChunksCreate(const vector<Terrain_Chunk>& chunks)
+    {
+        ChunksRemove();
+
+        // A child entity per chunk, so that each one is culled and picks its level of detail on its own
+        World* world = m_context->GetSubsystem<World>();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(chunks.size()); i++)
         {
-            renderable->GeometrySet(
-                "Terrain",
-                0,                                  // index offset
-                model->GetMesh()->Indices_Count(),  // index count
-                0,                                  // vertex offset
-                model->GetMesh()->Vertices_Count(), // vertex count
-                model->GetAabb(),
-                model.get()
-            );
+            const Terrain_Chunk& chunk = chunks[i];
+
+            shared_ptr<Entity> entity = world->EntityCreate();
+            entity->SetName(string(m_chunk_name) + to_string(i));
+            entity->SetHierarchyVisibility(false);
+            entity->GetTransform()->SetParent(m_entity->GetTransform());
+
+            // Chunks which share the patch are moved to where they start
+            if (m_patch)
+            {
+                entity->GetTransform()->SetPositionLocal(Vector3(chunk.x - m_width * 0.5f, 0.0f, chunk.y - m_height * 0.5f));
+            }
 
-            renderable->UseDefaultMaterial();
+            if (Renderable* renderable = entity->AddComponent<Renderable>())
+            {
+                renderable->GeometrySet(
+                    "Terrain",
+                    chunk.index_offsets[0],                 // index offset
+                    chunk.index_counts[0],                  // index count
+                    0,                                      // vertex offset
+                    m_model->GetMesh()->Vertices_Count(),   // vertex count
+                    chunk.aabb,
+                    m_model.get()
+                );
+
+                for (uint32_t lod = 1; lod < m_chunk_lod_count; lod++)
+                {
+                    renderable->GeometryLodAdd(chunk.index_offsets[lod], chunk.index_counts[lod], chunk.errors[lod]);
+                }
+
+                renderable->UseDefaultMaterial();
+            }
         }
     }
 
-    void Terrain::UpdateFromVertices(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+    void Terrain::UpdateFromVertices(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<Terrain_Chunk>& chunks)
     {
+        m_patch = m_displaced;
+
         // Add vertices and indices into a model struct (and cache that)
         if (!m_model)
         {
             // Create new model
             m_model = make_shared<Model>(m_context);
+            m_model->SetResidency(Model_Residency_Full); // it's regenerated in place, and its chunks read the cpu geometry
 
             // Set geometry
             m_model->AppendGeometry(indices, vertices);
@@ -431,6 +734,6 @@ namespace Spartan
             m_model->UpdateGeometry();
         }
 
-        UpdateFromModel(m_model);
+        ChunksCreate(chunks);
     }
 }
@@ -24,7 +24,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ========================
 #include "IComponent.h"
 #include <atomic>
+#include <array>
+#include <mutex>
 #include "../../RHI/RHI_Definition.h"
+#include "../../Math/BoundingBox.h"
+#include "../../Threading/Threading.h"
 //===================================
 
 namespace Spartan
@@ -35,14 +39,40 @@ namespace Spartan
         class Vector3;
     }
 
+    // The terrain is split into square chunks of the height map grid, each one a child entity with its own levels of detail
+    static const uint32_t terrain_chunk_lod_count = 4;
+    struct Terrain_Chunk
+    {
+        uint32_t x      = 0; // first grid vertex
+        uint32_t y      = 0;
+        uint32_t x_end  = 0; // last grid vertex
+        uint32_t y_end  = 0;
+        Math::BoundingBox aabb;
+        std::array<uint32_t, terrain_chunk_lod_count> index_offsets = {};
+        std::array<uint32_t, terrain_chunk_lod_count> index_counts  = {};
+        std::array<float, terrain_chunk_lod_count> errors           = {}; // relative to the bounding box diagonal, see Geometry_Lod
+    };
+
+    // The heights of a generated terrain, a byte per height map texel (0 is min_y and 255 is max_y), which heightfield colliders read as they are
+    struct Terrain_HeightSamples
+    {
+        std::vector<uint8_t> heights;
+        uint32_t width      = 0;
+        uint32_t height     = 0;
+        float min_y         = 0.0f;
+        float max_y         = 0.0f;
+        uint32_t revision   = 0; // increases with every generation
+    };
+
     class SPARTAN_CLASS Terrain : public IComponent
     {
     public:
         Terrain(Context* context, Entity* entity, uint32_t id = 0);
-        ~Terrain() = default;
+        ~Terrain();
 
         //= IComponent ===============================
         void OnInitialize() override;
+        void OnTick(float delta_time) override;
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
         //============================================
@@ -59,21 +89,44 @@ namespace Spartan
         float GetProgress() const { return static_cast<float>(static_cast<double>(m_progress_jobs_done) / static_cast<double>(m_progress_job_count)); }
         const auto& GetProgressDescription() const { return m_progress_desc; }
 
+        // Displaced terrains share a single flat chunk (a patch) which the vertex shaders lift by sampling the height map, so there is no mesh of the
+        // whole terrain and changes to the height map and the height range show up right away (the bounds of the chunks update with GenerateAsync()).
+        // They can be moved and scaled, but not rotated. Switching takes effect with the next GenerateAsync().
+        bool GetDisplaced() const               { return m_displaced; }
+        void SetDisplaced(const bool displaced) { m_displaced = displaced; }
+
+        // Generates in the background and creates the model and the chunks on the main thread, a terrain generates once at a time
         void GenerateAsync();
+        bool IsGenerating() const { return !m_generate.IsDone(); }
+
+        // The heights of the last generation (null until there is one), a collider of ColliderShape_Terrain is built from them and rebuilt when they change
+        const auto& GetHeightSamples() const { return m_height_samples; }
 
     private:
         bool GeneratePositions(std::vector<Math::Vector3>& positions, const std::vector<std::byte>& height_map);
-        bool GenerateVerticesIndices(const std::vector<Math::Vector3>& positions, std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
-        bool GenerateNormalTangents(const std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
-        void UpdateFromModel(const std::shared_ptr<Model>& model) const;
-        void UpdateFromVertices(const std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
+        bool GenerateVertices(const std::vector<Math::Vector3>& positions, std::vector<RHI_Vertex_PosTexNorTan>& vertices);
+        bool GenerateNormalTangents(std::vector<RHI_Vertex_PosTexNorTan>& vertices);
+        bool GenerateChunks(std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<uint32_t>& indices, std::vector<Terrain_Chunk>& chunks);
+        bool GeneratePatch(const std::vector<std::byte>& height_map, std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<uint32_t>& indices, std::vector<Terrain_Chunk>& chunks);
+        void UpdateDisplacement();
+        void GenerateHeightSamples(const std::vector<std::byte>& height_map);
+        void ChunksRemove();
+        void ChunksCreate(const std::vector<Terrain_Chunk>& chunks);
+        void UpdateFromVertices(const std::vector<uint32_t>& indices, std::vector<RHI_Vertex_PosTexNorTan>& vertices, const std::vector<Terrain_Chunk>& chunks);
+        void GenerateProgressClear();
+
+        static const uint32_t m_chunk_size          = 64; // quads along a side
+        static const uint32_t m_chunk_lod_count     = terrain_chunk_lod_count;
+        static constexpr const char* m_chunk_name   = "terrain_chunk_"; // the names of the chunk entities start with it
 
         uint32_t m_width                            = 0;
         uint32_t m_height                           = 0;
         float m_min_y                               = 0.0f;
         float m_max_y                               = 30.0f;
         float m_vertex_density                      = 1.0f;
-        bool m_is_generating                        = false;
+        TaskChain m_generate;
+        bool m_displaced                            = false;
+        bool m_patch                                = false; // the model is the patch of a displaced terrain (it was generated so)
         uint64_t m_vertex_count                     = 0;
         uint64_t m_face_count                       = 0;
         std::atomic<uint64_t> m_progress_jobs_done  = 0;
@@ -81,5 +134,10 @@ namespace Spartan
         std::string m_progress_desc;
         std::shared_ptr<RHI_Texture2D> m_height_map;
         std::shared_ptr<Model> m_model;
+        std::shared_ptr<const Terrain_HeightSamples> m_height_samples;
+        std::shared_ptr<const Terrain_HeightSamples> m_height_samples_generated; // handed over by the generation, on the next tick
+        std::mutex m_height_samples_mutex;
+        uint32_t m_height_samples_revision          = 0;
+        bool m_height_samples_requested             = false;
     };
 }
@@ -76,9 +76,11 @@ namespace Spartan
 		uint32_t parententity_id = 0;
 		stream->Read(&parententity_id);
 
-		if (parententity_id != 0)
+		// A world which loads in parallel links the hierarchy by itself, once everything is deserialized
+		World* world = GetContext()->GetSubsystem<World>();
+		if (parententity_id != 0 && !world->IsHierarchyLinkDeferred())
 		{
-			if (const auto parent = GetContext()->GetSubsystem<World>()->EntityGetById(parententity_id))
+			if (const auto parent = world->EntityGetById(parententity_id))
 			{
 				parent->GetTransform()->AddChild(this);
 			}
@@ -88,11 +90,52 @@ namespace Spartan
 	}
 	//===============================================================================================
 	void Transform::UpdateTransform()
+	{
+		// Mark this transform and its descendants as dirty, a dirty descendant implies a dirty ancestor (so drop out when meeting one)
+		if (!m_is_dirty)
+		{
+			m_is_dirty = true;
+
+			for (const auto& child : m_children)
+			{
+				child->UpdateTransform();
+			}
+		}
+
+		// Let the ancestors know, so that UpdateHierarchy() can skip the parts of the hierarchy which didn't change.
+		// Start from the parent even if this transform is already flagged, it might have just been moved under a new parent.
+		m_is_dirty_hierarchy = true;
+		for (Transform* transform = m_parent; transform && !transform->m_is_dirty_hierarchy; transform = transform->m_parent)
+		{
+			transform->m_is_dirty_hierarchy = true;
+		}
+	}
+
+	void Transform::UpdateHierarchy()
+	{
+		if (!m_is_dirty_hierarchy)
+			return;
+
+		// Parents before children, so every child finds an up to date parent matrix
+		if (m_is_dirty)
+		{
+			ComputeMatrices();
+		}
+
+		for (const auto& child : m_children)
+		{
+			child->UpdateHierarchy();
+		}
+
+		m_is_dirty_hierarchy = false;
+	}
+
+	void Transform::ComputeMatrices() const
 	{
 		// Compute local transform
 		m_matrixLocal = Matrix(m_positionLocal, m_rotationLocal, m_scaleLocal);
 
-		// Compute world transform
+		// Compute world transform (GetParentTransformMatrix() computes the parent first, if it's dirty)
 		if (!HasParent())
 		{
 			m_matrix = m_matrixLocal;
@@ -101,12 +144,9 @@ namespace Spartan
 		{
 			m_matrix = m_matrixLocal * GetParentTransformMatrix();
 		}
-		
-		// Update children
-		for (const auto& child : m_children)
-		{
-			child->UpdateTransform();
-		}
+
+		m_matrix_revision++;
+		m_is_dirty = false;
 	}
 
 	//= TRANSLATION ==================================================================================
@@ -364,6 +404,29 @@ namespace Spartan
 		}
 	}
 
+	void Transform::LinkHierarchy(const vector<pair<Transform*, Transform*>>& child_parent_pairs)
+	{
+		for (const auto& child_parent : child_parent_pairs)
+		{
+			Transform* child	= child_parent.first;
+			Transform* parent	= child_parent.second;
+			if (!child || !parent || child == parent || child->m_parent)
+				continue;
+
+			child->m_parent = parent;
+			parent->m_children.emplace_back(child);
+		}
+
+		// Parents come before their children, so marking them dirty reaches the whole hierarchy
+		for (const auto& child_parent : child_parent_pairs)
+		{
+			if (child_parent.first)
+			{
+				child_parent.first->UpdateTransform();
+			}
+		}
+	}
+
 	bool Transform::IsDescendantOf(const Transform* transform) const
 	{
         for (const Transform* child : transform->GetChildren())
@@ -394,6 +457,53 @@ namespace Spartan
 		}
 	}
 
+	void Transform::OnFixedStep(const uint64_t step_index)
+	{
+		for (Transform* child : m_children)
+		{
+			child->OnFixedStep(step_index);
+		}
+
+		const uint64_t revision = GetMatrixRevision();
+
+		// A transform which missed a step (it was created or inactive) starts over, instead of interpolating from wherever it was
+		if (m_step_index == 0 || m_step_index + 1 != step_index)
+		{
+			m_matrix_step			= GetMatrix();
+			m_matrix_step_previous	= m_matrix_step;
+			m_matrix_step_revision	= revision;
+			m_step_index			= step_index;
+			m_step_moved			= false;
+			return;
+		}
+		m_step_index = step_index;
+
+		// Most transforms don't move, they skip the copies once both steps agree
+		const bool moved = revision != m_matrix_step_revision;
+		if (!moved && !m_step_moved)
+			return;
+
+		m_matrix_step_previous	= m_matrix_step;
+		m_matrix_step			= GetMatrix();
+		m_matrix_step_revision	= revision;
+		m_step_moved			= moved;
+	}
+
+	void Transform::OnSnapshot(const uint64_t step_index, const float alpha)
+	{
+		// Changed outside of the steps (e.g. by the editor), or not moving, nothing to interpolate
+		if (m_step_index != step_index || m_matrix_step_revision != GetMatrixRevision() || !m_step_moved)
+		{
+			OnSnapshot();
+			return;
+		}
+
+		const Vector3 position		= Helper::Lerp(m_matrix_step_previous.GetTranslation(), m_matrix_step.GetTranslation(), alpha);
+		const Quaternion rotation	= Quaternion::Lerp(m_matrix_step_previous.GetRotation(), m_matrix_step.GetRotation(), alpha);
+		const Vector3 scale			= Helper::Lerp(m_matrix_step_previous.GetScale(), m_matrix_step.GetScale(), alpha);
+		m_matrix_render				= Matrix(position, rotation, scale);
+	}
+
     Matrix Transform::GetParentTransformMatrix() const
 	{
 		return HasParent() ? GetParent()->GetMatrix() : Matrix::Identity;
@@ -42,28 +42,40 @@ namespace Spartan
 
 		//= ICOMPONENT ===============================
 		void OnInitialize() override;
+		void OnSnapshot() override { m_matrix_render = GetMatrix(); }
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
 		//============================================
 
+		// Marks the transform and its descendants as dirty, their matrices are computed when next needed (or by UpdateHierarchy()).
+		// Setting position, rotation and scale in a row doesn't recompute the hierarchy three times.
 		void UpdateTransform();
+		// Computes the matrices of any dirty transforms in the hierarchy, parents before children, the world calls it once per frame for every root
+		void UpdateHierarchy();
+
+		//= FIXED STEP =========================================================================================
+		// Records the world matrices of the hierarchy as of the given fixed step, the world calls it for every root after each step
+		void OnFixedStep(uint64_t step_index);
+		// Like OnSnapshot(), but in between the last two fixed steps (alpha = 0 is the previous step, 1 the last)
+		void OnSnapshot(uint64_t step_index, float alpha);
+		//======================================================================================================
 
 		//= POSITION ==============================================================
-		auto GetPosition()              const { return m_matrix.GetTranslation(); }
+		auto GetPosition()              const { return GetMatrix().GetTranslation(); }
 		const auto& GetPositionLocal()  const { return m_positionLocal; }
 		void SetPosition(const Math::Vector3& position);
 		void SetPositionLocal(const Math::Vector3& position);
 		//=========================================================================
 
 		//= ROTATION ===========================================================
-		Math::Quaternion GetRotation() const { return m_matrix.GetRotation(); }
+		Math::Quaternion GetRotation() const { return GetMatrix().GetRotation(); }
 		const auto& GetRotationLocal() const { return m_rotationLocal; }
 		void SetRotation(const Math::Quaternion& rotation);
 		void SetRotationLocal(const Math::Quaternion& rotation);
 		//======================================================================
 
 		//= SCALE =======================================================
-		auto GetScale()             const { return m_matrix.GetScale(); }
+		auto GetScale()             const { return GetMatrix().GetScale(); }
 		const auto& GetScaleLocal() const { return m_scaleLocal; }
 		void SetScale(const Math::Vector3& scale);
 		void SetScaleLocal(const Math::Vector3& scale);
@@ -98,31 +110,50 @@ namespace Spartan
 		const std::vector<Transform*>& GetChildren() const	{ return m_children; }
 	
 		void AcquireChildren();
+		// Links children to their parents without the hierarchy searches of SetParent(), for loading many transforms at once.
+		// The children must be roots without children of their own, and each parent is expected to be linked before its children.
+		static void LinkHierarchy(const std::vector<std::pair<Transform*, Transform*>>& child_parent_pairs);
 		bool IsDescendantOf(const Transform* transform) const;
 		void GetDescendants(std::vector<Transform*>* descendants);
 		//======================================================================================
 
 		void LookAt(const Math::Vector3& v)                       { m_lookAt = v; }
-		const Math::Matrix& GetMatrix()                     const { return m_matrix; }     
-		const Math::Matrix& GetLocalMatrix()                const { return m_matrixLocal; }
+		const Math::Matrix& GetMatrix()                     const { if (m_is_dirty) ComputeMatrices(); return m_matrix; }
+		const Math::Matrix& GetLocalMatrix()                const { if (m_is_dirty) ComputeMatrices(); return m_matrixLocal; }
         const Math::Matrix& GetWvpLastFrame()               const { return m_wvp_previous; }
         void SetWvpLastFrame(const Math::Matrix& matrix)          { m_wvp_previous = matrix;}
+        const Math::Matrix& GetMatrixRender()               const { return m_matrix_render; } // as of the last renderer snapshot
+        // Changes whenever the world matrix is recomputed, so that what's derived from it can be cached
+        uint64_t GetMatrixRevision()                        const { if (m_is_dirty) ComputeMatrices(); return m_matrix_revision; }
 
 	private:
 		Math::Matrix GetParentTransformMatrix() const;
+		void ComputeMatrices() const;
 
 		// local
 		Math::Vector3 m_positionLocal;
 		Math::Quaternion m_rotationLocal;
 		Math::Vector3 m_scaleLocal;
 
-		Math::Matrix m_matrix;
-		Math::Matrix m_matrixLocal;
+		// computed on demand, so they can change through the const getters
+		mutable Math::Matrix m_matrix;
+		mutable Math::Matrix m_matrixLocal;
+		mutable bool m_is_dirty		    = true;
+		mutable uint64_t m_matrix_revision = 0;
+		bool m_is_dirty_hierarchy	    = true;
 		Math::Vector3 m_lookAt;
 
 		Transform* m_parent; // the parent of this transform
 		std::vector<Transform*> m_children; // the children of this transform
 
 		Math::Matrix m_wvp_previous;
+		Math::Matrix m_matrix_render;
+
+		// world matrices as of the last two fixed steps
+		Math::Matrix m_matrix_step;
+		Math::Matrix m_matrix_step_previous;
+		uint64_t m_matrix_step_revision = 0;
+		uint64_t m_step_index           = 0;
+		bool m_step_moved               = false;
 	};
 }
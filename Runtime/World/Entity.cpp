@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ========================
 #include "Entity.h"
 #include "World.h"
+#include "Prefab.h"
 #include "Components/Camera.h"
 #include "Components/Collider.h"
 #include "Components/Transform.h"
@@ -35,8 +36,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Components/AudioSource.h"
 #include "Components/AudioListener.h"
 #include "Components/Terrain.h"
+#include "Components/Animator.h"
+#include "Components/Foliage.h"
+#include "Components/ParticleEmitter.h"
+#include "Components/Decal.h"
+#include "Components/ReflectionProbe.h"
 #include "../IO/FileStream.h"
 #include "../Core/Context.h"
+#include "../Resource/ResourceCache.h"
 //===================================
 
 //= NAMESPACES =====
@@ -48,7 +55,7 @@ namespace Spartan
     Entity::Entity(Context* context, uint32_t transform_id /*= 0*/)
     {
         m_context               = context;
-        m_name                  = "Entity";
+        SetName("Entity");
         m_is_active             = true;
         m_hierarchy_visibility  = true;
         AddComponent<Transform>(transform_id);
@@ -62,7 +69,9 @@ namespace Spartan
         m_renderable            = nullptr;
         m_context               = nullptr;
         m_name.clear();
+        m_name_id = StringId();
         m_component_mask = 0;
+        m_component_slots.fill(nullptr);
 		for (auto it = m_components.begin(); it != m_components.end();)
 		{
 			(*it)->OnRemove();
@@ -86,6 +95,7 @@ namespace Spartan
 			clone->SetName(entity->GetName());
 			clone->SetActive(entity->IsActive());
 			clone->SetHierarchyVisibility(entity->IsVisibleInHierarchy());
+			clone->SetPrefab(entity->GetPrefab(), entity->GetPrefabNode());
 
 			// Clone all the components
 			for (const auto& component : entity->GetAllComponents())
@@ -126,7 +136,10 @@ namespace Spartan
 		// call component Start()
 		for (auto const& component : m_components)
 		{
-			component->OnStart();
+            if (component->HasPhase(ComponentPhase_Start))
+            {
+			    component->OnStart();
+            }
 		}
 	}
 
@@ -135,10 +148,24 @@ namespace Spartan
 		// call component Stop()
 		for (auto const& component : m_components)
 		{
-			component->OnStop();
+            if (component->HasPhase(ComponentPhase_Stop))
+            {
+			    component->OnStop();
+            }
 		}
 	}
 
+    void Entity::SetActive(const bool active)
+    {
+        if (m_is_active == active)
+            return;
+
+        m_is_active = active;
+
+        // The world only ticks the components of active entities
+        FIRE_EVENT_DEFERRED(Event_World_Schedule_Pending);
+    }
+
 	void Entity::Tick(float delta_time)
 	{
 		if (!m_is_active)
@@ -147,7 +174,10 @@ namespace Spartan
 		// call component Update()
 		for (const auto& component : m_components)
 		{
-			component->OnTick(delta_time);
+            if (component->IsTickable())
+            {
+			    component->OnTick(delta_time);
+            }
 		}
 	}
 
@@ -161,6 +191,15 @@ namespace Spartan
             stream->Write(m_name);
         }
 
+        // PREFAB
+        {
+            stream->Write(m_prefab ? m_prefab->GetResourceFilePathNative() : string());
+            if (m_prefab)
+            {
+                stream->Write(m_prefab_node);
+            }
+        }
+
 		// COMPONENTS
         {
             stream->Write(static_cast<uint32_t>(m_components.size()));
@@ -170,8 +209,30 @@ namespace Spartan
                 stream->Write(component->GetId());
             }
 
+            array<uint32_t, ComponentType_Unknown> occurrences = {};
             for (const auto& component : m_components)
             {
+                // Components of prefab instances which match the prefab are a single flag
+                if (m_prefab)
+                {
+                    const string* data_prefab = m_prefab->GetComponentData(m_prefab_node, component->GetType(), occurrences[component->GetType()]++);
+
+                    bool is_override = true;
+                    if (data_prefab)
+                    {
+                        string data;
+                        {
+                            FileStream memory(&data, FileStream_Write);
+                            component->Serialize(&memory);
+                        }
+                        is_override = data != *data_prefab;
+                    }
+
+                    stream->Write(is_override);
+                    if (!is_override)
+                        continue;
+                }
+
                 component->Serialize(stream);
             }
         }
@@ -213,6 +274,17 @@ namespace Spartan
             stream->Read(&m_hierarchy_visibility);
             stream->Read(&m_id);
             stream->Read(&m_name);
+            m_name_id = m_name;
+        }
+
+        // PREFAB
+        const string prefab_path = stream->ReadAs<string>();
+        {
+            if (!prefab_path.empty())
+            {
+                m_prefab        = m_context->GetSubsystem<ResourceCache>()->Load<Prefab>(prefab_path);
+                m_prefab_node   = stream->ReadAs<uint32_t>();
+            }
         }
 
         // COMPONENTS
@@ -232,8 +304,25 @@ namespace Spartan
             // Sometimes there are component dependencies, e.g. a collider that needs
             // to set it's shape to a rigibody. So, it's important to first create all 
             // the components (like above) and then deserialize them (like here).
+            array<uint32_t, ComponentType_Unknown> occurrences = {};
             for (const auto& component : m_components)
             {
+                // Components of prefab instances can come from the prefab
+                const uint32_t occurrence = occurrences[component->GetType()]++;
+                if (!prefab_path.empty() && !stream->ReadAs<bool>())
+                {
+                    const string* data_prefab = m_prefab ? m_prefab->GetComponentData(m_prefab_node, component->GetType(), occurrence) : nullptr;
+                    if (!data_prefab)
+                    {
+                        LOG_WARNING("The data of \"%s\" in prefab \"%s\" is missing", component->GetEntityName().c_str(), prefab_path.c_str());
+                        continue;
+                    }
+
+                    FileStream memory(reinterpret_cast<const std::byte*>(data_prefab->data()), data_prefab->size());
+                    component->Deserialize(&memory);
+                    continue;
+                }
+
                 component->Deserialize(stream);
             }
 
@@ -272,7 +361,7 @@ namespace Spartan
         }
 
 		// Make the scene resolve
-		FIRE_EVENT(Event_World_Resolve_Pending);
+		FIRE_EVENT_DEFERRED(Event_World_Resolve_Pending);
 	}
 
     IComponent* Entity::AddComponent(const ComponentType type, uint32_t id /*= 0*/)
@@ -295,6 +384,11 @@ namespace Spartan
             case ComponentType_Environment:		return AddComponent<Environment>(id);
             case ComponentType_Transform:		return AddComponent<Transform>(id);
             case ComponentType_Terrain:		    return AddComponent<Terrain>(id);
+            case ComponentType_Animator:		return AddComponent<Animator>(id);
+            case ComponentType_Foliage:		    return AddComponent<Foliage>(id);
+            case ComponentType_ParticleEmitter:	return AddComponent<ParticleEmitter>(id);
+            case ComponentType_Decal:	        return AddComponent<Decal>(id);
+            case ComponentType_ReflectionProbe:	return AddComponent<ReflectionProbe>(id);
             case ComponentType_Unknown:			return nullptr;
             default:                            return nullptr;
         }
@@ -322,20 +416,62 @@ namespace Spartan
 			}
 		}
 
-        // The script component can have multiple instance, so only remove
-        // it's flag if there are no more components of that type left
-        bool others_of_same_type_exist = false;
-        for (auto it = m_components.begin(); it != m_components.end(); ++it)
+        // The script component can have multiple instances, so the slot moves on to the next one (if any)
+        if (component_type != ComponentType_Unknown)
         {
-            others_of_same_type_exist = ((*it)->GetType() == component_type) ? true : others_of_same_type_exist;
-        }
-
-        if (!others_of_same_type_exist)
-        {
-            m_component_mask &= ~GetComponentMask(component_type);
+            UpdateComponentSlot(component_type);
         }
 
 		// Make the scene resolve
 		FIRE_EVENT(Event_World_Resolve_Pending);
 	}
+
+    const string* Entity::GetPrefabComponentData(const IComponent* component) const
+    {
+        if (!m_prefab || !component)
+            return nullptr;
+
+        // The nth component of a type maps to the nth component of that type in the node
+        uint32_t occurrence = 0;
+        for (const auto& candidate : m_components)
+        {
+            if (candidate.get() == component)
+                break;
+
+            if (candidate->GetType() == component->GetType())
+            {
+                occurrence++;
+            }
+        }
+
+        return m_prefab->GetComponentData(m_prefab_node, component->GetType(), occurrence);
+    }
+
+    void Entity::UpdateComponentSlot(const ComponentType type)
+    {
+        IComponent* first = nullptr;
+        for (const auto& component : m_components)
+        {
+            if (component->GetType() == type)
+            {
+                first = component.get();
+                break;
+            }
+        }
+
+        m_component_slots[type] = first;
+
+        if (first)
+        {
+            m_component_mask |= GetComponentMask(type);
+        }
+        else
+        {
+            m_component_mask &= ~GetComponentMask(type);
+        }
+
+        // Drop the cached pointers of removed components
+        if (type == ComponentType_Transform)    { m_transform   = static_cast<Transform*>(first); }
+        if (type == ComponentType_Renderable)   { m_renderable  = static_cast<Renderable*>(first); }
+    }
 }
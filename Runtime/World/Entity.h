@@ -23,8 +23,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =====================
 #include <vector>
+#include <array>
 #include "../Core/EventSystem.h"
+#include "../Core/StringId.h"
 #include "Components/IComponent.h"
+#include "Components/ComponentPool.h"
 //================================
 
 namespace Spartan
@@ -32,6 +35,7 @@ namespace Spartan
 	class Context;
 	class Transform;
 	class Renderable;
+	class Prefab;
 	
 	class SPARTAN_CLASS Entity : public Spartan_Object, public std::enable_shared_from_this<Entity>
 	{
@@ -48,15 +52,26 @@ namespace Spartan
 
 		//= PROPERTIES ===================================================================================================
 		const std::string& GetName() const								{ return m_name; }
-		void SetName(const std::string& name)							{ m_name = name; }
+		StringId GetNameId() const										{ return m_name_id; } // compares without touching the characters
+		void SetName(const std::string& name)							{ m_name = name; m_name_id = name; }
 
 		bool IsActive() const											{ return m_is_active; }
-		void SetActive(const bool active)								{ m_is_active = active; }
+		void SetActive(const bool active);
 
 		bool IsVisibleInHierarchy() const								{ return m_hierarchy_visibility; }
 		void SetHierarchyVisibility(const bool hierarchy_visibility)	{ m_hierarchy_visibility = hierarchy_visibility; }
 		//================================================================================================================
 
+		//= PREFAB ===========================================================================================================
+		// An entity which was created from a prefab only serializes the components which differ from the prefab's node
+		void SetPrefab(const std::shared_ptr<Prefab>& prefab, uint32_t node)	{ m_prefab = prefab; m_prefab_node = node; }
+		const std::shared_ptr<Prefab>& GetPrefab() const						{ return m_prefab; }
+		uint32_t GetPrefabNode() const											{ return m_prefab_node; }
+		bool IsPrefabInstance() const											{ return m_prefab != nullptr; }
+		// Returns the prefab's data of one of the entity's components, nullptr if the entity or its node has no such component
+		const std::string* GetPrefabComponentData(const IComponent* component) const;
+		//====================================================================================================================
+
 		// Adds a component of type T
 		template <class T>
         T* AddComponent(uint32_t id = 0)
@@ -67,12 +82,16 @@ namespace Spartan
 			if (HasComponent(type) && type != ComponentType_Script)
 				return GetComponent<T>();
 
-            // Create a new component
-            std::shared_ptr<T> component = std::make_shared<T>(m_context, this, id);
+            // Create a new component, in the pool of its type
+            std::shared_ptr<T> component = std::allocate_shared<T>(ComponentAllocator<T>(ComponentPool::Get(type)), m_context, this, id);
 
             // Save new component
             m_components.emplace_back(std::static_pointer_cast<IComponent>(component));
             m_component_mask |= GetComponentMask(type);
+            if (!m_component_slots[type])
+            {
+                m_component_slots[type] = component.get();
+            }
 
             // Caching of rendering performance critical components
             if constexpr (std::is_same<T, Transform>::value)    { m_transform   = static_cast<Transform*>(component.get()); }
@@ -80,10 +99,11 @@ namespace Spartan
 
             // Initialize component
             component->SetType(type);
+            component->SetPhases(IComponent::PhasesOf<T>()); // components are never called for the phases they don't override
             component->OnInitialize();
 
-			// Make the scene resolve
-			FIRE_EVENT(Event_World_Resolve_Pending);
+			// Make the scene resolve, queued since components can be added from any thread (and thousands at a time during import)
+			FIRE_EVENT_DEFERRED(Event_World_Resolve_Pending);
 
             return component.get();
 		}
@@ -91,22 +111,11 @@ namespace Spartan
         // Adds a component of ComponentType 
         IComponent* AddComponent(ComponentType type, uint32_t id = 0);
 
-		// Returns a component of type T (if it exists)
+		// Returns a component of type T (if it exists), for Script this is the first one
 		template <class T>
         T* GetComponent()
 		{
-            const ComponentType type = IComponent::TypeToEnum<T>();
-
-            if (!HasComponent(type))
-                return nullptr;
-
-			for (const auto& component : m_components)
-			{
-				if (component->GetType() == type)
-					return static_cast<T*>(component.get());
-			}
-
-			return nullptr;
+            return static_cast<T*>(m_component_slots[IComponent::TypeToEnum<T>()]);
 		}
 
 		// Returns any components of type T (if they exist)
@@ -150,15 +159,15 @@ namespace Spartan
 				{
 					component->OnRemove();
 					it = m_components.erase(it);
-                    m_component_mask &= ~GetComponentMask(type);
 				}
 				else
 				{
 					++it;
 				}
 			}
+            UpdateComponentSlot(type);
 
-			// Make the scene resolve
+			// Make the scene resolve, right away since the world must not tick the removed component again
 			FIRE_EVENT(Event_World_Resolve_Pending);
 		}
 
@@ -175,16 +184,23 @@ namespace Spartan
 
 	private:
         constexpr uint32_t GetComponentMask(ComponentType type) { return static_cast<uint32_t>(1) << static_cast<uint32_t>(type); }
+        // Points the slot (and the mask bit) of a type to the first remaining component of that type, if any
+        void UpdateComponentSlot(ComponentType type);
 
 		std::string m_name			= "Entity";
+		StringId m_name_id			= "Entity";
 		bool m_is_active			= true;
 		bool m_hierarchy_visibility	= true;
 		Transform* m_transform		= nullptr;
 		Renderable* m_renderable	= nullptr;
         bool m_destruction_pending  = false;
+        std::shared_ptr<Prefab> m_prefab;
+        uint32_t m_prefab_node      = 0;
 		
         // Components
         std::vector<std::shared_ptr<IComponent>> m_components;
         uint32_t m_component_mask = 0;
+        // The first component of each type, so that GetComponent() is a single load (the vector above owns them)
+        std::array<IComponent*, ComponentType_Unknown> m_component_slots = {};
 	};
 }
@@ -0,0 +1,234 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ========================
+#include "Prefab.h"
+#include "World.h"
+#include "Entity.h"
+#include "Components/Transform.h"
+#include "../IO/FileStream.h"
+#include "../Core/Context.h"
+//===================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+	Prefab::Prefab(Context* context) : IResource(context, Resource_Prefab)
+	{
+
+	}
+
+	bool Prefab::LoadFromFile(const string& file_path)
+	{
+		auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
+		if (!file->IsOpen())
+			return false;
+
+		m_nodes.clear();
+		m_nodes.resize(file->ReadAs<uint32_t>());
+		for (Prefab_Node& node : m_nodes)
+		{
+			file->Read(&node.name);
+			file->Read(&node.is_active);
+			file->Read(&node.parent);
+			file->Read(&node.position);
+			file->Read(&node.rotation);
+			file->Read(&node.scale);
+
+			node.components.resize(file->ReadAs<uint32_t>());
+			for (auto& component : node.components)
+			{
+				component.first = static_cast<ComponentType>(file->ReadAs<uint32_t>());
+				file->Read(&component.second);
+			}
+		}
+
+		SetResourceFilePath(file_path);
+
+		return true;
+	}
+
+	bool Prefab::SaveToFile(const string& file_path)
+	{
+		auto file = make_unique<FileStream>(file_path, FileStream_Write);
+		if (!file->IsOpen())
+			return false;
+
+		file->Write(static_cast<uint32_t>(m_nodes.size()));
+		for (const Prefab_Node& node : m_nodes)
+		{
+			file->Write(node.name);
+			file->Write(node.is_active);
+			file->Write(node.parent);
+			file->Write(node.position);
+			file->Write(node.rotation);
+			file->Write(node.scale);
+
+			file->Write(static_cast<uint32_t>(node.components.size()));
+			for (const auto& component : node.components)
+			{
+				file->Write(static_cast<uint32_t>(component.first));
+				file->Write(component.second);
+			}
+		}
+
+		file->Close();
+
+		SetResourceFilePath(file_path);
+
+		return true;
+	}
+
+	bool Prefab::SetTemplate(Entity* root)
+	{
+		if (!root || !root->GetTransform())
+		{
+			LOG_ERROR_INVALID_PARAMETER();
+			return false;
+		}
+
+		m_nodes.clear();
+
+		// Depth first, so that instancing can parent every node to one which already exists
+		function<void(Entity*, int32_t)> capture = [this, &capture](Entity* entity, const int32_t parent)
+		{
+			const auto index	= static_cast<int32_t>(m_nodes.size());
+			Prefab_Node& node	= m_nodes.emplace_back();
+			Transform* transform = entity->GetTransform();
+
+			node.name		= entity->GetName();
+			node.is_active	= entity->IsActive();
+			node.parent		= parent;
+			node.position	= transform->GetPositionLocal();
+			node.rotation	= transform->GetRotationLocal();
+			node.scale		= transform->GetScaleLocal();
+
+			for (const auto& component : entity->GetAllComponents())
+			{
+				// The transform refers to its parent by id, which means nothing to an instance
+				if (component->GetType() == ComponentType_Transform)
+					continue;
+
+				string data;
+				{
+					FileStream stream(&data, FileStream_Write);
+					component->Serialize(&stream);
+				}
+				m_nodes[index].components.emplace_back(component->GetType(), move(data));
+			}
+
+			for (Transform* child : transform->GetChildren())
+			{
+				if (child->GetEntity())
+				{
+					capture(child->GetEntity(), index);
+				}
+			}
+		};
+		capture(root, -1);
+
+		return true;
+	}
+
+	shared_ptr<Entity> Prefab::Instantiate(const Vector3& position /*= Vector3::Zero*/, const Quaternion& rotation /*= Quaternion::Identity*/, const Vector3& scale /*= Vector3::One*/)
+	{
+		if (m_nodes.empty())
+		{
+			LOG_ERROR("\"%s\" has no template", GetResourceName().c_str());
+			return nullptr;
+		}
+
+		World* world				= m_context->GetSubsystem<World>();
+		shared_ptr<Prefab> self		= shared_from_this();
+		vector<Entity*> entities;
+		entities.reserve(m_nodes.size());
+
+		// Create all the entities and components first, components can depend on each other (see Entity::Deserialize())
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_nodes.size()); i++)
+		{
+			const Prefab_Node& node = m_nodes[i];
+			Entity* entity			= world->EntityCreate(node.is_active).get();
+
+			entity->SetName(node.name);
+			entity->SetPrefab(self, i);
+
+			for (const auto& component : node.components)
+			{
+				entity->AddComponent(component.first);
+			}
+
+			Transform* transform = entity->GetTransform();
+			if (node.parent >= 0)
+			{
+				transform->SetParent(entities[node.parent]->GetTransform());
+				transform->SetPositionLocal(node.position);
+				transform->SetRotationLocal(node.rotation);
+				transform->SetScaleLocal(node.scale);
+			}
+			else
+			{
+				transform->SetPositionLocal(position);
+				transform->SetRotationLocal(rotation);
+				transform->SetScaleLocal(scale);
+			}
+
+			entities.emplace_back(entity);
+		}
+
+		// Deserialize the components from the template
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_nodes.size()); i++)
+		{
+			uint32_t component_index = 0;
+			for (const auto& component : entities[i]->GetAllComponents())
+			{
+				if (component->GetType() == ComponentType_Transform)
+					continue;
+
+				const string& data = m_nodes[i].components[component_index++].second;
+				FileStream stream(reinterpret_cast<const std::byte*>(data.data()), data.size());
+				component->Deserialize(&stream);
+			}
+		}
+
+		return entities.front()->GetPtrShared();
+	}
+
+	const string* Prefab::GetComponentData(const uint32_t node_index, const ComponentType type, uint32_t occurrence /*= 0*/) const
+	{
+		if (node_index >= m_nodes.size())
+			return nullptr;
+
+		for (const auto& component : m_nodes[node_index].components)
+		{
+			if (component.first != type)
+				continue;
+
+			if (occurrence-- == 0)
+				return &component.second;
+		}
+
+		return nullptr;
+	}
+}
@@ -0,0 +1,79 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ==========================
+#include <vector>
+#include <memory>
+#include "../Resource/IResource.h"
+#include "../Math/Vector3.h"
+#include "../Math/Quaternion.h"
+#include "Components/IComponent.h"
+//=====================================
+
+namespace Spartan
+{
+	class Entity;
+
+	// A node of a prefab's hierarchy, the component data is whatever the component serializes (the transform is kept as plain values)
+	struct Prefab_Node
+	{
+		std::string name;
+		bool is_active							= true;
+		int32_t parent							= -1; // index of the parent node, the root has none
+		Math::Vector3 position					= Math::Vector3::Zero;
+		Math::Quaternion rotation				= Math::Quaternion::Identity;
+		Math::Vector3 scale						= Math::Vector3::One;
+		std::vector<std::pair<ComponentType, std::string>> components;
+	};
+
+	// An entity hierarchy which is saved once and shared by all of its instances.
+	// Instances are created from memory and remember their prefab, so a world only stores their transforms and
+	// the components which differ from the template (see Entity::Serialize()).
+	class SPARTAN_CLASS Prefab : public IResource, public std::enable_shared_from_this<Prefab>
+	{
+	public:
+		Prefab(Context* context);
+		~Prefab() = default;
+
+		//= IResource ===========================================
+		bool LoadFromFile(const std::string& file_path) override;
+		bool SaveToFile(const std::string& file_path) override;
+		//=======================================================
+
+		// Captures an entity and its descendants as the template
+		bool SetTemplate(Entity* root);
+
+		// Creates an instance of the template, the transform is applied to the root
+		std::shared_ptr<Entity> Instantiate(const Math::Vector3& position = Math::Vector3::Zero, const Math::Quaternion& rotation = Math::Quaternion::Identity, const Math::Vector3& scale = Math::Vector3::One);
+
+		// Returns the template data of the nth component of a type in a node, nullptr if there is none
+		const std::string* GetComponentData(uint32_t node_index, ComponentType type, uint32_t occurrence = 0) const;
+
+		const auto& GetNodes()		const { return m_nodes; }
+		uint32_t GetNodeCount()		const { return static_cast<uint32_t>(m_nodes.size()); }
+
+	private:
+		// Nodes are stored depth first, so a parent always comes before its children
+		std::vector<Prefab_Node> m_nodes;
+	};
+}
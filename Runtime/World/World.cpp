@@ -27,15 +27,21 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Components/Light.h"
 #include "Components/Environment.h"
 #include "Components/AudioListener.h"
+#include "Components/Animator.h"
+#include "Components/Script.h"
+#include "Components/ComponentPool.h"
 #include "../Core/Engine.h"
 #include "../Core/Stopwatch.h"
+#include "../Core/Timer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ProgressReport.h"
 #include "../IO/FileStream.h"
 #include "../Profiling/Profiler.h"
 #include "../Rendering/Renderer.h"
 #include "../Input/Input.h"
+#include "../Threading/Threading.h"
 #include "../RHI/RHI_Device.h"
+#include <map>
 //=====================================
 
 //= NAMESPACES ================
@@ -45,10 +51,26 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace _World
+    {
+        static const float cell_size                = 128.0f;   // the side of a cell, in world units
+        static const float cell_load_distance       = 192.0f;   // from the camera to the closest point of a cell
+        static const float cell_unload_distance     = 256.0f;   // further than the load distance, so that a camera on the edge doesn't keep loading and unloading
+        static const uint32_t cell_roots_per_tick   = 16;       // root entities deserialized per tick, so that a cell doesn't stall a frame
+        static const uint32_t animator_channels_per_tick = 65536; // animation channels sampled per tick, animators past it are sampled on the next one
+        static const char* cell_extension           = ".cell";
+
+        static string cell_directory(const string& file_path_world)
+        {
+            return FileSystem::GetFilePathWithoutExtension(file_path_world) + "_cells";
+        }
+    }
+
 	World::World(Context* context) : ISubsystem(context)
 	{
 		// Subscribe to events
-		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Pending, [this](Variant) { m_is_dirty = true; });
+		SUBSCRIBE_TO_EVENT(Event_World_Resolve_Pending, [this](Variant) { m_is_dirty = true; m_component_lists_dirty = true; });
+		SUBSCRIBE_TO_EVENT(Event_World_Schedule_Pending, [this](Variant) { m_component_lists_dirty = true; });
 		SUBSCRIBE_TO_EVENT(Event_World_Stop,	        [this](Variant)	{ m_state = Idle; });
 		SUBSCRIBE_TO_EVENT(Event_World_Start,	        [this](Variant)	{ m_state = Ticking; });
 	}
@@ -58,12 +80,14 @@ namespace Spartan
 		Unload();
         m_input     = nullptr;
         m_profiler  = nullptr;
+        m_timer     = nullptr;
 	}
 
 	bool World::Initialize()
 	{
 		m_input		= m_context->GetSubsystem<Input>();
 		m_profiler	= m_context->GetSubsystem<Profiler>();
+		m_timer		= m_context->GetSubsystem<Timer>();
 
 		CreateCamera();
 		CreateEnvironment();
@@ -85,6 +109,12 @@ namespace Spartan
 
         SCOPED_TIME_BLOCK(m_profiler);
 
+        // Load and unload cells, before the entities tick, so that the entities of a cell start ticking along with the rest
+        if (!m_cells.empty())
+        {
+            StreamingTick();
+        }
+
         // Tick entities
 		{
             // Detect game toggling
@@ -92,49 +122,64 @@ namespace Spartan
             const bool stopped      = !m_context->m_engine->EngineMode_IsSet(Engine_Game) && !m_was_in_editor_mode;
             m_was_in_editor_mode    = !m_context->m_engine->EngineMode_IsSet(Engine_Game);
 
+            if (m_component_lists_dirty)
+            {
+                UpdateComponentLists();
+            }
+
             // Start
             if (started)
             {
-                for (const auto& entity : m_entities)
+                for (IComponent* component : m_components_startable)
                 {
-                    entity->Start();
+                    component->OnStart();
                 }
             }
 
             // Stop
             if (stopped)
             {
-                for (const auto& entity : m_entities)
+                for (IComponent* component : m_components_stoppable)
                 {
-                    entity->Stop();
+                    component->OnStop();
                 }
             }
 
-            // Tick
-            for (const auto& entity : m_entities)
-            {
-                entity->Tick(delta_time);
-            }
-		}
-
-        if (m_is_dirty)
-        {
-            // Update dirty entities
+            // Tick, one component type at a time
+            for (uint32_t type = 0; type < ComponentType_Unknown; type++)
             {
-                // Make a copy so we can iterate while removing entities
-                auto entities_copy = m_entities;
+                // Scripts update in batches, one per script class
+                if (type == ComponentType_Script)
+                {
+                    ScriptsTick(delta_time);
+                    continue;
+                }
 
-                for (const auto& entity : entities_copy)
+                // The lists are rebuilt once the deferred Event_World_Schedule_Pending fires, until then they can hold entities which were just deactivated
+                for (IComponent* component : m_components_tickable[type])
                 {
-                    if (entity->IsPendingDestruction())
+                    if (component->GetEntity()->IsActive())
                     {
-                        _EntityRemove(entity);
+                        component->OnTick(delta_time);
                     }
                 }
             }
 
+            // Sample the animators, after they ticked and before the transforms update
+            AnimatorsTick();
+
+            // Compute the transforms which changed (the components above are what usually changes them).
+            // When the world ticks with the fixed step, the transforms also record where the step left them, for the renderer to interpolate.
+            TransformsUpdate(m_timer->IsFixedStepEnabled() ? m_timer->GetFixedStepIndex() : 0);
+		}
+
+        if (m_is_dirty)
+        {
+            // Remove the entities which are pending destruction
+            EntitiesRemovePending();
+
             // Notify Renderer
-            FIRE_EVENT_DATA(Event_World_Resolve_Complete, m_entities);
+            FIRE_EVENT_DATA(Event_World_Resolve_Complete, Span<shared_ptr<Entity>>(m_entities));
             m_is_dirty = false;
         }
 	}
@@ -144,8 +189,19 @@ namespace Spartan
         // Notify any systems that the entities are about to be cleared
 		FIRE_EVENT(Event_World_Unload);
 
+        // A save which is still writing, the chunks it's writing are of these entities
+        BlocksWait();
+        m_chunks.clear();
+        m_chunks_file_path.clear();
+        m_chunks_file_size = 0;
+
+        CellsClear();
         m_entities.clear();
         m_entities.shrink_to_fit();
+        m_entities_pending_destruction.clear();
+        m_entity_index_by_id.clear();
+        m_entity_index_by_name.clear();
+        m_component_lists_dirty = true;
 
 		m_is_dirty = true;
 	}
@@ -169,43 +225,35 @@ namespace Spartan
 		// Notify subsystems that need to save data
 		FIRE_EVENT(Event_World_Save);
 
-		// Create a prefab file
-		auto file = make_unique<FileStream>(file_path, FileStream_Write);
-		if (!file->IsOpen())
-		{
-			LOG_ERROR_GENERIC_FAILURE();
-			return false;
-		}
+        // Cells which are not loaded have nothing in memory to save, so they are loaded first
+        CellsLoadAll();
 
 		// Only save root entities as they will also save their descendants
 		auto root_actors = EntityGetRoots();
-		const auto root_entity_count = static_cast<uint32_t>(root_actors.size());
-
-		ProgressReport::Get().SetJobCount(g_progress_world, root_entity_count);
-
-		// Save root entity count
-		file->Write(root_entity_count);
 
-		// Save root entity IDs
-		for (const auto& root : root_actors)
-		{
-			file->Write(root->GetId());
-		}
+        // Streamed roots go to the files of their cells, the rest stay in the world file
+        const string directory_cells = _World::cell_directory(file_path);
+        if (m_streaming)
+        {
+            if (!CellsSave(directory_cells, root_actors))
+                return false;
+        }
+        else if (FileSystem::Exists(directory_cells))
+        {
+            FileSystem::Delete(directory_cells);
+            m_cells.clear();
+        }
 
-		// Save root entities
-		for (const auto& root : root_actors)
+		if (!BlocksSave(file_path, root_actors))
 		{
-			root->Serialize(file.get());
-			ProgressReport::Get().IncrementJobsDone(g_progress_world);
+			LOG_ERROR_GENERIC_FAILURE();
+			return false;
 		}
 
-		// Finish with progress report and timer
+		// Finish with progress report and timer, Event_World_Saved fires once the write is done
 		ProgressReport::Get().SetIsLoading(g_progress_world, false);
 		LOG_INFO("Saving took %.2f ms", timer.GetElapsedTimeMs());
 
-		// Notify subsystems waiting for us to finish
-		FIRE_EVENT(Event_World_Saved);
-
 		return true;
 	}
 
@@ -233,35 +281,46 @@ namespace Spartan
 		// Unload current entities
 		Unload();
 
-		// Read all the resource file paths
-		auto file = make_unique<FileStream>(file_path, FileStream_Read);
-		if (!file->IsOpen())
-			return false;
-
 		m_name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
 
 		// Notify subsystems that need to load data
 		FIRE_EVENT(Event_World_Load);
 
-		// Load root entity count
-        const auto root_entity_count = file->ReadAs<uint32_t>();
-
-		ProgressReport::Get().SetJobCount(g_progress_world, root_entity_count);
-
-		// Load root entity IDs
-		for (uint32_t i = 0; i < root_entity_count; i++)
+		if (BlocksIsFile(file_path))
 		{
-			auto& entity = EntityCreate();
-			entity->SetId(file->ReadAs<uint32_t>());
+			if (!BlocksLoad(file_path))
+				return false;
 		}
-
-		// Serialize root entities
-		for (uint32_t i = 0; i < root_entity_count; i++)
+		// Worlds which were saved before the block format, entity by entity
+		else
 		{
-			m_entities[i]->Deserialize(file.get(), nullptr);
-			ProgressReport::Get().IncrementJobsDone(g_progress_world);
+			auto file = make_unique<FileStream>(file_path, FileStream_Read | FileStream_Mapped);
+			if (!file->IsOpen())
+				return false;
+
+			// Load root entity count
+			const auto root_entity_count = file->ReadAs<uint32_t>();
+
+			ProgressReport::Get().SetJobCount(g_progress_world, root_entity_count);
+
+			// Load root entity IDs
+			for (uint32_t i = 0; i < root_entity_count; i++)
+			{
+				auto& entity = EntityCreate();
+				entity->SetId(file->ReadAs<uint32_t>());
+			}
+
+			// Serialize root entities
+			for (uint32_t i = 0; i < root_entity_count; i++)
+			{
+				m_entities[i]->Deserialize(file.get(), nullptr);
+				ProgressReport::Get().IncrementJobsDone(g_progress_world);
+			}
 		}
 
+        // The cells load as the camera gets close to them
+        CellsAcquire(_World::cell_directory(file_path));
+
 		m_is_dirty	= true;
 		m_state		= Ticking;
 		ProgressReport::Get().SetIsLoading(g_progress_world, false);	
@@ -273,8 +332,10 @@ namespace Spartan
 
     shared_ptr<Entity>& World::EntityCreate(bool is_active /*= true*/)
     {
-        auto& entity = m_entities.emplace_back(make_shared<Entity>(m_context));
+        // Pooled, like the components, so that spawning and streaming don't go through the heap for every entity
+        auto& entity = m_entities.emplace_back(allocate_shared<Entity>(ComponentAllocator<Entity>(ComponentPool::GetEntities()), m_context));
         entity->SetActive(is_active);
+        m_entity_index_by_id[entity->GetId()] = static_cast<uint32_t>(m_entities.size() - 1);
         return entity;
     }
 
@@ -285,6 +346,7 @@ namespace Spartan
 		if (!entity)
 			return empty;
 
+        m_entity_index_by_id[entity->GetId()] = static_cast<uint32_t>(m_entities.size());
 		return m_entities.emplace_back(entity);
 	}
 
@@ -303,7 +365,11 @@ namespace Spartan
 
         // Mark for destruction but don't delete now
 	    // as the Renderer might still be using it.
-        entity->MarkForDestruction();
+        if (!entity->IsPendingDestruction())
+        {
+            entity->MarkForDestruction();
+            m_entities_pending_destruction.emplace_back(entity);
+        }
         m_is_dirty = true;
 	}
 
@@ -321,12 +387,20 @@ namespace Spartan
 		return root_entities;
 	}
 
-	const shared_ptr<Entity>& World::EntityGetByName(const string& name)
+	const shared_ptr<Entity>& World::EntityGetByName(const StringId name)
 	{
-		for (const auto& entity : m_entities)
+        // Names are indexed on the first lookup and re-validated on every one after that, since entities get renamed all the time
+        const auto it = m_entity_index_by_name.find(name);
+        if (it != m_entity_index_by_name.end() && it->second < m_entities.size() && m_entities[it->second]->GetNameId() == name)
+            return m_entities[it->second];
+
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_entities.size()); i++)
 		{
-			if (entity->GetName() == name)
-				return entity;
+			if (m_entities[i]->GetNameId() == name)
+            {
+                m_entity_index_by_name[name] = i;
+				return m_entities[i];
+            }
 		}
 
         static shared_ptr<Entity> empty;
@@ -335,11 +409,9 @@ namespace Spartan
 
 	const shared_ptr<Entity>& World::EntityGetById(const uint32_t id)
 	{
-		for (const auto& entity : m_entities)
-		{
-			if (entity->GetId() == id)
-				return entity;
-		}
+        const int32_t index = EntityGetIndex(id);
+        if (index != -1)
+            return m_entities[index];
 
         static shared_ptr<Entity> empty;
 		return empty;
@@ -358,16 +430,23 @@ namespace Spartan
         // Keep a reference to it's parent (in case it has one)
         auto parent = entity->GetTransform()->GetParent();
 
-        // Remove this entity
-        for (auto it = m_entities.begin(); it < m_entities.end();)
+        // The renderer might still be recording a frame that draws this entity, let it hold on to it until then
+        if (Renderer* renderer = m_context->GetSubsystem<Renderer>())
+        {
+            renderer->RegistryRelease(entity);
+        }
+
+        // Remove this entity, the last entity takes its place (so nothing else moves)
+        const int32_t index = EntityGetIndex(entity->GetId());
+        if (index != -1)
         {
-            const auto temp = *it;
-            if (temp->GetId() == entity->GetId())
+            if (index != static_cast<int32_t>(m_entities.size()) - 1)
             {
-                it = m_entities.erase(it);
-                break;
+                m_entities[index] = std::move(m_entities.back());
+                m_entity_index_by_id[m_entities[index]->GetId()] = static_cast<uint32_t>(index);
             }
-            ++it;
+            m_entities.pop_back();
+            m_entity_index_by_id.erase(entity->GetId());
         }
 
         // If there was a parent, update it
@@ -375,6 +454,424 @@ namespace Spartan
         {
             parent->AcquireChildren();
         }
+
+        m_component_lists_dirty = true;
+    }
+
+    void World::EntitiesRemovePending()
+    {
+        // Removing an entity marks its descendants, which are appended and removed in the same pass
+        for (size_t i = 0; i < m_entities_pending_destruction.size(); i++)
+        {
+            const shared_ptr<Entity> entity = m_entities_pending_destruction[i];
+            _EntityRemove(entity);
+        }
+        m_entities_pending_destruction.clear();
+    }
+
+    int32_t World::EntityGetIndex(const uint32_t id)
+    {
+        const auto it = m_entity_index_by_id.find(id);
+        if (it != m_entity_index_by_id.end() && it->second < m_entities.size() && m_entities[it->second]->GetId() == id)
+            return static_cast<int32_t>(it->second);
+
+        // The id can be new to the index, loading for example assigns ids after the entities are created
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_entities.size()); i++)
+        {
+            if (m_entities[i]->GetId() == id)
+            {
+                m_entity_index_by_id[id] = i;
+                return static_cast<int32_t>(i);
+            }
+        }
+
+        return -1;
+    }
+
+    void World::UpdateComponentLists()
+    {
+        for (vector<IComponent*>& components : m_components_tickable)
+        {
+            components.clear();
+        }
+        m_components_startable.clear();
+        m_components_stoppable.clear();
+        m_transform_roots.clear();
+
+        for (const auto& entity : m_entities)
+        {
+            if (Transform* transform = entity->GetTransform())
+            {
+                if (transform->IsRoot())
+                {
+                    m_transform_roots.emplace_back(transform);
+                }
+            }
+
+            // Inactive entities start and stop along with the rest, but don't tick
+            for (const auto& component : entity->GetAllComponents())
+            {
+                if (component->HasPhase(ComponentPhase_Start))
+                {
+                    m_components_startable.emplace_back(component.get());
+                }
+
+                if (component->HasPhase(ComponentPhase_Stop))
+                {
+                    m_components_stoppable.emplace_back(component.get());
+                }
+
+                if (component->IsTickable() && entity->IsActive() && component->GetType() < ComponentType_Unknown)
+                {
+                    m_components_tickable[component->GetType()].emplace_back(component.get());
+                }
+            }
+        }
+
+        m_component_lists_dirty = false;
+    }
+
+    void World::ScriptsTick(float delta_time)
+    {
+        const vector<IComponent*>& scripts = m_components_tickable[ComponentType_Script];
+        if (scripts.empty())
+            return;
+
+        m_scripts_due.clear();
+        bool parallel = false;
+        for (IComponent* component : scripts)
+        {
+            if (!component->GetEntity()->IsActive())
+                continue;
+
+            ScriptInstance* instance = static_cast<Script*>(component)->GetScriptInstance();
+            if (instance && instance->IsInstantiated())
+            {
+                m_scripts_due.emplace_back(instance);
+                parallel = parallel || instance->GetParallelUpdateFunction() != nullptr;
+            }
+        }
+
+        // ParallelUpdate() reads transforms from worker threads, a dirty one would compute its matrices on several of them at once
+        if (parallel)
+        {
+            TransformsUpdate(0);
+        }
+
+        m_context->GetSubsystem<Scripting>()->ExecuteUpdates(m_scripts_due, delta_time);
+    }
+
+    void World::TransformsUpdate(const uint64_t step_index)
+    {
+        // A thread per root
+        m_context->GetSubsystem<Threading>()->ParallelFor([this, step_index](uint32_t index_start, uint32_t index_end)
+        {
+            for (uint32_t i = index_start; i < index_end; i++)
+            {
+                // A transform which got a parent since the lists were made, updates along with its new root
+                if (m_transform_roots[i]->IsRoot())
+                {
+                    m_transform_roots[i]->UpdateHierarchy();
+
+                    if (step_index != 0)
+                    {
+                        m_transform_roots[i]->OnFixedStep(step_index);
+                    }
+                }
+            }
+        }, static_cast<uint32_t>(m_transform_roots.size()));
+    }
+
+    void World::AnimatorsTick()
+    {
+        const vector<IComponent*>& animators = m_components_tickable[ComponentType_Animator];
+        if (animators.empty())
+            return;
+
+        // Pick the animators to sample, round robin from where the last tick stopped, so that every one gets its turn when a crowd is over budget
+        m_animators_due.clear();
+        uint32_t channel_budget     = _World::animator_channels_per_tick;
+        const auto animator_count   = static_cast<uint32_t>(animators.size());
+        m_animator_cursor           = m_animator_cursor < animator_count ? m_animator_cursor : 0;
+        for (uint32_t i = 0; i < animator_count; i++)
+        {
+            auto animator = static_cast<Animator*>(animators[(m_animator_cursor + i) % animator_count]);
+            if (!animator->GetEntity()->IsActive() || !animator->IsPoseDirty())
+                continue;
+
+            // The first one always fits, so that a single huge animator isn't starved
+            const uint32_t channel_count = animator->GetChannelCount();
+            if (channel_count > channel_budget && !m_animators_due.empty())
+            {
+                m_animator_cursor = (m_animator_cursor + i) % animator_count;
+                break;
+            }
+
+            channel_budget -= min(channel_count, channel_budget);
+            m_animators_due.emplace_back(animator);
+        }
+
+        // Sampling only writes to the animators, so they go wide, while writing the poses to the transforms is serial (siblings share their ancestors' dirty flags)
+        m_context->GetSubsystem<Threading>()->ParallelFor([this](uint32_t index_start, uint32_t index_end)
+        {
+            for (uint32_t i = index_start; i < index_end; i++)
+            {
+                m_animators_due[i]->UpdatePose();
+            }
+        }, static_cast<uint32_t>(m_animators_due.size()));
+
+        for (Animator* animator : m_animators_due)
+        {
+            animator->ApplyPose();
+        }
+    }
+
+    void World::StreamingTick()
+    {
+        const shared_ptr<Camera>& camera = m_context->GetSubsystem<Renderer>()->GetCamera();
+        if (!camera)
+            return;
+
+        const Vector3 position = camera->GetTransform()->GetPosition();
+
+        // Cells which are done reading or are still deserializing share a budget of roots per tick
+        uint32_t root_budget = _World::cell_roots_per_tick;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_cells.size()); i++)
+        {
+            World_Cell& cell = m_cells[i];
+
+            // Distance from the camera to the closest point of the cell, on the xz plane
+            const float x_min       = static_cast<float>(cell.x) * _World::cell_size;
+            const float z_min       = static_cast<float>(cell.z) * _World::cell_size;
+            const float dx          = Helper::Max(Helper::Max(x_min - position.x, position.x - (x_min + _World::cell_size)), 0.0f);
+            const float dz          = Helper::Max(Helper::Max(z_min - position.z, position.z - (z_min + _World::cell_size)), 0.0f);
+            const float distance    = Helper::Sqrt(dx * dx + dz * dz);
+
+            if (cell.state == World_Cell_Unloaded && distance < _World::cell_load_distance)
+            {
+                CellLoadBegin(i);
+            }
+            else if (cell.state == World_Cell_Loaded && distance > _World::cell_unload_distance)
+            {
+                CellUnload(i);
+            }
+            else if ((cell.state == World_Cell_Reading || cell.state == World_Cell_Deserializing) && root_budget != 0)
+            {
+                root_budget -= CellLoadStep(i, root_budget);
+            }
+        }
+    }
+
+    void World::CellLoadBegin(const uint32_t index)
+    {
+        World_Cell& cell = m_cells[index];
+
+        // The disk is touched on the background pool only, the cell isn't moved or removed before the task is done (see CellsClear())
+        cell.state  = World_Cell_Reading;
+        cell.task   = m_context->GetSubsystem<Threading>()->AddTask([this, index]()
+        {
+            World_Cell& cell = m_cells[index];
+            cell.stream = make_shared<FileStream>(cell.file_path, FileStream_Read | FileStream_Memory);
+        }, {}, Threading_Pool_Background);
+    }
+
+    uint32_t World::CellLoadStep(const uint32_t index, const uint32_t root_budget)
+    {
+        World_Cell& cell = m_cells[index];
+
+        if (cell.state == World_Cell_Reading)
+        {
+            if (!cell.task->IsDone())
+                return 0;
+
+            cell.task = nullptr;
+
+            if (!cell.stream->IsOpen())
+            {
+                LOG_ERROR("Failed to load cell %d, %d", cell.x, cell.z);
+                cell.stream = nullptr;
+                cell.state  = World_Cell_Loaded; // as good as it gets, it won't be tried again until it unloads
+                return 0;
+            }
+
+            // Same layout as the world file, the roots are created (inactive) up front and deserialized over the next ticks
+            const uint32_t root_count = cell.stream->ReadAs<uint32_t>();
+            cell.roots_pending.reserve(root_count);
+            for (uint32_t i = 0; i < root_count; i++)
+            {
+                shared_ptr<Entity> entity = EntityCreate(false);
+                entity->SetId(cell.stream->ReadAs<uint32_t>());
+                cell.root_ids.emplace_back(entity->GetId());
+                cell.roots_pending.emplace_back(entity);
+            }
+
+            // Deserialization goes in order
+            reverse(cell.roots_pending.begin(), cell.roots_pending.end());
+            cell.state = World_Cell_Deserializing;
+        }
+
+        uint32_t roots_done = 0;
+        while (roots_done < root_budget && !cell.roots_pending.empty())
+        {
+            cell.roots_pending.back()->Deserialize(cell.stream.get(), nullptr);
+            cell.roots_pending.pop_back();
+            roots_done++;
+        }
+
+        if (cell.roots_pending.empty())
+        {
+            cell.stream = nullptr;
+            cell.state  = World_Cell_Loaded;
+            m_is_dirty  = true;
+            FIRE_EVENT_DATA(Event_World_Cell_Loaded, index);
+        }
+
+        return roots_done;
+    }
+
+    void World::CellUnload(const uint32_t index)
+    {
+        World_Cell& cell = m_cells[index];
+
+        // Removal is deferred, like any other, as the renderer might be using the entities
+        for (const uint32_t id : cell.root_ids)
+        {
+            EntityRemove(EntityGetById(id));
+        }
+
+        cell.root_ids.clear();
+        cell.state = World_Cell_Unloaded;
+        FIRE_EVENT_DATA(Event_World_Cell_Unloaded, index);
+    }
+
+    void World::CellsLoadAll()
+    {
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_cells.size()); i++)
+        {
+            World_Cell& cell = m_cells[i];
+
+            if (cell.state == World_Cell_Unloaded)
+            {
+                cell.state  = World_Cell_Reading;
+                cell.task   = m_context->GetSubsystem<Threading>()->AddTask([this, i]()
+                {
+                    m_cells[i].stream = make_shared<FileStream>(m_cells[i].file_path, FileStream_Read | FileStream_Memory);
+                }, {}, Threading_Pool_Background);
+            }
+
+            if (cell.task)
+            {
+                m_context->GetSubsystem<Threading>()->Wait(cell.task);
+            }
+
+            while (cell.state != World_Cell_Loaded)
+            {
+                CellLoadStep(i, numeric_limits<uint32_t>::max());
+            }
+        }
+
+        // Entities of cells which unloaded but didn't resolve yet, would otherwise be saved twice
+        EntitiesRemovePending();
+    }
+
+    void World::CellsClear()
+    {
+        // The reading tasks write to their cells
+        for (World_Cell& cell : m_cells)
+        {
+            if (cell.task)
+            {
+                m_context->GetSubsystem<Threading>()->Wait(cell.task);
+            }
+        }
+
+        m_cells.clear();
+    }
+
+    bool World::CellsSave(const string& directory, vector<shared_ptr<Entity>>& roots)
+    {
+        // Start from scratch, the entities could have moved to other cells since they were loaded
+        FileSystem::Delete(directory);
+        if (!FileSystem::CreateDirectory_(directory))
+        {
+            LOG_ERROR("Failed to create \"%s\"", directory.c_str());
+            return false;
+        }
+
+        // Partition the roots, ordered so that the cells are saved in the same order every time
+        map<pair<int32_t, int32_t>, vector<shared_ptr<Entity>>> cells;
+        for (auto it = roots.begin(); it != roots.end();)
+        {
+            const shared_ptr<Entity>& entity = *it;
+            if (entity->HasComponent<Camera>() || entity->HasComponent<Light>() || entity->HasComponent<Environment>())
+            {
+                ++it;
+                continue;
+            }
+
+            const Vector3 position  = entity->GetTransform()->GetPosition();
+            const int32_t x         = static_cast<int32_t>(floor(position.x / _World::cell_size));
+            const int32_t z         = static_cast<int32_t>(floor(position.z / _World::cell_size));
+            cells[make_pair(x, z)].emplace_back(entity);
+            it = roots.erase(it);
+        }
+
+        // Every cell gets a file, with the same layout as the world file
+        m_cells.clear();
+        for (const auto& it : cells)
+        {
+            World_Cell& cell    = m_cells.emplace_back();
+            cell.x              = it.first.first;
+            cell.z              = it.first.second;
+            cell.file_path      = directory + "/" + to_string(cell.x) + "_" + to_string(cell.z) + _World::cell_extension;
+            cell.state          = World_Cell_Loaded;
+
+            auto file = make_unique<FileStream>(cell.file_path, FileStream_Write);
+            if (!file->IsOpen())
+            {
+                LOG_ERROR("Failed to save cell %d, %d", cell.x, cell.z);
+                return false;
+            }
+
+            file->Write(static_cast<uint32_t>(it.second.size()));
+            for (const auto& root : it.second)
+            {
+                file->Write(root->GetId());
+                cell.root_ids.emplace_back(root->GetId());
+            }
+
+            for (const auto& root : it.second)
+            {
+                root->Serialize(file.get());
+            }
+        }
+
+        return true;
+    }
+
+    void World::CellsAcquire(const string& directory)
+    {
+        m_cells.clear();
+        m_streaming = FileSystem::IsDirectory(directory);
+        if (!m_streaming)
+            return;
+
+        // The coordinates of a cell are its file name
+        for (const string& file_path : FileSystem::GetFilesInDirectory(directory))
+        {
+            if (FileSystem::GetExtensionFromFilePath(file_path) != _World::cell_extension)
+                continue;
+
+            const string name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
+            const size_t separator = name.find('_');
+            if (separator == string::npos)
+                continue;
+
+            World_Cell& cell    = m_cells.emplace_back();
+            cell.x              = stoi(name.substr(0, separator));
+            cell.z              = stoi(name.substr(separator + 1));
+            cell.file_path      = file_path;
+        }
     }
 
 	shared_ptr<Entity>& World::CreateEnvironment()
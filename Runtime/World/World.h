@@ -23,18 +23,28 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ==================
 #include <vector>
+#include <array>
+#include <unordered_map>
 #include <memory>
 #include <string>
 #include "../Core/EngineDefs.h"
 #include "../Core/ISubsystem.h"
+#include "../Core/StringId.h"
+#include "Components/IComponent.h"
 //=============================
 
 namespace Spartan
 {
 	class Entity;
 	class Light;
+	class Animator;
+	class ScriptInstance;
+	class Transform;
 	class Input;
 	class Profiler;
+	class Timer;
+	class Task;
+	class FileStream;
 
 	enum Scene_State
 	{
@@ -44,6 +54,35 @@ namespace Spartan
 		Loading
 	};
 
+	enum World_Cell_State
+	{
+		World_Cell_Unloaded,
+		World_Cell_Reading,		// the file is read into memory, on the background pool
+		World_Cell_Deserializing,	// the entities are created, a few every tick
+		World_Cell_Loaded
+	};
+
+	// A part of a streamed world, the root entities whose position falls in a square of the xz plane (along with their descendants)
+	struct World_Cell
+	{
+		int32_t x = 0;
+		int32_t z = 0;
+		std::string file_path;
+		World_Cell_State state = World_Cell_Unloaded;
+		std::vector<uint32_t> root_ids;						// the roots which the cell created, while it's loaded
+		std::shared_ptr<Task> task;							// reads the file
+		std::shared_ptr<FileStream> stream;					// the file, in memory
+		std::vector<std::shared_ptr<Entity>> roots_pending;	// created but not yet deserialized
+	};
+
+	// A part of the world file, the root entities whose id falls in it (along with their descendants)
+	struct World_Chunk
+	{
+		uint64_t hash	= 0;				// of the image, as of the last save
+		uint64_t offset	= 0;				// where the chunk is in the file
+		uint64_t size	= 0;				// 0 for a chunk without entities
+	};
+
 	class SPARTAN_CLASS World : public ISubsystem
 	{
 	public:
@@ -61,13 +100,22 @@ namespace Spartan
 		const auto& GetName() const { return m_name; }
         void MakeDirty() { m_is_dirty = true; }
 
+        // Streaming, saving partitions the world into cells which load and unload asynchronously by their distance to the camera.
+        // Cameras, lights and environments stay in the world file. A world which has cells streams when it's loaded.
+        void SetStreaming(const bool streaming) { m_streaming = streaming; }
+        bool GetStreaming() const               { return m_streaming; }
+        const auto& GetCells() const            { return m_cells; }
+
+        // While a world file is loading, transforms don't attach to their parents by themselves (the world links them in one pass at the end)
+        bool IsHierarchyLinkDeferred() const    { return m_hierarchy_link_deferred; }
+
 		//= Entities ===========================================================================
 		std::shared_ptr<Entity>& EntityCreate(bool is_active = true);
 		std::shared_ptr<Entity>& EntityAdd(const std::shared_ptr<Entity>& entity);
 		bool EntityExists(const std::shared_ptr<Entity>& entity);
 		void EntityRemove(const std::shared_ptr<Entity>& entity);	
 		std::vector<std::shared_ptr<Entity>> EntityGetRoots();
-		const std::shared_ptr<Entity>& EntityGetByName(const std::string& name);
+		const std::shared_ptr<Entity>& EntityGetByName(StringId name);
 		const std::shared_ptr<Entity>& EntityGetById(uint32_t id);
 		const auto& EntityGetAll() const    { return m_entities; }
 		auto EntityGetCount() const         { return static_cast<uint32_t>(m_entities.size()); }
@@ -75,6 +123,36 @@ namespace Spartan
 
 	private:
         void _EntityRemove(const std::shared_ptr<Entity>& entity);
+        void EntitiesRemovePending();
+        void UpdateComponentLists();
+        void AnimatorsTick();
+        void ScriptsTick(float delta_time);
+        // Computes the dirty transforms, and records them for the given fixed step (unless it's 0)
+        void TransformsUpdate(uint64_t step_index);
+        int32_t EntityGetIndex(const uint32_t id);
+
+        //= BLOCKS ===========================================================================
+        // The world file is a table of chunks, each of which is an image: a table of contents followed by blocks, one for the entities
+        // and one per component type. It's read in one go, the blocks decode in parallel and the component types which allow it deserialize in parallel.
+        // A save appends only the chunks whose image changed, the write runs in the background (see World_Chunk).
+        bool BlocksSave(const std::string& file_path, const std::vector<std::shared_ptr<Entity>>& roots);
+        bool BlocksLoad(const std::string& file_path);
+        bool BlocksLoadImage(const std::byte* image, uint64_t size, const std::string& file_path);
+        void BlocksPartition(const std::vector<std::shared_ptr<Entity>>& roots, std::vector<std::vector<std::shared_ptr<Entity>>>* chunk_roots) const;
+        void BlocksWait();
+        static bool BlocksIsFile(const std::string& file_path);
+        //====================================================================================
+
+        //= STREAMING ===================================================
+        void StreamingTick();
+        void CellLoadBegin(uint32_t index);
+        uint32_t CellLoadStep(uint32_t index, uint32_t root_budget); // returns the number of roots it deserialized
+        void CellUnload(uint32_t index);
+        void CellsLoadAll();
+        void CellsClear();
+        bool CellsSave(const std::string& directory, std::vector<std::shared_ptr<Entity>>& roots);
+        void CellsAcquire(const std::string& directory);
+        //===============================================================
 
 		//= COMMON ENTITY CREATION ========================
 		std::shared_ptr<Entity>& CreateEnvironment();
@@ -88,7 +166,41 @@ namespace Spartan
         Scene_State m_state         = Ticking;	
         Input* m_input              = nullptr;
         Profiler* m_profiler        = nullptr;
+        Timer* m_timer              = nullptr;
 
         std::vector<std::shared_ptr<Entity>> m_entities;
+        // Entities which EntityRemove() marked, they are removed on the next resolve (the renderer might still be using them)
+        std::vector<std::shared_ptr<Entity>> m_entities_pending_destruction;
+
+        // Indices into m_entities (ids and names can change without the world knowing, so every hit is validated and a miss falls back to a search)
+        std::unordered_map<uint32_t, uint32_t> m_entity_index_by_id;
+        std::unordered_map<StringId, uint32_t> m_entity_index_by_name;
+
+        // Components of active entities which override OnTick(), grouped by type so that each type ticks in one go (instead of entity by entity)
+        std::array<std::vector<IComponent*>, ComponentType_Unknown> m_components_tickable;
+        // Components which override OnStart() and OnStop(), the rest aren't called when the simulation starts or stops
+        std::vector<IComponent*> m_components_startable;
+        std::vector<IComponent*> m_components_stoppable;
+        // The root of every transform hierarchy, they update in parallel
+        std::vector<Transform*> m_transform_roots;
+        bool m_component_lists_dirty = true;
+
+        // Animators which are sampled this tick and where the next tick starts picking them
+        std::vector<Animator*> m_animators_due;
+        uint32_t m_animator_cursor = 0;
+
+        // Script instances which update this tick
+        std::vector<ScriptInstance*> m_scripts_due;
+
+        // Streaming
+        std::vector<World_Cell> m_cells;
+        bool m_streaming = false;
+
+        // Blocks
+        bool m_hierarchy_link_deferred = false;
+        std::vector<World_Chunk> m_chunks;      // as the file at m_chunks_file_path has them
+        std::string m_chunks_file_path;         // empty if the next save has to write every chunk
+        uint64_t m_chunks_file_size = 0;
+        std::shared_ptr<Task> m_chunks_write;   // the background write of the last save
 	};
 }
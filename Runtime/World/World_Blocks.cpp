@@ -0,0 +1,687 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================
+#include "World.h"
+#include "Entity.h"
+#include "Prefab.h"
+#include "Components/Transform.h"
+#include "../Resource/ResourceCache.h"
+#include "../Resource/ProgressReport.h"
+#include "../IO/FileStream.h"
+#include "../Threading/Threading.h"
+#include "../Core/FileSystem.h"
+#include <fstream>
+#include <cstring>
+#include <string_view>
+//=====================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+// Layout of a world file:
+//  header:     magic, version (2), chunk count
+//  chunks:     offset and size of every chunk (the offsets are from the start of the file, a chunk without entities has a size of 0)
+//  data:       the images of the chunks, in no particular order and with the ones which later saves replaced in between
+//
+// Layout of an image (worlds saved before the chunks are a single one):
+//  header:     magic, version (1), block count
+//  contents:   kind, item count, offset and size of every block (the offsets are relative to the end of the contents)
+//  blocks:     the entity block (the entities depth first, with the index of their parent), then a block per component type
+//              (the entity index, id and prefab flag of every component, followed by the offset of each component's data and the data)
+
+namespace Spartan
+{
+    namespace _World_Blocks
+    {
+        static const uint32_t magic             = 0x42575053; // "SPWB"
+        static const uint32_t version           = 1;
+        static const uint32_t version_chunked   = 2;
+        static const uint32_t kind_entities     = ComponentType_Unknown; // component blocks use their component type as their kind
+
+        // Roots go to a chunk by their id, so an entity stays in the same chunk from save to save (and an edit only rewrites its chunk)
+        static const uint32_t chunk_count           = 64;
+        static const uint64_t chunk_table_offset    = 3 * sizeof(uint32_t);
+        static const uint64_t chunk_data_offset     = chunk_table_offset + chunk_count * 2 * sizeof(uint64_t);
+
+        // The only component whose Deserialize() touches nothing but itself (once the hierarchy is deferred),
+        // the others create physics bodies, GPU resources or load assets, and those deserialize on the calling thread
+        static bool is_parallel(const ComponentType type) { return type == ComponentType_Transform; }
+
+        struct Block
+        {
+            uint32_t kind   = 0;
+            uint32_t count  = 0;
+            uint64_t offset = 0;
+            uint64_t size   = 0;
+        };
+
+        struct Block_Entity
+        {
+            uint32_t id             = 0;
+            bool is_active          = true;
+            bool is_visible         = true;
+            std::string name;
+            int32_t parent          = -1;
+            std::string prefab_path;
+            uint32_t prefab_node    = 0;
+        };
+
+        struct Block_Decoded
+        {
+            uint32_t kind = 0;
+            std::vector<Block_Entity> entities;
+            std::vector<uint32_t> entity_indices;
+            std::vector<uint32_t> ids;
+            std::vector<unsigned char> from_prefab;
+            std::vector<uint32_t> offsets; // into records, one more than there are components
+            const std::byte* records    = nullptr; // straight out of the file's mapping
+            uint32_t records_size       = 0;
+            std::vector<IComponent*> components;
+        };
+
+        template <typename T>
+        static T read(const std::byte*& data)
+        {
+            T value;
+            memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return value;
+        }
+
+        template <typename T>
+        static void write(string& data, const T& value)
+        {
+            data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        static bool decode(const std::byte* data, const Block& block, Block_Decoded& decoded)
+        {
+            decoded.kind = block.kind;
+
+            FileStream stream(data + block.offset, static_cast<size_t>(block.size));
+
+            if (block.kind == kind_entities)
+            {
+                decoded.entities.resize(stream.ReadAs<uint32_t>());
+                for (Block_Entity& entity : decoded.entities)
+                {
+                    stream.Read(&entity.id);
+                    stream.Read(&entity.is_active);
+                    stream.Read(&entity.is_visible);
+                    stream.Read(&entity.name);
+                    stream.Read(&entity.parent);
+                    stream.Read(&entity.prefab_path);
+                    if (!entity.prefab_path.empty())
+                    {
+                        stream.Read(&entity.prefab_node);
+                    }
+                }
+
+                return true;
+            }
+
+            stream.Read(&decoded.entity_indices);
+            stream.Read(&decoded.ids);
+            stream.Read(&decoded.from_prefab);
+            stream.Read(&decoded.offsets);
+            decoded.records = stream.ReadSpan<std::byte>(&decoded.records_size);
+
+            const size_t count = decoded.entity_indices.size();
+            if (decoded.ids.size() != count || decoded.from_prefab.size() != count || decoded.offsets.size() != count + 1 || decoded.offsets.back() > decoded.records_size)
+                return false;
+
+            decoded.components.resize(count, nullptr);
+            return true;
+        }
+
+        // Depth first, so that parents come before their children (and children keep their order)
+        static void gather(Entity* entity, const int32_t parent, vector<Entity*>& entities, vector<int32_t>& parents)
+        {
+            const auto index = static_cast<int32_t>(entities.size());
+            entities.emplace_back(entity);
+            parents.emplace_back(parent);
+
+            for (Transform* child : entity->GetTransform()->GetChildren())
+            {
+                if (child->GetEntity())
+                {
+                    gather(child->GetEntity(), index, entities, parents);
+                }
+            }
+        }
+
+        static void encode(const vector<shared_ptr<Entity>>& roots, string& image)
+        {
+            vector<Entity*> entities;
+            vector<int32_t> parents;
+            for (const auto& root : roots)
+            {
+                gather(root.get(), -1, entities, parents);
+            }
+
+            vector<_World_Blocks::Block> contents;
+            vector<string> blocks;
+
+            // Entities
+            {
+                string& block = blocks.emplace_back();
+                {
+                    FileStream stream(&block, FileStream_Write);
+                    stream.Write(static_cast<uint32_t>(entities.size()));
+                    for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+                    {
+                        Entity* entity = entities[i];
+                        stream.Write(entity->GetId());
+                        stream.Write(entity->IsActive());
+                        stream.Write(entity->IsVisibleInHierarchy());
+                        stream.Write(entity->GetName());
+                        stream.Write(parents[i]);
+                        stream.Write(entity->GetPrefab() ? entity->GetPrefab()->GetResourceFilePathNative() : string());
+                        if (entity->GetPrefab())
+                        {
+                            stream.Write(entity->GetPrefabNode());
+                        }
+                    }
+                }
+
+                contents.push_back({ _World_Blocks::kind_entities, static_cast<uint32_t>(entities.size()), 0, 0 });
+            }
+
+            // Components, the transforms go first since every other type can depend on them
+            vector<ComponentType> types = { ComponentType_Transform };
+            for (uint32_t type = 0; type < ComponentType_Unknown; type++)
+            {
+                if (type != ComponentType_Transform)
+                {
+                    types.emplace_back(static_cast<ComponentType>(type));
+                }
+            }
+
+            for (const ComponentType type : types)
+            {
+                vector<uint32_t> entity_indices;
+                vector<uint32_t> ids;
+                vector<unsigned char> from_prefab;
+                vector<uint32_t> offsets;
+                string records;
+
+                for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+                {
+                    for (const auto& component : entities[i]->GetAllComponents())
+                    {
+                        if (component->GetType() != type)
+                            continue;
+
+                        string data;
+                        {
+                            FileStream stream(&data, FileStream_Write);
+                            component->Serialize(&stream);
+                        }
+
+                        // Components of prefab instances which match the prefab have no data
+                        const string* data_prefab   = entities[i]->GetPrefabComponentData(component.get());
+                        const bool is_from_prefab   = data_prefab && *data_prefab == data;
+
+                        entity_indices.emplace_back(i);
+                        ids.emplace_back(component->GetId());
+                        from_prefab.emplace_back(is_from_prefab ? 1 : 0);
+                        offsets.emplace_back(static_cast<uint32_t>(records.size()));
+                        if (!is_from_prefab)
+                        {
+                            records += data;
+                        }
+                    }
+                }
+
+                if (entity_indices.empty())
+                    continue;
+
+                offsets.emplace_back(static_cast<uint32_t>(records.size()));
+
+                string& block = blocks.emplace_back();
+                {
+                    FileStream stream(&block, FileStream_Write);
+                    stream.Write(entity_indices);
+                    stream.Write(ids);
+                    stream.Write(from_prefab);
+                    stream.Write(offsets);
+                    stream.Write(records);
+                }
+
+                contents.push_back({ static_cast<uint32_t>(type), static_cast<uint32_t>(entity_indices.size()), 0, 0 });
+            }
+
+            // Header and contents
+            _World_Blocks::write(image, _World_Blocks::magic);
+            _World_Blocks::write(image, _World_Blocks::version);
+            _World_Blocks::write(image, static_cast<uint32_t>(contents.size()));
+
+            uint64_t offset = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(contents.size()); i++)
+            {
+                contents[i].offset  = offset;
+                contents[i].size    = blocks[i].size();
+                offset             += blocks[i].size();
+
+                _World_Blocks::write(image, contents[i].kind);
+                _World_Blocks::write(image, contents[i].count);
+                _World_Blocks::write(image, contents[i].offset);
+                _World_Blocks::write(image, contents[i].size);
+            }
+
+            for (const string& block : blocks)
+            {
+                image += block;
+            }
+        }
+
+        // Chunks are compared by the hash of their image, so whatever changed in any component is picked up
+        static uint64_t hash(const char* image, const uint64_t size)
+        {
+            return static_cast<uint64_t>(std::hash<string_view>{}(string_view(image, static_cast<size_t>(size))));
+        }
+    }
+
+    bool World::BlocksIsFile(const string& file_path)
+    {
+        ifstream file(file_path, ios::in | ios::binary);
+        uint32_t magic = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        return file.good() && magic == _World_Blocks::magic;
+    }
+
+    void World::BlocksPartition(const vector<shared_ptr<Entity>>& roots, vector<vector<shared_ptr<Entity>>>* chunk_roots) const
+    {
+        chunk_roots->assign(_World_Blocks::chunk_count, vector<shared_ptr<Entity>>());
+        for (const auto& root : roots)
+        {
+            (*chunk_roots)[root->GetId() % _World_Blocks::chunk_count].emplace_back(root);
+        }
+    }
+
+    void World::BlocksWait()
+    {
+        if (m_chunks_write)
+        {
+            m_context->GetSubsystem<Threading>()->Wait(m_chunks_write);
+            m_chunks_write = nullptr;
+        }
+    }
+
+    bool World::BlocksSave(const string& file_path, const vector<shared_ptr<Entity>>& roots)
+    {
+        // The chunk table of the previous save is what this one starts from
+        BlocksWait();
+
+        vector<vector<shared_ptr<Entity>>> chunk_roots;
+        BlocksPartition(roots, &chunk_roots);
+
+        // Every chunk is written again if the file isn't the one which the chunks are of (or something else changed it),
+        // or if the chunks which later saves replaced take up more of it than the live ones
+        uint64_t size_live = 0;
+        for (const World_Chunk& chunk : m_chunks)
+        {
+            size_live += chunk.size;
+        }
+        const bool full =
+            m_chunks.size() != _World_Blocks::chunk_count ||
+            file_path != m_chunks_file_path ||
+            FileSystem::GetFileSize(file_path) != m_chunks_file_size ||
+            m_chunks_file_size - _World_Blocks::chunk_data_offset > size_live * 2;
+
+        if (full)
+        {
+            m_chunks.assign(_World_Blocks::chunk_count, World_Chunk());
+            m_chunks_file_size = _World_Blocks::chunk_data_offset;
+        }
+
+        // Encode every chunk now and keep the ones which changed, the write then works from this snapshot while the world goes on.
+        // Encoding is in memory, so it's the file write which this saves (and no change to a component can be missed).
+        const uint64_t append_offset = m_chunks_file_size;
+        vector<string> images;
+        string image;
+        for (uint32_t i = 0; i < _World_Blocks::chunk_count; i++)
+        {
+            World_Chunk& chunk = m_chunks[i];
+            if (chunk_roots[i].empty())
+            {
+                chunk = World_Chunk();
+                continue;
+            }
+
+            image.clear();
+            _World_Blocks::encode(chunk_roots[i], image);
+            const uint64_t hash = _World_Blocks::hash(image.data(), image.size());
+            if (!full && chunk.size != 0 && chunk.hash == hash)
+                continue;
+
+            chunk.hash          = hash;
+            chunk.offset        = m_chunks_file_size;
+            chunk.size          = image.size();
+            m_chunks_file_size += image.size();
+            images.emplace_back(move(image));
+        }
+        m_chunks_file_path = file_path;
+
+        string table;
+        _World_Blocks::write(table, _World_Blocks::magic);
+        _World_Blocks::write(table, _World_Blocks::version_chunked);
+        _World_Blocks::write(table, _World_Blocks::chunk_count);
+        for (const World_Chunk& chunk : m_chunks)
+        {
+            _World_Blocks::write(table, chunk.offset);
+            _World_Blocks::write(table, chunk.size);
+        }
+
+        // Appended, and the table is written last, so until then the file still describes the previous save
+        m_chunks_write = m_context->GetSubsystem<Threading>()->AddTask([this, file_path, full, append_offset, table = move(table), images = move(images)]()
+        {
+            fstream file(file_path, ios::in | ios::out | ios::binary | (full ? ios::trunc : ios::openmode()));
+            if (!file.is_open())
+            {
+                LOG_ERROR("Failed to open \"%s\" for writing", file_path.c_str());
+                m_chunks_file_path.clear();
+                return;
+            }
+
+            file.seekp(append_offset);
+            for (const string& image : images)
+            {
+                file.write(image.data(), image.size());
+            }
+
+            file.seekp(0);
+            file.write(table.data(), table.size());
+            file.flush();
+
+            if (!file.good())
+            {
+                LOG_ERROR("Failed to write \"%s\"", file_path.c_str());
+                m_chunks_file_path.clear();
+                return;
+            }
+
+            FIRE_EVENT(Event_World_Saved);
+        }, {}, Threading_Pool_Background);
+
+        return true;
+    }
+
+    bool World::BlocksLoad(const string& file_path)
+    {
+        // The blocks are decoded straight out of the file's mapping, which stays around until everything is deserialized
+        const uint64_t file_size = FileSystem::GetFileSize(file_path);
+        FileStream file(file_path, FileStream_Read | FileStream_Mapped);
+        const std::byte* data = file.IsOpen() && file.IsMemory() ? file.ReadSpan(static_cast<size_t>(file_size)) : nullptr;
+        if (!data || file_size < _World_Blocks::chunk_table_offset)
+        {
+            LOG_ERROR("Failed to open \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        const std::byte* header = data;
+        const uint32_t magic    = _World_Blocks::read<uint32_t>(header);
+        const uint32_t version  = _World_Blocks::read<uint32_t>(header);
+        const uint32_t count    = _World_Blocks::read<uint32_t>(header);
+        if (magic != _World_Blocks::magic)
+        {
+            LOG_ERROR("\"%s\" is not a world file", file_path.c_str());
+            return false;
+        }
+
+        m_chunks.clear();
+        m_chunks_file_path.clear();
+        m_chunks_file_size = 0;
+
+        // Saved before the chunks, a single image (the next save writes every chunk)
+        if (version == _World_Blocks::version)
+        {
+            ProgressReport::Get().SetJobCount(g_progress_world, 1);
+            if (!BlocksLoadImage(data, file_size, file_path))
+                return false;
+            ProgressReport::Get().IncrementJobsDone(g_progress_world);
+        }
+        else if (version == _World_Blocks::version_chunked)
+        {
+            if (count != _World_Blocks::chunk_count || file_size < _World_Blocks::chunk_data_offset)
+            {
+                LOG_ERROR("\"%s\" has an invalid chunk table", file_path.c_str());
+                return false;
+            }
+
+            vector<World_Chunk> chunks(count);
+            for (World_Chunk& chunk : chunks)
+            {
+                chunk.offset    = _World_Blocks::read<uint64_t>(header);
+                chunk.size      = _World_Blocks::read<uint64_t>(header);
+                if (chunk.size != 0 && (chunk.offset < _World_Blocks::chunk_data_offset || chunk.offset + chunk.size < chunk.offset || chunk.offset + chunk.size > file_size))
+                {
+                    LOG_ERROR("\"%s\" has an invalid chunk", file_path.c_str());
+                    return false;
+                }
+            }
+
+            ProgressReport::Get().SetJobCount(g_progress_world, count);
+            for (const World_Chunk& chunk : chunks)
+            {
+                if (chunk.size != 0 && !BlocksLoadImage(data + chunk.offset, chunk.size, file_path))
+                    return false;
+
+                ProgressReport::Get().IncrementJobsDone(g_progress_world);
+            }
+
+            // Hashed as loaded, so that the next save only writes the chunks which change from here on
+            for (World_Chunk& chunk : chunks)
+            {
+                chunk.hash = chunk.size != 0 ? _World_Blocks::hash(reinterpret_cast<const char*>(data + chunk.offset), chunk.size) : 0;
+            }
+
+            m_chunks            = move(chunks);
+            m_chunks_file_path  = file_path;
+            m_chunks_file_size  = file_size;
+        }
+        else
+        {
+            LOG_ERROR("\"%s\" is of version %d, expected %d", file_path.c_str(), version, _World_Blocks::version_chunked);
+            return false;
+        }
+
+        FIRE_EVENT_DEFERRED(Event_World_Resolve_Pending);
+
+        return true;
+    }
+
+    bool World::BlocksLoadImage(const std::byte* image, const uint64_t size, const string& file_path)
+    {
+        FileStream file(image, static_cast<size_t>(size));
+
+        // Header and contents
+        const std::byte* header = file.ReadSpan(3 * sizeof(uint32_t));
+        if (!header || _World_Blocks::read<uint32_t>(header) != _World_Blocks::magic)
+        {
+            LOG_ERROR("\"%s\" is not a world file", file_path.c_str());
+            return false;
+        }
+
+        const uint32_t version  = _World_Blocks::read<uint32_t>(header);
+        const uint32_t count    = _World_Blocks::read<uint32_t>(header);
+        if (version != _World_Blocks::version)
+        {
+            LOG_ERROR("\"%s\" is of version %d, expected %d", file_path.c_str(), version, _World_Blocks::version);
+            return false;
+        }
+
+        const std::byte* contents_data = file.ReadSpan(static_cast<size_t>(count) * (2 * sizeof(uint32_t) + 2 * sizeof(uint64_t)));
+        if (!contents_data)
+        {
+            LOG_ERROR("The contents of \"%s\" are truncated", file_path.c_str());
+            return false;
+        }
+
+        vector<_World_Blocks::Block> contents(count);
+        uint64_t data_size = 0;
+        for (_World_Blocks::Block& block : contents)
+        {
+            block.kind      = _World_Blocks::read<uint32_t>(contents_data);
+            block.count     = _World_Blocks::read<uint32_t>(contents_data);
+            block.offset    = _World_Blocks::read<uint64_t>(contents_data);
+            block.size      = _World_Blocks::read<uint64_t>(contents_data);
+            data_size       = max(data_size, block.offset + block.size);
+
+            if (block.kind > _World_Blocks::kind_entities || block.offset + block.size < block.offset)
+            {
+                LOG_ERROR("\"%s\" has an invalid block", file_path.c_str());
+                return false;
+            }
+        }
+
+        const std::byte* data = file.ReadSpan(static_cast<size_t>(data_size));
+        if (!data && data_size != 0)
+        {
+            LOG_ERROR("The blocks of \"%s\" are truncated", file_path.c_str());
+            return false;
+        }
+
+        if (contents.empty() || contents.front().kind != _World_Blocks::kind_entities)
+        {
+            LOG_ERROR("\"%s\" has no entities", file_path.c_str());
+            return false;
+        }
+
+        // Decode every block on its own thread
+        Threading* threading = m_context->GetSubsystem<Threading>();
+        vector<_World_Blocks::Block_Decoded> blocks(count);
+        atomic<bool> decoded = true;
+        threading->ParallelFor([&](uint32_t index_start, uint32_t index_end)
+        {
+            for (uint32_t i = index_start; i < index_end; i++)
+            {
+                if (!_World_Blocks::decode(data, contents[i], blocks[i]))
+                {
+                    decoded = false;
+                }
+            }
+        }, count, 1);
+
+        if (!decoded)
+        {
+            LOG_ERROR("\"%s\" has a corrupt block", file_path.c_str());
+            return false;
+        }
+
+        // Entities and components, creating them touches the world, the component pools and the resource cache so it's done here
+        ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
+        const vector<_World_Blocks::Block_Entity>& entities_decoded = blocks.front().entities;
+        vector<Entity*> entities(entities_decoded.size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+        {
+            const _World_Blocks::Block_Entity& decoded_entity = entities_decoded[i];
+
+            Entity* entity = EntityCreate(decoded_entity.is_active).get();
+            entity->SetId(decoded_entity.id);
+            entity->SetName(decoded_entity.name);
+            entity->SetHierarchyVisibility(decoded_entity.is_visible);
+            if (!decoded_entity.prefab_path.empty())
+            {
+                entity->SetPrefab(resource_cache->Load<Prefab>(decoded_entity.prefab_path), decoded_entity.prefab_node);
+            }
+
+            entities[i] = entity;
+        }
+        for (uint32_t b = 1; b < count; b++)
+        {
+            _World_Blocks::Block_Decoded& block = blocks[b];
+            for (uint32_t i = 0; i < static_cast<uint32_t>(block.components.size()); i++)
+            {
+                if (block.entity_indices[i] < entities.size())
+                {
+                    block.components[i] = entities[block.entity_indices[i]]->AddComponent(static_cast<ComponentType>(block.kind), block.ids[i]);
+                }
+            }
+        }
+
+        // Deserialize the components, a block at a time and in parallel for the types which allow it
+        m_hierarchy_link_deferred = true;
+        for (uint32_t b = 1; b < count; b++)
+        {
+            _World_Blocks::Block_Decoded& block = blocks[b];
+            const auto deserialize = [&block](uint32_t index_start, uint32_t index_end)
+            {
+                // The data of a range of components is contiguous, so a range reads from a single stream
+                FileStream stream(block.records + block.offsets[index_start], block.offsets[index_end] - block.offsets[index_start]);
+
+                for (uint32_t i = index_start; i < index_end; i++)
+                {
+                    IComponent* component = block.components[i];
+                    if (!component)
+                    {
+                        LOG_ERROR("A component of type %d has no entity, skipping the rest of its range", block.kind);
+                        return;
+                    }
+
+                    if (block.from_prefab[i])
+                    {
+                        if (const string* data_prefab = component->GetEntity()->GetPrefabComponentData(component))
+                        {
+                            FileStream memory_prefab(reinterpret_cast<const std::byte*>(data_prefab->data()), data_prefab->size());
+                            component->Deserialize(&memory_prefab);
+                        }
+                        else
+                        {
+                            LOG_WARNING("The prefab data of \"%s\" is missing", component->GetEntityName().c_str());
+                        }
+
+                        continue;
+                    }
+
+                    component->Deserialize(&stream);
+                }
+            };
+
+            const auto component_count = static_cast<uint32_t>(block.components.size());
+            if (_World_Blocks::is_parallel(static_cast<ComponentType>(block.kind)))
+            {
+                threading->ParallelFor(deserialize, component_count);
+            }
+            else if (component_count != 0)
+            {
+                deserialize(0, component_count);
+            }
+        }
+        m_hierarchy_link_deferred = false;
+
+        // Link the hierarchy in one pass
+        vector<pair<Transform*, Transform*>> child_parent_pairs;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+        {
+            const int32_t parent = entities_decoded[i].parent;
+            if (parent >= 0 && static_cast<uint32_t>(parent) < i)
+            {
+                child_parent_pairs.emplace_back(entities[i]->GetTransform(), entities[parent]->GetTransform());
+            }
+        }
+        Transform::LinkHierarchy(child_parent_pairs);
+
+        return true;
+    }
+}
@@ -20,10 +20,16 @@
 SOLUTION_NAME		= "Spartan"
 EDITOR_NAME			= "Editor"
 RUNTIME_NAME		= "Runtime"
+SHADER_COMPILER_NAME = "ShaderCompiler"
+BENCHMARKS_NAME		= "Benchmarks"
+RUNNER_NAME			= "Runner"
 TARGET_NAME			= "Spartan" -- Name of executable
 DEBUG_FORMAT		= "c7"
 EDITOR_DIR			= "../" .. EDITOR_NAME
 RUNTIME_DIR			= "../" .. RUNTIME_NAME
+SHADER_COMPILER_DIR = "../" .. SHADER_COMPILER_NAME
+BENCHMARKS_DIR		= "../" .. BENCHMARKS_NAME
+RUNNER_DIR			= "../" .. RUNNER_NAME
 IGNORE_FILES		= {}
 LIBRARY_DIR			= "../ThirdParty/libraries"
 INTERMEDIATE_DIR	= "../Binaries/Intermediate"
@@ -182,4 +188,111 @@ project (EDITOR_NAME)
 	-- "Release"
 	filter "configurations:Release"
 		targetdir (TARGET_DIR_RELEASE)
-		debugdir (TARGET_DIR_RELEASE)
\ No newline at end of file
+		debugdir (TARGET_DIR_RELEASE)
+
+-- Shader compiler -----------------------------------------------------------------------------------------
+-- Compiles every shader permutation offline and packs them into Data/shaders/cache/shaders_<api>.pak
+project (SHADER_COMPILER_NAME)
+	location (SHADER_COMPILER_DIR)
+	links { RUNTIME_NAME }
+	dependson { RUNTIME_NAME }
+	targetname ( SHADER_COMPILER_NAME .. "_" .. _ARGS[1] )
+	objdir (INTERMEDIATE_DIR)
+	kind "ConsoleApp"
+	staticruntime "On"
+	defines{ API_GRAPHICS }
+	
+	-- Files
+	files 
+	{ 
+		SHADER_COMPILER_DIR .. "/**.h",
+		SHADER_COMPILER_DIR .. "/**.cpp"
+	}
+	
+	-- Includes
+	includedirs { "../" .. RUNTIME_NAME }
+	
+	-- Libraries
+	libdirs (LIBRARY_DIR)
+
+	-- "Debug"
+	filter "configurations:Debug"
+		targetdir (TARGET_DIR_DEBUG)	
+		debugdir (TARGET_DIR_DEBUG)
+		debugformat (DEBUG_FORMAT)		
+				
+	-- "Release"
+	filter "configurations:Release"
+		targetdir (TARGET_DIR_RELEASE)
+		debugdir (TARGET_DIR_RELEASE)
+
+-- Benchmarks ----------------------------------------------------------------------------------------------
+-- Micro-benchmarks of Runtime/Math, they write benchmarks.json and compare it to an earlier one with --baseline
+project (BENCHMARKS_NAME)
+	location (BENCHMARKS_DIR)
+	links { RUNTIME_NAME }
+	dependson { RUNTIME_NAME }
+	objdir (INTERMEDIATE_DIR)
+	kind "ConsoleApp"
+	staticruntime "On"
+	defines{ API_GRAPHICS }
+	
+	-- Files
+	files 
+	{ 
+		BENCHMARKS_DIR .. "/**.h",
+		BENCHMARKS_DIR .. "/**.cpp"
+	}
+	
+	-- Includes
+	includedirs { "../" .. RUNTIME_NAME }
+	
+	-- Libraries
+	libdirs (LIBRARY_DIR)
+
+	-- "Debug"
+	filter "configurations:Debug"
+		targetdir (TARGET_DIR_DEBUG)	
+		debugdir (TARGET_DIR_DEBUG)
+		debugformat (DEBUG_FORMAT)		
+				
+	-- "Release"
+	filter "configurations:Release"
+		targetdir (TARGET_DIR_RELEASE)
+		debugdir (TARGET_DIR_RELEASE)
+
+-- Runner --------------------------------------------------------------------------------------------------
+-- Renders a world headless along a camera path, it writes runner.csv and runner.json and compares them to an earlier run with --baseline
+project (RUNNER_NAME)
+	location (RUNNER_DIR)
+	links { RUNTIME_NAME }
+	dependson { RUNTIME_NAME }
+	targetname ( RUNNER_NAME .. "_" .. _ARGS[1] )
+	objdir (INTERMEDIATE_DIR)
+	kind "ConsoleApp"
+	staticruntime "On"
+	defines{ API_GRAPHICS }
+	
+	-- Files
+	files 
+	{ 
+		RUNNER_DIR .. "/**.h",
+		RUNNER_DIR .. "/**.cpp"
+	}
+	
+	-- Includes
+	includedirs { "../" .. RUNTIME_NAME }
+	
+	-- Libraries
+	libdirs (LIBRARY_DIR)
+
+	-- "Debug"
+	filter "configurations:Debug"
+		targetdir (TARGET_DIR_DEBUG)	
+		debugdir (TARGET_DIR_DEBUG)
+		debugformat (DEBUG_FORMAT)		
+				
+	-- "Release"
+	filter "configurations:Release"
+		targetdir (TARGET_DIR_RELEASE)
+		debugdir (TARGET_DIR_RELEASE)
@@ -0,0 +1,28 @@
+@echo off
+
+rem Runs every generated scene of the runner and compares it to its baseline in Runner\baselines\ (if there is one).
+rem Usage: run_benchmark_scenes.bat [api] [--update], api is the runner's build (vulkan by default) and --update replaces the baselines.
+rem Baselines depend on the GPU and the driver, so they should come from the machine which compares against them.
+
+set API=%1
+if "%API%"=="" set API=vulkan
+set RUNNER=Binaries\Release\Runner_%API%.exe
+set BASELINES=Runner\baselines
+set FAILED=0
+
+cd /D "%~dp0\.."
+if not exist "%BASELINES%" mkdir "%BASELINES%"
+
+for %%s in (instances lights rigid_bodies scripts terrain transparency) do (
+	echo %%s
+	if "%2"=="--update" (
+		"%RUNNER%" --scene %%s --csv "%BASELINES%\%%s_%API%.csv" --json "%BASELINES%\%%s_%API%.json" || set FAILED=1
+	) else if exist "%BASELINES%\%%s_%API%.json" (
+		"%RUNNER%" --scene %%s --csv "runner_%%s.csv" --json "runner_%%s.json" --baseline "%BASELINES%\%%s_%API%.json" || set FAILED=1
+	) else (
+		"%RUNNER%" --scene %%s --csv "runner_%%s.csv" --json "runner_%%s.json" || set FAILED=1
+	)
+	echo:
+)
+
+exit /b %FAILED%
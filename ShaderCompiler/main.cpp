@@ -0,0 +1,116 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include "Core/FileSystem.h"
+#include "Logging/ILogger.h"
+#include "Logging/Log.h"
+#include "Rendering/ShaderGBuffer.h"
+#include "Rendering/ShaderLight.h"
+//================================
+
+//= NAMESPACES ==========
+using namespace std;
+using namespace Spartan;
+//=======================
+
+// Offline shader compiler, it compiles every shader permutation for the graphics API it's built for (there is one build
+// per API, just like the engine) and packs the results into the archive which RHI_Shader looks in before compiling.
+//
+// Usage: ShaderCompiler [data directory], the data directory defaults to "Data/"
+
+class ConsoleLogger : public ILogger
+{
+public:
+    void Log(const string& log, uint32_t type) override
+    {
+        (type == Log_Info ? cout : cerr) << log << endl;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    shared_ptr<ConsoleLogger> logger = make_shared<ConsoleLogger>();
+    Log::SetLogger(logger);
+    LOG_TO_FILE(false);
+
+    const string data_directory     = argc > 1 ? string(argv[1]) + "/" : "Data/";
+    const string shader_directory   = data_directory + "shaders/";
+    if (!FileSystem::IsDirectory(shader_directory))
+    {
+        LOG_ERROR("\"%s\" doesn't exist", shader_directory.c_str());
+        return 1;
+    }
+
+    // Enumerate the permutations
+    vector<shared_ptr<RHI_Shader>> shaders;
+    vector<string> file_paths;
+    for (const uint16_t flags : ShaderGBuffer::GetPermutations())
+    {
+        shared_ptr<RHI_Shader> shader = make_shared<RHI_Shader>();
+        ShaderGBuffer::AddDefines(shader.get(), flags);
+        shaders.emplace_back(shader);
+        file_paths.emplace_back(shader_directory + ShaderGBuffer::GetFileName());
+    }
+    for (const uint16_t flags : ShaderLight::GetPermutations())
+    {
+        shared_ptr<RHI_Shader> shader = make_shared<RHI_Shader>();
+        ShaderLight::AddDefines(shader.get(), flags);
+        shaders.emplace_back(shader);
+        file_paths.emplace_back(shader_directory + ShaderLight::GetFileName());
+    }
+
+    // Compile them in parallel, each thread takes the next permutation until there are none left
+    atomic<uint32_t> next   = 0;
+    atomic<bool> failed     = false;
+    vector<thread> threads(max(thread::hardware_concurrency(), 1u));
+    for (thread& thread : threads)
+    {
+        thread = std::thread([&]()
+        {
+            for (uint32_t i = next++; i < static_cast<uint32_t>(shaders.size()); i = next++)
+            {
+                if (!shaders[i]->CompileToCache(RHI_Shader_Pixel, file_paths[i]))
+                {
+                    failed = true;
+                }
+            }
+        });
+    }
+
+    for (thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (failed)
+    {
+        LOG_ERROR("Some permutations failed to compile, no archive was written");
+        return 1;
+    }
+
+    // Pack
+    return RHI_Shader::SaveCacheArchive(shader_directory, shaders) ? 0 : 1;
+}